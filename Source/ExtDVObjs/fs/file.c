@@ -30,8 +30,10 @@
 
 #include <unistd.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 
 #define BUFFER_SIZE         4096
+#define MIN_MAPPED_SIZE     (256 * 1024)
 #define ENDIAN_PLATFORM     0
 #define ENDIAN_LITTLE       1
 #define ENDIAN_BIG          2
@@ -192,16 +194,13 @@ static size_t scan_lines (FILE *fp)
         if (read_size == 0)
             break;
 
-        size_t i;
-        for (i = 0; i < read_size; i++) {
-            if (buffer[i] == '\n') {
-                total_line ++;
-                new_line_flag = false;
-            }
-            else {
-                new_line_flag = true;
-            }
+        const char *p = buffer;
+        const char *end = buffer + read_size;
+        while ((p = memchr (p, '\n', end - p))) {
+            total_line ++;
+            p++;
         }
+        new_line_flag = (buffer[read_size - 1] != '\n');
 
         if (read_size < BUFFER_SIZE) // No more content.
             break;
@@ -214,6 +213,45 @@ static size_t scan_lines (FILE *fp)
     return total_line;
 }
 
+// Scan the file backward block by block, and tell me where the last
+// line_num (> 0) lines start; the last 0x0A ends the last line.
+static off_t find_last_lines (FILE *fp, size_t line_num)
+{
+    char    buffer[BUFFER_SIZE];
+    off_t   end;
+    bool    last_byte = true;
+
+    if (fseeko (fp, 0, SEEK_END) || (end = ftello (fp)) < 0)
+        return 0;
+
+    while (end > 0) {
+        size_t read_size = (end > BUFFER_SIZE) ? BUFFER_SIZE : (size_t)end;
+        off_t start = end - read_size;
+
+        if (fseeko (fp, start, SEEK_SET) ||
+                fread (buffer, 1, read_size, fp) != read_size)
+            break;
+
+        size_t i = read_size;
+        if (last_byte) {
+            if (buffer[i - 1] == '\n')
+                i--;
+            last_byte = false;
+        }
+
+        while (i > 0) {
+            if (buffer[--i] == '\n') {
+                if (--line_num == 0)
+                    return start + i + 1;
+            }
+        }
+
+        end = start;
+    }
+
+    return 0;
+}
+
 // line_num == 0: Read all lines.
 // line_num  > 0: Read the first line_num lines.
 // line_num  < 0: Skip the first line_num lines and read the remaining lines.
@@ -457,24 +495,65 @@ text_tail_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         ret_var = read_lines (fp, line_num);
     }
     else {
-        // line_num > 0: Read the last line_num lines.
-
-        // Scan the file and tell me how many lines there will be.
-        size_t total_line = scan_lines (fp);
-
-        line_num = total_line - line_num;
+        // line_num > 0: Read the last line_num lines, located by
+        // scanning from the end instead of the whole file.
+        off_t pos = find_last_lines (fp, line_num);
 
-        if (line_num <= 0)
-            ret_var = purc_variant_make_array (0, PURC_VARIANT_INVALID);
+        if (fseeko (fp, pos, SEEK_SET) == 0)
+            ret_var = read_lines (fp, 0);
         else
-            // Skip line_num lines.
-            ret_var = read_lines (fp, -line_num);
+            ret_var = purc_variant_make_array (0, PURC_VARIANT_INVALID);
     }
 
     fclose (fp);
     return ret_var;
 }
 
+/*
+ * Maps the range [offset, offset + length) of the regular file @fd, and
+ * makes a byte sequence or a string which references the mapped pages;
+ * the pages are unmapped when the variant is released. Returns false if
+ * the range is not mapped (too small, or the mapping failed), in which
+ * case the caller reads the file instead.
+ *
+ * A string needs a null byte after it in the mapped pages, so it is mapped
+ * only if the range ends at the end of a file whose size is not a multiple
+ * of the page size (the rest of the last page is filled with zeros).
+ */
+bool pcdvobjs_file_map_range (int fd, off_t offset, size_t length,
+        off_t file_size, bool binary, bool check_encoding,
+        purc_variant_t *result)
+{
+    off_t page_size = sysconf (_SC_PAGESIZE);
+
+    if (length < MIN_MAPPED_SIZE)
+        return false;
+
+    if (!binary && (offset + (off_t)length != file_size ||
+                file_size % page_size == 0))
+        return false;
+
+    off_t base = offset & ~(page_size - 1);
+    size_t sz_map = offset - base + length + (binary ? 0 : 1);
+    void *addr = mmap (NULL, sz_map, PROT_READ, MAP_PRIVATE, fd, base);
+    if (addr == MAP_FAILED)
+        return false;
+
+    // the contents are usually consumed from the head to the tail
+    madvise (addr, sz_map, MADV_SEQUENTIAL);
+
+    const char *data = (const char *)addr + (offset - base);
+    if (binary)
+        *result = purc_variant_make_byte_sequence_mapped (data, length);
+    else
+        *result = purc_variant_make_string_mapped (data, length,
+                check_encoding);
+
+    if (*result == PURC_VARIANT_INVALID)
+        munmap (addr, sz_map);
+    return true;
+}
+
 static purc_variant_t
 bin_head_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         bool silently)
@@ -539,6 +618,12 @@ bin_head_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
             pos = filestat.st_size + byte_num;
     }
 
+    if (pcdvobjs_file_map_range (fileno (fp), 0, pos, filestat.st_size,
+                true, false, &ret_var)) {
+        fclose (fp);
+        return ret_var;
+    }
+
     char *content = malloc (pos);
     if (content == NULL) {
         fclose (fp);
@@ -619,6 +704,12 @@ bin_tail_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
             pos = filestat.st_size + byte_num;
     }
 
+    if (pcdvobjs_file_map_range (fileno (fp), filestat.st_size - pos, pos,
+                filestat.st_size, true, false, &ret_var)) {
+        fclose (fp);
+        return ret_var;
+    }
+
     fseek (fp, filestat.st_size - pos, SEEK_SET);
 
     char *content = malloc (pos);
@@ -54,11 +54,18 @@
 #include <glib.h>
 #endif
 
+#if USE(PTHREADS)
+#include <pthread.h>
+#endif
+
 #define FS_DVOBJ_VERSION    0
 
 #define CKEY_DIR        "DIR"
 
 purc_variant_t pcdvobjs_create_file (void);
+bool pcdvobjs_file_map_range (int fd, off_t offset, size_t length,
+        off_t file_size, bool binary, bool check_encoding,
+        purc_variant_t *result);
 typedef purc_variant_t (*pcdvobjs_create) (void);
 
 // as FILE, FS, MATH
@@ -84,22 +91,7 @@ static const char * pcdvobjs_remove_space (char *buffer)
     return buffer;
 }
 
-#if USE(GLIB)
-static bool wildcard_cmp (const char *str1, const char *pattern)
-{
-    GPatternSpec *glib_pattern = g_pattern_spec_new (pattern);
-
-#if GLIB_CHECK_VERSION(2, 70, 0)
-    gboolean result = g_pattern_spec_match_string (glib_pattern, str1);
-#else
-    gboolean result = g_pattern_match_string (glib_pattern, str1);
-#endif
-
-    g_pattern_spec_free (glib_pattern);
-
-    return (bool)result;
-}
-#else
+#if !USE(GLIB)
 static bool wildcard_cmp (const char *str1, const char *pattern)
 {
     if (str1 == NULL)
@@ -149,6 +141,111 @@ static bool wildcard_cmp (const char *str1, const char *pattern)
 }
 #endif
 
+/*
+ * The filter like `*.c; *.h` compiled once, instead of compiling every
+ * pattern again for every entry of a directory.
+ */
+struct name_filter {
+    size_t nr_patterns;
+    char **patterns;
+#if USE(GLIB)
+    GPatternSpec **specs;
+#endif
+};
+
+static void name_filter_delete (struct name_filter *filter)
+{
+    for (size_t i = 0; i < filter->nr_patterns; i++) {
+        free (filter->patterns[i]);
+#if USE(GLIB)
+        if (filter->specs[i])
+            g_pattern_spec_free (filter->specs[i]);
+#endif
+    }
+
+    free (filter->patterns);
+#if USE(GLIB)
+    free (filter->specs);
+#endif
+    free (filter);
+}
+
+/* returns NULL and sets the error if no memory */
+static struct name_filter *name_filter_new (const char *string)
+{
+    struct name_filter *filter = calloc (1, sizeof(*filter));
+    if (filter == NULL)
+        goto failed;
+
+    size_t length = 0;
+    size_t nr = 0;
+    const char *head = pcutils_get_next_token (string, ";", &length);
+    while (head) {
+        nr++;
+        head = pcutils_get_next_token (head + length, ";", &length);
+    }
+
+    if (nr == 0)
+        return filter;
+
+    filter->patterns = calloc (nr, sizeof(char *));
+#if USE(GLIB)
+    filter->specs = calloc (nr, sizeof(GPatternSpec *));
+    if (filter->specs == NULL)
+        goto failed;
+#endif
+    if (filter->patterns == NULL)
+        goto failed;
+
+    head = pcutils_get_next_token (string, ";", &length);
+    while (head) {
+        char *pattern = strndup (head, length);
+        if (pattern == NULL)
+            goto failed;
+
+        pcdvobjs_remove_space (pattern);
+        filter->patterns[filter->nr_patterns] = pattern;
+#if USE(GLIB)
+        filter->specs[filter->nr_patterns] = g_pattern_spec_new (pattern);
+#endif
+        filter->nr_patterns++;
+        head = pcutils_get_next_token (head + length, ";", &length);
+    }
+
+    return filter;
+
+failed:
+    if (filter)
+        name_filter_delete (filter);
+    purc_set_error (PURC_ERROR_OUT_OF_MEMORY);
+    return NULL;
+}
+
+/* an empty filter matches any name */
+static bool name_filter_match (const struct name_filter *filter,
+        const char *name)
+{
+    if (filter == NULL || filter->nr_patterns == 0)
+        return true;
+
+    for (size_t i = 0; i < filter->nr_patterns; i++) {
+#if USE(GLIB)
+#if GLIB_CHECK_VERSION(2, 70, 0)
+        if (g_pattern_spec_match_string (filter->specs[i], name))
+            return true;
+#else
+        if (g_pattern_match_string (filter->specs[i], name))
+            return true;
+#endif
+#else
+        if (wildcard_cmp (name, filter->patterns[i]))
+            return true;
+#endif
+    }
+
+    return false;
+}
+
 static bool remove_dir (char *dir)
 {
     char dir_name[PATH_MAX];
@@ -797,13 +894,11 @@ list_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
     UNUSED_PARAM(silently);
 
     char dir_name[PATH_MAX + 1];
-    char filename[PATH_MAX + NAME_MAX + 1];
     const char *string_filename = NULL;
     purc_variant_t ret_var = PURC_VARIANT_INVALID;
     purc_variant_t val = PURC_VARIANT_INVALID;
     const char *filter = NULL;
-    struct wildcard_list *wildcard = NULL;
-    struct wildcard_list *temp_wildcard = NULL;
+    struct name_filter *name_filter = NULL;
     char au[10] = {0};
     int i = 0;
 
@@ -836,30 +931,9 @@ list_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
 
     // get filter array
     if (filter) {
-        size_t length = 0;
-        const char *head = pcutils_get_next_token (filter, ";", &length);
-        while (head) {
-            if (wildcard == NULL) {
-                wildcard = malloc (sizeof(struct wildcard_list));
-                if (wildcard == NULL)
-                    goto error;
-                temp_wildcard = wildcard;
-            }
-            else {
-                temp_wildcard->next = malloc (sizeof(struct wildcard_list));
-                if (temp_wildcard->next == NULL)
-                    goto error;
-                temp_wildcard = temp_wildcard->next;
-            }
-            temp_wildcard->next = NULL;
-            temp_wildcard->wildcard = malloc (length + 1);
-            if (temp_wildcard->wildcard == NULL)
-                goto error;
-            strncpy(temp_wildcard->wildcard, head, length);
-            *(temp_wildcard->wildcard + length) = 0x00;
-            pcdvobjs_remove_space (temp_wildcard->wildcard);
-            head = pcutils_get_next_token (head + length + 1, ";", &length);
-        }
+        name_filter = name_filter_new (filter);
+        if (name_filter == NULL)
+            goto error;
     }
 
     // get the dirctory content
@@ -880,25 +954,15 @@ list_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
             continue;
 
         // use filter
-        temp_wildcard = wildcard;
-        while (temp_wildcard) {
-            if (wildcard_cmp (ptr->d_name, temp_wildcard->wildcard))
-                break;
-            temp_wildcard = temp_wildcard->next;
-        }
-        if (wildcard && (temp_wildcard == NULL))
+        if (!name_filter_match (name_filter, ptr->d_name))
+            continue;
+
+        if (fstatat (dirfd (dir), ptr->d_name, &file_stat, 0) < 0)
             continue;
 
         obj_var = purc_variant_make_object (0, PURC_VARIANT_INVALID,
                 PURC_VARIANT_INVALID);
 
-        strncpy (filename, dir_name, sizeof(filename)-1);
-        strcat (filename, "/");
-        strcat (filename, ptr->d_name);
-
-        if (stat(filename, &file_stat) < 0)
-            continue;
-
         // name
         val = purc_variant_make_string (ptr->d_name, false);
         purc_variant_object_set_by_static_ckey (obj_var, "name", val);
@@ -1043,13 +1107,8 @@ list_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
     closedir(dir);
 
 error:
-    while (wildcard) {
-        if (wildcard->wildcard)
-            free (wildcard->wildcard);
-        temp_wildcard = wildcard;
-        wildcard = wildcard->next;
-        free (temp_wildcard);
-    }
+    if (name_filter)
+        name_filter_delete (name_filter);
     return ret_var;
 }
 
@@ -1074,11 +1133,9 @@ list_prt_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         DISPLAY_MAX
     };
     char dir_name[PATH_MAX + 1];
-    char filename[PATH_MAX + NAME_MAX + 1];
     const char *string_filename = NULL;
     const char *filter = NULL;
-    struct wildcard_list *wildcard = NULL;
-    struct wildcard_list *temp_wildcard = NULL;
+    struct name_filter *name_filter = NULL;
     const char *mode = NULL;
     char display[DISPLAY_MAX] = {0};
     purc_variant_t ret_var = PURC_VARIANT_INVALID;
@@ -1115,30 +1172,9 @@ list_prt_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
 
     // get filter array
     if (filter) {
-        size_t length = 0;
-        const char *head = pcutils_get_next_token (filter, ";", &length);
-        while (head) {
-            if (wildcard == NULL) {
-                wildcard = malloc (sizeof(struct wildcard_list));
-                if (wildcard == NULL)
-                    goto error;
-                temp_wildcard = wildcard;
-            }
-            else {
-                temp_wildcard->next = malloc (sizeof(struct wildcard_list));
-                if (temp_wildcard->next == NULL)
-                    goto error;
-                temp_wildcard = temp_wildcard->next;
-            }
-            temp_wildcard->next = NULL;
-            temp_wildcard->wildcard = malloc (length + 1);
-            if (temp_wildcard->wildcard == NULL)
-                goto error;
-            strncpy(temp_wildcard->wildcard, head, length);
-            *(temp_wildcard->wildcard + length) = 0x00;
-            pcdvobjs_remove_space (temp_wildcard->wildcard);
-            head = pcutils_get_next_token (head + length + 1, ";", &length);
-        }
+        name_filter = name_filter_new (filter);
+        if (name_filter == NULL)
+            goto error;
     }
 
     // get the mode
@@ -1264,20 +1300,10 @@ list_prt_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
             continue;
 
         // use filter
-        temp_wildcard = wildcard;
-        while (temp_wildcard) {
-            if (wildcard_cmp (ptr->d_name, temp_wildcard->wildcard))
-                break;
-            temp_wildcard = temp_wildcard->next;
-        }
-        if (wildcard && (temp_wildcard == NULL))
+        if (!name_filter_match (name_filter, ptr->d_name))
             continue;
 
-        strncpy (filename, dir_name, sizeof(filename)-1);
-        strcat (filename, "/");
-        strcat (filename, ptr->d_name);
-
-        if (stat(filename, &file_stat) < 0)
+        if (fstatat (dirfd (dir), ptr->d_name, &file_stat, 0) < 0)
             continue;
 
         for (i = 0; i < (DISPLAY_MAX - 1); i++) {
@@ -1380,13 +1406,8 @@ list_prt_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
     closedir(dir);
 
 error:
-    while (wildcard) {
-        if (wildcard->wildcard)
-            free (wildcard->wildcard);
-        temp_wildcard = wildcard;
-        wildcard = wildcard->next;
-        free (temp_wildcard);
-    }
+    if (name_filter)
+        name_filter_delete (name_filter);
     return ret_var;
 }
 
@@ -2838,6 +2859,13 @@ file_contents_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         goto err;
     }
 
+    /* reference the pages of a large file instead of copying them */
+    if (pcdvobjs_file_map_range (fileno (fp), offset, length, filesize,
+                flag_binary, true, &ret_var)) {
+        fclose (fp);
+        return ret_var;
+    }
+
     bsequence = malloc (length + 1);
     bsequence[length] = 0x0;
 
@@ -3000,11 +3028,52 @@ file_contents_setter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
     return ret_var;
 }
 
+#define DEF_DIR_BATCH_SIZE      256
+#define MAX_DIR_BATCH_SIZE      65536
+#define MAX_DIR_DEPTH           64
+
+/* the least number of entries of a batch to stat in parallel */
+#define MIN_PARALLEL_STATS      64
+#define MAX_STAT_WORKERS        8
+
+struct dir_level {
+    DIR    *dirp;
+    size_t  prefix_len;     /* the length of the path of the level in
+                               `relpath`, including the trailing slash */
+};
+
 struct pcdvobjs_dir_stream {
     DIR* dirp;
     char dirpath[PATH_MAX];
+
+    /* the directories being walked by read_batch(); the first one is
+       `dirp`, the last one is read first. */
+    struct dir_level levels[MAX_DIR_DEPTH];
+    int nr_levels;
+    char relpath[PATH_MAX];
+
+    bool recursive;         /* walk the subdirectories */
+    bool parallel;          /* stat the entries of a batch in parallel */
 };
 
+/* an entry collected by read_batch() */
+struct dir_batch_entry {
+    char           *path;   /* relative to the directory opened */
+    ino_t           ino;
+    unsigned char   d_type;
+    bool            stat_ok;
+    struct stat     st;
+};
+
+/* pops the subdirectories walked; the first level is kept */
+static void dir_stream_pop_levels (struct pcdvobjs_dir_stream *dir_stream)
+{
+    while (dir_stream->nr_levels > 1) {
+        dir_stream->nr_levels--;
+        closedir (dir_stream->levels[dir_stream->nr_levels].dirp);
+    }
+}
+
 static purc_variant_t
 dir_read_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         bool silently)
@@ -3077,18 +3146,369 @@ dir_rewind_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         return PURC_VARIANT_INVALID;
     }
 
+    dir_stream_pop_levels (dir_stream);
     rewinddir(dirp);
 
     return purc_variant_make_boolean (true);
 }
 
+static const char *type_of_dirent (unsigned char d_type)
+{
+    switch (d_type) {
+    case DT_BLK:
+        return "b";
+    case DT_CHR:
+        return "c";
+    case DT_DIR:
+        return "d";
+    case DT_FIFO:
+        return "f";
+    case DT_LNK:
+        return "l";
+    case DT_REG:
+        return "r";
+    case DT_SOCK:
+        return "s";
+    default:
+        return "u";
+    }
+}
+
+static unsigned char dirent_type_of_mode (mode_t mode)
+{
+    if (S_ISBLK(mode))
+        return DT_BLK;
+    if (S_ISCHR(mode))
+        return DT_CHR;
+    if (S_ISDIR(mode))
+        return DT_DIR;
+    if (S_ISFIFO(mode))
+        return DT_FIFO;
+    if (S_ISLNK(mode))
+        return DT_LNK;
+    if (S_ISREG(mode))
+        return DT_REG;
+    if (S_ISSOCK(mode))
+        return DT_SOCK;
+    return DT_UNKNOWN;
+}
+
+struct stat_task {
+    int                     rootfd;
+    struct dir_batch_entry *entries;
+    size_t                  nr_entries;
+};
+
+static void *stat_entries (void *arg)
+{
+    struct stat_task *task = arg;
+
+    for (size_t i = 0; i < task->nr_entries; i++) {
+        struct dir_batch_entry *entry = task->entries + i;
+        if (!entry->stat_ok)
+            entry->stat_ok = fstatat (task->rootfd, entry->path, &entry->st,
+                    AT_SYMLINK_NOFOLLOW) == 0;
+    }
+
+    return NULL;
+}
+
+/* stats the entries which are not stat'ed yet, on the workers if wanted. */
+static void stat_batch (struct pcdvobjs_dir_stream *dir_stream,
+        struct dir_batch_entry *entries, size_t nr_entries)
+{
+    int rootfd = dirfd (dir_stream->dirp);
+
+#if USE(PTHREADS)
+    long nr_cpus = sysconf (_SC_NPROCESSORS_ONLN);
+    if (dir_stream->parallel && nr_entries >= MIN_PARALLEL_STATS &&
+            nr_cpus > 1) {
+        size_t nr_workers = nr_cpus > MAX_STAT_WORKERS ?
+            MAX_STAT_WORKERS : (size_t)nr_cpus;
+        struct stat_task tasks[MAX_STAT_WORKERS];
+        pthread_t threads[MAX_STAT_WORKERS];
+        size_t nr_started = 1;
+
+        for (size_t i = 0; i < nr_workers; i++) {
+            size_t start = nr_entries * i / nr_workers;
+            size_t end = nr_entries * (i + 1) / nr_workers;
+            tasks[i].rootfd = rootfd;
+            tasks[i].entries = entries + start;
+            tasks[i].nr_entries = end - start;
+        }
+
+        for (; nr_started < nr_workers; nr_started++) {
+            if (pthread_create (threads + nr_started, NULL, stat_entries,
+                        tasks + nr_started))
+                break;
+        }
+
+        /* the calling thread takes the first part and those not started */
+        stat_entries (tasks);
+        for (size_t i = nr_started; i < nr_workers; i++)
+            stat_entries (tasks + i);
+        for (size_t i = 1; i < nr_started; i++)
+            pthread_join (threads[i], NULL);
+        return;
+    }
+#endif
+
+    struct stat_task task = { rootfd, entries, nr_entries };
+    stat_entries (&task);
+}
+
+/* enters the subdirectory @relpath (relative to the directory opened) */
+static void dir_stream_push_level (struct pcdvobjs_dir_stream *dir_stream,
+        const char *relpath)
+{
+    if (dir_stream->nr_levels >= MAX_DIR_DEPTH)
+        return;
+
+    size_t len = strlen (relpath);
+    if (len + 2 > sizeof(dir_stream->relpath))
+        return;
+
+    int fd = openat (dirfd (dir_stream->dirp), relpath,
+            O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0)
+        return;
+
+    DIR *dirp = fdopendir (fd);
+    if (dirp == NULL) {
+        close (fd);
+        return;
+    }
+
+    memcpy (dir_stream->relpath, relpath, len);
+    dir_stream->relpath[len] = '/';
+
+    struct dir_level *level = dir_stream->levels + dir_stream->nr_levels;
+    level->dirp = dirp;
+    level->prefix_len = len + 1;
+    dir_stream->nr_levels++;
+}
+
+static purc_variant_t make_batch_entry (const struct dir_batch_entry *entry,
+        bool with_stat)
+{
+    purc_variant_t obj_var, val;
+
+    obj_var = purc_variant_make_object (0, PURC_VARIANT_INVALID,
+            PURC_VARIANT_INVALID);
+    if (obj_var == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    val = purc_variant_make_string (entry->path, false);
+    purc_variant_object_set_by_static_ckey (obj_var, "name", val);
+    purc_variant_unref (val);
+
+    val = purc_variant_make_string_static (type_of_dirent (entry->d_type),
+            false);
+    purc_variant_object_set_by_static_ckey (obj_var, "type", val);
+    purc_variant_unref (val);
+
+    val = purc_variant_make_ulongint (entry->ino);
+    purc_variant_object_set_by_static_ckey (obj_var, "inode", val);
+    purc_variant_unref (val);
+
+    if (!with_stat || !entry->stat_ok)
+        return obj_var;
+
+    static const char *keys[] = {
+        "mode", "nlink", "uid", "gid", "size", "blocks",
+        "atime", "mtime", "ctime",
+    };
+    const struct stat *st = &entry->st;
+    double values[] = {
+        st->st_mode, st->st_nlink, st->st_uid, st->st_gid, st->st_size,
+        st->st_blocks, st->st_atime, st->st_mtime, st->st_ctime,
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(keys); i++) {
+        val = purc_variant_make_number (values[i]);
+        purc_variant_object_set_by_static_ckey (obj_var, keys[i], val);
+        purc_variant_unref (val);
+    }
+
+    return obj_var;
+}
+
+/*
+ * $dir.read_batch([<real $count = 256>[, <string $filter>[,
+ *      <boolean $with_stat = false>]]])
+ *
+ * Returns an array of at most @count entries as objects with `name`,
+ * `type`, and `inode`, or false if there is no more entry. The type comes
+ * from the directory entry, so the entries are not stat'ed unless
+ * @with_stat is true (the link itself is stat'ed for a symbolic link).
+ * If the directory is opened in the recursive mode, the names are
+ * relative to it, and the subdirectories are walked in depth-first order
+ * whether they match @filter or not.
+ */
+static purc_variant_t
+dir_read_batch_getter (purc_variant_t root, size_t nr_args,
+        purc_variant_t *argv, bool silently)
+{
+    UNUSED_PARAM(silently);
+
+    struct pcdvobjs_dir_stream *dir_stream;
+    struct name_filter *filter = NULL;
+    struct dir_batch_entry *entries = NULL;
+    size_t nr_entries = 0;
+    uint64_t count = DEF_DIR_BATCH_SIZE;
+    bool with_stat = false;
+    purc_variant_t dir_var;
+    purc_variant_t ret_var = PURC_VARIANT_INVALID;
+
+    dir_var = purc_variant_object_get_by_ckey(root, CKEY_DIR);
+    if (dir_var == PURC_VARIANT_INVALID) {
+        purc_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+        return PURC_VARIANT_INVALID;
+    }
+
+    dir_stream = (struct pcdvobjs_dir_stream *)(dir_var->ptr_ptr[0]);
+    if (NULL == dir_stream || NULL == dir_stream->dirp) {
+        return PURC_VARIANT_INVALID;
+    }
+
+    if (nr_args > 0 && !purc_variant_is_null (argv[0])) {
+        if (!purc_variant_cast_to_ulongint (argv[0], &count, false)) {
+            purc_set_error (PURC_ERROR_WRONG_DATA_TYPE);
+            return PURC_VARIANT_INVALID;
+        }
+        if (count == 0 || count > MAX_DIR_BATCH_SIZE) {
+            purc_set_error (PURC_ERROR_INVALID_VALUE);
+            return PURC_VARIANT_INVALID;
+        }
+    }
+
+    if (nr_args > 1 && !purc_variant_is_null (argv[1])) {
+        const char *string_filter = purc_variant_get_string_const (argv[1]);
+        if (string_filter == NULL) {
+            purc_set_error (PURC_ERROR_WRONG_DATA_TYPE);
+            return PURC_VARIANT_INVALID;
+        }
+
+        filter = name_filter_new (string_filter);
+        if (filter == NULL)
+            return PURC_VARIANT_INVALID;
+    }
+
+    if (nr_args > 2)
+        with_stat = purc_variant_booleanize (argv[2]);
+
+    entries = calloc (count, sizeof(*entries));
+    if (entries == NULL) {
+        purc_set_error (PURC_ERROR_OUT_OF_MEMORY);
+        goto done;
+    }
+
+    while (nr_entries < count) {
+        struct dir_level *top = dir_stream->levels +
+            dir_stream->nr_levels - 1;
+        struct dirent *dp = readdir (top->dirp);
+
+        if (dp == NULL) {
+            if (dir_stream->nr_levels == 1)
+                break;
+
+            closedir (top->dirp);
+            dir_stream->nr_levels--;
+            continue;
+        }
+
+        if (strcmp (dp->d_name, ".") == 0 || strcmp (dp->d_name, "..") == 0)
+            continue;
+
+        bool matched = name_filter_match (filter, dp->d_name);
+        if (!matched && !dir_stream->recursive)
+            continue;
+
+        size_t name_len = strlen (dp->d_name);
+        if (top->prefix_len + name_len >= sizeof(dir_stream->relpath))
+            continue;
+
+        struct dir_batch_entry *entry = entries + nr_entries;
+        entry->path = malloc (top->prefix_len + name_len + 1);
+        if (entry->path == NULL) {
+            purc_set_error (PURC_ERROR_OUT_OF_MEMORY);
+            goto done;
+        }
+        memcpy (entry->path, dir_stream->relpath, top->prefix_len);
+        memcpy (entry->path + top->prefix_len, dp->d_name, name_len + 1);
+        entry->ino = dp->d_ino;
+        entry->d_type = dp->d_type;
+
+        /* stat only if the file system does not tell the type */
+        if (entry->d_type == DT_UNKNOWN) {
+            entry->stat_ok = fstatat (dirfd (top->dirp), dp->d_name,
+                    &entry->st, AT_SYMLINK_NOFOLLOW) == 0;
+            if (entry->stat_ok)
+                entry->d_type = dirent_type_of_mode (entry->st.st_mode);
+        }
+
+        bool is_dir = (entry->d_type == DT_DIR);
+        if (matched) {
+            nr_entries++;
+        }
+
+        /* `top` is not valid any more after pushing a level */
+        if (dir_stream->recursive && is_dir)
+            dir_stream_push_level (dir_stream, entry->path);
+
+        if (!matched) {
+            free (entry->path);
+            memset (entry, 0, sizeof(*entry));
+        }
+    }
+
+    if (nr_entries == 0) {
+        ret_var = purc_variant_make_boolean (false);
+        goto done;
+    }
+
+    if (with_stat)
+        stat_batch (dir_stream, entries, nr_entries);
+
+    ret_var = purc_variant_make_array (0, PURC_VARIANT_INVALID);
+    if (ret_var == PURC_VARIANT_INVALID)
+        goto done;
+
+    for (size_t i = 0; i < nr_entries; i++) {
+        purc_variant_t obj_var = make_batch_entry (entries + i, with_stat);
+        if (obj_var == PURC_VARIANT_INVALID) {
+            purc_variant_unref (ret_var);
+            ret_var = PURC_VARIANT_INVALID;
+            goto done;
+        }
+
+        purc_variant_array_append (ret_var, obj_var);
+        purc_variant_unref (obj_var);
+    }
+
+done:
+    if (entries) {
+        for (size_t i = 0; i < nr_entries; i++)
+            free (entries[i].path);
+        free (entries);
+    }
+    if (filter)
+        name_filter_delete (filter);
+    return ret_var;
+}
+
 static bool add_dir_native(purc_variant_t v, DIR *dirp,
-        const char *string_pathname)
+        const char *string_pathname, bool recursive, bool parallel)
 {
     struct pcdvobjs_dir_stream *dir_stream = calloc(1,
             sizeof(struct pcdvobjs_dir_stream));
     dir_stream->dirp = dirp;
     strncpy(dir_stream->dirpath, string_pathname, sizeof(dir_stream->dirpath)-1);
+    dir_stream->levels[0].dirp = dirp;
+    dir_stream->levels[0].prefix_len = 0;
+    dir_stream->nr_levels = 1;
+    dir_stream->recursive = recursive;
+    dir_stream->parallel = parallel;
 
     purc_variant_t var = purc_variant_make_native((void *)dir_stream, NULL);
     if (var == PURC_VARIANT_INVALID) {
@@ -3134,6 +3554,32 @@ opendir_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
     if (stat (string_pathname, &dir_stat) < 0)
         return purc_variant_make_boolean (false);
 
+    // get the options: `recursive` and/or `parallel`
+    bool recursive = false, parallel = false;
+    if (nr_args > 1) {
+        const char *options = purc_variant_get_string_const (argv[1]);
+        if (options == NULL) {
+            purc_set_error (PURC_ERROR_WRONG_DATA_TYPE);
+            return PURC_VARIANT_INVALID;
+        }
+
+        size_t length = 0;
+        const char *head = pcutils_get_next_token (options, " \t", &length);
+        while (head) {
+            if (length == sizeof("recursive") - 1 &&
+                    pcutils_strncasecmp (head, "recursive", length) == 0)
+                recursive = true;
+            else if (length == sizeof("parallel") - 1 &&
+                    pcutils_strncasecmp (head, "parallel", length) == 0)
+                parallel = true;
+            else {
+                purc_set_error (PURC_ERROR_INVALID_VALUE);
+                return PURC_VARIANT_INVALID;
+            }
+            head = pcutils_get_next_token (head + length, " \t", &length);
+        }
+    }
+
     if (S_ISDIR(dir_stat.st_mode)) {
         dirp = opendir (string_pathname);
     }
@@ -3141,9 +3587,13 @@ opendir_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         return purc_variant_make_boolean (false);
     }
 
+    if (dirp == NULL)
+        return purc_variant_make_boolean (false);
+
     static struct purc_dvobj_method dirStream[] = {
-        {"read",    dir_read_getter,      NULL},
-        {"rewind",  dir_rewind_getter,    NULL},
+        {"read",        dir_read_getter,        NULL},
+        {"read_batch",  dir_read_batch_getter,  NULL},
+        {"rewind",      dir_rewind_getter,      NULL},
     };
 
     ret_var = purc_dvobj_make_from_methods(dirStream,
@@ -3152,7 +3602,7 @@ opendir_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         return PURC_VARIANT_INVALID;
     }
 
-    if (add_dir_native(ret_var, dirp, string_pathname)) {
+    if (add_dir_native(ret_var, dirp, string_pathname, recursive, parallel)) {
         return ret_var;
     }
 
@@ -3192,6 +3642,7 @@ closedir_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         return PURC_VARIANT_INVALID;
     }
 
+    dir_stream_pop_levels (dir_stream);
     if (0 == closedir(dirp))
         ret_var = purc_variant_make_boolean (true);
     else
@@ -1484,20 +1484,25 @@ internal_eval_getter (int is_long_double, purc_variant_t root,
 
     purc_variant_t param = nr_args >=2 ? argv[1] : PURC_VARIANT_INVALID;
 
+    /* the expression is parsed only if not in the cache */
+    struct math_program *program = math_program_get(input);
+    if (program == NULL)
+        return PURC_VARIANT_INVALID;
+
+    purc_variant_t ret_var = PURC_VARIANT_INVALID;
     if (!is_long_double) {
         double v = 0;
-        int r = math_eval(input, &v, param);
-        if (r)
-            return PURC_VARIANT_INVALID;
-        return purc_variant_make_number(v);
+        if (math_eval_expr(program->expr, &v, param) == 0)
+            ret_var = purc_variant_make_number(v);
     }
     else {
         long double v = 0;
-        int r = math_eval_l(input, &v, param);
-        if (r)
-            return PURC_VARIANT_INVALID;
-        return purc_variant_make_longdouble(v);
+        if (math_eval_expr_l(program->expr_l, &v, param) == 0)
+            ret_var = purc_variant_make_longdouble(v);
     }
+
+    math_program_unref(program);
+    return ret_var;
 }
 
 static purc_variant_t
@@ -1543,6 +1548,8 @@ static void map_free_val(void *val)
 
 void __attribute__ ((destructor)) math_fini(void)
 {
+    math_program_cache_term();
+
     if (const_map) {
         pcutils_map_destroy (const_map);
         const_map = NULL;
@@ -1619,6 +1626,7 @@ static purc_variant_t pcdvobjs_create_math (void)
         {"const_l", const_l_getter, NULL},
         {"eval",    eval_getter, NULL},
         {"eval_l",  eval_l_getter, NULL},
+        {"compile", math_compile_getter, NULL},
         {"sin",     sin_getter, NULL},
         {"sin_l",   sin_l_getter, NULL},
         {"cos",     cos_getter, NULL},
@@ -1664,9 +1672,35 @@ static purc_variant_t pcdvobjs_create_math (void)
         {"sub",     sub_getter, NULL},
         {"mul",     mul_getter, NULL},
         {"div",     div_getter, NULL},
+        {"map",     math_map_getter, NULL},
+        {"sum",     math_sum_getter, NULL},
+        {"avg",     math_avg_getter, NULL},
+        {"min",     math_min_getter, NULL},
+        {"max",     math_max_getter, NULL},
+        {"dot",     math_dot_getter, NULL},
+    };
+
+    /* the constants and eval depend on the constants set by users */
+    static const char *pure_methods[] = {
+        "sin", "sin_l", "cos", "cos_l", "tan", "tan_l",
+        "sinh", "sinh_l", "cosh", "cosh_l", "tanh", "tanh_l",
+        "asin", "asin_l", "acos", "acos_l", "atan", "atan_l",
+        "asinh", "asinh_l", "acosh", "acosh_l", "atanh", "atanh_l",
+        "sqrt", "sqrt_l", "fmod", "fmod_l", "fabs",
+        "log", "log_l", "log10", "log10_l", "pow", "pow_l", "exp", "exp_l",
+        "floor", "floor_l", "ceil", "ceil_l",
+        "add", "sub", "mul", "div",
+        "map", "sum", "avg", "min", "max", "dot",
     };
 
-    return purc_dvobj_make_from_methods (method, PCA_TABLESIZE(method));
+    purc_variant_t retv;
+    retv = purc_dvobj_make_from_methods (method, PCA_TABLESIZE(method));
+    if (retv != PURC_VARIANT_INVALID) {
+        purc_dvobj_set_pure_methods (retv, pure_methods,
+                PCA_TABLESIZE(pure_methods));
+    }
+
+    return retv;
 }
 
 purc_variant_t __purcex_load_dynamic_variant (const char *name, int *ver_code)
@@ -1701,7 +1735,7 @@ const char * __purcex_get_dynamic_variant_desc (size_t idx)
     return MATH_DESCRIPTION;
 }
 
-static int post_check(void)
+int math_post_check(void)
 {
     int flags = FE_INVALID | FE_DIVBYZERO | FE_OVERFLOW | FE_UNDERFLOW;
     int x = fetestexcept(flags);
@@ -1727,7 +1761,7 @@ math_voi(double *r, double (*f)(void))
 
     *r = f();
 
-    return post_check();
+    return math_post_check();
 }
 
 int
@@ -1737,7 +1771,7 @@ math_voi_l(long double *r, long double (*f)(void))
 
     *r = f();
 
-    return post_check();
+    return math_post_check();
 }
 
 int
@@ -1747,7 +1781,7 @@ math_uni(double *r, double (*f)(double a), double a)
 
     *r = f(a);
 
-    return post_check();
+    return math_post_check();
 }
 
 int
@@ -1757,7 +1791,7 @@ math_uni_l(long double *r, long double (*f)(long double a), long double a)
 
     *r = f(a);
 
-    return post_check();
+    return math_post_check();
 }
 
 int
@@ -1767,7 +1801,7 @@ math_bin(double *r, double (*f)(double a, double b), double a, double b)
 
     *r = f(a, b);
 
-    return post_check();
+    return math_post_check();
 }
 
 int
@@ -1778,7 +1812,7 @@ math_bin_l(long double *r, long double (*f)(long double a, long double b),
 
     *r = f(a, b);
 
-    return post_check();
+    return math_post_check();
 }
 
 double
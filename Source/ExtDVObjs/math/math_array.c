@@ -0,0 +1,458 @@
+/*
+ * @file math_array.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The methods of MATH operating on arrays of numbers.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "purc-errors.h"
+#include "purc-variant.h"
+#include "purc-utils.h"
+
+#include "mathlib.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fenv.h>
+
+#define UNUSED_PARAM (void)
+
+/*
+ * The members of a linear container are unboxed once into a contiguous
+ * vector of doubles, and the operations run as plain loops over the vector,
+ * which the compiler turns into SIMD code where the operation allows.
+ * The sums use several independent accumulators for the same reason.
+ */
+
+#define NR_ACCUMULATORS     4
+
+/* Unboxes the numeric members of @container; returns NULL on error. */
+static double *unbox_numbers(purc_variant_t container, size_t *nr)
+{
+    size_t sz;
+
+    if (container == PURC_VARIANT_INVALID ||
+            !purc_variant_linear_container_size(container, &sz)) {
+        purc_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+        return NULL;
+    }
+
+    double *v = malloc(sizeof(double) * (sz ? sz : 1));
+    if (v == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < sz; i++) {
+        purc_variant_t m = purc_variant_linear_container_get(container, i);
+        if (!purc_variant_is_number(m) && !purc_variant_is_longint(m) &&
+                !purc_variant_is_ulongint(m) &&
+                !purc_variant_is_longdouble(m)) {
+            free(v);
+            purc_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+            return NULL;
+        }
+        purc_variant_cast_to_number(m, v + i, false);
+    }
+
+    *nr = sz;
+    return v;
+}
+
+static purc_variant_t make_number_array(const double *v, size_t nr)
+{
+    purc_variant_t arr = purc_variant_make_array_0();
+    if (arr == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    for (size_t i = 0; i < nr; i++) {
+        purc_variant_t num = purc_variant_make_number(v[i]);
+        if (num == PURC_VARIANT_INVALID ||
+                !purc_variant_array_append(arr, num)) {
+            if (num)
+                purc_variant_unref(num);
+            purc_variant_unref(arr);
+            return PURC_VARIANT_INVALID;
+        }
+        purc_variant_unref(num);
+    }
+
+    return arr;
+}
+
+#define UNARY_KERNEL(fn)                                                \
+static void fn##_kernel(double *restrict v, size_t n, double arg)       \
+{                                                                       \
+    UNUSED_PARAM(arg);                                                  \
+    for (size_t i = 0; i < n; i++)                                      \
+        v[i] = fn(v[i]);                                                \
+}
+
+#define BINARY_KERNEL(fn)                                               \
+static void fn##_kernel(double *restrict v, size_t n, double arg)       \
+{                                                                       \
+    for (size_t i = 0; i < n; i++)                                      \
+        v[i] = fn(v[i], arg);                                           \
+}
+
+UNARY_KERNEL(sin)
+UNARY_KERNEL(cos)
+UNARY_KERNEL(tan)
+UNARY_KERNEL(sinh)
+UNARY_KERNEL(cosh)
+UNARY_KERNEL(tanh)
+UNARY_KERNEL(asin)
+UNARY_KERNEL(acos)
+UNARY_KERNEL(atan)
+UNARY_KERNEL(asinh)
+UNARY_KERNEL(acosh)
+UNARY_KERNEL(atanh)
+UNARY_KERNEL(sqrt)
+UNARY_KERNEL(fabs)
+UNARY_KERNEL(log)
+UNARY_KERNEL(log10)
+UNARY_KERNEL(exp)
+UNARY_KERNEL(floor)
+UNARY_KERNEL(ceil)
+BINARY_KERNEL(pow)
+BINARY_KERNEL(fmod)
+
+static void add_kernel(double *restrict v, size_t n, double arg)
+{
+    for (size_t i = 0; i < n; i++)
+        v[i] += arg;
+}
+
+static void sub_kernel(double *restrict v, size_t n, double arg)
+{
+    for (size_t i = 0; i < n; i++)
+        v[i] -= arg;
+}
+
+static void mul_kernel(double *restrict v, size_t n, double arg)
+{
+    for (size_t i = 0; i < n; i++)
+        v[i] *= arg;
+}
+
+static void div_kernel(double *restrict v, size_t n, double arg)
+{
+    for (size_t i = 0; i < n; i++)
+        v[i] /= arg;
+}
+
+typedef void (*map_kernel)(double *restrict v, size_t n, double arg);
+
+static const struct map_op {
+    const char *name;
+    map_kernel  kernel;
+    bool        binary;
+} map_ops[] = {
+    { "sin",    sin_kernel,     false },
+    { "cos",    cos_kernel,     false },
+    { "tan",    tan_kernel,     false },
+    { "sinh",   sinh_kernel,    false },
+    { "cosh",   cosh_kernel,    false },
+    { "tanh",   tanh_kernel,    false },
+    { "asin",   asin_kernel,    false },
+    { "acos",   acos_kernel,    false },
+    { "atan",   atan_kernel,    false },
+    { "asinh",  asinh_kernel,   false },
+    { "acosh",  acosh_kernel,   false },
+    { "atanh",  atanh_kernel,   false },
+    { "sqrt",   sqrt_kernel,    false },
+    { "fabs",   fabs_kernel,    false },
+    { "log",    log_kernel,     false },
+    { "log10",  log10_kernel,   false },
+    { "exp",    exp_kernel,     false },
+    { "floor",  floor_kernel,   false },
+    { "ceil",   ceil_kernel,    false },
+    { "pow",    pow_kernel,     true },
+    { "fmod",   fmod_kernel,    true },
+    { "add",    add_kernel,     true },
+    { "sub",    sub_kernel,     true },
+    { "mul",    mul_kernel,     true },
+    { "div",    div_kernel,     true },
+};
+
+static const struct map_op *find_map_op(const char *name)
+{
+    for (size_t i = 0; i < PCA_TABLESIZE(map_ops); i++) {
+        if (strcmp(map_ops[i].name, name) == 0)
+            return map_ops + i;
+    }
+
+    return NULL;
+}
+
+/* Fails like the scalar methods if any result is NaN or an exception
+   has been raised. */
+static int check_results(const double *v, size_t n)
+{
+    bool has_nan = false;
+    for (size_t i = 0; i < n; i++)
+        has_nan |= isnan(v[i]);
+
+    if (has_nan) {
+        purc_set_error(PURC_ERROR_INVALID_FLOAT);
+        return -1;
+    }
+
+    return math_post_check();
+}
+
+/*
+ * $MATH.map(<string: function>, <array | tuple: numbers>
+ *      [, <number: operand>])
+ *
+ * Applies the function to every member and returns a new array; the
+ * binary functions (`pow`, `fmod`, `add`, `sub`, `mul`, and `div`) take
+ * the operand as the second argument.
+ */
+purc_variant_t
+math_map_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+{
+    UNUSED_PARAM(root);
+    UNUSED_PARAM(silently);
+
+    if (nr_args < 2) {
+        purc_set_error(PURC_ERROR_ARGUMENT_MISSED);
+        return PURC_VARIANT_INVALID;
+    }
+
+    const char *name = purc_variant_get_string_const(argv[0]);
+    if (name == NULL) {
+        purc_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+        return PURC_VARIANT_INVALID;
+    }
+
+    const struct map_op *op = find_map_op(name);
+    if (op == NULL) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return PURC_VARIANT_INVALID;
+    }
+
+    double operand = 0.0;
+    if (op->binary) {
+        if (nr_args < 3) {
+            purc_set_error(PURC_ERROR_ARGUMENT_MISSED);
+            return PURC_VARIANT_INVALID;
+        }
+        if (!purc_variant_cast_to_number(argv[2], &operand, false)) {
+            purc_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+            return PURC_VARIANT_INVALID;
+        }
+    }
+
+    size_t nr;
+    double *v = unbox_numbers(argv[1], &nr);
+    if (v == NULL)
+        return PURC_VARIANT_INVALID;
+
+    purc_variant_t ret_var = PURC_VARIANT_INVALID;
+    feclearexcept(FE_ALL_EXCEPT);
+    op->kernel(v, nr, operand);
+    if (check_results(v, nr) == 0)
+        ret_var = make_number_array(v, nr);
+
+    free(v);
+    return ret_var;
+}
+
+static double sum_kernel(const double *restrict v, size_t n)
+{
+    double acc[NR_ACCUMULATORS] = { 0.0 };
+    size_t i = 0;
+
+    for (; i + NR_ACCUMULATORS <= n; i += NR_ACCUMULATORS) {
+        for (size_t j = 0; j < NR_ACCUMULATORS; j++)
+            acc[j] += v[i + j];
+    }
+    for (; i < n; i++)
+        acc[0] += v[i];
+
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+static double dot_kernel(const double *restrict a, const double *restrict b,
+        size_t n)
+{
+    double acc[NR_ACCUMULATORS] = { 0.0 };
+    size_t i = 0;
+
+    for (; i + NR_ACCUMULATORS <= n; i += NR_ACCUMULATORS) {
+        for (size_t j = 0; j < NR_ACCUMULATORS; j++)
+            acc[j] += a[i + j] * b[i + j];
+    }
+    for (; i < n; i++)
+        acc[0] += a[i] * b[i];
+
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+static double min_kernel(const double *restrict v, size_t n)
+{
+    double r = v[0];
+    for (size_t i = 1; i < n; i++)
+        r = (v[i] < r) ? v[i] : r;
+    return r;
+}
+
+static double max_kernel(const double *restrict v, size_t n)
+{
+    double r = v[0];
+    for (size_t i = 1; i < n; i++)
+        r = (v[i] > r) ? v[i] : r;
+    return r;
+}
+
+enum reduce_op {
+    REDUCE_SUM,
+    REDUCE_AVG,
+    REDUCE_MIN,
+    REDUCE_MAX,
+};
+
+static purc_variant_t
+reduce(size_t nr_args, purc_variant_t *argv, enum reduce_op op)
+{
+    if (nr_args < 1) {
+        purc_set_error(PURC_ERROR_ARGUMENT_MISSED);
+        return PURC_VARIANT_INVALID;
+    }
+
+    size_t nr;
+    double *v = unbox_numbers(argv[0], &nr);
+    if (v == NULL)
+        return PURC_VARIANT_INVALID;
+
+    purc_variant_t ret_var = PURC_VARIANT_INVALID;
+    if (nr == 0 && op != REDUCE_SUM) {
+        /* no average nor extremum of nothing */
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        goto done;
+    }
+
+    double r = 0.0;
+    feclearexcept(FE_ALL_EXCEPT);
+    switch (op) {
+    case REDUCE_SUM:
+        r = sum_kernel(v, nr);
+        break;
+    case REDUCE_AVG:
+        r = sum_kernel(v, nr) / nr;
+        break;
+    case REDUCE_MIN:
+        r = min_kernel(v, nr);
+        break;
+    case REDUCE_MAX:
+        r = max_kernel(v, nr);
+        break;
+    }
+
+    if (check_results(&r, 1) == 0)
+        ret_var = purc_variant_make_number(r);
+
+done:
+    free(v);
+    return ret_var;
+}
+
+/* $MATH.sum(<array | tuple: numbers>) */
+purc_variant_t
+math_sum_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+{
+    UNUSED_PARAM(root);
+    UNUSED_PARAM(silently);
+    return reduce(nr_args, argv, REDUCE_SUM);
+}
+
+/* $MATH.avg(<array | tuple: numbers>) */
+purc_variant_t
+math_avg_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+{
+    UNUSED_PARAM(root);
+    UNUSED_PARAM(silently);
+    return reduce(nr_args, argv, REDUCE_AVG);
+}
+
+/* $MATH.min(<array | tuple: numbers>) */
+purc_variant_t
+math_min_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+{
+    UNUSED_PARAM(root);
+    UNUSED_PARAM(silently);
+    return reduce(nr_args, argv, REDUCE_MIN);
+}
+
+/* $MATH.max(<array | tuple: numbers>) */
+purc_variant_t
+math_max_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+{
+    UNUSED_PARAM(root);
+    UNUSED_PARAM(silently);
+    return reduce(nr_args, argv, REDUCE_MAX);
+}
+
+/* $MATH.dot(<array | tuple: numbers>, <array | tuple: numbers>) */
+purc_variant_t
+math_dot_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+{
+    UNUSED_PARAM(root);
+    UNUSED_PARAM(silently);
+
+    if (nr_args < 2) {
+        purc_set_error(PURC_ERROR_ARGUMENT_MISSED);
+        return PURC_VARIANT_INVALID;
+    }
+
+    size_t nr_a, nr_b;
+    double *a = unbox_numbers(argv[0], &nr_a);
+    if (a == NULL)
+        return PURC_VARIANT_INVALID;
+
+    double *b = unbox_numbers(argv[1], &nr_b);
+    if (b == NULL) {
+        free(a);
+        return PURC_VARIANT_INVALID;
+    }
+
+    purc_variant_t ret_var = PURC_VARIANT_INVALID;
+    if (nr_a != nr_b) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+    }
+    else {
+        feclearexcept(FE_ALL_EXCEPT);
+        double r = dot_kernel(a, b, nr_a);
+        if (check_results(&r, 1) == 0)
+            ret_var = purc_variant_make_number(r);
+    }
+
+    free(a);
+    free(b);
+    return ret_var;
+}
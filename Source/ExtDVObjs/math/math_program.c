@@ -0,0 +1,272 @@
+/*
+ * @file math_program.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The cache of the compiled expressions of MATH.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "purc-errors.h"
+#include "purc-variant.h"
+#include "purc-utils.h"
+
+#include "mathlib.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define UNUSED_PARAM (void)
+
+/*
+ * $MATH.eval() and $MATH.eval_l() look the expression up in a small LRU
+ * cache of compiled programs before parsing it, so a formula evaluated
+ * again with other parameters is parsed only once. The cache is shared by
+ * all instances in the process (the library may be unloaded by any of
+ * them), so it is protected by a mutex; a program is reference counted
+ * because it may be evicted while being evaluated.
+ */
+
+#define NR_CACHED_PROGRAMS      64
+
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* the most recently used one comes first */
+static struct math_program *cached_programs[NR_CACHED_PROGRAMS];
+static size_t nr_cached_programs;
+
+/* FNV-1a */
+static unsigned hash_source(const char *source)
+{
+    unsigned hash = 2166136261u;
+    while (*source) {
+        hash ^= (unsigned char)*source++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void free_program(struct math_program *program)
+{
+    if (program->expr)
+        math_free_expr(program->expr);
+    if (program->expr_l)
+        math_free_expr_l(program->expr_l);
+    free(program->source);
+    free(program);
+}
+
+static struct math_program *compile_program(const char *source, unsigned hash)
+{
+    struct math_program *program = calloc(1, sizeof(*program));
+    if (program == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    program->refc = 1;
+    program->hash = hash;
+    program->source = strdup(source);
+    if (program->source == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto failed;
+    }
+
+    program->expr = math_compile(source);
+    if (program->expr == NULL)
+        goto failed;
+
+    program->expr_l = math_compile_l(source);
+    if (program->expr_l == NULL)
+        goto failed;
+
+    return program;
+
+failed:
+    free_program(program);
+    return NULL;
+}
+
+/* call with cache_lock held */
+static void unref_program_nolock(struct math_program *program)
+{
+    if (--program->refc == 0)
+        free_program(program);
+}
+
+struct math_program *math_program_get(const char *source)
+{
+    unsigned hash = hash_source(source);
+    struct math_program *program = NULL;
+
+    pthread_mutex_lock(&cache_lock);
+    for (size_t i = 0; i < nr_cached_programs; i++) {
+        struct math_program *p = cached_programs[i];
+        if (p->hash == hash && strcmp(p->source, source) == 0) {
+            memmove(cached_programs + 1, cached_programs,
+                    sizeof(cached_programs[0]) * i);
+            cached_programs[0] = p;
+            program = p;
+            program->refc++;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&cache_lock);
+
+    if (program)
+        return program;
+
+    /* compile without the lock held */
+    program = compile_program(source, hash);
+    if (program == NULL)
+        return NULL;
+
+    pthread_mutex_lock(&cache_lock);
+    if (nr_cached_programs == NR_CACHED_PROGRAMS) {
+        unref_program_nolock(cached_programs[--nr_cached_programs]);
+    }
+    memmove(cached_programs + 1, cached_programs,
+            sizeof(cached_programs[0]) * nr_cached_programs);
+    cached_programs[0] = program;
+    nr_cached_programs++;
+    program->refc++;
+    pthread_mutex_unlock(&cache_lock);
+
+    return program;
+}
+
+void math_program_unref(struct math_program *program)
+{
+    pthread_mutex_lock(&cache_lock);
+    unref_program_nolock(program);
+    pthread_mutex_unlock(&cache_lock);
+}
+
+void math_program_cache_term(void)
+{
+    pthread_mutex_lock(&cache_lock);
+    for (size_t i = 0; i < nr_cached_programs; i++)
+        unref_program_nolock(cached_programs[i]);
+    nr_cached_programs = 0;
+    pthread_mutex_unlock(&cache_lock);
+}
+
+static bool check_param(size_t nr_args, purc_variant_t *argv)
+{
+    if (nr_args > 0 && (argv[0] == PURC_VARIANT_INVALID ||
+                !purc_variant_is_object(argv[0]))) {
+        purc_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+        return false;
+    }
+
+    return true;
+}
+
+/* $MATH.compile(...).eval([<object: parameters>]) */
+static purc_variant_t
+program_eval_getter(void *native_entity, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+{
+    UNUSED_PARAM(silently);
+
+    struct math_program *program = native_entity;
+    if (!check_param(nr_args, argv))
+        return PURC_VARIANT_INVALID;
+
+    double v = 0;
+    if (math_eval_expr(program->expr, &v,
+                nr_args > 0 ? argv[0] : PURC_VARIANT_INVALID))
+        return PURC_VARIANT_INVALID;
+
+    return purc_variant_make_number(v);
+}
+
+/* $MATH.compile(...).eval_l([<object: parameters>]) */
+static purc_variant_t
+program_eval_l_getter(void *native_entity, size_t nr_args,
+        purc_variant_t *argv, bool silently)
+{
+    UNUSED_PARAM(silently);
+
+    struct math_program *program = native_entity;
+    if (!check_param(nr_args, argv))
+        return PURC_VARIANT_INVALID;
+
+    long double v = 0;
+    if (math_eval_expr_l(program->expr_l, &v,
+                nr_args > 0 ? argv[0] : PURC_VARIANT_INVALID))
+        return PURC_VARIANT_INVALID;
+
+    return purc_variant_make_longdouble(v);
+}
+
+static purc_nvariant_method program_property_getter(const char *name)
+{
+    if (strcmp(name, "eval") == 0)
+        return program_eval_getter;
+    else if (strcmp(name, "eval_l") == 0)
+        return program_eval_l_getter;
+
+    return NULL;
+}
+
+static void program_on_release(void *native_entity)
+{
+    math_program_unref(native_entity);
+}
+
+/*
+ * $MATH.compile(<string: expression>)
+ *
+ * Returns a native entity which evaluates the compiled expression by
+ * its `eval` and `eval_l` methods with the parameters given then.
+ */
+purc_variant_t
+math_compile_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+{
+    UNUSED_PARAM(root);
+    UNUSED_PARAM(silently);
+
+    static const struct purc_native_ops ops = {
+        .property_getter = program_property_getter,
+        .on_release = program_on_release,
+    };
+
+    if (nr_args < 1) {
+        purc_set_error(PURC_ERROR_ARGUMENT_MISSED);
+        return PURC_VARIANT_INVALID;
+    }
+
+    const char *source = purc_variant_get_string_const(argv[0]);
+    if (source == NULL) {
+        purc_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+        return PURC_VARIANT_INVALID;
+    }
+
+    struct math_program *program = math_program_get(source);
+    if (program == NULL)
+        return PURC_VARIANT_INVALID;
+
+    purc_variant_t ret_var = purc_variant_make_native(program, &ops);
+    if (ret_var == PURC_VARIANT_INVALID)
+        math_program_unref(program);
+
+    return ret_var;
+}
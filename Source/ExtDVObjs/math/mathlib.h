@@ -46,6 +46,43 @@ enum math_pre_defined_var {
 
 typedef purc_variant_t (*pcdvobjs_create) (void);
 
+/* Sets the error according to the floating-point exceptions raised;
+   returns -1 if there is any. */
+int
+math_post_check(void)
+__attribute__((visibility("hidden")));
+
+/* The methods operating on arrays of numbers; see math_array.c */
+purc_variant_t
+math_map_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+__attribute__((visibility("hidden")));
+
+purc_variant_t
+math_sum_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+__attribute__((visibility("hidden")));
+
+purc_variant_t
+math_avg_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+__attribute__((visibility("hidden")));
+
+purc_variant_t
+math_min_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+__attribute__((visibility("hidden")));
+
+purc_variant_t
+math_max_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+__attribute__((visibility("hidden")));
+
+purc_variant_t
+math_dot_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+__attribute__((visibility("hidden")));
+
 int
 math_eval(const char *input, double *d, purc_variant_t param)
 __attribute__((visibility("hidden")));
@@ -54,6 +91,66 @@ int
 math_eval_l(const char *input, long double *d, purc_variant_t param)
 __attribute__((visibility("hidden")));
 
+/* The expressions compiled by the parsers; see parsers/math.y */
+struct math_expr;
+struct math_expr_l;
+
+struct math_expr *
+math_compile(const char *input)
+__attribute__((visibility("hidden")));
+
+struct math_expr_l *
+math_compile_l(const char *input)
+__attribute__((visibility("hidden")));
+
+int
+math_eval_expr(const struct math_expr *expr, double *d, purc_variant_t param)
+__attribute__((visibility("hidden")));
+
+int
+math_eval_expr_l(const struct math_expr_l *expr, long double *d,
+        purc_variant_t param)
+__attribute__((visibility("hidden")));
+
+void
+math_free_expr(struct math_expr *expr)
+__attribute__((visibility("hidden")));
+
+void
+math_free_expr_l(struct math_expr_l *expr)
+__attribute__((visibility("hidden")));
+
+/* An expression compiled for both double and long double, shared by the
+   cache and the native entities returned by $MATH.compile(); see
+   math_program.c */
+struct math_program {
+    unsigned            refc;
+    unsigned            hash;
+    char               *source;
+    struct math_expr   *expr;
+    struct math_expr_l *expr_l;
+};
+
+/* Returns the program of @source from the cache, compiling it if missed;
+   the caller owns a reference. */
+struct math_program *
+math_program_get(const char *source)
+__attribute__((visibility("hidden")));
+
+void
+math_program_unref(struct math_program *program)
+__attribute__((visibility("hidden")));
+
+/* Empties the cache; called when the library is unloaded. */
+void
+math_program_cache_term(void)
+__attribute__((visibility("hidden")));
+
+purc_variant_t
+math_compile_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+__attribute__((visibility("hidden")));
+
 int
 math_voi(double *r, double (*f)(void))
 __attribute__((visibility("hidden")));
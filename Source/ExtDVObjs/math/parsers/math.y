@@ -38,6 +38,10 @@
 
         #define VALUE_TYPE     double
         #define FUNC_NAME      math_eval
+        #define EXPR_STRUCT    math_expr
+        #define COMPILE_NAME   math_compile
+        #define EVAL_NAME      math_eval_expr
+        #define FREE_NAME      math_free_expr
 
         #define STRTOD         strtod
         #define CAST_TO_NUMBER purc_variant_cast_to_number
@@ -89,6 +93,10 @@
 
         #define VALUE_TYPE     long double
         #define FUNC_NAME      math_eval_l
+        #define EXPR_STRUCT    math_expr_l
+        #define COMPILE_NAME   math_compile_l
+        #define EVAL_NAME      math_eval_expr_l
+        #define FREE_NAME      math_free_expr_l
 
         #define STRTOD         strtold
         #define CAST_TO_NUMBER purc_variant_cast_to_longdouble
@@ -136,15 +144,43 @@
 
     #endif
 
-    struct internal_value {
-        VALUE_TYPE      d;
+    /* The nodes of the expression tree compiled from the expression. */
+    enum math_node_type {
+        MATH_NODE_NUMBER,
+        MATH_NODE_VAR,
+        MATH_NODE_PRE_DEFINED,
+        MATH_NODE_NEG,
+        MATH_NODE_ADD,
+        MATH_NODE_SUB,
+        MATH_NODE_MUL,
+        MATH_NODE_DIV,
+        MATH_NODE_VOI_FUNC,
+        MATH_NODE_UNI_FUNC,
+        MATH_NODE_BIN_FUNC,
+    };
+
+    struct math_node {
+        enum math_node_type type;
+        union {
+            VALUE_TYPE d;                           /* NUMBER */
+            char      *name;                        /* VAR */
+            enum math_pre_defined_var pre;          /* PRE_DEFINED */
+            VALUE_TYPE (*voi_func)(void);
+            VALUE_TYPE (*uni_func)(VALUE_TYPE a);
+            VALUE_TYPE (*bin_func)(VALUE_TYPE a, VALUE_TYPE b);
+        };
+        /* the key to override the pre-defined value in the parameters */
+        const char        *pre_name;
+        struct math_node  *l, *r;
+    };
+
+    struct EXPR_STRUCT {
+        /* NULL for an empty expression, which evaluates to zero */
+        struct math_node  *root;
     };
 
     struct internal_param {
-        purc_variant_t param;
-        purc_variant_t variables;
-        VALUE_TYPE     d;
-        unsigned int   divide_by_zero:1;
+        struct math_node  *root;
     };
 
     struct math_token {
@@ -165,35 +201,42 @@
     // generated header from flex
     // introduce yylex decl for later use
     #include <math.h>
+    #include <stdlib.h>
+
+    static void free_node(struct math_node *node)
+    {
+        if (node == NULL)
+            return;
+
+        free_node(node->l);
+        free_node(node->r);
+        if (node->type == MATH_NODE_VAR)
+            free(node->name);
+        free(node);
+    }
 
-    #define SET(_r, _a) do {                           \
-            _r->d = _a.d;                              \
-    } while (0)
-
-    #define NEG(_r, _a) do {                           \
-            _r.d = -_a.d;                              \
-    } while (0)
-
-    #define ADD(_r, _a, _b) do {                       \
-            _r.d = _a.d + _b.d;                        \
-    } while (0)
-
-    #define SUB(_r, _a, _b) do {                       \
-            _r.d = _a.d - _b.d;                        \
-    } while (0)
+    /* takes the ownership of the children, also on failure */
+    static struct math_node *
+    new_node(enum math_node_type type, struct math_node *l,
+            struct math_node *r)
+    {
+        struct math_node *node = calloc(1, sizeof(*node));
+        if (node == NULL) {
+            free_node(l);
+            free_node(r);
+            return NULL;
+        }
 
-    #define MUL(_r, _a, _b) do {                       \
-            _r.d = _a.d * _b.d;                        \
-    } while (0)
+        node->type = type;
+        node->l = l;
+        node->r = r;
+        return node;
+    }
 
-    #define DIV(_r, _a, _b, _loc) do {                        \
-            int f = fpclassify(_b.d);                         \
-            if (f & FP_ZERO) {                                \
-                param->divide_by_zero = 1;                    \
-                yyerror(_loc,arg,param,"Divide by zero");     \
-                YYERROR;                                      \
-            }                                                 \
-            _r.d = _a.d / _b.d;                               \
+    #define NEW_NODE(_r, _t, _a, _b) do {              \
+            _r = new_node(_t, _a, _b);                 \
+            if (_r == NULL)                            \
+                YYABORT;                               \
     } while (0)
 
     #define SET_BY_NUM(_r, _a) do {                                 \
@@ -202,78 +245,35 @@
             const char _c = _s[_a.leng];                            \
             char *endptr = NULL;                                    \
             _s[_a.leng] = '\0';                                     \
-            _r.d = STRTOD(_s, &endptr);                             \
+            VALUE_TYPE _d = STRTOD(_s, &endptr);                    \
             _s[_a.leng] = _c;                                       \
             if (endptr && *endptr)                                  \
                 YYABORT;                                            \
+            NEW_NODE(_r, MATH_NODE_NUMBER, NULL, NULL);             \
+            _r->d = _d;                                             \
     } while (0)
 
-    #define SET_BY_VAR(_r, _a) do {                                      \
-        purc_variant_t _v;                                               \
-        char *_s = (char*)_a.text;                                       \
-        const char _c = _s[_a.leng];                                     \
-        if (param->variables) {                                          \
-            _s[_a.leng] = '\0';                                          \
-            _v = purc_variant_object_get_by_ckey(param->variables, _s);  \
-            _s[_a.leng] = _c;                                            \
-            if (_v) {                                                    \
-                bool ok = CAST_TO_NUMBER(_v, &_r.d, false);              \
-                if (ok)                                                  \
-                    break;                                               \
-            }                                                            \
-        }                                                                \
-        if (param->param && purc_variant_is_object(param->param)) {      \
-            _s[_a.leng] = '\0';                                          \
-            _v = purc_variant_object_get_by_ckey(param->param, _s);      \
-            _s[_a.leng] = _c;                                            \
-            if (_v) {                                                    \
-                bool ok = CAST_TO_NUMBER(_v, &_r.d, false);              \
-                if (ok)                                                  \
-                    break;                                               \
-            }                                                            \
-        }                                                                \
-        YYABORT;                                                         \
-    } while (0)
-
-    #define SET_BY_PRE_DEFINED(_r, _a, _s) do {                          \
-        purc_variant_t _v;                                               \
-        if (param->variables) {                                          \
-            _v = purc_variant_object_get_by_ckey(param->variables, _s);  \
-            if (_v) {                                                    \
-                bool ok = CAST_TO_NUMBER(_v, &_r.d, false);              \
-                if (ok)                                                  \
-                    break;                                               \
-            }                                                            \
-        }                                                                \
-        if (param->param && purc_variant_is_object(param->param)) {      \
-            _v = purc_variant_object_get_by_ckey(param->param, _s);      \
-            if (_v) {                                                    \
-                bool ok = CAST_TO_NUMBER(_v, &_r.d, false);              \
-                fprintf(stderr, "_s: %s; ok: %d\n", _s, ok); \
-                if (ok)                                                  \
-                    break;                                               \
-            }                                                            \
-        }                                                                \
-        _r.d = PRE_DEFINED(_a);                                          \
-        purc_clr_error();                                                \
-    } while (0)
-
-    #define EVAL_BY_VOI_FUNC(_r, _f) do {                                \
-        int r = VOI_FUNC(&_r.d, _f);                                     \
-        if (r)                                                           \
-            YYABORT;                                                     \
+    #define SET_BY_VAR(_r, _a) do {                                 \
+            char *_name = strndup(_a.text, _a.leng);                \
+            if (_name == NULL)                                      \
+                YYABORT;                                            \
+            _r = new_node(MATH_NODE_VAR, NULL, NULL);               \
+            if (_r == NULL) {                                       \
+                free(_name);                                        \
+                YYABORT;                                            \
+            }                                                       \
+            _r->name = _name;                                       \
     } while (0)
 
-    #define EVAL_BY_UNI_FUNC(_r, _f, _a) do {                            \
-        int r = UNI_FUNC(&_r.d, _f, _a.d);                               \
-        if (r)                                                           \
-            YYABORT;                                                     \
+    #define SET_BY_PRE_DEFINED(_r, _a, _s) do {                     \
+            NEW_NODE(_r, MATH_NODE_PRE_DEFINED, NULL, NULL);        \
+            _r->pre = _a;                                           \
+            _r->pre_name = _s;                                      \
     } while (0)
 
-    #define EVAL_BY_BIN_FUNC(_r, _f, _a, _b) do {                        \
-        int r = BIN_FUNC(&_r.d, _f, _a.d, _b.d);                         \
-        if (r)                                                           \
-            YYABORT;                                                     \
+    #define SET_FUNC(_r, _t, _m, _f, _a, _b) do {                   \
+            NEW_NODE(_r, _t, _a, _b);                               \
+            _r->_m = _f;                                            \
     } while (0)
 
     static void yyerror(
@@ -299,11 +299,13 @@
 %parse-param { struct internal_param *param }
 
 %union { struct math_token token; }
-%union { struct internal_value v; }
+%union { struct math_node *node; }
 %union { VALUE_TYPE (*voi_func)(void); }
 %union { VALUE_TYPE (*uni_func)(VALUE_TYPE a); }
 %union { VALUE_TYPE (*bin_func)(VALUE_TYPE a, VALUE_TYPE b); }
 
+%destructor { free_node($$); } <node>
+
 %precedence '='
 %left '-' '+'
 %left '*' '/'
@@ -320,7 +322,7 @@
 %token PI E LN2 LN10 LOG2E LOG10E SQRT1_2 SQRT2
 
 %token <token> NUMBER VAR
-%nterm <v> exp term pre_defined
+%nterm <node> exp term pre_defined
 %nterm <voi_func> voi_func
 %nterm <uni_func> uni_func
 %nterm <bin_func> bin_func
@@ -334,26 +336,29 @@ input:
 ;
 
 statement:
-  exp         { SET(param, $1); }
+  exp         { param->root = $1; }
 ;
 
 exp:
   term
-| exp '+' exp   { ADD($$, $1, $3); }
-| exp '-' exp   { SUB($$, $1, $3); }
-| exp '*' exp   { MUL($$, $1, $3); }
-| exp '/' exp   { DIV($$, $1, $3, &(@3)); }
-| exp '^' exp   { EVAL_BY_BIN_FUNC($$, POW, $1, $3); }
-| '-' exp %prec NEG { NEG($$, $2); }
+| exp '+' exp   { NEW_NODE($$, MATH_NODE_ADD, $1, $3); }
+| exp '-' exp   { NEW_NODE($$, MATH_NODE_SUB, $1, $3); }
+| exp '*' exp   { NEW_NODE($$, MATH_NODE_MUL, $1, $3); }
+| exp '/' exp   { NEW_NODE($$, MATH_NODE_DIV, $1, $3); }
+| exp '^' exp   { SET_FUNC($$, MATH_NODE_BIN_FUNC, bin_func, POW, $1, $3); }
+| '-' exp %prec NEG { NEW_NODE($$, MATH_NODE_NEG, $2, NULL); }
 ;
 
 term:
   NUMBER      { SET_BY_NUM($$, $1); }
 | VAR         { SET_BY_VAR($$, $1); }
 | pre_defined { $$ = $1; }
-| voi_func '(' ')' { EVAL_BY_VOI_FUNC($$, $1); }
-| uni_func '(' exp ')' { EVAL_BY_UNI_FUNC($$, $1, $3); }
-| bin_func '(' exp ',' exp ')' { EVAL_BY_BIN_FUNC($$, $1, $3, $5); }
+| voi_func '(' ')' {
+        SET_FUNC($$, MATH_NODE_VOI_FUNC, voi_func, $1, NULL, NULL); }
+| uni_func '(' exp ')' {
+        SET_FUNC($$, MATH_NODE_UNI_FUNC, uni_func, $1, $3, NULL); }
+| bin_func '(' exp ',' exp ')' {
+        SET_FUNC($$, MATH_NODE_BIN_FUNC, bin_func, $1, $3, $5); }
 | '(' exp ')' { $$ = $2; }
 ;
 
@@ -428,35 +433,143 @@ yyerror(
         errsg);
 }
 
-int FUNC_NAME(const char *input, VALUE_TYPE *d, purc_variant_t param)
+struct EXPR_STRUCT *COMPILE_NAME(const char *input)
 {
     struct internal_param ud = {0};
-    ud.param = param;
-    ud.variables = PURC_VARIANT_INVALID;
 
     yyscan_t arg = {0};
     yylex_init(&arg);
     // yyset_in(in, arg);
     // yyset_debug(debug, arg);
-    yyset_extra(param, arg);
     yy_scan_string(input, arg);
-    int ret =yyparse(arg, &ud);
-    if (ud.variables) {
-        purc_variant_unref(ud.variables);
-        ud.variables = PURC_VARIANT_INVALID;
-    }
+    int ret = yyparse(arg, &ud);
     yylex_destroy(arg);
-    if (ret==0 && d) {
-        *d = ud.d;
+
+    struct EXPR_STRUCT *expr = NULL;
+    if (ret == 0)
+        expr = malloc(sizeof(*expr));
+
+    if (expr == NULL) {
+        free_node(ud.root);
+        purc_set_error(PURC_ERROR_INTERNAL_FAILURE);
+        return NULL;
     }
-    else {
-        if (ud.divide_by_zero) {
+
+    expr->root = ud.root;
+    return expr;
+}
+
+void FREE_NAME(struct EXPR_STRUCT *expr)
+{
+    free_node(expr->root);
+    free(expr);
+}
+
+/* looks the value up in the parameters; the members must be numbers */
+static bool
+get_param(purc_variant_t param, const char *name, VALUE_TYPE *d)
+{
+    if (param == PURC_VARIANT_INVALID || !purc_variant_is_object(param))
+        return false;
+
+    purc_variant_t v = purc_variant_object_get_by_ckey(param, name);
+    return v && CAST_TO_NUMBER(v, d, false);
+}
+
+static int
+eval_node(const struct math_node *node, purc_variant_t param,
+        VALUE_TYPE *r, bool *divide_by_zero)
+{
+    VALUE_TYPE a = 0, b = 0;
+
+    if (node->l && eval_node(node->l, param, &a, divide_by_zero))
+        return -1;
+    if (node->r && eval_node(node->r, param, &b, divide_by_zero))
+        return -1;
+
+    switch (node->type) {
+    case MATH_NODE_NUMBER:
+        *r = node->d;
+        break;
+
+    case MATH_NODE_VAR:
+        if (!get_param(param, node->name, r))
+            return -1;
+        break;
+
+    case MATH_NODE_PRE_DEFINED:
+        if (!get_param(param, node->pre_name, r)) {
+            *r = PRE_DEFINED(node->pre);
+            purc_clr_error();
+        }
+        break;
+
+    case MATH_NODE_NEG:
+        *r = -a;
+        break;
+
+    case MATH_NODE_ADD:
+        *r = a + b;
+        break;
+
+    case MATH_NODE_SUB:
+        *r = a - b;
+        break;
+
+    case MATH_NODE_MUL:
+        *r = a * b;
+        break;
+
+    case MATH_NODE_DIV:
+        if (fpclassify(b) == FP_ZERO) {
+            *divide_by_zero = true;
+            return -1;
+        }
+        *r = a / b;
+        break;
+
+    case MATH_NODE_VOI_FUNC:
+        return VOI_FUNC(r, node->voi_func);
+
+    case MATH_NODE_UNI_FUNC:
+        return UNI_FUNC(r, node->uni_func, a);
+
+    case MATH_NODE_BIN_FUNC:
+        return BIN_FUNC(r, node->bin_func, a, b);
+    }
+
+    return 0;
+}
+
+int EVAL_NAME(const struct EXPR_STRUCT *expr, VALUE_TYPE *d,
+        purc_variant_t param)
+{
+    VALUE_TYPE v = 0;
+    bool divide_by_zero = false;
+
+    if (expr->root && eval_node(expr->root, param, &v, &divide_by_zero)) {
+        if (divide_by_zero) {
             purc_set_error(PURC_ERROR_OVERFLOW);
         }
         else {
             purc_set_error(PURC_ERROR_INTERNAL_FAILURE);
         }
+        return 1;
     }
-    return ret ? 1 : 0;
+
+    if (d)
+        *d = v;
+    return 0;
+}
+
+int FUNC_NAME(const char *input, VALUE_TYPE *d, purc_variant_t param)
+{
+    struct EXPR_STRUCT *expr = COMPILE_NAME(input);
+    if (expr == NULL)
+        return 1;
+
+    int ret = EVAL_NAME(expr, d, param);
+    FREE_NAME(expr);
+    return ret;
 }
 
@@ -0,0 +1,99 @@
+#
+# Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+#
+# This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#
+# Author: Vincent Wei <https://github.com/VincentWei>
+
+"""
+Generate a minimal-collision-free (perfect) hash for a static set of names
+by the hash-and-displace method:
+
+    h    = FNV-1a (32-bit) of the name in lower case
+    d    = displacements[h % nr_buckets]
+    slot = (h + d * ((h >> 16) | 1)) % nr_slots
+
+Every name gets a distinct slot, so a lookup costs one hash and at most one
+string comparison. The same computation is done in C by the functions in
+`include/private/phash.h`; keep them in sync.
+"""
+
+FNV_PRIME_32B = 0x01000193
+FNV_INIT_32B  = 0x811c9dc5
+
+MAX_DISPLACEMENT = 255
+
+def hash_name(name):
+    hval = FNV_INIT_32B
+    for c in name.lower().encode():
+        hval ^= c
+        hval = (hval * FNV_PRIME_32B) & 0xFFFFFFFF
+    return hval
+
+def slot_of(hval, disp, nr_slots):
+    return ((hval + disp * ((hval >> 16) | 1)) & 0xFFFFFFFF) % nr_slots
+
+def _try_build(hashes, nr_buckets, nr_slots):
+    buckets = [[] for i in range(nr_buckets)]
+    for name in hashes:
+        buckets[hashes[name] % nr_buckets].append(name)
+
+    disps = [0] * nr_buckets
+    slots = [None] * nr_slots
+
+    # place the largest buckets first
+    order = sorted(range(nr_buckets), key=lambda b: -len(buckets[b]))
+    for b in order:
+        names = buckets[b]
+        if len(names) == 0:
+            break
+
+        for disp in range(0, MAX_DISPLACEMENT + 1):
+            taken = [slot_of(hashes[name], disp, nr_slots) for name in names]
+            if len(set(taken)) == len(taken) and \
+                    all(slots[s] is None for s in taken):
+                break
+        else:
+            return None
+
+        disps[b] = disp
+        for name, s in zip(names, taken):
+            slots[s] = name
+
+    return disps, slots
+
+def generate(names):
+    """
+    Returns (nr_buckets, displacements, slots), where slots[i] is the name
+    placed in the slot i, or None.
+    """
+    hashes = {}
+    for name in names:
+        hval = hash_name(name)
+        for other in hashes:
+            if hashes[other] == hval:
+                raise Exception('same hash value for %s and %s' % (name, other))
+        hashes[name] = hval
+
+    nr_names = len(hashes)
+    nr_buckets = max(1, (nr_names + 3) // 4)
+    nr_slots = nr_names
+    while True:
+        result = _try_build(hashes, nr_buckets, nr_slots)
+        if result is not None:
+            disps, slots = result
+            return nr_buckets, disps, slots
+        nr_slots += 1
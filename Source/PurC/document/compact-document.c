@@ -0,0 +1,1526 @@
+/**
+ * @file compact-document.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The implementation of compact HTML document.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#undef NDEBUG
+
+#include "purc-document.h"
+#include "purc-errors.h"
+#include "purc-html.h"
+#include "purc-utils.h"
+
+#include "private/document.h"
+#include "private/atom-buckets.h"
+#include "private/debug.h"
+
+#include <ctype.h>
+#include <strings.h>
+
+/*
+ * A compact HTML document keeps the nodes in a structure of arrays indexed
+ * by the node identifier, which is also the handle of the node; 0 is the
+ * null node. The tag and attribute names are atoms, and all texts and
+ * attribute values are stored in one growing buffer, null-terminated.
+ *
+ * The document is parsed by the HTML parser, then the tree is converted and
+ * the parser document is thrown away. The text stored is never moved out of
+ * the buffer; it is released as a whole when the document is reset.
+ */
+
+enum {
+    CNODE_FREE = 0,
+    CNODE_ELEMENT,
+    CNODE_TEXT,
+    CNODE_COMMENT,
+};
+
+#define CNODE_NULL          0
+#define CATTR_NULL          0
+
+#define NR_NODES_INIT       64
+#define NR_ATTRS_INIT       32
+#define SZ_TEXT_INIT        1024
+
+#define LEN_BUFF_LONGLONGINT    128
+
+struct compact_doc {
+    /* the nodes; index 0 is not used */
+    uint32_t        nr_nodes;
+    uint32_t        sz_nodes;
+    uint8_t        *kinds;
+    uint32_t       *parents;
+    uint32_t       *firsts;
+    uint32_t       *lasts;
+    uint32_t       *prevs;
+    uint32_t       *nexts;
+    /* the atom of the tag for an element, the offset of the text for
+       a text or comment node */
+    uint32_t       *names;
+    /* the first attribute for an element, the length of the text for
+       a text or comment node */
+    uint32_t       *datas;
+    /* the freed nodes, linked by `nexts` */
+    uint32_t        free_nodes;
+
+    /* the attributes; index 0 is not used */
+    uint32_t        nr_attrs;
+    uint32_t        sz_attrs;
+    purc_atom_t    *attr_names;
+    uint32_t       *attr_vals;
+    uint32_t       *attr_lens;
+    uint32_t       *attr_nexts;
+    /* the freed attributes, linked by `attr_nexts` */
+    uint32_t        free_attrs;
+
+    /* the texts and attribute values */
+    char           *text;
+    size_t          len_text;
+    size_t          sz_text;
+
+    uint32_t        root;
+    uint32_t        head;
+    uint32_t        body;
+    unsigned        has_doctype:1;
+
+    purc_atom_t     atom_id;
+    purc_atom_t     atom_class;
+};
+
+#define HANDLE_OF(id)       ((void *)(uintptr_t)(id))
+#define ID_OF(handle)       ((uint32_t)(uintptr_t)(handle))
+
+static purc_atom_t
+intern_name(const char *name, size_t len)
+{
+    char buff[64];
+    char *lower = buff;
+    purc_atom_t atom;
+
+    if (len >= sizeof(buff)) {
+        lower = malloc(len + 1);
+        if (lower == NULL)
+            return 0;
+    }
+
+    for (size_t i = 0; i < len; i++)
+        lower[i] = tolower((unsigned char)name[i]);
+    lower[len] = 0;
+
+    atom = purc_atom_from_string_ex(ATOM_BUCKET_HTML, lower);
+    if (lower != buff)
+        free(lower);
+    return atom;
+}
+
+/* returns the offset of the text copied, or (uint32_t)-1 on failure */
+static uint32_t
+store_text(struct compact_doc *cdoc, const char *str, size_t len)
+{
+    if (cdoc->len_text + len + 1 > UINT32_MAX)
+        return (uint32_t)-1;
+
+    if (cdoc->len_text + len + 1 > cdoc->sz_text) {
+        size_t sz = cdoc->sz_text ? cdoc->sz_text : SZ_TEXT_INIT;
+        while (sz < cdoc->len_text + len + 1)
+            sz *= 2;
+        char *text = realloc(cdoc->text, sz);
+        if (text == NULL)
+            return (uint32_t)-1;
+        cdoc->text = text;
+        cdoc->sz_text = sz;
+    }
+
+    uint32_t off = (uint32_t)cdoc->len_text;
+    if (len)
+        memcpy(cdoc->text + off, str, len);
+    cdoc->text[off + len] = 0;
+    cdoc->len_text += len + 1;
+    return off;
+}
+
+#define GROW_ARRAY(array, sz)                                           \
+    do {                                                                \
+        void *p = realloc((array), (sz) * sizeof(*(array)));            \
+        if (p == NULL)                                                  \
+            return -1;                                                  \
+        (array) = p;                                                    \
+    } while (0)
+
+static int
+grow_nodes(struct compact_doc *cdoc)
+{
+    uint32_t sz = cdoc->sz_nodes ? cdoc->sz_nodes * 2 : NR_NODES_INIT;
+    if (sz <= cdoc->sz_nodes)
+        return -1;
+
+    /* the arrays grown are kept even if a later one fails */
+    GROW_ARRAY(cdoc->kinds, sz);
+    GROW_ARRAY(cdoc->parents, sz);
+    GROW_ARRAY(cdoc->firsts, sz);
+    GROW_ARRAY(cdoc->lasts, sz);
+    GROW_ARRAY(cdoc->prevs, sz);
+    GROW_ARRAY(cdoc->nexts, sz);
+    GROW_ARRAY(cdoc->names, sz);
+    GROW_ARRAY(cdoc->datas, sz);
+    cdoc->sz_nodes = sz;
+    return 0;
+}
+
+static int
+grow_attrs(struct compact_doc *cdoc)
+{
+    uint32_t sz = cdoc->sz_attrs ? cdoc->sz_attrs * 2 : NR_ATTRS_INIT;
+    if (sz <= cdoc->sz_attrs)
+        return -1;
+
+    GROW_ARRAY(cdoc->attr_names, sz);
+    GROW_ARRAY(cdoc->attr_vals, sz);
+    GROW_ARRAY(cdoc->attr_lens, sz);
+    GROW_ARRAY(cdoc->attr_nexts, sz);
+    cdoc->sz_attrs = sz;
+    return 0;
+}
+
+static uint32_t
+new_node(struct compact_doc *cdoc, uint8_t kind, uint32_t name,
+        uint32_t data)
+{
+    uint32_t id;
+
+    if (cdoc->free_nodes) {
+        id = cdoc->free_nodes;
+        cdoc->free_nodes = cdoc->nexts[id];
+    }
+    else {
+        if (cdoc->nr_nodes == cdoc->sz_nodes && grow_nodes(cdoc)) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return CNODE_NULL;
+        }
+        id = cdoc->nr_nodes++;
+    }
+
+    cdoc->kinds[id] = kind;
+    cdoc->parents[id] = CNODE_NULL;
+    cdoc->firsts[id] = CNODE_NULL;
+    cdoc->lasts[id] = CNODE_NULL;
+    cdoc->prevs[id] = CNODE_NULL;
+    cdoc->nexts[id] = CNODE_NULL;
+    cdoc->names[id] = name;
+    cdoc->datas[id] = data;
+    return id;
+}
+
+static uint32_t
+new_element(struct compact_doc *cdoc, const char *tag, size_t len)
+{
+    purc_atom_t atom = intern_name(tag, len);
+    if (atom == 0) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return CNODE_NULL;
+    }
+
+    return new_node(cdoc, CNODE_ELEMENT, atom, CATTR_NULL);
+}
+
+static uint32_t
+new_text(struct compact_doc *cdoc, uint8_t kind, const char *text,
+        size_t len)
+{
+    uint32_t off = store_text(cdoc, text, len);
+    if (off == (uint32_t)-1) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return CNODE_NULL;
+    }
+
+    return new_node(cdoc, kind, off, (uint32_t)len);
+}
+
+static void
+free_node(struct compact_doc *cdoc, uint32_t id)
+{
+    if (cdoc->kinds[id] == CNODE_ELEMENT) {
+        uint32_t attr = cdoc->datas[id];
+        while (attr) {
+            uint32_t next = cdoc->attr_nexts[attr];
+            cdoc->attr_nexts[attr] = cdoc->free_attrs;
+            cdoc->free_attrs = attr;
+            attr = next;
+        }
+    }
+
+    if (id == cdoc->head)
+        cdoc->head = CNODE_NULL;
+    else if (id == cdoc->body)
+        cdoc->body = CNODE_NULL;
+
+    cdoc->kinds[id] = CNODE_FREE;
+    cdoc->nexts[id] = cdoc->free_nodes;
+    cdoc->free_nodes = id;
+}
+
+static void
+unlink_node(struct compact_doc *cdoc, uint32_t id)
+{
+    uint32_t parent = cdoc->parents[id];
+    uint32_t prev = cdoc->prevs[id];
+    uint32_t next = cdoc->nexts[id];
+
+    if (prev)
+        cdoc->nexts[prev] = next;
+    else if (parent)
+        cdoc->firsts[parent] = next;
+
+    if (next)
+        cdoc->prevs[next] = prev;
+    else if (parent)
+        cdoc->lasts[parent] = prev;
+
+    cdoc->parents[id] = CNODE_NULL;
+    cdoc->prevs[id] = CNODE_NULL;
+    cdoc->nexts[id] = CNODE_NULL;
+}
+
+/* frees the node and its descendants in post order without a stack;
+   the node must have been unlinked */
+static void
+free_subtree(struct compact_doc *cdoc, uint32_t root)
+{
+    uint32_t node = root;
+
+    for (;;) {
+        while (cdoc->firsts[node])
+            node = cdoc->firsts[node];
+
+        if (node == root) {
+            free_node(cdoc, node);
+            break;
+        }
+
+        uint32_t parent = cdoc->parents[node];
+        uint32_t next = cdoc->nexts[node];
+        cdoc->firsts[parent] = next;
+        free_node(cdoc, node);
+        node = next ? next : parent;
+    }
+}
+
+static void
+erase_children(struct compact_doc *cdoc, uint32_t parent)
+{
+    while (cdoc->firsts[parent]) {
+        uint32_t child = cdoc->firsts[parent];
+        unlink_node(cdoc, child);
+        free_subtree(cdoc, child);
+    }
+}
+
+static void
+append_child(struct compact_doc *cdoc, uint32_t parent, uint32_t id)
+{
+    uint32_t last = cdoc->lasts[parent];
+
+    cdoc->parents[id] = parent;
+    cdoc->prevs[id] = last;
+    cdoc->nexts[id] = CNODE_NULL;
+    if (last)
+        cdoc->nexts[last] = id;
+    else
+        cdoc->firsts[parent] = id;
+    cdoc->lasts[parent] = id;
+}
+
+static void
+insert_before(struct compact_doc *cdoc, uint32_t ref, uint32_t id)
+{
+    uint32_t parent = cdoc->parents[ref];
+    uint32_t prev = cdoc->prevs[ref];
+
+    cdoc->parents[id] = parent;
+    cdoc->prevs[id] = prev;
+    cdoc->nexts[id] = ref;
+    cdoc->prevs[ref] = id;
+    if (prev)
+        cdoc->nexts[prev] = id;
+    else if (parent)
+        cdoc->firsts[parent] = id;
+}
+
+static void
+insert_after(struct compact_doc *cdoc, uint32_t ref, uint32_t id)
+{
+    uint32_t parent = cdoc->parents[ref];
+    uint32_t next = cdoc->nexts[ref];
+
+    cdoc->parents[id] = parent;
+    cdoc->prevs[id] = ref;
+    cdoc->nexts[id] = next;
+    cdoc->nexts[ref] = id;
+    if (next)
+        cdoc->prevs[next] = id;
+    else if (parent)
+        cdoc->lasts[parent] = id;
+}
+
+/* places the children of the container in order against the element,
+   and frees the container */
+static void
+place_children(struct compact_doc *cdoc, uint32_t elem, pcdoc_operation op,
+        uint32_t container)
+{
+    uint32_t ref = CNODE_NULL;
+
+    if (op == PCDOC_OP_DISPLACE)
+        erase_children(cdoc, elem);
+    else if (op == PCDOC_OP_PREPEND)
+        ref = cdoc->firsts[elem];
+    else if (op == PCDOC_OP_INSERTAFTER)
+        ref = elem;
+
+    while (cdoc->firsts[container]) {
+        uint32_t child = cdoc->firsts[container];
+        unlink_node(cdoc, child);
+
+        switch (op) {
+        case PCDOC_OP_PREPEND:
+            if (ref)
+                insert_before(cdoc, ref, child);
+            else
+                append_child(cdoc, elem, child);
+            break;
+
+        case PCDOC_OP_INSERTBEFORE:
+            insert_before(cdoc, elem, child);
+            break;
+
+        case PCDOC_OP_INSERTAFTER:
+            insert_after(cdoc, ref, child);
+            ref = child;
+            break;
+
+        default:
+            append_child(cdoc, elem, child);
+            break;
+        }
+    }
+
+    free_subtree(cdoc, container);
+}
+
+static void
+place_node(struct compact_doc *cdoc, uint32_t elem, pcdoc_operation op,
+        uint32_t id)
+{
+    switch (op) {
+    case PCDOC_OP_PREPEND:
+        if (cdoc->firsts[elem])
+            insert_before(cdoc, cdoc->firsts[elem], id);
+        else
+            append_child(cdoc, elem, id);
+        break;
+
+    case PCDOC_OP_INSERTBEFORE:
+        insert_before(cdoc, elem, id);
+        break;
+
+    case PCDOC_OP_INSERTAFTER:
+        insert_after(cdoc, elem, id);
+        break;
+
+    case PCDOC_OP_DISPLACE:
+        erase_children(cdoc, elem);
+        append_child(cdoc, elem, id);
+        break;
+
+    default:
+        append_child(cdoc, elem, id);
+        break;
+    }
+}
+
+static uint32_t
+find_attr(struct compact_doc *cdoc, uint32_t elem, purc_atom_t name,
+        uint32_t *prev)
+{
+    uint32_t p = CATTR_NULL;
+    uint32_t attr = cdoc->datas[elem];
+
+    while (attr) {
+        if (cdoc->attr_names[attr] == name)
+            break;
+        p = attr;
+        attr = cdoc->attr_nexts[attr];
+    }
+
+    if (prev)
+        *prev = p;
+    return attr;
+}
+
+static int
+set_attr(struct compact_doc *cdoc, uint32_t elem, const char *name,
+        size_t name_len, const char *val, size_t len)
+{
+    purc_atom_t atom = intern_name(name, name_len);
+    if (atom == 0) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return -1;
+    }
+
+    uint32_t off = store_text(cdoc, val, len);
+    if (off == (uint32_t)-1) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    uint32_t prev;
+    uint32_t attr = find_attr(cdoc, elem, atom, &prev);
+    if (attr == CATTR_NULL) {
+        if (cdoc->free_attrs) {
+            attr = cdoc->free_attrs;
+            cdoc->free_attrs = cdoc->attr_nexts[attr];
+        }
+        else {
+            if (cdoc->nr_attrs == cdoc->sz_attrs && grow_attrs(cdoc)) {
+                purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+                return -1;
+            }
+            attr = cdoc->nr_attrs++;
+        }
+
+        /* keeps the attributes in the order they were set */
+        cdoc->attr_names[attr] = atom;
+        cdoc->attr_nexts[attr] = CATTR_NULL;
+        if (prev)
+            cdoc->attr_nexts[prev] = attr;
+        else
+            cdoc->datas[elem] = attr;
+    }
+
+    cdoc->attr_vals[attr] = off;
+    cdoc->attr_lens[attr] = (uint32_t)len;
+    return 0;
+}
+
+static int
+remove_attr(struct compact_doc *cdoc, uint32_t elem, const char *name)
+{
+    purc_atom_t atom = intern_name(name, strlen(name));
+    uint32_t prev;
+    uint32_t attr = find_attr(cdoc, elem, atom, &prev);
+    if (attr == CATTR_NULL)
+        return -1;
+
+    if (prev)
+        cdoc->attr_nexts[prev] = cdoc->attr_nexts[attr];
+    else
+        cdoc->datas[elem] = cdoc->attr_nexts[attr];
+
+    cdoc->attr_nexts[attr] = cdoc->free_attrs;
+    cdoc->free_attrs = attr;
+    return 0;
+}
+
+/* converts the children of the eDOM node under the compact node */
+static int
+convert_children(struct compact_doc *cdoc, pcdom_node_t *from, uint32_t to)
+{
+    pcdom_node_t *node = from->first_child;
+
+    while (node) {
+        uint32_t id = CNODE_NULL;
+
+        switch (node->type) {
+        case PCDOM_NODE_TYPE_ELEMENT: {
+            pcdom_element_t *elem = pcdom_interface_element(node);
+            const char *name;
+            size_t len;
+
+            name = (const char *)pcdom_element_local_name(elem, &len);
+            id = new_element(cdoc, name, len);
+            if (id == CNODE_NULL)
+                return -1;
+
+            pcdom_attr_t *attr = pcdom_element_first_attribute(elem);
+            while (attr) {
+                const char *val;
+                size_t val_len;
+
+                name = (const char *)pcdom_attr_local_name(attr, &len);
+                val = (const char *)pcdom_attr_value(attr, &val_len);
+                if (set_attr(cdoc, id, name, len, val ? val : "", val_len))
+                    return -1;
+                attr = pcdom_element_next_attribute(attr);
+            }
+            break;
+        }
+
+        case PCDOM_NODE_TYPE_TEXT:
+        case PCDOM_NODE_TYPE_CDATA_SECTION:
+        case PCDOM_NODE_TYPE_COMMENT: {
+            pcdom_character_data_t *cd = (pcdom_character_data_t *)node;
+            id = new_text(cdoc,
+                    node->type == PCDOM_NODE_TYPE_COMMENT ?
+                        CNODE_COMMENT : CNODE_TEXT,
+                    (const char *)cd->data.data, cd->data.length);
+            if (id == CNODE_NULL)
+                return -1;
+            break;
+        }
+
+        default:
+            break;
+        }
+
+        if (id) {
+            append_child(cdoc, to, id);
+
+            /* walks down and up the tree instead of recursing */
+            if (node->type == PCDOM_NODE_TYPE_ELEMENT && node->first_child) {
+                node = node->first_child;
+                to = id;
+                continue;
+            }
+        }
+
+        while (node->next == NULL && node->parent != from) {
+            node = node->parent;
+            to = cdoc->parents[to];
+        }
+
+        node = node->next;
+    }
+
+    return 0;
+}
+
+static uint32_t
+find_child_element(struct compact_doc *cdoc, uint32_t parent,
+        const char *tag)
+{
+    purc_atom_t atom = purc_atom_try_string_ex(ATOM_BUCKET_HTML, tag);
+    if (atom == 0)
+        return CNODE_NULL;
+
+    for (uint32_t child = cdoc->firsts[parent]; child;
+            child = cdoc->nexts[child]) {
+        if (cdoc->kinds[child] == CNODE_ELEMENT && cdoc->names[child] == atom)
+            return child;
+    }
+
+    return CNODE_NULL;
+}
+
+static int
+load_content(struct compact_doc *cdoc, const char *content, size_t length)
+{
+    pchtml_html_document_t *html_doc;
+    int ret = -1;
+
+    if (content == NULL) {
+        content = "<html></html>";
+        length = 0;
+    }
+
+    if (length == 0) {
+        length = strlen(content);
+    }
+
+    html_doc = pchtml_html_document_create();
+    if (!html_doc) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    unsigned int r;
+    r = pchtml_html_document_parse_with_buf(html_doc,
+            (const unsigned char*)content, length);
+    if (r) {
+        PC_WARN("bad content\n");
+    }
+
+    pcdom_document_t *dom_doc = pchtml_doc_get_document(html_doc);
+    pcdom_node_t *dom_root = pcdom_interface_node(dom_doc->element);
+    if (dom_root == NULL) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        goto done;
+    }
+
+    cdoc->has_doctype = dom_doc->doctype ? 1 : 0;
+    cdoc->root = new_element(cdoc, "html", 4);
+    if (cdoc->root == CNODE_NULL)
+        goto done;
+
+    pcdom_element_t *dom_elem = pcdom_interface_element(dom_root);
+    pcdom_attr_t *attr = pcdom_element_first_attribute(dom_elem);
+    while (attr) {
+        const char *name, *val;
+        size_t len, val_len;
+
+        name = (const char *)pcdom_attr_local_name(attr, &len);
+        val = (const char *)pcdom_attr_value(attr, &val_len);
+        if (set_attr(cdoc, cdoc->root, name, len, val ? val : "", val_len))
+            goto done;
+        attr = pcdom_element_next_attribute(attr);
+    }
+
+    if (convert_children(cdoc, dom_root, cdoc->root))
+        goto done;
+
+    cdoc->head = find_child_element(cdoc, cdoc->root, "head");
+    cdoc->body = find_child_element(cdoc, cdoc->root, "body");
+    ret = 0;
+
+done:
+    pchtml_html_document_destroy(html_doc);
+    return ret;
+}
+
+/* parses the fragment in the context of the element, and returns a
+   detached container holding the nodes made */
+static uint32_t
+parse_fragment(struct compact_doc *cdoc, uint32_t context,
+        const char *fragment, size_t length)
+{
+    pchtml_html_document_t *html_doc;
+    uint32_t container = CNODE_NULL;
+
+    html_doc = pchtml_html_document_create();
+    if (!html_doc) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return CNODE_NULL;
+    }
+
+    /* the context decides how the fragment is tokenized */
+    const char *tag = purc_atom_to_string(cdoc->names[context]);
+    pcdom_element_t *dom_elem;
+    dom_elem = pcdom_document_create_element(
+            pchtml_doc_get_document(html_doc),
+            (const unsigned char *)tag, strlen(tag), NULL);
+    if (dom_elem == NULL)
+        goto failed;
+
+    pcdom_node_t *root = NULL;
+    if (pchtml_html_document_parse_fragment_chunk_begin(html_doc, dom_elem) ||
+            pchtml_html_document_parse_fragment_chunk(html_doc,
+                (const unsigned char*)"<div>", 5) ||
+            pchtml_html_document_parse_fragment_chunk(html_doc,
+                (const unsigned char*)fragment, length) ||
+            pchtml_html_document_parse_fragment_chunk(html_doc,
+                (const unsigned char*)"</div>", 6))
+        goto failed;
+
+    root = pchtml_html_document_parse_fragment_chunk_end(html_doc);
+    if (root == NULL || root->first_child == NULL)
+        goto failed;
+
+    container = new_element(cdoc, "div", 3);
+    if (container == CNODE_NULL)
+        goto failed;
+
+    if (convert_children(cdoc, root->first_child, container)) {
+        free_subtree(cdoc, container);
+        container = CNODE_NULL;
+    }
+
+failed:
+    pchtml_html_document_destroy(html_doc);
+    return container;
+}
+
+static inline struct compact_doc *
+compact_doc(purc_document_t doc)
+{
+    return (struct compact_doc *)doc->impl;
+}
+
+/* returns the identifier of the node, or 0 if the handle is bad */
+static inline uint32_t
+valid_node(struct compact_doc *cdoc, void *handle, uint8_t kind)
+{
+    uint32_t id = ID_OF(handle);
+    if (id == CNODE_NULL || id >= cdoc->nr_nodes || cdoc->kinds[id] != kind) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return CNODE_NULL;
+    }
+
+    return id;
+}
+
+static void
+release_impl(struct compact_doc *cdoc)
+{
+    free(cdoc->kinds);
+    free(cdoc->parents);
+    free(cdoc->firsts);
+    free(cdoc->lasts);
+    free(cdoc->prevs);
+    free(cdoc->nexts);
+    free(cdoc->names);
+    free(cdoc->datas);
+    free(cdoc->attr_names);
+    free(cdoc->attr_vals);
+    free(cdoc->attr_lens);
+    free(cdoc->attr_nexts);
+    free(cdoc->text);
+    free(cdoc);
+}
+
+static purc_document_t create(const char *content, size_t length)
+{
+    struct compact_doc *cdoc = calloc(1, sizeof(*cdoc));
+    if (cdoc == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    /* skips the null node and the null attribute */
+    cdoc->nr_nodes = 1;
+    cdoc->nr_attrs = 1;
+    if (grow_nodes(cdoc) || grow_attrs(cdoc)) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto failed;
+    }
+    cdoc->kinds[CNODE_NULL] = CNODE_FREE;
+    cdoc->atom_id = intern_name("id", 2);
+    cdoc->atom_class = intern_name("class", 5);
+
+    if (load_content(cdoc, content, length))
+        goto failed;
+
+    purc_document_t doc = calloc(1, sizeof(*doc));
+    if (doc == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto failed;
+    }
+
+    doc->type = PCDOC_K_TYPE_HTML;
+    doc->def_text_type = PCRDR_MSG_DATA_TYPE_HTML;
+    /* a compact document is only serialized, never rendered */
+    doc->need_rdr = 0;
+    doc->data_content = 0;
+    doc->have_head = 1;
+    doc->have_body = 1;
+
+    doc->refc = 1;
+
+    doc->ops = &_pcdoc_compact_html_ops;
+    doc->impl = cdoc;
+    return doc;
+
+failed:
+    release_impl(cdoc);
+    return NULL;
+}
+
+static void destroy(purc_document_t doc)
+{
+    assert(doc->impl);
+    release_impl(compact_doc(doc));
+    free(doc);
+}
+
+static int reset(purc_document_t doc, const char *content, size_t length)
+{
+    struct compact_doc *cdoc = compact_doc(doc);
+
+    /* keeps the arrays and the buffer for the content */
+    cdoc->nr_nodes = 1;
+    cdoc->free_nodes = CNODE_NULL;
+    cdoc->nr_attrs = 1;
+    cdoc->free_attrs = CATTR_NULL;
+    cdoc->len_text = 0;
+    cdoc->root = cdoc->head = cdoc->body = CNODE_NULL;
+
+    return load_content(cdoc, content, length);
+}
+
+static pcdoc_element_t operate_element(purc_document_t doc,
+            pcdoc_element_t elem, pcdoc_operation op,
+            const char *tag, bool self_close)
+{
+    UNUSED_PARAM(self_close);
+
+    struct compact_doc *cdoc = compact_doc(doc);
+    uint32_t id = valid_node(cdoc, elem, CNODE_ELEMENT);
+    if (id == CNODE_NULL)
+        return NULL;
+
+    if (op == PCDOC_OP_ERASE) {
+        if (id == cdoc->root) {
+            purc_set_error(PURC_ERROR_NOT_SUPPORTED);
+            return NULL;
+        }
+
+        unlink_node(cdoc, id);
+        free_subtree(cdoc, id);
+        return NULL;
+    }
+    else if (op == PCDOC_OP_CLEAR) {
+        erase_children(cdoc, id);
+        return elem;
+    }
+
+    if (UNLIKELY(op > PCDOC_OP_DISPLACE)) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return NULL;
+    }
+
+    uint32_t new_elem = new_element(cdoc, tag, strlen(tag));
+    if (new_elem == CNODE_NULL)
+        return NULL;
+
+    place_node(cdoc, id, op, new_elem);
+    return HANDLE_OF(new_elem);
+}
+
+static pcdoc_text_node_t new_text_content(purc_document_t doc,
+            pcdoc_element_t elem, pcdoc_operation op,
+            const char *text, size_t length)
+{
+    if (UNLIKELY(op > PCDOC_OP_DISPLACE)) {
+        PC_DEBUG("invalid op: %d\n", op);
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return NULL;
+    }
+
+    struct compact_doc *cdoc = compact_doc(doc);
+    uint32_t id = valid_node(cdoc, elem, CNODE_ELEMENT);
+    if (id == CNODE_NULL)
+        return NULL;
+
+    uint32_t text_node = new_text(cdoc, CNODE_TEXT, text,
+            length ? length : strlen(text));
+    if (text_node == CNODE_NULL)
+        return NULL;
+
+    place_node(cdoc, id, op, text_node);
+    return HANDLE_OF(text_node);
+}
+
+static pcdoc_node new_content(purc_document_t doc,
+            pcdoc_element_t elem, pcdoc_operation op,
+            const char *content, size_t length)
+{
+    struct compact_doc *cdoc = compact_doc(doc);
+    pcdoc_node node;
+
+    node.type = PCDOC_NODE_VOID;
+    node.elem = NULL;
+
+    if (UNLIKELY(op > PCDOC_OP_DISPLACE)) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        goto done;
+    }
+
+    uint32_t id = valid_node(cdoc, elem, CNODE_ELEMENT);
+    if (id == CNODE_NULL)
+        goto done;
+
+    uint32_t container = parse_fragment(cdoc, id, content,
+            length ? length : strlen(content));
+    if (container) {
+        place_children(cdoc, id, op, container);
+    }
+    else {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+    }
+
+    node.type = PCDOC_NODE_ELEMENT;
+    node.elem = (pcdoc_element_t)doc;
+
+done:
+    return node;
+}
+
+static int set_attribute(purc_document_t doc,
+            pcdoc_element_t elem, pcdoc_operation op,
+            const char *name, const char *val, size_t len)
+{
+    struct compact_doc *cdoc = compact_doc(doc);
+    uint32_t id = valid_node(cdoc, elem, CNODE_ELEMENT);
+    int r = -1;
+
+    if (id == CNODE_NULL)
+        return -1;
+
+    if (op == PCDOC_OP_ERASE) {
+        r = remove_attr(cdoc, id, name);
+    }
+    else if (op == PCDOC_OP_CLEAR) {
+        r = set_attr(cdoc, id, name, strlen(name), "", 0);
+    }
+    else if (op == PCDOC_OP_DISPLACE) {
+        r = set_attr(cdoc, id, name, strlen(name),
+                val, len ? len : strlen(val));
+    }
+    else {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+    }
+
+    return r;
+}
+
+static pcdoc_element_t special_elem(purc_document_t doc,
+            pcdoc_special_elem which)
+{
+    struct compact_doc *cdoc = compact_doc(doc);
+
+    switch (which) {
+    case PCDOC_SPECIAL_ELEM_ROOT:
+        return HANDLE_OF(cdoc->root);
+
+    case PCDOC_SPECIAL_ELEM_HEAD:
+        return HANDLE_OF(cdoc->head);
+
+    case PCDOC_SPECIAL_ELEM_BODY:
+        return HANDLE_OF(cdoc->body);
+    }
+
+    return NULL;
+}
+
+static pcdoc_element_t get_parent(purc_document_t doc, pcdoc_node node)
+{
+    struct compact_doc *cdoc = compact_doc(doc);
+
+    assert(node.type != PCDOC_NODE_VOID && node.type != PCDOC_NODE_OTHERS);
+
+    uint32_t id = ID_OF(node.elem);
+    assert(id && id < cdoc->nr_nodes);
+
+    return HANDLE_OF(cdoc->parents[id]);
+}
+
+static inline pcdoc_node_type
+node_type(uint8_t kind)
+{
+    switch (kind) {
+        case CNODE_ELEMENT:
+            return PCDOC_NODE_ELEMENT;
+        case CNODE_TEXT:
+            return PCDOC_NODE_TEXT;
+        default:
+            break;
+    }
+
+    return PCDOC_NODE_OTHERS;
+}
+
+static int children_count(purc_document_t doc, pcdoc_element_t elem,
+        size_t *nrs)
+{
+    struct compact_doc *cdoc = compact_doc(doc);
+    uint32_t id = valid_node(cdoc, elem, CNODE_ELEMENT);
+    if (id == CNODE_NULL)
+        return -1;
+
+    for (uint32_t child = cdoc->firsts[id]; child;
+            child = cdoc->nexts[child]) {
+        nrs[node_type(cdoc->kinds[child])]++;
+    }
+
+    return 0;
+}
+
+static pcdoc_node get_child(purc_document_t doc,
+            pcdoc_element_t elem, pcdoc_node_type type, size_t idx)
+{
+    struct compact_doc *cdoc = compact_doc(doc);
+    pcdoc_node node;
+    node.type = PCDOC_NODE_VOID;
+    node.elem = NULL;
+
+    uint32_t id = valid_node(cdoc, elem, CNODE_ELEMENT);
+    if (id == CNODE_NULL)
+        return node;
+
+    size_t i = 0;
+    for (uint32_t child = cdoc->firsts[id]; child;
+            child = cdoc->nexts[child]) {
+        if (node_type(cdoc->kinds[child]) == type) {
+            if (i == idx) {
+                node.type = type;
+                node.elem = HANDLE_OF(child);
+                break;
+            }
+
+            i++;
+        }
+    }
+
+    return node;
+}
+
+static int get_attribute(purc_document_t doc, pcdoc_element_t elem,
+            const char *name, const char **val, size_t *len)
+{
+    struct compact_doc *cdoc = compact_doc(doc);
+    uint32_t id = valid_node(cdoc, elem, CNODE_ELEMENT);
+    if (id == CNODE_NULL)
+        return -1;
+
+    for (uint32_t attr = cdoc->datas[id]; attr;
+            attr = cdoc->attr_nexts[attr]) {
+        if (strcasecmp(name, purc_atom_to_string(cdoc->attr_names[attr]))
+                == 0) {
+            *val = cdoc->text + cdoc->attr_vals[attr];
+            if (len)
+                *len = cdoc->attr_lens[attr];
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+static int get_special_attr(purc_document_t doc, pcdoc_element_t elem,
+            pcdoc_special_attr which, const char **val, size_t *len)
+{
+    struct compact_doc *cdoc = compact_doc(doc);
+    uint32_t id = valid_node(cdoc, elem, CNODE_ELEMENT);
+    if (id == CNODE_NULL)
+        return -1;
+
+    purc_atom_t atom;
+    if (which == PCDOC_ATTR_ID)
+        atom = cdoc->atom_id;
+    else if (which == PCDOC_ATTR_CLASS)
+        atom = cdoc->atom_class;
+    else
+        return 0;
+
+    uint32_t attr = find_attr(cdoc, id, atom, NULL);
+    if (attr == CATTR_NULL)
+        return -1;
+
+    *val = cdoc->text + cdoc->attr_vals[attr];
+    if (len)
+        *len = cdoc->attr_lens[attr];
+    return 0;
+}
+
+static int get_text(purc_document_t doc, pcdoc_text_node_t text_node,
+            const char **text, size_t *len)
+{
+    struct compact_doc *cdoc = compact_doc(doc);
+    uint32_t id = valid_node(cdoc, text_node, CNODE_TEXT);
+    if (id == CNODE_NULL)
+        return -1;
+
+    *text = cdoc->text + cdoc->names[id];
+    if (len)
+        *len = cdoc->datas[id];
+
+    return 0;
+}
+
+static int
+travel(purc_document_t doc, pcdoc_element_t ancestor,
+            pcdoc_node_cb cb, struct pcdoc_travel_info *info)
+{
+    struct compact_doc *cdoc = compact_doc(doc);
+    uint32_t root = valid_node(cdoc, ancestor, CNODE_ELEMENT);
+    if (root == CNODE_NULL)
+        return -1;
+
+    if (info->type == PCDOC_NODE_ELEMENT) {
+        int r = cb(doc, ancestor, info->ctxt);
+        if (r)
+            return -1;
+        info->nr++;
+    }
+
+    /* visits the descendants in document order */
+    uint32_t node = cdoc->firsts[root];
+    while (node) {
+        if (node_type(cdoc->kinds[node]) == info->type) {
+            int r = cb(doc, HANDLE_OF(node), info->ctxt);
+            if (r)
+                return -1;
+            info->nr++;
+        }
+
+        if (cdoc->firsts[node]) {
+            node = cdoc->firsts[node];
+            continue;
+        }
+
+        while (node != root && cdoc->nexts[node] == CNODE_NULL)
+            node = cdoc->parents[node];
+        node = (node == root) ? CNODE_NULL : cdoc->nexts[node];
+    }
+
+    return 0;
+}
+
+/* the children of these elements are not escaped */
+static const char *raw_text_tags[] = {
+    "iframe", "noembed", "noframes", "plaintext", "script", "style", "xmp",
+};
+
+static const char *void_tags[] = {
+    "area", "base", "basefont", "bgsound", "br", "col", "embed", "frame",
+    "hr", "img", "input", "keygen", "link", "meta", "param", "source",
+    "track", "wbr",
+};
+
+static bool
+is_tag_in(const char *tag, const char **tags, size_t nr_tags)
+{
+    for (size_t i = 0; i < nr_tags; i++) {
+        if (strcmp(tag, tags[i]) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+static int
+write_escaped(purc_rwstream_t stm, const char *str, size_t len,
+        bool in_attr)
+{
+    size_t start = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        const char *entity = NULL;
+        size_t skip = 1;
+
+        switch (str[i]) {
+        case '&':
+            entity = "&amp;";
+            break;
+        case '<':
+            if (!in_attr)
+                entity = "&lt;";
+            break;
+        case '>':
+            if (!in_attr)
+                entity = "&gt;";
+            break;
+        case '"':
+            if (in_attr)
+                entity = "&quot;";
+            break;
+        case '\xC2':
+            /* U+00A0 NO-BREAK SPACE */
+            if (i + 1 < len && str[i + 1] == '\xA0') {
+                entity = "&nbsp;";
+                skip = 2;
+            }
+            break;
+        default:
+            break;
+        }
+
+        if (entity) {
+            if (i > start &&
+                    purc_rwstream_write(stm, str + start, i - start) < 0)
+                return -1;
+            if (purc_rwstream_write(stm, entity, strlen(entity)) < 0)
+                return -1;
+            i += skip - 1;
+            start = i + 1;
+        }
+    }
+
+    if (len > start && purc_rwstream_write(stm, str + start, len - start) < 0)
+        return -1;
+    return 0;
+}
+
+static bool
+is_ws_text(const char *text, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        if (!purc_isspace(text[i]))
+            return false;
+    }
+
+    return true;
+}
+
+static int
+write_start_tag(struct compact_doc *cdoc, uint32_t id, unsigned opts,
+        purc_rwstream_t stm)
+{
+    const char *tag = purc_atom_to_string(cdoc->names[id]);
+
+    if (purc_rwstream_write(stm, "<", 1) < 0 ||
+            purc_rwstream_write(stm, tag, strlen(tag)) < 0)
+        return -1;
+
+    for (uint32_t attr = cdoc->datas[id]; attr;
+            attr = cdoc->attr_nexts[attr]) {
+        const char *name = purc_atom_to_string(cdoc->attr_names[attr]);
+        const char *val = cdoc->text + cdoc->attr_vals[attr];
+        size_t len = cdoc->attr_lens[attr];
+
+        if (purc_rwstream_write(stm, " ", 1) < 0 ||
+                purc_rwstream_write(stm, name, strlen(name)) < 0 ||
+                purc_rwstream_write(stm, "=\"", 2) < 0)
+            return -1;
+        if (opts & PCDOC_SERIALIZE_OPT_RAW) {
+            if (purc_rwstream_write(stm, val, len) < 0)
+                return -1;
+        }
+        else if (write_escaped(stm, val, len, true)) {
+            return -1;
+        }
+        if (purc_rwstream_write(stm, "\"", 1) < 0)
+            return -1;
+    }
+
+    if (opts & PCDOC_SERIALIZE_OPT_WITH_HVML_HANDLE) {
+        char buff[LEN_BUFF_LONGLONGINT];
+        int n = snprintf(buff, sizeof(buff), " hvml-handle=%llx",
+                (unsigned long long int)id);
+        if (n < 0 || (size_t)n >= sizeof(buff) ||
+                purc_rwstream_write(stm, buff, n) < 0)
+            return -1;
+    }
+
+    return purc_rwstream_write(stm, ">", 1) < 0 ? -1 : 0;
+}
+
+static int
+write_end_tag(struct compact_doc *cdoc, uint32_t id, unsigned opts,
+        purc_rwstream_t stm)
+{
+    const char *tag = purc_atom_to_string(cdoc->names[id]);
+
+    if ((opts & PCDOC_SERIALIZE_OPT_WITHOUT_CLOSING) ||
+            is_tag_in(tag, void_tags, PCA_TABLESIZE(void_tags)))
+        return 0;
+
+    if (purc_rwstream_write(stm, "</", 2) < 0 ||
+            purc_rwstream_write(stm, tag, strlen(tag)) < 0 ||
+            purc_rwstream_write(stm, ">", 1) < 0)
+        return -1;
+    return 0;
+}
+
+static int
+write_leaf(struct compact_doc *cdoc, uint32_t id, unsigned opts,
+        purc_rwstream_t stm)
+{
+    const char *text = cdoc->text + cdoc->names[id];
+    size_t len = cdoc->datas[id];
+
+    if (cdoc->kinds[id] == CNODE_COMMENT) {
+        if (opts & PCDOC_SERIALIZE_OPT_SKIP_COMMENT)
+            return 0;
+        if (purc_rwstream_write(stm, "<!-- ", 5) < 0 ||
+                purc_rwstream_write(stm, text, len) < 0 ||
+                purc_rwstream_write(stm, " -->", 4) < 0)
+            return -1;
+        return 0;
+    }
+
+    if ((opts & PCDOC_SERIALIZE_OPT_SKIP_WS_NODES) && is_ws_text(text, len))
+        return 0;
+
+    uint32_t parent = cdoc->parents[id];
+    if ((opts & PCDOC_SERIALIZE_OPT_RAW) || (parent &&
+                is_tag_in(purc_atom_to_string(cdoc->names[parent]),
+                    raw_text_tags, PCA_TABLESIZE(raw_text_tags)))) {
+        return purc_rwstream_write(stm, text, len) < 0 ? -1 : 0;
+    }
+
+    return write_escaped(stm, text, len, false);
+}
+
+/* writes the subtree in document order without recursing */
+static int
+write_subtree(struct compact_doc *cdoc, uint32_t root, unsigned opts,
+        purc_rwstream_t stm)
+{
+    if (cdoc->kinds[root] != CNODE_ELEMENT)
+        return write_leaf(cdoc, root, opts, stm);
+
+    uint32_t node = root;
+    for (;;) {
+        if (cdoc->kinds[node] == CNODE_ELEMENT) {
+            if (write_start_tag(cdoc, node, opts, stm))
+                return -1;
+            if (cdoc->firsts[node]) {
+                node = cdoc->firsts[node];
+                continue;
+            }
+            if (write_end_tag(cdoc, node, opts, stm))
+                return -1;
+        }
+        else if (write_leaf(cdoc, node, opts, stm)) {
+            return -1;
+        }
+
+        while (node != root && cdoc->nexts[node] == CNODE_NULL) {
+            node = cdoc->parents[node];
+            if (write_end_tag(cdoc, node, opts, stm))
+                return -1;
+        }
+
+        if (node == root)
+            break;
+        node = cdoc->nexts[node];
+    }
+
+    return 0;
+}
+
+static int serialize(purc_document_t doc, pcdoc_node node,
+            unsigned opts, purc_rwstream_t stm)
+{
+    struct compact_doc *cdoc = compact_doc(doc);
+
+    if (node.type == PCDOC_NODE_OTHERS) {
+        if (cdoc->has_doctype &&
+                purc_rwstream_write(stm, "<!DOCTYPE html>", 15) < 0)
+            return -1;
+        return write_subtree(cdoc, cdoc->root, opts, stm);
+    }
+
+    uint32_t id = ID_OF(node.elem);
+    if (id == CNODE_NULL || id >= cdoc->nr_nodes ||
+            cdoc->kinds[id] == CNODE_FREE) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return -1;
+    }
+
+    return write_subtree(cdoc, id, opts, stm);
+}
+
+static int build_subtree(purc_document_t doc,
+            pcdoc_element_t elem, pcdoc_operation op,
+            const struct pcdoc_build_step *steps, size_t nr_steps,
+            unsigned opts, purc_rwstream_t markup)
+{
+    struct compact_doc *cdoc = compact_doc(doc);
+
+    if (UNLIKELY(op > PCDOC_OP_DISPLACE)) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return -1;
+    }
+
+    uint32_t id = valid_node(cdoc, elem, CNODE_ELEMENT);
+    if (id == CNODE_NULL)
+        return -1;
+
+    /* the nodes are made under a detached container like new_content() */
+    uint32_t container = new_element(cdoc, "div", 3);
+    if (container == CNODE_NULL)
+        return -1;
+
+    uint32_t current = container;
+    for (size_t i = 0; i < nr_steps; i++) {
+        const struct pcdoc_build_step *step = steps + i;
+        size_t len = step->len;
+        uint32_t node;
+
+        switch (step->type) {
+        case PCDOC_BUILD_ELEMENT:
+            node = new_element(cdoc, step->name, strlen(step->name));
+            if (node == CNODE_NULL)
+                goto failed;
+            append_child(cdoc, current, node);
+            current = node;
+            break;
+
+        case PCDOC_BUILD_ATTRIBUTE:
+            if (current == container) {
+                purc_set_error(PURC_ERROR_INVALID_VALUE);
+                goto failed;
+            }
+            if (step->value && len == 0)
+                len = strlen(step->value);
+            if (set_attr(cdoc, current, step->name, strlen(step->name),
+                        step->value ? step->value : "", len))
+                goto failed;
+            break;
+
+        case PCDOC_BUILD_TEXT:
+            if (len == 0)
+                len = strlen(step->value);
+            node = new_text(cdoc, CNODE_TEXT, step->value, len);
+            if (node == CNODE_NULL)
+                goto failed;
+            append_child(cdoc, current, node);
+            break;
+
+        case PCDOC_BUILD_END:
+            if (current == container) {
+                purc_set_error(PURC_ERROR_INVALID_VALUE);
+                goto failed;
+            }
+            current = cdoc->parents[current];
+            break;
+
+        default:
+            purc_set_error(PURC_ERROR_INVALID_VALUE);
+            goto failed;
+        }
+    }
+
+    if (markup) {
+        for (uint32_t child = cdoc->firsts[container]; child;
+                child = cdoc->nexts[child]) {
+            if (write_subtree(cdoc, child, opts, markup))
+                goto failed;
+        }
+    }
+
+    place_children(cdoc, id, op, container);
+    return 0;
+
+failed:
+    free_subtree(cdoc, container);
+    return -1;
+}
+
+/* The selector engine matches eDOM elements only, so the compact document
+   leaves `find_elem`, `elem_coll_select`, and `elem_coll_filter` null and
+   the queries on it find nothing. */
+struct purc_document_ops _pcdoc_compact_html_ops = {
+    .create = create,
+    .destroy = destroy,
+    .operate_element = operate_element,
+    .new_text_content = new_text_content,
+    .new_shared_text_content = NULL,
+    .new_data_content = NULL,
+    .new_content = new_content,
+    .set_attribute = set_attribute,
+    .special_elem = special_elem,
+    .get_parent = get_parent,
+    .children_count = children_count,
+    .get_child = get_child,
+    .get_attribute = get_attribute,
+    .get_special_attr = get_special_attr,
+    .get_text = get_text,
+    .get_data = NULL,
+    .travel = travel,
+    .serialize = serialize,
+    .find_elem = NULL,
+    .elem_coll_select = NULL,
+    .elem_coll_filter = NULL,
+    .build_subtree = build_subtree,
+    .reset = reset,
+};
@@ -92,12 +92,122 @@ purc_document_load(purc_document_type type, const char *content, size_t len)
     return ops->create(content, len);
 }
 
+purc_document_t
+purc_document_load_transient(purc_document_type type,
+        const char *content, size_t len)
+{
+    purc_document_t doc = purc_document_load(type, content, len);
+    if (doc)
+        doc->transient = 1;
+    return doc;
+}
+
+purc_document_t
+purc_document_load_compact(const char *content, size_t len)
+{
+    return _pcdoc_compact_html_ops.create(content, len);
+}
+
 unsigned int
 purc_document_get_refc(purc_document_t doc)
 {
     return doc->refc;
 }
 
+static void
+release_memoized_queries(purc_document_t doc)
+{
+    if (doc->memoized == NULL)
+        return;
+
+    for (size_t i = 0; i < PCDOC_NR_MEMOIZED_QUERIES; i++) {
+        struct pcdoc_memoized_query *memo = doc->memoized + i;
+        if (memo->result) {
+            free(memo->selector);
+            purc_variant_unref(memo->result);
+        }
+    }
+
+    free(doc->memoized);
+    doc->memoized = NULL;
+}
+
+static inline void
+document_mutated(purc_document_t doc)
+{
+    doc->epoch++;
+}
+
+static inline void
+document_added(purc_document_t doc, size_t nr_nodes, size_t len)
+{
+    doc->sz_added += nr_nodes * PCDOC_EST_NODE_SIZE + len;
+}
+
+static struct pcdoc_memoized_query *
+memoized_query_slot(purc_document_t doc, pcdoc_element_t ancestor,
+        const char *selector)
+{
+    /* FNV-1a */
+    uint32_t hash = 2166136261U;
+    for (const char *p = selector; *p; p++) {
+        hash ^= (unsigned char)*p;
+        hash *= 16777619U;
+    }
+    hash ^= (uint32_t)((uintptr_t)ancestor >> 4);
+
+    return doc->memoized + (hash % PCDOC_NR_MEMOIZED_QUERIES);
+}
+
+purc_variant_t
+pcdoc_get_memoized_query(purc_document_t doc, pcdoc_element_t ancestor,
+        const char *selector)
+{
+    if (doc->memoized == NULL)
+        return PURC_VARIANT_INVALID;
+
+    struct pcdoc_memoized_query *memo;
+    memo = memoized_query_slot(doc, ancestor, selector);
+    if (memo->result && memo->epoch == doc->epoch &&
+            memo->ancestor == ancestor &&
+            strcmp(memo->selector, selector) == 0) {
+        return purc_variant_ref(memo->result);
+    }
+
+    return PURC_VARIANT_INVALID;
+}
+
+void
+pcdoc_memoize_query(purc_document_t doc, pcdoc_element_t ancestor,
+        const char *selector, purc_variant_t result)
+{
+    if (doc->memoized == NULL) {
+        doc->memoized = calloc(PCDOC_NR_MEMOIZED_QUERIES,
+                sizeof(struct pcdoc_memoized_query));
+        if (doc->memoized == NULL)
+            return;
+    }
+
+    struct pcdoc_memoized_query *memo;
+    memo = memoized_query_slot(doc, ancestor, selector);
+    if (memo->result == NULL || strcmp(memo->selector, selector)) {
+        char *dup = strdup(selector);
+        if (dup == NULL)
+            return;
+
+        if (memo->result)
+            free(memo->selector);
+        memo->selector = dup;
+    }
+
+    if (memo->result)
+        purc_variant_unref(memo->result);
+
+    memo->ancestor = ancestor;
+    memo->epoch = doc->epoch;
+    memo->result = purc_variant_ref(result);
+}
+
 purc_document_t
 purc_document_ref(purc_document_t doc)
 {
@@ -112,6 +222,8 @@ purc_document_unref(purc_document_t doc)
 
     unsigned int refc = doc->refc;
     if (refc == 0) {
+        release_memoized_queries(doc);
+        pcdoc_release_selectors(doc);
         doc->ops->destroy(doc);
     }
 
@@ -122,10 +234,26 @@ unsigned int
 purc_document_delete(purc_document_t doc)
 {
     unsigned int refc = doc->refc;
+    release_memoized_queries(doc);
+    pcdoc_release_selectors(doc);
     doc->ops->destroy(doc);
     return refc;
 }
 
+int
+purc_document_reset(purc_document_t doc, const char *content, size_t len)
+{
+    if (doc->ops->reset == NULL) {
+        purc_set_error(PURC_ERROR_NOT_SUPPORTED);
+        return -1;
+    }
+
+    release_memoized_queries(doc);
+    pcdoc_release_selectors(doc);
+    document_mutated(doc);
+    return doc->ops->reset(doc, content, len);
+}
+
 pcdoc_element_t
 purc_document_special_elem(purc_document_t doc, pcdoc_special_elem elem)
 {
@@ -137,18 +265,22 @@ pcdoc_element_new_element(purc_document_t doc,
         pcdoc_element_t elem, pcdoc_operation op,
         const char *tag, bool self_close)
 {
+    document_mutated(doc);
+    document_added(doc, 1, tag ? strlen(tag) : 0);
     return doc->ops->operate_element(doc, elem, op, tag, self_close);
 }
 
 void
 pcdoc_element_clear(purc_document_t doc, pcdoc_element_t elem)
 {
+    document_mutated(doc);
     doc->ops->operate_element(doc, elem, PCDOC_OP_CLEAR, NULL, 0);
 }
 
 void
 pcdoc_element_erase(purc_document_t doc, pcdoc_element_t elem)
 {
+    document_mutated(doc);
     doc->ops->operate_element(doc, elem, PCDOC_OP_ERASE, NULL, 0);
 }
 
@@ -157,16 +289,42 @@ pcdoc_element_new_text_content(purc_document_t doc,
         pcdoc_element_t elem, pcdoc_operation op,
         const char *text, size_t len)
 {
+    document_mutated(doc);
+    document_added(doc, 1, len);
     return doc->ops->new_text_content(doc, elem, op, text, len);
 }
 
+pcdoc_text_node_t
+pcdoc_element_new_text_content_ex(purc_document_t doc,
+        pcdoc_element_t elem, pcdoc_operation op,
+        purc_variant_t text, unsigned flags)
+{
+    size_t len;
+    const char *str = purc_variant_get_string_const_ex(text, &len);
+    if (str == NULL) {
+        purc_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+        return NULL;
+    }
+
+    document_mutated(doc);
+    document_added(doc, 1, len);
+    if ((flags & PCDOC_TEXT_CONTENT_F_SHARED) &&
+            doc->ops->new_shared_text_content && len >= PCDOC_MIN_SHARED_TEXT)
+        return doc->ops->new_shared_text_content(doc, elem, op, text);
+
+    return doc->ops->new_text_content(doc, elem, op, str, len);
+}
+
 pcdoc_data_node_t
 pcdoc_element_set_data_content(purc_document_t doc,
         pcdoc_element_t elem, pcdoc_operation op,
         purc_variant_t data)
 {
-    if (doc->ops->new_data_content)
+    if (doc->ops->new_data_content) {
+        document_mutated(doc);
+        document_added(doc, 1, 0);
         return doc->ops->new_data_content(doc, elem, op, data);
+    }
 
     purc_set_error(PURC_ERROR_NOT_SUPPORTED);
     return NULL;
@@ -177,15 +335,48 @@ pcdoc_element_new_content(purc_document_t doc,
         pcdoc_element_t elem, pcdoc_operation op,
         const char *content, size_t len)
 {
+    document_mutated(doc);
+    document_added(doc, 1, len);
     return doc->ops->new_content(doc, elem, op, content, len);
 }
 
+int
+pcdoc_element_build_subtree(purc_document_t doc,
+        pcdoc_element_t elem, pcdoc_operation op,
+        const struct pcdoc_build_step *steps, size_t nr_steps,
+        unsigned opts, purc_rwstream_t markup)
+{
+    if (doc->ops->build_subtree) {
+        document_mutated(doc);
+        document_added(doc, nr_steps, 0);
+        return doc->ops->build_subtree(doc, elem, op, steps, nr_steps,
+                opts, markup);
+    }
+
+    purc_set_error(PURC_ERROR_NOT_SUPPORTED);
+    return -1;
+}
+
+const struct pcdoc_build_step *
+pcdoc_element_parse_steps(purc_document_t doc, pcdoc_element_t elem,
+        const char *markup, size_t len, size_t *nr_steps)
+{
+    if (doc->ops->parse_steps) {
+        return doc->ops->parse_steps(doc, elem, markup,
+                len ? len : strlen(markup), nr_steps);
+    }
+
+    purc_set_error(PURC_ERROR_NOT_SUPPORTED);
+    return NULL;
+}
+
 int
 pcdoc_element_set_attribute(purc_document_t doc,
         pcdoc_element_t elem, pcdoc_operation op,
         const char *name, const char *val, size_t len)
 {
     if (doc->ops->set_attribute) {
+        document_mutated(doc);
         return doc->ops->set_attribute(doc, elem, op, name, val, len);
     }
 
@@ -303,6 +494,7 @@ pcdoc_element_children_count(purc_document_t doc, pcdoc_element_t elem,
                 *nr_text_nodes = nrs[PCDOC_NODE_TEXT];
             if (nr_data_nodes)
                 *nr_data_nodes = nrs[PCDOC_NODE_DATA];
+            return 0;
         }
         else {
             return -1;
@@ -494,6 +686,14 @@ purc_document_serialize_contents_to_stream(purc_document_t doc,
     return 0;
 }
 
+unsigned
+purc_document_set_serialize_workers(purc_document_t doc, unsigned nr_workers)
+{
+    unsigned old = doc->nr_serialize_workers;
+    doc->nr_serialize_workers = nr_workers;
+    return old;
+}
+
 pcdoc_element_t
 pcdoc_find_element_in_descendants(purc_document_t doc,
         pcdoc_element_t ancestor, const char *selector)
@@ -536,7 +736,7 @@ pcdoc_elem_coll_new_from_descendants(purc_document_t doc,
                     PCDOC_SPECIAL_ELEM_ROOT);
         }
 
-        if (!doc->ops->elem_coll_select(doc, coll, ancestor, selector)) {
+        if (doc->ops->elem_coll_select(doc, coll, ancestor, selector)) {
             pcdoc_elem_coll_delete(doc, coll);
             coll = NULL;
         }
@@ -552,7 +752,7 @@ pcdoc_elem_coll_filter(purc_document_t doc,
     pcdoc_elem_coll_t dst_coll = element_collection_new(selector);
 
     if (doc->ops->elem_coll_filter) {
-        if (!doc->ops->elem_coll_filter(doc, dst_coll,
+        if (doc->ops->elem_coll_filter(doc, dst_coll,
                 elem_coll, selector)) {
             pcdoc_elem_coll_delete(doc, dst_coll);
             dst_coll = NULL;
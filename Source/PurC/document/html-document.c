@@ -29,8 +29,169 @@
 #include "purc-html.h"
 
 #include "private/document.h"
+#include "private/kvlist.h"
 #include "private/debug.h"
 
+#include <strings.h>
+
+/* the ID and class indexes; every list holds the elements in no order */
+struct pcdoc_elem_index {
+    struct kvlist   ids;        // id -> struct pcutils_arrlist *
+    struct kvlist   classes;    // class -> struct pcutils_arrlist *
+};
+
+#define SZ_KEY_BUFF     64
+
+static void
+index_update(struct kvlist *kv, const char *token, size_t len,
+        pcdom_element_t *elem, bool add)
+{
+    char buff[SZ_KEY_BUFF];
+    char *key = buff;
+
+    if (len >= sizeof(buff) && (key = malloc(len + 1)) == NULL)
+        return;
+    memcpy(key, token, len);
+    key[len] = '\0';
+
+    struct pcutils_arrlist **data = pcutils_kvlist_get(kv, key);
+    struct pcutils_arrlist *elems = data ? *data : NULL;
+    if (add) {
+        if (elems == NULL) {
+            elems = pcutils_arrlist_new_ex(NULL, 1);
+            if (elems == NULL || !pcutils_kvlist_set(kv, key, &elems)) {
+                if (elems)
+                    pcutils_arrlist_free(elems);
+                goto done;
+            }
+        }
+
+        pcutils_arrlist_append(elems, elem);
+    }
+    else if (elems) {
+        size_t n = pcutils_arrlist_length(elems);
+        for (size_t i = 0; i < n; i++) {
+            if (pcutils_arrlist_get_idx(elems, i) == elem) {
+                pcutils_arrlist_del_idx(elems, i, 1);
+                break;
+            }
+        }
+
+        if (pcutils_arrlist_length(elems) == 0) {
+            pcutils_arrlist_free(elems);
+            pcutils_kvlist_delete(kv, key);
+        }
+    }
+
+done:
+    if (key != buff)
+        free(key);
+}
+
+static inline bool
+is_class_ws(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+static void
+index_element(struct pcdoc_elem_index *index, pcdom_element_t *elem,
+        bool add)
+{
+    size_t len;
+    const char *val;
+
+    val = (const char *)pcdom_element_id(elem, &len);
+    if (val && len > 0)
+        index_update(&index->ids, val, len, elem, add);
+
+    val = (const char *)pcdom_element_class(elem, &len);
+    if (val) {
+        const char *end = val + len;
+        while (val < end) {
+            while (val < end && is_class_ws(*val))
+                val++;
+
+            const char *start = val;
+            while (val < end && !is_class_ws(*val))
+                val++;
+
+            if (val > start)
+                index_update(&index->classes, start, val - start, elem, add);
+        }
+    }
+}
+
+/* indexes or unindexes the elements in the subtree rooted at node */
+static void
+index_subtree(struct pcdoc_elem_index *index, pcdom_node_t *root, bool add)
+{
+    pcdom_node_t *node = root;
+
+    while (node) {
+        if (node->type == PCDOM_NODE_TYPE_ELEMENT)
+            index_element(index, pcdom_interface_element(node), add);
+
+        if (node->first_child) {
+            node = node->first_child;
+        }
+        else {
+            while (node != root && node->next == NULL)
+                node = node->parent;
+
+            if (node == root)
+                break;
+            node = node->next;
+        }
+    }
+}
+
+static void
+index_children(struct pcdoc_elem_index *index, pcdom_node_t *parent,
+        bool add)
+{
+    for (pcdom_node_t *child = parent->first_child; child;
+            child = child->next) {
+        index_subtree(index, child, add);
+    }
+}
+
+static void
+index_destroy(struct pcdoc_elem_index *index)
+{
+    const char *name;
+    void *next, *data;
+
+    kvlist_for_each_safe(&index->ids, name, next, data) {
+        pcutils_arrlist_free(*(struct pcutils_arrlist **)data);
+    }
+    pcutils_kvlist_free(&index->ids);
+
+    kvlist_for_each_safe(&index->classes, name, next, data) {
+        pcutils_arrlist_free(*(struct pcutils_arrlist **)data);
+    }
+    pcutils_kvlist_free(&index->classes);
+
+    free(index);
+}
+
+static struct pcdoc_elem_index *
+index_build(purc_document_t doc)
+{
+    struct pcdoc_elem_index *index = calloc(1, sizeof(*index));
+    if (index) {
+        pcutils_kvlist_init(&index->ids, NULL);
+        pcutils_kvlist_init(&index->classes, NULL);
+
+        pchtml_html_document_t *html_doc = doc->impl;
+        pcdom_node_t *root;
+        root = pcdom_interface_node(pchtml_doc_get_document(html_doc));
+        index_children(index, root, true);
+    }
+
+    return index;
+}
+
 static purc_document_t create(const char *content, size_t length)
 {
     pchtml_html_document_t *html_doc;
@@ -72,13 +233,89 @@ static purc_document_t create(const char *content, size_t length)
     return doc;
 }
 
+/* the children of one type of an element in order, valid in an epoch */
+struct pcdoc_child_cache {
+    pcdom_node_t       *parent;
+    pcdoc_node_type     type;
+    uint64_t            epoch;
+
+    size_t              nr_nodes;
+    size_t              sz_nodes;
+    pcdom_node_t      **nodes;
+};
+
+/* the children before this index are reached by walking the list */
+#define NR_CHILDREN_WALKED      8
+
+static void
+child_cache_destroy(struct pcdoc_child_cache *cache)
+{
+    free(cache->nodes);
+    free(cache);
+}
+
+static void
+steps_cache_destroy(struct pcdoc_steps_cache *cache);
+
 static void destroy(purc_document_t doc)
 {
     assert(doc->impl);
+    if (doc->index)
+        index_destroy(doc->index);
+    if (doc->child_cache)
+        child_cache_destroy(doc->child_cache);
+    if (doc->serial_cache)
+        pchtml_html_serialize_cache_delete(doc->serial_cache);
+    if (doc->steps_cache)
+        steps_cache_destroy(doc->steps_cache);
     pchtml_html_document_destroy(doc->impl);
     free(doc);
 }
 
+static int reset(purc_document_t doc, const char *content, size_t length)
+{
+    if (doc->index) {
+        index_destroy(doc->index);
+        doc->index = NULL;
+    }
+    if (doc->child_cache) {
+        child_cache_destroy(doc->child_cache);
+        doc->child_cache = NULL;
+    }
+    if (doc->serial_cache) {
+        pchtml_html_serialize_cache_delete(doc->serial_cache);
+        doc->serial_cache = NULL;
+    }
+    /* the names of the custom tags are released with the nodes */
+    if (doc->steps_cache) {
+        steps_cache_destroy(doc->steps_cache);
+        doc->steps_cache = NULL;
+    }
+
+    if (content == NULL) {
+        content = "<html></html>";
+        length = 0;
+    }
+
+    if (length == 0) {
+        length = strlen(content);
+    }
+
+    /* releases all nodes but keeps the first block of the arena */
+    pchtml_html_document_clean(doc->impl);
+
+    unsigned int r;
+    r = pchtml_html_document_parse_with_buf(doc->impl,
+            (const unsigned char*)content, length);
+    if (r) {
+        PC_WARN("bad content\n");
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return -1;
+    }
+
+    return 0;
+}
+
 static void
 dom_append_node_to_element(pcdom_element_t *element,
         pcdom_node_t *node)
@@ -151,18 +388,51 @@ dom_clear_element(pcdom_element_t *element)
     }
 }
 
+/* In a transient document, the nodes removed are left in the arena of the
+   document, which is released as a whole when the document is destroyed or
+   reset, instead of being freed one by one. */
+static void
+dom_detach_children(pcdom_element_t *element)
+{
+    pcdom_node_t *parent = pcdom_interface_node(element);
+    while (parent->first_child != NULL) {
+        pcdom_node_remove(parent->first_child);
+    }
+}
+
+static inline void
+transient_displace(purc_document_t doc, pcdoc_element_t elem,
+        pcdoc_operation op)
+{
+    /* leaves nothing for the displacing operation to destroy */
+    if (doc->transient && op == PCDOC_OP_DISPLACE)
+        dom_detach_children(pcdom_interface_element(elem));
+}
+
 static pcdoc_element_t operate_element(purc_document_t doc,
             pcdoc_element_t elem, pcdoc_operation op,
             const char *tag, bool self_close)
 {
     UNUSED_PARAM(self_close);
 
+    pchtml_html_serialize_cache_invalidate(pcdom_interface_node(elem));
+
     if (op == PCDOC_OP_ERASE) {
-        dom_erase_element(pcdom_interface_element(elem));
+        if (doc->index)
+            index_subtree(doc->index, pcdom_interface_node(elem), false);
+        if (doc->transient)
+            pcdom_node_remove(pcdom_interface_node(elem));
+        else
+            dom_erase_element(pcdom_interface_element(elem));
         return NULL;
     }
     else if (op == PCDOC_OP_CLEAR) {
-        dom_clear_element(pcdom_interface_element(elem));
+        if (doc->index)
+            index_children(doc->index, pcdom_interface_node(elem), false);
+        if (doc->transient)
+            dom_detach_children(pcdom_interface_element(elem));
+        else
+            dom_clear_element(pcdom_interface_element(elem));
         return elem;
     }
 
@@ -177,6 +447,10 @@ static pcdoc_element_t operate_element(purc_document_t doc,
     new_elem = pcdom_document_create_element(dom_doc,
             (const unsigned char*)tag, strlen(tag), NULL);
     if (new_elem) {
+        /* the new element has no attribute, so needs no indexing */
+        if (op == PCDOC_OP_DISPLACE && doc->index)
+            index_children(doc->index, pcdom_interface_node(elem), false);
+        transient_displace(doc, elem, op);
         dom_node_ops[op](dom_elem, pcdom_interface_node(new_elem));
     }
     else {
@@ -203,6 +477,10 @@ static pcdoc_text_node_t new_text_content(purc_document_t doc,
     text_node = pcdom_document_create_text_node(dom_doc,
             (const unsigned char *)text, length ? length : strlen(text));
     if (text_node) {
+        pchtml_html_serialize_cache_invalidate(pcdom_interface_node(elem));
+        if (op == PCDOC_OP_DISPLACE && doc->index)
+            index_children(doc->index, pcdom_interface_node(elem), false);
+        transient_displace(doc, elem, op);
         dom_node_ops[op](dom_elem, pcdom_interface_node(text_node));
     }
     else {
@@ -212,6 +490,34 @@ static pcdoc_text_node_t new_text_content(purc_document_t doc,
     return (pcdoc_text_node_t)text_node;
 }
 
+static pcdoc_text_node_t new_shared_text_content(purc_document_t doc,
+            pcdoc_element_t elem, pcdoc_operation op, purc_variant_t text)
+{
+    if (UNLIKELY(op >= PCA_TABLESIZE(dom_node_ops))) {
+        PC_DEBUG("invalid op: %d\n", op);
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return NULL;
+    }
+
+    pcdom_document_t *dom_doc = pcdom_interface_document(doc->impl);
+    pcdom_element_t *dom_elem = pcdom_interface_element(elem);
+    pcdom_text_t *text_node;
+
+    text_node = pcdom_document_create_text_node_shared(dom_doc, text);
+    if (text_node) {
+        pchtml_html_serialize_cache_invalidate(pcdom_interface_node(elem));
+        if (op == PCDOC_OP_DISPLACE && doc->index)
+            index_children(doc->index, pcdom_interface_node(elem), false);
+        transient_displace(doc, elem, op);
+        dom_node_ops[op](dom_elem, pcdom_interface_node(text_node));
+    }
+    else {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    }
+
+    return (pcdoc_text_node_t)text_node;
+}
+
 static pcdom_node_t *
 dom_parse_fragment(pcdom_document_t *dom_doc,
         pcdom_element_t *parent, const char *fragment, size_t length)
@@ -385,6 +691,15 @@ static pcdoc_node new_content(purc_document_t doc,
             content, length ? length : strlen(content));
 
     if (subtree) {
+        pchtml_html_serialize_cache_invalidate(pcdom_interface_node(elem));
+        if (doc->index) {
+            if (op == PCDOC_OP_DISPLACE)
+                index_children(doc->index, pcdom_interface_node(elem), false);
+            /* the children of the wrapping <div> are moved into place */
+            if (subtree->first_child)
+                index_children(doc->index, subtree->first_child, true);
+        }
+        transient_displace(doc, elem, op);
         dom_subtree_ops[op](dom_elem, subtree);
     }
     else {
@@ -425,26 +740,386 @@ static int set_attribute(purc_document_t doc,
             pcdoc_element_t elem, pcdoc_operation op,
             const char *name, const char *val, size_t len)
 {
-    UNUSED_PARAM(doc);
-
     pcdom_element_t *dom_elem = pcdom_interface_element(elem);
+    bool indexed = doc->index &&
+        (strcasecmp(name, "id") == 0 || strcasecmp(name, "class") == 0);
+    int r = -1;
+
+    pchtml_html_serialize_cache_invalidate(pcdom_interface_node(dom_elem));
+    if (indexed)
+        index_element(doc->index, dom_elem, false);
+
     if (op == PCDOC_OP_ERASE) {
-        return dom_remove_element_attr(dom_elem, name);
+        r = dom_remove_element_attr(dom_elem, name);
     }
     else if (op == PCDOC_OP_CLEAR) {
-        return dom_set_element_attribute(dom_elem, name, "", 0);
+        r = dom_set_element_attribute(dom_elem, name, "", 0);
     }
     else if (op == PCDOC_OP_DISPLACE) {
-        return dom_set_element_attribute(dom_elem, name,
+        r = dom_set_element_attribute(dom_elem, name,
                 val, len ? len : strlen(val));
     }
     else {
         purc_set_error(PURC_ERROR_INVALID_VALUE);
     }
 
+    if (indexed)
+        index_element(doc->index, dom_elem, true);
+
+    return r;
+}
+
+static int build_subtree(purc_document_t doc,
+            pcdoc_element_t elem, pcdoc_operation op,
+            const struct pcdoc_build_step *steps, size_t nr_steps,
+            unsigned opts, purc_rwstream_t markup)
+{
+    if (UNLIKELY(op >= PCA_TABLESIZE(dom_subtree_ops))) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return -1;
+    }
+
+    pcdom_document_t *dom_doc = pcdom_interface_document(doc->impl);
+    pcdom_element_t *dom_elem = pcdom_interface_element(elem);
+
+    /* the nodes are made under a <div> in a fragment like new_content() */
+    pcdom_document_fragment_t *frag;
+    frag = pcdom_document_create_document_fragment(dom_doc);
+    if (frag == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    pcdom_node_t *subtree = pcdom_interface_node(frag);
+    pcdom_element_t *div = pcdom_document_create_element(dom_doc,
+            (const unsigned char *)"div", 3, NULL);
+    if (div == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto failed;
+    }
+    pcdom_node_append_child(subtree, pcdom_interface_node(div));
+
+    pcdom_node_t *container = pcdom_interface_node(div);
+    pcdom_node_t *current = container;
+    for (size_t i = 0; i < nr_steps; i++) {
+        const struct pcdoc_build_step *step = steps + i;
+        size_t len = step->len;
+
+        switch (step->type) {
+        case PCDOC_BUILD_ELEMENT: {
+            pcdom_element_t *new_elem;
+            new_elem = pcdom_document_create_element(dom_doc,
+                    (const unsigned char *)step->name, strlen(step->name),
+                    NULL);
+            if (new_elem == NULL) {
+                purc_set_error(PURC_ERROR_INVALID_VALUE);
+                goto failed;
+            }
+            pcdom_node_append_child(current, pcdom_interface_node(new_elem));
+            current = pcdom_interface_node(new_elem);
+            break;
+        }
+
+        case PCDOC_BUILD_ATTRIBUTE:
+            if (current == container) {
+                purc_set_error(PURC_ERROR_INVALID_VALUE);
+                goto failed;
+            }
+            if (step->value && len == 0)
+                len = strlen(step->value);
+            if (dom_set_element_attribute(pcdom_interface_element(current),
+                        step->name, step->value ? step->value : "", len)) {
+                purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+                goto failed;
+            }
+            break;
+
+        case PCDOC_BUILD_TEXT: {
+            pcdom_text_t *text_node;
+            if (len == 0)
+                len = strlen(step->value);
+            text_node = pcdom_document_create_text_node(dom_doc,
+                    (const unsigned char *)step->value, len);
+            if (text_node == NULL) {
+                purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+                goto failed;
+            }
+            pcdom_node_append_child(current, pcdom_interface_node(text_node));
+            break;
+        }
+
+        case PCDOC_BUILD_END:
+            if (current == container) {
+                purc_set_error(PURC_ERROR_INVALID_VALUE);
+                goto failed;
+            }
+            current = current->parent;
+            break;
+
+        default:
+            purc_set_error(PURC_ERROR_INVALID_VALUE);
+            goto failed;
+        }
+    }
+
+    if (markup) {
+        for (pcdom_node_t *child = container->first_child; child;
+                child = child->next) {
+            if (pcdom_node_write_to_stream_ex(child, opts, markup))
+                goto failed;
+        }
+    }
+
+    pchtml_html_serialize_cache_invalidate(pcdom_interface_node(dom_elem));
+    if (doc->index) {
+        if (op == PCDOC_OP_DISPLACE)
+            index_children(doc->index, pcdom_interface_node(elem), false);
+        index_children(doc->index, container, true);
+    }
+    transient_displace(doc, elem, op);
+    dom_subtree_ops[op](dom_elem, subtree);
+    return 0;
+
+failed:
+    pcdom_node_destroy_deep(subtree);
     return -1;
 }
 
+/* the steps parsed from a markup as the content of a kind of element */
+struct pcdoc_parsed_steps {
+    uintptr_t                   context;    /* the local name */
+    uintptr_t                   context_ns;
+    size_t                      len;
+    /* NULL if the markup makes the nodes not built by steps */
+    struct pcdoc_build_step    *steps;
+    size_t                      nr_steps;
+
+    /* the markup, then the steps and their strings follow */
+    char                        markup[];
+};
+
+#define PCDOC_NR_PARSED_STEPS       8
+
+struct pcdoc_steps_cache {
+    unsigned                    next;       /* the slot to replace next */
+    struct pcdoc_parsed_steps  *slots[PCDOC_NR_PARSED_STEPS];
+};
+
+static void
+steps_cache_destroy(struct pcdoc_steps_cache *cache)
+{
+    for (size_t i = 0; i < PCA_TABLESIZE(cache->slots); i++)
+        free(cache->slots[i]);
+    free(cache);
+}
+
+/* counts the steps and the bytes of the strings first, then fills them */
+struct steps_writer {
+    struct pcdoc_build_step    *steps;
+    char                       *pool;
+    size_t                      nr_steps;
+    size_t                      sz_pool;
+};
+
+static const char *
+steps_writer_copy(struct steps_writer *w, const unsigned char *str,
+        size_t len)
+{
+    char *p = NULL;
+    if (w->pool) {
+        p = w->pool + w->sz_pool;
+        memcpy(p, str, len);
+        p[len] = '\0';
+    }
+    w->sz_pool += len + 1;
+    return p;
+}
+
+static void
+steps_writer_add(struct steps_writer *w, pcdoc_build_step_type type,
+        const unsigned char *name, size_t name_len,
+        const unsigned char *value, size_t value_len)
+{
+    const char *n = name ? steps_writer_copy(w, name, name_len) : NULL;
+    const char *v = value ? steps_writer_copy(w, value, value_len) : NULL;
+    if (w->steps) {
+        struct pcdoc_build_step *step = w->steps + w->nr_steps;
+        step->type = type;
+        step->name = n;
+        step->value = v;
+        step->len = value_len;
+    }
+    w->nr_steps++;
+}
+
+/* walks the children of the container in order; returns -1 if there is
+   a node which can not be built by steps */
+static int
+steps_writer_walk(struct steps_writer *w, pcdom_node_t *container)
+{
+    pcdom_node_t *node = container->first_child;
+    while (node) {
+        const unsigned char *str;
+        size_t len;
+
+        if (node->type == PCDOM_NODE_TYPE_ELEMENT) {
+            pcdom_element_t *elem = pcdom_interface_element(node);
+            str = pcdom_element_local_name(elem, &len);
+            /* the elements are made in the namespace of the container,
+               and the content of <template> is not in the children */
+            if (node->ns != container->ns ||
+                    (len == 8 && memcmp(str, "template", 8) == 0))
+                return -1;
+            steps_writer_add(w, PCDOC_BUILD_ELEMENT, str, len, NULL, 0);
+
+            pcdom_attr_t *attr = pcdom_element_first_attribute(elem);
+            while (attr) {
+                size_t value_len;
+                const unsigned char *value;
+                str = pcdom_attr_qualified_name(attr, &len);
+                value = pcdom_attr_value(attr, &value_len);
+                steps_writer_add(w, PCDOC_BUILD_ATTRIBUTE, str, len,
+                        value ? value : (const unsigned char *)"",
+                        value ? value_len : 0);
+                attr = pcdom_element_next_attribute(attr);
+            }
+
+            if (node->first_child) {
+                node = node->first_child;
+                continue;
+            }
+            steps_writer_add(w, PCDOC_BUILD_END, NULL, 0, NULL, 0);
+        }
+        else if (node->type == PCDOM_NODE_TYPE_TEXT) {
+            pcdom_text_t *text = pcdom_interface_text(node);
+            len = text->char_data.data.length;
+            /* a text step of zero length is taken as null-terminated */
+            if (len > 0) {
+                steps_writer_add(w, PCDOC_BUILD_TEXT, NULL, 0,
+                        text->char_data.data.data, len);
+            }
+        }
+        else {
+            return -1;
+        }
+
+        /* the next sibling, or the one of the nearest ancestor */
+        while (node->next == NULL) {
+            node = node->parent;
+            if (node == container)
+                return 0;
+            steps_writer_add(w, PCDOC_BUILD_END, NULL, 0, NULL, 0);
+        }
+        node = node->next;
+    }
+
+    return 0;
+}
+
+static struct pcdoc_parsed_steps *
+parse_steps_in(purc_document_t doc, pcdom_element_t *dom_elem,
+        const char *markup, size_t len)
+{
+    pcdom_document_t *dom_doc = pcdom_interface_document(doc->impl);
+    pcdom_node_t *subtree = dom_parse_fragment(dom_doc, dom_elem,
+            markup, len);
+    if (subtree == NULL) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return NULL;
+    }
+
+    pcdom_node_t *container = subtree->first_child;
+    struct steps_writer w = { NULL, NULL, 0, 0 };
+    bool ok = (container == NULL || steps_writer_walk(&w, container) == 0);
+
+    size_t sz = sizeof(struct pcdoc_parsed_steps) + len + 1;
+    size_t off_steps = 0;
+    if (ok) {
+        off_steps = (sz + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+        sz = off_steps + sizeof(struct pcdoc_build_step) * w.nr_steps +
+            w.sz_pool;
+    }
+
+    struct pcdoc_parsed_steps *parsed = malloc(sz);
+    if (parsed == NULL) {
+        pcdom_node_destroy_deep(subtree);
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    pcdom_node_t *context = pcdom_interface_node(dom_elem);
+    parsed->context = context->local_name;
+    parsed->context_ns = context->ns;
+    parsed->len = len;
+    memcpy(parsed->markup, markup, len);
+    parsed->markup[len] = '\0';
+    parsed->steps = NULL;
+    parsed->nr_steps = 0;
+
+    if (ok) {
+        parsed->steps = (struct pcdoc_build_step *)((char *)parsed +
+                off_steps);
+        w.steps = parsed->steps;
+        w.pool = (char *)(parsed->steps + w.nr_steps);
+        w.nr_steps = 0;
+        w.sz_pool = 0;
+        if (container)
+            steps_writer_walk(&w, container);
+        parsed->nr_steps = w.nr_steps;
+    }
+
+    pcdom_node_destroy_deep(subtree);
+    return parsed;
+}
+
+static const struct pcdoc_build_step *
+parse_steps(purc_document_t doc, pcdoc_element_t elem,
+        const char *markup, size_t len, size_t *nr_steps)
+{
+    struct pcdoc_steps_cache *cache = doc->steps_cache;
+    if (cache == NULL) {
+        cache = calloc(1, sizeof(*cache));
+        if (cache == NULL) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return NULL;
+        }
+        doc->steps_cache = cache;
+    }
+
+    /* the result of parsing depends on the kind of the element */
+    pcdom_node_t *context = pcdom_interface_node(elem);
+    struct pcdoc_parsed_steps *parsed = NULL;
+    for (size_t i = 0; i < PCA_TABLESIZE(cache->slots); i++) {
+        struct pcdoc_parsed_steps *p = cache->slots[i];
+        if (p && p->context == context->local_name &&
+                p->context_ns == context->ns && p->len == len &&
+                memcmp(p->markup, markup, len) == 0) {
+            parsed = p;
+            break;
+        }
+    }
+
+    if (parsed == NULL) {
+        parsed = parse_steps_in(doc, pcdom_interface_element(elem),
+                markup, len);
+        if (parsed == NULL)
+            return NULL;
+
+        free(cache->slots[cache->next]);
+        cache->slots[cache->next] = parsed;
+        cache->next = (cache->next + 1) % PCA_TABLESIZE(cache->slots);
+    }
+
+    /* the failure is kept as well to not parse the markup again */
+    if (parsed->steps == NULL) {
+        purc_set_error(PURC_ERROR_NOT_SUPPORTED);
+        return NULL;
+    }
+
+    *nr_steps = parsed->nr_steps;
+    return parsed->steps;
+}
+
 static pcdoc_element_t special_elem(purc_document_t doc,
             pcdoc_special_elem which)
 {
@@ -522,17 +1197,71 @@ node_type(pcdom_node_type_t type)
     return PCDOC_NODE_OTHERS;
 }
 
+static struct pcdoc_child_cache *
+child_cache_fill(purc_document_t doc, pcdom_node_t *parent,
+        pcdoc_node_type type)
+{
+    struct pcdoc_child_cache *cache = doc->child_cache;
+    if (cache == NULL) {
+        cache = calloc(1, sizeof(*cache));
+        if (cache == NULL)
+            return NULL;
+        doc->child_cache = cache;
+    }
+
+    cache->parent = NULL;
+    cache->nr_nodes = 0;
+    for (pcdom_node_t *child = parent->first_child; child;
+            child = child->next) {
+        if (node_type(child->type) != type)
+            continue;
+
+        if (cache->nr_nodes == cache->sz_nodes) {
+            size_t sz = cache->sz_nodes ? cache->sz_nodes * 2 : 16;
+            pcdom_node_t **nodes = realloc(cache->nodes, sz * sizeof(*nodes));
+            if (nodes == NULL)
+                return NULL;
+            cache->nodes = nodes;
+            cache->sz_nodes = sz;
+        }
+
+        cache->nodes[cache->nr_nodes++] = child;
+    }
+
+    cache->parent = parent;
+    cache->type = type;
+    cache->epoch = doc->epoch;
+    return cache;
+}
+
 static pcdoc_node get_child(purc_document_t doc,
             pcdoc_element_t elem, pcdoc_node_type type, size_t idx)
 {
-    UNUSED_PARAM(doc);
-
     pcdoc_node node;
     node.type = PCDOC_NODE_VOID;
     node.elem = NULL;
 
-    size_t i = 0;
     pcdom_node_t *dom_node = pcdom_interface_node(elem);
+
+    /* accessing the children by index in a loop is linear in total:
+       the children are cached until the document is changed */
+    if (idx >= NR_CHILDREN_WALKED) {
+        struct pcdoc_child_cache *cache = doc->child_cache;
+        if (cache == NULL || cache->parent != dom_node ||
+                cache->type != type || cache->epoch != doc->epoch) {
+            cache = child_cache_fill(doc, dom_node, type);
+        }
+
+        if (cache) {
+            if (idx < cache->nr_nodes) {
+                node.type = type;
+                node.elem = (pcdoc_element_t)cache->nodes[idx];
+            }
+            return node;
+        }
+    }
+
+    size_t i = 0;
     pcdom_node_t *child = dom_node->first_child;
     while (child) {
         if (node_type(child->type) == type) {
@@ -659,19 +1388,256 @@ travel(purc_document_t doc, pcdoc_element_t ancestor,
 static int serialize(purc_document_t doc, pcdoc_node node,
             unsigned opts, purc_rwstream_t stm)
 {
-    if (node.type == PCDOC_NODE_OTHERS)
-        return pchtml_doc_write_to_stream_ex(doc->impl, opts, stm);
+    /* the cache is kept in the nodes, so the workers do not use it */
+    if (doc->nr_serialize_workers > 1) {
+        pcdom_node_t *dom_node = (node.type == PCDOC_NODE_OTHERS) ?
+            pcdom_interface_node(doc->impl) : pcdom_interface_node(node.elem);
+        return pcdom_node_write_to_stream_parallel(dom_node, opts,
+                doc->nr_serialize_workers, stm);
+    }
+
+    if (node.type == PCDOC_NODE_OTHERS) {
+        if (doc->serial_cache == NULL) {
+            doc->serial_cache = pchtml_html_serialize_cache_new();
+            if (doc->serial_cache == NULL)
+                return pchtml_doc_write_to_stream_ex(doc->impl, opts, stm);
+        }
+
+        /* the subtrees not changed since the last time are copied */
+        return pchtml_doc_write_to_stream_cached(doc->impl, opts,
+                doc->serial_cache, stm);
+    }
     else {
         pcdom_node_t *dom_node = pcdom_interface_node(node.elem);
         return pcdom_node_write_to_stream_ex(dom_node, opts, stm);
     }
 }
 
+/* returns the next element after node in the document order within the
+   subtree of scope, or NULL */
+static pcdom_node_t *
+next_element_in_scope(pcdom_node_t *scope, pcdom_node_t *node)
+{
+    do {
+        if (node->first_child) {
+            node = node->first_child;
+        }
+        else {
+            while (node != scope && node->next == NULL)
+                node = node->parent;
+
+            if (node == scope)
+                return NULL;
+            node = node->next;
+        }
+    } while (node->type != PCDOM_NODE_TYPE_ELEMENT);
+
+    return node;
+}
+
+static struct pcdoc_selector *
+bound_selector(purc_document_t doc, const char *selector)
+{
+    struct pcdoc_selector *sel = pcdoc_get_selector(doc, selector);
+    if (sel) {
+        pchtml_html_document_t *html_doc = doc->impl;
+        pcdoc_selector_bind_dom(sel, pchtml_doc_get_document(html_doc));
+    }
+
+    return sel;
+}
+
+/* gets the indexed candidates for the selector; returns false if the
+   selector can not use the index. */
+static bool
+index_candidates(purc_document_t doc, struct pcdoc_selector *sel,
+        struct pcutils_arrlist **cands)
+{
+    size_t len;
+    bool is_id;
+    const char *key = pcdoc_selector_index_key(sel, &len, &is_id);
+    if (key == NULL)
+        return false;
+
+    if (doc->index == NULL && (doc->index = index_build(doc)) == NULL)
+        return false;
+
+    struct pcutils_arrlist **data;
+    data = pcutils_kvlist_get(is_id ? &doc->index->ids :
+            &doc->index->classes, key);
+    *cands = data ? *data : NULL;
+    return true;
+}
+
+static bool
+is_in_scope(pcdom_node_t *scope, pcdom_node_t *node)
+{
+    for (; node; node = node->parent) {
+        if (node == scope)
+            return true;
+    }
+
+    return false;
+}
+
+static size_t
+node_depth(pcdom_node_t *node)
+{
+    size_t depth = 0;
+    for (; node->parent; node = node->parent)
+        depth++;
+    return depth;
+}
+
+/* compares the positions of two nodes in the document order */
+static int
+compare_order(pcdom_node_t *a, pcdom_node_t *b)
+{
+    if (a == b)
+        return 0;
+
+    size_t depth_a = node_depth(a), depth_b = node_depth(b);
+    pcdom_node_t *ua = a, *ub = b;
+    for (; depth_a > depth_b; depth_a--)
+        ua = ua->parent;
+    for (; depth_b > depth_a; depth_b--)
+        ub = ub->parent;
+
+    /* one is the ancestor of the other */
+    if (ua == ub)
+        return (ua == a) ? -1 : 1;
+
+    while (ua->parent != ub->parent) {
+        ua = ua->parent;
+        ub = ub->parent;
+    }
+
+    for (pcdom_node_t *n = ua->next; n; n = n->next) {
+        if (n == ub)
+            return -1;
+    }
+
+    return 1;
+}
+
+static int
+compare_elem_order(const void *a, const void *b)
+{
+    return compare_order(*(pcdom_node_t * const *)a,
+            *(pcdom_node_t * const *)b);
+}
+
+static pcdoc_element_t
+find_elem(purc_document_t doc, pcdoc_element_t scope, const char *selector)
+{
+    struct pcdoc_selector *sel = bound_selector(doc, selector);
+    if (sel == NULL)
+        return NULL;
+
+    pcdom_node_t *root = pcdom_interface_node(scope);
+
+    struct pcutils_arrlist *cands;
+    if (index_candidates(doc, sel, &cands)) {
+        pcdom_node_t *found = NULL;
+        size_t n = cands ? pcutils_arrlist_length(cands) : 0;
+
+        for (size_t i = 0; i < n; i++) {
+            pcdom_node_t *node = pcutils_arrlist_get_idx(cands, i);
+            if ((found == NULL || compare_order(node, found) < 0) &&
+                    is_in_scope(root, node) &&
+                    pcdoc_selector_match_dom(sel,
+                        pcdom_interface_element(node))) {
+                found = node;
+            }
+        }
+
+        return (pcdoc_element_t)found;
+    }
+
+    pcdom_node_t *node = root;
+    while (node) {
+        if (pcdoc_selector_match_dom(sel, pcdom_interface_element(node)))
+            return (pcdoc_element_t)node;
+        node = next_element_in_scope(root, node);
+    }
+
+    return NULL;
+}
+
+static int
+elem_coll_select(purc_document_t doc, pcdoc_elem_coll_t coll,
+        pcdoc_element_t scope, const char *selector)
+{
+    struct pcdoc_selector *sel = bound_selector(doc, selector);
+    if (sel == NULL)
+        return -1;
+
+    pcdom_node_t *root = pcdom_interface_node(scope);
+
+    struct pcutils_arrlist *cands;
+    if (index_candidates(doc, sel, &cands)) {
+        size_t n = cands ? pcutils_arrlist_length(cands) : 0;
+
+        for (size_t i = 0; i < n; i++) {
+            pcdom_node_t *node = pcutils_arrlist_get_idx(cands, i);
+            if (is_in_scope(root, node) &&
+                    pcdoc_selector_match_dom(sel,
+                        pcdom_interface_element(node))) {
+                if (pcutils_arrlist_append(coll->elems, node)) {
+                    purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+                    return -1;
+                }
+            }
+        }
+
+        if (pcutils_arrlist_length(coll->elems) > 1)
+            pcutils_arrlist_sort(coll->elems, compare_elem_order);
+        return 0;
+    }
+
+    pcdom_node_t *node = root;
+    while (node) {
+        if (pcdoc_selector_match_dom(sel, pcdom_interface_element(node))) {
+            if (pcutils_arrlist_append(coll->elems, node)) {
+                purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+                return -1;
+            }
+        }
+        node = next_element_in_scope(root, node);
+    }
+
+    return 0;
+}
+
+static int
+elem_coll_filter(purc_document_t doc, pcdoc_elem_coll_t dst_coll,
+        pcdoc_elem_coll_t src_coll, const char *selector)
+{
+    struct pcdoc_selector *sel = bound_selector(doc, selector);
+    if (sel == NULL)
+        return -1;
+
+    size_t n = pcutils_arrlist_length(src_coll->elems);
+    for (size_t i = 0; i < n; i++) {
+        pcdom_element_t *elem;
+        elem = pcutils_arrlist_get_idx(src_coll->elems, i);
+        if (pcdoc_selector_match_dom(sel, elem)) {
+            if (pcutils_arrlist_append(dst_coll->elems, elem)) {
+                purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+
 struct purc_document_ops _pcdoc_html_ops = {
     .create = create,
     .destroy = destroy,
     .operate_element = operate_element,
     .new_text_content = new_text_content,
+    .new_shared_text_content = new_shared_text_content,
     .new_data_content = NULL,
     .new_content = new_content,
     .set_attribute = set_attribute,
@@ -685,7 +1651,11 @@ struct purc_document_ops _pcdoc_html_ops = {
     .get_data = NULL,
     .travel = travel,
     .serialize = serialize,
-    .elem_coll_select = NULL,
-    .elem_coll_filter = NULL,
+    .find_elem = find_elem,
+    .elem_coll_select = elem_coll_select,
+    .elem_coll_filter = elem_coll_filter,
+    .build_subtree = build_subtree,
+    .parse_steps = parse_steps,
+    .reset = reset,
 };
 
@@ -0,0 +1,925 @@
+/**
+ * @file selector.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The compiler and the matcher of CSS selectors for documents.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "purc-document.h"
+#include "purc-errors.h"
+#include "purc-html.h"
+
+#include "private/document.h"
+#include "private/dom.h"
+#include "private/debug.h"
+
+#include <string.h>
+#include <strings.h>
+#include <assert.h>
+
+/* The selector supported is a list of complex selectors separated by
+   commas; a complex selector is a sequence of compound selectors joined
+   by the descendant, child (`>`), next-sibling (`+`), or subsequent-sibling
+   (`~`) combinators; and a compound selector consists of an optional type
+   selector (or `*`), and any number of ID, class, attribute selectors,
+   and the pseudo-classes listed in `pseudo_classes`. */
+
+enum {
+    COMB_NONE = 0,
+    COMB_DESCENDANT,
+    COMB_CHILD,
+    COMB_NEXT_SIBLING,
+    COMB_SUBSEQUENT_SIBLING,
+};
+
+enum {
+    ATTR_OP_EXISTS = 0,
+    ATTR_OP_EQUAL,          // [attr=value]
+    ATTR_OP_INCLUDES,       // [attr~=value]
+    ATTR_OP_DASH_MATCH,     // [attr|=value]
+    ATTR_OP_PREFIX,         // [attr^=value]
+    ATTR_OP_SUFFIX,         // [attr$=value]
+    ATTR_OP_SUBSTRING,      // [attr*=value]
+};
+
+#define PSEUDO_FIRST_CHILD      0x01
+#define PSEUDO_LAST_CHILD       0x02
+#define PSEUDO_ONLY_CHILD       (PSEUDO_FIRST_CHILD | PSEUDO_LAST_CHILD)
+#define PSEUDO_EMPTY            0x04
+#define PSEUDO_ROOT             0x08
+
+static const struct {
+    const char *name;
+    unsigned    flag;
+} pseudo_classes[] = {
+    { "first-child",    PSEUDO_FIRST_CHILD },
+    { "last-child",     PSEUDO_LAST_CHILD },
+    { "only-child",     PSEUDO_ONLY_CHILD },
+    { "empty",          PSEUDO_EMPTY },
+    { "root",           PSEUDO_ROOT },
+};
+
+struct sel_attr {
+    char               *name;
+    size_t              name_len;
+    char               *value;
+    size_t              value_len;
+    int                 op;
+    bool                icase;
+
+    /* resolved in the document bound; unknown if the document has
+       no such attribute name at all */
+    bool                unknown;
+    pcdom_attr_id_t     attr_id;
+};
+
+struct sel_compound {
+    /* the relation with the compound on the left */
+    int                 combinator;
+
+    /* the lowercase tag name; NULL for any */
+    char               *tag;
+    size_t              tag_len;
+    pchtml_tag_id_t     tag_id;
+
+    char               *id;
+    size_t              id_len;
+
+    char              **classes;
+    size_t             *class_lens;
+    size_t              nr_classes;
+
+    struct sel_attr    *attrs;
+    size_t              nr_attrs;
+
+    unsigned            pseudos;
+
+    /* matches nothing, e.g., `#a#b` */
+    bool                impossible;
+};
+
+struct sel_complex {
+    /* from left to right, but matched from right to left */
+    struct sel_compound *compounds;
+    size_t              nr_compounds;
+};
+
+struct pcdoc_selector {
+    char               *text;
+    struct sel_complex *complexes;
+    size_t              nr_complexes;
+
+    /* the DOM document which the names were resolved in */
+    pcdom_document_t   *bound_doc;
+};
+
+static void
+compound_release(struct sel_compound *c)
+{
+    free(c->tag);
+    free(c->id);
+    for (size_t i = 0; i < c->nr_classes; i++)
+        free(c->classes[i]);
+    free(c->classes);
+    free(c->class_lens);
+    for (size_t i = 0; i < c->nr_attrs; i++) {
+        free(c->attrs[i].name);
+        free(c->attrs[i].value);
+    }
+    free(c->attrs);
+}
+
+void
+pcdoc_selector_delete(struct pcdoc_selector *sel)
+{
+    for (size_t i = 0; i < sel->nr_complexes; i++) {
+        struct sel_complex *cx = sel->complexes + i;
+        for (size_t j = 0; j < cx->nr_compounds; j++)
+            compound_release(cx->compounds + j);
+        free(cx->compounds);
+    }
+
+    free(sel->complexes);
+    free(sel->text);
+    free(sel);
+}
+
+struct parser {
+    const char *p;
+    bool        failed;
+};
+
+static inline bool
+is_ws(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+static inline void
+skip_ws(struct parser *ps)
+{
+    while (is_ws(*ps->p))
+        ps->p++;
+}
+
+static inline bool
+is_ident_char(unsigned char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+        (c >= '0' && c <= '9') || c == '-' || c == '_' || c >= 0x80;
+}
+
+/* parses an identifier with the backslash escapes of single characters;
+   returns a new string or NULL if there is no identifier */
+static char *
+parse_ident(struct parser *ps, size_t *len, bool lowercase)
+{
+    const char *start = ps->p;
+    size_t n = 0;
+
+    while (*ps->p) {
+        if (*ps->p == '\\' && ps->p[1]) {
+            ps->p += 2;
+        }
+        else if (is_ident_char((unsigned char)*ps->p)) {
+            ps->p++;
+        }
+        else {
+            break;
+        }
+        n++;
+    }
+
+    if (n == 0)
+        return NULL;
+
+    char *ident = malloc(n + 1);
+    if (ident == NULL) {
+        ps->failed = true;
+        return NULL;
+    }
+
+    char *q = ident;
+    for (const char *s = start; s < ps->p; s++) {
+        if (*s == '\\')
+            s++;
+        *q++ = lowercase ? (char)purc_tolower(*s) : *s;
+    }
+    *q = '\0';
+
+    *len = n;
+    return ident;
+}
+
+static char *
+parse_string(struct parser *ps, size_t *len)
+{
+    char quote = *ps->p++;
+    const char *start = ps->p;
+    size_t n = 0;
+
+    while (*ps->p && *ps->p != quote) {
+        if (*ps->p == '\\' && ps->p[1])
+            ps->p++;
+        ps->p++;
+        n++;
+    }
+
+    if (*ps->p != quote)
+        return NULL;
+
+    char *str = malloc(n + 1);
+    if (str == NULL) {
+        ps->failed = true;
+        return NULL;
+    }
+
+    char *q = str;
+    for (const char *s = start; s < ps->p; s++) {
+        if (*s == '\\')
+            s++;
+        *q++ = *s;
+    }
+    *q = '\0';
+
+    ps->p++;    // skip the closing quote
+    *len = n;
+    return str;
+}
+
+static bool
+parse_attr(struct parser *ps, struct sel_compound *c)
+{
+    struct sel_attr attr = { 0 };
+    struct sel_attr *attrs;
+
+    ps->p++;    // skip '['
+    skip_ws(ps);
+    if ((attr.name = parse_ident(ps, &attr.name_len, true)) == NULL)
+        goto failed;
+    skip_ws(ps);
+
+    switch (*ps->p) {
+    case ']':
+        attr.op = ATTR_OP_EXISTS;
+        break;
+    case '=':
+        attr.op = ATTR_OP_EQUAL;
+        break;
+    case '~':
+        attr.op = ATTR_OP_INCLUDES;
+        break;
+    case '|':
+        attr.op = ATTR_OP_DASH_MATCH;
+        break;
+    case '^':
+        attr.op = ATTR_OP_PREFIX;
+        break;
+    case '$':
+        attr.op = ATTR_OP_SUFFIX;
+        break;
+    case '*':
+        attr.op = ATTR_OP_SUBSTRING;
+        break;
+    default:
+        goto failed;
+    }
+
+    if (attr.op != ATTR_OP_EXISTS) {
+        if (attr.op != ATTR_OP_EQUAL) {
+            ps->p++;
+            if (*ps->p != '=')
+                goto failed;
+        }
+        ps->p++;
+        skip_ws(ps);
+
+        if (*ps->p == '"' || *ps->p == '\'')
+            attr.value = parse_string(ps, &attr.value_len);
+        else
+            attr.value = parse_ident(ps, &attr.value_len, false);
+        if (attr.value == NULL)
+            goto failed;
+
+        skip_ws(ps);
+        if (*ps->p == 'i' || *ps->p == 'I') {
+            attr.icase = true;
+            ps->p++;
+            skip_ws(ps);
+        }
+        else if (*ps->p == 's' || *ps->p == 'S') {
+            ps->p++;
+            skip_ws(ps);
+        }
+    }
+
+    if (*ps->p != ']')
+        goto failed;
+    ps->p++;
+
+    attrs = realloc(c->attrs, sizeof(attr) * (c->nr_attrs + 1));
+    if (attrs == NULL) {
+        ps->failed = true;
+        goto failed;
+    }
+
+    c->attrs = attrs;
+    c->attrs[c->nr_attrs++] = attr;
+    return true;
+
+failed:
+    free(attr.name);
+    free(attr.value);
+    return false;
+}
+
+static bool
+parse_class(struct parser *ps, struct sel_compound *c)
+{
+    size_t len;
+    char *klass;
+
+    ps->p++;    // skip '.'
+    if ((klass = parse_ident(ps, &len, false)) == NULL)
+        return false;
+
+    char **classes = realloc(c->classes,
+            sizeof(char *) * (c->nr_classes + 1));
+    if (classes == NULL)
+        goto failed;
+    c->classes = classes;
+
+    size_t *lens = realloc(c->class_lens,
+            sizeof(size_t) * (c->nr_classes + 1));
+    if (lens == NULL)
+        goto failed;
+    c->class_lens = lens;
+
+    c->classes[c->nr_classes] = klass;
+    c->class_lens[c->nr_classes] = len;
+    c->nr_classes++;
+    return true;
+
+failed:
+    ps->failed = true;
+    free(klass);
+    return false;
+}
+
+static bool
+parse_pseudo(struct parser *ps, struct sel_compound *c)
+{
+    size_t len;
+    char *name;
+
+    ps->p++;    // skip ':'
+    if ((name = parse_ident(ps, &len, true)) == NULL)
+        return false;
+
+    for (size_t i = 0; i < PCA_TABLESIZE(pseudo_classes); i++) {
+        if (strcmp(name, pseudo_classes[i].name) == 0) {
+            c->pseudos |= pseudo_classes[i].flag;
+            free(name);
+            return true;
+        }
+    }
+
+    PC_DEBUG("Not supported pseudo-class in selector: %s\n", name);
+    free(name);
+    return false;
+}
+
+static bool
+parse_compound(struct parser *ps, struct sel_compound *c)
+{
+    bool empty = true;
+
+    if (*ps->p == '*') {
+        ps->p++;
+        empty = false;
+    }
+    else if (is_ident_char((unsigned char)*ps->p) || *ps->p == '\\') {
+        if ((c->tag = parse_ident(ps, &c->tag_len, true)) == NULL)
+            return false;
+        empty = false;
+    }
+
+    while (*ps->p) {
+        bool ok;
+
+        switch (*ps->p) {
+        case '#': {
+            size_t len;
+            char *id;
+
+            ps->p++;
+            if ((id = parse_ident(ps, &len, false)) == NULL)
+                return false;
+
+            if (c->id == NULL) {
+                c->id = id;
+                c->id_len = len;
+            }
+            else {
+                /* an element has one ID only */
+                if (strcmp(c->id, id))
+                    c->impossible = true;
+                free(id);
+            }
+            ok = true;
+            break;
+        }
+        case '.':
+            ok = parse_class(ps, c);
+            break;
+        case '[':
+            ok = parse_attr(ps, c);
+            break;
+        case ':':
+            ok = parse_pseudo(ps, c);
+            break;
+        default:
+            return !empty;
+        }
+
+        if (!ok)
+            return false;
+        empty = false;
+    }
+
+    return !empty;
+}
+
+static bool
+parse_complex(struct parser *ps, struct sel_complex *cx)
+{
+    int combinator = COMB_NONE;
+
+    skip_ws(ps);
+    while (true) {
+        struct sel_compound *compounds = realloc(cx->compounds,
+                sizeof(struct sel_compound) * (cx->nr_compounds + 1));
+        if (compounds == NULL) {
+            ps->failed = true;
+            return false;
+        }
+
+        cx->compounds = compounds;
+        struct sel_compound *c = cx->compounds + cx->nr_compounds;
+        memset(c, 0, sizeof(*c));
+        cx->nr_compounds++;
+
+        c->combinator = combinator;
+        if (!parse_compound(ps, c))
+            return false;
+
+        bool ws = is_ws(*ps->p);
+        skip_ws(ps);
+
+        if (*ps->p == '\0' || *ps->p == ',') {
+            break;
+        }
+        else if (*ps->p == '>') {
+            combinator = COMB_CHILD;
+        }
+        else if (*ps->p == '+') {
+            combinator = COMB_NEXT_SIBLING;
+        }
+        else if (*ps->p == '~') {
+            combinator = COMB_SUBSEQUENT_SIBLING;
+        }
+        else if (ws) {
+            combinator = COMB_DESCENDANT;
+            continue;
+        }
+        else {
+            return false;
+        }
+
+        ps->p++;
+        skip_ws(ps);
+    }
+
+    return true;
+}
+
+struct pcdoc_selector *
+pcdoc_selector_new(const char *selector)
+{
+    struct pcdoc_selector *sel = calloc(1, sizeof(*sel));
+    if (sel == NULL)
+        goto failed_nomem;
+
+    if ((sel->text = strdup(selector)) == NULL)
+        goto failed_nomem;
+
+    struct parser ps = { selector, false };
+    while (true) {
+        struct sel_complex *complexes = realloc(sel->complexes,
+                sizeof(struct sel_complex) * (sel->nr_complexes + 1));
+        if (complexes == NULL)
+            goto failed_nomem;
+
+        sel->complexes = complexes;
+        struct sel_complex *cx = sel->complexes + sel->nr_complexes;
+        memset(cx, 0, sizeof(*cx));
+        sel->nr_complexes++;
+
+        if (!parse_complex(&ps, cx)) {
+            if (ps.failed)
+                goto failed_nomem;
+            goto failed_syntax;
+        }
+
+        if (*ps.p == '\0')
+            break;
+
+        ps.p++;     // skip ','
+    }
+
+    return sel;
+
+failed_syntax:
+    PC_DEBUG("Bad CSS selector: %s\n", selector);
+    pcdoc_selector_delete(sel);
+    purc_set_error(PURC_ERROR_INVALID_VALUE);
+    return NULL;
+
+failed_nomem:
+    if (sel)
+        pcdoc_selector_delete(sel);
+    purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    return NULL;
+}
+
+void
+pcdoc_selector_bind_dom(struct pcdoc_selector *sel, pcdom_document_t *doc)
+{
+    /* the names are resolved for every query, because the names which
+       did not exist in the document may be added with the new elements */
+    for (size_t i = 0; i < sel->nr_complexes; i++) {
+        struct sel_complex *cx = sel->complexes + i;
+
+        for (size_t j = 0; j < cx->nr_compounds; j++) {
+            struct sel_compound *c = cx->compounds + j;
+
+            if (c->tag) {
+                c->tag_id = pchtml_tag_id_by_name(doc->tags,
+                        (const unsigned char *)c->tag, c->tag_len);
+            }
+
+            for (size_t k = 0; k < c->nr_attrs; k++) {
+                struct sel_attr *attr = c->attrs + k;
+                const pcdom_attr_data_t *data;
+
+                data = pcdom_attr_data_by_local_name(doc->attrs,
+                        (const unsigned char *)attr->name, attr->name_len);
+                attr->unknown = (data == NULL);
+                attr->attr_id = data ? data->attr_id : 0;
+            }
+        }
+    }
+
+    sel->bound_doc = doc;
+}
+
+static inline bool
+str_equal(const char *a, size_t a_len, const char *b, size_t b_len,
+        bool icase)
+{
+    if (a_len != b_len)
+        return false;
+    return icase ? (strncasecmp(a, b, a_len) == 0) : (memcmp(a, b, a_len) == 0);
+}
+
+/* whether the white-space separated list contains the token */
+static bool
+list_includes(const char *list, size_t len, const char *token,
+        size_t token_len, bool icase)
+{
+    const char *end = list + len;
+    const char *p = list;
+
+    while (p < end) {
+        while (p < end && is_ws(*p))
+            p++;
+
+        const char *start = p;
+        while (p < end && !is_ws(*p))
+            p++;
+
+        if (p > start && str_equal(start, p - start, token, token_len, icase))
+            return true;
+    }
+
+    return false;
+}
+
+static bool
+match_attr(pcdom_element_t *elem, const struct sel_attr *sa)
+{
+    if (sa->unknown)
+        return false;
+
+    pcdom_attr_t *attr = pcdom_element_first_attribute(elem);
+    while (attr) {
+        if (attr->node.local_name == sa->attr_id)
+            break;
+        attr = pcdom_element_next_attribute(attr);
+    }
+
+    if (attr == NULL)
+        return false;
+
+    if (sa->op == ATTR_OP_EXISTS)
+        return true;
+
+    size_t len;
+    const char *val = (const char *)pcdom_attr_value(attr, &len);
+    if (val == NULL) {
+        val = "";
+        len = 0;
+    }
+
+    switch (sa->op) {
+    case ATTR_OP_EQUAL:
+        return str_equal(val, len, sa->value, sa->value_len, sa->icase);
+
+    case ATTR_OP_INCLUDES:
+        return sa->value_len > 0 &&
+            list_includes(val, len, sa->value, sa->value_len, sa->icase);
+
+    case ATTR_OP_DASH_MATCH:
+        if (len == sa->value_len)
+            return str_equal(val, len, sa->value, sa->value_len, sa->icase);
+        return len > sa->value_len && val[sa->value_len] == '-' &&
+            str_equal(val, sa->value_len, sa->value, sa->value_len,
+                    sa->icase);
+
+    case ATTR_OP_PREFIX:
+        return sa->value_len > 0 && len >= sa->value_len &&
+            str_equal(val, sa->value_len, sa->value, sa->value_len,
+                    sa->icase);
+
+    case ATTR_OP_SUFFIX:
+        return sa->value_len > 0 && len >= sa->value_len &&
+            str_equal(val + len - sa->value_len, sa->value_len,
+                    sa->value, sa->value_len, sa->icase);
+
+    case ATTR_OP_SUBSTRING:
+        if (sa->value_len == 0 || len < sa->value_len)
+            return false;
+        for (size_t i = 0; i + sa->value_len <= len; i++) {
+            if (str_equal(val + i, sa->value_len,
+                        sa->value, sa->value_len, sa->icase))
+                return true;
+        }
+        return false;
+    }
+
+    return false;
+}
+
+static inline pcdom_element_t *
+parent_element(pcdom_element_t *elem)
+{
+    pcdom_node_t *parent = elem->node.parent;
+    if (parent && parent->type == PCDOM_NODE_TYPE_ELEMENT)
+        return (pcdom_element_t *)parent;
+    return NULL;
+}
+
+static inline pcdom_element_t *
+prev_element(pcdom_element_t *elem)
+{
+    pcdom_node_t *node = elem->node.prev;
+    while (node && node->type != PCDOM_NODE_TYPE_ELEMENT)
+        node = node->prev;
+    return (pcdom_element_t *)node;
+}
+
+static inline pcdom_element_t *
+next_element(pcdom_element_t *elem)
+{
+    pcdom_node_t *node = elem->node.next;
+    while (node && node->type != PCDOM_NODE_TYPE_ELEMENT)
+        node = node->next;
+    return (pcdom_element_t *)node;
+}
+
+static bool
+match_pseudos(pcdom_element_t *elem, unsigned pseudos)
+{
+    if ((pseudos & PSEUDO_FIRST_CHILD) && prev_element(elem))
+        return false;
+
+    if ((pseudos & PSEUDO_LAST_CHILD) && next_element(elem))
+        return false;
+
+    if (pseudos & PSEUDO_EMPTY) {
+        pcdom_node_t *child = elem->node.first_child;
+        for (; child; child = child->next) {
+            if (child->type == PCDOM_NODE_TYPE_ELEMENT)
+                return false;
+            if (child->type == PCDOM_NODE_TYPE_TEXT) {
+                pcdom_text_t *text = pcdom_interface_text(child);
+                if (text->char_data.data.length > 0)
+                    return false;
+            }
+        }
+    }
+
+    if ((pseudos & PSEUDO_ROOT) && parent_element(elem))
+        return false;
+
+    return true;
+}
+
+static bool
+match_compound(pcdom_element_t *elem, const struct sel_compound *c)
+{
+    if (c->impossible)
+        return false;
+
+    /* in the order of the probable selectivity */
+    if (c->tag && elem->node.local_name != c->tag_id)
+        return false;
+
+    if (c->id) {
+        size_t len;
+        const char *id = (const char *)pcdom_element_id(elem, &len);
+        if (id == NULL || !str_equal(id, len, c->id, c->id_len, false))
+            return false;
+    }
+
+    if (c->nr_classes) {
+        size_t len;
+        const char *klass = (const char *)pcdom_element_class(elem, &len);
+        if (klass == NULL)
+            return false;
+
+        for (size_t i = 0; i < c->nr_classes; i++) {
+            if (!list_includes(klass, len,
+                        c->classes[i], c->class_lens[i], false))
+                return false;
+        }
+    }
+
+    for (size_t i = 0; i < c->nr_attrs; i++) {
+        if (!match_attr(elem, c->attrs + i))
+            return false;
+    }
+
+    if (c->pseudos && !match_pseudos(elem, c->pseudos))
+        return false;
+
+    return true;
+}
+
+/* matches the compounds [0, idx] from right to left */
+static bool
+match_complex(pcdom_element_t *elem, const struct sel_complex *cx, size_t idx)
+{
+    const struct sel_compound *c = cx->compounds + idx;
+
+    if (!match_compound(elem, c))
+        return false;
+
+    if (idx == 0)
+        return true;
+
+    switch (c->combinator) {
+    case COMB_DESCENDANT:
+        for (elem = parent_element(elem); elem; elem = parent_element(elem)) {
+            if (match_complex(elem, cx, idx - 1))
+                return true;
+        }
+        break;
+
+    case COMB_CHILD:
+        if ((elem = parent_element(elem)))
+            return match_complex(elem, cx, idx - 1);
+        break;
+
+    case COMB_NEXT_SIBLING:
+        if ((elem = prev_element(elem)))
+            return match_complex(elem, cx, idx - 1);
+        break;
+
+    case COMB_SUBSEQUENT_SIBLING:
+        for (elem = prev_element(elem); elem; elem = prev_element(elem)) {
+            if (match_complex(elem, cx, idx - 1))
+                return true;
+        }
+        break;
+    }
+
+    return false;
+}
+
+bool
+pcdoc_selector_match_dom(struct pcdoc_selector *sel, pcdom_element_t *elem)
+{
+    assert(sel->bound_doc == elem->node.owner_document);
+
+    for (size_t i = 0; i < sel->nr_complexes; i++) {
+        const struct sel_complex *cx = sel->complexes + i;
+        if (match_complex(elem, cx, cx->nr_compounds - 1))
+            return true;
+    }
+
+    return false;
+}
+
+const char *
+pcdoc_selector_index_key(struct pcdoc_selector *sel, size_t *len, bool *is_id)
+{
+    if (sel->nr_complexes != 1)
+        return NULL;
+
+    const struct sel_complex *cx = sel->complexes;
+    const struct sel_compound *c = cx->compounds + cx->nr_compounds - 1;
+    if (c->id) {
+        *is_id = true;
+        *len = c->id_len;
+        return c->id;
+    }
+    else if (c->nr_classes) {
+        *is_id = false;
+        *len = c->class_lens[0];
+        return c->classes[0];
+    }
+
+    return NULL;
+}
+
+static size_t
+selector_slot(const char *selector)
+{
+    /* FNV-1a */
+    uint32_t hash = 2166136261U;
+    for (const char *p = selector; *p; p++) {
+        hash ^= (unsigned char)*p;
+        hash *= 16777619U;
+    }
+
+    return hash % PCDOC_NR_CACHED_SELECTORS;
+}
+
+struct pcdoc_selector *
+pcdoc_get_selector(purc_document_t doc, const char *selector)
+{
+    if (doc->selectors == NULL) {
+        doc->selectors = calloc(PCDOC_NR_CACHED_SELECTORS,
+                sizeof(struct pcdoc_selector *));
+        if (doc->selectors == NULL) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return NULL;
+        }
+    }
+
+    struct pcdoc_selector **slot = doc->selectors + selector_slot(selector);
+    if (*slot && strcmp((*slot)->text, selector) == 0)
+        return *slot;
+
+    struct pcdoc_selector *sel = pcdoc_selector_new(selector);
+    if (sel == NULL)
+        return NULL;
+
+    if (*slot)
+        pcdoc_selector_delete(*slot);
+    *slot = sel;
+    return sel;
+}
+
+void
+pcdoc_release_selectors(purc_document_t doc)
+{
+    if (doc->selectors == NULL)
+        return;
+
+    for (size_t i = 0; i < PCDOC_NR_CACHED_SELECTORS; i++) {
+        if (doc->selectors[i])
+            pcdoc_selector_delete(doc->selectors[i]);
+    }
+
+    free(doc->selectors);
+    doc->selectors = NULL;
+}
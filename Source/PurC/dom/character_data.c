@@ -57,9 +57,13 @@ pcdom_character_data_interface_create(pcdom_document_t *document)
 pcdom_character_data_t *
 pcdom_character_data_interface_destroy(pcdom_character_data_t *character_data)
 {
-    pcutils_str_destroy(&character_data->data,
-                       pcdom_interface_node(character_data)->owner_document->text,
-                       false);
+    pcdom_node_t *node = pcdom_interface_node(character_data);
+
+    if (node->flags & PCDOM_NODE_FLAG_SHARED_DATA)
+        pcdom_document_release_shared_data(node);
+    else
+        pcutils_str_destroy(&character_data->data,
+                node->owner_document->text, false);
 
     return pcutils_mraw_free(
         pcdom_interface_node(character_data)->owner_document->mraw,
@@ -75,6 +79,15 @@ pcdom_character_data_replace(pcdom_character_data_t *ch_data,
     UNUSED_PARAM(offset);
     UNUSED_PARAM(count);
 
+    /* the shared bytes are never changed; the new data may be them */
+    pcdom_node_t *node = pcdom_interface_node(ch_data);
+    void *shared = NULL;
+    if (node->flags & PCDOM_NODE_FLAG_SHARED_DATA) {
+        shared = node->user;
+        ch_data->data.data = NULL;
+        ch_data->data.length = 0;
+    }
+
     if (ch_data->data.data == NULL) {
         pcutils_str_init(&ch_data->data, ch_data->node.owner_document->text, len);
         if (ch_data->data.data == NULL) {
@@ -96,5 +109,8 @@ pcdom_character_data_replace(pcdom_character_data_t *ch_data,
     ch_data->data.data[len] = 0x00;
     ch_data->data.length = len;
 
+    if (shared)
+        pcdom_document_release_shared_data(node);
+
     return PURC_ERROR_OK;
 }
@@ -34,6 +34,9 @@
 #include "config.h"
 #include "private/dom.h"
 
+static void
+release_all_shared_data(pcdom_document_t *document);
+
 pcdom_document_t *
 pcdom_document_interface_create(pcdom_document_t *document)
 {
@@ -173,6 +176,7 @@ unsigned int
 pcdom_document_clean(pcdom_document_t *document)
 {
     if (pcdom_interface_node(document)->owner_document == document) {
+        release_all_shared_data(document);
         pcutils_mraw_clean(document->mraw);
         pcutils_mraw_clean(document->text);
         pcutils_hash_clean(document->tags);
@@ -204,6 +208,7 @@ pcdom_document_destroy(pcdom_document_t *document)
         return pcutils_mraw_free(owner->mraw, document);
     }
 
+    release_all_shared_data(document);
     pcutils_mraw_destroy(document->text, true);
     pcutils_mraw_destroy(document->mraw, true);
     pcutils_hash_destroy(document->tags, true);
@@ -288,6 +293,96 @@ pcdom_document_create_text_node(pcdom_document_t *document,
     return text;
 }
 
+struct pcdom_shared_data {
+    pcdom_shared_data_t    *prev;
+    pcdom_shared_data_t    *next;
+    purc_variant_t          str;
+};
+
+pcdom_text_t *
+pcdom_document_create_text_node_shared(pcdom_document_t *document,
+                                  purc_variant_t str)
+{
+    pcdom_text_t *text;
+    pcdom_shared_data_t *shared;
+    const char *data;
+    size_t len;
+
+    data = purc_variant_get_string_const_ex(str, &len);
+    if (data == NULL) {
+        return NULL;
+    }
+
+    shared = pcutils_malloc(sizeof(*shared));
+    if (shared == NULL) {
+        return NULL;
+    }
+
+    text = pcdom_document_create_interface(document,
+                                             PCHTML_TAG__TEXT, PCHTML_NS_HTML);
+    if (text == NULL) {
+        pcutils_free(shared);
+        return NULL;
+    }
+
+    /* the holders are linked to the document owning the memory */
+    pcdom_document_t *owner = pcdom_interface_node(text)->owner_document;
+    shared->str = purc_variant_ref(str);
+    shared->prev = NULL;
+    shared->next = owner->shared_data;
+    if (owner->shared_data)
+        owner->shared_data->prev = shared;
+    owner->shared_data = shared;
+
+    /* string variants are immutable and null-terminated */
+    text->char_data.data.data = (unsigned char *)data;
+    text->char_data.data.length = len;
+    pcdom_interface_node(text)->flags |= PCDOM_NODE_FLAG_SHARED_DATA;
+    pcdom_interface_node(text)->user = shared;
+
+    return text;
+}
+
+void
+pcdom_document_release_shared_data(pcdom_node_t *node)
+{
+    pcdom_shared_data_t *shared = node->user;
+    pcdom_document_t *owner = node->owner_document;
+
+    if ((node->flags & PCDOM_NODE_FLAG_SHARED_DATA) == 0) {
+        return;
+    }
+
+    if (shared->prev)
+        shared->prev->next = shared->next;
+    else
+        owner->shared_data = shared->next;
+    if (shared->next)
+        shared->next->prev = shared->prev;
+
+    purc_variant_unref(shared->str);
+    pcutils_free(shared);
+
+    node->flags &= ~PCDOM_NODE_FLAG_SHARED_DATA;
+    node->user = NULL;
+}
+
+static void
+release_all_shared_data(pcdom_document_t *document)
+{
+    pcdom_shared_data_t *shared = document->shared_data;
+
+    /* the nodes are released with the memory of the document */
+    while (shared) {
+        pcdom_shared_data_t *next = shared->next;
+        purc_variant_unref(shared->str);
+        pcutils_free(shared);
+        shared = next;
+    }
+
+    document->shared_data = NULL;
+}
+
 pcdom_cdata_section_t *
 pcdom_document_create_cdata_section(pcdom_document_t *document,
                                       const unsigned char *data, size_t len)
@@ -44,6 +44,7 @@ static int dom_init_once(void)
 }
 
 struct pcmodule _module_dom = {
+    .name            = "dom",
     .id              = PURC_HAVE_DOM,
     .module_inited   = 0,
 
@@ -56,8 +56,11 @@ pcdom_text_interface_create(pcdom_document_t *document)
 pcdom_text_t *
 pcdom_text_interface_destroy(pcdom_text_t *text)
 {
-    pcutils_str_destroy(&text->char_data.data,
-                       pcdom_interface_node(text)->owner_document->text, false);
+    if (pcdom_interface_node(text)->flags & PCDOM_NODE_FLAG_SHARED_DATA)
+        pcdom_document_release_shared_data(pcdom_interface_node(text));
+    else
+        pcutils_str_destroy(&text->char_data.data,
+                pcdom_interface_node(text)->owner_document->text, false);
 
     return pcutils_mraw_free(
         pcdom_interface_node(text)->owner_document->mraw,
@@ -411,6 +411,273 @@ failed:
     return PURC_VARIANT_INVALID;
 }
 
+static purc_variant_t
+slice_steps_getter(purc_variant_t root,
+        size_t nr_args, purc_variant_t *argv, bool silently)
+{
+    UNUSED_PARAM(nr_args);
+    UNUSED_PARAM(argv);
+    UNUSED_PARAM(silently);
+
+    pcintr_coroutine_t cor = hvml_ctrl_coroutine(root);
+    assert(cor);
+
+    return purc_variant_make_ulongint(cor->slice_steps);
+}
+
+static purc_variant_t
+slice_steps_setter(purc_variant_t root,
+        size_t nr_args, purc_variant_t *argv, bool silently)
+{
+    if (nr_args < 1) {
+        purc_set_error(PURC_ERROR_ARGUMENT_MISSED);
+        goto failed;
+    }
+
+    uint64_t u64;
+    if (purc_variant_cast_to_ulongint(argv[0], &u64, false) && u64 > 0) {
+        pcintr_coroutine_t cor = hvml_ctrl_coroutine(root);
+        assert(cor);
+
+        cor->slice_steps = u64;
+        return purc_variant_make_ulongint(u64);
+    }
+
+    purc_set_error(PURC_ERROR_INVALID_VALUE);
+
+failed:
+    if (silently)
+        return purc_variant_make_boolean(false);
+    return PURC_VARIANT_INVALID;
+}
+
+static purc_variant_t
+slice_time_getter(purc_variant_t root,
+        size_t nr_args, purc_variant_t *argv, bool silently)
+{
+    UNUSED_PARAM(nr_args);
+    UNUSED_PARAM(argv);
+    UNUSED_PARAM(silently);
+
+    pcintr_coroutine_t cor = hvml_ctrl_coroutine(root);
+    assert(cor);
+
+    return purc_variant_make_ulongint(cor->slice_time);
+}
+
+/* the time slice in milliseconds; zero for no time limit */
+static purc_variant_t
+slice_time_setter(purc_variant_t root,
+        size_t nr_args, purc_variant_t *argv, bool silently)
+{
+    if (nr_args < 1) {
+        purc_set_error(PURC_ERROR_ARGUMENT_MISSED);
+        goto failed;
+    }
+
+    uint64_t u64;
+    if (purc_variant_cast_to_ulongint(argv[0], &u64, false)) {
+        pcintr_coroutine_t cor = hvml_ctrl_coroutine(root);
+        assert(cor);
+
+        cor->slice_time = u64;
+        return purc_variant_make_ulongint(u64);
+    }
+
+    purc_set_error(PURC_ERROR_INVALID_VALUE);
+
+failed:
+    if (silently)
+        return purc_variant_make_boolean(false);
+    return PURC_VARIANT_INVALID;
+}
+
+static purc_variant_t
+slice_stat_getter(purc_variant_t root,
+        size_t nr_args, purc_variant_t *argv, bool silently)
+{
+    UNUSED_PARAM(nr_args);
+    UNUSED_PARAM(argv);
+    UNUSED_PARAM(silently);
+
+    pcintr_coroutine_t cor = hvml_ctrl_coroutine(root);
+    assert(cor);
+
+    purc_variant_t retv = purc_variant_make_object_0();
+    if (retv == PURC_VARIANT_INVALID)
+        goto failed;
+
+    static const char *keys[] = { "slices", "steps", "preempted" };
+    uint64_t values[] = { cor->nr_slices, cor->nr_steps, cor->nr_preempted };
+    for (size_t i = 0; i < PCA_TABLESIZE(keys); i++) {
+        purc_variant_t val = purc_variant_make_ulongint(values[i]);
+        if (val == PURC_VARIANT_INVALID ||
+                !purc_variant_object_set_by_static_ckey(retv, keys[i], val)) {
+            if (val)
+                purc_variant_unref(val);
+            goto failed;
+        }
+        purc_variant_unref(val);
+    }
+
+    purc_variant_t val = purc_variant_make_number(cor->max_slice_time);
+    if (val == PURC_VARIANT_INVALID ||
+            !purc_variant_object_set_by_static_ckey(retv,
+                "maxSliceTime", val)) {
+        if (val)
+            purc_variant_unref(val);
+        goto failed;
+    }
+    purc_variant_unref(val);
+
+    return retv;
+
+failed:
+    if (retv)
+        purc_variant_unref(retv);
+    if (silently)
+        return purc_variant_make_undefined();
+    return PURC_VARIANT_INVALID;
+}
+
+static purc_variant_t
+make_ulongint_object(const char **keys, const uint64_t *values, size_t nr)
+{
+    purc_variant_t retv = purc_variant_make_object_0();
+    if (retv == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    for (size_t i = 0; i < nr; i++) {
+        purc_variant_t val = purc_variant_make_ulongint(values[i]);
+        if (val == PURC_VARIANT_INVALID ||
+                !purc_variant_object_set_by_static_ckey(retv, keys[i], val)) {
+            if (val)
+                purc_variant_unref(val);
+            purc_variant_unref(retv);
+            return PURC_VARIANT_INVALID;
+        }
+        purc_variant_unref(val);
+    }
+
+    return retv;
+}
+
+/* the memory charged to the coroutine; `dom` is an estimate */
+static purc_variant_t
+mem_stat_getter(purc_variant_t root,
+        size_t nr_args, purc_variant_t *argv, bool silently)
+{
+    UNUSED_PARAM(nr_args);
+    UNUSED_PARAM(argv);
+
+    pcintr_coroutine_t cor = hvml_ctrl_coroutine(root);
+    assert(cor);
+
+    static const char *keys[] = { "values", "memory", "dom" };
+    uint64_t values[] = {
+        cor->mem_charge.nr_values > 0 ? cor->mem_charge.nr_values : 0,
+        pcintr_coroutine_mem_usage(cor),
+        cor->stack.doc ? cor->stack.doc->sz_added : 0,
+    };
+
+    purc_variant_t retv = make_ulongint_object(keys, values,
+            PCA_TABLESIZE(keys));
+    if (retv == PURC_VARIANT_INVALID && silently)
+        return purc_variant_make_undefined();
+    return retv;
+}
+
+static purc_variant_t
+mem_limits_getter(purc_variant_t root,
+        size_t nr_args, purc_variant_t *argv, bool silently)
+{
+    UNUSED_PARAM(nr_args);
+    UNUSED_PARAM(argv);
+
+    pcintr_coroutine_t cor = hvml_ctrl_coroutine(root);
+    assert(cor);
+
+    static const char *keys[] = { "soft", "hard" };
+    uint64_t values[] = { cor->mem_soft_limit, cor->mem_hard_limit };
+
+    purc_variant_t retv = make_ulongint_object(keys, values,
+            PCA_TABLESIZE(keys));
+    if (retv == PURC_VARIANT_INVALID && silently)
+        return purc_variant_make_undefined();
+    return retv;
+}
+
+/* the soft and the optional hard limits in bytes; zero for no limit */
+static purc_variant_t
+mem_limits_setter(purc_variant_t root,
+        size_t nr_args, purc_variant_t *argv, bool silently)
+{
+    if (nr_args < 1) {
+        purc_set_error(PURC_ERROR_ARGUMENT_MISSED);
+        goto failed;
+    }
+
+    pcintr_coroutine_t cor = hvml_ctrl_coroutine(root);
+    assert(cor);
+
+    uint64_t soft, hard = cor->mem_hard_limit;
+    if (!purc_variant_cast_to_ulongint(argv[0], &soft, false) ||
+            (nr_args > 1 &&
+             !purc_variant_cast_to_ulongint(argv[1], &hard, false))) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        goto failed;
+    }
+
+    cor->mem_soft_limit = (size_t)soft;
+    cor->mem_hard_limit = (size_t)hard;
+    cor->mem_soft_notified = 0;
+    return purc_variant_make_boolean(true);
+
+failed:
+    if (silently)
+        return purc_variant_make_boolean(false);
+    return PURC_VARIANT_INVALID;
+}
+
+static purc_variant_t
+frame_stat_getter(purc_variant_t root,
+        size_t nr_args, purc_variant_t *argv, bool silently)
+{
+    UNUSED_PARAM(nr_args);
+    UNUSED_PARAM(argv);
+    UNUSED_PARAM(silently);
+
+    pcintr_coroutine_t cor = hvml_ctrl_coroutine(root);
+    assert(cor);
+
+    purc_variant_t retv = purc_variant_make_object_0();
+    if (retv == PURC_VARIANT_INVALID)
+        goto failed;
+
+    static const char *keys[] = { "hits", "misses", "free" };
+    uint64_t values[] = { cor->stack.nr_frame_hits,
+        cor->stack.nr_frame_misses, cor->stack.nr_free_frames };
+    for (size_t i = 0; i < PCA_TABLESIZE(keys); i++) {
+        purc_variant_t val = purc_variant_make_ulongint(values[i]);
+        if (val == PURC_VARIANT_INVALID ||
+                !purc_variant_object_set_by_static_ckey(retv, keys[i], val)) {
+            if (val)
+                purc_variant_unref(val);
+            goto failed;
+        }
+        purc_variant_unref(val);
+    }
+
+    return retv;
+
+failed:
+    if (retv)
+        purc_variant_unref(retv);
+    if (silently)
+        return purc_variant_make_undefined();
+    return PURC_VARIANT_INVALID;
+}
+
 static purc_variant_t
 cid_getter(purc_variant_t root,
         size_t nr_args, purc_variant_t *argv, bool silently)
@@ -469,6 +736,33 @@ curator_getter(purc_variant_t root,
     return purc_variant_make_ulongint(cor->curator);
 }
 
+bool
+pcdvobjs_coroutine_init_attrs(pcintr_coroutine_t cor)
+{
+    cor->target = strdup(DEFAULT_HVML_TARGET);
+    if (cor->target == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return false;
+    }
+
+    cor->base_url_string = strdup(DEFAULT_HVML_BASE);
+    if (cor->base_url_string == NULL ||
+            !pcutils_url_break_down(&cor->base_url_broken_down,
+                DEFAULT_HVML_BASE)) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return false;
+    }
+
+    cor->max_iteration_count = UINT64_MAX;
+    cor->max_recursion_depth = UINT16_MAX;
+    cor->max_embedded_levels = DEF_EMBEDDED_LEVELS;
+    cor->timeout.tv_sec = DEFAULT_HVML_TIMEOUT_SEC;
+    cor->timeout.tv_nsec = DEFAULT_HVML_TIMEOUT_NSEC;
+    cor->slice_steps = PCINTR_DEF_SLICE_STEPS;
+    cor->slice_time = PCINTR_DEF_SLICE_TIME;
+    return true;
+}
+
 purc_variant_t
 purc_dvobj_coroutine_new(pcintr_coroutine_t cor)
 {
@@ -485,6 +779,12 @@ purc_dvobj_coroutine_new(pcintr_coroutine_t cor)
         { "max_embedded_levels",
             max_embedded_levels_getter, max_embedded_levels_setter },
         { "timeout", timeout_getter, timeout_setter },
+        { "slice_steps", slice_steps_getter, slice_steps_setter },
+        { "slice_time",  slice_time_getter,  slice_time_setter },
+        { "slice_stat",  slice_stat_getter,  NULL },
+        { "frame_stat",  frame_stat_getter,  NULL },
+        { "mem_stat",    mem_stat_getter,    NULL },
+        { "mem_limits",  mem_limits_getter,  mem_limits_setter },
         { "cid",     cid_getter,     NULL },
         { "uri",     uri_getter,     NULL },
         { "token",   token_getter,   NULL },
@@ -497,26 +797,6 @@ purc_dvobj_coroutine_new(pcintr_coroutine_t cor)
         goto failed;
     }
 
-    cor->target = strdup(DEFAULT_HVML_TARGET);
-    if (cor->target == NULL) {
-        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
-        goto failed;
-    }
-
-    cor->base_url_string = strdup(DEFAULT_HVML_BASE);
-    if (cor->base_url_string == NULL ||
-            !pcutils_url_break_down(&cor->base_url_broken_down,
-                DEFAULT_HVML_BASE)) {
-        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
-        goto failed;
-    }
-
-    cor->max_iteration_count = UINT64_MAX;
-    cor->max_recursion_depth = UINT16_MAX;
-    cor->max_embedded_levels = DEF_EMBEDDED_LEVELS;
-    cor->timeout.tv_sec = DEFAULT_HVML_TIMEOUT_SEC;
-    cor->timeout.tv_nsec = DEFAULT_HVML_TIMEOUT_NSEC;
-
     val = purc_variant_make_native((void *)cor, NULL);
     if (val == PURC_VARIANT_INVALID) {
         pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
@@ -37,6 +37,7 @@
 #include "purc-version.h"
 
 #include <errno.h>
+#include <locale.h>
 #include <time.h>
 #include <math.h>
 #include <sys/time.h>
@@ -149,56 +150,28 @@ static const char *timeformats[] = {
     _TF_w3c,
 };
 
-static char *set_tz(const char *timezone)
-{
-    char *tz_old = NULL;
-
-    if (timezone) {
-        char *env = getenv("TZ");
-        if (env)
-            tz_old = strdup(env);
-
-        if (env == NULL || strcmp(env, timezone)) {
-            /* change timezone temporarily. */
-            char new_timezone[strlen(timezone) + 1];
-            strcpy(new_timezone, ":");
-            strcat(new_timezone, timezone);
-            setenv("TZ", new_timezone, 1);
-            tzset();
-        }
-    }
-
-    return tz_old;
-}
-
-static void unset_tz(char *tz_old)
-{
-    if (tz_old) {
-        if (strcmp(getenv("TZ"), tz_old)) {
-            // restore old timezone.
-            setenv("TZ", tz_old, 1);
-            tzset();
-        }
-        free(tz_old);
-    }
-}
-
+/* the conversions in a timezone given never change the environment */
 static void get_local_broken_down_time(struct tm *result,
         time_t sec, const char *timezone)
 {
-    char *tz_old = set_tz(timezone);
-    localtime_r(&sec, result);
-    unset_tz(tz_old);
+    const struct pcdvobjs_tzinfo *tz;
+    if (timezone && (tz = pcdvobjs_tzinfo_get(timezone))) {
+        pcdvobjs_tzinfo_localtime(tz, sec, result);
+    }
+    else {
+        localtime_r(&sec, result);
+    }
 }
 
 static time_t get_time_from_broken_down_time(struct tm *tm,
         const char *timezone)
 {
-    char *tz_old = set_tz(timezone);
-    time_t t = mktime(tm);
-    unset_tz(tz_old);
+    const struct pcdvobjs_tzinfo *tz;
+    if (timezone && (tz = pcdvobjs_tzinfo_get(timezone))) {
+        return pcdvobjs_tzinfo_mktime(tz, tm);
+    }
 
-    return t;
+    return mktime(tm);
 }
 
 #define DEF_LEN_ABBR_NAME       32
@@ -467,9 +440,499 @@ on_found(const char *needle, size_t len, void *ctxt, size_t *rep_len)
     return result;
 }
 
+#define LDNAME_TIME_FORMATS     "datetime_time_formats"
+#define NR_CACHED_TIME_FORMATS  16
+
+enum {
+    TF_OP_LITERAL = 0,
+    TF_OP_STRFTIME,     /* a conversion done by strftime(), e.g., `%c` */
+    TF_OP_YEAR,         /* %Y */
+    TF_OP_YEAR2,        /* %y */
+    TF_OP_MON,          /* %m */
+    TF_OP_MDAY,         /* %d */
+    TF_OP_HOUR,         /* %H */
+    TF_OP_MIN,          /* %M */
+    TF_OP_SEC,          /* %S */
+    TF_OP_WDAY_NAME,    /* %a */
+    TF_OP_MON_NAME,     /* %b or %h */
+    TF_OP_ZONE,         /* %z */
+    TF_OP_ZONE_NAME,    /* %Z */
+    TF_OP_ZONE_COLON,   /* {%z:} */
+    TF_OP_MSEC,         /* {m} */
+};
+
+struct time_op {
+    uint8_t     op;
+    /* the text in the texts of the format, for TF_OP_LITERAL and
+       TF_OP_STRFTIME; the one for TF_OP_STRFTIME is null-terminated */
+    uint16_t    len;
+    uint32_t    off;
+};
+
+/* a time format compiled to the operations, so it is parsed only once */
+struct time_format {
+    unsigned    hash;
+    char       *source;
+    size_t      len;
+
+    /* interpreted by strftime() and handle_braces() as a whole */
+    bool        generic;
+    /* uses the names of the weekdays or months */
+    bool        names;
+    /* the maximal length of the result */
+    size_t      max_len;
+
+    char       *texts;
+    size_t      nr_ops;
+    struct time_op ops[];
+};
+
+struct time_format_cache {
+    size_t nr;
+    /* the most recently used one comes first */
+    struct time_format *formats[NR_CACHED_TIME_FORMATS];
+};
+
+static void free_time_format(struct time_format *fmt)
+{
+    free(fmt->source);
+    free(fmt->texts);
+    free(fmt);
+}
+
+static void cb_free_time_format_cache(void *key, void *local_data)
+{
+    UNUSED_PARAM(key);
+
+    struct time_format_cache *cache = local_data;
+    for (size_t i = 0; i < cache->nr; i++)
+        free_time_format(cache->formats[i]);
+    free(cache);
+}
+
+static struct time_format_cache *get_time_format_cache(void)
+{
+    struct time_format_cache *cache = NULL;
+
+    if (purc_get_local_data(LDNAME_TIME_FORMATS,
+                (uintptr_t *)&cache, NULL) == 1)
+        return cache;
+
+    cache = calloc(1, sizeof(*cache));
+    if (cache && !purc_set_local_data(LDNAME_TIME_FORMATS,
+                (uintptr_t)cache, cb_free_time_format_cache)) {
+        free(cache);
+        cache = NULL;
+    }
+    return cache;
+}
+
+/* FNV-1a */
+static unsigned hash_time_format(const char *timeformat, size_t len)
+{
+    unsigned hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)timeformat[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int simple_time_op(int specifier)
+{
+    switch (specifier) {
+    case 'Y':
+        return TF_OP_YEAR;
+    case 'y':
+        return TF_OP_YEAR2;
+    case 'm':
+        return TF_OP_MON;
+    case 'd':
+        return TF_OP_MDAY;
+    case 'H':
+        return TF_OP_HOUR;
+    case 'M':
+        return TF_OP_MIN;
+    case 'S':
+        return TF_OP_SEC;
+    case 'a':
+        return TF_OP_WDAY_NAME;
+    case 'b':
+    case 'h':
+        return TF_OP_MON_NAME;
+    case 'z':
+        return TF_OP_ZONE;
+    case 'Z':
+        return TF_OP_ZONE_NAME;
+    default:
+        break;
+    }
+
+    return TF_OP_STRFTIME;
+}
+
+static bool append_text(struct time_format *fmt, size_t *sz_texts,
+        const char *text, size_t len)
+{
+    /* merge with the literal text before */
+    if (fmt->nr_ops > 0 && fmt->ops[fmt->nr_ops - 1].op == TF_OP_LITERAL &&
+            fmt->ops[fmt->nr_ops - 1].len + len <= UINT16_MAX) {
+        memcpy(fmt->texts + *sz_texts, text, len);
+        *sz_texts += len;
+        fmt->ops[fmt->nr_ops - 1].len += len;
+        fmt->max_len += len;
+        return true;
+    }
+
+    if (len > UINT16_MAX)
+        return false;
+
+    struct time_op *op = fmt->ops + fmt->nr_ops++;
+    op->op = TF_OP_LITERAL;
+    op->len = (uint16_t)len;
+    op->off = (uint32_t)*sz_texts;
+    memcpy(fmt->texts + *sz_texts, text, len);
+    *sz_texts += len;
+    fmt->max_len += len;
+    return true;
+}
+
+/* Compiles the format; the braces other than `{m}` and `{%z:}`, and the
+   escaped ones, are left to the generic way. */
+static struct time_format *compile_time_format(const char *timeformat,
+        size_t len)
+{
+    /* one operation per character at most */
+    struct time_format *fmt = calloc(1,
+            sizeof(*fmt) + sizeof(struct time_op) * (len + 1));
+    if (fmt == NULL || (fmt->texts = malloc(len * 2 + 1)) == NULL) {
+        free(fmt);
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    size_t sz_texts = 0;
+    const char *p = timeformat;
+    const char *end = timeformat + len;
+    while (p < end && !fmt->generic) {
+        if (p[0] == '\\' && (p[1] == '{' || p[1] == '}')) {
+            fmt->generic = true;
+        }
+        else if (p[0] == '{') {
+            struct time_op *op = fmt->ops + fmt->nr_ops;
+            if (strncmp(p, "{m}", 3) == 0) {
+                op->op = TF_OP_MSEC;
+                fmt->max_len += 3;
+                p += 3;
+            }
+            else if (strncmp(p, "{%z:}", 5) == 0) {
+                op->op = TF_OP_ZONE_COLON;
+                fmt->max_len += 6;
+                p += 5;
+            }
+            else {
+                fmt->generic = true;
+                break;
+            }
+            fmt->nr_ops++;
+        }
+        else if (p[0] == '%') {
+            /* the flags and the width of glibc change the length */
+            const char *q = p + 1;
+            if (q < end && (*q == 'E' || *q == 'O'))
+                q++;
+            if (q >= end || strchr("-_0^#", *q) || purc_isdigit(*q)) {
+                fmt->generic = true;
+                break;
+            }
+
+            int specifier = *q++;
+            if (q - p == 2 && specifier == '%') {
+                append_text(fmt, &sz_texts, "%", 1);
+            }
+            else if (q - p == 2 && specifier == 'n') {
+                append_text(fmt, &sz_texts, "\n", 1);
+            }
+            else if (q - p == 2 && specifier == 't') {
+                append_text(fmt, &sz_texts, "\t", 1);
+            }
+            else {
+                struct time_op *op = fmt->ops + fmt->nr_ops++;
+                op->op = (q - p == 2) ? simple_time_op(specifier) :
+                    TF_OP_STRFTIME;
+
+                /* the spec for the fallback to strftime() */
+                op->len = (uint16_t)(q - p);
+                op->off = (uint32_t)sz_texts;
+                memcpy(fmt->texts + sz_texts, p, q - p);
+                sz_texts += q - p;
+                fmt->texts[sz_texts++] = 0;
+
+                if (op->op == TF_OP_WDAY_NAME || op->op == TF_OP_MON_NAME)
+                    fmt->names = true;
+                fmt->max_len += length_of_specifier(specifier);
+            }
+            p = q;
+        }
+        else {
+            const char *q = p + 1;
+            while (q < end && *q != '%' && *q != '{' && *q != '\\')
+                q++;
+            if (!append_text(fmt, &sz_texts, p, q - p))
+                fmt->generic = true;
+            p = q;
+        }
+    }
+
+    /* strftime() fails with an empty result as well */
+    if (fmt->nr_ops == 0)
+        fmt->generic = true;
+    return fmt;
+}
+
+/* Returns the compiled format owned by the cache, or by the caller via
+   @to_free if there is no cache. */
+static const struct time_format *
+get_time_format(const char *timeformat, struct time_format **to_free)
+{
+    struct time_format_cache *cache = get_time_format_cache();
+    size_t len = strlen(timeformat);
+    unsigned hash = hash_time_format(timeformat, len);
+
+    *to_free = NULL;
+    if (cache) {
+        for (size_t i = 0; i < cache->nr; i++) {
+            struct time_format *fmt = cache->formats[i];
+            if (fmt->hash == hash && fmt->len == len &&
+                    memcmp(fmt->source, timeformat, len) == 0) {
+                memmove(cache->formats + 1, cache->formats,
+                        sizeof(cache->formats[0]) * i);
+                cache->formats[0] = fmt;
+                return fmt;
+            }
+        }
+    }
+
+    struct time_format *fmt = compile_time_format(timeformat, len);
+    if (fmt == NULL)
+        return NULL;
+
+    fmt->hash = hash;
+    fmt->len = len;
+    fmt->source = cache ? strndup(timeformat, len) : NULL;
+    if (fmt->source == NULL) {
+        *to_free = fmt;
+        return fmt;
+    }
+
+    if (cache->nr == NR_CACHED_TIME_FORMATS) {
+        cache->nr--;
+        free_time_format(cache->formats[cache->nr]);
+    }
+    memmove(cache->formats + 1, cache->formats,
+            sizeof(cache->formats[0]) * cache->nr);
+    cache->formats[0] = fmt;
+    cache->nr++;
+    return fmt;
+}
+
+static char *put_2digits(char *p, int v)
+{
+    p[0] = '0' + v / 10;
+    p[1] = '0' + v % 10;
+    return p + 2;
+}
+
+/* the names in the C locale */
+static bool is_c_time_locale(void)
+{
+    const char *locale = setlocale(LC_TIME, NULL);
+    return locale && (strcmp(locale, "C") == 0 ||
+            strcmp(locale, "POSIX") == 0);
+}
+
+/* Executes the operations of the format; returns the end of the result,
+   or NULL if some conversion can not be done. */
+static char *
+run_time_format(const struct time_format *fmt, const struct tm *tm,
+        suseconds_t usec, char *p)
+{
+    static const char *wday_names[] = {
+        "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"
+    };
+    static const char *mon_names[] = {
+        "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+        "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+    };
+
+    bool c_names = fmt->names && is_c_time_locale();
+    int year = tm->tm_year + 1900;
+
+    for (size_t i = 0; i < fmt->nr_ops; i++) {
+        const struct time_op *op = fmt->ops + i;
+        int op_code = op->op;
+
+        /* out of the ranges of the direct ways */
+        switch (op_code) {
+        case TF_OP_YEAR:
+            if (year < 1000 || year > 9999)
+                op_code = TF_OP_STRFTIME;
+            break;
+        case TF_OP_YEAR2:
+            if (year < 0)
+                op_code = TF_OP_STRFTIME;
+            break;
+        case TF_OP_MON:
+            if (tm->tm_mon < 0 || tm->tm_mon > 11)
+                op_code = TF_OP_STRFTIME;
+            break;
+        case TF_OP_MDAY:
+            if (tm->tm_mday < 0 || tm->tm_mday > 99)
+                op_code = TF_OP_STRFTIME;
+            break;
+        case TF_OP_HOUR:
+            if (tm->tm_hour < 0 || tm->tm_hour > 99)
+                op_code = TF_OP_STRFTIME;
+            break;
+        case TF_OP_MIN:
+            if (tm->tm_min < 0 || tm->tm_min > 99)
+                op_code = TF_OP_STRFTIME;
+            break;
+        case TF_OP_SEC:
+            if (tm->tm_sec < 0 || tm->tm_sec > 99)
+                op_code = TF_OP_STRFTIME;
+            break;
+        case TF_OP_WDAY_NAME:
+            if (!c_names || tm->tm_wday < 0 || tm->tm_wday > 6)
+                op_code = TF_OP_STRFTIME;
+            break;
+        case TF_OP_MON_NAME:
+            if (!c_names || tm->tm_mon < 0 || tm->tm_mon > 11)
+                op_code = TF_OP_STRFTIME;
+            break;
+#if !HAVE(TM_GMTOFF)
+        case TF_OP_ZONE:
+            op_code = TF_OP_STRFTIME;
+            break;
+#endif
+        case TF_OP_ZONE_NAME:
+#if HAVE(TM_ZONE)
+            if (tm->tm_zone == NULL)
+#endif
+                op_code = TF_OP_STRFTIME;
+            break;
+        default:
+            break;
+        }
+
+        switch (op_code) {
+        case TF_OP_LITERAL:
+            memcpy(p, fmt->texts + op->off, op->len);
+            p += op->len;
+            break;
+
+        case TF_OP_STRFTIME:
+        {
+            const char *spec = fmt->texts + op->off;
+            /* an empty result is fine for a single conversion */
+            p += strftime(p, length_of_specifier(spec[op->len - 1]) + 1,
+                    spec, tm);
+            break;
+        }
+
+        case TF_OP_YEAR:
+            p = put_2digits(p, year / 100);
+            p = put_2digits(p, year % 100);
+            break;
+        case TF_OP_YEAR2:
+            p = put_2digits(p, year % 100);
+            break;
+        case TF_OP_MON:
+            p = put_2digits(p, tm->tm_mon + 1);
+            break;
+        case TF_OP_MDAY:
+            p = put_2digits(p, tm->tm_mday);
+            break;
+        case TF_OP_HOUR:
+            p = put_2digits(p, tm->tm_hour);
+            break;
+        case TF_OP_MIN:
+            p = put_2digits(p, tm->tm_min);
+            break;
+        case TF_OP_SEC:
+            p = put_2digits(p, tm->tm_sec);
+            break;
+
+        case TF_OP_WDAY_NAME:
+            memcpy(p, wday_names[tm->tm_wday], 3);
+            p += 3;
+            break;
+        case TF_OP_MON_NAME:
+            memcpy(p, mon_names[tm->tm_mon], 3);
+            p += 3;
+            break;
+
+#if HAVE(TM_GMTOFF)
+        case TF_OP_ZONE:
+        case TF_OP_ZONE_COLON:
+        {
+            long off = tm->tm_gmtoff;
+            *p++ = (off < 0) ? '-' : '+';
+            if (off < 0)
+                off = -off;
+            p = put_2digits(p, (int)(off / 3600 % 100));
+            if (op_code == TF_OP_ZONE_COLON)
+                *p++ = ':';
+            p = put_2digits(p, (int)(off / 60 % 60));
+            break;
+        }
+#else
+        case TF_OP_ZONE_COLON:
+        {
+            char zone[16];
+            if (strftime(zone, sizeof(zone), "%z", tm) != 5)
+                return NULL;
+            memcpy(p, zone, 3);
+            p[3] = ':';
+            memcpy(p + 4, zone + 3, 2);
+            p += 6;
+            break;
+        }
+#endif
+
+#if HAVE(TM_ZONE)
+        case TF_OP_ZONE_NAME:
+        {
+            size_t n = strnlen(tm->tm_zone, DEF_LEN_TIMEZONE_NAME);
+            memcpy(p, tm->tm_zone, n);
+            p += n;
+            break;
+        }
+#endif
+
+        case TF_OP_MSEC:
+        {
+            if (usec < 0) usec = 0;
+            if (usec > 999999) usec = 999999;
+
+            int msec = usec / 1000;
+            *p++ = '0' + msec / 100;
+            p = put_2digits(p, msec % 100);
+            break;
+        }
+
+        default:
+            return NULL;
+        }
+    }
+
+    return p;
+}
+
+/* the format is interpreted by strftime(), then the braces are handled */
 static purc_variant_t
-format_broken_down_time(const char *timeformat, const struct tm *tm,
-        suseconds_t usec, const char *timezone)
+interpret_time_format(const char *timeformat, const struct tm *tm,
+        suseconds_t usec)
 {
     size_t max;
     char *result = NULL;
@@ -483,14 +946,13 @@ format_broken_down_time(const char *timeformat, const struct tm *tm,
         return PURC_VARIANT_INVALID;
     }
 
-    char *tz_old = set_tz(timezone);
     if (strftime(result, max, timeformat, tm) == 0) {
         // should not occur.
         PC_ERROR("Too small buffer to format time\n");
+        free(result);
         purc_set_error(PURC_ERROR_TOO_SMALL_BUFF);
         return PURC_VARIANT_INVALID;
     }
-    unset_tz(tz_old);
 
     // PC_DEBUG("formated time: %s\n", result);
 
@@ -548,6 +1010,45 @@ format_broken_down_time(const char *timeformat, const struct tm *tm,
     return purc_variant_make_string_reuse_buff(result, max, false);
 }
 
+/* %z and %Z are formatted with tm_gmtoff and tm_zone of @tm */
+static purc_variant_t
+format_broken_down_time(const char *timeformat, const struct tm *tm,
+        suseconds_t usec)
+{
+    struct time_format *to_free;
+    const struct time_format *fmt = get_time_format(timeformat, &to_free);
+    if (fmt == NULL)
+        return PURC_VARIANT_INVALID;
+
+    purc_variant_t retv = PURC_VARIANT_INVALID;
+    char *result = NULL;
+    char *end = NULL;
+    if (!fmt->generic) {
+        result = malloc(fmt->max_len + 1);
+        if (result == NULL) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            goto done;
+        }
+
+        end = run_time_format(fmt, tm, usec, result);
+    }
+
+    if (end) {
+        *end = 0;
+        retv = purc_variant_make_string_reuse_buff(result,
+                fmt->max_len + 1, false);
+    }
+    else {
+        free(result);
+        retv = interpret_time_format(timeformat, tm, usec);
+    }
+
+done:
+    if (to_free)
+        free_time_format(to_free);
+    return retv;
+}
+
 static purc_variant_t
 format_time(const char *timeformat, const struct timeval *tv,
         const char *timezone)
@@ -564,7 +1065,7 @@ format_time(const char *timeformat, const struct timeval *tv,
         get_local_broken_down_time(&tm, tv->tv_sec, timezone);
     }
 
-    return format_broken_down_time(timeformat, &tm, tv->tv_usec, timezone);
+    return format_broken_down_time(timeformat, &tm, tv->tv_usec);
 }
 
 static purc_variant_t
@@ -1141,11 +1642,7 @@ get_broken_down_time(purc_variant_t bdtime, struct tm *tm, suseconds_t *usec)
     if (number < 0)
         tm->tm_isdst = -1;
 
-    char *tz_old = set_tz(timezone);
-    time_t t = mktime(tm);
-    localtime_r(&t, tm);
-    unset_tz(tz_old);
-
+    get_time_from_broken_down_time(tm, timezone);
     return timezone;
 
 failed:
@@ -1195,7 +1692,7 @@ fmtbdtime_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
                 sizeof(PURC_TFORMAT_PREFIX_UTC) - 1) == 0) {
         timeformat += sizeof(PURC_TFORMAT_PREFIX_UTC) - 1;
     }
-    return format_broken_down_time(timeformat, &tm, usec, timezone);
+    return format_broken_down_time(timeformat, &tm, usec);
 
 failed:
     if (silently)
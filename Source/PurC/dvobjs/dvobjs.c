@@ -191,6 +191,7 @@ static int _init_once(void)
 }
 
 struct pcmodule _module_dvobjs = {
+    .name            = "dvobjs",
     .id              = PURC_HAVE_EJSON,
     .module_inited   = 0,
 
@@ -29,8 +29,10 @@
 
 #include "private/variant.h"
 #include "private/errors.h"
+#include "private/ejson.h"
 #include "private/atom-buckets.h"
 #include "private/dvobjs.h"
+#include "private/interpreter.h"
 #include "private/utils.h"
 #include "private/utf8.h"
 #include "helper.h"
@@ -613,13 +615,18 @@ parse_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         goto failed;
     }
 
+    purc_variant_t retv;
+    if (pcejson_parse_plain(&retv, string, length,
+                PCEJSON_DEFAULT_DEPTH, 0) == 0) {
+        return retv;
+    }
+
     struct purc_ejson_parse_tree *ptree;
     ptree = purc_variant_ejson_parse_string(string, length);
     if (ptree == NULL) {
         goto failed;
     }
 
-    purc_variant_t retv;
     retv = purc_variant_ejson_parse_tree_evalute(ptree, NULL, NULL, silently);
     purc_variant_ejson_parse_tree_destroy(ptree);
     return retv;
@@ -631,6 +638,69 @@ failed:
     return PURC_VARIANT_INVALID;
 }
 
+static purc_variant_t
+encode_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+{
+    UNUSED_PARAM(root);
+    UNUSED_PARAM(silently);
+
+    if (nr_args < 1) {
+        purc_set_error(PURC_ERROR_ARGUMENT_MISSED);
+        return PURC_VARIANT_INVALID;
+    }
+
+    purc_rwstream_t my_stream;
+    my_stream = purc_rwstream_new_buffer(LEN_INI_SERIALIZE_BUF,
+            LEN_MAX_SERIALIZE_BUF);
+    if (my_stream == NULL)
+        return PURC_VARIANT_INVALID;
+
+    if (purc_variant_serialize_binary(argv[0], my_stream, 0) < 0) {
+        purc_rwstream_destroy(my_stream);
+        return PURC_VARIANT_INVALID;
+    }
+
+    size_t sz_content, sz_buffer;
+    void *bytes = purc_rwstream_get_mem_buffer_ex(my_stream,
+            &sz_content, &sz_buffer, true);
+    purc_rwstream_destroy(my_stream);
+
+    return purc_variant_make_byte_sequence_reuse_buff(bytes, sz_content,
+            sz_buffer);
+}
+
+static purc_variant_t
+decode_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+{
+    UNUSED_PARAM(root);
+
+    if (nr_args < 1) {
+        purc_set_error(PURC_ERROR_ARGUMENT_MISSED);
+        goto failed;
+    }
+
+    if (!purc_variant_is_bsequence(argv[0])) {
+        purc_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+        goto failed;
+    }
+
+    const unsigned char *bytes;
+    size_t nr_bytes;
+    bytes = purc_variant_get_bytes_const(argv[0], &nr_bytes);
+
+    purc_variant_t retv = purc_variant_load_from_binary(bytes, nr_bytes, 0);
+    if (retv)
+        return retv;
+
+failed:
+    if (silently)
+        return purc_variant_make_undefined();
+
+    return PURC_VARIANT_INVALID;
+}
+
 static purc_variant_t
 isequal_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         bool silently)
@@ -1070,6 +1140,27 @@ static size_t dump_utf8_string(const char *str, size_t len, size_t nr_chars,
     return n;
 }
 
+static inline purc_variant_t
+make_real(int real_id, const unsigned char *bytes)
+{
+    purc_real_t real = real_info[real_id].fetcher(bytes);
+    switch (real_info[real_id].real_type) {
+        case PURC_VARIANT_TYPE_LONGINT:
+            return purc_variant_make_longint(real.i64);
+        case PURC_VARIANT_TYPE_ULONGINT:
+            return purc_variant_make_ulongint(real.u64);
+        case PURC_VARIANT_TYPE_NUMBER:
+            return purc_variant_make_number(real.d);
+        case PURC_VARIANT_TYPE_LONGDOUBLE:
+            return purc_variant_make_longdouble(real.ld);
+        default:
+            assert(0);
+            break;
+    }
+
+    return PURC_VARIANT_INVALID;
+}
+
 purc_variant_t
 purc_dvobj_unpack_real(const unsigned char *bytes, size_t nr_bytes,
         int format_id, size_t quantity)
@@ -1081,20 +1172,7 @@ purc_dvobj_unpack_real(const unsigned char *bytes, size_t nr_bytes,
     }
 
     if (quantity == 1) {
-        purc_real_t real = real_info[real_id].fetcher(bytes);
-        switch (real_info[real_id].real_type) {
-            case PURC_VARIANT_TYPE_LONGINT:
-                return purc_variant_make_longint(real.i64);
-            case PURC_VARIANT_TYPE_ULONGINT:
-                return purc_variant_make_ulongint(real.u64);
-            case PURC_VARIANT_TYPE_NUMBER:
-                return purc_variant_make_ulongint(real.d);
-            case PURC_VARIANT_TYPE_LONGDOUBLE:
-                return purc_variant_make_ulongint(real.ld);
-            default:
-                assert(0);
-                break;
-        }
+        return make_real(real_id, bytes);
     }
     else {
         purc_variant_t retv;
@@ -1105,26 +1183,7 @@ purc_dvobj_unpack_real(const unsigned char *bytes, size_t nr_bytes,
         }
 
         for (size_t i = 0; i < quantity; i++) {
-            purc_variant_t vrt = PURC_VARIANT_INVALID;
-            purc_real_t real = real_info[real_id].fetcher(bytes);
-            switch (real_info[real_id].real_type) {
-                case PURC_VARIANT_TYPE_LONGINT:
-                    vrt = purc_variant_make_longint(real.i64);
-                    break;
-                case PURC_VARIANT_TYPE_ULONGINT:
-                    vrt = purc_variant_make_ulongint(real.u64);
-                    break;
-                case PURC_VARIANT_TYPE_NUMBER:
-                    vrt = purc_variant_make_ulongint(real.d);
-                    break;
-                case PURC_VARIANT_TYPE_LONGDOUBLE:
-                    vrt = purc_variant_make_ulongint(real.ld);
-                    break;
-                default:
-                    assert(0);
-                    break;
-            }
-
+            purc_variant_t vrt = make_real(real_id, bytes);
             if (vrt == PURC_VARIANT_INVALID)
                 goto fatal;
 
@@ -1219,119 +1278,313 @@ fatal:
     return PURC_VARIANT_INVALID;
 }
 
+/*
+ * The formats of pack(), unpack(), readstruct(), and writestruct() are
+ * compiled to an array of fields once, and the ones used recently are kept
+ * in a small LRU cache of the instance; a protocol decoding many messages
+ * with the same formats parses them only once.
+ */
+#define LDNAME_PACK_FORMATS     "ejson_pack_formats"
+#define NR_CACHED_FORMATS       32
+
+struct pack_field {
+    int         format_id;
+    size_t      quantity;       // 0 if not specified
+};
+
+struct pack_format {
+    unsigned    hash;
+    char       *source;
+    size_t      len;
+
+    /* the size of a record in bytes, 0 if any field has a variable size */
+    size_t      record_size;
+    /* the number of the fields except the paddings */
+    size_t      nr_members;
+
+    size_t      nr_fields;
+    struct pack_field fields[];
+};
+
+struct format_cache {
+    size_t nr;
+    /* the most recently used one comes first */
+    struct pack_format *formats[NR_CACHED_FORMATS];
+};
+
+static void free_pack_format(struct pack_format *fmt)
+{
+    free(fmt->source);
+    free(fmt);
+}
+
+static void cb_free_format_cache(void *key, void *local_data)
+{
+    UNUSED_PARAM(key);
+
+    struct format_cache *cache = local_data;
+    for (size_t i = 0; i < cache->nr; i++)
+        free_pack_format(cache->formats[i]);
+    free(cache);
+}
+
+static struct format_cache *get_format_cache(void)
+{
+    struct format_cache *cache = NULL;
+
+    if (purc_get_local_data(LDNAME_PACK_FORMATS,
+                (uintptr_t *)&cache, NULL) == 1)
+        return cache;
+
+    cache = calloc(1, sizeof(*cache));
+    if (cache && !purc_set_local_data(LDNAME_PACK_FORMATS,
+                (uintptr_t)cache, cb_free_format_cache)) {
+        free(cache);
+        cache = NULL;
+    }
+    return cache;
+}
+
+/* FNV-1a */
+static unsigned hash_formats(const char *formats, size_t len)
+{
+    unsigned hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)formats[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static struct pack_format *
+compile_pack_format(const char *formats, size_t formats_left)
+{
+    const char *format;
+    size_t format_len;
+    size_t nr_fields = 0;
+
+    const char *left = formats;
+    size_t nr_left = formats_left;
+    while ((format = pcutils_get_next_token_len(left, nr_left,
+                    _KW_DELIMITERS, &format_len))) {
+        nr_fields++;
+        nr_left -= format + format_len - left;
+        left = format + format_len;
+    }
+
+    struct pack_format *fmt = calloc(1,
+            sizeof(*fmt) + sizeof(struct pack_field) * nr_fields);
+    if (fmt == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    bool fixed = true;
+    left = formats;
+    nr_left = formats_left;
+    while ((format = pcutils_get_next_token_len(left, nr_left,
+                    _KW_DELIMITERS, &format_len))) {
+        nr_left -= format + format_len - left;
+        left = format + format_len;
+
+        struct pack_field *field = fmt->fields + fmt->nr_fields;
+        field->format_id = purc_dvobj_parse_format(format, format_len,
+                &field->quantity);
+
+        if (field->format_id >= PURC_K_KW_i8 &&
+                field->format_id <= PURC_K_KW_f128be) {
+            size_t quantity = field->quantity ? field->quantity : 1;
+            fmt->record_size +=
+                real_info[field->format_id - PURC_K_KW_i8].length * quantity;
+        }
+        else if (field->format_id == PURC_K_KW_bytes ||
+                field->format_id == PURC_K_KW_padding ||
+                (field->format_id >= PURC_K_KW_utf8 &&
+                 field->format_id <= PURC_K_KW_utf32be)) {
+            if (field->quantity == 0)
+                fixed = false;
+            fmt->record_size += field->quantity;
+        }
+        else {
+            free(fmt);
+            purc_set_error(PURC_ERROR_INVALID_VALUE);
+            return NULL;
+        }
+
+        if (field->format_id != PURC_K_KW_padding)
+            fmt->nr_members++;
+        fmt->nr_fields++;
+    }
+
+    if (!fixed)
+        fmt->record_size = 0;
+    return fmt;
+}
+
+/* Returns the compiled formats owned by the cache, or by the caller via
+   @to_free if there is no cache. */
+static const struct pack_format *
+compile_formats(const char *formats, size_t formats_left,
+        struct pack_format **to_free)
+{
+    struct format_cache *cache = get_format_cache();
+    unsigned hash = hash_formats(formats, formats_left);
+
+    *to_free = NULL;
+    if (cache) {
+        for (size_t i = 0; i < cache->nr; i++) {
+            struct pack_format *fmt = cache->formats[i];
+            if (fmt->hash == hash && fmt->len == formats_left &&
+                    memcmp(fmt->source, formats, formats_left) == 0) {
+                memmove(cache->formats + 1, cache->formats,
+                        sizeof(cache->formats[0]) * i);
+                cache->formats[0] = fmt;
+                return fmt;
+            }
+        }
+    }
+
+    struct pack_format *fmt = compile_pack_format(formats, formats_left);
+    if (fmt == NULL)
+        return NULL;
+
+    fmt->hash = hash;
+    fmt->len = formats_left;
+    fmt->source = cache ? strndup(formats, formats_left) : NULL;
+    if (fmt->source == NULL) {
+        *to_free = fmt;
+        return fmt;
+    }
+
+    if (cache->nr == NR_CACHED_FORMATS) {
+        cache->nr--;
+        free_pack_format(cache->formats[cache->nr]);
+    }
+    memmove(cache->formats + 1, cache->formats,
+            sizeof(cache->formats[0]) * cache->nr);
+    cache->formats[0] = fmt;
+    cache->nr++;
+    return fmt;
+}
+
+/* Unpacks a field other than padding. Returns undefined for bad data,
+   or an invalid variant for fatal error. */
+static purc_variant_t
+unpack_field(const struct pack_field *field, const uint8_t *bytes,
+        size_t nr_bytes, size_t *consumed, bool silently)
+{
+    int format_id = field->format_id;
+    size_t quantity = field->quantity;
+
+    if (format_id >= PURC_K_KW_i8 && format_id <= PURC_K_KW_f128be) {
+        if (quantity == 0)
+            quantity = 1;
+
+        *consumed = real_info[format_id - PURC_K_KW_i8].length * quantity;
+        if (*consumed > nr_bytes)
+            goto bad;
+
+        return purc_dvobj_unpack_real(bytes, nr_bytes, format_id, quantity);
+    }
+    else if (format_id == PURC_K_KW_bytes) {
+        if (quantity == 0 || quantity > nr_bytes)
+            goto bad;
+
+        *consumed = quantity;
+        return purc_variant_make_byte_sequence(bytes, quantity);
+    }
+
+    if (quantity > nr_bytes)
+        goto bad;
+
+    if (quantity == 0)
+        quantity = nr_bytes;
+
+    return purc_dvobj_unpack_string(bytes, quantity, consumed,
+            format_id, silently);
+
+bad:
+    purc_set_error(PURC_ERROR_INVALID_VALUE);
+    return purc_variant_make_undefined();
+}
+
 purc_variant_t
 purc_dvobj_unpack_bytes(const uint8_t *bytes, size_t nr_bytes,
         const char *formats, size_t formats_left, bool silently)
 {
     purc_variant_t retv = purc_variant_make_array(0, PURC_VARIANT_INVALID);
     purc_variant_t item = PURC_VARIANT_INVALID;
+    struct pack_format *to_free = NULL;
 
     if (retv == PURC_VARIANT_INVALID) {
         purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
         goto fatal;
     }
 
-    do {
-        const char *format;
-        size_t format_len, consumed;
-
-        format = pcutils_get_next_token_len(formats, formats_left,
-                _KW_DELIMITERS, &format_len);
-        if (format == NULL) {
-            break;
-        }
-
-        formats += format_len;
-        formats_left -= format_len;
-
-        int format_id;
-        size_t quantity;
-        format_id = purc_dvobj_parse_format(format, format_len, &quantity);
-        if (format_id < 0) {
-            purc_set_error(PURC_ERROR_INVALID_VALUE);
-            goto failed;
-        }
-
-        if (format_id >= PURC_K_KW_i8 && format_id <= PURC_K_KW_f128be) {
+    const struct pack_format *fmt;
+    fmt = compile_formats(formats, formats_left, &to_free);
+    if (fmt == NULL) {
+        goto failed;
+    }
 
-            if (quantity == 0)
-                quantity = 1;
+    for (size_t i = 0; i < fmt->nr_fields; i++) {
+        const struct pack_field *field = fmt->fields + i;
+        size_t consumed;
 
-            int real_id = format_id - PURC_K_KW_i8;
-            consumed = real_info[real_id].length * quantity;
-            if (consumed > nr_bytes) {
+        if (field->format_id == PURC_K_KW_padding) {
+            if (field->quantity == 0 || field->quantity > nr_bytes) {
                 purc_set_error(PURC_ERROR_INVALID_VALUE);
                 goto failed;
             }
 
-            item = purc_dvobj_unpack_real(bytes, nr_bytes, format_id, quantity);
+            /* skip the padding bytes */
+            consumed = field->quantity;
         }
-        else if (format_id == PURC_K_KW_bytes) {
-            if (quantity == 0 || quantity > nr_bytes) {
-                purc_set_error(PURC_ERROR_INVALID_VALUE);
-                goto failed;
+        else {
+            item = unpack_field(field, bytes, nr_bytes, &consumed, silently);
+            if (item == PURC_VARIANT_INVALID) {
+                goto fatal;
             }
-
-            item = purc_variant_make_byte_sequence(bytes, quantity);
-            consumed = quantity;
-        }
-        else if (format_id == PURC_K_KW_padding) {
-            if (quantity == 0 || quantity > nr_bytes) {
-                purc_set_error(PURC_ERROR_INVALID_VALUE);
+            else if (purc_variant_is_undefined(item)) {
+                purc_variant_unref(item);
+                item = PURC_VARIANT_INVALID;
                 goto failed;
             }
-
-            item = purc_variant_make_undefined();
-            consumed = quantity;
-        }
-        else if (format_id >= PURC_K_KW_utf8 &&
-                format_id <= PURC_K_KW_utf32be) {
-
-            if (quantity > nr_bytes) {
-                purc_set_error(PURC_ERROR_INVALID_VALUE);
-                goto failed;
+            else if (!purc_variant_array_append(retv, item)) {
+                goto fatal;
             }
-
-            if (quantity == 0)
-                quantity = nr_bytes;
-
-            item = purc_dvobj_unpack_string(bytes, quantity, &consumed,
-                    format_id, silently);
-        }
-
-        if (item == PURC_VARIANT_INVALID) {
-            goto fatal;
-        }
-        else if (purc_variant_is_undefined(item)) {
             purc_variant_unref(item);
-            goto failed;
-        }
-        else if (!purc_variant_array_append(retv, item)) {
-            goto fatal;
+            item = PURC_VARIANT_INVALID;
         }
-        purc_variant_unref(item);
 
         if (consumed >= nr_bytes)
             break;
 
         bytes += consumed;
         nr_bytes -= consumed;
+    }
 
-    } while (true);
+    if (to_free)
+        free_pack_format(to_free);
 
     /* if there is only one member, return the member instead of the array */
     if (purc_variant_array_get_size(retv) == 1) {
-        item = purc_variant_ref(item);
+        item = purc_variant_ref(purc_variant_array_get(retv, 0));
         purc_variant_unref(retv);
         return item;
     }
     return retv;
 
 failed:
-    if (silently)
+    if (silently) {
+        if (to_free)
+            free_pack_format(to_free);
         return retv;
+    }
 
 fatal:
+    if (to_free)
+        free_pack_format(to_free);
     if (item)
         purc_variant_unref(item);
     if (retv)
@@ -1404,12 +1657,19 @@ purc_dvobj_read_struct(purc_rwstream_t stream,
     purc_rwstream_t rws = NULL;
     purc_variant_t retv = purc_variant_make_array(0, PURC_VARIANT_INVALID);
     purc_variant_t item = PURC_VARIANT_INVALID;
+    struct pack_format *to_free = NULL;
 
     if (retv == PURC_VARIANT_INVALID) {
         purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
         goto fatal;
     }
 
+    const struct pack_format *fmt;
+    fmt = compile_formats(formats, formats_left, &to_free);
+    if (fmt == NULL) {
+        goto failed;
+    }
+
     rws = purc_rwstream_new_buffer(LEN_INI_SERIALIZE_BUF,
             LEN_MAX_SERIALIZE_BUF);
     if (rws == NULL) {
@@ -1417,26 +1677,10 @@ purc_dvobj_read_struct(purc_rwstream_t stream,
         goto fatal;
     }
 
-    do {
-        const char *format;
-        size_t format_len, consumed;
-
-        format = pcutils_get_next_token_len(formats, formats_left,
-                _KW_DELIMITERS, &format_len);
-        if (format == NULL) {
-            break;
-        }
-
-        formats += format_len;
-        formats_left -= format_len;
-
-        int format_id;
-        size_t quantity;
-        format_id = purc_dvobj_parse_format(format, format_len, &quantity);
-        if (format_id < 0) {
-            purc_set_error(PURC_ERROR_INVALID_VALUE);
-            goto failed;
-        }
+    for (size_t i = 0; i < fmt->nr_fields; i++) {
+        size_t consumed;
+        int format_id = fmt->fields[i].format_id;
+        size_t quantity = fmt->fields[i].quantity;
 
         if (format_id >= PURC_K_KW_i8 && format_id <= PURC_K_KW_f128be) {
 
@@ -1481,8 +1725,8 @@ purc_dvobj_read_struct(purc_rwstream_t stream,
                 goto failed;
             }
 
-            item = purc_variant_make_undefined();
-            consumed = quantity;
+            /* skip the padding bytes */
+            continue;
         }
         else if (format_id >= PURC_K_KW_utf8 &&
                 format_id <= PURC_K_KW_utf32be) {
@@ -1512,22 +1756,26 @@ purc_dvobj_read_struct(purc_rwstream_t stream,
         }
         else if (purc_variant_is_undefined(item)) {
             purc_variant_unref(item);
+            item = PURC_VARIANT_INVALID;
             goto failed;
         }
         else if (!purc_variant_array_append(retv, item)) {
             goto fatal;
         }
         purc_variant_unref(item);
-    } while (true);
+        item = PURC_VARIANT_INVALID;
+    }
 
     if (rws) {
         purc_rwstream_destroy(rws);
         rws = NULL;
     }
+    if (to_free)
+        free_pack_format(to_free);
 
     /* if there is only one member, return the member instead of the array */
     if (purc_variant_array_get_size(retv) == 1) {
-        item = purc_variant_ref(item);
+        item = purc_variant_ref(purc_variant_array_get(retv, 0));
         purc_variant_unref(retv);
         return item;
     }
@@ -1538,6 +1786,8 @@ failed:
         if (rws) {
             purc_rwstream_destroy(rws);
         }
+        if (to_free)
+            free_pack_format(to_free);
         return retv;
     }
 
@@ -1548,10 +1798,39 @@ fatal:
         purc_variant_unref(retv);
     if (rws)
         purc_rwstream_destroy(rws);
+    if (to_free)
+        free_pack_format(to_free);
 
     return PURC_VARIANT_INVALID;
 }
 
+/* Makes room for @count more bytes; the buffer grows geometrically, and
+   `bytes` is freed and set to NULL if no memory. */
+static int bytes_buff_reserve(struct pcdvobj_bytes_buff *bf, size_t count)
+{
+    size_t needed = bf->nr_bytes + count;
+    if (bf->bytes && needed <= bf->sz_allocated)
+        return 0;
+
+    size_t sz = bf->sz_allocated * 2;
+    if (sz < needed)
+        sz = needed;
+    if (sz < 64)
+        sz = 64;
+
+    uint8_t *bytes = realloc(bf->bytes, sz);
+    if (bytes == NULL) {
+        free(bf->bytes);
+        bf->bytes = NULL;
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    bf->bytes = bytes;
+    bf->sz_allocated = sz;
+    return 0;
+}
+
 int
 purc_dvobj_pack_real(struct pcdvobj_bytes_buff *bf, purc_variant_t item,
         int format_id, size_t quantity, bool silently)
@@ -1560,10 +1839,7 @@ purc_dvobj_pack_real(struct pcdvobj_bytes_buff *bf, purc_variant_t item,
         quantity = 1;
 
     int real_id = format_id - PURC_K_KW_i8;
-    bf->sz_allocated += real_info[real_id].length * quantity;
-    bf->bytes = realloc(bf->bytes, bf->sz_allocated);
-    if (bf->bytes == NULL) {
-        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    if (bytes_buff_reserve(bf, real_info[real_id].length * quantity)) {
         goto failed;
     }
 
@@ -1694,10 +1970,7 @@ purc_dvobj_pack_string(struct pcdvobj_bytes_buff *bf, purc_variant_t item,
         goto failed;
     }
 
-    bf->sz_allocated += length;
-    bf->bytes = realloc(bf->bytes, bf->sz_allocated);
-    if (bf->bytes == NULL) {
-        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    if (bytes_buff_reserve(bf, length)) {
         goto failed;
     }
 
@@ -1717,23 +1990,26 @@ purc_dvobj_pack_variants(struct pcdvobj_bytes_buff *bf,
     size_t item_idx = 0, nr_items;
     bool items_in_array = (nr_args == 1) &&
         purc_variant_array_size(argv[0], &nr_items);
+    struct pack_format *to_free = NULL;
 
     if (!items_in_array) {
         nr_items = nr_args;
     }
 
-    do {
-        const char *format;
-        size_t format_len;
+    const struct pack_format *fmt;
+    fmt = compile_formats(formats, formats_left, &to_free);
+    if (fmt == NULL) {
+        goto failed;
+    }
 
-        format = pcutils_get_next_token_len(formats, formats_left,
-                _KW_DELIMITERS, &format_len);
-        if (format == NULL) {
-            break;
-        }
+    /* the size of the fixed formats is known in advance */
+    if (fmt->record_size && bytes_buff_reserve(bf, fmt->record_size)) {
+        goto failed;
+    }
 
-        formats += format_len;
-        formats_left -= format_len;
+    for (size_t i = 0; i < fmt->nr_fields; i++) {
+        int format_id = fmt->fields[i].format_id;
+        size_t quantity = fmt->fields[i].quantity;
 
         if (item_idx >= nr_items) {
             purc_set_error(PURC_ERROR_ARGUMENT_MISSED);
@@ -1750,13 +2026,6 @@ purc_dvobj_pack_variants(struct pcdvobj_bytes_buff *bf,
         }
         item_idx++;
 
-        size_t quantity;
-        int format_id = purc_dvobj_parse_format(format, format_len, &quantity);
-        if (format_id < 0) {
-            purc_set_error(PURC_ERROR_INVALID_VALUE);
-            goto failed;
-        }
-
         if (format_id >= PURC_K_KW_i8 && format_id <= PURC_K_KW_f128be) {
             if (purc_dvobj_pack_real(bf, item, format_id, quantity,
                         silently)) {
@@ -1782,10 +2051,7 @@ purc_dvobj_pack_variants(struct pcdvobj_bytes_buff *bf,
                 quantity = nr_this;
             }
 
-            bf->sz_allocated += quantity;
-            bf->bytes = realloc(bf->bytes, bf->sz_allocated);
-            if (bf->bytes == NULL) {
-                purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            if (bytes_buff_reserve(bf, quantity)) {
                 goto failed;
             }
 
@@ -1793,10 +2059,7 @@ purc_dvobj_pack_variants(struct pcdvobj_bytes_buff *bf,
             bf->nr_bytes += quantity;
         }
         else if (format_id == PURC_K_KW_padding) {
-            bf->sz_allocated += quantity;
-            bf->bytes = realloc(bf->bytes, bf->sz_allocated);
-            if (bf->bytes == NULL) {
-                purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            if (bytes_buff_reserve(bf, quantity)) {
                 goto failed;
             }
 
@@ -1810,12 +2073,15 @@ purc_dvobj_pack_variants(struct pcdvobj_bytes_buff *bf,
                 goto failed;
             }
         }
+    }
 
-    } while (true);
-
+    if (to_free)
+        free_pack_format(to_free);
     return 0;
 
 failed:
+    if (to_free)
+        free_pack_format(to_free);
     return -1;
 }
 
@@ -1915,36 +2181,254 @@ failed:
     return PURC_VARIANT_INVALID;
 }
 
-static purc_variant_t
-shuffle_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
-        bool silently)
+/* Unpacks the members of a record to @members. */
+static int
+unpack_record(const struct pack_format *fmt, const uint8_t *bytes,
+        purc_variant_t *members, bool silently)
 {
-    UNUSED_PARAM(root);
+    size_t n = 0, left = fmt->record_size;
 
-    if (nr_args < 1) {
-        purc_set_error(PURC_ERROR_ARGUMENT_MISSED);
-        goto failed;
-    }
+    for (size_t i = 0; i < fmt->nr_fields; i++) {
+        const struct pack_field *field = fmt->fields + i;
+        int format_id = field->format_id;
+        size_t consumed = field->quantity;
+        purc_variant_t item;
 
-    if (purc_variant_is_array(argv[0])) {
-        ssize_t sz = purc_variant_array_get_size(argv[0]);
+        if (format_id == PURC_K_KW_padding) {
+            bytes += consumed;
+            left -= consumed;
+            continue;
+        }
+
+        if (format_id >= PURC_K_KW_i8 && format_id <= PURC_K_KW_f128be &&
+                field->quantity <= 1) {
+            /* the most common case: a single real number */
+            int real_id = format_id - PURC_K_KW_i8;
+            item = make_real(real_id, bytes);
+            consumed = real_info[real_id].length;
+        }
+        else {
+            item = unpack_field(field, bytes, left, &consumed, silently);
+            if (format_id >= PURC_K_KW_utf8 && format_id <= PURC_K_KW_utf32be)
+                consumed = field->quantity;
+        }
+
+        if (item == PURC_VARIANT_INVALID)
+            goto failed;
+        else if (purc_variant_is_undefined(item)) {
+            purc_variant_unref(item);
+            goto failed;
+        }
+
+        members[n++] = item;
+        bytes += consumed;
+        left -= consumed;
+    }
+
+    return 0;
+
+failed:
+    while (n > 0)
+        purc_variant_unref(members[--n]);
+    return -1;
+}
+
+/*
+$EJSON.unpack_records(
+        <string $formats>,
+        <bsequence $bytes>
+        [, <'tuples | columns'> $layout = 'tuples']
+) array | tuple
+
+Unpacks all records of the fixed-size formats in @bytes in a single pass.
+Returns an array of tuples (one per record) for `tuples`, or a tuple of
+arrays (one per field except the paddings) for `columns`. When called
+silently, the bytes left after the last whole record are ignored.
+*/
+static purc_variant_t
+unpack_records_getter(purc_variant_t root, size_t nr_args,
+        purc_variant_t *argv, bool silently)
+{
+    UNUSED_PARAM(root);
+
+    purc_variant_t retv = PURC_VARIANT_INVALID;
+    purc_variant_t *members = NULL;
+    struct pack_format *to_free = NULL;
+    const struct pack_format *fmt;
+    bool columns = false;
+
+    if (nr_args < 2) {
+        purc_set_error(PURC_ERROR_ARGUMENT_MISSED);
+        goto failed;
+    }
+
+    const char *formats;
+    size_t formats_left;
+    formats = purc_variant_get_string_const_ex(argv[0], &formats_left);
+    if (formats == NULL) {
+        purc_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+        goto failed;
+    }
+
+    formats = pcutils_trim_spaces(formats, &formats_left);
+    if (formats_left == 0) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        goto failed;
+    }
+
+    const unsigned char *bytes;
+    size_t nr_bytes;
+    bytes = purc_variant_get_bytes_const(argv[1], &nr_bytes);
+    if (bytes == NULL) {
+        purc_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+        goto failed;
+    }
+
+    if (nr_args > 2) {
+        const char *layout;
+        size_t layout_len;
+        layout = purc_variant_get_string_const_ex(argv[2], &layout_len);
+        if (layout == NULL) {
+            purc_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+            goto failed;
+        }
+
+        layout = pcutils_trim_spaces(layout, &layout_len);
+        if (layout_len == sizeof("columns") - 1 &&
+                strncmp(layout, "columns", layout_len) == 0) {
+            columns = true;
+        }
+        else if (layout_len != sizeof("tuples") - 1 ||
+                strncmp(layout, "tuples", layout_len)) {
+            purc_set_error(PURC_ERROR_INVALID_VALUE);
+            goto failed;
+        }
+    }
+
+    fmt = compile_formats(formats, formats_left, &to_free);
+    if (fmt == NULL) {
+        goto failed;
+    }
+
+    /* only the formats in fixed size make records */
+    if (fmt->record_size == 0 || fmt->nr_members == 0) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        goto failed;
+    }
+
+    size_t nr_records = nr_bytes / fmt->record_size;
+    if (nr_bytes % fmt->record_size && !silently) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        goto failed;
+    }
+
+    members = calloc(fmt->nr_members, sizeof(purc_variant_t));
+    if (members == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto fatal;
+    }
+
+    if (columns) {
+        retv = purc_variant_make_tuple(fmt->nr_members, NULL);
+        if (retv == PURC_VARIANT_INVALID)
+            goto fatal;
+
+        for (size_t i = 0; i < fmt->nr_members; i++) {
+            purc_variant_t col = purc_variant_make_array_0();
+            if (col == PURC_VARIANT_INVALID)
+                goto fatal;
+            purc_variant_tuple_set(retv, i, col);
+            purc_variant_unref(col);
+        }
+    }
+    else {
+        retv = purc_variant_make_array_0();
+        if (retv == PURC_VARIANT_INVALID)
+            goto fatal;
+    }
+
+    for (size_t r = 0; r < nr_records; r++) {
+        if (unpack_record(fmt, bytes, members, silently)) {
+            if (purc_get_last_error() == PURC_ERROR_OUT_OF_MEMORY)
+                goto fatal;
+            goto failed;
+        }
+
+        bool ok = true;
+        if (columns) {
+            for (size_t i = 0; i < fmt->nr_members; i++) {
+                if (ok && !purc_variant_array_append(
+                            purc_variant_tuple_get(retv, i), members[i]))
+                    ok = false;
+                purc_variant_unref(members[i]);
+            }
+        }
+        else {
+            purc_variant_t tuple;
+            tuple = purc_variant_make_tuple(fmt->nr_members, members);
+            for (size_t i = 0; i < fmt->nr_members; i++)
+                purc_variant_unref(members[i]);
+
+            if (tuple == PURC_VARIANT_INVALID)
+                goto fatal;
+            ok = purc_variant_array_append(retv, tuple);
+            purc_variant_unref(tuple);
+        }
+
+        if (!ok)
+            goto fatal;
+        bytes += fmt->record_size;
+    }
+
+    free(members);
+    if (to_free)
+        free_pack_format(to_free);
+    return retv;
+
+failed:
+    if (silently) {
+        free(members);
+        if (to_free)
+            free_pack_format(to_free);
+        if (retv)
+            purc_variant_unref(retv);
+        return purc_variant_make_array_0();
+    }
+
+fatal:
+    free(members);
+    if (to_free)
+        free_pack_format(to_free);
+    if (retv)
+        purc_variant_unref(retv);
+    return PURC_VARIANT_INVALID;
+}
+
+static purc_variant_t
+shuffle_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+{
+    UNUSED_PARAM(root);
+
+    if (nr_args < 1) {
+        purc_set_error(PURC_ERROR_ARGUMENT_MISSED);
+        goto failed;
+    }
+
+    if (purc_variant_is_array(argv[0])) {
+        ssize_t sz = purc_variant_array_get_size(argv[0]);
 
         if (sz > 1) {
-            struct pcutils_array_list *al = variant_array_get_data(argv[0]);
-            struct pcutils_array_list_node *p;
-            array_list_for_each(al, p) {
+            variant_arr_t data = (variant_arr_t)argv[0]->sz_ptr[1];
+            for (size_t idx = 0; idx < data->nr; idx++) {
 
-                size_t new_idx;
-                if (sz < RAND_MAX) {
-                    new_idx = (size_t)pcdvobjs_get_random() % sz;
-                }
-                else {
-                    new_idx = (size_t)pcdvobjs_get_random();
-                    new_idx = new_idx * sz / RAND_MAX;
-                }
+                size_t new_idx = (size_t)pcdvobjs_get_random_below(sz);
 
-                if (new_idx != p->idx)
-                    pcutils_array_list_swap(al, p->idx, new_idx);
+                if (new_idx != idx) {
+                    purc_variant_t tmp = data->vals[idx];
+                    data->vals[idx] = data->vals[new_idx];
+                    data->vals[new_idx] = tmp;
+                }
             }
         }
     }
@@ -1959,14 +2443,7 @@ shuffle_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
 
             for (size_t idx = 0; idx < nr; idx++) {
 
-                size_t new_idx;
-                if (sz < RAND_MAX) {
-                    new_idx = (size_t)pcdvobjs_get_random() % sz;
-                }
-                else {
-                    new_idx = (size_t)pcdvobjs_get_random();
-                    new_idx = new_idx * sz / RAND_MAX;
-                }
+                size_t new_idx = (size_t)pcdvobjs_get_random_below(sz);
 
                 if (new_idx != idx)
                     pcutils_array_list_swap(al, idx, new_idx);
@@ -2162,6 +2639,18 @@ sort_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         }
     }
 
+    purc_vrtcmp_opt_t cmpopt;
+    cmpopt = (purc_vrtcmp_opt_t)(sort_opt & PCVARIANT_CMPOPT_MASK);
+    if (cmpopt != PCVARIANT_COMPARE_OPT_AUTO) {
+        /* the members are numberified or stringified only once */
+        bool by_number = (cmpopt == PCVARIANT_COMPARE_OPT_NUMBER);
+        if (pcvariant_sort_by_keys(argv[0], 1, &by_number, NULL, NULL,
+                sort_opt & PCVARIANT_SORT_DESC,
+                cmpopt == PCVARIANT_COMPARE_OPT_CASELESS) == 0)
+            goto done;
+        goto failed;
+    }
+
     /* use the default variant comparison function */
     if (purc_variant_is_array(argv[0])) {
         pcvariant_array_sort(argv[0], (void *)sort_opt, NULL);
@@ -2275,20 +2764,28 @@ crc32_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
     }
 
     pcutils_crc32_ctxt ctxt;
-    stream = purc_rwstream_new_for_dump(&ctxt, cb_calc_crc32);
-    if (stream == NULL) {
-        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-        goto fatal;
-    }
-
     pcutils_crc32_begin(&ctxt, algo);
 
-    if (purc_variant_stringify(stream, argv[0],
-            PCVARIANT_STRINGIFY_OPT_BSEQUENCE_BAREBYTES, NULL) < 0) {
-        goto fatal;
+    if (pcdvobjs_is_stream(argv[0])) {
+        /* digest the data read from the stream chunk by chunk */
+        if (pcdvobjs_stream_consume(argv[0], cb_calc_crc32, &ctxt) < 0)
+            goto fatal;
     }
+    else {
+        stream = purc_rwstream_new_for_dump(&ctxt, cb_calc_crc32);
+        if (stream == NULL) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            goto fatal;
+        }
 
-    purc_rwstream_destroy(stream);
+        if (purc_variant_stringify(stream, argv[0],
+                PCVARIANT_STRINGIFY_OPT_BSEQUENCE_BAREBYTES, NULL) < 0) {
+            goto fatal;
+        }
+
+        purc_rwstream_destroy(stream);
+        stream = NULL;
+    }
 
     uint32_t crc32;
     pcutils_crc32_end(&ctxt, &crc32);
@@ -2320,6 +2817,119 @@ fatal:
     return PURC_VARIANT_INVALID;
 }
 
+static purc_variant_t
+make_digest(const unsigned char *digest, size_t size, int ret_type)
+{
+    switch (ret_type) {
+        case PURC_K_KW_binary:  // fallthrough
+        default:
+            return purc_variant_make_byte_sequence(digest, size);
+
+        case PURC_K_KW_uppercase:
+        case PURC_K_KW_lowercase:
+        {
+            char hex[size * 2 + 1];
+            pcutils_bin2hex(digest, size, hex,
+                    ret_type == PURC_K_KW_uppercase);
+            return purc_variant_make_string(hex, false);
+        }
+    }
+}
+
+/* the digest of a string or a byte sequence computed on the thread pool */
+struct digest_job {
+    purc_variant_t      data;   // the string or the byte sequence held
+    const void         *bytes;
+    size_t              len;
+    bool                sha1;
+    int                 ret_type;
+    unsigned char       digest[SHA1_DIGEST_SIZE];
+};
+
+static void *
+digest_work(void *arg)
+{
+    struct digest_job *job = arg;
+
+    if (job->sha1) {
+        pcutils_sha1_ctxt ctxt;
+        pcutils_sha1_begin(&ctxt);
+        pcutils_sha1_hash(&ctxt, job->bytes, job->len);
+        pcutils_sha1_end(&ctxt, job->digest);
+    }
+    else {
+        pcutils_md5_ctxt ctxt;
+        pcutils_md5_begin(&ctxt);
+        pcutils_md5_hash(&ctxt, job->bytes, job->len);
+        pcutils_md5_end(&ctxt, job->digest);
+    }
+
+    return job;
+}
+
+static purc_variant_t
+digest_done(void *data, void *result)
+{
+    struct digest_job *job = data;
+    purc_variant_t v = PURC_VARIANT_INVALID;
+
+    if (result) {
+        v = make_digest(job->digest,
+                job->sha1 ? SHA1_DIGEST_SIZE : MD5_DIGEST_SIZE, job->ret_type);
+    }
+
+    purc_variant_unref(job->data);
+    free(job);
+    return v;
+}
+
+/* parses the mode argument: returns 1 for `async`, 0 for `sync`, or -1 */
+static int
+parse_digest_mode(purc_variant_t arg)
+{
+    const char *option;
+    size_t option_len;
+    option = purc_variant_get_string_const_ex(arg, &option_len);
+    if (option == NULL) {
+        purc_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+        return -1;
+    }
+
+    option = pcutils_trim_spaces(option, &option_len);
+    if (option_len == 5 && strncmp(option, "async", 5) == 0)
+        return 1;
+    if (option_len == 4 && strncmp(option, "sync", 4) == 0)
+        return 0;
+
+    purc_set_error(PURC_ERROR_INVALID_VALUE);
+    return -1;
+}
+
+/* starts digesting a string or a byte sequence asynchronously */
+static purc_variant_t
+digest_async(purc_variant_t data, bool sha1, int ret_type)
+{
+    const void *bytes;
+    size_t len;
+    if (purc_variant_is_string(data))
+        bytes = purc_variant_get_string_const_ex(data, &len);
+    else
+        bytes = purc_variant_get_bytes_const(data, &len);
+
+    struct digest_job *job = malloc(sizeof(*job));
+    if (job == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return PURC_VARIANT_INVALID;
+    }
+
+    job->data = purc_variant_ref(data);
+    job->bytes = bytes;
+    job->len = len;
+    job->sha1 = sha1;
+    job->ret_type = ret_type;
+    return pcintr_async_call(digest_work, digest_done, job);
+}
+
 static ssize_t cb_calc_md5(void *ctxt, const void *buf, size_t count)
 {
     pcutils_md5_ctxt *md5_ctxt = ctxt;
@@ -2359,37 +2969,48 @@ md5_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         ret_type = pcdvobjs_global_keyword_id(option, option_len);
     }
 
-    pcutils_md5_ctxt md5_ctxt;
-    stream = purc_rwstream_new_for_dump(&md5_ctxt, cb_calc_md5);
-    if (stream == NULL) {
-        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-        goto fatal;
+    /* digests a string or a byte sequence on the thread pool */
+    if (nr_args > 2) {
+        int mode = parse_digest_mode(argv[2]);
+        if (mode < 0)
+            goto failed;
+
+        if (mode && (purc_variant_is_string(argv[0]) ||
+                    purc_variant_is_bsequence(argv[0]))) {
+            purc_variant_t v = digest_async(argv[0], false, ret_type);
+            if (v == PURC_VARIANT_INVALID)
+                goto fatal;
+            return v;
+        }
     }
 
+    pcutils_md5_ctxt md5_ctxt;
     pcutils_md5_begin(&md5_ctxt);
-    if (purc_variant_stringify(stream, argv[0],
-            PCVARIANT_STRINGIFY_OPT_BSEQUENCE_BAREBYTES, NULL) < 0) {
-        goto fatal;
+
+    if (pcdvobjs_is_stream(argv[0])) {
+        /* digest the data read from the stream chunk by chunk */
+        if (pcdvobjs_stream_consume(argv[0], cb_calc_md5, &md5_ctxt) < 0)
+            goto fatal;
     }
+    else {
+        stream = purc_rwstream_new_for_dump(&md5_ctxt, cb_calc_md5);
+        if (stream == NULL) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            goto fatal;
+        }
+
+        if (purc_variant_stringify(stream, argv[0],
+                PCVARIANT_STRINGIFY_OPT_BSEQUENCE_BAREBYTES, NULL) < 0) {
+            goto fatal;
+        }
 
-    purc_rwstream_destroy(stream);
+        purc_rwstream_destroy(stream);
+        stream = NULL;
+    }
 
     unsigned char md5[MD5_DIGEST_SIZE];
     pcutils_md5_end(&md5_ctxt, md5);
-
-    switch (ret_type) {
-        case PURC_K_KW_binary:  // fallthrough
-        default:
-            return purc_variant_make_byte_sequence(md5, sizeof(md5));
-        case PURC_K_KW_uppercase:
-        case PURC_K_KW_lowercase:
-        {
-            char hex[sizeof(md5) * 2 + 1];
-            pcutils_bin2hex(md5, sizeof(md5), hex,
-                    ret_type == PURC_K_KW_uppercase);
-            return purc_variant_make_string(hex, false);
-        }
-    }
+    return make_digest(md5, sizeof(md5), ret_type);
 
 failed:
     if (silently)
@@ -2440,38 +3061,48 @@ sha1_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         ret_type = pcdvobjs_global_keyword_id(option, option_len);
     }
 
-    pcutils_sha1_ctxt sha1_ctxt;
-    stream = purc_rwstream_new_for_dump(&sha1_ctxt, cb_calc_sha1);
-    if (stream == NULL) {
-        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-        goto fatal;
+    /* digests a string or a byte sequence on the thread pool */
+    if (nr_args > 2) {
+        int mode = parse_digest_mode(argv[2]);
+        if (mode < 0)
+            goto failed;
+
+        if (mode && (purc_variant_is_string(argv[0]) ||
+                    purc_variant_is_bsequence(argv[0]))) {
+            purc_variant_t v = digest_async(argv[0], true, ret_type);
+            if (v == PURC_VARIANT_INVALID)
+                goto fatal;
+            return v;
+        }
     }
 
+    pcutils_sha1_ctxt sha1_ctxt;
     pcutils_sha1_begin(&sha1_ctxt);
-    if (purc_variant_stringify(stream, argv[0],
-            PCVARIANT_STRINGIFY_OPT_BSEQUENCE_BAREBYTES, NULL) < 0) {
-        goto fatal;
+
+    if (pcdvobjs_is_stream(argv[0])) {
+        /* digest the data read from the stream chunk by chunk */
+        if (pcdvobjs_stream_consume(argv[0], cb_calc_sha1, &sha1_ctxt) < 0)
+            goto fatal;
     }
+    else {
+        stream = purc_rwstream_new_for_dump(&sha1_ctxt, cb_calc_sha1);
+        if (stream == NULL) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            goto fatal;
+        }
+
+        if (purc_variant_stringify(stream, argv[0],
+                PCVARIANT_STRINGIFY_OPT_BSEQUENCE_BAREBYTES, NULL) < 0) {
+            goto fatal;
+        }
 
-    purc_rwstream_destroy(stream);
+        purc_rwstream_destroy(stream);
+        stream = NULL;
+    }
 
     unsigned char sha1[SHA1_DIGEST_SIZE];
     pcutils_sha1_end(&sha1_ctxt, sha1);
-
-    switch (ret_type) {
-        case PURC_K_KW_binary:  // fallthrough
-        default:
-            return purc_variant_make_byte_sequence(sha1, sizeof(sha1));
-
-        case PURC_K_KW_uppercase:
-        case PURC_K_KW_lowercase:
-        {
-            char hex[sizeof(sha1) * 2 + 1];
-            pcutils_bin2hex(sha1, sizeof(sha1), hex,
-                    ret_type == PURC_K_KW_uppercase);
-            return purc_variant_make_string(hex, false);
-        }
-    }
+    return make_digest(sha1, sizeof(sha1), ret_type);
 
 failed:
     if (silently)
@@ -2608,6 +3239,97 @@ fatal:
     return PURC_VARIANT_INVALID;
 }
 
+/* The context to encode the data read from a stream in base64. */
+struct b64_stream_ctxt {
+    char *buff;
+    size_t sz_buff, len;
+
+    /* the bytes left which do not make a complete quantum */
+    unsigned char left[3];
+    size_t nr_left;
+};
+
+static int b64_reserve(struct b64_stream_ctxt *ctxt, size_t nr_bytes)
+{
+    /* the encoded data and the terminating null character */
+    size_t needed = ctxt->len + (nr_bytes + 2) / 3 * 4 + 1;
+    if (needed <= ctxt->sz_buff)
+        return 0;
+
+    size_t sz_buff = ctxt->sz_buff ? ctxt->sz_buff : 4096;
+    while (sz_buff < needed)
+        sz_buff *= 2;
+
+    char *buff = realloc(ctxt->buff, sz_buff);
+    if (buff == NULL)
+        return -1;
+
+    ctxt->buff = buff;
+    ctxt->sz_buff = sz_buff;
+    return 0;
+}
+
+static ssize_t cb_b64_encode(void *_ctxt, const void *buf, size_t count)
+{
+    struct b64_stream_ctxt *ctxt = _ctxt;
+    const unsigned char *bytes = buf;
+    size_t n = count;
+
+    if (b64_reserve(ctxt, ctxt->nr_left + n) < 0) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    if (ctxt->nr_left > 0) {
+        while (ctxt->nr_left < 3 && n > 0) {
+            ctxt->left[ctxt->nr_left++] = *bytes++;
+            n--;
+        }
+
+        if (ctxt->nr_left < 3)
+            return count;
+
+        ctxt->len += pcutils_b64_encode(ctxt->left, 3,
+                ctxt->buff + ctxt->len, ctxt->sz_buff - ctxt->len);
+        ctxt->nr_left = 0;
+    }
+
+    size_t nr_whole = n / 3 * 3;
+    if (nr_whole > 0) {
+        ctxt->len += pcutils_b64_encode(bytes, nr_whole,
+                ctxt->buff + ctxt->len, ctxt->sz_buff - ctxt->len);
+    }
+
+    ctxt->nr_left = n - nr_whole;
+    memcpy(ctxt->left, bytes + nr_whole, ctxt->nr_left);
+    return count;
+}
+
+static purc_variant_t
+base64_encode_stream(purc_variant_t stream)
+{
+    struct b64_stream_ctxt ctxt = { };
+
+    if (pcdvobjs_stream_consume(stream, cb_b64_encode, &ctxt) < 0)
+        goto failed;
+
+    if (ctxt.nr_left > 0) {
+        ctxt.len += pcutils_b64_encode(ctxt.left, ctxt.nr_left,
+                ctxt.buff + ctxt.len, ctxt.sz_buff - ctxt.len);
+    }
+
+    if (ctxt.len == 0) {
+        free(ctxt.buff);
+        return purc_variant_make_string_static("", false);
+    }
+
+    return purc_variant_make_string_reuse_buff(ctxt.buff, ctxt.sz_buff, false);
+
+failed:
+    free(ctxt.buff);
+    return PURC_VARIANT_INVALID;
+}
+
 static purc_variant_t
 base64_encode_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         bool silently)
@@ -2622,6 +3344,13 @@ base64_encode_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         goto failed;
     }
 
+    if (pcdvobjs_is_stream(argv[0])) {
+        purc_variant_t retv = base64_encode_stream(argv[0]);
+        if (retv == PURC_VARIANT_INVALID)
+            goto failed;
+        return retv;
+    }
+
     if (purc_variant_is_string(argv[0])) {
         bytes = (const unsigned char *)
             purc_variant_get_string_const_ex(argv[0], &nr_bytes);
@@ -2721,12 +3450,15 @@ purc_variant_t purc_dvobj_ejson_new(void)
         { "stringify",  stringify_getter, NULL },
         { "serialize",  serialize_getter, NULL },
         { "parse",      parse_getter, NULL },
+        { "encode",     encode_getter, NULL },
+        { "decode",     decode_getter, NULL },
         { "isequal",    isequal_getter, NULL },
         { "compare",    compare_getter, NULL },
         { "fetchstr",   fetchstr_getter, NULL },
         { "fetchreal",  fetchreal_getter, NULL },
         { "pack",       pack_getter, NULL },
         { "unpack",     unpack_getter, NULL },
+        { "unpack_records", unpack_records_getter, NULL },
         { "shuffle",    shuffle_getter, NULL },
         { "sort",       sort_getter, NULL },
         { "crc32",      crc32_getter, NULL },
@@ -26,6 +26,7 @@
 #include "purc-errors.h"
 
 #include "private/dvobjs.h"
+#include "private/document.h"
 #include "private/stringbuilder.h"
 
 #include "internal.h"
@@ -538,11 +539,42 @@ visit_element(purc_document_t doc, pcdoc_element_t element, void *ud)
     return 0;
 }
 
+static int
+select_elements(purc_document_t doc, pcdoc_element_t root,
+        struct visit_args *args)
+{
+    pcdoc_elem_coll_t coll;
+
+    coll = pcdoc_elem_coll_new_from_descendants(doc, root, args->css);
+    if (coll == NULL)
+        return -1;
+
+    int r = 0;
+    size_t n = pcutils_arrlist_length(coll->elems);
+    for (size_t i = 0; i < n; i++) {
+        if (!add_element(args->elements,
+                    pcutils_arrlist_get_idx(coll->elems, i))) {
+            r = -1;
+            break;
+        }
+    }
+
+    pcdoc_elem_coll_delete(doc, coll);
+    return r;
+}
+
 purc_variant_t
 pcdvobjs_query_elements(purc_document_t doc, pcdoc_element_t root,
         const char *css)
 {
-    if (strcmp(css, "*") != 0) {
+    /* the documents with a native selector engine accept any selector */
+    if (doc->ops->elem_coll_select) {
+        if (css[0] == '\0') {
+            pcinst_set_error(PURC_ERROR_ARGUMENT_MISSED);
+            return PURC_VARIANT_INVALID;
+        }
+    }
+    else if (strcmp(css, "*") != 0) {
         if (css[0] != '.' && css[0] != '#') {
             pcinst_set_error(PURC_ERROR_ARGUMENT_MISSED);
             return PURC_VARIANT_INVALID;
@@ -553,7 +585,13 @@ pcdvobjs_query_elements(purc_document_t doc, pcdoc_element_t root,
         }
     }
 
-    purc_variant_t elements = make_elements();
+    /* the elements variant never changes once made, so it is shared
+       until the document is mutated */
+    purc_variant_t elements = pcdoc_get_memoized_query(doc, root, css);
+    if (elements)
+        return elements;
+
+    elements = make_elements();
     if (elements == PURC_VARIANT_INVALID)
         return PURC_VARIANT_INVALID;
 
@@ -574,13 +612,18 @@ pcdvobjs_query_elements(purc_document_t doc, pcdoc_element_t root,
     args.elements = (struct pcdvobjs_elements*)entity;
     args.css      = css;
 
-    int r = pcdoc_travel_descendant_elements(doc, root,
-            visit_element, &args, NULL);
+    int r;
+    if (doc->ops->elem_coll_select)
+        r = select_elements(doc, root, &args);
+    else
+        r = pcdoc_travel_descendant_elements(doc, root,
+                visit_element, &args, NULL);
     if (r) {
         purc_variant_unref(elements);
         return PURC_VARIANT_INVALID;
     }
 
+    pcdoc_memoize_query(doc, root, css, elements);
     return elements;
 }
 
@@ -27,6 +27,7 @@
 #include "private/instance.h"
 #include "private/errors.h"
 #include "private/dvobjs.h"
+#include "private/vcm.h"
 #include "purc-variant.h"
 #include "helper.h"
 
@@ -148,3 +149,43 @@ error:
     return PURC_VARIANT_INVALID;
 }
 
+bool
+purc_dvobj_set_pure_methods(purc_variant_t dvobj, const char **names,
+        size_t nr_names)
+{
+    for (size_t i = 0; i < nr_names; i++) {
+        purc_variant_t val = purc_variant_object_get_by_ckey(dvobj, names[i]);
+        if (val == PURC_VARIANT_INVALID || !purc_variant_is_dynamic(val)) {
+            pcinst_set_error(PURC_ERROR_INVALID_VALUE);
+            return false;
+        }
+
+        val->flags |= PCVARIANT_FLAG_DYNAMIC_PURE;
+    }
+
+    return true;
+}
+
+bool
+purc_dvobj_set_lazy_methods(purc_variant_t dvobj, const char **names,
+        size_t nr_names)
+{
+    for (size_t i = 0; i < nr_names; i++) {
+        purc_variant_t val = purc_variant_object_get_by_ckey(dvobj, names[i]);
+        if (val == PURC_VARIANT_INVALID || !purc_variant_is_dynamic(val)) {
+            pcinst_set_error(PURC_ERROR_INVALID_VALUE);
+            return false;
+        }
+
+        val->flags |= PCVARIANT_FLAG_DYNAMIC_LAZY;
+    }
+
+    return true;
+}
+
+purc_variant_t
+purc_dvobj_force_argument(purc_variant_t arg)
+{
+    return pcvcm_force_argument(arg);
+}
+
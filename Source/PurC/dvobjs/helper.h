@@ -35,11 +35,19 @@ extern "C" {
 
 #define STREAM_SIZE 1024
 
-struct pcdvobjs_logical_param {
-    int result;
+/* A node of the tree compiled from a logical expression: a number,
+   a variable, or an operator applied to the children. */
+struct pcdvobjs_logical_node {
+    double d;
+    char *name;
+    double (*f1)(double);
+    double (*f2)(double, double);
+    struct pcdvobjs_logical_node *l, *r;
+};
 
-    purc_variant_t v;
-    purc_variant_t variables;
+struct pcdvobjs_logical_expr {
+    /* NULL for an empty expression */
+    struct pcdvobjs_logical_node *root;
 };
 
 bool pcdvobjs_wildcard_cmp (const char *str1,
@@ -47,8 +55,16 @@ bool pcdvobjs_wildcard_cmp (const char *str1,
 
 const char *pcdvobjs_remove_space (char * buffer) WTF_INTERNAL;
 
-int pcdvobjs_logical_parse(const char *input,
-        struct pcdvobjs_logical_param *param) WTF_INTERNAL;
+/* Returns NULL if @input is not a valid logical expression. */
+struct pcdvobjs_logical_expr *pcdvobjs_logical_compile(
+        const char *input) WTF_INTERNAL;
+
+void pcdvobjs_logical_free(struct pcdvobjs_logical_expr *expr) WTF_INTERNAL;
+
+/* Evaluates the expression with the variables in the object @v;
+   returns 1 for true, 0 for false. */
+int pcdvobjs_logical_eval(const struct pcdvobjs_logical_expr *expr,
+        purc_variant_t v) WTF_INTERNAL;
 
 #ifdef __cplusplus
 }
@@ -105,7 +105,14 @@ and_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
     else {
         result = true;
         for (size_t i = 0; i < nr_args; i++) {
-            if (!purc_variant_booleanize(argv[i])) {
+            /* the arguments are lazy; the rest are not evaluated */
+            purc_variant_t arg = purc_dvobj_force_argument(argv[i]);
+            if (arg == PURC_VARIANT_INVALID)
+                return PURC_VARIANT_INVALID;
+
+            bool value = purc_variant_booleanize(arg);
+            purc_variant_unref(arg);
+            if (!value) {
                 result = false;
                 break;
             }
@@ -122,21 +129,18 @@ or_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
     UNUSED_PARAM(root);
     UNUSED_PARAM(silently);
 
-    bool result;
-    if (nr_args == 0) {
-        // treat as undefined
-        result = false;
-    }
-    else if (nr_args == 1) {
-        result = purc_variant_booleanize(argv[0]);
-    }
-    else {
-        result = false;
-        for (size_t i = 0; i < nr_args; i++) {
-            if (purc_variant_booleanize(argv[i])) {
-                result = true;
-                break;
-            }
+    bool result = false;
+    for (size_t i = 0; i < nr_args; i++) {
+        /* the arguments are lazy; the rest are not evaluated */
+        purc_variant_t arg = purc_dvobj_force_argument(argv[i]);
+        if (arg == PURC_VARIANT_INVALID)
+            return PURC_VARIANT_INVALID;
+
+        bool value = purc_variant_booleanize(arg);
+        purc_variant_unref(arg);
+        if (value) {
+            result = true;
+            break;
         }
     }
 
@@ -786,6 +790,111 @@ fatal:
     return PURC_VARIANT_INVALID;
 }
 
+/*
+ * The expressions evaluated by $L.eval() recently are kept compiled in
+ * a small LRU cache of the instance, so a condition evaluated again with
+ * other variables is parsed only once.
+ */
+#define LDNAME_LOGICAL_EXPRS        "logical_exprs"
+#define NR_CACHED_EXPRS             32
+
+struct cached_expr {
+    unsigned hash;
+    char *source;
+    struct pcdvobjs_logical_expr *expr;
+};
+
+struct expr_cache {
+    size_t nr;
+    /* the most recently used one comes first */
+    struct cached_expr exprs[NR_CACHED_EXPRS];
+};
+
+static void cb_free_expr_cache(void *key, void *local_data)
+{
+    UNUSED_PARAM(key);
+
+    struct expr_cache *cache = local_data;
+    for (size_t i = 0; i < cache->nr; i++) {
+        free(cache->exprs[i].source);
+        pcdvobjs_logical_free(cache->exprs[i].expr);
+    }
+    free(cache);
+}
+
+static struct expr_cache *get_expr_cache(void)
+{
+    struct expr_cache *cache = NULL;
+
+    if (purc_get_local_data(LDNAME_LOGICAL_EXPRS,
+                (uintptr_t *)&cache, NULL) == 1)
+        return cache;
+
+    cache = calloc(1, sizeof(*cache));
+    if (cache && !purc_set_local_data(LDNAME_LOGICAL_EXPRS,
+                (uintptr_t)cache, cb_free_expr_cache)) {
+        free(cache);
+        cache = NULL;
+    }
+    return cache;
+}
+
+/* FNV-1a */
+static unsigned hash_source(const char *source)
+{
+    unsigned hash = 2166136261u;
+    while (*source) {
+        hash ^= (unsigned char)*source++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/* Returns the compiled expression owned by the cache, or by the caller via
+   @to_free if there is no cache. */
+static const struct pcdvobjs_logical_expr *
+compile_expr(const char *source, struct pcdvobjs_logical_expr **to_free)
+{
+    struct expr_cache *cache = get_expr_cache();
+    unsigned hash = hash_source(source);
+    struct cached_expr entry;
+
+    *to_free = NULL;
+    if (cache) {
+        for (size_t i = 0; i < cache->nr; i++) {
+            entry = cache->exprs[i];
+            if (entry.hash == hash && strcmp(entry.source, source) == 0) {
+                memmove(cache->exprs + 1, cache->exprs,
+                        sizeof(cache->exprs[0]) * i);
+                cache->exprs[0] = entry;
+                return entry.expr;
+            }
+        }
+    }
+
+    entry.expr = pcdvobjs_logical_compile(source);
+    if (entry.expr == NULL)
+        return NULL;
+
+    entry.hash = hash;
+    entry.source = cache ? strdup(source) : NULL;
+    if (entry.source == NULL) {
+        *to_free = entry.expr;
+        return entry.expr;
+    }
+
+    if (cache->nr == NR_CACHED_EXPRS) {
+        cache->nr--;
+        free(cache->exprs[cache->nr].source);
+        pcdvobjs_logical_free(cache->exprs[cache->nr].expr);
+    }
+    memmove(cache->exprs + 1, cache->exprs,
+            sizeof(cache->exprs[0]) * cache->nr);
+    cache->exprs[0] = entry;
+    cache->nr++;
+    return entry.expr;
+}
+
 static purc_variant_t
 eval_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         bool silently)
@@ -808,14 +917,21 @@ eval_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         goto failed;
     }
 
-    struct pcdvobjs_logical_param myparam = {
-        0,
-        (nr_args > 1) ? argv[1] : PURC_VARIANT_INVALID,
-        PURC_VARIANT_INVALID
-    };
-    pcdvobjs_logical_parse(exp, &myparam);
+    /* an invalid expression evaluates to false */
+    int result = 0;
+    struct pcdvobjs_logical_expr *to_free;
+    const struct pcdvobjs_logical_expr *expr = compile_expr(exp, &to_free);
+    if (expr) {
+        result = pcdvobjs_logical_eval(expr,
+                (nr_args > 1) ? argv[1] : PURC_VARIANT_INVALID);
+        if (to_free)
+            pcdvobjs_logical_free(to_free);
+    }
+    else {
+        purc_clr_error();
+    }
 
-    return purc_variant_make_boolean(myparam.result);
+    return purc_variant_make_boolean(result);
 
 failed:
     if (silently)
@@ -846,5 +962,14 @@ purc_variant_t purc_dvobj_logical_new(void)
         {"eval",  eval_getter,  NULL}
     };
 
-    return purc_dvobj_make_from_methods(method, PCA_TABLESIZE(method));
+    static const char *lazy_methods[] = { "and", "or" };
+
+    purc_variant_t retv;
+    retv = purc_dvobj_make_from_methods(method, PCA_TABLESIZE(method));
+    if (retv != PURC_VARIANT_INVALID) {
+        purc_dvobj_set_lazy_methods(retv, lazy_methods,
+                PCA_TABLESIZE(lazy_methods));
+    }
+
+    return retv;
 }
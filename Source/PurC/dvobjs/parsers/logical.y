@@ -48,7 +48,7 @@
     static void yyerror(
         YYLTYPE *yylloc,                   // match %define locations
         yyscan_t arg,                      // match %param
-        struct pcdvobjs_logical_param *param, // match %parse-param
+        struct pcdvobjs_logical_expr *param, // match %parse-param
         const char *errsg
     );
 
@@ -116,19 +116,54 @@
         return (FP_ZERO == fpclassify(d)) ? false : true;
     }
 
+    static void free_node(struct pcdvobjs_logical_node *node)
+    {
+        if (node == NULL)
+            return;
+
+        free_node(node->l);
+        free_node(node->r);
+        if (node->name)
+            free(node->name);
+        free(node);
+    }
+
+    /* takes the ownership of the children, also on failure */
+    static struct pcdvobjs_logical_node *
+    new_node(struct pcdvobjs_logical_node *l, struct pcdvobjs_logical_node *r)
+    {
+        struct pcdvobjs_logical_node *node = calloc(1, sizeof(*node));
+        if (node == NULL) {
+            free_node(l);
+            free_node(r);
+            return NULL;
+        }
+
+        node->l = l;
+        node->r = r;
+        return node;
+    }
+
     #define EVAL_FREE(v) do {            \
+        free_node(v);                    \
     } while (0)
 
     #define EVAL_SET(_a) do {                          \
-        param->result = eval_boolean(_a);              \
+        param->root = _a;                              \
     } while (0)
 
     #define EVAL_APPLY_1(_f, _r, _a) do {                            \
-        _r = _f(_a);                                                 \
+        _r = new_node(_a, NULL);                                     \
+        if (_r == NULL)                                              \
+            YYABORT;                                                 \
+        _r->f1 = _f;                                                 \
     } while (0)
 
     #define EVAL_APPLY_2(_f, _r, _a, _b) do {                        \
-        _r = _f(_a, _b);                                             \
+        _r = new_node(_a, _b);                                       \
+        if (_r == NULL)                                              \
+            YYABORT;                                                 \
+        _r->f2 = _f;                                                 \
     } while (0)
 
     #define EVAL_INT(_r, _a) do {                                    \
@@ -138,7 +173,10 @@
         ptr[sz] = '\0';                                              \
         long long ll = atoll(ptr);                                   \
         ptr[sz] = c;                                                 \
-        _r = ll;                                                     \
+        _r = new_node(NULL, NULL);                                   \
+        if (_r == NULL)                                              \
+            YYABORT;                                                 \
+        _r->d = ll;                                                  \
     } while (0)
 
     #define EVAL_NUM(_r, _a) do {                                    \
@@ -148,29 +186,23 @@
         ptr[sz] = '\0';                                              \
         double d = atof(ptr);                                        \
         ptr[sz] = c;                                                 \
-        _r = d;                                                      \
+        _r = new_node(NULL, NULL);                                   \
+        if (_r == NULL)                                              \
+            YYABORT;                                                 \
+        _r->d = d;                                                   \
     } while (0)
 
+    /* the variable is looked up when evaluating */
     #define EVAL_VAR(_r, _a) do {                                    \
-        if (!param->variables)                                       \
+        char *name = strndup((const char *)_a[1], _a[0]);            \
+        if (name == NULL)                                            \
+            YYABORT;                                                 \
+        _r = new_node(NULL, NULL);                                   \
+        if (_r == NULL) {                                            \
+            free(name);                                              \
             YYABORT;                                                 \
-        char   *ptr = (char*)_a[1];                                  \
-        size_t  sz  = _a[0];                                         \
-        char c  = ptr[sz];                                           \
-        ptr[sz] = '\0';                                              \
-        purc_variant_t _v;                                           \
-        _v = purc_variant_object_get_by_ckey(param->variables, ptr); \
-        ptr[sz] = c;                                                 \
-        if (_v == PURC_VARIANT_INVALID) {                            \
-            if (!param->v && !purc_variant_is_object(param->v))      \
-                YYABORT;                                             \
-            ptr[sz] = '\0';                                          \
-            _v = purc_variant_object_get_by_ckey(param->v, ptr);     \
-            ptr[sz] = c;                                             \
-            if (_v == PURC_VARIANT_INVALID)                          \
-                YYABORT;                                             \
         }                                                            \
-        _r = purc_variant_numberify(_v);                             \
+        _r->name = name;                                             \
     } while (0)
 }
 
@@ -184,10 +216,10 @@
 %verbose
 
 %param { yyscan_t arg }
-%parse-param { struct pcdvobjs_logical_param *param }
+%parse-param { struct pcdvobjs_logical_expr *param }
 
 %union { uintptr_t  sz_ptr[2]; }
-%union { double v; }
+%union { struct pcdvobjs_logical_node *v; }
 
 %destructor { EVAL_FREE($$); } <v>
 
@@ -252,7 +284,7 @@ static void
 yyerror(
     YYLTYPE *yylloc,                   // match %define locations
     yyscan_t arg,                      // match %param
-    struct pcdvobjs_logical_param *param, // match %parse-param
+    struct pcdvobjs_logical_expr *param, // match %parse-param
     const char *errsg
 )
 {
@@ -266,23 +298,80 @@ yyerror(
         errsg);
 }
 
-int pcdvobjs_logical_parse(const char *input,
-        struct pcdvobjs_logical_param *param)
+struct pcdvobjs_logical_expr *pcdvobjs_logical_compile(const char *input)
 {
+    struct pcdvobjs_logical_expr *expr = calloc(1, sizeof(*expr));
+    if (expr == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
     yyscan_t arg = {0};
 
     yylex_init(&arg);
     // yyset_in(in, arg);
     // yyset_debug(debug, arg);
-    yyset_extra(param, arg);
+    yyset_extra(expr, arg);
     yy_scan_string(input, arg);
-    int ret =yyparse(arg, param);
+    int ret =yyparse(arg, expr);
     yylex_destroy(arg);
-    if (param->variables) {
-        purc_variant_unref(param->variables);
-        param->variables = NULL;
+
+    if (ret) {
+        pcdvobjs_logical_free(expr);
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return NULL;
     }
 
-    return ret ? 1 : 0;
+    return expr;
+}
+
+void pcdvobjs_logical_free(struct pcdvobjs_logical_expr *expr)
+{
+    free_node(expr->root);
+    free(expr);
+}
+
+static int eval_node(const struct pcdvobjs_logical_node *node,
+        purc_variant_t v, double *r)
+{
+    double a = 0, b = 0;
+
+    if (node->l && eval_node(node->l, v, &a))
+        return -1;
+    if (node->r && eval_node(node->r, v, &b))
+        return -1;
+
+    if (node->f1) {
+        *r = node->f1(a);
+    }
+    else if (node->f2) {
+        *r = node->f2(a, b);
+    }
+    else if (node->name) {
+        if (v == PURC_VARIANT_INVALID || !purc_variant_is_object(v))
+            return -1;
+
+        purc_variant_t val = purc_variant_object_get_by_ckey(v, node->name);
+        if (val == PURC_VARIANT_INVALID)
+            return -1;
+        *r = purc_variant_numberify(val);
+    }
+    else {
+        *r = node->d;
+    }
+
+    return 0;
+}
+
+int pcdvobjs_logical_eval(const struct pcdvobjs_logical_expr *expr,
+        purc_variant_t v)
+{
+    double d;
+
+    /* an empty expression or an undefined variable evaluates to false */
+    if (expr->root == NULL || eval_node(expr->root, v, &d))
+        return 0;
+
+    return eval_boolean(d);
 }
 
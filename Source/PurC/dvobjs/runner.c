@@ -27,10 +27,15 @@
 #include "private/vdom.h"
 #include "private/dvobjs.h"
 #include "private/url.h"
+#include "private/trace.h"
+#include "private/vcm.h"
+#include "private/fetcher.h"
+#include "private/metrics.h"
 #include "purc-variant.h"
 #include "helper.h"
 
 #include <limits.h>
+#include <string.h>
 #include <errno.h>
 
 #include <sys/types.h>
@@ -39,6 +44,8 @@
 
 #define KN_USER_OBJ     "myObj"
 
+#define _KW_DELIMITERS  " \t\n\v\f\r"
+
 static purc_variant_t
 user_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         bool silently)
@@ -164,6 +171,394 @@ uri_getter(purc_variant_t root,
     return purc_variant_make_string(inst->endpoint_name, false);
 }
 
+static purc_variant_t
+trace_getter(purc_variant_t root,
+        size_t nr_args, purc_variant_t *argv, bool silently)
+{
+    UNUSED_PARAM(root);
+    UNUSED_PARAM(nr_args);
+    UNUSED_PARAM(argv);
+    UNUSED_PARAM(silently);
+
+    struct pcinst* inst = pcinst_current();
+    char names[64] = "";
+
+    for (unsigned int cat = 1; cat & PC_TRACE_ALL; cat <<= 1) {
+        if (inst->trace_flags & cat) {
+            if (names[0])
+                strcat(names, " ");
+            strcat(names, pctrace_category_name(cat));
+        }
+    }
+
+    return purc_variant_make_string(names, false);
+}
+
+static purc_variant_t
+trace_setter(purc_variant_t root,
+        size_t nr_args, purc_variant_t *argv, bool silently)
+{
+    UNUSED_PARAM(root);
+
+    const char *names;
+    size_t names_len;
+    unsigned int flags = 0;
+
+    if (nr_args < 1) {
+        pcinst_set_error(PURC_ERROR_ARGUMENT_MISSED);
+        goto failed;
+    }
+
+    names = purc_variant_get_string_const_ex(argv[0], &names_len);
+    if (names == NULL) {
+        pcinst_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+        goto failed;
+    }
+
+    names = pcutils_trim_spaces(names, &names_len);
+    if (names_len > 0) {
+        size_t length = 0;
+        const char *name = pcutils_get_next_token_len(names, names_len,
+                _KW_DELIMITERS, &length);
+
+        do {
+            unsigned int cat;
+            if (length == 3 && strncmp(name, "all", 3) == 0)
+                cat = PC_TRACE_ALL;
+            else
+                cat = pctrace_category(name, length);
+
+            if (cat == 0) {
+                pcinst_set_error(PURC_ERROR_INVALID_VALUE);
+                goto failed;
+            }
+            flags |= cat;
+
+            size_t left = names + names_len - (name + length);
+            if (left == 0)
+                break;
+
+            name = pcutils_get_next_token_len(name + length, left,
+                    _KW_DELIMITERS, &length);
+        } while (name);
+    }
+
+    pcinst_current()->trace_flags = flags;
+    return purc_variant_make_boolean(true);
+
+failed:
+    if (silently)
+        return purc_variant_make_boolean(false);
+
+    return PURC_VARIANT_INVALID;
+}
+
+static purc_variant_t
+profile_getter(purc_variant_t root,
+        size_t nr_args, purc_variant_t *argv, bool silently)
+{
+    UNUSED_PARAM(root);
+
+    const char *key = NULL;
+    if (nr_args > 0) {
+        key = purc_variant_get_string_const(argv[0]);
+        if (key == NULL) {
+            pcinst_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+            goto failed;
+        }
+    }
+
+    purc_variant_t report = pcvcm_profile_report(pcinst_current());
+    if (key == NULL || report == PURC_VARIANT_INVALID ||
+            purc_variant_is_null(report))
+        return report;
+
+    /* `$RUNNER.profile.roots` or `$RUNNER.profile.methods` */
+    purc_variant_t val = purc_variant_object_get_by_ckey(report, key);
+    if (val != PURC_VARIANT_INVALID)
+        purc_variant_ref(val);
+    purc_variant_unref(report);
+    if (val == PURC_VARIANT_INVALID)
+        goto failed;
+    return val;
+
+failed:
+    if (silently)
+        return purc_variant_make_undefined();
+
+    return PURC_VARIANT_INVALID;
+}
+
+static purc_variant_t
+profile_setter(purc_variant_t root,
+        size_t nr_args, purc_variant_t *argv, bool silently)
+{
+    UNUSED_PARAM(root);
+
+    struct pcinst* inst = pcinst_current();
+
+    if (nr_args < 1) {
+        pcinst_set_error(PURC_ERROR_ARGUMENT_MISSED);
+        goto failed;
+    }
+
+    /* the statistics are discarded when stopped */
+    if (purc_variant_booleanize(argv[0])) {
+        if (pcvcm_profile_start(inst))
+            goto failed;
+    }
+    else {
+        pcvcm_profile_stop(inst);
+    }
+
+    return purc_variant_make_boolean(true);
+
+failed:
+    if (silently)
+        return purc_variant_make_boolean(false);
+
+    return PURC_VARIANT_INVALID;
+}
+
+static bool
+set_member(purc_variant_t obj, const char *key, purc_variant_t val)
+{
+    if (val == PURC_VARIANT_INVALID)
+        return false;
+
+    bool ok = purc_variant_object_set_by_static_ckey(obj, key, val);
+    purc_variant_unref(val);
+    return ok;
+}
+
+static purc_variant_t
+make_timing_histogram(const struct pcfetcher_timing_stats *timing)
+{
+    purc_variant_t arr = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    if (arr == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    for (size_t i = 0; i < PCFETCHER_NR_TIMING_BUCKETS; i++) {
+        purc_variant_t v = purc_variant_make_ulongint(timing->histogram[i]);
+        bool ok = v && purc_variant_array_append(arr, v);
+        if (v)
+            purc_variant_unref(v);
+        if (!ok) {
+            purc_variant_unref(arr);
+            return PURC_VARIANT_INVALID;
+        }
+    }
+
+    return arr;
+}
+
+static purc_variant_t
+fetch_stats_getter(purc_variant_t root,
+        size_t nr_args, purc_variant_t *argv, bool silently)
+{
+    UNUSED_PARAM(root);
+    UNUSED_PARAM(nr_args);
+    UNUSED_PARAM(argv);
+    UNUSED_PARAM(silently);
+
+    struct pcfetcher_stats stats;
+    if (pcfetcher_get_stats(&stats))
+        return purc_variant_make_null();
+
+    struct pcfetcher_timing_stats timing;
+    pcfetcher_get_timing_stats(&timing);
+
+    purc_variant_t report = purc_variant_make_object(0,
+            PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+    if (report == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    /* the times are the sums in seconds */
+    bool ok =
+        set_member(report, "maxConns",
+                purc_variant_make_ulongint(stats.max_conns)) &&
+        set_member(report, "active",
+                purc_variant_make_ulongint(stats.nr_active)) &&
+        set_member(report, "queued",
+                purc_variant_make_ulongint(stats.nr_queued)) &&
+        set_member(report, "peakActive",
+                purc_variant_make_ulongint(stats.nr_peak_active)) &&
+        set_member(report, "requests",
+                purc_variant_make_ulongint(stats.nr_requests)) &&
+        set_member(report, "coalesced",
+                purc_variant_make_ulongint(stats.nr_coalesced_requests)) &&
+        set_member(report, "processes",
+                purc_variant_make_ulongint(stats.nr_processes)) &&
+        set_member(report, "finished",
+                purc_variant_make_ulongint(timing.nr_requests)) &&
+        set_member(report, "cacheHits",
+                purc_variant_make_ulongint(timing.nr_cache_hits)) &&
+        set_member(report, "bytesReceived",
+                purc_variant_make_ulongint(timing.sz_received)) &&
+        set_member(report, "dnsTime",
+                purc_variant_make_number(timing.dns)) &&
+        set_member(report, "connectTime",
+                purc_variant_make_number(timing.connect)) &&
+        set_member(report, "tlsTime",
+                purc_variant_make_number(timing.tls)) &&
+        set_member(report, "ttfbTime",
+                purc_variant_make_number(timing.ttfb)) &&
+        set_member(report, "transferTime",
+                purc_variant_make_number(timing.transfer)) &&
+        set_member(report, "totalTime",
+                purc_variant_make_number(timing.total)) &&
+        set_member(report, "histogram", make_timing_histogram(&timing));
+    if (!ok) {
+        purc_variant_unref(report);
+        return PURC_VARIANT_INVALID;
+    }
+
+    return report;
+}
+
+static purc_variant_t
+fetch_stats_setter(purc_variant_t root,
+        size_t nr_args, purc_variant_t *argv, bool silently)
+{
+    UNUSED_PARAM(root);
+    UNUSED_PARAM(nr_args);
+    UNUSED_PARAM(argv);
+    UNUSED_PARAM(silently);
+
+    /* any value resets the timing statistics */
+    pcfetcher_reset_timing_stats();
+    return purc_variant_make_boolean(true);
+}
+
+static purc_variant_t
+metrics_getter(purc_variant_t root,
+        size_t nr_args, purc_variant_t *argv, bool silently)
+{
+    UNUSED_PARAM(root);
+    UNUSED_PARAM(nr_args);
+    UNUSED_PARAM(argv);
+    UNUSED_PARAM(silently);
+
+    return pcinst_metrics_make_variant(pcinst_current());
+}
+
+static purc_variant_t
+metrics_setter(purc_variant_t root,
+        size_t nr_args, purc_variant_t *argv, bool silently)
+{
+    UNUSED_PARAM(root);
+    UNUSED_PARAM(nr_args);
+    UNUSED_PARAM(argv);
+    UNUSED_PARAM(silently);
+
+    /* any value resets the metrics of the current instance */
+    pcinst_metrics_reset(pcinst_current());
+    return purc_variant_make_boolean(true);
+}
+
+static purc_variant_t
+startup_getter(purc_variant_t root,
+        size_t nr_args, purc_variant_t *argv, bool silently)
+{
+    UNUSED_PARAM(root);
+    UNUSED_PARAM(nr_args);
+    UNUSED_PARAM(argv);
+    UNUSED_PARAM(silently);
+
+    return pcinst_make_startup_report(pcinst_current());
+}
+
+static purc_variant_t
+subscribe_getter(purc_variant_t root,
+        size_t nr_args, purc_variant_t *argv, bool silently)
+{
+    UNUSED_PARAM(root);
+
+    const char *topic;
+    if (nr_args < 1) {
+        pcinst_set_error(PURC_ERROR_ARGUMENT_MISSED);
+        goto failed;
+    }
+
+    if ((topic = purc_variant_get_string_const(argv[0])) == NULL) {
+        pcinst_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+        goto failed;
+    }
+
+    if (purc_inst_subscribe_topic(topic))
+        goto failed;
+
+    return purc_variant_make_boolean(true);
+
+failed:
+    if (silently)
+        return purc_variant_make_boolean(false);
+
+    return PURC_VARIANT_INVALID;
+}
+
+static purc_variant_t
+unsubscribe_getter(purc_variant_t root,
+        size_t nr_args, purc_variant_t *argv, bool silently)
+{
+    UNUSED_PARAM(root);
+
+    const char *topic;
+    if (nr_args < 1) {
+        pcinst_set_error(PURC_ERROR_ARGUMENT_MISSED);
+        goto failed;
+    }
+
+    if ((topic = purc_variant_get_string_const(argv[0])) == NULL) {
+        pcinst_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+        goto failed;
+    }
+
+    if (purc_inst_unsubscribe_topic(topic))
+        goto failed;
+
+    return purc_variant_make_boolean(true);
+
+failed:
+    if (silently)
+        return purc_variant_make_boolean(false);
+
+    return PURC_VARIANT_INVALID;
+}
+
+/* $RUNNER.publish(<string $topic>[, <any $data>]): the number of the
+   runners the data was delivered to */
+static purc_variant_t
+publish_getter(purc_variant_t root,
+        size_t nr_args, purc_variant_t *argv, bool silently)
+{
+    UNUSED_PARAM(root);
+
+    const char *topic;
+    if (nr_args < 1) {
+        pcinst_set_error(PURC_ERROR_ARGUMENT_MISSED);
+        goto failed;
+    }
+
+    if ((topic = purc_variant_get_string_const(argv[0])) == NULL) {
+        pcinst_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+        goto failed;
+    }
+
+    ssize_t nr = purc_inst_publish_topic(topic,
+            nr_args > 1 ? argv[1] : PURC_VARIANT_INVALID);
+    if (nr < 0)
+        goto failed;
+
+    return purc_variant_make_ulongint((uint64_t)nr);
+
+failed:
+    if (silently)
+        return purc_variant_make_boolean(false);
+
+    return PURC_VARIANT_INVALID;
+}
+
 purc_variant_t
 purc_dvobj_runner_new(void)
 {
@@ -175,6 +570,14 @@ purc_dvobj_runner_new(void)
         { "runner", runner_getter,  NULL },
         { "rid",    rid_getter,     NULL },
         { "uri",    uri_getter,     NULL },
+        { "trace",  trace_getter,   trace_setter },
+        { "profile", profile_getter, profile_setter },
+        { "fetchStats", fetch_stats_getter, fetch_stats_setter },
+        { "metrics", metrics_getter, metrics_setter },
+        { "startup", startup_getter, NULL },
+        { "subscribe", subscribe_getter, NULL },
+        { "unsubscribe", unsubscribe_getter, NULL },
+        { "publish", publish_getter, NULL },
     };
 
     retv = purc_dvobj_make_from_methods(method, PCA_TABLESIZE(method));
@@ -44,7 +44,16 @@
 #include <sys/socket.h>
 #include <sys/un.h>
 
+#if OS(LINUX)
+#include <sys/sendfile.h>
+#endif
+
 #define BUFFER_SIZE                 1024
+#define LINE_BUFFER_SIZE            4096
+#define WRITE_QUEUE_SIZE            4096
+/* the writes to a nonblocking stream are short beyond this size */
+#define MAX_WRITE_QUEUE_SIZE        (4 * 1024 * 1024)
+#define PIPE_CHUNK_SIZE             (64 * 1024)
 
 #define ENDIAN_PLATFORM             0
 #define ENDIAN_LITTLE               1
@@ -57,6 +66,7 @@
 #define STREAM_EVENT_NAME           "event"
 #define STREAM_SUB_EVENT_READ       "readable"
 #define STREAM_SUB_EVENT_WRITE      "writable"
+#define STREAM_SUB_EVENT_DRAIN      "drain"
 #define STREAM_SUB_EVENT_ALL        "*"
 
 #define FILE_DEFAULT_MODE           0644
@@ -183,6 +193,19 @@ struct pcdvobjs_stream {
 
     pid_t cpid;                 /* only for pipe, the pid of child */
     purc_atom_t cid;
+
+    /* The buffer of the line reader; the data read ahead (between
+       `lbuf_start` and `lbuf_end`) is kept only for unseekable streams. */
+    char *lbuf;
+    size_t sz_lbuf, lbuf_start, lbuf_end;
+
+    /* The queue of the data not written yet to a nonblocking stream, and
+       the monitor flushing it; see stream_write(). */
+    char *wq;
+    size_t sz_wq, wq_start, wq_end;
+    uintptr_t monitor4flush;
+    bool nonblock;
+    bool eof_pending;           /* close the write end once flushed */
 };
 
 static
@@ -207,8 +230,25 @@ struct pcdvobjs_stream *dvobjs_stream_create(enum pcdvobjs_stream_type type,
     return stream;
 }
 
+static void flush_write_queue(struct pcdvobjs_stream *stream);
+
 static void native_stream_close(struct pcdvobjs_stream *stream)
 {
+    if (stream->monitor4flush) {
+        purc_runloop_remove_fd_monitor(purc_runloop_get_current(),
+                stream->monitor4flush);
+        stream->monitor4flush = 0;
+    }
+
+    /* the data still queued is dropped if it can not be written now */
+    if (stream->wq) {
+        if (stream->fd4w >= 0)
+            flush_write_queue(stream);
+        free(stream->wq);
+        stream->wq = NULL;
+    }
+    stream->sz_wq = stream->wq_start = stream->wq_end = 0;
+
     if (stream->stm4r) {
         purc_rwstream_destroy(stream->stm4r);
     }
@@ -220,6 +260,12 @@ static void native_stream_close(struct pcdvobjs_stream *stream)
     stream->stm4w = NULL;
     stream->stm4r = NULL;
 
+    if (stream->lbuf) {
+        free(stream->lbuf);
+        stream->lbuf = NULL;
+    }
+    stream->sz_lbuf = stream->lbuf_start = stream->lbuf_end = 0;
+
     if (stream->option) {
         purc_variant_unref(stream->option);
         stream->option = PURC_VARIANT_INVALID;
@@ -290,6 +336,153 @@ struct pcdvobjs_stream *get_stream(void *native_entity)
     return (struct pcdvobjs_stream*)native_entity;
 }
 
+static inline bool write_queue_empty(struct pcdvobjs_stream *stream)
+{
+    return stream->wq_start == stream->wq_end;
+}
+
+/* Writes the queued data as much as the fd accepts without blocking. */
+static void flush_write_queue(struct pcdvobjs_stream *stream)
+{
+    while (!write_queue_empty(stream)) {
+        ssize_t n = write(stream->fd4w, stream->wq + stream->wq_start,
+                stream->wq_end - stream->wq_start);
+        if (n > 0) {
+            stream->wq_start += n;
+        }
+        else if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        else {
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                /* the peer has gone; nothing can be written any more */
+                purc_log_warn("Drop %lu bytes queued for stream: %s\n",
+                        (unsigned long)(stream->wq_end - stream->wq_start),
+                        strerror(errno));
+                stream->wq_start = stream->wq_end;
+            }
+            break;
+        }
+    }
+
+    if (write_queue_empty(stream))
+        stream->wq_start = stream->wq_end = 0;
+}
+
+static void close_write_end(struct pcdvobjs_stream *stream)
+{
+    purc_rwstream_destroy(stream->stm4w);
+    stream->stm4w = NULL;
+    close(stream->fd4w);
+    stream->fd4w = -1;
+    stream->eof_pending = false;
+}
+
+static bool
+stream_flush_callback(int fd, purc_runloop_io_event event, void *ctxt)
+{
+    UNUSED_PARAM(fd);
+    UNUSED_PARAM(event);
+
+    struct pcdvobjs_stream *stream = (struct pcdvobjs_stream*) ctxt;
+    flush_write_queue(stream);
+    if (!write_queue_empty(stream))
+        return true;
+
+    /* the fd monitor of the interpreter allows removing in the callback */
+    purc_runloop_remove_fd_monitor(purc_runloop_get_current(),
+            stream->monitor4flush);
+    stream->monitor4flush = 0;
+
+    if (stream->eof_pending)
+        close_write_end(stream);
+
+    if (stream->cid) {
+        pcintr_coroutine_post_event(stream->cid,
+                PCRDR_MSG_EVENT_REDUCE_OPT_IGNORE,
+                stream->observed, STREAM_EVENT_NAME, STREAM_SUB_EVENT_DRAIN,
+                PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+    }
+    return true;
+}
+
+/* Appends the data to the write queue; returns the number of bytes queued,
+   which is less than @count if the queue is full. */
+static size_t
+queue_data(struct pcdvobjs_stream *stream, const void *buf, size_t count)
+{
+    size_t queued = stream->wq_end - stream->wq_start;
+    if (queued + count > MAX_WRITE_QUEUE_SIZE)
+        count = MAX_WRITE_QUEUE_SIZE - queued;
+    if (count == 0)
+        return 0;
+
+    if (stream->wq_end + count > stream->sz_wq) {
+        if (stream->wq_start > 0) {
+            memmove(stream->wq, stream->wq + stream->wq_start, queued);
+            stream->wq_start = 0;
+            stream->wq_end = queued;
+        }
+
+        size_t sz = stream->sz_wq ? stream->sz_wq : WRITE_QUEUE_SIZE;
+        while (sz < queued + count)
+            sz *= 2;
+        if (sz != stream->sz_wq) {
+            char *wq = realloc(stream->wq, sz);
+            if (wq == NULL) {
+                purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+                return 0;
+            }
+            stream->wq = wq;
+            stream->sz_wq = sz;
+        }
+    }
+
+    memcpy(stream->wq + stream->wq_end, buf, count);
+    stream->wq_end += count;
+
+    if (stream->monitor4flush == 0) {
+        stream->monitor4flush = purc_runloop_add_fd_monitor(
+                purc_runloop_get_current(), stream->fd4w, PCRUNLOOP_IO_OUT,
+                stream_flush_callback, stream);
+    }
+    return count;
+}
+
+/*
+ * Writes the data to the stream. For a stream opened with `nonblock`,
+ * the data which can not be written right now is queued, and flushed when
+ * the fd gets writable; the `event:drain` event is fired on the stream once
+ * the queue is empty. The write is short only if the queue is full.
+ */
+static ssize_t
+stream_write(struct pcdvobjs_stream *stream, const void *buf, size_t count)
+{
+    if (!stream->nonblock || stream->fd4w < 0)
+        return purc_rwstream_write(stream->stm4w, buf, count);
+
+    size_t written = 0;
+    if (write_queue_empty(stream)) {
+        do {
+            ssize_t n = write(stream->fd4w, buf, count);
+            if (n >= 0) {
+                written = n;
+            }
+            else if (errno != EAGAIN && errno != EWOULDBLOCK &&
+                    errno != EINTR) {
+                purc_set_error(purc_error_from_errno(errno));
+                return -1;
+            }
+        } while (written == 0 && errno == EINTR);
+
+        if (written == count)
+            return count;
+    }
+
+    return written + queue_data(stream, (const char *)buf + written,
+            count - written);
+}
+
 static purc_variant_t
 readstruct_getter(void *native_entity, size_t nr_args, purc_variant_t *argv,
                 bool silently)
@@ -404,7 +597,7 @@ writestruct_getter(void *native_entity, size_t nr_args, purc_variant_t *argv,
 failed:
     if (silently) {
         if (bf.bytes) {
-            write_length = purc_rwstream_write(rwstream, bf.bytes, bf.nr_bytes);
+            write_length = stream_write(stream, bf.bytes, bf.nr_bytes);
             free(bf.bytes);
             bf.bytes = NULL;
         }
@@ -420,52 +613,124 @@ out:
     return PURC_VARIANT_INVALID;
 }
 
-#define LINE_FLAG           "\n"
-static int read_lines(purc_rwstream_t stream, int line_num,
-        purc_variant_t array)
+static inline bool is_seekable(struct pcdvobjs_stream *stream)
 {
-    unsigned char buffer[BUFFER_SIZE];
-    ssize_t read_size = 0;
-    size_t length = 0;
-    const char *head = NULL;
-    const char *end = NULL;
-
-    while (line_num) {
-        read_size = purc_rwstream_read(stream, buffer, BUFFER_SIZE);
-        if (read_size < 0)
-            break;
+    return stream->type == STREAM_TYPE_FILE;
+}
 
-        end = (const char*)(buffer + read_size);
+/* Takes the data read ahead by the line reader. */
+static size_t take_read_ahead(struct pcdvobjs_stream *stream,
+        void *buf, size_t count)
+{
+    size_t left = stream->lbuf_end - stream->lbuf_start;
+    if (count > left)
+        count = left;
 
-        head = pcutils_get_next_token_len((const char*)buffer, read_size,
-                LINE_FLAG, &length);
-        while (head && head < end) {
-            purc_variant_t var = purc_variant_make_string_ex(head, length,
-                    false);
-            if (!var) {
-                return -1;
-            }
-            if (!purc_variant_array_append(array, var)) {
-                purc_variant_unref(var);
-                return -1;
-            }
-            purc_variant_unref(var);
-            line_num --;
+    if (count > 0) {
+        memcpy(buf, stream->lbuf + stream->lbuf_start, count);
+        stream->lbuf_start += count;
+    }
+    return count;
+}
+
+/* Makes room for reading more data at the end of the line buffer. */
+static int prepare_line_buffer(struct pcdvobjs_stream *stream)
+{
+    if (stream->lbuf_start > 0) {
+        memmove(stream->lbuf, stream->lbuf + stream->lbuf_start,
+                stream->lbuf_end - stream->lbuf_start);
+        stream->lbuf_end -= stream->lbuf_start;
+        stream->lbuf_start = 0;
+    }
+
+    if (stream->lbuf_end == stream->sz_lbuf) {
+        /* a line longer than the buffer */
+        size_t sz = stream->sz_lbuf ? stream->sz_lbuf * 2 : LINE_BUFFER_SIZE;
+        char *lbuf = realloc(stream->lbuf, sz);
+        if (lbuf == NULL) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return -1;
+        }
+        stream->lbuf = lbuf;
+        stream->sz_lbuf = sz;
+    }
+
+    return 0;
+}
+
+static int append_line(purc_variant_t array, const char *line, size_t len)
+{
+    purc_variant_t var = purc_variant_make_string_ex(line, len, false);
+    if (!var)
+        return -1;
+
+    bool ok = purc_variant_array_append(array, var);
+    purc_variant_unref(var);
+    return ok ? 0 : -1;
+}
+
+/*
+ * Reads at most @line_num lines via the buffer of the stream; a line
+ * crossing the boundary of two reads is carried over. For an unseekable
+ * stream, the reading stops after a short read, and a partial line is kept
+ * in the buffer for the next call. For a file, the data read ahead is given
+ * back by seeking, so that the other readers see the right position.
+ */
+static int read_lines(struct pcdvobjs_stream *stream, int64_t line_num,
+        purc_variant_t array)
+{
+    bool seekable = is_seekable(stream);
+    bool eof = false, drained = false;
+    int ret = 0;
 
-            if (line_num == 0)
+    while (line_num > 0) {
+        const char *head = stream->lbuf + stream->lbuf_start;
+        size_t left = stream->lbuf_end - stream->lbuf_start;
+        const char *nl = left ? memchr(head, '\n', left) : NULL;
+
+        if (nl) {
+            if ((ret = append_line(array, head, nl - head)))
                 break;
+            stream->lbuf_start += nl - head + 1;
+            line_num--;
+            continue;
+        }
 
-            head = pcutils_get_next_token_len(head + length, end - head - length,
-                LINE_FLAG, &length);
+        if (eof) {
+            if (left > 0) {
+                ret = append_line(array, head, left);
+                stream->lbuf_start = stream->lbuf_end;
+            }
+            break;
         }
-        if (read_size < BUFFER_SIZE)           // to the end
+
+        if (drained)
             break;
 
-        if (line_num == 0)
+        if ((ret = prepare_line_buffer(stream)))
             break;
+
+        size_t count = stream->sz_lbuf - stream->lbuf_end;
+        ssize_t nr_read = purc_rwstream_read(stream->stm4r,
+                stream->lbuf + stream->lbuf_end, count);
+        if (nr_read <= 0) {
+            eof = true;
+        }
+        else {
+            stream->lbuf_end += nr_read;
+            if (!seekable && (size_t)nr_read < count)
+                drained = true;
+        }
     }
 
-    return 0;
+    if (seekable) {
+        size_t left = stream->lbuf_end - stream->lbuf_start;
+        if (left > 0)
+            purc_rwstream_seek(stream->stm4r, -(off_t)left, SEEK_CUR);
+        stream->lbuf_start = stream->lbuf_end = 0;
+    }
+
+    return ret;
 }
 
 static purc_variant_t
@@ -505,7 +770,7 @@ readlines_getter(void *native_entity, size_t nr_args, purc_variant_t *argv,
     }
 
     if (line_num > 0) {
-        int ret = read_lines(rwstream, line_num, ret_var);
+        int ret = read_lines(stream, line_num, ret_var);
         if (ret != 0) {
             goto out;
         }
@@ -584,8 +849,8 @@ writelines_getter(void *native_entity, size_t nr_args, purc_variant_t *argv,
         buffer = (const char *)purc_variant_get_string_const(data);
         buffer_size = strlen(buffer);
         if (buffer && buffer_size > 0) {
-            nr_write = purc_rwstream_write (rwstream, buffer, buffer_size);
-            nr_write += purc_rwstream_write(rwstream, "\n", 1);
+            nr_write = stream_write(stream, buffer, buffer_size);
+            nr_write += stream_write(stream, "\n", 1);
         }
     }
     else {
@@ -595,8 +860,8 @@ writelines_getter(void *native_entity, size_t nr_args, purc_variant_t *argv,
             buffer = (const char *)purc_variant_get_string_const(var);
             buffer_size = strlen(buffer);
             if (buffer && buffer_size > 0) {
-                nr_write += purc_rwstream_write (rwstream, buffer, buffer_size);
-                nr_write += purc_rwstream_write(rwstream, "\n", 1);
+                nr_write += stream_write(stream, buffer, buffer_size);
+                nr_write += stream_write(stream, "\n", 1);
             }
         }
     }
@@ -653,7 +918,13 @@ readbytes_getter(void *native_entity, size_t nr_args, purc_variant_t *argv,
             goto out;
         }
 
-        size = purc_rwstream_read(rwstream, content, byte_num);
+        size = take_read_ahead(stream, content, byte_num);
+        if (size < byte_num) {
+            ssize_t nr_read = purc_rwstream_read(rwstream, content + size,
+                    byte_num - size);
+            if (nr_read > 0)
+                size += nr_read;
+        }
         if (size > 0) {
             ret_var = purc_variant_make_byte_sequence_reuse_buff(content,
                     size, size);
@@ -718,7 +989,7 @@ writebytes_getter(void *native_entity, size_t nr_args, purc_variant_t *argv,
         bsize = strlen((const char*)buffer) + 1;
     }
     if (buffer && bsize) {
-        ssize_t nr_write = purc_rwstream_write (rwstream, buffer, bsize);
+        ssize_t nr_write = stream_write(stream, buffer, bsize);
         return purc_variant_make_ulongint(nr_write);
     }
 
@@ -752,10 +1023,11 @@ writeeof_getter(void *native_entity, size_t nr_args, purc_variant_t *argv,
 
     bool ret;
     if (stream->stm4w) {
-        purc_rwstream_destroy(stream->stm4w);
-        stream->stm4w = NULL;
-        close(stream->fd4w);
-        stream->fd4w = -1;
+        /* the queued data is written before the end of file */
+        if (write_queue_empty(stream))
+            close_write_end(stream);
+        else
+            stream->eof_pending = true;
         ret = true;
     }
     else
@@ -1003,6 +1275,15 @@ on_observe(void *native_entity, const char *event_name,
     }
 
     struct pcdvobjs_stream *stream = (struct pcdvobjs_stream*)native_entity;
+    if (strcmp(event_subname, STREAM_SUB_EVENT_DRAIN) == 0) {
+        /* fired by the monitor flushing the write queue */
+        pcintr_coroutine_t co = pcintr_get_coroutine();
+        if (co) {
+            stream->cid = co->cid;
+        }
+        return true;
+    }
+
     if (event & PCRUNLOOP_IO_IN && stream->fd4r >= 0) {
         stream->monitor4r = purc_runloop_add_fd_monitor(
                 purc_runloop_get_current(), stream->fd4r, PCRUNLOOP_IO_IN,
@@ -1679,6 +1960,10 @@ stream_open_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         .on_forget = on_forget,
         .on_release = on_release,
     };
+    if (stream->fd4w >= 0 && (fcntl(stream->fd4w, F_GETFL) & O_NONBLOCK)) {
+        stream->nonblock = true;
+    }
+
     ret_var = purc_variant_make_native(stream, &ops);
     if (ret_var) {
         stream->observed = ret_var;
@@ -1722,6 +2007,189 @@ out:
     return PURC_VARIANT_INVALID;
 }
 
+bool pcdvobjs_is_stream(purc_variant_t v)
+{
+    if (v == PURC_VARIANT_INVALID || !purc_variant_is_native(v))
+        return false;
+
+    struct purc_native_ops *ops = purc_variant_native_get_ops(v);
+    return ops && ops->property_getter == property_getter;
+}
+
+ssize_t pcdvobjs_stream_consume(purc_variant_t v,
+        pcrws_cb_write consume, void *ctxt)
+{
+    struct pcdvobjs_stream *stream = purc_variant_native_get_entity(v);
+    if (stream->stm4r == NULL) {
+        purc_set_error(PURC_ERROR_NOT_DESIRED_ENTITY);
+        return -1;
+    }
+
+    char *buf = malloc(PIPE_CHUNK_SIZE);
+    if (buf == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    size_t total = 0;
+    for (;;) {
+        ssize_t n = take_read_ahead(stream, buf, PIPE_CHUNK_SIZE);
+        if (n == 0)
+            n = purc_rwstream_read(stream->stm4r, buf, PIPE_CHUNK_SIZE);
+        if (n <= 0)
+            break;
+
+        if (consume(ctxt, buf, n) < n) {
+            free(buf);
+            return -1;
+        }
+        total += n;
+    }
+
+    free(buf);
+    return total;
+}
+
+/* Moves the data read ahead by readlines() of @src to @dst first. */
+static ssize_t
+pipe_read_ahead(struct pcdvobjs_stream *src, struct pcdvobjs_stream *dst,
+        size_t count)
+{
+    size_t left = src->lbuf_end - src->lbuf_start;
+    if (count > left)
+        count = left;
+    if (count == 0)
+        return 0;
+
+    ssize_t n = stream_write(dst, src->lbuf + src->lbuf_start, count);
+    if (n > 0)
+        src->lbuf_start += n;
+    return n;
+}
+
+/*
+ * Moves at most @count bytes from @src to @dst, in the kernel if possible:
+ * splice(2) if one of the fds is a pipe, sendfile(2) if @src is a regular
+ * file. Returns 0 on the end of file or if the fds would block,
+ * and -1 on error.
+ */
+static ssize_t
+pipe_chunk(struct pcdvobjs_stream *src, struct pcdvobjs_stream *dst,
+        size_t count)
+{
+    ssize_t n;
+
+    if (count > PIPE_CHUNK_SIZE)
+        count = PIPE_CHUNK_SIZE;
+
+#if OS(LINUX)
+    /* the data queued must go first */
+    if (src->fd4r >= 0 && dst->fd4w >= 0 && write_queue_empty(dst)) {
+        struct stat st_src, st_dst;
+        if (fstat(src->fd4r, &st_src) == 0 && fstat(dst->fd4w, &st_dst) == 0) {
+            if (S_ISFIFO(st_src.st_mode) || S_ISFIFO(st_dst.st_mode)) {
+                do {
+                    n = splice(src->fd4r, NULL, dst->fd4w, NULL, count,
+                            SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+                } while (n < 0 && errno == EINTR);
+                if (n >= 0 || (errno != EINVAL && errno != ENOSYS))
+                    goto done;
+            }
+            else if (S_ISREG(st_src.st_mode)) {
+                do {
+                    n = sendfile(dst->fd4w, src->fd4r, NULL, count);
+                } while (n < 0 && errno == EINTR);
+                if (n >= 0 || (errno != EINVAL && errno != ENOSYS))
+                    goto done;
+            }
+        }
+    }
+#endif
+
+    /* copy through the user space */
+    char buf[PIPE_CHUNK_SIZE];
+    if (dst->nonblock && !write_queue_empty(dst)) {
+        /* do not read more than the queue can take */
+        size_t room = MAX_WRITE_QUEUE_SIZE - (dst->wq_end - dst->wq_start);
+        if (count > room)
+            count = room;
+        if (count == 0)
+            return 0;
+    }
+
+    n = purc_rwstream_read(src->stm4r, buf, count);
+    if (n > 0) {
+        ssize_t written = stream_write(dst, buf, n);
+        if (written < n)
+            return -1;
+    }
+    return n;
+
+#if OS(LINUX)
+done:
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return 0;
+    return n;
+#endif
+}
+
+static purc_variant_t
+stream_pipe_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+{
+    UNUSED_PARAM(root);
+
+    uint64_t count = UINT64_MAX;
+    uint64_t moved = 0;
+
+    if (nr_args < 2) {
+        purc_set_error(PURC_ERROR_ARGUMENT_MISSED);
+        goto out;
+    }
+
+    if (!purc_variant_is_native(argv[0]) ||
+            !purc_variant_is_native(argv[1])) {
+        purc_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+        goto out;
+    }
+
+    if (nr_args > 2 && !purc_variant_cast_to_ulongint(argv[2], &count, false)) {
+        purc_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+        goto out;
+    }
+
+    struct pcdvobjs_stream *src = purc_variant_native_get_entity(argv[0]);
+    struct pcdvobjs_stream *dst = purc_variant_native_get_entity(argv[1]);
+    if (src->stm4r == NULL || dst->stm4w == NULL) {
+        purc_set_error(PURC_ERROR_NOT_DESIRED_ENTITY);
+        goto out;
+    }
+
+    while (moved < count) {
+        ssize_t n = pipe_read_ahead(src, dst, count - moved);
+        if (n == 0)
+            n = pipe_chunk(src, dst, count - moved);
+        if (n < 0) {
+            if (moved == 0) {
+                purc_set_error(purc_error_from_errno(errno));
+                goto out;
+            }
+            break;
+        }
+        if (n == 0)
+            break;
+        moved += n;
+    }
+
+    return purc_variant_make_ulongint(moved);
+
+out:
+    if (silently)
+        return purc_variant_make_ulongint(0);
+
+    return PURC_VARIANT_INVALID;
+}
+
 static bool add_stdio_property(purc_variant_t v)
 {
     static const struct purc_native_ops ops = {
@@ -1792,6 +2260,7 @@ purc_variant_t purc_dvobj_stream_new(void)
     static struct purc_dvobj_method  stream[] = {
         { "open",   stream_open_getter,     NULL },
         { "close",  stream_close_getter,    NULL },
+        { "pipe",   stream_pipe_getter,     NULL },
     };
 
     if (keywords2atoms[0].atom == 0) {
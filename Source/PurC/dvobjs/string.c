@@ -148,7 +148,8 @@ contains_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         result  = pcutils_strcasestr(haystack, needle) != NULL;
     }
     else {
-        result = strstr(haystack, needle) != NULL;
+        result = pcutils_memmem(haystack, len_haystack,
+                needle, len_needle) != NULL;
     }
 
     return purc_variant_make_boolean(result);
@@ -160,6 +161,367 @@ failed:
     return PURC_VARIANT_INVALID;
 }
 
+#define LDNAME_NEEDLE_SETS      "string_needle_sets"
+#define NR_CACHED_NEEDLE_SETS   8
+
+/* the maximal number of the transitions of an automaton */
+#define MAX_NEEDLE_SET_TRANS    (1024 * 1024)
+
+/* an Aho-Corasick automaton matching the needles of a set at the same time */
+struct needle_set {
+    unsigned    hash;
+    /* the flag of case followed by the needles prefixed by their lengths */
+    char       *source;
+    size_t      len;
+
+    /* the bytes not in any needle fall in the class 0 */
+    uint8_t     classes[256];
+    size_t      nr_classes;
+    size_t      nr_states;
+    /* the state after a class got in a state: nr_states * nr_classes */
+    uint32_t   *next;
+    /* whether a needle is matched when getting in a state */
+    bool       *matched;
+};
+
+struct needle_set_cache {
+    size_t nr;
+    /* the most recently used one comes first */
+    struct needle_set *sets[NR_CACHED_NEEDLE_SETS];
+};
+
+static void free_needle_set(struct needle_set *set)
+{
+    free(set->source);
+    free(set->next);
+    free(set->matched);
+    free(set);
+}
+
+static void cb_free_needle_set_cache(void *key, void *local_data)
+{
+    UNUSED_PARAM(key);
+
+    struct needle_set_cache *cache = local_data;
+    for (size_t i = 0; i < cache->nr; i++)
+        free_needle_set(cache->sets[i]);
+    free(cache);
+}
+
+static struct needle_set_cache *get_needle_set_cache(void)
+{
+    struct needle_set_cache *cache = NULL;
+
+    if (purc_get_local_data(LDNAME_NEEDLE_SETS,
+                (uintptr_t *)&cache, NULL) == 1)
+        return cache;
+
+    cache = calloc(1, sizeof(*cache));
+    if (cache && !purc_set_local_data(LDNAME_NEEDLE_SETS,
+                (uintptr_t)cache, cb_free_needle_set_cache)) {
+        free(cache);
+        cache = NULL;
+    }
+    return cache;
+}
+
+/* FNV-1a */
+static unsigned hash_needle_set(const char *source, size_t len)
+{
+    unsigned hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)source[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static inline size_t needle_length(const char *p)
+{
+    size_t len;
+    memcpy(&len, p, sizeof(len));
+    return len;
+}
+
+/* Returns NULL if out of memory or the automaton would be too large. */
+static struct needle_set *
+build_needle_set(const char *source, size_t len)
+{
+    bool caseless = source[0];
+    const char *end = source + len;
+    const char *p;
+
+    struct needle_set *set = calloc(1, sizeof(*set));
+    if (set == NULL)
+        return NULL;
+
+    /* the states other than the root one are less than the bytes */
+    size_t nr_bytes = 0;
+    set->nr_classes = 1;
+    for (p = source + 1; p < end; ) {
+        size_t len_needle = needle_length(p);
+        p += sizeof(size_t);
+        for (size_t i = 0; i < len_needle; i++) {
+            int c = (unsigned char)p[i];
+            if (caseless)
+                c = purc_tolower(c);
+            if (set->classes[c] == 0) {
+                /* the class of a byte should fit in uint8_t */
+                if (set->nr_classes == 256)
+                    goto failed;
+                set->classes[c] = (uint8_t)set->nr_classes;
+                if (caseless)
+                    set->classes[purc_toupper(c)] = (uint8_t)set->nr_classes;
+                set->nr_classes++;
+            }
+        }
+        nr_bytes += len_needle;
+        p += len_needle;
+    }
+
+    if ((nr_bytes + 1) * set->nr_classes > MAX_NEEDLE_SET_TRANS)
+        goto failed;
+
+    set->next = calloc((nr_bytes + 1) * set->nr_classes, sizeof(uint32_t));
+    set->matched = calloc(nr_bytes + 1, sizeof(bool));
+    if (set->next == NULL || set->matched == NULL)
+        goto failed;
+
+    /* the trie; the state 0 is the root, thus no state goes to it yet */
+    set->nr_states = 1;
+    for (p = source + 1; p < end; ) {
+        size_t len_needle = needle_length(p);
+        p += sizeof(size_t);
+
+        uint32_t state = 0;
+        for (size_t i = 0; i < len_needle; i++) {
+            uint32_t *to = set->next + state * set->nr_classes +
+                set->classes[(unsigned char)p[i]];
+            if (*to == 0)
+                *to = (uint32_t)set->nr_states++;
+            state = *to;
+        }
+        set->matched[state] = true;
+        p += len_needle;
+    }
+
+    /* follow the failure links in the breadth-first order, so that
+       the transitions of the failure state are complete already */
+    uint32_t *queue = malloc(sizeof(uint32_t) * set->nr_states);
+    uint32_t *fail = calloc(set->nr_states, sizeof(uint32_t));
+    if (queue == NULL || fail == NULL) {
+        free(queue);
+        free(fail);
+        goto failed;
+    }
+
+    size_t head = 0, tail = 0;
+    queue[tail++] = 0;
+    while (head < tail) {
+        uint32_t state = queue[head++];
+        uint32_t *to = set->next + state * set->nr_classes;
+        uint32_t *to_fail = set->next + fail[state] * set->nr_classes;
+        for (size_t c = 0; c < set->nr_classes; c++) {
+            if (to[c] == 0) {
+                to[c] = (state == 0) ? 0 : to_fail[c];
+            }
+            else {
+                uint32_t child = to[c];
+                fail[child] = (state == 0) ? 0 : to_fail[c];
+                if (set->matched[fail[child]])
+                    set->matched[child] = true;
+                queue[tail++] = child;
+            }
+        }
+    }
+
+    free(queue);
+    free(fail);
+    return set;
+
+failed:
+    free_needle_set(set);
+    return NULL;
+}
+
+static struct needle_set *
+get_needle_set(const char *source, size_t len, struct needle_set **to_free)
+{
+    struct needle_set_cache *cache = get_needle_set_cache();
+    unsigned hash = hash_needle_set(source, len);
+
+    *to_free = NULL;
+    if (cache) {
+        for (size_t i = 0; i < cache->nr; i++) {
+            struct needle_set *set = cache->sets[i];
+            if (set->hash == hash && set->len == len &&
+                    memcmp(set->source, source, len) == 0) {
+                memmove(cache->sets + 1, cache->sets,
+                        sizeof(cache->sets[0]) * i);
+                cache->sets[0] = set;
+                return set;
+            }
+        }
+    }
+
+    struct needle_set *set = build_needle_set(source, len);
+    if (set == NULL)
+        return NULL;
+
+    set->hash = hash;
+    set->len = len;
+    set->source = cache ? malloc(len) : NULL;
+    if (set->source == NULL) {
+        *to_free = set;
+        return set;
+    }
+
+    memcpy(set->source, source, len);
+    if (cache->nr == NR_CACHED_NEEDLE_SETS) {
+        cache->nr--;
+        free_needle_set(cache->sets[cache->nr]);
+    }
+    memmove(cache->sets + 1, cache->sets,
+            sizeof(cache->sets[0]) * cache->nr);
+    cache->sets[0] = set;
+    cache->nr++;
+    return set;
+}
+
+static bool
+match_needle_set(const struct needle_set *set,
+        const char *haystack, size_t len_haystack)
+{
+    const unsigned char *p = (const unsigned char *)haystack;
+    uint32_t state = 0;
+
+    for (size_t i = 0; i < len_haystack; i++) {
+        state = set->next[state * set->nr_classes + set->classes[p[i]]];
+        if (set->matched[state])
+            return true;
+    }
+
+    return false;
+}
+
+/* searches the needles one by one */
+static bool
+match_needles(const char *haystack, size_t len_haystack,
+        purc_variant_t needles, size_t nr_needles, bool ignore_case)
+{
+    for (size_t i = 0; i < nr_needles; i++) {
+        size_t len_needle;
+        const char *needle = purc_variant_get_string_const_ex(
+                purc_variant_array_get(needles, i), &len_needle);
+
+        if (ignore_case) {
+            if (pcutils_strcasestr(haystack, needle))
+                return true;
+        }
+        else if (pcutils_memmem(haystack, len_haystack, needle, len_needle)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static purc_variant_t
+contains_any_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+{
+    UNUSED_PARAM(root);
+
+    char *source = NULL;
+
+    if (nr_args < 2) {
+        purc_set_error(PURC_ERROR_ARGUMENT_MISSED);
+        goto failed;
+    }
+
+    const char* haystack;
+    size_t len_haystack;
+    haystack = purc_variant_get_string_const_ex(argv[0], &len_haystack);
+    if (haystack == NULL || !purc_variant_is_array(argv[1])) {
+        purc_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+        goto failed;
+    }
+
+    bool ignore_case = false;
+    if (nr_args > 2) {
+        ignore_case = purc_variant_booleanize(argv[2]);
+    }
+
+    size_t nr_needles = 0;
+    purc_variant_array_size(argv[1], &nr_needles);
+
+    bool result = false;
+    bool ascii = !ignore_case || pcutils_is_ascii(haystack, len_haystack);
+    size_t len = 1;
+    for (size_t i = 0; i < nr_needles; i++) {
+        size_t len_needle;
+        const char *needle = purc_variant_get_string_const_ex(
+                purc_variant_array_get(argv[1], i), &len_needle);
+        if (needle == NULL) {
+            purc_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+            goto failed;
+        }
+
+        if (len_needle == 0)
+            result = true;
+        else if (ascii && ignore_case)
+            ascii = pcutils_is_ascii(needle, len_needle);
+        len += sizeof(size_t) + len_needle;
+    }
+
+    if (result || nr_needles == 0)
+        return purc_variant_make_boolean(result);
+
+    /* the source also keys the automaton in the cache */
+    source = malloc(len);
+    if (source == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto failed;
+    }
+
+    char *p = source;
+    *p++ = ignore_case;
+    for (size_t i = 0; i < nr_needles; i++) {
+        size_t len_needle;
+        const char *needle = purc_variant_get_string_const_ex(
+                purc_variant_array_get(argv[1], i), &len_needle);
+        memcpy(p, &len_needle, sizeof(size_t));
+        p += sizeof(size_t);
+        memcpy(p, needle, len_needle);
+        p += len_needle;
+    }
+
+    struct needle_set *set = NULL, *to_free = NULL;
+    /* beyond ASCII, the letters are lowered by the rules of Unicode */
+    if (ascii)
+        set = get_needle_set(source, len, &to_free);
+
+    if (set) {
+        result = match_needle_set(set, haystack, len_haystack);
+        if (to_free)
+            free_needle_set(to_free);
+    }
+    else {
+        result = match_needles(haystack, len_haystack, argv[1], nr_needles,
+                ignore_case);
+    }
+
+    free(source);
+    return purc_variant_make_boolean(result);
+
+failed:
+    free(source);
+    if (silently)
+        return purc_variant_make_boolean(false);
+
+    return PURC_VARIANT_INVALID;
+}
+
 static purc_variant_t
 starts_with_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         bool silently)
@@ -266,6 +628,28 @@ failed:
     return PURC_VARIANT_INVALID;
 }
 
+/* whether the stringified value of the variant is an ASCII string */
+static bool
+stringified_is_ascii(purc_variant_t v)
+{
+    switch (purc_variant_get_type(v)) {
+    case PURC_VARIANT_TYPE_UNDEFINED:
+    case PURC_VARIANT_TYPE_NULL:
+    case PURC_VARIANT_TYPE_BOOLEAN:
+    case PURC_VARIANT_TYPE_NUMBER:
+    case PURC_VARIANT_TYPE_LONGINT:
+    case PURC_VARIANT_TYPE_ULONGINT:
+    case PURC_VARIANT_TYPE_LONGDOUBLE:
+        return true;
+
+    case PURC_VARIANT_TYPE_STRING:
+        return pcvariant_string_is_ascii(v);
+
+    default:
+        return false;
+    }
+}
+
 static purc_variant_t
 join_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         bool silently)
@@ -273,56 +657,72 @@ join_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
     UNUSED_PARAM(root);
     UNUSED_PARAM(silently);
 
-    purc_rwstream_t rwstream;
-    rwstream = purc_rwstream_new_buffer(LEN_INI_PRINT_BUF, LEN_MAX_PRINT_BUF);
-    if (rwstream == NULL) {
+    purc_rwstream_t rwstream = NULL;
+    char *content = NULL;
+
+    /* the strings give their lengths, the others are stringified to count */
+    size_t sz_content = 0;
+    bool ascii = true;
+    for (size_t i = 0; i < nr_args; i++) {
+        size_t len;
+        if (purc_variant_get_string_const_ex(argv[i], &len) == NULL) {
+            len = 0;
+            if (purc_variant_stringify(NULL, argv[i], 0, &len) < 0)
+                goto fatal;
+        }
+
+        if (ascii)
+            ascii = stringified_is_ascii(argv[i]);
+        sz_content += len;
+    }
+
+    if (sz_content == 0)
+        return purc_variant_make_string_static("", false);
+
+    content = malloc(sz_content + 1);
+    if (content == NULL) {
         purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
         goto fatal;
     }
 
+    char *p = content;
     for (size_t i = 0; i < nr_args; i++) {
-#if 0
         const char *str;
-        size_t len_str;
+        size_t len;
 
-        str = purc_variant_get_string_const_ex(argv[i], &len_str);
+        str = purc_variant_get_string_const_ex(argv[i], &len);
         if (str) {
-            ssize_t nr_wrotten = purc_rwstream_write(rwstream, str, len_str);
-            if (nr_wrotten < 0 || (size_t)nr_wrotten < len_str) {
-                purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-                goto fatal;
-            }
-        }
-        else if (silently) {
-            // do nothing
-        }
-        else {
-            purc_set_error(PURC_ERROR_WRONG_DATA_TYPE);
-            goto fatal;
+            memcpy(p, str, len);
+            p += len;
+            continue;
         }
-#else
-        if (purc_variant_stringify(rwstream, argv[i], 0, NULL) < 0) {
-            goto fatal;
+
+        /* write in place, with the space counted already */
+        if (rwstream == NULL) {
+            rwstream = purc_rwstream_new_from_mem(content, sz_content + 1);
+            if (rwstream == NULL)
+                goto fatal;
         }
-#endif
-    }
 
-    if (purc_rwstream_write(rwstream, "", 1) < 1) {
-        goto fatal;
+        purc_rwstream_seek(rwstream, p - content, SEEK_SET);
+        ssize_t n = purc_variant_stringify(rwstream, argv[i], 0, NULL);
+        if (n < 0)
+            goto fatal;
+        p += n;
     }
+    *p = '\0';
 
-    size_t sz_buffer = 0;
-    size_t sz_content = 0;
-    char *content = NULL;
-    content = purc_rwstream_get_mem_buffer_ex(rwstream,
-            &sz_content, &sz_buffer, true);
-    purc_rwstream_destroy(rwstream);
+    if (rwstream)
+        purc_rwstream_destroy(rwstream);
 
-    return purc_variant_make_string_reuse_buff(content, sz_buffer, false);
+    if (ascii)
+        return pcvariant_make_ascii_string_reuse_buff(content, sz_content);
+    return purc_variant_make_string_reuse_buff(content, sz_content + 1, false);
 
 fatal:
     if (rwstream)
         purc_rwstream_destroy(rwstream);
+    free(content);
     return PURC_VARIANT_INVALID;
 }
 
@@ -443,7 +843,7 @@ shuffle_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         }
 
         for (size_t i =  0; i < len; i++) {
-            size_t new_idx = (size_t)pcdvobjs_get_random() % (size_t)len;
+            size_t new_idx = (size_t)pcdvobjs_get_random_below(len);
 
             if (new_idx != i) {
                 char tmp = new_str[new_idx];
@@ -463,14 +863,7 @@ shuffle_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         assert(n == nr_chars);
 
         for (size_t i =  0; i < n; i++) {
-            size_t new_idx;
-            if (n < RAND_MAX) {
-                new_idx = (size_t)pcdvobjs_get_random() % n;
-            }
-            else {
-                new_idx = (size_t)pcdvobjs_get_random();
-                new_idx = new_idx * n / RAND_MAX;
-            }
+            size_t new_idx = (size_t)pcdvobjs_get_random_below(n);
 
             if (new_idx != i) {
                 uint32_t tmp = ucs[new_idx];
@@ -503,7 +896,6 @@ repeat_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
 {
     UNUSED_PARAM(root);
 
-    purc_rwstream_t rwstream = NULL;
     if (nr_args < 2) {
         purc_set_error(PURC_ERROR_ARGUMENT_MISSED);
         goto failed;
@@ -533,41 +925,39 @@ repeat_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         return purc_variant_make_string_static("", false);
     }
 
-    rwstream = purc_rwstream_new_buffer(LEN_INI_PRINT_BUF, LEN_MAX_PRINT_BUF);
-    if (rwstream == NULL) {
-        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-        goto fatal;
-    }
-
-    for (int64_t i=0; i < times; i++) {
-        ssize_t nr_wrotten = purc_rwstream_write(rwstream, str, len_str);
-        if (nr_wrotten < 0 || (size_t)nr_wrotten < len_str) {
-            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-            goto fatal;
-        }
+    if ((uint64_t)times > (SIZE_MAX - 1) / len_str) {
+        purc_set_error(PURC_ERROR_TOO_LARGE_ENTITY);
+        goto failed;
     }
 
-    if (purc_rwstream_write(rwstream, "", 1) < 1) {
+    size_t sz_content = len_str * (size_t)times;
+    char *content = malloc(sz_content + 1);
+    if (content == NULL) {
         purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
         goto fatal;
     }
 
-    size_t sz_buffer = 0;
-    size_t sz_content = 0;
-    char *content = NULL;
-    content = purc_rwstream_get_mem_buffer_ex(rwstream,
-            &sz_content, &sz_buffer, true);
-    purc_rwstream_destroy(rwstream);
+    /* double the copies in the buffer each time */
+    memcpy(content, str, len_str);
+    size_t sz_copied = len_str;
+    while (sz_copied < sz_content) {
+        size_t n = sz_copied;
+        if (n > sz_content - sz_copied)
+            n = sz_content - sz_copied;
+        memcpy(content + sz_copied, content, n);
+        sz_copied += n;
+    }
+    content[sz_content] = '\0';
 
-    return purc_variant_make_string_reuse_buff(content, sz_buffer, false);
+    if (pcvariant_string_is_ascii(argv[0]))
+        return pcvariant_make_ascii_string_reuse_buff(content, sz_content);
+    return purc_variant_make_string_reuse_buff(content, sz_content + 1, false);
 
 failed:
     if (silently)
         return purc_variant_make_string_static("", false);
 
 fatal:
-    if (rwstream)
-        purc_rwstream_destroy(rwstream);
     return PURC_VARIANT_INVALID;
 }
 
@@ -607,6 +997,8 @@ reverse_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         goto fatal;
     }
 
+    if (pcvariant_string_is_ascii(argv[0]))
+        return pcvariant_make_ascii_string_reuse_buff(new_str, length);
     return purc_variant_make_string_reuse_buff(new_str, length, false);
 
 failed:
@@ -1217,7 +1609,10 @@ substr_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
 
         strncpy (buf, start, length);
         buf[length] = 0x00;
-        ret_var = purc_variant_make_string_reuse_buff (buf, length, false);
+        if (pcvariant_string_is_ascii (argv[0]))
+            ret_var = pcvariant_make_ascii_string_reuse_buff (buf, length);
+        else
+            ret_var = purc_variant_make_string_reuse_buff (buf, length, false);
     }
 
     return ret_var;
@@ -1229,6 +1624,7 @@ purc_variant_t purc_dvobj_string_new(void)
         { "nr_bytes",   nr_bytes_getter,    NULL },
         { "nr_chars",   nr_chars_getter,    NULL },
         { "contains",   contains_getter,    NULL },
+        { "contains_any", contains_any_getter, NULL },
         { "starts_with",starts_with_getter,   NULL },
         { "ends_with",  ends_with_getter,   NULL },
         { "join",       join_getter,        NULL },
@@ -1245,5 +1641,20 @@ purc_variant_t purc_dvobj_string_new(void)
         { "substr",     substr_getter,      NULL },
     };
 
-    return purc_dvobj_make_from_methods(method, PCA_TABLESIZE(method));
+    /* all but shuffle */
+    static const char *pure_methods[] = {
+        "nr_bytes", "nr_chars", "contains", "contains_any", "starts_with",
+        "ends_with",
+        "join", "tolower", "toupper", "repeat", "reverse", "explode",
+        "implode", "replace", "format_c", "format_p", "substr",
+    };
+
+    purc_variant_t retv;
+    retv = purc_dvobj_make_from_methods(method, PCA_TABLESIZE(method));
+    if (retv != PURC_VARIANT_INVALID) {
+        purc_dvobj_set_pure_methods(retv, pure_methods,
+                PCA_TABLESIZE(pure_methods));
+    }
+
+    return retv;
 }
@@ -28,6 +28,8 @@
 #include "private/errors.h"
 #include "private/atom-buckets.h"
 #include "private/dvobjs.h"
+#include "private/interpreter.h"
+#include "private/tls.h"
 
 #include "purc-variant.h"
 #include "purc-dvobjs.h"
@@ -42,6 +44,10 @@
 #include <sys/utsname.h>
 #include <sys/time.h>
 
+#if OS(LINUX)
+#include <sys/random.h>
+#endif
+
 #define MSG_SOURCE_SYSTEM         PURC_PREDEF_VARNAME_SYS
 
 #define MSG_TYPE_CHANGE           "change"
@@ -934,7 +940,15 @@ sleep_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
     struct timespec req, rem;
     req.tv_sec = (time_t)ul_sec;
     req.tv_nsec = (long)l_nsec;
-    if (nanosleep(&req, &rem) == 0) {
+
+    /* in a coroutine, the coroutine sleeps after evaluating the current
+       element, and the others go on meanwhile */
+    uint64_t ns = (ul_sec > (UINT64_MAX - l_nsec) / 1000000000) ?
+        UINT64_MAX : ul_sec * 1000000000 + l_nsec;
+    if (pcintr_defer_sleep(ns)) {
+        ld_rem = 0;
+    }
+    else if (nanosleep(&req, &rem) == 0) {
         ld_rem = 0;
     }
     else {
@@ -1303,29 +1317,8 @@ bool pcdvobjs_is_valid_timezone(const char *timezone)
 {
     assert(timezone);
 
-    char path[PATH_MAX + 1];
-    if (strlen(timezone) < PATH_MAX - sizeof(PURC_SYS_TZ_DIR)) {
-        strcpy(path, PURC_SYS_TZ_DIR);
-        strcat(path, timezone);
-        if (access(path, F_OK)) {
-            purc_set_error(PURC_ERROR_INVALID_VALUE);
-            goto failed;
-        }
-
-        if (access(path, R_OK)) {
-            purc_set_error(PURC_ERROR_ACCESS_DENIED);
-            goto failed;
-        }
-    }
-    else {
-        purc_set_error(PURC_ERROR_INVALID_VALUE);
-        goto failed;
-    }
-
-    return true;
-
-failed:
-    return false;
+    /* the timezone is loaded and cached for the later conversions */
+    return pcdvobjs_tzinfo_get(timezone) != NULL;
 }
 
 static purc_variant_t
@@ -1627,42 +1620,111 @@ failed:
     return PURC_VARIANT_INVALID;
 }
 
-#define MAX_LEN_STATE_BUF   256
-
-#if HAVE(RANDOM_R)
-struct local_random_data {
-    char                state_buf[MAX_LEN_STATE_BUF];
-    size_t              state_len;
-    struct random_data  data;
+/*
+ * The generator is xoshiro256** by David Blackman and Sebastiano Vigna,
+ * kept in a thread-local state, so no local data is looked up for a
+ * number. The state is seeded from the kernel when it is used first.
+ */
+struct random_state {
+    uint64_t    s[4];
+    bool        seeded;
 };
 
-static void cb_free_local_random_data(void *key, void *local_data)
+PURC_DEFINE_THREAD_LOCAL(struct random_state, local_random_state);
+
+static inline uint64_t rotl(uint64_t x, int k)
 {
-    if (key)
-        free_key_string(key);
-    free(local_data);
+    return (x << k) | (x >> (64 - k));
 }
-#else
-static char random_state[MAX_LEN_STATE_BUF];
+
+static uint64_t splitmix64(uint64_t *x)
+{
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static void seed_random(struct random_state *rs, uint64_t seed)
+{
+    for (int i = 0; i < 4; i++)
+        rs->s[i] = splitmix64(&seed);
+    rs->seeded = true;
+}
+
+static struct random_state *get_random_state(void)
+{
+    struct random_state *rs = PURC_GET_THREAD_LOCAL(local_random_state);
+    if (rs == NULL || rs->seeded)
+        return rs;
+
+    uint64_t seed = 0;
+#if OS(LINUX)
+    if (getrandom(&seed, sizeof(seed), GRND_NONBLOCK) != sizeof(seed))
 #endif
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        seed = ((uint64_t)ts.tv_sec << 32) ^ (uint64_t)ts.tv_nsec ^
+            (uint64_t)(uintptr_t)rs;
+    }
+
+    seed_random(rs, seed);
+    return rs;
+}
+
+uint64_t pcdvobjs_get_random64(void)
+{
+    struct random_state *rs = get_random_state();
+    if (rs == NULL)
+        return ((uint64_t)random() << 33) ^ ((uint64_t)random() << 2) ^
+            (uint64_t)random();
+
+    uint64_t *s = rs->s;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return result;
+}
 
 int32_t pcdvobjs_get_random(void)
 {
-#if HAVE(RANDOM_R)
-    struct local_random_data *rd = NULL;
-    purc_get_local_data(PURC_LDNAME_RANDOM_DATA, (uintptr_t *)&rd, NULL);
-
-    int32_t result;
-    if (rd)
-        random_r(&rd->data, &result);
-    else
-        result = (int32_t)random();
+    /* in [0, RAND_MAX] as random() gives */
+    return (int32_t)((pcdvobjs_get_random64() >> 32) %
+            ((uint64_t)RAND_MAX + 1));
+}
+
+uint64_t pcdvobjs_get_random_below(uint64_t bound)
+{
+    assert(bound > 0);
+
+#if defined(__SIZEOF_INT128__)
+    /* Lemire's method: divides only for the rare rejected ones */
+    unsigned __int128 m = (unsigned __int128)pcdvobjs_get_random64() * bound;
+    uint64_t low = (uint64_t)m;
+    if (low < bound) {
+        uint64_t threshold = -bound % bound;
+        while (low < threshold) {
+            m = (unsigned __int128)pcdvobjs_get_random64() * bound;
+            low = (uint64_t)m;
+        }
+    }
+    return (uint64_t)(m >> 64);
 #else
-    long int result;
-    result = random();
+    uint64_t threshold = -bound % bound;
+    uint64_t x;
+    do {
+        x = pcdvobjs_get_random64();
+    } while (x < threshold);
+    return x % bound;
 #endif
-
-    return (int32_t)result;
 }
 
 static purc_variant_t
@@ -1758,17 +1820,14 @@ random_setter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         }
     }
 
-#if HAVE(RANDOM_R)
-    struct local_random_data *rd = NULL;
-    purc_get_local_data(PURC_LDNAME_RANDOM_DATA, (uintptr_t *)&rd, NULL);
-    assert(rd);
-
-    rd->data.state = NULL;
-    initstate_r((unsigned int)seed, rd->state_buf, (size_t)complexity,
-            &rd->data);
-#else
-    initstate((unsigned int)seed, random_state, (size_t)complexity);
-#endif
+    /* the complexity was the size of the state of random_r(); the state
+       of the generator is fixed now */
+    struct random_state *rs = get_random_state();
+    if (rs == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto failed;
+    }
+    seed_random(rs, seed);
 
     return purc_variant_make_boolean(true);
 
@@ -1781,16 +1840,12 @@ failed:
 
 #if OS(LINUX)
 
-#include <sys/random.h>
-
 static purc_variant_t
 random_sequence_getter(purc_variant_t root,
         size_t nr_args, purc_variant_t *argv, bool silently)
 {
     UNUSED_PARAM(root);
 
-    char buf[256];
-
     if (nr_args < 1) {
         purc_set_error(PURC_ERROR_ARGUMENT_MISSED);
         goto failed;
@@ -1808,12 +1863,21 @@ random_sequence_getter(purc_variant_t root,
         goto failed;
     }
 
-    ssize_t ret = getrandom(buf, sizeof(buf), GRND_NONBLOCK);
-    if (ret < 0) {
+    /* filled in one call, since getrandom() does not return less than
+       256 bytes requested */
+    char *buf = malloc(length);
+    if (buf == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto failed;
+    }
+
+    if (getrandom(buf, length, GRND_NONBLOCK) != (ssize_t)length) {
+        free(buf);
         purc_set_error(PURC_ERROR_BAD_SYSTEM_CALL);
+        goto failed;
     }
 
-    return purc_variant_make_byte_sequence(buf, ret);
+    return purc_variant_make_byte_sequence_reuse_buff(buf, length, length);
 
 failed:
     if (silently) {
@@ -1867,27 +1931,6 @@ purc_variant_t purc_dvobj_system_new (void)
 
     }
 
-#if HAVE(RANDOM_R)
-    /* allocate data for state of the random generator */
-    struct local_random_data *rd;
-    rd = calloc(1, sizeof(*rd));
-    if (rd) {
-        if (!purc_set_local_data(PURC_LDNAME_RANDOM_DATA,
-                    (uintptr_t)rd, cb_free_local_random_data)) {
-            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-            return PURC_VARIANT_INVALID;
-        }
-
-        initstate_r(time(NULL), rd->state_buf, 8, &rd->data);
-    }
-    else {
-        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-        return PURC_VARIANT_INVALID;
-    }
-#else
-    initstate(time(NULL), random_state, 8);
-#endif
-
     return purc_dvobj_make_from_methods(methods, PCA_TABLESIZE(methods));
 }
 
@@ -0,0 +1,710 @@
+/*
+ * @file tzinfo.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The cache of the timezone data used by $DATETIME.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A timezone is loaded from the TZif file (RFC 8536) in the system
+ * directory once, and the times are converted with the data parsed,
+ * so the environment variable `TZ` is never changed for a conversion.
+ *
+ * The parsed timezones are never changed nor freed before exit, and they
+ * are prepended to a list by an atomic store, so the list can be searched
+ * without any lock; only the loading is serialized by the lock.
+ *
+ * The leap seconds are ignored, the same as the POSIX time.
+ */
+
+#include "config.h"
+
+#include "purc-errors.h"
+
+#include "private/dvobjs.h"
+#include "private/errors.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TZIF_MAGIC          "TZif"
+#define TZIF_MAX_FILE_SIZE  (1024 * 1024)
+
+#define SECS_PER_DAY        86400
+#define LEN_MAX_TZ_ABBR     16
+
+struct tz_type {
+    int32_t     utoff;      /* seconds east of UTC */
+    uint8_t     isdst;
+    uint8_t     abbr;       /* the index in chars */
+};
+
+/* the rule to change between the standard time and DST in a year */
+struct tz_rule {
+    char        kind;       /* 'J', 'D' (zero-based Julian day), or 'M' */
+    int         day;
+    int         week;
+    int         mon;
+    int32_t     time;       /* seconds after the local midnight */
+};
+
+/* the POSIX TZ string for the times after the last transition */
+struct tz_posix {
+    bool            has_dst;
+    int32_t         std_off;
+    int32_t         dst_off;
+    struct tz_rule  start;
+    struct tz_rule  end;
+    char            std_abbr[LEN_MAX_TZ_ABBR];
+    char            dst_abbr[LEN_MAX_TZ_ABBR];
+};
+
+struct pcdvobjs_tzinfo {
+    struct pcdvobjs_tzinfo *next;
+    char               *name;
+
+    size_t              nr_trans;
+    int64_t            *trans;
+    uint8_t            *trans_types;
+
+    size_t              nr_types;
+    struct tz_type     *types;
+
+    size_t              nr_chars;
+    char               *chars;
+
+    bool                has_posix;
+    struct tz_posix     posix;
+};
+
+/* the information of the local time at a specific time */
+struct tz_local {
+    int32_t             utoff;
+    int                 isdst;
+    const char         *abbr;
+};
+
+static pthread_mutex_t tzinfo_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct pcdvobjs_tzinfo *tzinfo_list;
+
+static void tzinfo_free(struct pcdvobjs_tzinfo *tz)
+{
+    free(tz->name);
+    free(tz->trans);
+    free(tz->trans_types);
+    free(tz->types);
+    free(tz->chars);
+    free(tz);
+}
+
+static void tzinfo_cleanup(void)
+{
+    struct pcdvobjs_tzinfo *tz = tzinfo_list;
+    tzinfo_list = NULL;
+    while (tz) {
+        struct pcdvobjs_tzinfo *next = tz->next;
+        tzinfo_free(tz);
+        tz = next;
+    }
+}
+
+static struct pcdvobjs_tzinfo *find_tzinfo(const char *name)
+{
+    struct pcdvobjs_tzinfo *tz = __atomic_load_n(&tzinfo_list,
+            __ATOMIC_ACQUIRE);
+    while (tz) {
+        if (strcmp(tz->name, name) == 0)
+            break;
+        tz = tz->next;
+    }
+
+    return tz;
+}
+
+static int64_t days_from_civil(int64_t y, int m, int d)
+{
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yoe = y - era * 400;
+    int64_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+static bool is_leap_year(int64_t y)
+{
+    return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+}
+
+static int days_in_month(int64_t y, int m)
+{
+    static const int days[] = {
+        31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+    };
+
+    return (m == 2 && is_leap_year(y)) ? 29 : days[m - 1];
+}
+
+static int64_t floor_div(int64_t a, int64_t b)
+{
+    return a / b - (a % b < 0);
+}
+
+/* the year in which the specified seconds since the Epoch lays */
+static int64_t year_of(int64_t t)
+{
+    int64_t days = floor_div(t, SECS_PER_DAY);
+    int64_t y = floor_div(days * 400, 146097) + 1970;
+    while (days_from_civil(y, 1, 1) > days)
+        y--;
+    while (days_from_civil(y + 1, 1, 1) <= days)
+        y++;
+    return y;
+}
+
+static const char *parse_number(const char *p, int min, int max, int *n)
+{
+    if (!purc_isdigit(*p))
+        return NULL;
+
+    int v = 0;
+    while (purc_isdigit(*p)) {
+        v = v * 10 + (*p - '0');
+        if (v > max)
+            return NULL;
+        p++;
+    }
+
+    if (v < min)
+        return NULL;
+
+    *n = v;
+    return p;
+}
+
+/* [+-]hh[:mm[:ss]]; the hours can be up to 167 in rule times */
+static const char *parse_hms(const char *p, int32_t *secs)
+{
+    int sign = 1;
+    int h, m = 0, s = 0;
+
+    if (*p == '+' || *p == '-') {
+        if (*p == '-')
+            sign = -1;
+        p++;
+    }
+
+    if ((p = parse_number(p, 0, 167, &h)) == NULL)
+        return NULL;
+    if (*p == ':') {
+        if ((p = parse_number(p + 1, 0, 59, &m)) == NULL)
+            return NULL;
+        if (*p == ':') {
+            if ((p = parse_number(p + 1, 0, 59, &s)) == NULL)
+                return NULL;
+        }
+    }
+
+    *secs = sign * (h * 3600 + m * 60 + s);
+    return p;
+}
+
+static const char *parse_abbr(const char *p, char *buf)
+{
+    size_t n = 0;
+
+    if (*p == '<') {
+        p++;
+        while (*p && *p != '>') {
+            if (n + 1 >= LEN_MAX_TZ_ABBR)
+                return NULL;
+            buf[n++] = *p++;
+        }
+
+        if (*p != '>')
+            return NULL;
+        p++;
+    }
+    else {
+        while (purc_isalpha(*p)) {
+            if (n + 1 >= LEN_MAX_TZ_ABBR)
+                return NULL;
+            buf[n++] = *p++;
+        }
+    }
+
+    if (n == 0)
+        return NULL;
+
+    buf[n] = 0;
+    return p;
+}
+
+static const char *parse_rule(const char *p, struct tz_rule *rule)
+{
+    if (*p == 'J') {
+        rule->kind = 'J';
+        p = parse_number(p + 1, 1, 365, &rule->day);
+    }
+    else if (*p == 'M') {
+        rule->kind = 'M';
+        if ((p = parse_number(p + 1, 1, 12, &rule->mon)) == NULL ||
+                *p != '.' ||
+                (p = parse_number(p + 1, 1, 5, &rule->week)) == NULL ||
+                *p != '.')
+            return NULL;
+        p = parse_number(p + 1, 0, 6, &rule->day);
+    }
+    else {
+        rule->kind = 'D';
+        p = parse_number(p, 0, 365, &rule->day);
+    }
+
+    if (p == NULL)
+        return NULL;
+
+    rule->time = 2 * 3600;
+    if (*p == '/') {
+        p = parse_hms(p + 1, &rule->time);
+    }
+
+    return p;
+}
+
+/* e.g., `CET-1CEST,M3.5.0,M10.5.0/3` or `<+08>-8` */
+static bool parse_posix(const char *p, struct tz_posix *posix)
+{
+    int32_t off;
+
+    if ((p = parse_abbr(p, posix->std_abbr)) == NULL ||
+            (p = parse_hms(p, &off)) == NULL)
+        return false;
+
+    /* the offsets in POSIX TZ strings are west of UTC */
+    posix->std_off = -off;
+    if (*p == 0) {
+        posix->has_dst = false;
+        return true;
+    }
+
+    if ((p = parse_abbr(p, posix->dst_abbr)) == NULL)
+        return false;
+
+    posix->has_dst = true;
+    posix->dst_off = posix->std_off + 3600;
+    if (*p && *p != ',') {
+        if ((p = parse_hms(p, &off)) == NULL)
+            return false;
+        posix->dst_off = -off;
+    }
+
+    if (*p == 0) {
+        /* the default rules of POSIX */
+        p = ",M3.2.0,M11.1.0";
+    }
+
+    if (*p != ',' || (p = parse_rule(p + 1, &posix->start)) == NULL ||
+            *p != ',' || (p = parse_rule(p + 1, &posix->end)) == NULL)
+        return false;
+
+    return *p == 0;
+}
+
+/* the local time of the rule in @year, in seconds since the Epoch */
+static int64_t rule_local_time(int64_t year, const struct tz_rule *rule)
+{
+    int64_t days = days_from_civil(year, 1, 1);
+
+    switch (rule->kind) {
+    case 'J':
+        /* the leap day is never counted */
+        days += rule->day - 1;
+        if (rule->day >= 60 && is_leap_year(year))
+            days++;
+        break;
+
+    case 'D':
+        days += rule->day;
+        break;
+
+    default:
+    {
+        days = days_from_civil(year, rule->mon, 1);
+
+        /* 1970-01-01 is Thursday */
+        int wday = (int)((days % 7 + 11) % 7);
+        int mday = (rule->day - wday + 7) % 7 + (rule->week - 1) * 7;
+        int nr_days = days_in_month(year, rule->mon);
+        while (mday >= nr_days)
+            mday -= 7;
+        days += mday;
+        break;
+    }
+    }
+
+    return days * SECS_PER_DAY + rule->time;
+}
+
+static void posix_local(const struct tz_posix *posix, int64_t t,
+        struct tz_local *local)
+{
+    bool dst = false;
+
+    if (posix->has_dst) {
+        int64_t year = year_of(t + posix->std_off);
+        int64_t start = rule_local_time(year, &posix->start) - posix->std_off;
+        int64_t end = rule_local_time(year, &posix->end) - posix->dst_off;
+
+        if (start < end)
+            dst = (t >= start && t < end);
+        else    /* in the southern hemisphere */
+            dst = !(t >= end && t < start);
+    }
+
+    if (dst) {
+        local->utoff = posix->dst_off;
+        local->isdst = 1;
+        local->abbr = posix->dst_abbr;
+    }
+    else {
+        local->utoff = posix->std_off;
+        local->isdst = 0;
+        local->abbr = posix->std_abbr;
+    }
+}
+
+static void tzinfo_local(const struct pcdvobjs_tzinfo *tz, int64_t t,
+        struct tz_local *local)
+{
+    size_t type = 0;
+
+    if (tz->nr_trans > 0 && t >= tz->trans[tz->nr_trans - 1] &&
+            tz->has_posix) {
+        posix_local(&tz->posix, t, local);
+        return;
+    }
+
+    if (tz->nr_trans > 0 && t >= tz->trans[0]) {
+        /* the last transition not after @t */
+        size_t lo = 0, hi = tz->nr_trans;
+        while (hi - lo > 1) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (tz->trans[mid] <= t)
+                lo = mid;
+            else
+                hi = mid;
+        }
+        type = tz->trans_types[lo];
+    }
+    else if (tz->nr_trans == 0 && tz->has_posix) {
+        posix_local(&tz->posix, t, local);
+        return;
+    }
+
+    local->utoff = tz->types[type].utoff;
+    local->isdst = tz->types[type].isdst;
+    local->abbr = tz->chars + tz->types[type].abbr;
+}
+
+static uint32_t get_be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+        ((uint32_t)p[2] << 8) | p[3];
+}
+
+static uint64_t get_be64(const uint8_t *p)
+{
+    return ((uint64_t)get_be32(p) << 32) | get_be32(p + 4);
+}
+
+struct tzif_header {
+    int         version;
+    uint32_t    isutcnt;
+    uint32_t    isstdcnt;
+    uint32_t    leapcnt;
+    uint32_t    timecnt;
+    uint32_t    typecnt;
+    uint32_t    charcnt;
+};
+
+#define TZIF_HEADER_SIZE    44
+
+static bool parse_header(const uint8_t *p, size_t sz, struct tzif_header *hdr)
+{
+    if (sz < TZIF_HEADER_SIZE || memcmp(p, TZIF_MAGIC, 4))
+        return false;
+
+    hdr->version = p[4] ? p[4] - '0' : 1;
+    hdr->isutcnt = get_be32(p + 20);
+    hdr->isstdcnt = get_be32(p + 24);
+    hdr->leapcnt = get_be32(p + 28);
+    hdr->timecnt = get_be32(p + 32);
+    hdr->typecnt = get_be32(p + 36);
+    hdr->charcnt = get_be32(p + 40);
+
+    return hdr->typecnt > 0 && hdr->typecnt <= 256 &&
+        hdr->charcnt > 0 && hdr->charcnt <= 256 &&
+        (hdr->isutcnt == 0 || hdr->isutcnt == hdr->typecnt) &&
+        (hdr->isstdcnt == 0 || hdr->isstdcnt == hdr->typecnt) &&
+        hdr->timecnt <= TZIF_MAX_FILE_SIZE;
+}
+
+/* the size of the data block after the header */
+static size_t data_size(const struct tzif_header *hdr, size_t sz_time)
+{
+    return hdr->timecnt * sz_time + hdr->timecnt + hdr->typecnt * 6 +
+        hdr->charcnt + hdr->leapcnt * (sz_time + 4) +
+        hdr->isstdcnt + hdr->isutcnt;
+}
+
+static bool parse_tzif(struct pcdvobjs_tzinfo *tz, const uint8_t *p,
+        size_t sz)
+{
+    struct tzif_header hdr;
+    size_t sz_time = 4;
+
+    if (!parse_header(p, sz, &hdr))
+        return false;
+
+    if (hdr.version >= 2) {
+        /* skip the version 1 data, and use the 64-bit one */
+        size_t skip = TZIF_HEADER_SIZE + data_size(&hdr, 4);
+        if (skip > sz || !parse_header(p + skip, sz - skip, &hdr))
+            return false;
+        p += skip;
+        sz -= skip;
+        sz_time = 8;
+    }
+
+    p += TZIF_HEADER_SIZE;
+    sz -= TZIF_HEADER_SIZE;
+    if (data_size(&hdr, sz_time) > sz)
+        return false;
+
+    tz->nr_trans = hdr.timecnt;
+    tz->nr_types = hdr.typecnt;
+    tz->nr_chars = hdr.charcnt;
+    tz->trans = malloc(sizeof(tz->trans[0]) * (hdr.timecnt + 1));
+    tz->trans_types = malloc(hdr.timecnt + 1);
+    tz->types = malloc(sizeof(tz->types[0]) * hdr.typecnt);
+    tz->chars = malloc(hdr.charcnt + 1);
+    if (!tz->trans || !tz->trans_types || !tz->types || !tz->chars)
+        return false;
+
+    for (size_t i = 0; i < hdr.timecnt; i++) {
+        if (sz_time == 8)
+            tz->trans[i] = (int64_t)get_be64(p);
+        else
+            tz->trans[i] = (int32_t)get_be32(p);
+        if (i > 0 && tz->trans[i] <= tz->trans[i - 1])
+            return false;
+        p += sz_time;
+    }
+
+    for (size_t i = 0; i < hdr.timecnt; i++) {
+        if (p[i] >= hdr.typecnt)
+            return false;
+        tz->trans_types[i] = p[i];
+    }
+    p += hdr.timecnt;
+
+    for (size_t i = 0; i < hdr.typecnt; i++) {
+        tz->types[i].utoff = (int32_t)get_be32(p);
+        tz->types[i].isdst = p[4] ? 1 : 0;
+        tz->types[i].abbr = p[5];
+        if (p[5] >= hdr.charcnt)
+            return false;
+        p += 6;
+    }
+
+    memcpy(tz->chars, p, hdr.charcnt);
+    tz->chars[hdr.charcnt] = 0;
+    p += hdr.charcnt;
+
+    p += hdr.leapcnt * (sz_time + 4) + hdr.isstdcnt + hdr.isutcnt;
+    sz -= data_size(&hdr, sz_time);
+
+    /* the footer: a POSIX TZ string between two new lines */
+    if (hdr.version >= 2 && sz > 2 && p[0] == '\n') {
+        const uint8_t *end = memchr(p + 1, '\n', sz - 1);
+        if (end && end - p > 1 && end - p < 128) {
+            char footer[128];
+            memcpy(footer, p + 1, end - p - 1);
+            footer[end - p - 1] = 0;
+            tz->has_posix = parse_posix(footer, &tz->posix);
+        }
+    }
+
+    return true;
+}
+
+static struct pcdvobjs_tzinfo *load_tzinfo(const char *name)
+{
+    char path[PATH_MAX + 1];
+    int n = snprintf(path, sizeof(path), "%s%s", PURC_SYS_TZ_DIR, name);
+    if (n < 0 || (size_t)n >= sizeof(path) || strstr(name, "..")) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return NULL;
+    }
+
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        purc_set_error(errno == EACCES ?
+                PURC_ERROR_ACCESS_DENIED : PURC_ERROR_INVALID_VALUE);
+        return NULL;
+    }
+
+    uint8_t *buf = malloc(TZIF_MAX_FILE_SIZE);
+    size_t sz = buf ? fread(buf, 1, TZIF_MAX_FILE_SIZE, fp) : 0;
+    fclose(fp);
+
+    struct pcdvobjs_tzinfo *tz = calloc(1, sizeof(*tz));
+    if (buf == NULL || tz == NULL || (tz->name = strdup(name)) == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto failed;
+    }
+
+    if (!parse_tzif(tz, buf, sz)) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        goto failed;
+    }
+
+    free(buf);
+    return tz;
+
+failed:
+    if (tz)
+        tzinfo_free(tz);
+    free(buf);
+    return NULL;
+}
+
+const struct pcdvobjs_tzinfo *pcdvobjs_tzinfo_get(const char *timezone)
+{
+    struct pcdvobjs_tzinfo *tz = find_tzinfo(timezone);
+    if (tz)
+        return tz;
+
+    pthread_mutex_lock(&tzinfo_lock);
+    /* may be loaded by another thread meanwhile */
+    if ((tz = find_tzinfo(timezone)) == NULL &&
+            (tz = load_tzinfo(timezone))) {
+        if (tzinfo_list == NULL)
+            atexit(tzinfo_cleanup);
+        tz->next = tzinfo_list;
+        __atomic_store_n(&tzinfo_list, tz, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&tzinfo_lock);
+
+    return tz;
+}
+
+static void fill_broken_down_time(int64_t t, const struct tz_local *local,
+        struct tm *tm)
+{
+    time_t lt = (time_t)(t + local->utoff);
+    gmtime_r(&lt, tm);
+
+    tm->tm_isdst = local->isdst;
+#if HAVE(TM_GMTOFF)
+    tm->tm_gmtoff = local->utoff;
+#endif
+#if HAVE(TM_ZONE)
+    tm->tm_zone = (char *)local->abbr;
+#endif
+}
+
+void pcdvobjs_tzinfo_localtime(const struct pcdvobjs_tzinfo *tz,
+        time_t t, struct tm *tm)
+{
+    struct tz_local local;
+    tzinfo_local(tz, t, &local);
+    fill_broken_down_time(t, &local, tm);
+}
+
+time_t pcdvobjs_tzinfo_mktime(const struct pcdvobjs_tzinfo *tz,
+        struct tm *tm)
+{
+    /* normalize the fields in the way of mktime() */
+    int64_t year = (int64_t)tm->tm_year + 1900 + floor_div(tm->tm_mon, 12);
+    int mon = (int)(tm->tm_mon - floor_div(tm->tm_mon, 12) * 12);
+    int64_t lt = (days_from_civil(year, mon + 1, 1) + tm->tm_mday - 1) *
+        SECS_PER_DAY + (int64_t)tm->tm_hour * 3600 +
+        (int64_t)tm->tm_min * 60 + tm->tm_sec;
+
+    /* the offsets a day before and after; no zone changes twice a day */
+    struct tz_local before, after, *chosen = NULL;
+    tzinfo_local(tz, lt - SECS_PER_DAY, &before);
+    tzinfo_local(tz, lt + SECS_PER_DAY, &after);
+
+    struct tz_local check;
+    bool before_ok, after_ok;
+    tzinfo_local(tz, lt - before.utoff, &check);
+    before_ok = (check.utoff == before.utoff);
+    tzinfo_local(tz, lt - after.utoff, &check);
+    after_ok = (check.utoff == after.utoff);
+
+    if (before_ok && after_ok && before.utoff != after.utoff) {
+        /* repeated local time; use the hint, or the earlier one */
+        if (tm->tm_isdst >= 0 && after.isdst == (tm->tm_isdst > 0) &&
+                before.isdst != after.isdst)
+            chosen = &after;
+        else
+            chosen = &before;
+    }
+    else if (after_ok) {
+        chosen = &after;
+    }
+    else {
+        /* skipped local time; use the offset before the gap */
+        chosen = &before;
+    }
+
+    /* the local time is given in the offset of the hint, as mktime() does */
+    int32_t utoff = chosen->utoff;
+    if (tm->tm_isdst >= 0 && chosen->isdst != (tm->tm_isdst > 0)) {
+        if (before.isdst != after.isdst) {
+            utoff = (chosen == &before) ? after.utoff : before.utoff;
+        }
+        else if (tz->has_posix && tz->posix.has_dst) {
+            utoff = tm->tm_isdst ? tz->posix.dst_off : tz->posix.std_off;
+        }
+        else {
+            for (size_t i = tz->nr_types; i > 0; i--) {
+                if (tz->types[i - 1].isdst == (tm->tm_isdst > 0)) {
+                    utoff = tz->types[i - 1].utoff;
+                    break;
+                }
+            }
+        }
+    }
+
+    int64_t t = lt - utoff;
+    if ((int64_t)(time_t)t != t) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return (time_t)-1;
+    }
+
+    pcdvobjs_tzinfo_localtime(tz, (time_t)t, tm);
+    return (time_t)t;
+}
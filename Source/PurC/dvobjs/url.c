@@ -29,6 +29,78 @@
 #include "private/utils.h"
 #include "private/dvobjs.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+static inline bool is_unreserved(unsigned char c)
+{
+    return purc_isalnum(c) || c == '-' || c == '_' || c == '.';
+}
+
+/* returns the length of the leading run of the bytes which are kept as is
+   by the encoding: the ASCII letters and digits, `-`, `_`, and `.` */
+static size_t
+unreserved_run_length(const unsigned char *p, size_t len)
+{
+    size_t n = 0;
+
+#if defined(__SSE2__)
+    /* the bytes not less than 0x80 are negative, thus out of the ranges */
+    const __m128i v_before_0 = _mm_set1_epi8('0' - 1);
+    const __m128i v_after_9 = _mm_set1_epi8('9' + 1);
+    const __m128i v_before_a = _mm_set1_epi8('a' - 1);
+    const __m128i v_after_z = _mm_set1_epi8('z' + 1);
+    const __m128i v_case = _mm_set1_epi8(0x20);
+    const __m128i v_minus = _mm_set1_epi8('-');
+    const __m128i v_underscore = _mm_set1_epi8('_');
+    const __m128i v_dot = _mm_set1_epi8('.');
+
+    while (n + 16 <= len) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(p + n));
+        __m128i lower = _mm_or_si128(chunk, v_case);
+        __m128i kept = _mm_or_si128(
+                _mm_and_si128(_mm_cmpgt_epi8(chunk, v_before_0),
+                    _mm_cmplt_epi8(chunk, v_after_9)),
+                _mm_and_si128(_mm_cmpgt_epi8(lower, v_before_a),
+                    _mm_cmplt_epi8(lower, v_after_z)));
+        kept = _mm_or_si128(kept,
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, v_minus),
+                    _mm_or_si128(_mm_cmpeq_epi8(chunk, v_underscore),
+                        _mm_cmpeq_epi8(chunk, v_dot))));
+        int mask = ~_mm_movemask_epi8(kept) & 0xFFFF;
+        if (mask) {
+            return n + __builtin_ctz(mask);
+        }
+        n += 16;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    while (n + 16 <= len) {
+        uint8x16_t chunk = vld1q_u8(p + n);
+        uint8x16_t lower = vorrq_u8(chunk, vdupq_n_u8(0x20));
+        uint8x16_t kept = vorrq_u8(
+                vcleq_u8(vsubq_u8(chunk, vdupq_n_u8('0')), vdupq_n_u8(9)),
+                vcleq_u8(vsubq_u8(lower, vdupq_n_u8('a')), vdupq_n_u8(25)));
+        kept = vorrq_u8(kept,
+                vorrq_u8(vceqq_u8(chunk, vdupq_n_u8('-')),
+                    vorrq_u8(vceqq_u8(chunk, vdupq_n_u8('_')),
+                        vceqq_u8(chunk, vdupq_n_u8('.')))));
+        if (vminvq_u8(kept) == 0) {
+            /* the scalar loop below locates the byte */
+            break;
+        }
+        n += 16;
+    }
+#endif
+
+    while (n < len && is_unreserved(p[n])) {
+        n++;
+    }
+    return n;
+}
+
 size_t pcdvobj_url_decode_in_place(char *string, size_t length, int rfc)
 {
     size_t nr_decoded = 0;
@@ -38,13 +110,18 @@ size_t pcdvobj_url_decode_in_place(char *string, size_t length, int rfc)
     while (left > 0) {
         unsigned char decoded;
 
+        size_t n = unreserved_run_length((unsigned char *)string, left);
+        if (n > 0) {
+            memmove(dest + nr_decoded, string, n);
+            nr_decoded += n;
+            string += n;
+            left -= n;
+            continue;
+        }
+
         if (rfc == PURC_K_KW_rfc1738 && *string == '+') {
             decoded = ' ';
         }
-        else if (purc_isalnum(*string) ||
-                *string == '-' || *string == '_' || *string == '.') {
-            decoded = (unsigned char)*string;
-        }
         else {
             if (*string == '%') {
                 if (left > 2) {
@@ -79,22 +156,28 @@ bad_encoding:
 int pcdvobj_url_encode(struct pcutils_mystring *mystr,
         const unsigned char *bytes, size_t nr_bytes, int rfc)
 {
+    static const char hex_digits[] = "0123456789ABCDEF";
+
     for (size_t i = 0; i < nr_bytes; i++) {
         unsigned char encoded[4];
         size_t len;
 
+        len = unreserved_run_length(bytes + i, nr_bytes - i);
+        if (len > 0) {
+            if (pcutils_mystring_append_mchar(mystr, bytes + i, len))
+                return -1;
+            i += len - 1;
+            continue;
+        }
+
         if (rfc == PURC_K_KW_rfc1738 && bytes[i] == ' ') {
             encoded[0] = '+';
             len = 1;
         }
-        else if (purc_isalnum(bytes[i]) ||
-                bytes[i] == '-' || bytes[i] == '_' || bytes[i] == '.') {
-            encoded[0] = bytes[i];
-            len = 1;
-        }
         else {
             encoded[0] = '%';
-            pcutils_bin2hex(bytes + i, 1, (char *)encoded + 1, true);
+            encoded[1] = hex_digits[bytes[i] >> 4];
+            encoded[2] = hex_digits[bytes[i] & 0x0F];
             len = 3;
         }
 
@@ -113,13 +196,19 @@ int pcdvobj_url_decode(struct pcutils_mystring *mystr,
     while (left > 0) {
         unsigned char decoded;
 
+        size_t n = unreserved_run_length((const unsigned char *)string, left);
+        if (n > 0) {
+            if (pcutils_mystring_append_mchar(mystr,
+                        (const unsigned char *)string, n))
+                return -1;
+            string += n;
+            left -= n;
+            continue;
+        }
+
         if (rfc == PURC_K_KW_rfc1738 && *string == '+') {
             decoded = ' ';
         }
-        else if (purc_isalnum(*string) ||
-                *string == '-' || *string == '_' || *string == '.') {
-            decoded = (unsigned char)*string;
-        }
         else {
             if (*string == '%') {
                 if (left > 2) {
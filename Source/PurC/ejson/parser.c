@@ -27,7 +27,9 @@
 
 #include "private/instance.h"
 #include "private/errors.h"
+#include "private/ejson.h"
 #include "private/debug.h"
+#include "private/trace.h"
 #include "private/utils.h"
 #include "private/stack.h"
 #include "private/tkz-helper.h"
@@ -41,7 +43,6 @@
 #endif
 
 #define ERROR_BUF_SIZE  100
-#define NR_CONSUMED_LIST_LIMIT   10
 
 #define INVALID_CHARACTER    0xFFFFFFFF
 
@@ -275,23 +276,6 @@ enum tokenizer_state {
     LAST_STATE = TKZ_STATE_EJSON_CJSONEE_FINISHED,
 };
 
-#define print_uc_list(uc_list, tag)                                         \
-    do {                                                                    \
-        PC_DEBUG( "begin print %s list\n|", tag);                           \
-        struct list_head *p, *n;                                            \
-        list_for_each_safe(p, n, uc_list) {                                 \
-            struct tkz_uc *puc = list_entry(p, struct tkz_uc, list);        \
-            PC_DEBUG( "%c", puc->character);                                \
-        }                                                                   \
-        PC_DEBUG( "|\nend print %s list\n", tag);                           \
-    } while(0)
-
-#define PRINT_CONSUMED_LIST(wrap)    \
-        print_uc_list(&wrap->consumed_list, "consumed")
-
-#define PRINT_RECONSUM_LIST(wrap)    \
-        print_uc_list(&wrap->reconsume_list, "reconsume")
-
 struct pcejson {
     int state;
     int return_state;
@@ -316,7 +300,6 @@ struct pcejson {
 #define EJSON_MIN_BUFFER_SIZE   128
 #define EJSON_MAX_BUFFER_SIZE   1024 * 1024 * 1024
 #define EJSON_END_OF_FILE       0
-#define PURC_ENVV_EJSON_LOG_ENABLE  "PURC_EJSON_LOG_ENABLE"
 
 struct pcejson *pcejson_create(uint32_t depth, uint32_t flags)
 {
@@ -340,9 +323,7 @@ struct pcejson *pcejson_create(uint32_t depth, uint32_t flags)
     parser->prev_separator = 0;
     parser->nr_quoted = 0;
 
-    const char *env_value = getenv(PURC_ENVV_EJSON_LOG_ENABLE);
-    parser->enable_log = ((env_value != NULL) &&
-            (*env_value == '1' || pcutils_strcasecmp(env_value, "true") == 0));
+    parser->enable_log = pctrace_enabled(PC_TRACE_EJSON);
 
     return parser;
 }
@@ -414,6 +395,16 @@ void pcejson_dec_depth (struct pcejson* parser)
     }
 }
 
+static struct pcvcm_node *
+ejson_new_object_node(struct pcejson *parser)
+{
+    struct pcvcm_node *node = pcvcm_node_new_object(0, NULL);
+    if (node && (parser->flags & PCEJSON_FLAG_INTERN_KEYS)) {
+        node->extra |= EXTRA_INTERN_KEYS_FLAG;
+    }
+    return node;
+}
+
 static UNUSED_FUNCTION
 struct pcvcm_node *create_byte_sequenct(struct tkz_buffer *buffer)
 {
@@ -782,7 +773,7 @@ BEGIN_STATE(TKZ_STATE_EJSON_LEFT_BRACE)
                 if (parser->vcm_node) {
                     vcm_stack_push(parser->vcm_node);
                 }
-                struct pcvcm_node *node = pcvcm_node_new_object(0, NULL);
+                struct pcvcm_node *node = ejson_new_object_node(parser);
                 UPDATE_VCM_NODE(node);
                 RECONSUME_IN(TKZ_STATE_EJSON_BEFORE_NAME);
             }
@@ -800,7 +791,7 @@ BEGIN_STATE(TKZ_STATE_EJSON_LEFT_BRACE)
         if (parser->vcm_node) {
             vcm_stack_push(parser->vcm_node);
         }
-        struct pcvcm_node *node = pcvcm_node_new_object(0, NULL);
+        struct pcvcm_node *node = ejson_new_object_node(parser);
         UPDATE_VCM_NODE(node);
         RECONSUME_IN(TKZ_STATE_EJSON_BEFORE_NAME);
     }
@@ -884,7 +875,7 @@ BEGIN_STATE(TKZ_STATE_EJSON_RIGHT_BRACE)
         if (uc == 'P') {
             ejson_stack_pop();
             ejson_stack_push('{');
-            struct pcvcm_node *node = pcvcm_node_new_object(0, NULL);
+            struct pcvcm_node *node = ejson_new_object_node(parser);
             APPEND_CHILD(node, parser->vcm_node);
             vcm_stack_push(node);
             RESET_VCM_NODE();
@@ -1774,7 +1765,7 @@ BEGIN_STATE(TKZ_STATE_EJSON_AFTER_VALUE_NUMBER)
             SET_ERR(PCEJSON_ERROR_BAD_JSON_NUMBER);
             RETURN_AND_STOP_PARSE();
         }
-        double d = strtod(
+        double d = pcutils_strtod(
                 tkz_buffer_get_bytes(parser->temp_buffer), NULL);
         RESTORE_VCM_NODE();
         struct pcvcm_node *node = pcvcm_node_new_number(d);
@@ -1872,7 +1863,8 @@ END_STATE()
 
 BEGIN_STATE(TKZ_STATE_EJSON_VALUE_NUMBER_EXPONENT)
     if (is_whitespace(character) || character == '}'
-            || character == ']' || character == ',' || character == ')') {
+            || character == ']' || character == ',' || character == ')'
+            || is_eof(character)) {
         RECONSUME_IN(TKZ_STATE_EJSON_AFTER_VALUE_NUMBER);
     }
     if (is_ascii_digit(character)) {
@@ -1888,7 +1880,8 @@ END_STATE()
 
 BEGIN_STATE(TKZ_STATE_EJSON_VALUE_NUMBER_EXPONENT_INTEGER)
     if (is_whitespace(character) || character == '}'
-            || character == ']' || character == ',' || character == ')') {
+            || character == ']' || character == ',' || character == ')'
+            || is_eof(character)) {
         RECONSUME_IN(TKZ_STATE_EJSON_AFTER_VALUE_NUMBER);
     }
     if (is_ascii_digit(character)) {
@@ -1965,7 +1958,8 @@ END_STATE()
 
 BEGIN_STATE(TKZ_STATE_EJSON_VALUE_NUMBER_HEX)
     if (is_whitespace(character) || character == '}'
-            || character == ']' || character == ',' || character == ')') {
+            || character == ']' || character == ',' || character == ')'
+            || is_eof(character)) {
         RECONSUME_IN(TKZ_STATE_EJSON_AFTER_VALUE_NUMBER_HEX);
     }
     if (is_ascii_hex_digit(character)) {
@@ -1981,7 +1975,8 @@ END_STATE()
 
 BEGIN_STATE(TKZ_STATE_EJSON_VALUE_NUMBER_HEX_SUFFIX)
     if (is_whitespace(character) || character == '}'
-            || character == ']' || character == ',' || character == ')') {
+            || character == ']' || character == ',' || character == ')'
+            || is_eof(character)) {
         RECONSUME_IN(TKZ_STATE_EJSON_AFTER_VALUE_NUMBER_HEX);
     }
     uint32_t last_c = tkz_buffer_get_last_char(parser->temp_buffer);
@@ -2031,7 +2026,8 @@ END_STATE()
 
 BEGIN_STATE(TKZ_STATE_EJSON_VALUE_NUMBER_INFINITY)
     if (is_whitespace(character) || character == '}'
-            || character == ']' || character == ',' || character == ')') {
+            || character == ']' || character == ',' || character == ')'
+            || is_eof(character)) {
         if (tkz_buffer_equal_to(parser->temp_buffer,
                     "-Infinity", 9)) {
             double d = -INFINITY;
@@ -2130,7 +2126,8 @@ END_STATE()
 
 BEGIN_STATE(TKZ_STATE_EJSON_VALUE_NAN)
     if (is_whitespace(character) || character == '}'
-            || character == ']' || character == ',' || character == ')') {
+            || character == ']' || character == ',' || character == ')'
+            || is_eof(character)) {
         if (tkz_buffer_equal_to(parser->temp_buffer, "NaN", 3)) {
             double d = NAN;
             RESTORE_VCM_NODE();
@@ -2348,7 +2345,7 @@ BEGIN_STATE(TKZ_STATE_EJSON_JSONEE_VARIABLE)
             ejson_stack_pop();
             ejson_stack_push('{');
             ejson_stack_push(':');
-            struct pcvcm_node *node = pcvcm_node_new_object(0, NULL);
+            struct pcvcm_node *node = ejson_new_object_node(parser);
             APPEND_CHILD(node, parser->vcm_node);
             UPDATE_VCM_NODE(node);
         }
@@ -0,0 +1,603 @@
+/*
+ * @file plain-json.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The fast path to parse the plain JSON text in memory.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Most of the eJSON texts from the fetchers and renderers are plain JSON.
+ * This parser works on the bytes in memory instead of the decoded
+ * characters: the bodies of the strings are scanned for the bytes which
+ * need attention 16 bytes at a time, and a string without the escape
+ * sequences to translate is made from the text directly.
+ *
+ * It gives up on the first construct which is not plain JSON (or which
+ * the eJSON parser treats differently, like `$` in a string), and the
+ * caller falls back to the eJSON parser. The values made are the same as
+ * the ones made by the eJSON parser; e.g., the escape sequences except
+ * `\"`, `\\`, and `\/` are kept verbatim in the strings.
+ */
+
+#include "config.h"
+
+#include "private/instance.h"
+#include "private/errors.h"
+#include "private/ejson.h"
+#include "private/variant.h"
+#include "private/utils.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* the longest number converted by strtod() */
+#define MAX_NUMBER_LEN          63
+
+/* the longest integer which can be converted to double exactly */
+#define MAX_EXACT_DIGITS        15
+
+struct plain_parser {
+    const char     *cur;
+    const char     *end;
+
+    uint32_t        max_depth;
+    uint32_t        depth;
+    uint32_t        flags;
+
+    /* the buffer for the strings with escape sequences to translate */
+    char           *buf;
+    size_t          sz_buf;
+    size_t          len_buf;
+};
+
+static purc_variant_t
+parse_value(struct plain_parser *pp);
+
+/* the whitespace characters which both JSON and eJSON accept */
+static inline bool
+is_json_whitespace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\t';
+}
+
+static inline void
+skip_whitespaces(struct plain_parser *pp)
+{
+    while (pp->cur < pp->end && is_json_whitespace(*pp->cur))
+        pp->cur++;
+}
+
+/* a scalar must be followed by a delimiter */
+static inline bool
+at_delimiter(struct plain_parser *pp)
+{
+    if (pp->cur == pp->end)
+        return true;
+
+    char c = *pp->cur;
+    return is_json_whitespace(c) || c == ',' || c == ']' || c == '}' ||
+        c == 0;
+}
+
+#define HAS_ZERO_BYTE(v)    \
+    (((v) - 0x0101010101010101ULL) & ~(v) & 0x8080808080808080ULL)
+#define BYTES_OF(c)         (0x0101010101010101ULL * (uint8_t)(c))
+
+/*
+ * Returns the length of the run of bytes in a string which need no
+ * attention: not a quote, a backslash, a dollar sign, a null byte,
+ * or a byte of a non-ASCII character.
+ */
+static size_t
+plain_run_length(const char *p, size_t len)
+{
+    size_t n = 0;
+
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i dollar = _mm_set1_epi8('$');
+    const __m128i zero = _mm_setzero_si128();
+
+    while (n + 16 <= len) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(p + n));
+        __m128i special = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                    _mm_cmpeq_epi8(chunk, backslash)),
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, dollar),
+                    _mm_cmpeq_epi8(chunk, zero)));
+        int mask = _mm_movemask_epi8(special) | _mm_movemask_epi8(chunk);
+        if (mask) {
+            return n + __builtin_ctz(mask);
+        }
+        n += 16;
+    }
+#else
+    while (n + sizeof(uint64_t) <= len) {
+        uint64_t word;
+        memcpy(&word, p + n, sizeof(word));
+        if ((word & 0x8080808080808080ULL) || HAS_ZERO_BYTE(word) ||
+                HAS_ZERO_BYTE(word ^ BYTES_OF('"')) ||
+                HAS_ZERO_BYTE(word ^ BYTES_OF('\\')) ||
+                HAS_ZERO_BYTE(word ^ BYTES_OF('$'))) {
+            break;
+        }
+        n += sizeof(uint64_t);
+    }
+#endif
+
+    while (n < len) {
+        unsigned char c = p[n];
+        if (c == '"' || c == '\\' || c == '$' || c == 0 || c >= 0x80)
+            break;
+        n++;
+    }
+    return n;
+}
+
+static bool
+append_to_buf(struct plain_parser *pp, const char *bytes, size_t len)
+{
+    if (pp->len_buf + len + 1 > pp->sz_buf) {
+        size_t sz = pp->sz_buf ? pp->sz_buf : 64;
+        while (sz < pp->len_buf + len + 1)
+            sz *= 2;
+
+        char *buf = realloc(pp->buf, sz);
+        if (buf == NULL)
+            return false;
+        pp->buf = buf;
+        pp->sz_buf = sz;
+    }
+
+    memcpy(pp->buf + pp->len_buf, bytes, len);
+    pp->len_buf += len;
+    pp->buf[pp->len_buf] = 0;
+    return true;
+}
+
+/*
+ * The eJSON tokenizer only decodes the characters in two or three bytes;
+ * leave the others to it for the same result.
+ */
+static bool
+check_non_ascii(const char *p, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        if ((unsigned char)p[i] >= 0xF0)
+            return false;
+    }
+
+    return pcutils_string_check_utf8_len(p, len, NULL, NULL);
+}
+
+/*
+ * Finds the end of the string after the opening quote. On success, the
+ * contents of the string are either in the text (the returned pointer)
+ * or in the buffer of the parser if some escape sequences are translated.
+ */
+static const char *
+scan_string(struct plain_parser *pp, size_t *len)
+{
+    const char *start = pp->cur;
+    const char *seg = start;
+    bool translated = false;
+    bool non_ascii = false;
+
+    pp->len_buf = 0;
+    for (;;) {
+        pp->cur += plain_run_length(pp->cur, pp->end - pp->cur);
+        if (pp->cur == pp->end)
+            return NULL;
+
+        unsigned char c = *pp->cur;
+        if (c == '"')
+            break;
+
+        if (c >= 0x80) {
+            non_ascii = true;
+            do {
+                pp->cur++;
+            } while (pp->cur < pp->end && (unsigned char)*pp->cur >= 0x80);
+            continue;
+        }
+
+        if (c != '\\' || pp->cur + 1 == pp->end)
+            return NULL;
+
+        char e = pp->cur[1];
+        switch (e) {
+        case 'b':
+        case 'f':
+        case 'n':
+        case 'r':
+        case 't':
+            pp->cur += 2;
+            break;
+
+        case 'u':
+            if (pp->end - pp->cur < 6)
+                return NULL;
+            for (int i = 2; i < 6; i++) {
+                if (!purc_isxdigit(pp->cur[i]))
+                    return NULL;
+            }
+            pp->cur += 6;
+            break;
+
+        case '"':
+        case '\\':
+        case '/':
+            if (!append_to_buf(pp, seg, pp->cur - seg) ||
+                    !append_to_buf(pp, &e, 1))
+                return NULL;
+            pp->cur += 2;
+            seg = pp->cur;
+            translated = true;
+            break;
+
+        default:
+            return NULL;
+        }
+    }
+
+    if (non_ascii && !check_non_ascii(start, pp->cur - start))
+        return NULL;
+
+    const char *str = start;
+    *len = pp->cur - start;
+    if (translated) {
+        if (!append_to_buf(pp, seg, pp->cur - seg))
+            return NULL;
+        str = pp->buf;
+        *len = pp->len_buf;
+    }
+
+    pp->cur++;      /* skip the closing quote */
+    return str;
+}
+
+static purc_variant_t
+parse_string(struct plain_parser *pp)
+{
+    size_t len;
+    const char *str = scan_string(pp, &len);
+    if (str == NULL || !at_delimiter(pp))
+        return PURC_VARIANT_INVALID;
+
+    return purc_variant_make_string_ex(str, len, false);
+}
+
+static purc_variant_t
+parse_key(struct plain_parser *pp)
+{
+    size_t len;
+    const char *str = scan_string(pp, &len);
+    if (str == NULL)
+        return PURC_VARIANT_INVALID;
+
+    if (pp->flags & PCEJSON_FLAG_INTERN_KEYS) {
+        if (str != pp->buf) {
+            pp->len_buf = 0;
+            if (!append_to_buf(pp, str, len))
+                return PURC_VARIANT_INVALID;
+        }
+        return pcvariant_make_object_key(pp->buf);
+    }
+
+    return purc_variant_make_string_ex(str, len, false);
+}
+
+static size_t
+count_digits(struct plain_parser *pp)
+{
+    const char *p = pp->cur;
+    while (pp->cur < pp->end && purc_isdigit(*pp->cur))
+        pp->cur++;
+    return pp->cur - p;
+}
+
+static purc_variant_t
+parse_number(struct plain_parser *pp)
+{
+    const char *start = pp->cur;
+    bool negative = false;
+
+    if (*pp->cur == '-') {
+        negative = true;
+        pp->cur++;
+    }
+
+    size_t nr_digits = count_digits(pp);
+    if (nr_digits == 0 || (nr_digits > 1 && pp->cur[-nr_digits] == '0'))
+        return PURC_VARIANT_INVALID;
+
+    bool integer = true;
+    if (pp->cur < pp->end && *pp->cur == '.') {
+        pp->cur++;
+        if (count_digits(pp) == 0)
+            return PURC_VARIANT_INVALID;
+        integer = false;
+    }
+
+    if (pp->cur < pp->end && (*pp->cur == 'e' || *pp->cur == 'E')) {
+        pp->cur++;
+        if (pp->cur < pp->end && (*pp->cur == '+' || *pp->cur == '-'))
+            pp->cur++;
+        if (count_digits(pp) == 0)
+            return PURC_VARIANT_INVALID;
+        integer = false;
+    }
+
+    if (!at_delimiter(pp))
+        return PURC_VARIANT_INVALID;
+
+    if (integer && nr_digits <= MAX_EXACT_DIGITS) {
+        uint64_t u = 0;
+        for (const char *p = pp->cur - nr_digits; p < pp->cur; p++)
+            u = u * 10 + (*p - '0');
+
+        double d = (double)u;
+        return purc_variant_make_number(negative ? -d : d);
+    }
+
+    size_t len = pp->cur - start;
+    if (len > MAX_NUMBER_LEN)
+        return PURC_VARIANT_INVALID;
+
+    char buf[MAX_NUMBER_LEN + 1];
+    memcpy(buf, start, len);
+    buf[len] = 0;
+    return purc_variant_make_number(pcutils_strtod(buf, NULL));
+}
+
+static bool
+match_keyword(struct plain_parser *pp, const char *keyword, size_t len)
+{
+    if ((size_t)(pp->end - pp->cur) < len ||
+            memcmp(pp->cur, keyword, len) != 0)
+        return false;
+
+    pp->cur += len;
+    return at_delimiter(pp);
+}
+
+static bool
+enter_container(struct plain_parser *pp)
+{
+    if (pp->depth >= pp->max_depth)
+        return false;
+
+    pp->depth++;
+    skip_whitespaces(pp);
+    return pp->cur < pp->end;
+}
+
+static purc_variant_t
+parse_object(struct plain_parser *pp)
+{
+    if (!enter_container(pp))
+        return PURC_VARIANT_INVALID;
+
+    purc_variant_t object = purc_variant_make_object(0,
+            PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+    if (object == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    if (*pp->cur == '}') {
+        pp->cur++;
+        goto done;
+    }
+
+    for (;;) {
+        if (*pp->cur != '"')
+            goto failed;
+        pp->cur++;
+
+        purc_variant_t key = parse_key(pp);
+        if (key == PURC_VARIANT_INVALID)
+            goto failed;
+
+        skip_whitespaces(pp);
+        if (pp->cur == pp->end || *pp->cur != ':') {
+            purc_variant_unref(key);
+            goto failed;
+        }
+        pp->cur++;
+
+        skip_whitespaces(pp);
+        purc_variant_t value = parse_value(pp);
+        if (value == PURC_VARIANT_INVALID) {
+            purc_variant_unref(key);
+            goto failed;
+        }
+
+        bool ok = purc_variant_object_set(object, key, value);
+        purc_variant_unref(key);
+        purc_variant_unref(value);
+        if (!ok)
+            goto failed;
+
+        skip_whitespaces(pp);
+        if (pp->cur == pp->end)
+            goto failed;
+        if (*pp->cur == '}') {
+            pp->cur++;
+            break;
+        }
+        if (*pp->cur != ',')
+            goto failed;
+        pp->cur++;
+
+        skip_whitespaces(pp);
+        if (pp->cur == pp->end)
+            goto failed;
+    }
+
+done:
+    pp->depth--;
+    if (!at_delimiter(pp))
+        goto failed;
+    return object;
+
+failed:
+    purc_variant_unref(object);
+    return PURC_VARIANT_INVALID;
+}
+
+static purc_variant_t
+parse_array(struct plain_parser *pp)
+{
+    if (!enter_container(pp))
+        return PURC_VARIANT_INVALID;
+
+    purc_variant_t array = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    if (array == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    if (*pp->cur == ']') {
+        pp->cur++;
+        goto done;
+    }
+
+    for (;;) {
+        purc_variant_t member = parse_value(pp);
+        if (member == PURC_VARIANT_INVALID)
+            goto failed;
+
+        bool ok = purc_variant_array_append(array, member);
+        purc_variant_unref(member);
+        if (!ok)
+            goto failed;
+
+        skip_whitespaces(pp);
+        if (pp->cur == pp->end)
+            goto failed;
+        if (*pp->cur == ']') {
+            pp->cur++;
+            break;
+        }
+        if (*pp->cur != ',')
+            goto failed;
+        pp->cur++;
+
+        skip_whitespaces(pp);
+        if (pp->cur == pp->end)
+            goto failed;
+    }
+
+done:
+    pp->depth--;
+    if (!at_delimiter(pp))
+        goto failed;
+    if (pp->flags & PCEJSON_FLAG_COMPACT_ARRAYS)
+        pcvariant_array_compact(array);
+    return array;
+
+failed:
+    purc_variant_unref(array);
+    return PURC_VARIANT_INVALID;
+}
+
+/* parses the value at the cursor, which is not at the end */
+static purc_variant_t
+parse_value(struct plain_parser *pp)
+{
+    if (pp->cur == pp->end)
+        return PURC_VARIANT_INVALID;
+
+    switch (*pp->cur) {
+    case '{':
+        pp->cur++;
+        return parse_object(pp);
+
+    case '[':
+        pp->cur++;
+        return parse_array(pp);
+
+    case '"':
+        pp->cur++;
+        return parse_string(pp);
+
+    case 't':
+        if (match_keyword(pp, "true", 4))
+            return purc_variant_make_boolean(true);
+        break;
+
+    case 'f':
+        if (match_keyword(pp, "false", 5))
+            return purc_variant_make_boolean(false);
+        break;
+
+    case 'n':
+        if (match_keyword(pp, "null", 4))
+            return purc_variant_make_null();
+        break;
+
+    case '-':
+        return parse_number(pp);
+    }
+
+    if (purc_isdigit(*pp->cur))
+        return parse_number(pp);
+    return PURC_VARIANT_INVALID;
+}
+
+int
+pcejson_parse_plain(purc_variant_t *value, const char *json, size_t len,
+        uint32_t depth, uint32_t flags)
+{
+    struct plain_parser pp = {
+        .cur = json,
+        .end = json + len,
+        .max_depth = depth > 0 ? depth : PCEJSON_DEFAULT_DEPTH,
+        .flags = flags,
+    };
+
+    *value = PURC_VARIANT_INVALID;
+
+    /* skip the UTF-8 BOM */
+    if (len >= 3 && memcmp(json, "\xEF\xBB\xBF", 3) == 0)
+        pp.cur += 3;
+
+    skip_whitespaces(&pp);
+    purc_variant_t v = parse_value(&pp);
+    if (v != PURC_VARIANT_INVALID) {
+        skip_whitespaces(&pp);
+        /* the eJSON tokenizer takes a null byte as the end of the text */
+        if (pp.cur < pp.end && *pp.cur != 0) {
+            purc_variant_unref(v);
+            v = PURC_VARIANT_INVALID;
+        }
+    }
+
+    free(pp.buf);
+    if (v == PURC_VARIANT_INVALID)
+        return -1;
+
+    *value = v;
+    return 0;
+}
+
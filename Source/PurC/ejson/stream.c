@@ -0,0 +1,778 @@
+/*
+ * @file stream.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The streaming parser for static eJSON.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This parser builds the variants directly while reading the characters,
+ * without the intermediate VCM tree made by pcejson_parse(). It only
+ * accepts static eJSON; the values it makes are the same as the ones
+ * evaluated from the VCM tree of the same text, including the escape
+ * sequences kept verbatim in the strings.
+ *
+ * Any dynamic expression (`$` in a value, a name, or a double-quoted
+ * string) makes it fail with PURC_ERROR_NOT_SUPPORTED. It also refuses
+ * some loose syntax which pcejson_parse() tolerates (unquoted strings,
+ * trailing commas, an unterminated number suffix, and so on), so the
+ * caller which can re-read the input should fall back to pcejson_parse()
+ * on any failure.
+ */
+
+#include "config.h"
+
+#include "private/instance.h"
+#include "private/errors.h"
+#include "private/ejson.h"
+#include "private/variant.h"
+#include "private/utils.h"
+#include "private/tkz-helper.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct ejson_stream {
+    struct tkz_reader  *reader;
+    struct tkz_buffer  *buffer;
+
+    uint32_t            max_depth;
+    uint32_t            depth;
+    uint32_t            flags;
+    int                 error;
+
+    /* the member callback asked to stop */
+    bool                stopped;
+};
+
+#define SET_ERR(s, err)     do {            \
+        if ((s)->error == PURC_ERROR_OK)    \
+            (s)->error = err;               \
+    } while (0)
+
+static purc_variant_t
+parse_value(struct ejson_stream *s, uint32_t c);
+
+static uint32_t
+next_char(struct ejson_stream *s)
+{
+    struct tkz_uc *uc = tkz_reader_next_char(s->reader);
+    if (uc == NULL) {
+        SET_ERR(s, PURC_ERROR_OUT_OF_MEMORY);
+        return TKZ_INVALID_CHARACTER;
+    }
+
+    if (uc->character == TKZ_INVALID_CHARACTER)
+        SET_ERR(s, PURC_ERROR_BAD_ENCODING);
+    return uc->character;
+}
+
+static uint32_t
+next_significant_char(struct ejson_stream *s)
+{
+    uint32_t c;
+    do {
+        c = next_char(s);
+    } while (is_whitespace(c));
+
+    return c;
+}
+
+static bool
+append_escaped_char(struct ejson_stream *s)
+{
+    uint32_t c = next_char(s);
+
+    switch (c) {
+    case 'b':
+    case 'f':
+    case 'n':
+    case 'r':
+    case 't':
+        tkz_buffer_append(s->buffer, '\\');
+        tkz_buffer_append(s->buffer, c);
+        return true;
+
+    case '$':
+    case '{':
+    case '}':
+    case '<':
+    case '>':
+    case '/':
+    case '\\':
+    case '"':
+        tkz_buffer_append(s->buffer, c);
+        return true;
+
+    case 'u':
+        tkz_buffer_append_bytes(s->buffer, "\\u", 2);
+        for (int i = 0; i < 4; i++) {
+            c = next_char(s);
+            if (!is_ascii_hex_digit(c))
+                goto failed;
+            tkz_buffer_append(s->buffer, c);
+        }
+        return true;
+    }
+
+failed:
+    SET_ERR(s, PCEJSON_ERROR_BAD_JSON_STRING_ESCAPE_ENTITY);
+    return false;
+}
+
+/* reads the characters till the closing quote into the buffer */
+static bool
+read_quoted(struct ejson_stream *s, uint32_t quote)
+{
+    tkz_buffer_reset(s->buffer);
+
+    for (;;) {
+        uint32_t c = next_char(s);
+
+        if (c == quote)
+            return true;
+
+        if (c == '\\') {
+            if (!append_escaped_char(s))
+                return false;
+            continue;
+        }
+
+        if (is_eof(c)) {
+            SET_ERR(s, PCEJSON_ERROR_UNEXPECTED_EOF);
+            return false;
+        }
+        if (c == TKZ_INVALID_CHARACTER)
+            return false;
+        if (c == '$' && quote == '"') {
+            SET_ERR(s, PURC_ERROR_NOT_SUPPORTED);
+            return false;
+        }
+
+        tkz_buffer_append(s->buffer, c);
+    }
+}
+
+/* reads the raw characters of a triple-quoted string into the buffer */
+static bool
+read_triple_quoted(struct ejson_stream *s)
+{
+    tkz_buffer_reset(s->buffer);
+
+    for (;;) {
+        uint32_t c = next_char(s);
+
+        if (is_eof(c)) {
+            SET_ERR(s, PCEJSON_ERROR_UNEXPECTED_EOF);
+            return false;
+        }
+        if (c == TKZ_INVALID_CHARACTER)
+            return false;
+
+        tkz_buffer_append(s->buffer, c);
+        if (c == '"' && tkz_buffer_end_with(s->buffer, "\"\"\"", 3)) {
+            tkz_buffer_delete_tail_chars(s->buffer, 3);
+            return true;
+        }
+    }
+}
+
+static purc_variant_t
+parse_double_quoted(struct ejson_stream *s)
+{
+    uint32_t c = next_char(s);
+    if (c == '"') {
+        c = next_char(s);
+        if (c == '"') {
+            if (!read_triple_quoted(s))
+                return PURC_VARIANT_INVALID;
+            goto done;
+        }
+
+        tkz_reader_reconsume_last_char(s->reader);
+        return purc_variant_make_string("", false);
+    }
+
+    tkz_reader_reconsume_last_char(s->reader);
+    if (!read_quoted(s, '"'))
+        return PURC_VARIANT_INVALID;
+
+done:
+    return purc_variant_make_string(tkz_buffer_get_bytes(s->buffer), false);
+}
+
+/* reads a run of the characters which may make up a bare token */
+static void
+read_token(struct ejson_stream *s, uint32_t c)
+{
+    tkz_buffer_reset(s->buffer);
+
+    do {
+        tkz_buffer_append(s->buffer, c);
+        c = next_char(s);
+    } while (is_ascii_alpha_numeric(c) || c == '.' || c == '+' ||
+            c == '-' || c == '/' || c == '=' || c == '_');
+
+    tkz_reader_reconsume_last_char(s->reader);
+}
+
+static size_t
+skip_digits(const char *p)
+{
+    size_t n = 0;
+    while (is_ascii_digit(p[n]))
+        n++;
+    return n;
+}
+
+static purc_variant_t
+make_number(struct ejson_stream *s, const char *token)
+{
+    const char *p = token + (token[0] == '-' ? 1 : 0);
+
+    if (strcmp(p, "Infinity") == 0)
+        return purc_variant_make_number(p == token ? INFINITY : -INFINITY);
+    if (strcmp(token, "NaN") == 0)
+        return purc_variant_make_number(NAN);
+
+    if (p == token && p[0] == '0' && p[1] == 'x') {
+        p += 2;
+        size_t n = 0;
+        while (is_ascii_hex_digit(p[n]))
+            n++;
+        if (n == 0)
+            goto failed;
+
+        if (strcmp(p + n, "U") == 0 || strcmp(p + n, "UL") == 0)
+            return purc_variant_make_ulongint(strtoull(p, NULL, 16));
+        if (p[n] == 0 || strcmp(p + n, "L") == 0)
+            return purc_variant_make_longint(strtoll(p, NULL, 16));
+        goto failed;
+    }
+
+    size_t n = skip_digits(p);
+    if (n == 0)
+        goto failed;
+    p += n;
+
+    if (strcmp(p, "L") == 0)
+        return purc_variant_make_longint(strtoll(token, NULL, 10));
+    if (strcmp(p, "UL") == 0)
+        return purc_variant_make_ulongint(strtoull(token, NULL, 10));
+
+    if (*p == '.') {
+        n = skip_digits(++p);
+        if (n == 0)
+            goto failed;
+        p += n;
+    }
+
+    if (*p == 'e' || *p == 'E') {
+        p++;
+        if (*p == '+' || *p == '-')
+            p++;
+        n = skip_digits(p);
+        if (n == 0)
+            goto failed;
+        p += n;
+    }
+
+    if (*p == 0)
+        return purc_variant_make_number(pcutils_strtod(token, NULL));
+    if (strcmp(p, "FL") == 0)
+        return purc_variant_make_longdouble(strtold(token, NULL));
+
+failed:
+    SET_ERR(s, PCEJSON_ERROR_BAD_JSON_NUMBER);
+    return PURC_VARIANT_INVALID;
+}
+
+static purc_variant_t
+make_keyword(struct ejson_stream *s, const char *token)
+{
+    if (strcmp(token, "true") == 0)
+        return purc_variant_make_boolean(true);
+    if (strcmp(token, "false") == 0)
+        return purc_variant_make_boolean(false);
+    if (strcmp(token, "null") == 0)
+        return purc_variant_make_null();
+    if (strcmp(token, "undefined") == 0)
+        return purc_variant_make_undefined();
+
+    SET_ERR(s, PCEJSON_ERROR_UNEXPECTED_JSON_KEYWORD);
+    return PURC_VARIANT_INVALID;
+}
+
+static int
+hex_value(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    return (c | 0x20) - 'a' + 10;
+}
+
+static purc_variant_t
+make_byte_sequence(struct ejson_stream *s, const char *token, size_t len)
+{
+    purc_variant_t v = PURC_VARIANT_INVALID;
+    uint8_t *bytes = NULL;
+    size_t nr_bytes = 0;
+
+    if (strncmp(token, "bx", 2) == 0) {
+        const char *p = token + 2;
+        size_t n = len - 2;
+        if (n == 0 || n % 2)
+            goto failed;
+
+        bytes = malloc(n / 2);
+        if (bytes == NULL)
+            goto oom;
+        for (size_t i = 0; i < n; i += 2) {
+            if (!is_ascii_hex_digit(p[i]) || !is_ascii_hex_digit(p[i + 1]))
+                goto failed;
+            bytes[nr_bytes++] = (hex_value(p[i]) << 4) | hex_value(p[i + 1]);
+        }
+    }
+    else if (strncmp(token, "bb", 2) == 0) {
+        size_t nr_bits = 0;
+        for (const char *p = token + 2; *p; p++) {
+            if (*p == '0' || *p == '1')
+                nr_bits++;
+            else if (*p != '.')
+                goto failed;
+        }
+        if (nr_bits == 0 || nr_bits % 8)
+            goto failed;
+
+        bytes = calloc(nr_bits / 8, 1);
+        if (bytes == NULL)
+            goto oom;
+        for (const char *p = token + 2; *p; p++) {
+            if (*p == '.')
+                continue;
+            bytes[nr_bytes / 8] |= (*p - '0') << (7 - nr_bytes % 8);
+            nr_bytes++;
+        }
+        nr_bytes /= 8;
+    }
+    else if (strncmp(token, "b64", 3) == 0) {
+        const char *p = token + 3;
+        size_t n = len - 3;
+        if (n == 0)
+            goto failed;
+
+        bytes = malloc(n);
+        if (bytes == NULL)
+            goto oom;
+        ssize_t ret = pcutils_b64_decode(p, bytes, n);
+        if (ret <= 0) {
+            SET_ERR(s, PCEJSON_ERROR_UNEXPECTED_BASE64);
+            goto done;
+        }
+        nr_bytes = ret;
+    }
+    else {
+        goto failed;
+    }
+
+    v = purc_variant_make_byte_sequence(bytes, nr_bytes);
+    goto done;
+
+oom:
+    SET_ERR(s, PURC_ERROR_OUT_OF_MEMORY);
+    goto done;
+
+failed:
+    SET_ERR(s, PCEJSON_ERROR_UNEXPECTED_CHARACTER);
+
+done:
+    free(bytes);
+    return v;
+}
+
+/* reads the name of a member into the buffer */
+static bool
+read_name(struct ejson_stream *s, uint32_t c)
+{
+    if (c == '"') {
+        c = next_char(s);
+        if (c == '"') {
+            tkz_buffer_reset(s->buffer);
+            return true;
+        }
+        tkz_reader_reconsume_last_char(s->reader);
+        return read_quoted(s, '"');
+    }
+
+    if (c == '\'') {
+        if (!read_quoted(s, '\''))
+            return false;
+        if (tkz_buffer_is_empty(s->buffer))
+            goto failed;
+        return true;
+    }
+
+    if (is_ascii_alpha(c) || c == '_') {
+        tkz_buffer_reset(s->buffer);
+        do {
+            tkz_buffer_append(s->buffer, c);
+            c = next_char(s);
+        } while (is_ascii_alpha_numeric(c) || c == '-' || c == '_');
+
+        if (c == '$') {
+            SET_ERR(s, PURC_ERROR_NOT_SUPPORTED);
+            return false;
+        }
+        tkz_reader_reconsume_last_char(s->reader);
+        return true;
+    }
+
+    if (c == '$') {
+        SET_ERR(s, PURC_ERROR_NOT_SUPPORTED);
+        return false;
+    }
+
+failed:
+    SET_ERR(s, PCEJSON_ERROR_UNEXPECTED_JSON_KEY_NAME);
+    return false;
+}
+
+static bool
+enter_container(struct ejson_stream *s)
+{
+    if (s->depth >= s->max_depth) {
+        SET_ERR(s, PCEJSON_ERROR_MAX_DEPTH_EXCEEDED);
+        return false;
+    }
+
+    s->depth++;
+    return true;
+}
+
+static purc_variant_t
+parse_object(struct ejson_stream *s)
+{
+    if (!enter_container(s))
+        return PURC_VARIANT_INVALID;
+
+    purc_variant_t object = purc_variant_make_object(0,
+            PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+    if (object == PURC_VARIANT_INVALID)
+        goto failed;
+
+    uint32_t c = next_significant_char(s);
+    if (c == '}')
+        goto done;
+
+    for (;;) {
+        if (!read_name(s, c))
+            goto failed;
+
+        purc_variant_t key;
+        if (s->flags & PCEJSON_FLAG_INTERN_KEYS)
+            key = pcvariant_make_object_key(tkz_buffer_get_bytes(s->buffer));
+        else
+            key = purc_variant_make_string(tkz_buffer_get_bytes(s->buffer),
+                    false);
+        if (key == PURC_VARIANT_INVALID)
+            goto failed;
+
+        c = next_significant_char(s);
+        if (c != ':') {
+            purc_variant_unref(key);
+            SET_ERR(s, PCEJSON_ERROR_UNEXPECTED_CHARACTER);
+            goto failed;
+        }
+
+        purc_variant_t value = parse_value(s, next_significant_char(s));
+        if (value == PURC_VARIANT_INVALID) {
+            purc_variant_unref(key);
+            goto failed;
+        }
+
+        bool ok = purc_variant_object_set(object, key, value);
+        purc_variant_unref(key);
+        purc_variant_unref(value);
+        if (!ok)
+            goto failed;
+
+        c = next_significant_char(s);
+        if (c == '}')
+            break;
+        if (c != ',') {
+            SET_ERR(s, is_eof(c) ? PCEJSON_ERROR_UNEXPECTED_EOF :
+                    PCEJSON_ERROR_UNEXPECTED_CHARACTER);
+            goto failed;
+        }
+
+        c = next_significant_char(s);
+        if (c == '}' || c == ',') {
+            SET_ERR(s, PCEJSON_ERROR_UNEXPECTED_COMMA);
+            goto failed;
+        }
+    }
+
+done:
+    s->depth--;
+    return object;
+
+failed:
+    if (object)
+        purc_variant_unref(object);
+    s->depth--;
+    return PURC_VARIANT_INVALID;
+}
+
+/*
+ * Parses the members of an array after the left bracket; calls
+ * on_member for every member if it is not NULL, otherwise appends
+ * the members to the array.
+ */
+static bool
+parse_members(struct ejson_stream *s, purc_variant_t array,
+        pcejson_member_cb on_member, void *ctxt)
+{
+    uint32_t c = next_significant_char(s);
+    if (c == ']')
+        return true;
+
+    for (;;) {
+        purc_variant_t member = parse_value(s, c);
+        if (member == PURC_VARIANT_INVALID)
+            return false;
+
+        bool ok;
+        if (on_member) {
+            /* stopping by callback is not an error */
+            if (!on_member(ctxt, member)) {
+                purc_variant_unref(member);
+                s->stopped = true;
+                return true;
+            }
+            ok = true;
+        }
+        else {
+            ok = purc_variant_array_append(array, member);
+        }
+        purc_variant_unref(member);
+        if (!ok)
+            return false;
+
+        c = next_significant_char(s);
+        if (c == ']')
+            return true;
+        if (c != ',') {
+            SET_ERR(s, is_eof(c) ? PCEJSON_ERROR_UNEXPECTED_EOF :
+                    PCEJSON_ERROR_UNEXPECTED_CHARACTER);
+            return false;
+        }
+
+        c = next_significant_char(s);
+        if (c == ']' || c == ',') {
+            SET_ERR(s, PCEJSON_ERROR_UNEXPECTED_COMMA);
+            return false;
+        }
+    }
+}
+
+static purc_variant_t
+parse_array(struct ejson_stream *s)
+{
+    if (!enter_container(s))
+        return PURC_VARIANT_INVALID;
+
+    purc_variant_t array = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    if (array != PURC_VARIANT_INVALID && !parse_members(s, array, NULL, NULL)) {
+        purc_variant_unref(array);
+        array = PURC_VARIANT_INVALID;
+    }
+    else if (array != PURC_VARIANT_INVALID &&
+            (s->flags & PCEJSON_FLAG_COMPACT_ARRAYS)) {
+        pcvariant_array_compact(array);
+    }
+
+    s->depth--;
+    return array;
+}
+
+static purc_variant_t
+parse_value(struct ejson_stream *s, uint32_t c)
+{
+    switch (c) {
+    case '{':
+        return parse_object(s);
+
+    case '[':
+        return parse_array(s);
+
+    case '"':
+        return parse_double_quoted(s);
+
+    case '\'':
+        if (!read_quoted(s, '\''))
+            return PURC_VARIANT_INVALID;
+        return purc_variant_make_string(tkz_buffer_get_bytes(s->buffer),
+                false);
+
+    case 'b':
+        read_token(s, c);
+        return make_byte_sequence(s, tkz_buffer_get_bytes(s->buffer),
+                tkz_buffer_get_size_in_bytes(s->buffer));
+
+    case 't':
+    case 'f':
+    case 'n':
+    case 'u':
+        read_token(s, c);
+        return make_keyword(s, tkz_buffer_get_bytes(s->buffer));
+
+    case '-':
+    case 'I':
+    case 'N':
+        read_token(s, c);
+        return make_number(s, tkz_buffer_get_bytes(s->buffer));
+
+    case '$':
+        SET_ERR(s, PURC_ERROR_NOT_SUPPORTED);
+        return PURC_VARIANT_INVALID;
+
+    case TKZ_END_OF_FILE:
+        SET_ERR(s, PCEJSON_ERROR_UNEXPECTED_EOF);
+        return PURC_VARIANT_INVALID;
+    }
+
+    if (is_ascii_digit(c)) {
+        read_token(s, c);
+        return make_number(s, tkz_buffer_get_bytes(s->buffer));
+    }
+
+    SET_ERR(s, PCEJSON_ERROR_UNEXPECTED_CHARACTER);
+    return PURC_VARIANT_INVALID;
+}
+
+static bool
+stream_init(struct ejson_stream *s, purc_rwstream_t rws, uint32_t depth,
+        uint32_t flags)
+{
+    memset(s, 0, sizeof(*s));
+    s->max_depth = depth > 0 ? depth : PCEJSON_DEFAULT_DEPTH;
+    s->flags = flags;
+
+    s->reader = tkz_reader_new();
+    s->buffer = tkz_buffer_new();
+    if (s->reader == NULL || s->buffer == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return false;
+    }
+
+    tkz_reader_set_rwstream(s->reader, rws);
+    return true;
+}
+
+static int
+stream_finish(struct ejson_stream *s)
+{
+    if (s->reader)
+        tkz_reader_destroy(s->reader);
+    if (s->buffer)
+        tkz_buffer_destroy(s->buffer);
+
+    if (s->error != PURC_ERROR_OK) {
+        pcinst_set_error(s->error);
+        return -1;
+    }
+
+    return 0;
+}
+
+static uint32_t
+first_significant_char(struct ejson_stream *s)
+{
+    uint32_t c;
+    do {
+        c = next_char(s);
+    } while (is_whitespace(c) || c == 0xFEFF);
+
+    return c;
+}
+
+static void
+check_trailing_chars(struct ejson_stream *s)
+{
+    uint32_t c = next_significant_char(s);
+    if (!is_eof(c))
+        SET_ERR(s, PCEJSON_ERROR_UNEXPECTED_CHARACTER);
+}
+
+int
+pcejson_parse_static(purc_variant_t *value, purc_rwstream_t rws,
+        uint32_t depth, uint32_t flags)
+{
+    struct ejson_stream s;
+
+    *value = PURC_VARIANT_INVALID;
+    if (!stream_init(&s, rws, depth, flags)) {
+        stream_finish(&s);
+        return -1;
+    }
+
+    purc_variant_t v = parse_value(&s, first_significant_char(&s));
+    if (v != PURC_VARIANT_INVALID)
+        check_trailing_chars(&s);
+    else
+        SET_ERR(&s, PURC_ERROR_OUT_OF_MEMORY);
+
+    if (stream_finish(&s)) {
+        if (v)
+            purc_variant_unref(v);
+        return -1;
+    }
+
+    *value = v;
+    return 0;
+}
+
+int
+pcejson_parse_static_members(purc_rwstream_t rws, uint32_t depth,
+        uint32_t flags, pcejson_member_cb on_member, void *ctxt)
+{
+    struct ejson_stream s;
+
+    if (!stream_init(&s, rws, depth, flags)) {
+        stream_finish(&s);
+        return -1;
+    }
+
+    uint32_t c = first_significant_char(&s);
+    if (c != '[') {
+        SET_ERR(&s, is_eof(c) ? PCEJSON_ERROR_UNEXPECTED_EOF :
+                PCEJSON_ERROR_UNEXPECTED_CHARACTER);
+    }
+    else if (enter_container(&s)) {
+        if (!parse_members(&s, PURC_VARIANT_INVALID, on_member, ctxt))
+            SET_ERR(&s, PURC_ERROR_OUT_OF_MEMORY);
+        else if (!s.stopped)
+            check_trailing_chars(&s);
+    }
+
+    return stream_finish(&s);
+}
+
@@ -31,6 +31,7 @@
 #include "purc-utils.h"
 #include "purc-errors.h"
 #include "private/errors.h"
+#include "private/utils.h"
 #include "private/tkz-helper.h"
 
 #if HAVE(GLIB)
@@ -39,9 +40,18 @@
 #include <stdlib.h>
 #endif
 
-#define NR_CONSUMED_LIST_LIMIT   10
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* the size of the ring of the consumed characters; must be a power of 2 */
+#define NR_CONSUMED_RING         16
 #define MIN_BUFFER_CAPACITY      32
 
+/* the sizes of the blocks read from the stream */
+#define MIN_READ_BLOCK           1024
+#define MAX_READ_BLOCK           (64 * 1024)
+
 #if HAVE(GLIB)
 #define    PCHVML_ALLOC(sz)   g_slice_alloc0(sz)
 #define    PCHVML_FREE(p)     g_slice_free1(sizeof(*p), (gpointer)p)
@@ -50,11 +60,38 @@
 #define    PCHVML_FREE(p)     free(p)
 #endif
 
+/*
+ * The characters are decoded from the blocks read from the stream; the
+ * size of the block doubles on every read up to MAX_READ_BLOCK, so a short
+ * stream does not cost a large buffer. The length of the run of ASCII
+ * characters at the read position is found in bulk, and these characters
+ * are returned without decoding.
+ *
+ * The last consumed characters are kept in a ring. Reconsuming a character
+ * only moves the cursor of the ring back, and the characters after the
+ * cursor are read again before reading from the stream.
+ *
+ * When the input is partial, more data will come in other streams later;
+ * the end of a stream is not the end of the input, and the bytes of an
+ * incomplete character at the end are kept for the next stream.
+ */
+/* no character available in the current stream of a partial input */
+#define TKZ_NO_INPUT            0xFFFFFFFE
+
 struct tkz_reader {
     purc_rwstream_t rws;
-    struct list_head reconsume_list;
-    struct list_head consumed_list;
-    size_t nr_consumed_list;
+    bool partial;
+    bool continued;             /* the next stream ends a partial input */
+    struct tkz_uc ring[NR_CONSUMED_RING];
+    unsigned cursor;            /* the slot for the next character */
+    unsigned nr_consumed;       /* the number of characters before cursor */
+    unsigned nr_reconsume;      /* the number of characters after cursor */
+
+    uint8_t *block;
+    size_t sz_block;
+    size_t nr_bytes;            /* the number of bytes in block */
+    size_t pos;                 /* the read position in block */
+    size_t nr_ascii;            /* the length of ASCII run at pos */
 
     struct tkz_uc curr_uc;
     int line;
@@ -62,17 +99,7 @@ struct tkz_reader {
     int consumed;
 };
 
-struct tkz_uc *tkz_uc_new(void)
-{
-    return PCHVML_ALLOC(sizeof(struct tkz_uc));
-}
-
-void tkz_uc_destroy(struct tkz_uc *uc)
-{
-    if (uc) {
-        PCHVML_FREE(uc);
-    }
-}
+#define RING_SLOT(idx)          ((idx) & (NR_CONSUMED_RING - 1))
 
 struct tkz_reader *tkz_reader_new(void)
 {
@@ -80,8 +107,6 @@ struct tkz_reader *tkz_reader_new(void)
     if (!reader) {
         return NULL;
     }
-    INIT_LIST_HEAD(&reader->reconsume_list);
-    INIT_LIST_HEAD(&reader->consumed_list);
     reader->line = 1;
     reader->column = 0;
     reader->consumed = 0;
@@ -91,17 +116,168 @@ struct tkz_reader *tkz_reader_new(void)
 void tkz_reader_set_rwstream(struct tkz_reader *reader,
         purc_rwstream_t rws)
 {
+    if (reader->rws != rws && !reader->partial && !reader->continued) {
+        /* the bytes read ahead belong to the previous stream */
+        reader->nr_bytes = 0;
+        reader->pos = 0;
+        reader->nr_ascii = 0;
+    }
+    reader->continued = false;
     reader->rws = rws;
 }
 
+void tkz_reader_set_partial_input(struct tkz_reader *reader, bool partial)
+{
+    if (reader->partial && !partial) {
+        reader->continued = true;
+    }
+    reader->partial = partial;
+}
+
+static size_t
+ascii_run_length(const uint8_t *p, size_t len)
+{
+    size_t n = 0;
+
+#if defined(__SSE2__)
+    while (n + 16 <= len) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(p + n));
+        int mask = _mm_movemask_epi8(chunk);
+        if (mask) {
+            return n + __builtin_ctz(mask);
+        }
+        n += 16;
+    }
+#else
+    while (n + sizeof(uint64_t) <= len) {
+        uint64_t word;
+        memcpy(&word, p + n, sizeof(word));
+        if (word & 0x8080808080808080ULL) {
+            break;
+        }
+        n += sizeof(uint64_t);
+    }
+#endif
+
+    while (n < len && p[n] < 0x80) {
+        n++;
+    }
+    return n;
+}
+
+/* make sure there are at least `nr` bytes after pos in block */
+static bool
+tkz_reader_fill_block(struct tkz_reader *reader, size_t nr)
+{
+    size_t left = reader->nr_bytes - reader->pos;
+
+    if (left >= nr) {
+        return true;
+    }
+
+    if (left && reader->pos) {
+        memmove(reader->block, reader->block + reader->pos, left);
+    }
+    reader->nr_bytes = left;
+    reader->pos = 0;
+
+    if (reader->sz_block < MAX_READ_BLOCK) {
+        size_t sz = reader->sz_block ? reader->sz_block * 2 : MIN_READ_BLOCK;
+        uint8_t *block = realloc(reader->block, sz);
+        if (block == NULL) {
+            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return false;
+        }
+        reader->block = block;
+        reader->sz_block = sz;
+    }
+
+    while (reader->nr_bytes < nr) {
+        ssize_t n = purc_rwstream_read(reader->rws,
+                reader->block + reader->nr_bytes,
+                reader->sz_block - reader->nr_bytes);
+        if (n <= 0) {
+            return false;
+        }
+        reader->nr_bytes += n;
+    }
+
+    return true;
+}
+
+/* decode a character at pos in block; the ASCII run at pos is empty */
+static uint32_t
+tkz_reader_decode_char(struct tkz_reader *reader)
+{
+    if (!tkz_reader_fill_block(reader, 1)) {
+        return reader->partial ? TKZ_NO_INPUT : TKZ_END_OF_FILE;
+    }
+
+    reader->nr_ascii = ascii_run_length(reader->block + reader->pos,
+            reader->nr_bytes - reader->pos);
+    if (reader->nr_ascii) {
+        reader->nr_ascii--;
+        return reader->block[reader->pos++];
+    }
+
+    uint8_t c = reader->block[reader->pos];
+    int len = 1;
+    while (len < 8 && (c & (0x80 >> len))) {
+        len++;
+    }
+
+    // FIXME: the characters longer than 3 bytes are not supported yet.
+    if (len < 2 || len > 3) {
+        reader->pos++;
+        goto bad_encoding;
+    }
+
+    if (!tkz_reader_fill_block(reader, len)) {
+        /* wait for the rest bytes of the character */
+        if (reader->partial)
+            return TKZ_NO_INPUT;
+        reader->pos = reader->nr_bytes;
+        goto bad_encoding;
+    }
+
+    const char *utf8 = (const char *)reader->block + reader->pos;
+    size_t nr_chars;
+    for (int i = 1; i < len; i++) {
+        if ((utf8[i] & 0xC0) != 0x80) {
+            reader->pos += i;
+            goto bad_encoding;
+        }
+    }
+
+    reader->pos += len;
+    if (!pcutils_string_check_utf8_len(utf8, len, &nr_chars, NULL)) {
+        goto bad_encoding;
+    }
+
+    uint32_t uc = c & ((1 << (8 - len)) - 1);
+    for (int i = 1; i < len; i++) {
+        uc = (uc << 6) | (utf8[i] & 0x3F);
+    }
+    return uc;
+
+bad_encoding:
+    pcinst_set_error(PURC_ERROR_BAD_ENCODING);
+    return TKZ_INVALID_CHARACTER;
+}
+
 static struct tkz_uc*
 tkz_reader_read_from_rwstream(struct tkz_reader *reader)
 {
-    char c[8] = {0};
-    uint32_t uc = 0;
-    int nr_c = purc_rwstream_read_utf8_char(reader->rws, c, &uc);
-    if (nr_c < 0) {
-        uc = TKZ_INVALID_CHARACTER;
+    uint32_t uc;
+    if (reader->nr_ascii) {
+        reader->nr_ascii--;
+        uc = reader->block[reader->pos++];
+    }
+    else {
+        uc = tkz_reader_decode_char(reader);
+        if (uc == TKZ_NO_INPUT) {
+            return NULL;
+        }
     }
     reader->column++;
     reader->consumed++;
@@ -114,105 +290,56 @@ tkz_reader_read_from_rwstream(struct tkz_reader *reader)
         reader->line++;
         reader->column = 0;
     }
+
+    /* the oldest character is overwritten when the ring is full */
+    reader->ring[reader->cursor] = reader->curr_uc;
     return &reader->curr_uc;
 }
 
 static struct tkz_uc*
 tkz_reader_read_from_reconsume_list(struct tkz_reader *reader)
 {
-    struct tkz_uc *puc = list_entry(reader->reconsume_list.next,
-            struct tkz_uc, list);
-    reader->curr_uc = *puc;
-    list_del_init(&puc->list);
-    tkz_uc_destroy(puc);
+    reader->curr_uc = reader->ring[reader->cursor];
+    reader->nr_reconsume--;
     return &reader->curr_uc;
 }
 
-#define print_uc_list(uc_list, tag)                                         \
-    do {                                                                    \
-        PC_DEBUG("begin print %s list\n|", tag);                            \
-        struct list_head *p, *n;                                            \
-        list_for_each_safe(p, n, uc_list) {                                 \
-            struct tkz_uc *puc = list_entry(p, struct tkz_uc, list);        \
-            PC_DEBUG("%c", puc->character);                                 \
-        }                                                                   \
-        PC_DEBUG("|\nend print %s list\n", tag);                            \
-    } while(0)
-
-#define PRINT_CONSUMED_LIST(reader)    \
-        print_uc_list(&reader->consumed_list, "consumed")
-
-#define PRINT_RECONSUM_LIST(reader)    \
-        print_uc_list(&reader->reconsume_list, "reconsume")
-
-static bool
-tkz_reader_add_consumed(struct tkz_reader *reader, struct tkz_uc *uc)
-{
-    struct tkz_uc *p = tkz_uc_new();
-    if (!p) {
-        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
-        return false;
-    }
-
-    *p = *uc;
-    list_add_tail(&p->list, &reader->consumed_list);
-    reader->nr_consumed_list++;
-
-    if (reader->nr_consumed_list > NR_CONSUMED_LIST_LIMIT) {
-        struct tkz_uc *first = list_first_entry(
-                &reader->consumed_list, struct tkz_uc, list);
-        list_del_init(&first->list);
-        tkz_uc_destroy(first);
-        reader->nr_consumed_list--;
-    }
-    return true;
-}
-
 bool tkz_reader_reconsume_last_char(struct tkz_reader *reader)
 {
-    if (!reader->nr_consumed_list) {
+    if (!reader->nr_consumed) {
         return true;
     }
 
-    struct tkz_uc *last = list_last_entry(
-            &reader->consumed_list, struct tkz_uc, list);
-    list_del_init(&last->list);
-    reader->nr_consumed_list--;
-
-    list_add(&last->list, &reader->reconsume_list);
+    reader->cursor = RING_SLOT(reader->cursor - 1);
+    reader->nr_consumed--;
+    reader->nr_reconsume++;
     return true;
 }
 
 struct tkz_uc *tkz_reader_next_char(struct tkz_reader *reader)
 {
     struct tkz_uc *ret = NULL;
-    if (list_empty(&reader->reconsume_list)) {
+    if (reader->nr_reconsume == 0) {
         ret = tkz_reader_read_from_rwstream(reader);
+        if (ret == NULL) {
+            return NULL;
+        }
     }
     else {
         ret = tkz_reader_read_from_reconsume_list(reader);
     }
 
-    if (tkz_reader_add_consumed(reader, ret)) {
-        return ret;
+    reader->cursor = RING_SLOT(reader->cursor + 1);
+    if (reader->nr_consumed + reader->nr_reconsume < NR_CONSUMED_RING) {
+        reader->nr_consumed++;
     }
-    return NULL;
+    return ret;
 }
 
 void tkz_reader_destroy(struct tkz_reader *reader)
 {
     if (reader) {
-        struct list_head *p, *n;
-        list_for_each_safe(p, n, &reader->reconsume_list) {
-            struct tkz_uc *puc = list_entry(p, struct tkz_uc, list);
-            list_del_init(&puc->list);
-            tkz_uc_destroy(puc);
-        }
-        list_for_each_safe(p, n, &reader->consumed_list) {
-            struct tkz_uc *puc = list_entry(p, struct tkz_uc, list);
-            list_del_init(&puc->list);
-            tkz_uc_destroy(puc);
-        }
+        free(reader->block);
         PCHVML_FREE(reader);
     }
 }
@@ -438,7 +565,7 @@ bool tkz_buffer_is_int(struct tkz_buffer *buffer)
 bool tkz_buffer_is_number(struct tkz_buffer *buffer)
 {
     char *p = NULL;
-    strtold((const char*)buffer->base, &p);
+    pcutils_strtod((const char*)buffer->base, &p);
     return (p == (const char*)buffer->here);
 }
 
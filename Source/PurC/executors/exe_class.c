@@ -29,6 +29,7 @@
 #include "private/variant.h"
 
 #include "private/debug.h"
+#include "private/dlmodule.h"
 #include "private/errors.h"
 #include "private/stringbuilder.h"
 
@@ -43,116 +44,14 @@
 static void*
 _load_module(const char *module)
 {
-#define PRINT_DEBUG
-#if OS(LINUX) || OS(UNIX) || OS(MAC_OS_X)             /* { */
-    const char *ext = ".so";
-#if OS(MAC_OS_X)
-    ext = ".dylib";
-#endif
-
-    void *library_handle = NULL;
-
-    char so[PATH_MAX+1];
-    int n;
-    do {
-        /* XXX: the order of searching directories:
-         *
-         * 1. the valid directories contains in the environment variable:
-         *      PURC_EXECUTOR_PATH
-         * 2. /usr/local/lib/purc-<purc-api-version>/
-         * 3. /usr/lib/purc-<purc-api-version>/
-         * 4. /lib/purc-<purc-api-version>/
-         */
-
-        // step1: search in directories defined by the env var
-        const char *env = getenv(PURC_ENVV_EXECUTOR_PATH);
-        if (env) {
-            char *path = strdup(env);
-            char *str1;
-            char *saveptr1;
-            char *dir;
-
-            for (str1 = path; ; str1 = NULL) {
-                dir = strtok_r(str1, ":;", &saveptr1);
-                if (dir == NULL || dir[0] != '/') {
-                    break;
-                }
-
-                n = snprintf(so, sizeof(so),
-                        "%s/libpurc-executor-%s%s", dir, module, ext);
-                PC_ASSERT(n>0 && (size_t)n<sizeof(so));
-                library_handle = dlopen(so, RTLD_LAZY);
-                if (library_handle) {
-#ifdef PRINT_DEBUG        /* { */
-                    PC_DEBUGX("Loaded Executor from %s\n", so);
-#endif                    /* } */
-                    break;
-                }
-                else {
-#ifdef PRINT_DEBUG        /* { */
-                    PC_DEBUGX("Failed loading Executor from %s\n", so);
-#endif                    /* } */
-                }
-            }
-
-            free(path);
-
-            if (library_handle)
-                break;
-        }
-
-        static const char *ver = PURC_API_VERSION_STRING;
-
-        // try in system directories.
-        static const char *other_tries[] = {
-            "/usr/local/lib/purc-%s/libpurc-executor-%s%s",
-            "/usr/lib/purc-%s/libpurc-executor-%s%s",
-            "/lib/purc-%s/libpurc-executor-%s%s",
-        };
-
-        for (size_t i = 0; i < PCA_TABLESIZE(other_tries); i++) {
-            n = snprintf(so, sizeof(so), other_tries[i], ver, module, ext);
-            PC_ASSERT(n>0 && (size_t)n<sizeof(so));
-            library_handle = dlopen(so, RTLD_LAZY);
-            if (library_handle) {
-#ifdef PRINT_DEBUG        /* { */
-                PC_DEBUGX("Loaded Executor from %s\n", so);
-#endif                    /* } */
-                break;
-            }
-            else {
-#ifdef PRINT_DEBUG        /* { */
-                PC_DEBUGX("Failed loading Executor from %s\n", so);
-#endif                    /* } */
-            }
-        }
-
-    } while (0);
-
-    if (!library_handle) {
-        purc_set_error_with_info(PURC_ERROR_BAD_SYSTEM_CALL,
-                "failed to load: %s", so);
-        return NULL;
-    }
-#ifdef PRINT_DEBUG        /* { */
-    PC_DEBUGX("loaded: %s", so);
-#endif                    /* } */
-
-    return library_handle;
-
-#else                                                 /* }{ */
-    UNUSED_PARAM(exe_class_inst);
-    UNUSED_PARAM(module);
-
-    // TODO: Add codes for other OS.
-    pcinst_set_error (PURC_ERROR_NOT_SUPPORTED);
-    PC_ASSERT(0); // Not implemented yet
-#endif                                                /* } */
-#undef PRINT_DEBUG
+    return pcutils_dlmodule_open(PURC_ENVV_EXECUTOR_PATH,
+            "libpurc-executor-", module);
 }
 
+// gets `<CLASS>_instantiate_batch` if exported, or `<CLASS>_instantiate`
 static int
-_get_symbol_by_rule(const char *rule, void **handle, void **symbol)
+_get_symbol_by_rule(const char *rule, void **handle, void **symbol,
+        bool *batch)
 {
     struct exe_class_param param = {0};
     param.debug_flex = 1;
@@ -175,7 +74,8 @@ _get_symbol_by_rule(const char *rule, void **handle, void **symbol)
     pcutils_string_init(&name, 64);
 
     do {
-        r = pcutils_string_append(&name, "%s_instantiate", param.rule.name);
+        r = pcutils_string_append(&name, "%s_instantiate_batch",
+                param.rule.name);
         if (r) {
             purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
             break;
@@ -189,13 +89,23 @@ _get_symbol_by_rule(const char *rule, void **handle, void **symbol)
         }
 
         const char *s = pcutils_string_get(&name);
+        dlerror();
         void *p = dlsym(library_handle, s);
-        if (dlerror() != NULL) {
-            dlclose(library_handle);
-            purc_set_error_with_info(PURC_ERROR_BAD_SYSTEM_CALL,
-                    "failed to locate symbol `%s` from `%s`",
-                    s, module);
-            break;
+        *batch = (dlerror() == NULL && p != NULL);
+
+        if (!*batch) {
+            // without the suffix `_batch`
+            char *plain = strndup(s, strlen(s) - (sizeof("_batch") - 1));
+            p = plain ? dlsym(library_handle, plain) : NULL;
+            if (dlerror() != NULL || p == NULL) {
+                dlclose(library_handle);
+                purc_set_error_with_info(PURC_ERROR_BAD_SYSTEM_CALL,
+                        "failed to locate symbol `%s` from `%s`",
+                        plain ? plain : s, module);
+                free(plain);
+                break;
+            }
+            free(plain);
         }
         PC_ASSERT(p);
 
@@ -213,19 +123,66 @@ _get_symbol_by_rule(const char *rule, void **handle, void **symbol)
     return -1;
 }
 
+/* the number of values fetched at once by the batch operations */
+#define CLASS_BATCH_SIZE        64
+
 struct pcexec_class_iter {
     void                      *handle;
     struct purc_iterator_ops   ops;
+    // the operations returned by `<CLASS>_instantiate_batch`, if any
+    struct purc_iterator_batch_ops  batch_ops;
+    bool                       batch;
+    bool                       batch_end;
 
     purc_variant_t             it;
 
     purc_variant_t             val;
+
+    // the values fetched ahead in a batch, after `val`
+    purc_variant_t             values[CLASS_BATCH_SIZE];
+    size_t                     nr_values;
+    size_t                     idx_value;
 };
 
+static void
+release_values(pcexec_class_iter_t it)
+{
+    for (size_t i = it->idx_value; i < it->nr_values; i++)
+        purc_variant_unref(it->values[i]);
+    it->nr_values = 0;
+    it->idx_value = 0;
+}
+
+// moves to the next value, fetches a batch of values if there is no more
+static purc_variant_t
+next_value(pcexec_class_iter_t it)
+{
+    if (!it->batch)
+        return it->ops.next(it->it);
+
+    if (it->idx_value == it->nr_values) {
+        if (it->batch_end)
+            return PURC_VARIANT_INVALID;
+
+        release_values(it);
+        ssize_t n = it->batch_ops.next_batch(it->it, it->values,
+                CLASS_BATCH_SIZE);
+        if (n <= 0)
+            return PURC_VARIANT_INVALID;
+
+        it->nr_values = n;
+        it->batch_end = (n < CLASS_BATCH_SIZE);
+    }
+
+    // the reference is moved to the caller
+    return it->values[it->idx_value++];
+}
+
 static void
 it_release(pcexec_class_iter_t it)
 {
     if (it) {
+        release_values(it);
         PURC_VARIANT_SAFE_CLEAR(it->val);
         PURC_VARIANT_SAFE_CLEAR(it->it);
         if (it->handle) {
@@ -259,7 +216,8 @@ exe_class_it_begin(const char* rule, purc_variant_t on,
 
     do {
         int r;
-        r = _get_symbol_by_rule(rule, &handle, &symbol);
+        bool batch;
+        r = _get_symbol_by_rule(rule, &handle, &symbol, &batch);
         if (r)
             break;
 
@@ -267,24 +225,46 @@ exe_class_it_begin(const char* rule, purc_variant_t on,
         PC_ASSERT(symbol);
 
         it->handle = handle;
+        it->batch = batch;
 
-        struct purc_iterator_ops* (*instantiate)(void);
-        instantiate = symbol;
+        if (batch) {
+            struct purc_iterator_batch_ops* (*instantiate)(void);
+            instantiate = symbol;
 
-        struct purc_iterator_ops  *ops;
-        ops = instantiate();
+            struct purc_iterator_batch_ops  *ops;
+            ops = instantiate();
+            if (!ops) {
+                PC_ASSERT(purc_get_last_error());
+                break;
+            }
 
-        if (!ops) {
-            PC_ASSERT(purc_get_last_error());
-            break;
+            it->batch_ops = *ops;
+            it->ops.begin = ops->begin;
+            if (!it->batch_ops.begin || !it->batch_ops.next_batch) {
+                purc_set_error_with_info(PURC_ERROR_INVALID_VALUE,
+                        "bad ops from external class executor");
+                break;
+            }
         }
+        else {
+            struct purc_iterator_ops* (*instantiate)(void);
+            instantiate = symbol;
 
-        it->ops = *ops;
+            struct purc_iterator_ops  *ops;
+            ops = instantiate();
 
-        if (!it->ops.begin || !it->ops.next) {
-            purc_set_error_with_info(PURC_ERROR_INVALID_VALUE,
-                    "bad ops from external class executor");
-            break;
+            if (!ops) {
+                PC_ASSERT(purc_get_last_error());
+                break;
+            }
+
+            it->ops = *ops;
+
+            if (!it->ops.begin || !it->ops.next) {
+                purc_set_error_with_info(PURC_ERROR_INVALID_VALUE,
+                        "bad ops from external class executor");
+                break;
+            }
         }
 
         it->it = it->ops.begin(on, with);
@@ -293,7 +273,7 @@ exe_class_it_begin(const char* rule, purc_variant_t on,
         }
         else {
             PURC_VARIANT_SAFE_CLEAR(it->val);
-            it->val = it->ops.next(it->it);
+            it->val = next_value(it);
             if (it->val == PURC_VARIANT_INVALID)
                 break;
         }
@@ -317,9 +297,9 @@ static pcexec_class_iter_t
 exe_class_it_next(pcexec_class_iter_t it)
 {
     PC_ASSERT(it);
-    PC_ASSERT(it->ops.next);
+    PC_ASSERT(it->ops.next || it->batch);
     PURC_VARIANT_SAFE_CLEAR(it->val);
-    it->val = it->ops.next(it->it);
+    it->val = next_value(it);
     if (it->val == PURC_VARIANT_INVALID) {
         it_destroy(it);
         return NULL;
@@ -34,7 +34,7 @@
 struct pcexec_exe_div_inst {
     struct purc_exec_inst       super;
 
-    struct exe_div_param        param;
+    struct exe_div_param       *param;    // compiled and shared
 
     double                      curr;
 };
@@ -43,31 +43,31 @@ struct pcexec_exe_div_inst {
 static inline void
 reset(struct pcexec_exe_div_inst *exe_div_inst)
 {
-    struct exe_div_param *param = &exe_div_inst->param;
-    exe_div_param_reset(param);
+    pcexecutor_put_compiled_rule(exe_div_inst->param);
+    exe_div_inst->param = NULL;
     pcexecutor_inst_reset(&exe_div_inst->super);
 }
 
+PCEXE_DEFINE_RULE_COMPILER(exe_div)
+
 static inline bool
 parse_rule(struct pcexec_exe_div_inst *exe_div_inst,
         const char* rule)
 {
     purc_exec_inst_t inst = &exe_div_inst->super;
 
-    struct exe_div_param param = {0};
-    int r = exe_div_parse(rule, strlen(rule), &param);
     if (inst->err_msg) {
         free(inst->err_msg);
         inst->err_msg = NULL;
     }
 
-    if (r) {
-        inst->err_msg = param.err_msg;
-        param.err_msg = NULL;
+    struct exe_div_param *param;
+    param = pcexecutor_get_compiled_rule("DIV", rule, sizeof(*param),
+            exe_div_compile_rule, exe_div_release_rule, &inst->err_msg);
+    if (param == NULL)
         return false;
-    }
 
-    exe_div_param_reset(&exe_div_inst->param);
+    pcexecutor_put_compiled_rule(exe_div_inst->param);
     exe_div_inst->param = param;
 
     return true;
@@ -77,7 +77,7 @@ static inline bool
 check_curr(struct pcexec_exe_div_inst *exe_div_inst, const double curr)
 {
     purc_exec_inst_t inst = &exe_div_inst->super;
-    struct exe_div_param *param = &exe_div_inst->param;
+    struct exe_div_param *param = exe_div_inst->param;
     struct div_rule *rule = &param->rule;
     struct number_comparing_logical_expression *ncle = rule->ncle;
 
@@ -128,7 +128,7 @@ fetch_next(struct pcexec_exe_div_inst *exe_div_inst)
 {
     purc_exec_inst_t inst = &exe_div_inst->super;
     purc_exec_iter_t it = &inst->it;
-    struct exe_div_param *param = &exe_div_inst->param;
+    struct exe_div_param *param = exe_div_inst->param;
     struct div_rule *rule = &param->rule;
     double curr = exe_div_inst->curr;
     if (!isnan(rule->nexp)) {
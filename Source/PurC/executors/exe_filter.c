@@ -37,159 +37,40 @@
 struct pcexec_exe_filter_inst {
     struct purc_exec_inst       super;
 
-    struct exe_filter_param        param;
+    struct exe_filter_param       *param;    // compiled and shared
 
-    purc_variant_t              result_set;
-};
-
-// clear internal data except `input`
-static inline void
-reset(struct pcexec_exe_filter_inst *exe_filter_inst)
-{
-    struct exe_filter_param *param = &exe_filter_inst->param;
-    exe_filter_param_reset(param);
-    pcexecutor_inst_reset(&exe_filter_inst->super);
-    PCEXE_CLR_VAR(exe_filter_inst->result_set);
-}
-
-static inline bool
-init_result_set_with_object(struct pcexec_exe_filter_inst *exe_filter_inst,
-        purc_variant_t result_set)
-{
-    purc_exec_inst_t inst = &exe_filter_inst->super;
-    purc_variant_t input = inst->input;
-
-    bool ok = true;
-    purc_variant_t k, v;
-    foreach_key_value_in_variant_object(input, k, v)
-        purc_variant_t arr = purc_variant_make_array(2, k, v);
-        if (arr == PURC_VARIANT_INVALID) {
-            ok = false;
-            break;
-        }
-        if (!purc_variant_array_append(result_set, arr)) {
-            ok = false;
-            break;
-        }
-    end_foreach;
-
-    if (ok) {
-        PCEXE_CLR_VAR(exe_filter_inst->result_set);
-        exe_filter_inst->result_set = result_set;
-        purc_variant_ref(result_set);
-    }
+    // the key of the member of an object at `it.curr`; the member is
+    // looked up by the key on every step, for the object may be changed
+    // by the iteration
+    purc_variant_t              obj_key;
 
-    return ok;
-}
-
-static inline bool
-init_result_set_with_array(struct pcexec_exe_filter_inst *exe_filter_inst,
-        purc_variant_t result_set)
-{
-    purc_exec_inst_t inst = &exe_filter_inst->super;
-    purc_variant_t input = inst->input;
-
-    bool ok = true;
-    purc_variant_t v;
-    size_t idx;
-    foreach_value_in_variant_array(input, v, idx)
-        (void)idx;
-        if (!purc_variant_array_append(result_set, v)) {
-            ok = false;
-            break;
-        }
-    end_foreach;
-
-    if (ok) {
-        PCEXE_CLR_VAR(exe_filter_inst->result_set);
-        exe_filter_inst->result_set = result_set;
-        purc_variant_ref(result_set);
-    }
+    // the members of an array or a set matching the rule, see fetch_begin()
+    unsigned char                *selected;
+    size_t                        nr_selected;
+};
 
-    return ok;
-}
+// the least number of members to compare in bulk
+#define MIN_MEMBERS_TO_SELECT       32
 
-static inline bool
-init_result_set_with_set(struct pcexec_exe_filter_inst *exe_filter_inst,
-        purc_variant_t result_set)
+static inline void
+clear_selected(struct pcexec_exe_filter_inst *exe_filter_inst)
 {
-    purc_exec_inst_t inst = &exe_filter_inst->super;
-    purc_variant_t input = inst->input;
-
-    bool ok = true;
-    purc_variant_t v;
-    // FIXME: document-order or content-order?
-    foreach_value_in_variant_set(input, v)
-        if (!purc_variant_array_append(result_set, v)) {
-            ok = false;
-            break;
-        }
-    end_foreach;
-
-    if (ok) {
-        PCEXE_CLR_VAR(exe_filter_inst->result_set);
-        exe_filter_inst->result_set = result_set;
-        purc_variant_ref(result_set);
-    }
-
-    return ok;
+    PCEXE_FREE(exe_filter_inst->selected);
+    exe_filter_inst->nr_selected = 0;
 }
 
-static inline bool
-init_result_set(struct pcexec_exe_filter_inst *exe_filter_inst,
-        purc_variant_t result_set)
+// clear internal data except `input`
+static inline void
+reset(struct pcexec_exe_filter_inst *exe_filter_inst)
 {
-    purc_exec_inst_t inst = &exe_filter_inst->super;
-    purc_variant_t input = inst->input;
-
-    switch (purc_variant_get_type(input)) {
-        case PURC_VARIANT_TYPE_OBJECT:
-            return init_result_set_with_object(exe_filter_inst, result_set);
-        case PURC_VARIANT_TYPE_ARRAY:
-            return init_result_set_with_array(exe_filter_inst, result_set);
-        case PURC_VARIANT_TYPE_SET:
-            return init_result_set_with_set(exe_filter_inst, result_set);
-        default:
-            PC_ASSERT(0);
-            return false;
-    }
-
-    bool ok = true;
-    purc_variant_t k, v;
-    foreach_key_value_in_variant_object(input, k, v)
-        if (!purc_variant_array_append(result_set, k)) {
-            ok = false;
-            break;
-        }
-        if (!purc_variant_array_append(result_set, v)) {
-            ok = false;
-            break;
-        }
-    end_foreach;
-
-    if (ok) {
-        PCEXE_CLR_VAR(exe_filter_inst->result_set);
-        exe_filter_inst->result_set = result_set;
-        purc_variant_ref(result_set);
-    }
-
-    return ok;
+    pcexecutor_put_compiled_rule(exe_filter_inst->param);
+    exe_filter_inst->param = NULL;
+    clear_selected(exe_filter_inst);
+    pcexecutor_inst_reset(&exe_filter_inst->super);
+    PCEXE_CLR_VAR(exe_filter_inst->obj_key);
 }
 
-static inline bool
-prepare_result_set(struct pcexec_exe_filter_inst *exe_filter_inst)
-{
-    purc_variant_t result_set;
-    result_set = purc_variant_make_array(0, PURC_VARIANT_INVALID);
-    if (result_set == PURC_VARIANT_INVALID) {
-        return false;
-    }
-
-    bool ok = init_result_set(exe_filter_inst, result_set);
-    purc_variant_unref(result_set);
-
-    return ok;
-}
+PCEXE_DEFINE_RULE_COMPILER(exe_filter)
 
 static inline bool
 parse_rule(struct pcexec_exe_filter_inst *exe_filter_inst,
@@ -197,23 +78,23 @@ parse_rule(struct pcexec_exe_filter_inst *exe_filter_inst,
 {
     purc_exec_inst_t inst = &exe_filter_inst->super;
 
-    struct exe_filter_param param = {0};
-    int r = exe_filter_parse(rule, strlen(rule), &param);
     if (inst->err_msg) {
         free(inst->err_msg);
         inst->err_msg = NULL;
     }
 
-    if (r) {
-        inst->err_msg = param.err_msg;
-        param.err_msg = NULL;
+    struct exe_filter_param *param;
+    param = pcexecutor_get_compiled_rule("FILTER", rule, sizeof(*param),
+            exe_filter_compile_rule, exe_filter_release_rule, &inst->err_msg);
+    if (param == NULL)
         return false;
-    }
 
-    exe_filter_param_reset(&exe_filter_inst->param);
+    pcexecutor_put_compiled_rule(exe_filter_inst->param);
     exe_filter_inst->param = param;
+    // selected by the previous rule
+    clear_selected(exe_filter_inst);
 
-    return prepare_result_set(exe_filter_inst);
+    return true;
 }
 
 int
@@ -236,27 +117,27 @@ filter_rule_eval(struct filter_rule *rule, purc_variant_t val, bool *result)
     return number_comparing_logical_expression_match(ncle, curr, result);
 }
 
+/*
+ * The members of the input are not copied to a result set beforehand:
+ * fetch_begin() and fetch_next() scan the input from the current position
+ * to the next one matching the rule, so only the members fetched are
+ * visited. The input is referenced, not snapshotted; the size is checked
+ * on every step.
+ */
 static inline bool
-check_item_with_object(struct pcexec_exe_filter_inst *exe_filter_inst,
-    const int curr, purc_variant_t item, bool *result)
+check_kv(struct pcexec_exe_filter_inst *exe_filter_inst,
+    purc_variant_t k, purc_variant_t v, bool *result)
 {
     purc_exec_inst_t inst = &exe_filter_inst->super;
-    purc_exec_iter_t it = &inst->it;
-    struct filter_rule *rule = &exe_filter_inst->param.rule;
-
-    purc_variant_t v = purc_variant_array_get(item, 1);
-    PC_ASSERT(v != PURC_VARIANT_INVALID);
+    struct filter_rule *rule = &exe_filter_inst->param->rule;
 
     if (filter_rule_eval(rule, v, result)) {
         // TODO: exception
         PC_ASSERT(0);
         return false;
     }
-    if (!result)
-        return false;
-
-    purc_variant_t k = purc_variant_array_get(item, 0);
-    PC_ASSERT(k != PURC_VARIANT_INVALID);
+    if (!*result)
+        return true;
 
     purc_variant_t val = PURC_VARIANT_INVALID;
 
@@ -275,114 +156,243 @@ check_item_with_object(struct pcexec_exe_filter_inst *exe_filter_inst,
             break;
     }
 
+    if (val == PURC_VARIANT_INVALID)
+        return false;
+
     PCEXE_CLR_VAR(inst->value);
     inst->value = val;
-    it->curr = curr;
 
     return true;
 }
 
 static inline bool
-check_item_with_array(struct pcexec_exe_filter_inst *exe_filter_inst,
-    const int curr, purc_variant_t item, bool *result)
+check_item(struct pcexec_exe_filter_inst *exe_filter_inst,
+    purc_variant_t item, bool *result)
 {
     purc_exec_inst_t inst = &exe_filter_inst->super;
-    purc_exec_iter_t it = &inst->it;
-    struct filter_rule *rule = &exe_filter_inst->param.rule;
+    struct filter_rule *rule = &exe_filter_inst->param->rule;
 
     if (filter_rule_eval(rule, item, result)) {
         // TODO: exception
         PC_ASSERT(0);
         return false;
     }
-    if (!result)
+    if (!*result)
         return true;
 
     PCEXE_CLR_VAR(inst->value);
     inst->value = item;
     purc_variant_ref(item);
-    it->curr = curr;
 
     return true;
 }
 
-static inline bool
-check_item_with_set(struct pcexec_exe_filter_inst *exe_filter_inst,
-    const int curr, purc_variant_t item, bool *result)
+// seeks the member of the object at `obj_key`, or the one after it if
+// the member was removed or `after` is true, and moves `obj_key` there;
+// clears `obj_key` if there is no more
+static purc_variant_t
+get_object_member(struct pcexec_exe_filter_inst *exe_filter_inst,
+        bool after, purc_variant_t *key)
 {
-    purc_exec_inst_t inst = &exe_filter_inst->super;
-    purc_exec_iter_t it = &inst->it;
-
-    *result = false;
-    PC_ASSERT(0); // Not implemented yet
+    purc_variant_t curr = exe_filter_inst->obj_key;
+    if (curr == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
 
-    PCEXE_CLR_VAR(inst->value);
-    inst->value = item;
-    purc_variant_ref(item);
-    it->curr = curr;
+    purc_variant_t v = pcvariant_object_lower_bound(
+            exe_filter_inst->super.input,
+            purc_variant_get_string_const(curr), after, key);
+    if (v == PURC_VARIANT_INVALID) {
+        purc_clr_error();
+        PCEXE_CLR_VAR(exe_filter_inst->obj_key);
+        return PURC_VARIANT_INVALID;
+    }
 
-    return true;
+    if (*key != curr) {
+        exe_filter_inst->obj_key = purc_variant_ref(*key);
+        purc_variant_unref(curr);
+    }
+    return v;
 }
 
-static inline bool
-check_item(struct pcexec_exe_filter_inst *exe_filter_inst,
-    const int curr, purc_variant_t item, bool *result)
+// fetches the member at `it.curr`, or returns NULL if there is no more
+static inline purc_variant_t
+get_member(struct pcexec_exe_filter_inst *exe_filter_inst,
+        purc_variant_t *key)
 {
     purc_exec_inst_t inst = &exe_filter_inst->super;
     purc_variant_t input = inst->input;
+    size_t curr = inst->it.curr;
 
     switch (purc_variant_get_type(input)) {
         case PURC_VARIANT_TYPE_OBJECT:
-            return check_item_with_object(exe_filter_inst, curr, item, result);
+            return get_object_member(exe_filter_inst, false, key);
+
         case PURC_VARIANT_TYPE_ARRAY:
-            return check_item_with_array(exe_filter_inst, curr, item, result);
+            if (curr >= (size_t)purc_variant_array_get_size(input))
+                return PURC_VARIANT_INVALID;
+            return purc_variant_array_get(input, curr);
+
         case PURC_VARIANT_TYPE_SET:
-            return check_item_with_set(exe_filter_inst, curr, item, result);
+            if (curr >= (size_t)purc_variant_set_get_size(input))
+                return PURC_VARIANT_INVALID;
+            return purc_variant_set_get_by_index(input, curr);
+
         default:
             PC_ASSERT(0);
-            return false;
+            return PURC_VARIANT_INVALID;
     }
 }
 
-static inline bool
-check_curr(struct pcexec_exe_filter_inst *exe_filter_inst)
+// moves to the next member
+static inline void
+step(struct pcexec_exe_filter_inst *exe_filter_inst)
 {
     purc_exec_inst_t inst = &exe_filter_inst->super;
-    purc_exec_iter_t it = &inst->it;
 
-    int curr = (int)it->curr;
+    inst->it.curr += 1;
+    if (exe_filter_inst->obj_key) {
+        purc_variant_t k;
+        get_object_member(exe_filter_inst, true, &k);
+    }
+}
+
+static int
+numberify_member(void *ctxt, size_t idx, purc_variant_t key,
+        purc_variant_t member)
+{
+    UNUSED_PARAM(key);
+
+    double *nums = ctxt;
+    nums[idx] = purc_variant_numberify(member);
+    return 0;
+}
+
+/*
+ * For an array or a set compared with numbers, fetch_begin() numberifies
+ * all the members into a vector and evaluates the comparisons over the
+ * vector at once (see number_comparing_logical_expression_match_bulk()),
+ * instead of evaluating the expression tree for every member. The members
+ * are compared when the iteration begins; if the size of the input is
+ * changed after that, the members left are compared one by one.
+ */
+static void
+select_members(struct pcexec_exe_filter_inst *exe_filter_inst)
+{
+    purc_exec_inst_t inst = &exe_filter_inst->super;
+    purc_variant_t input = inst->input;
+    struct filter_rule *rule = &exe_filter_inst->param->rule;
+    bool is_array = purc_variant_is_array(input);
+    ssize_t sz;
+
+    clear_selected(exe_filter_inst);
+    if (rule->ncle == NULL)
+        return;
+
+    if (is_array)
+        sz = purc_variant_array_get_size(input);
+    else if (purc_variant_is_set(input))
+        sz = purc_variant_set_get_size(input);
+    else
+        return;
+
+    if (sz < MIN_MEMBERS_TO_SELECT)
+        return;
+
+    size_t nr = sz;
+    double *nums = malloc(sizeof(*nums) * nr);
+    unsigned char *selected = malloc(nr);
+    if (nums == NULL || selected == NULL)
+        goto failed;
+
+    purc_variant_container_scan(input, numberify_member, nums);
+
+    if (number_comparing_logical_expression_match_bulk(rule->ncle,
+                nums, nr, selected))
+        goto failed;
+
+    free(nums);
+    exe_filter_inst->selected = selected;
+    exe_filter_inst->nr_selected = nr;
+    return;
+
+failed:
+    // fall back to comparing the members one by one
+    free(nums);
+    free(selected);
+    purc_clr_error();
+}
 
-    if (curr < 0) {
+// skips to the first member selected from `it.curr`
+static inline bool
+check_selected(struct pcexec_exe_filter_inst *exe_filter_inst)
+{
+    purc_exec_inst_t inst = &exe_filter_inst->super;
+    size_t nr = exe_filter_inst->nr_selected;
+    size_t curr = inst->it.curr;
+
+    const unsigned char *found = NULL;
+    if (curr < nr)
+        found = memchr(exe_filter_inst->selected + curr, 1, nr - curr);
+    if (found == NULL) {
+        inst->it.curr = nr;
         pcinst_set_error(PCEXECUTOR_ERROR_NOT_EXISTS);
         return false;
     }
 
-    purc_variant_t result_set = exe_filter_inst->result_set;
-    size_t nr;
-    if (!purc_variant_array_size(result_set, &nr)) {
-        pcinst_set_error(PCEXECUTOR_ERROR_NOT_EXISTS);
+    curr = found - exe_filter_inst->selected;
+    inst->it.curr = curr;
+
+    purc_variant_t item = purc_variant_is_array(inst->input) ?
+        purc_variant_array_get(inst->input, curr) :
+        purc_variant_set_get_by_index(inst->input, curr);
+    PCEXE_CLR_VAR(inst->value);
+    inst->value = purc_variant_ref(item);
+    return true;
+}
+
+static inline bool
+selection_valid(struct pcexec_exe_filter_inst *exe_filter_inst)
+{
+    purc_variant_t input = exe_filter_inst->super.input;
+
+    if (exe_filter_inst->selected == NULL)
         return false;
-    }
 
-    bool result = false;
-    while (!result) {
-        if ((size_t)curr >= nr) {
-            pcinst_set_error(PCEXECUTOR_ERROR_NOT_EXISTS);
-            return false;
-        }
+    ssize_t sz = purc_variant_is_array(input) ?
+        purc_variant_array_get_size(input) :
+        purc_variant_set_get_size(input);
+    if (sz >= 0 && (size_t)sz == exe_filter_inst->nr_selected)
+        return true;
 
-        purc_variant_t item = purc_variant_array_get(result_set, curr);
-        if (!check_item(exe_filter_inst, curr, item, &result)) {
-            // TODO: exception
-            PC_ASSERT(0);
+    clear_selected(exe_filter_inst);
+    return false;
+}
+
+// scans forward from `it.curr` to the first member matching the rule
+static inline bool
+check_curr(struct pcexec_exe_filter_inst *exe_filter_inst)
+{
+    if (selection_valid(exe_filter_inst))
+        return check_selected(exe_filter_inst);
+
+    for (;;) {
+        purc_variant_t k = PURC_VARIANT_INVALID;
+        purc_variant_t v = get_member(exe_filter_inst, &k);
+        if (v == PURC_VARIANT_INVALID)
+            break;
+
+        bool result = false;
+        bool ok;
+        if (k != PURC_VARIANT_INVALID)
+            ok = check_kv(exe_filter_inst, k, v, &result);
+        else
+            ok = check_item(exe_filter_inst, v, &result);
+        if (!ok)
             return false;
-        }
-        if (!result) {
-            curr += 1;
-            continue;
-        }
+        if (result)
+            return true;
 
-        return true;
+        step(exe_filter_inst);
     }
 
     pcinst_set_error(PCEXECUTOR_ERROR_NOT_EXISTS);
@@ -395,6 +405,18 @@ fetch_begin(struct pcexec_exe_filter_inst *exe_filter_inst)
     purc_exec_inst_t inst = &exe_filter_inst->super;
     purc_exec_iter_t it = &inst->it;
     it->curr = 0;
+
+    PCEXE_CLR_VAR(exe_filter_inst->obj_key);
+    if (purc_variant_is_object(inst->input)) {
+        // the empty string is not greater than any key
+        exe_filter_inst->obj_key = purc_variant_make_string_static("", false);
+        purc_variant_t k;
+        get_object_member(exe_filter_inst, false, &k);
+    }
+    else {
+        select_members(exe_filter_inst);
+    }
+
     if (check_curr(exe_filter_inst)) {
         return it;
     }
@@ -406,7 +428,7 @@ fetch_next(struct pcexec_exe_filter_inst *exe_filter_inst)
 {
     purc_exec_inst_t inst = &exe_filter_inst->super;
     purc_exec_iter_t it = &inst->it;
-    it->curr += 1;
+    step(exe_filter_inst);
     if (check_curr(exe_filter_inst)) {
         return it;
     }
@@ -451,11 +473,6 @@ exe_filter_create(enum purc_exec_type type,
     inst->type        = type;
     inst->asc_desc    = asc_desc;
 
-    int debug_flex, debug_bison;
-    pcexecutor_get_debug(&debug_flex, &debug_bison);
-    exe_filter_inst->param.debug_flex  = debug_flex;
-    exe_filter_inst->param.debug_bison = debug_bison;
-
     enum purc_variant_type vt = purc_variant_get_type(input);
     if (vt == PURC_VARIANT_TYPE_OBJECT ||
         vt == PURC_VARIANT_TYPE_ARRAY ||
@@ -716,6 +733,24 @@ static struct purc_exec_ops exe_filter_ops = {
     exe_filter_destroy,
 };
 
+// the values of an array or a set are chosen regardless of the positions
+int pcexec_exe_filter_choose_member(const char *rule, purc_variant_t member,
+        bool *chosen)
+{
+    char *err_msg = NULL;
+    struct exe_filter_param *param;
+    param = pcexecutor_get_compiled_rule("FILTER", rule, sizeof(*param),
+            exe_filter_compile_rule, exe_filter_release_rule, &err_msg);
+    if (param == NULL) {
+        free(err_msg);
+        return -1;
+    }
+
+    int r = filter_rule_eval(&param->rule, member, chosen);
+    pcexecutor_put_compiled_rule(param);
+    return r ? -1 : 0;
+}
+
 int pcexec_exe_filter_register(void)
 {
     bool ok = purc_register_executor("FILTER", &exe_filter_ops);
@@ -54,6 +54,9 @@ PCA_EXTERN_C_BEGIN
 
 int pcexec_exe_filter_register(void);
 
+int pcexec_exe_filter_choose_member(const char *rule, purc_variant_t member,
+        bool *chosen);
+
 static inline void
 filter_rule_release(struct filter_rule *rule)
 {
@@ -29,6 +29,7 @@
 #include "private/variant.h"
 
 #include "private/debug.h"
+#include "private/dlmodule.h"
 #include "private/errors.h"
 
 #include "keywords.h"
@@ -42,112 +43,8 @@
 static void*
 _load_module(const char *module)
 {
-#define PRINT_DEBUG
-#if OS(LINUX) || OS(UNIX) || OS(MAC_OS_X)             /* { */
-    const char *ext = ".so";
-#if OS(MAC_OS_X)
-    ext = ".dylib";
-#endif
-
-    void *library_handle = NULL;
-
-    char so[PATH_MAX+1];
-    int n;
-    do {
-        /* XXX: the order of searching directories:
-         *
-         * 1. the valid directories contains in the environment variable:
-         *      PURC_EXECUTOR_PATH
-         * 2. /usr/local/lib/purc-<purc-api-version>/
-         * 3. /usr/lib/purc-<purc-api-version>/
-         * 4. /lib/purc-<purc-api-version>/
-         */
-
-        // step1: search in directories defined by the env var
-        const char *env = getenv(PURC_ENVV_EXECUTOR_PATH);
-        if (env) {
-            char *path = strdup(env);
-            char *str1;
-            char *saveptr1;
-            char *dir;
-
-            for (str1 = path; ; str1 = NULL) {
-                dir = strtok_r(str1, ":;", &saveptr1);
-                if (dir == NULL || dir[0] != '/') {
-                    break;
-                }
-
-                n = snprintf(so, sizeof(so),
-                        "%s/libpurc-executor-%s%s", dir, module, ext);
-                PC_ASSERT(n>0 && (size_t)n<sizeof(so));
-                library_handle = dlopen(so, RTLD_LAZY);
-                if (library_handle) {
-#ifdef PRINT_DEBUG        /* { */
-                    PC_DEBUGX("Loaded Executor from %s\n", so);
-#endif                    /* } */
-                    break;
-                }
-                else {
-#ifdef PRINT_DEBUG        /* { */
-                    PC_DEBUGX("Failed loading Executor from %s\n", so);
-#endif                    /* } */
-                }
-            }
-
-            free(path);
-
-            if (library_handle)
-                break;
-        }
-
-        static const char *ver = PURC_API_VERSION_STRING;
-
-        // try in system directories.
-        static const char *other_tries[] = {
-            "/usr/local/lib/purc-%s/libpurc-executor-%s%s",
-            "/usr/lib/purc-%s/libpurc-executor-%s%s",
-            "/lib/purc-%s/libpurc-executor-%s%s",
-        };
-
-        for (size_t i = 0; i < PCA_TABLESIZE(other_tries); i++) {
-            n = snprintf(so, sizeof(so), other_tries[i], ver, module, ext);
-            PC_ASSERT(n>0 && (size_t)n<sizeof(so));
-            library_handle = dlopen(so, RTLD_LAZY);
-            if (library_handle) {
-#ifdef PRINT_DEBUG        /* { */
-                PC_DEBUGX("Loaded Executor from %s\n", so);
-#endif                    /* } */
-                break;
-            }
-            else {
-#ifdef PRINT_DEBUG        /* { */
-                PC_DEBUGX("Failed loading Executor from %s\n", so);
-#endif                    /* } */
-            }
-        }
-
-    } while (0);
-
-    if (!library_handle) {
-        purc_set_error_with_info(PURC_ERROR_BAD_SYSTEM_CALL,
-                "failed to load: %s", so);
-        return NULL;
-    }
-#ifdef PRINT_DEBUG        /* { */
-    PC_DEBUGX("loaded: %s", so);
-#endif                    /* } */
-
-    return library_handle;
-
-#else                                                 /* }{ */
-    UNUSED_PARAM(exe_func_inst);
-    UNUSED_PARAM(module);
-
-    // TODO: Add codes for other OS.
-    pcinst_set_error (PURC_ERROR_NOT_SUPPORTED);
-    PC_ASSERT(0); // Not implemented yet
-#endif                                                /* } */
-#undef PRINT_DEBUG
+    return pcutils_dlmodule_open(PURC_ENVV_EXECUTOR_PATH,
+            "libpurc-executor-", module);
 }
 
 static int
@@ -33,67 +33,143 @@
 #include "private/errors.h"
 
 #include <math.h>
+#include <stdint.h>
 
 struct pcexec_exe_key_inst {
     struct purc_exec_inst       super;
 
-    struct exe_key_param        param;
+    struct exe_key_param       *param;    // compiled and shared
 
-    purc_variant_t              result_set;
+    // the key of the input at `it.curr`; the member is looked up by the
+    // key on every step, for the input may be changed by the iteration
+    purc_variant_t              obj_key;
+
+    // the prefix of the rule to match if the rule has prefixes
+    size_t                      curr_prefix;
 };
 
 // clear internal data except `input`
 static inline void
 reset(struct pcexec_exe_key_inst *exe_key_inst)
 {
-    struct exe_key_param *param = &exe_key_inst->param;
-    exe_key_param_reset(param);
+    pcexecutor_put_compiled_rule(exe_key_inst->param);
+    exe_key_inst->param = NULL;
     pcexecutor_inst_reset(&exe_key_inst->super);
-    PCEXE_CLR_VAR(exe_key_inst->result_set);
+    PCEXE_CLR_VAR(exe_key_inst->obj_key);
 }
 
-static inline bool
-init_result_set(struct pcexec_exe_key_inst *exe_key_inst,
-        purc_variant_t result_set)
+static int append_prefix(struct key_rule *rule, const char *literal)
 {
-    purc_exec_inst_t inst = &exe_key_inst->super;
-    purc_variant_t input = inst->input;
+    char **prefixes = realloc(rule->prefixes,
+            sizeof(*prefixes) * (rule->nr_prefixes + 1));
+    if (!prefixes)
+        return -1;
+
+    rule->prefixes = prefixes;
+    prefixes[rule->nr_prefixes] = strdup(literal);
+    if (!prefixes[rule->nr_prefixes])
+        return -1;
+
+    rule->nr_prefixes++;
+    return 0;
+}
 
-    bool ok = true;
-    purc_variant_t k, v;
-    foreach_key_value_in_variant_object(input, k, v)
-        if (!purc_variant_array_append(result_set, k)) {
-            ok = false;
-            break;
-        }
-        if (!purc_variant_array_append(result_set, v)) {
-            ok = false;
-            break;
+// collects the literals of @exp if it only contains literals without any
+// matching suffix combined by OR; returns -1 if not
+static int
+collect_prefixes(struct key_rule *rule,
+        struct string_matching_logical_expression *exp)
+{
+    if (exp->type == STRING_MATCHING_LOGICAL_EXPRESSION_OR) {
+        struct pctree_node *n = pctree_node_child(&exp->node);
+        for (; n; n = pctree_node_next(n)) {
+            if (collect_prefixes(rule, container_of(n,
+                            struct string_matching_logical_expression,
+                            node)))
+                return -1;
         }
-    end_foreach;
+        return 0;
+    }
 
-    if (ok) {
-        PCEXE_CLR_VAR(exe_key_inst->result_set);
-        exe_key_inst->result_set = result_set;
-        purc_variant_ref(result_set);
+    if (exp->type != STRING_MATCHING_LOGICAL_EXPRESSION_STR ||
+            exp->smc.type != STRING_MATCHING_LITERAL)
+        return -1;
+
+    struct list_head *p;
+    list_for_each(p, &exp->smc.literals->list) {
+        struct literal_expression *lexp;
+        lexp = container_of(p, struct literal_expression, node);
+        if (lexp->suffix.matching_flags ||
+                lexp->suffix.max_matching_length > 0)
+            return -1;
+        if (append_prefix(rule, lexp->literal))
+            return -1;
     }
+    return 0;
+}
 
-    return ok;
+static int compare_prefixes(const void *l, const void *r)
+{
+    return strcmp(*(char * const *)l, *(char * const *)r);
 }
 
-static inline bool
-prepare_result_set(struct pcexec_exe_key_inst *exe_key_inst)
+/*
+ * A literal matches the keys starting with it, which are adjacent in the
+ * order of the keys of an object. So the literals are sorted, and the ones
+ * starting with another are dropped; the keys matching the rule are then
+ * the ranges of the prefixes in order, and they can be found by seeking
+ * instead of evaluating the rule for every key.
+ */
+static void
+key_rule_compile_prefixes(struct key_rule *rule)
 {
-    purc_variant_t result_set;
-    result_set = purc_variant_make_array(0, PURC_VARIANT_INVALID);
-    if (result_set == PURC_VARIANT_INVALID) {
-        return false;
+    if (!rule->smle)
+        return;
+
+    if (collect_prefixes(rule, rule->smle)) {
+        for (size_t i = 0; i < rule->nr_prefixes; i++)
+            free(rule->prefixes[i]);
+        free(rule->prefixes);
+        rule->prefixes = NULL;
+        rule->nr_prefixes = 0;
+        return;
+    }
+
+    qsort(rule->prefixes, rule->nr_prefixes, sizeof(*rule->prefixes),
+            compare_prefixes);
+
+    size_t n = 0;
+    for (size_t i = 0; i < rule->nr_prefixes; i++) {
+        char *prefix = rule->prefixes[i];
+        if (n > 0 && strncmp(prefix, rule->prefixes[n - 1],
+                    strlen(rule->prefixes[n - 1])) == 0) {
+            free(prefix);
+            continue;
+        }
+        rule->prefixes[n++] = prefix;
     }
+    rule->nr_prefixes = n;
+}
 
-    bool ok = init_result_set(exe_key_inst, result_set);
-    purc_variant_unref(result_set);
+static int
+exe_key_compile_rule(const char *rule, size_t len, void *p, char **err_msg)
+{
+    struct exe_key_param *param = (struct exe_key_param *)p;
+    int r = exe_key_parse(rule, len, param);
+    if (r) {
+        *err_msg = param->err_msg;
+        param->err_msg = NULL;
+        return r;
+    }
 
-    return ok;
+    key_rule_compile_prefixes(&param->rule);
+    return 0;
+}
+
+static void
+exe_key_release_rule(void *p)
+{
+    exe_key_param_reset((struct exe_key_param *)p);
 }
 
 static inline bool
@@ -102,23 +178,21 @@ parse_rule(struct pcexec_exe_key_inst *exe_key_inst,
 {
     purc_exec_inst_t inst = &exe_key_inst->super;
 
-    struct exe_key_param param = {0};
-    int r = exe_key_parse(rule, strlen(rule), &param);
     if (inst->err_msg) {
         free(inst->err_msg);
         inst->err_msg = NULL;
     }
 
-    if (r) {
-        inst->err_msg = param.err_msg;
-        param.err_msg = NULL;
+    struct exe_key_param *param;
+    param = pcexecutor_get_compiled_rule("KEY", rule, sizeof(*param),
+            exe_key_compile_rule, exe_key_release_rule, &inst->err_msg);
+    if (param == NULL)
         return false;
-    }
 
-    exe_key_param_reset(&exe_key_inst->param);
+    pcexecutor_put_compiled_rule(exe_key_inst->param);
     exe_key_inst->param = param;
 
-    return prepare_result_set(exe_key_inst);
+    return true;
 }
 
 int
@@ -134,48 +208,117 @@ key_rule_eval(struct key_rule *rule, purc_variant_t val, bool *result)
     return string_matching_logical_expression_match(smle, val, result);
 }
 
-static inline bool
-check_curr(struct pcexec_exe_key_inst *exe_key_inst)
+// seeks the first member whose key is not less than @key (greater than
+// @key if @after is true), and moves `obj_key` there; clears `obj_key`
+// if there is no more
+static purc_variant_t
+seek_key(struct pcexec_exe_key_inst *exe_key_inst, const char *key,
+        bool after)
 {
-    purc_exec_inst_t inst = &exe_key_inst->super;
-    purc_exec_iter_t it = &inst->it;
-    struct key_rule *rule = &exe_key_inst->param.rule;
-
-    int curr = (int)it->curr;
+    purc_variant_t k;
+    purc_variant_t v = pcvariant_object_lower_bound(
+            exe_key_inst->super.input, key, after, &k);
+    if (v == PURC_VARIANT_INVALID) {
+        purc_clr_error();
+        PCEXE_CLR_VAR(exe_key_inst->obj_key);
+        return PURC_VARIANT_INVALID;
+    }
 
-    if (curr < 0) {
-        pcinst_set_error(PCEXECUTOR_ERROR_NOT_EXISTS);
-        return false;
+    if (k != exe_key_inst->obj_key) {
+        PCEXE_CLR_VAR(exe_key_inst->obj_key);
+        exe_key_inst->obj_key = purc_variant_ref(k);
     }
+    return v;
+}
 
-    purc_variant_t result_set = exe_key_inst->result_set;
-    size_t nr;
-    if (!purc_variant_array_size(result_set, &nr)) {
-        pcinst_set_error(PCEXECUTOR_ERROR_NOT_EXISTS);
-        return false;
+// the member at `obj_key`, or the one after it if the member was removed
+static inline purc_variant_t
+get_member(struct pcexec_exe_key_inst *exe_key_inst)
+{
+    if (!exe_key_inst->obj_key)
+        return PURC_VARIANT_INVALID;
+
+    return seek_key(exe_key_inst,
+            purc_variant_get_string_const(exe_key_inst->obj_key), false);
+}
+
+// moves to the next key-value pair of the input
+static inline void
+step(struct pcexec_exe_key_inst *exe_key_inst)
+{
+    purc_exec_inst_t inst = &exe_key_inst->super;
+
+    inst->it.curr += 1;
+    if (exe_key_inst->obj_key &&
+            !seek_key(exe_key_inst,
+                purc_variant_get_string_const(exe_key_inst->obj_key), true)) {
+        // no key left for the remaining prefixes
+        exe_key_inst->curr_prefix = SIZE_MAX;
     }
+}
 
-    bool result = false;
-    while (!result) {
-        if ((size_t)curr >= nr) {
-            pcinst_set_error(PCEXECUTOR_ERROR_NOT_EXISTS);
-            return false;
+// moves `obj_key` forward to the first key having one of the prefixes
+static void
+seek_prefix(struct pcexec_exe_key_inst *exe_key_inst)
+{
+    struct key_rule *rule = &exe_key_inst->param->rule;
+
+    while (exe_key_inst->curr_prefix < rule->nr_prefixes) {
+        const char *prefix = rule->prefixes[exe_key_inst->curr_prefix];
+
+        // the member at `obj_key` may have been removed
+        purc_variant_t v = exe_key_inst->obj_key ?
+            get_member(exe_key_inst) : seek_key(exe_key_inst, prefix, false);
+        if (v == PURC_VARIANT_INVALID) {
+            // no key after the prefix
+            break;
         }
 
-        purc_variant_t k = purc_variant_array_get(result_set, curr);
-        if (key_rule_eval(rule, k, &result)) {
+        const char *sk = purc_variant_get_string_const(exe_key_inst->obj_key);
+        int r = strncmp(sk, prefix, strlen(prefix));
+        if (r == 0)
+            return;
+
+        if (r < 0) {
+            PCEXE_CLR_VAR(exe_key_inst->obj_key);
+        }
+        else {
+            exe_key_inst->curr_prefix++;
+        }
+    }
+
+    exe_key_inst->curr_prefix = SIZE_MAX;
+    PCEXE_CLR_VAR(exe_key_inst->obj_key);
+}
+
+// scans the input forward to the first key matching the rule, lazily
+static inline bool
+check_curr(struct pcexec_exe_key_inst *exe_key_inst)
+{
+    purc_exec_inst_t inst = &exe_key_inst->super;
+    struct key_rule *rule = &exe_key_inst->param->rule;
+
+    while (true) {
+        if (rule->prefixes)
+            seek_prefix(exe_key_inst);
+
+        purc_variant_t v = get_member(exe_key_inst);
+        if (v == PURC_VARIANT_INVALID)
+            break;
+
+        purc_variant_t k = exe_key_inst->obj_key;
+
+        bool result = true;
+        if (!rule->prefixes && key_rule_eval(rule, k, &result)) {
             // TODO: exception
             PC_ASSERT(0);
             return false;
         }
         if (!result) {
-            curr += 2;
+            step(exe_key_inst);
             continue;
         }
 
-        purc_variant_t v = purc_variant_array_get(result_set, curr+1);
-        PC_ASSERT(v != PURC_VARIANT_INVALID);
-
         purc_variant_t val = PURC_VARIANT_INVALID;
 
         switch (rule->for_clause) {
@@ -193,9 +336,11 @@ check_curr(struct pcexec_exe_key_inst *exe_key_inst)
                 break;
         }
 
+        if (val == PURC_VARIANT_INVALID)
+            return false;
+
         PCEXE_CLR_VAR(inst->value);
         inst->value = val;
-        it->curr = curr;
 
         return true;
     }
@@ -210,6 +355,15 @@ fetch_begin(struct pcexec_exe_key_inst *exe_key_inst)
     purc_exec_inst_t inst = &exe_key_inst->super;
     purc_exec_iter_t it = &inst->it;
     it->curr = 0;
+
+    PCEXE_CLR_VAR(exe_key_inst->obj_key);
+    exe_key_inst->curr_prefix = 0;
+
+    // the key is sought by seek_prefix() if the rule has prefixes;
+    // the empty string is not greater than any key
+    if (!exe_key_inst->param->rule.prefixes)
+        seek_key(exe_key_inst, "", false);
+
     if (check_curr(exe_key_inst)) {
         return it;
     }
@@ -221,7 +375,7 @@ fetch_next(struct pcexec_exe_key_inst *exe_key_inst)
 {
     purc_exec_inst_t inst = &exe_key_inst->super;
     purc_exec_iter_t it = &inst->it;
-    it->curr += 2;
+    step(exe_key_inst);
     if (check_curr(exe_key_inst)) {
         return it;
     }
@@ -266,11 +420,6 @@ exe_key_create(enum purc_exec_type type,
     inst->type        = type;
     inst->asc_desc    = asc_desc;
 
-    int debug_flex, debug_bison;
-    pcexecutor_get_debug(&debug_flex, &debug_bison);
-    exe_key_inst->param.debug_flex  = debug_flex;
-    exe_key_inst->param.debug_bison = debug_bison;
-
     enum purc_variant_type vt = purc_variant_get_type(input);
     if (vt == PURC_VARIANT_TYPE_OBJECT) {
         inst->input = input;
@@ -38,6 +38,11 @@ struct key_rule
 {
     struct string_matching_logical_expression  *smle;
     enum for_clause_type                        for_clause;
+
+    // the prefixes of the keys, sorted, if the rule only contains literals
+    // without any matching suffix, like `KEY: AS "a", "b"`
+    char                                      **prefixes;
+    size_t                                      nr_prefixes;
 };
 
 struct exe_key_param {
@@ -63,6 +68,14 @@ key_rule_release(struct key_rule *rule)
         string_matching_logical_expression_destroy(rule->smle);
         rule->smle = NULL;
     }
+
+    if (rule->prefixes) {
+        for (size_t i = 0; i < rule->nr_prefixes; i++)
+            free(rule->prefixes[i]);
+        free(rule->prefixes);
+        rule->prefixes = NULL;
+        rule->nr_prefixes = 0;
+    }
 }
 
 static inline void
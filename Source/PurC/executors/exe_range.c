@@ -39,126 +39,19 @@
 struct pcexec_exe_range_inst {
     struct purc_exec_inst       super;
 
-    struct exe_range_param        param;
-
-    purc_variant_t              result_set;
+    struct exe_range_param       *param;    // compiled and shared
 };
 
 // clear internal data except `input`
 static inline void
 reset(struct pcexec_exe_range_inst *exe_range_inst)
 {
-    struct exe_range_param *param = &exe_range_inst->param;
-    exe_range_param_reset(param);
+    pcexecutor_put_compiled_rule(exe_range_inst->param);
+    exe_range_inst->param = NULL;
     pcexecutor_inst_reset(&exe_range_inst->super);
-    PCEXE_CLR_VAR(exe_range_inst->result_set);
-}
-
-static inline bool
-init_result_set_with_array(struct pcexec_exe_range_inst *exe_range_inst,
-        purc_variant_t result_set)
-{
-    purc_exec_inst_t inst = &exe_range_inst->super;
-    purc_variant_t input = inst->input;
-
-    bool ok = true;
-    purc_variant_t v;
-    size_t idx;
-    foreach_value_in_variant_array(input, v, idx)
-        (void)idx;
-        if (!purc_variant_array_append(result_set, v)) {
-            ok = false;
-            break;
-        }
-    end_foreach;
-
-    if (ok) {
-        PCEXE_CLR_VAR(exe_range_inst->result_set);
-        exe_range_inst->result_set = result_set;
-        purc_variant_ref(result_set);
-    }
-
-    return ok;
-}
-
-static inline bool
-init_result_set_with_set(struct pcexec_exe_range_inst *exe_range_inst,
-        purc_variant_t result_set)
-{
-    purc_exec_inst_t inst = &exe_range_inst->super;
-    purc_variant_t input = inst->input;
-
-    bool ok = true;
-    purc_variant_t v;
-    // FIXME: document-order or content-order?
-    foreach_value_in_variant_set(input, v)
-        bool ok = purc_variant_array_append(result_set, v);
-        if (!ok)
-            break;
-    end_foreach;
-
-    if (ok) {
-        PCEXE_CLR_VAR(exe_range_inst->result_set);
-        exe_range_inst->result_set = result_set;
-        purc_variant_ref(result_set);
-    }
-
-    return ok;
 }
 
-static inline bool
-init_result_set(struct pcexec_exe_range_inst *exe_range_inst,
-        purc_variant_t result_set)
-{
-    purc_exec_inst_t inst = &exe_range_inst->super;
-    purc_variant_t input = inst->input;
-
-    switch (purc_variant_get_type(input)) {
-        case PURC_VARIANT_TYPE_ARRAY:
-            return init_result_set_with_array(exe_range_inst, result_set);
-        case PURC_VARIANT_TYPE_SET:
-            return init_result_set_with_set(exe_range_inst, result_set);
-        default:
-            PC_ASSERT(0);
-            return false;
-    }
-
-    bool ok = true;
-    purc_variant_t k, v;
-    foreach_key_value_in_variant_object(input, k, v)
-        if (!purc_variant_array_append(result_set, k)) {
-            ok = false;
-            break;
-        }
-        if (!purc_variant_array_append(result_set, v)) {
-            ok = false;
-            break;
-        }
-    end_foreach;
-
-    if (ok) {
-        PCEXE_CLR_VAR(exe_range_inst->result_set);
-        exe_range_inst->result_set = result_set;
-        purc_variant_ref(result_set);
-    }
-
-    return ok;
-}
-
-static inline bool
-prepare_result_set(struct pcexec_exe_range_inst *exe_range_inst)
-{
-    purc_variant_t result_set;
-    result_set = purc_variant_make_array(0, PURC_VARIANT_INVALID);
-    if (result_set == PURC_VARIANT_INVALID) {
-        return false;
-    }
-
-    bool ok = init_result_set(exe_range_inst, result_set);
-    purc_variant_unref(result_set);
-
-    return ok;
-}
+PCEXE_DEFINE_RULE_COMPILER(exe_range)
 
 static inline bool
 parse_rule(struct pcexec_exe_range_inst *exe_range_inst,
@@ -166,23 +59,21 @@ parse_rule(struct pcexec_exe_range_inst *exe_range_inst,
 {
     purc_exec_inst_t inst = &exe_range_inst->super;
 
-    struct exe_range_param param = {0};
-    int r = exe_range_parse(rule, strlen(rule), &param);
     if (inst->err_msg) {
         free(inst->err_msg);
         inst->err_msg = NULL;
     }
 
-    if (r) {
-        inst->err_msg = param.err_msg;
-        param.err_msg = NULL;
+    struct exe_range_param *param;
+    param = pcexecutor_get_compiled_rule("RANGE", rule, sizeof(*param),
+            exe_range_compile_rule, exe_range_release_rule, &inst->err_msg);
+    if (param == NULL)
         return false;
-    }
 
-    exe_range_param_reset(&exe_range_inst->param);
+    pcexecutor_put_compiled_rule(exe_range_inst->param);
     exe_range_inst->param = param;
 
-    return prepare_result_set(exe_range_inst);
+    return true;
 }
 
 static inline bool
@@ -190,7 +81,7 @@ check_curr(struct pcexec_exe_range_inst *exe_range_inst)
 {
     purc_exec_inst_t inst = &exe_range_inst->super;
     purc_exec_iter_t it = &inst->it;
-    struct exe_range_param *param = &exe_range_inst->param;
+    struct exe_range_param *param = exe_range_inst->param;
     struct range_rule *rule = &param->rule;
 
     int curr = (int)it->curr;
@@ -200,14 +91,17 @@ check_curr(struct pcexec_exe_range_inst *exe_range_inst)
         return false;
     }
 
-    purc_variant_t result_set = exe_range_inst->result_set;
-    size_t nr;
-    if (!purc_variant_array_size(result_set, &nr)) {
+    // the members are fetched from the input directly, without a copy
+    purc_variant_t input = inst->input;
+    bool is_array = purc_variant_is_array(input);
+    ssize_t nr = is_array ? purc_variant_array_get_size(input) :
+        purc_variant_set_get_size(input);
+    if (nr < 0) {
         pcinst_set_error(PCEXECUTOR_ERROR_NOT_EXISTS);
         return false;
     }
 
-    if ((size_t)curr >= nr) {
+    if ((size_t)curr >= (size_t)nr) {
         pcinst_set_error(PCEXECUTOR_ERROR_NOT_EXISTS);
         return false;
     }
@@ -226,7 +120,8 @@ check_curr(struct pcexec_exe_range_inst *exe_range_inst)
         }
     }
 
-    purc_variant_t item = purc_variant_array_get(result_set, curr);
+    purc_variant_t item = is_array ? purc_variant_array_get(input, curr) :
+        purc_variant_set_get_by_index(input, curr);
     PCEXE_CLR_VAR(inst->value);
     inst->value = item;
     purc_variant_ref(item);
@@ -240,7 +135,7 @@ fetch_begin(struct pcexec_exe_range_inst *exe_range_inst)
 {
     purc_exec_inst_t inst = &exe_range_inst->super;
     purc_exec_iter_t it = &inst->it;
-    struct exe_range_param *param = &exe_range_inst->param;
+    struct exe_range_param *param = exe_range_inst->param;
     struct range_rule *rule = &param->rule;
     it->curr = rule->from;
     if (check_curr(exe_range_inst)) {
@@ -254,7 +149,7 @@ fetch_next(struct pcexec_exe_range_inst *exe_range_inst)
 {
     purc_exec_inst_t inst = &exe_range_inst->super;
     purc_exec_iter_t it = &inst->it;
-    struct exe_range_param *param = &exe_range_inst->param;
+    struct exe_range_param *param = exe_range_inst->param;
     struct range_rule *rule = &param->rule;
     int advance = 1;
     if (isfinite(rule->advance))
@@ -307,11 +202,6 @@ exe_range_create(enum purc_exec_type type,
     inst->type        = type;
     inst->asc_desc    = asc_desc;
 
-    int debug_flex, debug_bison;
-    pcexecutor_get_debug(&debug_flex, &debug_bison);
-    exe_range_inst->param.debug_flex  = debug_flex;
-    exe_range_inst->param.debug_bison = debug_bison;
-
     enum purc_variant_type vt = purc_variant_get_type(input);
     if (vt == PURC_VARIANT_TYPE_ARRAY ||
         vt == PURC_VARIANT_TYPE_SET)
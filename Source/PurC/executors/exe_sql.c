@@ -24,59 +24,1713 @@
 
 #include "exe_sql.h"
 
+#include "pcexe-helper.h"
+
 #include "private/executor.h"
+#include "private/hashtable.h"
+#include "private/variant.h"
+
+#include "private/debug.h"
+#include "private/errors.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * A rule is executed over a temporary columnar copy of the input: the
+ * members of the input (an array or a set of objects, or one object) are
+ * the rows, and only the keys referenced by the rule become columns. A
+ * column is numeric if all its present values are numbers; its numbers
+ * and strings are extracted once, when first used.
+ *
+ * The expressions are evaluated a column at a time over a vector of the
+ * selected rows; AND and OR narrow the selection for their right operand.
+ * The rows selected, grouped and ordered are kept as indices, and the
+ * value of a row is only made when it is fetched.
+ *
+ * If the input is a set having an index on a key compared with a literal
+ * by a conjunct of WHERE, only the elements found by the index are loaded
+ * as the rows.
+ */
+
+struct sql_exp *
+sql_exp_new(enum sql_exp_type type, struct sql_exp *l, struct sql_exp *r)
+{
+    struct sql_exp *exp = calloc(1, sizeof(*exp));
+    if (!exp)
+        return NULL;
+
+    exp->type = type;
+    exp->l = l;
+    exp->r = r;
+    exp->col = -1;
+    return exp;
+}
+
+void sql_exp_destroy(struct sql_exp *exp)
+{
+    while (exp) {
+        struct sql_exp *next = exp->next;
+
+        sql_exp_destroy(exp->l);
+        sql_exp_destroy(exp->r);
+        free(exp->str);
+        free(exp->sub);
+        if (exp->wildcard)
+            pcutils_wildcard_destroy(exp->wildcard);
+        free(exp);
+
+        exp = next;
+    }
+}
+
+struct sql_item *sql_item_new(struct sql_exp *exp, char *alias)
+{
+    struct sql_item *item = calloc(1, sizeof(*item));
+    if (!item)
+        return NULL;
+
+    item->exp = exp;
+    item->alias = alias;
+    return item;
+}
+
+void sql_item_destroy(struct sql_item *item)
+{
+    while (item) {
+        struct sql_item *next = item->next;
+
+        sql_exp_destroy(item->exp);
+        free(item->alias);
+        free(item);
+
+        item = next;
+    }
+}
+
+void sql_select_destroy(struct sql_select *select)
+{
+    while (select) {
+        struct sql_select *next = select->next;
+
+        sql_item_destroy(select->items);
+        sql_exp_destroy(select->where);
+        sql_exp_destroy(select->group_by);
+        sql_exp_destroy(select->order_by);
+        free(select);
+
+        select = next;
+    }
+}
+
+struct sql_column {
+    const char                 *name;
+    const char                 *sub;
+
+    purc_variant_t             *vals;       // borrowed; INVALID if absent
+    bool                        numeric;
+
+    // the views extracted when first used
+    double                     *nums;       // NAN if absent
+    const char                **strs;       // NULL if absent
+    char                      **bufs;       // the strings made for strs
+};
+
+struct sql_table {
+    purc_variant_t             *rows;       // referenced
+    size_t                      nr_rows;
+
+    struct sql_column          *cols;
+    size_t                      nr_cols;
+    size_t                      sz_cols;
+};
+
+enum sql_vec_type {
+    SQL_VEC_NUMBER,
+    SQL_VEC_STRING,
+    SQL_VEC_BOOL,
+};
+
+// the values of an expression for the selected rows
+struct sql_vec {
+    enum sql_vec_type           type;
+    bool                        scalar;     // one value for all the rows
+    size_t                      nr;
+
+    double                     *nums;
+    const char                **strs;
+    unsigned char              *bools;
+    char                      **bufs;       // the strings owned
+};
+
+#define VEC_AT(_v, _i)      ((_v)->scalar ? 0 : (_i))
+
+struct sql_query {
+    const struct sql_select    *select;
+    struct sql_table            table;
+
+    size_t                     *matched;    // the rows matched by WHERE
+    size_t                      nr_matched;
+    size_t                     *gids;       // the group of a matched row
+
+    size_t                     *rows;       // the rows to return, in order
+    size_t                      nr;
+
+    struct sql_vec             *items;      // the values of the items
+};
+
+struct pcexec_exe_sql_inst {
+    struct purc_exec_inst       super;
+
+    struct exe_sql_param       *param;    // compiled and shared
+
+    struct sql_query           *queries;  // one for a select of UNION
+    size_t                      nr_queries;
+    size_t                      curr_query;
+    size_t                      curr_row;
+};
+
+static void vec_release(struct sql_vec *vec)
+{
+    free(vec->nums);
+    free(vec->strs);
+    free(vec->bools);
+    if (vec->bufs) {
+        for (size_t i = 0; i < vec->nr; i++)
+            free(vec->bufs[i]);
+        free(vec->bufs);
+    }
+    memset(vec, 0, sizeof(*vec));
+}
+
+static int vec_init(struct sql_vec *vec, enum sql_vec_type type,
+        bool scalar, size_t nr)
+{
+    memset(vec, 0, sizeof(*vec));
+    vec->type = type;
+    vec->scalar = scalar;
+    vec->nr = scalar ? 1 : nr;
+
+    size_t n = vec->nr ? vec->nr : 1;
+    switch (type) {
+    case SQL_VEC_NUMBER:
+        vec->nums = malloc(sizeof(*vec->nums) * n);
+        break;
+    case SQL_VEC_STRING:
+        vec->strs = calloc(n, sizeof(*vec->strs));
+        break;
+    case SQL_VEC_BOOL:
+        vec->bools = calloc(n, sizeof(*vec->bools));
+        break;
+    }
+
+    if (!vec->nums && !vec->strs && !vec->bools) {
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+        return -1;
+    }
+    return 0;
+}
+
+static const double *vec_numbers(struct sql_vec *vec)
+{
+    if (vec->nums)
+        return vec->nums;
+
+    vec->nums = malloc(sizeof(*vec->nums) * (vec->nr ? vec->nr : 1));
+    if (!vec->nums) {
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < vec->nr; i++) {
+        if (vec->type == SQL_VEC_BOOL) {
+            vec->nums[i] = vec->bools[i];
+        }
+        else if (vec->strs[i]) {
+            char *end;
+            vec->nums[i] = strtod(vec->strs[i], &end);
+            if (end == vec->strs[i])
+                vec->nums[i] = NAN;
+        }
+        else {
+            vec->nums[i] = NAN;
+        }
+    }
+    return vec->nums;
+}
+
+static const char **vec_strings(struct sql_vec *vec)
+{
+    if (vec->strs)
+        return vec->strs;
+
+    size_t n = vec->nr ? vec->nr : 1;
+    vec->strs = calloc(n, sizeof(*vec->strs));
+    vec->bufs = calloc(n, sizeof(*vec->bufs));
+    if (!vec->strs || !vec->bufs) {
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < vec->nr; i++) {
+        if (vec->type == SQL_VEC_BOOL) {
+            vec->strs[i] = vec->bools[i] ? "true" : "false";
+            continue;
+        }
+
+        if (isnan(vec->nums[i]))
+            continue;
+
+        // the same format as stringifying a number variant
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%g", vec->nums[i]);
+        vec->bufs[i] = strdup(buf);
+        if (!vec->bufs[i]) {
+            pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+            return NULL;
+        }
+        vec->strs[i] = vec->bufs[i];
+    }
+    return vec->strs;
+}
+
+static const unsigned char *vec_bools(struct sql_vec *vec)
+{
+    if (vec->bools)
+        return vec->bools;
+
+    vec->bools = calloc(vec->nr ? vec->nr : 1, sizeof(*vec->bools));
+    if (!vec->bools) {
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < vec->nr; i++) {
+        if (vec->type == SQL_VEC_NUMBER)
+            vec->bools[i] = !isnan(vec->nums[i]) && vec->nums[i] != 0;
+        else
+            vec->bools[i] = vec->strs[i] && vec->strs[i][0];
+    }
+    return vec->bools;
+}
+
+static bool is_number(purc_variant_t v)
+{
+    enum purc_variant_type type = purc_variant_get_type(v);
+    return type == PURC_VARIANT_TYPE_NUMBER ||
+        type == PURC_VARIANT_TYPE_LONGINT ||
+        type == PURC_VARIANT_TYPE_ULONGINT ||
+        type == PURC_VARIANT_TYPE_LONGDOUBLE;
+}
+
+static void column_release(struct sql_column *col, size_t nr_rows)
+{
+    free(col->vals);
+    free(col->nums);
+    free(col->strs);
+    if (col->bufs) {
+        for (size_t i = 0; i < nr_rows; i++)
+            free(col->bufs[i]);
+        free(col->bufs);
+    }
+}
+
+static const double *column_numbers(struct sql_column *col, size_t nr_rows)
+{
+    if (col->nums)
+        return col->nums;
+
+    col->nums = malloc(sizeof(*col->nums) * (nr_rows ? nr_rows : 1));
+    if (!col->nums) {
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < nr_rows; i++) {
+        purc_variant_t v = col->vals[i];
+        col->nums[i] = v ? purc_variant_numberify(v) : NAN;
+    }
+    return col->nums;
+}
+
+static const char **column_strings(struct sql_column *col, size_t nr_rows)
+{
+    if (col->strs)
+        return col->strs;
+
+    size_t n = nr_rows ? nr_rows : 1;
+    col->strs = calloc(n, sizeof(*col->strs));
+    col->bufs = calloc(n, sizeof(*col->bufs));
+    if (!col->strs || !col->bufs) {
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < nr_rows; i++) {
+        purc_variant_t v = col->vals[i];
+        if (v == PURC_VARIANT_INVALID)
+            continue;
+
+        if (purc_variant_is_string(v) || purc_variant_is_atomstring(v)) {
+            col->strs[i] = purc_variant_get_string_const(v);
+        }
+        else if (purc_variant_stringify_alloc(col->bufs + i, v) >= 0) {
+            col->strs[i] = col->bufs[i];
+        }
+        else {
+            col->bufs[i] = NULL;
+            pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+            return NULL;
+        }
+    }
+    return col->strs;
+}
+
+static void table_release(struct sql_table *table)
+{
+    for (size_t i = 0; i < table->nr_cols; i++)
+        column_release(table->cols + i, table->nr_rows);
+    free(table->cols);
+
+    for (size_t i = 0; i < table->nr_rows; i++)
+        purc_variant_unref(table->rows[i]);
+    free(table->rows);
+
+    memset(table, 0, sizeof(*table));
+}
+
+static int table_load_rows(struct sql_table *table, purc_variant_t input,
+        const size_t *positions, size_t nr_positions)
+{
+    size_t nr;
+    enum purc_variant_type type = purc_variant_get_type(input);
+
+    if (positions)
+        nr = nr_positions;
+    else if (type == PURC_VARIANT_TYPE_ARRAY)
+        nr = purc_variant_array_get_size(input);
+    else if (type == PURC_VARIANT_TYPE_SET)
+        nr = purc_variant_set_get_size(input);
+    else
+        nr = 1;
+
+    table->rows = malloc(sizeof(*table->rows) * (nr ? nr : 1));
+    if (!table->rows) {
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+        return -1;
+    }
+
+    for (size_t i = 0; i < nr; i++) {
+        purc_variant_t row;
+        if (positions)
+            row = purc_variant_set_get_by_index(input, positions[i]);
+        else if (type == PURC_VARIANT_TYPE_ARRAY)
+            row = purc_variant_array_get(input, i);
+        else if (type == PURC_VARIANT_TYPE_SET)
+            row = purc_variant_set_get_by_index(input, i);
+        else
+            row = input;
+
+        table->rows[i] = purc_variant_ref(row);
+    }
+    table->nr_rows = nr;
+    return 0;
+}
+
+static purc_variant_t literal_value(const struct sql_exp *exp)
+{
+    if (exp->type == SQL_EXP_NUMBER)
+        return purc_variant_make_number(exp->number);
+    if (exp->type == SQL_EXP_STRING)
+        return purc_variant_make_string(exp->str, false);
+    return PURC_VARIANT_INVALID;
+}
+
+static bool is_indexed_var(const struct sql_exp *exp, purc_variant_t set)
+{
+    return exp->type == SQL_EXP_VAR && !exp->sub &&
+        pcvariant_set_has_index(set, exp->str);
+}
+
+// looks the rows up by the index for a comparison of a key with a literal
+static int
+index_compare(const struct sql_exp *exp, purc_variant_t set,
+        size_t **positions, size_t *nr)
+{
+    const struct sql_exp *var = exp->l, *literal = exp->r;
+    enum sql_exp_type op = exp->type;
+
+    if (!is_indexed_var(var, set)) {
+        // the literal comes first; mirror the operator
+        var = exp->r;
+        literal = exp->l;
+        if (op == SQL_EXP_LT)
+            op = SQL_EXP_GT;
+        else if (op == SQL_EXP_GT)
+            op = SQL_EXP_LT;
+        else if (op == SQL_EXP_LE)
+            op = SQL_EXP_GE;
+        else if (op == SQL_EXP_GE)
+            op = SQL_EXP_LE;
+    }
+
+    if (!is_indexed_var(var, set))
+        return -1;
+
+    purc_variant_t v = literal_value(literal);
+    if (v == PURC_VARIANT_INVALID)
+        return -1;
+
+    purc_variant_t lo = PURC_VARIANT_INVALID, hi = PURC_VARIANT_INVALID;
+    bool lo_incl = true, hi_incl = true;
+    switch (op) {
+    case SQL_EXP_EQ:
+        lo = hi = v;
+        break;
+    case SQL_EXP_GT:
+        lo_incl = false;
+        lo = v;
+        break;
+    case SQL_EXP_GE:
+        lo = v;
+        break;
+    case SQL_EXP_LT:
+        hi_incl = false;
+        hi = v;
+        break;
+    default:
+        hi = v;
+        break;
+    }
+
+    int r = pcvariant_set_index_lookup(set, var->str, lo, lo_incl,
+            hi, hi_incl, positions, nr);
+    purc_variant_unref(v);
+    return r;
+}
+
+static int compare_positions(const void *l, const void *r)
+{
+    size_t a = *(const size_t *)l;
+    size_t b = *(const size_t *)r;
+    return (a > b) - (a < b);
+}
+
+// looks the rows up by the index for each member of IN
+static int
+index_in(const struct sql_exp *exp, purc_variant_t set,
+        size_t **positions, size_t *nr)
+{
+    if (!is_indexed_var(exp->l, set))
+        return -1;
+
+    size_t *all = NULL, nr_all = 0;
+    for (const struct sql_exp *e = exp->r; e; e = e->next) {
+        purc_variant_t v = literal_value(e);
+        if (v == PURC_VARIANT_INVALID)
+            goto failed;
+
+        size_t *found, nr_found;
+        int r = pcvariant_set_index_lookup(set, exp->l->str, v, true,
+                v, true, &found, &nr_found);
+        purc_variant_unref(v);
+        if (r)
+            goto failed;
+
+        size_t *p = realloc(all, sizeof(*all) * (nr_all + nr_found + 1));
+        if (!p) {
+            free(found);
+            pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+            goto failed;
+        }
+        all = p;
+        memcpy(all + nr_all, found, sizeof(*all) * nr_found);
+        nr_all += nr_found;
+        free(found);
+    }
+
+    // the positions in order, once each
+    qsort(all, nr_all, sizeof(*all), compare_positions);
+
+    size_t n = 0;
+    for (size_t i = 0; i < nr_all; i++) {
+        if (n == 0 || all[n - 1] != all[i])
+            all[n++] = all[i];
+    }
+
+    *positions = all;
+    *nr = n;
+    return 0;
+
+failed:
+    free(all);
+    return -1;
+}
+
+// the positions of the rows which may be matched by @where, by an index
+static int
+index_lookup(const struct sql_exp *where, purc_variant_t set,
+        size_t **positions, size_t *nr)
+{
+    switch (where->type) {
+    case SQL_EXP_AND:
+        if (index_lookup(where->l, set, positions, nr) == 0)
+            return 0;
+        return index_lookup(where->r, set, positions, nr);
+
+    case SQL_EXP_EQ:
+    case SQL_EXP_LT:
+    case SQL_EXP_GT:
+    case SQL_EXP_LE:
+    case SQL_EXP_GE:
+        return index_compare(where, set, positions, nr);
+
+    case SQL_EXP_IN:
+        return index_in(where, set, positions, nr);
+
+    default:
+        break;
+    }
+
+    return -1;
+}
+
+static int table_find_column(struct sql_table *table, struct sql_exp *var)
+{
+    for (size_t i = 0; i < table->nr_cols; i++) {
+        struct sql_column *col = table->cols + i;
+        if (strcmp(col->name, var->str) == 0 &&
+                ((!col->sub && !var->sub) ||
+                 (col->sub && var->sub && strcmp(col->sub, var->sub) == 0)))
+            return (int)i;
+    }
+
+    if (table->nr_cols == table->sz_cols) {
+        size_t sz = table->sz_cols ? table->sz_cols * 2 : 4;
+        struct sql_column *cols;
+        cols = realloc(table->cols, sizeof(*cols) * sz);
+        if (!cols) {
+            pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+            return -1;
+        }
+        table->cols = cols;
+        table->sz_cols = sz;
+    }
+
+    size_t nr_rows = table->nr_rows;
+    struct sql_column *col = table->cols + table->nr_cols;
+    memset(col, 0, sizeof(*col));
+    col->name = var->str;
+    col->sub = var->sub;
+    col->vals = calloc(nr_rows ? nr_rows : 1, sizeof(*col->vals));
+    if (!col->vals) {
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+        return -1;
+    }
+
+    bool missed = false;
+    size_t nr_present = 0, nr_numbers = 0;
+    for (size_t i = 0; i < nr_rows; i++) {
+        purc_variant_t v = table->rows[i];
+        v = purc_variant_is_object(v) ?
+            purc_variant_object_get_by_ckey(v, col->name) :
+            PURC_VARIANT_INVALID;
+        if (v && col->sub) {
+            v = purc_variant_is_object(v) ?
+                purc_variant_object_get_by_ckey(v, col->sub) :
+                PURC_VARIANT_INVALID;
+        }
+
+        col->vals[i] = v;
+        if (v == PURC_VARIANT_INVALID) {
+            missed = true;
+            continue;
+        }
+
+        nr_present++;
+        if (is_number(v))
+            nr_numbers++;
+    }
+
+    // an absent key is not an error
+    if (missed)
+        purc_clr_error();
+
+    col->numeric = nr_present > 0 && nr_numbers == nr_present;
+    return (int)table->nr_cols++;
+}
+
+// assigns the columns to the vars of @exp and the ones chained to it
+static int bind_columns(struct sql_table *table, struct sql_exp *exp)
+{
+    for (; exp; exp = exp->next) {
+        if (exp->type == SQL_EXP_VAR) {
+            exp->col = table_find_column(table, exp);
+            if (exp->col < 0)
+                return -1;
+        }
+
+        if (bind_columns(table, exp->l) || bind_columns(table, exp->r))
+            return -1;
+    }
+
+    return 0;
+}
+
+static int
+eval_exp(struct sql_query *q, struct sql_exp *exp, const size_t *sel,
+        size_t nr, struct sql_vec *out);
+
+static int
+eval_var(struct sql_query *q, struct sql_exp *exp, const size_t *sel,
+        size_t nr, struct sql_vec *out)
+{
+    struct sql_table *table = &q->table;
+    struct sql_column *col = table->cols + exp->col;
+
+    if (col->numeric) {
+        const double *nums = column_numbers(col, table->nr_rows);
+        if (!nums || vec_init(out, SQL_VEC_NUMBER, false, nr))
+            return -1;
+        for (size_t i = 0; i < nr; i++)
+            out->nums[i] = nums[sel[i]];
+    }
+    else {
+        const char **strs = column_strings(col, table->nr_rows);
+        if (!strs || vec_init(out, SQL_VEC_STRING, false, nr))
+            return -1;
+        for (size_t i = 0; i < nr; i++)
+            out->strs[i] = strs[sel[i]];
+    }
+
+    return 0;
+}
+
+static int
+eval_arith(struct sql_query *q, struct sql_exp *exp, const size_t *sel,
+        size_t nr, struct sql_vec *out)
+{
+    struct sql_vec lv, rv;
+    int ret = -1;
+
+    if (eval_exp(q, exp->l, sel, nr, &lv))
+        return -1;
+
+    if (exp->type == SQL_EXP_NEG) {
+        const double *ln = vec_numbers(&lv);
+        if (ln && vec_init(out, SQL_VEC_NUMBER, lv.scalar, nr) == 0) {
+            for (size_t i = 0; i < out->nr; i++)
+                out->nums[i] = -ln[i];
+            ret = 0;
+        }
+        vec_release(&lv);
+        return ret;
+    }
+
+    if (eval_exp(q, exp->r, sel, nr, &rv)) {
+        vec_release(&lv);
+        return -1;
+    }
+
+    const double *ln = vec_numbers(&lv);
+    const double *rn = vec_numbers(&rv);
+    if (!ln || !rn ||
+            vec_init(out, SQL_VEC_NUMBER, lv.scalar && rv.scalar, nr))
+        goto done;
+
+    for (size_t i = 0; i < out->nr; i++) {
+        double a = ln[VEC_AT(&lv, i)];
+        double b = rn[VEC_AT(&rv, i)];
+        switch (exp->type) {
+        case SQL_EXP_ADD:
+            out->nums[i] = a + b;
+            break;
+        case SQL_EXP_SUB:
+            out->nums[i] = a - b;
+            break;
+        case SQL_EXP_MUL:
+            out->nums[i] = a * b;
+            break;
+        default:
+            out->nums[i] = a / b;
+            break;
+        }
+    }
+    ret = 0;
+
+done:
+    vec_release(&lv);
+    vec_release(&rv);
+    return ret;
+}
+
+static inline unsigned char test_order(enum sql_exp_type op, int order)
+{
+    switch (op) {
+    case SQL_EXP_EQ:
+    case SQL_EXP_IN:
+        return order == 0;
+    case SQL_EXP_NE:
+        return order != 0;
+    case SQL_EXP_LT:
+        return order < 0;
+    case SQL_EXP_GT:
+        return order > 0;
+    case SQL_EXP_LE:
+        return order <= 0;
+    default:
+        return order >= 0;
+    }
+}
+
+// compares by numbers if either side is not a string; absent values
+// compare false
+static int
+compare_vecs(enum sql_exp_type op, struct sql_vec *lv, struct sql_vec *rv,
+        size_t nr, unsigned char *res)
+{
+    if (lv->type != SQL_VEC_STRING || rv->type != SQL_VEC_STRING) {
+        const double *ln = vec_numbers(lv);
+        const double *rn = vec_numbers(rv);
+        if (!ln || !rn)
+            return -1;
+
+        for (size_t i = 0; i < nr; i++) {
+            double a = ln[VEC_AT(lv, i)];
+            double b = rn[VEC_AT(rv, i)];
+            if (isnan(a) || isnan(b))
+                res[i] = 0;
+            else
+                res[i] = test_order(op, (a > b) - (a < b));
+        }
+    }
+    else {
+        for (size_t i = 0; i < nr; i++) {
+            const char *a = lv->strs[VEC_AT(lv, i)];
+            const char *b = rv->strs[VEC_AT(rv, i)];
+            if (!a || !b)
+                res[i] = 0;
+            else
+                res[i] = test_order(op, strcmp(a, b));
+        }
+    }
+
+    return 0;
+}
+
+static int
+eval_compare(struct sql_query *q, struct sql_exp *exp, const size_t *sel,
+        size_t nr, struct sql_vec *out)
+{
+    struct sql_vec lv, rv;
+    int ret = -1;
+
+    if (eval_exp(q, exp->l, sel, nr, &lv))
+        return -1;
+    if (eval_exp(q, exp->r, sel, nr, &rv)) {
+        vec_release(&lv);
+        return -1;
+    }
+
+    if (vec_init(out, SQL_VEC_BOOL, lv.scalar && rv.scalar, nr) == 0)
+        ret = compare_vecs(exp->type, &lv, &rv, out->nr, out->bools);
+
+    vec_release(&lv);
+    vec_release(&rv);
+    return ret;
+}
+
+static int
+eval_in(struct sql_query *q, struct sql_exp *exp, const size_t *sel,
+        size_t nr, struct sql_vec *out)
+{
+    struct sql_vec lv;
+    unsigned char *tmp = NULL;
+    int ret = -1;
+
+    if (eval_exp(q, exp->l, sel, nr, &lv))
+        return -1;
+
+    if (vec_init(out, SQL_VEC_BOOL, lv.scalar, nr))
+        goto done;
+
+    tmp = malloc(out->nr ? out->nr : 1);
+    if (!tmp) {
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+        goto done;
+    }
+
+    for (struct sql_exp *e = exp->r; e; e = e->next) {
+        struct sql_vec ev;
+        if (eval_exp(q, e, sel, nr, &ev))
+            goto done;
+
+        if (!ev.scalar && out->scalar) {
+            // a member depending on the row makes the result a vector
+            struct sql_vec vv;
+            if (vec_init(&vv, SQL_VEC_BOOL, false, nr)) {
+                vec_release(&ev);
+                goto done;
+            }
+            memset(vv.bools, out->bools[0], nr);
+            vec_release(out);
+            *out = vv;
+
+            unsigned char *t = realloc(tmp, nr ? nr : 1);
+            if (!t) {
+                vec_release(&ev);
+                pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+                goto done;
+            }
+            tmp = t;
+        }
+
+        int r = compare_vecs(SQL_EXP_IN, &lv, &ev, out->nr, tmp);
+        vec_release(&ev);
+        if (r)
+            goto done;
+
+        for (size_t i = 0; i < out->nr; i++)
+            out->bools[i] |= tmp[i];
+    }
+    ret = 0;
+
+done:
+    free(tmp);
+    vec_release(&lv);
+    return ret;
+}
+
+// the pattern of LIKE is a wildcard like the one of FILTER
+static struct pcutils_wildcard *like_pattern(struct sql_exp *pattern)
+{
+    struct pcutils_wildcard *wildcard;
+    wildcard = pcutils_wildcard_create(pattern->str, strlen(pattern->str));
+    if (!wildcard)
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+    return wildcard;
+}
+
+static int
+eval_like(struct sql_query *q, struct sql_exp *exp, const size_t *sel,
+        size_t nr, struct sql_vec *out)
+{
+    if (exp->r->type != SQL_EXP_STRING) {
+        pcinst_set_error(PCEXECUTOR_ERROR_NOT_IMPLEMENTED);
+        return -1;
+    }
+
+    if (!exp->wildcard) {
+        exp->wildcard = like_pattern(exp->r);
+        if (!exp->wildcard)
+            return -1;
+    }
+
+    struct sql_vec lv;
+    int ret = -1;
+
+    if (eval_exp(q, exp->l, sel, nr, &lv))
+        return -1;
+
+    const char **strs = vec_strings(&lv);
+    if (!strs || vec_init(out, SQL_VEC_BOOL, lv.scalar, nr))
+        goto done;
+
+    for (size_t i = 0; i < out->nr; i++) {
+        bool matched = false;
+        if (strs[i] && pcutils_wildcard_match(exp->wildcard, strs[i],
+                    strlen(strs[i]), &matched) == 0)
+            out->bools[i] = matched;
+    }
+    ret = 0;
+
+done:
+    vec_release(&lv);
+    return ret;
+}
+
+static int
+eval_bools(struct sql_query *q, struct sql_exp *exp, const size_t *sel,
+        size_t nr, struct sql_vec *out)
+{
+    if (eval_exp(q, exp, sel, nr, out))
+        return -1;
+
+    if (out->type != SQL_VEC_BOOL) {
+        unsigned char *bools = (unsigned char *)vec_bools(out);
+        if (!bools) {
+            vec_release(out);
+            return -1;
+        }
+
+        // keep the truth values only
+        bool scalar = out->scalar;
+        size_t n = out->nr;
+        out->bools = NULL;
+        vec_release(out);
+        out->type = SQL_VEC_BOOL;
+        out->scalar = scalar;
+        out->nr = n;
+        out->bools = bools;
+    }
+    return 0;
+}
+
+static int
+eval_not(struct sql_query *q, struct sql_exp *exp, const size_t *sel,
+        size_t nr, struct sql_vec *out)
+{
+    if (eval_bools(q, exp->l, sel, nr, out))
+        return -1;
+
+    for (size_t i = 0; i < out->nr; i++)
+        out->bools[i] = !out->bools[i];
+    return 0;
+}
+
+// the right operand is evaluated only for the rows the left one leaves
+// undecided
+static int
+eval_logical(struct sql_query *q, struct sql_exp *exp, const size_t *sel,
+        size_t nr, struct sql_vec *out)
+{
+    unsigned char undecided = (exp->type == SQL_EXP_AND);
+    struct sql_vec lv, rv;
+    size_t *sub = NULL;
+    int ret = -1;
+
+    if (eval_bools(q, exp->l, sel, nr, &lv))
+        return -1;
+
+    if (lv.scalar) {
+        unsigned char b = lv.bools[0];
+        vec_release(&lv);
+        if (b == undecided)
+            return eval_bools(q, exp->r, sel, nr, out);
+
+        if (vec_init(out, SQL_VEC_BOOL, true, nr))
+            return -1;
+        out->bools[0] = b;
+        return 0;
+    }
+
+    if (vec_init(out, SQL_VEC_BOOL, false, nr))
+        goto done;
+
+    sub = malloc(sizeof(*sub) * (nr ? nr : 1));
+    if (!sub) {
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+        goto done;
+    }
+
+    size_t nr_sub = 0;
+    for (size_t i = 0; i < nr; i++) {
+        out->bools[i] = lv.bools[i];
+        if (lv.bools[i] == undecided)
+            sub[nr_sub++] = sel[i];
+    }
+
+    if (nr_sub > 0) {
+        if (eval_bools(q, exp->r, sub, nr_sub, &rv))
+            goto done;
+
+        for (size_t i = 0, j = 0; i < nr; i++) {
+            if (lv.bools[i] == undecided) {
+                out->bools[i] = rv.bools[VEC_AT(&rv, j)];
+                j++;
+            }
+        }
+        vec_release(&rv);
+    }
+    ret = 0;
+
+done:
+    free(sub);
+    vec_release(&lv);
+    return ret;
+}
+
+static int
+eval_exp(struct sql_query *q, struct sql_exp *exp, const size_t *sel,
+        size_t nr, struct sql_vec *out)
+{
+    memset(out, 0, sizeof(*out));
+
+    switch (exp->type) {
+    case SQL_EXP_NUMBER:
+        if (vec_init(out, SQL_VEC_NUMBER, true, nr))
+            return -1;
+        out->nums[0] = exp->number;
+        return 0;
+
+    case SQL_EXP_STRING:
+        if (vec_init(out, SQL_VEC_STRING, true, nr))
+            return -1;
+        out->strs[0] = exp->str;
+        return 0;
+
+    case SQL_EXP_VAR:
+        return eval_var(q, exp, sel, nr, out);
+
+    case SQL_EXP_LIKE:
+        return eval_like(q, exp, sel, nr, out);
+
+    case SQL_EXP_IN:
+        return eval_in(q, exp, sel, nr, out);
+
+    case SQL_EXP_AND:
+    case SQL_EXP_OR:
+        return eval_logical(q, exp, sel, nr, out);
+
+    case SQL_EXP_NOT:
+        return eval_not(q, exp, sel, nr, out);
+
+    case SQL_EXP_EQ:
+    case SQL_EXP_NE:
+    case SQL_EXP_LT:
+    case SQL_EXP_GT:
+    case SQL_EXP_LE:
+    case SQL_EXP_GE:
+        return eval_compare(q, exp, sel, nr, out);
+
+    case SQL_EXP_ADD:
+    case SQL_EXP_SUB:
+    case SQL_EXP_MUL:
+    case SQL_EXP_DIV:
+    case SQL_EXP_NEG:
+        return eval_arith(q, exp, sel, nr, out);
+
+    // `*` and `&` have no values in an expression, and `@attr` is not
+    // supported yet; see TODO.md
+    case SQL_EXP_ALL:
+    case SQL_EXP_SELF:
+    case SQL_EXP_ATTR:
+        break;
+    }
+
+    pcinst_set_error(PCEXECUTOR_ERROR_NOT_IMPLEMENTED);
+    return -1;
+}
+
+static int query_where(struct sql_query *q)
+{
+    size_t nr_rows = q->table.nr_rows;
+
+    q->matched = malloc(sizeof(*q->matched) * (nr_rows ? nr_rows : 1));
+    if (!q->matched) {
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+        return -1;
+    }
+
+    for (size_t i = 0; i < nr_rows; i++)
+        q->matched[i] = i;
+    q->nr_matched = nr_rows;
+
+    if (!q->select->where || nr_rows == 0)
+        return 0;
+
+    struct sql_vec res;
+    if (eval_bools(q, q->select->where, q->matched, nr_rows, &res))
+        return -1;
+
+    size_t n = 0;
+    for (size_t i = 0; i < nr_rows; i++) {
+        if (res.bools[VEC_AT(&res, i)])
+            q->matched[n++] = i;
+    }
+    q->nr_matched = n;
+
+    vec_release(&res);
+    return 0;
+}
+
+struct sql_keybuf {
+    char           *buf;
+    size_t          len;
+    size_t          sz;
+};
+
+static int keybuf_append(struct sql_keybuf *kb, const char *str, size_t len)
+{
+    if (kb->len + len + 1 > kb->sz) {
+        size_t sz = (kb->len + len + 1) * 2;
+        char *buf = realloc(kb->buf, sz);
+        if (!buf) {
+            pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+            return -1;
+        }
+        kb->buf = buf;
+        kb->sz = sz;
+    }
+
+    memcpy(kb->buf + kb->len, str, len);
+    kb->len += len;
+    kb->buf[kb->len] = 0;
+    return 0;
+}
+
+// the key of the group of @row, with the values separated by @sep
+static int
+group_key(struct sql_query *q, size_t row, char sep, struct sql_keybuf *kb)
+{
+    kb->len = 0;
+    if (keybuf_append(kb, "", 0))
+        return -1;
+
+    for (struct sql_exp *var = q->select->group_by; var; var = var->next) {
+        struct sql_column *col = q->table.cols + var->col;
+        const char **strs = column_strings(col, q->table.nr_rows);
+        if (!strs)
+            return -1;
+
+        if (var != q->select->group_by && keybuf_append(kb, &sep, 1))
+            return -1;
+
+        const char *str = strs[row] ? strs[row] : "undefined";
+        if (keybuf_append(kb, str, strlen(str)))
+            return -1;
+    }
+
+    return 0;
+}
+
+static void free_group_key(struct pchash_entry *e)
+{
+    free(pchash_entry_k(e));
+}
+
+// a group is kept as the first row of it
+static int query_group(struct sql_query *q)
+{
+    size_t nr = q->nr_matched;
+
+    q->rows = malloc(sizeof(*q->rows) * (nr ? nr : 1));
+    if (!q->rows) {
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+        return -1;
+    }
+
+    if (!q->select->group_by) {
+        memcpy(q->rows, q->matched, sizeof(*q->rows) * nr);
+        q->nr = nr;
+        return 0;
+    }
+
+    q->gids = malloc(sizeof(*q->gids) * (nr ? nr : 1));
+    struct pchash_table *groups = pchash_kstr_table_new(
+            HASHTABLE_DEFAULT_SIZE, free_group_key);
+    struct sql_keybuf kb = { NULL, 0, 0 };
+    int ret = -1;
+
+    if (!q->gids || !groups) {
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+        goto done;
+    }
+
+    q->nr = 0;
+    for (size_t i = 0; i < nr; i++) {
+        size_t row = q->matched[i];
+        if (group_key(q, row, '\x1f', &kb))
+            goto done;
+
+        void *gid;
+        if (pchash_table_lookup_ex(groups, kb.buf, &gid)) {
+            q->gids[i] = (uintptr_t)gid;
+            continue;
+        }
+
+        char *key = strdup(kb.buf);
+        if (!key || pchash_table_insert(groups, key,
+                    (void *)(uintptr_t)q->nr)) {
+            free(key);
+            pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+            goto done;
+        }
+        q->gids[i] = q->nr;
+        q->rows[q->nr++] = row;
+    }
+    ret = 0;
+
+done:
+    free(kb.buf);
+    if (groups)
+        pchash_table_free(groups);
+    return ret;
+}
+
+struct sql_order_key {
+    bool                numeric;
+    const double       *nums;
+    const char        **strs;
+};
+
+static int
+compare_rows(const struct sql_order_key *keys, size_t nr_keys, bool desc,
+        size_t a, size_t b)
+{
+    for (size_t i = 0; i < nr_keys; i++) {
+        const struct sql_order_key *key = keys + i;
+        int ret;
+
+        if (key->numeric) {
+            double x = key->nums[a], y = key->nums[b];
+            // the absent values come first
+            if (isnan(x) || isnan(y))
+                ret = !isnan(x) - !isnan(y);
+            else
+                ret = (x > y) - (x < y);
+        }
+        else {
+            const char *x = key->strs[a], *y = key->strs[b];
+            if (!x || !y)
+                ret = (x != NULL) - (y != NULL);
+            else
+                ret = strcmp(x, y);
+        }
+
+        if (ret)
+            return desc ? -ret : ret;
+    }
+
+    return 0;
+}
+
+// a stable merge sort of the row indices
+static void
+sort_rows(size_t *rows, size_t *tmp, size_t nr,
+        const struct sql_order_key *keys, size_t nr_keys, bool desc)
+{
+    if (nr < 2)
+        return;
+
+    size_t half = nr / 2;
+    sort_rows(rows, tmp, half, keys, nr_keys, desc);
+    sort_rows(rows + half, tmp, nr - half, keys, nr_keys, desc);
+
+    size_t i = 0, j = half, k = 0;
+    while (i < half && j < nr) {
+        if (compare_rows(keys, nr_keys, desc, rows[j], rows[i]) < 0)
+            tmp[k++] = rows[j++];
+        else
+            tmp[k++] = rows[i++];
+    }
+    while (i < half)
+        tmp[k++] = rows[i++];
+    while (j < nr)
+        tmp[k++] = rows[j++];
+
+    memcpy(rows, tmp, sizeof(*rows) * nr);
+}
+
+static int query_order(struct sql_query *q)
+{
+    if (!q->select->order_by || q->nr < 2)
+        return 0;
+
+    size_t nr_keys = 0;
+    for (struct sql_exp *var = q->select->order_by; var; var = var->next)
+        nr_keys++;
+
+    struct sql_order_key *keys = calloc(nr_keys, sizeof(*keys));
+    size_t *tmp = malloc(sizeof(*tmp) * q->nr);
+    int ret = -1;
+
+    if (!keys || !tmp) {
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+        goto done;
+    }
+
+    size_t i = 0;
+    for (struct sql_exp *var = q->select->order_by; var; var = var->next) {
+        struct sql_column *col = q->table.cols + var->col;
+        keys[i].numeric = col->numeric;
+        if (col->numeric)
+            keys[i].nums = column_numbers(col, q->table.nr_rows);
+        else
+            keys[i].strs = column_strings(col, q->table.nr_rows);
+        if (!keys[i].nums && !keys[i].strs)
+            goto done;
+        i++;
+    }
+
+    sort_rows(q->rows, tmp, q->nr, keys, nr_keys, q->select->desc);
+    ret = 0;
+
+done:
+    free(keys);
+    free(tmp);
+    return ret;
+}
+
+static bool is_row_item(const struct sql_item *item)
+{
+    return item->exp->type == SQL_EXP_ALL || item->exp->type == SQL_EXP_SELF;
+}
+
+// evaluates the items other than the vars and the rows for the result
+static int query_items(struct sql_query *q)
+{
+    size_t nr_items = 0;
+    for (struct sql_item *item = q->select->items; item; item = item->next)
+        nr_items++;
+
+    q->items = calloc(nr_items, sizeof(*q->items));
+    if (!q->items) {
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+        return -1;
+    }
 
-#include "private/debug.h"
-#include "private/errors.h"
+    size_t i = 0;
+    for (struct sql_item *item = q->select->items; item; item = item->next) {
+        struct sql_vec *vec = q->items + i++;
+        if (item->exp->type == SQL_EXP_VAR || is_row_item(item) ||
+                q->nr == 0)
+            continue;
 
-struct pcexec_exe_sql_inst {
-    struct purc_exec_inst       super;
-};
+        if (eval_exp(q, item->exp, q->rows, q->nr, vec))
+            return -1;
+    }
+
+    return 0;
+}
+
+static void query_release(struct sql_query *q)
+{
+    if (q->items) {
+        size_t i = 0;
+        for (struct sql_item *item = q->select->items; item;
+                item = item->next)
+            vec_release(q->items + i++);
+        free(q->items);
+    }
+
+    free(q->rows);
+    free(q->gids);
+    free(q->matched);
+    table_release(&q->table);
+    memset(q, 0, sizeof(*q));
+}
+
+static int
+query_run(struct sql_query *q, const struct sql_select *select,
+        purc_variant_t input)
+{
+    memset(q, 0, sizeof(*q));
+    q->select = select;
+
+    // TRAVEL IN is not supported yet; see TODO.md
+    if (select->travel != SQL_TRAVEL_NONE) {
+        pcinst_set_error(PCEXECUTOR_ERROR_NOT_IMPLEMENTED);
+        return -1;
+    }
+
+    size_t *positions = NULL, nr_positions = 0;
+    if (select->where && purc_variant_is_set(input) &&
+            index_lookup(select->where, input, &positions, &nr_positions)) {
+        // no index to use; scan all the elements
+        positions = NULL;
+        purc_clr_error();
+    }
+
+    int r = table_load_rows(&q->table, input, positions, nr_positions);
+    free(positions);
+    if (r)
+        return -1;
+
+    for (struct sql_item *item = select->items; item; item = item->next) {
+        if (bind_columns(&q->table, item->exp))
+            return -1;
+    }
+
+    if (bind_columns(&q->table, select->where) ||
+            bind_columns(&q->table, select->group_by) ||
+            bind_columns(&q->table, select->order_by))
+        return -1;
+
+    if (query_where(q) || query_group(q) || query_order(q) ||
+            query_items(q))
+        return -1;
+
+    return 0;
+}
+
+static purc_variant_t vec_value(struct sql_vec *vec, size_t i)
+{
+    i = VEC_AT(vec, i);
+    switch (vec->type) {
+    case SQL_VEC_NUMBER:
+        return purc_variant_make_number(vec->nums[i]);
+    case SQL_VEC_BOOL:
+        return purc_variant_make_boolean(vec->bools[i]);
+    case SQL_VEC_STRING:
+        break;
+    }
+
+    if (vec->strs[i])
+        return purc_variant_make_string(vec->strs[i], false);
+    return purc_variant_make_null();
+}
+
+// the key of the @n-th item in the result; @name is the buffer for a
+// generated one
+static const char *
+item_name(const struct sql_item *item, size_t n, char name[32])
+{
+    if (item->alias)
+        return item->alias;
+    if (item->exp->type == SQL_EXP_VAR)
+        return item->exp->sub ? item->exp->sub : item->exp->str;
+
+    snprintf(name, 32, "_%u", (unsigned)n);
+    return name;
+}
+
+// the key is copied, for a name of an item lives in the rule or on the stack
+static bool
+object_set_by_ckey(purc_variant_t obj, const char *key, purc_variant_t val)
+{
+    purc_variant_t k = purc_variant_make_string(key, false);
+    if (k == PURC_VARIANT_INVALID)
+        return false;
+
+    bool ok = purc_variant_object_set(obj, k, val);
+    purc_variant_unref(k);
+    return ok;
+}
+
+// the value of the @i-th row of the result
+static purc_variant_t query_value(struct sql_query *q, size_t i)
+{
+    struct sql_item *items = q->select->items;
+    size_t row = q->rows[i];
+    purc_variant_t val = q->table.rows[row];
+
+    if (!items->next && is_row_item(items))
+        return purc_variant_ref(val);
+
+    purc_variant_t obj = purc_variant_make_object(0,
+            PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+    if (obj == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    size_t n = 0;
+    for (struct sql_item *item = items; item; item = item->next, n++) {
+        struct sql_exp *exp = item->exp;
+
+        if (exp->type == SQL_EXP_ALL) {
+            // all the members of the row
+            if (purc_variant_is_object(val) &&
+                    !purc_variant_object_merge_another(obj, val, false))
+                goto failed;
+            continue;
+        }
+
+        char name[32];
+        const char *key = item_name(item, n, name);
+
+        purc_variant_t v;
+        if (exp->type == SQL_EXP_SELF) {
+            v = purc_variant_ref(val);
+        }
+        else if (exp->type == SQL_EXP_VAR) {
+            v = q->table.cols[exp->col].vals[row];
+            v = v ? purc_variant_ref(v) : purc_variant_make_null();
+        }
+        else {
+            v = vec_value(q->items + n, i);
+        }
+        if (v == PURC_VARIANT_INVALID)
+            goto failed;
+
+        bool ok = object_set_by_ckey(obj, key, v);
+        purc_variant_unref(v);
+        if (!ok)
+            goto failed;
+    }
+
+    return obj;
+
+failed:
+    purc_variant_unref(obj);
+    return PURC_VARIANT_INVALID;
+}
+
+// clear internal data except `input`
+static inline void
+reset(struct pcexec_exe_sql_inst *exe_sql_inst)
+{
+    for (size_t i = 0; i < exe_sql_inst->nr_queries; i++)
+        query_release(exe_sql_inst->queries + i);
+    PCEXE_FREE(exe_sql_inst->queries);
+    exe_sql_inst->nr_queries = 0;
+
+    pcexecutor_put_compiled_rule(exe_sql_inst->param);
+    exe_sql_inst->param = NULL;
+    pcexecutor_inst_reset(&exe_sql_inst->super);
+}
+
+PCEXE_DEFINE_RULE_COMPILER(exe_sql)
+
+static inline bool
+run_queries(struct pcexec_exe_sql_inst *exe_sql_inst)
+{
+    purc_exec_inst_t inst = &exe_sql_inst->super;
+
+    size_t nr = 0;
+    for (struct sql_select *s = exe_sql_inst->param->select; s; s = s->next)
+        nr++;
+
+    exe_sql_inst->queries = calloc(nr, sizeof(*exe_sql_inst->queries));
+    if (!exe_sql_inst->queries) {
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+        return false;
+    }
+
+    struct sql_select *select = exe_sql_inst->param->select;
+    for (; select; select = select->next) {
+        struct sql_query *q;
+        q = exe_sql_inst->queries + exe_sql_inst->nr_queries++;
+        if (query_run(q, select, inst->input))
+            return false;
+    }
+
+    return true;
+}
+
+static inline bool
+parse_rule(struct pcexec_exe_sql_inst *exe_sql_inst,
+        const char* rule)
+{
+    purc_exec_inst_t inst = &exe_sql_inst->super;
+
+    if (inst->err_msg) {
+        free(inst->err_msg);
+        inst->err_msg = NULL;
+    }
+
+    struct exe_sql_param *param;
+    param = pcexecutor_get_compiled_rule("SQL", rule, sizeof(*param),
+            exe_sql_compile_rule, exe_sql_release_rule, &inst->err_msg);
+    if (param == NULL)
+        return false;
+
+    reset(exe_sql_inst);
+    exe_sql_inst->param = param;
+
+    if (!param->select) {
+        pcinst_set_error(PCEXECUTOR_ERROR_BAD_SYNTAX);
+        return false;
+    }
+
+    return run_queries(exe_sql_inst);
+}
+
+// moves to the @idx-th row of all the results of UNION
+static inline purc_exec_iter_t
+fetch_at(struct pcexec_exe_sql_inst *exe_sql_inst, size_t idx)
+{
+    purc_exec_inst_t inst = &exe_sql_inst->super;
+    purc_exec_iter_t it = &inst->it;
+
+    PCEXE_CLR_VAR(inst->value);
+    it->curr = idx;
+
+    for (size_t i = 0; i < exe_sql_inst->nr_queries; i++) {
+        struct sql_query *q = exe_sql_inst->queries + i;
+        if (idx < q->nr) {
+            exe_sql_inst->curr_query = i;
+            exe_sql_inst->curr_row = idx;
+            return it;
+        }
+        idx -= q->nr;
+    }
+
+    pcinst_set_error(PCEXECUTOR_ERROR_NOT_EXISTS);
+    return NULL;
+}
+
+static inline purc_variant_t
+fetch_value(struct pcexec_exe_sql_inst *exe_sql_inst)
+{
+    purc_exec_inst_t inst = &exe_sql_inst->super;
+
+    if (inst->value == PURC_VARIANT_INVALID) {
+        struct sql_query *q;
+        q = exe_sql_inst->queries + exe_sql_inst->curr_query;
+        inst->value = query_value(q, exe_sql_inst->curr_row);
+    }
+
+    return inst->value;
+}
+
+static inline void
+destroy(struct pcexec_exe_sql_inst *exe_sql_inst)
+{
+    purc_exec_inst_t inst = &exe_sql_inst->super;
+
+    reset(exe_sql_inst);
+
+    PCEXE_CLR_VAR(inst->input);
+    PCEXE_CLR_VAR(inst->value);
+
+    free(exe_sql_inst);
+}
 
 // 创建一个执行器实例
 static purc_exec_inst_t
 exe_sql_create(enum purc_exec_type type,
         purc_variant_t input, bool asc_desc)
 {
-    if (!purc_variant_is_object(input))
-        return NULL;
-
-    struct pcexec_exe_sql_inst *inst;
-    inst = calloc(1, sizeof(*inst));
-    if (!inst) {
+    struct pcexec_exe_sql_inst *exe_sql_inst;
+    exe_sql_inst = calloc(1, sizeof(*exe_sql_inst));
+    if (!exe_sql_inst) {
         pcinst_set_error(PCEXECUTOR_ERROR_OOM);
         return NULL;
     }
 
-    inst->super.type        = type;
-    inst->super.input       = input;
-    inst->super.asc_desc    = asc_desc;
+    purc_exec_inst_t inst = &exe_sql_inst->super;
+
+    inst->type        = type;
+    inst->asc_desc    = asc_desc;
 
-    purc_variant_ref(input);
+    enum purc_variant_type vt = purc_variant_get_type(input);
+    if (vt == PURC_VARIANT_TYPE_OBJECT ||
+        vt == PURC_VARIANT_TYPE_ARRAY ||
+        vt == PURC_VARIANT_TYPE_SET)
+    {
+        inst->input = input;
+        purc_variant_ref(input);
+        return inst;
+    }
 
-    return &inst->super;
+    pcinst_set_error(PCEXECUTOR_ERROR_BAD_ARG);
+    destroy(exe_sql_inst);
+    return NULL;
 }
 
-static inline bool
-exe_sql_parse_rule(purc_exec_inst_t inst, const char* rule)
+static inline purc_exec_iter_t
+it_begin(struct pcexec_exe_sql_inst *exe_sql_inst, const char *rule)
 {
-    // parse and fill the internal fields from rule
-    // for example, generating the `selected_keys` which contains all
-    // selected keys.
+    if (!parse_rule(exe_sql_inst, rule))
+        return NULL;
 
-    // clear previously-selected-keys
-    if (inst->selected_keys) {
-        purc_variant_unref(inst->selected_keys);
-        inst->selected_keys = PURC_VARIANT_INVALID;
-    }
+    return fetch_at(exe_sql_inst, 0);
+}
 
-    // TODO: parse rule and eval to selected_keys
+static inline purc_exec_iter_t
+it_next(struct pcexec_exe_sql_inst *exe_sql_inst, const char *rule)
+{
+    size_t next = exe_sql_inst->super.it.curr + 1;
 
-    UNUSED_PARAM(inst);
-    UNUSED_PARAM(rule);
+    // the rule is executed again, and the iteration goes on from there
+    if (rule) {
+        if (!parse_rule(exe_sql_inst, rule))
+            return NULL;
+    }
 
-    pcinst_set_error(PCEXECUTOR_ERROR_NOT_IMPLEMENTED);
-    return false;
+    return fetch_at(exe_sql_inst, next);
 }
 
 // 用于执行选择
@@ -88,48 +1742,42 @@ exe_sql_choose(purc_exec_inst_t inst, const char* rule)
         return PURC_VARIANT_INVALID;
     }
 
-    if (!exe_sql_parse_rule(inst, rule))
-        return PURC_VARIANT_INVALID;
-
-    size_t sz = purc_variant_array_get_size(inst->selected_keys);
+    struct pcexec_exe_sql_inst *exe_sql_inst;
+    exe_sql_inst = (struct pcexec_exe_sql_inst*)inst;
 
-    purc_variant_t vals = purc_variant_make_array(0, PURC_VARIANT_INVALID);
-    if (vals == PURC_VARIANT_INVALID) {
-        return vals;
-    }
+    if (!parse_rule(exe_sql_inst, rule))
+        return PURC_VARIANT_INVALID;
 
-    bool ok = true;
+    size_t total = 0;
+    for (size_t i = 0; i < exe_sql_inst->nr_queries; i++)
+        total += exe_sql_inst->queries[i].nr;
 
-    for (size_t i=0; i<sz; ++i) {
-        purc_variant_t k;
-        k = purc_variant_array_get(inst->selected_keys, i);
-        purc_variant_t v;
-        v = purc_variant_object_get(inst->input, k);
-        if (v==PURC_VARIANT_INVALID)
-            continue;
-        ok = purc_variant_array_append(vals, v);
-        if (!ok)
-            break;
+    if (total == 1) {
+        struct sql_query *q = exe_sql_inst->queries;
+        while (q->nr == 0)
+            q++;
+        return query_value(q, 0);
     }
 
-    PC_ASSERT(0); // Not tested yet!!!
+    purc_variant_t vals = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    if (vals == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
 
-    if (ok) {
-        size_t n;
-        purc_variant_array_size(vals, &n);
-        if (n == 1) {
-            purc_variant_t v = purc_variant_array_get(vals, 0);
-            purc_variant_ref(v);
-            purc_variant_unref(vals);
-            vals = v;
+    for (size_t i = 0; i < exe_sql_inst->nr_queries; i++) {
+        struct sql_query *q = exe_sql_inst->queries + i;
+        for (size_t j = 0; j < q->nr; j++) {
+            purc_variant_t v = query_value(q, j);
+            bool ok = v && purc_variant_array_append(vals, v);
+            if (v)
+                purc_variant_unref(v);
+            if (!ok) {
+                purc_variant_unref(vals);
+                return PURC_VARIANT_INVALID;
+            }
         }
     }
 
-    if (ok)
-        return vals;
-
-    purc_variant_unref(vals);
-    return PURC_VARIANT_INVALID;
+    return vals;
 }
 
 // 获得用于迭代的初始迭代子
@@ -141,17 +1789,17 @@ exe_sql_it_begin(purc_exec_inst_t inst, const char* rule)
         return NULL;
     }
 
-    inst->it.curr = 0;
-    if (!exe_sql_parse_rule(inst, rule))
-        return NULL;
-
-    size_t sz = purc_variant_array_get_size(inst->selected_keys);
-    if (sz<=0) {
-        pcinst_set_error(PCEXECUTOR_ERROR_NO_KEYS_SELECTED);
+    if (inst->type != PURC_EXEC_TYPE_ITERATE) {
+        pcinst_set_error(PCEXECUTOR_ERROR_NOT_ALLOWED);
         return NULL;
     }
 
-    return &inst->it;
+    PC_ASSERT(inst->input != PURC_VARIANT_INVALID);
+
+    struct pcexec_exe_sql_inst *exe_sql_inst;
+    exe_sql_inst = (struct pcexec_exe_sql_inst*)inst;
+
+    return it_begin(exe_sql_inst, rule);
 }
 
 // 根据迭代子获得对应的变体值
@@ -164,15 +1812,12 @@ exe_sql_it_value(purc_exec_inst_t inst, purc_exec_iter_t it)
     }
 
     PC_ASSERT(&inst->it == it);
-    PC_ASSERT(inst->selected_keys != PURC_VARIANT_INVALID);
     PC_ASSERT(inst->input != PURC_VARIANT_INVALID);
 
-    purc_variant_t k;
-    k = purc_variant_array_get(inst->selected_keys, it->curr);
-    purc_variant_t v;
-    v = purc_variant_object_get(inst->input, k);
+    struct pcexec_exe_sql_inst *exe_sql_inst;
+    exe_sql_inst = (struct pcexec_exe_sql_inst*)inst;
 
-    return v;
+    return fetch_value(exe_sql_inst);
 }
 
 // 获得下一个迭代子
@@ -187,27 +1832,328 @@ exe_sql_it_next(purc_exec_inst_t inst, purc_exec_iter_t it, const char* rule)
     }
 
     PC_ASSERT(&inst->it == it);
+    PC_ASSERT(inst->input != PURC_VARIANT_INVALID);
 
-    if (rule) {
-        // clear previously-selected-keys
-        if (inst->selected_keys) {
-            purc_variant_unref(inst->selected_keys);
-            inst->selected_keys = PURC_VARIANT_INVALID;
+    struct pcexec_exe_sql_inst *exe_sql_inst;
+    exe_sql_inst = (struct pcexec_exe_sql_inst*)inst;
+
+    return it_next(exe_sql_inst, rule);
+}
+
+struct sql_stats {
+    size_t              count;
+    double              sum;
+    double              max;
+    double              min;
+};
+
+/*
+ * All the items of the selects are reduced in one pass: a group has the
+ * stats of every item, which are kept together in `stats`, `nr_items` ones
+ * for a group.
+ */
+struct sql_reducer {
+    size_t              nr_items;
+    const char        **names;      // the keys of the items in the result
+    char              (*bufs)[32];  // the buffers for the generated names
+
+    struct sql_stats   *stats;
+    char              **keys;       // the key of every group, or NULL
+    size_t              nr;
+    size_t              sz;
+    struct pchash_table *groups;    // the key to the index of the group
+    size_t              ungrouped;  // the index of the group + 1, or 0
+};
+
+static int reducer_init(struct sql_reducer *reducer,
+        struct sql_query *queries, size_t nr_queries)
+{
+    memset(reducer, 0, sizeof(*reducer));
+
+    for (size_t i = 0; i < nr_queries; i++) {
+        size_t n = 0;
+        for (struct sql_item *item = queries[i].select->items; item;
+                item = item->next)
+            n++;
+        if (n > reducer->nr_items)
+            reducer->nr_items = n;
+    }
+
+    reducer->names = calloc(reducer->nr_items, sizeof(*reducer->names));
+    reducer->bufs = calloc(reducer->nr_items, sizeof(*reducer->bufs));
+    if (!reducer->names || !reducer->bufs) {
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+        return -1;
+    }
+
+    // an item is named by the first select having it
+    for (size_t i = 0; i < nr_queries; i++) {
+        size_t n = 0;
+        for (struct sql_item *item = queries[i].select->items; item;
+                item = item->next, n++) {
+            if (!reducer->names[n])
+                reducer->names[n] = item_name(item, n, reducer->bufs[n]);
         }
+    }
+    return 0;
+}
 
-        if (!exe_sql_parse_rule(inst, rule))
-            return NULL;
+static void reducer_release(struct sql_reducer *reducer)
+{
+    free(reducer->names);
+    free(reducer->bufs);
+    free(reducer->stats);
+    if (reducer->keys) {
+        for (size_t i = 0; i < reducer->nr; i++)
+            free(reducer->keys[i]);
+        free(reducer->keys);
+    }
+    if (reducer->groups)
+        pchash_table_free(reducer->groups);
+}
+
+static inline struct sql_stats *
+reducer_stats(struct sql_reducer *reducer, size_t group)
+{
+    return reducer->stats + group * reducer->nr_items;
+}
+
+// returns the index of the group of @key, or -1 if no memory
+static ssize_t
+reducer_get(struct sql_reducer *reducer, const char *key)
+{
+    void *idx;
+    if (key && reducer->groups &&
+            pchash_table_lookup_ex(reducer->groups, key, &idx)) {
+        return (uintptr_t)idx;
+    }
+    else if (!key && reducer->ungrouped) {
+        return reducer->ungrouped - 1;
     }
 
-    ++it->curr;
+    if (reducer->nr == reducer->sz) {
+        size_t sz = reducer->sz ? reducer->sz * 2 : 8;
+        struct sql_stats *stats;
+        stats = realloc(reducer->stats,
+                sizeof(*stats) * sz * reducer->nr_items);
+        if (!stats)
+            goto oom;
+        reducer->stats = stats;
 
-    size_t sz = purc_variant_array_get_size(inst->selected_keys);
-    if (it->curr >= sz) {
-        it->curr = sz;
-        return NULL;
+        char **keys = realloc(reducer->keys, sizeof(*keys) * sz);
+        if (!keys)
+            goto oom;
+        reducer->keys = keys;
+        reducer->sz = sz;
+    }
+
+    size_t group = reducer->nr;
+    struct sql_stats *stats = reducer_stats(reducer, group);
+    for (size_t i = 0; i < reducer->nr_items; i++) {
+        memset(stats + i, 0, sizeof(*stats));
+        stats[i].max = NAN;
+        stats[i].min = NAN;
+    }
+    reducer->keys[group] = NULL;
+
+    if (key) {
+        if (!reducer->groups) {
+            // the keys are owned by `keys`
+            reducer->groups = pchash_kstr_table_new(HASHTABLE_DEFAULT_SIZE,
+                    NULL);
+            if (!reducer->groups)
+                goto oom;
+        }
+
+        reducer->keys[group] = strdup(key);
+        if (!reducer->keys[group] || pchash_table_insert(reducer->groups,
+                    reducer->keys[group], (void *)(uintptr_t)group)) {
+            free(reducer->keys[group]);
+            reducer->keys[group] = NULL;
+            goto oom;
+        }
+    }
+    else {
+        reducer->ungrouped = group + 1;
+    }
+
+    reducer->nr++;
+    return group;
+
+oom:
+    pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+    return -1;
+}
+
+static void stats_add(struct sql_stats *stats, double d)
+{
+    stats->count++;
+    if (isnan(d))
+        return;
+
+    stats->sum += d;
+    if (isnan(stats->max) || d > stats->max)
+        stats->max = d;
+    if (isnan(stats->min) || d < stats->min)
+        stats->min = d;
+}
+
+#define SET_KEY_AND_NUM(_o, _k, _d) {                        \
+    purc_variant_t v;                                        \
+    bool ok;                                                 \
+    v = purc_variant_make_number(_d);                        \
+    if (v == PURC_VARIANT_INVALID) {                         \
+        ok = false;                                          \
+        break;                                               \
+    }                                                        \
+    ok = purc_variant_object_set_by_static_ckey(_o,          \
+            _k, v);                                          \
+    purc_variant_unref(v);                                   \
+    if (!ok)                                                 \
+        break;                                               \
+}
+
+static purc_variant_t stats_make_object(const struct sql_stats *stats)
+{
+    purc_variant_t obj = purc_variant_make_object(0,
+            PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+
+    if (obj == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    double avg = stats->count > 0 ? stats->sum / stats->count : 0;
+
+    do {
+        SET_KEY_AND_NUM(obj, "count", stats->count);
+        SET_KEY_AND_NUM(obj, "sum", stats->sum);
+        SET_KEY_AND_NUM(obj, "avg", avg);
+        SET_KEY_AND_NUM(obj, "max", stats->max);
+        SET_KEY_AND_NUM(obj, "min", stats->min);
+
+        return obj;
+    } while (0);
+
+    purc_variant_unref(obj);
+    return PURC_VARIANT_INVALID;
+}
+
+// the stats of a group, keyed by the names of the items if there are many
+static purc_variant_t
+group_make_object(struct sql_reducer *reducer, const struct sql_stats *stats)
+{
+    if (reducer->nr_items == 1)
+        return stats_make_object(stats);
+
+    purc_variant_t obj = purc_variant_make_object(0,
+            PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+    if (obj == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    for (size_t i = 0; i < reducer->nr_items; i++) {
+        purc_variant_t v = stats_make_object(stats + i);
+        bool ok = v && object_set_by_ckey(obj, reducer->names[i], v);
+        if (v)
+            purc_variant_unref(v);
+        if (!ok) {
+            purc_variant_unref(obj);
+            return PURC_VARIANT_INVALID;
+        }
+    }
+
+    return obj;
+}
+
+// evaluates an item for the matched rows of @q as numbers
+static int reduce_item(struct sql_query *q, struct sql_exp *exp,
+        struct sql_vec *vec)
+{
+    if (exp->type == SQL_EXP_ALL || exp->type == SQL_EXP_SELF) {
+        if (vec_init(vec, SQL_VEC_NUMBER, false, q->nr_matched))
+            return -1;
+        for (size_t i = 0; i < q->nr_matched; i++) {
+            vec->nums[i] =
+                purc_variant_numberify(q->table.rows[q->matched[i]]);
+        }
+        return 0;
+    }
+
+    if (eval_exp(q, exp, q->matched, q->nr_matched, vec))
+        return -1;
+    if (!vec_numbers(vec)) {
+        vec_release(vec);
+        return -1;
+    }
+    return 0;
+}
+
+// accumulates all the items of the matched rows of @q in one pass
+static int reduce_query(struct sql_query *q, struct sql_reducer *reducer)
+{
+    struct sql_keybuf kb = { NULL, 0, 0 };
+    struct sql_vec *vecs;
+    ssize_t *groups = NULL;
+    size_t nr_vecs = 0;
+    int ret = -1;
+
+    if (q->nr_matched == 0)
+        return 0;
+
+    vecs = calloc(reducer->nr_items, sizeof(*vecs));
+    if (!vecs) {
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+        return -1;
+    }
+
+    for (struct sql_item *item = q->select->items; item;
+            item = item->next, nr_vecs++) {
+        if (reduce_item(q, item->exp, vecs + nr_vecs))
+            goto done;
+    }
+
+    // the groups of the reducer in the order of the groups of this query
+    if (q->select->group_by) {
+        groups = malloc(sizeof(*groups) * (q->nr ? q->nr : 1));
+        if (!groups) {
+            pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+            goto done;
+        }
+        for (size_t i = 0; i < q->nr; i++)
+            groups[i] = -1;
+    }
+
+    for (size_t i = 0; i < q->nr_matched; i++) {
+        ssize_t group;
+        if (groups) {
+            size_t gid = q->gids[i];
+            if (groups[gid] < 0) {
+                if (group_key(q, q->matched[i], ',', &kb))
+                    goto done;
+                groups[gid] = reducer_get(reducer, kb.buf);
+                if (groups[gid] < 0)
+                    goto done;
+            }
+            group = groups[gid];
+        }
+        else {
+            group = reducer_get(reducer, NULL);
+            if (group < 0)
+                goto done;
+        }
+
+        // the stats may be moved by reducer_get(), so get them every time
+        struct sql_stats *stats = reducer_stats(reducer, group);
+        for (size_t j = 0; j < nr_vecs; j++)
+            stats_add(stats + j, vecs[j].nums[VEC_AT(vecs + j, i)]);
     }
+    ret = 0;
 
-    return it;
+done:
+    free(groups);
+    free(kb.buf);
+    for (size_t j = 0; j < nr_vecs; j++)
+        vec_release(vecs + j);
+    free(vecs);
+    return ret;
 }
 
 // 用于执行规约
@@ -219,37 +2165,60 @@ exe_sql_reduce(purc_exec_inst_t inst, const char* rule)
         return PURC_VARIANT_INVALID;
     }
 
-    if (!exe_sql_parse_rule(inst, rule))
+    struct pcexec_exe_sql_inst *exe_sql_inst;
+    exe_sql_inst = (struct pcexec_exe_sql_inst*)inst;
+
+    if (!parse_rule(exe_sql_inst, rule))
         return PURC_VARIANT_INVALID;
 
-    size_t sz = purc_variant_array_get_size(inst->selected_keys);
+    struct sql_reducer reducer;
+    purc_variant_t ret = PURC_VARIANT_INVALID;
+    bool grouped = false;
+
+    if (reducer_init(&reducer, exe_sql_inst->queries,
+                exe_sql_inst->nr_queries))
+        goto done;
 
-    purc_variant_t objs;
-    objs = purc_variant_make_object(0,
-                PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
-    if (objs == PURC_VARIANT_INVALID) {
-        return objs;
+    for (size_t i = 0; i < exe_sql_inst->nr_queries; i++) {
+        struct sql_query *q = exe_sql_inst->queries + i;
+        if (q->select->group_by)
+            grouped = true;
+        if (reduce_query(q, &reducer))
+            goto done;
     }
 
-    bool ok = false;
+    if (!grouped) {
+        // the empty stats if no row matched
+        if (reducer.nr == 0 && reducer_get(&reducer, NULL) < 0)
+            goto done;
+        ret = group_make_object(&reducer, reducer.stats);
+        goto done;
+    }
 
-    for (size_t i=0; i<sz; ++i) {
-        purc_variant_t k;
-        k = purc_variant_array_get(inst->selected_keys, i);
-        purc_variant_t v;
-        v = purc_variant_object_get(inst->input, k);
-        if (v==PURC_VARIANT_INVALID)
-            continue;
-        ok = purc_variant_object_set(objs, k, v);
-        if (!ok)
+    // the stats of the rows not grouped by a select of UNION are keyed by
+    // an empty string
+    ret = purc_variant_make_object(0,
+            PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+    if (ret == PURC_VARIANT_INVALID)
+        goto done;
+
+    for (size_t i = 0; i < reducer.nr; i++) {
+        const char *key = reducer.keys[i];
+        purc_variant_t v = group_make_object(&reducer,
+                reducer_stats(&reducer, i));
+        bool ok = v && object_set_by_ckey(ret, key ? key : "", v);
+        if (v)
+            purc_variant_unref(v);
+        if (!ok) {
+            purc_variant_unref(ret);
+            ret = PURC_VARIANT_INVALID;
             break;
+        }
     }
 
-    if (ok)
-        return objs;
-
-    purc_variant_unref(objs);
-    return PURC_VARIANT_INVALID;
+done:
+    reducer_release(&reducer);
+    return ret;
 }
 
 // 销毁一个执行器实例
@@ -261,18 +2230,10 @@ exe_sql_destroy(purc_exec_inst_t inst)
         return false;
     }
 
-    struct pcexec_exe_sql_inst *exe_sql_inst = (struct pcexec_exe_sql_inst*)inst;
+    struct pcexec_exe_sql_inst *exe_sql_inst;
+    exe_sql_inst = (struct pcexec_exe_sql_inst*)inst;
+    destroy(exe_sql_inst);
 
-    if (exe_sql_inst->super.input) {
-        purc_variant_unref(exe_sql_inst->super.input);
-        exe_sql_inst->super.input = PURC_VARIANT_INVALID;
-    }
-    if (exe_sql_inst->super.selected_keys) {
-        purc_variant_unref(exe_sql_inst->super.selected_keys);
-        exe_sql_inst->super.selected_keys = PURC_VARIANT_INVALID;
-    }
-
-    free(exe_sql_inst);
     return true;
 }
 
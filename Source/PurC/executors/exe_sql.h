@@ -29,11 +29,120 @@
 #include "config.h"
 
 #include "purc-macros.h"
+#include "purc-utils.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+enum sql_exp_type {
+    SQL_EXP_NUMBER,
+    SQL_EXP_STRING,
+    SQL_EXP_VAR,        // `key` or `key.subkey` of a row
+    SQL_EXP_ALL,        // `*`
+    SQL_EXP_SELF,       // `&`
+    SQL_EXP_ATTR,       // `@name`
+    SQL_EXP_LIKE,
+    SQL_EXP_IN,
+    SQL_EXP_AND,
+    SQL_EXP_OR,
+    SQL_EXP_NOT,
+    SQL_EXP_EQ,
+    SQL_EXP_NE,
+    SQL_EXP_LT,
+    SQL_EXP_GT,
+    SQL_EXP_LE,
+    SQL_EXP_GE,
+    SQL_EXP_ADD,
+    SQL_EXP_SUB,
+    SQL_EXP_MUL,
+    SQL_EXP_DIV,
+    SQL_EXP_NEG,
+};
+
+struct sql_exp {
+    enum sql_exp_type           type;
+
+    double                      number;
+    char                       *str;    // the string literal, or the name
+    char                       *sub;    // the subkey of a var, or NULL
+
+    struct sql_exp             *l;
+    struct sql_exp             *r;      // for IN, the list chained by `next`
+    struct sql_exp             *next;   // the next one in a list
+
+    // the column of a var; assigned when the rule is first executed
+    int                         col;
+    // the pattern of LIKE; created when the rule is first executed
+    struct pcutils_wildcard    *wildcard;
+};
+
+struct sql_item {
+    struct sql_exp             *exp;
+    char                       *alias;
+    struct sql_item            *next;
+};
+
+enum sql_travel {
+    SQL_TRAVEL_NONE,
+    SQL_TRAVEL_SIBLINGS,
+    SQL_TRAVEL_DEPTH,
+    SQL_TRAVEL_BREADTH,
+    SQL_TRAVEL_LEAVES,
+};
+
+struct sql_select {
+    struct sql_item            *items;
+    struct sql_exp             *where;
+    struct sql_exp             *group_by;   // the vars chained by `next`
+    struct sql_exp             *order_by;   // the vars chained by `next`
+    bool                        desc;
+    enum sql_travel             travel;
+
+    struct sql_select          *next;       // the next one of UNION
+};
+
+struct exe_sql_param {
+    char *err_msg;
+    int debug_flex;
+    int debug_bison;
+
+    struct sql_select          *select;
+};
 
 PCA_EXTERN_C_BEGIN
 
 int pcexec_exe_sql_register(void);
 
+int exe_sql_parse(const char *input, size_t len,
+        struct exe_sql_param *param);
+
+struct sql_exp *sql_exp_new(enum sql_exp_type type,
+        struct sql_exp *l, struct sql_exp *r);
+void sql_exp_destroy(struct sql_exp *exp);
+
+struct sql_item *sql_item_new(struct sql_exp *exp, char *alias);
+void sql_item_destroy(struct sql_item *item);
+
+void sql_select_destroy(struct sql_select *select);
+
+static inline void
+exe_sql_param_reset(struct exe_sql_param *param)
+{
+    if (!param)
+        return;
+
+    if (param->err_msg) {
+        free(param->err_msg);
+        param->err_msg = NULL;
+    }
+
+    if (param->select) {
+        sql_select_destroy(param->select);
+        param->select = NULL;
+    }
+}
+
 PCA_EXTERN_C_END
 
 #endif // PURC_EXECUTOR_SQL_H
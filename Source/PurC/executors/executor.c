@@ -184,28 +184,47 @@ static int _init_instance(struct pcinst *inst,
     return 0;
 }
 
+static void destroy_rule_cache(struct pcexecutor_rule_cache *cache);
+
 static void _cleanup_instance(struct pcinst *inst)
 {
     if (!inst->executor_heap)
         return;
 
+    if (inst->executor_heap->rule_cache)
+        destroy_rule_cache(inst->executor_heap->rule_cache);
     free(inst->executor_heap);
     inst->executor_heap = NULL;
 }
 
 struct pcmodule _module_executor = {
+    .name            = "executor",
     .id              = PURC_HAVE_VARIANT | PURC_HAVE_HVML,
     .module_inited   = 0,
+    .on_demand       = true,
 
     .init_once                = _init_once,
     .init_instance            = _init_instance,
     .cleanup_instance         = _cleanup_instance,
 };
 
+/* the executors are initialized for an instance by the first use */
+static struct pcexecutor_heap *get_heap(void)
+{
+    struct pcinst *inst = pcinst_current();
+    if (inst == NULL)
+        return NULL;
+
+    if (inst->executor_heap == NULL)
+        pcinst_init_module_on_demand(&_module_executor);
+    return inst->executor_heap;
+}
+
 void pcexecutor_set_debug(int debug_flex, int debug_bison)
 {
-    struct pcexecutor_heap *heap;
-    heap = pcinst_current()->executor_heap;
+    struct pcexecutor_heap *heap = get_heap();
+    if (!heap)
+        return;
 
     heap->debug_flex  = debug_flex;
     heap->debug_bison = debug_bison;
@@ -213,8 +232,14 @@ void pcexecutor_set_debug(int debug_flex, int debug_bison)
 
 void pcexecutor_get_debug(int *debug_flex, int *debug_bison)
 {
-    struct pcexecutor_heap *heap;
-    heap = pcinst_current()->executor_heap;
+    struct pcexecutor_heap *heap = get_heap();
+    if (!heap) {
+        if (debug_flex)
+            *debug_flex  = 0;
+        if (debug_bison)
+            *debug_bison = 0;
+        return;
+    }
 
     if (debug_flex)
         *debug_flex  = heap->debug_flex;
@@ -237,6 +262,9 @@ int pcexecutor_register(pcexec_ops_t ops)
         return -1;
     }
 
+    /* the builtin executors are registered before the others */
+    get_heap();
+
     pcutils_map_entry *entry = NULL;
     pcexec_ops_t record = NULL;
     void *key = (void*)(uint64_t)ops->atom;
@@ -274,13 +302,27 @@ failure:
 }
 
 bool purc_register_executor(const char* name, const purc_exec_ops_t ops)
+{
+    return purc_register_executor_ex(name, ops, 0);
+}
+
+bool purc_register_executor_ex(const char* name, const purc_exec_ops_t ops,
+        unsigned int flags)
 {
     pcexec_ops record = {
         .type         = PCEXEC_TYPE_INTERNAL,
         .internal_ops = ops,
         .atom         = PCHVML_KEYWORD_ATOM(HVML, name),
+        .flags        = flags,
     };
 
+    if ((flags & PURC_EXEC_FLAG_BATCH) && ops &&
+            ((purc_exec_batch_ops_t)ops)->it_values == NULL) {
+        purc_set_error_with_info(PCEXECUTOR_ERROR_BAD_ARG,
+                "no batch operation for `%s`", name);
+        return false;
+    }
+
     if (!record.atom) {
         purc_set_error_with_info(PCEXECUTOR_ERROR_BAD_ARG,
                 "unknown name `%s`", name);
@@ -297,8 +339,7 @@ get_executor(const char* name, pcexec_ops_t ops)
 {
     pcutils_map_entry *entry = NULL;
 
-    struct pcexecutor_heap *heap;
-    heap = pcinst_current()->executor_heap;
+    struct pcexecutor_heap *heap = get_heap();
     if (!heap) {
         pcinst_set_error(PCEXECUTOR_ERROR_NOT_EXISTS);
         return false;
@@ -424,4 +465,191 @@ pcexecutor_get_rule_name(const char *rule)
     return atom;
 }
 
+pcexecutor_member_chooser_f
+pcexecutor_get_member_chooser(const char *rule)
+{
+    purc_atom_t atom = pcexecutor_get_rule_name(rule);
+    if (atom == 0) {
+        purc_clr_error();
+        return NULL;
+    }
+
+    // the builtin executors can not be registered again
+    if (atom == PCHVML_KEYWORD_ATOM(HVML, "FILTER"))
+        return pcexec_exe_filter_choose_member;
+
+    return NULL;
+}
+
+/*
+ * The compiled rules are kept in a small LRU cache of the instance, keyed by
+ * the executor name and the rule string; so an `iterate` or `choose` with
+ * the same rule in a loop only parses the rule once. A compiled rule is
+ * reference counted, because it may be evicted while being used.
+ */
+#define NR_CACHED_RULES         64
+
+struct compiled_rule {
+    unsigned                    refc;
+    unsigned                    hash;
+    char                       *name;
+    char                       *rule;
+    pcexecutor_rule_releaser_f  releaser;
+
+    union {
+        long double             ld;
+        void                   *ptr;
+    } param[];
+};
+
+struct pcexecutor_rule_cache {
+    size_t                      nr_hits;
+    size_t                      nr_misses;
+
+    // the most recently used one comes first
+    size_t                      nr;
+    struct compiled_rule       *rules[NR_CACHED_RULES];
+};
+
+/* FNV-1a */
+static unsigned hash_rule(const char *name, const char *rule)
+{
+    unsigned hash = 2166136261u;
+    while (*name) {
+        hash ^= (unsigned char)*name++;
+        hash *= 16777619u;
+    }
+
+    hash ^= ':';
+    hash *= 16777619u;
+
+    while (*rule) {
+        hash ^= (unsigned char)*rule++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void unref_compiled_rule(struct compiled_rule *cr)
+{
+    if (--cr->refc == 0) {
+        cr->releaser(cr->param);
+        free(cr->name);
+        free(cr->rule);
+        free(cr);
+    }
+}
+
+static void destroy_rule_cache(struct pcexecutor_rule_cache *cache)
+{
+    for (size_t i = 0; i < cache->nr; i++)
+        unref_compiled_rule(cache->rules[i]);
+    free(cache);
+}
 
+static struct compiled_rule *
+compile_rule(const char *name, const char *rule, unsigned hash,
+        size_t sz_param, pcexecutor_rule_parser_f parser,
+        pcexecutor_rule_releaser_f releaser, char **err_msg)
+{
+    struct compiled_rule *cr;
+    cr = (struct compiled_rule *)calloc(1, sizeof(*cr) + sz_param);
+    if (cr == NULL) {
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+        return NULL;
+    }
+
+    cr->name = strdup(name);
+    cr->rule = strdup(rule);
+    if (cr->name == NULL || cr->rule == NULL) {
+        free(cr->name);
+        free(cr->rule);
+        free(cr);
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+        return NULL;
+    }
+
+    if (parser(rule, strlen(rule), cr->param, err_msg)) {
+        releaser(cr->param);
+        free(cr->name);
+        free(cr->rule);
+        free(cr);
+        return NULL;
+    }
+
+    cr->refc = 1;
+    cr->hash = hash;
+    cr->releaser = releaser;
+    return cr;
+}
+
+void *
+pcexecutor_get_compiled_rule(const char *name, const char *rule,
+        size_t sz_param, pcexecutor_rule_parser_f parser,
+        pcexecutor_rule_releaser_f releaser, char **err_msg)
+{
+    struct pcexecutor_heap *heap = get_heap();
+    if (heap == NULL) {
+        pcinst_set_error(PCEXECUTOR_ERROR_NOT_EXISTS);
+        return NULL;
+    }
+
+    struct pcexecutor_rule_cache *cache = heap->rule_cache;
+    unsigned hash = hash_rule(name, rule);
+
+    if (cache == NULL) {
+        cache = (struct pcexecutor_rule_cache *)calloc(1, sizeof(*cache));
+        heap->rule_cache = cache;
+    }
+
+    if (cache) {
+        for (size_t i = 0; i < cache->nr; i++) {
+            struct compiled_rule *cr = cache->rules[i];
+            if (cr->hash == hash && strcmp(cr->rule, rule) == 0 &&
+                    strcmp(cr->name, name) == 0) {
+                memmove(cache->rules + 1, cache->rules,
+                        sizeof(cache->rules[0]) * i);
+                cache->rules[0] = cr;
+                cache->nr_hits++;
+                cr->refc++;
+                return cr->param;
+            }
+        }
+    }
+
+    struct compiled_rule *cr = compile_rule(name, rule, hash,
+            sz_param, parser, releaser, err_msg);
+    if (cr == NULL)
+        return NULL;
+
+    if (cache) {
+        cache->nr_misses++;
+        if (cache->nr == NR_CACHED_RULES)
+            unref_compiled_rule(cache->rules[--cache->nr]);
+        memmove(cache->rules + 1, cache->rules,
+                sizeof(cache->rules[0]) * cache->nr);
+        cache->rules[0] = cr;
+        cache->nr++;
+        cr->refc++;
+    }
+
+    return cr->param;
+}
+
+void pcexecutor_put_compiled_rule(void *param)
+{
+    if (param)
+        unref_compiled_rule((struct compiled_rule *)
+                ((char *)param - offsetof(struct compiled_rule, param)));
+}
+
+void pcexecutor_get_rule_cache_stats(size_t *nr_hits, size_t *nr_misses)
+{
+    struct pcexecutor_heap *heap = pcinst_current()->executor_heap;
+    struct pcexecutor_rule_cache *cache = heap ? heap->rule_cache : NULL;
+
+    if (nr_hits)
+        *nr_hits = cache ? cache->nr_hits : 0;
+    if (nr_misses)
+        *nr_misses = cache ? cache->nr_misses : 0;
+}
@@ -146,7 +146,13 @@ input:
 ;
 
 key_rule:
-  KEY ':' subrule for_clause   { $$.smle = $3; $$.for_clause = $4; }
+  KEY ':' subrule for_clause   {
+      $$.smle = $3;
+      $$.for_clause = $4;
+      // made when the rule is compiled
+      $$.prefixes = NULL;
+      $$.nr_prefixes = 0;
+  }
 ;
 
 subrule:
@@ -30,26 +30,23 @@
 }
 
 %code requires {
-    struct exe_sql_param {
-        char *err_msg;
-        int debug_flex;
-        int debug_bison;
-    };
-
     struct exe_sql_token {
         const char      *text;
         size_t           leng;
     };
 
+    struct sql_exp;
+    struct exe_sql_order {
+        struct sql_exp  *vars;
+        bool             desc;
+    };
+
     #define YYSTYPE       EXE_SQL_YYSTYPE
     #define YYLTYPE       EXE_SQL_YYLTYPE
     #ifndef YY_TYPEDEF_YY_SCANNER_T
     #define YY_TYPEDEF_YY_SCANNER_T
     typedef void* yyscan_t;
     #endif
-
-    int exe_sql_parse(const char *input, size_t len,
-            struct exe_sql_param *param);
 }
 
 %code provides {
@@ -65,22 +62,108 @@
         const char *errsg
     );
 
-    #define SET_ARGS(_r, _a) do {              \
-        _r = strndup(_a.text, _a.leng);        \
-        if (!_r)                               \
-            YYABORT;                           \
+    #define SET_SELECT(_select) do {                            \
+        if (param) {                                            \
+            param->select = _select;                            \
+        } else {                                                \
+            sql_select_destroy(_select);                        \
+        }                                                       \
+    } while (0)
+
+    #define EXP_NEW(_r, _type, _a, _b) do {                     \
+        struct sql_exp *_l = _a, *_rr = _b;                     \
+        _r = sql_exp_new(_type, _l, _rr);                       \
+        if (!_r) {                                              \
+            sql_exp_destroy(_l);                                \
+            sql_exp_destroy(_rr);                               \
+            YYABORT;                                            \
+        }                                                       \
+    } while (0)
+
+    #define NUM_NEW(_r, _t) do {                                \
+        double d;                                               \
+        STRTOD(d, _t);                                          \
+        EXP_NEW(_r, SQL_EXP_NUMBER, NULL, NULL);                \
+        _r->number = d;                                         \
+    } while (0)
+
+    #define NAMED_NEW(_r, _type, _t) do {                       \
+        EXP_NEW(_r, _type, NULL, NULL);                         \
+        _r->str = strndup(_t.text, _t.leng);                    \
+        if (!_r->str) {                                         \
+            sql_exp_destroy(_r);                                \
+            YYABORT;                                            \
+        }                                                       \
+    } while (0)
+
+    #define VAR_SET_SUB(_r, _t) do {                            \
+        _r->sub = strndup(_t.text, _t.leng);                    \
+        if (!_r->sub) {                                         \
+            sql_exp_destroy(_r);                                \
+            YYABORT;                                            \
+        }                                                       \
     } while (0)
 
-    #define APPEND_ARGS(_r, _a, _b) do {       \
-        size_t len = strlen(_a);               \
-        size_t n   = len + _b.leng;            \
-        char *s = (char*)realloc(_a, n+1);     \
-        if (!s) {                              \
-            free(_r);                          \
-            YYABORT;                           \
-        }                                      \
-        memcpy(s+len, _b.text, _b.leng);       \
-        _r = s;                                \
+    #define STR_NEW(_r, _slist) do {                            \
+        char *str = pcexe_strlist_to_str(&_slist);              \
+        pcexe_strlist_reset(&_slist);                           \
+        if (!str)                                               \
+            YYABORT;                                            \
+        _r = sql_exp_new(SQL_EXP_STRING, NULL, NULL);           \
+        if (!_r) {                                              \
+            free(str);                                          \
+            YYABORT;                                            \
+        }                                                       \
+        _r->str = str;                                          \
+    } while (0)
+
+    #define EXP_APPEND(_list, _exp) do {                        \
+        struct sql_exp *p = _list;                              \
+        while (p->next)                                         \
+            p = p->next;                                        \
+        p->next = _exp;                                         \
+    } while (0)
+
+    #define ITEM_NEW(_r, _exp, _alias) do {                     \
+        struct sql_exp *e = _exp;                               \
+        char *alias = _alias;                                   \
+        _r = sql_item_new(e, alias);                            \
+        if (!_r) {                                              \
+            sql_exp_destroy(e);                                 \
+            free(alias);                                        \
+            YYABORT;                                            \
+        }                                                       \
+    } while (0)
+
+    #define ITEM_APPEND(_list, _item) do {                      \
+        struct sql_item *p = _list;                             \
+        while (p->next)                                         \
+            p = p->next;                                        \
+        p->next = _item;                                        \
+    } while (0)
+
+    #define SELECT_NEW(_r, _items, _where, _group, _order, _travel) do {  \
+        _r = (struct sql_select *)calloc(1, sizeof(*_r));       \
+        if (!_r) {                                              \
+            sql_item_destroy(_items);                           \
+            sql_exp_destroy(_where);                            \
+            sql_exp_destroy(_group);                            \
+            sql_exp_destroy(_order.vars);                       \
+            YYABORT;                                            \
+        }                                                       \
+        _r->items = _items;                                     \
+        _r->where = _where;                                     \
+        _r->group_by = _group;                                  \
+        _r->order_by = _order.vars;                             \
+        _r->desc = _order.desc;                                 \
+        _r->travel = _travel;                                   \
+    } while (0)
+
+    #define SELECT_APPEND(_list, _select) do {                  \
+        struct sql_select *p = _list;                           \
+        while (p->next)                                         \
+            p = p->next;                                        \
+        p->next = _select;                                      \
     } while (0)
 }
 
@@ -100,29 +183,43 @@
 
 // union members
 %union { struct exe_sql_token token; }
-%union { char *str; }
 %union { char c; }
-
-    /* %destructor { free($$); } <str> */ // destructor for `str`
+%union { struct pcexe_strlist slist; }
+%union { struct sql_exp *exp; }
+%union { struct sql_item *item; }
+%union { struct sql_select *select; }
+%union { struct exe_sql_order order; }
+%union { enum sql_travel travel; }
+
+%destructor { pcexe_strlist_reset(&$$); } <slist>
+%destructor { sql_exp_destroy($$); } <exp>
+%destructor { sql_item_destroy($$); } <item>
+%destructor { sql_select_destroy($$); } <select>
+%destructor { sql_exp_destroy($$.vars); } <order>
 
 %token SQL SELECT WHERE GROUP BY ORDER TRAVEL IN LIKE UNION AS ASC DESC
 %token SIBLINGS DEPTH BREADTH LEAVES
 %token NOT GE LE NE AT
-%token <c> CHR UNI
-%token <token> STR INTERIOR
+%token <c> CHR
+%token <token> STR INTERIOR UNI
 %token <token> INTEGER NUMBER ID
 
 %left UNION
+%left OR
+%left AND
+%precedence NEG
 %left IN LIKE
-%left AND OR
 %right '=' '<' '>' GE LE NE
 %left '-' '+'
 %left '*' '/'
 %precedence UMINUS
-%precedence NEG
 
- /* %nterm <str>   args */ // non-terminal `input` use `str` to store
-                           // token value as well
+%nterm <select> select_clause union_clause
+%nterm <item>   select_list select_item
+%nterm <exp>    var var_list where_clause group_by_clause exp exp_list
+%nterm <order>  order_by_clause
+%nterm <travel> travel_in_clause
+%nterm <slist>  str
 
 %% /* The grammar follows. */
 
@@ -135,103 +232,105 @@ rule:
 ;
 
 sql_rule:
-  SQL ':' union_clause
+  SQL ':' union_clause      { SET_SELECT($3); }
 ;
 
 select_clause:
   SELECT select_list where_clause group_by_clause order_by_clause travel_in_clause
+      { SELECT_NEW($$, $2, $3, $4, $5, $6); }
 ;
 
 union_clause:
-  select_clause
-| '(' union_clause ')'
-| union_clause UNION union_clause
+  select_clause                     { $$ = $1; }
+| '(' union_clause ')'              { $$ = $2; }
+| union_clause UNION union_clause   { SELECT_APPEND($1, $3); $$ = $1; }
 ;
 
 select_list:
-  select_item
-| select_list ',' select_item
+  select_item                       { $$ = $1; }
+| select_list ',' select_item       { ITEM_APPEND($1, $3); $$ = $1; }
 ;
 
 select_item:
-  exp
-| exp AS ID
+  exp           { ITEM_NEW($$, $1, NULL); }
+| exp AS ID     { ITEM_NEW($$, $1, strndup($3.text, $3.leng)); }
 ;
 
 var:
-  ID
-| ID '.' ID
+  ID            { NAMED_NEW($$, SQL_EXP_VAR, $1); }
+| ID '.' ID     { NAMED_NEW($$, SQL_EXP_VAR, $1); VAR_SET_SUB($$, $3); }
 ;
 
 var_list:
-  var
-| var_list ',' var
+  var                   { $$ = $1; }
+| var_list ',' var      { EXP_APPEND($1, $3); $$ = $1; }
 ;
 
 where_clause:
-  %empty
-| WHERE exp
+  %empty        { $$ = NULL; }
+| WHERE exp     { $$ = $2; }
 ;
 
 group_by_clause:
-  %empty
-| GROUP BY var_list
+  %empty            { $$ = NULL; }
+| GROUP BY var_list { $$ = $3; }
 ;
 
 order_by_clause:
-  %empty
-| ORDER BY var_list
-| ORDER BY var_list ASC
-| ORDER BY var_list DESC
+  %empty                    { $$.vars = NULL; $$.desc = false; }
+| ORDER BY var_list         { $$.vars = $3; $$.desc = false; }
+| ORDER BY var_list ASC     { $$.vars = $3; $$.desc = false; }
+| ORDER BY var_list DESC    { $$.vars = $3; $$.desc = true; }
 ;
 
 travel_in_clause:
-  %empty
-| TRAVEL IN SIBLINGS
-| TRAVEL IN DEPTH
-| TRAVEL IN BREADTH
-| TRAVEL IN LEAVES
+  %empty                { $$ = SQL_TRAVEL_NONE; }
+| TRAVEL IN SIBLINGS    { $$ = SQL_TRAVEL_SIBLINGS; }
+| TRAVEL IN DEPTH       { $$ = SQL_TRAVEL_DEPTH; }
+| TRAVEL IN BREADTH     { $$ = SQL_TRAVEL_BREADTH; }
+| TRAVEL IN LEAVES      { $$ = SQL_TRAVEL_LEAVES; }
 ;
 
 exp:
-  INTEGER
-| NUMBER
-| var
-| '*'
-| '&'
-| '"' str '"'
-| AT ID
-| exp LIKE exp
-| exp IN '(' exp_list ')'
-| exp AND exp
-| exp OR exp
-| NOT exp %prec NEG
-| exp '=' exp
-| exp NE exp
-| exp LE exp
-| exp GE exp
-| exp '>' exp
-| exp '<' exp
-| exp '+' exp
-| exp '-' exp
-| exp '*' exp
-| exp '/' exp
-| '-' exp %prec UMINUS
-| '(' exp ')'
+  INTEGER               { NUM_NEW($$, $1); }
+| NUMBER                { NUM_NEW($$, $1); }
+| var                   { $$ = $1; }
+| '*'                   { EXP_NEW($$, SQL_EXP_ALL, NULL, NULL); }
+| '&'                   { EXP_NEW($$, SQL_EXP_SELF, NULL, NULL); }
+| '"' str '"'           { STR_NEW($$, $2); }
+| '"' '"'               { struct pcexe_strlist empty; pcexe_strlist_init(&empty); STR_NEW($$, empty); }
+| AT ID                 { NAMED_NEW($$, SQL_EXP_ATTR, $2); }
+| exp LIKE exp          { EXP_NEW($$, SQL_EXP_LIKE, $1, $3); }
+| exp IN '(' exp_list ')'   { EXP_NEW($$, SQL_EXP_IN, $1, $4); }
+| exp AND exp           { EXP_NEW($$, SQL_EXP_AND, $1, $3); }
+| exp OR exp            { EXP_NEW($$, SQL_EXP_OR, $1, $3); }
+| NOT exp %prec NEG     { EXP_NEW($$, SQL_EXP_NOT, $2, NULL); }
+| exp '=' exp           { EXP_NEW($$, SQL_EXP_EQ, $1, $3); }
+| exp NE exp            { EXP_NEW($$, SQL_EXP_NE, $1, $3); }
+| exp LE exp            { EXP_NEW($$, SQL_EXP_LE, $1, $3); }
+| exp GE exp            { EXP_NEW($$, SQL_EXP_GE, $1, $3); }
+| exp '>' exp           { EXP_NEW($$, SQL_EXP_GT, $1, $3); }
+| exp '<' exp           { EXP_NEW($$, SQL_EXP_LT, $1, $3); }
+| exp '+' exp           { EXP_NEW($$, SQL_EXP_ADD, $1, $3); }
+| exp '-' exp           { EXP_NEW($$, SQL_EXP_SUB, $1, $3); }
+| exp '*' exp           { EXP_NEW($$, SQL_EXP_MUL, $1, $3); }
+| exp '/' exp           { EXP_NEW($$, SQL_EXP_DIV, $1, $3); }
+| '-' exp %prec UMINUS  { EXP_NEW($$, SQL_EXP_NEG, $2, NULL); }
+| '(' exp ')'           { $$ = $2; }
 ;
 
 exp_list:
-  exp
-| exp ',' exp
+  exp                   { $$ = $1; }
+| exp_list ',' exp      { EXP_APPEND($1, $3); $$ = $1; }
 ;
 
 str:
-  STR
-| CHR
-| UNI
-| str STR
-| str CHR
-| str UNI
+  STR           { STRLIST_INIT_STR($$, $1); }
+| CHR           { STRLIST_INIT_CHR($$, $1); }
+| UNI           { STRLIST_INIT_UNI($$, $1); }
+| str STR       { STRLIST_APPEND_STR($1, $2); $$ = $1; }
+| str CHR       { STRLIST_APPEND_CHR($1, $2); $$ = $1; }
+| str UNI       { STRLIST_APPEND_UNI($1, $2); $$ = $1; }
 ;
 
 %%
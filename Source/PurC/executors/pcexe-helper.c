@@ -631,6 +631,97 @@ number_comparing_logical_expression_match(
     return -1;
 }
 
+/* the loops have no branches, so that they can be vectorized */
+static int
+ncc_eval_bulk(struct number_comparing_condition *ncc,
+        const double *nums, size_t nr, unsigned char *match)
+{
+    const double v = ncc->nexp;
+
+    switch (ncc->op_type)
+    {
+        case NUMBER_COMPARING_LT:
+            for (size_t i = 0; i < nr; i++)
+                match[i] = nums[i] < v;
+            return 0;
+        case NUMBER_COMPARING_GT:
+            for (size_t i = 0; i < nr; i++)
+                match[i] = nums[i] > v;
+            return 0;
+        case NUMBER_COMPARING_LE:
+            for (size_t i = 0; i < nr; i++)
+                match[i] = nums[i] <= v;
+            return 0;
+        case NUMBER_COMPARING_GE:
+            for (size_t i = 0; i < nr; i++)
+                match[i] = nums[i] >= v;
+            return 0;
+        case NUMBER_COMPARING_EQ:
+            for (size_t i = 0; i < nr; i++)
+                match[i] = nums[i] == v;
+            return 0;
+        case NUMBER_COMPARING_NE:
+            for (size_t i = 0; i < nr; i++)
+                match[i] = nums[i] != v;
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+int
+number_comparing_logical_expression_match_bulk(
+        struct number_comparing_logical_expression *exp,
+        const double *nums, size_t nr, unsigned char *match)
+{
+    struct number_comparing_logical_expression *l = NULL, *r = NULL;
+    ncle_get_children(exp, &l, &r);
+
+    if (exp->type == NUMBER_COMPARING_LOGICAL_EXPRESSION_NUM) {
+        PC_ASSERT(!l && !r);
+        return ncc_eval_bulk(&exp->ncc, nums, nr, match);
+    }
+
+    if (number_comparing_logical_expression_match_bulk(l, nums, nr, match))
+        return -1;
+
+    if (exp->type == NUMBER_COMPARING_LOGICAL_EXPRESSION_NOT) {
+        PC_ASSERT(l && !r);
+        for (size_t i = 0; i < nr; i++)
+            match[i] = !match[i];
+        return 0;
+    }
+
+    PC_ASSERT(l && r);
+    unsigned char *rm = (unsigned char *)malloc(nr ? nr : 1);
+    if (!rm) {
+        pcinst_set_error(PCEXECUTOR_ERROR_OOM);
+        return -1;
+    }
+
+    int ret = number_comparing_logical_expression_match_bulk(r, nums, nr, rm);
+    if (ret == 0) {
+        switch (exp->type)
+        {
+            case NUMBER_COMPARING_LOGICAL_EXPRESSION_AND:
+                for (size_t i = 0; i < nr; i++)
+                    match[i] &= rm[i];
+                break;
+            case NUMBER_COMPARING_LOGICAL_EXPRESSION_OR:
+                for (size_t i = 0; i < nr; i++)
+                    match[i] |= rm[i];
+                break;
+            default:
+                for (size_t i = 0; i < nr; i++)
+                    match[i] ^= rm[i];
+                break;
+        }
+    }
+
+    free(rm);
+    return ret;
+}
+
 static inline void
 vncle_get_children(struct value_number_comparing_logical_expression *exp,
         struct value_number_comparing_logical_expression **l,
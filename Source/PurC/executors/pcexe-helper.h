@@ -52,6 +52,27 @@
     }                                             \
 } while (0)
 
+// defines `<exe>_compile_rule()` and `<exe>_release_rule()` for
+// pcexecutor_get_compiled_rule() by `<exe>_parse()` and `<exe>_param_reset()`
+#define PCEXE_DEFINE_RULE_COMPILER(_exe)                                    \
+static int                                                                  \
+_exe##_compile_rule(const char *rule, size_t len, void *p, char **err_msg)  \
+{                                                                           \
+    struct _exe##_param *param = (struct _exe##_param *)p;                  \
+    int r = _exe##_parse(rule, len, param);                                 \
+    if (r) {                                                                \
+        *err_msg = param->err_msg;                                          \
+        param->err_msg = NULL;                                              \
+    }                                                                       \
+    return r;                                                               \
+}                                                                           \
+                                                                            \
+static void                                                                 \
+_exe##_release_rule(void *p)                                                \
+{                                                                           \
+    _exe##_param_reset((struct _exe##_param *)p);                           \
+}
+
 PCA_EXTERN_C_BEGIN
 
 int pcexe_ucs2utf8(char *utf, const char *uni, size_t n);
@@ -407,6 +428,13 @@ number_comparing_logical_expression_match(
         struct number_comparing_logical_expression *exp,
         const double curr, bool *match);
 
+// evaluates @exp for @nr numbers at once: `match[i]` is set to 1 if
+// `nums[i]` matches, otherwise 0.
+int
+number_comparing_logical_expression_match_bulk(
+        struct number_comparing_logical_expression *exp,
+        const double *nums, size_t nr, unsigned char *match);
+
 enum string_matching_logical_expression_node_type
 {
     STRING_MATCHING_LOGICAL_EXPRESSION_AND,
@@ -0,0 +1,834 @@
+/*
+ * @file fetcher-bundle.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The bundles of the files of apps mounted as the `bundle:` scheme.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A bundle is a single file made of the data of the entries, the index of
+ * the entries sorted by the names, and the table of the strings:
+ *
+ *  - the header (struct bundle_header);
+ *  - the data of the entries, every one aligned to 8 bytes;
+ *  - the index (struct bundle_entry[nr_entries]);
+ *  - the names and the MIME types of the entries, terminated by NUL.
+ *
+ * A mounted bundle is mapped into memory, and the entries are found by
+ * binary searching the index, so a resource is got without reading any
+ * other one. An entry may be deflated; it is inflated when it is fetched.
+ * For a `.hvml` file, the bundle may also have the vDOM cache of it in
+ * another entry with the same name, which is loaded instead of parsing
+ * the program.
+ *
+ * The integers are in the byte order of the host, like the vDOM caches.
+ */
+
+#include "config.h"
+
+#include "purc.h"
+
+#include "private/debug.h"
+#include "private/errors.h"
+#include "private/fetcher.h"
+#include "private/list.h"
+#include "private/vdom.h"
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if OS(LINUX) || OS(UNIX) || OS(MAC_OS_X)
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if HAVE(ZLIB)
+#include <zlib.h>
+#endif
+
+#define BUNDLE_MAGIC            "PCBUNDL1"
+#define BUNDLE_VERSION          1
+#define BUNDLE_ALIGN            8
+
+#define BUNDLE_SCHEME           "bundle"
+#define BUNDLE_URL_PREFIX       "bundle://"
+
+#define ENTRY_COMPRESSED        0x01
+#define ENTRY_VDOM_CACHE        0x02
+
+struct bundle_header {
+    char        magic[8];
+    uint32_t    version;
+    uint32_t    nr_entries;
+    uint64_t    off_index;
+    uint64_t    off_strings;
+    uint64_t    sz_strings;
+};
+
+struct bundle_entry {
+    uint64_t    off_data;
+    uint64_t    sz_data;
+    /* the size of the data inflated */
+    uint64_t    sz_orig;
+    /* the name, then the MIME type, in the string table */
+    uint32_t    off_name;
+    uint16_t    len_name;
+    uint8_t     len_mime;
+    uint8_t     flags;
+};
+
+struct bundle_mount {
+    struct list_head            node;
+    char                       *app;
+
+    const uint8_t              *base;
+    size_t                      size;
+
+    const struct bundle_entry  *entries;
+    uint32_t                    nr_entries;
+    const char                 *strings;
+};
+
+static pthread_mutex_t mounts_lock = PTHREAD_MUTEX_INITIALIZER;
+static LIST_HEAD(mounts);
+static bool cleanup_registered;
+
+static const struct mime_type {
+    const char *ext;
+    const char *mime;
+} mime_types[] = {
+    { ".hvml",  "text/hvml" },
+    { ".html",  "text/html" },
+    { ".htm",   "text/html" },
+    { ".json",  "application/json" },
+    { ".js",    "text/javascript" },
+    { ".css",   "text/css" },
+    { ".xml",   "text/xml" },
+    { ".txt",   "text/plain" },
+    { ".svg",   "image/svg+xml" },
+    { ".png",   "image/png" },
+    { ".jpg",   "image/jpeg" },
+    { ".jpeg",  "image/jpeg" },
+    { ".gif",   "image/gif" },
+};
+
+#define MIME_DEFAULT            "application/octet-stream"
+
+static const char *get_mime(const char *name)
+{
+    const char *ext = strrchr(name, '.');
+    if (ext) {
+        for (size_t i = 0; i < PCA_TABLESIZE(mime_types); i++) {
+            if (strcasecmp(ext, mime_types[i].ext) == 0)
+                return mime_types[i].mime;
+        }
+    }
+    return MIME_DEFAULT;
+}
+
+static bool is_hvml(const char *name)
+{
+    const char *ext = strrchr(name, '.');
+    return ext && strcasecmp(ext, ".hvml") == 0;
+}
+
+/* compares the entries by the names, then the kinds of the entries */
+static int compare_key(const char *name1, size_t len1, unsigned cache1,
+        const char *name2, size_t len2, unsigned cache2)
+{
+    size_t len = len1 < len2 ? len1 : len2;
+    int r = memcmp(name1, name2, len);
+    if (r == 0 && len1 != len2)
+        r = len1 < len2 ? -1 : 1;
+    if (r == 0 && cache1 != cache2)
+        r = cache1 < cache2 ? -1 : 1;
+    return r;
+}
+
+/* the entries being made */
+struct made_entry {
+    char       *name;
+    const char *mime;
+    void       *data;
+    size_t      sz_data;
+    size_t      sz_orig;
+    unsigned    flags;
+};
+
+struct made_bundle {
+    struct made_entry  *entries;
+    size_t              nr_entries;
+    size_t              sz_entries;
+    unsigned int        flags;
+};
+
+static void clear_made_bundle(struct made_bundle *mb)
+{
+    for (size_t i = 0; i < mb->nr_entries; i++) {
+        free(mb->entries[i].name);
+        free(mb->entries[i].data);
+    }
+    free(mb->entries);
+}
+
+/* takes the ownerships of @name and @data */
+static int add_made_entry(struct made_bundle *mb, char *name,
+        void *data, size_t sz, unsigned flags)
+{
+    if (mb->nr_entries == mb->sz_entries) {
+        size_t n = mb->sz_entries ? mb->sz_entries * 2 : 16;
+        struct made_entry *entries = realloc(mb->entries, sizeof(*entries) * n);
+        if (entries == NULL)
+            goto failed;
+        mb->entries = entries;
+        mb->sz_entries = n;
+    }
+
+    struct made_entry *me = mb->entries + mb->nr_entries;
+    me->name = name;
+    me->mime = (flags & ENTRY_VDOM_CACHE) ? "" : get_mime(name);
+    me->data = data;
+    me->sz_data = sz;
+    me->sz_orig = sz;
+    me->flags = flags;
+    mb->nr_entries++;
+    return 0;
+
+failed:
+    free(name);
+    free(data);
+    purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    return -1;
+}
+
+/* a failure to make the cache is not an error: the program is parsed */
+static void add_vdom_cache(struct made_bundle *mb, const char *name,
+        void *data, size_t sz)
+{
+    purc_rwstream_t in = purc_rwstream_new_from_mem(data, sz);
+    if (in == NULL)
+        goto done;
+
+    purc_vdom_t vdom = purc_load_hvml_from_rwstream(in);
+    purc_rwstream_destroy(in);
+    if (vdom == NULL) {
+        PC_WARN("Failed to make the vDOM cache of %s\n", name);
+        goto done;
+    }
+
+    purc_rwstream_t out = purc_rwstream_new_buffer(sz, 0);
+    if (out) {
+        if (purc_vdom_save_cache(vdom, out)) {
+            size_t sz_cache;
+            void *cache = purc_rwstream_get_mem_buffer_ex(out, &sz_cache,
+                    NULL, true);
+            char *dup = strdup(name);
+            if (cache && dup) {
+                add_made_entry(mb, dup, cache, sz_cache, ENTRY_VDOM_CACHE);
+            }
+            else {
+                free(dup);
+                free(cache);
+            }
+        }
+        purc_rwstream_destroy(out);
+    }
+    pcvdom_document_unref(vdom);
+
+done:
+    purc_clr_error();
+}
+
+static void *read_file(const char *path, size_t *sz)
+{
+    purc_rwstream_t in = purc_rwstream_new_from_mmap(path);
+    if (in == NULL)
+        return NULL;
+
+    size_t len;
+    const void *mem = purc_rwstream_get_mem_buffer(in, &len);
+    void *data = malloc(len ? len : 1);
+    if (data) {
+        memcpy(data, mem, len);
+        *sz = len;
+    }
+    else {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    }
+
+    purc_rwstream_destroy(in);
+    return data;
+}
+
+/* adds the regular files in the directory @path to the bundle */
+static int add_dir(struct made_bundle *mb, char *path, size_t len_root)
+{
+    DIR *dir = opendir(path);
+    if (dir == NULL) {
+        purc_set_error_with_info(PURC_ERROR_BAD_SYSTEM_CALL,
+                "failed to open directory: %s", path);
+        return -1;
+    }
+
+    int ret = 0;
+    size_t len_path = strlen(path);
+    struct dirent *ent;
+    while (ret == 0 && (ent = readdir(dir))) {
+        if (ent->d_name[0] == '.')
+            continue;
+
+        size_t len = strlen(ent->d_name);
+        if (len_path + len + 2 > PATH_MAX) {
+            purc_set_error_with_info(PURC_ERROR_TOO_LONG,
+                    "path too long: %s/%s", path, ent->d_name);
+            ret = -1;
+            break;
+        }
+
+        path[len_path] = '/';
+        memcpy(path + len_path + 1, ent->d_name, len + 1);
+
+        struct stat st;
+        if (stat(path, &st)) {
+            purc_set_error(PURC_ERROR_BAD_SYSTEM_CALL);
+            ret = -1;
+        }
+        else if (S_ISDIR(st.st_mode)) {
+            ret = add_dir(mb, path, len_root);
+        }
+        else if (S_ISREG(st.st_mode)) {
+            const char *name = path + len_root + 1;
+            size_t sz;
+            void *data = read_file(path, &sz);
+            char *dup = data ? strdup(name) : NULL;
+            if (dup == NULL) {
+                free(data);
+                ret = -1;
+            }
+            else {
+                if ((mb->flags & PURC_BUNDLE_FLAG_VDOM_CACHE) &&
+                        is_hvml(name))
+                    add_vdom_cache(mb, name, data, sz);
+                ret = add_made_entry(mb, dup, data, sz, 0);
+            }
+        }
+
+        path[len_path] = 0;
+    }
+
+    closedir(dir);
+    return ret;
+}
+
+static int compress_entries(struct made_bundle *mb)
+{
+#if HAVE(ZLIB)
+    for (size_t i = 0; i < mb->nr_entries; i++) {
+        struct made_entry *me = mb->entries + i;
+        uLongf sz = compressBound(me->sz_orig);
+        void *buf = malloc(sz);
+        if (buf == NULL) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return -1;
+        }
+
+        /* keep the entry stored if it is not smaller */
+        if (compress2(buf, &sz, me->data, me->sz_orig,
+                    Z_DEFAULT_COMPRESSION) != Z_OK || sz >= me->sz_orig) {
+            free(buf);
+            continue;
+        }
+
+        free(me->data);
+        me->data = buf;
+        me->sz_data = sz;
+        me->flags |= ENTRY_COMPRESSED;
+    }
+
+    return 0;
+#else
+    UNUSED_PARAM(mb);
+    purc_set_error(PURC_ERROR_NOT_SUPPORTED);
+    return -1;
+#endif
+}
+
+static int cmp_made_entries(const void *a, const void *b)
+{
+    const struct made_entry *e1 = a;
+    const struct made_entry *e2 = b;
+    return compare_key(e1->name, strlen(e1->name),
+            e1->flags & ENTRY_VDOM_CACHE,
+            e2->name, strlen(e2->name), e2->flags & ENTRY_VDOM_CACHE);
+}
+
+static size_t align_offset(size_t off)
+{
+    return (off + BUNDLE_ALIGN - 1) & ~(size_t)(BUNDLE_ALIGN - 1);
+}
+
+static int write_bundle(struct made_bundle *mb, FILE *fp)
+{
+    static const char zeros[BUNDLE_ALIGN];
+
+    struct bundle_entry *index = calloc(mb->nr_entries ? mb->nr_entries : 1,
+            sizeof(*index));
+    if (index == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    size_t off = align_offset(sizeof(struct bundle_header));
+    size_t off_name = 0;
+    for (size_t i = 0; i < mb->nr_entries; i++) {
+        struct made_entry *me = mb->entries + i;
+        index[i].off_data = off;
+        index[i].sz_data = me->sz_data;
+        index[i].sz_orig = me->sz_orig;
+        index[i].off_name = off_name;
+        index[i].len_name = strlen(me->name);
+        index[i].len_mime = strlen(me->mime);
+        index[i].flags = me->flags;
+
+        off = align_offset(off + me->sz_data);
+        off_name += index[i].len_name + index[i].len_mime + 2;
+    }
+
+    struct bundle_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BUNDLE_MAGIC, sizeof(header.magic));
+    header.version = BUNDLE_VERSION;
+    header.nr_entries = mb->nr_entries;
+    header.off_index = off;
+    header.off_strings = off + sizeof(*index) * mb->nr_entries;
+    header.sz_strings = off_name;
+
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+    size_t pos = sizeof(header);
+    for (size_t i = 0; ok && i < mb->nr_entries; i++) {
+        ok = fwrite(zeros, 1, index[i].off_data - pos, fp) ==
+                index[i].off_data - pos &&
+            fwrite(mb->entries[i].data, 1, index[i].sz_data, fp) ==
+                index[i].sz_data;
+        pos = index[i].off_data + index[i].sz_data;
+    }
+
+    if (ok) {
+        ok = fwrite(zeros, 1, header.off_index - pos, fp) ==
+                header.off_index - pos &&
+            fwrite(index, sizeof(*index), mb->nr_entries, fp) ==
+                mb->nr_entries;
+    }
+
+    for (size_t i = 0; ok && i < mb->nr_entries; i++) {
+        struct made_entry *me = mb->entries + i;
+        ok = fwrite(me->name, 1, index[i].len_name + 1, fp) ==
+                index[i].len_name + 1u &&
+            fwrite(me->mime, 1, index[i].len_mime + 1, fp) ==
+                index[i].len_mime + 1u;
+    }
+
+    free(index);
+    if (!ok) {
+        purc_set_error(PURC_ERROR_BAD_SYSTEM_CALL);
+        return -1;
+    }
+    return 0;
+}
+
+int purc_bundle_make(const char *dir, const char *file, unsigned int flags)
+{
+    if (dir == NULL || file == NULL) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return -1;
+    }
+
+    char path[PATH_MAX + 1];
+    size_t len_root = strlen(dir);
+    while (len_root > 1 && dir[len_root - 1] == '/')
+        len_root--;
+    if (len_root >= sizeof(path)) {
+        purc_set_error(PURC_ERROR_TOO_LONG);
+        return -1;
+    }
+    memcpy(path, dir, len_root);
+    path[len_root] = 0;
+
+    struct made_bundle mb = { NULL, 0, 0, flags };
+    int ret = add_dir(&mb, path, len_root);
+    for (size_t i = 0; ret == 0 && i < mb.nr_entries; i++) {
+        if (strlen(mb.entries[i].name) > UINT16_MAX) {
+            purc_set_error(PURC_ERROR_TOO_LARGE_ENTITY);
+            ret = -1;
+        }
+    }
+
+    if (ret == 0 && (flags & PURC_BUNDLE_FLAG_COMPRESS))
+        ret = compress_entries(&mb);
+
+    if (ret == 0) {
+        qsort(mb.entries, mb.nr_entries, sizeof(*mb.entries),
+                cmp_made_entries);
+
+        FILE *fp = fopen(file, "wb");
+        if (fp == NULL) {
+            purc_set_error(PURC_ERROR_BAD_SYSTEM_CALL);
+            ret = -1;
+        }
+        else {
+            ret = write_bundle(&mb, fp);
+            if (fclose(fp) && ret == 0) {
+                purc_set_error(PURC_ERROR_BAD_SYSTEM_CALL);
+                ret = -1;
+            }
+            if (ret)
+                unlink(file);
+        }
+    }
+
+    clear_made_bundle(&mb);
+    return ret;
+}
+
+static const char *entry_name(const struct bundle_mount *bm,
+        const struct bundle_entry *be)
+{
+    return bm->strings + be->off_name;
+}
+
+static const char *entry_mime(const struct bundle_mount *bm,
+        const struct bundle_entry *be)
+{
+    return bm->strings + be->off_name + be->len_name + 1;
+}
+
+static bool check_bundle(struct bundle_mount *bm)
+{
+    const struct bundle_header *header = (const void *)bm->base;
+    if (bm->size < sizeof(*header) ||
+            memcmp(header->magic, BUNDLE_MAGIC, sizeof(header->magic)) ||
+            header->version != BUNDLE_VERSION)
+        return false;
+
+    uint64_t sz_index = (uint64_t)header->nr_entries *
+        sizeof(struct bundle_entry);
+    if (header->off_index % BUNDLE_ALIGN ||
+            header->off_index > bm->size ||
+            sz_index > bm->size - header->off_index ||
+            header->off_strings < header->off_index + sz_index ||
+            header->off_strings > bm->size ||
+            header->sz_strings > bm->size - header->off_strings)
+        return false;
+
+    bm->entries = (const void *)(bm->base + header->off_index);
+    bm->nr_entries = header->nr_entries;
+    bm->strings = (const char *)bm->base + header->off_strings;
+
+    for (uint32_t i = 0; i < bm->nr_entries; i++) {
+        const struct bundle_entry *be = bm->entries + i;
+        if (be->off_data > header->off_index ||
+                be->sz_data > header->off_index - be->off_data ||
+                (uint64_t)be->off_name + be->len_name + be->len_mime + 2 >
+                    header->sz_strings ||
+                entry_name(bm, be)[be->len_name] ||
+                entry_mime(bm, be)[be->len_mime])
+            return false;
+
+        if (!(be->flags & ENTRY_COMPRESSED) && be->sz_orig != be->sz_data)
+            return false;
+
+        /* the index is searched by bisection */
+        const struct bundle_entry *prev = be - 1;
+        if (i > 0 && compare_key(entry_name(bm, prev), prev->len_name,
+                    prev->flags & ENTRY_VDOM_CACHE,
+                    entry_name(bm, be), be->len_name,
+                    be->flags & ENTRY_VDOM_CACHE) >= 0)
+            return false;
+    }
+
+    return true;
+}
+
+static const struct bundle_entry *find_entry(const struct bundle_mount *bm,
+        const char *name, size_t len, unsigned kind)
+{
+    uint32_t low = 0, high = bm->nr_entries;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        const struct bundle_entry *be = bm->entries + mid;
+        int r = compare_key(name, len, kind, entry_name(bm, be), be->len_name,
+                be->flags & ENTRY_VDOM_CACHE);
+        if (r == 0)
+            return be;
+        if (r < 0)
+            high = mid;
+        else
+            low = mid + 1;
+    }
+
+    return NULL;
+}
+
+/* called with the lock held */
+static struct bundle_mount *find_mount(const char *app, size_t len)
+{
+    struct bundle_mount *bm;
+    list_for_each_entry(bm, &mounts, node) {
+        if (strncmp(bm->app, app, len) == 0 && bm->app[len] == 0)
+            return bm;
+    }
+    return NULL;
+}
+
+/*
+ * Finds the entry for `bundle://<app>/<name>`; the query and the fragment
+ * are ignored. The mounts are never removed, so the entry is valid after
+ * the lock is released.
+ */
+static const struct bundle_entry *lookup_url(const char *url, unsigned kind,
+        const struct bundle_mount **mount)
+{
+    if (strncasecmp(url, BUNDLE_URL_PREFIX, sizeof(BUNDLE_URL_PREFIX) - 1))
+        return NULL;
+
+    const char *app = url + sizeof(BUNDLE_URL_PREFIX) - 1;
+    const char *name = strchr(app, '/');
+    if (name == NULL)
+        return NULL;
+
+    size_t len_app = name - app;
+    name++;
+    size_t len_name = strcspn(name, "?#");
+
+    pthread_mutex_lock(&mounts_lock);
+    const struct bundle_entry *be = NULL;
+    struct bundle_mount *bm = find_mount(app, len_app);
+    if (bm) {
+        be = find_entry(bm, name, len_name, kind);
+        *mount = bm;
+    }
+    pthread_mutex_unlock(&mounts_lock);
+
+    return be;
+}
+
+/* returns the data of the entry, or a copy inflated (*to_free) */
+static const void *entry_data(const struct bundle_mount *bm,
+        const struct bundle_entry *be, void **to_free)
+{
+    const void *data = bm->base + be->off_data;
+    *to_free = NULL;
+    if (!(be->flags & ENTRY_COMPRESSED))
+        return data;
+
+#if HAVE(ZLIB)
+    void *buf = malloc(be->sz_orig ? be->sz_orig : 1);
+    if (buf == NULL)
+        return NULL;
+
+    uLongf sz = be->sz_orig;
+    if (uncompress(buf, &sz, data, be->sz_data) != Z_OK ||
+            sz != be->sz_orig) {
+        free(buf);
+        return NULL;
+    }
+
+    *to_free = buf;
+    return buf;
+#else
+    return NULL;
+#endif
+}
+
+static purc_rwstream_t bundle_scheme_handler(void *ctxt, const char *url,
+        struct pcfetcher_resp_header *resp_header)
+{
+    UNUSED_PARAM(ctxt);
+
+    resp_header->ret_code = 404;
+    resp_header->mime_type = NULL;
+    resp_header->sz_resp = 0;
+
+    const struct bundle_mount *bm;
+    const struct bundle_entry *be = lookup_url(url, 0, &bm);
+    if (be == NULL)
+        return NULL;
+
+    void *buf;
+    const void *data = entry_data(bm, be, &buf);
+    if (data == NULL) {
+        resp_header->ret_code = 500;
+        return NULL;
+    }
+
+    /* the data mapped is kept until the process exits */
+    purc_rwstream_t rws = purc_rwstream_new_from_mem_ex(data, be->sz_orig,
+            buf ? free : NULL, buf);
+    if (rws == NULL) {
+        free(buf);
+        resp_header->ret_code = 500;
+        return NULL;
+    }
+
+    resp_header->ret_code = 200;
+    resp_header->mime_type = strdup(entry_mime(bm, be));
+    resp_header->sz_resp = be->sz_orig;
+    return rws;
+}
+
+purc_vdom_t pcfetcher_bundle_load_vdom(const char *url, size_t *length)
+{
+    const struct bundle_mount *bm;
+    const struct bundle_entry *be = lookup_url(url, ENTRY_VDOM_CACHE, &bm);
+    if (be == NULL)
+        return NULL;
+
+    void *buf;
+    const void *data = entry_data(bm, be, &buf);
+    if (data == NULL)
+        return NULL;
+
+    /* a cache made by another version of PurC is ignored */
+    purc_vdom_t vdom = purc_load_hvml_from_cache(data, be->sz_orig);
+    if (vdom == NULL) {
+        purc_clr_error();
+    }
+    else {
+        *length = be->sz_orig;
+    }
+
+    free(buf);
+    return vdom;
+}
+
+static void unmount_all(void)
+{
+    pthread_mutex_lock(&mounts_lock);
+    struct bundle_mount *bm, *n;
+    list_for_each_entry_safe(bm, n, &mounts, node) {
+        list_del(&bm->node);
+        munmap((void *)bm->base, bm->size);
+        free(bm->app);
+        free(bm);
+    }
+    pthread_mutex_unlock(&mounts_lock);
+}
+
+int purc_bundle_mount(const char *file, const char *app)
+{
+    if (file == NULL || app == NULL || app[0] == 0 || strchr(app, '/')) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return -1;
+    }
+
+    struct bundle_mount *bm = calloc(1, sizeof(*bm));
+    if (bm == NULL || (bm->app = strdup(app)) == NULL) {
+        free(bm);
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    int fd = open(file, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) || !S_ISREG(st.st_mode) ||
+            st.st_size == 0) {
+        purc_set_error_with_info(PURC_ERROR_BAD_SYSTEM_CALL,
+                "failed to open bundle: %s", file);
+        goto failed;
+    }
+
+    bm->size = st.st_size;
+    bm->base = mmap(NULL, bm->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (bm->base == MAP_FAILED) {
+        bm->base = NULL;
+        purc_set_error(PURC_ERROR_BAD_SYSTEM_CALL);
+        goto failed;
+    }
+    close(fd);
+    fd = -1;
+
+    if (!check_bundle(bm)) {
+        purc_set_error_with_info(PURC_ERROR_INVALID_VALUE,
+                "bad bundle: %s", file);
+        goto failed;
+    }
+
+    pthread_mutex_lock(&mounts_lock);
+    bool exists = find_mount(app, strlen(app)) != NULL;
+    if (!exists) {
+        list_add_tail(&bm->node, &mounts);
+        if (!cleanup_registered)
+            cleanup_registered = (atexit(unmount_all) == 0);
+    }
+    pthread_mutex_unlock(&mounts_lock);
+
+    if (exists) {
+        purc_set_error(PURC_ERROR_EXISTS);
+        goto failed;
+    }
+
+    return pcfetcher_register_scheme(BUNDLE_SCHEME, bundle_scheme_handler,
+            NULL);
+
+failed:
+    if (fd >= 0)
+        close(fd);
+    if (bm->base)
+        munmap((void *)bm->base, bm->size);
+    free(bm->app);
+    free(bm);
+    return -1;
+}
+
+#else   /* OS(LINUX) || OS(UNIX) || OS(MAC_OS_X) */
+
+int purc_bundle_make(const char *dir, const char *file, unsigned int flags)
+{
+    UNUSED_PARAM(dir);
+    UNUSED_PARAM(file);
+    UNUSED_PARAM(flags);
+
+    // TODO: Add codes for other OS.
+    purc_set_error(PURC_ERROR_NOT_SUPPORTED);
+    return -1;
+}
+
+int purc_bundle_mount(const char *file, const char *app)
+{
+    UNUSED_PARAM(file);
+    UNUSED_PARAM(app);
+
+    purc_set_error(PURC_ERROR_NOT_SUPPORTED);
+    return -1;
+}
+
+purc_vdom_t pcfetcher_bundle_load_vdom(const char *url, size_t *length)
+{
+    UNUSED_PARAM(url);
+    UNUSED_PARAM(length);
+    return NULL;
+}
+
+#endif  /* !(OS(LINUX) || OS(UNIX) || OS(MAC_OS_X)) */
@@ -0,0 +1,414 @@
+/*
+ * @file fetcher-cache.cpp
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The response cache shared by the fetchers.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "fetcher-cache.h"
+#include "private/utils.h"
+
+#include <wtf/HashMap.h>
+#include <wtf/ListHashSet.h>
+#include <wtf/Lock.h>
+#include <wtf/text/StringHash.h>
+#include <wtf/text/WTFString.h>
+#include <wtf/text/CString.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * The cache keeps the most recently used responses in memory, bounded by
+ * the quota; the least recently used ones are evicted first. If the
+ * environment variable PURC_FETCHER_CACHE_DIR is set, every stored
+ * response is also written to that directory so that an entry evicted
+ * from memory (or cached by an earlier process) can be loaded again.
+ */
+
+#define CACHE_FILE_MAGIC        "PCFCACHE1"
+
+struct CacheEntry {
+    WTF_MAKE_FAST_ALLOCATED;
+public:
+    ~CacheEntry() { free(data); }
+
+    int ret_code = 0;
+    CString mime_type;
+    CString etag;
+    CString last_modified;
+    time_t expires = 0;
+    void *data = nullptr;
+    size_t sz_data = 0;
+
+    size_t cost(const String& url) const
+    {
+        return sizeof(CacheEntry) + url.length() + mime_type.length()
+            + etag.length() + last_modified.length() + sz_data;
+    }
+};
+
+static Lock s_cache_lock;
+static unsigned s_cache_refs;
+static size_t s_cache_quota;
+static size_t s_cache_used;
+static CString s_cache_dir;
+static HashMap<String, std::unique_ptr<CacheEntry>> *s_cache_entries;
+/* in the order of use; the first one is the least recently used */
+static ListHashSet<String> *s_cache_lru;
+
+static CString disk_path(const String& url)
+{
+    unsigned char digest[MD5_DIGEST_SIZE];
+    char hex[MD5_DIGEST_SIZE * 2 + 1];
+
+    pcutils_md5digest(url.utf8().data(), digest);
+    pcutils_bin2hex(digest, MD5_DIGEST_SIZE, hex, false);
+
+    String path = String::fromUTF8(s_cache_dir.data());
+    path.append('/');
+    path.append(hex);
+    return path.utf8();
+}
+
+static void disk_remove(const String& url)
+{
+    if (s_cache_dir.isNull())
+        return;
+
+    unlink(disk_path(url).data());
+}
+
+static void disk_write(const String& url, const CacheEntry& entry)
+{
+    if (s_cache_dir.isNull())
+        return;
+
+    CString path = disk_path(url);
+    FILE *fp = fopen(path.data(), "wb");
+    if (fp == NULL)
+        return;
+
+    CString key = url.utf8();
+    int n = fprintf(fp, "%s\n%s\n%d\n%lld\n%s\n%s\n%s\n%zu\n",
+            CACHE_FILE_MAGIC, key.data(), entry.ret_code,
+            (long long)entry.expires,
+            entry.mime_type.isNull() ? "" : entry.mime_type.data(),
+            entry.etag.isNull() ? "" : entry.etag.data(),
+            entry.last_modified.isNull() ? "" : entry.last_modified.data(),
+            entry.sz_data);
+    bool ok = n > 0 && (entry.sz_data == 0 ||
+            fwrite(entry.data, 1, entry.sz_data, fp) == entry.sz_data);
+    if (fclose(fp) != 0)
+        ok = false;
+    if (!ok)
+        unlink(path.data());
+}
+
+static bool read_line(FILE *fp, CString& line)
+{
+    char *buf = NULL;
+    size_t sz = 0;
+    ssize_t len = getline(&buf, &sz, fp);
+    if (len <= 0) {
+        free(buf);
+        return false;
+    }
+
+    if (buf[len - 1] == '\n')
+        buf[--len] = '\0';
+    line = len > 0 ? CString(buf, len) : CString();
+    free(buf);
+    return true;
+}
+
+static std::unique_ptr<CacheEntry> disk_read(const String& url)
+{
+    if (s_cache_dir.isNull())
+        return nullptr;
+
+    CString path = disk_path(url);
+    FILE *fp = fopen(path.data(), "rb");
+    if (fp == NULL)
+        return nullptr;
+
+    auto entry = makeUnique<CacheEntry>();
+    CString magic, key, code, expires, size;
+    if (!read_line(fp, magic) || magic.isNull() ||
+            strcmp(magic.data(), CACHE_FILE_MAGIC) ||
+            !read_line(fp, key) || key.isNull() ||
+            strcmp(key.data(), url.utf8().data()) ||
+            !read_line(fp, code) || code.isNull() ||
+            !read_line(fp, expires) || expires.isNull() ||
+            !read_line(fp, entry->mime_type) ||
+            !read_line(fp, entry->etag) ||
+            !read_line(fp, entry->last_modified) ||
+            !read_line(fp, size) || size.isNull())
+        goto failed;
+
+    entry->ret_code = atoi(code.data());
+    entry->expires = (time_t)strtoll(expires.data(), NULL, 10);
+    entry->sz_data = strtoull(size.data(), NULL, 10);
+    if (entry->sz_data > 0) {
+        entry->data = malloc(entry->sz_data);
+        if (entry->data == NULL ||
+                fread(entry->data, 1, entry->sz_data, fp) != entry->sz_data)
+            goto failed;
+    }
+
+    fclose(fp);
+    return entry;
+
+failed:
+    fclose(fp);
+    return nullptr;
+}
+
+static void remove_entry(const String& url)
+{
+    auto it = s_cache_entries->find(url);
+    if (it == s_cache_entries->end())
+        return;
+
+    s_cache_used -= it->value->cost(url);
+    s_cache_entries->remove(it);
+    s_cache_lru->remove(url);
+}
+
+/* evict the least recently used entries until @cost fits in the quota */
+static bool make_room(size_t cost)
+{
+    if (cost > s_cache_quota)
+        return false;
+
+    while (s_cache_used + cost > s_cache_quota && !s_cache_lru->isEmpty()) {
+        String victim = s_cache_lru->first();
+        remove_entry(victim);
+    }
+
+    return true;
+}
+
+static void insert_entry(const String& url, std::unique_ptr<CacheEntry> entry)
+{
+    remove_entry(url);
+
+    size_t cost = entry->cost(url);
+    if (!make_room(cost))
+        return;
+
+    s_cache_used += cost;
+    s_cache_lru->appendOrMoveToLast(url);
+    s_cache_entries->set(url, WTFMove(entry));
+}
+
+static CacheEntry *find_entry(const String& url)
+{
+    auto it = s_cache_entries->find(url);
+    if (it != s_cache_entries->end()) {
+        s_cache_lru->appendOrMoveToLast(url);
+        return it->value.get();
+    }
+
+    auto entry = disk_read(url);
+    if (!entry)
+        return nullptr;
+
+    CacheEntry *found = entry.get();
+    insert_entry(url, WTFMove(entry));
+    if (!s_cache_entries->contains(url)) {
+        /* too large for the memory tier; keep it on disk only */
+        return nullptr;
+    }
+    return found;
+}
+
+static bool copy_entry(const CacheEntry *entry,
+        struct pcfetcher_resp_header *resp_header, purc_rwstream_t *resp)
+{
+    purc_rwstream_t rws = purc_rwstream_new_buffer(
+            entry->sz_data ? entry->sz_data : 1, INT_MAX);
+    if (rws == NULL)
+        return false;
+
+    if (entry->sz_data &&
+            purc_rwstream_write(rws, entry->data, entry->sz_data) < 0) {
+        purc_rwstream_destroy(rws);
+        return false;
+    }
+    purc_rwstream_seek(rws, 0, SEEK_SET);
+
+    if (resp_header) {
+        resp_header->ret_code = entry->ret_code;
+        resp_header->mime_type = entry->mime_type.isNull() ? NULL :
+            strdup(entry->mime_type.data());
+        resp_header->sz_resp = entry->sz_data;
+    }
+    *resp = rws;
+    return true;
+}
+
+static inline char *dup_cstring(const CString& str)
+{
+    return str.isNull() ? NULL : strdup(str.data());
+}
+
+int pcfetcher_cache_init(size_t cache_quota)
+{
+    auto locker = holdLock(s_cache_lock);
+    if (s_cache_refs++ > 0)
+        return 0;
+
+    s_cache_quota = cache_quota * PCFETCHER_CACHE_QUOTA_UNIT;
+    s_cache_used = 0;
+    s_cache_entries = new HashMap<String, std::unique_ptr<CacheEntry>>();
+    s_cache_lru = new ListHashSet<String>();
+
+    const char *dir = getenv(PURC_ENVV_FETCHER_CACHE_DIR);
+    if (dir && dir[0] && access(dir, W_OK) == 0)
+        s_cache_dir = CString(dir);
+    else
+        s_cache_dir = CString();
+
+    return 0;
+}
+
+void pcfetcher_cache_term(void)
+{
+    auto locker = holdLock(s_cache_lock);
+    if (s_cache_refs == 0 || --s_cache_refs > 0)
+        return;
+
+    delete s_cache_entries;
+    s_cache_entries = nullptr;
+    delete s_cache_lru;
+    s_cache_lru = nullptr;
+    s_cache_used = 0;
+    s_cache_dir = CString();
+}
+
+enum pcfetcher_cache_status
+pcfetcher_cache_lookup(const char *url,
+        struct pcfetcher_resp_header *resp_header, purc_rwstream_t *resp,
+        char **etag, char **last_modified)
+{
+    auto locker = holdLock(s_cache_lock);
+    if (s_cache_entries == nullptr || s_cache_quota == 0)
+        return PCFETCHER_CACHE_MISS;
+
+    String key = String::fromUTF8(url);
+    CacheEntry *entry = find_entry(key);
+    if (entry == nullptr)
+        return PCFETCHER_CACHE_MISS;
+
+    if (entry->expires > time(NULL)) {
+        if (copy_entry(entry, resp_header, resp))
+            return PCFETCHER_CACHE_FRESH;
+        return PCFETCHER_CACHE_MISS;
+    }
+
+    if (entry->etag.isNull() && entry->last_modified.isNull()) {
+        /* a stale response without validators is useless */
+        remove_entry(key);
+        disk_remove(key);
+        return PCFETCHER_CACHE_MISS;
+    }
+
+    *etag = dup_cstring(entry->etag);
+    *last_modified = dup_cstring(entry->last_modified);
+    return PCFETCHER_CACHE_STALE;
+}
+
+void pcfetcher_cache_store(const char *url,
+        const struct pcfetcher_resp_header *resp_header,
+        const void *data, size_t sz_data,
+        const struct pcfetcher_cache_policy *policy)
+{
+    auto locker = holdLock(s_cache_lock);
+    if (s_cache_entries == nullptr || s_cache_quota == 0)
+        return;
+
+    String key = String::fromUTF8(url);
+    if (policy->no_store || resp_header->ret_code != 200 ||
+            (policy->expires <= time(NULL) &&
+             policy->etag == NULL && policy->last_modified == NULL)) {
+        remove_entry(key);
+        disk_remove(key);
+        return;
+    }
+
+    auto entry = makeUnique<CacheEntry>();
+    entry->ret_code = resp_header->ret_code;
+    if (resp_header->mime_type)
+        entry->mime_type = CString(resp_header->mime_type);
+    if (policy->etag)
+        entry->etag = CString(policy->etag);
+    if (policy->last_modified)
+        entry->last_modified = CString(policy->last_modified);
+    entry->expires = policy->expires;
+    if (sz_data > 0) {
+        entry->data = malloc(sz_data);
+        if (entry->data == NULL)
+            return;
+        memcpy(entry->data, data, sz_data);
+        entry->sz_data = sz_data;
+    }
+
+    disk_write(key, *entry);
+    insert_entry(key, WTFMove(entry));
+}
+
+bool pcfetcher_cache_revalidated(const char *url,
+        const struct pcfetcher_cache_policy *policy,
+        struct pcfetcher_resp_header *resp_header, purc_rwstream_t *resp)
+{
+    auto locker = holdLock(s_cache_lock);
+    if (s_cache_entries == nullptr)
+        return false;
+
+    String key = String::fromUTF8(url);
+    CacheEntry *entry = find_entry(key);
+    if (entry == nullptr)
+        return false;
+
+    /* a 304 response may update the validators and the freshness */
+    s_cache_used -= entry->cost(key);
+    entry->expires = policy->expires;
+    if (policy->etag)
+        entry->etag = CString(policy->etag);
+    if (policy->last_modified)
+        entry->last_modified = CString(policy->last_modified);
+    s_cache_used += entry->cost(key);
+
+    bool ok = copy_entry(entry, resp_header, resp);
+    if (policy->no_store) {
+        remove_entry(key);
+        disk_remove(key);
+    }
+    else {
+        disk_write(key, *entry);
+    }
+    return ok;
+}
+
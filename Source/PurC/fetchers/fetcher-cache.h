@@ -0,0 +1,103 @@
+/*
+ * @file fetcher-cache.h
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The interface of the response cache shared by the fetchers.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PURC_FETCHER_CACHE_H
+#define PURC_FETCHER_CACHE_H
+
+#include "fetcher-internal.h"
+
+/* If set, the cached responses are also kept in this directory. */
+#define PURC_ENVV_FETCHER_CACHE_DIR     "PURC_FETCHER_CACHE_DIR"
+
+/* The unit of the cache quota (`cache_quota` of an instance) in bytes. */
+#define PCFETCHER_CACHE_QUOTA_UNIT      1024
+
+/* The caching policy derived from the headers of a response. */
+struct pcfetcher_cache_policy {
+    /* Cache-Control: no-store; the response must not be cached. */
+    bool no_store;
+    /* The absolute time (seconds since Epoch) the response gets stale;
+       zero means the response must be revalidated before every use. */
+    time_t expires;
+    /* The validators; nullable. */
+    const char *etag;
+    const char *last_modified;
+};
+
+enum pcfetcher_cache_status {
+    PCFETCHER_CACHE_MISS = 0,
+    PCFETCHER_CACHE_FRESH,
+    PCFETCHER_CACHE_STALE,
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+/* Initialize the process-wide cache; the calls are reference counted. */
+int pcfetcher_cache_init(size_t cache_quota);
+
+void pcfetcher_cache_term(void);
+
+/*
+ * Look up the cached response of a GET request for @url.
+ *
+ * For PCFETCHER_CACHE_FRESH, @resp_header is filled (the caller owns
+ * `mime_type`) and a new memory stream holding a copy of the body is
+ * returned via @resp.
+ *
+ * For PCFETCHER_CACHE_STALE, the validators of the cached response are
+ * returned via @etag and @last_modified (nullable; freed by the caller)
+ * to make a conditional request.
+ */
+enum pcfetcher_cache_status
+pcfetcher_cache_lookup(const char *url,
+        struct pcfetcher_resp_header *resp_header, purc_rwstream_t *resp,
+        char **etag, char **last_modified);
+
+/*
+ * Store a response into the cache. If the response is not cacheable
+ * according to @policy, any stale entry for @url is dropped.
+ */
+void pcfetcher_cache_store(const char *url,
+        const struct pcfetcher_resp_header *resp_header,
+        const void *data, size_t sz_data,
+        const struct pcfetcher_cache_policy *policy);
+
+/*
+ * Handle a `304 Not Modified` response: update the freshness of the
+ * cached entry according to @policy and return a copy of it like
+ * pcfetcher_cache_lookup() does for a fresh entry.
+ * Returns false if the entry has been evicted meanwhile.
+ */
+bool pcfetcher_cache_revalidated(const char *url,
+        const struct pcfetcher_cache_policy *policy,
+        struct pcfetcher_resp_header *resp_header, purc_rwstream_t *resp);
+
+#ifdef __cplusplus
+}
+#endif  /* __cplusplus */
+
+#endif /* not defined PURC_FETCHER_CACHE_H */
+
@@ -61,6 +61,16 @@ typedef purc_variant_t (*pcfetcher_request_async_fn)(
         pcfetcher_response_handler handler,
         void* ctxt);
 
+typedef purc_variant_t (*pcfetcher_request_progressively_fn)(
+        struct pcfetcher* fetcher,
+        const char* url,
+        enum pcfetcher_request_method method,
+        purc_variant_t params,
+        uint32_t timeout,
+        pcfetcher_response_handler handler,
+        pcfetcher_progress_handler progress,
+        void* ctxt);
+
 typedef purc_rwstream_t (*pcfetcher_request_sync_fn)(
         struct pcfetcher* fetcher,
         const char* url,
@@ -75,6 +85,9 @@ typedef void (*pcfetcher_cancel_async_fn)(struct pcfetcher* fetcher,
 typedef int (*pcfetcher_check_response_fn)(struct pcfetcher* fetcher,
         uint32_t timeout_ms);
 
+typedef void (*pcfetcher_get_stats_fn)(struct pcfetcher* fetcher,
+        struct pcfetcher_stats *stats);
+
 struct pcfetcher {
     size_t max_conns;
     size_t cache_quota;
@@ -86,9 +99,12 @@ struct pcfetcher {
     pcfetcher_cookie_get_fn cookie_get;
     pcfetcher_cookie_remove_fn cookie_remove;
     pcfetcher_request_async_fn request_async;
+    /* nullable; the body will be handed over in one chunk if it is NULL */
+    pcfetcher_request_progressively_fn request_progressively;
     pcfetcher_request_sync_fn request_sync;
     pcfetcher_cancel_async_fn cancel_async;
     pcfetcher_check_response_fn check_response;
+    pcfetcher_get_stats_fn get_stats;
 };
 
 struct pcfetcher_callback_info {
@@ -99,9 +115,18 @@ struct pcfetcher_callback_info {
     volatile bool cancelled;
 
     pcfetcher_response_handler handler;
+    /* not NULL if the body is handed over progressively */
+    pcfetcher_progress_handler progress;
     void *ctxt;
 };
 
+/* whether @url starts with a scheme */
+bool pcfetcher_has_scheme(const char *url);
+
+/* gets the handler if the scheme of @url is served in the process */
+bool pcfetcher_lookup_scheme(const char *url,
+        pcfetcher_scheme_handler *handler, void **ctxt);
+
 struct pcfetcher* pcfetcher_local_init(size_t max_conns, size_t cache_quota);
 
 int pcfetcher_local_term(struct pcfetcher* fetcher);
@@ -143,6 +168,9 @@ void pcfetcher_local_cancel_async(struct pcfetcher* fetcher,
 int pcfetcher_local_check_response(struct pcfetcher* fetcher,
         uint32_t timeout_ms);
 
+void pcfetcher_local_get_stats(struct pcfetcher* fetcher,
+        struct pcfetcher_stats *stats);
+
 #if ENABLE(REMOTE_FETCHER)
 
 struct pcfetcher* pcfetcher_remote_init(size_t max_conns, size_t cache_quota);
@@ -173,6 +201,16 @@ purc_variant_t pcfetcher_remote_request_async(
         pcfetcher_response_handler handler,
         void* ctxt);
 
+purc_variant_t pcfetcher_remote_request_progressively(
+        struct pcfetcher* fetcher,
+        const char* url,
+        enum pcfetcher_request_method method,
+        purc_variant_t params,
+        uint32_t timeout,
+        pcfetcher_response_handler handler,
+        pcfetcher_progress_handler progress,
+        void* ctxt);
+
 purc_rwstream_t pcfetcher_remote_request_sync(
         struct pcfetcher* fetcher,
         const char* url,
@@ -187,6 +225,9 @@ void pcfetcher_remote_cancel_async(struct pcfetcher* fetcher,
 int pcfetcher_remote_check_response(struct pcfetcher* fetcher,
         uint32_t timeout_ms);
 
+void pcfetcher_remote_get_stats(struct pcfetcher* fetcher,
+        struct pcfetcher_stats *stats);
+
 #endif // ENABLE(REMOTE_FETCHER)
 
 struct pcfetcher_callback_info *pcfetcher_create_callback_info();
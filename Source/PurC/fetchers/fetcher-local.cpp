@@ -27,17 +27,29 @@
 #include "fetcher-internal.h"
 
 #include <wtf/URL.h>
+#include <wtf/MonotonicTime.h>
 #include <wtf/RunLoop.h>
+#include <wtf/WorkQueue.h>
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
 
 #include <stdlib.h>
 
+/* The number of the worker threads reading files for async requests. */
+#define NR_LOCAL_WORKERS        2
+
+/* The files not smaller than this are mapped instead of being read. */
+#define MIN_MMAP_FILE_SIZE      (256 * 1024)
+
 struct pcfetcher_local {
     struct pcfetcher base;
     char* base_uri;
+
+    WorkQueue *workers[NR_LOCAL_WORKERS];
+    unsigned next_worker;
 };
 
 struct mime_type {
@@ -82,12 +94,20 @@ struct pcfetcher* pcfetcher_local_init(size_t max_conns, size_t cache_quota)
     fetcher->cookie_get = pcfetcher_cookie_local_get;
     fetcher->cookie_remove = pcfetcher_cookie_loccal_remove;
     fetcher->request_async = pcfetcher_local_request_async;
+    fetcher->request_progressively = NULL;
     fetcher->request_sync = pcfetcher_local_request_sync;
     fetcher->cancel_async = pcfetcher_local_cancel_async;
     fetcher->check_response = pcfetcher_local_check_response;
+    fetcher->get_stats = pcfetcher_local_get_stats;
 
     local->base_uri = NULL;
 
+    for (size_t i = 0; i < NR_LOCAL_WORKERS; i++) {
+        local->workers[i] =
+            &WorkQueue::create("PcFetcherLocal_Queue").leakRef();
+    }
+    local->next_worker = 0;
+
     return fetcher;
 }
 
@@ -98,6 +118,9 @@ int pcfetcher_local_term(struct pcfetcher* fetcher)
     }
 
     struct pcfetcher_local* local = (struct pcfetcher_local*)fetcher;
+    for (size_t i = 0; i < NR_LOCAL_WORKERS; i++) {
+        local->workers[i]->deref();
+    }
     if (local->base_uri) {
         free(local->base_uri);
     }
@@ -162,6 +185,93 @@ const char* pcfetcher_cookie_loccal_remove(struct pcfetcher* fetcher,
     return NULL;
 }
 
+/* Loads the whole file, so that the stream never blocks on the disk. */
+static purc_rwstream_t load_file(const char *file, size_t *sz_file)
+{
+    int fd = open(file, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    purc_rwstream_t rws = NULL;
+    struct stat statbuf;
+    if (fstat(fd, &statbuf) || !S_ISREG(statbuf.st_mode)) {
+        goto done;
+    }
+
+    *sz_file = statbuf.st_size;
+    if (*sz_file >= MIN_MMAP_FILE_SIZE) {
+        rws = purc_rwstream_new_from_mmap(file);
+        if (rws) {
+            goto done;
+        }
+        /* fall back to read the file */
+        purc_clr_error();
+    }
+
+    rws = purc_rwstream_new_buffer(*sz_file ? *sz_file : 1, INT_MAX);
+    if (rws) {
+        char buf[4096];
+        ssize_t n;
+        while ((n = read(fd, buf, sizeof(buf))) > 0) {
+            purc_rwstream_write(rws, buf, n);
+        }
+
+        if (n < 0) {
+            purc_rwstream_destroy(rws);
+            rws = NULL;
+        }
+        else {
+            purc_rwstream_seek(rws, 0, SEEK_SET);
+        }
+    }
+
+done:
+    close(fd);
+    return rws;
+}
+
+static bool get_local_path(struct pcfetcher_local* local, const char* url,
+        CString& path)
+{
+    String uri;
+    if (local->base_uri &&
+            strncmp(url, local->base_uri, strlen(local->base_uri)) != 0) {
+        uri.append(local->base_uri);
+    }
+    uri.append(url);
+    PurCWTF::URL wurl(URL(), uri);
+    if (!wurl.isLocalFile()) {
+        return false;
+    }
+
+    path = wurl.path().utf8();
+    return true;
+}
+
+static purc_rwstream_t load_local_file(const char* file,
+        struct pcfetcher_resp_header *resp_header)
+{
+    MonotonicTime start = MonotonicTime::now();
+    size_t sz_file = 0;
+    purc_rwstream_t rws = load_file(file, &sz_file);
+    if (rws && resp_header) {
+        resp_header->ret_code = 200;
+        resp_header->sz_resp = sz_file;
+        resp_header->mime_type = strdup(get_mime(file));
+    }
+
+    struct pcfetcher_timing timing = { };
+    timing.total = (MonotonicTime::now() - start).seconds();
+    timing.transfer = timing.total;
+    timing.sz_received = rws ? sz_file : 0;
+    if (resp_header)
+        resp_header->timing = timing;
+    pcfetcher_record_timing(&timing);
+
+    return rws;
+}
+
 purc_variant_t pcfetcher_local_request_async(
         struct pcfetcher* fetcher,
         const char* url,
@@ -171,36 +281,46 @@ purc_variant_t pcfetcher_local_request_async(
         pcfetcher_response_handler handler,
         void* ctxt)
 {
-    UNUSED_PARAM(fetcher);
-    UNUSED_PARAM(url);
     UNUSED_PARAM(method);
     UNUSED_PARAM(params);
     UNUSED_PARAM(timeout);
-    UNUSED_PARAM(handler);
-    UNUSED_PARAM(ctxt);
 
     if (!fetcher || !url || !handler) {
         return PURC_VARIANT_INVALID;
     }
 
     struct pcfetcher_callback_info *info = pcfetcher_create_callback_info();
-    info->rws = pcfetcher_local_request_sync(fetcher, url, method,
-            params, timeout, &info->header);
+    if (info == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return PURC_VARIANT_INVALID;
+    }
     info->handler = handler;
     info->ctxt = ctxt;
     info->req_id = purc_variant_make_native(info, NULL);
 
-    if (!info->rws) {
-        info->header.ret_code = 404;
-    }
+    struct pcfetcher_local* local = (struct pcfetcher_local*)fetcher;
+    CString path;
+    bool is_local = get_local_path(local, url, path);
 
+    // the file is read on a worker, and the handler is called on the
+    // run loop of the requesting thread.
     RunLoop *runloop = &RunLoop::current();
+    WorkQueue *worker = local->workers[local->next_worker];
+    local->next_worker = (local->next_worker + 1) % NR_LOCAL_WORKERS;
+    worker->dispatch([info, runloop, is_local, path=WTFMove(path)] {
+        if (!info->cancelled && is_local) {
+            info->rws = load_local_file(path.data(), &info->header);
+        }
+        if (!info->rws) {
+            info->header.ret_code = 404;
+        }
+
 #ifdef NDEBUG
-    runloop->dispatch([info] {
+        runloop->dispatch([info] {
 #else
-    // random
-    double tm = randomNumber() * 10;
-    runloop->dispatchAfter(Seconds(tm), [info] {
+        // random
+        double tm = randomNumber() * 10;
+        runloop->dispatchAfter(Seconds(tm), [info] {
 #endif
                 if (!info->cancelled) {
                     info->handler(info->req_id, info->ctxt, &info->header,
@@ -209,17 +329,11 @@ purc_variant_t pcfetcher_local_request_async(
                 }
                 pcfetcher_destroy_callback_info(info);
             });
+    });
 
     return info->req_id;
 }
 
-off_t filesize(const char* filename)
-{
-    struct stat statbuf;
-    stat(filename,&statbuf);
-    return statbuf.st_size;
-}
-
 purc_rwstream_t pcfetcher_local_request_sync(
         struct pcfetcher* fetcher,
         const char* url,
@@ -228,45 +342,23 @@ purc_rwstream_t pcfetcher_local_request_sync(
         uint32_t timeout,
         struct pcfetcher_resp_header *resp_header)
 {
-    UNUSED_PARAM(fetcher);
-    UNUSED_PARAM(url);
     UNUSED_PARAM(method);
     UNUSED_PARAM(params);
     UNUSED_PARAM(timeout);
-    UNUSED_PARAM(resp_header);
 
     if (!fetcher || !url) {
         return NULL;
     }
     struct pcfetcher_local* local = (struct pcfetcher_local*)fetcher;
-    String uri;
-    if (local->base_uri &&
-            strncmp(url, local->base_uri, strlen(local->base_uri)) != 0) {
-        uri.append(local->base_uri);
-    }
-    uri.append(url);
-    PurCWTF::URL wurl(URL(), uri);
-    if (!wurl.isLocalFile()) {
+    CString path;
+    if (!get_local_path(local, url, path)) {
         resp_header->ret_code = 404;
         resp_header->sz_resp = 0;
         resp_header->mime_type = NULL;
         return NULL;
     }
 
-    const StringView path = wurl.path();
-    const CString& cpath = path.utf8();
-
-    const char* file = cpath.data();
-
-    purc_rwstream_t rws = purc_rwstream_new_from_file(file, "r");
-    if (rws && resp_header) {
-        resp_header->ret_code = 200;
-        resp_header->sz_resp = filesize(file);
-        resp_header->mime_type = strdup(get_mime(file));
-        return rws;
-    }
-
-    return NULL;
+    return load_local_file(path.data(), resp_header);
 }
 
 void pcfetcher_local_cancel_async(struct pcfetcher* fetcher,
@@ -292,4 +384,9 @@ int pcfetcher_local_check_response(struct pcfetcher* fetcher,
     return 0;
 }
 
-
+void pcfetcher_local_get_stats(struct pcfetcher* fetcher,
+        struct pcfetcher_stats *stats)
+{
+    // the local files are not fetched over any connection
+    stats->max_conns = fetcher->max_conns;
+}
@@ -38,8 +38,9 @@
 using namespace PurCFetcher;
 
 PcFetcherProcess::PcFetcherProcess(struct pcfetcher* fetcher,
-        bool alwaysRunsAtBackgroundPriority)
+        size_t maxConns, bool alwaysRunsAtBackgroundPriority)
  : m_fetcher(fetcher)
+ , m_maxConns(maxConns)
  , m_workQueue(WorkQueue::create("PcFetcherProcess_Queue"))
  , m_alwaysRunsAtBackgroundPriority(alwaysRunsAtBackgroundPriority)
 {
@@ -252,7 +253,7 @@ void PcFetcherProcess::setProcessSuppressionEnabled(bool processSuppressionEnabl
     UNUSED_PARAM(processSuppressionEnabled);
 }
 
-PcFetcherRequest* PcFetcherProcess::createRequest(void)
+bool PcFetcherProcess::connectRequest(PcFetcherRequest *request)
 {
     PurCFetcher::ProcessIdentifier pid = ProcessIdentifier::generate();
 //    PAL::SessionID sid(ProcessIdentifier::generate().toUInt64());
@@ -264,8 +265,18 @@ PcFetcherRequest* PcFetcherProcess::createRequest(void)
         Messages::NetworkProcess::CreateNetworkConnectionToWebProcess { pid, sid },
         Messages::NetworkProcess::CreateNetworkConnectionToWebProcess::Reply(
             attachment, cookieAcceptPolicy), destinationID);
-    PcFetcherRequest *request  = new PcFetcherRequest(sid.toUInt64(),
-            attachment->releaseFileDescriptor(), m_workQueue.get(), this);
+    if (!attachment) {
+        return false;
+    }
+
+    request->open(attachment->releaseFileDescriptor());
+    return true;
+}
+
+PcFetcherRequest* PcFetcherProcess::createRequest(void)
+{
+    PcFetcherRequest *request  = new PcFetcherRequest(1,
+            m_workQueue.get(), this);
     if (!request) {
         return NULL;
     }
@@ -300,7 +311,8 @@ purc_variant_t PcFetcherProcess::requestAsync(
         purc_variant_t params,
         uint32_t timeout,
         pcfetcher_response_handler handler,
-        void* ctxt)
+        void* ctxt,
+        pcfetcher_progress_handler progress)
 {
     PcFetcherRequest* session = createRequest();
     if (!session) {
@@ -308,8 +320,37 @@ purc_variant_t PcFetcherProcess::requestAsync(
         return PURC_VARIANT_INVALID;
     }
 
-    return session->requestAsync(base_uri, url, method,
-            params, timeout, handler, ctxt);
+    purc_variant_t req_id = session->prepareAsync(handler, ctxt, progress);
+    if (!req_id) {
+        removeRequest(session);
+        return PURC_VARIANT_INVALID;
+    }
+
+    {
+        auto locker = holdLock(m_requestLock);
+        m_nrRequests++;
+        if (m_maxConns && m_activeRequests.size() >= m_maxConns) {
+            // wait for a request in flight to finish
+            if (params)
+                purc_variant_ref(params);
+            m_pendingRequests.append({ session, CString(base_uri),
+                    CString(url), method, params, timeout });
+            m_nrQueued++;
+            return req_id;
+        }
+
+        m_activeRequests.add(session);
+        if (m_activeRequests.size() > m_peakActive)
+            m_peakActive = m_activeRequests.size();
+    }
+
+    if (!connectRequest(session)) {
+        session->cancel();
+        return req_id;
+    }
+
+    session->startAsync(base_uri, url, method, params, timeout);
+    return req_id;
 }
 
 purc_rwstream_t PcFetcherProcess::requestSync(
@@ -321,10 +362,56 @@ purc_rwstream_t PcFetcherProcess::requestSync(
         struct pcfetcher_resp_header *resp_header)
 {
     PcFetcherRequest* session = createRequest();
+    if (!session || !connectRequest(session)) {
+        if (session)
+            removeRequest(session);
+        return NULL;
+    }
+
+    // A sync request is never queued: the calling thread may be the one
+    // which has to run the callbacks of the requests in flight.
+    {
+        auto locker = holdLock(m_requestLock);
+        m_nrRequests++;
+        m_activeRequests.add(session);
+        if (m_activeRequests.size() > m_peakActive)
+            m_peakActive = m_activeRequests.size();
+    }
+
     return session->requestSync(base_uri, url, method,
             params, timeout, resp_header);
 }
 
+void PcFetcherProcess::startPendingRequests(void)
+{
+    while (true) {
+        PendingRequest pending;
+        {
+            auto locker = holdLock(m_requestLock);
+            if (m_pendingRequests.isEmpty() || (m_maxConns &&
+                    m_activeRequests.size() >= m_maxConns))
+                return;
+
+            pending = m_pendingRequests.takeFirst();
+            m_activeRequests.add(pending.request);
+            if (m_activeRequests.size() > m_peakActive)
+                m_peakActive = m_activeRequests.size();
+        }
+
+        if (connectRequest(pending.request)) {
+            pending.request->startAsync(pending.baseUri.data(),
+                    pending.url.data(), pending.method, pending.params,
+                    pending.timeout);
+        }
+        else {
+            pending.request->cancel();
+        }
+
+        if (pending.params)
+            purc_variant_unref(pending.params);
+    }
+}
+
 void PcFetcherProcess::cancelAsyncRequest(purc_variant_t request_id)
 {
     if (!request_id) {
@@ -347,7 +434,40 @@ void PcFetcherProcess::requestFinished(PcFetcherRequest *request)
     if (!request) {
         return;
     }
+
+    purc_variant_t params = PURC_VARIANT_INVALID;
+    {
+        auto locker = holdLock(m_requestLock);
+        if (!m_activeRequests.remove(request)) {
+            // a queued request was cancelled
+            for (auto it = m_pendingRequests.begin();
+                    it != m_pendingRequests.end(); ++it) {
+                if (it->request == request) {
+                    params = it->params;
+                    m_pendingRequests.remove(it);
+                    break;
+                }
+            }
+        }
+    }
+
+    if (params)
+        purc_variant_unref(params);
     removeRequest(request);
+    startPendingRequests();
+}
+
+void PcFetcherProcess::getStats(struct pcfetcher_stats *stats)
+{
+    auto locker = holdLock(m_requestLock);
+    stats->max_conns += m_maxConns;
+    stats->nr_active += m_activeRequests.size();
+    stats->nr_queued += m_pendingRequests.size();
+    stats->nr_peak_active += m_peakActive;
+    stats->nr_requests += m_nrRequests;
+    stats->nr_queued_requests += m_nrQueued;
+    stats->nr_processes++;
+    stats->nr_process_restarts += m_nrRestarts;
 }
 
 bool PcFetcherProcess::isReadyToTerm()
@@ -358,6 +478,11 @@ bool PcFetcherProcess::isReadyToTerm()
 
 void PcFetcherProcess::didClose(IPC::Connection&)
 {
+    // the requests in flight fail when their own connections are closed
+    {
+        auto locker = holdLock(m_requestLock);
+        m_nrRestarts++;
+    }
     reset();
     RunLoop::main().dispatch([process=this] {
         process->connect();
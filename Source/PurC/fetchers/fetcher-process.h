@@ -33,6 +33,8 @@
 #include "Connection.h"
 #include "ProcessLauncher.h"
 
+#include <wtf/Deque.h>
+#include <wtf/HashSet.h>
 #include <wtf/ProcessID.h>
 #include <wtf/SystemTracing.h>
 #include <wtf/ThreadSafeRefCounted.h>
@@ -43,7 +45,9 @@ class PcFetcherProcess : ProcessLauncher::Client, public IPC::Connection::Client
     WTF_MAKE_NONCOPYABLE(PcFetcherProcess);
 
 public:
-    PcFetcherProcess(struct pcfetcher* fetcher,
+    // @maxConns: the maximal number of the requests in flight handled by
+    // this process; 0 for no limit.
+    PcFetcherProcess(struct pcfetcher* fetcher, size_t maxConns,
             bool alwaysRunsAtBackgroundPriority = false);
 
     virtual ~PcFetcherProcess();
@@ -92,6 +96,9 @@ public:
     State state() const;
     bool isLaunching() const { return state() == State::Launching; }
     bool wasTerminated() const;
+    // whether the process is launching or running; a process being
+    // restarted after it crashed is not healthy.
+    bool isHealthy() const { return !wasTerminated(); }
 
     ProcessID processIdentifier() const { return m_processLauncher ? m_processLauncher->processIdentifier() : 0; }
 
@@ -111,7 +118,8 @@ public:
         purc_variant_t params,
         uint32_t timeout,
         pcfetcher_response_handler handler,
-        void* ctxt);
+        void* ctxt,
+        pcfetcher_progress_handler progress = nullptr);
 
     purc_rwstream_t requestSync(
         const char* base_uri,
@@ -121,7 +129,8 @@ public:
         uint32_t timeout,
         struct pcfetcher_resp_header *resp_header);
 
-    void cancelAsyncRequest(purc_variant_t request_id);
+    // the request knows the process handling it
+    static void cancelAsyncRequest(purc_variant_t request_id);
 
     int checkResponse(uint32_t timeout_ms);
 
@@ -129,6 +138,9 @@ public:
 
     bool isReadyToTerm();
 
+    // adds the statistics of this process to @stats
+    void getStats(struct pcfetcher_stats *stats);
+
 protected:
     // ProcessLauncher::Client
     void didFinishLaunching(ProcessLauncher*, IPC::Connection::Identifier) override;
@@ -154,10 +166,23 @@ protected:
 
 private:
     PcFetcherRequest* createRequest(void);
+    bool connectRequest(PcFetcherRequest *request);
     void removeRequest(PcFetcherRequest *request);
+    void startPendingRequests(void);
+
+    // an async request waiting for a free connection
+    struct PendingRequest {
+        PcFetcherRequest *request;
+        CString baseUri;
+        CString url;
+        enum pcfetcher_request_method method;
+        purc_variant_t params;
+        uint32_t timeout;
+    };
 
 private:
     struct pcfetcher* m_fetcher;
+    size_t m_maxConns;
 
     RefPtr<WorkQueue> m_workQueue;
     RunLoop *m_workQueueRunLoop;
@@ -172,6 +197,14 @@ private:
 
     Lock m_requestLock;
     Vector<PcFetcherRequest*> m_requestVec;
+
+    // the following members are protected by m_requestLock
+    Deque<PendingRequest> m_pendingRequests;
+    HashSet<PcFetcherRequest*> m_activeRequests;
+    size_t m_peakActive { 0 };
+    uint64_t m_nrRequests { 0 };
+    uint64_t m_nrQueued { 0 };
+    uint64_t m_nrRestarts { 0 };
 };
 
 template<typename T>
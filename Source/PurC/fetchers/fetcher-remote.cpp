@@ -29,15 +29,61 @@
 
 #include "fetcher-internal.h"
 #include "fetcher-process.h"
+#include "fetcher-cache.h"
 
 #if ENABLE(REMOTE_FETCHER)
 
+#include <wtf/URL.h>
+
+/* The number of the fetcher processes; the requests are sharded by origin */
+#define PURC_ENVV_FETCHER_PROCESSES     "PURC_FETCHER_PROCESSES"
+#define MAX_FETCHER_PROCESSES           8
+
 struct pcfetcher_remote {
     struct pcfetcher base;
-    PcFetcherProcess* process;
+    size_t nr_processes;
+    PcFetcherProcess* processes[MAX_FETCHER_PROCESSES];
     char* base_uri;
 };
 
+static size_t nr_fetcher_processes(void)
+{
+    const char *env = getenv(PURC_ENVV_FETCHER_PROCESSES);
+    long n = env ? strtol(env, NULL, 10) : 1;
+    if (n < 1)
+        return 1;
+    return (n > MAX_FETCHER_PROCESSES) ? MAX_FETCHER_PROCESSES : (size_t)n;
+}
+
+/*
+ * Returns the process for the origin of the URL; the requests to an origin
+ * go to the same process as long as it is healthy. While a process is being
+ * restarted after it crashed, its requests go to the next healthy one.
+ */
+static PcFetcherProcess* get_process(struct pcfetcher_remote* remote,
+        const char* url)
+{
+    if (remote->nr_processes == 1)
+        return remote->processes[0];
+
+    String uri;
+    if (remote->base_uri && !strstr(url, "://"))
+        uri.append(remote->base_uri);
+    uri.append(url);
+
+    URL wurl(URL(), uri);
+    unsigned hash = wurl.protocolHostAndPort().hash();
+    size_t idx = hash % remote->nr_processes;
+    for (size_t i = 0; i < remote->nr_processes; i++) {
+        PcFetcherProcess *process =
+            remote->processes[(idx + i) % remote->nr_processes];
+        if (process->isHealthy())
+            return process;
+    }
+
+    return remote->processes[idx];
+}
+
 struct pcfetcher* pcfetcher_remote_init(size_t max_conns, size_t cache_quota)
 {
     struct pcfetcher_remote* remote = (struct pcfetcher_remote*)malloc(
@@ -53,12 +99,21 @@ struct pcfetcher* pcfetcher_remote_init(size_t max_conns, size_t cache_quota)
     fetcher->cookie_get = pcfetcher_cookie_remote_get;
     fetcher->cookie_remove = pcfetcher_cookie_remote_remove;
     fetcher->request_async = pcfetcher_remote_request_async;
+    fetcher->request_progressively = pcfetcher_remote_request_progressively;
     fetcher->request_sync = pcfetcher_remote_request_sync;
     fetcher->cancel_async = pcfetcher_remote_cancel_async;
     fetcher->check_response = pcfetcher_remote_check_response;
+    fetcher->get_stats = pcfetcher_remote_get_stats;
 
-    remote->process = new PcFetcherProcess(fetcher);
-    remote->process->connect();
+    pcfetcher_cache_init(cache_quota);
+    remote->nr_processes = nr_fetcher_processes();
+    for (size_t i = 0; i < remote->nr_processes; i++) {
+        // the connections are shared out among the processes
+        size_t conns = max_conns ?
+            (max_conns + remote->nr_processes - 1) / remote->nr_processes : 0;
+        remote->processes[i] = new PcFetcherProcess(fetcher, conns);
+        remote->processes[i]->connect();
+    }
     remote->base_uri = NULL;
 
     return (struct pcfetcher*)remote;
@@ -67,11 +122,16 @@ struct pcfetcher* pcfetcher_remote_init(size_t max_conns, size_t cache_quota)
 int pcfetcher_remote_term(struct pcfetcher* fetcher)
 {
     struct pcfetcher_remote* remote = (struct pcfetcher_remote*)fetcher;
-    if (!remote->process->isReadyToTerm()) {
-        return PURC_ERROR_NOT_READY;
+    for (size_t i = 0; i < remote->nr_processes; i++) {
+        if (!remote->processes[i]->isReadyToTerm()) {
+            return PURC_ERROR_NOT_READY;
+        }
     }
 
-    delete remote->process;
+    for (size_t i = 0; i < remote->nr_processes; i++) {
+        delete remote->processes[i];
+    }
+    pcfetcher_cache_term();
     if (remote->base_uri) {
         free(remote->base_uri);
     }
@@ -148,11 +208,27 @@ purc_variant_t pcfetcher_remote_request_async(
         void* ctxt)
 {
     struct pcfetcher_remote* remote = (struct pcfetcher_remote*)fetcher;
-    return remote->process->requestAsync(
+    return get_process(remote, url)->requestAsync(
             remote->base_uri,
             url, method, params, timeout, handler, ctxt);
 }
 
+purc_variant_t pcfetcher_remote_request_progressively(
+        struct pcfetcher* fetcher,
+        const char* url,
+        enum pcfetcher_request_method method,
+        purc_variant_t params,
+        uint32_t timeout,
+        pcfetcher_response_handler handler,
+        pcfetcher_progress_handler progress,
+        void* ctxt)
+{
+    struct pcfetcher_remote* remote = (struct pcfetcher_remote*)fetcher;
+    return get_process(remote, url)->requestAsync(
+            remote->base_uri,
+            url, method, params, timeout, handler, ctxt, progress);
+}
+
 
 purc_rwstream_t pcfetcher_remote_request_sync(
         struct pcfetcher* fetcher,
@@ -163,7 +239,7 @@ purc_rwstream_t pcfetcher_remote_request_sync(
         struct pcfetcher_resp_header *resp_header)
 {
     struct pcfetcher_remote* remote = (struct pcfetcher_remote*)fetcher;
-    return remote->process->requestSync(
+    return get_process(remote, url)->requestSync(
             remote->base_uri,
             url, method, params, timeout, resp_header);
 }
@@ -171,15 +247,25 @@ purc_rwstream_t pcfetcher_remote_request_sync(
 void pcfetcher_remote_cancel_async(struct pcfetcher* fetcher,
         purc_variant_t request)
 {
-    struct pcfetcher_remote* remote = (struct pcfetcher_remote*)fetcher;
-    remote->process->cancelAsyncRequest(request);
+    UNUSED_PARAM(fetcher);
+    PcFetcherProcess::cancelAsyncRequest(request);
 }
 
 int pcfetcher_remote_check_response(struct pcfetcher* fetcher,
         uint32_t timeout_ms)
 {
     struct pcfetcher_remote* remote = (struct pcfetcher_remote*)fetcher;
-    return remote->process->checkResponse(timeout_ms);
+    return remote->processes[0]->checkResponse(timeout_ms);
+}
+
+void pcfetcher_remote_get_stats(struct pcfetcher* fetcher,
+        struct pcfetcher_stats *stats)
+{
+    struct pcfetcher_remote* remote = (struct pcfetcher_remote*)fetcher;
+    for (size_t i = 0; i < remote->nr_processes; i++) {
+        remote->processes[i]->getStats(stats);
+    }
+    stats->max_conns = fetcher->max_conns;
 }
 
 
@@ -35,33 +35,51 @@
 #include "ResourceResponse.h"
 
 #include <wtf/RunLoop.h>
+#include <wtf/WallTime.h>
 
 #define DEF_RWS_SIZE 1024
 
+/* The response bodies not smaller than this are handed over to the
+   rwstream without copying the received segments. */
+#define MIN_SHARED_BODY_SIZE    (64 * 1024)
+
+/* The fraction of the time since Last-Modified used as the heuristic
+   freshness lifetime when a response carries no explicit expiration. */
+#define HEURISTIC_FRESHNESS_FACTOR  0.1
+
 using namespace PurCFetcher;
 
 extern "C"  struct pcinst* pcinst_current(void);
 
 PcFetcherRequest::PcFetcherRequest(uint64_t sessionId,
-        IPC::Connection::Identifier identifier,
         WorkQueue *queue, PcFetcherProcess *process)
     : m_sessionId(sessionId)
     , m_req_id(0)
     , m_is_async(false)
-    , m_connection(IPC::Connection::createClientConnection(identifier, *this, queue))
+    , m_connection(nullptr)
     , m_workQueue(queue)
     , m_fetcherProcess(process)
+    , m_sizeDelivered(0)
+    , m_sizeReceived(0)
+    , m_timingRecorded(false)
+    , m_revalidating(false)
+    , m_notModified(false)
 {
+    memset(&m_cachePolicy, 0, sizeof(m_cachePolicy));
+
     auto locker = holdLock(m_callbackLock);
     m_callback = pcfetcher_create_callback_info();
-    if (m_callback == NULL) {
-        return;
-    }
-
-    m_connection->open();
     m_runloop = &RunLoop::current();
 }
 
+PcFetcherRequest::PcFetcherRequest(uint64_t sessionId,
+        IPC::Connection::Identifier identifier,
+        WorkQueue *queue, PcFetcherProcess *process)
+    : PcFetcherRequest(sessionId, queue, process)
+{
+    open(identifier);
+}
+
 PcFetcherRequest::~PcFetcherRequest()
 {
     close();
@@ -71,6 +89,14 @@ PcFetcherRequest::~PcFetcherRequest()
     }
 }
 
+void PcFetcherRequest::open(IPC::Connection::Identifier identifier)
+{
+    ASSERT(!m_connection);
+    m_connection = IPC::Connection::createClientConnection(identifier,
+            *this, m_workQueue);
+    m_connection->open();
+}
+
 void PcFetcherRequest::close()
 {
     if (m_connection) {
@@ -97,22 +123,245 @@ static const char* transMethod(enum pcfetcher_request_method method)
     }
 }
 
-purc_variant_t PcFetcherRequest::requestAsync(
+static void makeCachePolicy(const ResourceResponse& response,
+        struct pcfetcher_cache_policy *policy,
+        CString& etag, CString& lastModified)
+{
+    String field = response.httpHeaderField(HTTPHeaderName::ETag);
+    etag = field.isEmpty() ? CString() : field.utf8();
+    field = response.httpHeaderField(HTTPHeaderName::LastModified);
+    lastModified = field.isEmpty() ? CString() : field.utf8();
+
+    policy->no_store = response.cacheControlContainsNoStore();
+    policy->etag = etag.isNull() ? NULL : etag.data();
+    policy->last_modified = lastModified.isNull() ? NULL : lastModified.data();
+    policy->expires = 0;
+    if (policy->no_store || response.cacheControlContainsNoCache())
+        return;
+
+    double now = WallTime::now().secondsSinceEpoch().seconds();
+    double date = now;
+    if (auto responseDate = response.date())
+        date = responseDate->secondsSinceEpoch().seconds();
+
+    double lifetime = 0;
+    if (auto maxAge = response.cacheControlMaxAge())
+        lifetime = maxAge->seconds();
+    else if (auto expires = response.expires())
+        lifetime = expires->secondsSinceEpoch().seconds() - date;
+    else if (auto modified = response.lastModified())
+        lifetime = (date - modified->secondsSinceEpoch().seconds()) *
+            HEURISTIC_FRESHNESS_FACTOR;
+
+    if (auto age = response.age())
+        lifetime -= age->seconds();
+
+    if (lifetime > 0)
+        policy->expires = (time_t)(now + lifetime);
+}
+
+bool PcFetcherRequest::lookupCache(const String& uri,
+        enum pcfetcher_request_method method, ResourceRequest& request,
+        struct pcfetcher_resp_header *resp_header, purc_rwstream_t *resp)
+{
+    m_revalidating = false;
+    m_notModified = false;
+    if (method != PCFETCHER_REQUEST_METHOD_GET) {
+        m_cacheKey = CString();
+        return false;
+    }
+
+    m_cacheKey = uri.utf8();
+    char *etag = NULL;
+    char *lastModified = NULL;
+    switch (pcfetcher_cache_lookup(m_cacheKey.data(), resp_header, resp,
+                &etag, &lastModified)) {
+    case PCFETCHER_CACHE_FRESH:
+        return true;
+
+    case PCFETCHER_CACHE_STALE:
+        if (etag)
+            request.setHTTPHeaderField(HTTPHeaderName::IfNoneMatch,
+                    String::fromUTF8(etag));
+        if (lastModified)
+            request.setHTTPHeaderField(HTTPHeaderName::IfModifiedSince,
+                    String::fromUTF8(lastModified));
+        free(etag);
+        free(lastModified);
+        m_revalidating = true;
+        break;
+
+    default:
+        break;
+    }
+
+    return false;
+}
+
+// called with m_callbackLock held when the whole response is received
+void PcFetcherRequest::updateCache()
+{
+    if (m_cacheKey.isNull())
+        return;
+
+    if (m_notModified) {
+        struct pcfetcher_resp_header header = { };
+        purc_rwstream_t rws = NULL;
+        if (pcfetcher_cache_revalidated(m_cacheKey.data(), &m_cachePolicy,
+                    &header, &rws)) {
+            if (m_callback->header.mime_type)
+                free(m_callback->header.mime_type);
+            m_callback->header = header;
+            if (m_callback->rws)
+                purc_rwstream_destroy(m_callback->rws);
+            m_callback->rws = rws;
+        }
+        return;
+    }
+
+    size_t sz_content = 0;
+    void *data = NULL;
+    if (m_callback->rws)
+        data = purc_rwstream_get_mem_buffer_ex(m_callback->rws, &sz_content,
+                NULL, false);
+    pcfetcher_cache_store(m_cacheKey.data(), &m_callback->header,
+            data, sz_content, &m_cachePolicy);
+}
+
+static void releaseBodySegment(void *ctxt)
+{
+    static_cast<SharedBuffer::DataSegment*>(ctxt)->deref();
+}
+
+// called with m_callbackLock held; turns the received body into the rwstream
+void PcFetcherRequest::finishBody()
+{
+    if (!m_body)
+        return;
+
+    RefPtr<SharedBuffer> body = WTFMove(m_body);
+    if (m_callback->rws) {
+        purc_rwstream_destroy(m_callback->rws);
+        m_callback->rws = NULL;
+    }
+
+    if (body->size() < MIN_SHARED_BODY_SIZE) {
+        m_callback->rws = purc_rwstream_new_buffer(
+                body->size() ? body->size() : DEF_RWS_SIZE, INT_MAX);
+        for (const auto& element : *body)
+            purc_rwstream_write(m_callback->rws, element.segment->data(),
+                    element.segment->size());
+        return;
+    }
+
+    // A body received in one message maps to a single segment; otherwise
+    // the segments are combined once, instead of growing a buffer.
+    body->data();
+    Ref<SharedBuffer::DataSegment> segment = body->begin()->segment.copyRef();
+    const char *data = segment->data();
+    size_t size = segment->size();
+    m_callback->rws = purc_rwstream_new_from_mem_ex(data, size,
+            releaseBodySegment, &segment.leakRef());
+}
+
+static double metricsDelta(Seconds start, Seconds end)
+{
+    // -1 for the phases not happened
+    if (start.value() < 0 || end.value() < 0 || end < start)
+        return 0;
+    return (end - start).seconds();
+}
+
+// called with m_callbackLock held when the request finished or failed
+void PcFetcherRequest::finishTiming(const NetworkLoadMetrics* metrics,
+        bool cacheHit)
+{
+    if (m_timingRecorded)
+        return;
+    m_timingRecorded = true;
+
+    struct pcfetcher_timing *timing = &m_callback->header.timing;
+    memset(timing, 0, sizeof(*timing));
+    timing->cache_hit = cacheHit;
+    timing->sz_received = m_sizeReceived;
+
+    if (metrics && metrics->isComplete()) {
+        timing->dns = metricsDelta(metrics->domainLookupStart,
+                metrics->domainLookupEnd);
+        timing->connect = metricsDelta(metrics->connectStart,
+                metrics->connectEnd);
+        timing->tls = metricsDelta(metrics->secureConnectionStart,
+                metrics->connectEnd);
+        timing->ttfb = metrics->responseStart.seconds();
+        timing->transfer = metricsDelta(metrics->responseStart,
+                metrics->responseEnd);
+        timing->total = metrics->responseEnd.seconds();
+        if (metrics->responseBodyBytesReceived !=
+                std::numeric_limits<uint64_t>::max())
+            timing->sz_received = metrics->responseBodyBytesReceived;
+    }
+    else if (m_startTime) {
+        // measured here if the fetcher process gives no metrics
+        MonotonicTime now = MonotonicTime::now();
+        timing->total = (now - m_startTime).seconds();
+        if (m_responseTime) {
+            timing->ttfb = (m_responseTime - m_startTime).seconds();
+            timing->transfer = (now - m_responseTime).seconds();
+        }
+    }
+
+    pcfetcher_record_timing(timing);
+}
+
+// called with m_callbackLock held; hands a chunk of the body over
+void PcFetcherRequest::deliverChunk(RefPtr<SharedBuffer>&& chunk)
+{
+    m_sizeDelivered += chunk->size();
+
+    // the info outlives the chunk: the final handler is dispatched later
+    struct pcfetcher_callback_info *info = m_callback;
+    struct pcfetcher_resp_header header = info->header;
+    m_runloop->dispatch([info, header, chunk = WTFMove(chunk)] {
+            if (!info->cancelled)
+                info->progress(info->req_id, info->ctxt, &header,
+                        chunk->data(), chunk->size());
+            }
+        );
+}
+
+purc_variant_t PcFetcherRequest::prepareAsync(
+        pcfetcher_response_handler handler, void* ctxt,
+        pcfetcher_progress_handler progress)
+{
+    auto locker = holdLock(m_callbackLock);
+    if (m_callback == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return PURC_VARIANT_INVALID;
+    }
+
+    m_callback->handler = handler;
+    m_callback->progress = progress;
+    m_callback->ctxt = ctxt;
+    m_is_async = true;
+    m_callback->req_id = purc_variant_make_native(this, NULL);
+    return m_callback->req_id;
+}
+
+void PcFetcherRequest::startAsync(
         const char* base_uri,
         const char* url,
         enum pcfetcher_request_method method,
         purc_variant_t params,
-        uint32_t timeout,
-        pcfetcher_response_handler handler,
-        void* ctxt)
+        uint32_t timeout)
 {
     // TODO send params with http request
     UNUSED_PARAM(params);
 
     auto locker = holdLock(m_callbackLock);
-    m_callback->handler = handler;
-    m_callback->ctxt = ctxt;
-    m_is_async = true;
+    if (m_callback == NULL) {
+        // cancelled
+        return;
+    }
 
     String uri;
     if (base_uri &&
@@ -127,21 +376,59 @@ purc_variant_t PcFetcherRequest::requestAsync(
     request.setHTTPMethod(transMethod(method));
     request.setTimeoutInterval(timeout);
 
+    m_startTime = MonotonicTime::now();
+    m_responseTime = MonotonicTime();
+    m_sizeReceived = 0;
+    m_timingRecorded = false;
+
     m_req_id = ProcessIdentifier::generate().toUInt64();
     NetworkResourceLoadParameters loadParameters;
     loadParameters.identifier = m_req_id;
-    loadParameters.request = request;
     loadParameters.webPageProxyID = WebPageProxyIdentifier::generate();
     loadParameters.webPageID = PageIdentifier::generate();
     loadParameters.webFrameID = FrameIdentifier::generate();
     loadParameters.parentPID = getpid();
 
+    if (m_callback->progress) {
+        // the body is not kept, thus the response is not cacheable
+        m_cacheKey = CString();
+    }
+    else if (lookupCache(uri, method, request, &m_callback->header,
+                &m_callback->rws)) {
+        finishTiming(nullptr, true);
+        struct pcfetcher_callback_info *info = m_callback;
+        m_callback = NULL;
+        m_runloop->dispatch([info, session=this] {
+                info->handler(info->req_id, info->ctxt, &info->header,
+                        info->rws);
+                info->rws = NULL;
+                pcfetcher_destroy_callback_info(info);
+                session->m_fetcherProcess->requestFinished(session);
+                }
+            );
+        return;
+    }
+    loadParameters.request = request;
+
     m_connection->send(
             Messages::NetworkConnectionToWebProcess::ScheduleResourceLoad(
                 loadParameters), 0);
+}
 
-    m_callback->req_id = purc_variant_make_native(this, NULL);
-    return m_callback->req_id;
+purc_variant_t PcFetcherRequest::requestAsync(
+        const char* base_uri,
+        const char* url,
+        enum pcfetcher_request_method method,
+        purc_variant_t params,
+        uint32_t timeout,
+        pcfetcher_response_handler handler,
+        void* ctxt)
+{
+    purc_variant_t req_id = prepareAsync(handler, ctxt);
+    if (req_id) {
+        startAsync(base_uri, url, method, params, timeout);
+    }
+    return req_id;
 }
 
 purc_rwstream_t PcFetcherRequest::requestSync(
@@ -170,15 +457,34 @@ purc_rwstream_t PcFetcherRequest::requestSync(
     request.setHTTPMethod(transMethod(method));
     request.setTimeoutInterval(timeout);
 
+    m_startTime = MonotonicTime::now();
+    m_responseTime = MonotonicTime();
+    m_sizeReceived = 0;
+    m_timingRecorded = false;
+
     m_req_id = ProcessIdentifier::generate().toUInt64();
     NetworkResourceLoadParameters loadParameters;
     loadParameters.identifier = m_req_id;
-    loadParameters.request = request;
     loadParameters.webPageProxyID = WebPageProxyIdentifier::generate();
     loadParameters.webPageID = PageIdentifier::generate();
     loadParameters.webFrameID = FrameIdentifier::generate();
     loadParameters.parentPID = getpid();
 
+    purc_rwstream_t cached = NULL;
+    if (lookupCache(uri, method, request, resp_header, &cached)) {
+        {
+            auto locker = holdLock(m_callbackLock);
+            if (m_callback) {
+                finishTiming(nullptr, true);
+                if (resp_header)
+                    resp_header->timing = m_callback->header.timing;
+            }
+        }
+        m_fetcherProcess->requestFinished(this);
+        return cached;
+    }
+    loadParameters.request = request;
+
     m_connection->send(
             Messages::NetworkConnectionToWebProcess::ScheduleResourceLoad(
                 loadParameters), 0);
@@ -192,6 +498,9 @@ purc_rwstream_t PcFetcherRequest::requestSync(
             return NULL;
         }
 
+        // in case of timeout, hand over what has been received
+        finishBody();
+        finishTiming(nullptr, false);
         if (!m_callback->header.sz_resp && m_callback->rws) {
             size_t sz_content = 0;
             size_t sz_buffer = 0;
@@ -209,6 +518,7 @@ purc_rwstream_t PcFetcherRequest::requestSync(
                 resp_header->mime_type = NULL;
             }
             resp_header->sz_resp = m_callback->header.sz_resp;
+            resp_header->timing = m_callback->header.timing;
         }
 
         if (m_callback->rws) {
@@ -275,6 +585,8 @@ void PcFetcherRequest::wakeUp(void)
 
 void PcFetcherRequest::didClose(IPC::Connection&)
 {
+    // the fetcher process has gone; fail the request instead of hanging
+    fail(503);
 }
 
 void PcFetcherRequest::didReceiveInvalidMessage(IPC::Connection&,
@@ -340,9 +652,17 @@ void PcFetcherRequest::didReceiveResponse(
     m_callback->header.sz_resp = response.expectedContentLength();
     if (m_callback->rws) {
         purc_rwstream_destroy(m_callback->rws);
+        m_callback->rws = NULL;
     }
-    size_t init = m_callback->header.sz_resp ? m_callback->header.sz_resp : DEF_RWS_SIZE;
-    m_callback->rws = purc_rwstream_new_buffer(init, INT_MAX);
+    // the rwstream will be made by finishBody()
+    m_responseTime = MonotonicTime::now();
+    m_sizeDelivered = 0;
+    if (!m_callback->progress)
+        m_body = SharedBuffer::create();
+
+    makeCachePolicy(response, &m_cachePolicy, m_cacheETag,
+            m_cacheLastModified);
+    m_notModified = m_revalidating && response.httpStatusCode() == 304;
 }
 
 void PcFetcherRequest::didReceiveSharedBuffer(
@@ -350,21 +670,33 @@ void PcFetcherRequest::didReceiveSharedBuffer(
 {
     UNUSED_PARAM(encodedDataLength);
     auto locker = holdLock(m_callbackLock);
-    if (m_callback == NULL) {
+    if (m_callback == NULL || !data.buffer()) {
         return;
     }
-    purc_rwstream_write(m_callback->rws, data.data(), data.size());
+
+    m_sizeReceived += data.size();
+    if (m_callback->progress) {
+        deliverChunk(WTFMove(data.buffer()));
+        return;
+    }
+
+    if (!m_body)
+        m_body = SharedBuffer::create();
+    m_body->append(*data.buffer());
 }
 
 void PcFetcherRequest::didFinishResourceLoad(
         const NetworkLoadMetrics& networkLoadMetrics)
 {
-    UNUSED_PARAM(networkLoadMetrics);
     auto locker = holdLock(m_callbackLock);
     if (m_callback == NULL) {
         return;
     }
 
+    finishBody();
+    updateCache();
+    finishTiming(&networkLoadMetrics, m_notModified);
+
     if (!m_is_async) {
         wakeUp();
         return;
@@ -373,7 +705,10 @@ void PcFetcherRequest::didFinishResourceLoad(
     if (!m_callback->handler) {
         return;
     }
-    if (!m_callback->header.sz_resp && m_callback->rws) {
+    if (m_callback->progress) {
+        m_callback->header.sz_resp = m_sizeDelivered;
+    }
+    else if (!m_callback->header.sz_resp && m_callback->rws) {
         size_t sz_content = 0;
         size_t sz_buffer = 0;
         purc_rwstream_get_mem_buffer_ex(m_callback->rws, &sz_content,
@@ -398,12 +733,19 @@ void PcFetcherRequest::didFinishResourceLoad(
 void PcFetcherRequest::didFailResourceLoad(const ResourceError& error)
 {
     UNUSED_PARAM(error);
+    // TODO : trans error code
+    fail(408);
+}
+
+void PcFetcherRequest::fail(int retCode)
+{
     auto locker = holdLock(m_callbackLock);
     if (m_callback == NULL) {
         return;
     }
-    // TODO : trans error code
-    m_callback->header.ret_code = 408;
+    m_callback->header.ret_code = retCode;
+    finishBody();
+    finishTiming(nullptr, false);
 
     if (!m_is_async) {
         wakeUp();
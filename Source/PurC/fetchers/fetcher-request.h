@@ -28,6 +28,7 @@
 #if ENABLE(REMOTE_FETCHER)
 
 #include "fetcher-internal.h"
+#include "fetcher-cache.h"
 #include "fetcher-messages-basic.h"
 
 #include "WebCoreArgumentCoders.h"
@@ -37,9 +38,11 @@
 #include "ProcessLauncher.h"
 #include "FormDataReference.h"
 
+#include <wtf/MonotonicTime.h>
 #include <wtf/ProcessID.h>
 #include <wtf/SystemTracing.h>
 #include <wtf/ThreadSafeRefCounted.h>
+#include <wtf/text/CString.h>
 #include <wtf/threads/BinarySemaphore.h>
 
 using namespace PurCFetcher;
@@ -53,6 +56,10 @@ public:
             IPC::Connection::Identifier connectionIdentifier, WorkQueue *queue,
             PcFetcherProcess *process);
 
+    // a request which will be connected later by open()
+    PcFetcherRequest(uint64_t sessionId, WorkQueue *queue,
+            PcFetcherProcess *process);
+
     ~PcFetcherRequest();
 
     IPC::Connection* connection() const
@@ -61,8 +68,20 @@ public:
         return m_connection.get();
     }
 
+    void open(IPC::Connection::Identifier connectionIdentifier);
     void close();
 
+    // requestAsync() is the same as prepareAsync() followed by startAsync()
+    purc_variant_t prepareAsync(pcfetcher_response_handler handler,
+        void* ctxt, pcfetcher_progress_handler progress = nullptr);
+
+    void startAsync(
+        const char* base_uri,
+        const char* url,
+        enum pcfetcher_request_method method,
+        purc_variant_t params,
+        uint32_t timeout);
+
     purc_variant_t requestAsync(
         const char* base_uri,
         const char* url,
@@ -110,9 +129,18 @@ protected:
             int64_t encodedDataLength);
     void didFinishResourceLoad(const PurCFetcher::NetworkLoadMetrics&);
     void didFailResourceLoad(const ResourceError& error);
+    void fail(int retCode);
     void willSendRequest(ResourceRequest&&,
             IPC::FormDataReference&& requestBody, ResourceResponse&&);
 
+    bool lookupCache(const String& uri, enum pcfetcher_request_method method,
+            ResourceRequest& request,
+            struct pcfetcher_resp_header *resp_header, purc_rwstream_t *resp);
+    void updateCache();
+    void finishBody();
+    void deliverChunk(RefPtr<PurCFetcher::SharedBuffer>&& chunk);
+    void finishTiming(const NetworkLoadMetrics* metrics, bool cacheHit);
+
 private:
     uint64_t m_sessionId;
     uint64_t m_req_id;
@@ -128,6 +156,25 @@ private:
     struct pcfetcher_callback_info *m_callback;
 
     PcFetcherProcess *m_fetcherProcess;
+
+    // the segments of the response body received so far
+    RefPtr<PurCFetcher::SharedBuffer> m_body;
+    // the size of the body handed over progressively so far
+    size_t m_sizeDelivered;
+
+    // for the timing of the request
+    MonotonicTime m_startTime;
+    MonotonicTime m_responseTime;
+    uint64_t m_sizeReceived;
+    bool m_timingRecorded;
+
+    // the key in the response cache; null if the request is not cacheable
+    CString m_cacheKey;
+    bool m_revalidating;
+    bool m_notModified;
+    struct pcfetcher_cache_policy m_cachePolicy;
+    CString m_cacheETag;
+    CString m_cacheLastModified;
 };
 
 
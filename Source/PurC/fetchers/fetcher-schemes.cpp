@@ -0,0 +1,279 @@
+/*
+ * @file fetcher-schemes.cpp
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The schemes served in the process without the fetchers.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "fetcher-internal.h"
+#include "private/utils.h"
+
+#include <wtf/HashMap.h>
+#include <wtf/Lock.h>
+#include <wtf/text/CString.h>
+#include <wtf/text/StringHash.h>
+#include <wtf/text/WTFString.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The `data:` URLs are decoded directly, and the URLs of the schemes having
+ * a handler registered (e.g. `hvml:` for the resources of an app bundled in
+ * memory) are served by the handler; such requests never reach a fetcher.
+ */
+
+#define DATA_DEFAULT_MIME       "text/plain"
+
+struct SchemeEntry {
+    pcfetcher_scheme_handler handler;
+    void *ctxt;
+};
+
+struct BundleResource {
+    const void *data;
+    size_t sz_data;
+    CString mime_type;
+};
+
+static Lock s_schemes_lock;
+static HashMap<String, SchemeEntry> *s_schemes;
+static HashMap<String, BundleResource> *s_bundle;
+
+/* returns the length of the scheme of @url, or 0 if it has no scheme */
+static size_t scheme_length(const char *url)
+{
+    if (!purc_isalpha(url[0]))
+        return 0;
+
+    size_t len = 1;
+    while (purc_isalnum(url[len]) || url[len] == '+' ||
+            url[len] == '-' || url[len] == '.')
+        len++;
+
+    return (url[len] == ':') ? len : 0;
+}
+
+bool pcfetcher_has_scheme(const char *url)
+{
+    return scheme_length(url) > 0;
+}
+
+static bool decode_percent(const char *src, size_t len, char *dst,
+        size_t *sz_dst)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (src[i] == '%') {
+            unsigned char byte;
+            if (i + 2 >= len)
+                return false;
+            if (pcutils_hex2byte(src + i + 1, &byte))
+                return false;
+            dst[n++] = (char)byte;
+            i += 2;
+        }
+        else {
+            dst[n++] = src[i];
+        }
+    }
+
+    dst[n] = 0;
+    *sz_dst = n;
+    return true;
+}
+
+/* data:[<mediatype>][;base64],<data> */
+static purc_rwstream_t data_scheme_handler(void *ctxt, const char *url,
+        struct pcfetcher_resp_header *resp_header)
+{
+    UNUSED_PARAM(ctxt);
+
+    resp_header->ret_code = 400;
+    resp_header->mime_type = NULL;
+    resp_header->sz_resp = 0;
+
+    const char *meta = url + sizeof("data:") - 1;
+    const char *comma = strchr(meta, ',');
+    if (comma == NULL)
+        return NULL;
+
+    size_t sz_meta = comma - meta;
+    bool base64 = false;
+    if (sz_meta >= sizeof(";base64") - 1 &&
+            strncasecmp(comma - sizeof(";base64") + 1, ";base64",
+                sizeof(";base64") - 1) == 0) {
+        base64 = true;
+        sz_meta -= sizeof(";base64") - 1;
+    }
+
+    const char *payload = comma + 1;
+    size_t sz_payload = strlen(payload);
+    char *decoded = (char *)malloc(sz_payload + 1);
+    if (decoded == NULL)
+        return NULL;
+
+    size_t sz_decoded;
+    if (!decode_percent(payload, sz_payload, decoded, &sz_decoded)) {
+        free(decoded);
+        return NULL;
+    }
+
+    if (base64) {
+        size_t sz_buf = pcutils_b64_decoded_length(sz_decoded);
+        char *buf = (char *)malloc(sz_buf);
+        ssize_t len = buf ? pcutils_b64_decode(decoded, buf, sz_buf) : -1;
+        free(decoded);
+        if (len < 0) {
+            free(buf);
+            return NULL;
+        }
+        decoded = buf;
+        sz_decoded = len;
+    }
+
+    purc_rwstream_t rws = purc_rwstream_new_from_mem_ex(decoded, sz_decoded,
+            free, decoded);
+    if (rws == NULL) {
+        free(decoded);
+        return NULL;
+    }
+
+    /* the parameters of the media type like `charset` are ignored */
+    const char *semicolon = (const char *)memchr(meta, ';', sz_meta);
+    size_t sz_mime = semicolon ? (size_t)(semicolon - meta) : sz_meta;
+
+    resp_header->ret_code = 200;
+    resp_header->mime_type = sz_mime ? strndup(meta, sz_mime) :
+        strdup(DATA_DEFAULT_MIME);
+    resp_header->sz_resp = sz_decoded;
+    return rws;
+}
+
+static purc_rwstream_t bundle_scheme_handler(void *ctxt, const char *url,
+        struct pcfetcher_resp_header *resp_header)
+{
+    UNUSED_PARAM(ctxt);
+
+    resp_header->ret_code = 404;
+    resp_header->mime_type = NULL;
+    resp_header->sz_resp = 0;
+
+    auto locker = holdLock(s_schemes_lock);
+    auto it = s_bundle->find(String::fromUTF8(url));
+    if (it == s_bundle->end())
+        return NULL;
+
+    /* the bundled data outlives the streams */
+    purc_rwstream_t rws = purc_rwstream_new_from_mem_ex(it->value.data,
+            it->value.sz_data, NULL, NULL);
+    if (rws == NULL)
+        return NULL;
+
+    resp_header->ret_code = 200;
+    resp_header->mime_type = it->value.mime_type.isNull() ? NULL :
+        strdup(it->value.mime_type.data());
+    resp_header->sz_resp = it->value.sz_data;
+    return rws;
+}
+
+/* call with s_schemes_lock held */
+static bool register_scheme_nolock(const char *scheme,
+        pcfetcher_scheme_handler handler, void *ctxt)
+{
+    if (!s_schemes)
+        s_schemes = new HashMap<String, SchemeEntry>();
+
+    String key = String::fromUTF8(scheme).convertToASCIILowercase();
+    if (key.isEmpty() || key == "data")
+        return false;
+
+    if (handler)
+        s_schemes->set(key, SchemeEntry { handler, ctxt });
+    else
+        s_schemes->remove(key);
+    return true;
+}
+
+int pcfetcher_register_scheme(const char *scheme,
+        pcfetcher_scheme_handler handler, void *ctxt)
+{
+    auto locker = holdLock(s_schemes_lock);
+    if (!register_scheme_nolock(scheme, handler, ctxt)) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return -1;
+    }
+
+    return 0;
+}
+
+int pcfetcher_add_bundle_resource(const char *url,
+        const void *data, size_t sz_data, const char *mime_type)
+{
+    size_t len = scheme_length(url);
+    if (len == 0) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return -1;
+    }
+
+    char *scheme = strndup(url, len);
+    auto locker = holdLock(s_schemes_lock);
+    bool ok = register_scheme_nolock(scheme, bundle_scheme_handler, NULL);
+    free(scheme);
+    if (!ok) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return -1;
+    }
+
+    if (!s_bundle)
+        s_bundle = new HashMap<String, BundleResource>();
+    s_bundle->set(String::fromUTF8(url), BundleResource { data, sz_data,
+            mime_type ? CString(mime_type) : CString() });
+    return 0;
+}
+
+bool pcfetcher_lookup_scheme(const char *url,
+        pcfetcher_scheme_handler *handler, void **ctxt)
+{
+    size_t len = scheme_length(url);
+    if (len == 0)
+        return false;
+
+    if (len == sizeof("data") - 1 && strncasecmp(url, "data", len) == 0) {
+        *handler = data_scheme_handler;
+        *ctxt = NULL;
+        return true;
+    }
+
+    auto locker = holdLock(s_schemes_lock);
+    if (!s_schemes)
+        return false;
+
+    String key = String::fromUTF8(url, len).convertToASCIILowercase();
+    auto it = s_schemes->find(key);
+    if (it == s_schemes->end())
+        return false;
+
+    *handler = it->value.handler;
+    *ctxt = it->value.ctxt;
+    return true;
+}
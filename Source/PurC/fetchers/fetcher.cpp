@@ -26,10 +26,24 @@
 
 #include "private/fetcher.h"
 #include "private/instance.h"
+#include "private/metrics.h"
+#include "private/trace.h"
 
 #include "fetcher-internal.h"
 
+#include <wtf/HashMap.h>
+#include <wtf/HashSet.h>
 #include <wtf/Lock.h>
+#include <wtf/MonotonicTime.h>
+#include <wtf/RunLoop.h>
+#include <wtf/ThreadSafeRefCounted.h>
+#include <wtf/URL.h>
+#include <wtf/Vector.h>
+#include <wtf/text/CString.h>
+#include <wtf/text/StringHash.h>
+#include <wtf/text/WTFString.h>
+
+#include <string.h>
 
 static Lock s_fetcher_lock;
 static struct pcfetcher* s_remote_fetcher = NULL;
@@ -40,22 +54,444 @@ static struct pcfetcher* get_fetcher(void)
     return s_remote_fetcher ? s_remote_fetcher : s_local_fetcher;
 }
 
+extern struct pcmodule _module_fetcher_local;
+extern struct pcmodule _module_fetcher_remote;
+
+/* the fetchers are initialized for an instance by the first request */
+static struct pcfetcher* use_fetcher(void)
+{
+    pcinst_init_module_on_demand(&_module_fetcher_local);
+    pcinst_init_module_on_demand(&_module_fetcher_remote);
+    return get_fetcher();
+}
+
+/*
+ * The identical asynchronous GET requests in flight are coalesced: only the
+ * first one is issued to the fetcher, and its response is handed over to
+ * all of the requesters (the waiters), each on the runloop of its own.
+ */
+struct pcfetcher_flight;
+
+struct pcfetcher_waiter {
+    struct pcfetcher_flight *flight;
+    purc_variant_t req_id;
+    pcfetcher_response_handler handler;
+    void *ctxt;
+    RunLoop *runloop;
+};
+
+struct pcfetcher_flight {
+    String key;
+    /* the request issued to the fetcher and the runloop handling it */
+    purc_variant_t req_id;
+    RunLoop *runloop;
+    bool done;
+    Vector<struct pcfetcher_waiter *> waiters;
+};
+
+/* The body of a response shared by the streams handed over to the waiters */
+class SharedResponse : public ThreadSafeRefCounted<SharedResponse> {
+public:
+    static Ref<SharedResponse> create(purc_rwstream_t rws)
+    {
+        return adoptRef(*new SharedResponse(rws));
+    }
+
+    ~SharedResponse() { purc_rwstream_destroy(m_rws); }
+
+    purc_rwstream_t rws() const { return m_rws; }
+
+private:
+    explicit SharedResponse(purc_rwstream_t rws) : m_rws(rws) { }
+
+    purc_rwstream_t m_rws;
+};
+
+static Lock s_flight_lock;
+static HashMap<String, struct pcfetcher_flight *> *s_flights;
+static HashSet<struct pcfetcher_waiter *> *s_waiters;
+static String *s_base_url;
+static uint64_t s_nr_coalesced;
+
+static bool is_coalescible(enum pcfetcher_request_method method,
+        purc_variant_t params)
+{
+    if (method != PCFETCHER_REQUEST_METHOD_GET)
+        return false;
+
+    return params == PURC_VARIANT_INVALID ||
+        (purc_variant_is_object(params) &&
+         purc_variant_object_get_size(params) == 0);
+}
+
+/* call with s_flight_lock held */
+static String flight_key(const char *url)
+{
+    /* an absolute URL does not depend on the base URL */
+    if (strstr(url, "://") || !s_base_url)
+        return String::fromUTF8(url);
+
+    return *s_base_url + "\n" + String::fromUTF8(url);
+}
+
+/* An async request served in the process by the handler of its scheme */
+struct pcfetcher_fast_request {
+    purc_variant_t req_id;
+    pcfetcher_response_handler handler;
+    void *ctxt;
+    struct pcfetcher_resp_header header;
+    purc_rwstream_t rws;
+};
+
+/* the fast requests not handed over yet; protected by s_flight_lock */
+static HashSet<struct pcfetcher_fast_request *> *s_fast_requests;
+
+/* returns the handler if @url (resolved to @resolved) is served in the
+   process */
+static bool lookup_in_process(const char *url, CString& resolved,
+        pcfetcher_scheme_handler *handler, void **ctxt)
+{
+    if (pcfetcher_has_scheme(url)) {
+        resolved = CString(url);
+    }
+    else {
+        auto locker = holdLock(s_flight_lock);
+        if (!s_base_url)
+            return false;
+        // resolved the same way as the fetchers do
+        String uri = String::fromUTF8(url);
+        if (!uri.startsWith(*s_base_url))
+            uri = *s_base_url + uri;
+        resolved = uri.utf8();
+    }
+
+    return pcfetcher_lookup_scheme(resolved.data(), handler, ctxt);
+}
+
+static purc_rwstream_t serve_in_process(pcfetcher_scheme_handler handler,
+        void *ctxt, const char *url, struct pcfetcher_resp_header *header)
+{
+    MonotonicTime start = MonotonicTime::now();
+    purc_rwstream_t rws = handler(ctxt, url, header);
+
+    memset(&header->timing, 0, sizeof(header->timing));
+    header->timing.total = (MonotonicTime::now() - start).seconds();
+    header->timing.transfer = header->timing.total;
+    header->timing.sz_received = rws ? header->sz_resp : 0;
+    pcfetcher_record_timing(&header->timing);
+    return rws;
+}
+
+static purc_variant_t request_async_in_process(
+        pcfetcher_scheme_handler scheme_handler, void *scheme_ctxt,
+        const char *url, pcfetcher_response_handler handler, void *ctxt)
+{
+    struct pcfetcher_fast_request *req = (struct pcfetcher_fast_request *)
+        calloc(1, sizeof(*req));
+    if (!req) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return PURC_VARIANT_INVALID;
+    }
+
+    req->req_id = purc_variant_make_native(req, NULL);
+    if (!req->req_id) {
+        free(req);
+        return PURC_VARIANT_INVALID;
+    }
+    req->handler = handler;
+    req->ctxt = ctxt;
+    req->rws = serve_in_process(scheme_handler, scheme_ctxt, url,
+            &req->header);
+
+    {
+        auto locker = holdLock(s_flight_lock);
+        if (!s_fast_requests)
+            s_fast_requests = new HashSet<struct pcfetcher_fast_request *>();
+        s_fast_requests->add(req);
+    }
+
+    // the handler is always called asynchronously, as the fetchers do
+    RunLoop::current().dispatch([req] {
+            bool cancelled;
+            {
+                auto locker = holdLock(s_flight_lock);
+                cancelled = !s_fast_requests->remove(req);
+            }
+
+            if (cancelled) {
+                if (req->rws)
+                    purc_rwstream_destroy(req->rws);
+                req->rws = NULL;
+                req->header.ret_code = RESP_CODE_USER_CANCEL;
+            }
+            req->handler(req->req_id, req->ctxt, &req->header, req->rws);
+            if (req->header.mime_type)
+                free(req->header.mime_type);
+            purc_variant_unref(req->req_id);
+            free(req);
+        });
+
+    // one reference is kept for the dispatched call
+    return purc_variant_ref(req->req_id);
+}
+
+/* returns false if @request is not a fast request */
+static bool cancel_async_in_process(purc_variant_t request)
+{
+    struct pcfetcher_fast_request *req = (struct pcfetcher_fast_request *)
+        purc_variant_native_get_entity(request);
+
+    auto locker = holdLock(s_flight_lock);
+    return s_fast_requests && s_fast_requests->remove(req);
+}
+
+static void release_shared_response(void *ctxt)
+{
+    static_cast<SharedResponse *>(ctxt)->deref();
+}
+
+static void dispatch_to_waiter(struct pcfetcher_waiter *waiter,
+        const struct pcfetcher_resp_header *resp_header,
+        purc_rwstream_t resp)
+{
+    struct pcfetcher_resp_header header = *resp_header;
+    header.mime_type = resp_header->mime_type ?
+        strdup(resp_header->mime_type) : NULL;
+
+    waiter->runloop->dispatch([waiter, header, resp] {
+            waiter->handler(waiter->req_id, waiter->ctxt, &header, resp);
+            if (header.mime_type)
+                free(header.mime_type);
+            free(waiter);
+        });
+}
+
+static void on_flight_done(purc_variant_t request_id, void *ctxt,
+        const struct pcfetcher_resp_header *resp_header,
+        purc_rwstream_t resp)
+{
+    struct pcfetcher_flight *flight = (struct pcfetcher_flight *)ctxt;
+    Vector<struct pcfetcher_waiter *> waiters;
+
+    {
+        auto locker = holdLock(s_flight_lock);
+        flight->done = true;
+        auto it = s_flights->find(flight->key);
+        if (it != s_flights->end() && it->value == flight)
+            s_flights->remove(it);
+
+        waiters = WTFMove(flight->waiters);
+        for (auto waiter : waiters)
+            s_waiters->remove(waiter);
+    }
+
+    if (waiters.size() == 1) {
+        dispatch_to_waiter(waiters[0], resp_header, resp);
+        resp = NULL;
+    }
+    else if (waiters.size() > 1) {
+        const void *data = NULL;
+        size_t sz = 0;
+        if (resp) {
+            data = purc_rwstream_get_mem_buffer(resp, &sz);
+            if (data == NULL) {
+                /* not a memory stream; make a copy of the body first */
+                purc_rwstream_t buf = purc_rwstream_new_buffer(
+                        resp_header->sz_resp, 0);
+                if (buf) {
+                    purc_rwstream_seek(resp, 0, SEEK_SET);
+                    purc_rwstream_dump_to_another(resp, buf, -1);
+                    purc_rwstream_destroy(resp);
+                    resp = buf;
+                    data = purc_rwstream_get_mem_buffer(resp, &sz);
+                }
+            }
+        }
+
+        RefPtr<SharedResponse> shared;
+        if (data)
+            shared = SharedResponse::create(resp);
+        else if (resp)
+            purc_rwstream_destroy(resp);
+        resp = NULL;
+
+        for (auto waiter : waiters) {
+            purc_rwstream_t rws = NULL;
+            if (shared) {
+                shared->ref();
+                rws = purc_rwstream_new_from_mem_ex(data, sz,
+                        release_shared_response, shared.get());
+                if (rws == NULL)
+                    shared->deref();
+            }
+            dispatch_to_waiter(waiter, resp_header, rws);
+        }
+    }
+
+    if (resp)
+        purc_rwstream_destroy(resp);
+
+    purc_variant_unref(request_id);
+    delete flight;
+}
+
+static purc_variant_t request_async_coalesced(struct pcfetcher* fetcher,
+        const char* url, enum pcfetcher_request_method method,
+        purc_variant_t params, uint32_t timeout,
+        pcfetcher_response_handler handler, void* ctxt)
+{
+    struct pcfetcher_waiter *waiter = (struct pcfetcher_waiter *)
+        calloc(1, sizeof(*waiter));
+    if (!waiter) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return PURC_VARIANT_INVALID;
+    }
+
+    waiter->req_id = purc_variant_make_native(waiter, NULL);
+    if (!waiter->req_id) {
+        free(waiter);
+        return PURC_VARIANT_INVALID;
+    }
+    waiter->handler = handler;
+    waiter->ctxt = ctxt;
+    waiter->runloop = &RunLoop::current();
+
+    struct pcfetcher_flight *flight;
+    {
+        auto locker = holdLock(s_flight_lock);
+        if (!s_flights) {
+            s_flights = new HashMap<String, struct pcfetcher_flight *>();
+            s_waiters = new HashSet<struct pcfetcher_waiter *>();
+        }
+
+        String key = flight_key(url);
+        auto it = s_flights->find(key);
+        if (it != s_flights->end()) {
+            waiter->flight = it->value;
+            it->value->waiters.append(waiter);
+            s_waiters->add(waiter);
+            s_nr_coalesced++;
+            return waiter->req_id;
+        }
+
+        flight = new pcfetcher_flight;
+        flight->key = key;
+        flight->req_id = PURC_VARIANT_INVALID;
+        flight->runloop = waiter->runloop;
+        flight->done = false;
+        flight->waiters.append(waiter);
+        waiter->flight = flight;
+        s_flights->add(key, flight);
+        s_waiters->add(waiter);
+    }
+
+    /* the handler is always called asynchronously by the fetcher */
+    purc_variant_t req_id = fetcher->request_async(fetcher, url, method,
+            params, timeout, on_flight_done, flight);
+
+    auto locker = holdLock(s_flight_lock);
+    if (req_id == PURC_VARIANT_INVALID) {
+        /* the waiters joined meanwhile get a failure */
+        s_flights->remove(flight->key);
+        for (auto joined : flight->waiters) {
+            s_waiters->remove(joined);
+            if (joined != waiter) {
+                struct pcfetcher_resp_header header = { };
+                dispatch_to_waiter(joined, &header, NULL);
+            }
+        }
+        delete flight;
+
+        purc_variant_unref(waiter->req_id);
+        free(waiter);
+        return PURC_VARIANT_INVALID;
+    }
+
+    flight->req_id = req_id;
+    return waiter->req_id;
+}
+
+/* returns false if @request is not a request coalesced */
+static bool cancel_async_coalesced(struct pcfetcher* fetcher,
+        purc_variant_t request)
+{
+    struct pcfetcher_waiter *waiter = (struct pcfetcher_waiter *)
+        purc_variant_native_get_entity(request);
+    purc_variant_t to_cancel = PURC_VARIANT_INVALID;
+
+    {
+        auto locker = holdLock(s_flight_lock);
+        if (!s_waiters || !s_waiters->remove(waiter))
+            return false;
+
+        struct pcfetcher_flight *flight = waiter->flight;
+        flight->waiters.removeFirst(waiter);
+
+        /*
+         * Cancel the request issued if nobody waits for it any more; this is
+         * only safe on the runloop handling the response of the request.
+         */
+        if (flight->waiters.isEmpty()) {
+            auto it = s_flights->find(flight->key);
+            if (it != s_flights->end() && it->value == flight)
+                s_flights->remove(it);
+            if (!flight->done && flight->req_id &&
+                    flight->runloop == &RunLoop::current())
+                to_cancel = flight->req_id;
+        }
+    }
+
+    struct pcfetcher_resp_header header = { };
+    header.ret_code = RESP_CODE_USER_CANCEL;
+    dispatch_to_waiter(waiter, &header, NULL);
+
+    if (to_cancel)
+        fetcher->cancel_async(fetcher, to_cancel);
+    return true;
+}
+
 bool pcfetcher_is_init(void)
 {
-    return s_remote_fetcher || s_local_fetcher;
+    return use_fetcher() != NULL;
 }
 
 const char* pcfetcher_set_base_url(const char* base_url)
 {
-    struct pcfetcher* fetcher = get_fetcher();
-    return fetcher ? fetcher->set_base_url(fetcher, base_url) : NULL;
+    struct pcfetcher* fetcher = use_fetcher();
+    if (!fetcher)
+        return NULL;
+
+    {
+        auto locker = holdLock(s_flight_lock);
+        delete s_base_url;
+        s_base_url = base_url ? new String(String::fromUTF8(base_url)) : NULL;
+    }
+    return fetcher->set_base_url(fetcher, base_url);
+}
+
+char *pcfetcher_get_local_path(const char *url)
+{
+    if (!use_fetcher() || !url)
+        return NULL;
+
+    CString resolved;
+    pcfetcher_scheme_handler handler;
+    void *ctxt;
+    if (lookup_in_process(url, resolved, &handler, &ctxt))
+        return NULL;
+
+    PurCWTF::URL wurl(URL(), String::fromUTF8(resolved.data()));
+    if (!wurl.isLocalFile())
+        return NULL;
+
+    return strdup(wurl.path().utf8().data());
 }
 
 void pcfetcher_cookie_set(const char* domain,
         const char* path, const char* name, const char* content,
         time_t expire_time, bool secure)
 {
-    struct pcfetcher* fetcher = get_fetcher();
+    struct pcfetcher* fetcher = use_fetcher();
     if (fetcher) {
         fetcher->cookie_set(fetcher, domain, path, name, content,
                 expire_time, secure);
@@ -88,9 +524,117 @@ purc_variant_t pcfetcher_request_async(
         pcfetcher_response_handler handler,
         void* ctxt)
 {
-    struct pcfetcher* fetcher = get_fetcher();
-    return fetcher ? fetcher->request_async(fetcher, url, method,
-            params, timeout, handler, ctxt) : PURC_VARIANT_INVALID;
+    struct pcfetcher* fetcher = use_fetcher();
+    if (!fetcher)
+        return PURC_VARIANT_INVALID;
+
+    CString resolved;
+    pcfetcher_scheme_handler scheme_handler;
+    void *scheme_ctxt;
+    if (method == PCFETCHER_REQUEST_METHOD_GET &&
+            lookup_in_process(url, resolved, &scheme_handler, &scheme_ctxt))
+        return request_async_in_process(scheme_handler, scheme_ctxt,
+                resolved.data(), handler, ctxt);
+
+    if (is_coalescible(method, params))
+        return request_async_coalesced(fetcher, url, method, params,
+                timeout, handler, ctxt);
+
+    return fetcher->request_async(fetcher, url, method,
+            params, timeout, handler, ctxt);
+}
+
+/* the size of the chunks in which a stream is handed over progressively */
+#define PROGRESS_CHUNK_SIZE     (64 * 1024)
+
+struct progress_adapter {
+    pcfetcher_response_handler handler;
+    pcfetcher_progress_handler progress;
+    void *ctxt;
+};
+
+/* hands over the whole body in chunks for a fetcher not supporting it */
+static void on_progress_adapter_done(purc_variant_t request_id, void *ctxt,
+        const struct pcfetcher_resp_header *resp_header,
+        purc_rwstream_t resp)
+{
+    struct progress_adapter *adapter = (struct progress_adapter *)ctxt;
+    struct pcfetcher_resp_header header = *resp_header;
+    size_t sz_total = 0;
+
+    if (resp) {
+        size_t sz = 0;
+        const char *data = (const char *)purc_rwstream_get_mem_buffer(resp,
+                &sz);
+        if (data) {
+            for (size_t off = 0; off < sz; off += PROGRESS_CHUNK_SIZE) {
+                size_t len = std::min(sz - off, (size_t)PROGRESS_CHUNK_SIZE);
+                adapter->progress(request_id, adapter->ctxt, &header,
+                        data + off, len);
+            }
+            sz_total = sz;
+        }
+        else if (char *buf = (char *)malloc(PROGRESS_CHUNK_SIZE)) {
+            ssize_t len;
+            while ((len = purc_rwstream_read(resp, buf,
+                            PROGRESS_CHUNK_SIZE)) > 0) {
+                adapter->progress(request_id, adapter->ctxt, &header,
+                        buf, len);
+                sz_total += len;
+            }
+            free(buf);
+        }
+        purc_rwstream_destroy(resp);
+    }
+
+    header.sz_resp = sz_total;
+    adapter->handler(request_id, adapter->ctxt, &header, NULL);
+    free(adapter);
+}
+
+purc_variant_t pcfetcher_request_async_progressively(
+        const char* url,
+        enum pcfetcher_request_method method,
+        purc_variant_t params,
+        uint32_t timeout,
+        pcfetcher_response_handler handler,
+        pcfetcher_progress_handler progress,
+        void* ctxt)
+{
+    struct pcfetcher* fetcher = use_fetcher();
+    if (!fetcher)
+        return PURC_VARIANT_INVALID;
+
+    CString resolved;
+    pcfetcher_scheme_handler scheme_handler;
+    void *scheme_ctxt;
+    bool in_process = method == PCFETCHER_REQUEST_METHOD_GET &&
+        lookup_in_process(url, resolved, &scheme_handler, &scheme_ctxt);
+
+    if (!in_process && fetcher->request_progressively)
+        return fetcher->request_progressively(fetcher, url, method,
+                params, timeout, handler, progress, ctxt);
+
+    struct progress_adapter *adapter = (struct progress_adapter *)
+        malloc(sizeof(*adapter));
+    if (!adapter) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return PURC_VARIANT_INVALID;
+    }
+    adapter->handler = handler;
+    adapter->progress = progress;
+    adapter->ctxt = ctxt;
+
+    purc_variant_t req_id;
+    if (in_process)
+        req_id = request_async_in_process(scheme_handler, scheme_ctxt,
+                resolved.data(), on_progress_adapter_done, adapter);
+    else
+        req_id = fetcher->request_async(fetcher, url, method,
+                params, timeout, on_progress_adapter_done, adapter);
+    if (req_id == PURC_VARIANT_INVALID)
+        free(adapter);
+    return req_id;
 }
 
 purc_rwstream_t pcfetcher_request_sync(
@@ -100,9 +644,27 @@ purc_rwstream_t pcfetcher_request_sync(
         uint32_t timeout,
         struct pcfetcher_resp_header *resp_header)
 {
-    struct pcfetcher* fetcher = get_fetcher();
-    return fetcher ? fetcher->request_sync(fetcher, url, method,
-            params, timeout, resp_header) : NULL;
+    struct pcfetcher* fetcher = use_fetcher();
+    if (!fetcher)
+        return NULL;
+
+    CString resolved;
+    pcfetcher_scheme_handler scheme_handler;
+    void *scheme_ctxt;
+    if (method == PCFETCHER_REQUEST_METHOD_GET &&
+            lookup_in_process(url, resolved, &scheme_handler, &scheme_ctxt)) {
+        struct pcfetcher_resp_header header = { };
+        purc_rwstream_t rws = serve_in_process(scheme_handler, scheme_ctxt,
+                resolved.data(), &header);
+        if (resp_header)
+            *resp_header = header;
+        else if (header.mime_type)
+            free(header.mime_type);
+        return rws;
+    }
+
+    return fetcher->request_sync(fetcher, url, method,
+            params, timeout, resp_header);
 }
 
 
@@ -113,10 +675,75 @@ int pcfetcher_check_response(uint32_t timeout_ms)
             timeout_ms) : 0;
 }
 
+int pcfetcher_get_stats(struct pcfetcher_stats *stats)
+{
+    struct pcfetcher* fetcher = get_fetcher();
+    if (!fetcher || !stats) {
+        return -1;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    fetcher->get_stats(fetcher, stats);
+
+    auto locker = holdLock(s_flight_lock);
+    stats->nr_coalesced_requests = s_nr_coalesced;
+    return 0;
+}
+
+static Lock s_timing_lock;
+static struct pcfetcher_timing_stats s_timing_stats;
+
+void pcfetcher_record_timing(const struct pcfetcher_timing *timing)
+{
+    double ms = timing->total * 1000;
+    size_t bucket = 0;
+    while (bucket < PCFETCHER_NR_TIMING_BUCKETS - 1 &&
+            ms >= (double)(1ULL << bucket))
+        bucket++;
+
+    auto locker = holdLock(s_timing_lock);
+    s_timing_stats.nr_requests++;
+    if (timing->cache_hit)
+        s_timing_stats.nr_cache_hits++;
+    s_timing_stats.sz_received += timing->sz_received;
+    s_timing_stats.dns += timing->dns;
+    s_timing_stats.connect += timing->connect;
+    s_timing_stats.tls += timing->tls;
+    s_timing_stats.ttfb += timing->ttfb;
+    s_timing_stats.transfer += timing->transfer;
+    s_timing_stats.total += timing->total;
+    s_timing_stats.histogram[bucket]++;
+
+    pcinst_metrics_record_ns(pcinst_current(), PCINST_METRIC_FETCH_LATENCY,
+            (uint64_t)(timing->total * 1e9));
+
+    struct pcinst *inst = pctimeline_instance();
+    if (inst) {
+        uint64_t dur = (uint64_t)(timing->total * 1e9);
+        uint64_t now = pcinst_metrics_now();
+        pctimeline_add(inst, 'X', PC_TIMELINE_FETCHER,
+                timing->cache_hit ? "cached" : "fetch", NULL, 0,
+                now > dur ? now - dur : 0, dur);
+    }
+}
+
+void pcfetcher_get_timing_stats(struct pcfetcher_timing_stats *stats)
+{
+    auto locker = holdLock(s_timing_lock);
+    *stats = s_timing_stats;
+}
+
+void pcfetcher_reset_timing_stats(void)
+{
+    auto locker = holdLock(s_timing_lock);
+    memset(&s_timing_stats, 0, sizeof(s_timing_stats));
+}
+
 void pcfetcher_cancel_async(purc_variant_t request)
 {
     struct pcfetcher* fetcher = get_fetcher();
-    if (fetcher) {
+    if (fetcher && !cancel_async_in_process(request) &&
+            !cancel_async_coalesced(fetcher, request)) {
         fetcher->cancel_async(fetcher, request);
     }
 }
@@ -170,8 +797,10 @@ static void _local_cleanup_instance(struct pcinst* curr_inst)
 }
 
 struct pcmodule _module_fetcher_local = {
+    .name            = "fetcher-local",
     .id              = PURC_HAVE_FETCHER,
     .module_inited   = 0,
+    .on_demand       = true,
 
     .init_once              = _local_init_once,
     .init_instance          = _local_init_instance,
@@ -212,8 +841,10 @@ static void _remote_cleanup_instance(struct pcinst* curr_inst)
 }
 
 struct pcmodule _module_fetcher_remote = {
+    .name            = "fetcher-remote",
     .id              = PURC_HAVE_FETCHER_R,
     .module_inited   = 0,
+    .on_demand       = true,
 
     .init_once              = _remote_init_once,
     .init_instance          = _remote_init_instance,
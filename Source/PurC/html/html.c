@@ -44,6 +44,7 @@ static int html_init_once(void)
 }
 
 struct pcmodule _module_html = {
+    .name            = "html",
     .id              = PURC_HAVE_HTML,
     .module_inited   = 0,
 
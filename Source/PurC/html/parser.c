@@ -583,6 +583,26 @@ pchtml_doc_write_to_stream_ex(pchtml_html_document_t *doc,
     return ud.oom ? -1 : 0;
 }
 
+int
+pchtml_doc_write_to_stream_cached(pchtml_html_document_t *doc,
+    enum pchtml_html_serialize_opt opt,
+    pchtml_html_serialize_cache_t *cache, purc_rwstream_t out)
+{
+    struct serializer_data ud = {
+        .nr             = 0,
+        .ctxt           = out,
+        .writer         = rwstream_writer,
+        .oom            = 0,
+    };
+    unsigned int status;
+    status = pchtml_html_serialize_pretty_tree_cached_cb((pcdom_node_t *)doc,
+            opt, 0, cache, serializer_callback, &ud);
+    if (status != PCHTML_STATUS_OK)
+        return -1;
+
+    return ud.oom ? -1 : 0;
+}
+
 struct buffer_data {
     char         *orig_buf;
     size_t        orig_sz;
@@ -687,6 +707,26 @@ pcdom_node_write_to_stream_ex(pcdom_node_t *node,
     return 0;
 }
 
+int
+pcdom_node_write_to_stream_parallel(pcdom_node_t *node,
+    enum pchtml_html_serialize_opt opt, unsigned nr_workers,
+    purc_rwstream_t out)
+{
+    struct serializer_data ud = {
+        .nr             = 0,
+        .ctxt           = out,
+        .writer         = rwstream_writer,
+        .oom            = 0,
+    };
+    unsigned int status;
+    status = pchtml_html_serialize_pretty_tree_parallel_cb(node,
+            opt, 0, nr_workers, serializer_callback, &ud);
+    if (status != PCHTML_STATUS_OK)
+        return -1;
+
+    return ud.oom ? -1 : 0;
+}
+
 char*
 pcdom_node_snprintf_ex(pcdom_node_t *node,
         enum pchtml_html_serialize_opt opt, char *buf, size_t *io_sz,
@@ -43,6 +43,12 @@
 #define PCHTML_TOKENIZER_CHARS_MAP
 #include "str_res.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #define pchtml_html_serialize_send(data, len, ctx)                                \
     do {                                                                       \
         status = cb((const unsigned char *) data, len, ctx);                      \
@@ -569,6 +575,90 @@ pchtml_html_serialize_document_cb(pcdom_document_t *document,
     return PCHTML_STATUS_OK;
 }
 
+/* the optional bytes to escape besides `&`, `<`, `>`, and 0xC2 (the lead
+   byte of NO-BREAK SPACE) */
+#define ESCAPE_QUOTES       0x01    // `"` and `'`
+#define ESCAPE_NEWLINES     0x02    // LF and CR
+
+/* returns the length of the leading run of bytes which need no escaping */
+static size_t
+clean_run_length(const unsigned char *p, size_t len, unsigned set)
+{
+    size_t n = 0;
+
+    /* an unused byte is replaced by `&`, which is always in the set */
+    unsigned char quot = (set & ESCAPE_QUOTES) ? '"' : '&';
+    unsigned char apos = (set & ESCAPE_QUOTES) ? '\'' : '&';
+    unsigned char lf = (set & ESCAPE_NEWLINES) ? '\n' : '&';
+    unsigned char cr = (set & ESCAPE_NEWLINES) ? '\r' : '&';
+
+#if defined(__SSE2__)
+    const __m128i v_amp = _mm_set1_epi8('&');
+    const __m128i v_lt = _mm_set1_epi8('<');
+    const __m128i v_gt = _mm_set1_epi8('>');
+    const __m128i v_nbsp = _mm_set1_epi8((char)0xC2);
+    const __m128i v_quot = _mm_set1_epi8((char)quot);
+    const __m128i v_apos = _mm_set1_epi8((char)apos);
+    const __m128i v_lf = _mm_set1_epi8((char)lf);
+    const __m128i v_cr = _mm_set1_epi8((char)cr);
+
+    while (n + 16 <= len) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(p + n));
+        __m128i hit = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, v_amp),
+                    _mm_cmpeq_epi8(chunk, v_nbsp)),
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, v_lt),
+                    _mm_cmpeq_epi8(chunk, v_gt)));
+        hit = _mm_or_si128(hit,
+                _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(chunk, v_quot),
+                        _mm_cmpeq_epi8(chunk, v_apos)),
+                    _mm_or_si128(_mm_cmpeq_epi8(chunk, v_lf),
+                        _mm_cmpeq_epi8(chunk, v_cr))));
+        int mask = _mm_movemask_epi8(hit);
+        if (mask) {
+            return n + __builtin_ctz(mask);
+        }
+        n += 16;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x16_t v_amp = vdupq_n_u8('&');
+    const uint8x16_t v_lt = vdupq_n_u8('<');
+    const uint8x16_t v_gt = vdupq_n_u8('>');
+    const uint8x16_t v_nbsp = vdupq_n_u8(0xC2);
+    const uint8x16_t v_quot = vdupq_n_u8(quot);
+    const uint8x16_t v_apos = vdupq_n_u8(apos);
+    const uint8x16_t v_lf = vdupq_n_u8(lf);
+    const uint8x16_t v_cr = vdupq_n_u8(cr);
+
+    while (n + 16 <= len) {
+        uint8x16_t chunk = vld1q_u8(p + n);
+        uint8x16_t hit = vorrq_u8(
+                vorrq_u8(vceqq_u8(chunk, v_amp), vceqq_u8(chunk, v_nbsp)),
+                vorrq_u8(vceqq_u8(chunk, v_lt), vceqq_u8(chunk, v_gt)));
+        hit = vorrq_u8(hit,
+                vorrq_u8(
+                    vorrq_u8(vceqq_u8(chunk, v_quot), vceqq_u8(chunk, v_apos)),
+                    vorrq_u8(vceqq_u8(chunk, v_lf), vceqq_u8(chunk, v_cr))));
+        if (vmaxvq_u8(hit)) {
+            /* the scalar loop below locates the byte */
+            break;
+        }
+        n += 16;
+    }
+#endif
+
+    while (n < len) {
+        unsigned char c = p[n];
+        if (c == '&' || c == '<' || c == '>' || c == 0xC2 ||
+                c == quot || c == apos || c == lf || c == cr) {
+            break;
+        }
+        n++;
+    }
+    return n;
+}
+
 static unsigned int
 pchtml_html_serialize_send_escaping_attribute_string(const unsigned char *data,
                                                   size_t len,
@@ -580,6 +670,11 @@ pchtml_html_serialize_send_escaping_attribute_string(const unsigned char *data,
     const unsigned char *end = data + len;
 
     while (data != end) {
+        data += clean_run_length(data, end - data, ESCAPE_QUOTES);
+        if (data == end) {
+            break;
+        }
+
         switch (*data) {
             /* U+0026 AMPERSAND (&) */
             case 0x26:
@@ -693,6 +788,11 @@ pchtml_html_serialize_send_escaping_string(const unsigned char *data, size_t len
     const unsigned char *end = data + len;
 
     while (data != end) {
+        data += clean_run_length(data, end - data, 0);
+        if (data == end) {
+            break;
+        }
+
         switch (*data) {
             /* U+0026 AMPERSAND (&) */
             case 0x26:
@@ -1490,7 +1590,13 @@ pchtml_html_serialize_pretty_send_escaping_string(const unsigned char *data, siz
     }
 //    pchtml_html_serialize_send("\"", 1, ctx);
 
+    unsigned set = ESCAPE_QUOTES | (with_indent ? ESCAPE_NEWLINES : 0);
     while (data != end) {
+        data += clean_run_length(data, end - data, set);
+        if (data == end) {
+            break;
+        }
+
         switch (*data) {
             /* U+0026 AMPERSAND (&) */
             case 0x26:
@@ -1665,3 +1771,579 @@ pchtml_html_serialize_pretty_send_string(const unsigned char *data, size_t len,
 
     return PCHTML_STATUS_OK;
 }
+
+/*
+ * The serialization cache.
+ *
+ * The cache keeps the output of the last pass and, for every node serialized
+ * in that pass, the offset of its chunk relative to the chunk of its parent
+ * and the length of the chunk. A node marked as serialized is not changed
+ * since the last pass, so its chunk is copied from the last output instead
+ * of walking its subtree. The relative offsets of the descendants stay valid
+ * when a chunk is copied as a whole.
+ *
+ * The nodes are marked in the user-defined flags; a new node comes with no
+ * mark, and pchtml_html_serialize_cache_invalidate() clears the marks of
+ * a changed node and its ancestors.
+ */
+
+#define SERIALIZE_FLAG_CACHED   0x8000U
+
+#define NO_OFFSET               ((size_t)-1)
+#define MIN_CACHE_ENTRIES       64
+
+struct serialize_chunk {
+    const pcdom_node_t *node;
+    size_t              rel;    // offset relative to the parent's chunk
+    size_t              len;
+};
+
+struct pchtml_html_serialize_cache {
+    const pcdom_node_t *root;
+    pchtml_html_serialize_opt_t opt;
+    size_t              indent;
+
+    /* the output of the last pass */
+    char               *buf;
+    size_t              len;
+
+    /* the open-addressing table of the chunks keyed by the node */
+    struct serialize_chunk *chunks;
+    size_t              sz_chunks;
+    size_t              nr_chunks;
+    /* the number of chunks after the last full pass */
+    size_t              nr_full;
+};
+
+struct serialize_pass {
+    pchtml_html_serialize_cache_t *cache;
+    pchtml_html_serialize_opt_t opt;
+
+    pchtml_html_serialize_cb_f cb;
+    void               *ctx;
+
+    /* the output of this pass */
+    char               *buf;
+    size_t              len;
+    size_t              sz;
+};
+
+pchtml_html_serialize_cache_t *
+pchtml_html_serialize_cache_new(void)
+{
+    pchtml_html_serialize_cache_t *cache = calloc(1, sizeof(*cache));
+    if (cache == NULL)
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    return cache;
+}
+
+static void
+serialize_cache_reset(pchtml_html_serialize_cache_t *cache)
+{
+    free(cache->buf);
+    free(cache->chunks);
+    memset(cache, 0, sizeof(*cache));
+}
+
+void
+pchtml_html_serialize_cache_delete(pchtml_html_serialize_cache_t *cache)
+{
+    serialize_cache_reset(cache);
+    free(cache);
+}
+
+void
+pchtml_html_serialize_cache_invalidate(pcdom_node_t *node)
+{
+    /* an unmarked node has no marked ancestor within the cached tree */
+    while (node && (node->flags & SERIALIZE_FLAG_CACHED)) {
+        node->flags &= ~SERIALIZE_FLAG_CACHED;
+        node = node->parent;
+    }
+}
+
+static inline size_t
+chunk_hash(const pcdom_node_t *node, size_t sz)
+{
+    uintptr_t v = (uintptr_t)node;
+    v ^= v >> 17;
+    v *= (uintptr_t)0x9E3779B97F4A7C15ULL;
+    return (size_t)(v >> 7) & (sz - 1);
+}
+
+static struct serialize_chunk *
+chunk_find(pchtml_html_serialize_cache_t *cache, const pcdom_node_t *node)
+{
+    if (cache->sz_chunks == 0)
+        return NULL;
+
+    size_t i = chunk_hash(node, cache->sz_chunks);
+    while (cache->chunks[i].node) {
+        if (cache->chunks[i].node == node)
+            return cache->chunks + i;
+        i = (i + 1) & (cache->sz_chunks - 1);
+    }
+
+    return NULL;
+}
+
+static struct serialize_chunk *
+chunk_put(pchtml_html_serialize_cache_t *cache, const pcdom_node_t *node)
+{
+    if ((cache->nr_chunks + 1) * 10 > cache->sz_chunks * 7) {
+        size_t sz = cache->sz_chunks ? cache->sz_chunks * 2 :
+            MIN_CACHE_ENTRIES * 2;
+        struct serialize_chunk *chunks = calloc(sz, sizeof(*chunks));
+        if (chunks == NULL)
+            return NULL;
+
+        for (size_t n = 0; n < cache->sz_chunks; n++) {
+            if (cache->chunks[n].node == NULL)
+                continue;
+
+            size_t i = chunk_hash(cache->chunks[n].node, sz);
+            while (chunks[i].node)
+                i = (i + 1) & (sz - 1);
+            chunks[i] = cache->chunks[n];
+        }
+
+        free(cache->chunks);
+        cache->chunks = chunks;
+        cache->sz_chunks = sz;
+    }
+
+    size_t i = chunk_hash(node, cache->sz_chunks);
+    while (cache->chunks[i].node) {
+        if (cache->chunks[i].node == node)
+            return cache->chunks + i;
+        i = (i + 1) & (cache->sz_chunks - 1);
+    }
+
+    cache->chunks[i].node = node;
+    cache->nr_chunks++;
+    return cache->chunks + i;
+}
+
+static unsigned int
+serialize_pass_send(const unsigned char *data, size_t len, void *ctx)
+{
+    struct serialize_pass *pass = ctx;
+
+    if (pass->len + len > pass->sz) {
+        size_t sz = pass->sz ? pass->sz : 4096;
+        while (sz < pass->len + len)
+            sz *= 2;
+
+        char *buf = realloc(pass->buf, sz);
+        if (buf == NULL) {
+            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return PCHTML_STATUS_ERROR_MEMORY_ALLOCATION;
+        }
+        pass->buf = buf;
+        pass->sz = sz;
+    }
+
+    memcpy(pass->buf + pass->len, data, len);
+    pass->len += len;
+
+    return pass->cb(data, len, pass->ctx);
+}
+
+static unsigned int
+serialize_cached_node(struct serialize_pass *pass, pcdom_node_t *node,
+        size_t deep, size_t parent_old, size_t parent_new)
+{
+    pchtml_html_serialize_cache_t *cache = pass->cache;
+    pchtml_html_serialize_opt_t opt = pass->opt;
+    pchtml_html_serialize_cb_f cb = serialize_pass_send;
+    void *ctx = pass;
+    unsigned int status;
+
+    struct serialize_chunk *chunk = NULL;
+    size_t old_start = NO_OFFSET;
+    size_t new_start = pass->len;
+
+    if (parent_old != NO_OFFSET && (chunk = chunk_find(cache, node))) {
+        old_start = parent_old + chunk->rel;
+        if (old_start + chunk->len > cache->len)
+            old_start = NO_OFFSET;
+    }
+
+    if (old_start != NO_OFFSET && (node->flags & SERIALIZE_FLAG_CACHED)) {
+        pchtml_html_serialize_send(cache->buf + old_start, chunk->len, ctx);
+        chunk->rel = new_start - parent_new;
+        return PCHTML_STATUS_OK;
+    }
+
+    status = pchtml_html_serialize_pretty_cb(node, opt, deep, cb, ctx);
+    if (status != PCHTML_STATUS_OK)
+        return status;
+
+    if (pchtml_html_tree_node_is(node, PCHTML_TAG_TEMPLATE)) {
+        pchtml_html_template_element_t *temp;
+
+        temp = pchtml_html_interface_template(node);
+        if (temp->content != NULL && temp->content->node.first_child != NULL) {
+            pchtml_html_serialize_send_indent((deep + 1), ctx);
+            pchtml_html_serialize_send("#document-fragment", 18, ctx);
+            if ((opt & PCHTML_HTML_SERIALIZE_OPT_SKIP_WS_NODES) == 0) {
+                pchtml_html_serialize_send("\n", 1, ctx);
+            }
+
+            status = pchtml_html_serialize_pretty_deep_cb(&temp->content->node,
+                    opt, (deep + 2), cb, ctx);
+            if (status != PCHTML_STATUS_OK)
+                return status;
+        }
+    }
+
+    if (!pchtml_html_node_is_void(node)) {
+        pcdom_node_t *child = node->first_child;
+        while (child) {
+            status = serialize_cached_node(pass, child, deep + 1,
+                    old_start, new_start);
+            if (status != PCHTML_STATUS_OK)
+                return status;
+            child = child->next;
+        }
+    }
+
+    if (node->type == PCDOM_NODE_TYPE_ELEMENT
+            && pchtml_html_node_is_void(node) == false
+            && (opt & PCHTML_HTML_SERIALIZE_OPT_WITHOUT_CLOSING) == 0) {
+        if ((opt & PCHTML_HTML_SERIALIZE_OPT_WITHOUT_TEXT_INDENT) == 0) {
+            pchtml_html_serialize_send_indent(deep, ctx);
+        }
+
+        status = pchtml_html_serialize_element_closed_cb(
+                pcdom_interface_element(node), cb, ctx);
+        if (status != PCHTML_STATUS_OK)
+            return status;
+
+        if ((opt & PCHTML_HTML_SERIALIZE_OPT_SKIP_WS_NODES) == 0) {
+            pchtml_html_serialize_send("\n", 1, ctx);
+        }
+    }
+
+    /* the table may be rehashed, so the chunk is looked up again */
+    chunk = chunk_put(cache, node);
+    if (chunk == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return PCHTML_STATUS_ERROR_MEMORY_ALLOCATION;
+    }
+
+    chunk->rel = new_start - parent_new;
+    chunk->len = pass->len - new_start;
+    node->flags |= SERIALIZE_FLAG_CACHED;
+    return PCHTML_STATUS_OK;
+}
+
+unsigned int
+pchtml_html_serialize_pretty_tree_cached_cb(pcdom_node_t *node,
+        pchtml_html_serialize_opt_t opt, size_t indent,
+        pchtml_html_serialize_cache_t *cache,
+        pchtml_html_serialize_cb_f cb, void *ctx)
+{
+    struct serialize_pass pass = { cache, opt, cb, ctx, NULL, 0, 0 };
+    unsigned int status = PCHTML_STATUS_OK;
+    size_t root_old = 0;
+
+    if (cache->root != node || cache->opt != opt || cache->indent != indent) {
+        serialize_cache_reset(cache);
+        cache->root = node;
+        cache->opt = opt;
+        cache->indent = indent;
+        root_old = NO_OFFSET;
+    }
+    else if (cache->nr_chunks > cache->nr_full * 2) {
+        /* too many chunks of the destroyed nodes; starts over */
+        free(cache->buf);
+        free(cache->chunks);
+        cache->buf = NULL;
+        cache->len = 0;
+        cache->chunks = NULL;
+        cache->sz_chunks = 0;
+        cache->nr_chunks = 0;
+        root_old = NO_OFFSET;
+    }
+
+    /* For a document we must serialize all children without document node. */
+    if (node->local_name == PCHTML_TAG__DOCUMENT) {
+        pcdom_node_t *child = node->first_child;
+        while (child) {
+            status = serialize_cached_node(&pass, child, indent, root_old, 0);
+            if (status != PCHTML_STATUS_OK)
+                break;
+            child = child->next;
+        }
+    }
+    else {
+        status = serialize_cached_node(&pass, node, indent, root_old, 0);
+    }
+
+    if (status != PCHTML_STATUS_OK) {
+        /* the chunks are inconsistent with the output */
+        free(pass.buf);
+        serialize_cache_reset(cache);
+        return status;
+    }
+
+    free(cache->buf);
+    cache->buf = pass.buf;
+    cache->len = pass.len;
+    if (root_old == NO_OFFSET) {
+        cache->nr_full = cache->nr_chunks;
+        if (cache->nr_full < MIN_CACHE_ENTRIES)
+            cache->nr_full = MIN_CACHE_ENTRIES;
+    }
+
+    return PCHTML_STATUS_OK;
+}
+
+#if USE(PTHREADS)
+
+#include "private/threadpool.h"
+
+/* the subtrees smaller than this are not worth a worker */
+#define PARALLEL_MIN_NODES      4096
+
+/* a range of sibling subtrees serialized by one worker into its buffer */
+struct serialize_range {
+    pcdom_node_t       *first;
+    size_t              nr_nodes;
+    pchtml_html_serialize_opt_t opt;
+    size_t              deep;
+    unsigned int        status;
+
+    unsigned char      *buf;
+    size_t              len;
+    size_t              sz;
+};
+
+static unsigned int
+serialize_range_send(const unsigned char *data, size_t len, void *ctx)
+{
+    struct serialize_range *range = ctx;
+
+    if (range->len + len > range->sz) {
+        size_t sz = range->sz ? range->sz : 4096;
+        while (sz < range->len + len)
+            sz *= 2;
+
+        unsigned char *buf = realloc(range->buf, sz);
+        if (buf == NULL)
+            return PCHTML_STATUS_ERROR_MEMORY_ALLOCATION;
+        range->buf = buf;
+        range->sz = sz;
+    }
+
+    memcpy(range->buf + range->len, data, len);
+    range->len += len;
+    return PCHTML_STATUS_OK;
+}
+
+static void *
+serialize_range_main(void *arg)
+{
+    struct serialize_range *range = arg;
+    pcdom_node_t *node = range->first;
+
+    for (size_t i = 0; i < range->nr_nodes; i++) {
+        range->status = pchtml_html_serialize_pretty_node_cb(node, range->opt,
+                range->deep, serialize_range_send, range);
+        if (range->status != PCHTML_STATUS_OK)
+            break;
+        node = node->next;
+    }
+
+    return NULL;
+}
+
+static size_t
+subtree_size(pcdom_node_t *root)
+{
+    pcdom_node_t *node = root;
+    size_t nr = 0;
+
+    for (;;) {
+        nr++;
+        if (node->first_child) {
+            node = node->first_child;
+            continue;
+        }
+
+        while (node != root && node->next == NULL)
+            node = node->parent;
+        if (node == root)
+            break;
+        node = node->next;
+    }
+
+    return nr;
+}
+
+static inline bool
+serialize_can_split(pcdom_node_t *node)
+{
+    return node->type == PCDOM_NODE_TYPE_ELEMENT &&
+        node->first_child != NULL &&
+        !pchtml_html_node_is_void(node) &&
+        !pchtml_html_tree_node_is(node, PCHTML_TAG_TEMPLATE);
+}
+
+/* serializes the children of the parent in contiguous ranges of about the
+   same number of nodes, one range on every worker */
+static unsigned int
+serialize_children_parallel(pcdom_node_t *parent,
+        pchtml_html_serialize_opt_t opt, size_t deep, unsigned nr_workers,
+        size_t nr_nodes, pchtml_html_serialize_cb_f cb, void *ctx)
+{
+    struct serialize_range *ranges;
+    pcutils_task **handles;
+    unsigned int status = PCHTML_STATUS_OK;
+    unsigned nr_ranges = 0;
+
+    ranges = calloc(nr_workers, sizeof(*ranges));
+    handles = calloc(nr_workers, sizeof(*handles));
+    if (ranges == NULL || handles == NULL) {
+        free(ranges);
+        free(handles);
+        return pchtml_html_serialize_pretty_deep_cb(parent, opt, deep, cb, ctx);
+    }
+
+    size_t quota = nr_nodes / nr_workers + 1;
+    size_t acc = 0;
+    for (pcdom_node_t *child = parent->first_child; child;
+            child = child->next) {
+        struct serialize_range *range = ranges + nr_ranges;
+        if (range->first == NULL) {
+            range->first = child;
+            range->opt = opt;
+            range->deep = deep;
+        }
+        range->nr_nodes++;
+
+        acc += subtree_size(child);
+        if (acc >= quota * (nr_ranges + 1) && nr_ranges + 1 < nr_workers)
+            nr_ranges++;
+    }
+    if (ranges[nr_ranges].first)
+        nr_ranges++;
+
+    /* the calling thread takes the first range itself, and the ones
+       failed to submit to the thread pool */
+    for (unsigned i = 1; i < nr_ranges; i++)
+        handles[i] = pcutils_task_submit(serialize_range_main, ranges + i);
+    serialize_range_main(ranges);
+    for (unsigned i = 1; i < nr_ranges; i++) {
+        if (handles[i]) {
+            pcutils_task_wait(handles[i]);
+            pcutils_task_release(handles[i]);
+        }
+        else {
+            serialize_range_main(ranges + i);
+        }
+    }
+
+    /* stitches the buffers in order */
+    for (unsigned i = 0; i < nr_ranges; i++) {
+        if (status == PCHTML_STATUS_OK) {
+            status = ranges[i].status;
+            if (status == PCHTML_STATUS_ERROR_MEMORY_ALLOCATION)
+                pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            else if (status == PCHTML_STATUS_OK && ranges[i].len)
+                status = cb(ranges[i].buf, ranges[i].len, ctx);
+        }
+        free(ranges[i].buf);
+    }
+
+    free(ranges);
+    free(handles);
+    return status;
+}
+
+/* descends from the node through the elements with too few children to
+   keep the workers busy, then serializes the children in parallel */
+static unsigned int
+serialize_node_parallel(pcdom_node_t *node, pchtml_html_serialize_opt_t opt,
+        size_t deep, unsigned nr_workers,
+        pchtml_html_serialize_cb_f cb, void *ctx)
+{
+    unsigned int status;
+    bool is_doc = (node->local_name == PCHTML_TAG__DOCUMENT);
+    size_t nr_children = 0;
+
+    for (pcdom_node_t *child = node->first_child; child; child = child->next)
+        nr_children++;
+
+    if (!is_doc) {
+        status = pchtml_html_serialize_pretty_cb(node, opt, deep, cb, ctx);
+        if (status != PCHTML_STATUS_OK)
+            return status;
+        deep++;
+    }
+
+    if (nr_children >= nr_workers) {
+        status = serialize_children_parallel(node, opt, deep, nr_workers,
+                subtree_size(node), cb, ctx);
+        if (status != PCHTML_STATUS_OK)
+            return status;
+    }
+    else {
+        for (pcdom_node_t *child = node->first_child; child;
+                child = child->next) {
+            if (serialize_can_split(child) &&
+                    subtree_size(child) >= PARALLEL_MIN_NODES)
+                status = serialize_node_parallel(child, opt, deep,
+                        nr_workers, cb, ctx);
+            else
+                status = pchtml_html_serialize_pretty_node_cb(child, opt,
+                        deep, cb, ctx);
+            if (status != PCHTML_STATUS_OK)
+                return status;
+        }
+    }
+
+    if (is_doc)
+        return PCHTML_STATUS_OK;
+
+    deep--;
+    if ((opt & PCHTML_HTML_SERIALIZE_OPT_WITHOUT_CLOSING) == 0) {
+        if ((opt & PCHTML_HTML_SERIALIZE_OPT_WITHOUT_TEXT_INDENT) == 0) {
+            pchtml_html_serialize_send_indent(deep, ctx);
+        }
+
+        status = pchtml_html_serialize_element_closed_cb(
+                pcdom_interface_element(node), cb, ctx);
+        if (status != PCHTML_STATUS_OK)
+            return status;
+
+        if ((opt & PCHTML_HTML_SERIALIZE_OPT_SKIP_WS_NODES) == 0) {
+            pchtml_html_serialize_send("\n", 1, ctx);
+        }
+    }
+
+    return PCHTML_STATUS_OK;
+}
+
+#endif /* USE(PTHREADS) */
+
+unsigned int
+pchtml_html_serialize_pretty_tree_parallel_cb(pcdom_node_t *node,
+        pchtml_html_serialize_opt_t opt, size_t indent, unsigned nr_workers,
+        pchtml_html_serialize_cb_f cb, void *ctx)
+{
+#if USE(PTHREADS)
+    /* the tree is only read by the workers */
+    if (nr_workers > 1 && (node->local_name == PCHTML_TAG__DOCUMENT ||
+                serialize_can_split(node)) &&
+            subtree_size(node) >= PARALLEL_MIN_NODES) {
+        return serialize_node_parallel(node, opt, indent, nr_workers,
+                cb, ctx);
+    }
+#else
+    UNUSED_PARAM(nr_workers);
+#endif
+
+    return pchtml_html_serialize_pretty_tree_cb(node, opt, indent, cb, ctx);
+}
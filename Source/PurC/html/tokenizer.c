@@ -136,6 +136,7 @@ pchtml_html_tokenizer_init(pchtml_html_tokenizer_t *tkz)
 
     tkz->callback_token_done = pchtml_html_tokenizer_token_done;
     tkz->callback_token_ctx = NULL;
+    tkz->callback_sync = NULL;
 
     tkz->is_eof = false;
     tkz->status = PCHTML_STATUS_OK;
@@ -176,6 +177,7 @@ pchtml_html_tokenizer_inherit(pchtml_html_tokenizer_t *tkz_to,
 
     tkz_to->callback_token_done = pchtml_html_tokenizer_token_done;
     tkz_to->callback_token_ctx = NULL;
+    tkz_to->callback_sync = NULL;
 
     tkz_to->is_eof = false;
     tkz_to->status = PCHTML_STATUS_OK;
@@ -416,6 +418,10 @@ pchtml_html_tokenizer_current_namespace(pchtml_html_tokenizer_t *tkz)
         return PCHTML_NS__UNDEF;
     }
 
+    if (tkz->callback_sync != NULL) {
+        tkz->callback_sync(tkz, tkz->callback_token_ctx);
+    }
+
     pcdom_node_t *node = pchtml_html_tree_adjusted_current_node(tkz->tree);
 
     if (node == NULL) {
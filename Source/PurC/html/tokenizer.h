@@ -55,6 +55,8 @@ typedef pchtml_html_token_t *
 (*pchtml_html_tokenizer_token_f)(pchtml_html_tokenizer_t *tkz,
                               pchtml_html_token_t *token, void *ctx);
 
+typedef void
+(*pchtml_html_tokenizer_sync_f)(pchtml_html_tokenizer_t *tkz, void *ctx);
 
 struct pchtml_html_tokenizer {
     pchtml_html_tokenizer_state_f       state;
@@ -63,6 +65,9 @@ struct pchtml_html_tokenizer {
     pchtml_html_tokenizer_token_f       callback_token_done;
     void                             *callback_token_ctx;
 
+    /* Called before the tokenizer looks into the tree; NULL by default */
+    pchtml_html_tokenizer_sync_f        callback_sync;
+
     pcutils_hash_t                    *tags;
     pcutils_hash_t                    *attrs;
     pcutils_mraw_t                    *attrs_mraw;
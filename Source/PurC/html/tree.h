@@ -94,6 +94,9 @@ typedef enum {
 }
 pchtml_html_tree_insertion_position_t;
 
+/* A chunk of at least this size is tokenized on a helper thread. */
+#define PCHTML_HTML_TREE_PIPELINE_MIN_SIZE      (64 * 1024)
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -132,6 +135,13 @@ bool
 pchtml_html_tree_construction_dispatcher(pchtml_html_tree_t *tree,
                 pchtml_html_token_t *token) WTF_INTERNAL;
 
+#if USE(PTHREADS)
+/* Tokenizes the chunk on a helper thread while building the tree. */
+unsigned int
+pchtml_html_tree_chunk_pipelined(pchtml_html_tree_t *tree,
+                const unsigned char *data, size_t sz) WTF_INTERNAL;
+#endif
+
 pcdom_node_t *
 pchtml_html_tree_appropriate_place_inserting_node(pchtml_html_tree_t *tree,
                 pcdom_node_t *override_target,
@@ -264,6 +274,12 @@ static inline unsigned int
 pchtml_html_tree_chunk(pchtml_html_tree_t *tree,
                 const unsigned char *data, size_t sz)
 {
+#if USE(PTHREADS)
+    if (sz >= PCHTML_HTML_TREE_PIPELINE_MIN_SIZE) {
+        return pchtml_html_tree_chunk_pipelined(tree, data, sz);
+    }
+#endif
+
     return pchtml_html_tokenizer_chunk(tree->tkz_ref, data, sz);
 }
 
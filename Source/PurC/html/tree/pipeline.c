@@ -0,0 +1,743 @@
+/**
+ * @file pipeline.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief Tokenizing a large chunk of HTML on a helper thread while the
+ *  calling thread builds the tree.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The tokenizer runs on the helper thread with its token callback replaced
+ * by one which serializes every token into a batch, and with private hashes
+ * of tag and attribute names, so that it never touches the document.
+ * The batches are passed to the calling thread through a single-producer
+ * single-consumer ring; the calling thread rebuilds the tokens against the
+ * document and feeds them to the tree builder.
+ *
+ * The tree builder changes the state of the tokenizer after a few start
+ * tags (RCDATA, RAWTEXT, script data, and plaintext), and the tokenizer
+ * looks into the tree when it meets a CDATA section. At these points the
+ * helper thread waits until the ring is drained.
+ */
+
+#include "config.h"
+
+#include "private/errors.h"
+#include "private/instance.h"
+#include "private/dom.h"
+#include "private/hash.h"
+#include "private/mraw.h"
+#include "private/dobject.h"
+
+#include "html/tree.h"
+#include "html/tokenizer.h"
+#include "html/token.h"
+
+#if USE(PTHREADS)
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+/* this feature needs C11 (stdatomic.h) or above */
+#if HAVE(STDATOMIC_H)
+#include <stdatomic.h>
+#else
+#error "Not implemented for this platform."
+#endif
+
+#define PIPELINE_RING_SIZE      64
+#define PIPELINE_BATCH_SIZE     (32 * 1024)
+#define PIPELINE_SPIN_COUNT     1024
+
+const pchtml_tag_data_t *
+pchtml_tag_append_lower(pcutils_hash_t *hash,
+                     const unsigned char *name, size_t length);
+
+pcdom_attr_data_t *
+pcdom_attr_local_name_append(pcutils_hash_t *hash,
+                               const unsigned char *name, size_t length);
+
+/* A serialized token; followed by the name of a non-static tag, the text,
+   and the attributes. */
+struct pipeline_token {
+    pchtml_tag_id_t             tag_id;
+    pchtml_html_token_type_t    type;
+    size_t                      null_count;
+    size_t                      name_len;
+    size_t                      text_len;
+    size_t                      nr_attrs;
+    bool                        has_text;
+};
+
+/* A serialized attribute; followed by the name and the value. */
+struct pipeline_attr {
+    pchtml_html_token_attr_type_t type;
+    size_t                      name_len;
+    size_t                      value_len;
+    bool                        has_name;
+    bool                        has_value;      /* value_begin != NULL */
+    bool                        has_value_buf;  /* value != NULL */
+};
+
+struct pipeline_batch {
+    size_t                      size;
+    size_t                      capacity;
+    unsigned char               data[];
+};
+
+struct pipeline {
+    pchtml_html_tree_t         *tree;
+    pchtml_html_tokenizer_t    *tkz;
+    const unsigned char        *data;
+    size_t                      sz;
+
+    /* the ring; `head` is moved by the builder after a batch is built */
+    struct pipeline_batch      *ring[PIPELINE_RING_SIZE];
+    atomic_size_t               head;
+    atomic_size_t               tail;
+    atomic_bool                 done;
+    atomic_bool                 failed;
+
+    /* only used when one side has nothing to do */
+    pthread_mutex_t             lock;
+    pthread_cond_t              cond;
+    atomic_int                  nr_sleepers;
+
+    /* the tokenizer side */
+    struct pipeline_batch      *batch;
+    pcutils_hash_t             *tkz_tags;
+    pcutils_hash_t             *tkz_attrs;
+    pcutils_mraw_t             *tkz_attrs_mraw;
+
+    /* the builder side */
+    pcutils_hash_t             *tags;
+    pcutils_hash_t             *attrs;
+    pcutils_mraw_t             *attrs_mraw;
+    pcutils_dobject_t          *dobj_attr;
+    pchtml_html_token_t         token;
+    unsigned int                status;
+
+    /* the hooks of the tokenizer to restore */
+    pchtml_html_tokenizer_token_f callback_token_done;
+    void                       *callback_token_ctx;
+};
+
+typedef bool (*pipeline_cond_f)(struct pipeline *p);
+
+static bool
+pipeline_has_room(struct pipeline *p)
+{
+    return atomic_load(&p->tail) - atomic_load(&p->head) < PIPELINE_RING_SIZE
+        || atomic_load(&p->failed);
+}
+
+static bool
+pipeline_is_drained(struct pipeline *p)
+{
+    return atomic_load(&p->head) == atomic_load(&p->tail)
+        || atomic_load(&p->failed);
+}
+
+static bool
+pipeline_has_batch(struct pipeline *p)
+{
+    return atomic_load(&p->head) != atomic_load(&p->tail)
+        || atomic_load(&p->done);
+}
+
+static void
+pipeline_wait(struct pipeline *p, pipeline_cond_f cond)
+{
+    for (int i = 0; i < PIPELINE_SPIN_COUNT; i++) {
+        if (cond(p))
+            return;
+    }
+
+    pthread_mutex_lock(&p->lock);
+    atomic_fetch_add(&p->nr_sleepers, 1);
+    while (!cond(p)) {
+        pthread_cond_wait(&p->cond, &p->lock);
+    }
+    atomic_fetch_sub(&p->nr_sleepers, 1);
+    pthread_mutex_unlock(&p->lock);
+}
+
+static void
+pipeline_wake(struct pipeline *p)
+{
+    if (atomic_load(&p->nr_sleepers) > 0) {
+        pthread_mutex_lock(&p->lock);
+        pthread_cond_broadcast(&p->cond);
+        pthread_mutex_unlock(&p->lock);
+    }
+}
+
+/*
+ * The tokenizer side.
+ */
+static bool
+pipeline_push(struct pipeline *p)
+{
+    struct pipeline_batch *batch = p->batch;
+    size_t tail;
+
+    if (batch == NULL)
+        return !atomic_load(&p->failed);
+
+    p->batch = NULL;
+    pipeline_wait(p, pipeline_has_room);
+    if (atomic_load(&p->failed)) {
+        pcutils_free(batch);
+        return false;
+    }
+
+    tail = atomic_load(&p->tail);
+    p->ring[tail % PIPELINE_RING_SIZE] = batch;
+    atomic_store(&p->tail, tail + 1);
+    pipeline_wake(p);
+    return true;
+}
+
+static bool
+pipeline_drain(struct pipeline *p)
+{
+    if (!pipeline_push(p))
+        return false;
+
+    pipeline_wait(p, pipeline_is_drained);
+    return !atomic_load(&p->failed);
+}
+
+static unsigned char *
+pipeline_reserve(struct pipeline *p, size_t len)
+{
+    struct pipeline_batch *batch = p->batch;
+    unsigned char *at;
+
+    if (batch && batch->size + len > batch->capacity) {
+        if (!pipeline_push(p))
+            return NULL;
+        batch = NULL;
+    }
+
+    if (batch == NULL) {
+        size_t capacity = (len > PIPELINE_BATCH_SIZE) ?
+            len : PIPELINE_BATCH_SIZE;
+
+        batch = pcutils_malloc(sizeof(*batch) + capacity);
+        if (batch == NULL)
+            return NULL;
+
+        batch->size = 0;
+        batch->capacity = capacity;
+        p->batch = batch;
+    }
+
+    at = batch->data + batch->size;
+    batch->size += len;
+    return at;
+}
+
+static bool
+pipeline_put_token(struct pipeline *p, pchtml_html_token_t *token)
+{
+    struct pipeline_token rec;
+    const unsigned char *name = NULL;
+    pchtml_html_token_attr_t *attr;
+    unsigned char *at;
+    size_t len;
+
+    rec.tag_id = token->tag_id;
+    rec.type = token->type;
+    rec.null_count = token->null_count;
+    rec.name_len = 0;
+    rec.has_text = (token->text_start != NULL);
+    rec.text_len = rec.has_text ? token->text_end - token->text_start : 0;
+    rec.nr_attrs = 0;
+
+    /* the id of a non-static tag is only valid in the private hash */
+    if (token->tag_id >= PCHTML_TAG__LAST_ENTRY) {
+        name = pchtml_tag_name_by_id(p->tkz_tags, token->tag_id,
+                &rec.name_len);
+    }
+
+    len = sizeof(rec) + rec.name_len + rec.text_len;
+    for (attr = token->attr_first; attr != NULL; attr = attr->next) {
+        rec.nr_attrs++;
+        len += sizeof(struct pipeline_attr);
+        if (attr->name)
+            len += attr->name->entry.length;
+        if (attr->value)
+            len += attr->value_size;
+    }
+
+    at = pipeline_reserve(p, len);
+    if (at == NULL)
+        return false;
+
+    memcpy(at, &rec, sizeof(rec));
+    at += sizeof(rec);
+    if (rec.name_len) {
+        memcpy(at, name, rec.name_len);
+        at += rec.name_len;
+    }
+    if (rec.text_len) {
+        memcpy(at, token->text_start, rec.text_len);
+        at += rec.text_len;
+    }
+
+    for (attr = token->attr_first; attr != NULL; attr = attr->next) {
+        struct pipeline_attr arec;
+
+        arec.type = attr->type;
+        arec.has_name = (attr->name != NULL);
+        arec.name_len = arec.has_name ? attr->name->entry.length : 0;
+        arec.has_value = (attr->value_begin != NULL);
+        arec.has_value_buf = (attr->value != NULL);
+        arec.value_len = arec.has_value_buf ? attr->value_size : 0;
+
+        memcpy(at, &arec, sizeof(arec));
+        at += sizeof(arec);
+        if (arec.name_len) {
+            memcpy(at, pcutils_hash_entry_str(&attr->name->entry),
+                    arec.name_len);
+            at += arec.name_len;
+        }
+        if (arec.value_len) {
+            memcpy(at, attr->value, arec.value_len);
+            at += arec.value_len;
+        }
+    }
+
+    return true;
+}
+
+static bool
+pipeline_is_sync_tag(pchtml_tag_id_t tag_id)
+{
+    /* the start tags after which the tree builder switches the tokenizer */
+    switch (tag_id) {
+    case PCHTML_TAG_TITLE:
+    case PCHTML_TAG_TEXTAREA:
+    case PCHTML_TAG_STYLE:
+    case PCHTML_TAG_XMP:
+    case PCHTML_TAG_IFRAME:
+    case PCHTML_TAG_NOEMBED:
+    case PCHTML_TAG_NOFRAMES:
+    case PCHTML_TAG_NOSCRIPT:
+    case PCHTML_TAG_SCRIPT:
+    case PCHTML_TAG_PLAINTEXT:
+        return true;
+    default:
+        break;
+    }
+
+    return false;
+}
+
+static pchtml_html_token_t *
+pipeline_token_done(pchtml_html_tokenizer_t *tkz,
+        pchtml_html_token_t *token, void *ctx)
+{
+    struct pipeline *p = ctx;
+
+    if (!pipeline_put_token(p, token))
+        goto failed;
+
+    if ((token->type & PCHTML_HTML_TOKEN_TYPE_CLOSE) == 0 &&
+            pipeline_is_sync_tag(token->tag_id)) {
+        if (!pipeline_drain(p))
+            goto failed;
+    }
+
+    return token;
+
+failed:
+    /* no instance on this thread; the caller reports the error */
+    if (tkz->status == PCHTML_STATUS_OK) {
+        tkz->status = atomic_load(&p->failed) ?
+            PCHTML_STATUS_ERROR : PCHTML_STATUS_ERROR_MEMORY_ALLOCATION;
+    }
+    return NULL;
+}
+
+static void
+pipeline_sync(pchtml_html_tokenizer_t *tkz, void *ctx)
+{
+    UNUSED_PARAM(tkz);
+
+    /* the tokenizer is about to look into the tree */
+    pipeline_drain(ctx);
+}
+
+static void *
+pipeline_tokenize(void *arg)
+{
+    struct pipeline *p = arg;
+
+    pchtml_html_tokenizer_chunk(p->tkz, p->data, p->sz);
+    pipeline_push(p);
+
+    atomic_store(&p->done, true);
+    pipeline_wake(p);
+    return NULL;
+}
+
+/*
+ * The builder side.
+ */
+static const unsigned char *
+pipeline_get_token(struct pipeline *p, const unsigned char *at)
+{
+    pchtml_html_token_t *token = &p->token;
+    struct pipeline_token rec;
+
+    memcpy(&rec, at, sizeof(rec));
+    at += sizeof(rec);
+
+    memset(token, 0, sizeof(*token));
+    token->tag_id = rec.tag_id;
+    token->type = rec.type;
+    token->null_count = rec.null_count;
+
+    if (rec.tag_id >= PCHTML_TAG__LAST_ENTRY) {
+        const pchtml_tag_data_t *tag;
+
+        tag = pchtml_tag_append_lower(p->tags, at, rec.name_len);
+        if (tag == NULL)
+            goto failed;
+
+        token->tag_id = tag->tag_id;
+        at += rec.name_len;
+    }
+
+    if (rec.has_text) {
+        token->text_start = at;
+        token->text_end = at + rec.text_len;
+        token->begin = token->text_start;
+        token->end = token->text_end;
+        at += rec.text_len;
+    }
+
+    for (size_t i = 0; i < rec.nr_attrs; i++) {
+        pchtml_html_token_attr_t *attr;
+        struct pipeline_attr arec;
+
+        memcpy(&arec, at, sizeof(arec));
+        at += sizeof(arec);
+
+        attr = pchtml_html_token_attr_append(token, p->dobj_attr);
+        if (attr == NULL)
+            goto failed;
+
+        attr->type = arec.type;
+        if (arec.has_name) {
+            attr->name = pcdom_attr_local_name_append(p->attrs, at,
+                    arec.name_len);
+            if (attr->name == NULL)
+                goto failed;
+
+            attr->name_begin = at;
+            attr->name_end = at + arec.name_len;
+            at += arec.name_len;
+        }
+
+        if (arec.has_value) {
+            attr->value_begin = at;
+            attr->value_end = at + arec.value_len;
+        }
+
+        if (arec.has_value_buf) {
+            /* the tree keeps the value without copying it */
+            attr->value = pcutils_mraw_alloc(p->attrs_mraw,
+                    arec.value_len + 1);
+            if (attr->value == NULL)
+                goto failed;
+
+            memcpy(attr->value, at, arec.value_len);
+            attr->value[arec.value_len] = 0x00;
+            attr->value_size = arec.value_len;
+        }
+        at += arec.value_len;
+    }
+
+    return at;
+
+failed:
+    pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    p->status = PCHTML_STATUS_ERROR_MEMORY_ALLOCATION;
+    return NULL;
+}
+
+static void
+pipeline_build_batch(struct pipeline *p, struct pipeline_batch *batch)
+{
+    const unsigned char *at = batch->data;
+    const unsigned char *end = batch->data + batch->size;
+
+    while (at < end) {
+        at = pipeline_get_token(p, at);
+        if (at == NULL)
+            break;
+
+        while (pchtml_html_tree_construction_dispatcher(p->tree,
+                    &p->token) == false) {}
+
+        if (p->tree->status != PCHTML_STATUS_OK) {
+            p->status = p->tree->status;
+            break;
+        }
+    }
+
+    pcutils_dobject_clean(p->dobj_attr);
+}
+
+static void
+pipeline_build(struct pipeline *p)
+{
+    for (;;) {
+        struct pipeline_batch *batch;
+        size_t head;
+
+        pipeline_wait(p, pipeline_has_batch);
+
+        head = atomic_load(&p->head);
+        if (head == atomic_load(&p->tail))
+            break;
+
+        /* keep consuming after a failure until the tokenizer stops */
+        batch = p->ring[head % PIPELINE_RING_SIZE];
+        if (p->status == PCHTML_STATUS_OK) {
+            pipeline_build_batch(p, batch);
+            if (p->status != PCHTML_STATUS_OK)
+                atomic_store(&p->failed, true);
+        }
+        pcutils_free(batch);
+
+        atomic_store(&p->head, head + 1);
+        pipeline_wake(p);
+    }
+}
+
+/* moves the names and values of the pending token to the document */
+static unsigned int
+pipeline_adopt_token(struct pipeline *p, pchtml_html_token_t *token)
+{
+    pchtml_html_token_attr_t *attr;
+
+    if (token->tag_id >= PCHTML_TAG__LAST_ENTRY) {
+        const pchtml_tag_data_t *tag;
+        const unsigned char *name;
+        size_t len;
+
+        name = pchtml_tag_name_by_id(p->tkz_tags, token->tag_id, &len);
+        tag = pchtml_tag_append_lower(p->tags, name, len);
+        if (tag == NULL)
+            goto failed;
+
+        token->tag_id = tag->tag_id;
+    }
+
+    for (attr = token->attr_first; attr != NULL; attr = attr->next) {
+        if (attr->name) {
+            attr->name = pcdom_attr_local_name_append(p->attrs,
+                    pcutils_hash_entry_str(&attr->name->entry),
+                    attr->name->entry.length);
+            if (attr->name == NULL)
+                goto failed;
+        }
+
+        if (attr->value) {
+            unsigned char *value;
+
+            value = pcutils_mraw_alloc(p->attrs_mraw, attr->value_size + 1);
+            if (value == NULL)
+                goto failed;
+
+            memcpy(value, attr->value, attr->value_size + 1);
+            attr->value = value;
+        }
+    }
+
+    return PCHTML_STATUS_OK;
+
+failed:
+    pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    return PCHTML_STATUS_ERROR_MEMORY_ALLOCATION;
+}
+
+static void
+pipeline_destroy(struct pipeline *p)
+{
+    if (p->tkz_tags)
+        pcutils_hash_destroy(p->tkz_tags, true);
+    if (p->tkz_attrs)
+        pcutils_hash_destroy(p->tkz_attrs, true);
+    if (p->tkz_attrs_mraw)
+        pcutils_mraw_destroy(p->tkz_attrs_mraw, true);
+    if (p->dobj_attr)
+        pcutils_dobject_destroy(p->dobj_attr, true);
+
+    pcutils_free(p);
+}
+
+static struct pipeline *
+pipeline_create(pchtml_html_tree_t *tree,
+        const unsigned char *data, size_t sz)
+{
+    pchtml_html_tokenizer_t *tkz = tree->tkz_ref;
+    struct pipeline *p;
+
+    p = pcutils_calloc(1, sizeof(*p));
+    if (p == NULL)
+        return NULL;
+
+    p->tree = tree;
+    p->tkz = tkz;
+    p->data = data;
+    p->sz = sz;
+    p->status = PCHTML_STATUS_OK;
+
+    atomic_init(&p->head, 0);
+    atomic_init(&p->tail, 0);
+    atomic_init(&p->done, false);
+    atomic_init(&p->failed, false);
+    atomic_init(&p->nr_sleepers, 0);
+
+    p->tags = tkz->tags;
+    p->attrs = tkz->attrs;
+    p->attrs_mraw = tkz->attrs_mraw;
+
+    p->tkz_tags = pcutils_hash_create();
+    if (pcutils_hash_init(p->tkz_tags, 128,
+                sizeof(pchtml_tag_data_t)) != PCHTML_STATUS_OK)
+        goto failed;
+
+    p->tkz_attrs = pcutils_hash_create();
+    if (pcutils_hash_init(p->tkz_attrs, 128,
+                sizeof(pcdom_attr_data_t)) != PCHTML_STATUS_OK)
+        goto failed;
+
+    p->tkz_attrs_mraw = pcutils_mraw_create();
+    if (pcutils_mraw_init(p->tkz_attrs_mraw, (4096 * 4)) != PCHTML_STATUS_OK)
+        goto failed;
+
+    p->dobj_attr = pcutils_dobject_create();
+    if (pcutils_dobject_init(p->dobj_attr, 128,
+                sizeof(pchtml_html_token_attr_t)) != PCHTML_STATUS_OK)
+        goto failed;
+
+    return p;
+
+failed:
+    pipeline_destroy(p);
+    return NULL;
+}
+
+unsigned int
+pchtml_html_tree_chunk_pipelined(pchtml_html_tree_t *tree,
+                const unsigned char *data, size_t sz)
+{
+    pchtml_html_tokenizer_t *tkz = tree->tkz_ref;
+    struct pipeline *p;
+    pthread_t th;
+    unsigned int status;
+
+    /* only the tree builder set by pchtml_html_tree_init() is pipelined */
+    if (data == NULL || tkz->callback_token_ctx != tree ||
+            tkz->callback_sync != NULL || tkz->token == NULL ||
+            tkz->tags == NULL || tkz->attrs == NULL ||
+            tkz->attrs_mraw == NULL)
+        goto sequential;
+
+    p = pipeline_create(tree, data, sz);
+    if (p == NULL)
+        goto sequential;
+
+    if (pthread_mutex_init(&p->lock, NULL))
+        goto destroy;
+    if (pthread_cond_init(&p->cond, NULL))
+        goto destroy_lock;
+
+    p->callback_token_done = tkz->callback_token_done;
+    p->callback_token_ctx = tkz->callback_token_ctx;
+
+    tkz->tags = p->tkz_tags;
+    tkz->attrs = p->tkz_attrs;
+    tkz->attrs_mraw = p->tkz_attrs_mraw;
+    tkz->callback_token_done = pipeline_token_done;
+    tkz->callback_token_ctx = p;
+    tkz->callback_sync = pipeline_sync;
+
+    if (pthread_create(&th, NULL, pipeline_tokenize, p)) {
+        tkz->tags = p->tags;
+        tkz->attrs = p->attrs;
+        tkz->attrs_mraw = p->attrs_mraw;
+        tkz->callback_token_done = p->callback_token_done;
+        tkz->callback_token_ctx = p->callback_token_ctx;
+        tkz->callback_sync = NULL;
+        goto destroy_cond;
+    }
+
+    pipeline_build(p);
+    pthread_join(th, NULL);
+
+    tkz->tags = p->tags;
+    tkz->attrs = p->attrs;
+    tkz->attrs_mraw = p->attrs_mraw;
+    tkz->callback_token_done = p->callback_token_done;
+    tkz->callback_token_ctx = p->callback_token_ctx;
+    tkz->callback_sync = NULL;
+
+    if (p->status != PCHTML_STATUS_OK) {
+        status = p->status;
+    }
+    else if (tkz->status != PCHTML_STATUS_OK) {
+        pcinst_set_error(tkz->status == PCHTML_STATUS_ERROR_MEMORY_ALLOCATION ?
+                PURC_ERROR_OUT_OF_MEMORY : PURC_ERROR_HTML);
+        status = tkz->status;
+    }
+    else if (tkz->token) {
+        /* the chunk may end in the middle of a token */
+        status = pipeline_adopt_token(p, tkz->token);
+    }
+    else {
+        status = PCHTML_STATUS_OK;
+    }
+
+    tkz->status = status;
+
+    pthread_cond_destroy(&p->cond);
+    pthread_mutex_destroy(&p->lock);
+    pipeline_destroy(p);
+    return status;
+
+destroy_cond:
+    pthread_cond_destroy(&p->cond);
+destroy_lock:
+    pthread_mutex_destroy(&p->lock);
+destroy:
+    pipeline_destroy(p);
+sequential:
+    return pchtml_html_tokenizer_chunk(tkz, data, sz);
+}
+
+#endif /* USE(PTHREADS) */
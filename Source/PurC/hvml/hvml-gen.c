@@ -177,21 +177,6 @@ is_top_node_of_head(struct pcvdom_gen *gen)
     return gen->doc->head == elem ? true : false;
 }
 
-static inline enum pchvml_tag_id
-tag_id_from_tag(const char *tag)
-{
-    if (!tag)
-        return PCHVML_TAG__UNDEF;
-
-    const struct pchvml_tag_entry *entry;
-    entry = pchvml_tag_static_search(tag, strlen(tag));
-
-    if (entry)
-        return entry->id;
-
-    return PCHVML_TAG__UNDEF;
-}
-
 static inline bool
 is_tag_of_hvml_verb_cat(enum pchvml_tag_id id)
 {
@@ -242,18 +227,27 @@ set_parser_state_if_necessary(struct pcvdom_gen *gen)
 static struct pcvdom_element*
 create_element(struct pcvdom_gen *gen, struct pchvml_token *token)
 {
-    UNUSED_PARAM(gen);
-
     int r = 0;
 
     const char *tag = pchvml_token_get_name(token);
     size_t nr_attrs = pchvml_token_get_attr_size(token);
+    struct pcinst *inst = pcinst_current();
+    bool lazy = inst && inst->lazy_attr_vcm;
 
     struct pcvdom_element *elem = NULL;
-    elem = pcvdom_element_create_c(tag);
+    enum pchvml_tag_id tag_id = pchvml_token_get_tag_id(token);
+    if (tag_id != PCHVML_TAG__UNDEF)
+        elem = pcvdom_element_create(tag_id);
+    else
+        elem = pcvdom_element_create_c(tag);
     if (!elem)
         goto end;
 
+    pchvml_parser_get_curr_pos(gen->parser, NULL, &elem->line, NULL, NULL);
+
+    if (nr_attrs && pcvdom_element_reserve_attrs(elem, nr_attrs))
+        goto end;
+
     for (size_t i=0; i<nr_attrs; ++i) {
         // TODO: how to traverse attr
         struct pchvml_token_attr *attr;
@@ -266,7 +260,10 @@ create_element(struct pcvdom_gen *gen, struct pchvml_token *token)
         vcm = (struct pcvcm_node*)pchvml_token_attr_get_value_ex(attr, true);
 
         struct pcvdom_attr *vattr;
-        vattr = pcvdom_attr_create(name, op, vcm);
+        if (lazy)
+            vattr = pcvdom_attr_create_lazy(name, op, vcm);
+        else
+            vattr = pcvdom_attr_create(name, op, vcm);
 
         if (!vattr) {
             r = -1;
@@ -647,8 +644,7 @@ on_mode_before_hvml(struct pcvdom_gen *gen, struct pchvml_token *token)
     int r = 0;
     enum pchvml_token_type type = pchvml_token_get_type(token);
     if (type==VTT(_START_TAG)) {
-        const char *tag = pchvml_token_get_name(token);
-        const enum pchvml_tag_id tag_id = tag_id_from_tag(tag);
+        const enum pchvml_tag_id tag_id = pchvml_token_get_tag_id(token);
         if (tag_id == PCHVML_TAG_HVML) {
             return create_hvml(gen, token);
         }
@@ -698,8 +694,7 @@ on_mode_in_hvml(struct pcvdom_gen *gen, struct pchvml_token *token)
     }
 
     if (type==VTT(_START_TAG)) {
-        const char *tag = pchvml_token_get_name(token);
-        const enum pchvml_tag_id tag_id = tag_id_from_tag(tag);
+        const enum pchvml_tag_id tag_id = pchvml_token_get_tag_id(token);
         if (tag_id == PCHVML_TAG_INIT||
             tag_id == PCHVML_TAG_SET ||
             tag_id == PCHVML_TAG_ARCHEDATA ||
@@ -758,14 +753,14 @@ on_mode_in_hvml(struct pcvdom_gen *gen, struct pchvml_token *token)
     }
     else if (type==VTT(_END_TAG)) {
         const char *tag = pchvml_token_get_name(token);
-        const enum pchvml_tag_id tag_id = tag_id_from_tag(tag);
+        const enum pchvml_tag_id tag_id = pchvml_token_get_tag_id(token);
         if (tag_id == PCHVML_TAG__UNDEF) {
             while (1) {
                 struct pcvdom_node *node = top_node(gen);
                 struct pcvdom_element *elem;
                 elem = container_of(node, struct pcvdom_element, node);
                 const char *tagname = pcvdom_element_get_tagname(elem);
-                if (tag_id_from_tag(tagname) != PCHVML_TAG__UNDEF)
+                if (elem->tag_id != PCHVML_TAG__UNDEF)
                     FAIL_RET();
 
                 if (strcmp(tagname, tag)) {
@@ -789,8 +784,7 @@ on_mode_in_hvml(struct pcvdom_gen *gen, struct pchvml_token *token)
             struct pcvdom_node *node = top_node(gen);
             struct pcvdom_element *elem;
             elem = container_of(node, struct pcvdom_element, node);
-            const char *tagname = pcvdom_element_get_tagname(elem);
-            if (tag_id_from_tag(tagname) != tag_id)
+            if (elem->tag_id != tag_id)
                 FAIL_RET();
 
             pop_node(gen);
@@ -835,8 +829,7 @@ on_mode_before_head(struct pcvdom_gen *gen, struct pchvml_token *token)
     int r = 0;
     enum pchvml_token_type type = pchvml_token_get_type(token);
     if (type==VTT(_START_TAG)) {
-        const char *tag = pchvml_token_get_name(token);
-        const enum pchvml_tag_id tag_id = tag_id_from_tag(tag);
+        const enum pchvml_tag_id tag_id = pchvml_token_get_tag_id(token);
         if (tag_id == PCHVML_TAG_HVML) {
             FAIL_RET();
             return 0; // just ignore
@@ -900,8 +893,7 @@ on_mode_before_head(struct pcvdom_gen *gen, struct pchvml_token *token)
         }
     }
     else if (type==VTT(_END_TAG)) {
-        const char *tag = pchvml_token_get_name(token);
-        const enum pchvml_tag_id tag_id = tag_id_from_tag(tag);
+        const enum pchvml_tag_id tag_id = pchvml_token_get_tag_id(token);
 
         if (tag_id == PCHVML_TAG_HVML) {
             pop_node(gen);
@@ -925,8 +917,7 @@ on_mode_in_head(struct pcvdom_gen *gen, struct pchvml_token *token)
     if (type==VTT(_START_TAG)) {
         struct pcvdom_element *elem;
         struct pcvdom_element *top;
-        const char *tag = pchvml_token_get_name(token);
-        const enum pchvml_tag_id tag_id = tag_id_from_tag(tag);
+        const enum pchvml_tag_id tag_id = pchvml_token_get_tag_id(token);
         if (tag_id == PCHVML_TAG_INIT||
             tag_id == PCHVML_TAG_SET ||
             tag_id == PCHVML_TAG_ARCHEDATA ||
@@ -982,7 +973,7 @@ on_mode_in_head(struct pcvdom_gen *gen, struct pchvml_token *token)
     }
     else if (type==VTT(_END_TAG)) {
         const char *tag = pchvml_token_get_name(token);
-        const enum pchvml_tag_id tag_id = tag_id_from_tag(tag);
+        const enum pchvml_tag_id tag_id = pchvml_token_get_tag_id(token);
 
         if (tag_id == PCHVML_TAG_HEAD) {
             if (is_top_node_of_head(gen)) {
@@ -1044,8 +1035,7 @@ on_mode_after_head(struct pcvdom_gen *gen, struct pchvml_token *token)
     }
 
     if (type==VTT(_START_TAG)) {
-        const char *tag = pchvml_token_get_name(token);
-        const enum pchvml_tag_id tag_id = tag_id_from_tag(tag);
+        const enum pchvml_tag_id tag_id = pchvml_token_get_tag_id(token);
         if (tag_id == PCHVML_TAG_BODY) {
             r = create_body(gen, token);
             if (r)
@@ -1086,8 +1076,7 @@ on_mode_after_head(struct pcvdom_gen *gen, struct pchvml_token *token)
         }
     }
     else if (type==VTT(_END_TAG)) {
-        const char *tag = pchvml_token_get_name(token);
-        const enum pchvml_tag_id tag_id = tag_id_from_tag(tag);
+        const enum pchvml_tag_id tag_id = pchvml_token_get_tag_id(token);
 
         if (tag_id == PCHVML_TAG_HVML) {
             pop_node(gen);
@@ -1114,8 +1103,7 @@ on_mode_in_body(struct pcvdom_gen *gen, struct pchvml_token *token)
     }
 
     if (type==VTT(_START_TAG)) {
-        const char *tag = pchvml_token_get_name(token);
-        const enum pchvml_tag_id tag_id = tag_id_from_tag(tag);
+        const enum pchvml_tag_id tag_id = pchvml_token_get_tag_id(token);
         if (tag_id == PCHVML_TAG_INIT||
             tag_id == PCHVML_TAG_SET ||
             tag_id == PCHVML_TAG_ARCHEDATA ||
@@ -1174,7 +1162,7 @@ on_mode_in_body(struct pcvdom_gen *gen, struct pchvml_token *token)
     }
     else if (type==VTT(_END_TAG)) {
         const char *tag = pchvml_token_get_name(token);
-        const enum pchvml_tag_id tag_id = tag_id_from_tag(tag);
+        const enum pchvml_tag_id tag_id = pchvml_token_get_tag_id(token);
         if (tag_id == PCHVML_TAG_BODY) {
             if (is_top_node_of_body(gen)) {
                 pop_node(gen);
@@ -1190,7 +1178,7 @@ on_mode_in_body(struct pcvdom_gen *gen, struct pchvml_token *token)
                 struct pcvdom_element *elem;
                 elem = container_of(node, struct pcvdom_element, node);
                 const char *tagname = pcvdom_element_get_tagname(elem);
-                if (tag_id_from_tag(tagname) != PCHVML_TAG__UNDEF)
+                if (elem->tag_id != PCHVML_TAG__UNDEF)
                     FAIL_RET();
 
                 if (strcmp(tagname, tag)) {
@@ -1214,8 +1202,7 @@ on_mode_in_body(struct pcvdom_gen *gen, struct pchvml_token *token)
             struct pcvdom_node *node = top_node(gen);
             struct pcvdom_element *elem;
             elem = container_of(node, struct pcvdom_element, node);
-            const char *tagname = pcvdom_element_get_tagname(elem);
-            if (tag_id_from_tag(tagname) != tag_id)
+            if (elem->tag_id != tag_id)
                 FAIL_RET();
 
             pop_node(gen);
@@ -1259,8 +1246,7 @@ on_mode_after_body(struct pcvdom_gen *gen, struct pchvml_token *token)
         return 0; // just ignore
     }
     else if (type==VTT(_END_TAG)) {
-        const char *tag = pchvml_token_get_name(token);
-        const enum pchvml_tag_id tag_id = tag_id_from_tag(tag);
+        const enum pchvml_tag_id tag_id = pchvml_token_get_tag_id(token);
         if (tag_id == PCHVML_TAG_HVML) {
             gen->insertion_mode = VGIM(_AFTER_AFTER_BODY);
             return 0;
@@ -1353,9 +1339,8 @@ on_mode_after_after_body(struct pcvdom_gen *gen, struct pchvml_token *token)
     return 0; // just ignore
 }
 
-int
-pcvdom_gen_push_token(struct pcvdom_gen *gen,
-    struct pchvml_parser     *parser, /* exists for tokenizer state change */
+static int
+push_token(struct pcvdom_gen *gen, struct pchvml_parser *parser,
     struct pchvml_token *token)
 {
     int r = 0;
@@ -1370,6 +1355,10 @@ pcvdom_gen_push_token(struct pcvdom_gen *gen,
         gen->doc = pcvdom_document_create();
         if (!gen->doc)
             FAIL_RET();
+        if (parser && parser->vcm_arena) {
+            // the VCM nodes of the tokens live as long as the document
+            gen->doc->vcm_arena = pcvcm_arena_ref(parser->vcm_arena);
+        }
         if (push_node(gen, &gen->doc->node)) {
             pcvdom_document_unref(gen->doc);
             gen->doc = NULL;
@@ -1420,6 +1409,21 @@ again:
     return r ? -1 : 0;
 }
 
+int
+pcvdom_gen_push_token(struct pcvdom_gen *gen,
+    struct pchvml_parser     *parser, /* exists for tokenizer state change */
+    struct pchvml_token *token)
+{
+    if (!parser || !parser->vcm_arena)
+        return push_token(gen, parser, token);
+
+    // the nodes live as long as the document, like the VCM nodes
+    struct pcvcm_arena *old = pcvcm_arena_switch(parser->vcm_arena);
+    int r = push_token(gen, parser, token);
+    pcvcm_arena_switch(old);
+    return r;
+}
+
 int pchvml_parser_get_curr_pos(struct pchvml_parser* parser,
     uint32_t *character, int *line, int *column, int *position)
 {
@@ -1445,8 +1449,9 @@ int pchvml_parser_get_curr_pos(struct pchvml_parser* parser,
     return 0;
 }
 
-struct pcvdom_document*
-pcvdom_util_document_from_stream(purc_rwstream_t in, struct pcvdom_pos *pos)
+static struct pcvdom_document*
+document_from_stream(purc_rwstream_t in, struct pcvdom_pos *pos,
+        uint32_t flags)
 {
     struct pchvml_parser *parser = NULL;
     struct pcvdom_gen *gen = NULL;
@@ -1455,7 +1460,7 @@ pcvdom_util_document_from_stream(purc_rwstream_t in, struct pcvdom_pos *pos)
 
     PC_ASSERT(in);
 
-    parser = pchvml_create(0, 0);
+    parser = pchvml_create(flags, 0);
     if (!parser)
         goto end;
 
@@ -1498,6 +1503,12 @@ end:
     return doc;
 }
 
+struct pcvdom_document*
+pcvdom_util_document_from_stream(purc_rwstream_t in, struct pcvdom_pos *pos)
+{
+    return document_from_stream(in, pos, PCHVML_FLAG_VCM_ARENA);
+}
+
 struct pcvdom_document*
 pcvdom_util_document_from_buf(const unsigned char *buf, size_t len,
         struct pcvdom_pos *pos)
@@ -1551,7 +1562,7 @@ again:
     if (n == 0) {
         rs->idx += 1;
         if (rs->idx == 3)
-            return count;
+            return 0;
         goto again;
     }
 
@@ -1562,7 +1573,8 @@ struct pcvdom_element*
 parse_fragment(purc_rwstream_t in, struct pcvdom_pos *pos)
 {
     struct pcvdom_document *doc;
-    doc = pcvdom_util_document_from_stream(in, pos);
+    // no arena: the body outlives the document
+    doc = document_from_stream(in, pos, 0);
     PC_ASSERT(doc);
     if (!doc)
         return NULL;
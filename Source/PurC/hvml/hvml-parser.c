@@ -28,6 +28,7 @@
 #include "private/instance.h"
 #include "private/errors.h"
 #include "private/debug.h"
+#include "private/trace.h"
 #include "private/utils.h"
 #include "private/dom.h"
 #include "private/hvml.h"
@@ -78,6 +79,7 @@ static int hvml_init_once(void)
 }
 
 struct pcmodule _module_hvml = {
+    .name            = "hvml",
     .id              = PURC_HAVE_HVML,
     .module_inited   = 0,
 
@@ -86,15 +88,17 @@ struct pcmodule _module_hvml = {
 };
 
 
-#define PURC_ENVV_HVML_LOG_ENABLE   "PURC_HVML_LOG_ENABLE"
 
 struct pchvml_parser* pchvml_create(uint32_t flags, size_t queue_size)
 {
-    UNUSED_PARAM(flags);
     UNUSED_PARAM(queue_size);
 
     struct pchvml_parser* parser = (struct pchvml_parser*) PCHVML_ALLOC(
             sizeof(struct pchvml_parser));
+    if (flags & PCHVML_FLAG_VCM_ARENA) {
+        /* falls back to the heap if failed */
+        parser->vcm_arena = pcvcm_arena_new();
+    }
     parser->state = 0;
     parser->reader = tkz_reader_new ();
     parser->temp_buffer = tkz_buffer_new ();
@@ -108,9 +112,7 @@ struct pchvml_parser* pchvml_create(uint32_t flags, size_t queue_size)
     parser->tag_is_operation = 0;
     parser->tag_has_raw_attr = 0;
     parser->is_in_file_header = 1;
-    const char *env_value = getenv(PURC_ENVV_HVML_LOG_ENABLE);
-    parser->enable_log = ((env_value != NULL) &&
-            (*env_value == '1' || pcutils_strcasecmp(env_value, "true") == 0));
+    parser->enable_log = pctrace_enabled(PC_TRACE_HVML);
 
     return parser;
 }
@@ -150,6 +152,18 @@ void pchvml_reset(struct pchvml_parser* parser, uint32_t flags,
     parser->nr_quoted = 0;
     parser->tag_is_operation = false;
     parser->tag_has_raw_attr = false;
+    parser->tag_entry = NULL;
+    parser->is_waiting_input = false;
+}
+
+void pchvml_set_partial_input(struct pchvml_parser* parser, bool partial)
+{
+    tkz_reader_set_partial_input(parser->reader, partial);
+}
+
+bool pchvml_is_waiting_input(struct pchvml_parser* parser)
+{
+    return parser->is_waiting_input;
 }
 
 void pchvml_destroy(struct pchvml_parser* parser)
@@ -176,6 +190,7 @@ void pchvml_destroy(struct pchvml_parser* parser)
         if (parser->token) {
             pchvml_token_destroy(parser->token);
         }
+        pcvcm_arena_unref(parser->vcm_arena);
         PCHVML_FREE(parser);
     }
 }
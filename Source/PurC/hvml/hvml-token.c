@@ -78,6 +78,10 @@ struct pchvml_token {
     struct tkz_buffer* system_information;
 
     struct pchvml_token_attr* curr_attr;
+
+    /* the static tag entry of the name, resolved on the first query */
+    const struct pchvml_tag_entry* tag_entry;
+    bool tag_resolved;
 };
 
 struct pchvml_token_attr* pchvml_token_attr_new()
@@ -220,6 +224,9 @@ void pchvml_token_set_assignment_to_attr(struct pchvml_token* token,
     }
 }
 
+/* a list of up to these attributes costs only one allocation */
+#define NR_INLINE_ATTRS     8
+
 #define RAW_STRING          "raw"
 #define HVML_RAW_STRING     "hvml:raw"
 
@@ -235,8 +242,8 @@ void pchvml_token_end_attr(struct pchvml_token* token)
     }
 
     if (!token->attr_list) {
-        token->attr_list = pcutils_arrlist_new(
-                pchvml_token_attr_list_free_fn);
+        token->attr_list = pcutils_arrlist_new_ex(
+                pchvml_token_attr_list_free_fn, NR_INLINE_ATTRS);
     }
     const char* attr_name = tkz_buffer_get_bytes(token->curr_attr->name);
     if (strcmp(attr_name, RAW_STRING) == 0 ||
@@ -253,6 +260,7 @@ void pchvml_token_append_to_name(struct pchvml_token* token, uint32_t uc)
         token->name = tkz_buffer_new();
     }
     tkz_buffer_append(token->name, uc);
+    token->tag_resolved = false;
 }
 
 void pchvml_token_append_buffer_to_name(struct pchvml_token* token,
@@ -262,6 +270,7 @@ void pchvml_token_append_buffer_to_name(struct pchvml_token* token,
         token->name = tkz_buffer_new();
     }
     tkz_buffer_append_another(token->name, buffer);
+    token->tag_resolved = false;
 }
 
 const char* pchvml_token_get_name(struct pchvml_token* token)
@@ -269,6 +278,24 @@ const char* pchvml_token_get_name(struct pchvml_token* token)
     return token->name ? tkz_buffer_get_bytes(token->name) : NULL;
 }
 
+const struct pchvml_tag_entry*
+pchvml_token_get_tag_entry(struct pchvml_token* token)
+{
+    if (!token->tag_resolved) {
+        token->tag_entry = token->name ? pchvml_tag_static_search(
+                tkz_buffer_get_bytes(token->name),
+                tkz_buffer_get_size_in_bytes(token->name)) : NULL;
+        token->tag_resolved = true;
+    }
+    return token->tag_entry;
+}
+
+enum pchvml_tag_id pchvml_token_get_tag_id(struct pchvml_token* token)
+{
+    const struct pchvml_tag_entry* entry = pchvml_token_get_tag_entry(token);
+    return entry ? entry->id : PCHVML_TAG__UNDEF;
+}
+
 const char* pchvml_token_get_text(struct pchvml_token* token)
 {
     return token->text_content ?
@@ -89,6 +89,12 @@ void pchvml_token_append_buffer_to_name(struct pchvml_token* token,
 
 const char* pchvml_token_get_name(struct pchvml_token* token);
 
+/* the static tag entry of the token name, NULL for an unknown tag */
+const struct pchvml_tag_entry*
+pchvml_token_get_tag_entry(struct pchvml_token* token);
+
+enum pchvml_tag_id pchvml_token_get_tag_id(struct pchvml_token* token);
+
 void pchvml_token_append_bytes_to_text(struct pchvml_token* token,
         const char* bytes, size_t sz_bytes);
 
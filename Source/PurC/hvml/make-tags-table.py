@@ -23,8 +23,8 @@
 """
 Make HVML tags table:
     1. Read 'data/tags.txt' file.
-    5. Generate the hvml-tag-static-list tables (two tables; one for 64bit, the other for 32bit).
-    5. Write code to 'hvml-tag-static-list.inc'.
+    2. Generate the perfect hash of the tag names (see Scripts/PHash.py).
+    3. Write code to 'hvml-tag-static-list.inc' and 'hvml-tag.h'.
 """
 
 import os, sys
@@ -35,6 +35,7 @@ ABS_PATH = os.path.dirname(os.path.abspath(__file__))
 sys.path.append("{}/../Scripts/".format(ABS_PATH))
 
 import LXB
+import PHash
 
 WITHOUT_PRINT = 0
 
@@ -142,58 +143,6 @@ def scan_src_file(fsrc):
 
     return tag_info, cats_info, states_info
 
-FNV_PRIME_64B = 0x100000001b3
-FNV_INIT_64B  = 0xcbf29ce484222325
-
-FNV_PRIME_32B = 0x01000193
-FNV_INIT_32B  = 0x811c9dc5
-
-def str2key_64b (_str):
-
-    _bytes = _str.encode()
-    hval = FNV_INIT_64B;
-
-    for c in _bytes:
-        hval ^= c
-        hval *= FNV_PRIME_64B
-
-    return hval & 0xFFFFFFFFFFFFFFFF
-
-def str2key_32b (_str):
-    _bytes = _str.encode()
-
-    hval = FNV_INIT_32B;
-    for c in _bytes:
-        hval ^= c
-        hval *= FNV_PRIME_32B
-
-    return hval & 0xFFFFFFFF
-
-def calc_hash_degree (tag_info, nr_slots):
-    degrees = []
-    for i in range (0, nr_slots):
-        degrees.append (0)
-
-    min_degree = nr_slots
-    max_degree = 0
-
-    for tag in tag_info:
-        slot_idx = tag_info[tag]['key'] % nr_slots
-        degrees [slot_idx] += 1
-
-    nr_zeros = 0
-    for d in degrees:
-        if d > max_degree:
-            max_degree = d
-        if d < min_degree:
-            min_degree = d
-        if d == 0:
-            nr_zeros += 1
-
-    if not WITHOUT_PRINT:
-        print("%s: min/max hash degree: (%d, %d) / %d; zero slots: %d; %d" % (TOOL_NAME, min_degree, max_degree, nr_slots, nr_zeros, nr_zeros * max_degree))
-    return nr_zeros * max_degree
-
 def make_tag_id(tag_token):
     tag_id = tag_token.upper()
     tag_id = tag_id.replace('-', '_')
@@ -222,57 +171,15 @@ def make_categories_value (categories_list):
 
     return value
 
-def generate_static_tag_table (tag_info, str2key):
-    nr_tags = len (tag_info)
-    for tag in tag_info:
-        tag_info[tag]['key'] = str2key (tag)
-        if not WITHOUT_PRINT:
-            print("%s: key of string %s: 0x%x" % (TOOL_NAME, tag, tag_info[tag]['key'], ))
-
-    min_degree = nr_tags * nr_tags
-    best_slots = 0
-    for nr_slots in range (nr_tags, 2 * nr_tags):
-        d = calc_hash_degree (tag_info, nr_slots)
-        if d < min_degree:
-            min_degree = d
-            best_slots = nr_slots
+def generate_static_tag_table (tag_info):
+    nr_buckets, disps, slots = PHash.generate(list(tag_info.keys()))
 
     if not WITHOUT_PRINT:
-        print("%s: find the best number of slots: %d" % (TOOL_NAME, best_slots))
-
-    tag_table = []
-    for i in range (0, best_slots):
-        tag_table.append ({})
-
-    last_slot = best_slots
-    for tag in tag_info:
-        idx = tag_info[tag]['key'] % best_slots
-        if tag_table[idx]:
-            while tag_table[idx]['next'] and tag_table[idx]['next'] > 0:
-                idx = tag_table[idx]['next']
-            tag_table[idx]['next'] = last_slot
-            tag_table.append ({})
-            tag_table[last_slot]['tag'] = tag
-            tag_table[last_slot]['next'] = 0
-            last_slot += 1
-        else:
-            tag_table[idx]['tag'] = tag
-            tag_table[idx]['next'] = 0
-
-    idx = 0
-    for tag_slot in tag_table:
-        if tag_slot:
-            if not WITHOUT_PRINT:
-                print("%s: slot #%d: %s; next: %d" % (TOOL_NAME, idx, tag_slot['tag'], tag_slot['next']))
-        else:
-            if not WITHOUT_PRINT:
-                print("%s: slot #%d: no tag" % (TOOL_NAME, idx))
+        print("%s: %d tags in %d slots, %d buckets" % (TOOL_NAME, len(tag_info), len(slots), nr_buckets))
 
-        idx += 1
+    return nr_buckets, disps, slots
 
-    return best_slots, tag_table
-
-def write_static_tag_tables (tmpl_file, save_to, tag_info, best_slots_64b, tag_table_64b, best_slots_32b, tag_table_32b):
+def write_static_tag_tables (tmpl_file, save_to, tag_info, nr_buckets, disps, slots):
     lxb_temp = LXB.Temp(tmpl_file, save_to)
 
     buf = []
@@ -284,29 +191,23 @@ def write_static_tag_tables (tmpl_file, save_to, tag_info, best_slots_64b, tag_t
         idx += 1
     lxb_temp.pattern_append("%%PCHVML_TAG_BASE_LIST%%", '\n'.join(buf))
 
-    lxb_temp.pattern_append("%%BEST_SLOTS_64B%%", '{}'.format(best_slots_64b, ))
+    lxb_temp.pattern_append("%%NR_BUCKETS%%", '{}'.format(nr_buckets))
+    lxb_temp.pattern_append("%%NR_SLOTS%%", '{}'.format(len(slots)))
 
     buf = []
-    for tag_slot in tag_table_64b:
-        if tag_slot:
-            key = str2key_64b (tag_slot['tag'])
-            buf.append("   // hash value of this tag: 0x%016x, slot index: %d" % (key, key % best_slots_64b, ))
-            buf.append("   { &pchvml_tag_base_list[%s], %d}," % (make_tag_id (tag_slot['tag']), tag_slot['next'], ))
-        else:
-            buf.append("   { NULL, 0},")
-    lxb_temp.pattern_append("%%PCHVML_TAG_STATIC_LIST_INDEX_64B%%", '\n'.join(buf))
-
-    lxb_temp.pattern_append("%%BEST_SLOTS_32B%%", '{}'.format(best_slots_32b, ))
+    for i in range(0, len(disps), 16):
+        buf.append("    " + " ".join("%d," % d for d in disps[i:i + 16]))
+    lxb_temp.pattern_append("%%PCHVML_TAG_DISPLACEMENTS%%", '\n'.join(buf))
 
     buf = []
-    for tag_slot in tag_table_32b:
-        if tag_slot:
-            key = str2key_32b (tag_slot['tag'])
-            buf.append("   // hash value of this tag: 0x%016x, slot index: %d" % (key, key % best_slots_32b, ))
-            buf.append("   { &pchvml_tag_base_list[%s], %d}," % (make_tag_id (tag_slot['tag']), tag_slot['next'], ))
+    idx = 0
+    for tag in slots:
+        if tag:
+            buf.append("    &pchvml_tag_base_list[%s], // %d" % (make_tag_id (tag), idx))
         else:
-            buf.append("   { NULL, 0},")
-    lxb_temp.pattern_append("%%PCHVML_TAG_STATIC_LIST_INDEX_32B%%", '\n'.join(buf))
+            buf.append("    NULL, // %d" % (idx))
+        idx += 1
+    lxb_temp.pattern_append("%%PCHVML_TAG_SLOTS%%", '\n'.join(buf))
 
     lxb_temp.build()
     lxb_temp.save()
@@ -410,12 +311,8 @@ if __name__ == "__main__":
         print("DONE")
 
     if not WITHOUT_PRINT:
-        print("Generating static tag table for 64bit...")
-    best_slots_64b, tag_table_64b = generate_static_tag_table (tag_info, str2key_64b)
-
-    if not WITHOUT_PRINT:
-        print("Generating static tag table for 32bit...")
-    best_slots_32b, tag_table_32b = generate_static_tag_table (tag_info, str2key_32b)
+        print("Generating static tag table...")
+    nr_buckets, disps, slots = generate_static_tag_table (tag_info)
 
     if not WITHOUT_PRINT:
         print("DONE")
@@ -428,7 +325,7 @@ if __name__ == "__main__":
     if not WITHOUT_PRINT:
         print("Writting HVML static tag table to dst file %s..." % HVMLTAGSTABLE_FILE)
     try:
-        write_static_tag_tables (tmpl, dst, tag_info, best_slots_64b, tag_table_64b, best_slots_32b, tag_table_32b)
+        write_static_tag_tables (tmpl, dst, tag_info, nr_buckets, disps, slots)
     except:
         if not WITHOUT_PRINT:
             print("FAILED")
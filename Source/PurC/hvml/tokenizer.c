@@ -78,22 +78,25 @@
 } while (0)
 
 #define PCHVML_NEXT_TOKEN_BEGIN                                         \
-struct pchvml_token* pchvml_next_token(struct pchvml_parser* parser,    \
+static struct pchvml_token* next_token(struct pchvml_parser* parser,    \
                                           purc_rwstream_t rws)          \
 {                                                                       \
     uint32_t character = 0;                                             \
-    if (parser->token) {                                                \
+    if (parser->token && !parser->is_waiting_input) {                   \
         struct pchvml_token* token = parser->token;                     \
         parser->token = NULL;                                           \
         parser->last_token_type = pchvml_token_get_type(token);         \
         return token;                                                   \
     }                                                                   \
                                                                         \
+    parser->is_waiting_input = 0;                                       \
     tkz_reader_set_rwstream (parser->reader, rws);                 \
                                                                         \
 next_input:                                                             \
     parser->curr_uc = tkz_reader_next_char (parser->reader);       \
     if (!parser->curr_uc) {                                             \
+        /* the partial input is used up; resume in the same state */    \
+        parser->is_waiting_input = 1;                                   \
         return NULL;                                                    \
     }                                                                   \
                                                                         \
@@ -182,9 +185,9 @@ next_state:                                                             \
 
 #define CHECK_TEMPLATE_TAG_AND_SWITCH_STATE(token)                          \
     do {                                                                    \
-        const char* name = pchvml_token_get_name(token);                    \
         if (pchvml_token_is_type(token, PCHVML_TOKEN_START_TAG) &&          \
-                pchvml_parser_is_template_tag(name)) {                      \
+                pchvml_parser_is_template_tag_entry(                        \
+                    pchvml_token_get_tag_entry(token))) {                   \
             parser->state = TKZ_STATE_EJSON_DATA;                           \
         }                                                                   \
     } while (false)
@@ -438,16 +441,30 @@ bool pchvml_parser_is_json_content_tag(const char* name)
             || strcmp(name, "hvml") == 0);
 }
 
+static UNUSED_FUNCTION
+bool pchvml_parser_is_operation_tag_entry(
+        const struct pchvml_tag_entry* entry)
+{
+    return (entry &&
+            (entry->cats & (PCHVML_TAGCAT_TEMPLATE | PCHVML_TAGCAT_VERB)));
+}
+
+static UNUSED_FUNCTION
+bool pchvml_parser_is_template_tag_entry(const struct pchvml_tag_entry* entry)
+{
+    return (entry && (entry->id == PCHVML_TAG_ARCHETYPE
+                || entry->id == PCHVML_TAG_ERROR
+                || entry->id == PCHVML_TAG_EXCEPT));
+}
+
 static UNUSED_FUNCTION
 bool pchvml_parser_is_operation_tag(const char* name)
 {
     if (!name) {
         return false;
     }
-    const struct pchvml_tag_entry* entry = pchvml_tag_static_search(name,
-            strlen(name));
-    return (entry &&
-            (entry->cats & (PCHVML_TAGCAT_TEMPLATE | PCHVML_TAGCAT_VERB)));
+    return pchvml_parser_is_operation_tag_entry(
+            pchvml_tag_static_search(name, strlen(name)));
 }
 
 static UNUSED_FUNCTION
@@ -455,7 +472,9 @@ void pchvml_parser_save_tag_name(struct pchvml_parser* parser)
 {
     if (pchvml_token_is_type (parser->token, PCHVML_TOKEN_START_TAG)) {
         const char* name = pchvml_token_get_name(parser->token);
-        parser->tag_is_operation = pchvml_parser_is_operation_tag(name);
+        parser->tag_entry = pchvml_token_get_tag_entry(parser->token);
+        parser->tag_is_operation =
+            pchvml_parser_is_operation_tag_entry(parser->tag_entry);
         parser->tag_has_raw_attr = pchvml_token_has_raw_attr(parser->token);
         tkz_buffer_reset(parser->tag_name);
         tkz_buffer_append_bytes(parser->tag_name,
@@ -463,6 +482,7 @@ void pchvml_parser_save_tag_name(struct pchvml_parser* parser)
     }
     if (pchvml_token_is_type (parser->token, PCHVML_TOKEN_END_TAG)) {
         tkz_buffer_reset(parser->tag_name);
+        parser->tag_entry = NULL;
         parser->tag_is_operation = false;
         parser->tag_has_raw_attr = false;
     }
@@ -487,8 +507,8 @@ bool pchvml_parser_is_appropriate_tag_name(struct pchvml_parser* parser,
 static UNUSED_FUNCTION
 bool pchvml_parser_is_operation_tag_token (struct pchvml_token* token)
 {
-    const char* name = pchvml_token_get_name(token);
-    return pchvml_parser_is_operation_tag(name);
+    return pchvml_parser_is_operation_tag_entry(
+            pchvml_token_get_tag_entry(token));
 }
 
 static UNUSED_FUNCTION
@@ -520,19 +540,14 @@ bool pchvml_parser_is_preposition_attribute (
 static UNUSED_FUNCTION
 bool pchvml_parser_is_template_tag (const char* name)
 {
-    const struct pchvml_tag_entry* entry = pchvml_tag_static_search(name,
-            strlen(name));
-    bool ret = (entry && (entry->id == PCHVML_TAG_ARCHETYPE
-                || entry->id == PCHVML_TAG_ERROR
-                || entry->id == PCHVML_TAG_EXCEPT));
-    return ret;
+    return pchvml_parser_is_template_tag_entry(
+            pchvml_tag_static_search(name, strlen(name)));
 }
 
 static UNUSED_FUNCTION
 bool pchvml_parser_is_in_template (struct pchvml_parser* parser)
 {
-    const char* name = tkz_buffer_get_bytes(parser->tag_name);
-    return pchvml_parser_is_template_tag(name);
+    return pchvml_parser_is_template_tag_entry(parser->tag_entry);
 }
 
 static UNUSED_FUNCTION
@@ -570,9 +585,7 @@ bool pchvml_parser_is_handle_as_jsonee(struct pchvml_token* token, uint32_t uc)
 static UNUSED_FUNCTION
 bool pchvml_parser_is_in_raw_template (struct pchvml_parser* parser)
 {
-    const char* name = tkz_buffer_get_bytes(parser->tag_name);
-    const struct pchvml_tag_entry* entry = pchvml_tag_static_search(name,
-            strlen(name));
+    const struct pchvml_tag_entry* entry = parser->tag_entry;
     bool template = (entry && (entry->id == PCHVML_TAG_ARCHETYPE
                 || entry->id == PCHVML_TAG_ARCHEDATA
                 || entry->id == PCHVML_TAG_ERROR
@@ -4718,4 +4731,17 @@ END_STATE()
 
 PCHVML_NEXT_TOKEN_END
 
+struct pchvml_token* pchvml_next_token(struct pchvml_parser* parser,
+        purc_rwstream_t rws)
+{
+    if (!parser->vcm_arena) {
+        return next_token(parser, rws);
+    }
+
+    struct pcvcm_arena* old = pcvcm_arena_switch(parser->vcm_arena);
+    struct pchvml_token* token = next_token(parser, rws);
+    pcvcm_arena_switch(old);
+    return token;
+}
+
 
@@ -0,0 +1,70 @@
+/**
+ * @file affinity.h
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The hearder file for the CPU affinity and the NUMA nodes.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef PURC_PRIVATE_AFFINITY_H
+#define PURC_PRIVATE_AFFINITY_H
+
+#include "config.h"
+
+#include "purc-macros.h"
+
+/*
+ * The helpers to place a thread on some CPUs or NUMA nodes (Linux only).
+ * The topology is read from sysfs, and the memory policy is set by the
+ * system call directly, so there is no dependency on libnuma.
+ *
+ * A thread bound to a node before making its heaps gets the pages of them
+ * from the node, for the pages are allocated on the node of the CPU which
+ * touches them first, and the preferred node of the thread is set as well.
+ */
+
+/* the maximal number of the CPUs or the nodes in a list */
+#define PCUTILS_MAX_CPU_LIST    1024
+
+PCA_EXTERN_C_BEGIN
+
+/* parses the list of the CPUs or the nodes like `0-3,8` to @ids;
+   returns the number of the identifiers parsed */
+unsigned pcutils_parse_cpu_list(const char *str, int *ids, unsigned max)
+    WTF_INTERNAL;
+
+/* returns the NUMA node of @cpu, or 0 if it is unknown */
+int pcutils_cpu_node(int cpu) WTF_INTERNAL;
+
+/* returns the NUMA node of the CPU the calling thread is running on */
+int pcutils_current_node(void) WTF_INTERNAL;
+
+/* binds the calling thread to the CPUs in @cpus (like `0-3,8`) which
+   are on the nodes in @nodes (like `1`), and prefers the first node of
+   @nodes for the memory; either can be NULL. The affinity in effect is
+   kept to be restored by pcutils_unbind_thread(). Returns -1 if no CPU
+   is left or the affinity can not be set. */
+int pcutils_bind_thread(const char *cpus, const char *nodes) WTF_INTERNAL;
+
+/* restores the affinity of the calling thread in effect before
+   pcutils_bind_thread(), and the default memory policy */
+void pcutils_unbind_thread(void) WTF_INTERNAL;
+
+PCA_EXTERN_C_END
+
+#endif  /* PURC_PRIVATE_AFFINITY_H */
@@ -28,6 +28,7 @@
 #include "purc-utils.h"
 
 #include <assert.h>
+#include <stdint.h>
 
 enum pcatom_bucket {
     ATOM_BUCKET_FIRST = 0,
@@ -41,9 +42,10 @@ enum pcatom_bucket {
     ATOM_BUCKET_MSG,    /* the message types such as changed, attached, ... */
     ATOM_BUCKET_RDROP,  /* the renderer operations: startSession, load, ... */
     ATOM_BUCKET_DVOBJ,  /* the keywords of DVObjs: all, default, ... */
+    ATOM_BUCKET_OBJKEY, /* the interned keys of objects; never removed */
 
     /* XXX: change this if you add a new atom bucket. */
-    ATOM_BUCKET_LAST = ATOM_BUCKET_RDROP,
+    ATOM_BUCKET_LAST = ATOM_BUCKET_OBJKEY,
 };
 
 /* Make sure ATOM_BUCKET_LAST is less than PURC_ATOM_BUCKETS_NR */
@@ -63,10 +65,49 @@ struct const_str_atom {
     purc_atom_t atom;
 };
 
+#define PCATOM_BITS_NR      (sizeof(purc_atom_t) << 3)
+
+/* the atom of the static string in the slot (@seq - 1) of @bucket */
+#define PCATOM_STATIC(bucket, seq)                                      \
+    (((purc_atom_t)(bucket) << (PCATOM_BITS_NR - PURC_ATOM_BUCKET_BITS)) \
+     | (purc_atom_t)(seq))
+
+/*
+ * The static strings of a bucket, which are made by make-keywords-table.py
+ * at build time, and have the first sequence numbers of the bucket.
+ * They are found by a minimal perfect hash: the string @s is in the slot
+ *
+ *      pcatom_static_hash(seeds[pcatom_static_hash(0, s) % nr_seeds], s)
+ *          % nr_strings
+ *
+ * if it is a static string of the bucket.
+ */
+struct pcatom_static_bucket {
+    const char * const     *strings;
+    const uint16_t         *seeds;
+    uint32_t                nr_strings;
+    uint32_t                nr_seeds;
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif  /* __cplusplus */
 
+/* defined in the generated keywords.inc */
+extern const struct pcatom_static_bucket
+pcatom_static_buckets[PURC_ATOM_BUCKETS_NR];
+
+/* FNV-1a; the same as static_hash() in make-keywords-table.py */
+static inline uint32_t pcatom_static_hash(uint32_t seed, const char *s)
+{
+    uint32_t h = 0x811c9dc5 ^ seed;
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 0x01000193;
+    }
+    return h;
+}
+
 #ifdef __cplusplus
 }
 #endif  /* __cplusplus */
@@ -0,0 +1,110 @@
+/**
+ * @file btree.h
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The hearder file for the B-trees of pointers.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef PURC_PRIVATE_BTREE_H
+#define PURC_PRIVATE_BTREE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * A B-tree of the items (pointers, not NULL) ordered by a comparator, with
+ * up to 15 items in a node. A leaf node takes two cache lines, and has no
+ * link to the child nodes, so a lookup or an in-order walk touches much
+ * less memory than a red-black tree having a node per item. The items are
+ * not copied nor freed, and must be unique by the comparator.
+ *
+ * The tree can be embedded (initialized by pcutils_btree_init()). An
+ * iterator is invalidated by any change of the tree.
+ */
+
+/* enough for 2 * 8^15 items */
+#define PCUTILS_BTREE_MAX_HEIGHT    16
+
+/* compares @item with @key, which is another item or a key given to the
+   lookup functions; like strcmp() */
+typedef int (*pcutils_btree_cmp_f)(const void *item, const void *key,
+        void *ctxt);
+
+struct pcutils_btree_node;
+
+typedef struct pcutils_btree {
+    struct pcutils_btree_node  *root;
+    size_t                      nr_items;
+    int                         height;
+
+    pcutils_btree_cmp_f         cmp;        /* compares two items */
+    void                       *ctxt;
+} pcutils_btree;
+
+typedef struct pcutils_btree_iter {
+    struct pcutils_btree_node  *nodes[PCUTILS_BTREE_MAX_HEIGHT];
+    unsigned short              pos[PCUTILS_BTREE_MAX_HEIGHT];
+    int                         depth;
+} pcutils_btree_iter;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void pcutils_btree_init(pcutils_btree *tree, pcutils_btree_cmp_f cmp,
+        void *ctxt);
+
+/* removes all items, calling @free_fn (can be NULL) for them */
+void pcutils_btree_clear(pcutils_btree *tree,
+        void (*free_fn)(void *item, void *ctxt));
+
+static inline size_t pcutils_btree_size(const pcutils_btree *tree)
+{
+    return tree->nr_items;
+}
+
+/* inserts @item; returns 0 on success, 1 if an equal item exists, or -1
+   for no memory */
+int pcutils_btree_insert(pcutils_btree *tree, void *item);
+
+/* removes the item equal to @item; returns the removed one, or NULL */
+void *pcutils_btree_erase(pcutils_btree *tree, const void *item);
+
+/* returns the item equal to @key by @cmp (the comparator of the tree if
+   NULL), or NULL if not found */
+void *pcutils_btree_find(const pcutils_btree *tree, const void *key,
+        pcutils_btree_cmp_f cmp);
+
+/* returns the first item, or NULL if the tree is empty */
+void *pcutils_btree_first(const pcutils_btree *tree, pcutils_btree_iter *it);
+
+/* returns the first item not less than @key by @cmp (the comparator of the
+   tree if NULL), or greater than @key if @after_equal is true; NULL if no
+   such item */
+void *pcutils_btree_seek(const pcutils_btree *tree, pcutils_btree_iter *it,
+        const void *key, pcutils_btree_cmp_f cmp, bool after_equal);
+
+/* returns the item after the current one of @it, or NULL if no more */
+void *pcutils_btree_next(pcutils_btree_iter *it);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* PURC_PRIVATE_BTREE_H */
@@ -29,6 +29,7 @@
 #include "config.h"
 
 #include "purc-helpers.h"
+#include "private/log.h"
 
 #include <stdlib.h>
 #include <assert.h>
@@ -71,27 +72,27 @@ extern "C" {
 
 #define PC_ENABLE_DEBUG(x)  purc_enable_log(x, true)
 #define PC_ENABLE_SYSLOG(x) purc_enable_log(x?true:false, x)
-#define PC_ERROR(x, ...)    purc_log_error(x, ##__VA_ARGS__)
-#define PC_WARN(x, ...)     purc_log_warn(x, ##__VA_ARGS__)
-#define PC_INFO(x, ...)     purc_log_info(x, ##__VA_ARGS__)
+#define PC_ERROR(x, ...)    PC_LOG(PCLOG_LEVEL_ERROR, x, ##__VA_ARGS__)
+#define PC_WARN(x, ...)     PC_LOG(PCLOG_LEVEL_WARN, x, ##__VA_ARGS__)
+#define PC_INFO(x, ...)     PC_LOG(PCLOG_LEVEL_INFO, x, ##__VA_ARGS__)
 
 #ifndef NDEBUG
 
-#define PC_DEBUG(x, ...)    purc_log_debug(x, ##__VA_ARGS__)
+#define PC_DEBUG(x, ...)    PC_LOG(PCLOG_LEVEL_DEBUG, x, ##__VA_ARGS__)
 
 #define PC_DEBUGX(x, ...)                                                  \
-    purc_log_debug("%s[%d]:%s(): " x "\n",                                 \
+    PC_LOG(PCLOG_LEVEL_DEBUG, "%s[%d]:%s(): " x "\n",                      \
             pcutils_basename(__FILE__), __LINE__, __func__, ##__VA_ARGS__)
 
 #else /* not defined NDEBUG */
 
 #define PC_DEBUG(x, ...)                \
     if (0)                              \
-        purc_log_debug(x, ##__VA_ARGS__)
+        pclog_log(PCLOG_LEVEL_DEBUG, x, ##__VA_ARGS__)
 
 #define PC_DEBUGX(x, ...)                                                   \
     if (0)                                                                  \
-        purc_log_debug("%s[%d]:%s(): " x "\n",                              \
+        pclog_log(PCLOG_LEVEL_DEBUG, "%s[%d]:%s(): " x "\n",                \
                 pcutils_basename(__FILE__), __LINE__, __func__, ##__VA_ARGS__)
 
 #endif /* defined NDEBUG */
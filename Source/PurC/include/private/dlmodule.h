@@ -0,0 +1,56 @@
+/**
+ * @file dlmodule.h
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The hearder file for loading the shared libraries of extensions.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef PURC_PRIVATE_DLMODULE_H
+#define PURC_PRIVATE_DLMODULE_H
+
+#include "config.h"
+
+#include "purc-macros.h"
+
+/*
+ * The shared libraries of the dynamic variant objects and the executors
+ * are searched in the directories given by an environment variable, then
+ * in the system directories:
+ *
+ *  1. the valid directories contained in the environment variable;
+ *  2. /usr/local/lib/purc-<purc-api-version>/
+ *  3. /usr/lib/purc-<purc-api-version>/
+ *  4. /lib/purc-<purc-api-version>/
+ *
+ * The path found is remembered by the process, so the later loadings of
+ * the same library, by any coroutine or instance, open it directly.
+ */
+
+PCA_EXTERN_C_BEGIN
+
+/* opens the library named @prefix@module plus the suffix of the platform
+   (`.so` or `.dylib`) in the directories given by the environment variable
+   @env_name (nullable), then the system directories. Returns the handle
+   to be closed by dlclose(), or NULL with PURC_ERROR_BAD_SYSTEM_CALL. */
+void *pcutils_dlmodule_open(const char *env_name, const char *prefix,
+        const char *module) WTF_INTERNAL;
+
+PCA_EXTERN_C_END
+
+#endif  /* PURC_PRIVATE_DLMODULE_H */
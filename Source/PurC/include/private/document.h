@@ -56,6 +56,11 @@ struct purc_document_ops {
             pcdoc_element_t elem, pcdoc_operation op,
             const char *text, size_t length);
 
+    /* nullable; the text node refers to the bytes of the string variant */
+    pcdoc_text_node_t (*new_shared_text_content)(purc_document_t doc,
+            pcdoc_element_t elem, pcdoc_operation op,
+            purc_variant_t text);
+
     pcdoc_data_node_t (*new_data_content)(purc_document_t doc,
             pcdoc_element_t elem, pcdoc_operation op,
             purc_variant_t data);
@@ -106,6 +111,21 @@ struct purc_document_ops {
     int (*elem_coll_filter)(purc_document_t doc,
             pcdoc_elem_coll_t dst_coll,
             pcdoc_elem_coll_t src_coll, const char *selector);
+
+    /* nullable; makes the nodes of the steps and places them in one go */
+    int (*build_subtree)(purc_document_t doc,
+            pcdoc_element_t elem, pcdoc_operation op,
+            const struct pcdoc_build_step *steps, size_t nr_steps,
+            unsigned opts, purc_rwstream_t markup);
+
+    /* nullable; parses the markup as the content of the element into the
+       steps of build_subtree(), which are kept by the document */
+    const struct pcdoc_build_step *(*parse_steps)(purc_document_t doc,
+            pcdoc_element_t elem, const char *markup, size_t len,
+            size_t *nr_steps);
+
+    /* nullable; drops all nodes and loads the content again */
+    int (*reset)(purc_document_t doc, const char *content, size_t length);
 };
 
 struct purc_document {
@@ -116,11 +136,58 @@ struct purc_document {
     unsigned data_content:1;
     unsigned have_head:1;
     unsigned have_body:1;
+    /* the nodes removed are not freed until the document is destroyed */
+    unsigned transient:1;
     unsigned refc;
+    /* the number of threads to serialize the document; 0 or 1 for none */
+    unsigned nr_serialize_workers;
 
     struct purc_document_ops *ops;
 
     void *impl;
+
+    /* bumped by every mutation; a memoized query is valid in its epoch */
+    uint64_t epoch;
+    /* the estimated bytes of the nodes added after the document was made;
+       not decreased when the nodes are removed */
+    size_t sz_added;
+    /* the results of the queries memoized, allocated on demand */
+    struct pcdoc_memoized_query *memoized;
+    /* the compiled CSS selectors, allocated on demand */
+    struct pcdoc_selector **selectors;
+    /* the ID and class indexes of elements, built by the implementation
+       when a selector can use them first */
+    struct pcdoc_elem_index *index;
+    /* the children of the element accessed by index last time */
+    struct pcdoc_child_cache *child_cache;
+    /* the output of the subtrees serialized last time */
+    struct pchtml_html_serialize_cache *serial_cache;
+    /* the steps parsed from the markups recently, allocated on demand */
+    struct pcdoc_steps_cache *steps_cache;
+};
+
+/* the estimated bytes of a node, besides its tag name or text */
+#define PCDOC_EST_NODE_SIZE         64
+
+/* the texts shorter than this are copied even if they can be shared */
+#define PCDOC_MIN_SHARED_TEXT       64
+
+#define PCDOC_NR_MEMOIZED_QUERIES   16
+#define PCDOC_NR_CACHED_SELECTORS   16
+
+struct pcdoc_selector;
+struct pcdoc_elem_index;
+struct pcdoc_child_cache;
+struct pchtml_html_serialize_cache;
+struct pcdoc_steps_cache;
+struct pcdom_document;
+struct pcdom_element;
+
+struct pcdoc_memoized_query {
+    pcdoc_element_t ancestor;
+    char           *selector;
+    uint64_t        epoch;
+    purc_variant_t  result;
 };
 
 struct pcdoc_elem_coll {
@@ -139,6 +206,51 @@ extern "C" {
 extern struct purc_document_ops _pcdoc_void_ops WTF_INTERNAL;
 extern struct purc_document_ops _pcdoc_plain_ops WTF_INTERNAL;
 extern struct purc_document_ops _pcdoc_html_ops WTF_INTERNAL;
+extern struct purc_document_ops _pcdoc_compact_html_ops WTF_INTERNAL;
+
+/* returns a new reference to the result memoized for the selector in
+   the current epoch of the document, or PURC_VARIANT_INVALID */
+purc_variant_t
+pcdoc_get_memoized_query(purc_document_t doc, pcdoc_element_t ancestor,
+        const char *selector) WTF_INTERNAL;
+
+/* memoizes the result of the query for the current epoch; the result
+   must not be changed since */
+void
+pcdoc_memoize_query(purc_document_t doc, pcdoc_element_t ancestor,
+        const char *selector, purc_variant_t result) WTF_INTERNAL;
+
+/* compiles the CSS selector; returns NULL for a bad or unsupported one */
+struct pcdoc_selector *
+pcdoc_selector_new(const char *selector) WTF_INTERNAL;
+
+void
+pcdoc_selector_delete(struct pcdoc_selector *sel) WTF_INTERNAL;
+
+/* returns the compiled selector cached by the document, which is valid
+   until the next call with another selector */
+struct pcdoc_selector *
+pcdoc_get_selector(purc_document_t doc, const char *selector) WTF_INTERNAL;
+
+void
+pcdoc_release_selectors(purc_document_t doc) WTF_INTERNAL;
+
+/* resolves the names in the selector against the eDOM document; must be
+   called before matching the elements in the document */
+void
+pcdoc_selector_bind_dom(struct pcdoc_selector *sel,
+        struct pcdom_document *dom_doc) WTF_INTERNAL;
+
+bool
+pcdoc_selector_match_dom(struct pcdoc_selector *sel,
+        struct pcdom_element *elem) WTF_INTERNAL;
+
+/* returns the ID or the first class of the rightmost compound selector
+   if the selector has no comma, for the index to find the candidates;
+   NULL if there is no such key */
+const char *
+pcdoc_selector_index_key(struct pcdoc_selector *sel, size_t *len,
+        bool *is_id) WTF_INTERNAL;
 
 #ifdef __cplusplus
 }
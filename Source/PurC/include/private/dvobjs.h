@@ -210,15 +210,50 @@ int pcdvobjs_global_keyword_id(const char *keyword, size_t length);
 bool pcdvobjs_is_valid_timezone(const char *timezone) WTF_INTERNAL;
 bool pcdvobjs_get_current_timezone(char *buff, size_t sz_buff) WTF_INTERNAL;
 
+struct pcdvobjs_tzinfo;
+
+/* get the parsed data of the timezone, which is loaded only once and
+   shared by all threads; return NULL if the timezone is invalid. */
+const struct pcdvobjs_tzinfo *
+pcdvobjs_tzinfo_get(const char *timezone) WTF_INTERNAL;
+
+/* the same as localtime_r(), but in the specified timezone */
+void pcdvobjs_tzinfo_localtime(const struct pcdvobjs_tzinfo *tz,
+        time_t t, struct tm *tm) WTF_INTERNAL;
+
+/* the same as mktime(), but in the specified timezone */
+time_t pcdvobjs_tzinfo_mktime(const struct pcdvobjs_tzinfo *tz,
+        struct tm *tm) WTF_INTERNAL;
+
 struct pcinst;
+struct pcintr_coroutine;
+
+/* set the default attributes of a coroutine exposed by $CRTN */
+bool pcdvobjs_coroutine_init_attrs(struct pcintr_coroutine *cor);
+
+/* check whether the variant is a native entity of $STREAM */
+bool pcdvobjs_is_stream(purc_variant_t v) WTF_INTERNAL;
+
+/* read the stream until the end of file (or it would block), and pass
+   the data chunk by chunk to @consume; return the number of bytes read,
+   or -1 on error. */
+ssize_t pcdvobjs_stream_consume(purc_variant_t v,
+        pcrws_cb_write consume, void *ctxt) WTF_INTERNAL;
 
 struct wildcard_list {
     char * wildcard;
     struct wildcard_list *next;
 };
 
+/* a random number in [0, RAND_MAX], like random() gives */
 int32_t pcdvobjs_get_random(void) WTF_INTERNAL;
 
+/* a random number of 64 bits, from a generator kept per thread */
+uint64_t pcdvobjs_get_random64(void) WTF_INTERNAL;
+
+/* a random number uniformly distributed in [0, @bound) */
+uint64_t pcdvobjs_get_random_below(uint64_t bound) WTF_INTERNAL;
+
 purc_variant_t
 pcdvobjs_make_elements(purc_document_t doc, pcdoc_element_t element);
 
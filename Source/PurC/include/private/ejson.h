@@ -35,8 +35,29 @@
 
 #define PCEJSON_DEFAULT_DEPTH 32
 
+/*
+ * Intern the constant keys of the objects; the objects evaluated from
+ * the same document will share the key variants. Use this flag for
+ * the documents which contain many objects with the same keys.
+ */
+#define PCEJSON_FLAG_INTERN_KEYS    0x0100
+
+/*
+ * Shrink the storage of the small arrays to their members; the arrays
+ * grow as usual when they are changed. Use this flag for the documents
+ * which contain many small records, e.g., `[x, y]` points. Only the
+ * parsers for static eJSON honor this flag.
+ */
+#define PCEJSON_FLAG_COMPACT_ARRAYS 0x0200
+
 struct pcejson;
 
+/*
+ * The callback for the members of the top-level array; return false
+ * to stop parsing.
+ */
+typedef bool (*pcejson_member_cb)(void *ctxt, purc_variant_t member);
+
 #ifdef __cplusplus
 extern "C" {
 #endif  /* __cplusplus */
@@ -62,6 +83,28 @@ void pcejson_reset (struct pcejson* parser, uint32_t depth, uint32_t flags);
 int pcejson_parse (struct pcvcm_node** vcm_tree, struct pcejson** parser,
                    purc_rwstream_t rwstream, uint32_t depth);
 
+/*
+ * Parse static eJSON and make the variant directly, without the VCM tree.
+ * Fails with PURC_ERROR_NOT_SUPPORTED on any dynamic expression.
+ */
+int pcejson_parse_static(purc_variant_t *value, purc_rwstream_t rwstream,
+        uint32_t depth, uint32_t flags) WTF_INTERNAL;
+
+/*
+ * Parse the plain JSON text in memory without decoding the characters.
+ * Returns -1 without setting the error on the first construct which is
+ * not plain JSON; the caller should fall back to the eJSON parser then.
+ */
+int pcejson_parse_plain(purc_variant_t *value, const char *json, size_t len,
+        uint32_t depth, uint32_t flags) WTF_INTERNAL;
+
+/*
+ * Parse a static eJSON array and pass its members to the callback one
+ * by one; a member is released as soon as the callback returns.
+ */
+int pcejson_parse_static_members(purc_rwstream_t rwstream, uint32_t depth,
+        uint32_t flags, pcejson_member_cb on_member, void *ctxt) WTF_INTERNAL;
+
 #ifdef __cplusplus
 }
 #endif  /* __cplusplus */
@@ -91,18 +91,43 @@ struct pcexec_ops {
         pcexec_class_ops           *external_class_ops;
     };
     purc_atom_t                    atom;
+    // PURC_EXEC_FLAG_XXX, for an internal executor only
+    unsigned int                   flags;
 };
 
+// returns the batch operations of an internal executor, or NULL if none
+static inline purc_exec_batch_ops_t
+pcexec_get_batch_ops(pcexec_ops_t ops)
+{
+    if (ops->type == PCEXEC_TYPE_INTERNAL &&
+            (ops->flags & PURC_EXEC_FLAG_BATCH))
+        return (purc_exec_batch_ops_t)ops->internal_ops;
+    return NULL;
+}
+
 int pcexec_register_ops(pcexec_ops_t ops);
 
 int pcexec_get_by_rule(const char *rule, pcexec_ops_t ops);
 
 
+struct pcexecutor_rule_cache;
+
 struct pcexecutor_heap {
     unsigned int       debug_flex:1;
     unsigned int       debug_bison:1;
+
+    // the compiled rules of the builtin executors
+    struct pcexecutor_rule_cache   *rule_cache;
 };
 
+// parses @rule into the zero-initialized @param;
+// returns 0 on success, or sets @err_msg (if any) and returns -1.
+typedef int (*pcexecutor_rule_parser_f)(const char *rule, size_t len,
+        void *param, char **err_msg);
+
+// releases the data of the parsed @param, but not @param itself.
+typedef void (*pcexecutor_rule_releaser_f)(void *param);
+
 // 用于迭代的迭代器
 struct purc_exec_iter {
     size_t                     curr;
@@ -132,6 +157,30 @@ void pcexecutor_get_debug(int *debug_flex, int *debug_bison);
 
 void pcexecutor_inst_reset(struct purc_exec_inst *inst);
 
+// Returns the compiled param of @rule for the executor @name, which is
+// shared by all executor instances using the same rule and must not be
+// changed; call pcexecutor_put_compiled_rule() when it is no longer used.
+void *
+pcexecutor_get_compiled_rule(const char *name, const char *rule,
+        size_t sz_param, pcexecutor_rule_parser_f parser,
+        pcexecutor_rule_releaser_f releaser, char **err_msg);
+
+void pcexecutor_put_compiled_rule(void *param);
+
+void pcexecutor_get_rule_cache_stats(size_t *nr_hits, size_t *nr_misses);
+
+// checks whether @member of an array or a set is chosen by @rule; sets
+// @chosen and returns 0, or returns -1 for a bad rule.
+typedef int (*pcexecutor_member_chooser_f)(const char *rule,
+        purc_variant_t member, bool *chosen);
+
+// Returns the member chooser of the executor of @rule if the executor
+// chooses every member of an array or a set by the member alone, not by
+// its position nor the other members (only FILTER for now); so the result
+// can be maintained member by member. Returns NULL if not.
+pcexecutor_member_chooser_f
+pcexecutor_get_member_chooser(const char *rule);
+
 
 int pcexecutor_register(pcexec_ops_t ops);
 
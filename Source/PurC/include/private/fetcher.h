@@ -42,10 +42,72 @@ enum pcfetcher_request_method {
 #define RESP_CODE_USER_STOP         -1
 #define RESP_CODE_USER_CANCEL       -2
 
+/* The timing of a request in seconds; the phases not happened are zero. */
+struct pcfetcher_timing {
+    /* the DNS lookup, the TCP connecting, and the TLS handshake */
+    double dns;
+    double connect;
+    double tls;
+    /* from the start of the request to the first byte of the response */
+    double ttfb;
+    /* from the first byte to the last byte of the response */
+    double transfer;
+    /* from the start to the end of the request */
+    double total;
+    /* the bytes received for the response */
+    uint64_t sz_received;
+    /* the response was got from the cache */
+    bool cache_hit;
+};
+
 struct pcfetcher_resp_header {
     int ret_code;
     char* mime_type;
     size_t sz_resp;
+    struct pcfetcher_timing timing;
+};
+
+/* The number of the buckets of the histogram of the request durations */
+#define PCFETCHER_NR_TIMING_BUCKETS     16
+
+/* The process-wide statistics of the timing of the requests finished. */
+struct pcfetcher_timing_stats {
+    uint64_t nr_requests;
+    uint64_t nr_cache_hits;
+    uint64_t sz_received;
+    /* the sums of the phases of all requests in seconds */
+    double dns;
+    double connect;
+    double tls;
+    double ttfb;
+    double transfer;
+    double total;
+    /* the bucket i counts the requests taking less than 2^i milliseconds
+       (but not less than 2^(i-1)); the last bucket counts the rest */
+    uint64_t histogram[PCFETCHER_NR_TIMING_BUCKETS];
+};
+
+/* The statistics of the requests handled by the fetcher. */
+struct pcfetcher_stats {
+    /* the maximal number of the requests in flight; 0 for no limit */
+    size_t max_conns;
+    /* the number of the requests in flight */
+    size_t nr_active;
+    /* the number of the async requests waiting for a free connection */
+    size_t nr_queued;
+    /* the peak number of the requests in flight */
+    size_t nr_peak_active;
+    /* the total number of the requests */
+    uint64_t nr_requests;
+    /* the total number of the async requests ever queued */
+    uint64_t nr_queued_requests;
+    /* the total number of the async requests served by another identical
+       request in flight */
+    uint64_t nr_coalesced_requests;
+    /* the number of the fetcher processes; 0 for the local fetcher */
+    size_t nr_processes;
+    /* the times the fetcher processes restarted after they crashed */
+    uint64_t nr_process_restarts;
 };
 
 typedef void (*pcfetcher_response_handler)(
@@ -53,6 +115,17 @@ typedef void (*pcfetcher_response_handler)(
         const struct pcfetcher_resp_header *resp_header,
         purc_rwstream_t resp);
 
+/* The handler called for every chunk of the body received progressively;
+   the chunk is only valid during the call. */
+typedef void (*pcfetcher_progress_handler)(
+        purc_variant_t request_id, void* ctxt,
+        const struct pcfetcher_resp_header *resp_header,
+        const void *chunk, size_t sz_chunk);
+
+/* The handler serving the URLs of a scheme in the process; returns the
+   stream of the body, or NULL with `ret_code` of the header set. */
+typedef purc_rwstream_t (*pcfetcher_scheme_handler)(void *ctxt,
+        const char *url, struct pcfetcher_resp_header *resp_header);
 
 #ifdef __cplusplus
 extern "C" {
@@ -62,6 +135,11 @@ bool pcfetcher_is_init(void);
 
 const char* pcfetcher_set_base_url(const char* base_url);
 
+/* returns the path of the local file (to free) to which @url is resolved
+   against the base URL, or NULL if @url is not a local file, or it is
+   served by a scheme handler in the process. */
+char *pcfetcher_get_local_path(const char *url);
+
 void pcfetcher_cookie_set(const char* domain,
         const char* path, const char* name, const char* content,
         time_t expire_time, bool secure);
@@ -81,6 +159,21 @@ purc_variant_t pcfetcher_request_async(
         pcfetcher_response_handler handler,
         void* ctxt);
 
+/*
+ * The same as pcfetcher_request_async(), but the body of the response is
+ * handed over to @progress chunk by chunk as it arrives instead of being
+ * kept. At last, @handler is called with a NULL stream and `sz_resp` of
+ * the header set to the size of the whole body.
+ */
+purc_variant_t pcfetcher_request_async_progressively(
+        const char* url,
+        enum pcfetcher_request_method method,
+        purc_variant_t params,
+        uint32_t timeout,
+        pcfetcher_response_handler handler,
+        pcfetcher_progress_handler progress,
+        void* ctxt);
+
 purc_rwstream_t pcfetcher_request_sync(
         const char* url,
         enum pcfetcher_request_method method,
@@ -90,8 +183,40 @@ purc_rwstream_t pcfetcher_request_sync(
 
 void pcfetcher_cancel_async(purc_variant_t request);
 
+/*
+ * Registers a handler for the GET requests to the URLs of @scheme, which
+ * are then served in the process without a fetcher; a NULL @handler
+ * unregisters the scheme. `data:` URLs are always decoded in the process.
+ */
+int pcfetcher_register_scheme(const char *scheme,
+        pcfetcher_scheme_handler handler, void *ctxt);
+
+/*
+ * Adds a resource bundled in memory for @url, and registers the scheme of
+ * @url with the handler of the bundle. The data is not copied; it must
+ * be kept until the process exits.
+ */
+int pcfetcher_add_bundle_resource(const char *url,
+        const void *data, size_t sz_data, const char *mime_type);
+
+/*
+ * Loads the vDOM cache bundled for @url of the `bundle:` scheme, and sets
+ * the size of the cache to @length. Returns NULL if there is no cache, or
+ * the cache was made by another version of PurC.
+ */
+purc_vdom_t pcfetcher_bundle_load_vdom(const char *url, size_t *length);
+
 int pcfetcher_check_response(uint32_t timeout_ms);
 
+int pcfetcher_get_stats(struct pcfetcher_stats *stats);
+
+/* Records the timing of a request finished into the statistics. */
+void pcfetcher_record_timing(const struct pcfetcher_timing *timing);
+
+void pcfetcher_get_timing_stats(struct pcfetcher_timing_stats *stats);
+
+void pcfetcher_reset_timing_stats(void);
+
 #ifdef __cplusplus
 }
 #endif  /* __cplusplus */
@@ -43,6 +43,8 @@
 #ifndef PURC_PRIVATE_HASHTABLE_H
 #define PURC_PRIVATE_HASHTABLE_H
 
+#include <stddef.h>
+
 #define PCHASH_OBJECT_KEY_IS_NEW        (1 << 1)
 #define PCHASH_OBJECT_KEY_IS_CONSTANT   (1 << 2)
 
@@ -55,6 +57,9 @@ extern "C" {
 unsigned long pchash_default_char_hash(const void *k);
 unsigned long pchash_perllike_str_hash(const void *k);
 
+/* same as pchash_default_char_hash(), but for the string of @len bytes */
+unsigned long pchash_default_char_hash_len(const void *k, size_t len);
+
 struct pchash_entry;
 
 /**
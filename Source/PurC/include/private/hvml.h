@@ -51,11 +51,15 @@ struct pchvml_parser {
     unsigned int tag_has_raw_attr:1;
     unsigned int enable_log:1;
     unsigned int is_in_file_header:1;
+    /* the partial input is used up, and the token is not finished yet */
+    unsigned int is_waiting_input:1;
 
     struct tkz_uc* curr_uc;
     struct tkz_reader* reader;
     struct tkz_buffer* temp_buffer;
     struct tkz_buffer* tag_name;
+    /* the static tag entry of tag_name, NULL for an unknown tag */
+    const struct pchvml_tag_entry* tag_entry;
     struct tkz_buffer* string_buffer;
     struct pchvml_token* token;
     struct tkz_sbst* sbst;
@@ -64,8 +68,13 @@ struct pchvml_parser {
     struct pcutils_stack* ejson_stack;
     struct pchvml_token* start_tag_token;
 
+    /* the arena the VCM nodes of the tokens come from, if any */
+    struct pcvcm_arena* vcm_arena;
 };
 
+/* allocates the VCM nodes of the tokens from an arena shared with the vDOM */
+#define PCHVML_FLAG_VCM_ARENA       0x0001
+
 #ifdef __cplusplus
 extern "C" {
 #endif  /* __cplusplus */
@@ -82,6 +91,17 @@ struct pchvml_token* pchvml_next_token(struct pchvml_parser* hvml,
 
 void pchvml_switch_to_ejson_state(struct pchvml_parser* parser);
 
+/*
+ * Tells the parser whether the input is partial. If it is, the document is
+ * given in more than one stream, and pchvml_next_token() returns NULL at
+ * the end of a stream with pchvml_is_waiting_input() returning true; call
+ * pchvml_next_token() again with the next stream to continue. Clear the
+ * flag after the last stream to end the document.
+ */
+void pchvml_set_partial_input(struct pchvml_parser* parser, bool partial);
+
+bool pchvml_is_waiting_input(struct pchvml_parser* parser);
+
 int pchvml_parser_get_curr_pos(struct pchvml_parser* parser,
     uint32_t *character, int *line, int *column, int *position);
 
@@ -29,6 +29,7 @@
 
 #include "config.h"
 
+#include "private/list.h"
 #include "private/variant.h"
 #include "private/map.h"
 #include "private/executor.h"
@@ -46,16 +47,29 @@ typedef struct pcmodule *pcmodule_t;
 
 struct pcinst_msg_queue;
 
+/* the allocations counted for the benchmarks; see pcinst_count_alloc() */
+struct pcinst_alloc_counter {
+    uint64_t                nr_allocs;  // the number of the allocations
+    uint64_t                sz_allocs;  // the bytes allocated
+};
+
 typedef int (*module_init_once_f)(void);
 typedef int (*module_init_instance_f)(struct pcinst *curr_inst,
         const purc_instance_extra_info* extra_info);
 typedef void (*module_cleanup_instance_f)(struct pcinst *curr_inst);
 
 struct pcmodule {
+    /* the name in the report of the startup time */
+    const char                *name;
+
     // PURC_HAVE_XXXX if !always
     unsigned int               id;
     unsigned int               module_inited;
 
+    /* the instance initializer is called by the first use of the module,
+       see pcinst_init_module_on_demand(), with no extra information */
+    bool                       on_demand;
+
     module_init_once_f         init_once;
     module_init_instance_f     init_instance;
     module_cleanup_instance_f  cleanup_instance;
@@ -70,9 +84,25 @@ struct pcinst {
     unsigned int            modules;
     unsigned int            modules_inited;
 
+#define PCINST_MAX_MODULES  32
+    /* the modules to initialize on demand, by the indices of them */
+    uint32_t                modules_deferred;
+    /* the microseconds taken by the instance initializers of the modules */
+    uint32_t                module_init_usecs[PCINST_MAX_MODULES];
+    /* the variants made by the initializers, and the memory used by them */
+    size_t                  init_nr_values;
+    size_t                  init_sz_mem;
+
     // flags go here
     unsigned int            enable_remote_fetcher:1;
     unsigned int            is_instmgr:1;
+    /* keep the VCM trees of attributes packed until evaluated */
+    unsigned int            lazy_attr_vcm:1;
+
+    /* the categories of tracing enabled, see private/trace.h */
+    unsigned int            trace_flags;
+    /* the ring buffer of the timeline events; NULL if not recorded */
+    struct pctimeline      *timeline;
 
     char                   *app_name;
     char                   *runner_name;
@@ -86,6 +116,8 @@ struct pcinst {
 #define LOG_FILE_SYSLOG     ((FILE *)-1)
     /* the FILE object for logging (-1: use syslog; NULL: disabled) */
     FILE                   *fp_log;
+    /* the ring buffer of the asynchronous log; NULL if synchronous */
+    struct pclog_ring      *log_ring;
 
     /* data bounden to the current session, e.g, the statbuf of the random
        number generator */
@@ -96,9 +128,43 @@ struct pcinst {
 
     struct pcvarmgr        *variables;
 
+    /* bumped whenever a variable manager of the instance is changed or
+       destroyed; validates the named variables cached by the stacks */
+    unsigned int            vars_stamp;
+
     struct pcrdr_conn      *conn_to_rdr;
+
+    /* the message structures released for reuse, see move-buffer.c */
+    struct list_head        msg_pool;
+    struct purc_msg_pool_stat msg_pool_stat;
+    /* where the messages allocated by the instance are returned to */
+    struct pcinst_msg_home *msg_home;
+
+    /* the tasks of the thread pool submitted by the instance with a done
+       function not called yet, see threadpool.c */
+    struct list_head        tasks;
+
+    /* the runtime counters and histograms, see metrics.c */
+    struct pcinst_metrics  *metrics;
     struct renderer_capabilities *rdr_caps;
 
+    /* the number of attributes whose VCM trees were packed, and the number
+       of them unpacked for evaluation later */
+    size_t                  nr_lazy_attrs;
+    size_t                  nr_lazy_attrs_compiled;
+
+    /* the arena new VCM nodes are allocated from, NULL for the heap */
+    struct pcvcm_arena     *vcm_arena;
+
+    /* the values of the constant VCM subtrees folded, by identifiers */
+    pcutils_map            *vcm_folded;
+
+    /* the statistics of the VCM profiler, NULL if it is not running */
+    struct pcvcm_profile   *vcm_profile;
+
+    /* the counter of the allocations, NULL if no benchmark is counting */
+    struct pcinst_alloc_counter *alloc_counter;
+
     struct pcexecutor_heap *executor_heap;
     struct pcintr_heap     *intr_heap;
     purc_runloop_t          running_loop;
@@ -111,6 +177,15 @@ PCA_EXTERN_C_BEGIN
 
 /* gets the current instance */
 struct pcinst* pcinst_current(void) WTF_INTERNAL;
+
+/* initializes the module for the current instance if it is selected but
+   not initialized yet; returns 0 if it is ready or not selected */
+int pcinst_init_module_on_demand(struct pcmodule *m) WTF_INTERNAL;
+
+/* makes an object of the microseconds taken by the instance initializers
+   of the modules, the sum of them as `total`, and the number of the
+   variants made by them as `values`, the memory used as `memory` */
+purc_variant_t pcinst_make_startup_report(struct pcinst *inst) WTF_INTERNAL;
 pcvarmgr_t pcinst_get_variables(void) WTF_INTERNAL;
 purc_variant_t pcinst_get_variable(const char* name);
 
@@ -120,6 +195,26 @@ pcinst_get_session_variables(const char* name)
     return pcinst_get_variable(name);
 }
 
+/* sets the counter of the allocations made by the current instance
+   afterwards (NULL for none), and returns the old one; the allocations
+   are counted only if the benchmarks are enabled. */
+struct pcinst_alloc_counter *
+pcinst_set_alloc_counter(struct pcinst_alloc_counter *counter) WTF_INTERNAL;
+
+#if ENABLE(BENCHMARKS)
+/* counts an allocation of @sz bytes, e.g., a variant or a message */
+static inline void pcinst_count_alloc(size_t sz)
+{
+    struct pcinst *inst = pcinst_current();
+    if (inst && inst->alloc_counter) {
+        inst->alloc_counter->nr_allocs++;
+        inst->alloc_counter->sz_allocs += sz;
+    }
+}
+#else
+#define pcinst_count_alloc(sz)  do { } while (0)
+#endif
+
 struct pcrdr_msg *pcinst_get_message(void) WTF_INTERNAL;
 void pcinst_put_message(struct pcrdr_msg *msg) WTF_INTERNAL;
 
@@ -38,6 +38,8 @@
 #include "private/list.h"
 #include "private/vdom.h"
 #include "private/timer.h"
+#include "private/variant.h"
+#include "private/ptrmap.h"
 
 #define PCINTR_MOVE_BUFFER_SIZE 64
 
@@ -54,6 +56,7 @@
 #define MSG_TYPE_CORSTATE             "corState"
 #define MSG_TYPE_DESTROY              "destroy"
 #define MSG_TYPE_RDR_STATE            "rdrState"
+#define MSG_TYPE_MEMORY               "memory"
 
 
 #define MSG_SUB_TYPE_TIMEOUT          "timeout"
@@ -66,6 +69,9 @@
 #define MSG_SUB_TYPE_EXITED           "exited"
 #define MSG_SUB_TYPE_PAGE_CLOSED      "pageClosed"
 #define MSG_SUB_TYPE_CONN_LOST        "connLost"
+#define MSG_SUB_TYPE_REQ_FAILED       "reqFailed"
+#define MSG_SUB_TYPE_SOFT_LIMIT       "softLimit"
+#define MSG_SUB_TYPE_COALESCED        "coalesced"
 
 struct pcintr_heap;
 typedef struct pcintr_heap pcintr_heap;
@@ -99,6 +105,9 @@ struct pcintr_cancel {
     struct list_head             node;
 };
 
+struct pcintr_fdmon;
+struct pcintr_profiler;
+
 struct pcintr_heap {
     // owner instance
     struct pcinst        *owner;
@@ -110,6 +119,12 @@ struct pcintr_heap {
     // key as atom, val as struct pcintr_coroutine
     struct rb_root        coroutines;
 
+    // maintained by pcintr_coroutine_set_state():
+    // coroutines in CO_STATE_READY, in the order they became ready
+    struct list_head      ready_coroutines;
+    // coroutines waiting for events (neither ready nor running)
+    struct list_head      waiting_coroutines;
+
     struct list_head      routines;     // struct pcintr_routine
 
     int64_t               next_coroutine_id;
@@ -119,6 +134,33 @@ struct pcintr_heap {
     purc_cond_handler    cond_handler;
     unsigned int         keep_alive:1;
     double               timestamp;
+
+    // the period of idle events in ms, and the number of the observers
+    // of idle events in all coroutines; no idle event if there is none.
+    unsigned int         idle_period;
+    size_t               nr_idle_observers;
+
+    // the monitor waking up the parked scheduler for the renderer connection
+    uintptr_t            rdr_fd_monitor;
+    int                  rdr_fd;
+
+    // the ready coroutines deferred for their DOM operations not sent
+    // because the renderer connection runs out of in-flight credits
+    size_t               nr_credit_waiting;
+
+    // the runner pool this instance works for, and the slot in the pool
+    struct purc_runner_pool *runner_pool;
+    size_t               pool_slot;
+
+    // the epoll backend of fd monitors; NULL for using GLib
+    struct pcintr_fdmon  *fdmon;
+
+    // the sampling profiler; NULL if not enabled
+    struct pcintr_profiler *profiler;
+
+    // the default memory limits of the coroutines; 0 for no limit
+    size_t               crtn_mem_soft_limit;
+    size_t               crtn_mem_hard_limit;
 };
 
 struct pcintr_stack_frame;
@@ -162,11 +204,38 @@ struct pcintr_exception {
     struct pcdebug_backtrace  *bt;
 };
 
+#define PCINTR_NR_CACHED_VARS           16
+#define PCINTR_NR_OBSERVED_NAMES        32
+#define PCINTR_LEN_CACHED_VAR_NAME      23
+
+/*
+ * A named variable found in a variable manager by the frame. It is valid
+ * until the frame is popped or any variable manager of the instance changes,
+ * which is told by the serial number of the frame and the stamp of the
+ * instance.
+ */
+struct pcintr_cached_var {
+    // the serial number of the frame, 0 for an empty slot
+    uint64_t                      frame_serial;
+    struct pcvdom_element        *pos;
+    struct pcvdom_element        *scope;
+    unsigned int                  stamp;
+    // the value borrowed from the variable manager
+    purc_variant_t                value;
+    char                          name[PCINTR_LEN_CACHED_VAR_NAME + 1];
+};
+
 struct pcintr_stack {
     struct list_head              frames;
     // the number of stack frames.
     size_t                        nr_frames;
 
+    // the frames popped and kept for reuse, and the statistics
+    struct list_head              free_frames;
+    size_t                        nr_free_frames;
+    uint64_t                      nr_frame_hits;
+    uint64_t                      nr_frame_misses;
+
     // the pointer to the vDOM tree.
     purc_vdom_t                   vdom;
     purc_document_t               doc;
@@ -186,7 +255,9 @@ struct pcintr_stack {
     uint32_t volatile             last_msg_sent:1;
     uint32_t volatile             last_msg_read:1;
     /* uint32_t                   paused:1; */
-    uint32_t                      observe_idle:1;
+
+    // number of the observers on `$CRTN` for `idle` event
+    uint32_t                      nr_idle_observers;
 
     // error or except info
     // valid only when except == 1
@@ -209,11 +280,36 @@ struct pcintr_stack {
     struct list_head              dynamic_observers;
     struct list_head              native_observers;
 
+    // key: message type atom  val: struct pcintr_observer_bucket
+    pcutils_ptrmap                observer_index;
+
+    // key: observed container  val: struct change_watches (observe.c)
+    pcutils_ptrmap                change_watches;
+
+    // the reactive bindings of the eDOM content (nullable)
+    struct pcintr_reactive       *reactive;
+
+    // the results derived incrementally by the elements (nullable)
+    struct pcintr_derived        *derived;
+
+    // the variables restored from a snapshot not taken yet (nullable)
+    struct pcintr_restored       *restored;
+
     // async request ids (array)
     purc_variant_t                async_request_ids;
 
     // key: vdom_node  val: pcvarmgr_t
     struct rb_root                scoped_variables;
+
+    // the serial number of the last frame pushed
+    uint64_t                      last_frame_serial;
+
+    // the named variables resolved lately, see pcintr_find_named_var()
+    struct pcintr_cached_var      cached_vars[PCINTR_NR_CACHED_VARS];
+
+    // the numbers of the observers of the named variables, counted by the
+    // hash values of the names; see pcintr_get_named_var_for_observed()
+    unsigned int                  nr_named_observers[PCINTR_NR_OBSERVED_NAMES];
 };
 
 enum pcintr_coroutine_stage {
@@ -247,6 +343,17 @@ struct pcintr_coroutine_child {
     purc_atom_t                 cid;
 };
 
+#define PCINTR_DEF_IDLE_PERIOD      100     // ms
+
+/* by default, a ready coroutine yields to others after every step */
+#define PCINTR_DEF_SLICE_STEPS      1
+#define PCINTR_DEF_SLICE_TIME       0
+
+/* builtin variables of a coroutine bound on the first lookup */
+#define PCINTR_LAZY_VAR_CRTN        0x01
+#define PCINTR_LAZY_VAR_T           0x02
+#define PCINTR_LAZY_VAR_TIMERS      0x04
+
 struct pcintr_coroutine {
     pcintr_heap_t               owner;    /* owner heap */
     purc_atom_t                 cid;
@@ -261,8 +368,14 @@ struct pcintr_coroutine {
     uint64_t                    target_dom_handle;
     purc_variant_t              doc_contents;
     purc_variant_t              doc_wrotten_len;
+    /* the DOM operations buffered in the current time slice, or kept
+       for the in-flight credits of the renderer connection */
+    struct list_head            dom_ops;
+    size_t                      nr_dom_ops;
 
     struct rb_node              node;     /* heap::coroutines */
+    struct list_head            ln_sched; /* heap::ready_coroutines or
+                                             heap::waiting_coroutines */
 
     struct list_head            children; /* struct pcintr_coroutine_child */
 
@@ -285,8 +398,23 @@ struct pcintr_coroutine {
     struct pcinst_msg_queue    *mq;     /* message queue */
     struct list_head            tasks;  /* one event with multiple observers */
     struct list_head            event_handlers; /* struct pcintr_event_handler */
+    /* the builtin event handlers allocated in one block */
+    struct pcintr_event_handler *builtin_handlers;
     struct pcintr_event_handler *sleep_handler;
 
+    /* the nanoseconds to sleep after the current step, requested by
+       `$SYS.sleep`, and the timer to wake the coroutine up */
+    uint64_t                    sleep_ns;
+    pcintr_timer_t              sleep_timer;
+
+    /* the asynchronous native methods called by the coroutine and not
+       finished yet, and whether the coroutine yielded for them */
+    unsigned int                nr_asyncs;
+    unsigned int                async_waiting:1;
+
+    /* the builtin variables not bound yet; see PCINTR_LAZY_VAR_XXX */
+    unsigned int                lazy_vars;
+
     /* $CRTN  begin */
     /** The target as a null-terminated string. */
     char                       *target;
@@ -306,8 +434,29 @@ struct pcintr_coroutine {
 
     /** The timeout value for a remote request. */
     struct timespec             timeout;
+
+    /** The maximal number of steps executed in one time slice. */
+    uint64_t                    slice_steps;
+    /** The maximal milliseconds of one time slice; 0 for no limit. */
+    uint64_t                    slice_time;
     /* $CRTN  end */
 
+    /* the memory limits in bytes; 0 for no limit ($CRTN.mem_limits) */
+    size_t                      mem_soft_limit;
+    size_t                      mem_hard_limit;
+    /* whether the `memory:softLimit` event was posted and the usage has
+       not dropped below the soft limit since */
+    unsigned int                mem_soft_notified:1;
+
+    /* the variants charged to the coroutine */
+    struct pcvariant_charge     mem_charge;
+
+    /* the statistics of time slices, maintained by the scheduler */
+    uint64_t                    nr_slices;
+    uint64_t                    nr_steps;
+    uint64_t                    nr_preempted;   /* ended for the budget */
+    double                      max_slice_time; /* in milliseconds */
+
     struct pcintr_timers       *timers;     // $TIMERS
     struct pcvarmgr            *variables;  // coroutine level named variable
 
@@ -361,6 +510,8 @@ struct pcintr_stack_frame {
     enum pcintr_stack_frame_type             type;
     // pointers to sibling frames.
     struct list_head node;
+    // the serial number in the stack, never reused; the frame is recycled.
+    uint64_t serial;
     // the current scope.
     pcvdom_element_t scope;
 
@@ -417,9 +568,26 @@ struct pcintr_dynamic_args {
     purc_dvariant_method           setter;
 };
 
+enum {
+    PCINTR_SUB_TYPE_NONE = 0,   // no sub type
+    PCINTR_SUB_TYPE_LITERAL,    // no metacharacter; matches a substring
+    PCINTR_SUB_TYPE_PREFIX,     // `^` followed by a literal
+    PCINTR_SUB_TYPE_REGEX,      // compiled to sub_type_regex
+    PCINTR_SUB_TYPE_INVALID,    // not a valid regex; matches nothing
+};
+
+enum {
+    PCINTR_OBSERVER_RATE_NONE = 0,  // every event is handled
+    PCINTR_OBSERVER_RATE_THROTTLE,  // at most one event per interval
+    PCINTR_OBSERVER_RATE_DEBOUNCE,  // the last one of a burst of events
+};
+
 struct pcintr_observer {
     struct list_head            node;
 
+    // the node in the bucket of `observer_index` for the message type
+    struct list_head            type_node;
+
     pcintr_stack_t              stack;
     // the observed variant.
     purc_variant_t observed;
@@ -430,6 +598,10 @@ struct pcintr_observer {
     // the sub type of the message observed (cloned from the `for` attribute; nullable).
     char* sub_type;
 
+    // the sub type compiled when registering (see sub_type_kind).
+    struct pcregex *sub_type_regex;
+    size_t sub_type_len;
+
     pcvdom_element_t scope;
     pcdoc_element_t  edom_element;
 
@@ -442,6 +614,27 @@ struct pcintr_observer {
     // callback when revoke observer
     pcintr_on_revoke_observer on_revoke;
     void *on_revoke_data;
+
+    // whether it is an observer on `$CRTN` for `idle` event
+    unsigned int for_idle:1;
+
+    // how the sub type is matched: PCINTR_SUB_TYPE_XXX
+    unsigned int sub_type_kind:3;
+
+    // how the rate of handling the events is bounded: PCINTR_OBSERVER_RATE_XXX
+    unsigned int rate_kind:2;
+
+    // the interval of `throttle` or `debounce` in milliseconds
+    uint32_t rate_ms;
+
+    // when the last event was handled (for throttle)
+    uint64_t last_handled_ms;
+
+    // the event held until the interval elapses; overlaid by a newer one
+    pcintr_timer_t rate_timer;
+    purc_variant_t held_event_name;
+    purc_variant_t held_source;
+    purc_variant_t held_data;
 };
 
 struct pcinst;
@@ -486,6 +679,33 @@ void pcintr_yield(void *ctxt, void (*continuation)(void *ctxt, pcrdr_msg *msg),
         purc_variant_t event_name, bool custom_event_handler);
 void pcintr_resume(pcintr_coroutine_t cor, pcrdr_msg *msg);
 
+/* Requests the running coroutine to sleep for @ns nanoseconds after the
+   current step, so that the other coroutines go on meanwhile. Returns false
+   if there is no running coroutine. */
+bool pcintr_defer_sleep(uint64_t ns);
+
+/* The work of an asynchronous native method; returns NULL on failure. It
+   runs on a worker of the thread pool, so it must not call the APIs of the
+   instance, nor touch the variants not owned by it exclusively. */
+typedef void *(*pcintr_async_work_f)(void *data);
+
+/* Makes the result of an asynchronous native method on the thread of the
+   instance from the result of the work (NULL if it failed or did not run),
+   and releases @data. Returns PURC_VARIANT_INVALID with the error set on
+   failure. */
+typedef purc_variant_t (*pcintr_async_done_f)(void *data, void *result);
+
+/* Calls an asynchronous native method. In a running coroutine, runs @work
+   on the thread pool and returns a pending handle at once; the coroutine
+   yields after the current step until the work is done, and the property
+   `value` of the handle gives the result then. Without a running coroutine,
+   runs @work in place and returns the result of @done. */
+purc_variant_t pcintr_async_call(pcintr_async_work_f work,
+        pcintr_async_done_f done, void *data);
+
+/* Checks whether a variant is a pending handle of an asynchronous method. */
+bool pcintr_is_async_handle(purc_variant_t v);
+
 void
 pcintr_push_stack_frame_pseudo(pcvdom_element_t vdom_element);
 void
@@ -515,6 +735,10 @@ pcintr_unbind_coroutine_variable(purc_coroutine_t cor, const char* name)
     return purc_coroutine_unbind_variable(cor, name);
 }
 
+/* bind the builtin variable `name` if it is not bound yet */
+bool
+pcintr_bind_lazy_variable(purc_coroutine_t cor, const char *name);
+
 static inline purc_variant_t
 pcintr_get_coroutine_variable(purc_coroutine_t cor, const char* name)
 {
@@ -587,6 +811,10 @@ bool
 pcintr_parse_event(const char *event, purc_variant_t *type,
         purc_variant_t *sub_type);
 
+// type:sub_type, without making any variant; returns 0 if the type is unknown
+purc_atom_t
+pcintr_event_type_atom(const char *event, const char **sub_type);
+
 struct pcintr_observer*
 pcintr_register_observer(pcintr_stack_t stack,
         purc_variant_t observed,
@@ -606,6 +834,22 @@ void
 pcintr_revoke_observer_ex(pcintr_stack_t stack, purc_variant_t observed,
         purc_atom_t msg_type_atom, const char *sub_type);
 
+/* bounds the rate of handling the events of @observer; @kind is one of
+   PCINTR_OBSERVER_RATE_XXX, and @ms the interval in milliseconds */
+void
+pcintr_observer_set_rate(struct pcintr_observer *observer, int kind,
+        uint32_t ms);
+
+/* whether the event should be handled now; otherwise, it is held by
+   @observer, and handled when the interval elapses */
+bool
+pcintr_observer_pass_event(struct pcintr_observer *observer,
+        purc_variant_t event_name, purc_variant_t source,
+        purc_variant_t data);
+
+void
+pcintr_observer_release_held(struct pcintr_observer *observer);
+
 bool
 pcintr_load_dynamic_variant(pcintr_coroutine_t cor,
     const char *name, size_t len);
@@ -620,11 +864,23 @@ pcdoc_text_node_t
 pcintr_util_new_text_content(purc_document_t doc, pcdoc_element_t elem,
         pcdoc_operation op, const char *txt, size_t len);
 
+/* same as pcintr_util_new_text_content(), but the text node may refer to
+   the bytes of the string variant instead of a copy */
+pcdoc_text_node_t
+pcintr_util_new_shared_text_content(purc_document_t doc,
+        pcdoc_element_t elem, pcdoc_operation op, purc_variant_t txt);
+
 pcdoc_node
 pcintr_util_new_content(purc_document_t doc,
         pcdoc_element_t elem, pcdoc_operation op,
         const char *content, size_t len);
 
+/* builds a subtree in one call, and updates the renderer in one operation */
+int
+pcintr_util_build_subtree(purc_document_t doc,
+        pcdoc_element_t elem, pcdoc_operation op,
+        const struct pcdoc_build_step *steps, size_t nr_steps);
+
 int
 pcintr_util_set_attribute(purc_document_t doc,
         pcdoc_element_t elem, pcdoc_operation op,
@@ -643,6 +899,66 @@ pcintr_init_vdom_under_stack(pcintr_stack_t stack);
 purc_runloop_t
 pcintr_co_get_runloop(pcintr_coroutine_t co);
 
+/* wake up the scheduler of the instance if it is parked */
+void
+pcintr_wakeup_scheduler(struct pcinst *inst);
+
+/* add a monitor which only wakes up the parked scheduler
+   when the file descriptor becomes readable */
+uintptr_t
+pcintr_add_wakeup_fd_monitor(purc_runloop_t runloop, int fd);
+
+/* the handles of the monitors made by fdmon have this bit set */
+#define PCINTR_FDMON_HANDLE_TAG     ((uintptr_t)0x01)
+
+struct pcintr_fdmon_stat {
+    size_t nr_fds;          /* number of file descriptors monitored */
+    size_t nr_watches;      /* number of monitors */
+    size_t nr_dispatches;   /* number of batches dispatched */
+    size_t nr_events;       /* number of readiness events dispatched */
+    size_t max_batch;       /* maximal number of events in a batch */
+};
+
+/* create the epoll backend of file descriptor monitors on the runloop;
+   returns NULL if it is not supported. */
+struct pcintr_fdmon *
+pcintr_fdmon_create(purc_runloop_t runloop);
+
+void
+pcintr_fdmon_destroy(struct pcintr_fdmon *fdmon);
+
+uintptr_t
+pcintr_fdmon_add(struct pcintr_fdmon *fdmon, int fd,
+        purc_runloop_io_event event, purc_runloop_io_callback callback,
+        void *ctxt);
+
+/* returns false if the handle was not made by the fdmon */
+bool
+pcintr_fdmon_remove(struct pcintr_fdmon *fdmon, uintptr_t handle);
+
+void
+pcintr_fdmon_get_stat(struct pcintr_fdmon *fdmon,
+        struct pcintr_fdmon_stat *stat);
+
+/* the bytes of the memory charged to @co: the variants made by it and
+   the nodes added to its document */
+size_t
+pcintr_coroutine_mem_usage(pcintr_coroutine_t co);
+
+/* create the sampling profiler if it is enabled by the extra information
+   or the environment variables; returns NULL if not enabled. */
+struct pcintr_profiler *
+pcintr_profiler_create(const purc_instance_extra_info *extra_info);
+
+/* take a sample of the HVML stack of @co if it is time to */
+void
+pcintr_profiler_sample(struct pcintr_profiler *profiler, pcintr_coroutine_t co);
+
+/* append the samples to the file, and destroy the profiler */
+void
+pcintr_profiler_destroy(struct pcintr_profiler *profiler,
+        const char *runner_name);
+
 void*
 pcintr_load_module(const char *module,
         const char *env_name, const char *prefix);
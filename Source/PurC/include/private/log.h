@@ -0,0 +1,114 @@
+/*
+ * @file log.h
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The internal interfaces of the log facility.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PURC_PRIVATE_LOG_H
+#define PURC_PRIVATE_LOG_H
+
+#include "config.h"
+
+#include "purc-macros.h"
+
+#include <stdarg.h>
+#include <stdbool.h>
+
+/*
+ * The levels and the modules of the messages logged by the PC_XXX() macros.
+ * Whether a message is wanted is decided by one load of the mask of the
+ * module, before the arguments are evaluated.
+ *
+ * The module of a source file is given by PCLOG_MODULE, which is defined
+ * for the directories of PurC by the build system.
+ */
+
+#define PCLOG_LEVEL_ERROR       0x01
+#define PCLOG_LEVEL_WARN        0x02
+#define PCLOG_LEVEL_INFO        0x04
+#define PCLOG_LEVEL_DEBUG       0x08
+#define PCLOG_LEVEL_ALL         0x0F
+
+enum pclog_module {
+    PCLOG_MODULE_GENERIC = 0,
+    PCLOG_MODULE_INSTANCE,
+    PCLOG_MODULE_UTILS,
+    PCLOG_MODULE_VARIANT,
+    PCLOG_MODULE_HTML,
+    PCLOG_MODULE_DOM,
+    PCLOG_MODULE_DVOBJS,
+    PCLOG_MODULE_VCM,
+    PCLOG_MODULE_EJSON,
+    PCLOG_MODULE_HVML,
+    PCLOG_MODULE_VDOM,
+    PCLOG_MODULE_EXECUTORS,
+    PCLOG_MODULE_INTERPRETER,
+    PCLOG_MODULE_FETCHERS,
+    PCLOG_MODULE_PCRDR,
+    PCLOG_MODULE_DOCUMENT,
+
+    PCLOG_MODULE_NR,
+};
+
+#ifndef PCLOG_MODULE
+#   define PCLOG_MODULE         PCLOG_MODULE_GENERIC
+#endif
+
+PCA_EXTERN_C_BEGIN
+
+/* The masks of the levels enabled for the modules; only changed by
+   pclog_set_levels(), normally once by the environment variables
+   PURC_LOG_LEVELS and PURC_LOG_MODULES when PurC is initialized. */
+extern unsigned int pclog_masks[PCLOG_MODULE_NR];
+
+static inline bool pclog_is_enabled(int module, unsigned int level)
+{
+    return (pclog_masks[module] & level) != 0;
+}
+
+/* sets the levels enabled for @module, or all modules if @module is -1 */
+void pclog_set_levels(int module, unsigned int levels) WTF_INTERNAL;
+
+/* Logs a message without checking the level. The message goes to the log
+   of the current instance; it is formatted later by the thread of the
+   log facility if the log is asynchronous, see log.c. */
+void pclog_log(unsigned int level, const char *fmt, ...)
+    PCA_ATTRIBUTE_PRINTF(2, 3);
+
+void pclog_vlog(unsigned int level, const char *tag, const char *fmt,
+        va_list ap) PCA_ATTRIBUTE_PRINTF(3, 0);
+
+struct pcinst;
+
+/* writes out the messages of @inst not written yet, and makes the log of
+   @inst synchronous */
+void pclog_cleanup_instance(struct pcinst *inst) WTF_INTERNAL;
+
+PCA_EXTERN_C_END
+
+#define PC_LOG(level, x, ...)                                           \
+    do {                                                                \
+        if (pclog_is_enabled(PCLOG_MODULE, level))                      \
+            pclog_log(level, x, ##__VA_ARGS__);                         \
+    } while (0)
+
+#endif /* not defined PURC_PRIVATE_LOG_H */
+
@@ -0,0 +1,120 @@
+/*
+ * @file metrics.h
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The runtime counters and histograms of the instances.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PURC_PRIVATE_METRICS_H
+#define PURC_PRIVATE_METRICS_H
+
+#include "purc.h"
+
+#include "config.h"
+
+#include <time.h>
+
+/*
+ * Every instance has its own metrics, which are only updated by the thread
+ * of the instance, so an update is a plain store; they are readable from
+ * any thread, e.g. by the instance manager aggregating all of them.
+ */
+
+enum pcinst_metric_counter {
+    PCINST_METRIC_COROUTINES_CREATED = 0,
+    PCINST_METRIC_COROUTINES_EXITED,
+    /* the rounds of pcintr_schedule() having something done or not */
+    PCINST_METRIC_SCHED_BUSY_TICKS,
+    PCINST_METRIC_SCHED_IDLE_TICKS,
+    /* the messages appended to the message queues by the instance */
+    PCINST_METRIC_MSGS_ENQUEUED,
+    PCINST_METRIC_VCM_EVALS,
+
+    PCINST_METRIC_NR_COUNTERS,
+};
+
+enum pcinst_metric_gauge {
+    /* the peak number of the pending messages of a coroutine */
+    PCINST_METRIC_PEAK_QUEUE_DEPTH = 0,
+
+    PCINST_METRIC_NR_GAUGES,
+};
+
+enum pcinst_metric_histogram {
+    /* the time taken by pcinst_msg_queue_append() */
+    PCINST_METRIC_ENQUEUE_LATENCY = 0,
+    /* the time of a request to the renderer until the response */
+    PCINST_METRIC_RDR_RTT,
+    /* the time of a fetcher request until the response */
+    PCINST_METRIC_FETCH_LATENCY,
+
+    PCINST_METRIC_NR_HISTOGRAMS,
+};
+
+/* the bucket i counts the durations less than 2^i microseconds (but not less
+   than 2^(i-1)); the last bucket counts the rest */
+#define PCINST_METRIC_NR_BUCKETS    24
+
+struct pcinst;
+
+PCA_EXTERN_C_BEGIN
+
+/* the monotonic time in nanoseconds, for the durations to record */
+static inline uint64_t pcinst_metrics_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* The following ones do nothing if @inst is NULL. */
+
+void pcinst_metrics_count(struct pcinst *inst,
+        enum pcinst_metric_counter counter, uint64_t n) WTF_INTERNAL;
+
+/* raises the gauge to @value if it is less */
+void pcinst_metrics_peak(struct pcinst *inst,
+        enum pcinst_metric_gauge gauge, uint64_t value) WTF_INTERNAL;
+
+/* records a duration of @ns nanoseconds */
+void pcinst_metrics_record_ns(struct pcinst *inst,
+        enum pcinst_metric_histogram histogram, uint64_t ns) WTF_INTERNAL;
+
+/* records a duration started at @since, given by pcinst_metrics_now() */
+static inline void pcinst_metrics_record(struct pcinst *inst,
+        enum pcinst_metric_histogram histogram, uint64_t since)
+{
+    uint64_t now = pcinst_metrics_now();
+    pcinst_metrics_record_ns(inst, histogram, now > since ? now - since : 0);
+}
+
+void pcinst_metrics_reset(struct pcinst *inst) WTF_INTERNAL;
+
+/* makes an object of the metrics of @inst */
+purc_variant_t pcinst_metrics_make_variant(struct pcinst *inst) WTF_INTERNAL;
+
+/* makes an object of the sums of the metrics of all the instances alive or
+   gone, with the number of the instances alive as `instances` */
+purc_variant_t pcinst_metrics_make_aggregated_variant(void) WTF_INTERNAL;
+
+PCA_EXTERN_C_END
+
+#endif /* not defined PURC_PRIVATE_METRICS_H */
+
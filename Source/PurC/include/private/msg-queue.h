@@ -44,15 +44,41 @@ struct pcinst_msg_hdr {
     struct list_head        ln;
 };
 
+enum {
+    MSG_CLASS_RES = 0,
+    MSG_CLASS_REQ,
+    MSG_CLASS_EVENT,
+    MSG_CLASS_VOID,
+    NR_MSG_CLASSES,
+};
+
+/*
+ * A message queue has one consumer, the instance owning it, and may have
+ * many producers. A producer pushes a message onto the lock-free inbox of
+ * its class, which is a stack linked by `ln.next`; the consumer takes all
+ * the messages in an inbox by one exchange, and moves them to the list of
+ * the class in the order they were pushed. The lists, the event index and
+ * the reduction of events are only touched by the consumer.
+ */
 struct pcinst_msg_queue {
-    struct purc_rwlock  lock;
+    struct pcinst_msg_hdr * _Atomic inboxes[NR_MSG_CLASSES];
+
     struct list_head    req_msgs;
     struct list_head    res_msgs;
     struct list_head    event_msgs;
     struct list_head    void_msgs;
 
-    uint64_t            state;
-    size_t              nr_msgs;
+    // the MSG_QS_XXX bits of the inboxes which may not be empty
+    atomic_uint_fast64_t state;
+    // the messages in the inboxes and the lists
+    atomic_size_t       nr_msgs;
+
+    // the pending events indexed by their target, target value, name and
+    // element value; see msg-queue.c. NULL if the index could not be kept.
+    struct pchash_table *event_index;
+
+    // the instance consuming the messages; woken up by the producers
+    struct pcinst       *owner;
 };
 
 /* Make sure the size of `struct list_head` is two times of sizeof(void *) */
@@ -75,12 +101,26 @@ pcinst_msg_queue_destroy(struct pcinst_msg_queue *queue);
 int
 pcinst_msg_queue_append(struct pcinst_msg_queue *queue, pcrdr_msg *msg);
 
+/* the following ones are only called by the consumer of the queue */
+
 int
 pcinst_msg_queue_prepend(struct pcinst_msg_queue *queue, pcrdr_msg *msg);
 
 pcrdr_msg *
 pcinst_msg_queue_get_msg(struct pcinst_msg_queue *queue);
 
+/* takes all pending messages into @msgs at once, in the same order
+   as calling pcinst_msg_queue_get_msg() repeatedly; returns the number of
+   messages taken. */
+size_t
+pcinst_msg_queue_take_msgs(struct pcinst_msg_queue *queue,
+        struct list_head *msgs);
+
+/* puts the messages taken but not handled back to the heads of the queue */
+void
+pcinst_msg_queue_put_back_msgs(struct pcinst_msg_queue *queue,
+        struct list_head *msgs);
+
 pcrdr_msg *
 pcinst_msg_queue_get_event_by_element(struct pcinst_msg_queue *queue,
         purc_variant_t request_id, purc_variant_t element_value,
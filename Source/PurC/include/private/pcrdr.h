@@ -30,6 +30,8 @@
 #include "instance.h"
 #include "atom-buckets.h"
 
+#include <string.h>
+
 #define PCRDR_TIME_DEF_EXPECTED         5
 
 /* the capabilities of a renderer */
@@ -60,6 +62,13 @@ struct renderer_capabilities {
        0 for not supported, -1 for unlimited */
     long int    plainWindow;
 
+    /* the max number of DOM operations in one `batchOperations` request;
+       0 for not supported */
+    long int    batchOperations;
+
+    /* the version of the binary framing if supported, else 0 */
+    long int    binaryFraming;
+
     /* the session handle */
     uint64_t    session_handle;
     /* the default workspace handle */
@@ -76,6 +85,22 @@ pcrdr_parse_renderer_capabilities(const char *data) WTF_INTERNAL;
 void pcrdr_release_renderer_capabilities(
         struct renderer_capabilities *rdr_caps) WTF_INTERNAL;
 
+/* the magic and the version of the binary framing */
+#define PCRDR_BINARY_MAGIC          "\0PCM"
+#define PCRDR_LEN_BINARY_MAGIC      4
+#define PCRDR_BINARY_VERSION        1
+
+static inline bool
+pcrdr_is_binary_packet(const char *packet, size_t sz_packet)
+{
+    return sz_packet > PCRDR_LEN_BINARY_MAGIC &&
+        memcmp(packet, PCRDR_BINARY_MAGIC, PCRDR_LEN_BINARY_MAGIC) == 0;
+}
+
+/* parses a packet in the binary framing */
+int pcrdr_parse_packet_binary(const char *packet, size_t sz_packet,
+        pcrdr_msg **msg_out) WTF_INTERNAL;
+
 static inline purc_atom_t
 pcrdr_check_operation(const char *op)
 {
@@ -0,0 +1,59 @@
+/*
+ * @file phash.h
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The perfect hash of static names generated by Scripts/PHash.py.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PURC_PRIVATE_PHASH_H
+#define PURC_PRIVATE_PHASH_H
+
+#include "config.h"
+#include "purc-utils.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define PCUTILS_PHASH_FNV_PRIME     0x01000193U
+#define PCUTILS_PHASH_FNV_INIT      0x811c9dc5U
+
+/* the FNV-1a hash value of the name in lower case */
+static inline uint32_t
+pcutils_phash_name(const char *name, size_t length)
+{
+    uint32_t v = PCUTILS_PHASH_FNV_INIT;
+    for (size_t i = 0; i < length; i++) {
+        v ^= (unsigned char)purc_tolower(name[i]);
+        v *= PCUTILS_PHASH_FNV_PRIME;
+    }
+
+    return v;
+}
+
+/* the slot of a name by its hash value and the displacement table */
+static inline size_t
+pcutils_phash_slot(uint32_t v, const uint8_t *disps, size_t nr_buckets,
+        size_t nr_slots)
+{
+    uint32_t d = disps[v % nr_buckets];
+    return (uint32_t)(v + d * ((v >> 16) | 1)) % nr_slots;
+}
+
+#endif /* PURC_PRIVATE_PHASH_H */
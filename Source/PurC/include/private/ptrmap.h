@@ -0,0 +1,96 @@
+/**
+ * @file ptrmap.h
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The hearder file for the maps keyed by pointers.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef PURC_PRIVATE_PTRMAP_H
+#define PURC_PRIVATE_PTRMAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * A map from the pointers (not NULL) to the pointers, which copies and
+ * frees nothing. Up to PCUTILS_PTRMAP_NR_INLINE entries are stored in the
+ * map itself and searched linearly; more entries are stored in an
+ * open-addressing hash table of a power-of-two size.
+ *
+ * The map can be embedded (initialized by pcutils_ptrmap_init() or zeroed)
+ * or created by pcutils_ptrmap_create(). It must not be changed while being
+ * iterated by pcutils_ptrmap_next().
+ */
+
+#define PCUTILS_PTRMAP_NR_INLINE    4
+
+struct pcutils_ptrmap_entry {
+    void           *key;
+    void           *val;
+};
+
+typedef struct pcutils_ptrmap {
+    size_t          nr_entries;
+    size_t          nr_slots;   /* 0 if the inline entries are used */
+    size_t          nr_used;    /* the slots used, including the removed */
+
+    union {
+        struct pcutils_ptrmap_entry  inlined[PCUTILS_PTRMAP_NR_INLINE];
+        struct pcutils_ptrmap_entry *slots;
+    };
+} pcutils_ptrmap;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void pcutils_ptrmap_init(pcutils_ptrmap *map);
+
+/* removes all entries and frees the hash table */
+void pcutils_ptrmap_clear(pcutils_ptrmap *map);
+
+pcutils_ptrmap *pcutils_ptrmap_create(void);
+void pcutils_ptrmap_destroy(pcutils_ptrmap *map);
+
+static inline size_t pcutils_ptrmap_size(const pcutils_ptrmap *map)
+{
+    return map->nr_entries;
+}
+
+/* returns the entry of @key, or NULL if not found */
+struct pcutils_ptrmap_entry *
+pcutils_ptrmap_find(pcutils_ptrmap *map, const void *key);
+
+/* sets the value of @key, replacing the old one; returns 0 on success,
+   or -1 for no memory */
+int pcutils_ptrmap_set(pcutils_ptrmap *map, const void *key, void *val);
+
+/* removes the entry of @key; returns false if not found */
+bool pcutils_ptrmap_erase(pcutils_ptrmap *map, const void *key);
+
+/* returns the entry after the position @pos (0 for the first one) and
+   advances @pos, or NULL if no more */
+struct pcutils_ptrmap_entry *
+pcutils_ptrmap_next(pcutils_ptrmap *map, size_t *pos);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* PURC_PRIVATE_PTRMAP_H */
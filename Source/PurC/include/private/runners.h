@@ -54,9 +54,13 @@ enum {
 #define PCRUN_OPERATION_resumeCoroutine     "resumeCoroutine"
     PCRUN_K_OPERATION_shutdownInstance,
 #define PCRUN_OPERATION_shutdownInstance    "shutdownInstance"
+    PCRUN_K_OPERATION_attachRunnerPool,
+#define PCRUN_OPERATION_attachRunnerPool    "attachRunnerPool"
+    PCRUN_K_OPERATION_getMetrics,
+#define PCRUN_OPERATION_getMetrics          "getMetrics"
 
     /* XXX: change this when you append a new operation */
-    PCRUN_K_OPERATION_LAST = PCRUN_K_OPERATION_shutdownInstance,
+    PCRUN_K_OPERATION_LAST = PCRUN_K_OPERATION_getMetrics,
 };
 
 #define PCRUN_NR_OPERATIONS \
@@ -70,6 +74,8 @@ struct instmgr_info {
     struct sorted_array *sa_insts;
 };
 
+struct pcinst;
+
 PCA_EXTERN_C_BEGIN
 
 pcrdr_msg *
@@ -86,9 +92,27 @@ pcrun_create_inst_thread(const char *app_name, const char *runner_name,
 void
 pcrun_instmgr_handle_message(void *ctxt) WTF_INTERNAL;
 
+/* spawns a thread to wait in the pool of instances if it is not full */
+void
+pcrun_fill_inst_pool(void) WTF_INTERNAL;
+
 void
 pcrun_notify_instmgr(const char* event, purc_atom_t inst_crtn_id) WTF_INTERNAL;
 
+/* handles the `attachRunnerPool` request in a worker instance */
+void
+pcrun_attach_runner_pool(const pcrdr_msg *msg,
+        pcrdr_msg *response) WTF_INTERNAL;
+
+/* called when the worker instance is cleaning up */
+void
+pcrun_detach_runner_pool(struct pcinst *inst) WTF_INTERNAL;
+
+/* takes a job from the runner pool and schedules it as a new coroutine;
+   returns true if a job was scheduled. */
+bool
+pcrun_runner_pool_schedule_next(struct pcinst *inst) WTF_INTERNAL;
+
 PCA_EXTERN_C_END
 
 #endif /* not defined PURC_PRIVATE_RUNNERS_H */
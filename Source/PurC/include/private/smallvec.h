@@ -0,0 +1,131 @@
+/**
+ * @file smallvec.h
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The hearder file for the vectors with inline slots.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef PURC_PRIVATE_SMALLVEC_H
+#define PURC_PRIVATE_SMALLVEC_H
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * PCUTILS_SMALLVEC_DEFINE(name, type, nr_inline) defines `struct name`,
+ * a vector of @type which keeps the first @nr_inline elements in itself,
+ * so a vector living on the stack or embedded in another structure does
+ * not allocate anything until it grows beyond them; and the functions
+ * name_init(), name_reserve(), name_push(), name_data(), name_size(),
+ * name_at(), and name_clear(). The vector can be copied by value only
+ * when the inline slots are used (name_is_inline()).
+ *
+ *      PCUTILS_SMALLVEC_DEFINE(keyvec, const char *, 8);
+ *
+ *      struct keyvec keys;
+ *      keyvec_init(&keys);
+ *      if (keyvec_push(&keys, "foo"))
+ *          ...     // no memory
+ *      keyvec_clear(&keys);
+ */
+
+/* grows the slots to hold @min elements at least; returns -1 if no memory */
+static inline int
+pcutils_smallvec_grow(void **heap, const void *inlined, size_t *sz,
+        size_t nr, size_t min, size_t elem_sz)
+{
+    size_t new_sz = *sz * 2;
+    if (new_sz < min)
+        new_sz = min;
+
+    void *slots;
+    if (*heap) {
+        slots = realloc(*heap, new_sz * elem_sz);
+    }
+    else if ((slots = malloc(new_sz * elem_sz))) {
+        memcpy(slots, inlined, nr * elem_sz);
+    }
+
+    if (slots == NULL)
+        return -1;
+
+    *heap = slots;
+    *sz = new_sz;
+    return 0;
+}
+
+#define PCUTILS_SMALLVEC_DEFINE(name, type, nr_inline)                  \
+    struct name {                                                       \
+        type       *heap;       /* NULL if the inline slots are used */ \
+        size_t      nr;                                                 \
+        size_t      sz;                                                 \
+        type        inlined[nr_inline];                                 \
+    };                                                                  \
+                                                                        \
+    static inline void name##_init(struct name *v)                     \
+    {                                                                   \
+        v->heap = NULL;                                                 \
+        v->nr = 0;                                                      \
+        v->sz = nr_inline;                                              \
+    }                                                                   \
+                                                                        \
+    static inline int name##_is_inline(const struct name *v)           \
+    {                                                                   \
+        return v->heap == NULL;                                         \
+    }                                                                   \
+                                                                        \
+    static inline type *name##_data(struct name *v)                    \
+    {                                                                   \
+        return v->heap ? v->heap : v->inlined;                          \
+    }                                                                   \
+                                                                        \
+    static inline size_t name##_size(const struct name *v)             \
+    {                                                                   \
+        return v->nr;                                                   \
+    }                                                                   \
+                                                                        \
+    static inline type *name##_at(struct name *v, size_t i)            \
+    {                                                                   \
+        return name##_data(v) + i;                                      \
+    }                                                                   \
+                                                                        \
+    static inline int name##_reserve(struct name *v, size_t n)         \
+    {                                                                   \
+        if (n <= v->sz)                                                 \
+            return 0;                                                   \
+        return pcutils_smallvec_grow((void **)&v->heap, v->inlined,     \
+                &v->sz, v->nr, n, sizeof(type));                        \
+    }                                                                   \
+                                                                        \
+    static inline int name##_push(struct name *v, type elem)           \
+    {                                                                   \
+        if (v->nr == v->sz && name##_reserve(v, v->nr + 1))             \
+            return -1;                                                  \
+        name##_data(v)[v->nr++] = elem;                                 \
+        return 0;                                                       \
+    }                                                                   \
+                                                                        \
+    static inline void name##_clear(struct name *v)                    \
+    {                                                                   \
+        free(v->heap);                                                  \
+        name##_init(v);                                                 \
+    }                                                                   \
+    struct name
+
+#endif  /* PURC_PRIVATE_SMALLVEC_H */
@@ -0,0 +1,99 @@
+/**
+ * @file threadpool.h
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The hearder file for the thread pool of the CPU-bound tasks.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef PURC_PRIVATE_THREADPOOL_H
+#define PURC_PRIVATE_THREADPOOL_H
+
+#include "config.h"
+
+#include "purc-macros.h"
+
+#include <stdbool.h>
+
+/*
+ * A thread pool shared by all instances of the process to offload the
+ * CPU-bound work, such as sorting or serializing a large container. The
+ * tasks must not call the APIs of an instance, nor touch the variants
+ * not owned by them exclusively.
+ *
+ * Every worker has its own deque: the tasks submitted by a worker are
+ * pushed to its own deque, and the ones submitted by other threads to the
+ * shared queue; an idle worker steals the oldest task of the other ones.
+ * A thread waiting for a task runs the queued tasks meanwhile, so the
+ * tasks can wait for the sub-tasks they submitted.
+ *
+ * The workers are started by the first submission. The number of them and
+ * the CPUs they run on are given by the first instance initialized, see
+ * `nr_pool_workers` and `pool_cpu_affinity` of purc_instance_extra_info.
+ */
+
+typedef struct pcutils_task pcutils_task;
+
+typedef void *(*pcutils_task_func)(void *arg);
+
+/* called with the result of the task when it is finished */
+typedef void (*pcutils_task_done_func)(pcutils_task *task, void *result,
+        void *ctxt);
+
+PCA_EXTERN_C_BEGIN
+
+/* sets the number of the workers (0 for the number of CPUs online minus
+   one) and the CPUs (like `0-3,8`; NULL for no affinity) they run on;
+   returns -1 if the workers have been started */
+int pcutils_threadpool_configure(unsigned nr_workers, const char *cpus)
+    WTF_INTERNAL;
+
+/* returns the number of the workers configured */
+unsigned pcutils_threadpool_nr_workers(void) WTF_INTERNAL;
+
+/* waits for all tasks, then stops the workers; they will be started again
+   by next submission */
+void pcutils_threadpool_shutdown(void) WTF_INTERNAL;
+
+/* submits a task calling @func with @arg on a worker; returns NULL for no
+   memory. The task must be released by pcutils_task_release(). */
+pcutils_task *pcutils_task_submit(pcutils_task_func func, void *arg)
+    WTF_INTERNAL;
+
+/* submits a task whose @done will be called on the run loop of the
+   current instance when finished, or on the worker if there is no
+   instance. The done functions not called yet are dropped when
+   the instance is cleaned up, after the tasks are canceled or finished. */
+pcutils_task *pcutils_task_submit_ex(pcutils_task_func func, void *arg,
+        pcutils_task_done_func done, void *ctxt) WTF_INTERNAL;
+
+/* returns true if the task is finished or canceled */
+bool pcutils_task_is_done(pcutils_task *task) WTF_INTERNAL;
+
+/* waits for the task, and returns its result (NULL if canceled) */
+void *pcutils_task_wait(pcutils_task *task) WTF_INTERNAL;
+
+/* cancels the task if it does not start yet; returns false if not */
+bool pcutils_task_cancel(pcutils_task *task) WTF_INTERNAL;
+
+/* releases the task; a task not finished goes on */
+void pcutils_task_release(pcutils_task *task) WTF_INTERNAL;
+
+PCA_EXTERN_C_END
+
+#endif  /* PURC_PRIVATE_THREADPOOL_H */
@@ -43,7 +43,6 @@
 
 struct tkz_reader;
 struct tkz_uc {
-    struct list_head list;
     uint32_t character;
     int line;
     int column;
@@ -246,6 +245,10 @@ struct tkz_reader *tkz_reader_new(void);
 
 void tkz_reader_set_rwstream(struct tkz_reader *reader, purc_rwstream_t rws);
 
+/* the input will be given in more than one stream if partial is true, and
+   tkz_reader_next_char() returns NULL at the end of a stream. */
+void tkz_reader_set_partial_input(struct tkz_reader *reader, bool partial);
+
 struct tkz_uc *tkz_reader_next_char(struct tkz_reader *reader);
 
 bool tkz_reader_reconsume_last_char(struct tkz_reader *reader);
@@ -0,0 +1,161 @@
+/*
+ * @file trace.h
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The tracing facility shared by the modules of PurC.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PURC_PRIVATE_TRACE_H
+#define PURC_PRIVATE_TRACE_H
+
+#include "config.h"
+#include "purc-helpers.h"
+
+#include "private/instance.h"
+#include "private/metrics.h"
+
+#include <stdbool.h>
+
+/* the categories of tracing */
+#define PC_TRACE_VCM            0x0001
+#define PC_TRACE_HVML           0x0002
+#define PC_TRACE_EJSON          0x0004
+
+#define PC_TRACE_ALL            \
+    (PC_TRACE_VCM | PC_TRACE_HVML | PC_TRACE_EJSON)
+
+/*
+ * The categories are set from environment variables once when the instance
+ * is initialized, and can be changed by `$RUNNER.trace` later. The call sites
+ * vanish when the build option ENABLE_TRACE is off.
+ */
+#if ENABLE(TRACE)
+
+static inline bool pctrace_enabled(unsigned int categories)
+{
+    struct pcinst *inst = pcinst_current();
+    return UNLIKELY(inst && (inst->trace_flags & categories));
+}
+
+#else /* ENABLE(TRACE) */
+
+#define pctrace_enabled(categories)     false
+
+#endif /* !ENABLE(TRACE) */
+
+#define PC_TRACE(categories, x, ...)                    \
+    do {                                                \
+        if (pctrace_enabled(categories))                \
+            purc_log_debug(x, ##__VA_ARGS__);           \
+    } while (0)
+
+/*
+ * The timeline of an instance keeps the latest events in a ring buffer, and
+ * writes them in the Trace Event Format when the instance is cleaned up.
+ * The names and the arguments are copied (and truncated), so they can be
+ * transient; the categories must be static strings.
+ */
+#define PC_TIMELINE_ELEMENT     "element"
+#define PC_TIMELINE_COROUTINE   "coroutine"
+#define PC_TIMELINE_EVENT       "event"
+#define PC_TIMELINE_RDR         "renderer"
+#define PC_TIMELINE_FETCHER     "fetcher"
+#define PC_TIMELINE_TIMER       "timer"
+
+PCA_EXTERN_C_BEGIN
+
+/* @ph is the phase of the Trace Event Format: 'B', 'E', 'X' or 'i' */
+void pctimeline_add(struct pcinst *inst, char ph, const char *cat,
+        const char *name, const char *arg, int line,
+        uint64_t ts, uint64_t dur) WTF_INTERNAL;
+
+PCA_EXTERN_C_END
+
+#if ENABLE(TRACE)
+
+static inline struct pcinst *pctimeline_instance(void)
+{
+    struct pcinst *inst = pcinst_current();
+    return UNLIKELY(inst && inst->timeline) ? inst : NULL;
+}
+
+#else /* ENABLE(TRACE) */
+
+#define pctimeline_instance()           ((struct pcinst *)NULL)
+
+#endif /* !ENABLE(TRACE) */
+
+/* begins a span of @name (and @arg) at line @line; 0 for no line */
+static inline void
+pctimeline_begin(const char *cat, const char *name, const char *arg, int line)
+{
+    struct pcinst *inst = pctimeline_instance();
+    if (inst)
+        pctimeline_add(inst, 'B', cat, name, arg, line,
+                pcinst_metrics_now(), 0);
+}
+
+static inline void pctimeline_end(const char *cat, const char *name)
+{
+    struct pcinst *inst = pctimeline_instance();
+    if (inst)
+        pctimeline_add(inst, 'E', cat, name, NULL, 0, pcinst_metrics_now(), 0);
+}
+
+/* adds a span started at @since, given by pcinst_metrics_now() */
+static inline void
+pctimeline_complete(const char *cat, const char *name, const char *arg,
+        uint64_t since)
+{
+    struct pcinst *inst = pctimeline_instance();
+    if (inst) {
+        uint64_t now = pcinst_metrics_now();
+        pctimeline_add(inst, 'X', cat, name, arg, 0, since,
+                now > since ? now - since : 0);
+    }
+}
+
+static inline void
+pctimeline_instant(const char *cat, const char *name, const char *arg)
+{
+    struct pcinst *inst = pctimeline_instance();
+    if (inst)
+        pctimeline_add(inst, 'i', cat, name, arg, 0, pcinst_metrics_now(), 0);
+}
+
+PCA_EXTERN_C_BEGIN
+
+/* sets the categories of tracing from the environment variables, and
+   starts the timeline if it is asked by @extra_info or the environment */
+void pctrace_init_instance(struct pcinst *inst,
+        const purc_instance_extra_info *extra_info) WTF_INTERNAL;
+
+/* writes the timeline to the file, and frees it */
+void pctrace_cleanup_instance(struct pcinst *inst) WTF_INTERNAL;
+
+/* the category of the name, e.g., `vcm`; 0 for unknown */
+unsigned int pctrace_category(const char *name, size_t len) WTF_INTERNAL;
+
+/* the name of a single category */
+const char *pctrace_category_name(unsigned int category) WTF_INTERNAL;
+
+PCA_EXTERN_C_END
+
+#endif /* PURC_PRIVATE_TRACE_H */
@@ -149,6 +149,9 @@ typedef struct pcutils_crc32_ctxt {
         const uint32_t *table_static;
         uint32_t       *table_alloc;
     };
+
+    /* the tables for slicing-by-8 derived from the static one; nullable */
+    const uint32_t (*slices)[256];
 } pcutils_crc32_ctxt;
 
 void
@@ -231,6 +234,61 @@ int pcutils_parse_uint64(const char *buf, size_t len, uint64_t *retval);
 int pcutils_parse_double(const char *buf, size_t len, double *retval);
 int pcutils_parse_long_double(const char *buf, size_t len, long double *retval);
 
+/* the size of the buffer enough for pcutils_dtoa() */
+#define PCUTILS_DTOA_BUFSZ     32
+
+/* Formats @d like "%.17g" but with the shortest digits which are read back
+   as the same double, and regardless of the locale; returns the length. */
+size_t pcutils_dtoa(double d, char *buf);
+
+/* Formats @d like "%g" does, but regardless of the locale; returns the
+   length. The buffer should be not less than PCUTILS_DTOA_BUFSZ. */
+size_t pcutils_gtoa(double d, char *buf);
+
+/* the size of the buffer enough for pcutils_i64toa() and pcutils_u64toa() */
+#define PCUTILS_ITOA_BUFSZ     24
+
+/* Formats the integers in decimal without snprintf(); returns the length. */
+size_t pcutils_i64toa(int64_t i, char *buf);
+size_t pcutils_u64toa(uint64_t u, char *buf);
+
+/* Same as strtod(), but faster for the usual numbers. */
+double pcutils_strtod(const char *str, char **end);
+
+/* Searches @needle in @haystack by the lengths; returns NULL if not found. */
+const char *pcutils_memmem(const char *haystack, size_t len_haystack,
+        const char *needle, size_t len_needle) WTF_INTERNAL;
+
+/* Same as pcutils_memmem(), but ignores the case of ASCII letters. */
+const char *pcutils_memcasemem(const char *haystack, size_t len_haystack,
+        const char *needle, size_t len_needle) WTF_INTERNAL;
+
+/* Returns the first byte in [@p, @end) which is one of the four bytes,
+   or @end if there is none. */
+const unsigned char *pcutils_memchr4(const unsigned char *p,
+        const unsigned char *end, unsigned char c1, unsigned char c2,
+        unsigned char c3, unsigned char c4) WTF_INTERNAL;
+
+/* Checks whether the bytes are all in the ASCII character set. */
+bool pcutils_is_ascii(const char *str, size_t len) WTF_INTERNAL;
+
+/* Returns the length of the longest prefix (not longer than `n`) of the two
+   strings, which is in ASCII and equal when ignoring the case. */
+size_t pcutils_ascii_caseless_prefix(const char *s1, const char *s2,
+        size_t n) WTF_INTERNAL;
+
+/* Copies `len` bytes from `src` to `dst` (which can be `src`) and lowers
+   the ASCII letters. Returns false if a byte is not in ASCII. */
+bool pcutils_ascii_tolower_copy(char *dst, const char *src,
+        size_t len) WTF_INTERNAL;
+
+/* Folds the case of a string like pcutils_ascii_tolower_copy(), so that
+   strcmp() orders the folded strings as pcutils_strcasecmp() orders the
+   original ones. Returns false if the string is not in ASCII or the current
+   locale lowers an ASCII letter specially (e.g., `I` in Turkish). */
+bool pcutils_strfold_ascii(char *dst, const char *src,
+        size_t len) WTF_INTERNAL;
+
 struct pcutils_mystring {
     char *buff;
     size_t nr_bytes;
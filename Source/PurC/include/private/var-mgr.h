@@ -40,6 +40,9 @@ struct pcvarmgr {
     purc_variant_t object;
     struct pcvar_listener *listener;
 
+    // the event-observed variants built for the names, keyed by the names
+    purc_variant_t events;
+
     struct rb_node            node;
     struct pcvdom_node       *vdom_node;
 };
@@ -33,6 +33,7 @@
 #include "array_list.h"
 #include "private/debug.h"
 #include "private/map.h"
+#include "private/ptrmap.h"
 
 PCA_EXTERN_C_BEGIN
 
@@ -40,6 +41,26 @@ PCA_EXTERN_C_BEGIN
 #define PCVARIANT_FLAG_NOFREE          PCVARIANT_FLAG_CONSTANT
 #define PCVARIANT_FLAG_EXTRA_SIZE      (0x01 << 1)  // when use extra space
 #define PCVARIANT_FLAG_STRING_STATIC   (0x01 << 2)  // make_string_static
+#define PCVARIANT_FLAG_STRING_ASCII    (0x01 << 3)  // only ASCII characters
+#define PCVARIANT_FLAG_DYNAMIC_PURE    (0x01 << 4)  // the getter is pure
+#define PCVARIANT_FLAG_DYNAMIC_LAZY    (0x01 << 5)  // lazy arguments
+#define PCVARIANT_FLAG_MAPPED          (0x01 << 6)  // a mapped static buffer
+#define PCVARIANT_FLAG_STRING_HASHED   (0x01 << 7)  // the hash value cached
+
+// the operations listened by the listeners of a container; see observer.c
+#define PCVARIANT_FLAG_LISTENED_SHIFT  8
+#define PCVARIANT_FLAG_LISTENED_MASK   \
+    (PCVAR_OPERATION_ALL << PCVARIANT_FLAG_LISTENED_SHIFT)
+
+// the variants of a dataset shared by all instances; see shared-data.c
+#define PCVARIANT_FLAG_SHARED          (0x01 << 12) // frozen in move heap
+#define PCVARIANT_FLAG_SHARED_ROOT     (0x01 << 13) // the root of a dataset
+
+// a possible root of a cycle of containers; see cycles.c
+#define PCVARIANT_FLAG_GC_BUFFERED     (0x01 << 14)
+
+// a container being scanned by purc_variant_container_scan()
+#define PCVARIANT_FLAG_PINNED          (0x01 << 15)
 
 #define PVT(t)          (PURC_VARIANT_TYPE##t)
 #define IS_CONTAINER(t) (t == PURC_VARIANT_TYPE_OBJECT || \
@@ -191,6 +212,19 @@ struct purc_variant {
 #define MAX_RESERVED_VARIANTS           32
 #define USE_LOOP_BUFFER_FOR_RESERVED    0
 
+#define NR_INTERNED_KEYS        256
+
+/*
+ * The variants charged to a coroutine: the ones made while it is running,
+ * less the ones released while it is running. A variant made by one and
+ * released by another is credited to the latter, so the numbers can be
+ * negative for a coroutine releasing what others made.
+ */
+struct pcvariant_charge {
+    int64_t             nr_values;
+    int64_t             sz_mem;     // including the extra sizes
+};
+
 struct pcvariant_heap {
     // the constant values.
     struct purc_variant v_undefined;
@@ -201,6 +235,18 @@ struct pcvariant_heap {
     // the statistics of memory usage of variant values
     struct purc_variant_stat stat;
 
+    // the slab for variants and container nodes
+    struct pcvariant_slab *slab;
+
+    // the charge of the running coroutine; NULL for none
+    struct pcvariant_charge *charge;
+
+    // the cache of interned object keys; see pcvariant_make_object_key()
+    purc_variant_t      interned_keys[NR_INTERNED_KEYS];
+
+    // the cycle collector; NULL if it is not enabled
+    struct pcvariant_gc *gc;
+
 #if USE(LOOP_BUFFER_FOR_RESERVED)
     // the loop buffer for reserved values.
     purc_variant_t      v_reserved[MAX_RESERVED_VARIANTS];
@@ -216,12 +262,161 @@ purc_variant_t pcvariant_move_heap_in(purc_variant_t v) WTF_INTERNAL;
 purc_variant_t pcvariant_move_heap_out(purc_variant_t v) WTF_INTERNAL;
 
 void pcvariant_use_move_heap(void) WTF_INTERNAL;
+
+/*
+ * The shared datasets are immutable variant trees living in the move heap,
+ * which can be bound by all instances of the process at the same time.
+ * The variants in a dataset are referenced and unreferenced atomically,
+ * and any change to them fails with PURC_ERROR_ACCESS_DENIED. A dataset is
+ * released by the instance which drops the last reference to it.
+ */
+
+/* returns a reference to the dataset published under @name, or
+   PURC_VARIANT_INVALID with PCVARIANT_ERROR_NOT_FOUND */
+purc_variant_t pcvariant_shared_data_get(const char *name) WTF_INTERNAL;
+
+/* freezes the variant @v (the reference is taken over) and publishes it
+   under @name; returns a reference to the dataset published under @name,
+   which may be the one published by another instance meanwhile. */
+purc_variant_t pcvariant_shared_data_publish(const char *name,
+        purc_variant_t v) WTF_INTERNAL;
+
+/* freezes the variant @v (the reference is taken over) without publishing
+   it under a name, e.g. for the payload of messages to many instances;
+   returns a reference to the frozen variant, or PURC_VARIANT_INVALID */
+purc_variant_t pcvariant_shared_data_freeze(purc_variant_t v) WTF_INTERNAL;
+
+/* charges the variants made or released by the current instance afterwards
+   to @charge (NULL for none); the move heap is never charged. */
+void pcvariant_set_charge(struct pcvariant_charge *charge) WTF_INTERNAL;
+
+/* stops charging to @charge if it is the one charged to */
+void pcvariant_drop_charge(struct pcvariant_charge *charge) WTF_INTERNAL;
 void pcvariant_use_norm_heap(void) WTF_INTERNAL;
 
 purc_variant *pcvariant_alloc(void) WTF_INTERNAL;
 purc_variant *pcvariant_alloc_0(void) WTF_INTERNAL;
 void pcvariant_free(purc_variant *v) WTF_INTERNAL;
 
+// the slab allocator of the current instance; see slab.c
+struct pcvariant_slab;
+
+struct pcvariant_slab *pcvariant_slab_create(void) WTF_INTERNAL;
+void pcvariant_slab_destroy(struct pcvariant_slab *slab) WTF_INTERNAL;
+void pcvariant_slab_get_stat(struct pcvariant_slab *slab,
+        struct purc_variant_stat *stat) WTF_INTERNAL;
+
+void *pcvariant_slab_alloc(size_t sz) WTF_INTERNAL;
+void *pcvariant_slab_alloc0(size_t sz) WTF_INTERNAL;
+void pcvariant_slab_free(size_t sz, void *p) WTF_INTERNAL;
+
+// the cycle collector of the current instance; see cycles.c
+struct pcvariant_gc;
+
+/* enables the cycle collector of @heap if PURC_ENVV_VARIANT_GC_BUDGET is
+   set to a positive number */
+void pcvariant_gc_init(struct pcvariant_heap *heap) WTF_INTERNAL;
+void pcvariant_gc_cleanup(struct pcvariant_heap *heap) WTF_INTERNAL;
+
+/* the number of the instances which enabled the cycle collector */
+extern unsigned int pcvariant_nr_gc_heaps WTF_INTERNAL;
+
+/* buffers the container @v as a possible root of a cycle */
+void pcvariant_gc_buffer(purc_variant_t v) WTF_INTERNAL;
+
+/* removes @v from the buffer, for it is released, moved, or frozen */
+void pcvariant_gc_forget(purc_variant_t v) WTF_INTERNAL;
+
+/* whether @v is in a garbage cycle being released by the collector; the
+   reverse update edges between such containers are not maintained */
+bool pcvariant_gc_is_releasing(purc_variant_t v) WTF_INTERNAL;
+
+/* whether there is any possible root to collect from */
+bool pcvariant_gc_has_roots(void) WTF_INTERNAL;
+
+/* collects the cycles in the time budget of the instance on idle; returns
+   the memory reclaimed in bytes */
+size_t pcvariant_gc_collect_on_idle(void) WTF_INTERNAL;
+
+// whether any listener of the container listens to the operation
+static inline bool pcvariant_is_listened(purc_variant_t v, pcvar_op_t op)
+{
+    return (v->flags >> PCVARIANT_FLAG_LISTENED_SHIFT) & op;
+}
+
+// whether the variant belongs to a shared dataset, so it is immutable
+static inline bool pcvariant_is_shared(purc_variant_t v)
+{
+    return v->flags & PCVARIANT_FLAG_SHARED;
+}
+
+// whether the variant cannot be changed: it is shared or being scanned
+static inline bool pcvariant_is_immutable(purc_variant_t v)
+{
+    return v->flags & (PCVARIANT_FLAG_SHARED | PCVARIANT_FLAG_PINNED);
+}
+
+// whether the string contains only ASCII characters; the flag is set when
+// the variant is made, so the byte offsets are also the character offsets.
+static inline bool pcvariant_string_is_ascii(purc_variant_t v)
+{
+    return v->type == PURC_VARIANT_TYPE_STRING &&
+        (v->flags & PCVARIANT_FLAG_STRING_ASCII);
+}
+
+// the hash value of a string variant, the same as the one given by
+// pchash_default_char_hash() for the string. It is cached in the variant
+// along with the number of the characters on a 64-bit platform, so the
+// maps keyed by the string variants need not to hash them again.
+uint32_t pcvariant_string_hash(purc_variant_t v) WTF_INTERNAL;
+
+// make a string variant reusing a buffer (of at least `len + 1` bytes)
+// which is known to contain `len` ASCII characters; no scan is needed.
+purc_variant_t pcvariant_make_ascii_string_reuse_buff(char *str,
+        size_t len) WTF_INTERNAL;
+
+// make a string variant for an object key; the variants of the same key
+// share the string interned as an atom, and the recently used ones are
+// cached in the heap of the current instance.
+purc_variant_t pcvariant_make_object_key(const char *key) WTF_INTERNAL;
+
+// the same as purc_variant_load_from_json_stream(), but with the flags
+// of the eJSON parser, e.g., PCEJSON_FLAG_INTERN_KEYS.
+purc_variant_t pcvariant_load_from_json_stream_ex(purc_rwstream_t stream,
+        uint32_t flags) WTF_INTERNAL;
+
+// the writer used by the binary eJSON encoding; the same as pcrdr_cb_write.
+typedef ssize_t (*pcvariant_cb_write)(void *ctxt, const void *buf,
+        size_t count);
+
+// a NUL byte follows the bytes of every string in the binary eJSON encoding
+#define PCVARIANT_BINARY_FLAG_NUL       0x80000000
+
+// writes @v in the binary eJSON encoding (without the magic) by calling
+// @fn; returns 0, or -1 if @v contains an unknown type or @fn failed.
+int pcvariant_write_binary(pcvariant_cb_write fn, void *ctxt,
+        purc_variant_t v, unsigned int flags) WTF_INTERNAL;
+
+// reads a value in the binary eJSON encoding (without the magic) from
+// `*p` up to @end, and advances `*p` past the value; returns
+// PURC_VARIANT_INVALID with PURC_ERROR_INVALID_VALUE if it is malformed.
+purc_variant_t pcvariant_read_binary(const uint8_t **p, const uint8_t *end,
+        unsigned int flags) WTF_INTERNAL;
+
+// find the first member of the object whose key is not less than @key
+// (greater than @key if @after is true) by strcmp(), which is the order
+// of the iteration; returns the value and the key in @found_key, or
+// PURC_VARIANT_INVALID if there is no such member. Nothing is cached, so
+// it can be used to walk an object changed between the calls.
+purc_variant_t
+pcvariant_object_lower_bound(purc_variant_t object, const char *key,
+        bool after, purc_variant_t *found_key) WTF_INTERNAL;
+
+#define pcvariant_slab_new(type)        \
+    ((type *)pcvariant_slab_alloc0(sizeof(type)))
+#define pcvariant_slab_delete(type, p)  \
+    pcvariant_slab_free(sizeof(type), (p))
+
 struct pcinst;
 
 struct pcvar_rev_update_edge {
@@ -230,18 +425,24 @@ struct pcvar_rev_update_edge {
         // where to locate in parent
         struct set_node             *set_me;
         struct obj_node             *obj_me;
-        struct arr_node             *arr_me;
+        purc_variant_t               arr_me;    // the array itself
     };
 };
 
 // internal struct used by variant-set object
 typedef struct variant_set      *variant_set_t;
 
+struct set_sindex;
+struct set_sindex_entry;
+
 struct set_node {
     struct rb_node                       rbnode;
     struct pcutils_array_list_node       alnode;
     purc_variant_t   val;  // actual variant-element
-    char             md5[33];
+    uint64_t         hash; // see pcvariant_hash_by_set()
+
+    // the entries of the element in the secondary indexes
+    struct set_sindex_entry             *sindex_entries;
 };
 
 struct variant_set {
@@ -252,9 +453,18 @@ struct variant_set {
     struct rb_root          elems;  // multiple-variant-elements stored in set
     struct pcutils_array_list al;    // struct set_node
 
-    // key: arr_node/obj_node/set_node
+    // the open-addressing hash index of the elements; not used by
+    // a caseless set, which falls back to the red-black tree.
+    struct set_node       **index;
+    size_t                  index_size;     // always a power of 2
+    size_t                  index_used;     // including removed slots
+
+    // the secondary indexes on the members of the elements
+    struct set_sindex      *sindexes;
+
+    // key: array/obj_node/set_node
     // val: parent
-    pcutils_map                     *rev_update_chain;
+    pcutils_ptrmap                  *rev_update_chain;
 };
 
 // internal struct used by variant-obj object
@@ -264,42 +474,74 @@ struct obj_node {
     struct rb_node   node;
     purc_variant_t   key;
     purc_variant_t   val;
+    uint32_t         key_hash;  // the cached hash value of the key
 };
 
 struct variant_obj {
     struct rb_root          kvs;  // struct obj_node*
     size_t                  size;
 
-    // key: arr_node/obj_node/set_node
+    // the open-addressing hash index of the nodes, built only when
+    // the object has more than OBJ_INDEX_THRESHOLD members.
+    struct obj_node       **index;
+    size_t                  index_size;     // always a power of 2
+    size_t                  index_used;     // including the removed slots
+
+    // key: array/obj_node/set_node
     // val: parent
-    pcutils_map                     *rev_update_chain;
+    pcutils_ptrmap                  *rev_update_chain;
 };
 
 // internal struct used by variant-arr
 typedef struct variant_arr      *variant_arr_t;
 
-struct arr_node {
-    struct pcutils_array_list_node       node;
-    purc_variant_t   val;
-};
-
 struct variant_arr {
-    struct pcutils_array_list     al;  // struct arr_node*
+    purc_variant_t         *vals;   // the members stored contiguously
+    size_t                  nr;     // the number of members
+    size_t                  sz;     // the capacity of vals
 
-    // key: arr_node/obj_node/set_node
+    // key: array/obj_node/set_node
     // val: parent
-    pcutils_map                     *rev_update_chain;
+    pcutils_ptrmap                  *rev_update_chain;
 };
 
 #define PCVARIANT_SORT_DESC            0x10000000
 #define PCVARIANT_SORT_ASC             0x00000000
 #define PCVARIANT_CMPOPT_MASK          0x0000FFFF
 
+/* removes the members for which @pred returns true; it takes one pass if
+   nobody listens to the shrinking of the array and it belongs to no set,
+   otherwise the members are removed one by one from the last.
+   Returns -1 on failure, and the members failed to remove are kept. */
+int pcvariant_array_remove_if(purc_variant_t arr,
+        bool (*pred)(purc_variant_t member, void *ctxt), void *ctxt);
+
+/* shrinks the storage of a small array to its members, e.g., for the
+   records parsed from a data file which are seldom changed; the array
+   gets a normal capacity again on the first growth. */
+void pcvariant_array_compact(purc_variant_t arr) WTF_INTERNAL;
+
 int pcvariant_array_sort(purc_variant_t value, void *ud,
         int (*cmp)(purc_variant_t l, purc_variant_t r, void *ud));
 int pcvariant_set_sort(purc_variant_t value, void *ud,
         int (*cmp)(purc_variant_t l, purc_variant_t r, void *ud));
 
+/* Returns the key @idx of @member to sort by (not referenced), or
+   PURC_VARIANT_INVALID if the member has no such key. */
+typedef purc_variant_t (*pcvariant_sort_key_getter)(purc_variant_t member,
+        size_t idx, void *ud);
+
+/*
+ * Sorts the members of an array or a set by @nr_keys keys which are
+ * extracted once from every member by @getter (the member itself is the
+ * only key if @getter is NULL). The key @idx is compared by numbers if
+ * `by_number[idx]` is true, otherwise by the stringified values. The
+ * members having equal keys keep their order.
+ */
+int pcvariant_sort_by_keys(purc_variant_t container, size_t nr_keys,
+        const bool *by_number, pcvariant_sort_key_getter getter, void *ud,
+        bool desc, bool caseless);
+
 int pcvariant_diff(purc_variant_t l, purc_variant_t r);
 int pcvariant_diff_ex(purc_variant_t l, purc_variant_t r,
         enum purc_variant_compare_opt opt);
@@ -347,6 +589,31 @@ pcvariant_is_of_number(purc_variant_t v);
 int pcvariant_set_get_uniqkeys(purc_variant_t set, size_t *nr_keynames,
         const char ***keynames);
 
+/*
+ * A secondary index keeps the elements of a set ordered by the value of
+ * their member @keyname, and is updated when an element is added, removed,
+ * replaced, or changed. The elements without such a member are never
+ * found by a lookup.
+ */
+int pcvariant_set_create_index(purc_variant_t set, const char *keyname);
+int pcvariant_set_drop_index(purc_variant_t set, const char *keyname);
+bool pcvariant_set_has_index(purc_variant_t set, const char *keyname);
+
+/*
+ * Looks up the elements whose member @keyname is between @lo and @hi
+ * (either can be PURC_VARIANT_INVALID for no bound) by the index. On
+ * success, `*positions` is an ascending array of the positions of the
+ * elements in the set, which should be freed by the caller.
+ *
+ * Fails with PURC_ERROR_NOT_EXISTS if there is no such index, and with
+ * PURC_ERROR_NOT_SUPPORTED if the members present are not all of the type
+ * of the bounds (numbers or strings); the elements should be compared one
+ * by one then.
+ */
+int pcvariant_set_index_lookup(purc_variant_t set, const char *keyname,
+        purc_variant_t lo, bool lo_incl, purc_variant_t hi, bool hi_incl,
+        size_t **positions, size_t *nr_positions);
+
 ssize_t pcvariant_serialize(char *buf, size_t sz, purc_variant_t val);
 char* pcvariant_serialize_alloc(char *buf, size_t sz, purc_variant_t val);
 
@@ -428,14 +695,28 @@ pcvariant_md5(char *md5, purc_variant_t val)
     pcvariant_md5_ex(md5, val, salt, caseless, serialize_flags);
 }
 
-// md5 shall be at least 33 bytes long
-void
-pcvariant_md5_by_set(char *md5, purc_variant_t val,
-        purc_variant_t set) WTF_INTERNAL;
-
-int
-pcvariant_diff_by_set(const char *md5l, purc_variant_t l,
-        const char *md5r, purc_variant_t r, purc_variant_t set);
+// The hash of a set element, which is consistent with the comparison
+// used by a case-sensitive set: the elements equal to each other
+// always have the same hash value. For a caseless set, only the ASCII
+// letters are folded, so the elements equal in Unicode case folding
+// may have different hash values.
+uint64_t
+pcvariant_hash_by_set(purc_variant_t val, purc_variant_t set) WTF_INTERNAL;
+
+// The hash consistent with the comparison of the elements of a generic
+// case-sensitive set, i.e., PCVARIANT_COMPARE_OPT_CASE.
+uint64_t
+pcvariant_hash(purc_variant_t val) WTF_INTERNAL;
+
+// the size of the buffer enough for pcvariant_stringify_number()
+#define PCVARIANT_NUMBER_BUFSZ      32
+
+// Stringifies a number, longint, ulongint, or long double as
+// purc_variant_stringify() does, into a buffer on the stack, e.g., of
+// PCVARIANT_NUMBER_BUFSZ bytes. Returns the length, or -1 if the value
+// is not of such types.
+ssize_t
+pcvariant_stringify_number(purc_variant_t val, char *buf) WTF_INTERNAL;
 
 PCA_EXTERN_C_END
 
@@ -449,66 +730,47 @@ PCA_EXTERN_C_END
  */
 
 // purc_variant_t _arr;
-#define variant_array_get_data(_arr)        \
-    &(((variant_arr_t)_arr->sz_ptr[1])->al)
-
-// purc_variant_t _arr;
-// struct arr_node *_p;
-#define foreach_in_variant_array(_arr, _p)                               \
-    array_list_for_each_entry(variant_array_get_data(_arr),              \
-            _p, node)
-
-// purc_variant_t _arr;
-// struct arr_node *_p, *_n;
-#define foreach_in_variant_array_safe(_arr, _p, _n)                      \
-    array_list_for_each_entry_safe(variant_array_get_data(_arr),         \
-            _p, _n, node)
-
-// purc_variant_t _arr;
-// struct arr_node *_p;
-#define foreach_in_variant_array_reverse(_arr, _p)                       \
-    array_list_for_each_entry_reverse(variant_array_get_data(_arr),      \
-            _p, node)
-
-// purc_variant_t _arr;
-// struct arr_node *_p, *_n;
-#define foreach_in_variant_array_reverse_safe(_arr, _p, _n)              \
-    array_list_for_each_entry_reverse_safe(variant_array_get_data(_arr), \
-            _p, _n, node)
-
+// purc_variant_t _val;
+// size_t _idx;
 #define foreach_value_in_variant_array(_arr, _val, _idx)              \
     do {                                                              \
-        struct arr_node *_p;                                          \
-        foreach_in_variant_array(_arr, _p) {                          \
-            _val = _p->val;                                           \
-            _idx = _p->node.idx;                                      \
+        variant_arr_t _data;                                          \
+        _data = (variant_arr_t)_arr->sz_ptr[1];                       \
+        for (_idx = 0; _idx < _data->nr; _idx++) {                    \
+            _val = _data->vals[_idx];                                 \
      /* } */                                                          \
  /* } while (0) */
 
+// the current member can be removed in the iteration
 #define foreach_value_in_variant_array_safe(_arr, _val, _idx)      \
     do {                                                           \
-        struct arr_node *_p, *_n;                                  \
-        foreach_in_variant_array_safe(_arr, _p, _n) {              \
-            _val = _p->val;                                        \
-            _idx = _p->node.idx;                                   \
+        variant_arr_t _data;                                       \
+        _data = (variant_arr_t)_arr->sz_ptr[1];                    \
+        size_t _nr = _data->nr;                                    \
+        for (_idx = 0; _idx < _data->nr;                           \
+                _idx += (_data->nr >= _nr), _nr = _data->nr) {     \
+            _val = _data->vals[_idx];                              \
      /* } */                                                       \
  /* } while (0) */
 
 #define foreach_value_in_variant_array_reverse(_arr, _val, _idx)      \
     do {                                                              \
-        struct arr_node *_p;                                          \
-        foreach_in_variant_array_reverse(_arr, _p) {                  \
-            _val = _p->val;                                           \
-            _idx = _p->node.idx;                                      \
+        variant_arr_t _data;                                          \
+        _data = (variant_arr_t)_arr->sz_ptr[1];                       \
+        for (_idx = _data->nr; _idx-- > 0; ) {                        \
+            _val = _data->vals[_idx];                                 \
      /* } */                                                          \
  /* } while (0) */
 
+// the current member can be removed in the iteration
 #define foreach_value_in_variant_array_reverse_safe(_arr, _val, _idx)   \
     do {                                                                \
-        struct arr_node *_p, *_n;                                       \
-        foreach_in_variant_array_reverse_safe(_arr, _p, _n) {           \
-            _val = _p->val;                                             \
-            _idx = _p->node.idx;                                        \
+        variant_arr_t _data;                                            \
+        _data = (variant_arr_t)_arr->sz_ptr[1];                         \
+        for (_idx = _data->nr; _idx-- > 0; ) {                          \
+            if (_idx >= _data->nr)                                      \
+                continue;                                               \
+            _val = _data->vals[_idx];                                   \
      /* } */                                                            \
  /* } while (0) */
 
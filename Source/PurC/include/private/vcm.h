@@ -60,6 +60,10 @@ enum pcvcm_node_type {
 #define EXTRA_NULL              0x0000
 #define EXTRA_PROTECT_FLAG      0x0001
 #define EXTRA_SUGAR_FLAG        0x0002
+/* the object node whose constant keys will be interned */
+#define EXTRA_INTERN_KEYS_FLAG  0x0004
+/* the node gives the same value whenever evaluated; see vcm-fold.c */
+#define EXTRA_CONST_FLAG        0x0008
 
 #define PCVCM_EV_PROPERTY_EVAL            "eval"
 #define PCVCM_EV_PROPERTY_EVAL_CONST      "eval_const"
@@ -70,8 +74,15 @@ struct pcvcm_node {
     struct pctree_node tree_node;
     enum pcvcm_node_type type;
     uint32_t extra;
-    uintptr_t attach;
     bool is_closed;
+    /* allocated from an arena and freed with it */
+    bool in_arena;
+    /* the times evaluated as a tree before compiled */
+    uint8_t nr_evals;
+    /* the compiled code of the tree rooted at this node, or NULL */
+    struct pcvcm_code *code;
+    /* the identifier of the value folded for the node, or 0 */
+    uint32_t const_id;
     union {
         bool        b;
         double      d;
@@ -173,6 +184,37 @@ char *pcvcm_node_serialize(struct pcvcm_node *node, size_t *nr_bytes);
  */
 void pcvcm_node_destroy(struct pcvcm_node *root);
 
+/*
+ * The arena the VCM nodes of a vDOM are bump-allocated from. The nodes (and
+ * their string buffers) are freed all together when the last reference to
+ * the arena is released; pcvcm_node_destroy() on them only detaches them.
+ */
+struct pcvcm_arena;
+
+struct pcvcm_arena *pcvcm_arena_new(void);
+
+struct pcvcm_arena *pcvcm_arena_ref(struct pcvcm_arena *arena);
+
+void pcvcm_arena_unref(struct pcvcm_arena *arena);
+
+/*
+ * Makes the new VCM nodes of the current instance come from the arena,
+ * or from the heap if arena is NULL. Returns the arena in use before.
+ */
+struct pcvcm_arena *pcvcm_arena_switch(struct pcvcm_arena *arena);
+
+/*
+ * Returns the arena the new VCM nodes of the current instance come from,
+ * NULL if they come from the heap.
+ */
+struct pcvcm_arena *pcvcm_arena_current(void);
+
+/*
+ * Returns zeroed memory from the arena, which lives as long as the arena;
+ * the vDOM allocates its nodes from the arena of the document this way.
+ */
+void *pcvcm_arena_alloc(struct pcvcm_arena *arena, size_t size);
+
 struct pcvcm_stack;
 struct pcvcm_stack *pcvcm_stack_new();
 
@@ -195,6 +237,56 @@ struct pcintr_stack;
 purc_variant_t pcvcm_eval(struct pcvcm_node *tree, struct pcintr_stack *stack,
         bool silently);
 
+/* the function finding the variables of the stack (@ctxt) used by
+   pcvcm_eval(); for the callers wrapping it */
+purc_variant_t pcvcm_find_stack_var(void *ctxt, const char *name);
+
+/*
+ * A tree evaluated more than once by pcvcm_eval_ex() is compiled to a linear
+ * code, which is kept on the tree and run instead of walking the tree from
+ * then on. pcvcm_node_compile() compiles the tree at once; it returns false
+ * if the tree cannot be compiled, which is then always walked.
+ */
+struct pcvcm_code;
+
+bool pcvcm_node_compile(struct pcvcm_node *tree);
+
+/* evaluates the tree by walking it even if it has been compiled */
+purc_variant_t pcvcm_eval_walk(struct pcvcm_node *tree, cb_find_var find_var,
+        void *ctxt, bool silently);
+
+/*
+ * Marks the constant subtrees of the tree, e.g., the objects and arrays of
+ * literals. Such a subtree, and a call to a pure getter of a dynamic variant
+ * with constant arguments, is evaluated only once by an instance; the value
+ * is kept by the instance and reused from then on. It is done for the trees
+ * of the vDOM when they are attached to it.
+ */
+void pcvcm_node_fold_constants(struct pcvcm_node *tree);
+
+/* releases the values folded by the instance */
+struct pcinst;
+void pcvcm_release_folded_values(struct pcinst *inst);
+
+/*
+ * The profiler of VCM evaluation. When it is running, the instance counts
+ * the evaluations of every VCM tree of the vDOM, by the element, the
+ * attribute (none for the content) and the source line, and the calls to
+ * the methods of the dynamic variants, by the getters or setters. The total
+ * time covers the nested ones; the self time does not.
+ */
+int pcvcm_profile_start(struct pcinst *inst);
+
+/* stops the profiler and discards the statistics */
+void pcvcm_profile_stop(struct pcinst *inst);
+
+/* the statistics as an object of two arrays, `roots` and `methods`, by the
+   total time in descending order; null if the profiler is not running */
+purc_variant_t pcvcm_profile_report(struct pcinst *inst);
+
+/* the value of a lazy argument; a new reference to arg if not lazy */
+purc_variant_t pcvcm_force_argument(purc_variant_t arg);
+
 purc_variant_t
 pcvcm_to_expression_variable(struct pcvcm_node *vcm, bool release_vcm);
 
@@ -119,6 +119,34 @@ pcvdom_attr_create(const char *key, enum pchvml_attr_operator op,
 struct pcvdom_attr*
 pcvdom_attr_create_simple(const char *key, struct pcvcm_node *vcm);
 
+// the same as pcvdom_attr_create, but the VCM tree is packed in a compact
+// binary form and destroyed; it will be unpacked by pcvdom_attr_get_vcm
+// when the attribute is evaluated the first time.
+struct pcvdom_attr*
+pcvdom_attr_create_lazy(const char *key, enum pchvml_attr_operator op,
+    struct pcvcm_node *vcm);
+
+// creates an attribute with a copy of a packed VCM tree
+struct pcvdom_attr*
+pcvdom_attr_create_packed(const char *key, enum pchvml_attr_operator op,
+    const void *packed, size_t sz_packed);
+
+// returns the VCM tree of the attribute, unpacks it if it is still packed;
+// returns NULL if the attribute has no value or failed to unpack.
+struct pcvcm_node*
+pcvdom_attr_get_vcm(struct pcvdom_attr *attr);
+
+// returns the string of the attribute if its value is a literal string
+// which is not packed; returns NULL otherwise. The string is not
+// null-terminated; its length is returned via @len.
+const char*
+pcvdom_attr_get_literal(struct pcvdom_attr *attr, size_t *len);
+
+// gets the number of attributes whose VCM trees were packed in the current
+// instance, and the number of them compiled (unpacked) later.
+void
+pcvdom_get_lazy_attr_stat(size_t *nr_lazy, size_t *nr_compiled);
+
 void
 pcvdom_attr_destroy(struct pcvdom_attr *attr);
 
@@ -220,6 +248,23 @@ pcvdom_element_is_hvml_operation(struct pcvdom_element *element);
 struct pcvdom_attr*
 pcvdom_element_find_attr(struct pcvdom_element *element, const char *key);
 
+// releases the data compiled from the element by the interpreter, if any
+void
+pcvdom_element_discard_compiled(struct pcvdom_element *elem);
+
+// returns the data compiled from the element by the interpreter, if any
+// and released by @free_compiled; NULL otherwise.
+void *
+pcvdom_element_get_compiled(struct pcvdom_element *elem,
+        void (*free_compiled)(void *compiled));
+
+// attaches the data compiled from the element; returns the data attached,
+// which is the one attached by another thread meanwhile, and @compiled is
+// released by @free_compiled then.
+void *
+pcvdom_element_set_compiled(struct pcvdom_element *elem, void *compiled,
+        void (*free_compiled)(void *compiled));
+
 bool
 pcvdom_element_is_silently(struct pcvdom_element *element);
 
@@ -0,0 +1,211 @@
+/*
+ * @file wyhash.h
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The fast hash function for the keys of the hash tables.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PURC_PRIVATE_WYHASH_H
+#define PURC_PRIVATE_WYHASH_H
+
+#include "config.h"
+
+#include "purc-macros.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * The hash function wyhash (final version 4) of Wang Yi, released into the
+ * public domain. It reads the key by 8 or 4 bytes, and mixes them by the
+ * 64x64->128 multiplication, so it is several times faster than the ones
+ * hashing a byte a time for the keys longer than a few bytes.
+ *
+ * The keys can be folded to lower or upper case (ASCII only) while being
+ * read, for the caseless hash tables.
+ *
+ * The seed should be given by pcutils_hash_seed(), which is random for a
+ * process, so that the hash values can not be predicted to flood a table.
+ */
+
+enum pcutils_wyhash_fold {
+    PCUTILS_WYHASH_FOLD_NONE = 0,
+    PCUTILS_WYHASH_FOLD_LOWER,
+    PCUTILS_WYHASH_FOLD_UPPER,
+};
+
+PCA_EXTERN_C_BEGIN
+
+/* the random seed of the process for the hash functions */
+uint64_t pcutils_hash_seed(void) WTF_INTERNAL;
+
+PCA_EXTERN_C_END
+
+static inline void
+pcutils_wyhash_mum(uint64_t *a, uint64_t *b)
+{
+#ifdef __SIZEOF_INT128__
+    __uint128_t r = (__uint128_t)*a * *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32;
+    uint64_t la = (uint32_t)*a, lb = (uint32_t)*b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static inline uint64_t
+pcutils_wyhash_mix(uint64_t a, uint64_t b)
+{
+    pcutils_wyhash_mum(&a, &b);
+    return a ^ b;
+}
+
+/* folds the ASCII letters in the bytes of @v */
+static inline uint64_t
+pcutils_wyhash_fold(uint64_t v, enum pcutils_wyhash_fold fold)
+{
+    const uint64_t ones = 0x0101010101010101ULL;
+    uint64_t lo7 = v & (0x7F * ones);
+    uint64_t ascii = ~v & (0x80 * ones);
+
+    if (fold == PCUTILS_WYHASH_FOLD_LOWER) {
+        /* the high bit of a byte is set if it is in 'A' to 'Z' */
+        uint64_t ge = lo7 + (0x80 - 'A') * ones;
+        uint64_t gt = lo7 + (0x80 - 'Z' - 1) * ones;
+        return v | (((ge ^ gt) & ascii) >> 2);
+    }
+    else if (fold == PCUTILS_WYHASH_FOLD_UPPER) {
+        uint64_t ge = lo7 + (0x80 - 'a') * ones;
+        uint64_t gt = lo7 + (0x80 - 'z' - 1) * ones;
+        return v & ~(((ge ^ gt) & ascii) >> 2);
+    }
+
+    return v;
+}
+
+static inline uint64_t
+pcutils_wyhash_r8(const uint8_t *p, enum pcutils_wyhash_fold fold)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return pcutils_wyhash_fold(v, fold);
+}
+
+static inline uint64_t
+pcutils_wyhash_r4(const uint8_t *p, enum pcutils_wyhash_fold fold)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return pcutils_wyhash_fold(v, fold);
+}
+
+static inline uint64_t
+pcutils_wyhash_r3(const uint8_t *p, size_t k, enum pcutils_wyhash_fold fold)
+{
+    uint64_t v = ((uint64_t)p[0] << 16) | ((uint64_t)p[k >> 1] << 8) |
+        p[k - 1];
+    return pcutils_wyhash_fold(v, fold);
+}
+
+static inline uint64_t
+pcutils_wyhash_ex(const void *key, size_t len, uint64_t seed,
+        enum pcutils_wyhash_fold fold)
+{
+    static const uint64_t secret[4] = {
+        0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL,
+        0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL,
+    };
+
+    const uint8_t *p = (const uint8_t *)key;
+    uint64_t a, b;
+
+    seed ^= pcutils_wyhash_mix(seed ^ secret[0], secret[1]);
+    if (len <= 16) {
+        if (len >= 4) {
+            size_t off = (len >> 3) << 2;
+            a = (pcutils_wyhash_r4(p, fold) << 32) |
+                pcutils_wyhash_r4(p + off, fold);
+            b = (pcutils_wyhash_r4(p + len - 4, fold) << 32) |
+                pcutils_wyhash_r4(p + len - 4 - off, fold);
+        }
+        else if (len > 0) {
+            a = pcutils_wyhash_r3(p, len, fold);
+            b = 0;
+        }
+        else {
+            a = b = 0;
+        }
+    }
+    else {
+        size_t i = len;
+        if (i >= 48) {
+            uint64_t see1 = seed, see2 = seed;
+            do {
+                seed = pcutils_wyhash_mix(
+                        pcutils_wyhash_r8(p, fold) ^ secret[1],
+                        pcutils_wyhash_r8(p + 8, fold) ^ seed);
+                see1 = pcutils_wyhash_mix(
+                        pcutils_wyhash_r8(p + 16, fold) ^ secret[2],
+                        pcutils_wyhash_r8(p + 24, fold) ^ see1);
+                see2 = pcutils_wyhash_mix(
+                        pcutils_wyhash_r8(p + 32, fold) ^ secret[3],
+                        pcutils_wyhash_r8(p + 40, fold) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i >= 48);
+            seed ^= see1 ^ see2;
+        }
+
+        while (i > 16) {
+            seed = pcutils_wyhash_mix(pcutils_wyhash_r8(p, fold) ^ secret[1],
+                    pcutils_wyhash_r8(p + 8, fold) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+
+        a = pcutils_wyhash_r8(p + i - 16, fold);
+        b = pcutils_wyhash_r8(p + i - 8, fold);
+    }
+
+    a ^= secret[1];
+    b ^= seed;
+    pcutils_wyhash_mum(&a, &b);
+    return pcutils_wyhash_mix(a ^ secret[0] ^ len, b ^ secret[1]);
+}
+
+/* hashes @len bytes of @key with the seed of the process */
+static inline uint64_t
+pcutils_wyhash(const void *key, size_t len)
+{
+    return pcutils_wyhash_ex(key, len, pcutils_hash_seed(),
+            PCUTILS_WYHASH_FOLD_NONE);
+}
+
+#endif /* not defined PURC_PRIVATE_WYHASH_H */
+
@@ -197,6 +197,72 @@ purc_document_load(purc_document_type type, const char *content, size_t len);
 PCA_EXPORT unsigned int
 purc_document_delete(purc_document_t doc);
 
+/**
+ * Create a new transient document by loading a content.
+ *
+ * @param type: a string contains the type of the document.
+ * @param content (nullable): a string contains the content to load.
+ * @param len: the len of the content, 0 for null-terminated string.
+ *
+ * This function creates a new document like `purc_document_load()`, but
+ * the nodes erased or displaced from a transient document are not freed
+ * one by one; their memory is released as a whole when the document is
+ * deleted or reset. Use it for a document thrown away after a short use.
+ *
+ * Returns: a pointer to the document.
+ *
+ * Since: 0.9.0
+ */
+PCA_EXPORT purc_document_t
+purc_document_load_transient(purc_document_type type,
+        const char *content, size_t len);
+
+static inline purc_document_t
+purc_document_new_transient(purc_document_type type)
+{
+    return purc_document_load_transient(type, NULL, 0);
+}
+
+/**
+ * Create a new compact HTML document by loading a content.
+ *
+ * @param content (nullable): a string contains the HTML content to load.
+ * @param len: the len of the content, 0 for null-terminated string.
+ *
+ * This function creates an HTML document which keeps the nodes in arrays,
+ * the tag and attribute names as atoms, and all texts in one buffer. It
+ * takes several times less memory than a document created by
+ * `purc_document_load()`, but it is never rendered, and the queries by
+ * CSS selectors on it find nothing. Use it for a document which is only
+ * built and serialized, e.g., by a coroutine without a renderer.
+ *
+ * Returns: a pointer to the document.
+ *
+ * Since: 0.9.0
+ */
+PCA_EXPORT purc_document_t
+purc_document_load_compact(const char *content, size_t len);
+
+/**
+ * Reset a document for reuse.
+ *
+ * @param doc: The pointer to the document.
+ * @param content (nullable): a string contains the content to load,
+ *      @NULL for an empty document.
+ * @param len: the len of the content, 0 for null-terminated string.
+ *
+ * This function drops all nodes of the document and loads the content.
+ * The memory of the nodes is released at once, and the document keeps
+ * a part of it for the new nodes. All element handles got from the
+ * document before are invalid after this call.
+ *
+ * Returns: 0 for success, -1 for errors.
+ *
+ * Since: 0.9.0
+ */
+PCA_EXPORT int
+purc_document_reset(purc_document_t doc, const char *content, size_t len);
+
 typedef enum {
     PCDOC_SPECIAL_ELEM_ROOT = 0,
     PCDOC_SPECIAL_ELEM_HEAD,
@@ -289,6 +355,32 @@ pcdoc_element_new_text_content(purc_document_t doc,
         pcdoc_element_t elem, pcdoc_operation op,
         const char *text, size_t len);
 
+/* the text node refers to the bytes of the string variant */
+#define PCDOC_TEXT_CONTENT_F_SHARED     0x0001
+
+/**
+ * Create a new text content from a string variant and insert it to
+ * the specified position related to the specific element.
+ *
+ * @param elem: the pointer to an element.
+ * @param op: The operation.
+ * @param text: a string variant contains the text.
+ * @param flags: the flags; PCDOC_TEXT_CONTENT_F_SHARED to let the text node
+ *      refer to the bytes of the string instead of copying them. The variant
+ *      is then held by the document until the node is destroyed.
+ *
+ * The flag is ignored for a short text, or by the types of document which
+ * can not refer to a string variant.
+ *
+ * Returns: The pointer to the new text content.
+ *
+ * Since: 0.9.0
+ */
+PCA_EXPORT pcdoc_text_node_t
+pcdoc_element_new_text_content_ex(purc_document_t doc,
+        pcdoc_element_t elem, pcdoc_operation op,
+        purc_variant_t text, unsigned flags);
+
 /**
  * Set the data content of an element.
  *
@@ -344,6 +436,72 @@ pcdoc_element_set_attribute(purc_document_t doc,
         pcdoc_element_t elem, pcdoc_operation op,
         const char *name, const char *val, size_t len);
 
+/* The types of the steps to build a subtree */
+typedef enum {
+    /* opens a new element named `name` under the element opened last */
+    PCDOC_BUILD_ELEMENT = 0,
+    /* sets the attribute `name` of the element opened last to `value` */
+    PCDOC_BUILD_ATTRIBUTE,
+    /* makes a text node of `value` under the element opened last */
+    PCDOC_BUILD_TEXT,
+    /* closes the element opened last */
+    PCDOC_BUILD_END,
+} pcdoc_build_step_type;
+
+struct pcdoc_build_step {
+    pcdoc_build_step_type type;
+    const char *name;
+    const char *value;
+    /* the length of value, 0 for null-terminated string */
+    size_t      len;
+};
+
+/**
+ * Build a subtree in one call.
+ *
+ * @param elem: the pointer to an element.
+ * @param op: The operation, can be one of the following values:
+ *  - PCDOC_OP_APPEND, PCDOC_OP_PREPEND, PCDOC_OP_INSERTBEFORE,
+ *    PCDOC_OP_INSERTAFTER, or PCDOC_OP_DISPLACE.
+ * @param steps: the steps to build the nodes; the nodes made out of any
+ *  element are placed at the position given by @op in order, and the
+ *  elements left open are closed at the end.
+ * @param nr_steps: the number of the steps.
+ * @param opts: the serialization options for @markup.
+ * @param markup (nullable): the stream to write the new nodes to in the
+ *  target markup language, for example to update a renderer.
+ *
+ * Returns: 0 for success, -1 for failure.
+ *
+ * Since: 0.9.0
+ */
+PCA_EXPORT int
+pcdoc_element_build_subtree(purc_document_t doc,
+        pcdoc_element_t elem, pcdoc_operation op,
+        const struct pcdoc_build_step *steps, size_t nr_steps,
+        unsigned opts, purc_rwstream_t markup);
+
+/**
+ * Parse a markup as the content of an element into the steps to build
+ * the same nodes by pcdoc_element_build_subtree(). The steps of the recent
+ * markups are kept by the document, so parsing the same markup in the same
+ * kind of element again costs nothing.
+ *
+ * @param elem: the pointer to the element giving the context of parsing.
+ * @param markup: the markup.
+ * @param len: the length of the markup, 0 for null-terminated string.
+ * @param nr_steps: the buffer to return the number of the steps.
+ *
+ * Returns: the steps owned by the document, which are valid until next
+ *  call of this function; NULL for failure, for example the markup makes
+ *  the nodes which can not be built by steps, like comments.
+ *
+ * Since: 0.9.0
+ */
+PCA_EXPORT const struct pcdoc_build_step *
+pcdoc_element_parse_steps(purc_document_t doc, pcdoc_element_t elem,
+        const char *markup, size_t len, size_t *nr_steps);
+
 static inline int pcdoc_element_remove_attribute(purc_document_t doc,
         pcdoc_element_t elem, const char *name)
 {
@@ -676,6 +834,25 @@ PCA_EXPORT int
 purc_document_serialize_contents_to_stream(purc_document_t doc,
         unsigned opts, purc_rwstream_t out);
 
+/**
+ * Set the number of workers to serialize a document.
+ *
+ * @param doc: the document.
+ * @param nr_workers: the number of threads to serialize the subtrees of
+ *      a large document in parallel; 0 or 1 to serialize in the calling
+ *      thread only.
+ *
+ * The document must not be changed by other threads while it is being
+ * serialized. The setting is ignored by the types of document which can
+ * not be serialized in parallel.
+ *
+ * Returns: the number of workers set before.
+ *
+ * Since: 0.9.0
+ */
+PCA_EXPORT unsigned
+purc_document_set_serialize_workers(purc_document_t doc, unsigned nr_workers);
+
 /**
  * Find the first element matching the CSS selector from the descendants.
  *
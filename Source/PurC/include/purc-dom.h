@@ -37,6 +37,7 @@
 #include "purc-rwstream.h"
 #include "purc-utils.h"
 #include "purc-errors.h"
+#include "purc-variant.h"
 
 #define PURC_ERROR_DOM PURC_ERROR_FIRST_DOM
 
@@ -165,6 +166,12 @@ struct pcdom_node {
     void                *user;
 };
 
+/* the data of the text node refers to the bytes of a string variant held
+   by the owner document; `user` points to the holder */
+#define PCDOM_NODE_FLAG_SHARED_DATA     0x4000U
+
+typedef struct pcdom_shared_data pcdom_shared_data_t;
+
 typedef enum {
     PCHTML_ACTION_OK    = 0x00,
     PCHTML_ACTION_STOP  = 0x01,
@@ -383,6 +390,8 @@ struct pcdom_document {
     pcutils_hash_t             *ns;
     void                       *parser;
     void                       *user;
+    /* the holders of the string variants referred by the text nodes */
+    pcdom_shared_data_t        *shared_data;
 
     bool                       tags_inherited;
     bool                       ns_inherited;
@@ -450,6 +459,17 @@ pcdom_text_t *
 pcdom_document_create_text_node(pcdom_document_t *document,
             const unsigned char *data, size_t len);
 
+/* creates a text node which refers to the bytes of the string variant
+   instead of copying them; the variant is held until the node is destroyed
+   or the document is cleaned */
+pcdom_text_t *
+pcdom_document_create_text_node_shared(pcdom_document_t *document,
+            purc_variant_t str);
+
+/* releases the string variant referred by the node */
+void
+pcdom_document_release_shared_data(pcdom_node_t *node);
+
 pcdom_cdata_section_t *
 pcdom_document_create_cdata_section(pcdom_document_t *document,
             const unsigned char *data, size_t len);
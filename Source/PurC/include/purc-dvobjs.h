@@ -90,6 +90,40 @@ PCA_EXPORT purc_variant_t
 purc_dvobj_make_from_methods(const struct purc_dvobj_method *method,
         size_t size);
 
+/**
+ * Mark the getters of the named methods of a dynamic variant object as pure.
+ * A pure getter has no side effect, and always returns the same value for
+ * the same arguments, so a call to it with constant arguments in an
+ * expression may be evaluated only once.
+ *
+ * Returns: @true for success, @false if any name is not a dynamic method.
+ */
+PCA_EXPORT bool
+purc_dvobj_set_pure_methods(purc_variant_t dvobj, const char **names,
+        size_t nr_names);
+
+/**
+ * Mark the getters of the named methods of a dynamic variant object as
+ * taking lazy arguments. When called in an expression, such a getter gets
+ * a thunk for every argument, and evaluates only the arguments it needs
+ * by calling purc_dvobj_force_argument() during the call.
+ *
+ * Returns: @true for success, @false if any name is not a dynamic method.
+ */
+PCA_EXPORT bool
+purc_dvobj_set_lazy_methods(purc_variant_t dvobj, const char **names,
+        size_t nr_names);
+
+/**
+ * Force an argument passed to a getter taking lazy arguments.
+ *
+ * Returns: a new reference to the value of the argument, or
+ *  %PURC_VARIANT_INVALID if failed to evaluate it. A new reference to
+ *  @arg itself if it is not lazy.
+ */
+PCA_EXPORT purc_variant_t
+purc_dvobj_force_argument(purc_variant_t arg);
+
 /** Make a dynamic variant object for built-in `$SYS` variable. */
 PCA_EXPORT purc_variant_t
 purc_dvobj_system_new(void);
@@ -74,6 +74,30 @@ typedef struct purc_exec_ops {
 } purc_exec_ops;
 typedef struct purc_exec_ops* purc_exec_ops_t;
 
+/**
+ * The flag to register an executor implementing the batch operations:
+ * the operation set given is a `struct purc_exec_batch_ops`.
+ */
+#define PURC_EXEC_FLAG_BATCH    0x0001
+
+/** The operation set for the built-in executors with the batch operations */
+typedef struct purc_exec_batch_ops {
+    /** the operations called item by item */
+    struct purc_exec_ops    ops;
+
+    /**
+     * the operation to fetch the value at the iterator and the ones after it
+     * into @values, at most @nr ones, and forward the iterator past them.
+     * The values returned are referenced for the caller.
+     *
+     * Returns the number of values fetched; if it is less than @nr, there is
+     * no more. Returns -1 on failure.
+     */
+    ssize_t (*it_values) (purc_exec_inst_t inst, purc_exec_iter_t it,
+            purc_variant_t *values, size_t nr);
+} purc_exec_batch_ops;
+typedef struct purc_exec_batch_ops* purc_exec_batch_ops_t;
+
 struct purc_iterator_ops {
     purc_variant_t (*begin)(purc_variant_t on_value, purc_variant_t with_value);
     // @return:
@@ -87,9 +111,34 @@ typedef struct purc_iterator_ops* purc_iterator_ops_t;
 
 // typedef purc_iterator_ops_t (*iterator_instantiate)(void);
 
+/**
+ * The batch operations of an external class executor, returned by the
+ * function `<CLASS>_instantiate_batch()` if the shared object exports it;
+ * then `<CLASS>_instantiate()` is not called.
+ */
+struct purc_iterator_batch_ops {
+    purc_variant_t (*begin)(purc_variant_t on_value, purc_variant_t with_value);
+    // fetches the next values into @values, at most @nr ones.
+    // @return:
+    // the number of values fetched, which are owned by the caller;
+    // if it is less than @nr, no further iteration is available
+    // -1: exception: internal failure
+    ssize_t (*next_batch)(purc_variant_t it, purc_variant_t *values,
+            size_t nr);
+};
+typedef struct purc_iterator_batch_ops  purc_iterator_batch_ops;
+typedef struct purc_iterator_batch_ops* purc_iterator_batch_ops_t;
+
 /** Register a built-in executor */
 bool purc_register_executor(const char* name, const purc_exec_ops_t ops);
 
+/**
+ * Register a built-in executor with the flags: if @flags has
+ * PURC_EXEC_FLAG_BATCH, @ops points to a `struct purc_exec_batch_ops`.
+ */
+bool purc_register_executor_ex(const char* name, const purc_exec_ops_t ops,
+        unsigned int flags);
+
 /** Retrieve the operation set of a built-in executor */
 bool purc_get_executor(const char* name, purc_exec_ops_t* ops);
 
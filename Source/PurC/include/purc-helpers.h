@@ -309,6 +309,25 @@ char *purc_load_file_contents(const char *file, size_t *length);
 
 #define PURC_ENVV_LOG_ENABLE        "PURC_LOG_ENABLE"
 #define PURC_ENVV_LOG_SYSLOG        "PURC_LOG_SYSLOG"
+#define PURC_ENVV_LOG_ASYNC         "PURC_LOG_ASYNC"
+#define PURC_ENVV_LOG_LEVELS        "PURC_LOG_LEVELS"
+#define PURC_ENVV_LOG_MODULES       "PURC_LOG_MODULES"
+
+#define PURC_ENVV_VCM_LOG_ENABLE    "PURC_VCM_LOG_ENABLE"
+#define PURC_ENVV_HVML_LOG_ENABLE   "PURC_HVML_LOG_ENABLE"
+#define PURC_ENVV_EJSON_LOG_ENABLE  "PURC_EJSON_LOG_ENABLE"
+
+#define PURC_ENVV_TIMELINE_FILE     "PURC_TIMELINE_FILE"
+#define PURC_ENVV_TIMELINE_SIZE     "PURC_TIMELINE_SIZE"
+
+#define PURC_ENVV_PROFILE_FILE      "PURC_PROFILE_FILE"
+#define PURC_ENVV_PROFILE_INTERVAL  "PURC_PROFILE_INTERVAL"
+
+#define PURC_ENVV_CRTN_MEM_SOFT_LIMIT   "PURC_CRTN_MEM_SOFT_LIMIT"
+#define PURC_ENVV_CRTN_MEM_HARD_LIMIT   "PURC_CRTN_MEM_HARD_LIMIT"
+
+#define PURC_ENVV_POOL_WORKERS      "PURC_POOL_WORKERS"
+#define PURC_ENVV_POOL_AFFINITY     "PURC_POOL_AFFINITY"
 
 #define PURC_LOG_FILE_PATH_FORMAT   "/var/tmp/purc-%s-%s.log"
 
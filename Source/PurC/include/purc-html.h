@@ -321,6 +321,42 @@ enum pchtml_html_serialize_opt {
     PCHTML_HTML_SERIALIZE_OPT_WITH_HVML_HANDLE    = 0x80
 };
 
+/* the cache of the serialized subtrees for incremental serialization */
+typedef struct pchtml_html_serialize_cache pchtml_html_serialize_cache_t;
+
+pchtml_html_serialize_cache_t *
+pchtml_html_serialize_cache_new(void);
+
+void
+pchtml_html_serialize_cache_delete(pchtml_html_serialize_cache_t *cache);
+
+/* marks the node and its ancestors as changed since the last serialization;
+   call it before changing the attributes or the children of the node */
+void
+pchtml_html_serialize_cache_invalidate(pcdom_node_t *node);
+
+/* same as pchtml_html_serialize_pretty_tree_cb(), but copies the output of
+   the subtrees not changed since the last call from the cache */
+unsigned int
+pchtml_html_serialize_pretty_tree_cached_cb(pcdom_node_t *node,
+                pchtml_html_serialize_opt_t opt, size_t indent,
+                pchtml_html_serialize_cache_t *cache,
+                pchtml_html_serialize_cb_f cb, void *ctx);
+
+/* same as pchtml_html_serialize_pretty_tree_cb(), but serializes the
+   subtrees of a large tree on the given number of threads; the tree must
+   not be changed meanwhile */
+unsigned int
+pchtml_html_serialize_pretty_tree_parallel_cb(pcdom_node_t *node,
+                pchtml_html_serialize_opt_t opt, size_t indent,
+                unsigned nr_workers,
+                pchtml_html_serialize_cb_f cb, void *ctx);
+
+int
+pchtml_doc_write_to_stream_cached(pchtml_html_document_t *doc,
+        enum pchtml_html_serialize_opt opt,
+        pchtml_html_serialize_cache_t *cache, purc_rwstream_t out);
+
 int
 pchtml_doc_write_to_stream_ex(pchtml_html_document_t *doc,
         enum pchtml_html_serialize_opt opt, purc_rwstream_t out);
@@ -361,6 +397,11 @@ pcdom_node_snprintf_ex(pcdom_node_t *node,
         enum pchtml_html_serialize_opt opt, char *buf, size_t *io_sz,
         const char *prefix);
 
+int
+pcdom_node_write_to_stream_parallel(pcdom_node_t *node,
+        enum pchtml_html_serialize_opt opt, unsigned nr_workers,
+        purc_rwstream_t out);
+
 static inline int
 pcdom_node_write_to_stream(pcdom_node_t *node, purc_rwstream_t out)
 {
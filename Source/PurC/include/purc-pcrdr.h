@@ -52,6 +52,11 @@
 
 #define PCRDR_HEADLESS_LOGFILE_PATH_FORMAT      "/var/tmp/purc-%s-%s-msg.log"
 
+/* the URI of the headless renderer which keeps the DOM handles only */
+#define PCRDR_HEADLESS_URI_NOLOG                "nolog:"
+/* the URI of the headless renderer which acknowledges immediately */
+#define PCRDR_HEADLESS_URI_NULL                 "null:"
+
 #define PCRDR_NOT_AVAILABLE             "<N/A>"
 
 #define PCRDR_LOCALHOST                 "localhost"
@@ -127,9 +132,11 @@ enum {
 #define PCRDR_OPERATION_GETPROPERTY         "getProperty"
     PCRDR_K_OPERATION_SETPROPERTY,
 #define PCRDR_OPERATION_SETPROPERTY         "setProperty"
+    PCRDR_K_OPERATION_BATCHOPERATIONS,
+#define PCRDR_OPERATION_BATCHOPERATIONS     "batchOperations"
 
     /* XXX: change this when you append a new operation */
-    PCRDR_K_OPERATION_LAST = PCRDR_K_OPERATION_SETPROPERTY,
+    PCRDR_K_OPERATION_LAST = PCRDR_K_OPERATION_BATCHOPERATIONS,
 };
 
 #define PCRDR_NR_OPERATIONS \
@@ -175,6 +182,9 @@ enum {
 #define PCRDR_DEF_PACKET_BUFF_SIZE      1024
 #define PCRDR_DEF_TIME_EXPECTED         5   /* 5 seconds */
 
+/* the default number of requests in flight on a connection at most */
+#define PCRDR_DEF_INFLIGHT_REQUESTS     32
+
 /* the maximal size of a payload in a frame (4KiB) */
 #define PCRDR_MAX_FRAME_PAYLOAD_SIZE    4096
 
@@ -471,6 +481,35 @@ pcrdr_conn_set_poll_timeout(pcrdr_conn* conn, int timeout_ms);
 PCA_EXPORT size_t
 pcrdr_conn_pending_requests_count(pcrdr_conn* conn);
 
+/**
+ * Set the number of requests allowed in flight on a connection at most.
+ *
+ * @param conn: the pointer to the renderer connection.
+ * @param max: the number of requests in flight at most; 0 for no limit.
+ *
+ * When the limit is reached, sending a request waits for the responses
+ * to the pending requests first.
+ *
+ * Returns the old limit.
+ *
+ * Since: 0.9.0
+ */
+PCA_EXPORT size_t
+pcrdr_conn_set_max_inflight_requests(pcrdr_conn* conn, size_t max);
+
+/**
+ * Get the number of requests which can be sent without waiting.
+ *
+ * @param conn: the pointer to the renderer connection.
+ *
+ * Returns the number of the requests can be sent before reaching the
+ * in-flight limit; SIZE_MAX if there is no limit.
+ *
+ * Since: 0.9.0
+ */
+PCA_EXPORT size_t
+pcrdr_conn_inflight_credits(pcrdr_conn* conn);
+
 /**
  * Get the server host name of a connection.
  *
@@ -870,10 +909,29 @@ typedef ssize_t (*pcrdr_cb_write)(void *ctxt, const void *buf, size_t count);
 PCA_EXPORT int
 pcrdr_serialize_message(const pcrdr_msg *msg, pcrdr_cb_write fn, void *ctxt);
 
+/**
+ * Serialize a message in the binary framing.
+ *
+ * @param msg: the pointer to the message to serialize.
+ * @param fn: the callback to write characters.
+ * @param ctxt: the context will be passed to fn.
+ *
+ * Serializes a message in the binary framing, which is sent only to
+ * a renderer announcing the capability `binaryFraming`.
+ * `pcrdr_parse_packet()` parses a packet in either framing.
+ *
+ * Returns: zero on success; an error code on failure.
+ *
+ * Since: 0.9.0
+ */
+PCA_EXPORT int
+pcrdr_serialize_message_binary(const pcrdr_msg *msg,
+        pcrdr_cb_write fn, void *ctxt);
+
 /**
  * Serialize a message to buffer.
  *
- * @param msg: the poiter to the message to serialize.
+ * @param msg: the pointer to the message to serialize.
  * @param buff: the pointer to the buffer.
  * @param sz: the size of the buffer.
  *
@@ -886,6 +944,18 @@ PCA_EXPORT size_t
 pcrdr_serialize_message_to_buffer(const pcrdr_msg *msg,
         void *buff, size_t sz);
 
+/**
+ * Get the name of a data type of message.
+ *
+ * @param data_type: the data type.
+ *
+ * Returns: the name of the data type, e.g., `json`; NULL for a bad type.
+ *
+ * Since: 0.9.0
+ */
+PCA_EXPORT const char *
+pcrdr_data_type_name(pcrdr_msg_data_type data_type);
+
 /**
  * Compare two messages.
  *
@@ -1083,7 +1153,15 @@ pcrdr_ping_renderer(pcrdr_conn* conn);
  * @param runner_name: the runner name.
  * @param conn: the pointer to a pcrdr_conn* to return the renderer connection.
  *
- * Connects to a headless renderer.
+ * Connects to a headless renderer. The renderer writes all messages
+ * to the log file specified by a `file://` URI, or the default log file
+ * if @renderer_uri is NULL.
+ *
+ * If @renderer_uri is `PCRDR_HEADLESS_URI_NOLOG`, the renderer maintains
+ * the workspaces, windows, and DOM handles as usual but writes no log.
+ * If @renderer_uri is `PCRDR_HEADLESS_URI_NULL`, the renderer only counts
+ * the messages and acknowledges every request immediately with a new handle.
+ * The two modes are intended for measuring the throughput of interpreter.
  *
  * Returns: The initial response message; NULL on error.
  *
@@ -1208,6 +1286,23 @@ PCA_EXPORT int
 pcrdr_purcmc_send_text_packet(pcrdr_conn* conn,
         const char *text, size_t txt_len);
 
+/**
+ * Send a binary packet to the PurCMC server.
+ *
+ * @param conn: the pointer to the renderer connection.
+ * @param data: the pointer to the data to send.
+ * @param len: the length to send.
+ *
+ * Sends a binary packet to the PurCMC server.
+ *
+ * Returns: -1 for error; zero means everything is ok.
+ *
+ * Since: 0.9.0
+ */
+PCA_EXPORT int
+pcrdr_purcmc_send_binary_packet(pcrdr_conn* conn,
+        const void *data, size_t len);
+
 /**@}*/
 
 /**
@@ -1274,6 +1369,53 @@ purc_inst_destroy_move_buffer(void);
 PCA_EXPORT size_t
 purc_inst_move_message(purc_atom_t inst_to, pcrdr_msg *msg);
 
+/** The statistics of the message pool of an instance. */
+struct purc_msg_pool_stat {
+    /** The number of message structures allocated from the system. */
+    size_t nr_allocated;
+    /** The number of message structures reused from the pool. */
+    size_t nr_reused;
+    /** The number of message structures returned to the system. */
+    size_t nr_freed;
+    /** The number of message structures allocated by the instance and
+        returned by other instances releasing them. */
+    size_t nr_returned;
+    /** The number of message structures in the pool currently. */
+    size_t nr_pooled;
+    /** The maximum number of message structures kept in the pool. */
+    size_t max_pooled;
+};
+
+/**
+ * Get the statistics of the message pool of the current instance.
+ *
+ * The message structures released by `pcrdr_release_message()` are kept
+ * in a pool of the current instance, and reused by the subsequent calls to
+ * the functions making or cloning a message.
+ *
+ * Returns: the pointer to the statistics; NULL if there is no instance
+ *  for the current thread.
+ *
+ * Since: 0.9.0
+ */
+PCA_EXPORT const struct purc_msg_pool_stat *
+purc_inst_msg_pool_stat(void);
+
+/**
+ * Set the maximum number of message structures kept in the message pool
+ * of the current instance.
+ *
+ * @param max_pooled: the new maximum number; 0 disables the pool.
+ *
+ * The pooled messages exceeding the new maximum number will be freed.
+ *
+ * Returns: the old maximum number.
+ *
+ * Since: 0.9.0
+ */
+PCA_EXPORT size_t
+purc_inst_set_msg_pool_size(size_t max_pooled);
+
 /**
  * Get the number of messages holding in the move buffer of the current
  * instance.
@@ -1288,6 +1430,24 @@ purc_inst_move_message(purc_atom_t inst_to, pcrdr_msg *msg);
 PCA_EXPORT int
 purc_inst_holding_messages_count(size_t *count);
 
+/**
+ * Wait for messages to arrive in the move buffer of the current instance.
+ *
+ * @param timeout_ms: the maximum time to wait in milliseconds; 0 for
+ *  checking without waiting, and a negative value for waiting forever.
+ * @param count: the buffer to receive the number of the messages waiting
+ *  to take away; 0 if the time expired.
+ *
+ * Unlike polling purc_inst_holding_messages_count(), this function returns
+ * as soon as another thread moves a message to the buffer.
+ *
+ * Returns: 0 for success, otherwise the error code.
+ *
+ * Since: 0.9.0
+ */
+PCA_EXPORT int
+purc_inst_wait_for_messages(int timeout_ms, size_t *count);
+
 /**
  * Retrieve a message in the move buffer of the current instance.
  *
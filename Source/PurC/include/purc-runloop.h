@@ -40,6 +40,19 @@ typedef enum purc_runloop_io_event
     PCRUNLOOP_IO_NVAL = 0x20,
 } purc_runloop_io_event;
 
+/** The backends to monitor file descriptors. */
+typedef enum purc_runloop_fdmon
+{
+    /** Let the runloop (GLib) monitor every file descriptor. */
+    PCRUNLOOP_FDMON_GLIB = 0,
+    /**
+     * Monitor all file descriptors with one epoll instance, and dispatch
+     * the ready ones in a batch; only available on Linux, falls back
+     * to PCRUNLOOP_FDMON_GLIB on other systems.
+     */
+    PCRUNLOOP_FDMON_EPOLL,
+} purc_runloop_fdmon;
+
 PCA_EXTERN_C_BEGIN
 
 /**
@@ -134,6 +147,24 @@ PCA_EXPORT
 void purc_runloop_set_idle_func(purc_runloop_t runloop, purc_runloop_func func,
         void *ctxt);
 
+/**
+ * Park the idle function of the runloop.
+ *
+ * @param runloop: the runloop.
+ * @param timeout_ms: the maximal time to park in millisecond; a negative
+ *      value means parking until the runloop is woken up.
+ *
+ * The idle function will not be called until the timeout elapses, or any
+ * dispatched function, timer, or file descriptor monitor of the runloop
+ * has been fired, or purc_runloop_wakeup() is called (from any thread).
+ *
+ * Returns: void
+ *
+ * Since: 0.8.1
+ */
+PCA_EXPORT
+void purc_runloop_park_idle_func(purc_runloop_t runloop, long timeout_ms);
+
 typedef bool (*purc_runloop_io_callback)(int fd,
         purc_runloop_io_event event, void *ctxt);
 
@@ -70,6 +70,53 @@ purc_rwstream_t purc_rwstream_new_buffer (size_t sz_init, size_t sz_max);
  */
 PCA_EXPORT purc_rwstream_t purc_rwstream_new_from_mem (void* mem, size_t sz);
 
+typedef void (*pcrws_cb_release)(void *ctxt);
+
+/**
+ * Creates a new read-only purc_rwstream_t for the given memory buffer
+ * which is owned by someone else, for example, a shared memory segment.
+ * The callback @release will be called with @ctxt when the rwstream is
+ * destroyed, so that the owner can release the memory.
+ *
+ * The memory can not be reserved via purc_rwstream_get_mem_buffer_ex().
+ *
+ * @param mem: pointer to memory buffer
+ * @param sz:  size of memory buffer
+ * @param release: (nullable): the callback to release the memory
+ * @param ctxt: the context passed to @release
+ *
+ * @return A purc_rwstream_t on success, @NULL on failure and the error code
+ *         is set to indicate the error. The error code:
+ *  - @PURC_ERROR_INVALID_VALUE: Invalid value
+ *  - @PURC_ERROR_OUT_OF_MEMORY: Out of memory
+ *
+ * Since: 0.9.0
+ */
+PCA_EXPORT purc_rwstream_t purc_rwstream_new_from_mem_ex (const void* mem,
+        size_t sz, pcrws_cb_release release, void *ctxt);
+
+/**
+ * Creates a new purc_rwstream_t which keeps the written content in a list
+ * of chunks (a rope) rather than a contiguous buffer, so the content
+ * written is never copied again when the stream grows. The sizes of
+ * the chunks double from @sz_chunk up to 1 MiB.
+ *
+ * The content is made contiguous only when
+ * purc_rwstream_get_mem_buffer_ex() is called; it can be written to
+ * a file descriptor by purc_rwstream_dump_to_fd() without copying.
+ *
+ * @param sz_chunk: the size of the first chunk; 0 for the default one.
+ * @param sz_max: the maximal size of the content; 0 for no limit.
+ *
+ * @return A purc_rwstream_t on success, @NULL on failure and the error code
+ *         is set to indicate the error. The error code:
+ *  - @PURC_ERROR_OUT_OF_MEMORY: Out of memory
+ *
+ * Since: 0.9.0
+ */
+PCA_EXPORT purc_rwstream_t
+purc_rwstream_new_rope (size_t sz_chunk, size_t sz_max);
+
 /**
  * Creates a new purc_rwstream_t for the given file and mode.
  *
@@ -87,6 +134,26 @@ PCA_EXPORT purc_rwstream_t purc_rwstream_new_from_mem (void* mem, size_t sz);
 PCA_EXPORT purc_rwstream_t
 purc_rwstream_new_from_file (const char* file, const char* mode);
 
+/**
+ * Creates a new read-only purc_rwstream_t which maps the given regular file
+ * into memory. The content of the file can be got by calling
+ * purc_rwstream_get_mem_buffer_ex() without copying, but can not be taken
+ * over. The file is unmapped when the stream is destroyed.
+ *
+ * @param file: the file will be mapped
+ *
+ * @return A purc_rwstream_t on success, @NULL on failure and the error code
+ *         is set to indicate the error. The error code:
+ *  - @PURC_ERROR_BAD_SYSTEM_CALL: Bad system call
+ *  - @PURC_ERROR_NOT_SUPPORTED: Not a regular file
+ *  - @PURC_ERROR_OUT_OF_MEMORY: Out of memory
+ *  - @PURC_ERROR_NOT_IMPLEMENTED: Not implemented
+ *
+ * Since: 0.9.0
+ */
+PCA_EXPORT purc_rwstream_t
+purc_rwstream_new_from_mmap (const char* file);
+
 /**
  * Creates a new purc_rwstream_t for the given FILE pointer.
  *
@@ -347,6 +414,24 @@ PCA_EXPORT ssize_t purc_rwstream_flush (purc_rwstream_t rws);
 PCA_EXPORT ssize_t purc_rwstream_dump_to_another (purc_rwstream_t in,
         purc_rwstream_t out, ssize_t count);
 
+/**
+ * Writes the content of a rwstream from the current position to the end
+ * into a file descriptor. The chunks of a rope are written by writev()
+ * without copying.
+ *
+ * @param in: the rwstream to read.
+ * @param fd: the file descriptor to write.
+ *
+ * @return The number of the bytes written, -1 otherwise and the error code
+ *         is set to indicate the error. The error code:
+ *  - @PURC_ERROR_INVALID_VALUE: Invalid value
+ *  - @PURC_ERROR_NOT_IMPLEMENTED: Not implemented
+ *  - The error code mapped from errno of write()
+ *
+ * Since: 0.9.0
+ */
+PCA_EXPORT ssize_t purc_rwstream_dump_to_fd (purc_rwstream_t in, int fd);
+
 /**
  * Get the pointer and size of the rwstream whose type is memory (Created by
  * purc_rwstream_new_buffer or purc_rwstream_new_from_mem).
@@ -446,6 +446,37 @@ static inline bool purc_atom_remove_string(const char* string) {
 PCA_EXPORT const char*
 purc_atom_to_string(purc_atom_t atom);
 
+/** The statistics of an atom bucket. */
+struct purc_atom_stat {
+    /** The number of the atoms. */
+    size_t nr_atoms;
+    /** The number of the strings removed but kept. */
+    size_t nr_removed;
+    /** The number of the slots of the hash table. */
+    size_t nr_slots;
+    /** The number of the slots having any string. */
+    size_t nr_used_slots;
+    /** The length of the longest chain of a slot. */
+    size_t max_chain_len;
+    /** The times the hash table was enlarged. */
+    size_t nr_resizes;
+};
+
+/**
+ * purc_atom_bucket_stat:
+ * @bucket: the identifier of the atom bucket.
+ * @stat: the buffer to receive the statistics.
+ *
+ * Gets the statistics of the hash table of the specified atom bucket.
+ * All zeros for a bucket not used yet.
+ *
+ * Returns: %TRUE on success; %FALSE if @bucket is invalid.
+ *
+ * Since: 0.9.0
+ */
+PCA_EXPORT bool
+purc_atom_bucket_stat(int bucket, struct purc_atom_stat *stat);
+
 /**
  * SECTION: misc_utils
  * @title: Misc. Utilities
@@ -507,6 +538,10 @@ typedef struct pcutils_arrlist pcutils_arrlist;
  *
  * VW: @free_fn is nullable.
  *
+ * The slots of an initial size not greater than ARRAY_LIST_DEFAULT_SIZE
+ * are allocated along with the list, so a list which never grows beyond
+ * its initial size costs one allocation only.
+ *
  * @see pcutils_arrlist_shrink
  */
 PCA_EXPORT struct pcutils_arrlist *
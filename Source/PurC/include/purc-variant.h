@@ -242,6 +242,27 @@ PCA_EXPORT purc_variant_t
 purc_variant_make_string_reuse_buff(char* str_utf8, size_t sz_buff,
         bool check_encoding);
 
+/**
+ * Creates a variant value of string type referencing a memory region
+ * mapped by mmap(). The pages from the one containing @str_utf8 to the end
+ * of the string will be unmapped by calling munmap() when the variant is
+ * destroyed.
+ *
+ * @param str_utf8: the pointer of a string which is in UTF-8 encoding;
+ *      `str_utf8[len]` must be a null byte in the mapped region.
+ * @param len: the length of the string in bytes.
+ * @param check_encoding: whether check str_utf8 in UTF-8 encoding.
+ *
+ * Returns: A purc_variant_t with string type,
+ *      or PURC_VARIANT_INVALID on failure; the region is not unmapped
+ *      on failure.
+ *
+ * Since: 0.2.0
+ */
+PCA_EXPORT purc_variant_t
+purc_variant_make_string_mapped(const char* str_utf8, size_t len,
+        bool check_encoding);
+
 /**
  * Creates a variant value of string type by using non-null-terminated buffer
  *
@@ -423,6 +444,24 @@ PCA_EXPORT purc_variant_t
 purc_variant_make_byte_sequence_reuse_buff(void* bytes, size_t nr_bytes,
         size_t sz_buff);
 
+/**
+ * Creates a variant value of byte sequence type referencing a memory
+ * region mapped by mmap(). The pages from the one containing @bytes to
+ * the end of the sequence will be unmapped by calling munmap() when the
+ * variant is destroyed.
+ *
+ * @param bytes: the pointer of a byte sequence.
+ * @param nr_bytes: the number of bytes in sequence.
+ *
+ * Returns: A purc_variant_t with byte sequence type,
+ *      or PURC_VARIANT_INVALID on failure; the region is not unmapped
+ *      on failure.
+ *
+ * Since: 0.2.0
+ */
+PCA_EXPORT purc_variant_t
+purc_variant_make_byte_sequence_mapped(const void* bytes, size_t nr_bytes);
+
 /**
  * Creates an empty byte sequence variant.
  *
@@ -1760,6 +1799,26 @@ typedef enum purc_variant_compare_opt
     PCVARIANT_COMPARE_OPT_CASELESS,
 } purc_vrtcmp_opt_t;
 
+/**
+ * Sets the number of workers to sort a large array or set.
+ *
+ * @param nr_workers: the number of threads to sort the members in parallel
+ *      (at most 64); 0 or 1 to sort in the calling thread only.
+ * @param cutoff: the least number of members to sort in parallel;
+ *      0 for the default (65536).
+ *
+ * Only the sorts comparing the members by the builtin comparisons (by
+ * numbers, or by strings case-sensitively or caselessly) run in parallel;
+ * the keys are extracted from the members in the calling thread, so no
+ * variant is touched by the workers. The setting is process-wide.
+ *
+ * Returns: the number of workers set before.
+ *
+ * Since: 0.2.0
+ */
+PCA_EXPORT unsigned
+purc_variant_set_sort_workers(unsigned nr_workers, size_t cutoff);
+
 /**
  * Compares two variant value
  *
@@ -1919,6 +1978,66 @@ PCA_EXPORT ssize_t
 purc_variant_serialize(purc_variant_t value, purc_rwstream_t stream,
         int indent_level, unsigned int flags, size_t *len_expected);
 
+/**
+ * A flag for the purc_variant_load_from_binary() function which causes
+ * the strings and the byte sequences to reference the bytes in the buffer
+ * instead of copying them. The buffer must not be changed or released
+ * before all the variants loaded from it are destroyed; it is useful for
+ * the data in a memory region mapped by mmap() and kept for the life
+ * of the process.
+ */
+#define PCVARIANT_BINARY_OPT_ZERO_COPY                  0x00000001
+
+/**
+ * Serializes a variant value in the binary eJSON encoding, which is
+ * compact, self-describing, and keeps the types the text eJSON loses,
+ * e.g., the tuples, the sets with unique keys, and the long doubles.
+ * A dynamic or native value is serialized as null.
+ *
+ * @param value: the variant value to be serialized.
+ * @param stream: the stream to which the serialized data write.
+ * @param flags: the serialization flags; reserved, should be 0.
+ *
+ * Returns: The size of the serialized data written to the stream;
+ * on error, -1 is returned, and error code is set to indicate
+ * the cause of the error.
+ *
+ * Since: 0.9.0
+ */
+PCA_EXPORT ssize_t
+purc_variant_serialize_binary(purc_variant_t value, purc_rwstream_t stream,
+        unsigned int flags);
+
+/**
+ * Loads a variant value from the data made by
+ * purc_variant_serialize_binary().
+ *
+ * @param data: the pointer to the data.
+ * @param sz: the size of the data in bytes.
+ * @param flags: the loading flags, 0 or PCVARIANT_BINARY_OPT_ZERO_COPY.
+ *
+ * Returns: A purc_variant_t on success, or PURC_VARIANT_INVALID with
+ * PURC_ERROR_INVALID_VALUE if the data are malformed.
+ *
+ * Since: 0.9.0
+ */
+PCA_EXPORT purc_variant_t
+purc_variant_load_from_binary(const void *data, size_t sz,
+        unsigned int flags);
+
+/**
+ * Loads a variant value from a stream which contains the data made by
+ * purc_variant_serialize_binary(). The stream is read to the end.
+ *
+ * @param stream: the stream of purc_rwstream_t type.
+ *
+ * Returns: A purc_variant_t on success, or PURC_VARIANT_INVALID on failure.
+ *
+ * Since: 0.9.0
+ */
+PCA_EXPORT purc_variant_t
+purc_variant_load_from_binary_stream(purc_rwstream_t stream);
+
 
 #define PURC_ENVV_DVOBJS_PATH   "PURC_DVOBJS_PATH"
 
@@ -2189,6 +2308,16 @@ struct purc_variant_stat {
     size_t sz_total_mem;
     size_t nr_reserved;
     size_t nr_max_reserved;
+
+    /* since 0.8.1: the statistics of the slab allocator */
+    size_t nr_slab_hits;    /* allocations served by recycled chunks */
+    size_t nr_slab_misses;  /* allocations served by fresh chunks */
+    size_t sz_slab_mem;     /* the memory held by the slab */
+
+    /* since 0.8.1: the statistics of the cycle collector */
+    size_t nr_gc_roots;     /* the possible roots of cycles buffered */
+    size_t nr_gc_collected; /* the containers collected in cycles */
+    size_t sz_gc_reclaimed; /* the memory reclaimed by the collector */
 };
 
 /**
@@ -2201,6 +2330,29 @@ struct purc_variant_stat {
 PCA_EXPORT const struct purc_variant_stat *
 purc_variant_usage_stat(void);
 
+#define PURC_ENVV_VARIANT_GC_BUDGET     "PURC_VARIANT_GC_BUDGET"
+
+/**
+ * Collect the cycles of containers
+ *
+ * @param budget_us: the time budget in microseconds; 0 for no limit.
+ *
+ * Collects the containers (arrays, objects, sets, and tuples) which are
+ * referenced only by each other, and so never released by unreferencing.
+ *
+ * The cycle collector of an instance is enabled by setting the environment
+ * variable `PURC_VARIANT_GC_BUDGET` to a positive number of microseconds
+ * before initializing the instance; the scheduler then collects the cycles
+ * when it is idle, in that time budget. Nothing is collected if the
+ * collector is not enabled.
+ *
+ * Returns: the memory reclaimed in bytes.
+ *
+ * Since: 0.8.1
+ */
+PCA_EXPORT size_t
+purc_variant_collect_cycles(unsigned int budget_us);
+
 /**
  * Numberify a variant value to double
  *
@@ -2506,6 +2658,61 @@ PCA_EXPORT bool
 purc_variant_array_insert_another_after(purc_variant_t array,
         int idx, purc_variant_t another, bool silently);
 
+/**
+ * Unite operation on the array: append the members of the source which
+ * are not in the array yet. The members are compared like the elements
+ * of a generic set.
+ *
+ * @param array: the dst array variant
+ * @param src: the value to unite (array, set)
+ * @param silently: @true means ignoring the following errors:
+ *      - PURC_ERROR_INVALID_VALUE
+ *      - PURC_ERROR_WRONG_DATA_TYPE
+ *
+ * Returns: @true on success, otherwise @false.
+ *
+ * Since: 0.9.0
+ */
+PCA_EXPORT bool
+purc_variant_array_unite(purc_variant_t array,
+        purc_variant_t src, bool silently);
+
+/**
+ * Intersection operation on the array: remove the members which are not
+ * in the source, and keep the order of the others.
+ *
+ * @param array: the dst array variant
+ * @param src: the value to intersect (array, set)
+ * @param silently: @true means ignoring the following errors:
+ *      - PURC_ERROR_INVALID_VALUE
+ *      - PURC_ERROR_WRONG_DATA_TYPE
+ *
+ * Returns: @true on success, otherwise @false.
+ *
+ * Since: 0.9.0
+ */
+PCA_EXPORT bool
+purc_variant_array_intersect(purc_variant_t array,
+        purc_variant_t src, bool silently);
+
+/**
+ * Subtraction operation on the array: remove the members which are in
+ * the source.
+ *
+ * @param array: the dst array variant
+ * @param src: the value to subtract (array, set)
+ * @param silently: @true means ignoring the following errors:
+ *      - PURC_ERROR_INVALID_VALUE
+ *      - PURC_ERROR_WRONG_DATA_TYPE
+ *
+ * Returns: @true on success, otherwise @false.
+ *
+ * Since: 0.9.0
+ */
+PCA_EXPORT bool
+purc_variant_array_subtract(purc_variant_t array,
+        purc_variant_t src, bool silently);
+
 /**
  * Unite operation on the set
  *
@@ -2632,6 +2839,38 @@ purc_variant_container_clone(purc_variant_t ctnr);
 PCA_EXPORT purc_variant_t
 purc_variant_container_clone_recursively(purc_variant_t ctnr);
 
+/**
+ * The callback to visit a member of a container; @key is the key of
+ * the member in an object, and PURC_VARIANT_INVALID for other containers.
+ * Return 0 to continue, or any other value to stop the scan.
+ */
+typedef int (*purc_variant_member_cb)(void *ctxt, size_t idx,
+        purc_variant_t key, purc_variant_t member);
+
+/**
+ * Scans the members of a container (object, array, set, or tuple) for
+ * reading. The keys and members are borrowed: no reference count is
+ * changed and no iterator is made. The container is pinned while
+ * scanning, that is, any change to it fails with PURC_ERROR_ACCESS_DENIED,
+ * and the caller should hold a reference to it.
+ *
+ * The members of an object are scanned in the order of the keys, and
+ * the members of a set in the order of the indexes.
+ *
+ * @param ctnr: the container variant.
+ * @param cb: the callback to visit a member.
+ * @param ctxt: the context passed to the callback.
+ *
+ * Returns: 0 if all members are scanned, the value returned by @cb if
+ *  the scan is stopped, or -1 with PURC_ERROR_WRONG_DATA_TYPE if @ctnr
+ *  is not a container.
+ *
+ * Since: 0.8.1
+ */
+PCA_EXPORT int
+purc_variant_container_scan(purc_variant_t ctnr,
+        purc_variant_member_cb cb, void *ctxt);
+
 struct purc_ejson_parse_tree;
 
 /**
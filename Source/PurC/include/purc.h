@@ -96,6 +96,104 @@ typedef struct purc_instance_extra_info {
      */
     const char      *workspace_layout;
 
+    /**
+     * The backend to monitor the file descriptors of streams:
+     *  - PCRUNLOOP_FDMON_GLIB:
+     *      Use the runloop (GLib), the default one.
+     *  - PCRUNLOOP_FDMON_EPOLL:
+     *      Use epoll and dispatch the ready file descriptors in a batch
+     *      (Linux only; Since 0.8.1).
+     */
+    purc_runloop_fdmon  fd_monitor;
+
+    /**
+     * Whether to keep the VCM trees of the attributes in a vDOM packed
+     * in a compact binary form, and unpack one only when the attribute
+     * is evaluated the first time. This saves the memory used by the
+     * attributes which are never evaluated, and the time to load a vDOM
+     * from a cache (Since 0.8.1).
+     */
+    bool            lazy_attr_vcm;
+
+    /**
+     * The file to write the timeline of the instance to, in the JSON Array
+     * Format of the Trace Event Format, which can be loaded by Perfetto or
+     * `chrome://tracing`. The instances may share a file: the events are
+     * appended when an instance is cleaned up. If it is NULL, the value
+     * of the environment variable `PURC_TIMELINE_FILE` is used; no timeline
+     * is recorded if neither is given (Since 0.9.0).
+     */
+    const char      *timeline_file;
+
+    /**
+     * The number of the latest events of the timeline kept in the ring
+     * buffer; 0 for the value of the environment variable
+     * `PURC_TIMELINE_SIZE`, or 16384 by default (Since 0.9.0).
+     */
+    size_t          timeline_size;
+
+    /**
+     * The file to append the samples of the HVML stacks of the coroutines
+     * to, in the folded format of the flame graph tools, one line a stack:
+     * `<runner>;<tag>:<line>;...;<tag>:<line> <count>`. If it is NULL, the
+     * value of the environment variable `PURC_PROFILE_FILE` is used; there
+     * is no sampling if neither is given (Since 0.9.0).
+     */
+    const char      *profile_file;
+
+    /**
+     * The sampling interval in microseconds; 0 for the value of the
+     * environment variable `PURC_PROFILE_INTERVAL`, or 1000 by default
+     * (Since 0.9.0).
+     */
+    unsigned int    profile_interval;
+
+    /**
+     * The default soft and hard limits of the memory in bytes charged to
+     * a coroutine: the variants made by it and the nodes added to its
+     * document; 0 for the values of the environment variables
+     * `PURC_CRTN_MEM_SOFT_LIMIT` and `PURC_CRTN_MEM_HARD_LIMIT`, or no limit
+     * if neither is given. A coroutine going beyond the soft limit gets
+     * a `memory:softLimit` event, and one going beyond the hard limit gets
+     * a `MemoryFailure` exception. The limits of a coroutine can be changed
+     * by `$CRTN.mem_limits` (Since 0.9.0).
+     */
+    size_t          crtn_mem_soft_limit;
+    size_t          crtn_mem_hard_limit;
+
+    /**
+     * The number of the workers of the thread pool which runs the CPU-bound
+     * work, such as sorting a large container, for all instances of the
+     * process; 0 for the value of the environment variable
+     * `PURC_POOL_WORKERS`, or the number of the CPUs online minus one by
+     * default. Only the first instance initialized configures the pool
+     * (Since 0.9.0).
+     */
+    unsigned int    nr_pool_workers;
+
+    /**
+     * The CPUs the workers of the thread pool run on, like `0-3,8`; the
+     * workers are bound to the CPUs in turn, one CPU for a worker (Linux
+     * only). If it is NULL, the value of the environment variable
+     * `PURC_POOL_AFFINITY` is used; the workers are not bound if neither is
+     * given (Since 0.9.0).
+     */
+    const char     *pool_cpu_affinity;
+
+    /**
+     * The CPUs (like `0-3,8`) and the NUMA nodes (like `1`) the thread of
+     * an instance created by @purc_inst_create_or_get runs on: the thread
+     * is bound to the CPUs given which are on the nodes given, before the
+     * instance is initialized, so the variant heap and the move buffer of
+     * the instance are allocated from the memory local to the CPUs; the
+     * first node given is preferred for the memory of the thread as well.
+     * The workers of a runner pool are placed on the nodes given in turn,
+     * one node for a worker. Either can be NULL; the thread is not bound
+     * if both are NULL (Linux only, Since 0.9.0).
+     */
+    const char     *cpu_affinity;
+    const char     *numa_nodes;
+
 } purc_instance_extra_info;
 
 PCA_EXTERN_C_BEGIN
@@ -209,6 +307,27 @@ static inline int purc_init(const char* app_name, const char* runner_name,
     return purc_init_ex(PURC_MODULE_ALL, app_name, runner_name, extra_info);
 }
 
+/**
+ * purc_init_once:
+ *
+ * Runs the initializers of all modules which are called once in a process,
+ * such as the ones making the tables of the keywords, the atoms, and the
+ * error messages, without creating any PurC instance. They are called by
+ * the first call of purc_init_ex() otherwise.
+ *
+ * No thread is created, so a process can call this function then fork
+ * the children which share the tables made copy-on-write, and initialize
+ * a PurC instance in every child.
+ *
+ * Returns: the error code:
+ *  - @PURC_ERROR_OK: success
+ *  - @PURC_ERROR_NO_INSTANCE: failed to initialize a module.
+ *
+ * Since 0.9.0
+ */
+PCA_EXPORT int
+purc_init_once(void);
+
 /**
  * purc_cleanup:
  *
@@ -265,8 +384,8 @@ typedef void (*cb_free_local_data) (void *key, void *local_data);
  *
  *  - `format-double`: This local data contains the format (should be a
  *     pointer to a static string) which will be used to serilize a variant
- *     of double (number) type. If not defined, use the default format
- *     (`%.17g`).
+ *     of double (number) type. If not defined, use the shortest digits
+ *     which are read back as the same number, laid out like `%.17g`.
  *  - `format-long-double`: This local data contains the format (should be
  *     a pointer to a static string), which will be used to serilize a
  *     variant of long double type. If not defined, use the default format
@@ -410,6 +529,139 @@ purc_load_hvml_from_url(const char* url);
 PCA_EXPORT purc_vdom_t
 purc_load_hvml_from_rwstream(purc_rwstream_t stream);
 
+struct purc_hvml_loader;
+typedef struct purc_hvml_loader *purc_hvml_loader_t;
+
+/**
+ * purc_hvml_loader_new:
+ *
+ * Creates a progressive loader of HVML programs, which parses the program
+ * while its contents are coming, for example, from a socket; each piece
+ * is fed by calling @purc_hvml_loader_feed, and all complete tokens in it
+ * are added to the vDOM tree at once.
+ *
+ * Returns: A valid pointer to the loader for success; @NULL for failure.
+ *
+ * Since 0.8.1
+ */
+PCA_EXPORT purc_hvml_loader_t
+purc_hvml_loader_new(void);
+
+/**
+ * purc_hvml_loader_feed:
+ *
+ * @loader: The loader returned by @purc_hvml_loader_new.
+ * @data: The pointer to the next piece of the program.
+ * @sz: The size of the piece in bytes.
+ *
+ * Feeds the next piece of the program to the loader. A piece may end in
+ * the middle of a token, or even a character; the rest will be got from
+ * the next piece.
+ *
+ * Returns: 0 for success; -1 if the program is bad, then the loader can
+ *  only be ended.
+ *
+ * Since 0.8.1
+ */
+PCA_EXPORT int
+purc_hvml_loader_feed(purc_hvml_loader_t loader, const void *data, size_t sz);
+
+/**
+ * purc_hvml_loader_end:
+ *
+ * @loader: The loader returned by @purc_hvml_loader_new.
+ *
+ * Tells the loader there is no more piece of the program, and destroys
+ * the loader.
+ *
+ * Returns: A valid pointer to the vDOM tree for success; @NULL for failure.
+ *
+ * Since 0.8.1
+ */
+PCA_EXPORT purc_vdom_t
+purc_hvml_loader_end(purc_hvml_loader_t loader);
+
+/**
+ * purc_load_hvml_from_cache:
+ *
+ * @data: The pointer to the cache made by @purc_vdom_save_cache.
+ * @sz: The size of the cache in bytes.
+ *
+ * Loads a HVML program from a cache of the vDOM tree without parsing it
+ * again. The cache can be mapped from a file directly; it is not referenced
+ * after this function returns.
+ *
+ * Returns: A valid pointer to the vDOM tree for success; @NULL for failure,
+ *  for example, the cache is broken or made by another version of PurC.
+ *
+ * Since 0.8.1
+ */
+PCA_EXPORT purc_vdom_t
+purc_load_hvml_from_cache(const void *data, size_t sz);
+
+/**
+ * purc_vdom_save_cache:
+ *
+ * @vdom: The vDOM tree returned by one of the purc_load_hvml_from_xxx()
+ *  functions.
+ * @stream: The purc_rwstream object to write the cache to.
+ *
+ * Writes the vDOM tree to the stream in a binary format, which can be
+ * loaded by @purc_load_hvml_from_cache. The format depends on the version
+ * of PurC and the platform.
+ *
+ * Returns: @true for success; @false for failure.
+ *
+ * Since 0.8.1
+ */
+PCA_EXPORT bool
+purc_vdom_save_cache(purc_vdom_t vdom, purc_rwstream_t stream);
+
+/** Deflate the entries of the bundle; not supported without zlib. */
+#define PURC_BUNDLE_FLAG_COMPRESS       0x0001
+/** Add the vDOM caches of the HVML programs (`*.hvml`) to the bundle. */
+#define PURC_BUNDLE_FLAG_VDOM_CACHE     0x0002
+
+/**
+ * purc_bundle_make:
+ *
+ * @dir: The directory of the files of the app.
+ * @file: The path of the bundle file to make.
+ * @flags: The flags of the bundle, a combination of
+ *  @PURC_BUNDLE_FLAG_COMPRESS and @PURC_BUNDLE_FLAG_VDOM_CACHE.
+ *
+ * Makes a bundle of the regular files in @dir and its subdirectories; the
+ * hidden ones are skipped. The bundle has an index of the files, so a file
+ * is got from the mounted bundle without reading others. The vDOM caches
+ * depend on the version of PurC and the platform; a cache not matched is
+ * ignored, and the program is parsed.
+ *
+ * Returns: 0 for success; -1 for failure.
+ *
+ * Since 0.9.0
+ */
+PCA_EXPORT int
+purc_bundle_make(const char *dir, const char *file, unsigned int flags);
+
+/**
+ * purc_bundle_mount:
+ *
+ * @file: The path of the bundle made by @purc_bundle_make.
+ * @app: The name of the app to mount the bundle as.
+ *
+ * Maps the bundle into memory, and serves the files in it as the URLs
+ * `bundle://<app>/<path>` in the process. The program loaded from such
+ * a URL by @purc_load_hvml_from_url uses the vDOM cache in the bundle if
+ * there is one. A bundle is mounted until the process exits.
+ *
+ * Returns: 0 for success; -1 for failure, for example, the bundle is broken
+ *  (@PURC_ERROR_INVALID_VALUE) or @app is mounted (@PURC_ERROR_EXISTS).
+ *
+ * Since 0.9.0
+ */
+PCA_EXPORT int
+purc_bundle_mount(const char *file, const char *app);
+
 /**
  * purc_get_conn_to_renderer:
  *
@@ -497,6 +749,12 @@ typedef struct pcintr_coroutine *purc_coroutine_t;
  * Creates a new coroutine to run the specified vDOM.
  * If success, the new coroutine will be in READY state.
  *
+ * The vDOM is not changed by running it: the states of a run, such as
+ * the scoped variables and the folded values, belong to the coroutine or
+ * the instance, and the VCM trees unpacked or compiled on demand are
+ * published atomically. So a vDOM loaded once can be scheduled by
+ * the coroutines of different instances (threads) at the same time.
+ *
  * Returns: The pointer to the new coroutine, 0 for error.
  *
  * Since 0.2.0
@@ -626,6 +884,46 @@ purc_coroutine_get_variable(purc_coroutine_t cor, const char *name);
 PCA_EXPORT int
 purc_coroutine_dump_stack(purc_coroutine_t cor, purc_rwstream_t stm);
 
+/**
+ * purc_coroutine_snapshot:
+ *
+ * @cor: The pointer to a coroutine structure which representing a coroutine.
+ * @stm: The stream to write the snapshot to.
+ *
+ * Writes a snapshot of the named variables of the coroutine, at the
+ * coroutine level and in the scopes of the elements, to a stream. The
+ * variables of dynamic or native entities are not in the snapshot.
+ *
+ * Returns: 0 for success, -1 for failure.
+ *
+ * Since 0.9.0
+ */
+PCA_EXPORT int
+purc_coroutine_snapshot(purc_coroutine_t cor, purc_rwstream_t stm);
+
+/**
+ * purc_coroutine_restore:
+ *
+ * @cor: The pointer to a coroutine structure which representing a coroutine,
+ *  which is scheduled by @purc_schedule_vdom but has not run yet.
+ * @stm: The stream to read the snapshot made by @purc_coroutine_snapshot.
+ *
+ * Restores the variables in the snapshot to a coroutine running the same
+ * program, for example, after the process restarted. The coroutine-level
+ * variables not bound yet are bound at once; and when the coroutine runs,
+ * an `init` element binds the restored value of its variable instead of
+ * fetching or evaluating the value again. The eDOM is made again by running
+ * the program.
+ *
+ * Returns: 0 for success, -1 for failure, for example, the snapshot is of
+ *  another program (@PURC_ERROR_INVALID_VALUE), or the coroutine has run
+ *  (@PURC_ERROR_WRONG_STAGE).
+ *
+ * Since 0.9.0
+ */
+PCA_EXPORT int
+purc_coroutine_restore(purc_coroutine_t cor, purc_rwstream_t stm);
+
 struct purc_cor_run_info {
     unsigned long   run_idx;
     purc_variant_t  result;
@@ -768,6 +1066,24 @@ purc_get_cond_handler(void);
 PCA_EXPORT purc_cond_handler
 purc_set_cond_handler(purc_cond_handler handler);
 
+/**
+ * purc_set_idle_period:
+ *
+ * @period_ms: The period in milliseconds to fire `idle` events to the
+ *      coroutines observing `$CRTN` for `idle`; zero for the default one
+ *      (100 ms).
+ *
+ * Sets the period of `idle` events of the current PurC instance, and returns
+ * the old one. Note that no `idle` event will be fired, and the instance will
+ * not wake up periodically, if there is no coroutine observing `idle` events.
+ *
+ * Returns: The old period in milliseconds; zero for error.
+ *
+ * Since 0.8.1
+ */
+PCA_EXPORT unsigned int
+purc_set_idle_period(unsigned int period_ms);
+
 /**
  * purc_run:
  *
@@ -834,6 +1150,56 @@ purc_inst_create_or_get(const char *app_name, const char *runner_name,
         purc_cond_handler cond_handler,
         const purc_instance_extra_info* extra_info);
 
+/** The statistics of the pool of the threads of instances. */
+struct purc_inst_pool_stat {
+    /** The number of the threads waiting in the pool. */
+    size_t nr_idle;
+    /** The number of the threads spawned to wait in the pool. */
+    size_t nr_spawned;
+    /** The number of the instances created in the threads of the pool. */
+    size_t nr_reused;
+    /** The number of the threads put back after the instances exited. */
+    size_t nr_recycled;
+};
+
+/**
+ * purc_inst_set_pool:
+ *
+ * @nr_idle: the maximal number of the idle threads kept in the pool.
+ * @recycle: whether to put the thread of an instance back to the pool
+ *      after the instance exits, instead of terminating the thread.
+ *
+ * Configures the pool of the threads for the instances created by
+ * purc_inst_create_or_get(). The instance manager spawns the threads to
+ * wait in the pool when it is idle, and a new instance is initialized in
+ * a thread taken from the pool, which saves the time to create the thread
+ * and its run loop. A recycled thread has cleaned up the former instance
+ * completely, so nothing is shared between the instances run in it.
+ *
+ * Passing zero for @nr_idle terminates the idle threads and disables
+ * the pool.
+ *
+ * Returns: 0 for success.
+ *
+ * Since 0.9.0
+ */
+PCA_EXPORT int
+purc_inst_set_pool(size_t nr_idle, bool recycle);
+
+/**
+ * purc_inst_get_pool_stat:
+ *
+ * @stat: the buffer to return the statistics.
+ *
+ * Gets the statistics of the pool of the threads of instances.
+ *
+ * Returns: 0 for success, -1 for bad argument.
+ *
+ * Since 0.9.0
+ */
+PCA_EXPORT int
+purc_inst_get_pool_stat(struct purc_inst_pool_stat *stat);
+
 /**
  * purc_inst_ask_to_shutdown:
  *
@@ -887,6 +1253,152 @@ purc_inst_schedule_vdom(purc_atom_t inst, purc_vdom_t vdom,
         purc_renderer_extra_info *extra_rdr_info,
         const char *entry);
 
+struct purc_runner_pool;
+typedef struct purc_runner_pool purc_runner_pool;
+typedef struct purc_runner_pool *purc_runner_pool_t;
+
+/**
+ * purc_runner_pool_create:
+ *
+ * @app_name: a pointer to the string contains the app name of the workers.
+ * @runner_prefix: a pointer to the string contains the prefix of the runner
+ *      names of the workers; the workers will be named as `<prefix>0`,
+ *      `<prefix>1`, and so on.
+ * @nr_workers: the number of worker instances; zero for one worker per
+ *      online CPU.
+ * @cond_handler: a pointer to the condition handler for the workers.
+ * @extra_info: a pointer (nullable) to the extra information for the
+ *      worker instances.
+ *
+ * Creates a pool of worker instances. The vDOMs scheduled to the pool by
+ * calling @purc_runner_pool_schedule_vdom will be queued as jobs, and
+ * a job is turned into a coroutine only when a worker picks it up. A worker
+ * having no ready coroutine takes the first job in its own queue, or steals
+ * the last job in the queue of the busiest worker on the same NUMA node,
+ * or of the busiest one on any node if none on the same node has a job.
+ * If `numa_nodes` of @extra_info lists more than one node, the workers are
+ * placed on the nodes in turn.
+ *
+ * Note that the coroutines are never moved between the workers once
+ * they are created.
+ *
+ * Returns: The pointer to the new runner pool, NULL for error.
+ *
+ * Since: 0.8.1
+ */
+PCA_EXPORT purc_runner_pool_t
+purc_runner_pool_create(const char *app_name, const char *runner_prefix,
+        size_t nr_workers, purc_cond_handler cond_handler,
+        const purc_instance_extra_info* extra_info);
+
+/**
+ * purc_runner_pool_schedule_vdom:
+ *
+ * @pool: The pointer to the runner pool.
+ * @vdom: The vDOM entity returned by @purc_load_hvml_from_rwstream or
+ *  its brother functions.
+ * @request: The variant (nullable) which will be used as the request data.
+ *  The variant will be moved to the move heap, so do not change it after
+ *  calling this function.
+ * @entry: The identifier of the `body` element as the entry in @vdom.
+ *         When @NULL is given, use the first `body` element as the entry.
+ *
+ * Queues a job to run the specified vDOM in one of the workers of the pool.
+ * The new coroutine will use `null` as the renderer page type. An idle
+ * worker is preferred; if there is no idle worker, the job will be queued
+ * to the worker having the least pending jobs.
+ *
+ * Returns: 0 for success, -1 for error.
+ *
+ * Since: 0.8.1
+ */
+PCA_EXPORT int
+purc_runner_pool_schedule_vdom(purc_runner_pool_t pool, purc_vdom_t vdom,
+        purc_variant_t request, const char *entry);
+
+/**
+ * purc_runner_pool_schedule_vdom_ex:
+ *
+ * @pool: The pointer to the runner pool.
+ * @vdom: The vDOM entity returned by @purc_load_hvml_from_rwstream or
+ *  its brother functions.
+ * @request: The variant (nullable) which will be used as the request data.
+ * @entry: The identifier of the `body` element as the entry in @vdom.
+ * @user_data: The pointer to the initial user data of the new coroutine,
+ *  which can be got by calling @purc_coroutine_get_user_data in the
+ *  condition handler of the workers.
+ *
+ * The same as @purc_runner_pool_schedule_vdom, but with the user data of
+ * the new coroutine.
+ *
+ * Returns: 0 for success, -1 for error.
+ *
+ * Since: 0.9.0
+ */
+PCA_EXPORT int
+purc_runner_pool_schedule_vdom_ex(purc_runner_pool_t pool, purc_vdom_t vdom,
+        purc_variant_t request, const char *entry, void *user_data);
+
+/**
+ * purc_runner_pool_nr_workers:
+ *
+ * @pool: The pointer to the runner pool.
+ *
+ * Returns: the number of workers in the pool.
+ *
+ * Since: 0.8.1
+ */
+PCA_EXPORT size_t
+purc_runner_pool_nr_workers(purc_runner_pool_t pool);
+
+struct purc_runner_pool_stat {
+    /* the runner identifier of the worker; zero if the worker has gone */
+    purc_atom_t rid;
+    /* the number of jobs pending in the queue of the worker */
+    size_t      nr_pending;
+    /* the number of jobs run by the worker */
+    size_t      nr_run;
+    /* the number of jobs (included in nr_run) stolen from other workers */
+    size_t      nr_stolen;
+    /* the number of jobs (included in nr_stolen) stolen from the workers
+       on other NUMA nodes */
+    size_t      nr_stolen_remote;
+    /* the NUMA node the worker runs on */
+    int         node;
+};
+
+/**
+ * purc_runner_pool_get_stat:
+ *
+ * @pool: The pointer to the runner pool.
+ * @idx: The index of the worker.
+ * @stat: The pointer to the buffer to return the statistics.
+ *
+ * Gets the load-balancing statistics of the specific worker.
+ *
+ * Returns: 0 for success, -1 for bad index.
+ *
+ * Since: 0.8.1
+ */
+PCA_EXPORT int
+purc_runner_pool_get_stat(purc_runner_pool_t pool, size_t idx,
+        struct purc_runner_pool_stat *stat);
+
+/**
+ * purc_runner_pool_destroy:
+ *
+ * @pool: The pointer to the runner pool.
+ *
+ * Discards the pending jobs and asks all workers to shutdown.
+ * A worker will quit after all of its coroutines exited.
+ *
+ * Returns: 0 for success, -1 for error.
+ *
+ * Since: 0.8.1
+ */
+PCA_EXPORT int
+purc_runner_pool_destroy(purc_runner_pool_t pool);
+
 #define PURC_EVENT_TARGET_SELF          0
 #define PURC_EVENT_TARGET_BROADCAST     ((purc_atom_t)-1)
 
@@ -903,6 +1415,64 @@ purc_inst_schedule_vdom(purc_atom_t inst, purc_vdom_t vdom,
 PCA_EXPORT int
 purc_inst_post_event(purc_atom_t inst_to, pcrdr_msg *msg);
 
+#define PURC_EVENT_TYPE_TOPIC           "topic"
+
+/**
+ * purc_inst_subscribe_topic:
+ *
+ * @topic: The name of the topic, which should be a valid token.
+ *
+ * Subscribes the current instance to the topic. After this, every data
+ * published to the topic by any instance of the process is delivered to
+ * the move buffer of the current instance as an event message, which is
+ * named `topic:<topic>` and targeted to all coroutines of the instance,
+ * with `RUNNER` as the element, so the coroutines can observe it on
+ * `$RUNNER`. Subscribing to the same topic again has no effect.
+ *
+ * Returns: 0 for success, -1 for error.
+ *
+ * Since: 0.8.1
+ */
+PCA_EXPORT int
+purc_inst_subscribe_topic(const char *topic);
+
+/**
+ * purc_inst_unsubscribe_topic:
+ *
+ * @topic: The name of the topic.
+ *
+ * Unsubscribes the current instance from the topic. An instance is
+ * unsubscribed from all topics when it is cleaned up.
+ *
+ * Returns: 0 for success, -1 for error (@PURC_ERROR_NOT_EXISTS if the
+ *  instance did not subscribe to the topic).
+ *
+ * Since: 0.8.1
+ */
+PCA_EXPORT int
+purc_inst_unsubscribe_topic(const char *topic);
+
+/**
+ * purc_inst_publish_topic:
+ *
+ * @topic: The name of the topic.
+ * @data: The data to publish, or %PURC_VARIANT_INVALID for none.
+ *
+ * Publishes the data to all instances subscribing to the topic, including
+ * the current one if it does. The data is frozen once in the move heap as
+ * an immutable variant (the caller keeps its own reference, and the data
+ * is copied if the caller still holds it), and the messages delivered to
+ * the subscribers all refer to it, so the cost of a delivery does not
+ * depend on the size of the data. The data delivered can not be changed.
+ *
+ * Returns: the number of the instances the data was delivered to, or -1
+ *  for error, e.g., the data holds a native entity.
+ *
+ * Since: 0.8.1
+ */
+PCA_EXPORT ssize_t
+purc_inst_publish_topic(const char *topic, purc_variant_t data);
+
 typedef enum {
     PURC_INST_SIGNAL_CANCEL,
     PURC_INST_SIGNAL_KILL,
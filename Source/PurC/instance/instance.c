@@ -28,6 +28,8 @@
 
 #include "private/instance.h"
 #include "private/errors.h"
+#include "private/log.h"
+#include "private/metrics.h"
 #include "private/tls.h"
 #include "private/utils.h"
 #include "private/ports.h"
@@ -43,9 +45,11 @@
 #include "private/pcrdr.h"
 #include "private/msg-queue.h"
 #include "private/runners.h"
+#include "private/trace.h"
 #include "purc-runloop.h"
 
 #include "../interpreter/internal.h"
+#include "keywords.h"
 
 #include <locale.h>
 #if USE(PTHREADS)          /* { */
@@ -62,63 +66,63 @@
 #define FETCHER_MAX_CONNS        100
 #define FETCHER_CACHE_QUOTA      10240
 
-static struct const_str_atom _except_names[] = {
-    { "OK", 0 },
-    { "BadEncoding", 0 },
-    { "BadHVMLTag", 0 },
-    { "BadHVMLAttrName", 0 },
-    { "BadHVMLAttrValue", 0 },
-    { "BadHVMLContent", 0 },
-    { "BadTargetHTML", 0 },
-    { "BadTargetXGML", 0 },
-    { "BadTargetXML", 0 },
-    { "BadExpression", 0 },
-    { "BadExecutor", 0 },
-    { "BadName", 0 },
-    { "NoData", 0 },
-    { "NotIterable", 0 },
-    { "BadIndex", 0 },
-    { "NoSuchKey", 0 },
-    { "DuplicateKey", 0 },
-    { "ArgumentMissed", 0 },
-    { "WrongDataType", 0 },
-    { "InvalidValue", 0 },
-    { "MaxIterationCount", 0 },
-    { "MaxRecursionDepth", 0 },
-    { "Unauthorized", 0 },
-    { "Timeout", 0 },
-    { "eDOMFailure", 0 },
-    { "LostRenderer", 0 },
-    { "MemoryFailure", 0 },
-    { "InternalFailure", 0 },
-    { "ZeroDivision", 0 },
-    { "Overflow", 0 },
-    { "Underflow", 0 },
-    { "InvalidFloat", 0 },
-    { "AccessDenied", 0 },
-    { "IOFailure", 0 },
-    { "TooSmall", 0 },
-    { "TooMany", 0 },
-    { "TooLong", 0 },
-    { "TooLarge", 0 },
-    { "NotDesiredEntity", 0 },
-    { "InvalidOperand", 0 },
-    { "EntityNotFound", 0 },
-    { "EntityExists", 0 },
-    { "NoStorageSpace", 0 },
-    { "BrokenPipe", 0 },
-    { "ConnectionAborted", 0 },
-    { "ConnectionRefused", 0 },
-    { "ConnectionReset", 0 },
-    { "NameResolutionFailed", 0 },
-    { "RequestFailed", 0 },
-    { "SystemFault", 0 },
-    { "OSFailure", 0 },
-    { "NotReady", 0 },
-    { "NotImplemented", 0 },
-    { "Unsupported", 0 },
-    { "Incompleted", 0 },
-    { "DuplicateName", 0 },
+static const enum pchvml_keyword_enum _except_keywords[] = {
+    PCHVML_KEYWORD_EXCEPT_OK,
+    PCHVML_KEYWORD_EXCEPT_BADENCODING,
+    PCHVML_KEYWORD_EXCEPT_BADHVMLTAG,
+    PCHVML_KEYWORD_EXCEPT_BADHVMLATTRNAME,
+    PCHVML_KEYWORD_EXCEPT_BADHVMLATTRVALUE,
+    PCHVML_KEYWORD_EXCEPT_BADHVMLCONTENT,
+    PCHVML_KEYWORD_EXCEPT_BADTARGETHTML,
+    PCHVML_KEYWORD_EXCEPT_BADTARGETXGML,
+    PCHVML_KEYWORD_EXCEPT_BADTARGETXML,
+    PCHVML_KEYWORD_EXCEPT_BADEXPRESSION,
+    PCHVML_KEYWORD_EXCEPT_BADEXECUTOR,
+    PCHVML_KEYWORD_EXCEPT_BADNAME,
+    PCHVML_KEYWORD_EXCEPT_NODATA,
+    PCHVML_KEYWORD_EXCEPT_NOTITERABLE,
+    PCHVML_KEYWORD_EXCEPT_BADINDEX,
+    PCHVML_KEYWORD_EXCEPT_NOSUCHKEY,
+    PCHVML_KEYWORD_EXCEPT_DUPLICATEKEY,
+    PCHVML_KEYWORD_EXCEPT_ARGUMENTMISSED,
+    PCHVML_KEYWORD_EXCEPT_WRONGDATATYPE,
+    PCHVML_KEYWORD_EXCEPT_INVALIDVALUE,
+    PCHVML_KEYWORD_EXCEPT_MAXITERATIONCOUNT,
+    PCHVML_KEYWORD_EXCEPT_MAXRECURSIONDEPTH,
+    PCHVML_KEYWORD_EXCEPT_UNAUTHORIZED,
+    PCHVML_KEYWORD_EXCEPT_TIMEOUT,
+    PCHVML_KEYWORD_EXCEPT_EDOMFAILURE,
+    PCHVML_KEYWORD_EXCEPT_LOSTRENDERER,
+    PCHVML_KEYWORD_EXCEPT_MEMORYFAILURE,
+    PCHVML_KEYWORD_EXCEPT_INTERNALFAILURE,
+    PCHVML_KEYWORD_EXCEPT_ZERODIVISION,
+    PCHVML_KEYWORD_EXCEPT_OVERFLOW,
+    PCHVML_KEYWORD_EXCEPT_UNDERFLOW,
+    PCHVML_KEYWORD_EXCEPT_INVALIDFLOAT,
+    PCHVML_KEYWORD_EXCEPT_ACCESSDENIED,
+    PCHVML_KEYWORD_EXCEPT_IOFAILURE,
+    PCHVML_KEYWORD_EXCEPT_TOOSMALL,
+    PCHVML_KEYWORD_EXCEPT_TOOMANY,
+    PCHVML_KEYWORD_EXCEPT_TOOLONG,
+    PCHVML_KEYWORD_EXCEPT_TOOLARGE,
+    PCHVML_KEYWORD_EXCEPT_NOTDESIREDENTITY,
+    PCHVML_KEYWORD_EXCEPT_INVALIDOPERAND,
+    PCHVML_KEYWORD_EXCEPT_ENTITYNOTFOUND,
+    PCHVML_KEYWORD_EXCEPT_ENTITYEXISTS,
+    PCHVML_KEYWORD_EXCEPT_NOSTORAGESPACE,
+    PCHVML_KEYWORD_EXCEPT_BROKENPIPE,
+    PCHVML_KEYWORD_EXCEPT_CONNECTIONABORTED,
+    PCHVML_KEYWORD_EXCEPT_CONNECTIONREFUSED,
+    PCHVML_KEYWORD_EXCEPT_CONNECTIONRESET,
+    PCHVML_KEYWORD_EXCEPT_NAMERESOLUTIONFAILED,
+    PCHVML_KEYWORD_EXCEPT_REQUESTFAILED,
+    PCHVML_KEYWORD_EXCEPT_SYSTEMFAULT,
+    PCHVML_KEYWORD_EXCEPT_OSFAILURE,
+    PCHVML_KEYWORD_EXCEPT_NOTREADY,
+    PCHVML_KEYWORD_EXCEPT_NOTIMPLEMENTED,
+    PCHVML_KEYWORD_EXCEPT_UNSUPPORTED,
+    PCHVML_KEYWORD_EXCEPT_INCOMPLETED,
+    PCHVML_KEYWORD_EXCEPT_DUPLICATENAME,
 };
 
 /* Make sure the number of error messages matches the number of error codes */
@@ -129,7 +133,7 @@ _COMPILE_TIME_ASSERT(msgs,
         PCA_TABLESIZE(generic_err_msgs) == PURC_ERROR_NR);
 
 _COMPILE_TIME_ASSERT(excepts,
-        PCA_TABLESIZE(_except_names) == PURC_EXCEPT_NR);
+        PCA_TABLESIZE(_except_keywords) == PURC_EXCEPT_NR);
 
 #undef _COMPILE_TIME_ASSERT
 
@@ -139,10 +143,11 @@ static struct err_msg_seg _generic_err_msgs_seg = {
     generic_err_msgs,
 };
 
+/* the exception names are all the static strings of ATOM_BUCKET_EXCEPT */
 bool purc_is_except_atom (purc_atom_t atom)
 {
-    if (atom < _except_names[0].atom ||
-            atom > _except_names[PURC_EXCEPT_NR - 1].atom)
+    if (atom < PCATOM_STATIC(ATOM_BUCKET_EXCEPT, 1) ||
+            atom > PCATOM_STATIC(ATOM_BUCKET_EXCEPT, PURC_EXCEPT_NR))
         return false;
 
     return true;
@@ -150,35 +155,12 @@ bool purc_is_except_atom (purc_atom_t atom)
 
 purc_atom_t purc_get_except_atom_by_id (int id)
 {
-    if (id < PURC_EXCEPT_NR)
-        return _except_names[id].atom;
+    if (id >= 0 && id < PURC_EXCEPT_NR)
+        return pchvml_keyword(_except_keywords[id]);
 
     return 0;
 }
 
-static int
-except_init_once(void)
-{
-    for (size_t n = 0; n < PURC_EXCEPT_NR; n++) {
-        _except_names[n].atom =
-            purc_atom_from_static_string_ex(ATOM_BUCKET_EXCEPT,
-                _except_names[n].str);
-
-        if (!_except_names[n].atom)
-            return -1;
-    }
-
-    return 0;
-}
-
-struct pcmodule _module_except = {
-    .id              = PURC_HAVE_UTILS,
-    .module_inited   = 0,
-
-    .init_once       = except_init_once,
-    .init_instance   = NULL,
-};
-
 #if 0
 locale_t __purc_locale_c;
 static void free_locale_c(void)
@@ -198,6 +180,7 @@ locale_init_once(void)
 }
 
 struct pcmodule _module_locale = {
+    .name            = "locale",
     .id              = PURC_HAVE_UTILS,
     .module_inited   = 0,
 
@@ -213,6 +196,7 @@ errmsg_init_once(void)
 }
 
 struct pcmodule _module_errmsg = {
+    .name            = "error-message",
     .id              = PURC_HAVE_UTILS,
     .module_inited   = 0,
 
@@ -220,15 +204,19 @@ struct pcmodule _module_errmsg = {
     .init_instance   = NULL,
 };
 
+extern struct pcmodule _module_log;
 extern struct pcmodule _module_atom;
-extern struct pcmodule _module_keywords;
+extern struct pcmodule _module_metrics;
+extern struct pcmodule _module_threadpool;
 extern struct pcmodule _module_runloop;
 extern struct pcmodule _module_rwstream;
 extern struct pcmodule _module_dom;
 extern struct pcmodule _module_html;
 extern struct pcmodule _module_variant;
 extern struct pcmodule _module_mvheap;
+extern struct pcmodule _module_shared_data;
 extern struct pcmodule _module_mvbuf;
+extern struct pcmodule _module_topics;
 extern struct pcmodule _module_ejson;
 extern struct pcmodule _module_dvobjs;
 extern struct pcmodule _module_hvml;
@@ -239,13 +227,13 @@ extern struct pcmodule _module_fetcher_remote;
 extern struct pcmodule _module_renderer;
 
 struct pcmodule* _pc_modules[] = {
+    &_module_log,
     &_module_locale,
     &_module_atom,
 
-    &_module_except,
-    &_module_keywords,
-
     &_module_errmsg,
+    &_module_metrics,
+    &_module_threadpool,
 
     &_module_rwstream,
     &_module_dom,
@@ -253,7 +241,9 @@ struct pcmodule* _pc_modules[] = {
 
     &_module_variant,
     &_module_mvheap,
+    &_module_shared_data,
     &_module_mvbuf,
+    &_module_topics,
 
     &_module_ejson,
     &_module_dvobjs,
@@ -323,6 +313,18 @@ struct pcinst* pcinst_current(void)
     return curr_inst;
 }
 
+struct pcinst_alloc_counter *
+pcinst_set_alloc_counter(struct pcinst_alloc_counter *counter)
+{
+    struct pcinst *inst = pcinst_current();
+    if (inst == NULL)
+        return NULL;
+
+    struct pcinst_alloc_counter *old = inst->alloc_counter;
+    inst->alloc_counter = counter;
+    return old;
+}
+
 static void enable_log_on_demand(void)
 {
     const char *env_value;
@@ -345,11 +347,32 @@ static void enable_log_on_demand(void)
     purc_enable_log(true, use_syslog);
 }
 
+static int init_module(struct pcinst *curr_inst, size_t i,
+        const purc_instance_extra_info* extra_info)
+{
+    struct pcmodule *m = _pc_modules[i];
+
+    uint64_t since = pcinst_metrics_now();
+    int ret = m->init_instance(curr_inst, extra_info);
+    uint64_t usecs = (pcinst_metrics_now() - since) / 1000;
+    curr_inst->module_init_usecs[i] =
+        (usecs > UINT32_MAX) ? UINT32_MAX : (uint32_t)usecs;
+
+    if (ret == 0)
+        curr_inst->modules_inited |= m->id;
+    return ret;
+}
+
 static int init_modules(struct pcinst *curr_inst,
         unsigned int modules, const purc_instance_extra_info* extra_info)
 {
+    PC_ASSERT(PCA_TABLESIZE(_pc_modules) <= PCINST_MAX_MODULES);
+
     curr_inst->modules = modules;
     curr_inst->modules_inited = 0;
+    curr_inst->modules_deferred = 0;
+    memset(curr_inst->module_init_usecs, 0,
+            sizeof(curr_inst->module_init_usecs));
 
     curr_inst->max_conns                  = FETCHER_MAX_CONNS;
     curr_inst->cache_quota                = FETCHER_CACHE_QUOTA;
@@ -364,24 +387,108 @@ static int init_modules(struct pcinst *curr_inst,
             continue;
         if (m->init_instance == NULL)
             continue;
-        if (m->init_instance(curr_inst, extra_info)) {
+        if (m->on_demand) {
+            curr_inst->modules_deferred |= 1U << i;
+            continue;
+        }
+        if (init_module(curr_inst, i, extra_info)) {
             abort();
             return PURC_ERROR_OUT_OF_MEMORY;
         }
+    }
 
-        curr_inst->modules_inited |= m->id;
+    curr_inst->init_nr_values = 0;
+    curr_inst->init_sz_mem = 0;
+    if (curr_inst->variant_heap) {
+        const struct purc_variant_stat *stat = purc_variant_usage_stat();
+        curr_inst->init_nr_values = stat->nr_total_values;
+        curr_inst->init_sz_mem = stat->sz_total_mem + stat->sz_slab_mem;
     }
 
     return PURC_ERROR_OK;
 }
 
+int pcinst_init_module_on_demand(struct pcmodule *m)
+{
+    struct pcinst *curr_inst = pcinst_current();
+    if (curr_inst == NULL || curr_inst->modules_deferred == 0)
+        return 0;
+
+    for (size_t i = 0; i < PCA_TABLESIZE(_pc_modules); ++i) {
+        if (_pc_modules[i] != m)
+            continue;
+
+        uint32_t bit = 1U << i;
+        if (!(curr_inst->modules_deferred & bit))
+            break;
+
+        curr_inst->modules_deferred &= ~bit;
+        return init_module(curr_inst, i, NULL) ? -1 : 0;
+    }
+
+    return 0;
+}
+
+purc_variant_t pcinst_make_startup_report(struct pcinst *inst)
+{
+    purc_variant_t modules = purc_variant_make_object_0();
+    if (modules == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    uint64_t total = 0;
+    for (size_t i = 0; inst && i < PCA_TABLESIZE(_pc_modules); ++i) {
+        struct pcmodule *m = _pc_modules[i];
+        if (m->init_instance == NULL ||
+                (m->id & inst->modules) != m->id ||
+                (inst->modules_deferred & (1U << i)))
+            continue;
+
+        total += inst->module_init_usecs[i];
+        purc_variant_t v;
+        v = purc_variant_make_ulongint(inst->module_init_usecs[i]);
+        bool ok = v && purc_variant_object_set_by_static_ckey(modules,
+                m->name, v);
+        PURC_VARIANT_SAFE_CLEAR(v);
+        if (!ok)
+            goto failed;
+    }
+
+    purc_variant_t v = purc_variant_make_ulongint(total);
+    purc_variant_t values = purc_variant_make_ulongint(
+            inst ? inst->init_nr_values : 0);
+    purc_variant_t memory = purc_variant_make_ulongint(
+            inst ? inst->init_sz_mem : 0);
+
+    purc_variant_t report = PURC_VARIANT_INVALID;
+    if (v && values && memory) {
+        report = purc_variant_make_object_by_static_ckey(4,
+                "total", v, "modules", modules,
+                "values", values, "memory", memory);
+    }
+    PURC_VARIANT_SAFE_CLEAR(v);
+    PURC_VARIANT_SAFE_CLEAR(values);
+    PURC_VARIANT_SAFE_CLEAR(memory);
+    purc_variant_unref(modules);
+    return report;
+
+failed:
+    purc_variant_unref(modules);
+    return PURC_VARIANT_INVALID;
+}
+
 static void cleanup_modules(struct pcinst *curr_inst)
 {
     PURC_VARIANT_SAFE_CLEAR(curr_inst->err_exinfo);
 
+    /* no module is initialized on demand while cleaning up */
+    uint32_t deferred = curr_inst->modules_deferred;
+    curr_inst->modules_deferred = 0;
+
     // cleanup modules
     for (size_t i = PCA_TABLESIZE(_pc_modules); i > 0; ) {
         struct pcmodule *m = _pc_modules[--i];
+        if (deferred & (1U << i))
+            continue;
         if (m->cleanup_instance &&
                 (m->id & curr_inst->modules_inited) == m->id) {
             m->cleanup_instance(curr_inst);
@@ -396,6 +503,7 @@ static void cleanup_instance(struct pcinst *curr_inst)
         curr_inst->local_data_map = NULL;
     }
 
+    pclog_cleanup_instance(curr_inst);
     if (curr_inst->fp_log && curr_inst->fp_log != LOG_FILE_SYSLOG) {
         fclose(curr_inst->fp_log);
         curr_inst->fp_log = NULL;
@@ -406,6 +514,8 @@ static void cleanup_instance(struct pcinst *curr_inst)
         curr_inst->bt = NULL;
     }
 
+    pctrace_cleanup_instance(curr_inst);
+
     purc_atom_remove_string_ex(PURC_ATOM_BUCKET_DEF,
             curr_inst->endpoint_name);
 
@@ -419,6 +529,10 @@ static void cleanup_instance(struct pcinst *curr_inst)
         curr_inst->runner_name = NULL;
     }
 
+    curr_inst->lazy_attr_vcm = 0;
+    curr_inst->nr_lazy_attrs = 0;
+    curr_inst->nr_lazy_attrs_compiled = 0;
+
     curr_inst->modules = 0;
     curr_inst->modules_inited = 0;
 }
@@ -460,6 +574,12 @@ pcinst_endpoint_get(char *endpoint_name, size_t sz,
     return atom;
 }
 
+int purc_init_once(void)
+{
+    init_once();
+    return _init_ok ? PURC_ERROR_OK : PURC_ERROR_NO_INSTANCE;
+}
+
 int purc_init_ex(unsigned int modules,
         const char* app_name, const char* runner_name,
         const purc_instance_extra_info* extra_info)
@@ -530,12 +650,16 @@ int purc_init_ex(unsigned int modules,
     curr_inst->endpoint_atom = atom;
 
     enable_log_on_demand();
+    pctrace_init_instance(curr_inst, extra_info);
 
     // map for local data
     curr_inst->local_data_map =
         pcutils_map_create(copy_key_string,
                 free_key_string, NULL, NULL, comp_key_string, false);
 
+    if (extra_info && extra_info->lazy_attr_vcm)
+        curr_inst->lazy_attr_vcm = 1;
+
     int ret = init_modules(curr_inst, modules, extra_info);
     if (ret) {
         cleanup_modules(curr_inst);
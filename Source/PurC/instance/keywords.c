@@ -25,23 +25,7 @@
 #include "keywords.h"
 #include "private/debug.h"
 
-struct pchvml_keyword_cfg {
-    purc_atom_t                 atom;
-    const char                 *keyword;
-};
-
-static void
-keywords_bucket_init(struct pchvml_keyword_cfg *cfgs,
-        size_t start, size_t end, enum pcatom_bucket bucket)
-{
-    struct pchvml_keyword_cfg *cfg = cfgs + start;
-    for (size_t i=start; i<end; ++i) {
-        cfg->atom = purc_atom_from_string_ex(bucket, cfg->keyword);
-        PC_ASSERT(cfg->atom);
-        ++cfg;
-    }
-}
-
+/* the atoms and the static strings of the buckets made at build time */
 #include "keywords.inc"
 
 purc_atom_t pchvml_keyword(enum pchvml_keyword_enum keyword)
@@ -50,8 +34,7 @@ purc_atom_t pchvml_keyword(enum pchvml_keyword_enum keyword)
     if (keyword < 0 || keyword >= nr)
         return 0;
 
-    struct pchvml_keyword_cfg *cfg = keywords + keyword;
-    return cfg->atom;
+    return keywords[keyword];
 }
 
 purc_atom_t pchvml_keyword_try_string(enum pcatom_bucket bucket,
@@ -33,9 +33,827 @@
 #endif /* HAVE_SYSLOG_H */
 
 #include "private/instance.h"
+#include "private/list.h"
+#include "private/log.h"
 #include "private/ports.h"
 
+#include <ctype.h>
 #include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+/*
+ * When the log goes to a file or syslog, the messages are asynchronous by
+ * default (set PURC_LOG_ASYNC to 0 to disable): the calling thread copies
+ * the format string and the arguments it refers to into the ring buffer of
+ * the instance without formatting them, and the thread of the log facility
+ * formats and writes them out every LOG_DRAIN_INTERVAL.
+ *
+ * Only the thread of the instance writes a ring, and it takes no lock; the
+ * lock of a ring is only held while the ring is consumed, by the thread of
+ * the log facility or by the thread of the instance flushing the ring. An
+ * error is flushed before returning, for the program may abort after it.
+ * A message is dropped if the ring is full, and the number of the dropped
+ * messages is logged later.
+ *
+ * A format which cannot be captured (e.g. `%n`, `%m`, or the positional
+ * arguments) is formatted on the calling thread, as the messages logged
+ * to stderr are.
+ */
+
+#define LOG_RING_SIZE       (64 * 1024)     /* must be a power of 2 */
+#define LOG_RING_MASK       (LOG_RING_SIZE - 1)
+#define LOG_MAX_RECORD      2048
+#define LOG_MAX_TAG         63
+#define LOG_MAX_LINE        4096
+#define LOG_MAX_SPEC        32
+#define LOG_DRAIN_INTERVAL  10              /* in milliseconds */
+
+unsigned int pclog_masks[PCLOG_MODULE_NR] = {
+    [0 ... PCLOG_MODULE_NR - 1] = PCLOG_LEVEL_ALL,
+};
+
+static const char *level_tags[] = {
+    "ERROR",
+    "WARN",
+    "INFO",
+    "DEBUG",
+};
+
+/* the names in PURC_LOG_MODULES, in the order of enum pclog_module */
+static const char *module_names[PCLOG_MODULE_NR] = {
+    "generic",
+    "instance",
+    "utils",
+    "variant",
+    "html",
+    "dom",
+    "dvobjs",
+    "vcm",
+    "ejson",
+    "hvml",
+    "vdom",
+    "executors",
+    "interpreter",
+    "fetchers",
+    "pcrdr",
+    "document",
+};
+
+enum {
+    RECORD_CAPTURED = 0,    /* the format followed by the arguments */
+    RECORD_FORMATTED,       /* the text formatted already */
+    RECORD_PADDING,         /* the rest of the buffer to skip */
+};
+
+/* followed by the tag and the format or the text, null-terminated */
+struct log_record {
+    uint32_t    size;       /* including the header; a multiple of 8 */
+    uint8_t     kind;
+    uint8_t     level;
+    uint8_t     tag_len;    /* including the terminating null */
+    uint8_t     reserved;
+};
+
+struct pclog_ring {
+    struct list_head        ln;         /* in `all_rings` */
+    pthread_mutex_t         lock;       /* held while consuming */
+
+    FILE                   *fp;         /* LOG_FILE_SYSLOG for syslog */
+    char                   *ident;
+
+    atomic_size_t           head;       /* written by the producer */
+    atomic_size_t           tail;       /* written by the consumer */
+    atomic_uint_fast64_t    nr_dropped;
+    uint64_t                nr_reported;
+
+    _Alignas(8) unsigned char buf[LOG_RING_SIZE];
+};
+
+/* the rings alive, consumed by the thread of the log facility */
+static pthread_mutex_t rings_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t rings_cond = PTHREAD_COND_INITIALIZER;
+static LIST_HEAD(all_rings);
+static bool consumer_started;
+
+void pclog_set_levels(int module, unsigned int levels)
+{
+    levels &= PCLOG_LEVEL_ALL;
+    if (module < 0) {
+        for (int i = 0; i < PCLOG_MODULE_NR; i++)
+            pclog_masks[i] = levels;
+    }
+    else if (module < PCLOG_MODULE_NR) {
+        pclog_masks[module] = levels;
+    }
+}
+
+static unsigned int level_of_tag(const char *tag)
+{
+    for (size_t i = 0; i < PCA_TABLESIZE(level_tags); i++) {
+        if (strcmp(tag, level_tags[i]) == 0)
+            return 1U << i;
+    }
+
+    return PCLOG_LEVEL_INFO;
+}
+
+static const char *tag_of_level(unsigned int level)
+{
+    for (size_t i = 0; i < PCA_TABLESIZE(level_tags); i++) {
+        if (level & (1U << i))
+            return level_tags[i];
+    }
+
+    return "INFO";
+}
+
+/* parses the levels like `error,warn`, `all`, or `none` */
+static unsigned int parse_levels(const char *str)
+{
+    unsigned int levels = 0;
+    char *tokens = strdup(str);
+    if (tokens == NULL)
+        return PCLOG_LEVEL_ALL;
+
+    char *saveptr;
+    for (char *token = strtok_r(tokens, ", |", &saveptr); token;
+            token = strtok_r(NULL, ", |", &saveptr)) {
+        if (strcasecmp(token, "all") == 0) {
+            levels = PCLOG_LEVEL_ALL;
+            continue;
+        }
+        if (strcasecmp(token, "none") == 0) {
+            levels = 0;
+            continue;
+        }
+
+        for (size_t i = 0; i < PCA_TABLESIZE(level_tags); i++) {
+            if (strcasecmp(token, level_tags[i]) == 0) {
+                levels |= 1U << i;
+                break;
+            }
+        }
+    }
+
+    free(tokens);
+    return levels;
+}
+
+/* enables only the modules like `variant,interpreter` */
+static void set_modules(const char *str, unsigned int levels)
+{
+    char *tokens = strdup(str);
+    if (tokens == NULL)
+        return;
+
+    pclog_set_levels(-1, 0);
+
+    char *saveptr;
+    for (char *token = strtok_r(tokens, ", |", &saveptr); token;
+            token = strtok_r(NULL, ", |", &saveptr)) {
+        for (int i = 0; i < PCLOG_MODULE_NR; i++) {
+            if (strcasecmp(token, module_names[i]) == 0) {
+                pclog_set_levels(i, levels);
+                break;
+            }
+        }
+    }
+
+    free(tokens);
+}
+
+static int log_init_once(void)
+{
+    unsigned int levels = PCLOG_LEVEL_ALL;
+
+    const char *env_value = getenv(PURC_ENVV_LOG_LEVELS);
+    if (env_value)
+        levels = parse_levels(env_value);
+    pclog_set_levels(-1, levels);
+
+    env_value = getenv(PURC_ENVV_LOG_MODULES);
+    if (env_value)
+        set_modules(env_value, levels);
+
+    return 0;
+}
+
+struct pcmodule _module_log = {
+    .name            = "log",
+    .id              = PURC_HAVE_UTILS,
+    .module_inited   = 0,
+
+    .init_once       = log_init_once,
+    .init_instance   = NULL,
+    .cleanup_instance = NULL,
+};
+
+enum arg_type {
+    ARG_NONE = 0,       /* `%%` */
+    ARG_INT,
+    ARG_LONG,
+    ARG_LLONG,
+    ARG_INTMAX,
+    ARG_SIZE,
+    ARG_PTRDIFF,
+    ARG_DOUBLE,
+    ARG_LDOUBLE,
+    ARG_PTR,
+    ARG_STR,
+    ARG_BAD,            /* not supported */
+};
+
+struct conv_spec {
+    const char     *start;
+    const char     *end;
+    bool            star_width;
+    bool            star_prec;
+    enum arg_type   type;
+};
+
+/* parses the conversion specification at @p (a `%`); returns its end */
+static const char *parse_spec(const char *p, struct conv_spec *spec)
+{
+    enum { LEN_NONE, LEN_HH, LEN_H, LEN_L, LEN_LL, LEN_J, LEN_Z, LEN_T,
+        LEN_LD } length = LEN_NONE;
+
+    spec->start = p++;
+    spec->star_width = false;
+    spec->star_prec = false;
+
+    if (*p == '%') {
+        spec->type = ARG_NONE;
+        spec->end = p + 1;
+        return spec->end;
+    }
+
+    while (*p && strchr("-+ #0'", *p))
+        p++;
+
+    if (*p == '*') {
+        spec->star_width = true;
+        p++;
+    }
+    else {
+        while (isdigit((unsigned char)*p))
+            p++;
+    }
+
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            spec->star_prec = true;
+            p++;
+        }
+        else {
+            while (isdigit((unsigned char)*p))
+                p++;
+        }
+    }
+
+    switch (*p) {
+    case 'h':
+        length = (p[1] == 'h') ? LEN_HH : LEN_H;
+        p += (length == LEN_HH) ? 2 : 1;
+        break;
+    case 'l':
+        length = (p[1] == 'l') ? LEN_LL : LEN_L;
+        p += (length == LEN_LL) ? 2 : 1;
+        break;
+    case 'q':
+        length = LEN_LL;
+        p++;
+        break;
+    case 'j':
+        length = LEN_J;
+        p++;
+        break;
+    case 'z':
+        length = LEN_Z;
+        p++;
+        break;
+    case 't':
+        length = LEN_T;
+        p++;
+        break;
+    case 'L':
+        length = LEN_LD;
+        p++;
+        break;
+    }
+
+    spec->type = ARG_BAD;
+    switch (*p) {
+    case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+        switch (length) {
+        case LEN_NONE:
+        case LEN_HH:
+        case LEN_H:
+            spec->type = ARG_INT;
+            break;
+        case LEN_L:
+            spec->type = ARG_LONG;
+            break;
+        case LEN_LL:
+            spec->type = ARG_LLONG;
+            break;
+        case LEN_J:
+            spec->type = ARG_INTMAX;
+            break;
+        case LEN_Z:
+            spec->type = ARG_SIZE;
+            break;
+        case LEN_T:
+            spec->type = ARG_PTRDIFF;
+            break;
+        case LEN_LD:
+            break;
+        }
+        break;
+
+    case 'c':
+        if (length == LEN_NONE)
+            spec->type = ARG_INT;
+        break;
+
+    case 'e': case 'E': case 'f': case 'F':
+    case 'g': case 'G': case 'a': case 'A':
+        if (length == LEN_LD)
+            spec->type = ARG_LDOUBLE;
+        else if (length == LEN_NONE || length == LEN_L)
+            spec->type = ARG_DOUBLE;
+        break;
+
+    case 's':
+        if (length == LEN_NONE)
+            spec->type = ARG_STR;
+        break;
+
+    case 'p':
+        spec->type = ARG_PTR;
+        break;
+
+    default:
+        /* including `%n`, `%m`, the wide characters, and the end */
+        break;
+    }
+
+    if (*p)
+        p++;
+    spec->end = p;
+    if (spec->end - spec->start >= LOG_MAX_SPEC)
+        spec->type = ARG_BAD;
+    return p;
+}
+
+#define PUT_ARG(type, value)                                            \
+    do {                                                                \
+        type _v = (value);                                              \
+        if (len + sizeof(_v) > sz)                                      \
+            return 0;                                                   \
+        memcpy(buf + len, &_v, sizeof(_v));                             \
+        len += sizeof(_v);                                              \
+    } while (0)
+
+/* copies the arguments of @fmt into @buf; returns the length used,
+   or 0 if they cannot be captured */
+static size_t
+capture_args(unsigned char *buf, size_t sz, const char *fmt, va_list ap)
+{
+    size_t len = 0;
+
+    for (const char *p = strchr(fmt, '%'); p; p = strchr(p, '%')) {
+        struct conv_spec spec;
+        p = parse_spec(p, &spec);
+
+        if (spec.type == ARG_BAD)
+            return 0;
+        if (spec.star_width)
+            PUT_ARG(int, va_arg(ap, int));
+        if (spec.star_prec)
+            PUT_ARG(int, va_arg(ap, int));
+
+        switch (spec.type) {
+        case ARG_NONE:
+        case ARG_BAD:
+            break;
+        case ARG_INT:
+            PUT_ARG(int, va_arg(ap, int));
+            break;
+        case ARG_LONG:
+            PUT_ARG(long, va_arg(ap, long));
+            break;
+        case ARG_LLONG:
+            PUT_ARG(long long, va_arg(ap, long long));
+            break;
+        case ARG_INTMAX:
+            PUT_ARG(intmax_t, va_arg(ap, intmax_t));
+            break;
+        case ARG_SIZE:
+            PUT_ARG(size_t, va_arg(ap, size_t));
+            break;
+        case ARG_PTRDIFF:
+            PUT_ARG(ptrdiff_t, va_arg(ap, ptrdiff_t));
+            break;
+        case ARG_DOUBLE:
+            PUT_ARG(double, va_arg(ap, double));
+            break;
+        case ARG_LDOUBLE:
+            PUT_ARG(long double, va_arg(ap, long double));
+            break;
+        case ARG_PTR:
+            PUT_ARG(void *, va_arg(ap, void *));
+            break;
+        case ARG_STR: {
+            const char *str = va_arg(ap, const char *);
+            if (str == NULL)
+                str = "(null)";
+            size_t str_len = strlen(str) + 1;
+            if (len + str_len > sz)
+                return 0;
+            memcpy(buf + len, str, str_len);
+            len += str_len;
+            break;
+        }
+        }
+    }
+
+    /* not zero for a format without any argument */
+    if (len == 0 && sz > 0) {
+        buf[0] = 0;
+        len = 1;
+    }
+    return len;
+}
+
+#undef PUT_ARG
+
+#define GET_ARG(type, var)                                              \
+    type var;                                                           \
+    do {                                                                \
+        if (args_len < sizeof(var))                                     \
+            goto done;                                                  \
+        memcpy(&var, args, sizeof(var));                                \
+        args += sizeof(var);                                            \
+        args_len -= sizeof(var);                                        \
+    } while (0)
+
+#define FORMAT_ARG(type)                                                \
+    do {                                                                \
+        GET_ARG(type, v);                                               \
+        n = snprintf(text + len, sz - len, conv, v);                    \
+    } while (0)
+
+/* formats the format @fmt with the arguments captured in @args */
+static void
+format_args(char *text, size_t sz, const char *fmt,
+        const unsigned char *args, size_t args_len)
+{
+    size_t len = 0;
+    const char *p = fmt;
+
+    while (*p && len < sz - 1) {
+        const char *next = strchr(p, '%');
+        size_t n_literal = next ? (size_t)(next - p) : strlen(p);
+        if (n_literal > 0) {
+            if (n_literal > sz - 1 - len)
+                n_literal = sz - 1 - len;
+            memcpy(text + len, p, n_literal);
+            len += n_literal;
+            p += n_literal;
+            continue;
+        }
+
+        struct conv_spec spec;
+        p = parse_spec(p, &spec);
+        if (spec.type == ARG_NONE) {
+            text[len++] = '%';
+            continue;
+        }
+
+        /* substitute the widths and the precisions given as arguments */
+        char conv[LOG_MAX_SPEC * 2];
+        size_t conv_len = 0;
+        for (const char *q = spec.start; q < spec.end; q++) {
+            if (*q != '*') {
+                conv[conv_len++] = *q;
+                continue;
+            }
+
+            GET_ARG(int, value);
+            if (q > spec.start && q[-1] == '.') {
+                if (value < 0) {
+                    /* as if the precision is omitted */
+                    conv_len--;
+                    continue;
+                }
+            }
+            conv_len += snprintf(conv + conv_len, sizeof(conv) - conv_len,
+                    "%d", value);
+        }
+        conv[conv_len] = 0;
+
+        int n = 0;
+        switch (spec.type) {
+        case ARG_NONE:
+        case ARG_BAD:
+            goto done;
+        case ARG_INT:
+            FORMAT_ARG(int);
+            break;
+        case ARG_LONG:
+            FORMAT_ARG(long);
+            break;
+        case ARG_LLONG:
+            FORMAT_ARG(long long);
+            break;
+        case ARG_INTMAX:
+            FORMAT_ARG(intmax_t);
+            break;
+        case ARG_SIZE:
+            FORMAT_ARG(size_t);
+            break;
+        case ARG_PTRDIFF:
+            FORMAT_ARG(ptrdiff_t);
+            break;
+        case ARG_DOUBLE:
+            FORMAT_ARG(double);
+            break;
+        case ARG_LDOUBLE:
+            FORMAT_ARG(long double);
+            break;
+        case ARG_PTR:
+            FORMAT_ARG(void *);
+            break;
+        case ARG_STR: {
+            const char *str = (const char *)args;
+            size_t str_len = strnlen(str, args_len);
+            if (str_len == args_len)
+                goto done;
+            n = snprintf(text + len, sz - len, conv, str);
+            args += str_len + 1;
+            args_len -= str_len + 1;
+            break;
+        }
+        }
+
+        if (n > 0)
+            len += ((size_t)n < sz - len) ? (size_t)n : sz - 1 - len;
+    }
+
+done:
+    text[len] = 0;
+}
+
+#undef FORMAT_ARG
+#undef GET_ARG
+
+static void
+write_text(struct pclog_ring *ring, const char *tag, const char *text)
+{
+#if HAVE(VSYSLOG)
+    if (ring->fp == LOG_FILE_SYSLOG) {
+        /* only this thread calls openlog() for the asynchronous logs */
+        openlog(ring->ident, LOG_PID, LOG_USER);
+        syslog(LOG_INFO, "%s", text);
+        return;
+    }
+#endif
+
+    fprintf(ring->fp, "%s >> %s", tag, text);
+}
+
+/* writes out the messages in @ring; called with the lock of @ring held */
+static void drain_ring(struct pclog_ring *ring)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (tail == head && ring->nr_reported ==
+            atomic_load_explicit(&ring->nr_dropped, memory_order_relaxed))
+        return;
+
+    char text[LOG_MAX_LINE];
+    while (tail != head) {
+        const unsigned char *data = ring->buf + (tail & LOG_RING_MASK);
+        struct log_record rec;
+        memcpy(&rec, data, sizeof(rec));
+
+        if (rec.kind != RECORD_PADDING) {
+            const char *tag = (const char *)data + sizeof(rec);
+            const char *fmt = tag + rec.tag_len;
+
+            if (rec.kind == RECORD_FORMATTED) {
+                write_text(ring, tag, fmt);
+            }
+            else {
+                const unsigned char *args =
+                    (const unsigned char *)fmt + strlen(fmt) + 1;
+                format_args(text, sizeof(text), fmt, args,
+                        rec.size - (size_t)(args - data));
+                write_text(ring, tag, text);
+            }
+        }
+
+        tail += rec.size;
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    }
+
+    uint64_t nr_dropped = atomic_load_explicit(&ring->nr_dropped,
+            memory_order_relaxed);
+    if (nr_dropped != ring->nr_reported) {
+        snprintf(text, sizeof(text), "%llu messages dropped\n",
+                (unsigned long long)(nr_dropped - ring->nr_reported));
+        write_text(ring, "WARN", text);
+        ring->nr_reported = nr_dropped;
+    }
+
+    if (ring->fp != LOG_FILE_SYSLOG)
+        fflush(ring->fp);
+}
+
+static void flush_ring(struct pclog_ring *ring)
+{
+    pthread_mutex_lock(&ring->lock);
+    drain_ring(ring);
+    pthread_mutex_unlock(&ring->lock);
+}
+
+static void *consumer_main(void *arg)
+{
+    UNUSED_PARAM(arg);
+
+    const struct timespec interval = {
+        0, LOG_DRAIN_INTERVAL * 1000000L
+    };
+
+    pthread_mutex_lock(&rings_lock);
+    for (;;) {
+        while (list_empty(&all_rings))
+            pthread_cond_wait(&rings_cond, &rings_lock);
+
+        struct list_head *p;
+        list_for_each(p, &all_rings) {
+            flush_ring(list_entry(p, struct pclog_ring, ln));
+        }
+
+        pthread_mutex_unlock(&rings_lock);
+        nanosleep(&interval, NULL);
+        pthread_mutex_lock(&rings_lock);
+    }
+
+    return NULL;
+}
+
+/* copies the message into @ring; returns false if the ring is full */
+static bool PCA_ATTRIBUTE_PRINTF(4, 0)
+queue_message(struct pclog_ring *ring, unsigned int level, const char *tag,
+        const char *fmt, va_list ap)
+{
+    union {
+        uint64_t        align;
+        unsigned char   bytes[LOG_MAX_RECORD];
+    } rec_buf;
+    unsigned char *buf = rec_buf.bytes;
+    struct log_record rec = { 0, RECORD_CAPTURED, (uint8_t)level, 0, 0 };
+    size_t len = sizeof(rec);
+
+    size_t tag_len = strnlen(tag, LOG_MAX_TAG);
+    memcpy(buf + len, tag, tag_len);
+    buf[len + tag_len] = 0;
+    rec.tag_len = (uint8_t)(tag_len + 1);
+    len += rec.tag_len;
+
+    size_t fmt_len = strlen(fmt) + 1;
+    size_t args_len = 0;
+    if (len + fmt_len < LOG_MAX_RECORD) {
+        memcpy(buf + len, fmt, fmt_len);
+
+        va_list args;
+        va_copy(args, ap);
+        args_len = capture_args(buf + len + fmt_len,
+                LOG_MAX_RECORD - len - fmt_len, fmt, args);
+        va_end(args);
+    }
+
+    if (args_len > 0) {
+        len += fmt_len + args_len;
+    }
+    else {
+        va_list args;
+        va_copy(args, ap);
+        int n = vsnprintf((char *)buf + len, LOG_MAX_RECORD - len, fmt, args);
+        va_end(args);
+
+        rec.kind = RECORD_FORMATTED;
+        if (n < 0)
+            buf[len] = 0;
+        len += (n < 0) ? 1 : (size_t)n + 1;
+        if (len > LOG_MAX_RECORD)
+            len = LOG_MAX_RECORD;
+    }
+
+    rec.size = (uint32_t)((len + 7) & ~(size_t)7);
+    memcpy(buf, &rec, sizeof(rec));
+
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t pos = head & LOG_RING_MASK;
+    size_t gap = LOG_RING_SIZE - pos;
+    size_t needed = rec.size + ((gap < rec.size) ? gap : 0);
+
+    if (LOG_RING_SIZE - (head - tail) < needed)
+        return false;
+
+    if (gap < rec.size) {
+        struct log_record padding = { (uint32_t)gap, RECORD_PADDING, 0, 0, 0 };
+        memcpy(ring->buf + pos, &padding, sizeof(padding));
+        head += gap;
+        pos = 0;
+    }
+
+    memcpy(ring->buf + pos, buf, rec.size);
+    atomic_store_explicit(&ring->head, head + rec.size, memory_order_release);
+    return true;
+}
+
+static bool async_wanted(void)
+{
+    const char *env_value = getenv(PURC_ENVV_LOG_ASYNC);
+    if (env_value == NULL)
+        return true;
+
+    return !(strcmp(env_value, "0") == 0 ||
+            strcasecmp(env_value, "false") == 0);
+}
+
+static struct pclog_ring *create_ring(struct pcinst *inst)
+{
+    struct pclog_ring *ring = calloc(1, sizeof(*ring));
+    if (ring == NULL)
+        return NULL;
+
+    const char *ident = "purc";
+    if (inst->endpoint_atom)
+        ident = purc_atom_to_string(inst->endpoint_atom);
+    ring->ident = strdup(ident);
+    if (ring->ident == NULL) {
+        free(ring);
+        return NULL;
+    }
+
+    pthread_mutex_init(&ring->lock, NULL);
+    ring->fp = inst->fp_log;
+
+    pthread_mutex_lock(&rings_lock);
+    if (!consumer_started) {
+        pthread_t th;
+        if (pthread_create(&th, NULL, consumer_main, NULL) == 0) {
+            pthread_detach(th);
+            consumer_started = true;
+        }
+    }
+
+    if (consumer_started) {
+        list_add_tail(&ring->ln, &all_rings);
+        pthread_cond_signal(&rings_cond);
+    }
+    pthread_mutex_unlock(&rings_lock);
+
+    if (!consumer_started) {
+        pthread_mutex_destroy(&ring->lock);
+        free(ring->ident);
+        free(ring);
+        return NULL;
+    }
+
+    return ring;
+}
+
+static void destroy_ring(struct pclog_ring *ring)
+{
+    pthread_mutex_lock(&rings_lock);
+    list_del(&ring->ln);
+    pthread_mutex_unlock(&rings_lock);
+
+    flush_ring(ring);
+    pthread_mutex_destroy(&ring->lock);
+    free(ring->ident);
+    free(ring);
+}
+
+void pclog_cleanup_instance(struct pcinst *inst)
+{
+    if (inst->log_ring) {
+        destroy_ring(inst->log_ring);
+        inst->log_ring = NULL;
+    }
+}
 
 bool purc_enable_log(bool enable, bool use_syslog)
 {
@@ -43,6 +861,10 @@ bool purc_enable_log(bool enable, bool use_syslog)
     if (inst == NULL)
         return false;
 
+    /* the messages queued go to the old destination */
+    if (inst->log_ring)
+        flush_ring(inst->log_ring);
+
     if (enable) {
 #if HAVE(VSYSLOG)
         if (use_syslog) {
@@ -74,19 +896,32 @@ bool purc_enable_log(bool enable, bool use_syslog)
                 return false;
             }
         }
+
+        if (inst->log_ring) {
+            pthread_mutex_lock(&inst->log_ring->lock);
+            inst->log_ring->fp = inst->fp_log;
+            pthread_mutex_unlock(&inst->log_ring->lock);
+        }
+        else if (async_wanted()) {
+            /* stay synchronous if failed */
+            inst->log_ring = create_ring(inst);
+        }
     }
-    else if (inst->fp_log && inst->fp_log != LOG_FILE_SYSLOG) {
-        fclose(inst->fp_log);
-        inst->fp_log = NULL;
+    else {
+        pclog_cleanup_instance(inst);
+        if (inst->fp_log && inst->fp_log != LOG_FILE_SYSLOG) {
+            fclose(inst->fp_log);
+            inst->fp_log = NULL;
+        }
     }
 
     return true;
 }
 
-void purc_log_with_tag(const char *tag, const char *msg, va_list ap)
+static void PCA_ATTRIBUTE_PRINTF(3, 0)
+log_sync(struct pcinst *inst, const char *tag, const char *msg, va_list ap)
 {
     FILE *fp = NULL;
-    struct pcinst* inst = pcinst_current();
 
     if (inst)
         fp = inst->fp_log;
@@ -121,3 +956,47 @@ void purc_log_with_tag(const char *tag, const char *msg, va_list ap)
     }
 }
 
+void pclog_vlog(unsigned int level, const char *tag, const char *fmt,
+        va_list ap)
+{
+    struct pcinst* inst = pcinst_current();
+
+    if (inst && inst->log_ring) {
+        struct pclog_ring *ring = inst->log_ring;
+        bool queued = queue_message(ring, level, tag, fmt, ap);
+
+        /* the program may abort right after an error, see PC_ASSERT() */
+        if (level & PCLOG_LEVEL_ERROR) {
+            if (!queued) {
+                flush_ring(ring);
+                queued = queue_message(ring, level, tag, fmt, ap);
+            }
+            flush_ring(ring);
+        }
+
+        if (!queued) {
+            atomic_store_explicit(&ring->nr_dropped,
+                    atomic_load_explicit(&ring->nr_dropped,
+                        memory_order_relaxed) + 1, memory_order_relaxed);
+        }
+        return;
+    }
+
+    log_sync(inst, tag, fmt, ap);
+}
+
+void pclog_log(unsigned int level, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    pclog_vlog(level, tag_of_level(level), fmt, ap);
+    va_end(ap);
+}
+
+void purc_log_with_tag(const char *tag, const char *msg, va_list ap)
+{
+    unsigned int level = level_of_tag(tag);
+    if (pclog_is_enabled(PCLOG_MODULE_GENERIC, level))
+        pclog_vlog(level, tag, msg, ap);
+}
+
@@ -24,6 +24,10 @@
 Make HVML keywords table:
     1. Read 'data/keywords.txt' file.
     2. Generate the keywords.h and keywords.inc
+
+The keywords of a prefix are the static atoms of the bucket, which are
+made at build time: the atom of a keyword is its slot in the minimal
+perfect hash table of the bucket plus one.
 """
 
 import argparse
@@ -70,18 +74,92 @@ def gen_PURC_KEYWORD(idx, nr, first, prefix, kw):
         s = "     "
     return "    /* %*d */ %s PCHVML_KEYWORD_%s_%s" % (len(str(nr)), idx, s, prefix.upper(), kw.upper())
 
-def gen_pchvml_keyword(idx, nr, first, prefix, sz, kw):
-    # generate cfgs:     { 0, "<KEYWORD>" }
+def gen_pchvml_keyword(idx, nr, first, prefix, sz, kw, seq):
+    # generate atoms:    PCATOM_STATIC(ATOM_BUCKET_<PREFIX>, <SEQ>), /* <KEYWORD> */
     if idx == first:
         s = "/*=*/"
     else:
         s = "     "
-    return "    /* ATOM_BUCKET_%-*s */ %s { 0, \"%s\" }" % (len(str(sz)), prefix.upper(), s, kw)
-
-def gen_keywords_bucket_init(prefix, start, end):
-    # generate func_calls:
-    #   keywords_bucket_init(keywords, start, end, ATOM_BUCKET_<PREFIX>)
-    return "    keywords_bucket_init(keywords, %s, %s, ATOM_BUCKET_%s)" % (start, end, prefix.upper())
+    return "    %s PCATOM_STATIC(ATOM_BUCKET_%-*s %3d), /* %s */" % (s, sz, prefix.upper() + ",", seq, kw)
+
+def static_hash(seed, kw):
+    # the same as pcatom_static_hash() in private/atom-buckets.h
+    h = (0x811c9dc5 ^ seed) & 0xffffffff
+    for c in kw.encode():
+        h ^= c
+        h = (h * 0x01000193) & 0xffffffff
+    return h
+
+def make_perfect_hash(kws):
+    # hash and displace: the keywords are grouped by the first hash value,
+    # then the seed of every group is searched, from the biggest group,
+    # to put all keywords of the group in the slots not used yet.
+    nr = len(kws)
+    nr_seeds = max(1, (nr + 1) // 2)
+    while True:
+        groups = [[] for i in range(nr_seeds)]
+        for kw in kws:
+            groups[static_hash(0, kw) % nr_seeds].append(kw)
+
+        seeds = [0] * nr_seeds
+        slots = [None] * nr
+        ok = True
+        for g in sorted(range(nr_seeds), key=lambda i: -len(groups[i])):
+            if len(groups[g]) == 0:
+                break
+
+            found = False
+            for seed in range(1, 0x10000):
+                pos = [static_hash(seed, kw) % nr for kw in groups[g]]
+                if len(set(pos)) == len(pos) and \
+                        all(slots[i] is None for i in pos):
+                    found = True
+                    break
+
+            if not found:
+                ok = False
+                break
+
+            seeds[g] = seed
+            for kw, i in zip(groups[g], pos):
+                slots[i] = kw
+
+        if ok:
+            return seeds, slots
+        nr_seeds *= 2
+
+def make_static_atoms(cfgs):
+    # returns the sequences of the keywords and the perfect hash tables
+    seqs = {}
+    tables = {}
+    for prefix in cfgs:
+        seeds, slots = make_perfect_hash(cfgs[prefix])
+        tables[prefix] = (seeds, slots)
+        for i in range(len(slots)):
+            seqs[(prefix, slots[i])] = i + 1
+    return seqs, tables
+
+def gen_static_atoms(fout, tables):
+    for prefix in tables:
+        seeds, slots = tables[prefix]
+        fout.write("static const char * const static_strings_%s[] = {\n" % prefix)
+        for kw in slots:
+            fout.write("    \"%s\",\n" % kw)
+        fout.write("};\n\n")
+
+        fout.write("static const uint16_t static_seeds_%s[] = {\n" % prefix)
+        for i in range(0, len(seeds), 8):
+            fout.write("    %s,\n" % ", ".join("%5d" % x for x in seeds[i:i + 8]))
+        fout.write("};\n\n")
+
+    fout.write("const struct pcatom_static_bucket\n")
+    fout.write("pcatom_static_buckets[PURC_ATOM_BUCKETS_NR] = {\n")
+    for prefix in tables:
+        fout.write("    [ATOM_BUCKET_%s] = {\n" % prefix.upper())
+        fout.write("        static_strings_%s, static_seeds_%s,\n" % (prefix, prefix))
+        fout.write("        PCA_TABLESIZE(static_strings_%s), PCA_TABLESIZE(static_seeds_%s),\n" % (prefix, prefix))
+        fout.write("    },\n")
+    fout.write("};\n")
 
 def process_header_fn(fout, fin, cfgs):
     line_no = 1
@@ -115,6 +193,7 @@ def process_header(dst, src, cfgs):
     fin.close()
 
 def process_source_fn(fout, fin, cfgs):
+    seqs, tables = make_static_atoms(cfgs)
     line_no = 1
     line = fin.readline()
     while line:
@@ -135,18 +214,12 @@ def process_source_fn(fout, fin, cfgs):
                 kws = cfgs[prefix]
                 first = idx
                 for kw in kws:
-                    s = gen_pchvml_keyword(idx, nr, first, prefix, sz, kw)
-                    fout.write("%s,\n" % s)
+                    s = gen_pchvml_keyword(idx, nr, first, prefix, sz + 1, kw,
+                            seqs[(prefix, kw)])
+                    fout.write("%s\n" % s)
                     idx += 1
-        elif s == "%%keywords_bucket_init%%":
-            start = 0
-            for prefix in cfgs:
-                kws = cfgs[prefix]
-                nr = len(kws)
-                end = start + nr;
-                s = gen_keywords_bucket_init(prefix, start, end)
-                fout.write("%s;\n" % s)
-                start = end
+        elif s == "%%static_atoms%%":
+            gen_static_atoms(fout, tables)
         else:
             fout.write(line)
         line_no = line_no + 1
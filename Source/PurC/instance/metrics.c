@@ -0,0 +1,353 @@
+/*
+ * @file metrics.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The runtime counters and histograms of the instances.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "purc.h"
+#include "config.h"
+
+#include "private/instance.h"
+#include "private/list.h"
+#include "private/metrics.h"
+
+#include <stdatomic.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct metric_histogram {
+    atomic_uint_fast64_t    count;
+    atomic_uint_fast64_t    sum;        // in nanoseconds
+    atomic_uint_fast64_t    buckets[PCINST_METRIC_NR_BUCKETS];
+};
+
+struct pcinst_metrics {
+    struct list_head        ln;         // in `all_metrics`
+
+    atomic_uint_fast64_t    counters[PCINST_METRIC_NR_COUNTERS];
+    atomic_uint_fast64_t    gauges[PCINST_METRIC_NR_GAUGES];
+    struct metric_histogram histograms[PCINST_METRIC_NR_HISTOGRAMS];
+};
+
+/* the values read from the metrics */
+struct metric_values {
+    uint64_t counters[PCINST_METRIC_NR_COUNTERS];
+    uint64_t gauges[PCINST_METRIC_NR_GAUGES];
+    struct {
+        uint64_t count;
+        uint64_t sum;
+        uint64_t buckets[PCINST_METRIC_NR_BUCKETS];
+    } histograms[PCINST_METRIC_NR_HISTOGRAMS];
+};
+
+static const char *counter_names[PCINST_METRIC_NR_COUNTERS] = {
+    "coroutinesCreated",
+    "coroutinesExited",
+    "busyTicks",
+    "idleTicks",
+    "msgsEnqueued",
+    "vcmEvals",
+};
+
+static const char *gauge_names[PCINST_METRIC_NR_GAUGES] = {
+    "peakQueueDepth",
+};
+
+static const char *histogram_names[PCINST_METRIC_NR_HISTOGRAMS] = {
+    "enqueueLatency",
+    "rdrRtt",
+    "fetchLatency",
+};
+
+/* the metrics of the instances alive, and the sums of the ones gone */
+static pthread_mutex_t metrics_lock = PTHREAD_MUTEX_INITIALIZER;
+static LIST_HEAD(all_metrics);
+static struct metric_values retired_values;
+
+/* only the thread of the instance stores, so no read-modify-write needed */
+static inline void
+bump(atomic_uint_fast64_t *v, uint64_t n)
+{
+    atomic_store_explicit(v,
+            atomic_load_explicit(v, memory_order_relaxed) + n,
+            memory_order_relaxed);
+}
+
+static inline uint64_t
+load(atomic_uint_fast64_t *v)
+{
+    return atomic_load_explicit(v, memory_order_relaxed);
+}
+
+void
+pcinst_metrics_count(struct pcinst *inst,
+        enum pcinst_metric_counter counter, uint64_t n)
+{
+    if (inst && inst->metrics)
+        bump(&inst->metrics->counters[counter], n);
+}
+
+void
+pcinst_metrics_peak(struct pcinst *inst,
+        enum pcinst_metric_gauge gauge, uint64_t value)
+{
+    if (inst && inst->metrics) {
+        atomic_uint_fast64_t *v = &inst->metrics->gauges[gauge];
+        if (load(v) < value)
+            atomic_store_explicit(v, value, memory_order_relaxed);
+    }
+}
+
+void
+pcinst_metrics_record_ns(struct pcinst *inst,
+        enum pcinst_metric_histogram histogram, uint64_t ns)
+{
+    if (inst == NULL || inst->metrics == NULL)
+        return;
+
+    uint64_t us = ns / 1000;
+
+    size_t bucket = 0;
+    while (bucket < PCINST_METRIC_NR_BUCKETS - 1 && us >= (1ULL << bucket))
+        bucket++;
+
+    struct metric_histogram *h = &inst->metrics->histograms[histogram];
+    bump(&h->count, 1);
+    bump(&h->sum, ns);
+    bump(&h->buckets[bucket], 1);
+}
+
+static void
+read_values(struct pcinst_metrics *m, struct metric_values *values)
+{
+    for (int i = 0; i < PCINST_METRIC_NR_COUNTERS; i++)
+        values->counters[i] = load(&m->counters[i]);
+    for (int i = 0; i < PCINST_METRIC_NR_GAUGES; i++)
+        values->gauges[i] = load(&m->gauges[i]);
+    for (int i = 0; i < PCINST_METRIC_NR_HISTOGRAMS; i++) {
+        struct metric_histogram *h = &m->histograms[i];
+        values->histograms[i].count = load(&h->count);
+        values->histograms[i].sum = load(&h->sum);
+        for (int j = 0; j < PCINST_METRIC_NR_BUCKETS; j++)
+            values->histograms[i].buckets[j] = load(&h->buckets[j]);
+    }
+}
+
+/* the gauges are peaks, so they are merged by the maximum */
+static void
+add_values(struct metric_values *to, const struct metric_values *from)
+{
+    for (int i = 0; i < PCINST_METRIC_NR_COUNTERS; i++)
+        to->counters[i] += from->counters[i];
+    for (int i = 0; i < PCINST_METRIC_NR_GAUGES; i++) {
+        if (to->gauges[i] < from->gauges[i])
+            to->gauges[i] = from->gauges[i];
+    }
+    for (int i = 0; i < PCINST_METRIC_NR_HISTOGRAMS; i++) {
+        to->histograms[i].count += from->histograms[i].count;
+        to->histograms[i].sum += from->histograms[i].sum;
+        for (int j = 0; j < PCINST_METRIC_NR_BUCKETS; j++)
+            to->histograms[i].buckets[j] += from->histograms[i].buckets[j];
+    }
+}
+
+void
+pcinst_metrics_reset(struct pcinst *inst)
+{
+    if (inst == NULL || inst->metrics == NULL)
+        return;
+
+    struct pcinst_metrics *m = inst->metrics;
+    for (int i = 0; i < PCINST_METRIC_NR_COUNTERS; i++)
+        atomic_store_explicit(&m->counters[i], 0, memory_order_relaxed);
+    for (int i = 0; i < PCINST_METRIC_NR_GAUGES; i++)
+        atomic_store_explicit(&m->gauges[i], 0, memory_order_relaxed);
+    for (int i = 0; i < PCINST_METRIC_NR_HISTOGRAMS; i++) {
+        struct metric_histogram *h = &m->histograms[i];
+        atomic_store_explicit(&h->count, 0, memory_order_relaxed);
+        atomic_store_explicit(&h->sum, 0, memory_order_relaxed);
+        for (int j = 0; j < PCINST_METRIC_NR_BUCKETS; j++)
+            atomic_store_explicit(&h->buckets[j], 0, memory_order_relaxed);
+    }
+}
+
+static bool
+set_member(purc_variant_t obj, const char *key, purc_variant_t val)
+{
+    if (val == PURC_VARIANT_INVALID)
+        return false;
+
+    bool ok = purc_variant_object_set_by_static_ckey(obj, key, val);
+    purc_variant_unref(val);
+    return ok;
+}
+
+static purc_variant_t
+make_histogram(uint64_t count, uint64_t sum, const uint64_t *buckets)
+{
+    purc_variant_t obj = purc_variant_make_object(0,
+            PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+    if (obj == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    purc_variant_t arr = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    if (arr == PURC_VARIANT_INVALID)
+        goto failed;
+
+    for (size_t i = 0; i < PCINST_METRIC_NR_BUCKETS; i++) {
+        purc_variant_t v = purc_variant_make_ulongint(buckets[i]);
+        bool ok = v && purc_variant_array_append(arr, v);
+        if (v)
+            purc_variant_unref(v);
+        if (!ok) {
+            purc_variant_unref(arr);
+            goto failed;
+        }
+    }
+
+    /* the sum is in seconds */
+    if (set_member(obj, "count", purc_variant_make_ulongint(count)) &&
+            set_member(obj, "sum", purc_variant_make_number(sum / 1e9)) &&
+            set_member(obj, "histogram", arr))
+        return obj;
+
+failed:
+    purc_variant_unref(obj);
+    return PURC_VARIANT_INVALID;
+}
+
+static purc_variant_t
+make_variant(const struct metric_values *values)
+{
+    purc_variant_t obj = purc_variant_make_object(0,
+            PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+    if (obj == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    for (int i = 0; i < PCINST_METRIC_NR_COUNTERS; i++) {
+        if (!set_member(obj, counter_names[i],
+                    purc_variant_make_ulongint(values->counters[i])))
+            goto failed;
+    }
+
+    for (int i = 0; i < PCINST_METRIC_NR_GAUGES; i++) {
+        if (!set_member(obj, gauge_names[i],
+                    purc_variant_make_ulongint(values->gauges[i])))
+            goto failed;
+    }
+
+    for (int i = 0; i < PCINST_METRIC_NR_HISTOGRAMS; i++) {
+        if (!set_member(obj, histogram_names[i],
+                    make_histogram(values->histograms[i].count,
+                        values->histograms[i].sum,
+                        values->histograms[i].buckets)))
+            goto failed;
+    }
+
+    return obj;
+
+failed:
+    purc_variant_unref(obj);
+    return PURC_VARIANT_INVALID;
+}
+
+purc_variant_t
+pcinst_metrics_make_variant(struct pcinst *inst)
+{
+    struct metric_values values = { };
+    if (inst && inst->metrics)
+        read_values(inst->metrics, &values);
+    return make_variant(&values);
+}
+
+purc_variant_t
+pcinst_metrics_make_aggregated_variant(void)
+{
+    struct metric_values values, sums;
+    size_t nr_insts = 0;
+
+    pthread_mutex_lock(&metrics_lock);
+    sums = retired_values;
+    struct list_head *p;
+    list_for_each(p, &all_metrics) {
+        read_values(list_entry(p, struct pcinst_metrics, ln), &values);
+        add_values(&sums, &values);
+        nr_insts++;
+    }
+    pthread_mutex_unlock(&metrics_lock);
+
+    purc_variant_t obj = make_variant(&sums);
+    if (obj && !set_member(obj, "instances",
+                purc_variant_make_ulongint(nr_insts))) {
+        purc_variant_unref(obj);
+        obj = PURC_VARIANT_INVALID;
+    }
+    return obj;
+}
+
+static int
+metrics_init_instance(struct pcinst *curr_inst,
+        const purc_instance_extra_info* extra_info)
+{
+    UNUSED_PARAM(extra_info);
+
+    struct pcinst_metrics *m = calloc(1, sizeof(*m));
+    if (m == NULL)
+        return PURC_ERROR_OUT_OF_MEMORY;
+
+    pthread_mutex_lock(&metrics_lock);
+    list_add_tail(&m->ln, &all_metrics);
+    pthread_mutex_unlock(&metrics_lock);
+
+    curr_inst->metrics = m;
+    return 0;
+}
+
+static void
+metrics_cleanup_instance(struct pcinst *curr_inst)
+{
+    struct pcinst_metrics *m = curr_inst->metrics;
+    if (m == NULL)
+        return;
+
+    struct metric_values values;
+    read_values(m, &values);
+
+    pthread_mutex_lock(&metrics_lock);
+    list_del(&m->ln);
+    add_values(&retired_values, &values);
+    pthread_mutex_unlock(&metrics_lock);
+
+    curr_inst->metrics = NULL;
+    free(m);
+}
+
+struct pcmodule _module_metrics = {
+    .name            = "metrics",
+    .id              = PURC_HAVE_UTILS,
+    .module_inited   = 0,
+
+    .init_once       = NULL,
+    .init_instance   = metrics_init_instance,
+    .cleanup_instance = metrics_cleanup_instance,
+};
+
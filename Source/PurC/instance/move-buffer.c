@@ -27,23 +27,289 @@
 
 #include "purc-pcrdr.h"
 #include "purc-errors.h"
+#include "private/instance.h"
+#include "private/list.h"
+
+#include <string.h>
+#include <stdatomic.h>
+
+#if HAVE(GLIB)
+    #include <gmodule.h>
+#endif
+
+#define NR_DEF_POOLED_MSGS  32
+
+/*
+ * A message structure is allocated in a block tagged with the home of the
+ * instance allocating it. When a message moved to another instance is
+ * released there, the structure is pushed back to the lock-free stack of
+ * returned messages of its home, and the allocating instance takes the
+ * stack into its pool when the pool is empty. So the structures circulate
+ * between the instances exchanging messages instead of being allocated by
+ * the sender and freed by the receiver.
+ *
+ * The home is reference counted by the instance and by the structures out
+ * of the pool, so it outlives the instance while there are messages
+ * allocated by the instance in other instances.
+ */
+struct pcinst_msg_home {
+    /* the instance and the message structures out of the pool */
+    atomic_size_t               refc;
+    /* the instance has been cleaned up */
+    atomic_bool                 orphaned;
+    /* the messages returned by other instances, linked by the pool nodes */
+    struct msg_block * _Atomic  returned;
+    atomic_size_t               nr_returned;
+};
+
+struct msg_block {
+    struct pcinst_msg_home     *home;
+    pcrdr_msg                   msg;
+};
+
+/* the pooled messages are linked by the space reserved for list_head */
+#define msg_to_pool_node(msg)   ((struct list_head *)&(msg)->__padding1)
+#define pool_node_to_msg(p)     \
+    ((pcrdr_msg *)((char *)(p) - offsetof(pcrdr_msg, __padding1)))
+#define msg_to_block(m)         container_of(m, struct msg_block, msg)
+
+static void
+free_block(struct msg_block *block)
+{
+#if HAVE(GLIB)
+    g_slice_free1(sizeof(struct msg_block), (gpointer)block);
+#else
+    free(block);
+#endif
+}
+
+/* frees the messages in the stack of returned ones; returns the number */
+static size_t
+free_returned(struct msg_block *block)
+{
+    size_t nr = 0;
+    while (block) {
+        struct msg_block *next = block->msg.__padding1;
+        free_block(block);
+        block = next;
+        nr++;
+    }
+    return nr;
+}
+
+static void
+unref_home(struct pcinst_msg_home *home)
+{
+    if (atomic_fetch_sub(&home->refc, 1) == 1) {
+        free_returned(atomic_exchange(&home->returned, NULL));
+        free(home);
+    }
+}
+
+/* takes the messages returned by other instances into the pool */
+static void
+collect_returned(struct pcinst *inst)
+{
+    struct pcinst_msg_home *home = inst->msg_home;
+    struct purc_msg_pool_stat *stat = &inst->msg_pool_stat;
+
+    if (atomic_load_explicit(&home->returned, memory_order_relaxed) == NULL)
+        return;
+
+    struct msg_block *block = atomic_exchange(&home->returned, NULL);
+    stat->nr_returned = atomic_load(&home->nr_returned);
+    while (block) {
+        struct msg_block *next = block->msg.__padding1;
+        if (stat->nr_pooled < stat->max_pooled) {
+            list_add(msg_to_pool_node(&block->msg), &inst->msg_pool);
+            stat->nr_pooled++;
+        }
+        else {
+            free_block(block);
+            stat->nr_freed++;
+        }
+        block = next;
+    }
+}
+
+static pcrdr_msg *
+alloc_message(struct pcinst *inst)
+{
+    struct pcinst_msg_home *home = inst ? inst->msg_home : NULL;
+    struct msg_block *block;
+
+    if (home && inst->msg_pool_stat.nr_pooled == 0)
+        collect_returned(inst);
+
+    if (inst && inst->msg_pool_stat.nr_pooled > 0) {
+        struct list_head *p = inst->msg_pool.next;
+
+        list_del(p);
+        inst->msg_pool_stat.nr_pooled--;
+        inst->msg_pool_stat.nr_reused++;
+
+        pcrdr_msg *msg = pool_node_to_msg(p);
+        memset(msg, 0, sizeof(pcrdr_msg));
+        if (home)
+            atomic_fetch_add(&home->refc, 1);
+        return msg;
+    }
+
+#if HAVE(GLIB)
+    block = (struct msg_block *)g_slice_alloc0(sizeof(struct msg_block));
+#else
+    block = (struct msg_block *)calloc(1, sizeof(struct msg_block));
+#endif
+    if (block == NULL)
+        return NULL;
+
+    block->home = home;
+    if (home)
+        atomic_fetch_add(&home->refc, 1);
+    if (inst)
+        inst->msg_pool_stat.nr_allocated++;
+    return &block->msg;
+}
+
+static void
+free_message(struct pcinst *inst, pcrdr_msg *msg)
+{
+    struct msg_block *block = msg_to_block(msg);
+    struct pcinst_msg_home *home = block->home;
+
+    if (home && (inst == NULL || home != inst->msg_home)) {
+        /* returned to the instance allocating it, unless it is gone */
+        if (!atomic_load(&home->orphaned)) {
+            struct msg_block *head = atomic_load_explicit(&home->returned,
+                    memory_order_relaxed);
+            do {
+                msg->__padding1 = head;
+            } while (!atomic_compare_exchange_weak(&home->returned,
+                        &head, block));
+            atomic_fetch_add(&home->nr_returned, 1);
+        }
+        else {
+            free_block(block);
+        }
+
+        unref_home(home);
+        return;
+    }
+
+    if (home)
+        atomic_fetch_sub(&home->refc, 1);
+
+    if (inst && inst->msg_pool_stat.nr_pooled <
+            inst->msg_pool_stat.max_pooled) {
+        list_add(msg_to_pool_node(msg), &inst->msg_pool);
+        inst->msg_pool_stat.nr_pooled++;
+        return;
+    }
+
+    free_block(block);
+    if (inst)
+        inst->msg_pool_stat.nr_freed++;
+}
+
+static void
+trim_message_pool(struct pcinst *inst)
+{
+    struct purc_msg_pool_stat *stat = &inst->msg_pool_stat;
+
+    while (stat->nr_pooled > stat->max_pooled) {
+        struct list_head *p = inst->msg_pool.next;
+        list_del(p);
+        stat->nr_pooled--;
+
+        free_block(msg_to_block(pool_node_to_msg(p)));
+        stat->nr_freed++;
+    }
+}
+
+const struct purc_msg_pool_stat *
+purc_inst_msg_pool_stat(void)
+{
+    struct pcinst* inst = pcinst_current();
+    if (inst == NULL) {
+        purc_set_error(PURC_ERROR_NO_INSTANCE);
+        return NULL;
+    }
+
+    if (inst->msg_home)
+        inst->msg_pool_stat.nr_returned =
+            atomic_load(&inst->msg_home->nr_returned);
+    return &inst->msg_pool_stat;
+}
+
+size_t
+purc_inst_set_msg_pool_size(size_t max_pooled)
+{
+    struct pcinst* inst = pcinst_current();
+    if (inst == NULL) {
+        purc_set_error(PURC_ERROR_NO_INSTANCE);
+        return 0;
+    }
+
+    size_t old = inst->msg_pool_stat.max_pooled;
+    inst->msg_pool_stat.max_pooled = max_pooled;
+    trim_message_pool(inst);
+    return old;
+}
+
+static int
+mvbuf_init_instance(struct pcinst *curr_inst,
+        const purc_instance_extra_info* extra_info)
+{
+    UNUSED_PARAM(extra_info);
+
+    struct pcinst_msg_home *home = calloc(1, sizeof(*home));
+    if (home == NULL)
+        return PURC_ERROR_OUT_OF_MEMORY;
+
+    atomic_init(&home->refc, 1);
+    atomic_init(&home->orphaned, false);
+    atomic_init(&home->returned, NULL);
+    atomic_init(&home->nr_returned, 0);
+    curr_inst->msg_home = home;
+
+    list_head_init(&curr_inst->msg_pool);
+    memset(&curr_inst->msg_pool_stat, 0, sizeof(curr_inst->msg_pool_stat));
+    curr_inst->msg_pool_stat.max_pooled = NR_DEF_POOLED_MSGS;
+    return 0;
+}
+
+static void
+mvbuf_cleanup_instance(struct pcinst *curr_inst)
+{
+    /* the messages released after this will be freed directly */
+    curr_inst->msg_pool_stat.max_pooled = 0;
+    trim_message_pool(curr_inst);
+
+    struct pcinst_msg_home *home = curr_inst->msg_home;
+    if (home) {
+        /* the messages returned from now on are freed by the releasers */
+        atomic_store(&home->orphaned, true);
+        curr_inst->msg_pool_stat.nr_freed +=
+            free_returned(atomic_exchange(&home->returned, NULL));
+        curr_inst->msg_home = NULL;
+        unref_home(home);
+    }
+}
 
 /* this feature needs C11 (stdatomic.h) or above */
 #if HAVE(STDATOMIC_H)
 
-#include "private/instance.h"
-#include "private/list.h"
 #include "private/sorted-array.h"
 #include "private/utils.h"
 #include "private/ports.h"
 #include "private/debug.h"
+#include "purc-runloop.h"
 
 #include <stdatomic.h>
 #include <assert.h>
-
-#if HAVE(GLIB)
-    #include <gmodule.h>
-#endif
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
 
 #define NR_DEF_MAX_MSGS     4
 
@@ -56,8 +322,29 @@ struct pcinst_move_buffer {
     unsigned int        flags;
     size_t              max_nr_msgs;
     size_t              nr_msgs;
+
+    /* the running loop of the owner; woken up when a message arrives. */
+    purc_runloop_t      runloop;
+
+    /* the owner blocked in purc_inst_wait_for_messages() is signaled
+       through the condition when a message arrives. */
+    pthread_mutex_t     wait_lock;
+    pthread_cond_t      wait_cond;
+    unsigned int        nr_waiters;
 };
 
+static void
+wakeup_owner(struct pcinst_move_buffer *mb)
+{
+    pthread_mutex_lock(&mb->wait_lock);
+    if (mb->nr_waiters > 0)
+        pthread_cond_signal(&mb->wait_cond);
+    pthread_mutex_unlock(&mb->wait_lock);
+
+    if (mb->runloop)
+        purc_runloop_wakeup(mb->runloop);
+}
+
 /* the header of the struct pcrdr_msg */
 struct pcrdr_msg_hdr {
     atomic_uint             owner;
@@ -128,15 +415,11 @@ pcinst_get_message(void)
         return NULL;
     }
 
-#if HAVE(GLIB)
-    msg = (pcrdr_msg *)g_slice_alloc0(sizeof(pcrdr_msg));
-#else
-    msg = (pcrdr_msg *)calloc(1, sizeof(pcrdr_msg));
-#endif
-
+    msg = alloc_message(inst);
     if (msg) {
         struct pcrdr_msg_hdr *hdr = (struct pcrdr_msg_hdr *)msg;
         atomic_init(&hdr->owner, inst->endpoint_atom);
+        pcinst_count_alloc(sizeof(pcrdr_msg));
 #ifdef PRINT_DEBUG            /* { */
         PC_DEBUG("New message in %s: %p\n", __func__, msg);
 #endif                        /* }*/
@@ -168,11 +451,7 @@ pcinst_put_message(pcrdr_msg *msg)
                 purc_variant_unref(msg->variants[i]);
         }
 
-#if HAVE(GLIB)
-        g_slice_free1(sizeof(pcrdr_msg), (gpointer)msg);
-#else
-        free(msg);
-#endif
+        free_message(inst, msg);
     }
 }
 
@@ -209,8 +488,22 @@ purc_inst_create_move_buffer(unsigned int flags, size_t max_msgs)
         goto done;
     }
 
+    if (pthread_mutex_init(&mb->wait_lock, NULL)) {
+        errcode = PURC_ERROR_BAD_SYSTEM_CALL;
+        goto done;
+    }
+
+    if (pthread_cond_init(&mb->wait_cond, NULL)) {
+        pthread_mutex_destroy(&mb->wait_lock);
+        errcode = PURC_ERROR_BAD_SYSTEM_CALL;
+        goto done;
+    }
+    mb->nr_waiters = 0;
+
     if (pcutils_sorted_array_add(mb_atom2buff_map,
                 (void *)(uintptr_t)atom, mb) < 0) {
+        pthread_cond_destroy(&mb->wait_cond);
+        pthread_mutex_destroy(&mb->wait_lock);
         errcode = PURC_ERROR_OUT_OF_MEMORY;
         goto done;
     }
@@ -218,6 +511,7 @@ purc_inst_create_move_buffer(unsigned int flags, size_t max_msgs)
     mb->flags = flags;
     mb->nr_msgs = 0;
     mb->max_nr_msgs = (max_msgs > 0) ? max_msgs : NR_DEF_MAX_MSGS;
+    mb->runloop = inst->running_loop;
     list_head_init(&mb->msgs);
 
 done:
@@ -258,11 +552,9 @@ pcinst_grind_message(pcrdr_msg *msg)
                 purc_variant_unref(msg->variants[i]);
         }
 
-#if HAVE(GLIB)
-        g_slice_free1(sizeof(pcrdr_msg), (gpointer)msg);
-#else
-        free(msg);
-#endif
+        /* the variants are freed in the move heap; the structure itself
+           can be reused by the current instance */
+        free_message(pcinst_current(), msg);
     }
     else {
         PC_ERROR("Freeing a message not owned by the move buffer: %p\n", msg);
@@ -310,6 +602,8 @@ purc_inst_destroy_move_buffer(void)
 
     pcutils_sorted_array_remove(mb_atom2buff_map, (void *)(uintptr_t)atom);
     purc_rwlock_clear(&mb->lock);
+    pthread_cond_destroy(&mb->wait_cond);
+    pthread_mutex_destroy(&mb->wait_lock);
     free(mb);
 
 done:
@@ -397,6 +691,7 @@ purc_inst_move_message(purc_atom_t inst_to, pcrdr_msg *msg)
         mb->nr_msgs++;
         purc_rwlock_writer_unlock(&mb->lock);
 
+        wakeup_owner(mb);
         nr++;
     }
     else {
@@ -434,6 +729,8 @@ purc_inst_move_message(purc_atom_t inst_to, pcrdr_msg *msg)
                 list_add_tail(&hdr->ln, &mb->msgs);
                 mb->nr_msgs++;
                 purc_rwlock_writer_unlock(&mb->lock);
+
+                wakeup_owner(mb);
                 nr++;
             }
         }
@@ -487,6 +784,66 @@ done:
     return errcode;
 }
 
+int
+purc_inst_wait_for_messages(int timeout_ms, size_t *nr)
+{
+    struct pcinst* inst = pcinst_current();
+    if (inst == NULL) {
+        purc_set_error(PURC_ERROR_NO_INSTANCE);
+        return PURC_ERROR_NO_INSTANCE;
+    }
+
+    struct pcinst_move_buffer *mb;
+
+    purc_rwlock_reader_lock(&mb_lock);
+    if (!pcutils_sorted_array_find(mb_atom2buff_map,
+                (void *)(uintptr_t)inst->endpoint_atom, (void **)&mb)) {
+        mb = NULL;
+    }
+    purc_rwlock_reader_unlock(&mb_lock);
+
+    if (mb == NULL) {
+        purc_set_error(PURC_ERROR_NOT_EXISTS);
+        return PURC_ERROR_NOT_EXISTS;
+    }
+
+    /* only the owner destroys the buffer, so it is safe to use the buffer
+       without holding the global lock, which would block the others
+       creating or destroying their buffers. */
+    if (timeout_ms != 0) {
+        struct timespec abstime;
+
+        if (timeout_ms > 0) {
+            clock_gettime(CLOCK_REALTIME, &abstime);
+            abstime.tv_sec += timeout_ms / 1000;
+            abstime.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+            if (abstime.tv_nsec >= 1000000000L) {
+                abstime.tv_sec++;
+                abstime.tv_nsec -= 1000000000L;
+            }
+        }
+
+        pthread_mutex_lock(&mb->wait_lock);
+        mb->nr_waiters++;
+        while (mb->nr_msgs == 0) {
+            int r;
+            if (timeout_ms > 0)
+                r = pthread_cond_timedwait(&mb->wait_cond, &mb->wait_lock,
+                        &abstime);
+            else
+                r = pthread_cond_wait(&mb->wait_cond, &mb->wait_lock);
+            if (r == ETIMEDOUT)
+                break;
+        }
+        mb->nr_waiters--;
+        pthread_mutex_unlock(&mb->wait_lock);
+    }
+
+    /* no need to lock the buffer */
+    *nr = mb->nr_msgs;
+    return 0;
+}
+
 const pcrdr_msg *
 purc_inst_retrieve_message(size_t index)
 {
@@ -594,10 +951,6 @@ done:
 
 #else   /* HAVE(STDATOMIC_H) */
 
-#if HAVE(GLIB)
-    #include <gmodule.h>
-#endif
-
 static int mvbuf_init_once(void)
 {
     // do nothing.
@@ -622,21 +975,13 @@ purc_inst_destroy_move_buffer(void)
 pcrdr_msg *
 pcinst_get_message(void)
 {
-#if HAVE(GLIB)
-    return g_slice_alloc0(sizeof(pcrdr_msg));
-#else
-    return calloc(1, sizeof(pcrdr_msg));
-#endif
+    return alloc_message(pcinst_current());
 }
 
 void
 pcinst_put_message(pcrdr_msg *msg)
 {
-#if HAVE(GLIB)
-    g_slice_free1(sizeof(pcrdr_msg), (gpointer)msg);
-#else
-    free(msg);
-#endif
+    free_message(pcinst_current(), msg);
 }
 
 size_t
@@ -655,6 +1000,15 @@ purc_inst_holding_messages_count(size_t *nr)
     return PURC_ERROR_NOT_SUPPORTED;
 }
 
+int
+purc_inst_wait_for_messages(int timeout_ms, size_t *nr)
+{
+    UNUSED_PARAM(timeout_ms);
+    UNUSED_PARAM(nr);
+    purc_set_error(PURC_ERROR_NOT_SUPPORTED);
+    return PURC_ERROR_NOT_SUPPORTED;
+}
+
 const pcrdr_msg *
 purc_inst_retrieve_message(size_t index)
 {
@@ -674,10 +1028,12 @@ purc_inst_take_away_message(size_t index)
 #endif  /* !HAVE(STDATOMIC_H) */
 
 struct pcmodule _module_mvbuf = {
+    .name            = "move-buffer",
     .id              = PURC_HAVE_VARIANT,
     .module_inited   = 0,
 
     .init_once       = mvbuf_init_once,
-    .init_instance   = NULL,
+    .init_instance   = mvbuf_init_instance,
+    .cleanup_instance = mvbuf_cleanup_instance,
 };
 
@@ -26,54 +26,406 @@
 #include "config.h"
 
 #include "private/errors.h"
+#include "private/hashtable.h"
 #include "private/instance.h"
+#include "private/metrics.h"
 #include "private/utils.h"
 #include "private/variant.h"
 #include "private/msg-queue.h"
+#include "private/interpreter.h"
 
 #if HAVE(GLIB)
     #include <gmodule.h>
 #endif
 
+bool
+is_event_match(pcrdr_msg *left, pcrdr_msg *right)
+{
+    if ((left->target == right->target) &&
+            (left->targetValue == right->targetValue) &&
+            (purc_variant_is_equal_to(left->eventName, right->eventName)) &&
+            (purc_variant_is_equal_to(left->elementValue, right->elementValue))
+            ) {
+        return true;
+    }
+    return false;
+}
+
+/*
+ * The pending events are indexed by their target, target value, name and
+ * element value, so an event to reduce finds the one it is reduced to
+ * without scanning all the pending events. An entry of the index is keyed
+ * by the first (the oldest) one of the equal events in `event_msgs`, and
+ * counts them.
+ *
+ * If the index could not be kept because of no memory, the events are
+ * scanned as before until they are drained.
+ */
+
+struct event_entry {
+    pcrdr_msg          *first;
+    size_t              nr;
+};
+
+/* FNV-1a */
+static uint64_t
+hash_bytes(uint64_t hash, const void *data, size_t len)
+{
+    const unsigned char *p = data;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/* consistent with purc_variant_is_equal_to(): the variants equal to each
+   other always have the same hash value */
+static uint64_t
+hash_variant(uint64_t hash, purc_variant_t v)
+{
+    if (v == PURC_VARIANT_INVALID)
+        return hash;
+
+    unsigned int type = v->type;
+    hash = hash_bytes(hash, &type, sizeof(type));
+
+    const char *str;
+    size_t len;
+    switch (type) {
+    case PURC_VARIANT_TYPE_BOOLEAN:
+        return hash_bytes(hash, &v->b, sizeof(v->b));
+
+    case PURC_VARIANT_TYPE_EXCEPTION:
+        return hash_bytes(hash, &v->atom, sizeof(v->atom));
+
+    case PURC_VARIANT_TYPE_LONGINT:
+        return hash_bytes(hash, &v->i64, sizeof(v->i64));
+
+    case PURC_VARIANT_TYPE_ULONGINT:
+        return hash_bytes(hash, &v->u64, sizeof(v->u64));
+
+    case PURC_VARIANT_TYPE_ATOMSTRING:
+        str = purc_atom_to_string(v->atom);
+        return hash_bytes(hash, str, strlen(str));
+
+    case PURC_VARIANT_TYPE_STRING:
+        str = purc_variant_get_string_const_ex(v, &len);
+        return hash_bytes(hash, str, len);
+
+    case PURC_VARIANT_TYPE_BSEQUENCE:
+        str = (const char *)purc_variant_get_bytes_const(v, &len);
+        return hash_bytes(hash, str, len);
+
+    case PURC_VARIANT_TYPE_NATIVE:
+    case PURC_VARIANT_TYPE_DYNAMIC:
+        return hash_bytes(hash, v->ptr_ptr, sizeof(v->ptr_ptr));
+
+    default:
+        /* the numbers are compared with a tolerance, and the containers
+           by their members */
+        return hash;
+    }
+}
+
+static unsigned long
+event_hash(const void *k)
+{
+    const pcrdr_msg *msg = k;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    hash = hash_bytes(hash, &msg->target, sizeof(msg->target));
+    hash = hash_bytes(hash, &msg->targetValue, sizeof(msg->targetValue));
+    hash = hash_variant(hash, msg->eventName);
+    hash = hash_variant(hash, msg->elementValue);
+    return (unsigned long)hash;
+}
+
+static int
+event_equal(const void *k1, const void *k2)
+{
+    return is_event_match((pcrdr_msg *)k1, (pcrdr_msg *)k2);
+}
+
+static void
+free_event_entry(struct pchash_entry *e)
+{
+    free((void *)pchash_entry_v(e));
+}
+
+static struct pchash_table *
+event_index_new(void)
+{
+    return pchash_table_new(HASHTABLE_DEFAULT_SIZE, free_event_entry,
+            event_hash, event_equal);
+}
+
+static pcrdr_msg *
+scan_events(struct pcinst_msg_queue *queue, pcrdr_msg *msg)
+{
+    struct list_head *p;
+    list_for_each(p, &queue->event_msgs) {
+        pcrdr_msg *orig = (pcrdr_msg *)list_entry(p,
+                struct pcinst_msg_hdr, ln);
+        if (is_event_match(orig, msg))
+            return orig;
+    }
+    return NULL;
+}
+
+/* returns the first pending event matching @msg, or NULL */
+static pcrdr_msg *
+find_event(struct pcinst_msg_queue *queue, pcrdr_msg *msg)
+{
+    if (queue->event_index) {
+        struct pchash_entry *e;
+        e = pchash_table_lookup_entry(queue->event_index, msg);
+        if (e == NULL)
+            return NULL;
+        return ((struct event_entry *)pchash_entry_v(e))->first;
+    }
+
+    return scan_events(queue, msg);
+}
+
+/* adds @msg to the tail or the head of the pending events */
+static void
+add_event(struct pcinst_msg_queue *queue, pcrdr_msg *msg, bool tail)
+{
+    struct pcinst_msg_hdr *hdr = (struct pcinst_msg_hdr *)msg;
+
+    /* the index given up is made again once the events are drained */
+    if (queue->event_index == NULL && list_empty(&queue->event_msgs))
+        queue->event_index = event_index_new();
+
+    if (queue->event_index) {
+        struct pchash_entry *e;
+        e = pchash_table_lookup_entry(queue->event_index, msg);
+        if (e) {
+            struct event_entry *entry = (struct event_entry *)e->v;
+            entry->nr++;
+            if (!tail) {
+                /* replaced by an equal key, which has the same hash */
+                e->k = msg;
+                entry->first = msg;
+            }
+        }
+        else {
+            struct event_entry *entry = malloc(sizeof(*entry));
+            if (entry) {
+                entry->first = msg;
+                entry->nr = 1;
+            }
+
+            if (entry == NULL ||
+                    pchash_table_insert(queue->event_index, msg, entry)) {
+                free(entry);
+                pchash_table_free(queue->event_index);
+                queue->event_index = NULL;
+            }
+        }
+    }
+
+    if (tail) {
+        list_add_tail(&hdr->ln, &queue->event_msgs);
+    }
+    else {
+        list_add(&hdr->ln, &queue->event_msgs);
+    }
+}
+
+/* removes @msg from the index after it is removed from the events */
+static void
+unindex_event(struct pcinst_msg_queue *queue, pcrdr_msg *msg)
+{
+    struct pchash_table *index = queue->event_index;
+    if (index == NULL)
+        return;
+
+    struct pchash_entry *e = pchash_table_lookup_entry(index, msg);
+    if (e == NULL)
+        return;
+
+    struct event_entry *entry = (struct event_entry *)e->v;
+    if (--entry->nr == 0) {
+        pchash_table_delete_entry(index, e);
+
+        /* drop the slots of the removed entries, which are passed over
+           by every lookup, when a large backlog has been drained */
+        if (index->count == 0 && index->size > HASHTABLE_DEFAULT_SIZE)
+            pchash_table_resize(index, HASHTABLE_DEFAULT_SIZE);
+        return;
+    }
+
+    /* the first one is removed in most cases: it is the oldest one */
+    if (entry->first == msg) {
+        pcrdr_msg *first = scan_events(queue, msg);
+        if (first == NULL) {
+            /* not reached */
+            pchash_table_delete_entry(index, e);
+            return;
+        }
+
+        /* replaced by an equal key, which has the same hash */
+        e->k = first;
+        entry->first = first;
+    }
+}
+
+static const uint64_t class_bits[NR_MSG_CLASSES] = {
+    MSG_QS_RES,
+    MSG_QS_REQ,
+    MSG_QS_EVENT,
+    MSG_QS_VOID,
+};
+
+static inline int
+msg_class(pcrdr_msg_type type)
+{
+    switch (type) {
+    case PCRDR_MSG_TYPE_REQUEST:
+        return MSG_CLASS_REQ;
+    case PCRDR_MSG_TYPE_RESPONSE:
+        return MSG_CLASS_RES;
+    case PCRDR_MSG_TYPE_EVENT:
+        return MSG_CLASS_EVENT;
+    default:
+        return MSG_CLASS_VOID;
+    }
+}
+
+static inline struct list_head *
+class_list(struct pcinst_msg_queue *queue, int c)
+{
+    switch (c) {
+    case MSG_CLASS_RES:
+        return &queue->res_msgs;
+    case MSG_CLASS_REQ:
+        return &queue->req_msgs;
+    case MSG_CLASS_EVENT:
+        return &queue->event_msgs;
+    default:
+        return &queue->void_msgs;
+    }
+}
+
 struct pcinst_msg_queue *
 pcinst_msg_queue_create(void)
 {
-    int errcode = 0;
     struct pcinst_msg_queue *queue = NULL;
 
-    if ((queue = malloc(sizeof(*queue))) == NULL) {
-        errcode = PURC_ERROR_OUT_OF_MEMORY;
-        goto done;
+    if ((queue = calloc(1, sizeof(*queue))) == NULL) {
+        goto failed;
     }
 
-    purc_rwlock_init(&queue->lock);
-    if (queue->lock.native_impl == NULL) {
-        errcode = PURC_ERROR_BAD_SYSTEM_CALL;
-        goto done;
+    for (int c = 0; c < NR_MSG_CLASSES; c++) {
+        atomic_init(&queue->inboxes[c], NULL);
     }
-
-    queue->state = 0;
-    queue->nr_msgs = 0;
+    atomic_init(&queue->state, 0);
+    atomic_init(&queue->nr_msgs, 0);
     list_head_init(&queue->req_msgs);
     list_head_init(&queue->res_msgs);
     list_head_init(&queue->event_msgs);
     list_head_init(&queue->void_msgs);
 
-done:
+    queue->event_index = event_index_new();
+    if (queue->event_index == NULL) {
+        goto failed;
+    }
 
-    if (errcode) {
-        if (queue) {
-            if (queue->lock.native_impl) {
-                purc_rwlock_clear(&queue->lock);
-            }
+    queue->owner = pcinst_current();
+    return queue;
+
+failed:
+    free(queue);
+    purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    return NULL;
+}
 
-            free(queue);
+/* returns whether @msg is queued; false if it is reduced to another one */
+static bool
+reduce_event(struct pcinst_msg_queue *queue, pcrdr_msg *msg, bool tail)
+{
+    pcrdr_msg *orig = find_event(queue, msg);
+    if (orig) {
+        if (msg->reduceOpt == PCRDR_MSG_EVENT_REDUCE_OPT_IGNORE) {
+            return false;
+        }
+        // OVERLAY : data
+        if (orig->data) {
+            purc_variant_unref(orig->data);
+            orig->data = PURC_VARIANT_INVALID;
+        }
+        if (msg->data) {
+            orig->data = msg->data;
+            purc_variant_ref(orig->data);
         }
+        return false;
+    }
 
-        purc_set_error(errcode);
-        return NULL;
+    add_event(queue, msg, tail);
+    return true;
+}
+
+/* queues an event taken from the inbox or prepended by the consumer */
+static void
+queue_event(struct pcinst_msg_queue *queue, pcrdr_msg *msg, bool tail)
+{
+    if (msg->reduceOpt == PCRDR_MSG_EVENT_REDUCE_OPT_KEEP) {
+        add_event(queue, msg, tail);
+    }
+    else if (!reduce_event(queue, msg, tail)) {
+        pcrdr_release_message(msg);
+        atomic_fetch_sub(&queue->nr_msgs, 1);
+    }
+}
+
+/* moves the messages in the inbox of class @c to the list of the class */
+static void
+drain_inbox(struct pcinst_msg_queue *queue, int c)
+{
+    uint64_t bit = class_bits[c];
+    if (!(atomic_load_explicit(&queue->state, memory_order_relaxed) & bit)) {
+        return;
+    }
+
+    /* clear the bit before taking the inbox: a message pushed after the
+       exchange sets it again */
+    atomic_fetch_and(&queue->state, ~bit);
+    struct pcinst_msg_hdr *hdr = atomic_exchange(&queue->inboxes[c], NULL);
+
+    /* the inbox is in the reverse order of pushing */
+    LIST_HEAD(msgs);
+    while (hdr) {
+        struct pcinst_msg_hdr *next = NULL;
+        if (hdr->ln.next)
+            next = list_entry(hdr->ln.next, struct pcinst_msg_hdr, ln);
+        list_add(&hdr->ln, &msgs);
+        hdr = next;
+    }
+
+    if (c != MSG_CLASS_EVENT) {
+        list_splice_tail_init(&msgs, class_list(queue, c));
+        return;
+    }
+
+    /* the events are reduced by the consumer */
+    while (!list_empty(&msgs)) {
+        hdr = list_first_entry(&msgs, struct pcinst_msg_hdr, ln);
+        list_del(&hdr->ln);
+        queue_event(queue, (pcrdr_msg *)hdr, true);
     }
-    return queue;
+}
+
+static void
+drain_inboxes(struct pcinst_msg_queue *queue)
+{
+    for (int c = 0; c < NR_MSG_CLASSES; c++) {
+        drain_inbox(queue, c);
+    }
+
+    pcinst_metrics_peak(pcinst_current(), PCINST_METRIC_PEAK_QUEUE_DEPTH,
+            atomic_load(&queue->nr_msgs));
 }
 
 static ssize_t
@@ -95,119 +447,42 @@ ssize_t
 pcinst_msg_queue_destroy(struct pcinst_msg_queue *queue)
 {
     ssize_t nr = 0;
-    purc_rwlock_writer_lock(&queue->lock);
 
+    drain_inboxes(queue);
     nr += grind_msg_list(&queue->req_msgs);
     nr += grind_msg_list(&queue->res_msgs);
     nr += grind_msg_list(&queue->event_msgs);
     nr += grind_msg_list(&queue->void_msgs);
-    queue->nr_msgs -= nr;
-
-    purc_rwlock_writer_unlock(&queue->lock);
 
-    purc_rwlock_clear(&queue->lock);
+    if (queue->event_index)
+        pchash_table_free(queue->event_index);
     free(queue);
 
     return nr;
 }
 
-bool
-is_event_match(pcrdr_msg *left, pcrdr_msg *right)
-{
-    if ((left->target == right->target) &&
-            (left->targetValue == right->targetValue) &&
-            (purc_variant_is_equal_to(left->eventName, right->eventName)) &&
-            (purc_variant_is_equal_to(left->elementValue, right->elementValue))
-            ) {
-        return true;
-    }
-    return false;
-}
-
-int
-reduce_event(struct pcinst_msg_queue *queue, pcrdr_msg *msg, bool tail)
-{
-    struct pcinst_msg_hdr *hdr;
-    struct list_head *p, *n;
-    list_for_each_safe(p, n, &queue->event_msgs) {
-        hdr = list_entry(p, struct pcinst_msg_hdr, ln);
-        pcrdr_msg *orig = (pcrdr_msg*) hdr;
-        if (is_event_match(orig, msg)) {
-            if (msg->reduceOpt == PCRDR_MSG_EVENT_REDUCE_OPT_IGNORE) {
-                return 0;
-            }
-            // OVERLAY : data
-            if (orig->data) {
-                purc_variant_unref(orig->data);
-                orig->data = PURC_VARIANT_INVALID;
-            }
-            if (msg->data) {
-                orig->data = msg->data;
-                purc_variant_ref(orig->data);
-            }
-            return 0;
-        }
-    }
-
-    hdr = (struct pcinst_msg_hdr *)msg;
-    if (tail) {
-        list_add_tail(&hdr->ln, &queue->event_msgs);
-    }
-    else {
-        list_add(&hdr->ln, &queue->event_msgs);
-    }
-    queue->state |= MSG_QS_EVENT;
-    queue->nr_msgs++;
-
-    return 0;
-}
-
 int
 pcinst_msg_queue_append(struct pcinst_msg_queue *queue, pcrdr_msg *msg)
 {
     struct pcinst_msg_hdr *hdr = (struct pcinst_msg_hdr *)msg;
+    struct pcinst *inst = queue->owner;
+    uint64_t since = pcinst_metrics_now();
+    int c = msg_class(msg->type);
 
-    purc_rwlock_writer_lock(&queue->lock);
+    /* counted before pushing, so the consumer never counts it down first */
+    atomic_fetch_add(&queue->nr_msgs, 1);
 
-    switch (msg->type) {
-    case PCRDR_MSG_TYPE_VOID:
-        list_add_tail(&hdr->ln, &queue->void_msgs);
-        queue->state |= MSG_QS_VOID;
-        queue->nr_msgs++;
-        break;
+    struct pcinst_msg_hdr *head;
+    head = atomic_load_explicit(&queue->inboxes[c], memory_order_relaxed);
+    do {
+        hdr->ln.next = head ? &head->ln : NULL;
+    } while (!atomic_compare_exchange_weak(&queue->inboxes[c], &head, hdr));
 
-    case PCRDR_MSG_TYPE_REQUEST:
-        list_add_tail(&hdr->ln, &queue->req_msgs);
-        queue->state |= MSG_QS_REQ;
-        queue->nr_msgs++;
-        break;
+    atomic_fetch_or(&queue->state, class_bits[c]);
 
-    case PCRDR_MSG_TYPE_RESPONSE:
-        list_add_tail(&hdr->ln, &queue->res_msgs);
-        queue->state |= MSG_QS_RES;
-        queue->nr_msgs++;
-        break;
-
-    case PCRDR_MSG_TYPE_EVENT:
-        queue->state |= MSG_QS_EVENT;
-        if (msg->reduceOpt == PCRDR_MSG_EVENT_REDUCE_OPT_KEEP) {
-            list_add_tail(&hdr->ln, &queue->event_msgs);
-            queue->state |= MSG_QS_EVENT;
-            queue->nr_msgs++;
-        }
-        else {
-            reduce_event(queue, msg, true);
-        }
-        break;
-
-    default:
-        list_add_tail(&hdr->ln, &queue->void_msgs);
-        queue->state |= MSG_QS_VOID;
-        queue->nr_msgs++;
-        break;
-    }
-
-    purc_rwlock_writer_unlock(&queue->lock);
+    pcintr_wakeup_scheduler(inst);
+    pcinst_metrics_count(inst, PCINST_METRIC_MSGS_ENQUEUED, 1);
+    pcinst_metrics_record(inst, PCINST_METRIC_ENQUEUE_LATENCY, since);
     return 0;
 }
 
@@ -215,48 +490,20 @@ int
 pcinst_msg_queue_prepend(struct pcinst_msg_queue *queue, pcrdr_msg *msg)
 {
     struct pcinst_msg_hdr *hdr = (struct pcinst_msg_hdr *)msg;
+    int c = msg_class(msg->type);
 
-    purc_rwlock_writer_lock(&queue->lock);
-
-    switch (msg->type) {
-    case PCRDR_MSG_TYPE_VOID:
-        list_add(&hdr->ln, &queue->void_msgs);
-        queue->state |= MSG_QS_VOID;
-        queue->nr_msgs++;
-        break;
-
-    case PCRDR_MSG_TYPE_REQUEST:
-        list_add(&hdr->ln, &queue->req_msgs);
-        queue->state |= MSG_QS_REQ;
-        queue->nr_msgs++;
-        break;
+    /* an event is reduced against the ones pushed before as well */
+    drain_inbox(queue, c);
+    atomic_fetch_add(&queue->nr_msgs, 1);
 
-    case PCRDR_MSG_TYPE_RESPONSE:
-        list_add(&hdr->ln, &queue->res_msgs);
-        queue->state |= MSG_QS_RES;
-        queue->nr_msgs++;
-        break;
-
-    case PCRDR_MSG_TYPE_EVENT:
-        queue->state |= MSG_QS_EVENT;
-        if (msg->reduceOpt == PCRDR_MSG_EVENT_REDUCE_OPT_KEEP) {
-            list_add(&hdr->ln, &queue->event_msgs);
-            queue->state |= MSG_QS_EVENT;
-            queue->nr_msgs++;
-        }
-        else {
-            reduce_event(queue, msg, false);
-        }
-        break;
-
-    default:
-        list_add(&hdr->ln, &queue->void_msgs);
-        queue->state |= MSG_QS_VOID;
-        queue->nr_msgs++;
-        break;
+    if (c == MSG_CLASS_EVENT) {
+        queue_event(queue, msg, false);
+    }
+    else {
+        list_add(&hdr->ln, class_list(queue, c));
     }
 
-    purc_rwlock_writer_unlock(&queue->lock);
+    pcintr_wakeup_scheduler(queue->owner);
     return 0;
 }
 
@@ -270,49 +517,100 @@ get_msg(struct pcinst_msg_queue *queue, struct list_head *msgs)
             struct pcinst_msg_hdr, ln);
     pcrdr_msg *msg = (pcrdr_msg *)hdr;
     list_del(&hdr->ln);
-    queue->nr_msgs--;
-    if (list_empty(msgs)) {
-        queue->state &= ~MSG_QS_RES;
-    }
+    if (msgs == &queue->event_msgs)
+        unindex_event(queue, msg);
+    atomic_fetch_sub(&queue->nr_msgs, 1);
     return msg;
 }
 
 pcrdr_msg *
 pcinst_msg_queue_get_msg(struct pcinst_msg_queue *queue)
 {
-    purc_rwlock_writer_lock(&queue->lock);
-    pcrdr_msg *msg = NULL;
-    if (queue->state & MSG_QS_RES) {
-        msg = get_msg(queue, &queue->res_msgs);
-        if (msg) {
-            goto done;
-        }
-    }
+    pcrdr_msg *msg;
 
-    if (queue->state & MSG_QS_REQ) {
-        msg = get_msg(queue, &queue->req_msgs);
-        if (msg) {
-            goto done;
-        }
+    drain_inboxes(queue);
+
+    if ((msg = get_msg(queue, &queue->res_msgs)))
+        return msg;
+    if ((msg = get_msg(queue, &queue->req_msgs)))
+        return msg;
+    if ((msg = get_msg(queue, &queue->event_msgs)))
+        return msg;
+    return get_msg(queue, &queue->void_msgs);
+}
+
+static size_t
+take_msgs(struct pcinst_msg_queue *queue, struct list_head *from,
+        struct list_head *to)
+{
+    size_t nr = 0;
+    struct list_head *p;
+    list_for_each(p, from) {
+        nr++;
     }
+    list_splice_tail_init(from, to);
 
-    if (queue->state & MSG_QS_EVENT) {
-        msg = get_msg(queue, &queue->event_msgs);
-        if (msg) {
-            goto done;
+    if (from == &queue->event_msgs && queue->event_index) {
+        struct pchash_entry *e, *tmp;
+        pchash_foreach_safe(queue->event_index, e, tmp) {
+            pchash_table_delete_entry(queue->event_index, e);
         }
+        if (queue->event_index->size > HASHTABLE_DEFAULT_SIZE)
+            pchash_table_resize(queue->event_index, HASHTABLE_DEFAULT_SIZE);
     }
 
-    if (queue->state & MSG_QS_VOID) {
-        msg = get_msg(queue, &queue->void_msgs);
-        if (msg) {
-            goto done;
+    return nr;
+}
+
+size_t
+pcinst_msg_queue_take_msgs(struct pcinst_msg_queue *queue,
+        struct list_head *msgs)
+{
+    size_t nr = 0;
+
+    drain_inboxes(queue);
+
+    /* in the same order as pcinst_msg_queue_get_msg() */
+    nr += take_msgs(queue, &queue->res_msgs, msgs);
+    nr += take_msgs(queue, &queue->req_msgs, msgs);
+    nr += take_msgs(queue, &queue->event_msgs, msgs);
+    nr += take_msgs(queue, &queue->void_msgs, msgs);
+
+    atomic_fetch_sub(&queue->nr_msgs, nr);
+    return nr;
+}
+
+void
+pcinst_msg_queue_put_back_msgs(struct pcinst_msg_queue *queue,
+        struct list_head *msgs)
+{
+    /* the events pushed in between are reduced before the ones put back */
+    drain_inboxes(queue);
+
+    /* walk backwards and prepend, so the original order is kept */
+    while (!list_empty(msgs)) {
+        struct pcinst_msg_hdr *hdr = list_last_entry(msgs,
+                struct pcinst_msg_hdr, ln);
+        pcrdr_msg *msg = (pcrdr_msg *)hdr;
+        list_del(&hdr->ln);
+
+        int c = msg_class(msg->type);
+        if (c == MSG_CLASS_EVENT) {
+            if (msg->reduceOpt != PCRDR_MSG_EVENT_REDUCE_OPT_KEEP) {
+                /* a newer event posted in between overrides this one */
+                if (find_event(queue, msg)) {
+                    pcrdr_release_message(msg);
+                    continue;
+                }
+            }
+            add_event(queue, msg, false);
+        }
+        else {
+            list_add(&hdr->ln, class_list(queue, c));
         }
-    }
 
-done:
-    purc_rwlock_writer_unlock(&queue->lock);
-    return msg;
+        atomic_fetch_add(&queue->nr_msgs, 1);
+    }
 }
 
 pcrdr_msg *
@@ -320,8 +618,7 @@ pcinst_msg_queue_get_event_by_element(struct pcinst_msg_queue *queue,
         purc_variant_t request_id, purc_variant_t element_value,
         purc_variant_t event_name)
 {
-    pcrdr_msg *msg = NULL;
-    purc_rwlock_writer_lock(&queue->lock);
+    drain_inbox(queue, MSG_CLASS_EVENT);
 
     struct list_head *msgs = &queue->event_msgs;
     struct list_head *p, *n;
@@ -332,14 +629,14 @@ pcinst_msg_queue_get_event_by_element(struct pcinst_msg_queue *queue,
         if (purc_variant_is_equal_to(m->requestId, request_id) &&
                 purc_variant_is_equal_to(m->elementValue, element_value) &&
                 purc_variant_is_equal_to(m->eventName, event_name)) {
-            msg = m;
             list_del(&hdr->ln);
-            break;
+            unindex_event(queue, m);
+            atomic_fetch_sub(&queue->nr_msgs, 1);
+            return m;
         }
     }
 
-    purc_rwlock_writer_unlock(&queue->lock);
-    return msg;
+    return NULL;
 }
 
 int
@@ -463,10 +760,5 @@ pcinst_broadcast_event(pcrdr_msg_event_reduce_opt reduce_op,
 size_t
 pcinst_msg_queue_count(struct pcinst_msg_queue *queue)
 {
-    size_t nr = 0;
-    purc_rwlock_writer_lock(&queue->lock);
-    nr = queue->nr_msgs;
-    purc_rwlock_writer_unlock(&queue->lock);
-    return nr;
+    return atomic_load(&queue->nr_msgs);
 }
-
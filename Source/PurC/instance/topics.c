@@ -0,0 +1,358 @@
+/*
+ * @file topics.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The topics published to and subscribed by the instances.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The registry maps a topic to the endpoint atoms of the instances
+ * subscribing to it. A publication freezes the data once (see
+ * shared-data.c), along with the event name, the element, and the source
+ * URI of the messages, so every variant of a message delivered is shared:
+ * moving the message to the move buffer of a subscriber moves no variant,
+ * and the subscribers of the same publication all refer to the same data.
+ *
+ * The subscribers are copied out of the registry before the messages are
+ * moved, so the lock is never held while delivering.
+ */
+
+#include "purc.h"
+#include "config.h"
+
+#include "private/debug.h"
+#include "private/errors.h"
+#include "private/instance.h"
+#include "private/list.h"
+#include "private/variant.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NR_MIN_SUBSCRIBERS      4
+
+struct topic_entry {
+    struct list_head    node;
+    char               *name;
+
+    /* the endpoint atoms of the subscribers */
+    purc_atom_t        *subs;
+    size_t              nr_subs;
+    size_t              sz_subs;
+};
+
+static struct purc_mutex    tp_lock;
+static struct list_head     tp_entries;
+
+static void
+free_entry(struct topic_entry *entry)
+{
+    list_del(&entry->node);
+    free(entry->subs);
+    free(entry->name);
+    free(entry);
+}
+
+static void topics_cleanup_once(void)
+{
+    struct topic_entry *p, *n;
+    list_for_each_entry_safe(p, n, &tp_entries, node) {
+        free_entry(p);
+    }
+
+    if (tp_lock.native_impl)
+        purc_mutex_clear(&tp_lock);
+}
+
+static int topics_init_once(void)
+{
+    INIT_LIST_HEAD(&tp_entries);
+
+    purc_mutex_init(&tp_lock);
+    if (tp_lock.native_impl == NULL)
+        return -1;
+
+    if (atexit(topics_cleanup_once)) {
+        purc_mutex_clear(&tp_lock);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* called with the lock held; returns true if the entry is freed */
+static bool
+remove_subscriber(struct topic_entry *entry, purc_atom_t atom)
+{
+    for (size_t i = 0; i < entry->nr_subs; i++) {
+        if (entry->subs[i] == atom) {
+            entry->nr_subs--;
+            memmove(entry->subs + i, entry->subs + i + 1,
+                    sizeof(purc_atom_t) * (entry->nr_subs - i));
+            break;
+        }
+    }
+
+    if (entry->nr_subs == 0) {
+        free_entry(entry);
+        return true;
+    }
+
+    return false;
+}
+
+static void topics_cleanup_instance(struct pcinst *curr_inst)
+{
+    if (curr_inst->endpoint_atom == 0)
+        return;
+
+    purc_mutex_lock(&tp_lock);
+    struct topic_entry *p, *n;
+    list_for_each_entry_safe(p, n, &tp_entries, node) {
+        remove_subscriber(p, curr_inst->endpoint_atom);
+    }
+    purc_mutex_unlock(&tp_lock);
+}
+
+struct pcmodule _module_topics = {
+    .name            = "topics",
+    .id              = PURC_HAVE_VARIANT,
+    .module_inited   = 0,
+
+    .init_once       = topics_init_once,
+    .init_instance   = NULL,
+    .cleanup_instance = topics_cleanup_instance,
+};
+
+/* called with the lock held */
+static struct topic_entry *
+find_entry(const char *topic)
+{
+    struct topic_entry *p;
+    list_for_each_entry(p, &tp_entries, node) {
+        if (strcmp(p->name, topic) == 0)
+            return p;
+    }
+
+    return NULL;
+}
+
+static struct pcinst *
+check_topic(const char *topic)
+{
+    struct pcinst *inst = pcinst_current();
+    if (inst == NULL) {
+        purc_set_error(PURC_ERROR_NO_INSTANCE);
+        return NULL;
+    }
+
+    if (topic == NULL ||
+            !purc_is_valid_token(topic, PURC_LEN_IDENTIFIER)) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return NULL;
+    }
+
+    return inst;
+}
+
+int
+purc_inst_subscribe_topic(const char *topic)
+{
+    struct pcinst *inst = check_topic(topic);
+    if (inst == NULL)
+        return -1;
+
+    int errcode = PURC_ERROR_OK;
+    purc_mutex_lock(&tp_lock);
+
+    struct topic_entry *entry = find_entry(topic);
+    if (entry == NULL) {
+        entry = calloc(1, sizeof(*entry));
+        if (entry == NULL || (entry->name = strdup(topic)) == NULL) {
+            free(entry);
+            errcode = PURC_ERROR_OUT_OF_MEMORY;
+            goto done;
+        }
+        list_add_tail(&entry->node, &tp_entries);
+    }
+
+    for (size_t i = 0; i < entry->nr_subs; i++) {
+        if (entry->subs[i] == inst->endpoint_atom)
+            goto done;
+    }
+
+    if (entry->nr_subs == entry->sz_subs) {
+        size_t sz = entry->sz_subs ? entry->sz_subs * 2 : NR_MIN_SUBSCRIBERS;
+        purc_atom_t *subs = realloc(entry->subs, sizeof(purc_atom_t) * sz);
+        if (subs == NULL) {
+            if (entry->nr_subs == 0)
+                free_entry(entry);
+            errcode = PURC_ERROR_OUT_OF_MEMORY;
+            goto done;
+        }
+        entry->subs = subs;
+        entry->sz_subs = sz;
+    }
+
+    entry->subs[entry->nr_subs++] = inst->endpoint_atom;
+
+done:
+    purc_mutex_unlock(&tp_lock);
+
+    if (errcode) {
+        purc_set_error(errcode);
+        return -1;
+    }
+    return 0;
+}
+
+int
+purc_inst_unsubscribe_topic(const char *topic)
+{
+    struct pcinst *inst = check_topic(topic);
+    if (inst == NULL)
+        return -1;
+
+    int errcode = PURC_ERROR_NOT_EXISTS;
+    purc_mutex_lock(&tp_lock);
+
+    struct topic_entry *entry = find_entry(topic);
+    if (entry) {
+        for (size_t i = 0; i < entry->nr_subs; i++) {
+            if (entry->subs[i] == inst->endpoint_atom) {
+                remove_subscriber(entry, inst->endpoint_atom);
+                errcode = PURC_ERROR_OK;
+                break;
+            }
+        }
+    }
+
+    purc_mutex_unlock(&tp_lock);
+
+    if (errcode) {
+        purc_set_error(errcode);
+        return -1;
+    }
+    return 0;
+}
+
+/* returns a frozen string, or PURC_VARIANT_INVALID */
+static purc_variant_t
+make_frozen_string(const char *str)
+{
+    purc_variant_t v = purc_variant_make_string(str, false);
+    if (v == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+    return pcvariant_shared_data_freeze(v);
+}
+
+ssize_t
+purc_inst_publish_topic(const char *topic, purc_variant_t data)
+{
+    struct pcinst *inst = check_topic(topic);
+    if (inst == NULL)
+        return -1;
+
+    /* take a snapshot of the subscribers */
+    purc_atom_t *subs = NULL;
+    size_t nr_subs = 0;
+    int errcode = PURC_ERROR_OK;
+
+    purc_mutex_lock(&tp_lock);
+    struct topic_entry *entry = find_entry(topic);
+    if (entry) {
+        subs = malloc(sizeof(purc_atom_t) * entry->nr_subs);
+        if (subs) {
+            nr_subs = entry->nr_subs;
+            memcpy(subs, entry->subs, sizeof(purc_atom_t) * nr_subs);
+        }
+        else {
+            errcode = PURC_ERROR_OUT_OF_MEMORY;
+        }
+    }
+    purc_mutex_unlock(&tp_lock);
+
+    if (errcode) {
+        purc_set_error(errcode);
+        return -1;
+    }
+
+    if (nr_subs == 0)
+        return 0;
+
+    ssize_t nr = -1;
+    purc_variant_t variants[4] = { PURC_VARIANT_INVALID };
+    enum { V_NAME, V_ELEMENT, V_SOURCE, V_DATA };
+
+    char *event_name = malloc(sizeof(PURC_EVENT_TYPE_TOPIC) + 1 +
+            strlen(topic));
+    if (event_name == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto done;
+    }
+    strcpy(event_name, PURC_EVENT_TYPE_TOPIC ":");
+    strcat(event_name, topic);
+
+    variants[V_NAME] = make_frozen_string(event_name);
+    free(event_name);
+    variants[V_ELEMENT] = make_frozen_string(PURC_PREDEF_VARNAME_RUNNER);
+    variants[V_SOURCE] = make_frozen_string(inst->endpoint_name);
+    if (!variants[V_NAME] || !variants[V_ELEMENT] || !variants[V_SOURCE])
+        goto done;
+
+    if (data) {
+        variants[V_DATA] =
+            pcvariant_shared_data_freeze(purc_variant_ref(data));
+        if (variants[V_DATA] == PURC_VARIANT_INVALID)
+            goto done;
+    }
+
+    nr = 0;
+    for (size_t i = 0; i < nr_subs; i++) {
+        pcrdr_msg *msg = pcinst_get_message();
+        if (msg == NULL)
+            break;
+
+        msg->type = PCRDR_MSG_TYPE_EVENT;
+        msg->target = PCRDR_MSG_TARGET_COROUTINE;
+        msg->targetValue = PURC_EVENT_TARGET_BROADCAST;
+        msg->reduceOpt = PCRDR_MSG_EVENT_REDUCE_OPT_KEEP;
+        msg->eventName = purc_variant_ref(variants[V_NAME]);
+        msg->sourceURI = purc_variant_ref(variants[V_SOURCE]);
+        msg->elementType = PCRDR_MSG_ELEMENT_TYPE_VARIANT;
+        msg->elementValue = purc_variant_ref(variants[V_ELEMENT]);
+        if (variants[V_DATA]) {
+            msg->dataType = PCRDR_MSG_DATA_TYPE_JSON;
+            msg->data = purc_variant_ref(variants[V_DATA]);
+        }
+
+        /* the message is released here only if it was not moved */
+        nr += purc_inst_move_message(subs[i], msg);
+        pcrdr_release_message(msg);
+    }
+
+done:
+    for (size_t i = 0; i < PCA_TABLESIZE(variants); i++) {
+        if (variants[i])
+            purc_variant_unref(variants[i]);
+    }
+    free(subs);
+    return nr;
+}
@@ -0,0 +1,270 @@
+/*
+ * trace.c - The implementation of tracing facility.
+ * Date: 2026/10/14
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * Authors:
+ *  Vincent Wei (https://github.com/VincentWei), 2022
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "purc-helpers.h"
+#include "purc-utils.h"
+
+#include "private/instance.h"
+#include "private/trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define NR_DEF_TIMELINE_EVENTS  16384
+#define LEN_TIMELINE_NAME       40
+#define LEN_TIMELINE_ARG        56
+
+struct timeline_event {
+    uint64_t        ts;         // in nanoseconds
+    uint64_t        dur;        // in nanoseconds, for 'X' only
+    const char     *cat;
+    int             line;
+    char            ph;
+    char            name[LEN_TIMELINE_NAME];
+    char            arg[LEN_TIMELINE_ARG];
+};
+
+struct pctimeline {
+    char           *file;
+    size_t          size;       // the number of the slots
+    size_t          nr;         // the number of the events kept
+    size_t          next;       // the slot of the next event
+    uint64_t        nr_dropped; // the events overwritten
+
+    struct timeline_event events[];
+};
+
+/* the instances may share a file */
+static pthread_mutex_t timeline_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static const struct trace_category {
+    unsigned int    category;
+    const char     *name;
+    const char     *envv;
+} categories[] = {
+    { PC_TRACE_VCM,     "vcm",      PURC_ENVV_VCM_LOG_ENABLE },
+    { PC_TRACE_HVML,    "hvml",     PURC_ENVV_HVML_LOG_ENABLE },
+    { PC_TRACE_EJSON,   "ejson",    PURC_ENVV_EJSON_LOG_ENABLE },
+};
+
+static void init_timeline(struct pcinst *inst,
+        const purc_instance_extra_info *extra_info)
+{
+    inst->timeline = NULL;
+
+    const char *file = extra_info ? extra_info->timeline_file : NULL;
+    if (file == NULL)
+        file = getenv(PURC_ENVV_TIMELINE_FILE);
+    if (file == NULL || file[0] == 0)
+        return;
+
+    size_t size = extra_info ? extra_info->timeline_size : 0;
+    if (size == 0) {
+        const char *env_value = getenv(PURC_ENVV_TIMELINE_SIZE);
+        if (env_value)
+            size = (size_t)strtoul(env_value, NULL, 10);
+    }
+    if (size == 0)
+        size = NR_DEF_TIMELINE_EVENTS;
+
+    struct pctimeline *timeline = calloc(1, sizeof(*timeline) +
+            sizeof(struct timeline_event) * size);
+    if (timeline == NULL || (timeline->file = strdup(file)) == NULL) {
+        free(timeline);
+        purc_log_warn("No memory for the timeline of %s\n",
+                inst->runner_name);
+        return;
+    }
+
+    timeline->size = size;
+    inst->timeline = timeline;
+}
+
+void pctrace_init_instance(struct pcinst *inst,
+        const purc_instance_extra_info *extra_info)
+{
+    inst->trace_flags = 0;
+
+    for (size_t i = 0; i < PCA_TABLESIZE(categories); i++) {
+        const char *env_value = getenv(categories[i].envv);
+        if (env_value && (*env_value == '1' ||
+                    pcutils_strcasecmp(env_value, "true") == 0)) {
+            inst->trace_flags |= categories[i].category;
+        }
+    }
+
+#if ENABLE(TRACE)
+    init_timeline(inst, extra_info);
+#else
+    UNUSED_PARAM(extra_info);
+    UNUSED_PARAM(init_timeline);
+    inst->timeline = NULL;
+#endif
+}
+
+static void copy_str(char *buf, size_t sz, const char *str)
+{
+    size_t len = 0;
+    if (str) {
+        len = strlen(str);
+        if (len >= sz)
+            len = sz - 1;
+        memcpy(buf, str, len);
+    }
+    buf[len] = 0;
+}
+
+void pctimeline_add(struct pcinst *inst, char ph, const char *cat,
+        const char *name, const char *arg, int line,
+        uint64_t ts, uint64_t dur)
+{
+    struct pctimeline *timeline = inst->timeline;
+    struct timeline_event *event = timeline->events + timeline->next;
+
+    event->ts = ts;
+    event->dur = dur;
+    event->cat = cat;
+    event->line = line;
+    event->ph = ph;
+    copy_str(event->name, sizeof(event->name), name);
+    copy_str(event->arg, sizeof(event->arg), arg);
+
+    if (++timeline->next == timeline->size)
+        timeline->next = 0;
+    if (timeline->nr < timeline->size)
+        timeline->nr++;
+    else
+        timeline->nr_dropped++;
+}
+
+static void write_json_string(FILE *fp, const char *str)
+{
+    fputc('"', fp);
+    for (const unsigned char *p = (const unsigned char *)str; *p; p++) {
+        if (*p == '"' || *p == '\\')
+            fprintf(fp, "\\%c", *p);
+        else if (*p < 0x20)
+            fprintf(fp, "\\u%04x", *p);
+        else
+            fputc(*p, fp);
+    }
+    fputc('"', fp);
+}
+
+static void write_event(FILE *fp, const struct timeline_event *event,
+        int pid, unsigned int tid)
+{
+    fprintf(fp, "{\"name\":");
+    write_json_string(fp, event->name);
+    fprintf(fp, ",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,"
+            "\"pid\":%d,\"tid\":%u", event->cat, event->ph,
+            event->ts / 1000.0, pid, tid);
+
+    if (event->ph == 'X')
+        fprintf(fp, ",\"dur\":%.3f", event->dur / 1000.0);
+    else if (event->ph == 'i')
+        fprintf(fp, ",\"s\":\"t\"");
+
+    if (event->line > 0 || event->arg[0]) {
+        fprintf(fp, ",\"args\":{");
+        if (event->line > 0)
+            fprintf(fp, "\"line\":%d%s", event->line,
+                    event->arg[0] ? "," : "");
+        if (event->arg[0]) {
+            fprintf(fp, "\"detail\":");
+            write_json_string(fp, event->arg);
+        }
+        fputc('}', fp);
+    }
+
+    /* the JSON Array Format allows the trailing comma and no closing ] */
+    fprintf(fp, "},\n");
+}
+
+void pctrace_cleanup_instance(struct pcinst *inst)
+{
+    struct pctimeline *timeline = inst->timeline;
+    if (timeline == NULL)
+        return;
+
+    inst->timeline = NULL;
+
+    int pid = (int)getpid();
+    unsigned int tid = (unsigned int)inst->endpoint_atom;
+
+    pthread_mutex_lock(&timeline_lock);
+    FILE *fp = fopen(timeline->file, "a");
+    if (fp) {
+        if (ftell(fp) == 0)
+            fprintf(fp, "[\n");
+
+        fprintf(fp, "{\"name\":\"thread_name\",\"ph\":\"M\","
+                "\"pid\":%d,\"tid\":%u,\"args\":{\"name\":", pid, tid);
+        write_json_string(fp, inst->runner_name ? inst->runner_name : "");
+        fprintf(fp, ",\"dropped\":%llu}},\n",
+                (unsigned long long)timeline->nr_dropped);
+
+        size_t first = (timeline->nr < timeline->size) ? 0 : timeline->next;
+        for (size_t i = 0; i < timeline->nr; i++) {
+            write_event(fp, timeline->events +
+                    (first + i) % timeline->size, pid, tid);
+        }
+        fclose(fp);
+    }
+    else {
+        purc_log_warn("Failed to open the timeline file: %s\n",
+                timeline->file);
+    }
+    pthread_mutex_unlock(&timeline_lock);
+
+    free(timeline->file);
+    free(timeline);
+}
+
+unsigned int pctrace_category(const char *name, size_t len)
+{
+    for (size_t i = 0; i < PCA_TABLESIZE(categories); i++) {
+        if (strlen(categories[i].name) == len &&
+                pcutils_strncasecmp(categories[i].name, name, len) == 0)
+            return categories[i].category;
+    }
+
+    return 0;
+}
+
+const char *pctrace_category_name(unsigned int category)
+{
+    for (size_t i = 0; i < PCA_TABLESIZE(categories); i++) {
+        if (categories[i].category == category)
+            return categories[i].name;
+    }
+
+    return NULL;
+}
@@ -0,0 +1,261 @@
+/*
+ * @file async.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The asynchronous native methods.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "purc.h"
+
+#include "config.h"
+
+#include "internal.h"
+
+#include "private/debug.h"
+#include "private/errors.h"
+#include "private/instance.h"
+#include "private/interpreter.h"
+#include "private/threadpool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * A getter can not be suspended in the middle of an evaluation, so an
+ * asynchronous native method returns a pending handle at once, and the work
+ * goes on on the thread pool. The coroutine calling it goes on to the end of
+ * the current step, then yields until all of its pending handles are done:
+ * the done function of the task, called on the run loop of the instance,
+ * makes the result and resumes the coroutine with pcintr_resume(). The
+ * handle holds a reference to itself while the work is pending, so it
+ * outlives the variables referring to it.
+ */
+
+enum async_state {
+    ASYNC_PENDING = 0,
+    ASYNC_DONE,
+    ASYNC_FAILED,
+};
+
+struct pcintr_async {
+    pcutils_task           *task;
+    pcintr_async_work_f     work;
+    pcintr_async_done_f     done;
+    void                   *data;
+
+    /* the coroutine called the method */
+    purc_atom_t             cid;
+
+    enum async_state        state;
+    /* the result if done, or the error code if failed */
+    purc_variant_t          result;
+    int                     errcode;
+
+    /* the reference to the handle itself while the work is pending */
+    purc_variant_t          self;
+};
+
+static const char *state_names[] = {
+    "pending",
+    "done",
+    "failed",
+};
+
+static purc_variant_t
+state_getter(void *native_entity, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+{
+    UNUSED_PARAM(nr_args);
+    UNUSED_PARAM(argv);
+    UNUSED_PARAM(silently);
+
+    struct pcintr_async *async = native_entity;
+    return purc_variant_make_string_static(state_names[async->state], false);
+}
+
+static purc_variant_t
+value_getter(void *native_entity, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+{
+    UNUSED_PARAM(nr_args);
+    UNUSED_PARAM(argv);
+    UNUSED_PARAM(silently);
+
+    struct pcintr_async *async = native_entity;
+    if (async->state == ASYNC_DONE)
+        return purc_variant_ref(async->result);
+    return purc_variant_make_undefined();
+}
+
+static purc_variant_t
+error_getter(void *native_entity, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+{
+    UNUSED_PARAM(nr_args);
+    UNUSED_PARAM(argv);
+    UNUSED_PARAM(silently);
+
+    struct pcintr_async *async = native_entity;
+    if (async->state == ASYNC_FAILED) {
+        const char *except = purc_atom_to_string(
+                purc_get_error_exception(async->errcode));
+        if (except)
+            return purc_variant_make_string_static(except, false);
+    }
+    return purc_variant_make_null();
+}
+
+static purc_nvariant_method
+property_getter(const char *name)
+{
+    if (strcmp(name, "state") == 0)
+        return state_getter;
+    if (strcmp(name, "value") == 0)
+        return value_getter;
+    if (strcmp(name, "error") == 0)
+        return error_getter;
+
+    purc_set_error(PURC_ERROR_NOT_SUPPORTED);
+    return NULL;
+}
+
+static void
+on_release(void *native_entity)
+{
+    struct pcintr_async *async = native_entity;
+
+    /* no self reference, so the work is finished */
+    PC_ASSERT(async->task == NULL);
+    if (async->result)
+        purc_variant_unref(async->result);
+    free(async);
+}
+
+static const struct purc_native_ops async_ops = {
+    .property_getter    = property_getter,
+    .on_release         = on_release,
+};
+
+static void
+settle(struct pcintr_async *async, void *result)
+{
+    async->result = async->done(async->data, result);
+    async->data = NULL;
+    if (async->result) {
+        async->state = ASYNC_DONE;
+    }
+    else {
+        async->state = ASYNC_FAILED;
+        async->errcode = purc_get_last_error();
+        if (async->errcode == PURC_ERROR_OK)
+            async->errcode = PURC_ERROR_UNKNOWN;
+        purc_clr_error();
+    }
+}
+
+/* called on the run loop of the instance */
+static void
+on_work_done(pcutils_task *task, void *result, void *ctxt)
+{
+    struct pcintr_async *async = ctxt;
+
+    settle(async, result);
+    pcutils_task_release(task);
+    async->task = NULL;
+
+    pcintr_coroutine_t co = pcintr_coroutine_get_by_id(async->cid);
+    if (co) {
+        PC_ASSERT(co->nr_asyncs > 0);
+        co->nr_asyncs--;
+        if (co->nr_asyncs == 0 && co->async_waiting) {
+            co->async_waiting = 0;
+            pcintr_set_current_co(co);
+            pcintr_resume(co, NULL);
+            pcintr_set_current_co(NULL);
+            pcintr_wakeup_scheduler(pcinst_current());
+        }
+    }
+
+    purc_variant_t self = async->self;
+    async->self = PURC_VARIANT_INVALID;
+    purc_variant_unref(self);
+}
+
+static void *
+run_work(void *arg)
+{
+    struct pcintr_async *async = arg;
+    return async->work(async->data);
+}
+
+purc_variant_t
+pcintr_async_call(pcintr_async_work_f work, pcintr_async_done_f done,
+        void *data)
+{
+    pcintr_coroutine_t co = pcintr_get_coroutine();
+    if (co == NULL || co->state != CO_STATE_RUNNING)
+        return done(data, work(data));
+
+    struct pcintr_async *async = calloc(1, sizeof(*async));
+    if (async == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto failed;
+    }
+
+    async->work = work;
+    async->done = done;
+    async->data = data;
+    async->cid = co->cid;
+    async->self = purc_variant_make_native(async, &async_ops);
+    if (async->self == PURC_VARIANT_INVALID) {
+        free(async);
+        goto failed;
+    }
+
+    async->task = pcutils_task_submit_ex(run_work, async, on_work_done, async);
+    if (async->task == NULL) {
+        /* the handle is settled in place */
+        settle(async, work(async->data));
+        purc_variant_t handle = async->self;
+        async->self = PURC_VARIANT_INVALID;
+        return handle;
+    }
+
+    co->nr_asyncs++;
+    return purc_variant_ref(async->self);
+
+failed:
+    /* let @done release @data */
+    {
+        int errcode = purc_get_last_error();
+        purc_variant_t v = done(data, NULL);
+        if (v)
+            purc_variant_unref(v);
+        purc_set_error(errcode);
+    }
+    return PURC_VARIANT_INVALID;
+}
+
+bool
+pcintr_is_async_handle(purc_variant_t v)
+{
+    return v && purc_variant_is_native(v) &&
+        purc_variant_native_get_ops(v) == &async_ops;
+}
@@ -146,13 +146,10 @@ pcintr_get_scoped_variables(purc_coroutine_t cor, struct pcvdom_node *node)
         return cor->variables;
     }
 
-    struct rb_node *p;
-    struct rb_node *first = pcutils_rbtree_first(&stack->scoped_variables);
-    pcutils_rbtree_for_each(first, p) {
-        pcvarmgr_t mgr = container_of(p, struct pcvarmgr, node);
-        if (mgr->vdom_node == node)
-            return mgr;
-    }
+    struct rb_node *p = pcutils_rbtree_find(&stack->scoped_variables, node,
+            cmp_f);
+    if (p)
+        return container_of(p, struct pcvarmgr, node);
 
     return NULL;
 }
@@ -189,7 +186,14 @@ purc_coroutine_get_variable(purc_coroutine_t cor, const char *name)
         return PURC_VARIANT_INVALID;
     }
 
-    return pcvarmgr_get(cor->variables, name);
+    purc_variant_t v = pcvarmgr_get(cor->variables, name);
+    if (v == PURC_VARIANT_INVALID && cor->lazy_vars &&
+            pcintr_bind_lazy_variable(cor, name)) {
+        purc_clr_error();
+        v = pcvarmgr_get(cor->variables, name);
+    }
+
+    return v;
 }
 
 void *
@@ -0,0 +1,322 @@
+/*
+ * @file derived.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The results derived incrementally by the elements.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "internal.h"
+
+#include "private/executor.h"
+#include "private/instance.h"
+
+#define OPS_LISTENED   \
+    (PCVAR_OPERATION_GROW | PCVAR_OPERATION_SHRINK | PCVAR_OPERATION_CHANGE)
+
+#define NOT_CHECKED     -1
+
+/* a member of the array at the same position */
+struct derived_slot {
+    purc_variant_t              member;
+    int                         chosen;     /* NOT_CHECKED, 0, or 1 */
+};
+
+struct derived_choice {
+    struct list_head            node;
+    pcvdom_element_t            element;
+    char                       *rule;
+    purc_variant_t              on;
+    struct pcvar_listener      *listener;
+    pcexecutor_member_chooser_f chooser;
+
+    struct derived_slot        *slots;
+    size_t                      nr_slots;
+    size_t                      sz_slots;
+};
+
+struct pcintr_derived {
+    struct list_head            choices;
+};
+
+static void
+destroy_choice(struct derived_choice *dc)
+{
+    list_del(&dc->node);
+    if (dc->listener) {
+        purc_variant_revoke_listener(dc->on, dc->listener);
+    }
+    for (size_t i = 0; i < dc->nr_slots; i++) {
+        PURC_VARIANT_SAFE_CLEAR(dc->slots[i].member);
+    }
+    free(dc->slots);
+    purc_variant_unref(dc->on);
+    free(dc->rule);
+    free(dc);
+}
+
+static int
+reserve_slots(struct derived_choice *dc, size_t nr)
+{
+    if (nr <= dc->sz_slots)
+        return 0;
+
+    size_t sz = dc->sz_slots ? dc->sz_slots * 2 : 16;
+    if (sz < nr)
+        sz = nr;
+
+    struct derived_slot *slots = realloc(dc->slots, sizeof(*slots) * sz);
+    if (slots == NULL)
+        return -1;
+
+    dc->slots = slots;
+    dc->sz_slots = sz;
+    return 0;
+}
+
+/*
+ * Keeps the slots at the positions of the members; any change missed here
+ * (no memory, or a change made without notification such as sorting) is
+ * found by sync_slots(), which compares the members position by position.
+ */
+static bool
+on_changed(purc_variant_t source, pcvar_op_t op, void *ctxt,
+        size_t nr_args, purc_variant_t *argv)
+{
+    UNUSED_PARAM(source);
+
+    struct derived_choice *dc = (struct derived_choice *)ctxt;
+    int64_t idx;
+    if (nr_args < 2 || argv[0] == PURC_VARIANT_INVALID ||
+            !purc_variant_cast_to_longint(argv[0], &idx, false) ||
+            idx < 0 || (size_t)idx > dc->nr_slots)
+        return true;
+
+    struct derived_slot *slot = dc->slots + idx;
+    switch (op) {
+    case PCVAR_OPERATION_GROW:
+        if (reserve_slots(dc, dc->nr_slots + 1))
+            break;
+        slot = dc->slots + idx;
+        memmove(slot + 1, slot, sizeof(*slot) * (dc->nr_slots - idx));
+        slot->member = purc_variant_ref(argv[1]);
+        slot->chosen = NOT_CHECKED;
+        dc->nr_slots++;
+        break;
+
+    case PCVAR_OPERATION_SHRINK:
+        if ((size_t)idx == dc->nr_slots)
+            break;
+        PURC_VARIANT_SAFE_CLEAR(slot->member);
+        memmove(slot, slot + 1, sizeof(*slot) * (dc->nr_slots - idx - 1));
+        dc->nr_slots--;
+        break;
+
+    case PCVAR_OPERATION_CHANGE:
+        if ((size_t)idx == dc->nr_slots || nr_args < 3)
+            break;
+        PURC_VARIANT_SAFE_CLEAR(slot->member);
+        slot->member = purc_variant_ref(argv[2]);
+        slot->chosen = NOT_CHECKED;
+        break;
+
+    default:
+        break;
+    }
+
+    purc_clr_error();
+    return true;
+}
+
+static int
+sync_slots(struct derived_choice *dc)
+{
+    size_t nr = 0;
+    purc_variant_array_size(dc->on, &nr);
+
+    while (dc->nr_slots > nr) {
+        dc->nr_slots--;
+        PURC_VARIANT_SAFE_CLEAR(dc->slots[dc->nr_slots].member);
+    }
+
+    if (reserve_slots(dc, nr)) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    for (size_t i = 0; i < nr; i++) {
+        purc_variant_t member = purc_variant_array_get(dc->on, i);
+        struct derived_slot *slot = dc->slots + i;
+        if (i == dc->nr_slots) {
+            slot->member = PURC_VARIANT_INVALID;
+            dc->nr_slots++;
+        }
+        else if (slot->member == member) {
+            continue;
+        }
+
+        PURC_VARIANT_SAFE_CLEAR(slot->member);
+        slot->member = purc_variant_ref(member);
+        slot->chosen = NOT_CHECKED;
+    }
+
+    return 0;
+}
+
+static purc_variant_t
+make_result(struct derived_choice *dc)
+{
+    purc_variant_t result = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    if (result == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    for (size_t i = 0; i < dc->nr_slots; i++) {
+        struct derived_slot *slot = dc->slots + i;
+        if (slot->chosen == NOT_CHECKED) {
+            bool chosen = false;
+            if (dc->chooser(dc->rule, slot->member, &chosen)) {
+                if (purc_get_last_error() == PURC_ERROR_OK)
+                    purc_set_error(PURC_ERROR_INVALID_VALUE);
+                goto failed;
+            }
+            slot->chosen = chosen ? 1 : 0;
+        }
+
+        if (slot->chosen && !purc_variant_array_append(result, slot->member))
+            goto failed;
+    }
+
+    /* the same as choosing by the executor: a single one is not wrapped */
+    size_t nr = 0;
+    purc_variant_array_size(result, &nr);
+    if (nr == 1) {
+        purc_variant_t v = purc_variant_array_get(result, 0);
+        purc_variant_ref(v);
+        purc_variant_unref(result);
+        result = v;
+    }
+    return result;
+
+failed:
+    purc_variant_unref(result);
+    return PURC_VARIANT_INVALID;
+}
+
+static struct derived_choice *
+find_choice(struct pcintr_derived *derived, pcvdom_element_t element)
+{
+    struct derived_choice *p;
+    list_for_each_entry(p, &derived->choices, node) {
+        if (p->element == element)
+            return p;
+    }
+    return NULL;
+}
+
+static struct derived_choice *
+make_choice(struct pcintr_derived *derived, pcvdom_element_t element,
+        purc_variant_t on, const char *rule,
+        pcexecutor_member_chooser_f chooser)
+{
+    struct derived_choice *dc = calloc(1, sizeof(*dc));
+    if (dc == NULL)
+        goto failed;
+
+    dc->rule = strdup(rule);
+    if (dc->rule == NULL) {
+        free(dc);
+        goto failed;
+    }
+
+    dc->element = element;
+    dc->on = purc_variant_ref(on);
+    dc->chooser = chooser;
+    list_add_tail(&dc->node, &derived->choices);
+
+    /* the result is still right without the listener, only slower */
+    dc->listener = purc_variant_register_post_listener(on, OPS_LISTENED,
+            on_changed, dc);
+    purc_clr_error();
+    return dc;
+
+failed:
+    purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    return NULL;
+}
+
+int
+pcintr_derived_choose(pcintr_stack_t stack, pcvdom_element_t element,
+        purc_variant_t on, const char *rule, purc_variant_t *chosen)
+{
+    if (!purc_variant_is_array(on))
+        return 1;
+
+    pcexecutor_member_chooser_f chooser;
+    chooser = pcexecutor_get_member_chooser(rule);
+    if (chooser == NULL)
+        return 1;
+
+    struct pcintr_derived *derived = stack->derived;
+    if (derived == NULL) {
+        derived = calloc(1, sizeof(*derived));
+        if (derived == NULL) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return -1;
+        }
+        INIT_LIST_HEAD(&derived->choices);
+        stack->derived = derived;
+    }
+
+    /* the state is kept for the last array and rule of the element */
+    struct derived_choice *dc = find_choice(derived, element);
+    if (dc && (dc->on != on || strcmp(dc->rule, rule) != 0)) {
+        destroy_choice(dc);
+        dc = NULL;
+    }
+
+    if (dc == NULL) {
+        dc = make_choice(derived, element, on, rule, chooser);
+        if (dc == NULL)
+            return -1;
+    }
+
+    if (sync_slots(dc))
+        return -1;
+
+    *chosen = make_result(dc);
+    return (*chosen == PURC_VARIANT_INVALID) ? -1 : 0;
+}
+
+void
+pcintr_derived_cleanup(pcintr_stack_t stack)
+{
+    struct pcintr_derived *derived = stack->derived;
+    if (derived == NULL)
+        return;
+
+    struct derived_choice *p, *n;
+    list_for_each_entry_safe(p, n, &derived->choices, node) {
+        destroy_choice(p);
+    }
+
+    free(derived);
+    stack->derived = NULL;
+}
@@ -210,7 +210,7 @@ match_id(pcintr_coroutine_t co,
         return false;
 
     bool silently = false;
-    purc_variant_t v = pcvcm_eval(attr->val, &co->stack, silently);
+    purc_variant_t v = pcvcm_eval(pcvdom_attr_get_vcm(attr), &co->stack, silently);
     purc_clr_error();
     if (v == PURC_VARIANT_INVALID)
         return false;
@@ -574,7 +574,7 @@ attr_found(struct pcintr_stack_frame *frame,
     if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, ON)) == name) {
         struct ctxt_for_bind *ctxt;
         ctxt = (struct ctxt_for_bind*)frame->ctxt;
-        ctxt->vcm_ev = attr->val;
+        ctxt->vcm_ev = pcvdom_attr_get_vcm(attr);
         return 0;
     }
 
@@ -199,11 +199,12 @@ on_content(pcintr_coroutine_t co, struct pcintr_stack_frame *frame,
     pcintr_set_question_var(frame, v);
     if (purc_variant_is_string(v)) {
         size_t sz;
-        const char *text = purc_variant_get_string_const_ex(v, &sz);
+        purc_variant_get_string_const_ex(v, &sz);
         if (sz > 0) {
             pcdoc_text_node_t text_node;
-            text_node = pcintr_util_new_text_content(frame->owner->doc,
-                    frame->edom_element, PCDOC_OP_APPEND, text, sz);
+            text_node = pcintr_util_new_shared_text_content(
+                    frame->owner->doc, frame->edom_element,
+                    PCDOC_OP_APPEND, v);
             PC_ASSERT(text_node);
         }
     }
@@ -44,6 +44,8 @@ struct ctxt_for_choose {
     purc_variant_t by;
     purc_variant_t in;
     purc_variant_t with;
+
+    unsigned int incremental:1;
 };
 
 static void
@@ -105,8 +107,6 @@ do_external_func(pcexec_func_ops_t ops,
 static int
 post_process_dest_data(pcintr_coroutine_t co, struct pcintr_stack_frame *frame)
 {
-    UNUSED_PARAM(co);
-
     struct ctxt_for_choose *ctxt;
     ctxt = (struct ctxt_for_choose*)frame->ctxt;
     PC_ASSERT(ctxt);
@@ -132,14 +132,21 @@ post_process_dest_data(pcintr_coroutine_t co, struct pcintr_stack_frame *frame)
         const char *rule = purc_variant_get_string_const(by);
         PC_ASSERT(rule);
 
-        pcexec_ops ops;
+        purc_variant_t v = PURC_VARIANT_INVALID;
         int r;
+        if (ctxt->incremental) {
+            r = pcintr_derived_choose(&co->stack, frame->pos, on, rule, &v);
+            if (r < 0)
+                return -1;
+            if (r == 0)
+                goto chosen;
+        }
+
+        pcexec_ops ops;
         r = pcexecutor_get_by_rule(rule, &ops);
         if (r)
             return -1;
 
-        purc_variant_t v = PURC_VARIANT_INVALID;
-
         switch (ops.type) {
             case PCEXEC_TYPE_INTERNAL:
                 v = do_internal(ops.internal_ops, rule, on, with);
@@ -158,6 +165,7 @@ post_process_dest_data(pcintr_coroutine_t co, struct pcintr_stack_frame *frame)
                 PC_ASSERT(0);
         }
 
+chosen:
         if (v == PURC_VARIANT_INVALID)
             return -1;
 
@@ -337,6 +345,12 @@ attr_found_val(struct pcintr_stack_frame *frame,
     if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, WITH)) == name) {
         return process_attr_with(frame, element, name, val);
     }
+    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, INCREMENTALLY)) == name) {
+        struct ctxt_for_choose *ctxt;
+        ctxt = (struct ctxt_for_choose*)frame->ctxt;
+        ctxt->incremental = 1;
+        return 0;
+    }
 
     purc_set_error_with_info(PURC_ERROR_NOT_IMPLEMENTED,
             "vdom attribute '%s' for element <%s>",
@@ -155,7 +155,7 @@ match_id(pcintr_coroutine_t co,
         return false;
 
     bool silently = false;
-    purc_variant_t v = pcvcm_eval(attr->val, &co->stack, silently);
+    purc_variant_t v = pcvcm_eval(pcvdom_attr_get_vcm(attr), &co->stack, silently);
     purc_clr_error();
     if (v == PURC_VARIANT_INVALID)
         return false;
@@ -28,6 +28,9 @@
 #include "../internal.h"
 
 #include "private/debug.h"
+#include "private/ejson.h"
+#include "private/fetcher.h"
+#include "private/variant.h"
 #include "purc-runloop.h"
 
 #include "../ops.h"
@@ -75,6 +78,7 @@ struct ctxt_for_init {
     unsigned int                  async:1;
     unsigned int                  casesensitively:1;
     unsigned int                  uniquely:1;
+    unsigned int                  shared:1;
 };
 
 struct fetcher_for_init {
@@ -257,7 +261,7 @@ match_id(pcintr_coroutine_t co,
         return false;
 
     bool silently = false;
-    purc_variant_t v = pcvcm_eval(attr->val, &co->stack, silently);
+    purc_variant_t v = pcvcm_eval(pcvdom_attr_get_vcm(attr), &co->stack, silently);
     purc_clr_error();
     if (v == PURC_VARIANT_INVALID)
         return false;
@@ -795,6 +799,11 @@ attr_found_val(struct pcintr_stack_frame *frame,
         ctxt->uniquely = 1;
         return 0;
     }
+    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, SHARED)) == name) {
+        PC_ASSERT(purc_variant_is_undefined(val));
+        ctxt->shared = 1;
+        return 0;
+    }
     if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, CASESENSITIVELY)) == name) {
         PC_ASSERT(purc_variant_is_undefined(val));
         ctxt->casesensitively= 1;
@@ -1013,6 +1022,88 @@ params_from_with(struct ctxt_for_init *ctxt)
     return params;
 }
 
+/* returns 1 if the file can not be read */
+static int
+parse_local_file(const char *path, unsigned int flags, purc_variant_t *ret)
+{
+    purc_rwstream_t rws = purc_rwstream_new_from_mmap(path);
+    if (rws == NULL) {
+        /* not a regular file, e.g., a named pipe */
+        purc_clr_error();
+        rws = purc_rwstream_new_from_file(path, "r");
+    }
+    if (rws == NULL) {
+        purc_clr_error();
+        return 1;
+    }
+
+    *ret = pcvariant_load_from_json_stream_ex(rws, flags);
+    purc_rwstream_destroy(rws);
+    return (*ret == PURC_VARIANT_INVALID) ? -1 : 0;
+}
+
+/*
+ * Loads the data from a local file by mapping it and parsing the text in
+ * place, without copying the file through the fetcher; the keys of the
+ * objects are interned, for the data usually have many objects with the
+ * same keys. Returns 1 if the source is not a local file which can be
+ * read, then the data should be fetched as usual.
+ *
+ * With the adverb `shared`, the data is frozen and shared with the other
+ * coroutines and instances loading the same file, so only one copy of it
+ * is kept in the process; it can not be changed then.
+ */
+static int
+load_local_file(pcintr_coroutine_t co, pcintr_stack_frame_t frame)
+{
+    struct ctxt_for_init *ctxt;
+    ctxt = (struct ctxt_for_init*)frame->ctxt;
+
+    if (ctxt->via != VIA_UNDEFINED && ctxt->via != VIA_GET)
+        return 1;
+    if (ctxt->with != PURC_VARIANT_INVALID &&
+            (!purc_variant_is_object(ctxt->with) ||
+             purc_variant_object_get_size(ctxt->with) > 0))
+        return 1;
+
+    if (co->base_url_string) {
+        pcfetcher_set_base_url(co->base_url_string);
+    }
+
+    char *path = pcfetcher_get_local_path(ctxt->from_uri);
+    if (path == NULL)
+        return 1;
+
+    int r = 0;
+    purc_variant_t ret = PURC_VARIANT_INVALID;
+    if (ctxt->shared) {
+        /* the path is the name of the dataset */
+        ret = pcvariant_shared_data_get(path);
+        if (ret == PURC_VARIANT_INVALID) {
+            purc_clr_error();
+
+            /* the interned keys would be copied when the data is frozen */
+            r = parse_local_file(path, PCEJSON_FLAG_COMPACT_ARRAYS, &ret);
+            if (r == 0) {
+                ret = pcvariant_shared_data_publish(path, ret);
+                if (ret == PURC_VARIANT_INVALID)
+                    r = -1;
+            }
+        }
+    }
+    else {
+        r = parse_local_file(path,
+                PCEJSON_FLAG_INTERN_KEYS | PCEJSON_FLAG_COMPACT_ARRAYS, &ret);
+    }
+    free(path);
+    if (r)
+        return r;
+
+    r = post_process(co, frame, ret);
+    purc_variant_unref(ret);
+    return r;
+}
+
 static int
 process_from_sync(pcintr_coroutine_t co, pcintr_stack_frame_t frame)
 {
@@ -1022,6 +1113,10 @@ process_from_sync(pcintr_coroutine_t co, pcintr_stack_frame_t frame)
     ctxt = (struct ctxt_for_init*)frame->ctxt;
     PC_ASSERT(ctxt);
 
+    int r = load_local_file(co, frame);
+    if (r <= 0)
+        return r;
+
     enum pcfetcher_request_method method;
     method = method_from_via(ctxt->via);
 
@@ -1439,6 +1534,18 @@ after_pushed(pcintr_stack_t stack, pcvdom_element_t pos)
         return ctxt;
     }
 
+    /* the value restored from a snapshot is not evaluated again */
+    if (!ctxt->temporarily) {
+        purc_variant_t restored = pcintr_restored_take(stack, frame->pos,
+                get_name(ctxt->as));
+        if (restored) {
+            _bind_src(stack->co, frame, ctxt->as, ctxt->at,
+                    ctxt->under_head, ctxt->temporarily, restored);
+            purc_variant_unref(restored);
+            return ctxt;
+        }
+    }
+
     if (ctxt->via == VIA_LOAD) {
         r = process_via(stack->co);
         return ctxt;
@@ -36,6 +36,7 @@
 #include "purc-executor.h"
 
 #include <pthread.h>
+#include <string.h>
 #include <unistd.h>
 
 struct ctxt_for_iterate {
@@ -63,11 +64,34 @@ struct ctxt_for_iterate {
     size_t                        sz;
     size_t                        idx_curr;
 
+    /* the rule parsed by the internal executor last time; it is parsed
+       again only if the rule or the container iterated on changed */
+    char                         *parsed_rule;
+    struct pcvar_listener        *on_listener;
+
+    /* the values fetched ahead from an executor with batch operations */
+    purc_variant_t               *batch;
+    size_t                        nr_batch;
+    size_t                        idx_batch;
+
     unsigned int                  stop:1;
     unsigned int                  by_rule:1;
+    unsigned int                  batch_end:1;
     unsigned int                  nosetotail:1;
+    unsigned int                  on_changed:1;
 };
 
+#define ITERATE_BATCH_SIZE      64
+
+static void
+release_batch(struct ctxt_for_iterate *ctxt)
+{
+    for (size_t i = 0; i < ctxt->nr_batch; i++)
+        purc_variant_unref(ctxt->batch[i]);
+    ctxt->nr_batch = 0;
+    ctxt->idx_batch = 0;
+}
+
 static void
 ctxt_for_iterate_destroy(struct ctxt_for_iterate *ctxt)
 {
@@ -78,6 +102,15 @@ ctxt_for_iterate_destroy(struct ctxt_for_iterate *ctxt)
             PC_ASSERT(ok);
             ctxt->exec_inst = NULL;
         }
+        if (ctxt->on_listener) {
+            purc_variant_revoke_listener(ctxt->on, ctxt->on_listener);
+            ctxt->on_listener = NULL;
+        }
+        free(ctxt->parsed_rule);
+
+        release_batch(ctxt);
+        free(ctxt->batch);
+
         PURC_VARIANT_SAFE_CLEAR(ctxt->on);
         PURC_VARIANT_SAFE_CLEAR(ctxt->in);
         PURC_VARIANT_SAFE_CLEAR(ctxt->evalued_rule);
@@ -259,6 +292,93 @@ eval_rule(struct ctxt_for_iterate *ctxt, pcintr_stack_t stack)
     return rule;
 }
 
+static bool
+on_changed(purc_variant_t src, pcvar_op_t op, void *ctxt,
+        size_t nr_args, purc_variant_t *argv)
+{
+    UNUSED_PARAM(src);
+    UNUSED_PARAM(op);
+    UNUSED_PARAM(nr_args);
+    UNUSED_PARAM(argv);
+
+    ((struct ctxt_for_iterate*)ctxt)->on_changed = 1;
+    return true;
+}
+
+/* keeps the rule parsed, and watches the container iterated on */
+static void
+keep_parsed_rule(struct ctxt_for_iterate *ctxt, const char *rule)
+{
+    free(ctxt->parsed_rule);
+    ctxt->parsed_rule = strdup(rule);
+    ctxt->on_changed = 0;
+
+    purc_variant_t on = ctxt->on;
+    if (ctxt->on_listener == NULL && (purc_variant_is_array(on) ||
+                purc_variant_is_object(on) || purc_variant_is_set(on))) {
+        ctxt->on_listener = purc_variant_register_post_listener(on,
+                PCVAR_OPERATION_GROW | PCVAR_OPERATION_SHRINK |
+                PCVAR_OPERATION_CHANGE, on_changed, ctxt);
+        /* without the listener, the rule is always parsed again */
+        if (ctxt->on_listener == NULL) {
+            free(ctxt->parsed_rule);
+            ctxt->parsed_rule = NULL;
+        }
+    }
+}
+
+/* whether the executor has to parse the rule again for the next item */
+static bool
+is_rule_changed(struct ctxt_for_iterate *ctxt, const char *rule)
+{
+    return ctxt->on_changed || ctxt->parsed_rule == NULL ||
+        strcmp(ctxt->parsed_rule, rule);
+}
+
+/*
+ * For an executor registered with the batch operations, the values are
+ * fetched in batches instead of one by one. This is only done when the
+ * rule is a literal, so that the rule is the same for all the items; the
+ * changes of the container iterated on are seen from the next batch.
+ */
+static bool
+use_batch(struct ctxt_for_iterate *ctxt)
+{
+    if (pcexec_get_batch_ops(&ctxt->ops) == NULL)
+        return false;
+
+    size_t len;
+    return ctxt->rule_attr == NULL ||
+        pcvdom_attr_get_literal(ctxt->rule_attr, &len) != NULL;
+}
+
+// returns the number of values fetched, or -1 on failure
+static ssize_t
+fetch_batch(struct ctxt_for_iterate *ctxt)
+{
+    purc_exec_batch_ops_t ops = pcexec_get_batch_ops(&ctxt->ops);
+
+    release_batch(ctxt);
+    if (ctxt->batch == NULL) {
+        ctxt->batch = (purc_variant_t *)malloc(sizeof(purc_variant_t) *
+                ITERATE_BATCH_SIZE);
+        if (ctxt->batch == NULL) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return -1;
+        }
+    }
+
+    ssize_t n = ops->it_values(ctxt->exec_inst, ctxt->it, ctxt->batch,
+            ITERATE_BATCH_SIZE);
+    if (n < 0)
+        return -1;
+
+    PC_ASSERT(n <= ITERATE_BATCH_SIZE);
+    ctxt->nr_batch = n;
+    ctxt->batch_end = (n < ITERATE_BATCH_SIZE);
+    return n;
+}
+
 static struct ctxt_for_iterate*
 post_process_by_internal_rule(struct ctxt_for_iterate *ctxt,
         struct pcintr_stack_frame *frame, const char *rule,
@@ -294,9 +414,21 @@ post_process_by_internal_rule(struct ctxt_for_iterate *ctxt,
     }
 
     ctxt->it = it;
+    keep_parsed_rule(ctxt, rule);
 
     purc_variant_t value;
-    value = ops->it_value(exec_inst, it);
+    if (use_batch(ctxt)) {
+        ssize_t n = fetch_batch(ctxt);
+        if (n <= 0) {
+            if (n < 0 || purc_get_last_error())
+                return ctxt;
+            return NULL;
+        }
+        value = ctxt->batch[0];
+    }
+    else {
+        value = ops->it_value(exec_inst, it);
+    }
     if (value == PURC_VARIANT_INVALID) {
         if (purc_get_last_error())
             return ctxt;
@@ -752,13 +884,37 @@ on_popping_internal_rule(struct ctxt_for_iterate *ctxt, pcintr_stack_t stack)
     if (!it)
         return true;
 
+    if (ctxt->batch) {
+        if (++ctxt->idx_batch < ctxt->nr_batch)
+            return false;
+        if (ctxt->batch_end)
+            return true;
+
+        ssize_t n = fetch_batch(ctxt);
+        if (n <= 0) {
+            if (purc_get_last_error() == PURC_ERROR_NOT_EXISTS)
+                purc_clr_error();
+            return true;
+        }
+        return false;
+    }
+
     const char *rule = eval_rule(ctxt, stack);
     if (!rule)
         return true;
 
     purc_exec_ops_t ops = ctxt->ops.internal_ops;
 
-    it = ops->it_next(exec_inst, it, rule);
+    /* parsing the same rule again makes the same result set, which takes
+       a copy of the whole container for some executors */
+    if (is_rule_changed(ctxt, rule)) {
+        it = ops->it_next(exec_inst, it, rule);
+        if (it)
+            keep_parsed_rule(ctxt, rule);
+    }
+    else {
+        it = ops->it_next(exec_inst, it, NULL);
+    }
 
     ctxt->it = it;
     if (!it) {
@@ -911,7 +1067,10 @@ rerun_internal_rule(struct ctxt_for_iterate *ctxt,
     purc_exec_ops_t ops = ctxt->ops.internal_ops;
 
     purc_variant_t value;
-    value = ops->it_value(exec_inst, it);
+    if (ctxt->batch)
+        value = ctxt->batch[ctxt->idx_batch];
+    else
+        value = ops->it_value(exec_inst, it);
     if (value == PURC_VARIANT_INVALID)
         return false;
 
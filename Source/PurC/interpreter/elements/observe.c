@@ -33,7 +33,9 @@
 
 #include "../ops.h"
 
+#include <errno.h>
 #include <pthread.h>
+#include <stdlib.h>
 #include <unistd.h>
 
 #define EVENT_SEPARATOR      ':'
@@ -53,6 +55,10 @@ struct ctxt_for_observe {
     char                         *msg_type;
     char                         *sub_type;
     purc_atom_t                   msg_type_atom;
+
+    // `throttle` or `debounce`: PCINTR_OBSERVER_RATE_XXX
+    int                           rate_kind;
+    uint32_t                      rate_ms;
 };
 
 static void
@@ -85,40 +91,6 @@ ctxt_destroy(void *ctxt)
     ctxt_for_observe_destroy((struct ctxt_for_observe*)ctxt);
 }
 
-bool base_variant_msg_listener(purc_variant_t source, pcvar_op_t msg_type,
-        void* ctxt, size_t nr_args, purc_variant_t* argv)
-{
-    UNUSED_PARAM(source);
-    UNUSED_PARAM(msg_type);
-    UNUSED_PARAM(ctxt);
-    UNUSED_PARAM(nr_args);
-    UNUSED_PARAM(argv);
-
-    const char *smsg = NULL;
-    switch (msg_type) {
-        case PCVAR_OPERATION_GROW:
-            smsg = MSG_TYPE_GROW;
-            break;
-        case PCVAR_OPERATION_SHRINK:
-            smsg = MSG_TYPE_SHRINK;
-            break;
-        case PCVAR_OPERATION_CHANGE:
-            smsg = MSG_TYPE_CHANGE;
-            break;
-        default:
-            PC_ASSERT(0);
-            break;
-    }
-
-    pcintr_stack_t stack = (pcintr_stack_t)ctxt;
-    pcintr_coroutine_post_event(stack->co->cid,
-            PCRDR_MSG_EVENT_REDUCE_OPT_IGNORE,
-            source, smsg, NULL, PURC_VARIANT_INVALID,
-            PURC_VARIANT_INVALID);
-
-    return true;
-}
-
 #define TIMERS_EXPIRED_PREFIX                "expired:"
 #define TIMERS_ACTIVATED_PREFIX              "activated:"
 #define TIMERS_DEACTIVATED_PREFIX            "deactivated:"
@@ -159,31 +131,314 @@ is_immutable_variant_msg(purc_atom_t msg)
     return false;
 }
 
+/*
+ * The observers of a container for a message type of the same coroutine
+ * share one listener of the container: a change fires one event with the
+ * delta as the data, like
+ *
+ *      { "op": "change", "index": 3, "old": ..., "new": ... }
+ *
+ * in which `index` is for an array, `key` for an object, and `old` and
+ * `new` are the removed one and the added one. The observers for the
+ * sub type `coalesced` get one event for all changes made in a step of
+ * the run loop instead, whose data is the array of the deltas.
+ */
+#define NR_WATCH_OPS            3
+
+struct change_batch;
+
+struct change_watch {
+    pcintr_stack_t              stack;
+    purc_variant_t              observed;
+    struct pcvar_listener      *listener;
+    const char                 *msg_type;
+    size_t                      nr_observers;
+    bool                        coalesce;
+
+    /* the deltas not posted yet if coalesce */
+    struct change_batch        *batch;
+};
+
+struct change_batch {
+    /* NULL if the watch is revoked */
+    struct change_watch        *watch;
+
+    purc_atom_t                 cid;
+    purc_variant_t              observed;
+    const char                 *msg_type;
+    purc_variant_t              deltas;
+};
+
+struct change_watches {
+    struct change_watch        *slots[NR_WATCH_OPS * 2];
+};
+
+static purc_variant_t
+make_change_delta(purc_variant_t source, const char *msg_type, pcvar_op_t op,
+        size_t nr_args, purc_variant_t *argv)
+{
+    const char *key_name = NULL;
+    purc_variant_t key = PURC_VARIANT_INVALID;
+    purc_variant_t o = PURC_VARIANT_INVALID;
+    purc_variant_t n = PURC_VARIANT_INVALID;
+
+    switch (purc_variant_get_type(source)) {
+    case PURC_VARIANT_TYPE_ARRAY:
+    case PURC_VARIANT_TYPE_OBJECT:
+        /* array: pos, value or pos, old, new;
+           object: key, value or key, old, key, new */
+        if (nr_args < 2)
+            break;
+        key_name = purc_variant_is_array(source) ? "index" : "key";
+        key = argv[0];
+        if (op == PCVAR_OPERATION_GROW)
+            n = argv[1];
+        else if (op == PCVAR_OPERATION_SHRINK || nr_args < 3)
+            o = argv[1];
+        else {
+            o = argv[1];
+            n = argv[nr_args - 1];
+        }
+        break;
+
+    case PURC_VARIANT_TYPE_SET:
+        /* value or old, new */
+        if (nr_args < 1)
+            break;
+        if (op == PCVAR_OPERATION_GROW)
+            n = argv[0];
+        else if (op == PCVAR_OPERATION_SHRINK || nr_args < 2)
+            o = argv[0];
+        else {
+            o = argv[0];
+            n = argv[1];
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    purc_variant_t delta = purc_variant_make_object_0();
+    if (delta == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    purc_variant_t v = purc_variant_make_string_static(msg_type, false);
+    if (v == PURC_VARIANT_INVALID)
+        goto failed;
+
+    bool ok = purc_variant_object_set_by_static_ckey(delta, "op", v);
+    purc_variant_unref(v);
+    if (!ok)
+        goto failed;
+
+    if ((key && !purc_variant_object_set_by_static_ckey(delta, key_name, key))
+            || (o && !purc_variant_object_set_by_static_ckey(delta, "old", o))
+            || (n && !purc_variant_object_set_by_static_ckey(delta, "new", n)))
+        goto failed;
+
+    return delta;
+
+failed:
+    purc_variant_unref(delta);
+    return PURC_VARIANT_INVALID;
+}
+
+static void
+flush_change_batch(void *ctxt)
+{
+    struct change_batch *batch = (struct change_batch *)ctxt;
+    if (batch->watch) {
+        batch->watch->batch = NULL;
+    }
+
+    pcintr_coroutine_post_event(batch->cid,
+            PCRDR_MSG_EVENT_REDUCE_OPT_KEEP,
+            batch->observed, batch->msg_type, MSG_SUB_TYPE_COALESCED,
+            batch->deltas, PURC_VARIANT_INVALID);
+
+    purc_variant_unref(batch->deltas);
+    purc_variant_unref(batch->observed);
+    free(batch);
+}
+
+static struct change_batch *
+new_change_batch(struct change_watch *watch)
+{
+    struct change_batch *batch = malloc(sizeof(*batch));
+    if (batch == NULL)
+        return NULL;
+
+    batch->deltas = purc_variant_make_array_0();
+    if (batch->deltas == PURC_VARIANT_INVALID) {
+        free(batch);
+        return NULL;
+    }
+
+    batch->watch = watch;
+    batch->cid = watch->stack->co->cid;
+    batch->observed = purc_variant_ref(watch->observed);
+    batch->msg_type = watch->msg_type;
+
+    purc_runloop_dispatch(purc_runloop_get_current(), flush_change_batch,
+            batch);
+    return batch;
+}
+
 static bool
-regist_variant_listener(pcintr_stack_t stack, purc_variant_t observed,
-        purc_atom_t op, struct pcvar_listener** listener)
+change_watch_handler(purc_variant_t source, pcvar_op_t op,
+        void* ctxt, size_t nr_args, purc_variant_t* argv)
+{
+    struct change_watch *watch = (struct change_watch *)ctxt;
+    purc_variant_t delta = make_change_delta(source, watch->msg_type, op,
+            nr_args, argv);
+
+    if (watch->coalesce && delta) {
+        if (watch->batch == NULL) {
+            watch->batch = new_change_batch(watch);
+        }
+
+        if (watch->batch &&
+                purc_variant_array_append(watch->batch->deltas, delta)) {
+            purc_variant_unref(delta);
+            return true;
+        }
+    }
+
+    // post the change alone, without the delta if no memory
+    pcintr_coroutine_post_event(watch->stack->co->cid,
+            PCRDR_MSG_EVENT_REDUCE_OPT_KEEP,
+            source, watch->msg_type,
+            watch->coalesce ? MSG_SUB_TYPE_COALESCED : NULL,
+            delta, PURC_VARIANT_INVALID);
+
+    if (delta) {
+        purc_variant_unref(delta);
+    }
+    return true;
+}
+
+static int
+watch_slot(purc_atom_t op, bool coalesce)
 {
+    int idx;
+    if (op == pcvariant_atom_grow)
+        idx = 0;
+    else if (op == pcvariant_atom_shrink)
+        idx = 1;
+    else
+        idx = 2;
+
+    return idx * 2 + (coalesce ? 1 : 0);
+}
+
+static struct change_watch *
+acquire_change_watch(pcintr_stack_t stack, purc_variant_t observed,
+        purc_atom_t op, bool coalesce)
+{
+    struct change_watches *watches = NULL;
+    struct pcutils_ptrmap_entry *entry;
+    entry = pcutils_ptrmap_find(&stack->change_watches, observed);
+    if (entry) {
+        watches = (struct change_watches *)entry->val;
+    }
+    else {
+        watches = calloc(1, sizeof(*watches));
+        if (watches == NULL ||
+                pcutils_ptrmap_set(&stack->change_watches, observed,
+                    watches)) {
+            free(watches);
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return NULL;
+        }
+    }
+
+    int slot = watch_slot(op, coalesce);
+    struct change_watch *watch = watches->slots[slot];
+    if (watch) {
+        watch->nr_observers++;
+        return watch;
+    }
+
+    pcvar_op_t var_op;
+    const char *msg_type;
     if (op == pcvariant_atom_grow) {
-        *listener = purc_variant_register_post_listener(observed,
-                PCVAR_OPERATION_GROW, base_variant_msg_listener, stack);
+        var_op = PCVAR_OPERATION_GROW;
+        msg_type = MSG_TYPE_GROW;
     }
     else if (op == pcvariant_atom_shrink) {
-        *listener = purc_variant_register_post_listener(observed,
-                PCVAR_OPERATION_SHRINK, base_variant_msg_listener, stack);
-    }
-    else if (op == pcvariant_atom_change) {
-        *listener = purc_variant_register_post_listener(observed,
-                PCVAR_OPERATION_CHANGE, base_variant_msg_listener, stack);
+        var_op = PCVAR_OPERATION_SHRINK;
+        msg_type = MSG_TYPE_SHRINK;
     }
     else {
-        PC_ASSERT(0);
-        return false;
+        PC_ASSERT(op == pcvariant_atom_change);
+        var_op = PCVAR_OPERATION_CHANGE;
+        msg_type = MSG_TYPE_CHANGE;
     }
 
-    if (*listener != NULL) {
-        return true;
+    watch = calloc(1, sizeof(*watch));
+    if (watch == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto failed;
     }
-    return false;
+
+    watch->stack = stack;
+    watch->observed = observed;
+    watch->msg_type = msg_type;
+    watch->coalesce = coalesce;
+    watch->nr_observers = 1;
+    watch->listener = purc_variant_register_post_listener(observed,
+            var_op, change_watch_handler, watch);
+    if (watch->listener == NULL) {
+        free(watch);
+        goto failed;
+    }
+
+    watches->slots[slot] = watch;
+    return watch;
+
+failed:
+    for (int i = 0; i < NR_WATCH_OPS * 2; i++) {
+        if (watches->slots[i])
+            return NULL;
+    }
+    pcutils_ptrmap_erase(&stack->change_watches, observed);
+    free(watches);
+    return NULL;
+}
+
+static void
+release_change_watch(struct change_watch *watch)
+{
+    if (--watch->nr_observers > 0)
+        return;
+
+    pcintr_stack_t stack = watch->stack;
+    struct pcutils_ptrmap_entry *entry;
+    entry = pcutils_ptrmap_find(&stack->change_watches, watch->observed);
+    PC_ASSERT(entry);
+
+    struct change_watches *watches = (struct change_watches *)entry->val;
+    bool empty = true;
+    for (int i = 0; i < NR_WATCH_OPS * 2; i++) {
+        if (watches->slots[i] == watch)
+            watches->slots[i] = NULL;
+        else if (watches->slots[i])
+            empty = false;
+    }
+
+    if (empty) {
+        pcutils_ptrmap_erase(&stack->change_watches, watch->observed);
+        free(watches);
+    }
+
+    // the pending deltas are still posted
+    if (watch->batch) {
+        watch->batch->watch = NULL;
+    }
+
+    purc_variant_revoke_listener(watch->observed, watch->listener);
+    free(watch);
 }
 
 static int
@@ -387,6 +642,72 @@ process_attr_in(struct pcintr_stack_frame *frame,
     return 0;
 }
 
+/* the interval is a number of milliseconds, or a string like `50ms`, `1s` */
+static bool
+parse_rate_interval(purc_variant_t val, uint32_t *ms)
+{
+    if (purc_variant_is_number(val)) {
+        double d;
+        if (!purc_variant_cast_to_number(val, &d, false) ||
+                !(d >= 0) || d > UINT32_MAX)
+            return false;
+        *ms = (uint32_t)d;
+        return true;
+    }
+
+    const char *s = purc_variant_get_string_const(val);
+    if (s == NULL || !purc_isdigit(*s))
+        return false;
+
+    char *end;
+    errno = 0;
+    unsigned long long n = strtoull(s, &end, 10);
+    if (errno == ERANGE)
+        return false;
+
+    if (*end == '\0' || strcmp(end, "ms") == 0) {
+        // milliseconds
+    }
+    else if (strcmp(end, "s") == 0) {
+        if (n > UINT32_MAX / 1000)
+            return false;
+        n *= 1000;
+    }
+    else {
+        return false;
+    }
+
+    if (n > UINT32_MAX)
+        return false;
+    *ms = (uint32_t)n;
+    return true;
+}
+
+static int
+process_attr_rate(struct pcintr_stack_frame *frame,
+        struct pcvdom_element *element,
+        purc_atom_t name, purc_variant_t val, int kind)
+{
+    struct ctxt_for_observe *ctxt;
+    ctxt = (struct ctxt_for_observe*)frame->ctxt;
+    if (ctxt->rate_kind != PCINTR_OBSERVER_RATE_NONE) {
+        purc_set_error_with_info(PURC_ERROR_DUPLICATED,
+                "vdom attribute '%s' for element <%s>",
+                purc_atom_to_string(name), element->tag_name);
+        return -1;
+    }
+    if (val == PURC_VARIANT_INVALID || !parse_rate_interval(val,
+                &ctxt->rate_ms)) {
+        purc_set_error_with_info(PURC_ERROR_INVALID_VALUE,
+                "vdom attribute '%s' for element <%s> is not an interval",
+                purc_atom_to_string(name), element->tag_name);
+        return -1;
+    }
+    ctxt->rate_kind = kind;
+
+    return 0;
+}
+
 static int
 attr_found_val(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
@@ -420,6 +741,14 @@ attr_found_val(struct pcintr_stack_frame *frame,
     if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, IN)) == name) {
         return process_attr_in(frame, element, name, val);
     }
+    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, THROTTLE)) == name) {
+        return process_attr_rate(frame, element, name, val,
+                PCINTR_OBSERVER_RATE_THROTTLE);
+    }
+    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, DEBOUNCE)) == name) {
+        return process_attr_rate(frame, element, name, val,
+                PCINTR_OBSERVER_RATE_DEBOUNCE);
+    }
 
     purc_set_error_with_info(PURC_ERROR_NOT_IMPLEMENTED,
             "vdom attribute '%s' for element <%s>",
@@ -558,12 +887,12 @@ register_timer_observer(pcintr_stack_t stack,
             edom_element, frame->pos, NULL, NULL);
 }
 
-void on_revoke_mmutable_var_observer(struct pcintr_observer *observer,
+static void
+on_revoke_mmutable_var_observer(struct pcintr_observer *observer,
         void *data)
 {
     if (observer && data) {
-        struct pcvar_listener *listener = (struct pcvar_listener*)data;
-        purc_variant_revoke_listener(observer->observed, listener);
+        release_change_watch((struct change_watch *)data);
     }
 }
 
@@ -576,8 +905,9 @@ register_mmutable_var_observer(pcintr_stack_t stack,
     struct ctxt_for_observe *ctxt;
     ctxt = (struct ctxt_for_observe*)frame->ctxt;
 
-    struct pcvar_listener *listener = NULL;
-    if (!regist_variant_listener(stack, on, ctxt->msg_type_atom, &listener))
+    struct change_watch *watch = acquire_change_watch(stack, on,
+            ctxt->msg_type_atom, ctxt->sub_type != NULL);
+    if (watch == NULL)
         return NULL;
 
     purc_variant_t at = pcintr_get_at_var(frame);
@@ -585,11 +915,15 @@ register_mmutable_var_observer(pcintr_stack_t stack,
     edom_element = pcdvobjs_get_element_from_elements(at, 0);
     PC_ASSERT(edom_element);
 
-    return pcintr_register_observer(stack, on,
+    struct pcintr_observer *observer = pcintr_register_observer(stack, on,
             ctxt->for_var, ctxt->msg_type_atom, ctxt->sub_type,
             frame->pos,
             edom_element, frame->pos,
-            on_revoke_mmutable_var_observer, listener);
+            on_revoke_mmutable_var_observer, watch);
+    if (observer == NULL) {
+        release_change_watch(watch);
+    }
+    return observer;
 }
 
 static bool
@@ -666,7 +1000,8 @@ process_variant_observer(pcintr_stack_t stack,
     case PURC_VARIANT_TYPE_ARRAY:
     case PURC_VARIANT_TYPE_SET:
         if (is_mmutable_variant_msg(ctxt->msg_type_atom) &&
-                (ctxt->sub_type == NULL)) {
+                (ctxt->sub_type == NULL ||
+                 strcmp(ctxt->sub_type, MSG_SUB_TYPE_COALESCED) == 0)) {
             return register_mmutable_var_observer(stack, frame, observed);
         }
         return register_default_observer(stack, frame, observed);
@@ -811,6 +1146,10 @@ after_pushed(pcintr_stack_t stack, pcvdom_element_t pos)
         return ctxt;
     }
 
+    if (ctxt->rate_kind != PCINTR_OBSERVER_RATE_NONE) {
+        pcintr_observer_set_rate(observer, ctxt->rate_kind, ctxt->rate_ms);
+    }
+
     if (ctxt->as != PURC_VARIANT_INVALID && purc_variant_is_string(ctxt->as)) {
         const char* name = purc_variant_get_string_const(ctxt->as);
         static struct purc_native_ops ops = {
@@ -30,6 +30,7 @@
 #include "private/debug.h"
 #include "private/dvobjs.h"
 #include "private/executor.h"
+#include "private/smallvec.h"
 #include "purc-runloop.h"
 
 #include "../executors/exe_func.h"
@@ -41,11 +42,16 @@
 #include <unistd.h>
 #include <errno.h>
 
+/* the keys given by `against` are rarely more than these */
+#define NR_INLINE_SORT_KEYS     4
+
 struct sort_key {
     char *key;
     bool by_number;
 };
 
+PCUTILS_SMALLVEC_DEFINE(boolvec, bool, NR_INLINE_SORT_KEYS * 2);
+
 struct ctxt_for_sort {
     struct pcvdom_node           *curr;
     purc_variant_t                on;
@@ -288,7 +294,8 @@ split_key(const char *key)
         return NULL;
     }
 
-    struct pcutils_arrlist *keys = pcutils_arrlist_new(sort_key_free_fn);
+    struct pcutils_arrlist *keys = pcutils_arrlist_new_ex(sort_key_free_fn,
+            NR_INLINE_SORT_KEYS);
     if (keys == NULL) {
         purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
         return NULL;
@@ -319,104 +326,44 @@ split_key(const char *key)
     return keys;
 }
 
-static int
-comp_number(double l, double r, bool ascendingly)
-{
-    if (ascendingly) {
-        return (l > r) ? 1 : (l < r ? -1 : 0);
-    }
-    return (l > r) ? -1 : (l < r ? 1 : 0);
-}
-
-static int
-comp_string(const char *l, const char *r, bool ascendingly, bool casesensitively)
-{
-    if (!l || !r) {
-        return 0;
-    }
-    int ret = casesensitively ? strcmp(l, r) : strcasecmp(l, r);
-    return ascendingly ? ret : -ret;
-}
-
-#define UNDEFINED_STR       "undefined"
-
-static char *
-variant_to_string(purc_variant_t v)
-{
-    if (!v) {
-        return strdup(UNDEFINED_STR);
-    }
-
-    char *buf = NULL;
-    int total = purc_variant_stringify_alloc(&buf, v);
-    if (total < 0) {
-        return NULL;
-    }
-    return buf;
-}
-
-static int
-comp_raw(purc_variant_t l, purc_variant_t r, bool by_number,
-        bool ascendingly, bool casesensitively)
-{
-    if (by_number) {
-        double dl = l ? purc_variant_numberify(l) : 0.0f;
-        double dr = r ? purc_variant_numberify(r) : 0.0f;
-        return comp_number(dl, dr, ascendingly);
-    }
-
-    char *buf_l = variant_to_string(l);
-    char *buf_r = variant_to_string(r);
-    int ret = comp_string(buf_l, buf_r, ascendingly, casesensitively);
-    if (buf_l) {
-        free(buf_l);
-    }
-    if (buf_r) {
-        free(buf_r);
-    }
-    return ret;
-}
-
-static int
-comp_by_key(purc_variant_t l, purc_variant_t r, const char *key, bool by_number,
-        bool ascendingly, bool casesensitively)
+static purc_variant_t
+get_sort_key(purc_variant_t member, size_t idx, void *ud)
 {
-    purc_variant_t lv = PURC_VARIANT_INVALID;
-    purc_variant_t rv = PURC_VARIANT_INVALID;
-    if (purc_variant_is_object(l)) {
-        lv = purc_variant_object_get_by_ckey(l, key);
-        purc_clr_error();
+    struct ctxt_for_sort *ctxt = ud;
+    struct sort_key *key = pcutils_arrlist_get_idx(ctxt->keys, idx);
+    if (key->key == NULL) {
+        return member;
     }
 
-    if (purc_variant_is_object(r)) {
-        rv = purc_variant_object_get_by_ckey(r, key);
+    purc_variant_t v = PURC_VARIANT_INVALID;
+    if (purc_variant_is_object(member)) {
+        v = purc_variant_object_get_by_ckey(member, key->key);
         purc_clr_error();
     }
-
-    return comp_raw(lv, rv, by_number, ascendingly, casesensitively);
+    return v;
 }
 
-static int
-sort_cmp(purc_variant_t l, purc_variant_t r, void *data)
+/* the keys are extracted once instead of in every comparison */
+static void
+sort_by_keys(struct ctxt_for_sort *ctxt, purc_variant_t container)
 {
-    struct ctxt_for_sort *ctxt = data;
     size_t nr_keys = pcutils_arrlist_length(ctxt->keys);
+    struct boolvec by_number;
+    boolvec_init(&by_number);
+
     for (size_t i = 0; i < nr_keys; i++) {
         struct sort_key *key = pcutils_arrlist_get_idx(ctxt->keys, i);
-        int ret = 0;
-        if (key->key == NULL) {
-            ret = comp_raw(l, r, key->by_number, ctxt->ascendingly,
-                    ctxt->casesensitively);
-        }
-        else {
-            ret = comp_by_key(l, r, key->key, key->by_number,
-                    ctxt->ascendingly, ctxt->casesensitively);
-        }
-        if (ret != 0) {
-            return ret;
+        if (boolvec_push(&by_number, key->by_number)) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            goto done;
         }
     }
-    return 0;
+
+    pcvariant_sort_by_keys(container, nr_keys, boolvec_data(&by_number),
+            get_sort_key, ctxt, !ctxt->ascendingly, !ctxt->casesensitively);
+
+done:
+    boolvec_clear(&by_number);
 }
 
 static bool
@@ -449,7 +396,8 @@ sort_array(struct ctxt_for_sort *ctxt, purc_variant_t array,
     }
 
     if (ctxt->keys == NULL) {
-        struct pcutils_arrlist *keys = pcutils_arrlist_new(sort_key_free_fn);
+        struct pcutils_arrlist *keys = pcutils_arrlist_new_ex(
+                sort_key_free_fn, 1);
         if (keys == NULL) {
             purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
             return;
@@ -485,7 +433,7 @@ sort_array(struct ctxt_for_sort *ctxt, purc_variant_t array,
             }
         }
     }
-    pcvariant_array_sort(array, ctxt, sort_cmp);
+    sort_by_keys(ctxt, array);
 }
 
 
@@ -502,7 +450,8 @@ sort_set(struct ctxt_for_sort *ctxt, purc_variant_t set, purc_variant_t against)
     }
 
     if (ctxt->keys == NULL) {
-        struct pcutils_arrlist *keys = pcutils_arrlist_new(sort_key_free_fn);
+        struct pcutils_arrlist *keys = pcutils_arrlist_new_ex(
+                sort_key_free_fn, 1);
         if (keys == NULL) {
             purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
             return;
@@ -538,7 +487,7 @@ sort_set(struct ctxt_for_sort *ctxt, purc_variant_t set, purc_variant_t against)
             }
         }
     }
-    pcvariant_set_sort(set, ctxt, sort_cmp);
+    sort_by_keys(ctxt, set);
 }
 
 static int
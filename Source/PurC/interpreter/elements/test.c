@@ -35,6 +35,12 @@
 
 #include "purc-executor.h"
 
+#include "private/hashtable.h"
+
+// FIXME: the parser of `for` rules and the expressions it compiles to are
+// internal to the executors; move what <test> needs to include/private/.
+#include "../executors/match_for.h"
+
 #include <pthread.h>
 #include <unistd.h>
 
@@ -49,9 +55,314 @@ struct ctxt_for_test {
     purc_exec_inst_t        exec_inst;
     purc_exec_iter_t        it;
 
+    // the children to select, given by the dispatch table; NULL if there
+    // is no table, then all the children are selected in turn
+    struct test_branches   *branches;
+    size_t                  next_branch;
+    bool                    dispatched;
+
     bool handle_differ;
 };
 
+/*
+ * When every <match> child of a <test> compares the value only for the
+ * equality with constant numbers (e.g. `for="EQ 3"` or `for="EQ 3 OR EQ 5"`),
+ * a dispatch table from the numbers to the children is compiled when the
+ * element is executed the first time, and kept in the vDOM element. Then
+ * select_child() only goes through the children which may match, instead of
+ * pushing every <match> to evaluate its `for` attribute in turn.
+ */
+
+// the least number of <match> to compile a dispatch table for
+#define MIN_MATCHES_TO_DISPATCH     4
+
+struct test_branches {
+    struct pcvdom_element **elems;
+    size_t                  nr;
+    size_t                  sz;
+};
+
+struct test_case {
+    double                  key;
+    struct test_branches    branches;
+};
+
+struct test_dispatch {
+    // key: double *, val: struct test_case *; NULL if the children can not
+    // be dispatched
+    struct pchash_table    *cases;
+    struct test_case       *all_cases;
+    size_t                  nr_cases;
+
+    // the children selected if no case is matched
+    struct test_branches    defaults;
+};
+
+// a child to dispatch, and the keys to select it; always selected if
+// `keys` is NULL
+struct test_child {
+    struct pcvdom_element  *elem;
+    double                 *keys;
+    size_t                  nr_keys;
+};
+
+static unsigned long
+case_key_hash(const void *k)
+{
+    uint64_t bits;
+    memcpy(&bits, k, sizeof(bits));
+    bits ^= bits >> 33;
+    bits *= 0xff51afd7ed558ccdULL;
+    bits ^= bits >> 33;
+    return (unsigned long)bits;
+}
+
+static int
+case_key_equal(const void *k1, const void *k2)
+{
+    return *(const double *)k1 == *(const double *)k2;
+}
+
+static void
+branches_reset(struct test_branches *branches)
+{
+    free(branches->elems);
+    branches->elems = NULL;
+    branches->nr = 0;
+    branches->sz = 0;
+}
+
+static void
+test_dispatch_free(void *compiled)
+{
+    struct test_dispatch *dispatch = (struct test_dispatch *)compiled;
+
+    if (dispatch->cases)
+        pchash_table_free(dispatch->cases);
+    for (size_t i = 0; i < dispatch->nr_cases; i++)
+        branches_reset(&dispatch->all_cases[i].branches);
+    free(dispatch->all_cases);
+    branches_reset(&dispatch->defaults);
+    free(dispatch);
+}
+
+static int
+append_branch(struct test_branches *branches, struct pcvdom_element *elem)
+{
+    // a child may give the same key twice
+    if (branches->nr > 0 && branches->elems[branches->nr - 1] == elem)
+        return 0;
+
+    if (branches->nr == branches->sz) {
+        size_t sz = branches->sz ? branches->sz * 2 : 4;
+        struct pcvdom_element **elems = (struct pcvdom_element **)
+            realloc(branches->elems, sizeof(*elems) * sz);
+        if (elems == NULL)
+            return -1;
+        branches->elems = elems;
+        branches->sz = sz;
+    }
+
+    branches->elems[branches->nr++] = elem;
+    return 0;
+}
+
+// -0 equals 0, so they should be the same key
+static inline double
+normalize_key(double key)
+{
+    return key == 0 ? 0 : key;
+}
+
+static int
+collect_keys(struct number_comparing_logical_expression *ncle,
+        struct test_child *child)
+{
+    struct pctree_node *node = &ncle->node;
+    struct number_comparing_logical_expression *l = NULL, *r = NULL;
+    if (node->first_child) {
+        l = container_of(node->first_child,
+                struct number_comparing_logical_expression, node);
+        if (node->first_child->next)
+            r = container_of(node->first_child->next,
+                    struct number_comparing_logical_expression, node);
+    }
+
+    switch (ncle->type) {
+        case NUMBER_COMPARING_LOGICAL_EXPRESSION_OR:
+            PC_ASSERT(l && r);
+            if (collect_keys(l, child) || collect_keys(r, child))
+                return -1;
+            return 0;
+
+        case NUMBER_COMPARING_LOGICAL_EXPRESSION_NUM:
+            if (ncle->ncc.op_type != NUMBER_COMPARING_EQ)
+                return -1;
+            break;
+
+        default:
+            return -1;
+    }
+
+    // NaN never equals any value
+    if (isnan(ncle->ncc.nexp))
+        return 0;
+
+    double *keys = (double *)realloc(child->keys,
+            sizeof(*keys) * (child->nr_keys + 1));
+    if (keys == NULL)
+        return -1;
+    keys[child->nr_keys++] = normalize_key(ncle->ncc.nexp);
+    child->keys = keys;
+    return 0;
+}
+
+// gets the keys from the `for` attribute of a <match>
+static int
+parse_match_keys(struct pcvdom_element *elem, struct test_child *child)
+{
+    struct pcvdom_attr *attr;
+    attr = pcvdom_element_find_attr(elem,
+            pchvml_keyword_str(PCHVML_KEYWORD_ENUM(HVML, FOR)));
+    if (attr == NULL)
+        return 0;       // always matched
+
+    if (attr->op != PCHVML_ATTRIBUTE_OPERATOR)
+        return -1;
+
+    size_t len;
+    pcvdom_attr_get_vcm(attr);
+    const char *literal = pcvdom_attr_get_literal(attr, &len);
+    if (literal == NULL)
+        return -1;
+
+    struct match_for_param param;
+    memset(&param, 0, sizeof(param));
+
+    int r = -1;
+    char *rule = strndup(literal, len);
+    if (rule && match_for_parse(rule, len, &param) == 0 &&
+            param.rule.ncle && !param.rule.smle) {
+        // an empty set of keys is never matched
+        child->keys = (double *)malloc(sizeof(double));
+        if (child->keys)
+            r = collect_keys(param.rule.ncle, child);
+    }
+
+    free(rule);
+    match_for_param_reset(&param);
+    return r;
+}
+
+static struct test_dispatch *
+compile_dispatch(struct pcvdom_element *element)
+{
+    struct test_dispatch *dispatch;
+    dispatch = (struct test_dispatch *)calloc(1, sizeof(*dispatch));
+    if (dispatch == NULL)
+        return NULL;
+
+    struct test_child *children = NULL;
+    size_t nr_children = 0, nr_matches = 0, nr_keys = 0;
+
+    struct pcvdom_node *node = pcvdom_node_first_child(&element->node);
+    for (; node; node = pcvdom_node_next_sibling(node)) {
+        if (node->type != PCVDOM_NODE_ELEMENT)
+            continue;
+
+        struct pcvdom_element *elem = PCVDOM_ELEMENT_FROM_NODE(node);
+        if (elem->tag_id == PCHVML_TAG_DIFFER)
+            continue;
+
+        struct test_child *tmp = (struct test_child *)realloc(children,
+                sizeof(*children) * (nr_children + 1));
+        if (tmp == NULL)
+            goto failed;
+        children = tmp;
+
+        struct test_child *child = children + nr_children++;
+        memset(child, 0, sizeof(*child));
+        child->elem = elem;
+
+        if (elem->tag_id == PCHVML_TAG_MATCH) {
+            if (parse_match_keys(elem, child))
+                goto failed;
+            if (child->keys) {
+                nr_matches++;
+                nr_keys += child->nr_keys;
+            }
+        }
+    }
+
+    if (nr_matches < MIN_MATCHES_TO_DISPATCH)
+        goto failed;
+
+    dispatch->all_cases = (struct test_case *)calloc(nr_keys ? nr_keys : 1,
+            sizeof(struct test_case));
+    dispatch->cases = pchash_table_new(nr_keys * 2 + 1, NULL,
+            case_key_hash, case_key_equal);
+    if (dispatch->all_cases == NULL || dispatch->cases == NULL)
+        goto failed;
+
+    for (size_t i = 0; i < nr_children; i++) {
+        struct test_child *child = children + i;
+
+        if (child->keys == NULL) {
+            for (size_t j = 0; j < dispatch->nr_cases; j++) {
+                if (append_branch(&dispatch->all_cases[j].branches,
+                            child->elem))
+                    goto failed;
+            }
+            if (append_branch(&dispatch->defaults, child->elem))
+                goto failed;
+            continue;
+        }
+
+        for (size_t k = 0; k < child->nr_keys; k++) {
+            struct test_case *tc = NULL;
+            if (!pchash_table_lookup_ex(dispatch->cases, child->keys + k,
+                        (void **)&tc)) {
+                // a new case selects the children always selected so far
+                tc = dispatch->all_cases + dispatch->nr_cases++;
+                tc->key = child->keys[k];
+                for (size_t j = 0; j < dispatch->defaults.nr; j++) {
+                    if (append_branch(&tc->branches,
+                                dispatch->defaults.elems[j]))
+                        goto failed;
+                }
+                if (pchash_table_insert(dispatch->cases, &tc->key, tc))
+                    goto failed;
+            }
+
+            if (append_branch(&tc->branches, child->elem))
+                goto failed;
+        }
+    }
+
+    for (size_t i = 0; i < nr_children; i++)
+        free(children[i].keys);
+    free(children);
+    purc_clr_error();
+    return dispatch;
+
+failed:
+    for (size_t i = 0; i < nr_children; i++)
+        free(children[i].keys);
+    free(children);
+
+    // keep an empty one to not compile again
+    if (dispatch->cases) {
+        pchash_table_free(dispatch->cases);
+        dispatch->cases = NULL;
+    }
+    for (size_t i = 0; i < dispatch->nr_cases; i++)
+        branches_reset(&dispatch->all_cases[i].branches);
+    dispatch->nr_cases = 0;
+    branches_reset(&dispatch->defaults);
+    purc_clr_error();
+    return dispatch;
+}
+
 static void
 ctxt_for_test_destroy(struct ctxt_for_test *ctxt)
 {
@@ -76,6 +387,43 @@ ctxt_destroy(void *ctxt)
     ctxt_for_test_destroy((struct ctxt_for_test*)ctxt);
 }
 
+// gets the children to select by the dispatch table, or NULL if no table
+static struct test_branches *
+dispatch_branches(struct pcintr_stack_frame *frame,
+        struct ctxt_for_test *ctxt)
+{
+    struct pcvdom_element *element = frame->pos;
+
+    if (ctxt->handle_differ || ctxt->on == PURC_VARIANT_INVALID)
+        return NULL;
+
+    struct test_dispatch *dispatch = (struct test_dispatch *)
+        pcvdom_element_get_compiled(element, test_dispatch_free);
+    if (dispatch == NULL) {
+        dispatch = compile_dispatch(element);
+        if (dispatch == NULL) {
+            purc_clr_error();
+            return NULL;
+        }
+        dispatch = (struct test_dispatch *)
+            pcvdom_element_set_compiled(element, dispatch, test_dispatch_free);
+    }
+
+    if (dispatch->cases == NULL)
+        return NULL;
+
+    purc_variant_t value = pcintr_get_question_var(frame);
+    if (value == PURC_VARIANT_INVALID)
+        return NULL;
+
+    double key = normalize_key(purc_variant_numberify(value));
+    struct test_case *tc = NULL;
+    if (pchash_table_lookup_ex(dispatch->cases, &key, (void **)&tc))
+        return &tc->branches;
+
+    return &dispatch->defaults;
+}
+
 static int
 post_process_dest_data(pcintr_coroutine_t co, struct pcintr_stack_frame *frame)
 {
@@ -480,6 +828,21 @@ select_child(pcintr_stack_t stack, void* ud)
 
     struct pcvdom_node *curr;
 
+    if (!ctxt->dispatched) {
+        ctxt->dispatched = true;
+        ctxt->branches = dispatch_branches(frame, ctxt);
+    }
+
+    if (ctxt->branches) {
+        if (ctxt->next_branch >= ctxt->branches->nr)
+            return NULL;
+
+        pcvdom_element_t element;
+        element = ctxt->branches->elems[ctxt->next_branch++];
+        on_element(co, frame, element);
+        return element;
+    }
+
 again:
     curr = ctxt->curr;
 
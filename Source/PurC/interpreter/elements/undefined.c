@@ -35,9 +35,16 @@
 #include <pthread.h>
 #include <unistd.h>
 
+#define ATTR_REACTIVE        "hvml:reactive"
+
 struct ctxt_for_undefined {
     struct pcvdom_node           *curr;
     purc_variant_t                href;
+
+    // for `hvml:reactive`; the binding is owned by the stack
+    char                         *elem_id;
+    struct pcintr_binding        *binding;
+    unsigned int                  reactive:1;
 };
 
 static void
@@ -45,6 +52,7 @@ ctxt_for_undefined_destroy(struct ctxt_for_undefined *ctxt)
 {
     if (ctxt) {
         PURC_VARIANT_SAFE_CLEAR(ctxt->href);
+        free(ctxt->elem_id);
         free(ctxt);
     }
 }
@@ -106,9 +114,19 @@ attr_found_val(struct pcintr_stack_frame *frame,
 
     /* VW: do not set attributes having `hvml:` prefix to eDOM */
     if (strncmp(attr->key, "hvml:", 5) == 0) {
+        if (strcmp(attr->key, ATTR_REACTIVE) == 0) {
+            struct ctxt_for_undefined *ctxt = frame->ctxt;
+            ctxt->reactive = 1;
+        }
         goto done;
     }
 
+    if (strcmp(attr->key, "id") == 0 && sv[0]) {
+        struct ctxt_for_undefined *ctxt = frame->ctxt;
+        free(ctxt->elem_id);
+        ctxt->elem_id = strdup(sv);
+    }
+
     int r = pcintr_util_set_attribute(frame->owner->doc,
             frame->edom_element, PCDOC_OP_DISPLACE, attr->key, sv, 0);
     PC_ASSERT(r == 0);
@@ -294,6 +312,38 @@ on_element(pcintr_coroutine_t co, struct pcintr_stack_frame *frame,
     UNUSED_PARAM(element);
 }
 
+static bool
+has_child_element(struct pcvdom_element *element)
+{
+    struct pcvdom_node *node = pcvdom_node_first_child(&element->node);
+    for (; node; node = pcvdom_node_next_sibling(node)) {
+        if (node->type == PCVDOM_NODE_ELEMENT)
+            return true;
+    }
+    return false;
+}
+
+/* the text content of a reactive element is refreshed as a whole, so
+   a binding is made only for an element having an identifier and no
+   child element */
+static struct pcintr_binding *
+get_binding(pcintr_stack_t stack, struct pcintr_stack_frame *frame)
+{
+    struct ctxt_for_undefined *ctxt = frame->ctxt;
+    if (ctxt == NULL || !ctxt->reactive || ctxt->elem_id == NULL)
+        return NULL;
+
+    if (ctxt->binding == NULL && !has_child_element(frame->pos)) {
+        ctxt->binding = pcintr_reactive_bind(stack, ctxt->elem_id,
+                frame->silently);
+    }
+
+    // not to try again
+    if (ctxt->binding == NULL)
+        ctxt->reactive = 0;
+    return ctxt->binding;
+}
+
 static void
 on_content(pcintr_coroutine_t co, struct pcintr_stack_frame *frame,
         struct pcvdom_content *content)
@@ -310,7 +360,12 @@ on_content(pcintr_coroutine_t co, struct pcintr_stack_frame *frame,
     if (!vcm)
         return;
 
-    purc_variant_t v = pcvcm_eval(vcm, stack, frame->silently);
+    purc_variant_t v;
+    struct pcintr_binding *binding = get_binding(stack, frame);
+    if (binding)
+        v = pcintr_reactive_eval(stack, binding, vcm);
+    else
+        v = pcvcm_eval(vcm, stack, frame->silently);
     if (v == PURC_VARIANT_INVALID)
         return;
 
@@ -50,6 +50,8 @@ struct ctxt_for_update {
     purc_variant_t                with;
     enum pchvml_attr_operator     with_op;
     pcintr_attribute_op           with_eval;
+    /* the values of the holes if the template with can be placed */
+    purc_variant_t                holes;
 
     purc_variant_t                literal;
 };
@@ -64,6 +66,7 @@ ctxt_for_update_destroy(struct ctxt_for_update *ctxt)
         PURC_VARIANT_SAFE_CLEAR(ctxt->from);
         PURC_VARIANT_SAFE_CLEAR(ctxt->from_result);
         PURC_VARIANT_SAFE_CLEAR(ctxt->with);
+        PURC_VARIANT_SAFE_CLEAR(ctxt->holes);
         PURC_VARIANT_SAFE_CLEAR(ctxt->literal);
         free(ctxt);
     }
@@ -102,7 +105,11 @@ get_source_by_with(pcintr_coroutine_t co, struct pcintr_stack_frame *frame,
         return with;
     }
     else if (purc_variant_is_native(with)) {
-        return pcintr_template_expansion(with);
+        struct ctxt_for_update *ctxt;
+        ctxt = (struct ctxt_for_update*)frame->ctxt;
+        PURC_VARIANT_SAFE_CLEAR(ctxt->holes);
+        return pcintr_template_expansion_ex(with, frame->silently,
+                &ctxt->holes);
     }
     else {
         purc_variant_ref(with);
@@ -249,6 +256,18 @@ update_array(pcintr_coroutine_t co, struct pcintr_stack_frame *frame,
         bool ok = purc_variant_array_append(target, src);
         return ok ? 0 : -1;
     }
+    if (strcmp(op, "unite") == 0) {
+        bool ok = purc_variant_array_unite(target, src, frame->silently);
+        return ok ? 0 : -1;
+    }
+    if (strcmp(op, "intersect") == 0) {
+        bool ok = purc_variant_array_intersect(target, src, frame->silently);
+        return ok ? 0 : -1;
+    }
+    if (strcmp(op, "subtract") == 0) {
+        bool ok = purc_variant_array_subtract(target, src, frame->silently);
+        return ok ? 0 : -1;
+    }
 
     struct pcvdom_element *element = frame->pos;
     PC_ASSERT(element);
@@ -358,9 +377,19 @@ static pcdoc_operation convert_operation(const char *to)
 static int
 update_target_child(pcintr_stack_t stack, pcdoc_element_t target,
         const char *to, purc_variant_t src,
-        pcintr_attribute_op with_eval)
+        pcintr_attribute_op with_eval, struct ctxt_for_update *ctxt)
 {
     UNUSED_PARAM(stack);
+
+    /* the nodes of the template are placed without parsing src again */
+    pcdoc_operation op = convert_operation(to);
+    if (ctxt->holes != PURC_VARIANT_INVALID && op != PCDOC_OP_UNKNOWN) {
+        int r = pcintr_template_place(stack, ctxt->with, ctxt->holes,
+                target, op);
+        if (r <= 0)
+            return r;
+    }
+
     char *t = NULL;
     const char *s = "undefined";
     if (purc_variant_is_undefined(src)) {
@@ -380,7 +409,6 @@ update_target_child(pcintr_stack_t stack, pcdoc_element_t target,
 
     UNUSED_PARAM(with_eval);
 
-    pcdoc_operation op = convert_operation(to);
     if (op != PCDOC_OP_UNKNOWN) {
         pcintr_util_new_content(stack->doc, target, op, s, 0);
         if (t)
@@ -406,13 +434,11 @@ update_target_content(pcintr_stack_t stack, pcdoc_element_t target,
     UNUSED_PARAM(with_eval);
 
     if (purc_variant_is_string(src)) {
-        size_t len;
-        const char *s = purc_variant_get_string_const_ex(src, &len);
-
         pcdoc_operation op = convert_operation(to);
         if (op != PCDOC_OP_UNKNOWN) {
-            pcdoc_text_node_t node = pcintr_util_new_text_content(stack->doc,
-                    target, op, s, len);
+            pcdoc_text_node_t node;
+            node = pcintr_util_new_shared_text_content(stack->doc,
+                    target, op, src);
             PC_ASSERT(node);
             return 0;
         }
@@ -496,7 +522,7 @@ update_target_attr(pcintr_stack_t stack, pcdoc_element_t target,
 static int
 update_target(pcintr_stack_t stack, pcdoc_element_t target,
         purc_variant_t at, purc_variant_t to, purc_variant_t src,
-        pcintr_attribute_op with_eval)
+        pcintr_attribute_op with_eval, struct ctxt_for_update *ctxt)
 {
     const char *s_to = "displace";
     if (to != PURC_VARIANT_INVALID) {
@@ -512,7 +538,8 @@ update_target(pcintr_stack_t stack, pcdoc_element_t target,
     }
 
     if (!s_at) {
-        return update_target_child(stack, target, s_to, src, with_eval);
+        return update_target_child(stack, target, s_to, src, with_eval,
+                ctxt);
     }
     if (strcmp(s_at, "textContent") == 0) {
         return update_target_content(stack, target, s_to, src, with_eval);
@@ -533,7 +560,7 @@ static int
 update_elements(pcintr_stack_t stack,
         purc_variant_t elems, purc_variant_t at, purc_variant_t to,
         purc_variant_t src,
-        pcintr_attribute_op with_eval)
+        pcintr_attribute_op with_eval, struct ctxt_for_update *ctxt)
 {
     PC_ASSERT(purc_variant_is_native(elems));
     size_t idx = 0;
@@ -542,7 +569,7 @@ update_elements(pcintr_stack_t stack,
         target = pcdvobjs_get_element_from_elements(elems, idx++);
         if (!target)
             break;
-        int r = update_target(stack, target, at, to, src, with_eval);
+        int r = update_target(stack, target, at, to, src, with_eval, ctxt);
         if (r)
             return -1;
     }
@@ -569,7 +596,8 @@ process(pcintr_coroutine_t co, struct pcintr_stack_frame *frame,
     if (type == PURC_VARIANT_TYPE_NATIVE) {
         // const char *s = purc_variant_get_string_const(src);
         // PC_ASSERT(to != PURC_VARIANT_INVALID);
-        return update_elements(&co->stack, on, at, to, src, with_eval);
+        return update_elements(&co->stack, on, at, to, src, with_eval,
+                ctxt);
     }
     if (type == PURC_VARIANT_TYPE_OBJECT) {
         return update_object(&co->stack, on, at, to, src, with_eval);
@@ -590,7 +618,8 @@ process(pcintr_coroutine_t co, struct pcintr_stack_frame *frame,
         elem = pcdvobjs_get_element_from_elements(elems, 0);
         int r = 0;
         if (elem) {
-            r = update_elements(&co->stack, elems, at, to, src, with_eval);
+            r = update_elements(&co->stack, elems, at, to, src, with_eval,
+                    ctxt);
         }
         purc_variant_unref(elems);
         return r ? -1 : 0;
@@ -0,0 +1,434 @@
+/*
+ * @file fdmon.cpp
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The epoll backend of the file descriptor monitors of runloop.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "purc.h"
+
+#include "config.h"
+
+#include "purc-runloop.h"
+#include "private/debug.h"
+#include "private/errors.h"
+#include "private/interpreter.h"
+#include "private/list.h"
+#include "private/sorted-array.h"
+
+#include <wtf/RunLoop.h>
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if OS(LINUX)
+#include <sys/epoll.h>
+
+/*
+ * All file descriptors monitored by an instance are put into one epoll
+ * instance, and only the epoll file descriptor is monitored by GLib.
+ * When it becomes readable, the ready file descriptors are fetched and
+ * dispatched in a batch.
+ */
+
+#define FDMON_MAX_EVENTS        64
+
+struct fdmon_fd;
+
+struct fdmon_watch {
+    struct list_head            ln;
+    struct fdmon_fd            *fde;
+    uint32_t                    events;     // EPOLLIN, EPOLLPRI, EPOLLOUT
+    uint64_t                    seq;        // the last dispatching sequence
+    purc_runloop_io_callback    callback;
+    void                       *ctxt;
+};
+
+struct fdmon_fd {
+    struct list_head            watches;
+    struct list_head            ln_dead;
+    int                         fd;
+    uint32_t                    events;     // the events registered
+    unsigned int                dead:1;
+};
+
+struct pcintr_fdmon {
+    RunLoop                    *loop;
+    int                         epfd;
+    uintptr_t                   epfd_monitor;
+
+    // fd -> struct fdmon_fd
+    struct sorted_array        *fds;
+
+    // the fd entries removed while dispatching
+    struct list_head            dead_fds;
+    uint64_t                    seq;
+    unsigned int                dispatching;
+
+    struct pcintr_fdmon_stat    stat;
+};
+
+static uint32_t
+to_epoll_events(purc_runloop_io_event event)
+{
+    uint32_t events = 0;
+    if (event & PCRUNLOOP_IO_IN) {
+        events |= EPOLLIN;
+    }
+    if (event & PCRUNLOOP_IO_PRI) {
+        events |= EPOLLPRI;
+    }
+    if (event & PCRUNLOOP_IO_OUT) {
+        events |= EPOLLOUT;
+    }
+    return events;
+}
+
+static purc_runloop_io_event
+to_runloop_io_event(uint32_t events)
+{
+    int event = 0;
+    if (events & EPOLLIN) {
+        event |= PCRUNLOOP_IO_IN;
+    }
+    if (events & EPOLLPRI) {
+        event |= PCRUNLOOP_IO_PRI;
+    }
+    if (events & EPOLLOUT) {
+        event |= PCRUNLOOP_IO_OUT;
+    }
+    if (events & EPOLLERR) {
+        event |= PCRUNLOOP_IO_ERR;
+    }
+    if (events & EPOLLHUP) {
+        event |= PCRUNLOOP_IO_HUP;
+    }
+    return (purc_runloop_io_event)event;
+}
+
+static void
+release_fd(struct pcintr_fdmon *fdmon, struct fdmon_fd *fde)
+{
+    epoll_ctl(fdmon->epfd, EPOLL_CTL_DEL, fde->fd, NULL);
+    pcutils_sorted_array_remove(fdmon->fds, (void *)(uintptr_t)fde->fd);
+    fdmon->stat.nr_fds--;
+
+    if (fdmon->dispatching) {
+        /* the events fetched may still refer to it */
+        fde->dead = 1;
+        list_add_tail(&fde->ln_dead, &fdmon->dead_fds);
+    }
+    else {
+        free(fde);
+    }
+}
+
+static void
+update_fd_events(struct pcintr_fdmon *fdmon, struct fdmon_fd *fde)
+{
+    uint32_t events = 0;
+    struct fdmon_watch *w;
+    list_for_each_entry(w, &fde->watches, ln) {
+        events |= w->events;
+    }
+
+    if (events != fde->events) {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = events;
+        ev.data.ptr = fde;
+        if (epoll_ctl(fdmon->epfd, EPOLL_CTL_MOD, fde->fd, &ev) == 0) {
+            fde->events = events;
+        }
+    }
+}
+
+static void
+dispatch_fd(struct pcintr_fdmon *fdmon, struct fdmon_fd *fde,
+        uint32_t revents)
+{
+    /* a callback may remove any watch of the fd, so always look for
+       the next one not dispatched from the head of the list. */
+    while (!fde->dead) {
+        struct fdmon_watch *w = NULL, *p;
+        list_for_each_entry(p, &fde->watches, ln) {
+            if (p->seq != fdmon->seq) {
+                w = p;
+                break;
+            }
+        }
+
+        if (w == NULL) {
+            break;
+        }
+
+        w->seq = fdmon->seq;
+        uint32_t events = revents & (w->events | EPOLLERR | EPOLLHUP);
+        if (events) {
+            w->callback(fde->fd, to_runloop_io_event(events), w->ctxt);
+        }
+    }
+}
+
+static void
+dispatch_events(struct pcintr_fdmon *fdmon)
+{
+    struct epoll_event events[FDMON_MAX_EVENTS];
+
+    int n = epoll_wait(fdmon->epfd, events, FDMON_MAX_EVENTS, 0);
+    if (n <= 0) {
+        return;
+    }
+
+    fdmon->stat.nr_dispatches++;
+    fdmon->stat.nr_events += n;
+    if ((size_t)n > fdmon->stat.max_batch) {
+        fdmon->stat.max_batch = n;
+    }
+
+    fdmon->dispatching++;
+    for (int i = 0; i < n; i++) {
+        fdmon->seq++;
+        dispatch_fd(fdmon, (struct fdmon_fd *)events[i].data.ptr,
+                events[i].events);
+    }
+    fdmon->dispatching--;
+
+    if (fdmon->dispatching == 0) {
+        while (!list_empty(&fdmon->dead_fds)) {
+            struct fdmon_fd *fde = list_first_entry(&fdmon->dead_fds,
+                    struct fdmon_fd, ln_dead);
+            list_del(&fde->ln_dead);
+            free(fde);
+        }
+    }
+}
+
+struct pcintr_fdmon *
+pcintr_fdmon_create(purc_runloop_t runloop)
+{
+    struct pcintr_fdmon *fdmon;
+    fdmon = (struct pcintr_fdmon *)calloc(1, sizeof(*fdmon));
+    if (fdmon == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto failed;
+    }
+
+    fdmon->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (fdmon->epfd < 0) {
+        purc_set_error(purc_error_from_errno(errno));
+        goto failed_free;
+    }
+
+    fdmon->fds = pcutils_sorted_array_create(SAFLAG_DEFAULT, 0, NULL, NULL);
+    if (fdmon->fds == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto failed_close;
+    }
+
+    list_head_init(&fdmon->dead_fds);
+    fdmon->loop = (RunLoop *)runloop;
+    fdmon->epfd_monitor = fdmon->loop->addFdMonitor(fdmon->epfd, G_IO_IN,
+            [fdmon] (gint fd, GIOCondition condition) -> gboolean {
+            UNUSED_PARAM(fd);
+            UNUSED_PARAM(condition);
+            dispatch_events(fdmon);
+            return true;
+        });
+
+    return fdmon;
+
+failed_close:
+    close(fdmon->epfd);
+failed_free:
+    free(fdmon);
+failed:
+    return NULL;
+}
+
+void
+pcintr_fdmon_destroy(struct pcintr_fdmon *fdmon)
+{
+    PC_ASSERT(fdmon->dispatching == 0);
+
+    fdmon->loop->removeFdMonitor(fdmon->epfd_monitor);
+
+    size_t n = pcutils_sorted_array_count(fdmon->fds);
+    for (size_t i = 0; i < n; i++) {
+        struct fdmon_fd *fde;
+        pcutils_sorted_array_get(fdmon->fds, i, (void **)&fde);
+        while (!list_empty(&fde->watches)) {
+            struct fdmon_watch *w = list_first_entry(&fde->watches,
+                    struct fdmon_watch, ln);
+            list_del(&w->ln);
+            free(w);
+        }
+        free(fde);
+    }
+
+    pcutils_sorted_array_destroy(fdmon->fds);
+    close(fdmon->epfd);
+    free(fdmon);
+}
+
+uintptr_t
+pcintr_fdmon_add(struct pcintr_fdmon *fdmon, int fd,
+        purc_runloop_io_event event, purc_runloop_io_callback callback,
+        void *ctxt)
+{
+    struct fdmon_watch *w;
+    w = (struct fdmon_watch *)calloc(1, sizeof(*w));
+    if (w == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto failed;
+    }
+
+    w->events = to_epoll_events(event);
+    w->seq = fdmon->seq;    /* not to be dispatched in the current batch */
+    w->callback = callback;
+    w->ctxt = ctxt;
+
+    struct fdmon_fd *fde;
+    if (!pcutils_sorted_array_find(fdmon->fds, (void *)(uintptr_t)fd,
+                (void **)&fde)) {
+        fde = (struct fdmon_fd *)calloc(1, sizeof(*fde));
+        if (fde == NULL) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            goto failed_free;
+        }
+
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = w->events;
+        ev.data.ptr = fde;
+        if (epoll_ctl(fdmon->epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            purc_set_error(purc_error_from_errno(errno));
+            free(fde);
+            goto failed_free;
+        }
+
+        if (pcutils_sorted_array_add(fdmon->fds, (void *)(uintptr_t)fd,
+                    fde)) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            epoll_ctl(fdmon->epfd, EPOLL_CTL_DEL, fd, NULL);
+            free(fde);
+            goto failed_free;
+        }
+
+        list_head_init(&fde->watches);
+        fde->fd = fd;
+        fde->events = w->events;
+        fdmon->stat.nr_fds++;
+    }
+
+    w->fde = fde;
+    list_add_tail(&w->ln, &fde->watches);
+    update_fd_events(fdmon, fde);
+    fdmon->stat.nr_watches++;
+
+    return (uintptr_t)w | PCINTR_FDMON_HANDLE_TAG;
+
+failed_free:
+    free(w);
+failed:
+    return 0;
+}
+
+bool
+pcintr_fdmon_remove(struct pcintr_fdmon *fdmon, uintptr_t handle)
+{
+    if ((handle & PCINTR_FDMON_HANDLE_TAG) == 0) {
+        return false;
+    }
+
+    struct fdmon_watch *w;
+    w = (struct fdmon_watch *)(handle & ~PCINTR_FDMON_HANDLE_TAG);
+
+    struct fdmon_fd *fde = w->fde;
+    list_del(&w->ln);
+    free(w);
+    fdmon->stat.nr_watches--;
+
+    if (list_empty(&fde->watches)) {
+        release_fd(fdmon, fde);
+    }
+    else {
+        update_fd_events(fdmon, fde);
+    }
+
+    return true;
+}
+
+void
+pcintr_fdmon_get_stat(struct pcintr_fdmon *fdmon,
+        struct pcintr_fdmon_stat *stat)
+{
+    *stat = fdmon->stat;
+}
+
+#else   /* OS(LINUX) */
+
+struct pcintr_fdmon *
+pcintr_fdmon_create(purc_runloop_t runloop)
+{
+    UNUSED_PARAM(runloop);
+    purc_set_error(PURC_ERROR_NOT_SUPPORTED);
+    return NULL;
+}
+
+void
+pcintr_fdmon_destroy(struct pcintr_fdmon *fdmon)
+{
+    UNUSED_PARAM(fdmon);
+}
+
+uintptr_t
+pcintr_fdmon_add(struct pcintr_fdmon *fdmon, int fd,
+        purc_runloop_io_event event, purc_runloop_io_callback callback,
+        void *ctxt)
+{
+    UNUSED_PARAM(fdmon);
+    UNUSED_PARAM(fd);
+    UNUSED_PARAM(event);
+    UNUSED_PARAM(callback);
+    UNUSED_PARAM(ctxt);
+    purc_set_error(PURC_ERROR_NOT_SUPPORTED);
+    return 0;
+}
+
+bool
+pcintr_fdmon_remove(struct pcintr_fdmon *fdmon, uintptr_t handle)
+{
+    UNUSED_PARAM(fdmon);
+    UNUSED_PARAM(handle);
+    return false;
+}
+
+void
+pcintr_fdmon_get_stat(struct pcintr_fdmon *fdmon,
+        struct pcintr_fdmon_stat *stat)
+{
+    UNUSED_PARAM(fdmon);
+    memset(stat, 0, sizeof(*stat));
+}
+
+#endif  /* !OS(LINUX) */
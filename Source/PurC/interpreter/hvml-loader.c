@@ -23,6 +23,7 @@
  */
 
 #include "purc.h"
+#include "internal.h"
 
 #include "private/hvml.h"
 #include "private/map.h"
@@ -32,6 +33,127 @@
 
 #include <time.h>
 
+/* the maximal number of resources prefetched for a vDOM */
+#define MAX_PREFETCHED_RESOURCES    16
+/* the timeout of a prefetching request in seconds */
+#define PREFETCH_TIMEOUT            10
+
+struct prefetch_ctxt {
+    size_t  nr_urls;
+    char   *urls[MAX_PREFETCHED_RESOURCES];
+};
+
+static void
+on_prefetch_done(purc_variant_t request_id, void *ctxt,
+        const struct pcfetcher_resp_header *resp_header,
+        purc_rwstream_t resp)
+{
+    UNUSED_PARAM(ctxt);
+    UNUSED_PARAM(resp_header);
+
+    /* the response has been kept by the cache of the fetcher if cacheable */
+    if (resp)
+        purc_rwstream_destroy(resp);
+    purc_variant_unref(request_id);
+}
+
+/*
+ * Only the absolute HTTP(S) URLs are prefetched: a relative one is resolved
+ * against the base URL of the coroutine, which is not known until the vDOM
+ * is scheduled; and the local files are not cached by the fetcher.
+ */
+static bool
+is_prefetchable(const char *url, size_t len)
+{
+    if (len > 7 && strncasecmp(url, "http://", 7) == 0)
+        return true;
+    if (len > 8 && strncasecmp(url, "https://", 8) == 0)
+        return true;
+    return false;
+}
+
+static int
+prefetch_element(struct pcvdom_element *top, struct pcvdom_element *elem,
+        void *ctxt)
+{
+    UNUSED_PARAM(top);
+    struct prefetch_ctxt *prefetch = ctxt;
+    const char *key;
+
+    switch (elem->tag_id) {
+    case PCHVML_TAG_INIT:
+    case PCHVML_TAG_UPDATE:
+        key = "from";
+        break;
+    case PCHVML_TAG_ARCHETYPE:
+        key = "src";
+        break;
+    default:
+        return 0;
+    }
+
+    /* the request depends on the parameters or the method given */
+    if (pcvdom_element_find_attr(elem, "with") ||
+            pcvdom_element_find_attr(elem, "via") ||
+            pcvdom_element_find_attr(elem, "param") ||
+            pcvdom_element_find_attr(elem, "method"))
+        return 0;
+
+    struct pcvdom_attr *attr = pcvdom_element_find_attr(elem, key);
+    if (attr == NULL)
+        return 0;
+
+    size_t len;
+    const char *url = pcvdom_attr_get_literal(attr, &len);
+    if (url == NULL || !is_prefetchable(url, len))
+        return 0;
+
+    for (size_t i = 0; i < prefetch->nr_urls; i++) {
+        if (strncmp(prefetch->urls[i], url, len) == 0 &&
+                prefetch->urls[i][len] == 0)
+            return 0;
+    }
+
+    char *dup = strndup(url, len);
+    if (dup == NULL)
+        return -1;
+
+    prefetch->urls[prefetch->nr_urls++] = dup;
+    return (prefetch->nr_urls < MAX_PREFETCHED_RESOURCES) ? 0 : -1;
+}
+
+/*
+ * Issues asynchronous GET requests for the resources which will be loaded
+ * by the vDOM with static URLs, so that the responses are likely in the
+ * cache of the fetcher when the elements are executed.
+ */
+static void
+prefetch_resources(struct pcvdom_document *doc)
+{
+    if (!pcfetcher_is_init())
+        return;
+
+    struct pcvdom_element *root = pcvdom_document_get_root(doc);
+    if (root == NULL)
+        return;
+
+    struct prefetch_ctxt prefetch = { 0, { NULL } };
+    pcvdom_element_traverse(root, &prefetch, prefetch_element);
+
+    for (size_t i = 0; i < prefetch.nr_urls; i++) {
+        purc_variant_t req_id = pcfetcher_request_async(prefetch.urls[i],
+                PCFETCHER_REQUEST_METHOD_GET, PURC_VARIANT_INVALID,
+                PREFETCH_TIMEOUT, on_prefetch_done, NULL);
+        if (req_id == PURC_VARIANT_INVALID) {
+            PC_DEBUG("Failed to prefetch %s\n", prefetch.urls[i]);
+        }
+        free(prefetch.urls[i]);
+    }
+
+    /* the failures of prefetching are not the errors of loading */
+    purc_clr_error();
+}
+
 purc_vdom_t
 purc_load_hvml_from_rwstream(purc_rwstream_t stm)
 {
@@ -40,7 +162,7 @@ purc_load_hvml_from_rwstream(purc_rwstream_t stm)
     struct pcvdom_document *doc = NULL;
     struct pchvml_token *token = NULL;
 
-    parser = pchvml_create(0, 0);
+    parser = pchvml_create(PCHVML_FLAG_VCM_ARENA, 0);
     if (!parser)
         goto error;
 
@@ -65,6 +187,8 @@ again:
     }
 
     doc = pcvdom_gen_end(gen);
+    if (doc)
+        prefetch_resources(doc);
     goto end;
 
 error:
@@ -87,6 +211,117 @@ end:
     return doc;
 }
 
+struct purc_hvml_loader {
+    struct pchvml_parser   *parser;
+    struct pcvdom_gen      *gen;
+    bool                    failed;
+};
+
+purc_hvml_loader_t
+purc_hvml_loader_new(void)
+{
+    struct purc_hvml_loader *loader = calloc(1, sizeof(*loader));
+    if (!loader) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    loader->parser = pchvml_create(PCHVML_FLAG_VCM_ARENA, 0);
+    if (!loader->parser)
+        goto error;
+
+    loader->gen = pcvdom_gen_create();
+    if (!loader->gen)
+        goto error;
+
+    pchvml_set_partial_input(loader->parser, true);
+    return loader;
+
+error:
+    if (loader->parser)
+        pchvml_destroy(loader->parser);
+    free(loader);
+    return NULL;
+}
+
+/* parses all tokens available in the stream */
+static int
+loader_parse(struct purc_hvml_loader *loader, purc_rwstream_t stm)
+{
+    struct pchvml_token *token;
+
+    while ((token = pchvml_next_token(loader->parser, stm))) {
+        int r = pcvdom_gen_push_token(loader->gen, loader->parser, token);
+        bool eof = pchvml_token_is_type(token, PCHVML_TOKEN_EOF);
+        pchvml_token_destroy(token);
+        if (r)
+            goto failed;
+        if (eof)
+            return 0;
+    }
+
+    if (pchvml_is_waiting_input(loader->parser))
+        return 0;
+
+failed:
+    loader->failed = true;
+    return -1;
+}
+
+int
+purc_hvml_loader_feed(purc_hvml_loader_t loader, const void *data, size_t sz)
+{
+    if (loader->failed)
+        return -1;
+
+    if (sz == 0)
+        return 0;
+
+    purc_rwstream_t stm = purc_rwstream_new_from_mem((void *)data, sz);
+    if (!stm) {
+        loader->failed = true;
+        return -1;
+    }
+
+    int r = loader_parse(loader, stm);
+    purc_rwstream_destroy(stm);
+    return r;
+}
+
+purc_vdom_t
+purc_hvml_loader_end(purc_hvml_loader_t loader)
+{
+    struct pcvdom_document *doc = NULL;
+
+    if (!loader->failed) {
+        /* parse the characters left with the end of the input */
+        char dummy = 0;
+        purc_rwstream_t stm = purc_rwstream_new_from_mem(&dummy, 0);
+        if (stm) {
+            pchvml_set_partial_input(loader->parser, false);
+            loader_parse(loader, stm);
+            purc_rwstream_destroy(stm);
+        }
+        else {
+            loader->failed = true;
+        }
+    }
+
+    doc = pcvdom_gen_end(loader->gen);
+    if (doc && loader->failed) {
+        pcvdom_document_unref(doc);
+        doc = NULL;
+    }
+
+    pcvdom_gen_destroy(loader->gen);
+    pchvml_destroy(loader->parser);
+    free(loader);
+
+    if (doc)
+        prefetch_resources(doc);
+    return doc;
+}
+
 /*
  * TODO:
  * When total_orig_size reaches a number (say 64KB), we can shrink the cached
@@ -261,7 +496,12 @@ purc_load_hvml_from_file(const char* file)
     vdom = find_vdom_in_cache(md5);
     if (vdom == NULL) {
         purc_rwstream_t in;
-        in = purc_rwstream_new_from_file(file, "r");
+        in = purc_rwstream_new_from_mmap(file);
+        if (!in) {
+            /* not a regular file, e.g., a named pipe */
+            purc_clr_error();
+            in = purc_rwstream_new_from_file(file, "r");
+        }
         if (!in) {
             goto failed;
         }
@@ -294,6 +534,11 @@ purc_load_hvml_from_url(const char* url)
     pcutils_md5digest(url, md5);
 
     vdom = find_vdom_in_cache(md5);
+    if (vdom == NULL && (vdom = pcfetcher_bundle_load_vdom(url, &length))) {
+        /* a mounted bundle does not change */
+        cache_vdom(md5, 0, length, vdom);
+    }
+
     if (vdom == NULL) {
         struct pcfetcher_resp_header resp_header = {0};
         purc_rwstream_t resp = pcfetcher_request_sync(
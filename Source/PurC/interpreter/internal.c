@@ -113,7 +113,7 @@ match_id(pcintr_stack_t stack, struct pcvdom_element *elem, const char *id)
     }
 
     bool silently = false;
-    purc_variant_t v = pcvcm_eval(attr->val, stack, silently);
+    purc_variant_t v = pcvcm_eval(pcvdom_attr_get_vcm(attr), stack, silently);
     purc_clr_error();
     if (v == PURC_VARIANT_INVALID) {
         return false;
@@ -51,6 +51,13 @@
 struct pcvdom_template {
     struct pcvcm_node            *vcm;
     bool                          to_free;
+
+    /* the literal parts of the markup with the marks of the holes between,
+       NULL if the nodes can not be placed by the steps of the skeleton */
+    bool                          skeleton_made;
+    char                         *skeleton;
+    size_t                        len_skeleton;
+    size_t                        nr_holes;
 };
 
 struct pcintr_observer_task {
@@ -78,7 +85,9 @@ struct pcintr_event_handler {
     int                           cor_stage;
     int                           cor_state;
     unsigned int                  support_null_event:1; /* support null event */
-    char                         *name;
+    unsigned int                  builtin:1;  /* allocated with coroutine */
+    purc_atom_t                   event_type; /* 0 for any event type */
+    const char                   *name;       /* static string */
     void                         *data;
     event_handle_fn               handle;
     event_match_fn                is_match;
@@ -94,6 +103,67 @@ pcintr_destroy_observer_list(struct list_head *observer_list);
 struct list_head *
 pcintr_get_observer_list(pcintr_stack_t stack, purc_variant_t observed);
 
+/* returns the list of the observers (linked by `type_node`) in the list
+   for @observed and for the messages of @type_atom, or NULL if none */
+struct list_head *
+pcintr_get_observer_bucket(pcintr_stack_t stack, purc_variant_t observed,
+        purc_atom_t type_atom);
+
+void
+pcintr_destroy_observer_index(pcintr_stack_t stack);
+
+/*
+ * A reactive binding keeps the text content of an element having the
+ * identifier @elem_id live: the variables read by the contents evaluated
+ * by pcintr_reactive_eval() are recorded, and the contents are evaluated
+ * again, with the same variables, when one of the containers changes. The
+ * elements are refreshed once for all changes in a step of the run loop,
+ * and the binding is dropped when the element is gone.
+ */
+struct pcintr_binding;
+
+struct pcintr_binding *
+pcintr_reactive_bind(pcintr_stack_t stack, const char *elem_id,
+        bool silently);
+
+purc_variant_t
+pcintr_reactive_eval(pcintr_stack_t stack, struct pcintr_binding *binding,
+        struct pcvcm_node *vcm);
+
+void
+pcintr_reactive_cleanup(pcintr_stack_t stack);
+
+/*
+ * The result of a `choose` element run `incrementally` on an array is kept
+ * as derived state of the element: whether every member is chosen, and a
+ * listener on the array keeps the state in line with the members grown,
+ * shrunk, or changed; so running the element again only checks the members
+ * changed since the last run. Returns 1 if the result can not be derived
+ * so (@on is not an array, or the executor of @rule does not choose the
+ * members on their own), then the caller chooses as usual; 0 with the
+ * result in @chosen, or -1 on failure.
+ */
+int
+pcintr_derived_choose(pcintr_stack_t stack, pcvdom_element_t element,
+        purc_variant_t on, const char *rule, purc_variant_t *chosen);
+
+void
+pcintr_derived_cleanup(pcintr_stack_t stack);
+
+/*
+ * The variables restored from a snapshot by purc_coroutine_restore() are
+ * kept for the `init` elements: an `init` element takes the value of its
+ * variable in the scopes of the ancestors or the coroutine level instead
+ * of evaluating the value again; a value is only taken once. Returns the
+ * value (to unref), or PURC_VARIANT_INVALID if @name was not restored.
+ */
+purc_variant_t
+pcintr_restored_take(pcintr_stack_t stack, pcvdom_element_t element,
+        const char *name);
+
+void
+pcintr_restored_cleanup(pcintr_stack_t stack);
+
 bool
 pcintr_is_observer_match(struct pcintr_observer *observer,
         purc_variant_t observed, purc_atom_t type_atom, const char *sub_type);
@@ -176,6 +246,14 @@ pcintr_load_from_uri_async(pcintr_stack_t stack, const char* uri,
         enum pcfetcher_request_method method, purc_variant_t params,
         pcfetcher_response_handler handler, void* ctxt);
 
+/* The same as pcintr_load_from_uri_async(), but the body is handed over to
+   @progress chunk by chunk; @handler gets a NULL stream at last. */
+purc_variant_t
+pcintr_load_from_uri_progressively(pcintr_stack_t stack, const char* uri,
+        enum pcfetcher_request_method method, purc_variant_t params,
+        pcfetcher_response_handler handler,
+        pcfetcher_progress_handler progress, void* ctxt);
+
 bool
 pcintr_save_async_request_id(pcintr_stack_t stack, purc_variant_t req_id);
 
@@ -333,6 +411,18 @@ pcintr_rdr_send_dom_req_simple_raw(pcintr_stack_t stack, pcdoc_operation op,
         pcdoc_element_t element, const char *property,
         pcrdr_msg_data_type data_type, const char *data, size_t len);
 
+/* sends the DOM operations buffered by the coroutine */
+void
+pcintr_rdr_flush_dom_ops(pcintr_coroutine_t co);
+
+/* sends the buffered DOM operations as far as the in-flight credits allow;
+   returns whether no operation is left */
+bool
+pcintr_rdr_try_flush_dom_ops(pcintr_coroutine_t co);
+
+/* discards the DOM operations buffered by the coroutine */
+void
+pcintr_rdr_drop_dom_ops(pcintr_coroutine_t co);
 
 #define pcintr_rdr_dom_append_content(stack, element, content)          \
     pcintr_rdr_send_dom_req_simple_raw(stack, PCDOC_OP_APPEND,          \
@@ -395,6 +485,20 @@ pcintr_bind_template(purc_variant_t templates,
 purc_variant_t
 pcintr_template_expansion(purc_variant_t val);
 
+/* expands the template like pcintr_template_expansion(), and returns the
+   values of the holes (an array of strings) in @holes if the nodes of the
+   template can be placed by pcintr_template_place() */
+purc_variant_t
+pcintr_template_expansion_ex(purc_variant_t val, bool silently,
+        purc_variant_t *holes);
+
+/* places the nodes of the template filled with the values of the holes
+   without parsing the expanded markup; returns 1 if the nodes can not be
+   placed in this way, 0 for success, and -1 for failure */
+int
+pcintr_template_place(pcintr_stack_t stack, purc_variant_t val,
+        purc_variant_t holes, pcdoc_element_t elem, pcdoc_operation op);
+
 pcintr_coroutine_t
 pcintr_coroutine_get_by_id(purc_atom_t id);
 
@@ -440,6 +544,11 @@ void pcintr_coroutine_set_state_with_location(pcintr_coroutine_t co,
 int
 pcintr_coroutine_clear_tasks(pcintr_coroutine_t co);
 
+void
+pcintr_event_handler_init(struct pcintr_event_handler *handler,
+        const char *name, int stage, int state, void *data, event_handle_fn fn,
+        event_match_fn is_match_fn, bool support_null_event);
+
 struct pcintr_event_handler *
 pcintr_event_handler_create(const char *name,
         int stage, int state, void *data, event_handle_fn fn,
@@ -462,14 +571,9 @@ pcintr_coroutine_remove_event_hander(struct pcintr_event_handler *handler);
 int
 pcintr_coroutine_clear_event_handlers(pcintr_coroutine_t co);
 
-void
-pcintr_coroutine_add_observer_event_handler(pcintr_coroutine_t co);
-
-void
-pcintr_coroutine_add_sub_exit_event_handler(pcintr_coroutine_t co);
-
-void
-pcintr_coroutine_add_last_msg_event_handler(pcintr_coroutine_t co);
+/* add the observer, subExit and lastMsg event handlers in one block */
+int
+pcintr_coroutine_add_builtin_event_handlers(pcintr_coroutine_t co);
 
 int
 pcintr_calc_and_set_caret_symbol(pcintr_stack_t stack,
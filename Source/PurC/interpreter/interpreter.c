@@ -32,11 +32,15 @@
 #include "internal.h"
 
 #include "private/debug.h"
+#include "private/dlmodule.h"
 #include "private/instance.h"
 #include "private/dvobjs.h"
 #include "private/fetcher.h"
 #include "private/regex.h"
 #include "private/stringbuilder.h"
+#include "private/printbuf.h"
+#include "private/metrics.h"
+#include "private/trace.h"
 #include "private/msg-queue.h"
 #include "private/runners.h"
 
@@ -56,9 +60,73 @@
 #define EVENT_SEPARATOR      ':'
 
 
+/* the maximal number of popped frames kept for reuse by a coroutine */
+#define MAX_FREE_FRAMES     DEF_EMBEDDED_LEVELS
+
+/* normal and pseudo frames share the same blocks */
+#define FRAME_BLOCK_SIZE    \
+    (sizeof(struct pcintr_stack_frame_normal) >                 \
+        sizeof(struct pcintr_stack_frame_pseudo) ?              \
+     sizeof(struct pcintr_stack_frame_normal) :                 \
+     sizeof(struct pcintr_stack_frame_pseudo))
+
 #define COROUTINE_PREFIX    "COROUTINE"
 #define HVML_VARIABLE_REGEX "^[A-Za-z_][A-Za-z0-9_]*$"
 
+static void *
+stack_frame_alloc(pcintr_stack_t stack)
+{
+    void *block;
+
+    if (stack->nr_free_frames > 0) {
+        struct pcintr_stack_frame_normal *frame_normal;
+        frame_normal = list_first_entry(&stack->free_frames,
+                struct pcintr_stack_frame_normal, frame.node);
+        list_del(&frame_normal->frame.node);
+        stack->nr_free_frames--;
+        stack->nr_frame_hits++;
+
+        block = frame_normal;
+        memset(block, 0, FRAME_BLOCK_SIZE);
+    }
+    else {
+        stack->nr_frame_misses++;
+        block = calloc(1, FRAME_BLOCK_SIZE);
+        if (block == NULL) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        }
+    }
+
+    return block;
+}
+
+/* frame is the frame in the block to free */
+static void
+stack_frame_free(void *block, struct pcintr_stack_frame *frame)
+{
+    pcintr_stack_t stack = frame->owner;
+    if (stack && stack->nr_free_frames < MAX_FREE_FRAMES) {
+        list_add(&frame->node, &stack->free_frames);
+        stack->nr_free_frames++;
+    }
+    else {
+        free(block);
+    }
+}
+
+static void
+stack_free_frames(pcintr_stack_t stack)
+{
+    while (!list_empty(&stack->free_frames)) {
+        struct pcintr_stack_frame_normal *frame_normal;
+        frame_normal = list_first_entry(&stack->free_frames,
+                struct pcintr_stack_frame_normal, frame.node);
+        list_del(&frame_normal->frame.node);
+        free(frame_normal);
+    }
+    stack->nr_free_frames = 0;
+}
+
 static void
 stack_frame_release(struct pcintr_stack_frame *frame)
 {
@@ -102,7 +170,7 @@ stack_frame_pseudo_destroy(struct pcintr_stack_frame_pseudo *frame_pseudo)
         return;
 
     stack_frame_pseudo_release(frame_pseudo);
-    free(frame_pseudo);
+    stack_frame_free(frame_pseudo, &frame_pseudo->frame);
 }
 
 static void
@@ -121,7 +189,7 @@ stack_frame_normal_destroy(struct pcintr_stack_frame_normal *frame_normal)
         return;
 
     stack_frame_normal_release(frame_normal);
-    free(frame_normal);
+    stack_frame_free(frame_normal, &frame_normal->frame);
 }
 
 static int
@@ -320,9 +388,17 @@ stack_release(pcintr_stack_t stack)
 
     release_scoped_variables(stack);
 
+    stack_free_frames(stack);
+
     pcintr_destroy_observer_list(&stack->common_observers);
     pcintr_destroy_observer_list(&stack->dynamic_observers);
     pcintr_destroy_observer_list(&stack->native_observers);
+    pcintr_destroy_observer_index(stack);
+    PC_ASSERT(pcutils_ptrmap_size(&stack->change_watches) == 0);
+    pcutils_ptrmap_clear(&stack->change_watches);
+    pcintr_reactive_cleanup(stack);
+    pcintr_derived_cleanup(stack);
+    pcintr_restored_cleanup(stack);
 
     if (stack->doc) {
         purc_document_unref(stack->doc);
@@ -362,6 +438,10 @@ coroutine_release(pcintr_coroutine_t co)
         struct pcintr_heap *heap = pcintr_get_heap();
         PC_ASSERT(heap && co->owner == heap);
 
+        /* the variants released from now on are not charged to it */
+        pcvariant_drop_charge(&co->mem_charge);
+
+        pcintr_rdr_drop_dom_ops(co);
         stack_release(&co->stack);
         pcvdom_document_unref(co->vdom);
 
@@ -383,12 +463,19 @@ coroutine_release(pcintr_coroutine_t co)
         if (co->mq) {
             pcinst_msg_queue_destroy(co->mq);
         }
+        pcinst_metrics_count(pcinst_current(),
+                PCINST_METRIC_COROUTINES_EXITED, 1);
 
         pcintr_coroutine_clear_tasks(co);
         pcintr_coroutine_clear_event_handlers(co);
+        free(co->builtin_handlers);
+        co->builtin_handlers = NULL;
         if (co->sleep_handler) {
             pcintr_event_handler_destroy(co->sleep_handler);
         }
+        if (co->sleep_timer) {
+            pcintr_timer_destroy(co->sleep_timer);
+        }
 
         if (co->variables) {
             pcvarmgr_destroy(co->variables);
@@ -457,6 +544,7 @@ static void
 coroutine_destroy(pcintr_coroutine_t co)
 {
     if (co) {
+        list_del(&co->ln_sched);
         coroutine_release(co);
         free(co);
     }
@@ -466,9 +554,12 @@ static void
 stack_init(pcintr_stack_t stack)
 {
     INIT_LIST_HEAD(&stack->frames);
+    INIT_LIST_HEAD(&stack->free_frames);
     INIT_LIST_HEAD(&stack->common_observers);
     INIT_LIST_HEAD(&stack->dynamic_observers);
     INIT_LIST_HEAD(&stack->native_observers);
+    pcutils_ptrmap_init(&stack->observer_index);
+    pcutils_ptrmap_init(&stack->change_watches);
     stack->scoped_variables = RB_ROOT;
 
     stack->mode = STACK_VDOM_BEFORE_HVML;
@@ -480,6 +571,8 @@ static void _cleanup_instance(struct pcinst* inst)
     if (!heap)
         return;
 
+    pcrun_detach_runner_pool(inst);
+
     struct rb_root *coroutines = &heap->coroutines;
 
     struct rb_node *p, *n;
@@ -503,6 +596,22 @@ static void _cleanup_instance(struct pcinst* inst)
         heap->event_timer = NULL;
     }
 
+    if (heap->rdr_fd_monitor) {
+        purc_runloop_remove_fd_monitor(inst->running_loop,
+                heap->rdr_fd_monitor);
+        heap->rdr_fd_monitor = 0;
+    }
+
+    if (heap->fdmon) {
+        pcintr_fdmon_destroy(heap->fdmon);
+        heap->fdmon = NULL;
+    }
+
+    if (heap->profiler) {
+        pcintr_profiler_destroy(heap->profiler, inst->runner_name);
+        heap->profiler = NULL;
+    }
+
     free(heap);
     inst->intr_heap = NULL;
 }
@@ -511,10 +620,20 @@ static void _cleanup_instance(struct pcinst* inst)
 static void
 event_timer_fire(pcintr_timer_t timer, const char* id, void* data);
 
+static size_t
+get_mem_limit(size_t limit, const char *env_name)
+{
+    if (limit == 0) {
+        const char *env_value = getenv(env_name);
+        if (env_value)
+            limit = (size_t)strtoull(env_value, NULL, 10);
+    }
+    return limit;
+}
+
 static int _init_instance(struct pcinst* inst,
         const purc_instance_extra_info* extra_info)
 {
-    UNUSED_PARAM(extra_info);
     inst->intr_heap = NULL;
 
     struct pcintr_heap *heap = inst->intr_heap;
@@ -524,6 +643,8 @@ static int _init_instance(struct pcinst* inst,
     if (!heap)
         return PURC_ERROR_OUT_OF_MEMORY;
 
+    /* the move buffer wakes up the running loop when a message arrives */
+    inst->running_loop = purc_runloop_get_current();
     heap->move_buff = purc_inst_create_move_buffer(
             PCINST_MOVE_BUFFER_BROADCAST, PCINTR_MOVE_BUFFER_SIZE);
     if (!heap->move_buff) {
@@ -536,11 +657,28 @@ static int _init_instance(struct pcinst* inst,
         return purc_get_last_error();
     }
 
-    inst->running_loop = purc_runloop_get_current();
     inst->intr_heap = heap;
     heap->owner     = inst;
+    heap->idle_period = PCINTR_DEF_IDLE_PERIOD;
+
+    if (extra_info && extra_info->fd_monitor == PCRUNLOOP_FDMON_EPOLL) {
+        /* fall back to GLib if epoll is not available */
+        heap->fdmon = pcintr_fdmon_create(inst->running_loop);
+        purc_clr_error();
+    }
+
+    heap->profiler = pcintr_profiler_create(extra_info);
+
+    heap->crtn_mem_soft_limit = get_mem_limit(
+            extra_info ? extra_info->crtn_mem_soft_limit : 0,
+            PURC_ENVV_CRTN_MEM_SOFT_LIMIT);
+    heap->crtn_mem_hard_limit = get_mem_limit(
+            extra_info ? extra_info->crtn_mem_hard_limit : 0,
+            PURC_ENVV_CRTN_MEM_HARD_LIMIT);
 
     heap->coroutines = RB_ROOT;
+    INIT_LIST_HEAD(&heap->ready_coroutines);
+    INIT_LIST_HEAD(&heap->waiting_coroutines);
     heap->running_coroutine = NULL;
     heap->next_coroutine_id = 1;
 
@@ -568,6 +706,7 @@ static int _init_once(void)
 }
 
 struct pcmodule _module_interpreter = {
+    .name            = "interpreter",
     .id              = PURC_HAVE_HVML,
     .module_inited   = 0,
 
@@ -590,6 +729,16 @@ pcintr_get_coroutine(void)
     return heap ? heap->running_coroutine : NULL;
 }
 
+size_t
+pcintr_coroutine_mem_usage(pcintr_coroutine_t co)
+{
+    size_t usage = co->mem_charge.sz_mem > 0 ?
+        (size_t)co->mem_charge.sz_mem : 0;
+    if (co->stack.doc)
+        usage += co->stack.doc->sz_added;
+    return usage;
+}
+
 purc_runloop_t
 pcintr_get_runloop(void)
 {
@@ -626,6 +775,7 @@ coroutine_set_current_with_location(struct pcintr_coroutine *co,
     }
 
     heap->running_coroutine = co;
+    pcvariant_set_charge(co ? &co->mem_charge : NULL);
 }
 
 #define coroutine_set_current(co) \
@@ -828,9 +978,8 @@ init_symvals_with_vals(struct pcintr_stack_frame *frame)
     if (init_at_symval(frame))
         return -1;
 
-    // $0!
-    if (init_exclamation_symval(frame))
-        return -1;
+    // $0! is made when it is used first; see pcintr_get_symbol_var()
+    PURC_VARIANT_SAFE_CLEAR(frame->symbol_vars[PURC_SYMBOL_VAR_EXCLAMATION]);
 
     return 0;
 }
@@ -839,6 +988,7 @@ static int
 init_stack_frame(pcintr_stack_t stack, struct pcintr_stack_frame* frame)
 {
     frame->owner           = stack;
+    frame->serial          = ++stack->last_frame_serial;
     frame->silently        = 0;
 
     frame->except_templates = purc_variant_make_object_0();
@@ -874,10 +1024,8 @@ static struct pcintr_stack_frame_pseudo*
 stack_frame_pseudo_create(pcintr_stack_t stack)
 {
     struct pcintr_stack_frame_pseudo *frame_pseudo;
-    frame_pseudo = (struct pcintr_stack_frame_pseudo*)calloc(1,
-            sizeof(*frame_pseudo));
+    frame_pseudo = (struct pcintr_stack_frame_pseudo*)stack_frame_alloc(stack);
     if (!frame_pseudo) {
-        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
         return NULL;
     }
 
@@ -974,10 +1122,8 @@ static struct pcintr_stack_frame_normal*
 stack_frame_normal_create(pcintr_stack_t stack)
 {
     struct pcintr_stack_frame_normal *frame_normal;
-    frame_normal = (struct pcintr_stack_frame_normal*)calloc(1,
-            sizeof(*frame_normal));
+    frame_normal = (struct pcintr_stack_frame_normal*)stack_frame_alloc(stack);
     if (!frame_normal) {
-        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
         return NULL;
     }
 
@@ -1034,12 +1180,17 @@ eval_vdom_attr(pcintr_stack_t stack, struct pcvdom_attr *attr)
 {
     PC_ASSERT(attr);
     PC_ASSERT(attr->key);
-    if (!attr->val)
+    if (!attr->val && !attr->packed_val)
         return purc_variant_make_undefined();
 
+    /* the VCM tree of a lazy attribute is compiled the first time here */
+    struct pcvcm_node *vcm = pcvdom_attr_get_vcm(attr);
+    if (!vcm)
+        return PURC_VARIANT_INVALID;
+
     struct pcintr_stack_frame *frame;
     frame = pcintr_stack_get_bottom_frame(stack);
-    return pcvcm_eval(attr->val, stack, frame->silently ? true : false);
+    return pcvcm_eval(vcm, stack, frame->silently ? true : false);
 }
 
 int
@@ -1079,43 +1230,11 @@ pcintr_eval_vdom_attr(pcintr_stack_t stack, struct pcvdom_attr *attr)
     return eval_vdom_attr(stack, attr);
 }
 
-struct pcintr_walk_attrs_ud {
-    struct pcintr_stack_frame       *frame;
-    struct pcvdom_element           *element;
-    void                            *ud;
-    pcintr_attr_f                    cb;
-};
-
-static int
-walk_attr(void *key, void *val, void *ud)
-{
-    PC_ASSERT(key);
-    PC_ASSERT(val);
-    PC_ASSERT(ud);
-
-    struct pcintr_walk_attrs_ud *data = (struct pcintr_walk_attrs_ud*)ud;
-
-    struct pcintr_stack_frame *frame = data->frame;
-    PC_ASSERT(frame);
-
-    struct pcvdom_attr *attr = (struct pcvdom_attr*)val;
-    PC_ASSERT(attr->key);
-    PC_ASSERT(attr->key == key);
-
-    struct pcvdom_element *element = data->element;
-    PC_ASSERT(element);
-
-    purc_atom_t atom = PCHVML_KEYWORD_ATOM(HVML, attr->key);
-    // NOTE: we only dispatch those keyworded-attr to caller
-    return data->cb(frame, element, atom, attr, data->ud);
-}
-
 int
 pcintr_vdom_walk_attrs(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element, void *ud, pcintr_attr_f cb)
 {
-    struct pcutils_map *attrs = element->attrs;
-    if (!attrs)
+    if (element->nr_attrs == 0)
         return 0;
 
     PC_ASSERT(frame->pos == element);
@@ -1127,16 +1246,21 @@ pcintr_vdom_walk_attrs(struct pcintr_stack_frame *frame,
             return -1;
     }
 
-    struct pcintr_walk_attrs_ud data = {
-        .frame        = frame,
-        .element      = element,
-        .ud           = ud,
-        .cb           = cb,
-    };
+    for (size_t i = 0; i < element->nr_attrs; i++) {
+        struct pcvdom_attr *attr = element->attrs[i];
+        PC_ASSERT(attr->key);
 
-    int r = pcutils_map_traverse(attrs, &data, walk_attr);
-    if (r)
-        return r;
+        /* the atom is resolved when the attribute was created; it is 0
+           if the keywords were not initialized then */
+        purc_atom_t atom = attr->atom;
+        if (atom == 0)
+            atom = PCHVML_KEYWORD_ATOM(HVML, attr->key);
+
+        // NOTE: we only dispatch those keyworded-attr to caller
+        int r = cb(frame, element, atom, attr, ud);
+        if (r)
+            return r;
+    }
 
     return 0;
 }
@@ -1252,6 +1376,10 @@ static void
 after_pushed(pcintr_coroutine_t co, struct pcintr_stack_frame *frame)
 {
     //pcintr_coroutine_dump(co);
+    // the frame of the document has no element
+    pctimeline_begin(PC_TIMELINE_ELEMENT,
+            frame->pos ? frame->pos->tag_name : NULL, NULL,
+            frame->pos ? frame->pos->line : 0);
     if (frame->ops.after_pushed) {
         void *ctxt = frame->ops.after_pushed(&co->stack, frame->pos);
         if (co->state == CO_STATE_STOPPED) {
@@ -1299,12 +1427,9 @@ on_popping(pcintr_coroutine_t co, struct pcintr_stack_frame *frame)
 
         pcdoc_element_t target;
         target = frame->edom_element;
-        size_t len;
-        const char *s = purc_variant_get_string_const_ex(content, &len);
-
         pcdoc_text_node_t txt;
-        txt = pcdoc_element_new_text_content(stack->doc, target,
-                PCDOC_OP_APPEND, s, len);
+        txt = pcdoc_element_new_text_content_ex(stack->doc, target,
+                PCDOC_OP_APPEND, content, PCDOC_TEXT_CONTENT_F_SHARED);
         PURC_VARIANT_SAFE_CLEAR(content);
 
         if (txt == NULL) {
@@ -1320,6 +1445,8 @@ on_popping(pcintr_coroutine_t co, struct pcintr_stack_frame *frame)
 
     if (ok) {
         pcintr_stack_t stack = &co->stack;
+        pctimeline_end(PC_TIMELINE_ELEMENT,
+                frame->pos ? frame->pos->tag_name : NULL);
         pop_stack_frame(stack);
     } else {
         frame->next_step = NEXT_STEP_RERUN;
@@ -1456,6 +1583,7 @@ pcintr_stack_frame_get_parent(struct pcintr_stack_frame *frame)
 #define BUILTIN_VAR_T           PURC_PREDEF_VARNAME_T
 #define BUILTIN_VAR_DOC         PURC_PREDEF_VARNAME_DOC
 #define BUILTIN_VAR_REQ         PURC_PREDEF_VARNAME_REQ
+#define BUILTIN_VAR_TIMERS      PURC_PREDEF_VARNAME_TIMERS
 
 static bool
 bind_cor_named_variable(purc_coroutine_t cor, const char* name,
@@ -1477,9 +1605,7 @@ bind_cor_named_variable(purc_coroutine_t cor, const char* name,
 static bool
 bind_builtin_coroutine_variables(purc_coroutine_t cor, purc_variant_t request)
 {
-    // $TIMERS
-    cor->timers = pcintr_timers_init(cor);
-    if (!cor->timers) {
+    if (!pcdvobjs_coroutine_init_attrs(cor)) {
         return false;
     }
 
@@ -1490,19 +1616,39 @@ bind_builtin_coroutine_variables(purc_coroutine_t cor, purc_variant_t request)
         return false;
     }
 
-    // $CRTN
-    if(!bind_cor_named_variable(cor, BUILTIN_VAR_CRTN,
-                purc_dvobj_coroutine_new(cor))) {
-        return false;
+    /* $CRTN, $T, and $TIMERS will be bound on the first lookup;
+       most of the coroutines created by `call` or `concurrently call`
+       never touch them. */
+    cor->lazy_vars = PCINTR_LAZY_VAR_CRTN | PCINTR_LAZY_VAR_T |
+        PCINTR_LAZY_VAR_TIMERS;
+    return true;
+}
+
+bool
+pcintr_bind_lazy_variable(purc_coroutine_t cor, const char *name)
+{
+    if (cor->lazy_vars & PCINTR_LAZY_VAR_CRTN &&
+            strcmp(name, BUILTIN_VAR_CRTN) == 0) {
+        cor->lazy_vars &= ~PCINTR_LAZY_VAR_CRTN;
+        return bind_cor_named_variable(cor, BUILTIN_VAR_CRTN,
+                purc_dvobj_coroutine_new(cor));
     }
 
-    // $T
-    if(!bind_cor_named_variable(cor, BUILTIN_VAR_T,
-                purc_dvobj_text_new())) {
-        return false;
+    if (cor->lazy_vars & PCINTR_LAZY_VAR_T &&
+            strcmp(name, BUILTIN_VAR_T) == 0) {
+        cor->lazy_vars &= ~PCINTR_LAZY_VAR_T;
+        return bind_cor_named_variable(cor, BUILTIN_VAR_T,
+                purc_dvobj_text_new());
     }
 
-    return true;
+    if (cor->lazy_vars & PCINTR_LAZY_VAR_TIMERS &&
+            strcmp(name, BUILTIN_VAR_TIMERS) == 0) {
+        cor->lazy_vars &= ~PCINTR_LAZY_VAR_TIMERS;
+        cor->timers = pcintr_timers_init(cor);
+        return cor->timers != NULL;
+    }
+
+    return false;
 }
 
 int
@@ -1820,7 +1966,8 @@ coroutine_create(purc_vdom_t vdom, pcintr_coroutine_t parent,
 
     pcvdom_document_ref(vdom);
     co->vdom = vdom;
-    pcintr_coroutine_set_state(co, CO_STATE_READY);
+    INIT_LIST_HEAD(&co->ln_sched);
+    INIT_LIST_HEAD(&co->dom_ops);
     INIT_LIST_HEAD(&co->children);
     INIT_LIST_HEAD(&co->registered_cancels);
     INIT_LIST_HEAD(&co->tasks);
@@ -1831,9 +1978,9 @@ coroutine_create(purc_vdom_t vdom, pcintr_coroutine_t parent,
         goto fail_co;
     }
 
-    pcintr_coroutine_add_sub_exit_event_handler(co);
-    pcintr_coroutine_add_last_msg_event_handler(co);
-    pcintr_coroutine_add_observer_event_handler(co);
+    if (pcintr_coroutine_add_builtin_event_handlers(co)) {
+        goto fail_handlers;
+    }
 
     co->variables = pcvarmgr_create();
     if (!co->variables) {
@@ -1845,11 +1992,14 @@ coroutine_create(purc_vdom_t vdom, pcintr_coroutine_t parent,
     co->owner = heap;
     co->user_data = user_data;
     co->loaded_vars = RB_ROOT;
+    co->mem_soft_limit = heap->crtn_mem_soft_limit;
+    co->mem_hard_limit = heap->crtn_mem_hard_limit;
 
     int r;
     r = pcutils_rbtree_insert_only(coroutines, &co->cid,
             cmp_by_atom, &co->node);
     PC_ASSERT(r == 0);
+    pcintr_coroutine_set_state(co, CO_STATE_READY);
 
     stack_init(stack);
 
@@ -1881,9 +2031,16 @@ coroutine_create(purc_vdom_t vdom, pcintr_coroutine_t parent,
                 (void *)(uintptr_t)co->cid);
     }
 
+    pcinst_metrics_count(pcinst_current(),
+            PCINST_METRIC_COROUTINES_CREATED, 1);
     return co;
 
 fail_variables:
+    list_del_init(&co->ln_sched);
+    INIT_LIST_HEAD(&co->event_handlers);
+    free(co->builtin_handlers);
+
+fail_handlers:
     pcinst_msg_queue_destroy(co->mq);
 
 fail_co:
@@ -2016,6 +2173,27 @@ purc_set_cond_handler(purc_cond_handler handler)
     return old;
 }
 
+unsigned int
+purc_set_idle_period(unsigned int period_ms)
+{
+    struct pcinst *inst = pcinst_current();
+    if (!inst) {
+        purc_set_error(PURC_ERROR_NO_INSTANCE);
+        return 0;
+    }
+
+    struct pcintr_heap *heap = inst->intr_heap;
+    if (!heap) {
+        purc_set_error(PURC_ERROR_NOT_SUPPORTED);
+        return 0;
+    }
+
+    unsigned int old = heap->idle_period;
+    heap->idle_period = period_ms ? period_ms : PCINTR_DEF_IDLE_PERIOD;
+    pcintr_wakeup_scheduler(inst);
+    return old;
+}
+
 int
 purc_run(purc_cond_handler handler)
 {
@@ -2122,6 +2300,48 @@ out:
     return false;
 }
 
+#define EVENT_TYPE_BUF_SIZE     64
+
+purc_atom_t
+pcintr_event_type_atom(const char *event, const char **sub_type)
+{
+    if (sub_type) {
+        *sub_type = NULL;
+    }
+
+    if (event == NULL) {
+        return 0;
+    }
+
+    const char *p = strchr(event, EVENT_SEPARATOR);
+    if (p == NULL) {
+        return purc_atom_try_string_ex(ATOM_BUCKET_MSG, event);
+    }
+
+    if (sub_type) {
+        *sub_type = p + 1;
+    }
+
+    purc_atom_t atom;
+    size_t len = p - event;
+    if (len < EVENT_TYPE_BUF_SIZE) {
+        char buf[EVENT_TYPE_BUF_SIZE];
+        memcpy(buf, event, len);
+        buf[len] = '\0';
+        atom = purc_atom_try_string_ex(ATOM_BUCKET_MSG, buf);
+    }
+    else {
+        char *buf = strndup(event, len);
+        if (buf == NULL) {
+            return 0;
+        }
+        atom = purc_atom_try_string_ex(ATOM_BUCKET_MSG, buf);
+        free(buf);
+    }
+
+    return atom;
+}
+
 purc_variant_t
 pcintr_load_from_uri(pcintr_stack_t stack, const char* uri)
 {
@@ -2163,6 +2383,7 @@ pcintr_load_from_uri(pcintr_stack_t stack, const char* uri)
 
 struct load_async_data {
     pcfetcher_response_handler handler;
+    pcfetcher_progress_handler progress;
     void* ctxt;
     pthread_t                  requesting_thread;
     pcintr_stack_t             requesting_stack;
@@ -2175,6 +2396,7 @@ release_load_async_data(struct load_async_data *data)
     if (data) {
         PURC_VARIANT_SAFE_CLEAR(data->request_id);
         data->handler           = NULL;
+        data->progress          = NULL;
         data->ctxt              = NULL;
         data->requesting_thread = 0;
         data->requesting_stack  = NULL;
@@ -2202,10 +2424,22 @@ on_load_async_done(
     destroy_load_async_data(data);
 }
 
-purc_variant_t
-pcintr_load_from_uri_async(pcintr_stack_t stack, const char* uri,
+static void
+on_load_async_progress(
+        purc_variant_t request_id, void* ctxt,
+        const struct pcfetcher_resp_header *resp_header,
+        const void *chunk, size_t sz_chunk)
+{
+    struct load_async_data *data;
+    data = (struct load_async_data*)ctxt;
+    data->progress(request_id, data->ctxt, resp_header, chunk, sz_chunk);
+}
+
+static purc_variant_t
+load_from_uri_async(pcintr_stack_t stack, const char* uri,
         enum pcfetcher_request_method method, purc_variant_t params,
-        pcfetcher_response_handler handler, void* ctxt)
+        pcfetcher_response_handler handler,
+        pcfetcher_progress_handler progress, void* ctxt)
 {
     PC_ASSERT(stack);
     PC_ASSERT(uri);
@@ -2220,6 +2454,7 @@ pcintr_load_from_uri_async(pcintr_stack_t stack, const char* uri,
         return PURC_VARIANT_INVALID;
     }
     data->handler              = handler;
+    data->progress             = progress;
     data->ctxt                 = ctxt;
     data->requesting_thread    = pthread_self();
     data->requesting_stack     = stack;
@@ -2230,13 +2465,25 @@ pcintr_load_from_uri_async(pcintr_stack_t stack, const char* uri,
     }
 
     uint32_t timeout = stack->co->timeout.tv_sec;
-    data->request_id = pcfetcher_request_async(
-            uri,
-            method,
-            params,
-            timeout,
-            on_load_async_done,
-            data);
+    if (progress) {
+        data->request_id = pcfetcher_request_async_progressively(
+                uri,
+                method,
+                params,
+                timeout,
+                on_load_async_done,
+                on_load_async_progress,
+                data);
+    }
+    else {
+        data->request_id = pcfetcher_request_async(
+                uri,
+                method,
+                params,
+                timeout,
+                on_load_async_done,
+                data);
+    }
 
     if (data->request_id == PURC_VARIANT_INVALID) {
         destroy_load_async_data(data);
@@ -2246,6 +2493,26 @@ pcintr_load_from_uri_async(pcintr_stack_t stack, const char* uri,
     return data->request_id;
 }
 
+purc_variant_t
+pcintr_load_from_uri_async(pcintr_stack_t stack, const char* uri,
+        enum pcfetcher_request_method method, purc_variant_t params,
+        pcfetcher_response_handler handler, void* ctxt)
+{
+    return load_from_uri_async(stack, uri, method, params, handler, NULL,
+            ctxt);
+}
+
+purc_variant_t
+pcintr_load_from_uri_progressively(pcintr_stack_t stack, const char* uri,
+        enum pcfetcher_request_method method, purc_variant_t params,
+        pcfetcher_response_handler handler,
+        pcfetcher_progress_handler progress, void* ctxt)
+{
+    PC_ASSERT(progress);
+    return load_from_uri_async(stack, uri, method, params, handler, progress,
+            ctxt);
+}
+
 bool
 pcintr_save_async_request_id(pcintr_stack_t stack, purc_variant_t req_id)
 {
@@ -2437,6 +2704,10 @@ template_cleaner(struct pcvdom_template *tpl)
     }
     tpl->vcm = NULL;
     tpl->to_free = false;
+
+    free(tpl->skeleton);
+    tpl->skeleton = NULL;
+    tpl->skeleton_made = false;
 }
 
 static void
@@ -2686,6 +2957,13 @@ pcintr_get_symbol_var(struct pcintr_stack_frame *frame,
     PC_ASSERT(symbol >= 0);
     PC_ASSERT(symbol < PURC_SYMBOL_VAR_MAX);
 
+    if (frame->symbol_vars[symbol] == PURC_VARIANT_INVALID &&
+            symbol == PURC_SYMBOL_VAR_EXCLAMATION) {
+        /* most of the frames never use the object */
+        if (init_exclamation_symval(frame))
+            return PURC_VARIANT_INVALID;
+    }
+
     return frame->symbol_vars[symbol];
 }
 
@@ -2968,110 +3246,7 @@ void*
 pcintr_load_module(const char *module,
         const char *env_name, const char *prefix)
 {
-#define PRINT_DEBUG
-#if OS(LINUX) || OS(UNIX) || OS(MAC_OS_X)             /* { */
-    const char *ext = ".so";
-#if OS(MAC_OS_X)
-    ext = ".dylib";
-#endif
-
-    if (!prefix)
-        prefix = "";
-
-    void *library_handle = NULL;
-
-    char so[PATH_MAX+1];
-    int n;
-    do {
-        /* XXX: the order of searching directories:
-         *
-         * 1. the valid directories contains in the environment variable:
-         *      $(env_name)
-         * 2. /usr/local/lib/purc-<purc-api-version>/
-         * 3. /usr/lib/purc-<purc-api-version>/
-         * 4. /lib/purc-<purc-api-version>/
-         */
-
-        // step1: search in directories defined by the env var
-        const char *env = NULL;
-        if (env_name)
-            env = getenv(env_name);
-
-        if (env) {
-            char *path = strdup(env);
-            char *str1;
-            char *saveptr1;
-            char *dir;
-
-            for (str1 = path; ; str1 = NULL) {
-                dir = strtok_r(str1, ":;", &saveptr1);
-                if (dir == NULL || dir[0] != '/') {
-                    break;
-                }
-
-                n = snprintf(so, sizeof(so),
-                        "%s/%s%s%s", dir, prefix, module, ext);
-                PC_ASSERT(n>0 && (size_t)n<sizeof(so));
-                library_handle = dlopen(so, RTLD_LAZY);
-                if (library_handle) {
-#ifdef PRINT_DEBUG        /* { */
-                    PC_DEBUGX("Loaded from %s\n", so);
-#endif                    /* } */
-                    break;
-                }
-            }
-
-            free(path);
-
-            if (library_handle)
-                break;
-        }
-
-        static const char *ver = PURC_API_VERSION_STRING;
-
-        // try in system directories.
-        static const char *other_tries[] = {
-            "/usr/local/lib/purc-%s/%s%s%s",
-            "/usr/lib/purc-%s/%s%s%s",
-            "/lib/purc-%s/%s%s%s",
-        };
-
-        for (size_t i = 0; i < PCA_TABLESIZE(other_tries); i++) {
-            n = snprintf(so, sizeof(so), other_tries[i], ver,
-                    prefix, module, ext);
-            PC_ASSERT(n>0 && (size_t)n<sizeof(so));
-            library_handle = dlopen(so, RTLD_LAZY);
-            if (library_handle) {
-#ifdef PRINT_DEBUG        /* { */
-                PC_DEBUGX("Loaded from %s\n", so);
-#endif                    /* } */
-                break;
-            }
-        }
-
-    } while (0);
-
-    if (!library_handle) {
-        purc_set_error_with_info(PURC_ERROR_BAD_SYSTEM_CALL,
-                "failed to load: %s", so);
-        return NULL;
-    }
-#ifdef PRINT_DEBUG        /* { */
-    PC_DEBUGX("loaded: %s", so);
-#endif                    /* } */
-
-    return library_handle;
-
-#else                                                 /* }{ */
-    UNUSED_PARAM(module);
-    UNUSED_PARAM(env_name);
-    UNUSED_PARAM(prefix);
-
-    // TODO: Add codes for other OS.
-    pcinst_set_error (PURC_ERROR_NOT_SUPPORTED);
-    PC_ASSERT(0); // Not implemented yet
-#endif                                                /* } */
-#undef PRINT_DEBUG
+    return pcutils_dlmodule_open(env_name, prefix, module);
 }
 
 void
@@ -3172,33 +3347,8 @@ template_walker(struct pcvcm_node *vcm, void *ctxt)
     purc_variant_t v = pcvcm_eval(vcm, stack, false);
     PC_ASSERT(v != PURC_VARIANT_INVALID);
 
-    if (purc_variant_is_string(v)) {
-        const char *s = purc_variant_get_string_const(v);
-
-        size_t chunk = 128;
-        struct pcutils_stringbuilder sb;
-        pcutils_stringbuilder_init(&sb, chunk);
-        int n = pcutils_stringbuilder_snprintf(&sb, "%s", s);
-        if (n < 0 || (size_t)n != strlen(s)) {
-            pcutils_stringbuilder_reset(&sb);
-            purc_variant_unref(v);
-            ud->r = -1;
-            return -1;
-        }
-
-        char *ssv = pcutils_stringbuilder_build(&sb);
-        if (ssv) {
-            ud->val = purc_variant_make_string_reuse_buff(ssv, strlen(ssv), true);
-            PC_ASSERT(v);
-        }
-        pcutils_stringbuilder_reset(&sb);
-    }
-    else {
-        ud->val = v;
-        purc_variant_ref(ud->val);
-    }
-
-    purc_variant_unref(v);
+    /* the strings are immutable, so the result is taken as it is */
+    ud->val = v;
     return 0;
 }
 
@@ -3227,6 +3377,401 @@ pcintr_template_expansion(purc_variant_t val)
     return v;
 }
 
+/* the mark of a hole is its index between U+E000 and U+E001 */
+#define HOLE_MARK_OPEN          "\xEE\x80\x80"
+#define HOLE_MARK_CLOSE         "\xEE\x80\x81"
+#define HOLE_MARK_LEN           3
+
+static inline struct pcvcm_node *
+vcm_first_child(struct pcvcm_node *node)
+{
+    return (struct pcvcm_node *)pctree_node_child(&node->tree_node);
+}
+
+static inline struct pcvcm_node *
+vcm_next_child(struct pcvcm_node *node)
+{
+    return (struct pcvcm_node *)pctree_node_next(&node->tree_node);
+}
+
+/* returns true if the tokenizer is in a tag or a character reference at
+   the end of the literal, where a hole changes the kind of the tokens */
+static bool
+is_open_before_hole(const char *s, size_t len)
+{
+    if (len > 0 && s[len - 1] == '<')
+        return true;
+    if (len > 1 && s[len - 2] == '<' && s[len - 1] == '/')
+        return true;
+
+    while (len > 0 && (purc_isalnum(s[len - 1]) || s[len - 1] == '#'))
+        len--;
+    return len > 0 && s[len - 1] == '&';
+}
+
+/* makes the skeleton if the content is a string or a concatenation of the
+   literals and the expressions */
+static void
+template_make_skeleton(struct pcvdom_template *tpl)
+{
+    tpl->skeleton_made = true;
+
+    struct pcvcm_node *vcm = tpl->vcm;
+    struct pcvcm_node *child;
+    if (vcm->type == PCVCM_NODE_TYPE_STRING)
+        child = vcm;
+    else if (vcm->type == PCVCM_NODE_TYPE_FUNC_CONCAT_STRING)
+        child = vcm_first_child(vcm);
+    else
+        return;
+
+    struct pcutils_printbuf pb;
+    if (pcutils_printbuf_init(&pb))
+        return;
+
+    const char *last = NULL;
+    size_t len_last = 0;
+    size_t nr_holes = 0;
+    for (; child; child = (child == vcm) ? NULL : vcm_next_child(child)) {
+        if (child->type == PCVCM_NODE_TYPE_STRING) {
+            last = (const char *)child->sz_ptr[1];
+            len_last = (size_t)child->sz_ptr[0];
+            if (strstr(last, HOLE_MARK_OPEN) ||
+                    strstr(last, HOLE_MARK_CLOSE) ||
+                    pcutils_printbuf_memappend(&pb, last, (int)len_last) < 0)
+                goto failed;
+            continue;
+        }
+
+        if (last && is_open_before_hole(last, len_last))
+            goto failed;
+        last = NULL;
+
+        char mark[32];
+        int n = snprintf(mark, sizeof(mark),
+                HOLE_MARK_OPEN "%u" HOLE_MARK_CLOSE, (unsigned)nr_holes);
+        if (pcutils_printbuf_memappend(&pb, mark, n) < 0)
+            goto failed;
+        nr_holes++;
+    }
+
+    tpl->skeleton = pb.buf;
+    tpl->len_skeleton = pcutils_printbuf_length(&pb);
+    tpl->nr_holes = nr_holes;
+    return;
+
+failed:
+    free(pb.buf);
+}
+
+static purc_variant_t
+hole_string(purc_variant_t v)
+{
+    if (purc_variant_is_string(v))
+        return purc_variant_ref(v);
+
+    char *buf = NULL;
+    ssize_t n = purc_variant_stringify_alloc(&buf, v);
+    if (n < 0 || buf == NULL)
+        return PURC_VARIANT_INVALID;
+    return purc_variant_make_string_reuse_buff(buf, n + 1, false);
+}
+
+purc_variant_t
+pcintr_template_expansion_ex(purc_variant_t val, bool silently,
+        purc_variant_t *holes)
+{
+    *holes = PURC_VARIANT_INVALID;
+
+    int r = check_template_variant(val);
+    PC_ASSERT(r == 0);
+
+    struct pcvdom_template *tpl;
+    tpl = (struct pcvdom_template*)purc_variant_native_get_entity(val);
+    if (!tpl->skeleton_made)
+        template_make_skeleton(tpl);
+    if (tpl->skeleton == NULL)
+        return pcintr_template_expansion(val);
+
+    pcintr_stack_t stack = pcintr_get_stack();
+    PC_ASSERT(stack);
+
+    struct pcutils_printbuf pb;
+    purc_variant_t arr = purc_variant_make_array_0();
+    if (arr == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+    if (pcutils_printbuf_init(&pb)) {
+        purc_variant_unref(arr);
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return PURC_VARIANT_INVALID;
+    }
+
+    /* the same as evaluating the concatenation, but keeps the holes */
+    struct pcvcm_node *vcm = tpl->vcm;
+    struct pcvcm_node *child = (vcm->type == PCVCM_NODE_TYPE_STRING) ?
+        vcm : vcm_first_child(vcm);
+    for (; child; child = (child == vcm) ? NULL : vcm_next_child(child)) {
+        const char *s;
+        size_t len;
+        if (child->type == PCVCM_NODE_TYPE_STRING) {
+            s = (const char *)child->sz_ptr[1];
+            len = (size_t)child->sz_ptr[0];
+        }
+        else {
+            purc_variant_t v = pcvcm_eval(child, stack, silently);
+            if (v == PURC_VARIANT_INVALID)
+                goto failed;
+
+            purc_variant_t hole = hole_string(v);
+            purc_variant_unref(v);
+            if (hole == PURC_VARIANT_INVALID)
+                goto failed;
+
+            bool ok = purc_variant_array_append(arr, hole);
+            purc_variant_unref(hole);
+            if (!ok)
+                goto failed;
+            s = purc_variant_get_string_const_ex(hole, &len);
+        }
+
+        if (len > 0 && pcutils_printbuf_memappend(&pb, s, (int)len) < 0) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            goto failed;
+        }
+    }
+
+    purc_variant_t v = purc_variant_make_string_reuse_buff(pb.buf, pb.size,
+            false);
+    if (v == PURC_VARIANT_INVALID) {
+        free(pb.buf);
+        purc_variant_unref(arr);
+        return PURC_VARIANT_INVALID;
+    }
+
+    *holes = arr;
+    return v;
+
+failed:
+    free(pb.buf);
+    purc_variant_unref(arr);
+    return PURC_VARIANT_INVALID;
+}
+
+/* returns false if the value of a hole makes other tokens than the mark,
+   for example a tag, a character reference, or the end of an unquoted
+   attribute value */
+static bool
+is_hole_value_inert(const char *s, size_t len, bool in_attr)
+{
+    if (in_attr && len == 0)
+        return false;
+    /* the first newline after <pre> or <textarea> is dropped */
+    if (!in_attr && len > 0 && s[0] == '\n')
+        return false;
+
+    for (size_t i = 0; i < len; i++) {
+        switch (s[i]) {
+        case '<':
+        case '>':
+        case '&':
+        case '"':
+        case '\'':
+        case '\r':
+            return false;
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\f':
+            if (in_attr)
+                return false;
+            break;
+        }
+    }
+
+    return true;
+}
+
+static bool
+is_all_spaces(const char *s, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        if (!purc_isspace(s[i]))
+            return false;
+    }
+    return true;
+}
+
+/* fills the holes in the null-terminated string of a step; returns 1 if
+   the nodes can not be placed */
+static int
+fill_holes(struct pcutils_printbuf *pb, const char *s, size_t len,
+        bool in_attr, purc_variant_t holes, uint8_t *nr_uses, bool *filled)
+{
+    size_t nr_holes = (size_t)purc_variant_array_get_size(holes);
+    const char *end = s + len;
+
+    *filled = false;
+    while (s < end) {
+        const char *mark = strstr(s, HOLE_MARK_OPEN);
+        if (mark == NULL || mark >= end) {
+            if (pcutils_printbuf_memappend(pb, s, (int)(end - s)) < 0)
+                return -1;
+            break;
+        }
+
+        if (mark > s && pcutils_printbuf_memappend(pb, s, (int)(mark - s)) < 0)
+            return -1;
+
+        char *digits_end;
+        unsigned long idx = strtoul(mark + HOLE_MARK_LEN, &digits_end, 10);
+        if (idx >= nr_holes || (size_t)(end - digits_end) < HOLE_MARK_LEN ||
+                memcmp(digits_end, HOLE_MARK_CLOSE, HOLE_MARK_LEN))
+            return 1;
+
+        size_t sz;
+        const char *v = purc_variant_get_string_const_ex(
+                purc_variant_array_get(holes, idx), &sz);
+        if (nr_uses[idx]++ || !is_hole_value_inert(v, sz, in_attr))
+            return 1;
+        if (sz > 0 && pcutils_printbuf_memappend(pb, v, (int)sz) < 0)
+            return -1;
+
+        *filled = true;
+        s = digits_end + HOLE_MARK_LEN;
+    }
+
+    return 0;
+}
+
+static inline bool
+has_hole_mark(const char *s)
+{
+    return s && strstr(s, HOLE_MARK_OPEN) != NULL;
+}
+
+int
+pcintr_template_place(pcintr_stack_t stack, purc_variant_t val,
+        purc_variant_t holes, pcdoc_element_t elem, pcdoc_operation op)
+{
+    struct pcvdom_template *tpl;
+    tpl = (struct pcvdom_template*)purc_variant_native_get_entity(val);
+    if (tpl == NULL || tpl->skeleton == NULL ||
+            (size_t)purc_variant_array_get_size(holes) != tpl->nr_holes)
+        return 1;
+
+    /* the steps are parsed once for a kind of element */
+    size_t nr_steps;
+    const struct pcdoc_build_step *steps;
+    steps = pcdoc_element_parse_steps(stack->doc, elem, tpl->skeleton,
+            tpl->len_skeleton, &nr_steps);
+    if (steps == NULL) {
+        purc_clr_error();
+        return 1;
+    }
+
+    /* the filled strings are located by the offsets until all are made */
+    int r = -1;
+    struct pcutils_printbuf pb = { NULL, 0, 0 };
+    struct pcdoc_build_step *filled_steps = NULL;
+    size_t *offsets = NULL;
+    uint8_t *nr_uses = calloc(tpl->nr_holes + 1, sizeof(uint8_t));
+    if (nr_uses == NULL || pcutils_printbuf_init(&pb))
+        goto done;
+
+    filled_steps = malloc((sizeof(*filled_steps) + sizeof(size_t)) *
+            (nr_steps + 1));
+    if (filled_steps == NULL)
+        goto done;
+    offsets = (size_t *)(filled_steps + nr_steps + 1);
+
+    size_t n = 0;
+    for (size_t i = 0; i < nr_steps; i++) {
+        const struct pcdoc_build_step *step = steps + i;
+        bool filled = false;
+        size_t len = 0;
+
+        offsets[n] = (size_t)-1;
+        if (has_hole_mark(step->name)) {
+            r = 1;
+            goto done;
+        }
+
+        if (step->type == PCDOC_BUILD_ATTRIBUTE ||
+                step->type == PCDOC_BUILD_TEXT) {
+            size_t off = pcutils_printbuf_length(&pb);
+            r = fill_holes(&pb, step->value, step->len,
+                    step->type == PCDOC_BUILD_ATTRIBUTE, holes, nr_uses,
+                    &filled);
+            if (r)
+                goto done;
+
+            len = pcutils_printbuf_length(&pb) - off;
+            if (filled) {
+                if (step->type == PCDOC_BUILD_TEXT) {
+                    /* the spaces are not placed like other characters */
+                    if (len > 0 && is_all_spaces(pb.buf + off, len)) {
+                        r = 1;
+                        goto done;
+                    }
+                    /* a text step of zero length is null-terminated */
+                    else if (len == 0)
+                        continue;
+                }
+                offsets[n] = off;
+            }
+        }
+
+        filled_steps[n] = *step;
+        if (filled)
+            filled_steps[n].len = len;
+        n++;
+    }
+
+    for (size_t i = 0; i < tpl->nr_holes; i++) {
+        if (nr_uses[i] != 1) {
+            r = 1;
+            goto done;
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        if (offsets[i] != (size_t)-1)
+            filled_steps[i].value = pb.buf + offsets[i];
+    }
+
+    r = pcintr_util_build_subtree(stack->doc, elem, op, filled_steps, n);
+
+done:
+    if (r < 0 && purc_get_last_error() == PURC_ERROR_OK)
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    free(filled_steps);
+    free(nr_uses);
+    free(pb.buf);
+    return r;
+}
+
+static const char *
+state_name(enum pcintr_coroutine_state state)
+{
+    switch (state) {
+    case CO_STATE_READY:
+        return "ready";
+    case CO_STATE_RUNNING:
+        return "running";
+    case CO_STATE_STOPPED:
+        return "stopped";
+    case CO_STATE_OBSERVING:
+        return "observing";
+    case CO_STATE_EXITED:
+        return "exited";
+    case CO_STATE_TERMINATED:
+        return "terminated";
+    case CO_STATE_TRACKED:
+        return "tracked";
+    }
+    return "unknown";
+}
+
 void
 pcintr_coroutine_set_state_with_location(pcintr_coroutine_t co,
         enum pcintr_coroutine_state state,
@@ -3236,7 +3781,41 @@ pcintr_coroutine_set_state_with_location(pcintr_coroutine_t co,
     UNUSED_PARAM(file);
     UNUSED_PARAM(line);
     UNUSED_PARAM(func);
+    enum pcintr_coroutine_state old_state = co->state;
     co->state = state;
+
+    if (old_state != state && pctimeline_instance()) {
+        pctimeline_instant(PC_TIMELINE_COROUTINE, state_name(state),
+                purc_atom_to_string(co->cid));
+    }
+
+    pcintr_heap_t heap = co->owner;
+    if (heap == NULL) {
+        return;
+    }
+
+    switch (state) {
+    case CO_STATE_READY:
+        if (old_state != CO_STATE_READY || list_empty(&co->ln_sched)) {
+            list_del_init(&co->ln_sched);
+            list_add_tail(&co->ln_sched, &heap->ready_coroutines);
+        }
+        pcintr_wakeup_scheduler(heap->owner);
+        break;
+
+    case CO_STATE_RUNNING:
+        list_del_init(&co->ln_sched);
+        break;
+
+    default:
+        /* keep the position if it is already waiting */
+        if (old_state == CO_STATE_READY || old_state == CO_STATE_RUNNING ||
+                list_empty(&co->ln_sched)) {
+            list_del_init(&co->ln_sched);
+            list_add_tail(&co->ln_sched, &heap->waiting_coroutines);
+        }
+        break;
+    }
 }
 
 pcdoc_element_t
@@ -3273,6 +3852,27 @@ pcintr_util_new_text_content(purc_document_t doc, pcdoc_element_t elem,
     return text_node;
 }
 
+pcdoc_text_node_t
+pcintr_util_new_shared_text_content(purc_document_t doc,
+        pcdoc_element_t elem, pcdoc_operation op, purc_variant_t txt)
+{
+    pcdoc_text_node_t text_node;
+
+    text_node = pcdoc_element_new_text_content_ex(doc, elem, op,
+            txt, PCDOC_TEXT_CONTENT_F_SHARED);
+
+    pcintr_stack_t stack = pcintr_get_stack();
+    if (text_node && stack && stack->co->target_page_handle) {
+        size_t len;
+        const char *s = purc_variant_get_string_const_ex(txt, &len);
+        pcintr_rdr_send_dom_req_simple_raw(stack, op,
+                elem, "textContent", PCRDR_MSG_DATA_TYPE_PLAIN,
+                s, len);
+    }
+
+    return text_node;
+}
+
 pcdoc_node
 pcintr_util_new_content(purc_document_t doc,
         pcdoc_element_t elem, pcdoc_operation op,
@@ -3292,6 +3892,41 @@ pcintr_util_new_content(purc_document_t doc,
     return node;
 }
 
+int
+pcintr_util_build_subtree(purc_document_t doc,
+        pcdoc_element_t elem, pcdoc_operation op,
+        const struct pcdoc_build_step *steps, size_t nr_steps)
+{
+    pcintr_stack_t stack = pcintr_get_stack();
+    purc_rwstream_t markup = NULL;
+    unsigned opts = 0;
+
+    if (stack && stack->co->target_page_handle) {
+        /* the renderer gets the new nodes in one operation */
+        markup = purc_rwstream_new_buffer(1024, 1024 * 1024 * 4);
+        if (markup == NULL)
+            return -1;
+
+        opts |= PCDOC_SERIALIZE_OPT_SKIP_WS_NODES;
+        opts |= PCDOC_SERIALIZE_OPT_WITHOUT_TEXT_INDENT;
+        opts |= PCDOC_SERIALIZE_OPT_WITH_HVML_HANDLE;
+    }
+
+    int r = pcdoc_element_build_subtree(doc, elem, op, steps, nr_steps,
+            opts, markup);
+    if (r == 0 && markup) {
+        size_t sz_content = 0;
+        const char *content = purc_rwstream_get_mem_buffer(markup,
+                &sz_content);
+        pcintr_rdr_send_dom_req_simple_raw(stack, op,
+                elem, NULL, doc->def_text_type, content, sz_content);
+    }
+
+    if (markup)
+        purc_rwstream_destroy(markup);
+    return r;
+}
+
 int
 pcintr_util_set_attribute(purc_document_t doc,
         pcdoc_element_t elem, pcdoc_operation op,
@@ -33,6 +33,7 @@
 #include "private/regex.h"
 
 #include <sys/time.h>
+#include <time.h>
 
 #define EXCLAMATION_EVENT_NAME     "_eventName"
 #define EXCLAMATION_EVENT_SOURCE   "_eventSource"
@@ -142,8 +143,132 @@ add_task(pcintr_coroutine_t co, struct pcintr_observer *p,
     list_add_tail(&task->ln, &co->tasks);
 }
 
+/*
+ * The events observed with `throttle` or `debounce` are bounded per
+ * observer, so the observers of the same target with different rates do not
+ * affect each other. An event not to handle at once is held by the observer:
+ * a newer one overlays it (like PCRDR_MSG_EVENT_REDUCE_OPT_OVERLAY), and it
+ * is handled when the timer of the observer fires, that is, when the
+ * interval elapses since the last one (throttle), or since the last one of a
+ * burst of events (debounce).
+ */
+static uint64_t
+monotonic_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+void
+pcintr_observer_set_rate(struct pcintr_observer *observer, int kind,
+        uint32_t ms)
+{
+    observer->rate_kind = kind;
+    observer->rate_ms = ms;
+}
+
+void
+pcintr_observer_release_held(struct pcintr_observer *observer)
+{
+    if (observer->rate_timer) {
+        pcintr_timer_destroy(observer->rate_timer);
+        observer->rate_timer = NULL;
+    }
+
+    PURC_VARIANT_SAFE_CLEAR(observer->held_event_name);
+    PURC_VARIANT_SAFE_CLEAR(observer->held_source);
+    PURC_VARIANT_SAFE_CLEAR(observer->held_data);
+}
+
+static void
+on_rate_timeout(pcintr_timer_t timer, const char *id, void *data)
+{
+    UNUSED_PARAM(timer);
+    UNUSED_PARAM(id);
+
+    struct pcintr_observer *observer = data;
+    pcintr_coroutine_t co = observer->stack->co;
+    if (observer->held_event_name == PURC_VARIANT_INVALID || co->stack.exited)
+        return;
+
+    add_task(co, observer, observer->held_data, observer->held_source,
+            observer->held_event_name);
+    observer->last_handled_ms = monotonic_ms();
+
+    PURC_VARIANT_SAFE_CLEAR(observer->held_event_name);
+    PURC_VARIANT_SAFE_CLEAR(observer->held_source);
+    PURC_VARIANT_SAFE_CLEAR(observer->held_data);
+
+    pcintr_wakeup_scheduler(pcinst_current());
+}
+
+static void
+hold_event(struct pcintr_observer *observer, purc_variant_t event_name,
+        purc_variant_t source, purc_variant_t data)
+{
+    PURC_VARIANT_SAFE_CLEAR(observer->held_event_name);
+    PURC_VARIANT_SAFE_CLEAR(observer->held_source);
+    PURC_VARIANT_SAFE_CLEAR(observer->held_data);
+
+    if (event_name)
+        observer->held_event_name = purc_variant_ref(event_name);
+    if (source)
+        observer->held_source = purc_variant_ref(source);
+    if (data)
+        observer->held_data = purc_variant_ref(data);
+}
+
+bool
+pcintr_observer_pass_event(struct pcintr_observer *observer,
+        purc_variant_t event_name, purc_variant_t source,
+        purc_variant_t data)
+{
+    if (observer->rate_kind == PCINTR_OBSERVER_RATE_NONE ||
+            observer->rate_ms == 0 || event_name == PURC_VARIANT_INVALID)
+        return true;
+
+    uint64_t now = monotonic_ms();
+    bool throttle = (observer->rate_kind == PCINTR_OBSERVER_RATE_THROTTLE);
+    if (throttle && observer->held_event_name == PURC_VARIANT_INVALID &&
+            (observer->last_handled_ms == 0 ||
+             now - observer->last_handled_ms >= observer->rate_ms)) {
+        observer->last_handled_ms = now;
+        return true;
+    }
+
+    if (observer->rate_timer == NULL) {
+        observer->rate_timer = pcintr_timer_create(NULL, NULL,
+                on_rate_timeout, observer);
+        if (observer->rate_timer == NULL) {
+            // not able to hold it
+            purc_clr_error();
+            return true;
+        }
+    }
+
+    hold_event(observer, event_name, source, data);
+
+    if (throttle) {
+        if (!pcintr_timer_is_active(observer->rate_timer)) {
+            uint64_t due = observer->last_handled_ms + observer->rate_ms;
+            pcintr_timer_set_interval(observer->rate_timer,
+                    due > now ? (uint32_t)(due - now) : 1);
+            pcintr_timer_start_oneshot(observer->rate_timer);
+        }
+    }
+    else {
+        // restart the interval for every event of a burst
+        pcintr_timer_stop(observer->rate_timer);
+        pcintr_timer_set_interval(observer->rate_timer, observer->rate_ms);
+        pcintr_timer_start_oneshot(observer->rate_timer);
+    }
+
+    return false;
+}
+
 static void handle_vdom_event(pcintr_stack_t stack, purc_vdom_t vdom,
-        purc_atom_t type, purc_variant_t sub_type, purc_variant_t data)
+        purc_atom_t type, const char *sub_type, purc_variant_t data)
 {
     UNUSED_PARAM(stack);
     UNUSED_PARAM(vdom);
@@ -165,23 +290,9 @@ process_coroutine_event(pcintr_coroutine_t co, pcrdr_msg *msg)
         return -1;
     }
 
-    purc_variant_t msg_type = PURC_VARIANT_INVALID;
-    purc_variant_t msg_sub_type = PURC_VARIANT_INVALID;
-    const char *event = purc_variant_get_string_const(msg->eventName);
-    if (!pcintr_parse_event(event, &msg_type, &msg_sub_type)) {
-        return -1;
-    }
-
-    const char *msg_type_s = purc_variant_get_string_const(msg_type);
-    PC_ASSERT(msg_type_s);
-
     const char *sub_type_s = NULL;
-    if (msg_sub_type != PURC_VARIANT_INVALID) {
-        sub_type_s = purc_variant_get_string_const(msg_sub_type);
-    }
-
-    purc_atom_t msg_type_atom = purc_atom_try_string_ex(ATOM_BUCKET_MSG,
-            msg_type_s);
+    const char *event = purc_variant_get_string_const(msg->eventName);
+    purc_atom_t msg_type_atom = pcintr_event_type_atom(event, &sub_type_s);
     if (!msg_type_atom) {
         return -1;
     }
@@ -189,12 +300,20 @@ process_coroutine_event(pcintr_coroutine_t co, pcrdr_msg *msg)
     purc_variant_t observed = msg->elementValue;
 
     bool handle = false;
-    struct list_head* list = pcintr_get_observer_list(stack, observed);
-    struct pcintr_observer *p, *n;
-    list_for_each_entry_safe(p, n, list, node) {
-        if (pcintr_is_observer_match(p, observed, msg_type_atom, sub_type_s)) {
-            handle = true;
-            add_task(co, p, msg->data, msg->sourceURI, msg->eventName);
+    struct list_head* list = pcintr_get_observer_bucket(stack, observed,
+            msg_type_atom);
+    if (list) {
+        struct pcintr_observer *p, *n;
+        list_for_each_entry_safe(p, n, list, type_node) {
+            if (pcintr_is_observer_match(p, observed, msg_type_atom,
+                        sub_type_s)) {
+                handle = true;
+                if (pcintr_observer_pass_event(p, msg->eventName,
+                            msg->sourceURI, msg->data)) {
+                    add_task(co, p, msg->data, msg->sourceURI,
+                            msg->eventName);
+                }
+            }
         }
     }
 
@@ -203,17 +322,10 @@ process_coroutine_event(pcintr_coroutine_t co, pcrdr_msg *msg)
         // window close event dispatch to vdom
         if (dest == stack->vdom) {
             handle_vdom_event(stack, stack->vdom, msg_type_atom,
-                    msg_sub_type, msg->data);
+                    sub_type_s, msg->data);
         }
     }
 
-    if (msg_type) {
-        purc_variant_unref(msg_type);
-    }
-    if (msg_sub_type) {
-        purc_variant_unref(msg_sub_type);
-    }
-
     return 0;
 }
 
@@ -260,31 +372,23 @@ is_observer_event_handler_match(struct pcintr_event_handler *handler,
         return false;
     }
 
-    purc_variant_t msg_type = PURC_VARIANT_INVALID;
-    purc_variant_t msg_sub_type = PURC_VARIANT_INVALID;
-    const char *event = purc_variant_get_string_const(msg->eventName);
-    if (!pcintr_parse_event(event, &msg_type, &msg_sub_type)) {
-        return false;
-    }
-
-    const char *msg_type_s = purc_variant_get_string_const(msg_type);
-
-    const char *sub_type_s = NULL;
-    if (msg_sub_type != PURC_VARIANT_INVALID) {
-        sub_type_s = purc_variant_get_string_const(msg_sub_type);
-    }
-
     bool match = false;
-    purc_atom_t msg_type_atom = purc_atom_try_string_ex(ATOM_BUCKET_MSG,
-            msg_type_s);
+    const char *sub_type_s = NULL;
+    const char *event = purc_variant_get_string_const(msg->eventName);
+    purc_atom_t msg_type_atom = pcintr_event_type_atom(event, &sub_type_s);
     if (!msg_type_atom) {
         goto out;
     }
 
     purc_variant_t observed = msg->elementValue;
-    struct list_head* list = pcintr_get_observer_list(&co->stack, observed);
+    struct list_head* list = pcintr_get_observer_bucket(&co->stack, observed,
+            msg_type_atom);
+    if (list == NULL) {
+        goto out;
+    }
+
     struct pcintr_observer *p, *n;
-    list_for_each_entry_safe(p, n, list, node) {
+    list_for_each_entry_safe(p, n, list, type_node) {
         if (pcintr_is_observer_match(p, observed, msg_type_atom, sub_type_s)) {
             match = true;
             break;
@@ -292,13 +396,6 @@ is_observer_event_handler_match(struct pcintr_event_handler *handler,
     }
 
 out:
-    if (msg_type) {
-        purc_variant_unref(msg_type);
-    }
-    if (msg_sub_type) {
-        purc_variant_unref(msg_sub_type);
-    }
-
     *out_observed = match;
     return match;
 }
@@ -333,15 +430,6 @@ observer_event_handle(struct pcintr_event_handler *handler,
     return ret;
 }
 
-void pcintr_coroutine_add_observer_event_handler(pcintr_coroutine_t co)
-{
-    struct pcintr_event_handler *handler = pcintr_coroutine_add_event_handler(
-            co,  OBSERVER_EVENT_HANDER,
-            CO_STAGE_OBSERVING, CO_STATE_OBSERVING,
-            NULL, observer_event_handle, is_observer_event_handler_match, true);
-    PC_ASSERT(handler);
-}
-
 static bool
 is_sub_exit_event_handler_match(struct pcintr_event_handler *handler,
         pcintr_coroutine_t co, pcrdr_msg *msg, bool *observed)
@@ -396,18 +484,6 @@ sub_exit_event_handle(struct pcintr_event_handler *handler,
     return PURC_ERROR_OK;
 }
 
-void
-pcintr_coroutine_add_sub_exit_event_handler(pcintr_coroutine_t co)
-{
-    UNUSED_PARAM(co);
-    struct pcintr_event_handler *handler = pcintr_coroutine_add_event_handler(
-            co,  SUB_EXIT_EVENT_HANDER,
-            CO_STAGE_FIRST_RUN | CO_STAGE_OBSERVING,
-            CO_STATE_READY | CO_STATE_OBSERVING,
-            NULL, sub_exit_event_handle, is_sub_exit_event_handler_match, false);
-    PC_ASSERT(handler);
-}
-
 static bool
 is_last_msg_event_handler_match(struct pcintr_event_handler *handler,
         pcintr_coroutine_t co, pcrdr_msg *msg, bool *observed)
@@ -444,16 +520,44 @@ last_msg_event_handle(struct pcintr_event_handler *handler,
     return PURC_ERROR_OK;
 }
 
-void
-pcintr_coroutine_add_last_msg_event_handler(pcintr_coroutine_t co)
+#define NR_BUILTIN_EVENT_HANDLERS   3
+
+int
+pcintr_coroutine_add_builtin_event_handlers(pcintr_coroutine_t co)
 {
-    UNUSED_PARAM(co);
-    struct pcintr_event_handler *handler = pcintr_coroutine_add_event_handler(
-            co,  LAST_MSG_EVENT_HANDER,
+    struct pcintr_event_handler *handlers;
+    handlers = (struct pcintr_event_handler *)calloc(
+            NR_BUILTIN_EVENT_HANDLERS, sizeof(*handlers));
+    if (!handlers) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    pcintr_event_handler_init(&handlers[0], SUB_EXIT_EVENT_HANDER,
+            CO_STAGE_FIRST_RUN | CO_STAGE_OBSERVING,
+            CO_STATE_READY | CO_STATE_OBSERVING,
+            NULL, sub_exit_event_handle, is_sub_exit_event_handler_match, false);
+    handlers[0].event_type = purc_atom_from_static_string_ex(ATOM_BUCKET_MSG,
+            MSG_TYPE_SUB_EXIT);
+
+    pcintr_event_handler_init(&handlers[1], LAST_MSG_EVENT_HANDER,
             CO_STAGE_FIRST_RUN | CO_STAGE_OBSERVING,
             CO_STATE_READY | CO_STATE_OBSERVING | CO_STATE_EXITED,
             NULL, last_msg_event_handle, is_last_msg_event_handler_match, false);
-    PC_ASSERT(handler);
+    handlers[1].event_type = purc_atom_from_static_string_ex(ATOM_BUCKET_MSG,
+            MSG_TYPE_LAST_MSG);
+
+    pcintr_event_handler_init(&handlers[2], OBSERVER_EVENT_HANDER,
+            CO_STAGE_OBSERVING, CO_STATE_OBSERVING,
+            NULL, observer_event_handle, is_observer_event_handler_match, true);
+
+    for (size_t i = 0; i < NR_BUILTIN_EVENT_HANDLERS; i++) {
+        handlers[i].builtin = 1;
+        list_add_tail(&handlers[i].ln, &co->event_handlers);
+    }
+
+    co->builtin_handlers = handlers;
+    return 0;
 }
 
 int
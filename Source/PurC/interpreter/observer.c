@@ -33,6 +33,108 @@
 
 #define BUILTIN_VAR_CRTN        PURC_PREDEF_VARNAME_CRTN
 
+#define REGEX_METACHARS         "\\^$.|?*+()[]{}"
+
+enum {
+    OBSERVER_LIST_DYNAMIC = 0,
+    OBSERVER_LIST_NATIVE,
+    OBSERVER_LIST_COMMON,
+    NR_OBSERVER_LISTS,
+};
+
+/* the observers for the messages of a type, in the order of registering;
+   one list for each observer list of the stack */
+struct pcintr_observer_bucket {
+    struct list_head            lists[NR_OBSERVER_LISTS];
+};
+
+static inline void *
+bucket_key(purc_atom_t type_atom)
+{
+    /* the atom of an unknown type is zero, but a key cannot be NULL */
+    return (void *)((uintptr_t)type_atom + 1);
+}
+
+static int
+observer_list_index(pcintr_stack_t stack, struct list_head *list)
+{
+    if (list == &stack->dynamic_observers)
+        return OBSERVER_LIST_DYNAMIC;
+    if (list == &stack->native_observers)
+        return OBSERVER_LIST_NATIVE;
+
+    PC_ASSERT(list == &stack->common_observers);
+    return OBSERVER_LIST_COMMON;
+}
+
+static struct pcintr_observer_bucket *
+find_bucket(pcintr_stack_t stack, purc_atom_t type_atom)
+{
+    struct pcutils_ptrmap_entry *entry;
+    entry = pcutils_ptrmap_find(&stack->observer_index, bucket_key(type_atom));
+    return entry ? entry->val : NULL;
+}
+
+static int
+add_observer_into_index(pcintr_stack_t stack, struct list_head *list,
+        struct pcintr_observer *observer)
+{
+    struct pcintr_observer_bucket *bucket;
+    bucket = find_bucket(stack, observer->msg_type_atom);
+    if (bucket == NULL) {
+        bucket = malloc(sizeof(*bucket));
+        if (bucket == NULL)
+            return -1;
+
+        for (int i = 0; i < NR_OBSERVER_LISTS; i++)
+            INIT_LIST_HEAD(&bucket->lists[i]);
+
+        if (pcutils_ptrmap_set(&stack->observer_index,
+                    bucket_key(observer->msg_type_atom), bucket)) {
+            free(bucket);
+            return -1;
+        }
+    }
+
+    list_add_tail(&observer->type_node,
+            &bucket->lists[observer_list_index(stack, list)]);
+    return 0;
+}
+
+static void
+remove_observer_from_index(struct pcintr_observer *observer)
+{
+    if (observer->type_node.next == NULL)
+        return;
+
+    list_del(&observer->type_node);
+
+    pcintr_stack_t stack = observer->stack;
+    struct pcintr_observer_bucket *bucket;
+    bucket = find_bucket(stack, observer->msg_type_atom);
+    PC_ASSERT(bucket);
+
+    for (int i = 0; i < NR_OBSERVER_LISTS; i++) {
+        if (!list_empty(&bucket->lists[i]))
+            return;
+    }
+
+    pcutils_ptrmap_erase(&stack->observer_index,
+            bucket_key(observer->msg_type_atom));
+    free(bucket);
+}
+
+void
+pcintr_destroy_observer_index(pcintr_stack_t stack)
+{
+    struct pcutils_ptrmap_entry *entry;
+    size_t pos = 0;
+    while ((entry = pcutils_ptrmap_next(&stack->observer_index, &pos))) {
+        free(entry->val);
+    }
+    pcutils_ptrmap_clear(&stack->observer_index);
+}
+
 static void
 release_observer(struct pcintr_observer *observer)
 {
@@ -40,6 +142,16 @@ release_observer(struct pcintr_observer *observer)
         return;
 
     list_del(&observer->node);
+    remove_observer_from_index(observer);
+
+    if (observer->for_idle) {
+        pcintr_stack_t stack = observer->stack;
+        PC_ASSERT(stack->nr_idle_observers > 0);
+        stack->nr_idle_observers--;
+        PC_ASSERT(stack->co->owner->nr_idle_observers > 0);
+        stack->co->owner->nr_idle_observers--;
+        observer->for_idle = 0;
+    }
 
     if (observer->on_revoke) {
         observer->on_revoke(observer, observer->on_revoke_data);
@@ -61,6 +173,13 @@ release_observer(struct pcintr_observer *observer)
         PURC_VARIANT_SAFE_CLEAR(observer->observed);
     }
 
+    pcintr_observer_release_held(observer);
+
+    if (observer->sub_type_regex) {
+        pcregex_destroy(observer->sub_type_regex);
+        observer->sub_type_regex = NULL;
+    }
+
     free(observer->sub_type);
     observer->sub_type = NULL;
 }
@@ -113,8 +232,6 @@ pcintr_destroy_observer_list(struct list_head *observer_list)
 {
     struct pcintr_observer *p, *n;
     list_for_each_entry_reverse_safe(p, n, observer_list, node) {
-        list_del(&p->node);
-        list_del(&p->node);
         free_observer(p);
     }
 }
@@ -152,20 +269,90 @@ pcintr_get_observer_list(pcintr_stack_t stack, purc_variant_t observed)
     return list;
 }
 
-bool
-pcintr_is_observer_match(struct pcintr_observer *observer,
-        purc_variant_t observed, purc_atom_t type_atom, const char *sub_type)
+struct list_head *
+pcintr_get_observer_bucket(pcintr_stack_t stack, purc_variant_t observed,
+        purc_atom_t type_atom)
+{
+    struct pcintr_observer_bucket *bucket = find_bucket(stack, type_atom);
+    if (bucket == NULL)
+        return NULL;
+
+    struct list_head *list = pcintr_get_observer_list(stack, observed);
+    return &bucket->lists[observer_list_index(stack, list)];
+}
+
+/* classifies the sub type of @observer, and compiles it if it is not a
+   literal or a prefix; the patterns are not anchored, as pcregex_match() */
+static void
+compile_sub_type(struct pcintr_observer *observer)
 {
-    if ((is_variant_match_observe(observer->observed, observed)) &&
-                (observer->msg_type_atom == type_atom)) {
-        if (observer->sub_type == sub_type ||
-                pcregex_is_match(observer->sub_type, sub_type)) {
+    const char *sub_type = observer->sub_type;
+    if (sub_type == NULL) {
+        observer->sub_type_kind = PCINTR_SUB_TYPE_NONE;
+        return;
+    }
+
+    if (strpbrk(sub_type, REGEX_METACHARS) == NULL) {
+        observer->sub_type_kind = PCINTR_SUB_TYPE_LITERAL;
+        observer->sub_type_len = strlen(sub_type);
+        return;
+    }
+
+    if (sub_type[0] == '^' &&
+            strpbrk(sub_type + 1, REGEX_METACHARS) == NULL) {
+        observer->sub_type_kind = PCINTR_SUB_TYPE_PREFIX;
+        observer->sub_type_len = strlen(sub_type + 1);
+        return;
+    }
+
+    observer->sub_type_regex = pcregex_new(sub_type);
+    if (observer->sub_type_regex) {
+        observer->sub_type_kind = PCINTR_SUB_TYPE_REGEX;
+    }
+    else {
+        // an invalid pattern never matches, as pcregex_is_match() does
+        observer->sub_type_kind = PCINTR_SUB_TYPE_INVALID;
+        purc_clr_error();
+    }
+}
+
+static bool
+is_sub_type_match(struct pcintr_observer *observer, const char *sub_type)
+{
+    switch (observer->sub_type_kind) {
+    case PCINTR_SUB_TYPE_NONE:
+        return sub_type == NULL;
+
+    case PCINTR_SUB_TYPE_LITERAL:
+        return sub_type && strstr(sub_type, observer->sub_type) != NULL;
+
+    case PCINTR_SUB_TYPE_PREFIX:
+        return sub_type && strncmp(sub_type, observer->sub_type + 1,
+                observer->sub_type_len) == 0;
+
+    case PCINTR_SUB_TYPE_REGEX:
+        if (sub_type == NULL)
+            return false;
+        if (strcmp(observer->sub_type, sub_type) == 0)
             return true;
-        }
+        return pcregex_match(observer->sub_type_regex, sub_type, NULL);
+
+    default:
+        break;
     }
+
     return false;
 }
 
+bool
+pcintr_is_observer_match(struct pcintr_observer *observer,
+        purc_variant_t observed, purc_atom_t type_atom, const char *sub_type)
+{
+    return observer->msg_type_atom == type_atom &&
+        is_variant_match_observe(observer->observed, observed) &&
+        is_sub_type_match(observer, sub_type);
+}
+
 
 
 
@@ -209,15 +396,29 @@ pcintr_register_observer(pcintr_stack_t stack,
     observer->pos = pos;
     observer->msg_type_atom = msg_type_atom;
     observer->sub_type = sub_type ? strdup(sub_type) : NULL;
+    if ((sub_type && observer->sub_type == NULL) ||
+            add_observer_into_index(stack, list, observer)) {
+        purc_variant_unref(observed);
+        free(observer->sub_type);
+        free(observer);
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+    compile_sub_type(observer);
     observer->on_revoke = on_revoke;
     observer->on_revoke_data = on_revoke_data;
     add_observer_into_list(stack, list, observer);
 
-    // observe idle
-    purc_variant_t hvml = pcintr_get_coroutine_variable(stack->co,
-            BUILTIN_VAR_CRTN);
-    if (observed == hvml) {
-        stack->observe_idle = 1;
+    // observe idle; nothing observes $CRTN before it is bound
+    purc_variant_t hvml = PURC_VARIANT_INVALID;
+    if (!(stack->co->lazy_vars & PCINTR_LAZY_VAR_CRTN)) {
+        hvml = pcintr_get_coroutine_variable(stack->co, BUILTIN_VAR_CRTN);
+    }
+    if (hvml && observed == hvml && msg_type_atom ==
+            purc_atom_try_string_ex(ATOM_BUCKET_MSG, MSG_TYPE_IDLE)) {
+        observer->for_idle = 1;
+        stack->nr_idle_observers++;
+        stack->co->owner->nr_idle_observers++;
     }
 
     return observer;
@@ -235,13 +436,6 @@ pcintr_revoke_observer(struct pcintr_observer* observer)
     PC_ASSERT(stack->co->waits >= 1);
     stack->co->waits--;
 
-    // observe idle
-    purc_variant_t hvml = pcintr_get_coroutine_variable(stack->co,
-            BUILTIN_VAR_CRTN);
-    if (observer->observed == hvml) {
-        stack->observe_idle = 0;
-    }
-
     free_observer(observer);
 }
 
@@ -249,9 +443,13 @@ void
 pcintr_revoke_observer_ex(pcintr_stack_t stack, purc_variant_t observed,
         purc_atom_t msg_type_atom, const char *sub_type)
 {
-    struct list_head* list = pcintr_get_observer_list(stack, observed);
+    struct list_head* list = pcintr_get_observer_bucket(stack, observed,
+            msg_type_atom);
+    if (list == NULL)
+        return;
+
     struct pcintr_observer *p, *n;
-    list_for_each_entry_safe(p, n, list, node) {
+    list_for_each_entry_safe(p, n, list, type_node) {
         if (pcintr_is_observer_match(p, observed, msg_type_atom, sub_type)) {
             pcintr_revoke_observer(p);
             break;
@@ -0,0 +1,218 @@
+/*
+ * @file profiler.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The sampling profiler of the HVML programs.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "purc.h"
+
+#include "config.h"
+
+#include "internal.h"
+
+#include "private/debug.h"
+#include "private/hashtable.h"
+#include "private/interpreter.h"
+#include "private/metrics.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The scheduler takes a sample before a step of a coroutine once the
+ * interval has elapsed since the last sample, so the steps taking more time
+ * are more likely to be sampled. A sample is the HVML stack of the coroutine
+ * folded as `tag:line;tag:line;...`, from the outermost element; the same
+ * stacks are counted by one entry. This needs no signal: a coroutine can
+ * only be interrupted between two steps.
+ */
+
+#define DEF_PROFILE_INTERVAL    1000    /* in microseconds */
+#define MAX_SAMPLED_FRAMES      64
+#define LEN_FOLDED_STACK        1024
+
+struct pcintr_profiler {
+    char                   *file;
+    uint64_t                interval;   /* in nanoseconds */
+    uint64_t                next;       /* the time of the next sample */
+    uint64_t                nr_samples;
+    uint64_t                nr_truncated;
+
+    /* the folded stacks (owned) to the numbers of the samples */
+    struct pchash_table    *stacks;
+};
+
+/* the instances may share a file */
+static pthread_mutex_t profile_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void
+free_stack_entry(struct pchash_entry *e)
+{
+    free(pchash_entry_k(e));
+}
+
+struct pcintr_profiler *
+pcintr_profiler_create(const purc_instance_extra_info *extra_info)
+{
+    const char *file = extra_info ? extra_info->profile_file : NULL;
+    if (file == NULL)
+        file = getenv(PURC_ENVV_PROFILE_FILE);
+    if (file == NULL || file[0] == 0)
+        return NULL;
+
+    unsigned int interval = extra_info ? extra_info->profile_interval : 0;
+    if (interval == 0) {
+        const char *env_value = getenv(PURC_ENVV_PROFILE_INTERVAL);
+        if (env_value)
+            interval = (unsigned int)strtoul(env_value, NULL, 10);
+    }
+    if (interval == 0)
+        interval = DEF_PROFILE_INTERVAL;
+
+    struct pcintr_profiler *profiler = calloc(1, sizeof(*profiler));
+    if (profiler == NULL)
+        goto failed;
+
+    profiler->file = strdup(file);
+    profiler->stacks = pchash_kstr_table_new(HASHTABLE_DEFAULT_SIZE,
+            free_stack_entry);
+    if (profiler->file == NULL || profiler->stacks == NULL)
+        goto failed;
+
+    profiler->interval = interval * 1000ULL;
+    profiler->next = pcinst_metrics_now() + profiler->interval;
+    return profiler;
+
+failed:
+    if (profiler) {
+        if (profiler->stacks)
+            pchash_table_free(profiler->stacks);
+        free(profiler->file);
+        free(profiler);
+    }
+    purc_log_warn("No memory for the profiler\n");
+    return NULL;
+}
+
+/* folds the stack of @co into @buf; returns the length, or 0 if empty */
+static size_t
+fold_stack(pcintr_coroutine_t co, char *buf, size_t sz, bool *truncated)
+{
+    pcvdom_element_t elems[MAX_SAMPLED_FRAMES];
+    size_t nr = 0;
+
+    /* from the innermost frame; the outer ones beyond are dropped */
+    struct pcintr_stack_frame *frame;
+    frame = pcintr_stack_get_bottom_frame(&co->stack);
+    while (frame && frame->pos) {
+        if (nr == MAX_SAMPLED_FRAMES) {
+            *truncated = true;
+            break;
+        }
+        elems[nr++] = frame->pos;
+        frame = pcintr_stack_frame_get_parent(frame);
+    }
+
+    size_t len = 0;
+    while (nr > 0) {
+        pcvdom_element_t elem = elems[--nr];
+        int n = snprintf(buf + len, sz - len, "%s%s:%d", len ? ";" : "",
+                elem->tag_name ? elem->tag_name : "?", elem->line);
+        if (n < 0 || (size_t)n >= sz - len) {
+            /* keep the complete frames only */
+            buf[len] = 0;
+            *truncated = true;
+            break;
+        }
+        len += n;
+    }
+
+    return len;
+}
+
+void
+pcintr_profiler_sample(struct pcintr_profiler *profiler, pcintr_coroutine_t co)
+{
+    uint64_t now = pcinst_metrics_now();
+    if (now < profiler->next)
+        return;
+    profiler->next = now + profiler->interval;
+
+    char buf[LEN_FOLDED_STACK];
+    bool truncated = false;
+    if (fold_stack(co, buf, sizeof(buf), &truncated) == 0)
+        return;
+
+    profiler->nr_samples++;
+    if (truncated)
+        profiler->nr_truncated++;
+
+    struct pchash_entry *e = pchash_table_lookup_entry(profiler->stacks, buf);
+    if (e) {
+        e->v = (void *)((uintptr_t)e->v + 1);
+        return;
+    }
+
+    char *key = strdup(buf);
+    if (key == NULL ||
+            pchash_table_insert(profiler->stacks, key, (void *)(uintptr_t)1)) {
+        free(key);
+    }
+}
+
+static void
+write_stacks(struct pcintr_profiler *profiler, const char *runner_name)
+{
+    pthread_mutex_lock(&profile_lock);
+    FILE *fp = fopen(profiler->file, "a");
+    if (fp) {
+        struct pchash_entry *e;
+        pchash_foreach(profiler->stacks, e) {
+            fprintf(fp, "%s;%s %llu\n", runner_name,
+                    (const char *)pchash_entry_k(e),
+                    (unsigned long long)(uintptr_t)pchash_entry_v(e));
+        }
+        fclose(fp);
+    }
+    else {
+        purc_log_warn("Failed to open the profile file: %s\n", profiler->file);
+    }
+    pthread_mutex_unlock(&profile_lock);
+
+    PC_DEBUG("%s: %llu samples (%llu truncated) of %d stacks profiled\n",
+            runner_name, (unsigned long long)profiler->nr_samples,
+            (unsigned long long)profiler->nr_truncated,
+            pchash_table_length(profiler->stacks));
+}
+
+void
+pcintr_profiler_destroy(struct pcintr_profiler *profiler,
+        const char *runner_name)
+{
+    if (profiler->nr_samples > 0)
+        write_stacks(profiler, runner_name ? runner_name : "-");
+
+    pchash_table_free(profiler->stacks);
+    free(profiler->file);
+    free(profiler);
+}
@@ -31,6 +31,8 @@
 #include "private/utils.h"
 #include "private/variant.h"
 #include "private/pcrdr.h"
+#include "private/metrics.h"
+#include "private/trace.h"
 
 #include <string.h>
 
@@ -75,6 +77,12 @@ pcrdr_msg *pcintr_rdr_send_request_and_wait_response(struct pcrdr_conn *conn,
         const char *property, pcrdr_msg_data_type data_type,
         purc_variant_t data, size_t data_len)
 {
+    /* keep the order of the DOM operations buffered by the coroutine */
+    pcintr_coroutine_t co = pcintr_get_coroutine();
+    if (co) {
+        pcintr_rdr_flush_dom_ops(co);
+    }
+
     pcrdr_msg *response_msg = NULL;
     pcrdr_msg *msg = pcrdr_make_request_message(
             target,                             /* target */
@@ -100,10 +108,13 @@ pcrdr_msg *pcintr_rdr_send_request_and_wait_response(struct pcrdr_conn *conn,
         msg->textLen = data_len;
     }
 
+    uint64_t since = pcinst_metrics_now();
     if (pcrdr_send_request_and_wait_response(conn,
             msg, PCRDR_TIME_DEF_EXPECTED, &response_msg) < 0) {
         goto failed;
     }
+    pcinst_metrics_record(pcinst_current(), PCINST_METRIC_RDR_RTT, since);
+    pctimeline_complete(PC_TIMELINE_RDR, operation, NULL, since);
     pcrdr_release_message(msg);
     msg = NULL;
 
@@ -881,6 +892,12 @@ pcintr_rdr_page_control_load(pcintr_stack_t stack)
     if (stack->co->target_page_handle == 0) {
         return true;
     }
+
+    /* The page holds the document already, and the changes made in the
+       first run have been sent as DOM operations; do not reload it. */
+    if (stack->co->target_dom_handle != 0) {
+        return true;
+    }
     int ret_code;
     pcrdr_msg *response_msg = NULL;
 
@@ -1001,47 +1018,126 @@ static const char *rdr_ops[] = {
     "",     // unknown
 };
 
-pcrdr_msg *
-pcintr_rdr_send_dom_req(pcintr_stack_t stack, pcdoc_operation op,
-        pcdoc_element_t element, const char* property,
-        pcrdr_msg_data_type data_type, purc_variant_t data)
-{
-    if (!stack || stack->co->target_page_handle == 0
-            || stack->co->stage != CO_STAGE_OBSERVING) {
-        return NULL;
-    }
+/* the operations buffered by a coroutine at most before flushing */
+#define MAX_BUFFERED_DOM_OPS        64
+
+struct dom_op {
+    struct list_head    ln;
+    const char         *operation;
+    pcdoc_operation     op;
+    pcdoc_element_t     element;
+    char               *property;
+    pcrdr_msg_data_type data_type;
+    purc_variant_t      data;
+};
 
-    const char *operation = rdr_ops[op];
+static const char *
+dom_operation(pcdoc_operation op, const char *property)
+{
     if (property && op == PCDOC_OP_DISPLACE) {
         // VW: use 'update' operation when displace property
-        operation = PCRDR_OPERATION_UPDATE;
+        return PCRDR_OPERATION_UPDATE;
     }
 
-    pcrdr_msg *response_msg = NULL;
-
-    pcrdr_msg_target target = PCRDR_MSG_TARGET_DOM;
-    uint64_t target_value = stack->co->target_dom_handle;
-    pcrdr_msg_element_type element_type = PCRDR_MSG_ELEMENT_TYPE_HANDLE;
+    return rdr_ops[op];
+}
 
-    char elem[LEN_BUFF_LONGLONGINT];
-    int n = snprintf(elem, sizeof(elem),
+static bool
+element_handle(pcdoc_element_t element, char *buf, size_t sz)
+{
+    int n = snprintf(buf, sz,
             "%llx", (unsigned long long int)(uint64_t)element);
     if (n < 0) {
         purc_set_error(PURC_ERROR_BAD_STDC_CALL);
-        goto failed;
+        return false;
     }
-    else if ((size_t)n >= sizeof (elem)) {
+    else if ((size_t)n >= sz) {
         PC_DEBUG ("Too small elemer to serialize message.\n");
         purc_set_error(PURC_ERROR_TOO_SMALL_BUFF);
+        return false;
+    }
+
+    return true;
+}
+
+/* makes the request for the DOM operation; data is taken by the request */
+static pcrdr_msg *
+make_dom_req(pcintr_coroutine_t co, const char *operation,
+        pcdoc_element_t element, const char* property,
+        pcrdr_msg_data_type data_type, purc_variant_t data)
+{
+    char elem[LEN_BUFF_LONGLONGINT];
+    if (element && !element_handle(element, elem, sizeof(elem))) {
         goto failed;
     }
 
-    struct pcinst *inst = pcinst_current();
-    response_msg = pcintr_rdr_send_request_and_wait_response(inst->conn_to_rdr,
-        target, target_value, operation, element_type, elem,
-        property, data_type, data, 0);
+    pcrdr_msg *msg = pcrdr_make_request_message(
+            PCRDR_MSG_TARGET_DOM,               /* target */
+            co->target_dom_handle,              /* target_value */
+            operation,                          /* operation */
+            NULL,                               /* request_id */
+            NULL,                               /* source_uri */
+            element ? PCRDR_MSG_ELEMENT_TYPE_HANDLE :
+                PCRDR_MSG_ELEMENT_TYPE_VOID,    /* element_type */
+            element ? elem : NULL,              /* element */
+            property,                           /* property */
+            PCRDR_MSG_DATA_TYPE_VOID,           /* data_type */
+            NULL,                               /* data */
+            0                                   /* data_len */
+            );
+    if (msg == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto failed;
+    }
 
-    if (response_msg == NULL) {
+    msg->dataType = data_type;
+    msg->data = data;
+    return msg;
+
+failed:
+    if (data != PURC_VARIANT_INVALID) {
+        purc_variant_unref(data);
+    }
+    return NULL;
+}
+
+/*
+ * The DOM in the renderer is ready after the document loaded, or during
+ * the first run if the page holds the document already, i.e., the document
+ * is shared with the parent coroutine which loaded it.
+ */
+static inline bool
+is_dom_ready(pcintr_stack_t stack)
+{
+    return stack && stack->co->target_page_handle != 0
+        && (stack->co->stage == CO_STAGE_OBSERVING ||
+                stack->co->target_dom_handle != 0);
+}
+
+pcrdr_msg *
+pcintr_rdr_send_dom_req(pcintr_stack_t stack, pcdoc_operation op,
+        pcdoc_element_t element, const char* property,
+        pcrdr_msg_data_type data_type, purc_variant_t data)
+{
+    if (!is_dom_ready(stack)) {
+        return NULL;
+    }
+
+    /* the buffered operations go first */
+    pcintr_rdr_flush_dom_ops(stack->co);
+
+    pcrdr_msg *response_msg = NULL;
+    pcrdr_msg *msg = make_dom_req(stack->co, dom_operation(op, property),
+            element, property, data_type, data);
+    if (msg == NULL) {
+        goto failed;
+    }
+
+    struct pcinst *inst = pcinst_current();
+    int r = pcrdr_send_request_and_wait_response(inst->conn_to_rdr,
+            msg, PCRDR_TIME_DEF_EXPECTED, &response_msg);
+    pcrdr_release_message(msg);
+    if (r < 0 || response_msg == NULL) {
         goto failed;
     }
 
@@ -1060,42 +1156,432 @@ failed:
     return NULL;
 }
 
+static purc_variant_t
+make_dom_req_data(pcrdr_msg_data_type data_type, const char *data, size_t len)
+{
+    purc_variant_t req_data;
+    if (data_type == PCRDR_MSG_DATA_TYPE_JSON) {
+        req_data = purc_variant_make_from_json_string(data, len);
+    }
+    else {  /* VW: for other data types */
+        req_data = purc_variant_make_string(data, false);
+    }
+
+    if (req_data == PURC_VARIANT_INVALID) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    }
+    return req_data;
+}
+
 pcrdr_msg *
 pcintr_rdr_send_dom_req_raw(pcintr_stack_t stack, pcdoc_operation op,
         pcdoc_element_t element, const char* property,
         pcrdr_msg_data_type data_type, const char *data, size_t len)
 {
-    if (!stack || stack->co->target_page_handle == 0
-            || stack->co->stage != CO_STAGE_OBSERVING) {
+    if (!is_dom_ready(stack)) {
         return NULL;
     }
 
-    pcrdr_msg *ret = NULL;
-    purc_variant_t req_data = PURC_VARIANT_INVALID;
-    if (data_type == PCRDR_MSG_DATA_TYPE_JSON) {
-        req_data = purc_variant_make_from_json_string(data, len);
-        if (req_data == PURC_VARIANT_INVALID) {
-            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-            goto failed;
+    purc_variant_t req_data = make_dom_req_data(data_type, data, len);
+    if (req_data == PURC_VARIANT_INVALID) {
+        return NULL;
+    }
+
+    return pcintr_rdr_send_dom_req(stack, op, element,
+            property, data_type, req_data);
+}
+
+struct dom_req_ctxt {
+    purc_atom_t         cid;
+    const char         *operation;
+};
+
+/*
+ * The response to a DOM request sent without waiting. The coroutine is told
+ * by a `rdrState:reqFailed` event if the renderer refused the request or it
+ * timed out; nothing is told if the connection is gone, since the coroutines
+ * get `rdrState:connLost` then.
+ */
+static int
+dom_response_handler(pcrdr_conn* conn, const char *request_id, int state,
+        void *context, const pcrdr_msg *response_msg)
+{
+    UNUSED_PARAM(conn);
+    UNUSED_PARAM(request_id);
+
+    struct dom_req_ctxt *ctxt = context;
+    int ret_code;
+    if (state == PCRDR_RESPONSE_RESULT) {
+        ret_code = response_msg->retCode;
+    }
+    else if (state == PCRDR_RESPONSE_TIMEOUT) {
+        ret_code = PCRDR_SC_CALLEE_TIMEOUT;
+    }
+    else {
+        ret_code = PCRDR_SC_OK;
+    }
+
+    pcintr_coroutine_t co;
+    if (ret_code != PCRDR_SC_OK &&
+            (co = pcintr_coroutine_get_by_id(ctxt->cid))) {
+        purc_variant_t hvml = pcintr_get_coroutine_variable(co,
+                PURC_PREDEF_VARNAME_CRTN);
+        purc_variant_t data = purc_variant_make_object(0,
+                PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+        if (data) {
+            object_set(data, "operation", ctxt->operation);
+
+            purc_variant_t v = purc_variant_make_longint(ret_code);
+            if (v) {
+                purc_variant_object_set_by_static_ckey(data, "retCode", v);
+                purc_variant_unref(v);
+            }
+
+            pcintr_coroutine_post_event(ctxt->cid,
+                    PCRDR_MSG_EVENT_REDUCE_OPT_KEEP,
+                    hvml, MSG_TYPE_RDR_STATE, MSG_SUB_TYPE_REQ_FAILED,
+                    data, PURC_VARIANT_INVALID);
+            purc_variant_unref(data);
         }
     }
-    else {  /* VW: for other data types */
-        req_data = purc_variant_make_string(data, false);
-        if (req_data == PURC_VARIANT_INVALID) {
-            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+
+    free(ctxt);
+    return 0;
+}
+
+/*
+ * Sends the request without waiting for the response, so the requests of
+ * a coroutine are pipelined; the renderer handles them in order, and
+ * a request waited for later is still answered after them.
+ */
+static bool
+send_dom_req_async(pcintr_coroutine_t co, const char *operation,
+        pcdoc_element_t element, const char* property,
+        pcrdr_msg_data_type data_type, purc_variant_t data)
+{
+    struct dom_req_ctxt *ctxt = NULL;
+    pcrdr_msg *msg = make_dom_req(co, operation, element, property,
+            data_type, data);
+    if (msg == NULL) {
+        goto failed;
+    }
+
+    ctxt = malloc(sizeof(*ctxt));
+    if (ctxt == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto failed;
+    }
+    ctxt->cid = co->cid;
+    ctxt->operation = operation;
+
+    struct pcinst *inst = pcinst_current();
+    if (pcrdr_send_request(inst->conn_to_rdr, msg, PCRDR_TIME_DEF_EXPECTED,
+                ctxt, dom_response_handler) < 0) {
+        goto failed;
+    }
+
+    pcrdr_release_message(msg);
+    return true;
+
+failed:
+    free(ctxt);
+    if (msg) {
+        pcrdr_release_message(msg);
+    }
+    return false;
+}
+
+static void
+release_dom_op(struct dom_op *dop)
+{
+    list_del(&dop->ln);
+    free(dop->property);
+    if (dop->data)
+        purc_variant_unref(dop->data);
+    free(dop);
+}
+
+/* whether the data of the operation on the content may make elements */
+static inline bool
+may_make_elements(struct dom_op *dop)
+{
+    return dop->property == NULL &&
+        dop->data_type != PCRDR_MSG_DATA_TYPE_VOID &&
+        dop->data_type != PCRDR_MSG_DATA_TYPE_PLAIN &&
+        dop->data_type != PCRDR_MSG_DATA_TYPE_JSON;
+}
+
+static inline bool
+is_text_content(const char *property)
+{
+    return property && strcmp(property, "textContent") == 0;
+}
+
+/* whether the earlier operation is superseded by the new operation */
+static bool
+is_superseded(struct dom_op *dop, pcdoc_operation op, const char *property)
+{
+    if (dop->op == PCDOC_OP_INSERTBEFORE || dop->op == PCDOC_OP_INSERTAFTER) {
+        /* it makes the siblings */
+        return false;
+    }
+
+    switch (op) {
+    case PCDOC_OP_ERASE:
+        if (property == NULL) {
+            /* the element is gone */
+            return true;
+        }
+        /* fall through */
+    case PCDOC_OP_DISPLACE:
+    case PCDOC_OP_UPDATE:
+    case PCDOC_OP_CLEAR:
+        if (property == NULL || is_text_content(property)) {
+            /* the content is overwritten */
+            return dop->property == NULL || is_text_content(dop->property);
+        }
+
+        /* the property is overwritten */
+        return dop->property && strcmp(dop->property, property) == 0;
+
+    default:
+        break;
+    }
+
+    return false;
+}
+
+/*
+ * Drops the buffered operations made useless by the new operation, e.g.,
+ * displacing the content of an element twice, or appending to an element
+ * erased later. An operation which may make elements is dropped only if
+ * no operation on other elements follows it, since the latter may target
+ * the elements made.
+ */
+static void
+collapse_dom_ops(pcintr_coroutine_t co, pcdoc_operation op,
+        pcdoc_element_t element, const char *property)
+{
+    bool others_follow = false;
+    struct dom_op *dop, *prev;
+    list_for_each_entry_reverse_safe(dop, prev, &co->dom_ops, ln) {
+        if (dop->element != element) {
+            others_follow = true;
+            continue;
+        }
+
+        if (is_superseded(dop, op, property) &&
+                !(others_follow && may_make_elements(dop))) {
+            release_dom_op(dop);
+            co->nr_dom_ops--;
+        }
+    }
+}
+
+static void
+flush_dom_ops_one_by_one(pcintr_coroutine_t co)
+{
+    struct dom_op *dop, *next;
+    list_for_each_entry_safe(dop, next, &co->dom_ops, ln) {
+        send_dom_req_async(co, dop->operation, dop->element, dop->property,
+                dop->data_type, dop->data);
+        dop->data = PURC_VARIANT_INVALID;
+        release_dom_op(dop);
+    }
+}
+
+static purc_variant_t
+make_batch_item(struct dom_op *dop)
+{
+    purc_variant_t item = purc_variant_make_object(0,
+            PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+    if (item == PURC_VARIANT_INVALID) {
+        goto failed;
+    }
+
+    char elem[LEN_BUFF_LONGLONGINT];
+    if (!element_handle(dop->element, elem, sizeof(elem)) ||
+            !object_set(item, "operation", dop->operation) ||
+            !object_set(item, "element", elem) ||
+            (dop->property && !object_set(item, "property", dop->property))) {
+        goto failed;
+    }
+
+    if (dop->data) {
+        if (!object_set(item, "dataType",
+                    pcrdr_data_type_name(dop->data_type)) ||
+                !purc_variant_object_set_by_static_ckey(item, "data",
+                    dop->data)) {
             goto failed;
         }
     }
 
-    ret = pcintr_rdr_send_dom_req(stack, op, element,
-            property, data_type, req_data);
-    return ret;
+    return item;
 
 failed:
-    if (req_data != PURC_VARIANT_INVALID) {
-        purc_variant_unref(req_data);
+    if (item) {
+        purc_variant_unref(item);
     }
-    return ret;
+    return PURC_VARIANT_INVALID;
+}
+
+/* sends (at most) max operations in one `batchOperations` request */
+static bool
+flush_dom_ops_in_batch(pcintr_coroutine_t co, size_t max)
+{
+    purc_variant_t ops = purc_variant_make_array_0();
+    if (ops == PURC_VARIANT_INVALID) {
+        return false;
+    }
+
+    size_t n = 0;
+    struct dom_op *dop, *next;
+    list_for_each_entry(dop, &co->dom_ops, ln) {
+        if (n == max) {
+            break;
+        }
+
+        purc_variant_t item = make_batch_item(dop);
+        if (item == PURC_VARIANT_INVALID ||
+                !purc_variant_array_append(ops, item)) {
+            if (item) {
+                purc_variant_unref(item);
+            }
+            purc_variant_unref(ops);
+            return false;
+        }
+
+        purc_variant_unref(item);
+        n++;
+    }
+
+    list_for_each_entry_safe(dop, next, &co->dom_ops, ln) {
+        if (n-- == 0) {
+            break;
+        }
+
+        release_dom_op(dop);
+        co->nr_dom_ops--;
+    }
+
+    return send_dom_req_async(co, PCRDR_OPERATION_BATCHOPERATIONS,
+            NULL, NULL, PCRDR_MSG_DATA_TYPE_JSON, ops);
+}
+
+/*
+ * Sends the buffered operations; every batch or single operation takes
+ * an in-flight credit of the connection. If not forced, the operations
+ * left when the credits run out are kept, and false is returned.
+ */
+static bool
+flush_dom_ops(pcintr_coroutine_t co, bool forced)
+{
+    if (list_empty(&co->dom_ops)) {
+        return true;
+    }
+
+    struct pcinst *inst = pcinst_current();
+    struct pcrdr_conn *conn = inst->conn_to_rdr;
+    if (conn == NULL || co->target_page_handle == 0) {
+        pcintr_rdr_drop_dom_ops(co);
+        return true;
+    }
+
+    long int max = inst->rdr_caps ? inst->rdr_caps->batchOperations : 0;
+    while (max > 1 && co->nr_dom_ops > 1) {
+        if (!forced && pcrdr_conn_inflight_credits(conn) == 0) {
+            return false;
+        }
+
+        if (!flush_dom_ops_in_batch(co, (size_t)max)) {
+            break;
+        }
+    }
+
+    if (forced) {
+        flush_dom_ops_one_by_one(co);
+    }
+    else {
+        struct dom_op *dop, *next;
+        list_for_each_entry_safe(dop, next, &co->dom_ops, ln) {
+            if (pcrdr_conn_inflight_credits(conn) == 0) {
+                return false;
+            }
+
+            send_dom_req_async(co, dop->operation, dop->element,
+                    dop->property, dop->data_type, dop->data);
+            dop->data = PURC_VARIANT_INVALID;
+            release_dom_op(dop);
+            co->nr_dom_ops--;
+        }
+    }
+
+    pcintr_rdr_drop_dom_ops(co);
+    return true;
+}
+
+void
+pcintr_rdr_flush_dom_ops(pcintr_coroutine_t co)
+{
+    flush_dom_ops(co, true);
+}
+
+bool
+pcintr_rdr_try_flush_dom_ops(pcintr_coroutine_t co)
+{
+    return flush_dom_ops(co, false);
+}
+
+void
+pcintr_rdr_drop_dom_ops(pcintr_coroutine_t co)
+{
+    struct dom_op *dop, *next;
+    list_for_each_entry_safe(dop, next, &co->dom_ops, ln) {
+        release_dom_op(dop);
+    }
+    co->nr_dom_ops = 0;
+}
+
+/*
+ * Buffers the operation while the coroutine is running a step, and the
+ * scheduler flushes the buffered operations after the coroutine yields
+ * the time slice; otherwise the operation is sent at once.
+ */
+static bool
+queue_dom_req(pcintr_stack_t stack, pcdoc_operation op,
+        pcdoc_element_t element, const char* property,
+        pcrdr_msg_data_type data_type, purc_variant_t data)
+{
+    pcintr_coroutine_t co = stack->co;
+    if (co != pcintr_get_coroutine() || co->state != CO_STATE_RUNNING) {
+        return send_dom_req_async(co, dom_operation(op, property),
+                element, property, data_type, data);
+    }
+
+    struct dom_op *dop = calloc(1, sizeof(*dop));
+    if (dop == NULL || (property && (dop->property = strdup(property)) == NULL)) {
+        free(dop);
+        if (data) {
+            purc_variant_unref(data);
+        }
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return false;
+    }
+
+    collapse_dom_ops(co, op, element, property);
+
+    dop->operation = dom_operation(op, property);
+    dop->op = op;
+    dop->element = element;
+    dop->data_type = data_type;
+    dop->data = data;
+    list_add_tail(&dop->ln, &co->dom_ops);
+    co->nr_dom_ops++;
+
+    if (co->nr_dom_ops >= MAX_BUFFERED_DOM_OPS) {
+        pcintr_rdr_flush_dom_ops(co);
+    }
+    return true;
 }
 
 bool
@@ -1103,13 +1589,11 @@ pcintr_rdr_send_dom_req_simple(pcintr_stack_t stack, pcdoc_operation op,
         pcdoc_element_t element, const char *property,
         pcrdr_msg_data_type data_type, purc_variant_t data)
 {
-    pcrdr_msg *response_msg = pcintr_rdr_send_dom_req(stack, op,
-            element, property, data_type, data);
-    if (response_msg != NULL) {
-        pcrdr_release_message(response_msg);
-        return true;
+    if (!is_dom_ready(stack)) {
+        return false;
     }
-    return false;
+
+    return queue_dom_req(stack, op, element, property, data_type, data);
 }
 
 bool
@@ -1118,6 +1602,10 @@ pcintr_rdr_send_dom_req_simple_raw(pcintr_stack_t stack,
         const char *property, pcrdr_msg_data_type data_type,
         const char *data, size_t len)
 {
+    if (!is_dom_ready(stack)) {
+        return false;
+    }
+
     if (data && len == 0) {
         len = strlen(data);
     }
@@ -1126,13 +1614,12 @@ pcintr_rdr_send_dom_req_simple_raw(pcintr_stack_t stack,
         data = " ";
         len = 1;
     }
-    pcrdr_msg *response_msg = pcintr_rdr_send_dom_req_raw(stack, op,
-            element, property, data_type, data, len);
 
-    if (response_msg != NULL) {
-        pcrdr_release_message(response_msg);
-        return true;
+    purc_variant_t req_data = make_dom_req_data(data_type, data, len);
+    if (req_data == PURC_VARIANT_INVALID) {
+        return false;
     }
-    return false;
+
+    return queue_dom_req(stack, op, element, property, data_type, req_data);
 }
 
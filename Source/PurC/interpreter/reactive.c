@@ -0,0 +1,379 @@
+/*
+ * @file reactive.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The reactive bindings of the eDOM content.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "internal.h"
+
+#include "private/instance.h"
+#include "private/printbuf.h"
+#include "private/vcm.h"
+#include "purc-runloop.h"
+
+#define OPS_LISTENED   \
+    (PCVAR_OPERATION_GROW | PCVAR_OPERATION_SHRINK | PCVAR_OPERATION_CHANGE)
+
+/* a variable read by the content, and the listener if it is a container */
+struct reactive_dep {
+    char                       *name;
+    purc_variant_t              val;
+    struct pcvar_listener      *listener;
+};
+
+struct pcintr_binding {
+    struct list_head            node;
+    struct pcintr_reactive     *reactive;
+
+    /* `#` followed by the identifier of the element */
+    char                       *selector;
+    bool                        silently;
+    bool                        dirty;
+
+    /* the content nodes of the element in vDOM */
+    struct pcvcm_node         **contents;
+    size_t                      nr_contents;
+
+    struct reactive_dep        *deps;
+    size_t                      nr_deps;
+};
+
+struct pcintr_reactive {
+    purc_atom_t                 cid;
+    struct list_head            bindings;
+    bool                        flush_scheduled;
+};
+
+/* the context of the evaluation recording the variables read */
+struct capture {
+    pcintr_stack_t              stack;      /* NULL when refreshing */
+    struct pcintr_binding      *binding;
+
+    struct reactive_dep        *deps;
+    size_t                      nr_deps;
+    size_t                      sz_deps;
+    bool                        failed;
+};
+
+static void
+clear_deps(struct reactive_dep *deps, size_t nr_deps)
+{
+    for (size_t i = 0; i < nr_deps; i++) {
+        if (deps[i].listener) {
+            purc_variant_revoke_listener(deps[i].val, deps[i].listener);
+        }
+        purc_variant_unref(deps[i].val);
+        free(deps[i].name);
+    }
+    free(deps);
+}
+
+static struct reactive_dep *
+find_dep(struct reactive_dep *deps, size_t nr_deps, const char *name)
+{
+    for (size_t i = 0; i < nr_deps; i++) {
+        if (strcmp(deps[i].name, name) == 0)
+            return deps + i;
+    }
+    return NULL;
+}
+
+static void
+record_dep(struct capture *cap, const char *name, purc_variant_t val)
+{
+    if (find_dep(cap->deps, cap->nr_deps, name))
+        return;
+
+    if (cap->nr_deps == cap->sz_deps) {
+        size_t sz = cap->sz_deps ? cap->sz_deps * 2 : 4;
+        struct reactive_dep *deps = realloc(cap->deps, sizeof(*deps) * sz);
+        if (deps == NULL) {
+            cap->failed = true;
+            return;
+        }
+        cap->deps = deps;
+        cap->sz_deps = sz;
+    }
+
+    struct reactive_dep *dep = cap->deps + cap->nr_deps;
+    dep->name = strdup(name);
+    if (dep->name == NULL) {
+        cap->failed = true;
+        return;
+    }
+    dep->val = purc_variant_ref(val);
+    dep->listener = NULL;
+    cap->nr_deps++;
+}
+
+static purc_variant_t
+capture_var(void *ctxt, const char *name)
+{
+    struct capture *cap = (struct capture *)ctxt;
+    purc_variant_t val;
+
+    if (cap->stack) {
+        val = pcvcm_find_stack_var(cap->stack, name);
+    }
+    else {
+        /* no stack frame to find other variables when refreshing */
+        struct pcintr_binding *binding = cap->binding;
+        struct reactive_dep *dep;
+        dep = find_dep(binding->deps, binding->nr_deps, name);
+        if (dep == NULL) {
+            purc_set_error(PCVARIANT_ERROR_NOT_FOUND);
+            return PURC_VARIANT_INVALID;
+        }
+        val = dep->val;
+    }
+
+    if (val) {
+        record_dep(cap, name, val);
+    }
+    return val;
+}
+
+static void
+flush_bindings(void *ctxt);
+
+static bool
+dep_changed(purc_variant_t source, pcvar_op_t op, void *ctxt,
+        size_t nr_args, purc_variant_t *argv)
+{
+    UNUSED_PARAM(source);
+    UNUSED_PARAM(op);
+    UNUSED_PARAM(nr_args);
+    UNUSED_PARAM(argv);
+
+    struct pcintr_binding *binding = (struct pcintr_binding *)ctxt;
+    binding->dirty = true;
+
+    struct pcintr_reactive *reactive = binding->reactive;
+    if (!reactive->flush_scheduled) {
+        reactive->flush_scheduled = true;
+        purc_runloop_dispatch(purc_runloop_get_current(), flush_bindings,
+                (void *)(uintptr_t)reactive->cid);
+    }
+    return true;
+}
+
+/* replaces the variables read by @binding with the ones of @cap */
+static void
+update_deps(struct pcintr_binding *binding, struct capture *cap)
+{
+    for (size_t i = 0; i < cap->nr_deps; i++) {
+        struct reactive_dep *dep = cap->deps + i;
+        if (pcvariant_is_mutable(dep->val)) {
+            dep->listener = purc_variant_register_post_listener(dep->val,
+                    OPS_LISTENED, dep_changed, binding);
+        }
+    }
+
+    clear_deps(binding->deps, binding->nr_deps);
+    binding->deps = cap->deps;
+    binding->nr_deps = cap->nr_deps;
+    cap->deps = NULL;
+    cap->nr_deps = 0;
+}
+
+static void
+destroy_binding(struct pcintr_binding *binding)
+{
+    list_del(&binding->node);
+    clear_deps(binding->deps, binding->nr_deps);
+    free(binding->contents);
+    free(binding->selector);
+    free(binding);
+}
+
+struct pcintr_binding *
+pcintr_reactive_bind(pcintr_stack_t stack, const char *elem_id,
+        bool silently)
+{
+    struct pcintr_reactive *reactive = stack->reactive;
+    if (reactive == NULL) {
+        reactive = calloc(1, sizeof(*reactive));
+        if (reactive == NULL)
+            goto failed;
+
+        reactive->cid = stack->co->cid;
+        INIT_LIST_HEAD(&reactive->bindings);
+        stack->reactive = reactive;
+    }
+
+    struct pcintr_binding *binding = calloc(1, sizeof(*binding));
+    if (binding == NULL)
+        goto failed;
+
+    size_t len = strlen(elem_id);
+    binding->selector = malloc(len + 2);
+    if (binding->selector == NULL) {
+        free(binding);
+        goto failed;
+    }
+    binding->selector[0] = '#';
+    memcpy(binding->selector + 1, elem_id, len + 1);
+
+    binding->reactive = reactive;
+    binding->silently = silently;
+    list_add_tail(&binding->node, &reactive->bindings);
+    return binding;
+
+failed:
+    purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    return NULL;
+}
+
+purc_variant_t
+pcintr_reactive_eval(pcintr_stack_t stack, struct pcintr_binding *binding,
+        struct pcvcm_node *vcm)
+{
+    struct pcvcm_node **contents = realloc(binding->contents,
+            sizeof(*contents) * (binding->nr_contents + 1));
+    if (contents == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return PURC_VARIANT_INVALID;
+    }
+    contents[binding->nr_contents++] = vcm;
+    binding->contents = contents;
+
+    /* keep the variables read by the former contents */
+    struct capture cap = { stack, binding, NULL, 0, 0, false };
+    for (size_t i = 0; i < binding->nr_deps; i++) {
+        record_dep(&cap, binding->deps[i].name, binding->deps[i].val);
+    }
+
+    purc_variant_t v = pcvcm_eval_ex(vcm, capture_var, &cap,
+            binding->silently);
+    if (!cap.failed) {
+        update_deps(binding, &cap);
+    }
+    clear_deps(cap.deps, cap.nr_deps);
+    return v;
+}
+
+static int
+append_value(struct pcutils_printbuf *pb, purc_variant_t v)
+{
+    int r;
+    if (purc_variant_is_string(v)) {
+        size_t sz;
+        const char *s = purc_variant_get_string_const_ex(v, &sz);
+        r = pcutils_printbuf_memappend(pb, s, (int)sz);
+    }
+    else {
+        char *s = pcvariant_to_string(v);
+        if (s == NULL)
+            return -1;
+        r = pcutils_printbuf_memappend(pb, s, (int)strlen(s));
+        free(s);
+    }
+    return r < 0 ? -1 : 0;
+}
+
+/* evaluates the contents again; returns false if the element is gone */
+static bool
+refresh_binding(pcintr_stack_t stack, struct pcintr_binding *binding)
+{
+    binding->dirty = false;
+
+    pcdoc_element_t elem;
+    elem = pcdoc_find_element_in_document(stack->doc, binding->selector);
+    if (elem == NULL)
+        return false;
+
+    struct pcutils_printbuf pb;
+    if (pcutils_printbuf_init(&pb))
+        return true;
+
+    struct capture cap = { NULL, binding, NULL, 0, 0, false };
+    for (size_t i = 0; i < binding->nr_contents; i++) {
+        purc_variant_t v = pcvcm_eval_ex(binding->contents[i], capture_var,
+                &cap, binding->silently);
+        if (v == PURC_VARIANT_INVALID) {
+            cap.failed = true;
+            break;
+        }
+
+        int r = append_value(&pb, v);
+        purc_variant_unref(v);
+        if (r) {
+            cap.failed = true;
+            break;
+        }
+    }
+
+    /* keep the content and the variables if failed */
+    if (!cap.failed) {
+        pcintr_util_new_text_content(stack->doc, elem, PCDOC_OP_DISPLACE,
+                pb.buf ? pb.buf : "", pcutils_printbuf_length(&pb));
+        update_deps(binding, &cap);
+    }
+
+    clear_deps(cap.deps, cap.nr_deps);
+    free(pb.buf);
+    purc_clr_error();
+    return true;
+}
+
+static void
+flush_bindings(void *ctxt)
+{
+    purc_atom_t cid = (purc_atom_t)(uintptr_t)ctxt;
+    pcintr_coroutine_t co = pcintr_coroutine_get_by_id(cid);
+    if (co == NULL || co->stack.reactive == NULL)
+        return;
+
+    pcintr_stack_t stack = &co->stack;
+    struct pcintr_reactive *reactive = stack->reactive;
+    reactive->flush_scheduled = false;
+
+    /* the changes are sent to the renderer by the current coroutine */
+    pcintr_coroutine_t curr = pcintr_get_coroutine();
+    pcintr_set_current_co(co);
+
+    struct pcintr_binding *p, *n;
+    list_for_each_entry_safe(p, n, &reactive->bindings, node) {
+        if (p->dirty && !refresh_binding(stack, p)) {
+            destroy_binding(p);
+        }
+    }
+
+    pcintr_set_current_co(curr);
+}
+
+void
+pcintr_reactive_cleanup(pcintr_stack_t stack)
+{
+    struct pcintr_reactive *reactive = stack->reactive;
+    if (reactive == NULL)
+        return;
+
+    struct pcintr_binding *p, *n;
+    list_for_each_entry_safe(p, n, &reactive->bindings, node) {
+        destroy_binding(p);
+    }
+
+    free(reactive);
+    stack->reactive = NULL;
+}
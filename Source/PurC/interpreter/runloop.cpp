@@ -31,7 +31,9 @@
 #include "private/interpreter.h"
 #include "private/instance.h"
 #include "private/runners.h"
+#include "private/affinity.h"
 #include "private/sorted-array.h"
+#include "private/list.h"
 #include "internal.h"
 
 #include <wtf/Threading.h>
@@ -100,6 +102,15 @@ void purc_runloop_set_idle_func(purc_runloop_t runloop, purc_runloop_func func,
     }
 }
 
+void purc_runloop_park_idle_func(purc_runloop_t runloop, long timeout_ms)
+{
+    if (runloop) {
+        ((RunLoop*)runloop)->parkIdleCallback(timeout_ms < 0 ?
+                PurCWTF::Seconds(-1) :
+                PurCWTF::Seconds::fromMilliseconds(timeout_ms));
+    }
+}
+
 static purc_runloop_io_event
 to_runloop_io_event(GIOCondition condition)
 {
@@ -150,18 +161,31 @@ to_gio_condition(purc_runloop_io_event event)
     return (GIOCondition)condition;
 }
 
+static struct pcintr_fdmon *get_fdmon(purc_runloop_t runloop)
+{
+    struct pcinst *inst = pcinst_current();
+    if (inst && inst->intr_heap && inst->running_loop == runloop) {
+        return inst->intr_heap->fdmon;
+    }
+    return NULL;
+}
+
 uintptr_t purc_runloop_add_fd_monitor(purc_runloop_t runloop, int fd,
         purc_runloop_io_event event, purc_runloop_io_callback callback,
         void *ctxt)
 {
-    pcintr_coroutine_t co = pcintr_get_coroutine();
-    PC_ASSERT(co);
-    PC_ASSERT(pcintr_get_runloop() == runloop);
+    PC_ASSERT(pcinst_current() &&
+            pcinst_current()->running_loop == runloop);
+
+    struct pcintr_fdmon *fdmon = get_fdmon(runloop);
+    if (fdmon) {
+        return pcintr_fdmon_add(fdmon, fd, event, callback, ctxt);
+    }
 
     RunLoop *runLoop = (RunLoop*)runloop;
 
     return runLoop->addFdMonitor(fd, to_gio_condition(event),
-            [callback, ctxt, runLoop, co] (gint fd, GIOCondition condition) -> gboolean {
+            [callback, ctxt] (gint fd, GIOCondition condition) -> gboolean {
             PC_ASSERT(pcintr_get_runloop()==nullptr);
             purc_runloop_io_event io_event;
             io_event = to_runloop_io_event(condition);
@@ -175,62 +199,274 @@ void purc_runloop_remove_fd_monitor(purc_runloop_t runloop, uintptr_t handle)
     if (!runloop) {
         runloop = purc_runloop_get_current();
     }
+
+    if (handle & PCINTR_FDMON_HANDLE_TAG) {
+        /* all monitors have gone if the fdmon has been destroyed */
+        struct pcintr_fdmon *fdmon = get_fdmon(runloop);
+        if (fdmon) {
+            pcintr_fdmon_remove(fdmon, handle);
+        }
+        return;
+    }
+
     ((RunLoop*)runloop)->removeFdMonitor(handle);
 }
 
-extern "C" purc_atom_t
-pcrun_create_inst_thread(const char *app_name, const char *runner_name,
-        purc_cond_handler cond_handler,
-        struct purc_instance_extra_info *extra_info, void **th)
+uintptr_t pcintr_add_wakeup_fd_monitor(purc_runloop_t runloop, int fd)
 {
-    purc_atom_t atom = 0;
-    BinarySemaphore semaphore;
+    RunLoop *runLoop = (RunLoop*)runloop;
 
-    RefPtr<Thread> inst_th =
-        Thread::create("hvml-instance", [&] {
-                int ret = purc_init_ex(PURC_MODULE_HVML,
-                        app_name, runner_name, extra_info);
+    /* the monitor does nothing but waking up the parked scheduler */
+    return runLoop->addFdMonitor(fd, G_IO_IN,
+            [] (gint fd, GIOCondition condition) -> gboolean {
+            UNUSED_PARAM(fd);
+            UNUSED_PARAM(condition);
+            return true;
+        });
+}
 
-                if (ret != PURC_ERROR_OK) {
-                    semaphore.signal();
-                }
-                else {
-                    struct pcinst *inst = pcinst_current();
-                    assert(inst && inst->intr_heap);
-                    purc_atom_t my_atom;
-                    atom = my_atom = inst->intr_heap->move_buff;
+/*
+   The threads of the instances are pooled: a thread parked in the pool is
+   handed out to the next instance created by the instance manager, which
+   saves creating the thread and its run loop. An instance is bound to its
+   endpoint name from the start of purc_init_ex(), so the instance itself
+   is initialized after the thread is handed out, and cleaned up before
+   the thread is parked again.
+ */
+struct inst_job {
+    const char                         *app_name;
+    const char                         *runner_name;
+    purc_cond_handler                   cond_handler;
+    struct purc_instance_extra_info    *extra_info;
+
+    /* the results */
+    purc_atom_t                         atom;
+    void                               *th;
+    BinarySemaphore                     done;
+};
+
+/* a plain structure for list_entry(); the semaphore is on the stack */
+struct idle_thread {
+    struct list_head                    ln;
+    BinarySemaphore                    *wakeup;
+    struct inst_job                    *job;    /* NULL to quit */
+};
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static LIST_HEAD(idle_threads);
+static struct purc_inst_pool_stat pool_stat;
+static size_t pool_max_idle;
+static size_t pool_nr_spawning;
+static bool pool_recycle;
+
+/* returns false if the instance failed to initialize */
+static bool run_inst_job(struct inst_job *job)
+{
+    /* the job is gone after the semaphore is signaled */
+    purc_instance_extra_info *extra_info = job->extra_info;
+
+    /* bind the thread before making the heaps of the instance */
+    if (extra_info && (extra_info->cpu_affinity || extra_info->numa_nodes) &&
+            pcutils_bind_thread(extra_info->cpu_affinity,
+                extra_info->numa_nodes)) {
+        purc_log_warn("Failed to bind the thread of %s/%s to CPUs %s, "
+                "nodes %s\n", job->app_name, job->runner_name,
+                extra_info->cpu_affinity ? extra_info->cpu_affinity : "-",
+                extra_info->numa_nodes ? extra_info->numa_nodes : "-");
+    }
+
+    int ret = purc_init_ex(PURC_MODULE_HVML,
+            job->app_name, job->runner_name, extra_info);
+    if (ret != PURC_ERROR_OK) {
+        pcutils_unbind_thread();
+        job->done.signal();
+        return false;
+    }
+
+    struct pcinst *inst = pcinst_current();
+    assert(inst && inst->intr_heap);
+    purc_atom_t my_atom;
+    job->atom = my_atom = inst->intr_heap->move_buff;
 
-                    purc_cond_handler my_handler = cond_handler;
+    purc_cond_handler my_handler = job->cond_handler;
 
 #if USE(PTHREADS)
-                    pthread_t *my_th = (pthread_t *)malloc(sizeof(pthread_t));
-                    *my_th = pthread_self();
-                    *th = (void *)my_th;
+    pthread_t *my_th = (pthread_t *)malloc(sizeof(pthread_t));
+    *my_th = pthread_self();
+    job->th = (void *)my_th;
 #else
 #error "Need code when not using PThreads"
 #endif
-                    if (cond_handler) {
-                        cond_handler(PURC_COND_STARTED,
-                                (void *)(uintptr_t)atom, extra_info);
-                    }
-                    semaphore.signal();
-
-                    purc_run(my_handler);
-
-                    pcrun_notify_instmgr(PCRUN_EVENT_inst_stopped, my_atom);
-                    if ((my_handler = inst->intr_heap->cond_handler)) {
-                        my_handler(PURC_COND_STOPPED,
-                                (void *)(uintptr_t)my_atom, NULL);
-                    }
-
-                    purc_cleanup();
-                }
-            });
+    if (my_handler) {
+        my_handler(PURC_COND_STARTED, (void *)(uintptr_t)my_atom, extra_info);
+    }
+    job->done.signal();
 
-    inst_th->detach();
-    semaphore.wait();
+    purc_run(my_handler);
+
+    pcrun_notify_instmgr(PCRUN_EVENT_inst_stopped, my_atom);
+    if ((my_handler = inst->intr_heap->cond_handler)) {
+        my_handler(PURC_COND_STOPPED, (void *)(uintptr_t)my_atom, NULL);
+    }
+
+    purc_cleanup();
+
+    /* the thread may be handed out to another instance */
+    pcutils_unbind_thread();
+    return true;
+}
+
+/* parks the thread in the pool; returns the next job or NULL to quit */
+static struct inst_job *park_thread(struct idle_thread *self, bool spawned)
+{
+    pthread_mutex_lock(&pool_lock);
+    if (spawned)
+        pool_nr_spawning--;
+
+    if ((!spawned && !pool_recycle) || pool_stat.nr_idle >= pool_max_idle) {
+        pthread_mutex_unlock(&pool_lock);
+        return NULL;
+    }
 
-    return atom;
+    self->job = NULL;
+    list_add_tail(&self->ln, &idle_threads);
+    pool_stat.nr_idle++;
+    if (!spawned)
+        pool_stat.nr_recycled++;
+    pthread_mutex_unlock(&pool_lock);
+
+    self->wakeup->wait();
+    return self->job;
+}
+
+static struct idle_thread *take_idle_thread(void)
+{
+    struct idle_thread *idle = NULL;
+
+    pthread_mutex_lock(&pool_lock);
+    if (!list_empty(&idle_threads)) {
+        idle = list_first_entry(&idle_threads, struct idle_thread, ln);
+        list_del(&idle->ln);
+        pool_stat.nr_idle--;
+        pool_stat.nr_reused++;
+    }
+    pthread_mutex_unlock(&pool_lock);
+
+    return idle;
+}
+
+/* @job is NULL for a thread spawned to wait in the pool */
+static void inst_thread_main(struct inst_job *job)
+{
+    BinarySemaphore wakeup;
+    struct idle_thread self;
+    self.wakeup = &wakeup;
+    bool spawned = (job == NULL);
+
+    if (spawned) {
+        /* make the run loop of the thread before it is needed */
+        RunLoop::current();
+    }
+    else if (!run_inst_job(job)) {
+        return;
+    }
+
+    while ((job = park_thread(&self, spawned))) {
+        spawned = false;
+        if (!run_inst_job(job))
+            break;
+    }
+}
+
+extern "C" purc_atom_t
+pcrun_create_inst_thread(const char *app_name, const char *runner_name,
+        purc_cond_handler cond_handler,
+        struct purc_instance_extra_info *extra_info, void **th)
+{
+    struct inst_job job;
+    job.app_name = app_name;
+    job.runner_name = runner_name;
+    job.cond_handler = cond_handler;
+    job.extra_info = extra_info;
+    job.atom = 0;
+    job.th = NULL;
+
+    struct idle_thread *idle = take_idle_thread();
+    if (idle) {
+        idle->job = &job;
+        idle->wakeup->signal();
+    }
+    else {
+        RefPtr<Thread> inst_th =
+            Thread::create("hvml-instance", [&job] {
+                    inst_thread_main(&job);
+                });
+        inst_th->detach();
+    }
+
+    job.done.wait();
+
+    *th = job.th;
+    return job.atom;
+}
+
+extern "C" void
+pcrun_fill_inst_pool(void)
+{
+    pthread_mutex_lock(&pool_lock);
+    bool need = (pool_stat.nr_idle + pool_nr_spawning < pool_max_idle);
+    if (need) {
+        pool_nr_spawning++;
+        pool_stat.nr_spawned++;
+    }
+    pthread_mutex_unlock(&pool_lock);
+
+    if (need) {
+        RefPtr<Thread> inst_th =
+            Thread::create("hvml-instance", [] {
+                    inst_thread_main(NULL);
+                });
+        inst_th->detach();
+    }
+}
+
+int purc_inst_set_pool(size_t nr_idle, bool recycle)
+{
+    LIST_HEAD(quitting);
+
+    pthread_mutex_lock(&pool_lock);
+    pool_max_idle = nr_idle;
+    pool_recycle = recycle;
+    while (pool_stat.nr_idle > nr_idle) {
+        struct idle_thread *idle;
+        idle = list_last_entry(&idle_threads, struct idle_thread, ln);
+        list_move(&idle->ln, &quitting);
+        pool_stat.nr_idle--;
+    }
+    pthread_mutex_unlock(&pool_lock);
+
+    struct idle_thread *p, *n;
+    list_for_each_entry_safe(p, n, &quitting, ln) {
+        list_del(&p->ln);
+        p->job = NULL;
+        p->wakeup->signal();
+    }
+
+    /* the threads are spawned by the instance manager when it is idle */
+    return 0;
+}
+
+int purc_inst_get_pool_stat(struct purc_inst_pool_stat *stat)
+{
+    if (stat == NULL) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return -1;
+    }
+
+    pthread_mutex_lock(&pool_lock);
+    *stat = pool_stat;
+    pthread_mutex_unlock(&pool_lock);
+    return 0;
 }
 
 static void my_sa_free(void *sortv, void *data)
@@ -335,8 +571,10 @@ static void _cleanup_instance(struct pcinst* curr_inst)
 }
 
 struct pcmodule _module_runloop = {
+    .name            = "runloop",
     .id              = PURC_HAVE_HVML,
     .module_inited   = 0,
+    .on_demand       = false,
 
     .init_once              = _init_once,
     .init_instance          = _init_instance,
@@ -0,0 +1,559 @@
+/*
+ * @file runner-pool.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The implementation of purc_runner_pool_xxx APIs.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "purc.h"
+#include "private/runners.h"
+#include "private/affinity.h"
+#include "private/instance.h"
+#include "private/interpreter.h"
+#include "private/variant.h"
+#include "private/list.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <unistd.h>
+
+/*
+   A job is a vDOM scheduled to the pool but not turned into a coroutine yet.
+   The request variant of a job lives in the move heap until a worker
+   takes the job, so any worker can steal it.
+ */
+struct pool_job {
+    struct list_head    ln;
+    purc_vdom_t         vdom;
+    purc_variant_t      request;    // in the move heap
+    char               *body_id;
+    void               *user_data;
+};
+
+struct pool_worker {
+    purc_atom_t         rid;
+    /* the run loop of the worker; NULL if not attached or gone */
+    purc_runloop_t      runloop;
+
+    struct list_head    jobs;
+    size_t              nr_jobs;
+    size_t              nr_run;
+    size_t              nr_stolen;
+    size_t              nr_stolen_remote;
+
+    /* the NUMA node the worker runs on, got when it is attached */
+    int                 node;
+
+    /* the worker found nothing to do at the last time; cleared when
+       a job is queued to it. */
+    bool                idle;
+};
+
+struct purc_runner_pool {
+    purc_mutex          lock;
+
+    /* one for the creator, one for every attached worker */
+    unsigned            refc;
+    bool                closed;
+
+    size_t              next;       // the hint to search for an idle worker
+    size_t              nr_workers;
+    struct pool_worker  workers[0];
+};
+
+static void release_job(struct pool_job *job)
+{
+    if (job->request) {
+        pcvariant_use_move_heap();
+        purc_variant_unref(job->request);
+        pcvariant_use_norm_heap();
+    }
+
+    if (job->body_id)
+        free(job->body_id);
+    free(job);
+}
+
+static void release_pool(struct purc_runner_pool *pool)
+{
+    purc_mutex_lock(&pool->lock);
+    unsigned refc = --pool->refc;
+    purc_mutex_unlock(&pool->lock);
+
+    if (refc == 0) {
+        purc_mutex_clear(&pool->lock);
+        free(pool);
+    }
+}
+
+/* must be called with the pool locked */
+static struct pool_job *
+take_job(struct purc_runner_pool *pool, size_t slot, bool *stolen)
+{
+    struct pool_worker *self = pool->workers + slot;
+    struct pool_job *job;
+
+    *stolen = false;
+    if (self->nr_jobs > 0) {
+        job = list_first_entry(&self->jobs, struct pool_job, ln);
+        list_del(&job->ln);
+        self->nr_jobs--;
+        return job;
+    }
+
+    /* steal the newest job of the busiest worker, on the same node if
+       possible to keep off the traffic between the nodes; the gone workers
+       are victims as well, so their pending jobs will not be lost. */
+    struct pool_worker *victim = NULL, *local = NULL;
+    for (size_t i = 0; i < pool->nr_workers; i++) {
+        struct pool_worker *w = pool->workers + i;
+        if (w == self || w->nr_jobs == 0)
+            continue;
+
+        if (victim == NULL || w->nr_jobs > victim->nr_jobs)
+            victim = w;
+        if (w->node == self->node &&
+                (local == NULL || w->nr_jobs > local->nr_jobs))
+            local = w;
+    }
+
+    if (local)
+        victim = local;
+    else if (victim == NULL)
+        return NULL;
+    else
+        self->nr_stolen_remote++;
+
+    job = list_last_entry(&victim->jobs, struct pool_job, ln);
+    list_del(&job->ln);
+    victim->nr_jobs--;
+    *stolen = true;
+    return job;
+}
+
+/* must be called with the pool locked */
+static struct pool_worker *
+choose_worker(struct purc_runner_pool *pool)
+{
+    struct pool_worker *chosen = NULL;
+
+    for (size_t i = 0; i < pool->nr_workers; i++) {
+        size_t idx = (pool->next + i) % pool->nr_workers;
+        struct pool_worker *w = pool->workers + idx;
+        if (w->runloop == NULL)
+            continue;
+
+        if (w->idle && w->nr_jobs == 0) {
+            pool->next = idx + 1;
+            return w;
+        }
+
+        if (chosen == NULL || w->nr_jobs < chosen->nr_jobs)
+            chosen = w;
+    }
+
+    return chosen;
+}
+
+bool
+pcrun_runner_pool_schedule_next(struct pcinst *inst)
+{
+    struct pcintr_heap *heap = inst->intr_heap;
+    struct purc_runner_pool *pool = heap->runner_pool;
+    struct pool_job *job = NULL;
+    bool stolen;
+
+    if (pool == NULL)
+        return false;
+
+    purc_mutex_lock(&pool->lock);
+    if (!pool->closed) {
+        struct pool_worker *self = pool->workers + heap->pool_slot;
+        job = take_job(pool, heap->pool_slot, &stolen);
+        if (job) {
+            self->idle = false;
+            self->nr_run++;
+            if (stolen)
+                self->nr_stolen++;
+        }
+        else {
+            self->idle = true;
+        }
+    }
+    purc_mutex_unlock(&pool->lock);
+
+    if (job == NULL)
+        return false;
+
+    purc_variant_t request = PURC_VARIANT_INVALID;
+    if (job->request) {
+        request = pcvariant_move_heap_out(job->request);
+        job->request = PURC_VARIANT_INVALID;
+    }
+
+    purc_coroutine_t cor = purc_schedule_vdom(job->vdom, 0, request,
+            PCRDR_PAGE_TYPE_NULL, NULL, NULL, NULL, NULL, job->body_id,
+            job->user_data);
+    if (cor == NULL) {
+        purc_log_error("Failed to schedule a job of runner pool: %s\n",
+                purc_get_error_message(purc_get_last_error()));
+    }
+
+    if (request)
+        purc_variant_unref(request);
+    release_job(job);
+    return true;
+}
+
+void
+pcrun_attach_runner_pool(const pcrdr_msg *msg, pcrdr_msg *response)
+{
+    struct pcinst *inst = pcinst_current();
+    assert(inst && inst->intr_heap);
+
+    if (!purc_variant_is_object(msg->data) ||
+            inst->intr_heap->runner_pool != NULL) {
+        return;
+    }
+
+    purc_variant_t tmp;
+    uint64_t u64;
+
+    struct purc_runner_pool *pool = NULL;
+    tmp = purc_variant_object_get_by_ckey(msg->data, "pool");
+    if (tmp && purc_variant_cast_to_ulongint(tmp, &u64, false)) {
+        pool = (struct purc_runner_pool *)(uintptr_t)u64;
+    }
+
+    size_t slot = 0;
+    tmp = purc_variant_object_get_by_ckey(msg->data, "slot");
+    if (tmp && purc_variant_cast_to_ulongint(tmp, &u64, false)) {
+        slot = (size_t)u64;
+    }
+
+    if (pool == NULL || slot >= pool->nr_workers)
+        return;
+
+    purc_mutex_lock(&pool->lock);
+    pool->workers[slot].runloop = inst->running_loop;
+    pool->workers[slot].node = pcutils_current_node();
+    pool->workers[slot].idle = true;
+    pool->refc++;
+    purc_mutex_unlock(&pool->lock);
+
+    inst->intr_heap->runner_pool = pool;
+    inst->intr_heap->pool_slot = slot;
+    /* wait for the jobs until asked to shut down, even with no coroutine */
+    inst->intr_heap->keep_alive = 1;
+
+    response->type = PCRDR_MSG_TYPE_RESPONSE;
+    response->requestId = purc_variant_ref(msg->requestId);
+    response->sourceURI = purc_variant_make_string(purc_get_endpoint(NULL),
+            false);
+    response->retCode = PCRDR_SC_OK;
+    response->resultValue = 0;
+    response->dataType = PCRDR_MSG_DATA_TYPE_VOID;
+    response->data = PURC_VARIANT_INVALID;
+}
+
+void
+pcrun_detach_runner_pool(struct pcinst *inst)
+{
+    struct pcintr_heap *heap = inst->intr_heap;
+    struct purc_runner_pool *pool = heap->runner_pool;
+
+    if (pool == NULL)
+        return;
+
+    /* the pending jobs are left in the queue to be stolen by others */
+    purc_mutex_lock(&pool->lock);
+    pool->workers[heap->pool_slot].runloop = NULL;
+    pool->workers[heap->pool_slot].rid = 0;
+    purc_mutex_unlock(&pool->lock);
+
+    heap->runner_pool = NULL;
+    release_pool(pool);
+}
+
+static int
+attach_worker(struct purc_runner_pool *pool, size_t slot)
+{
+    purc_atom_t rid = pool->workers[slot].rid;
+
+    pcrdr_msg *request_msg = pcrdr_make_request_message(
+            PCRDR_MSG_TARGET_INSTANCE, rid,
+            PCRUN_OPERATION_attachRunnerPool, NULL,
+            purc_get_endpoint(NULL),
+            PCRDR_MSG_ELEMENT_TYPE_VOID, NULL,
+            NULL,
+            PCRDR_MSG_DATA_TYPE_VOID, NULL, 0);
+
+    purc_variant_t data, tmp;
+    data = purc_variant_make_object_0();
+
+    tmp = purc_variant_make_ulongint((uint64_t)(uintptr_t)pool);
+    purc_variant_object_set_by_static_ckey(data, "pool", tmp);
+    purc_variant_unref(tmp);
+
+    tmp = purc_variant_make_ulongint((uint64_t)slot);
+    purc_variant_object_set_by_static_ckey(data, "slot", tmp);
+    purc_variant_unref(tmp);
+
+    request_msg->dataType = PCRDR_MSG_DATA_TYPE_JSON;
+    request_msg->data = data;
+
+    purc_variant_t request_id = purc_variant_ref(request_msg->requestId);
+    size_t n = purc_inst_move_message(rid, request_msg);
+    pcrdr_release_message(request_msg);
+    if (n == 0) {
+        purc_variant_unref(request_id);
+        purc_log_warn("Failed to send request message\n");
+        return -1;
+    }
+
+    struct pcrdr_conn *conn = purc_get_conn_to_renderer();
+    assert(conn);
+
+    pcrdr_msg *response = NULL;
+    int ret = pcrdr_wait_response_for_specific_request(conn,
+            request_id, PCRUN_TIMEOUT_DEF, &response);
+    purc_variant_unref(request_id);
+
+    int retv = -1;
+    if (ret || response == NULL) {
+        purc_log_error("Failed to wait response: %s\n",
+               purc_get_error_message(purc_get_last_error()));
+    }
+    else if (response->retCode != PCRDR_SC_OK) {
+        purc_log_error("Failed to attach worker to runner pool: %d\n",
+                response->retCode);
+    }
+    else {
+        retv = 0;
+    }
+
+    if (response)
+        pcrdr_release_message(response);
+    return retv;
+}
+
+purc_runner_pool_t
+purc_runner_pool_create(const char *app_name, const char *runner_prefix,
+        size_t nr_workers, purc_cond_handler cond_handler,
+        const purc_instance_extra_info* extra_info)
+{
+    struct pcinst *inst = pcinst_current();
+    if (inst == NULL || inst->intr_heap == NULL) {
+        purc_set_error(PURC_ERROR_NO_INSTANCE);
+        return NULL;
+    }
+
+    if (runner_prefix == NULL ||
+            strlen(runner_prefix) + 10 > PURC_LEN_RUNNER_NAME) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return NULL;
+    }
+
+    if (nr_workers == 0) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        nr_workers = (n > 0) ? (size_t)n : 1;
+    }
+
+    struct purc_runner_pool *pool;
+    pool = calloc(1, sizeof(*pool) + sizeof(struct pool_worker) * nr_workers);
+    if (pool == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    purc_mutex_init(&pool->lock);
+    pool->refc = 1;
+    pool->nr_workers = nr_workers;
+    for (size_t i = 0; i < nr_workers; i++) {
+        INIT_LIST_HEAD(&pool->workers[i].jobs);
+    }
+
+    /* place the workers on the nodes in turn */
+    int nodes[PCUTILS_MAX_CPU_LIST];
+    unsigned nr_nodes = 0;
+    purc_instance_extra_info worker_info;
+    if (extra_info && extra_info->numa_nodes) {
+        nr_nodes = pcutils_parse_cpu_list(extra_info->numa_nodes, nodes,
+                PCUTILS_MAX_CPU_LIST);
+        worker_info = *extra_info;
+    }
+
+    for (size_t i = 0; i < nr_workers; i++) {
+        char runner_name[PURC_LEN_RUNNER_NAME + 1];
+        snprintf(runner_name, sizeof(runner_name), "%s%u",
+                runner_prefix, (unsigned)i);
+
+        char node[16];
+        const purc_instance_extra_info *info = extra_info;
+        if (nr_nodes > 1) {
+            snprintf(node, sizeof(node), "%d", nodes[i % nr_nodes]);
+            worker_info.numa_nodes = node;
+            info = &worker_info;
+        }
+
+        /* invalid names will be checked by purc_inst_create_or_get() */
+        purc_atom_t rid = purc_inst_create_or_get(app_name, runner_name,
+                cond_handler, info);
+        if (rid == 0)
+            goto failed;
+
+        pool->workers[i].rid = rid;
+        if (attach_worker(pool, i))
+            goto failed;
+    }
+
+    return pool;
+
+failed:
+    purc_runner_pool_destroy(pool);
+    return NULL;
+}
+
+int
+purc_runner_pool_schedule_vdom(purc_runner_pool_t pool, purc_vdom_t vdom,
+        purc_variant_t request, const char *entry)
+{
+    return purc_runner_pool_schedule_vdom_ex(pool, vdom, request, entry,
+            NULL);
+}
+
+int
+purc_runner_pool_schedule_vdom_ex(purc_runner_pool_t pool, purc_vdom_t vdom,
+        purc_variant_t request, const char *entry, void *user_data)
+{
+    if (pool == NULL || vdom == NULL || pcinst_current() == NULL) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return -1;
+    }
+
+    struct pool_job *job = calloc(1, sizeof(*job));
+    if (job == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    job->vdom = vdom;
+    job->user_data = user_data;
+    if (entry && (job->body_id = strdup(entry)) == NULL) {
+        free(job);
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    if (request) {
+        /* pcvariant_move_heap_in() takes over the reference */
+        job->request = pcvariant_move_heap_in(purc_variant_ref(request));
+        if (job->request == PURC_VARIANT_INVALID) {
+            release_job(job);
+            return -1;
+        }
+    }
+
+    int retv = -1;
+    purc_mutex_lock(&pool->lock);
+    struct pool_worker *worker = pool->closed ? NULL : choose_worker(pool);
+    if (worker) {
+        list_add_tail(&job->ln, &worker->jobs);
+        worker->nr_jobs++;
+        worker->idle = false;
+        /* waking up under the lock, so the worker can not detach in between */
+        purc_runloop_wakeup(worker->runloop);
+        retv = 0;
+    }
+    purc_mutex_unlock(&pool->lock);
+
+    if (retv) {
+        release_job(job);
+        purc_set_error(PURC_ERROR_NO_INSTANCE);
+    }
+
+    return retv;
+}
+
+size_t
+purc_runner_pool_nr_workers(purc_runner_pool_t pool)
+{
+    return pool->nr_workers;
+}
+
+int
+purc_runner_pool_get_stat(purc_runner_pool_t pool, size_t idx,
+        struct purc_runner_pool_stat *stat)
+{
+    if (idx >= pool->nr_workers) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return -1;
+    }
+
+    purc_mutex_lock(&pool->lock);
+    stat->rid = pool->workers[idx].rid;
+    stat->nr_pending = pool->workers[idx].nr_jobs;
+    stat->nr_run = pool->workers[idx].nr_run;
+    stat->nr_stolen = pool->workers[idx].nr_stolen;
+    stat->nr_stolen_remote = pool->workers[idx].nr_stolen_remote;
+    stat->node = pool->workers[idx].node;
+    purc_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+int
+purc_runner_pool_destroy(purc_runner_pool_t pool)
+{
+    if (pool == NULL) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return -1;
+    }
+
+    LIST_HEAD(jobs);
+    purc_atom_t rids[pool->nr_workers];
+
+    purc_mutex_lock(&pool->lock);
+    pool->closed = true;
+    for (size_t i = 0; i < pool->nr_workers; i++) {
+        struct pool_worker *w = pool->workers + i;
+        list_splice_tail_init(&w->jobs, &jobs);
+        w->nr_jobs = 0;
+        rids[i] = w->rid;
+    }
+    purc_mutex_unlock(&pool->lock);
+
+    struct list_head *p, *n;
+    list_for_each_safe(p, n, &jobs) {
+        struct pool_job *job = list_entry(p, struct pool_job, ln);
+        list_del(p);
+        release_job(job);
+    }
+
+    for (size_t i = 0; i < pool->nr_workers; i++) {
+        if (rids[i])
+            purc_inst_ask_to_shutdown(rids[i]);
+    }
+
+    release_pool(pool);
+    return 0;
+}
+
@@ -29,6 +29,7 @@
 #include "purc.h"
 #include "private/runners.h"
 #include "private/instance.h"
+#include "private/metrics.h"
 #include "private/sorted-array.h"
 #include "private/ports.h"
 
@@ -281,6 +282,9 @@ void pcrun_request_handler(pcrdr_conn* conn, const pcrdr_msg *msg)
         else if (strcmp(op, PCRUN_OPERATION_shutdownInstance) == 0) {
             shutdown_instance(requester, msg, response);
         }
+        else if (strcmp(op, PCRUN_OPERATION_attachRunnerPool) == 0) {
+            pcrun_attach_runner_pool(msg, response);
+        }
         else {
             struct pcinst *inst = pcinst_current();
             assert(inst && inst->intr_heap);
@@ -451,6 +455,16 @@ static void create_instance(struct instmgr_info *mgr_info,
         info.workspace_layout = purc_variant_get_string_const(tmp);
     }
 
+    tmp = purc_variant_object_get_by_ckey(request->data, "cpuAffinity");
+    if (tmp) {
+        info.cpu_affinity = purc_variant_get_string_const(tmp);
+    }
+
+    tmp = purc_variant_object_get_by_ckey(request->data, "numaNodes");
+    if (tmp) {
+        info.numa_nodes = purc_variant_get_string_const(tmp);
+    }
+
     void *th = NULL;
     atom = pcrun_create_inst_thread(app_name, runner_name, cond_handler,
             &info, &th);
@@ -618,6 +632,25 @@ static void kill_instance(struct instmgr_info *info,
     }
 }
 
+/* responds the sums of the metrics of all instances as the data */
+static void get_metrics(struct instmgr_info *info,
+        const pcrdr_msg *request, pcrdr_msg *response)
+{
+    purc_variant_t metrics = pcinst_metrics_make_aggregated_variant();
+    if (metrics == PURC_VARIANT_INVALID) {
+        return;
+    }
+
+    response->type = PCRDR_MSG_TYPE_RESPONSE;
+    response->requestId = purc_variant_ref(request->requestId);
+    response->sourceURI = purc_variant_make_string(purc_get_endpoint(NULL),
+            false);
+    response->retCode = PCRDR_SC_OK;
+    response->resultValue = (uint64_t)info->nr_insts;
+    response->dataType = PCRDR_MSG_DATA_TYPE_JSON;
+    response->data = metrics;
+}
+
 void pcrun_instmgr_handle_message(void *ctxt)
 {
     struct instmgr_info *info = ctxt;
@@ -629,6 +662,7 @@ void pcrun_instmgr_handle_message(void *ctxt)
         return;
     }
     else if (n == 0) {
+        pcrun_fill_inst_pool();
         // sleep 1ms to take a breath
         pcutils_usleep(1000);
         return;
@@ -666,6 +700,9 @@ void pcrun_instmgr_handle_message(void *ctxt)
         else if (strcmp(op, PCRUN_OPERATION_killInstance) == 0) {
             kill_instance(info, msg, response);
         }
+        else if (strcmp(op, PCRUN_OPERATION_getMetrics) == 0) {
+            get_metrics(info, msg, response);
+        }
         else {
             purc_log_warn("InstMgr got an unknown `%s` request from %s\n",
                     op, source_uri);
@@ -850,6 +887,20 @@ purc_inst_create_or_get(const char *app_name, const char *runner_name,
             purc_variant_object_set_by_static_ckey(data, "workspaceLayout", tmp);
             purc_variant_unref(tmp);
         }
+
+        if (extra_info->cpu_affinity) {
+            tmp = purc_variant_make_string_static(extra_info->cpu_affinity,
+                    false);
+            purc_variant_object_set_by_static_ckey(data, "cpuAffinity", tmp);
+            purc_variant_unref(tmp);
+        }
+
+        if (extra_info->numa_nodes) {
+            tmp = purc_variant_make_string_static(extra_info->numa_nodes,
+                    false);
+            purc_variant_object_set_by_static_ckey(data, "numaNodes", tmp);
+            purc_variant_unref(tmp);
+        }
     }
 
     purc_variant_t request_id = purc_variant_ref(request->requestId);
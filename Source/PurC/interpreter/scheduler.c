@@ -34,7 +34,10 @@
 #include "private/utils.h"
 #include "private/variant.h"
 #include "private/ports.h"
+#include "private/metrics.h"
+#include "private/trace.h"
 #include "private/msg-queue.h"
+#include "private/runners.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -42,7 +45,6 @@
 #include <sys/time.h>
 
 #define SCHEDULE_SLEEP          10000           // usec
-#define IDLE_EVENT_TIMEOUT      100             // ms
 
 #define BUILTIN_VAR_CRTN        PURC_PREDEF_VARNAME_CRTN
 
@@ -52,6 +54,11 @@ static void
 broadcast_idle_event(struct pcinst *inst)
 {
     struct pcintr_heap *heap = inst->intr_heap;
+    size_t nr_left = heap->nr_idle_observers;
+    if (nr_left == 0) {
+        return;
+    }
+
     struct rb_root *coroutines = &heap->coroutines;
     struct rb_node *p, *n;
     struct rb_node *first = pcutils_rbtree_first(coroutines);
@@ -59,13 +66,18 @@ broadcast_idle_event(struct pcinst *inst)
         pcintr_coroutine_t co = container_of(p, struct pcintr_coroutine,
                 node);
         pcintr_stack_t stack = &co->stack;
-        if (stack->observe_idle) {
+        if (stack->nr_idle_observers) {
             purc_variant_t hvml = pcintr_get_coroutine_variable(stack->co,
                     BUILTIN_VAR_CRTN);
             pcintr_coroutine_post_event(stack->co->cid,
                     PCRDR_MSG_EVENT_REDUCE_OPT_OVERLAY,
                     hvml, MSG_TYPE_IDLE, NULL,
                     PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+
+            if (nr_left <= stack->nr_idle_observers) {
+                break;
+            }
+            nr_left -= stack->nr_idle_observers;
         }
     }
 }
@@ -95,6 +107,12 @@ handle_rdr_conn_lost(struct pcinst *inst)
                 PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
     }
 
+    if (heap->rdr_fd_monitor) {
+        purc_runloop_remove_fd_monitor(inst->running_loop,
+                heap->rdr_fd_monitor);
+        heap->rdr_fd_monitor = 0;
+    }
+
     // FIXME:
     // pcrdr_disconnect(inst->conn_to_rdr);
     pcrdr_free_connection(inst->conn_to_rdr);
@@ -289,19 +307,196 @@ pcintr_check_after_execution_full(struct pcinst *inst, pcintr_coroutine_t co)
     }
 }
 
+/*
+ * The limits are checked after every step instead of every allocation,
+ * so an element is never interrupted by a failed allocation: a coroutine
+ * beyond its hard limit gets a `MemoryFailure` exception as if the step
+ * failed, which can be caught to release some memory, or terminates it.
+ */
+static void
+check_mem_limits(struct pcinst *inst, pcintr_coroutine_t co)
+{
+    size_t usage = pcintr_coroutine_mem_usage(co);
+
+    /* a stopped coroutine will resume the step, so raise nothing */
+    if (co->mem_hard_limit && usage > co->mem_hard_limit &&
+            co->state != CO_STATE_STOPPED &&
+            inst->errcode == 0 && !co->stack.except) {
+        purc_set_error_with_info(PURC_ERROR_OUT_OF_MEMORY,
+                "%zu bytes used beyond the hard limit (%zu bytes)",
+                usage, co->mem_hard_limit);
+    }
+
+    if (co->mem_soft_limit == 0)
+        return;
+
+    if (usage <= co->mem_soft_limit) {
+        co->mem_soft_notified = 0;
+    }
+    else if (!co->mem_soft_notified) {
+        co->mem_soft_notified = 1;
+
+        purc_variant_t hvml = pcintr_get_coroutine_variable(co,
+                BUILTIN_VAR_CRTN);
+        purc_variant_t data = purc_variant_make_ulongint(usage);
+        pcintr_coroutine_post_event(co->cid,
+                PCRDR_MSG_EVENT_REDUCE_OPT_OVERLAY,
+                hvml, MSG_TYPE_MEMORY, MSG_SUB_TYPE_SOFT_LIMIT,
+                data, PURC_VARIANT_INVALID);
+        PURC_VARIANT_SAFE_CLEAR(data);
+    }
+}
+
+static void
+on_deferred_sleep_timeout(pcintr_timer_t timer, const char *id, void *data)
+{
+    UNUSED_PARAM(timer);
+    UNUSED_PARAM(id);
+
+    pcintr_coroutine_t co = data;
+    if (co->stack.exited)
+        return;
+
+    purc_variant_t element_value = purc_variant_make_native(co, NULL);
+    if (element_value) {
+        pcintr_coroutine_post_event(co->cid,
+                PCRDR_MSG_EVENT_REDUCE_OPT_KEEP,
+                element_value,
+                MSG_TYPE_SLEEP, MSG_SUB_TYPE_TIMEOUT,
+                PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+        purc_variant_unref(element_value);
+    }
+}
+
+static void
+on_deferred_sleep_done(void *ctxt, pcrdr_msg *msg)
+{
+    UNUSED_PARAM(msg);
+
+    pcintr_coroutine_t co = ctxt;
+    if (co->sleep_timer) {
+        pcintr_timer_destroy(co->sleep_timer);
+        co->sleep_timer = NULL;
+    }
+}
+
+static bool
+is_able_to_yield(struct pcinst *inst, pcintr_coroutine_t co)
+{
+    struct pcintr_stack_frame *frame;
+    frame = pcintr_stack_get_bottom_frame(&co->stack);
+    return inst->errcode == 0 && !co->stack.exited && frame &&
+        frame->type == STACK_FRAME_TYPE_NORMAL;
+}
+
+static void
+on_async_done(void *ctxt, pcrdr_msg *msg)
+{
+    UNUSED_PARAM(ctxt);
+    UNUSED_PARAM(msg);
+}
+
+/* yields the coroutine until the asynchronous native methods called in the
+   last step are done; see async.c */
+static void
+start_async_wait(struct pcinst *inst, pcintr_coroutine_t co)
+{
+    /* the coroutine yielded in the step by itself: waits after resuming */
+    if (co->state != CO_STATE_RUNNING || !is_able_to_yield(inst, co))
+        return;
+
+    co->async_waiting = 1;
+    pcintr_yield(co, on_async_done, PURC_VARIANT_INVALID,
+            PURC_VARIANT_INVALID, PURC_VARIANT_INVALID, true);
+}
+
+/* yields the coroutine until the timer for the sleep requested by
+   pcintr_defer_sleep() in the last step fires */
+static void
+start_deferred_sleep(struct pcinst *inst, pcintr_coroutine_t co)
+{
+    /* the coroutine yielded in the step by itself: sleeps after resuming */
+    if (co->state != CO_STATE_RUNNING)
+        return;
+
+    uint64_t ms = co->sleep_ns / 1000000 + (co->sleep_ns % 1000000 ? 1 : 0);
+    co->sleep_ns = 0;
+    if (!is_able_to_yield(inst, co))
+        return;
+
+    PC_ASSERT(co->sleep_timer == NULL);
+    co->sleep_timer = pcintr_timer_create(NULL, NULL,
+            on_deferred_sleep_timeout, co);
+    if (co->sleep_timer == NULL)
+        return;
+
+    purc_variant_t element_value = purc_variant_make_native(co, NULL);
+    purc_variant_t event_name = purc_variant_make_string_static(
+            MSG_TYPE_SLEEP ":" MSG_SUB_TYPE_TIMEOUT, false);
+    if (element_value && event_name) {
+        pcintr_timer_set_interval(co->sleep_timer,
+                ms > UINT32_MAX ? UINT32_MAX : (uint32_t)ms);
+        pcintr_timer_start_oneshot(co->sleep_timer);
+        pcintr_yield(co, on_deferred_sleep_done, PURC_VARIANT_INVALID,
+                element_value, event_name, false);
+    }
+    else {
+        pcintr_timer_destroy(co->sleep_timer);
+        co->sleep_timer = NULL;
+        pcinst_clear_error(inst);
+    }
+
+    PURC_VARIANT_SAFE_CLEAR(element_value);
+    PURC_VARIANT_SAFE_CLEAR(event_name);
+}
+
 static void
 execute_one_step_for_ready_co(struct pcinst *inst, pcintr_coroutine_t co)
 {
     UNUSED_PARAM(inst);
     UNUSED_PARAM(co);
 
+    double started = pcintr_get_current_time();
+    uint64_t steps = 0;
+
     pcintr_set_current_co(co);
 
-    pcintr_coroutine_set_state(co, CO_STATE_RUNNING);
-    pcintr_execute_one_step_for_ready_co(co);
-    pcintr_check_after_execution_full(inst, co);
+    // run the coroutine until it is not ready any more or
+    // its time slice is used up.
+    while (1) {
+        pcintr_coroutine_set_state(co, CO_STATE_RUNNING);
+        if (inst->intr_heap->profiler)
+            pcintr_profiler_sample(inst->intr_heap->profiler, co);
+        pcintr_execute_one_step_for_ready_co(co);
+        if (co->nr_asyncs)
+            start_async_wait(inst, co);
+        else if (co->sleep_ns)
+            start_deferred_sleep(inst, co);
+        if (co->mem_soft_limit || co->mem_hard_limit)
+            check_mem_limits(inst, co);
+        pcintr_check_after_execution_full(inst, co);
+        steps++;
+
+        if (co->state != CO_STATE_READY)
+            break;
+
+        if (steps >= co->slice_steps || (co->slice_time &&
+                pcintr_get_current_time() - started >= co->slice_time)) {
+            co->nr_preempted++;
+            break;
+        }
+    }
 
+    /* send the DOM operations of the time slice in batches; those beyond
+       the in-flight credits of the renderer connection are kept */
+    pcintr_rdr_try_flush_dom_ops(co);
     pcintr_set_current_co(NULL);
+
+    double elapsed = pcintr_get_current_time() - started;
+    co->nr_slices++;
+    co->nr_steps += steps;
+    if (elapsed > co->max_slice_time)
+        co->max_slice_time = elapsed;
 }
 
 // execute one step for all ready coroutines of the inst
@@ -310,14 +505,25 @@ static bool
 execute_one_step(struct pcinst *inst)
 {
     struct pcintr_heap *heap = inst->intr_heap;
-    struct rb_root *coroutines = &heap->coroutines;
-    struct rb_node *p, *n;
-    struct rb_node *first = pcutils_rbtree_first(coroutines);
     bool busy = false;
-    pcutils_rbtree_for_each_safe(first, p, n) {
-        pcintr_coroutine_t co = container_of(p, struct pcintr_coroutine,
-                node);
-        if (co->state != CO_STATE_READY) {
+
+    // take the ready queue; the coroutines becoming ready during this round
+    // will be queued in heap->ready_coroutines for the next round.
+    LIST_HEAD(ready);
+    list_splice_init(&heap->ready_coroutines, &ready);
+    heap->nr_credit_waiting = 0;
+
+    while (!list_empty(&ready)) {
+        pcintr_coroutine_t co = list_first_entry(&ready,
+                struct pcintr_coroutine, ln_sched);
+        list_del_init(&co->ln_sched);
+        PC_ASSERT(co->state == CO_STATE_READY);
+
+        // a coroutine whose DOM operations are still waiting for the
+        // renderer does not run, while the others go on.
+        if (!pcintr_rdr_try_flush_dom_ops(co)) {
+            list_add_tail(&co->ln_sched, &heap->ready_coroutines);
+            heap->nr_credit_waiting++;
             continue;
         }
 
@@ -339,11 +545,30 @@ check_and_dispatch_event_from_conn(struct pcinst *inst)
             pcrdr_conn_set_event_handler(conn, pcintr_conn_event_handler);
         }
 
+        /* wake up the parked scheduler when the renderer sends something */
+        struct pcintr_heap *heap = inst->intr_heap;
+        int fd = pcrdr_conn_socket_fd(conn);
+        if (fd >= 0 && (heap->rdr_fd_monitor == 0 || heap->rdr_fd != fd)) {
+            if (heap->rdr_fd_monitor) {
+                purc_runloop_remove_fd_monitor(inst->running_loop,
+                        heap->rdr_fd_monitor);
+            }
+            heap->rdr_fd = fd;
+            heap->rdr_fd_monitor = pcintr_add_wakeup_fd_monitor(
+                    inst->running_loop, fd);
+        }
+
         int last_err = purc_get_last_error();
         purc_clr_error();
 
         pcrdr_wait_and_dispatch_message(conn, 0);
 
+        /* the responses read may have returned the credits waited for */
+        if (heap->nr_credit_waiting &&
+                pcrdr_conn_inflight_credits(conn) > 0) {
+            pcintr_wakeup_scheduler(inst);
+        }
+
         int err = purc_get_last_error();
         if (err == PCRDR_ERROR_IO || err == PCRDR_ERROR_PEER_CLOSED) {
             handle_rdr_conn_lost(inst);
@@ -356,27 +581,33 @@ check_and_dispatch_event_from_conn(struct pcinst *inst)
     }
 }
 
-/* return whether busy */
-bool
-handle_coroutine_event(pcintr_coroutine_t co)
+/* return whether busy; msg is released, requeued or handed over */
+static bool
+handle_coroutine_msg(pcintr_coroutine_t co, pcrdr_msg *msg)
 {
     bool busy = false;
     int handle_ret = PURC_ERROR_INCOMPLETED;
-    if (co->state == CO_STATE_READY || co->state == CO_STATE_RUNNING) {
-        goto out;
-    }
-
-    pcrdr_msg *msg = pcinst_msg_queue_get_msg(co->mq);
     bool remove_handler = false;
     bool performed = false;
     bool msg_observed = false;
 
+    purc_atom_t msg_type = 0;
+    if (msg && msg->type == PCRDR_MSG_TYPE_EVENT) {
+        msg_type = pcintr_event_type_atom(
+                purc_variant_get_string_const(msg->eventName), NULL);
+    }
+
     struct list_head *handlers = &co->event_handlers;
     struct list_head *p, *n;
     list_for_each_safe(p, n, handlers) {
         struct pcintr_event_handler *handler;
         handler = list_entry(p, struct pcintr_event_handler, ln);
 
+        // skip the handlers which only care about another type of event
+        if (msg && handler->event_type && handler->event_type != msg_type) {
+            continue;
+        }
+
         bool matched = false;
         bool observed = false;
         if (msg || handler->support_null_event) {
@@ -457,6 +688,59 @@ out:
     return busy;
 }
 
+static inline bool
+is_co_able_to_handle_msg(pcintr_coroutine_t co)
+{
+    return co->state != CO_STATE_READY && co->state != CO_STATE_RUNNING &&
+        !co->stack.last_msg_read;
+}
+
+/* return whether busy */
+bool
+handle_coroutine_event(pcintr_coroutine_t co)
+{
+    bool busy = false;
+    if (co->state == CO_STATE_READY || co->state == CO_STATE_RUNNING) {
+        goto out;
+    }
+
+    // the events wait until the DOM operations are sent to the renderer
+    if (!pcintr_rdr_try_flush_dom_ops(co)) {
+        goto out;
+    }
+
+    // take all pending messages under a single lock, and handle them
+    // until the coroutine becomes ready to run again.
+    LIST_HEAD(msgs);
+    if (pcinst_msg_queue_take_msgs(co->mq, &msgs) == 0) {
+        busy = handle_coroutine_msg(co, NULL);
+        goto out;
+    }
+
+    do {
+        struct pcinst_msg_hdr *hdr = list_first_entry(&msgs,
+                struct pcinst_msg_hdr, ln);
+        list_del(&hdr->ln);
+
+        /* the message may be released once handled */
+        pcrdr_msg *msg = (pcrdr_msg *)hdr;
+        pctimeline_begin(PC_TIMELINE_EVENT, msg->type == PCRDR_MSG_TYPE_EVENT ?
+                purc_variant_get_string_const(msg->eventName) : "message",
+                NULL, 0);
+        if (handle_coroutine_msg(co, msg)) {
+            busy = true;
+        }
+        pctimeline_end(PC_TIMELINE_EVENT, NULL);
+    } while (!list_empty(&msgs) && is_co_able_to_handle_msg(co));
+
+    if (!list_empty(&msgs)) {
+        pcinst_msg_queue_put_back_msgs(co->mq, &msgs);
+    }
+
+out:
+    return busy;
+}
+
 static bool
 dispatch_event(struct pcinst *inst)
 {
@@ -467,15 +751,21 @@ dispatch_event(struct pcinst *inst)
 
     bool co_is_busy = false;
     struct pcintr_heap *heap = inst->intr_heap;
-    struct rb_root *coroutines = &heap->coroutines;
-    struct rb_node *p, *n;
-    struct rb_node *first = pcutils_rbtree_first(coroutines);
-    pcutils_rbtree_for_each_safe(first, p, n) {
+
+    // visit the waiting coroutines only; a coroutine is put back before
+    // handling its event, so it can be moved or destroyed safely.
+    LIST_HEAD(waiting);
+    list_splice_init(&heap->waiting_coroutines, &waiting);
+
+    while (!list_empty(&waiting)) {
         pcintr_coroutine_t co;
-        co = container_of(p, struct pcintr_coroutine, node);
+        co = list_first_entry(&waiting, struct pcintr_coroutine, ln_sched);
+        list_move_tail(&co->ln_sched, &heap->waiting_coroutines);
+
         co_is_busy = handle_coroutine_event(co);
 
         if (co->stack.exited && co->stack.last_msg_read) {
+            pcintr_rdr_flush_dom_ops(co);
             pcintr_run_exiting_co(co);
         }
 
@@ -512,16 +802,51 @@ pcintr_schedule(void *ctxt)
     // 3. its busy, goto next scheduler without sleep
     if (step_is_busy || event_is_busy) {
         pcintr_update_timestamp(inst);
+        pcinst_metrics_count(inst, PCINST_METRIC_SCHED_BUSY_TICKS, 1);
+        goto out;
+    }
+
+    // 4. nothing ready: take a job from the runner pool, if any
+    if (list_empty(&heap->ready_coroutines) &&
+            pcrun_runner_pool_schedule_next(inst)) {
+        pcintr_update_timestamp(inst);
+        pcinst_metrics_count(inst, PCINST_METRIC_SCHED_BUSY_TICKS, 1);
         goto out;
     }
 
-    // 5. broadcast idle event
+    pcinst_metrics_count(inst, PCINST_METRIC_SCHED_IDLE_TICKS, 1);
+
+    // 5. broadcast idle event, only if someone observes it
     double now = pcintr_get_current_time();
-    if (now - IDLE_EVENT_TIMEOUT > heap->timestamp) {
+    long period = (long)heap->idle_period;
+    if (now - period > heap->timestamp) {
         broadcast_idle_event(inst);
+        // collect the garbage cycles of variants in the time budget
+        pcvariant_gc_collect_on_idle();
         pcintr_update_timestamp(inst);
     }
 
+    // 6. park the scheduler until a new message, a ready coroutine, a timer,
+    // or the renderer wakes it up, or it is time to broadcast idle event.
+    // No effect if there was a wake-up during this round.
+    long timeout_ms;
+    if (heap->nr_idle_observers == 0 && !pcvariant_gc_has_roots() &&
+            (heap->rdr_fd_monitor || purc_get_conn_to_renderer() == NULL)) {
+        // nothing to poll: park until woken up
+        timeout_ms = -1;
+    }
+    else {
+        timeout_ms = (long)(heap->timestamp + period + 1 - now);
+        if (timeout_ms <= 0) {
+            timeout_ms = 1;
+        }
+        else if (timeout_ms > period + 1) {
+            timeout_ms = period + 1;
+        }
+    }
+    purc_runloop_park_idle_func(inst->running_loop, timeout_ms);
+    goto out;
+
 out_sleep:
     pcutils_usleep(SCHEDULE_SLEEP);
 
@@ -530,6 +855,14 @@ out:
     return;
 }
 
+void
+pcintr_wakeup_scheduler(struct pcinst *inst)
+{
+    if (inst && inst->running_loop) {
+        purc_runloop_wakeup(inst->running_loop);
+    }
+}
+
 static bool
 default_event_match(struct pcintr_event_handler *handler, pcintr_coroutine_t co,
         pcrdr_msg *msg, bool *observed)
@@ -542,6 +875,20 @@ default_event_match(struct pcintr_event_handler *handler, pcintr_coroutine_t co,
 }
 
 
+void
+pcintr_event_handler_init(struct pcintr_event_handler *handler,
+        const char *name, int stage, int state, void *data, event_handle_fn fn,
+        event_match_fn is_match_fn, bool support_null_event)
+{
+    handler->name = name;
+    handler->cor_stage = stage;
+    handler->cor_state = state;
+    handler->data = data;
+    handler->handle = fn;
+    handler->is_match = is_match_fn ? is_match_fn : default_event_match;
+    handler->support_null_event = support_null_event;
+}
+
 struct pcintr_event_handler *
 pcintr_event_handler_create(const char *name,
         int stage, int state, void *data, event_handle_fn fn,
@@ -554,13 +901,8 @@ pcintr_event_handler_create(const char *name,
         goto out;
     }
 
-    handler->name = name ? strdup(name) : NULL;
-    handler->cor_stage = stage;
-    handler->cor_state = state;
-    handler->data = data;
-    handler->handle = fn;
-    handler->is_match = is_match_fn ? is_match_fn : default_event_match;
-    handler->support_null_event = support_null_event;
+    pcintr_event_handler_init(handler, name, stage, state, data, fn,
+            is_match_fn, support_null_event);
 out:
     return handler;
 }
@@ -568,10 +910,10 @@ out:
 void
 pcintr_event_handler_destroy(struct pcintr_event_handler *handler)
 {
-    if (handler->name) {
-        free(handler->name);
+    /* the builtin ones are freed along with the coroutine */
+    if (!handler->builtin) {
+        free(handler);
     }
-    free(handler);
 }
 
 
@@ -697,6 +1039,18 @@ void pcintr_yield(void *ctxt, void (*continuation)(void *ctxt, pcrdr_msg *msg),
     }
 }
 
+bool
+pcintr_defer_sleep(uint64_t ns)
+{
+    pcintr_coroutine_t co = pcintr_get_coroutine();
+    if (co == NULL || co->state != CO_STATE_RUNNING)
+        return false;
+
+    co->sleep_ns = (UINT64_MAX - co->sleep_ns < ns) ?
+        UINT64_MAX : co->sleep_ns + ns;
+    return true;
+}
+
 void pcintr_resume(pcintr_coroutine_t co, pcrdr_msg *msg)
 {
     PC_ASSERT(co);
@@ -747,7 +1101,7 @@ serial_symbol_vars(const char *symbol, int id,
 {
     purc_rwstream_write(stm, symbol, strlen(symbol));
     size_t len_expected = 0;
-    purc_variant_serialize(frame->symbol_vars[id],
+    purc_variant_serialize(pcintr_get_symbol_var(frame, id),
             stm, 0,
             PCVARIANT_SERIALIZE_OPT_REAL_EJSON |
             PCVARIANT_SERIALIZE_OPT_BSEQUENCE_BASE64 |
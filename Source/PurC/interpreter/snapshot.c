@@ -0,0 +1,459 @@
+/*
+ * @file snapshot.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The snapshots of the variables of coroutines.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A snapshot is an object in the binary eJSON encoding:
+ *
+ *  {
+ *      "version": 1,
+ *      "elements": <the number of the elements in the vDOM>,
+ *      "variables": { <the coroutine-level variables> },
+ *      "scoped": [ { "element": <the index of the element in the vDOM>,
+ *                    "variables": { <the variables of the element> } } ]
+ *  }
+ *
+ * The elements are numbered in the document order, so a snapshot can only
+ * be restored to a coroutine running the same program. The variables of
+ * dynamic or native entities, or containing such ones, are not in the
+ * snapshot, since they can not be serialized.
+ */
+
+#include "config.h"
+
+#include "internal.h"
+
+#include "private/instance.h"
+#include "private/var-mgr.h"
+#include "private/vdom.h"
+
+#define SNAPSHOT_VERSION        2
+
+struct restored_scope {
+    pcvdom_element_t            element;
+    purc_variant_t              variables;
+};
+
+struct pcintr_restored {
+    purc_variant_t              variables;
+
+    struct restored_scope      *scopes;
+    size_t                      nr_scopes;
+};
+
+static bool
+is_persistable(purc_variant_t v)
+{
+    switch (purc_variant_get_type(v)) {
+    case PURC_VARIANT_TYPE_DYNAMIC:
+    case PURC_VARIANT_TYPE_NATIVE:
+        return false;
+
+    case PURC_VARIANT_TYPE_ARRAY:
+    {
+        purc_variant_t m;
+        size_t idx;
+        foreach_value_in_variant_array(v, m, idx) {
+            (void)idx;
+            if (!is_persistable(m))
+                return false;
+        } end_foreach;
+        break;
+    }
+
+    case PURC_VARIANT_TYPE_OBJECT:
+    {
+        purc_variant_t k, m;
+        foreach_key_value_in_variant_object(v, k, m) {
+            (void)k;
+            if (!is_persistable(m))
+                return false;
+        } end_foreach;
+        break;
+    }
+
+    case PURC_VARIANT_TYPE_SET:
+    {
+        purc_variant_t m;
+        foreach_value_in_variant_set(v, m) {
+            if (!is_persistable(m))
+                return false;
+        } end_foreach;
+        break;
+    }
+
+    case PURC_VARIANT_TYPE_TUPLE:
+    {
+        size_t sz = 0;
+        purc_variant_tuple_size(v, &sz);
+        for (size_t i = 0; i < sz; i++) {
+            if (!is_persistable(purc_variant_tuple_get(v, i)))
+                return false;
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    return true;
+}
+
+/* returns an object of the variables of @mgr can be serialized */
+static purc_variant_t
+collect_variables(pcvarmgr_t mgr)
+{
+    purc_variant_t vars = purc_variant_make_object_0();
+    if (vars == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    purc_variant_t k, v;
+    foreach_key_value_in_variant_object(mgr->object, k, v) {
+        if (is_persistable(v) &&
+                !purc_variant_object_set(vars, k, v)) {
+            purc_variant_unref(vars);
+            return PURC_VARIANT_INVALID;
+        }
+    } end_foreach;
+
+    return vars;
+}
+
+/* the next element after @elem in the document order */
+static pcvdom_element_t
+next_element(pcvdom_element_t elem)
+{
+    pcvdom_element_t next = pcvdom_element_first_child_element(elem);
+    while (next == NULL && elem) {
+        next = pcvdom_element_next_sibling_element(elem);
+        if (next == NULL) {
+            elem = pcvdom_element_parent(elem);
+            if (elem && elem->node.type == PCVDOM_NODE_DOCUMENT)
+                elem = NULL;
+        }
+    }
+    return next;
+}
+
+static uint64_t
+count_elements(purc_vdom_t vdom)
+{
+    uint64_t nr = 0;
+    pcvdom_element_t elem = pcvdom_document_get_root(vdom);
+    for (; elem; elem = next_element(elem))
+        nr++;
+    return nr;
+}
+
+static purc_variant_t
+make_snapshot(purc_coroutine_t cor)
+{
+    purc_variant_t snapshot = PURC_VARIANT_INVALID;
+    purc_variant_t scoped = PURC_VARIANT_INVALID;
+    purc_variant_t vars = PURC_VARIANT_INVALID;
+    purc_variant_t v;
+
+    snapshot = purc_variant_make_object_0();
+    scoped = purc_variant_make_array_0();
+    vars = collect_variables(cor->variables);
+    if (!snapshot || !scoped || !vars)
+        goto failed;
+
+    uint64_t idx = 0;
+    pcvdom_element_t elem = pcvdom_document_get_root(cor->vdom);
+    for (; elem; elem = next_element(elem), idx++) {
+        pcvarmgr_t mgr = pcintr_get_scoped_variables(cor,
+                pcvdom_ele_cast_to_node(elem));
+        if (mgr == NULL)
+            continue;
+
+        purc_variant_t scope_vars = collect_variables(mgr);
+        if (scope_vars == PURC_VARIANT_INVALID)
+            goto failed;
+
+        if (purc_variant_object_get_size(scope_vars) == 0) {
+            purc_variant_unref(scope_vars);
+            continue;
+        }
+
+        purc_variant_t scope = purc_variant_make_object_0();
+        v = PURC_VARIANT_INVALID;
+        bool ok = scope &&
+            (v = purc_variant_make_ulongint(idx)) &&
+            purc_variant_object_set_by_static_ckey(scope, "element", v);
+        if (v)
+            purc_variant_unref(v);
+        ok = ok && purc_variant_object_set_by_static_ckey(scope, "variables",
+                scope_vars) && purc_variant_array_append(scoped, scope);
+        purc_variant_unref(scope_vars);
+        if (scope)
+            purc_variant_unref(scope);
+        if (!ok)
+            goto failed;
+    }
+
+    v = purc_variant_make_ulongint(SNAPSHOT_VERSION);
+    if (!v || !purc_variant_object_set_by_static_ckey(snapshot, "version", v))
+        goto failed_v;
+    purc_variant_unref(v);
+
+    v = purc_variant_make_ulongint(idx);
+    if (!v || !purc_variant_object_set_by_static_ckey(snapshot, "elements", v))
+        goto failed_v;
+    purc_variant_unref(v);
+
+    if (!purc_variant_object_set_by_static_ckey(snapshot, "variables", vars) ||
+            !purc_variant_object_set_by_static_ckey(snapshot, "scoped",
+                scoped))
+        goto failed;
+
+    purc_variant_unref(vars);
+    purc_variant_unref(scoped);
+    return snapshot;
+
+failed_v:
+    if (v)
+        purc_variant_unref(v);
+failed:
+    if (vars)
+        purc_variant_unref(vars);
+    if (scoped)
+        purc_variant_unref(scoped);
+    if (snapshot)
+        purc_variant_unref(snapshot);
+    return PURC_VARIANT_INVALID;
+}
+
+int
+purc_coroutine_snapshot(purc_coroutine_t cor, purc_rwstream_t stm)
+{
+    if (!cor || !cor->vdom || !stm) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return -1;
+    }
+
+    purc_variant_t snapshot = make_snapshot(cor);
+    if (snapshot == PURC_VARIANT_INVALID) {
+        if (purc_get_last_error() == PURC_ERROR_OK)
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    ssize_t n = purc_variant_serialize_binary(snapshot, stm, 0);
+    purc_variant_unref(snapshot);
+    return (n < 0) ? -1 : 0;
+}
+
+static bool
+get_ulongint(purc_variant_t obj, const char *key, uint64_t *u)
+{
+    purc_variant_t v = purc_variant_object_get_by_ckey(obj, key);
+    return v && purc_variant_cast_to_ulongint(v, u, false);
+}
+
+/* finds the elements of the scopes in the snapshot */
+static int
+restore_scopes(struct pcintr_restored *restored, purc_vdom_t vdom,
+        purc_variant_t scoped, uint64_t nr_elements)
+{
+    size_t nr = 0;
+    if (!purc_variant_array_size(scoped, &nr))
+        return -1;
+    if (nr == 0)
+        return 0;
+
+    restored->scopes = calloc(nr, sizeof(*restored->scopes));
+    if (restored->scopes == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    /* the scopes are in the document order */
+    pcvdom_element_t elem = pcvdom_document_get_root(vdom);
+    uint64_t idx = 0;
+    for (size_t i = 0; i < nr; i++) {
+        purc_variant_t scope = purc_variant_array_get(scoped, i);
+        purc_variant_t vars;
+        uint64_t target;
+        if (!purc_variant_is_object(scope) ||
+                !get_ulongint(scope, "element", &target) ||
+                target < idx || target >= nr_elements ||
+                !(vars = purc_variant_object_get_by_ckey(scope, "variables")) ||
+                !purc_variant_is_object(vars))
+            goto bad;
+
+        for (; idx < target; idx++)
+            elem = next_element(elem);
+
+        restored->scopes[i].element = elem;
+        restored->scopes[i].variables = purc_variant_ref(vars);
+        restored->nr_scopes++;
+    }
+
+    return 0;
+
+bad:
+    purc_set_error(PURC_ERROR_INVALID_VALUE);
+    return -1;
+}
+
+static void
+destroy_restored(struct pcintr_restored *restored)
+{
+    for (size_t i = 0; i < restored->nr_scopes; i++) {
+        purc_variant_unref(restored->scopes[i].variables);
+    }
+    free(restored->scopes);
+    PURC_VARIANT_SAFE_CLEAR(restored->variables);
+    free(restored);
+}
+
+static struct pcintr_restored *
+restore_snapshot(purc_coroutine_t cor, purc_variant_t snapshot)
+{
+    struct pcintr_restored *restored = calloc(1, sizeof(*restored));
+    if (restored == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    uint64_t version, nr_elements;
+    purc_variant_t vars, scoped;
+    if (!purc_variant_is_object(snapshot) ||
+            !get_ulongint(snapshot, "version", &version) ||
+            version != SNAPSHOT_VERSION ||
+            !get_ulongint(snapshot, "elements", &nr_elements) ||
+            !(vars = purc_variant_object_get_by_ckey(snapshot, "variables")) ||
+            !purc_variant_is_object(vars) ||
+            !(scoped = purc_variant_object_get_by_ckey(snapshot, "scoped")) ||
+            !purc_variant_is_array(scoped)) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        goto failed;
+    }
+
+    if (nr_elements != count_elements(cor->vdom)) {
+        purc_set_error_with_info(PURC_ERROR_INVALID_VALUE,
+                "snapshot of another program");
+        goto failed;
+    }
+
+    restored->variables = purc_variant_ref(vars);
+    if (restore_scopes(restored, cor->vdom, scoped, nr_elements))
+        goto failed;
+
+    /* the variables bound already, e.g. the builtin ones, are kept */
+    purc_variant_t k, v;
+    foreach_key_value_in_variant_object(vars, k, v) {
+        const char *name = purc_variant_get_string_const(k);
+        if (purc_coroutine_get_variable(cor, name))
+            continue;
+        purc_clr_error();
+        if (!pcvarmgr_add(cor->variables, name, v))
+            goto failed;
+    } end_foreach;
+
+    return restored;
+
+failed:
+    destroy_restored(restored);
+    return NULL;
+}
+
+int
+purc_coroutine_restore(purc_coroutine_t cor, purc_rwstream_t stm)
+{
+    if (!cor || !cor->vdom || !stm) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return -1;
+    }
+
+    /* the document frame is pushed when scheduled; it has not run yet */
+    pcintr_stack_t stack = &cor->stack;
+    struct pcintr_stack_frame *frame = pcintr_stack_get_bottom_frame(stack);
+    if (cor->stage != CO_STAGE_FIRST_RUN || stack->nr_frames != 1 ||
+            frame->next_step != NEXT_STEP_AFTER_PUSHED || stack->restored) {
+        purc_set_error_with_info(PURC_ERROR_WRONG_STAGE,
+                "the coroutine ran or was restored");
+        return -1;
+    }
+
+    purc_variant_t snapshot = purc_variant_load_from_binary_stream(stm);
+    if (snapshot == PURC_VARIANT_INVALID)
+        return -1;
+
+    stack->restored = restore_snapshot(cor, snapshot);
+    purc_variant_unref(snapshot);
+    return stack->restored ? 0 : -1;
+}
+
+/* takes the value of @name in @vars if it is there */
+static purc_variant_t
+take_variable(purc_variant_t vars, const char *name)
+{
+    purc_variant_t v = purc_variant_object_get_by_ckey(vars, name);
+    if (v == PURC_VARIANT_INVALID) {
+        purc_clr_error();
+        return PURC_VARIANT_INVALID;
+    }
+
+    purc_variant_ref(v);
+    purc_variant_object_remove_by_static_ckey(vars, name, true);
+    return v;
+}
+
+purc_variant_t
+pcintr_restored_take(pcintr_stack_t stack, pcvdom_element_t element,
+        const char *name)
+{
+    struct pcintr_restored *restored = stack->restored;
+    if (restored == NULL || name == NULL)
+        return PURC_VARIANT_INVALID;
+
+    purc_variant_t v = PURC_VARIANT_INVALID;
+    pcvdom_element_t p = pcvdom_element_parent(element);
+    for (; p && p->node.type != PCVDOM_NODE_DOCUMENT && v == NULL;
+            p = pcvdom_element_parent(p)) {
+        for (size_t i = 0; i < restored->nr_scopes; i++) {
+            if (restored->scopes[i].element == p) {
+                v = take_variable(restored->scopes[i].variables, name);
+                break;
+            }
+        }
+    }
+
+    if (v == PURC_VARIANT_INVALID)
+        v = take_variable(restored->variables, name);
+
+    purc_clr_error();
+    return v;
+}
+
+void
+pcintr_restored_cleanup(pcintr_stack_t stack)
+{
+    if (stack->restored) {
+        destroy_restored(stack->restored);
+        stack->restored = NULL;
+    }
+}
@@ -29,62 +29,375 @@
 #include "internal.h"
 
 #include "private/errors.h"
+#include "private/ptrmap.h"
 #include "private/timer.h"
 #include "private/interpreter.h"
+#include "private/trace.h"
 #include "purc-runloop.h"
 
+#include <wtf/HashMap.h>
+#include <wtf/Lock.h>
+#include <wtf/MonotonicTime.h>
 #include <wtf/RunLoop.h>
 #include <wtf/Seconds.h>
 
 #include <stdlib.h>
 #include <string.h>
 
-class Timer : public PurCWTF::RunLoop::TimerBase {
+/*
+ * All timers of a run loop are kept in one hierarchical timer wheel which
+ * is driven by a single run loop timer armed at the nearest deadline.
+ * The timers expiring in the same tick are fired in one shot, and starting,
+ * stopping or firing a timer costs O(1).
+ *
+ * The wheel has four levels like the classic Linux timer wheel: 256 slots
+ * of one tick for the first level, then three levels of 64 slots; a timer
+ * in an outer level is cascaded to the inner level when the inner level
+ * wraps around.
+ */
+#define TIMER_TICK_MS           1
+
+#define WHEEL_ROOT_BITS         8
+#define WHEEL_NODE_BITS         6
+#define WHEEL_ROOT_SIZE         (1 << WHEEL_ROOT_BITS)
+#define WHEEL_NODE_SIZE         (1 << WHEEL_NODE_BITS)
+#define WHEEL_ROOT_MASK         (WHEEL_ROOT_SIZE - 1)
+#define WHEEL_NODE_MASK         (WHEEL_NODE_SIZE - 1)
+#define WHEEL_NR_NODES          3
+#define WHEEL_MAX_TICKS         \
+    ((1ULL << (WHEEL_ROOT_BITS + WHEEL_NR_NODES * WHEEL_NODE_BITS)) - 1)
+
+class TimerWheel;
+class Timer;
+
+/* a plain struct, so that container_of() can be used */
+struct wheel_link {
+    struct list_head ln;        // the slot in the wheel
+    Timer *timer;
+};
+
+class Timer {
     public:
-        Timer(const char *id, pcintr_timer_fire_func func, RunLoop& runLoop,
+        Timer(const char *id, pcintr_timer_fire_func func, TimerWheel *wheel,
                 void *data)
-            : TimerBase(runLoop)
+            : m_wheel(wheel)
             , m_id(NULL)
             , m_func(func)
             , m_data(data)
         {
             m_id = id ? strdup(id) : NULL;
+            INIT_LIST_HEAD(&m_link.ln);
+            m_link.timer = this;
         }
 
-        ~Timer()
-        {
-            stop();
-            if (m_id) {
-                free(m_id);
-            }
-        }
+        ~Timer();
 
         void setInterval(uint32_t interval) { m_interval = interval; }
         uint32_t getInterval() { return m_interval; }
         const char *getId() { return m_id; }
         void *getData() { return m_data; }
 
-        virtual void fired()
+        void start(bool repeating);
+        void stop();
+        bool isActive() { return m_active; }
+
+        void fired()
         {
+            // the timer may be destroyed by the callback
+            pctimeline_begin(PC_TIMELINE_TIMER, m_id, NULL, 0);
             m_func(this, m_id, m_data);
+            pctimeline_end(PC_TIMELINE_TIMER, NULL);
         }
 
-        virtual void processed(void) {}
+        struct wheel_link m_link;
+        uint64_t m_expires { 0 };   // in ticks
+        bool m_repeating { false };
+        bool m_active { false };
 
     private:
+        TimerWheel *m_wheel;
         char *m_id;
         pcintr_timer_fire_func m_func;
         void *m_data;
-        uint32_t m_interval;
+        uint32_t m_interval { 0 };
+};
+
+class TimerWheel : public PurCWTF::RunLoop::TimerBase {
+    public:
+        TimerWheel(RunLoop& runLoop)
+            : TimerBase(runLoop)
+            , m_loop(runLoop)
+        {
+            m_base = currentTick();
+            for (int i = 0; i < WHEEL_ROOT_SIZE; i++)
+                INIT_LIST_HEAD(m_root + i);
+            for (int n = 0; n < WHEEL_NR_NODES; n++)
+                for (int i = 0; i < WHEEL_NODE_SIZE; i++)
+                    INIT_LIST_HEAD(m_nodes[n] + i);
+        }
+
+        ~TimerWheel() { TimerBase::stop(); }
+
+        static TimerWheel *ref(RunLoop& runLoop);
+        void unref();
+
+        static uint64_t currentTick()
+        {
+            return (uint64_t)(MonotonicTime::now().secondsSinceEpoch()
+                    .milliseconds() / TIMER_TICK_MS);
+        }
+
+        void add(Timer *timer)
+        {
+            // do not walk through the ticks passed while the wheel was empty
+            if (m_nr_linked == 0) {
+                uint64_t now = currentTick();
+                if (now > m_base)
+                    m_base = now;
+            }
+
+            link(timer);
+            m_nr_linked++;
+            if (!m_armed || timer->m_expires < m_armed_tick)
+                arm();
+        }
+
+        void remove(Timer *timer)
+        {
+            list_del_init(&timer->m_link.ln);
+            m_nr_linked--;
+            if (m_firing == timer)
+                m_firing = NULL;
+        }
+
+        // the timer is destroyed; it may be the one being fired, which
+        // has been removed from the slots already
+        void forget(Timer *timer)
+        {
+            if (m_firing == timer)
+                m_firing = NULL;
+        }
+
+        virtual void fired();
+
+    private:
+        void link(Timer *timer);
+        bool cascade(int level, unsigned index);
+        void arm();
+
+        RunLoop& m_loop;
+        unsigned m_refc { 0 };
+        size_t m_nr_linked { 0 };
+
+        uint64_t m_base;        // the next tick to process
+        bool m_armed { false };
+        uint64_t m_armed_tick { 0 };
+
+        // the timer being fired; cleared if it is stopped or destroyed
+        Timer *m_firing { NULL };
+
+        struct list_head m_root[WHEEL_ROOT_SIZE];
+        struct list_head m_nodes[WHEEL_NR_NODES][WHEEL_NODE_SIZE];
 };
 
+static Lock s_wheels_lock;
+static HashMap<RunLoop*, TimerWheel*> *s_wheels;
+
+TimerWheel *
+TimerWheel::ref(RunLoop& runLoop)
+{
+    auto locker = holdLock(s_wheels_lock);
+    if (s_wheels == NULL)
+        s_wheels = new HashMap<RunLoop*, TimerWheel*>();
+
+    TimerWheel *wheel = s_wheels->get(&runLoop);
+    if (wheel == NULL) {
+        wheel = new TimerWheel(runLoop);
+        s_wheels->set(&runLoop, wheel);
+    }
+
+    wheel->m_refc++;
+    return wheel;
+}
+
+void
+TimerWheel::unref()
+{
+    auto locker = holdLock(s_wheels_lock);
+    if (--m_refc == 0) {
+        s_wheels->remove(&m_loop);
+        delete this;
+    }
+}
+
+void
+TimerWheel::link(Timer *timer)
+{
+    uint64_t expires = timer->m_expires;
+    uint64_t idx;
+    struct list_head *slot;
+
+    if (expires < m_base) {
+        // already expired; fire it in the next tick.
+        expires = m_base;
+    }
+
+    idx = expires - m_base;
+    if (idx > WHEEL_MAX_TICKS) {
+        idx = WHEEL_MAX_TICKS;
+        expires = m_base + idx;
+    }
+
+    if (idx < WHEEL_ROOT_SIZE) {
+        slot = m_root + (expires & WHEEL_ROOT_MASK);
+    }
+    else {
+        int level = 0;
+        while (level < WHEEL_NR_NODES - 1 &&
+                idx >= (1ULL << (WHEEL_ROOT_BITS +
+                        (level + 1) * WHEEL_NODE_BITS))) {
+            level++;
+        }
+
+        unsigned shift = WHEEL_ROOT_BITS + level * WHEEL_NODE_BITS;
+        slot = m_nodes[level] + ((expires >> shift) & WHEEL_NODE_MASK);
+    }
+
+    list_add_tail(&timer->m_link.ln, slot);
+}
+
+bool
+TimerWheel::cascade(int level, unsigned index)
+{
+    LIST_HEAD(timers);
+    list_splice_init(m_nodes[level] + index, &timers);
+
+    while (!list_empty(&timers)) {
+        Timer *timer = list_first_entry(&timers, struct wheel_link, ln)->timer;
+        list_del_init(&timer->m_link.ln);
+        link(timer);
+    }
+
+    return index == 0;
+}
+
+void
+TimerWheel::arm()
+{
+    if (m_nr_linked == 0) {
+        TimerBase::stop();
+        m_armed = false;
+        return;
+    }
+
+    // the first non-empty slot of the root level, or the next time to
+    // cascade the outer levels.
+    uint64_t next = (m_base | WHEEL_ROOT_MASK) + 1;
+    for (uint64_t tick = m_base; tick < next; tick++) {
+        if (!list_empty(m_root + (tick & WHEEL_ROOT_MASK))) {
+            next = tick;
+            break;
+        }
+    }
+
+    uint64_t now = currentTick();
+    uint64_t delay = (next > now) ? (next - now) * TIMER_TICK_MS : 0;
+    m_armed = true;
+    m_armed_tick = next;
+    startOneShot(PurCWTF::Seconds::fromMilliseconds(delay));
+}
+
+void
+TimerWheel::fired()
+{
+    uint64_t now = currentTick();
+    LIST_HEAD(expired);
+
+    // the last timer may be destroyed by a callback; keep the wheel alive.
+    {
+        auto locker = holdLock(s_wheels_lock);
+        m_refc++;
+    }
+
+    m_armed = false;
+    while (m_base <= now) {
+        unsigned index = m_base & WHEEL_ROOT_MASK;
+        if (index == 0) {
+            for (int level = 0; level < WHEEL_NR_NODES; level++) {
+                unsigned shift = WHEEL_ROOT_BITS + level * WHEEL_NODE_BITS;
+                if (!cascade(level, (m_base >> shift) & WHEEL_NODE_MASK))
+                    break;
+            }
+        }
+
+        list_splice_tail_init(m_root + index, &expired);
+        m_base++;
+    }
+
+    // the callbacks may stop or destroy any timer, including the expired ones.
+    while (!list_empty(&expired)) {
+        Timer *timer = list_first_entry(&expired, struct wheel_link, ln)->timer;
+        remove(timer);
+
+        if (!timer->m_repeating)
+            timer->m_active = false;
+
+        m_firing = timer;
+        timer->fired();
+        if (m_firing == timer && timer->m_repeating && timer->m_active &&
+                list_empty(&timer->m_link.ln)) {
+            uint64_t ticks = timer->getInterval() / TIMER_TICK_MS;
+            timer->m_expires = now + (ticks ? ticks : 1);
+            link(timer);
+            m_nr_linked++;
+        }
+        m_firing = NULL;
+    }
+
+    arm();
+    unref();
+}
+
+Timer::~Timer()
+{
+    stop();
+    m_wheel->forget(this);
+    if (m_id) {
+        free(m_id);
+    }
+    m_wheel->unref();
+}
+
+void
+Timer::start(bool repeating)
+{
+    if (!list_empty(&m_link.ln))
+        m_wheel->remove(this);
+
+    uint64_t ticks = m_interval / TIMER_TICK_MS;
+    m_expires = TimerWheel::currentTick() + ticks;
+    m_repeating = repeating;
+    m_active = true;
+    m_wheel->add(this);
+}
+
+void
+Timer::stop()
+{
+    m_active = false;
+    if (!list_empty(&m_link.ln))
+        m_wheel->remove(this);
+}
+
 pcintr_timer_t
 pcintr_timer_create(purc_runloop_t runloop, const char* id,
         pcintr_timer_fire_func func, void *data)
 {
     RunLoop* loop = runloop ? (RunLoop*)runloop : &RunLoop::current();
-    Timer* timer = new Timer(id, func, *loop, data);
+    TimerWheel* wheel = TimerWheel::ref(*loop);
+    Timer* timer = new Timer(id, func, wheel, data);
     if (!timer) {
+        wheel->unref();
         purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
         return NULL;
     }
@@ -112,9 +425,7 @@ void
 pcintr_timer_start(pcintr_timer_t timer)
 {
     if (timer) {
-        Timer* tm = (Timer*)timer;
-        tm->startRepeating(
-                PurCWTF::Seconds::fromMilliseconds(tm->getInterval()));
+        ((Timer*)timer)->start(true);
     }
 }
 
@@ -122,9 +433,7 @@ void
 pcintr_timer_start_oneshot(pcintr_timer_t timer)
 {
     if (timer) {
-        Timer* tm = (Timer*)timer;
-        tm->startOneShot(
-                PurCWTF::Seconds::fromMilliseconds(tm->getInterval()));
+        ((Timer*)timer)->start(false);
     }
 }
 
@@ -164,7 +473,7 @@ struct pcintr_timers {
     purc_variant_t timers_var;
     struct pcvar_listener* timer_listener;
     pcutils_map* timers_map; // id : pcintr_timer_t
-    pcutils_map* listener_map; // variant : struct pcvar_listener
+    pcutils_ptrmap listener_map; // variant : struct pcvar_listener
 };
 
 int
@@ -172,32 +481,31 @@ listener_map_comp_by_key(const void *key1, const void *key2)
 {
     uintptr_t k1 = (uintptr_t)key1;
     uintptr_t k2 = (uintptr_t)key2;
-    return k1 - k2;
+    return (k1 > k2) - (k1 < k2);
 }
 
 int
-listener_map_set_listener(pcutils_map *map, purc_variant_t obj,
+listener_map_set_listener(pcutils_ptrmap *map, purc_variant_t obj,
         struct pcvar_listener *listener)
 {
-    pcutils_map_entry *entry = pcutils_map_find(map, obj);
-    if (entry) {
+    if (pcutils_ptrmap_find(map, obj)) {
         return -1;
     }
 
-    return pcutils_map_insert(map, obj, listener);
+    return pcutils_ptrmap_set(map, obj, listener);
 }
 
 void
-listener_map_remove_listener(pcutils_map *map, purc_variant_t obj)
+listener_map_remove_listener(pcutils_ptrmap *map, purc_variant_t obj)
 {
-    pcutils_map_entry *entry = pcutils_map_find(map, obj);
+    pcutils_ptrmap_entry *entry = pcutils_ptrmap_find(map, obj);
     if (entry == NULL) {
         return;
     }
 
     struct pcvar_listener *listener = (struct pcvar_listener*)(entry->val);
 
-    pcutils_map_erase(map, obj);
+    pcutils_ptrmap_erase(map, obj);
 
     purc_variant_revoke_listener(obj, listener);
 }
@@ -241,18 +549,34 @@ is_euqal(purc_variant_t var, const char* comp)
     return false;
 }
 
+/* the timers are indexed by the atoms of their identifiers */
+#define TIMERS_ATOM_BUCKET          PURC_ATOM_BUCKET_USER
+
 pcintr_timer_t
 find_timer(struct pcintr_timers* timers, const char* id)
 {
-    pcutils_map_entry* entry = pcutils_map_find(timers->timers_map, id);
+    purc_atom_t atom = purc_atom_try_string_ex(TIMERS_ATOM_BUCKET, id);
+    if (atom == 0) {
+        return NULL;
+    }
+
+    pcutils_map_entry* entry = pcutils_map_find(timers->timers_map,
+            (void *)(uintptr_t)atom);
     return entry ? (pcintr_timer_t) entry->val : NULL;
 }
 
 bool
 add_timer(struct pcintr_timers* timers, const char* id, pcintr_timer_t timer)
 {
+    purc_atom_t atom = purc_atom_from_string_ex(TIMERS_ATOM_BUCKET, id);
+    if (atom == 0) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return false;
+    }
+
     int r;
-    r = pcutils_map_find_replace_or_insert(timers->timers_map, id, timer, NULL);
+    r = pcutils_map_find_replace_or_insert(timers->timers_map,
+            (void *)(uintptr_t)atom, timer, NULL);
     if (0 == r) {
         return true;
     }
@@ -262,7 +586,10 @@ add_timer(struct pcintr_timers* timers, const char* id, pcintr_timer_t timer)
 void
 remove_timer(struct pcintr_timers* timers, const char* id)
 {
-    pcutils_map_erase(timers->timers_map, (void*)id);
+    purc_atom_t atom = purc_atom_try_string_ex(TIMERS_ATOM_BUCKET, id);
+    if (atom) {
+        pcutils_map_erase(timers->timers_map, (void *)(uintptr_t)atom);
+    }
 }
 
 static pcintr_timer_t
@@ -381,7 +708,7 @@ timers_set_grow(purc_variant_t source, pcvar_op_t msg_type,
     if (!listener) {
         return false;
     }
-    listener_map_set_listener(cor->timers->listener_map, argv[0], listener);
+    listener_map_set_listener(&cor->timers->listener_map, argv[0], listener);
 
     uint64_t ret = 0;
     purc_variant_cast_to_ulongint(interval, &ret, false);
@@ -402,7 +729,7 @@ timers_set_shrink(purc_variant_t source, pcvar_op_t msg_type,
     UNUSED_PARAM(ctxt);
 
     purc_coroutine_t cor = (purc_coroutine_t)ctxt;
-    listener_map_remove_listener(cor->timers->listener_map, argv[0]);
+    listener_map_remove_listener(&cor->timers->listener_map, argv[0]);
     destroy_inner_timer(cor, argv[0]);
     return true;
 }
@@ -425,13 +752,13 @@ timers_set_change(purc_variant_t source, pcvar_op_t msg_type,
         return false;
     }
 
-    listener_map_remove_listener(cor->timers->listener_map, argv[0]);
+    listener_map_remove_listener(&cor->timers->listener_map, argv[0]);
     listener = purc_variant_register_post_listener(nv,
             PCVAR_OPERATION_CHANGE, timer_listener_handler, timer);
     if (!listener) {
         return false;
     }
-    listener_map_set_listener(cor->timers->listener_map, nv, listener);
+    listener_map_set_listener(&cor->timers->listener_map, nv, listener);
 
     purc_variant_t interval = purc_variant_object_get_by_ckey(nv,
             TIMERS_STR_INTERVAL);
@@ -513,19 +840,15 @@ pcintr_timers_init(purc_coroutine_t cor)
     timers->timers_var = ret;
     purc_variant_ref(ret);
 
-    timers->timers_map = pcutils_map_create (copy_key_string, free_key_string,
-                          map_copy_val, map_free_val, comp_key_string, false);
+    timers->timers_map = pcutils_map_create (NULL, NULL,
+                          map_copy_val, map_free_val,
+                          listener_map_comp_by_key, false);
     if (!timers->timers_map) {
         purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
         goto failure;
     }
 
-    timers->listener_map = pcutils_map_create (NULL, NULL, NULL, NULL,
-            listener_map_comp_by_key, false);
-    if (!timers->listener_map) {
-        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-        goto failure;
-    }
+    pcutils_ptrmap_init(&timers->listener_map);
 
     timers->timer_listener = purc_variant_register_post_listener(ret,
             (pcvar_op_t)op, timers_set_listener_handler, cor);
@@ -572,10 +895,7 @@ pcintr_timers_destroy(struct pcintr_timers* timers)
             timers->timers_map = NULL;
         }
 
-        if (timers->listener_map) {
-            pcutils_map_destroy(timers->listener_map);
-            timers->listener_map = NULL;
-        }
+        pcutils_ptrmap_clear(&timers->listener_map);
 
         PURC_VARIANT_SAFE_CLEAR(timers->timers_var);
         free(timers);
@@ -588,5 +908,5 @@ pcintr_is_timers(purc_coroutine_t cor, purc_variant_t v)
     if (!cor) {
         return false;
     }
-    return (v == cor->timers->timers_var);
+    return (cor->timers && v == cor->timers->timers_var);
 }
@@ -59,8 +59,36 @@ struct pcvarmgr_named_variables_observe {
     char *name;
     pcintr_stack_t stack;
     pcvdom_element_t elem;
+
+    // the counter of the observers in the stack for the name
+    unsigned int *nr_observers;
 };
 
+static uint32_t
+name_hash(const char *name, size_t len)
+{
+    /* FNV-1a */
+    uint32_t hash = 2166136261U;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
+/*
+ * The observers of the named variables are counted by the hash values of
+ * the names, so the change of a variable not observed by any coroutine is
+ * not posted at all; a collision only costs an event matched by nobody.
+ */
+static unsigned int *
+named_observers_slot(pcintr_stack_t stack, const char *name)
+{
+    uint32_t hash = name_hash(name, strlen(name));
+    return stack->nr_named_observers + (hash % PCINTR_NR_OBSERVED_NAMES);
+}
+
 static purc_variant_t
 pcvarmgr_build_event_observed(const char *name, pcvarmgr_t mgr)
 {
@@ -110,6 +138,54 @@ failed:
     return PURC_VARIANT_INVALID;
 }
 
+/* returns a new reference to the event-observed variant for @name, which is
+   built only once for the variable manager */
+static purc_variant_t
+get_event_observed(pcvarmgr_t mgr, const char *name)
+{
+    purc_variant_t v;
+    if (mgr->events == PURC_VARIANT_INVALID) {
+        mgr->events = purc_variant_make_object_0();
+        if (mgr->events == PURC_VARIANT_INVALID)
+            return PURC_VARIANT_INVALID;
+    }
+    else if ((v = purc_variant_object_get_by_ckey(mgr->events, name))) {
+        return purc_variant_ref(v);
+    }
+    purc_clr_error();
+
+    v = pcvarmgr_build_event_observed(name, mgr);
+    if (v == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    /* the variant is still usable if it can not be cached */
+    purc_variant_t k = purc_variant_make_string(name, true);
+    if (k == PURC_VARIANT_INVALID ||
+            !purc_variant_object_set(mgr->events, k, v)) {
+        purc_clr_error();
+    }
+    PURC_VARIANT_SAFE_CLEAR(k);
+    return v;
+}
+
+static void
+post_change_event(pcvarmgr_t mgr, const char *name, const char *sub_type)
+{
+    pcintr_stack_t stack = pcintr_get_stack();
+    if (!stack || *named_observers_slot(stack, name) == 0) {
+        return;
+    }
+
+    purc_variant_t dest = get_event_observed(mgr, name);
+    if (dest) {
+        pcintr_coroutine_post_event(stack->co->cid,
+                PCRDR_MSG_EVENT_REDUCE_OPT_OVERLAY,
+                dest, MSG_TYPE_CHANGE, sub_type,
+                PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+        purc_variant_unref(dest);
+    }
+}
+
 static bool mgr_grow_handler(purc_variant_t source, pcvar_op_t msg_type,
         void* ctxt, size_t nr_args, purc_variant_t* argv)
 {
@@ -117,22 +193,14 @@ static bool mgr_grow_handler(purc_variant_t source, pcvar_op_t msg_type,
     UNUSED_PARAM(msg_type);
     UNUSED_PARAM(nr_args);
 
-    pcintr_stack_t stack = pcintr_get_stack();
-    if (ctxt == NULL || !stack) {
+    if (ctxt == NULL) {
         return true;
     }
 
     pcvarmgr_t mgr = (pcvarmgr_t)ctxt;
 
     const char* name = purc_variant_get_string_const(argv[0]);
-    purc_variant_t dest = pcvarmgr_build_event_observed(name, mgr);
-    if (dest) {
-        pcintr_coroutine_post_event(stack->co->cid,
-                PCRDR_MSG_EVENT_REDUCE_OPT_OVERLAY,
-                dest, MSG_TYPE_CHANGE, MSG_SUB_TYPE_ATTACHED,
-                PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
-        purc_variant_unref(dest);
-    }
+    post_change_event(mgr, name, MSG_SUB_TYPE_ATTACHED);
 
     return true;
 }
@@ -144,22 +212,14 @@ static bool mgr_shrink_handler(purc_variant_t source, pcvar_op_t msg_type,
     UNUSED_PARAM(msg_type);
     UNUSED_PARAM(nr_args);
 
-    pcintr_stack_t stack = pcintr_get_stack();
-    if (ctxt == NULL || !stack) {
+    if (ctxt == NULL) {
         return true;
     }
 
     pcvarmgr_t mgr = (pcvarmgr_t)ctxt;
 
     const char* name = purc_variant_get_string_const(argv[0]);
-    purc_variant_t dest = pcvarmgr_build_event_observed(name, mgr);
-    if (dest) {
-        pcintr_coroutine_post_event(stack->co->cid,
-                PCRDR_MSG_EVENT_REDUCE_OPT_OVERLAY,
-                dest, MSG_TYPE_CHANGE, MSG_SUB_TYPE_DETACHED,
-                PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
-        purc_variant_unref(dest);
-    }
+    post_change_event(mgr, name, MSG_SUB_TYPE_DETACHED);
 
     return true;
 }
@@ -171,29 +231,30 @@ static bool mgr_change_handler(purc_variant_t source, pcvar_op_t msg_type,
     UNUSED_PARAM(msg_type);
     UNUSED_PARAM(nr_args);
 
-    pcintr_stack_t stack = pcintr_get_stack();
-    if (ctxt == NULL || !stack) {
+    if (ctxt == NULL) {
         return true;
     }
 
     pcvarmgr_t mgr = (pcvarmgr_t)ctxt;
 
     const char* name = purc_variant_get_string_const(argv[0]);
-    purc_variant_t dest = pcvarmgr_build_event_observed(name, mgr);
-    if (dest) {
-        pcintr_coroutine_post_event(stack->co->cid,
-                PCRDR_MSG_EVENT_REDUCE_OPT_OVERLAY,
-                dest, MSG_TYPE_CHANGE, MSG_SUB_TYPE_DISPLACED,
-                PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
-        purc_variant_unref(dest);
-    }
+    post_change_event(mgr, name, MSG_SUB_TYPE_DISPLACED);
 
     return true;
 }
 
+static inline void invalidate_cached_vars(void)
+{
+    struct pcinst *inst = pcinst_current();
+    if (inst)
+        inst->vars_stamp++;
+}
+
 static bool mgr_handler(purc_variant_t source, pcvar_op_t msg_type,
         void* ctxt, size_t nr_args, purc_variant_t* argv)
 {
+    invalidate_cached_vars();
+
     switch (msg_type) {
     case PCVAR_OPERATION_GROW:
         return mgr_grow_handler(source, msg_type, ctxt, nr_args, argv);
@@ -261,9 +322,11 @@ int pcvarmgr_destroy(pcvarmgr_t mgr)
 {
     if (mgr) {
         PC_ASSERT(mgr->node.rb_parent == NULL);
+        invalidate_cached_vars();
         if (mgr->listener) {
             purc_variant_revoke_listener(mgr->object, mgr->listener);
         }
+        PURC_VARIANT_SAFE_CLEAR(mgr->events);
         purc_variant_unref(mgr->object);
         free(mgr);
     }
@@ -343,19 +406,7 @@ bool pcvarmgr_remove_ex(pcvarmgr_t mgr, const char* name, bool silently)
 bool pcvarmgr_dispatch_except(pcvarmgr_t mgr, const char* name,
         const char* except)
 {
-    pcintr_stack_t stack = pcintr_get_stack();
-    if (!stack) {
-        return true;
-    }
-    purc_variant_t dest = pcvarmgr_build_event_observed(name, mgr);
-    if (dest) {
-        pcintr_coroutine_post_event(stack->co->cid,
-                PCRDR_MSG_EVENT_REDUCE_OPT_OVERLAY,
-                dest, MSG_TYPE_CHANGE, except,
-                PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
-        purc_variant_unref(dest);
-    }
-
+    post_change_event(mgr, name, except);
     return true;
 }
 
@@ -507,6 +558,55 @@ again:
     goto again;
 }
 
+static struct pcintr_cached_var *
+cached_var_slot(pcintr_stack_t stack, const char *name, size_t len)
+{
+    uint32_t hash = name_hash(name, len);
+    return stack->cached_vars + (hash % PCINTR_NR_CACHED_VARS);
+}
+
+static purc_variant_t
+find_cached_var(pcintr_stack_t stack, struct pcintr_stack_frame *frame,
+        const char *name, size_t len)
+{
+    if (len > PCINTR_LEN_CACHED_VAR_NAME)
+        return PURC_VARIANT_INVALID;
+
+    struct pcintr_cached_var *cached = cached_var_slot(stack, name, len);
+    struct pcinst *inst = pcinst_current();
+    if (cached->frame_serial == frame->serial &&
+            cached->pos == frame->pos && cached->scope == frame->scope &&
+            cached->stamp == inst->vars_stamp &&
+            memcmp(cached->name, name, len + 1) == 0) {
+        return cached->value;
+    }
+
+    return PURC_VARIANT_INVALID;
+}
+
+static void
+cache_var(pcintr_stack_t stack, struct pcintr_stack_frame *frame,
+        const char *name, size_t len, purc_variant_t v)
+{
+    if (len > PCINTR_LEN_CACHED_VAR_NAME)
+        return;
+
+    struct pcintr_cached_var *cached = cached_var_slot(stack, name, len);
+    cached->frame_serial = frame->serial;
+    cached->pos = frame->pos;
+    cached->scope = frame->scope;
+    /* got after the lookup, which may bind a lazy variable */
+    cached->stamp = pcinst_current()->vars_stamp;
+    cached->value = v;
+    memcpy(cached->name, name, len + 1);
+}
+
+/*
+ * The temporary variables are always searched, for they are kept in
+ * the `$!` objects of the frames instead of variable managers. A variable
+ * found in a variable manager is cached then, until the frame is popped,
+ * or any variable manager is changed, which may shadow it.
+ */
 purc_variant_t
 pcintr_find_named_var(pcintr_stack_t stack, const char* name)
 {
@@ -525,26 +625,32 @@ pcintr_find_named_var(pcintr_stack_t stack, const char* name)
         return v;
     }
 
-    v = _find_named_scope_var(stack->co, frame, name, NULL);
+    size_t len = strlen(name);
+    v = find_cached_var(stack, frame, name, len);
     if (v) {
         purc_clr_error();
         return v;
     }
 
+    v = _find_named_scope_var(stack->co, frame, name, NULL);
+    if (v)
+        goto found;
+
     v = find_cor_level_var(stack->co, name);
-    if (v) {
-        purc_clr_error();
-        return v;
-    }
+    if (v)
+        goto found;
 
     v = find_inst_var(name);
-    if (v) {
-        purc_clr_error();
-        return v;
-    }
+    if (v)
+        goto found;
 
     purc_set_error_with_info(PCVARIANT_ERROR_NOT_FOUND, "name:%s", name);
     return PURC_VARIANT_INVALID;
+
+found:
+    purc_clr_error();
+    cache_var(stack, frame, name, len, v);
+    return v;
 }
 
 enum purc_symbol_var _to_symbol(char symbol)
@@ -615,32 +721,39 @@ pcintr_find_anchor_symbolized_var(pcintr_stack_t stack, const char *anchor,
 
     struct pcintr_stack_frame* frame = pcintr_stack_get_bottom_frame(stack);
 
-    while (frame) {
+    for (; frame; frame = pcintr_stack_frame_get_parent(frame)) {
         pcvdom_element_t elem = frame->pos;
-        purc_variant_t elem_id = pcvdom_element_eval_attr_val(stack, elem,
-                ATTR_KEY_ID);
-        if (!elem_id) {
-            frame = pcintr_stack_frame_get_parent(frame);
+        if (elem == NULL)
             continue;
+
+        /* a literal anchor is known since the vDOM was built, so only a
+           dynamic `id` is evaluated */
+        bool matched = false;
+        if (elem->anchor) {
+            matched = strcmp(elem->anchor, anchor) == 0;
         }
+        else if (elem->dynamic_id) {
+            purc_variant_t elem_id = pcvdom_element_eval_attr_val(stack,
+                    elem, ATTR_KEY_ID);
+            if (!elem_id)
+                continue;
 
-        if (purc_variant_is_string(elem_id)) {
             const char *id = purc_variant_get_string_const(elem_id);
-            if (id && id[0] == '#' && strcmp(id+1, anchor) == 0) {
-                ret = pcintr_get_symbol_var(frame, symbol_var);
-                if (ret == PURC_VARIANT_INVALID) {
-                    purc_set_error_with_info(PCVARIANT_ERROR_NOT_FOUND,
-                            "symbol:%c", symbol);
-                }
-                else {
-                    purc_clr_error();
-                }
-                purc_variant_unref(elem_id);
-                return ret;
+            matched = id && id[0] == '#' && strcmp(id + 1, anchor) == 0;
+            purc_variant_unref(elem_id);
+        }
+
+        if (matched) {
+            ret = pcintr_get_symbol_var(frame, symbol_var);
+            if (ret == PURC_VARIANT_INVALID) {
+                purc_set_error_with_info(PCVARIANT_ERROR_NOT_FOUND,
+                        "symbol:%c", symbol);
+            }
+            else {
+                purc_clr_error();
             }
+            return ret;
         }
-        purc_variant_unref(elem_id);
-        frame = pcintr_stack_frame_get_parent(frame);
     }
 
     return PURC_VARIANT_INVALID;
@@ -819,6 +932,8 @@ on_release(void *native_entity)
     PC_ASSERT(native_entity);
     struct pcvarmgr_named_variables_observe *named =
         (struct pcvarmgr_named_variables_observe*)native_entity;
+    PC_ASSERT(*named->nr_observers > 0);
+    (*named->nr_observers)--;
     named_destroy(named);
 }
 
@@ -853,12 +968,14 @@ pcintr_get_named_var_for_observed(pcintr_stack_t stack, const char *name,
 
     named->name = strdup(name);
     if (!named->name) {
+        free(named);
         purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
         return PURC_VARIANT_INVALID;
     }
 
     named->stack = stack;
     named->elem = elem;
+    named->nr_observers = named_observers_slot(stack, name);
 
     purc_variant_t v = purc_variant_make_native(named, &ops);
     if (v == PURC_VARIANT_INVALID) {
@@ -866,6 +983,8 @@ pcintr_get_named_var_for_observed(pcintr_stack_t stack, const char *name,
         return PURC_VARIANT_INVALID;
     }
 
+    /* counted until the observer is revoked and the variant is released */
+    (*named->nr_observers)++;
     return v;
 }
 
@@ -873,7 +992,7 @@ purc_variant_t
 pcintr_get_named_var_for_event(pcintr_stack_t stack, const char *name)
 {
     pcvarmgr_t mgr = pcintr_get_coroutine_variables(stack->co);
-    return pcvarmgr_build_event_observed(name, mgr);
+    return get_event_observed(mgr, name);
 }
 
 bool
@@ -0,0 +1,294 @@
+/*
+ * @file binary.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The binary framing of PurCMC messages.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A binary packet is made of, in order and in little endian:
+ *
+ *  - the magic `\0PCM` and the version of the framing (u8);
+ *  - the type, the target, the element type, the data type, and
+ *    the reduce option (u8 each);
+ *  - the return code (u32), the target value and the result value (u64);
+ *  - the operation or event name, the request identifier, the source URI,
+ *    the element value, and the property, as strings;
+ *  - the data: a binary eJSON value for JSON, a string for the others,
+ *    and nothing for void.
+ *
+ * A string is its length (u32) followed by the bytes, and the length
+ * 0xFFFFFFFF stands for a missing one.
+ *
+ * The binary eJSON values are the ones of the variant layer without the
+ * NUL bytes following the strings; see variant/binary.c.
+ *
+ * The packet is told from a text one by the magic, since a text packet
+ * never starts with a NUL.
+ */
+
+#include "config.h"
+#include "private/pcrdr.h"
+#include "private/instance.h"
+#include "private/variant.h"
+#include "private/errors.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#define LEN_NONE_STRING     0xFFFFFFFFU
+
+static void put_u8(pcrdr_cb_write fn, void *ctxt, uint8_t u8)
+{
+    fn(ctxt, &u8, 1);
+}
+
+static void put_u32(pcrdr_cb_write fn, void *ctxt, uint32_t u32)
+{
+    uint8_t buf[4];
+    for (int i = 0; i < 4; i++) {
+        buf[i] = (uint8_t)(u32 >> (i * 8));
+    }
+    fn(ctxt, buf, sizeof(buf));
+}
+
+static void put_u64(pcrdr_cb_write fn, void *ctxt, uint64_t u64)
+{
+    uint8_t buf[8];
+    for (int i = 0; i < 8; i++) {
+        buf[i] = (uint8_t)(u64 >> (i * 8));
+    }
+    fn(ctxt, buf, sizeof(buf));
+}
+
+static void put_bytes(pcrdr_cb_write fn, void *ctxt,
+        const void *bytes, size_t len)
+{
+    put_u32(fn, ctxt, (uint32_t)len);
+    if (len > 0)
+        fn(ctxt, bytes, len);
+}
+
+/* writes the string variant, or a missing string for any other */
+static void put_string_variant(pcrdr_cb_write fn, void *ctxt,
+        purc_variant_t v)
+{
+    size_t len;
+    const char *str = v ? purc_variant_get_string_const_ex(v, &len) : NULL;
+    if (str)
+        put_bytes(fn, ctxt, str, len);
+    else
+        put_u32(fn, ctxt, LEN_NONE_STRING);
+}
+
+int pcrdr_serialize_message_binary(const pcrdr_msg *msg,
+        pcrdr_cb_write fn, void *ctxt)
+{
+    fn(ctxt, PCRDR_BINARY_MAGIC, PCRDR_LEN_BINARY_MAGIC);
+    put_u8(fn, ctxt, PCRDR_BINARY_VERSION);
+
+    put_u8(fn, ctxt, (uint8_t)msg->type);
+    put_u8(fn, ctxt, (uint8_t)msg->target);
+    put_u8(fn, ctxt, (uint8_t)msg->elementType);
+    put_u8(fn, ctxt, (uint8_t)msg->dataType);
+    put_u8(fn, ctxt, (uint8_t)msg->reduceOpt);
+    put_u32(fn, ctxt, msg->retCode);
+    put_u64(fn, ctxt, msg->targetValue);
+    put_u64(fn, ctxt, msg->resultValue);
+
+    /* the variants but the data */
+    for (int i = 0; i < PCRDR_NR_MSG_VARIANTS - 1; i++) {
+        put_string_variant(fn, ctxt, msg->variants[i]);
+    }
+
+    if (msg->dataType == PCRDR_MSG_DATA_TYPE_VOID) {
+        // do nothing
+    }
+    else if (msg->dataType == PCRDR_MSG_DATA_TYPE_JSON) {
+        if (pcvariant_write_binary(fn, ctxt, msg->data, 0))
+            return PCRDR_ERROR_UNEXPECTED;
+    }
+    else {  /* for other text types */
+        size_t text_len;
+        const char *text = purc_variant_get_string_const_ex(msg->data,
+                &text_len);
+        if (text == NULL)
+            return PCRDR_ERROR_BAD_MESSAGE;
+        if (msg->textLen > 0)   /* override by textLen */
+            text_len = msg->textLen;
+        put_bytes(fn, ctxt, text, text_len);
+    }
+
+    return 0;
+}
+
+struct reader {
+    const uint8_t  *p;
+    const uint8_t  *end;
+};
+
+static bool get_u8(struct reader *rd, uint8_t *u8)
+{
+    if (rd->p + 1 > rd->end)
+        return false;
+    *u8 = *rd->p++;
+    return true;
+}
+
+static bool get_u32(struct reader *rd, uint32_t *u32)
+{
+    if (rd->p + 4 > rd->end)
+        return false;
+
+    *u32 = 0;
+    for (int i = 0; i < 4; i++) {
+        *u32 |= (uint32_t)rd->p[i] << (i * 8);
+    }
+    rd->p += 4;
+    return true;
+}
+
+static bool get_u64(struct reader *rd, uint64_t *u64)
+{
+    if (rd->p + 8 > rd->end)
+        return false;
+
+    *u64 = 0;
+    for (int i = 0; i < 8; i++) {
+        *u64 |= (uint64_t)rd->p[i] << (i * 8);
+    }
+    rd->p += 8;
+    return true;
+}
+
+/* the bytes are not terminated by NUL; *bytes is NULL for a missing one */
+static bool get_bytes(struct reader *rd, const char **bytes, size_t *len)
+{
+    uint32_t u32;
+    if (!get_u32(rd, &u32))
+        return false;
+
+    if (u32 == LEN_NONE_STRING) {
+        *bytes = NULL;
+        *len = 0;
+        return true;
+    }
+
+    if ((size_t)(rd->end - rd->p) < u32)
+        return false;
+
+    *bytes = (const char *)rd->p;
+    *len = u32;
+    rd->p += u32;
+    return true;
+}
+
+static purc_variant_t get_string_variant(struct reader *rd, bool *ok)
+{
+    const char *bytes;
+    size_t len;
+
+    *ok = get_bytes(rd, &bytes, &len);
+    if (!*ok || bytes == NULL)
+        return PURC_VARIANT_INVALID;
+
+    purc_variant_t v = purc_variant_make_string_ex(bytes, len, true);
+    if (v == PURC_VARIANT_INVALID)
+        *ok = false;
+    return v;
+}
+
+int pcrdr_parse_packet_binary(const char *packet, size_t sz_packet,
+        pcrdr_msg **msg_out)
+{
+    pcrdr_msg *msg;
+    struct reader rd = { (const uint8_t *)packet,
+        (const uint8_t *)packet + sz_packet };
+
+    if (!pcrdr_is_binary_packet(packet, sz_packet)) {
+        purc_set_error(PCRDR_ERROR_BAD_MESSAGE);
+        return -1;
+    }
+    rd.p += PCRDR_LEN_BINARY_MAGIC;
+
+    if ((msg = pcinst_get_message()) == NULL) {
+        purc_set_error(PCRDR_ERROR_NOMEM);
+        return -1;
+    }
+
+    uint8_t version, type, target, element_type, data_type, reduce_opt;
+    if (!get_u8(&rd, &version) || version != PCRDR_BINARY_VERSION ||
+            !get_u8(&rd, &type) || type >= PCRDR_MSG_TYPE_NR ||
+            !get_u8(&rd, &target) || target >= PCRDR_MSG_TARGET_NR ||
+            !get_u8(&rd, &element_type) ||
+            element_type >= PCRDR_MSG_ELEMENT_TYPE_NR ||
+            !get_u8(&rd, &data_type) || data_type >= PCRDR_MSG_DATA_TYPE_NR ||
+            !get_u8(&rd, &reduce_opt) ||
+            reduce_opt >= PCRDR_MSG_EVENT_REDUCE_OPT_NR ||
+            !get_u32(&rd, &msg->retCode) ||
+            !get_u64(&rd, &msg->targetValue) ||
+            !get_u64(&rd, &msg->resultValue)) {
+        goto failed;
+    }
+
+    msg->type = type;
+    msg->target = target;
+    msg->elementType = element_type;
+    msg->dataType = data_type;
+    msg->reduceOpt = reduce_opt;
+
+    for (int i = 0; i < PCRDR_NR_MSG_VARIANTS - 1; i++) {
+        bool ok;
+        msg->variants[i] = get_string_variant(&rd, &ok);
+        if (!ok)
+            goto failed;
+    }
+
+    if (msg->dataType == PCRDR_MSG_DATA_TYPE_VOID) {
+        // do nothing
+    }
+    else if (msg->dataType == PCRDR_MSG_DATA_TYPE_JSON) {
+        msg->data = pcvariant_read_binary(&rd.p, rd.end, 0);
+        if (msg->data == PURC_VARIANT_INVALID)
+            goto failed;
+    }
+    else {  /* for other text types */
+        bool ok;
+        msg->data = get_string_variant(&rd, &ok);
+        if (msg->data == PURC_VARIANT_INVALID)
+            goto failed;
+        size_t bytes;
+        purc_variant_string_bytes(msg->data, &bytes);
+        msg->__data_len = (unsigned int)bytes;
+    }
+
+    if (rd.p != rd.end)
+        goto failed;
+
+    *msg_out = msg;
+    return 0;
+
+failed:
+    pcrdr_release_message(msg);
+    purc_set_error(PCRDR_ERROR_BAD_MESSAGE);
+    return -1;
+}
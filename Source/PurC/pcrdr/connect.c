@@ -151,13 +151,44 @@ int pcrdr_conn_set_poll_timeout(pcrdr_conn* conn, int timeout_ms)
 
 size_t pcrdr_conn_pending_requests_count(pcrdr_conn* conn)
 {
-    size_t n = 0;
-    struct pending_request *pr;
-    list_for_each_entry(pr, &conn->pending_requests, list) {
-        n++;
-    }
+    return conn->nr_pending_requests;
+}
+
+size_t pcrdr_conn_set_max_inflight_requests(pcrdr_conn* conn, size_t max)
+{
+    size_t old = conn->max_inflight_requests;
+    conn->max_inflight_requests = max;
+    return old;
+}
+
+size_t pcrdr_conn_inflight_credits(pcrdr_conn* conn)
+{
+    if (conn->max_inflight_requests == 0)
+        return SIZE_MAX;
+
+    if (conn->nr_pending_requests >= conn->max_inflight_requests)
+        return 0;
+
+    return conn->max_inflight_requests - conn->nr_pending_requests;
+}
 
-    return n;
+static void
+add_pending_request(pcrdr_conn *conn, struct pending_request *pr, bool head)
+{
+    if (head)
+        list_add(&pr->list, &conn->pending_requests);
+    else
+        list_add_tail(&pr->list, &conn->pending_requests);
+    conn->nr_pending_requests++;
+}
+
+static void
+remove_pending_request(pcrdr_conn *conn, struct pending_request *pr)
+{
+    list_del(&pr->list);
+    purc_variant_unref(pr->request_id);
+    free(pr);
+    conn->nr_pending_requests--;
 }
 
 int pcrdr_free_connection(pcrdr_conn* conn)
@@ -175,9 +206,7 @@ int pcrdr_free_connection(pcrdr_conn* conn)
                     purc_variant_get_string_const(pr->request_id),
                     PCRDR_RESPONSE_CANCELLED, pr->context, NULL);
         }
-        list_del(&pr->list);
-        purc_variant_unref(pr->request_id);
-        free(pr);
+        remove_pending_request(conn, pr);
     }
 
     free(conn);
@@ -244,7 +273,26 @@ pcrdr_set_handler_for_response_from_extra_source(pcrdr_conn* conn,
         pr->time_expected = purc_get_monotoic_time() + 3600;
     else
         pr->time_expected = purc_get_monotoic_time() + seconds_expected;
-    list_add_tail(&pr->list, &conn->pending_requests);
+    add_pending_request(conn, pr, false);
+
+    return 0;
+}
+
+/*
+ * Waits until a request can be sent within the in-flight limit, by handling
+ * the messages from the renderer in the meantime; so a slow renderer makes
+ * the sender wait instead of the pending requests piling up.
+ */
+static int
+wait_for_inflight_credits(pcrdr_conn* conn)
+{
+    while (pcrdr_conn_inflight_credits(conn) == 0) {
+        if (pcrdr_wait_and_dispatch_message(conn, conn->timeout_ms) < 0) {
+            if (purc_get_last_error() != PCRDR_ERROR_TIMEOUT)
+                return -1;
+            purc_clr_error();
+        }
+    }
 
     return 0;
 }
@@ -260,6 +308,10 @@ int pcrdr_send_request(pcrdr_conn* conn, pcrdr_msg *request_msg,
         return -1;
     }
 
+    if (wait_for_inflight_credits(conn) < 0) {
+        return -1;
+    }
+
     if (conn->send_message(conn, request_msg) < 0) {
         return -1;
     }
@@ -280,16 +332,22 @@ variant_strcmp(purc_variant_t a, purc_variant_t b)
             purc_variant_get_string_const(b));
 }
 
+/*
+ * The requests sent without waiting are pending along with the one being
+ * waited for, which is put at the head of the list; so the response is
+ * matched against all pending requests rather than the first one only.
+ */
 static int
 handle_response_message(pcrdr_conn* conn, const pcrdr_msg *msg)
 {
-    int retval = -1;
-
-    if (!list_empty(&conn->pending_requests)) {
-        struct pending_request *pr;
-        pr = list_first_entry(&conn->pending_requests,
-                struct pending_request, list);
+    if (list_empty(&conn->pending_requests)) {
+        purc_log_error("no pending request?\n");
+        purc_set_error(PCRDR_ERROR_UNEXPECTED);
+        return -1;
+    }
 
+    struct pending_request *pr;
+    list_for_each_entry(pr, &conn->pending_requests, list) {
         if (variant_strcmp(msg->requestId, pr->request_id) == 0) {
             const char *request_id =
                 purc_variant_get_string_const(msg->requestId);
@@ -300,22 +358,14 @@ handle_response_message(pcrdr_conn* conn, const pcrdr_msg *msg)
                         request_id);
             }
 
-            retval = 0;
-            list_del(&pr->list);
-            purc_variant_unref(pr->request_id);
-            free(pr);
-        }
-        else {
-            purc_log_error("response not matched the first pending request\n");
-            purc_set_error(PCRDR_ERROR_UNEXPECTED);
+            remove_pending_request(conn, pr);
+            return 0;
         }
     }
-    else {
-        purc_log_error("no pending request?\n");
-        purc_set_error(PCRDR_ERROR_UNEXPECTED);
-    }
 
-    return retval;
+    purc_log_error("response not matched any pending request\n");
+    purc_set_error(PCRDR_ERROR_UNEXPECTED);
+    return -1;
 }
 
 static int
@@ -332,9 +382,7 @@ check_timeout_requests(pcrdr_conn *conn)
                         PCRDR_RESPONSE_TIMEOUT, pr->context, NULL);
             }
 
-            list_del(&pr->list);
-            purc_variant_unref(pr->request_id);
-            free(pr);
+            remove_pending_request(conn, pr);
         }
     }
 
@@ -510,7 +558,7 @@ pcrdr_wait_response_for_specific_request(pcrdr_conn* conn,
         pr->time_expected = purc_get_monotoic_time() + 3600;
     else
         pr->time_expected = purc_get_monotoic_time() + seconds_expected;
-    list_add(&pr->list, &conn->pending_requests);
+    add_pending_request(conn, pr, true);
 
     while (*response_msg == NULL) {
         pcrdr_msg *msg;
@@ -560,9 +608,7 @@ pcrdr_wait_response_for_specific_request(pcrdr_conn* conn,
     }
 
     if (*response_msg == NULL) {
-        list_del(&pr->list);
-        purc_variant_unref(pr->request_id);
-        free(pr);
+        remove_pending_request(conn, pr);
     }
     else if (*response_msg == MSG_POINTER_INVALID) {
         *response_msg = NULL;   /* reset response messge to NULL */
@@ -584,6 +630,10 @@ int pcrdr_send_request_and_wait_response(pcrdr_conn* conn,
         return -1;
     }
 
+    if (wait_for_inflight_credits(conn) < 0) {
+        return -1;
+    }
+
     if (conn->send_message(conn, request_msg) < 0) {
         return -1;
     }
@@ -43,6 +43,7 @@ struct pending_request {
 };
 
 struct pcrdr_prot_data;
+struct pcrdr_ws;
 
 struct pcrdr_conn {
     int prot;
@@ -57,6 +58,7 @@ struct pcrdr_conn {
 
     void *user_data;
     struct pcrdr_prot_data *prot_data;
+    struct pcrdr_ws *ws;    /* the WebSocket, for CT_WEB_SOCKET */
 
     pcrdr_extra_message_source source_fn;
     void *source_ctxt; /* context for extra message source */
@@ -64,8 +66,15 @@ struct pcrdr_conn {
     pcrdr_request_handler request_handler;
     pcrdr_event_handler event_handler;
 
+    /* whether to send messages in the binary framing */
+    bool binary_framing;
+
     /* the pending requests queue */
     struct list_head pending_requests;
+    size_t nr_pending_requests;
+
+    /* the requests allowed in flight at most; 0 for no limit */
+    size_t max_inflight_requests;
 
     /* operations */
     int (*wait_message) (pcrdr_conn* conn, int timeout_ms);
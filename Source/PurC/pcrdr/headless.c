@@ -56,7 +56,8 @@
     "workspace:" __STRING(8)                        \
     "/tabbedWindow:" __STRING(8)                    \
     "/widgetInTabbedWindow:" __STRING(32)           \
-    "/plainWindow:" __STRING(256)
+    "/plainWindow:" __STRING(256) "\n"           \
+    "batchOperations:" __STRING(64)
 
 struct tabbed_window_info {
     // handle of this tabbedWindow; NULL for not used slot.
@@ -110,10 +111,26 @@ struct result_info {
     purc_variant_t data;
 };
 
+enum {
+    HEADLESS_MODE_LOG = 0,  // evaluate the requests and log the messages
+    HEADLESS_MODE_NOLOG,    // evaluate the requests without log
+    HEADLESS_MODE_NULL,     // count the requests and ack immediately
+};
+
 struct pcrdr_prot_data {
-    // FILE pointer to serialize the message.
+    // FILE pointer to serialize the message; NULL if no log.
     FILE                *fp;
 
+    // the running mode.
+    int                  mode;
+
+    // the counters of the messages.
+    size_t               nr_requests;
+    size_t               nr_responses;
+
+    // the last fake handle returned in the null mode.
+    uint64_t             last_handle;
+
     // requestId -> results;
     struct kvlist        results;
 
@@ -144,7 +161,11 @@ static struct result_info *result_of_first_request(pcrdr_conn* conn)
 
 static int my_wait_message(pcrdr_conn* conn, int timeout_ms)
 {
-    if (result_of_first_request(conn) == NULL) {
+    if (conn->prot_data->mode == HEADLESS_MODE_NULL) {
+        if (!list_empty(&conn->pending_requests))
+            return 1;
+    }
+    else if (result_of_first_request(conn) == NULL) {
         if (timeout_ms > 1000) {
             pcutils_sleep(timeout_ms / 1000);
         }
@@ -173,11 +194,42 @@ static ssize_t write_to_log(void *ctxt, const void *buf, size_t count)
     return -1;
 }
 
+static pcrdr_msg *read_null_response(pcrdr_conn* conn)
+{
+    pcrdr_msg* msg;
+
+    if (list_empty(&conn->pending_requests)) {
+        purc_set_error(PCRDR_ERROR_UNEXPECTED);
+        return NULL;
+    }
+
+    struct pending_request *pr;
+    pr = list_first_entry(&conn->pending_requests,
+            struct pending_request, list);
+
+    msg = pcrdr_make_response_message(
+            purc_variant_get_string_const(pr->request_id), NULL,
+            PCRDR_SC_OK, ++conn->prot_data->last_handle,
+            PCRDR_MSG_DATA_TYPE_VOID, NULL, 0);
+    if (msg == NULL) {
+        purc_set_error(PCRDR_ERROR_NOMEM);
+    }
+    else {
+        conn->prot_data->nr_responses++;
+    }
+
+    return msg;
+}
+
 static pcrdr_msg *my_read_message(pcrdr_conn* conn)
 {
     pcrdr_msg* msg = NULL;
     struct result_info *result;
 
+    if (conn->prot_data->mode == HEADLESS_MODE_NULL) {
+        return read_null_response(conn);
+    }
+
     if ((result = result_of_first_request(conn)) == NULL) {
         purc_log_warn("There is not any result for the first request.\n");
         purc_set_error(PCRDR_ERROR_UNEXPECTED);
@@ -195,8 +247,10 @@ static pcrdr_msg *my_read_message(pcrdr_conn* conn)
             request_id, NULL,
             result->retCode, (uint64_t)(uintptr_t)result->resultValue,
             PCRDR_MSG_DATA_TYPE_VOID, NULL, 0);
-    msg->dataType = result->data_type;
-    msg->data = result->data;
+    if (msg) {
+        msg->dataType = result->data_type;
+        msg->data = result->data;
+    }
 
     pcutils_kvlist_delete(&conn->prot_data->results, request_id);
     free(result);
@@ -205,10 +259,13 @@ static pcrdr_msg *my_read_message(pcrdr_conn* conn)
         purc_set_error(PCRDR_ERROR_NOMEM);
     }
     else {
-        fputs("<<<\n", conn->prot_data->fp);
-        pcrdr_serialize_message(msg,
-                (pcrdr_cb_write)write_to_log, conn->prot_data->fp);
-        fputs("\n<<<END\n", conn->prot_data->fp);
+        conn->prot_data->nr_responses++;
+        if (conn->prot_data->fp) {
+            fputs("<<<\n", conn->prot_data->fp);
+            pcrdr_serialize_message(msg,
+                    (pcrdr_cb_write)write_to_log, conn->prot_data->fp);
+            fputs("\n<<<END\n", conn->prot_data->fp);
+        }
     }
 
     return msg;
@@ -1318,6 +1375,7 @@ static request_handler handlers[] = {
     on_call_method,
     on_get_property,
     on_set_property,
+    on_operate_dom,
 };
 
 /* make sure the number of operation handlers matches the enumulators */
@@ -1360,12 +1418,19 @@ done:
 
 static int my_send_message(pcrdr_conn* conn, pcrdr_msg *msg)
 {
-    fputs(">>>\n", conn->prot_data->fp);
-    if (pcrdr_serialize_message(msg,
-                (pcrdr_cb_write)write_to_log, conn->prot_data->fp) < 0) {
-        goto failed;
+    conn->prot_data->nr_requests++;
+    if (conn->prot_data->mode == HEADLESS_MODE_NULL) {
+        return 0;
+    }
+
+    if (conn->prot_data->fp) {
+        fputs(">>>\n", conn->prot_data->fp);
+        if (pcrdr_serialize_message(msg,
+                    (pcrdr_cb_write)write_to_log, conn->prot_data->fp) < 0) {
+            goto failed;
+        }
+        fputs("\n>>>END\n", conn->prot_data->fp);
     }
-    fputs("\n>>>END\n", conn->prot_data->fp);
 
     evaluate_result(conn->prot_data, msg);
     return 0;
@@ -1394,7 +1459,12 @@ static int my_disconnect(pcrdr_conn* conn)
     }
 
     pcutils_kvlist_free(&conn->prot_data->results);
-    fclose(conn->prot_data->fp);
+    if (conn->prot_data->fp)
+        fclose(conn->prot_data->fp);
+    else
+        PC_INFO("Headless renderer: %u requests, %u responses\n",
+                (unsigned)conn->prot_data->nr_requests,
+                (unsigned)conn->prot_data->nr_responses);
     if (conn->prot_data->session)
         free(conn->prot_data->session);
     free(conn->prot_data);
@@ -1433,7 +1503,17 @@ pcrdr_msg *pcrdr_headless_connect(const char* renderer_uri,
         goto failed;
     }
 
-    if (renderer_uri && strlen(renderer_uri) > sizeof(SCHEMA_LOCAL_FILE)) {
+    if (renderer_uri && strcmp(renderer_uri, PCRDR_HEADLESS_URI_NULL) == 0) {
+        (*conn)->prot_data->mode = HEADLESS_MODE_NULL;
+        logfile = NULL;
+    }
+    else if (renderer_uri &&
+            strcmp(renderer_uri, PCRDR_HEADLESS_URI_NOLOG) == 0) {
+        (*conn)->prot_data->mode = HEADLESS_MODE_NOLOG;
+        logfile = NULL;
+    }
+    else if (renderer_uri &&
+            strlen(renderer_uri) > sizeof(SCHEMA_LOCAL_FILE)) {
         logfile = renderer_uri + sizeof(SCHEMA_LOCAL_FILE) - 1;
     }
     else {
@@ -1452,10 +1532,12 @@ pcrdr_msg *pcrdr_headless_connect(const char* renderer_uri,
         logfile = buff;
     }
 
-    (*conn)->prot_data->fp = fopen(logfile, "a");
-    if ((*conn)->prot_data->fp == NULL) {
-        purc_set_error(PURC_ERROR_BAD_STDC_CALL);
-        goto failed;
+    if (logfile) {
+        (*conn)->prot_data->fp = fopen(logfile, "a");
+        if ((*conn)->prot_data->fp == NULL) {
+            purc_set_error(PURC_ERROR_BAD_STDC_CALL);
+            goto failed;
+        }
     }
 
     pcutils_kvlist_init(&(*conn)->prot_data->results, NULL);
@@ -1468,7 +1550,7 @@ pcrdr_msg *pcrdr_headless_connect(const char* renderer_uri,
         purc_set_error(PCRDR_ERROR_NOMEM);
         goto failed;
     }
-    else {
+    else if ((*conn)->prot_data->fp) {
         fputs("<<<\n", (*conn)->prot_data->fp);
         pcrdr_serialize_message(msg,
                     (pcrdr_cb_write)write_to_log, (*conn)->prot_data->fp);
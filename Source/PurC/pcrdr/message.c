@@ -612,6 +612,14 @@ _COMPILE_TIME_ASSERT(data_types,
         PCA_TABLESIZE(data_type_names) == PCRDR_MSG_DATA_TYPE_NR);
 #undef _COMPILE_TIME_ASSERT
 
+const char *pcrdr_data_type_name(pcrdr_msg_data_type data_type)
+{
+    if (data_type <= PCRDR_MSG_DATA_TYPE_LAST)
+        return data_type_names[data_type - PCRDR_MSG_DATA_TYPE_FIRST];
+
+    return NULL;
+}
+
 static bool on_data_type(pcrdr_msg *msg, char *value)
 {
     for (size_t i = 0; i < PCA_TABLESIZE(data_type_names); i++) {
@@ -703,7 +711,9 @@ int pcrdr_parse_packet(char *packet, size_t sz_packet, pcrdr_msg **msg_out)
     char *saveptr1;
     char *data;
 
-    UNUSED_PARAM(sz_packet);
+    if (pcrdr_is_binary_packet(packet, sz_packet)) {
+        return pcrdr_parse_packet_binary(packet, sz_packet, msg_out);
+    }
 
     if ((msg = pcinst_get_message()) == NULL) {
         purc_set_error(PCRDR_ERROR_NOMEM);
@@ -793,27 +803,28 @@ serialize_message_data(const pcrdr_msg *msg, pcrdr_cb_write fn, void *ctxt)
     int n, errcode = 0;
     size_t text_len = 0;
     const char *text = NULL;
-    char *text_alloc = NULL;
+    purc_rwstream_t rope = NULL;
 
     if (msg->dataType == PCRDR_MSG_DATA_TYPE_VOID) {
         // do nothing
     }
     else if (msg->dataType == PCRDR_MSG_DATA_TYPE_JSON) {
-        purc_rwstream_t buffer = NULL;
-        buffer = purc_rwstream_new_buffer(PCRDR_MIN_PACKET_BUFF_SIZE,
+        /* the chunks are written out without being made contiguous */
+        rope = purc_rwstream_new_rope(PCRDR_MIN_PACKET_BUFF_SIZE,
                 PCRDR_MAX_INMEM_PAYLOAD_SIZE);
+        if (rope == NULL) {
+            errcode = purc_get_last_error();
+            goto done;
+        }
 
         /* always serialize as a standard JSON */
-        if (purc_variant_serialize(msg->data, buffer, 0,
+        if (purc_variant_serialize(msg->data, rope, 0,
                 PCVARIANT_SERIALIZE_OPT_PLAIN, NULL) < 0) {
             errcode = purc_get_last_error();
             goto done;
         }
 
-        text_alloc = purc_rwstream_get_mem_buffer_ex(buffer, &text_len,
-                NULL, true);
-        text = text_alloc;
-        purc_rwstream_destroy(buffer);
+        text_len = purc_rwstream_tell(rope);
     }
     else {  /* for other text types */
         text = purc_variant_get_string_const_ex(msg->data, &text_len);
@@ -849,14 +860,25 @@ serialize_message_data(const pcrdr_msg *msg, pcrdr_cb_write fn, void *ctxt)
     /* a blank line */
     fn(ctxt, STR_BLANK_LINE, sizeof(STR_BLANK_LINE) - 1);
 
-    if (text && text_len > 0) {
+    if (rope && text_len > 0) {
+        purc_rwstream_t out = purc_rwstream_new_for_dump(ctxt, fn);
+        if (out) {
+            purc_rwstream_seek(rope, 0, SEEK_SET);
+            purc_rwstream_dump_to_another(rope, out, -1);
+            purc_rwstream_destroy(out);
+        }
+        else {
+            errcode = purc_get_last_error();
+        }
+    }
+    else if (text && text_len > 0) {
         /* the data */
         fn(ctxt, text, text_len);
     }
 
 done:
-    if (text_alloc)
-        free(text_alloc);
+    if (rope)
+        purc_rwstream_destroy(rope);
 
     return errcode;
 }
@@ -1266,8 +1288,16 @@ pcrdr_parse_renderer_capabilities(const char *data)
                 rdr_caps->windowLevel = 0;
             }
 #endif
-            PC_WARN("Unknown renderer capability: %s\n", cap);
-            break;
+            if (pcutils_strcasecmp(cap, "batchOperations") == 0) {
+                rdr_caps->batchOperations = strtol(value, NULL, 10);
+            }
+            else if (pcutils_strcasecmp(cap, "binaryFraming") == 0) {
+                rdr_caps->binaryFraming = strtol(value, NULL, 10);
+            }
+            else {
+                PC_WARN("Unknown renderer capability: %s\n", cap);
+                break;
+            }
         }
 
         line_no++;
@@ -86,6 +86,7 @@ static struct pcrdr_opatom {
     { PCRDR_OPERATION_CALLMETHOD,           0 }, // "callMethod"
     { PCRDR_OPERATION_GETPROPERTY,          0 }, // "getProperty"
     { PCRDR_OPERATION_SETPROPERTY,          0 }, // "setProperty"
+    { PCRDR_OPERATION_BATCHOPERATIONS,      0 }, // "batchOperations"
 };
 
 /* make sure the number of operations matches the enumulators */
@@ -192,7 +193,7 @@ static int _init_instance(struct pcinst *curr_inst,
         goto failed;
     }
 
-    purc_variant_t vs[10] = { NULL };
+    purc_variant_t vs[12] = { NULL };
     vs[0] = purc_variant_make_string_static("protocolName", false);
     vs[1] = purc_variant_make_string_static(prot_names[rdr_prot], false);
     vs[2] = purc_variant_make_string_static("protocolVersion", false);
@@ -204,13 +205,16 @@ static int _init_instance(struct pcinst *curr_inst,
     vs[7] = purc_variant_make_string_static(inst->app_name, false);
     vs[8] = purc_variant_make_string_static("runnerName", false);
     vs[9] = purc_variant_make_string_static(inst->runner_name, false);
+    /* tell the renderer we understand the binary framing too */
+    vs[10] = purc_variant_make_string_static("binaryFraming", false);
+    vs[11] = purc_variant_make_ulongint(PCRDR_BINARY_VERSION);
 
     session_data = purc_variant_make_object(0, NULL, NULL);
-    if (session_data == PURC_VARIANT_INVALID || vs[9] == NULL) {
+    if (session_data == PURC_VARIANT_INVALID || vs[11] == NULL) {
         purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
         goto failed;
     }
-    for (int i = 0; i < 5; i++) {
+    for (int i = 0; i < 6; i++) {
         purc_variant_object_set(session_data, vs[i * 2], vs[i * 2 + 1]);
         purc_variant_unref(vs[i * 2]);
         purc_variant_unref(vs[i * 2 + 1]);
@@ -229,6 +233,17 @@ static int _init_instance(struct pcinst *curr_inst,
     int ret_code = response_msg->retCode;
     if (ret_code == PCRDR_SC_OK) {
         inst->rdr_caps->session_handle = response_msg->resultValue;
+
+        /* switch to the binary framing if the renderer supports it;
+           the text one is still parsed from the renderer */
+        if (rdr_prot == PURC_RDRPROT_PURCMC &&
+                inst->rdr_caps->binaryFraming == PCRDR_BINARY_VERSION) {
+            inst->conn_to_rdr->binary_framing = true;
+        }
+
+        /* bound the requests sent without waiting for the responses */
+        pcrdr_conn_set_max_inflight_requests(inst->conn_to_rdr,
+                PCRDR_DEF_INFLIGHT_REQUESTS);
     }
 
     pcrdr_release_message(response_msg);
@@ -363,6 +378,7 @@ static void _cleanup_instance(struct pcinst* inst)
 }
 
 struct pcmodule _module_renderer = {
+    .name            = "renderer",
     .id              = PURC_HAVE_PCRDR,
     .module_inited   = 0,
 
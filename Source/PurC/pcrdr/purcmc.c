@@ -27,8 +27,10 @@
 #include "private/list.h"
 #include "private/debug.h"
 #include "private/utils.h"
+#include "private/pcrdr.h"
 #include "purc-utils.h"
 #include "connect.h"
+#include "websocket.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -47,10 +49,17 @@
 #include <sys/fcntl.h>
 #include <sys/un.h>
 #include <sys/time.h>
+#include <sys/uio.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 
 #define CLI_PATH    "/var/tmp/"
 #define CLI_PERM    S_IRWXU
 
+/* the segments of a packet: the head, the data, and the tail */
+#define MAX_PACKET_SEGMENTS     3
+
 static inline int conn_read (int fd, void *buff, ssize_t sz)
 {
     if (read (fd, buff, sz) == sz) {
@@ -86,6 +95,9 @@ static int my_wait_message (pcrdr_conn* conn, int timeout_ms)
     return select (conn->fd + 1, &rfds, NULL, NULL, NULL);
 }
 
+static int send_segments (pcrdr_conn* conn, int op,
+        const struct iovec *segs, int nr_segs);
+
 static pcrdr_msg *my_read_message (pcrdr_conn* conn)
 {
     void* packet;
@@ -125,33 +137,104 @@ done:
     return msg;
 }
 
+/*
+ * The message is serialized with the bytes copied into a buffer, but the
+ * text of the data, which is the large part of a message such as a chunk
+ * of a document, is referenced in place.
+ */
+struct gather_ctxt {
+    char       *buf;
+    size_t      len;
+    size_t      sz;
+
+    const char *ref;        /* the bytes to reference in place */
+    size_t      ref_len;
+    size_t      ref_off;    /* the offset of them in the packet */
+    bool        referenced;
+    bool        failed;
+};
+
+static ssize_t gather_write (void *ctxt, const void *buf, size_t count)
+{
+    struct gather_ctxt *gc = ctxt;
+
+    if (!gc->referenced && gc->ref && buf == gc->ref &&
+            count == gc->ref_len) {
+        gc->ref_off = gc->len;
+        gc->referenced = true;
+        return count;
+    }
+
+    if (gc->len + count > gc->sz) {
+        size_t sz = gc->sz ? gc->sz : PCRDR_MIN_PACKET_BUFF_SIZE;
+        while (sz < gc->len + count)
+            sz <<= 1;
+
+        char *p = realloc (gc->buf, sz);
+        if (p == NULL) {
+            gc->failed = true;
+            return -1;
+        }
+        gc->buf = p;
+        gc->sz = sz;
+    }
+
+    memcpy (gc->buf + gc->len, buf, count);
+    gc->len += count;
+    return count;
+}
+
 static int my_send_message (pcrdr_conn* conn, pcrdr_msg *msg)
 {
     int retv = -1;
-    purc_rwstream_t buffer = NULL;
+    struct gather_ctxt gc = { 0 };
+
+    if (msg->dataType != PCRDR_MSG_DATA_TYPE_VOID &&
+            msg->dataType != PCRDR_MSG_DATA_TYPE_JSON && msg->data) {
+        gc.ref = purc_variant_get_string_const_ex (msg->data, &gc.ref_len);
+        if (msg->textLen > 0)   /* override by textLen */
+            gc.ref_len = msg->textLen;
+        if (gc.ref_len == 0)
+            gc.ref = NULL;
+    }
+
+    int (*serialize) (const pcrdr_msg *, pcrdr_cb_write, void *);
+    serialize = conn->binary_framing ?
+        pcrdr_serialize_message_binary : pcrdr_serialize_message;
+    int err_code = serialize (msg, gather_write, &gc);
+    if (err_code || gc.failed) {
+        purc_set_error (gc.failed ? PCRDR_ERROR_NOMEM : err_code);
+        goto done;
+    }
 
-    buffer = purc_rwstream_new_buffer (PCRDR_MIN_PACKET_BUFF_SIZE,
-            PCRDR_MAX_INMEM_PAYLOAD_SIZE);
+    if (!gc.referenced) {
+        gc.ref_off = gc.len;
+        gc.ref_len = 0;
+    }
 
-    if (pcrdr_serialize_message (msg,
-                (pcrdr_cb_write)purc_rwstream_write, buffer) < 0) {
+    if (gc.len + gc.ref_len > PCRDR_MAX_INMEM_PAYLOAD_SIZE) {
+        purc_set_error (PCRDR_ERROR_TOO_LARGE);
         goto done;
     }
 
-    size_t packet_len;
-    const char * packet = purc_rwstream_get_mem_buffer (buffer, &packet_len);
+    struct iovec segs[MAX_PACKET_SEGMENTS] = {
+        { gc.buf, gc.ref_off },
+        { (void *)gc.ref, gc.ref_len },
+        { gc.buf + gc.ref_off, gc.len - gc.ref_off },
+    };
 
-    if (pcrdr_purcmc_send_text_packet (conn, packet, packet_len) < 0) {
+    err_code = send_segments (conn,
+            conn->binary_framing ? US_OPCODE_BIN : US_OPCODE_TEXT,
+            segs, MAX_PACKET_SEGMENTS);
+    if (err_code) {
+        purc_set_error (err_code);
         goto done;
     }
 
     retv = 0;
 
 done:
-    if (buffer) {
-        purc_rwstream_destroy(buffer);
-    }
-
+    free (gc.buf);
     return retv;
 }
 
@@ -170,8 +253,7 @@ static int my_ping_peer (pcrdr_conn* conn)
         }
     }
     else if (conn->type == CT_WEB_SOCKET) {
-        /* TODO */
-        err_code = PCRDR_ERROR_NOT_IMPLEMENTED;
+        err_code = pcrdr_ws_send_control (conn->ws, WS_OPCODE_PING, NULL, 0);
     }
     else {
         err_code = PCRDR_ERROR_INVALID_VALUE;
@@ -201,8 +283,8 @@ static int my_disconnect (pcrdr_conn* conn)
         }
     }
     else if (conn->type == CT_WEB_SOCKET) {
-        /* TODO */
-        err_code = PCRDR_ERROR_NOT_IMPLEMENTED;
+        pcrdr_ws_delete (conn->ws, true);
+        conn->ws = NULL;
     }
     else {
         err_code = PCRDR_ERROR_INVALID_VALUE;
@@ -316,16 +398,95 @@ error:
     return -1;
 }
 
-int pcrdr_purcmc_connect_via_web_socket (const char* host_name, int port,
-        const char* app_name, const char* runner_name, pcrdr_conn** conn)
+/* returns fd if all OK, -1 on error */
+static int purcmc_connect_via_web_socket (const char* host_name, int port,
+        const char* path, const char* app_name, const char* runner_name,
+        pcrdr_conn** conn)
 {
-    UNUSED_PARAM(host_name);
-    UNUSED_PARAM(port);
-    UNUSED_PARAM(app_name);
-    UNUSED_PARAM(runner_name);
-    UNUSED_PARAM(conn);
+    int fd = -1, err_code = PCRDR_ERROR_BAD_CONNECTION;
+    struct addrinfo hints, *addrs = NULL, *ai;
+    char port_str[16];
+
+    *conn = NULL;
+    if (!purc_is_valid_app_name(app_name) ||
+            !purc_is_valid_runner_name(runner_name)) {
+        purc_set_error(PURC_EXCEPT_INVALID_VALUE);
+        return -1;
+    }
+
+    memset (&hints, 0, sizeof (hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    snprintf (port_str, sizeof (port_str), "%d", port);
+    if (getaddrinfo (host_name, port_str, &hints, &addrs)) {
+        PC_DEBUG ("Failed to resolve the host %s\n", host_name);
+        goto error;
+    }
+
+    for (ai = addrs; ai; ai = ai->ai_next) {
+        fd = socket (ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0)
+            continue;
+
+        if (connect (fd, ai->ai_addr, ai->ai_addrlen) == 0)
+            break;
+
+        close (fd);
+        fd = -1;
+    }
+    freeaddrinfo (addrs);
+
+    if (fd < 0) {
+        PC_DEBUG ("Failed to connect to %s:%d: %s\n", host_name, port,
+                strerror (errno));
+        goto error;
+    }
+
+    /* the frames are written in whole; do not delay the small ones */
+    int on = 1;
+    setsockopt (fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof (on));
+
+    if ((*conn = calloc (1, sizeof (pcrdr_conn))) == NULL) {
+        PC_DEBUG ("Failed to callocate space for connection: %s\n",
+                strerror (errno));
+        err_code = PCRDR_ERROR_NOMEM;
+        goto error;
+    }
+
+    /* offer permessage-deflate; the renderer may decline it */
+    if (((*conn)->ws = pcrdr_ws_handshake (fd, host_name, port, path,
+                    true)) == NULL) {
+        err_code = purc_get_last_error ();
+        goto error;
+    }
+
+    (*conn)->prot = PURC_RDRPROT_PURCMC;
+    (*conn)->type = CT_WEB_SOCKET;
+    (*conn)->fd = fd;
+    (*conn)->timeout_ms = 10;   /* 10 milliseconds */
+    (*conn)->srv_host_name = strdup (host_name);
+    (*conn)->own_host_name = strdup (PCRDR_LOCALHOST);
+    (*conn)->app_name = app_name;
+    (*conn)->runner_name = runner_name;
+
+    (*conn)->wait_message = my_wait_message;
+    (*conn)->read_message = my_read_message;
+    (*conn)->send_message = my_send_message;
+    (*conn)->ping_peer = my_ping_peer;
+    (*conn)->disconnect = my_disconnect;
+
+    list_head_init (&(*conn)->pending_requests);
+
+    return fd;
+
+error:
+    if (fd >= 0)
+        close (fd);
+
+    free (*conn);
+    *conn = NULL;
 
-    purc_set_error (PCRDR_ERROR_NOT_IMPLEMENTED);
+    purc_set_error (err_code);
     return -1;
 }
 
@@ -434,8 +595,21 @@ int pcrdr_purcmc_read_packet (pcrdr_conn* conn, char* packet_buf, size_t *sz_pac
         }
     }
     else if (conn->type == CT_WEB_SOCKET) {
-        /* TODO */
-        err_code = PCRDR_ERROR_NOT_IMPLEMENTED;
+        void *packet;
+        size_t len;
+
+        err_code = pcrdr_ws_read_message (conn->ws, &packet, &len);
+        if (err_code == 0) {
+            if (len > *sz_packet) {
+                err_code = PCRDR_ERROR_TOO_LARGE;
+            }
+            else {
+                if (len > 0)
+                    memcpy (packet_buf, packet, len);
+                *sz_packet = len;
+            }
+            free (packet);
+        }
     }
     else {
         err_code = PCRDR_ERROR_INVALID_VALUE;
@@ -571,8 +745,8 @@ int pcrdr_purcmc_read_packet_alloc (pcrdr_conn* conn, void **packet, size_t *sz_
         }
     }
     else if (conn->type == CT_WEB_SOCKET) {
-        /* TODO */
-        err_code = PCRDR_ERROR_NOT_IMPLEMENTED;
+        err_code = pcrdr_ws_read_message (conn->ws,
+                (void **)&packet_buf, sz_packet);
         goto done;
     }
     else {
@@ -595,62 +769,177 @@ done:
     return 0;
 }
 
-int pcrdr_purcmc_send_text_packet (pcrdr_conn* conn, const char* text, size_t len)
+/* writes all vectors, and the vectors are consumed */
+static int conn_writev (int fd, struct iovec *iov, int iovcnt)
 {
-    int retv = 0;
+    while (iovcnt > 0) {
+        ssize_t n = writev (fd, iov, iovcnt);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return PCRDR_ERROR_IO;
+        }
 
-    if (conn->type == CT_UNIX_SOCKET) {
-        USFrameHeader header;
+        while (iovcnt > 0 && (size_t)n >= iov->iov_len) {
+            n -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
 
-        if (len > PCRDR_MAX_FRAME_PAYLOAD_SIZE) {
-            size_t left = len;
+        if (iovcnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
 
-            do {
-                if (left == len) {
-                    header.op = US_OPCODE_TEXT;
-                    header.fragmented = len;
-                    header.sz_payload = PCRDR_MAX_FRAME_PAYLOAD_SIZE;
-                    left -= PCRDR_MAX_FRAME_PAYLOAD_SIZE;
-                }
-                else if (left > PCRDR_MAX_FRAME_PAYLOAD_SIZE) {
-                    header.op = US_OPCODE_CONTINUATION;
-                    header.fragmented = 0;
-                    header.sz_payload = PCRDR_MAX_FRAME_PAYLOAD_SIZE;
-                    left -= PCRDR_MAX_FRAME_PAYLOAD_SIZE;
-                }
-                else {
-                    header.op = US_OPCODE_END;
-                    header.fragmented = 0;
-                    header.sz_payload = left;
-                    left = 0;
-                }
+    return 0;
+}
 
-                if (conn_write (conn->fd, &header, sizeof (USFrameHeader)) == 0) {
-                    retv = conn_write (conn->fd, text, header.sz_payload);
-                    text += header.sz_payload;
-                }
+/*
+ * Sends a packet made of the segments in frames; every frame, including
+ * its header, is sent with one writev() call, and the segments are never
+ * copied.
+ */
+static int send_segments (pcrdr_conn* conn, int op,
+        const struct iovec *segs, int nr_segs)
+{
+    if (conn->type == CT_WEB_SOCKET) {
+        return pcrdr_ws_send_message (conn->ws,
+                (op == US_OPCODE_BIN) ? WS_OPCODE_BIN : WS_OPCODE_TEXT,
+                segs, nr_segs);
+    }
+    else if (conn->type != CT_UNIX_SOCKET) {
+        return PCRDR_ERROR_INVALID_VALUE;
+    }
+
+    size_t len = 0;
+    for (int i = 0; i < nr_segs; i++)
+        len += segs[i].iov_len;
+
+    USFrameHeader header;
+    struct iovec iov[MAX_PACKET_SEGMENTS + 1];
+    int seg = 0;
+    size_t seg_off = 0, left = len;
+
+    do {
+        size_t sz_payload = left > PCRDR_MAX_FRAME_PAYLOAD_SIZE ?
+            PCRDR_MAX_FRAME_PAYLOAD_SIZE : left;
 
-            } while (left > 0 && retv == 0);
+        if (left == len) {
+            header.op = op;
+            header.fragmented = (len > PCRDR_MAX_FRAME_PAYLOAD_SIZE) ? len : 0;
         }
         else {
-            header.op = US_OPCODE_TEXT;
+            header.op = (left > PCRDR_MAX_FRAME_PAYLOAD_SIZE) ?
+                US_OPCODE_CONTINUATION : US_OPCODE_END;
             header.fragmented = 0;
-            header.sz_payload = len;
-            if (conn_write (conn->fd, &header, sizeof (USFrameHeader)) == 0)
-                retv = conn_write (conn->fd, text, len);
         }
-    }
-    else if (conn->type == CT_WEB_SOCKET) {
-        /* TODO */
-        retv = PCRDR_ERROR_NOT_IMPLEMENTED;
-    }
-    else
-        retv = PCRDR_ERROR_INVALID_VALUE;
+        header.sz_payload = sz_payload;
+        left -= sz_payload;
+
+        iov[0].iov_base = &header;
+        iov[0].iov_len = sizeof (USFrameHeader);
+        int iovcnt = 1;
+        while (sz_payload > 0) {
+            size_t n = segs[seg].iov_len - seg_off;
+            if (n > sz_payload)
+                n = sz_payload;
+
+            if (n > 0) {
+                iov[iovcnt].iov_base = (char *)segs[seg].iov_base + seg_off;
+                iov[iovcnt].iov_len = n;
+                iovcnt++;
+            }
 
-    return retv;
+            seg_off += n;
+            sz_payload -= n;
+            if (seg_off == segs[seg].iov_len) {
+                seg++;
+                seg_off = 0;
+            }
+        }
+
+        int retv = conn_writev (conn->fd, iov, iovcnt);
+        if (retv)
+            return retv;
+    } while (left > 0);
+
+    return 0;
+}
+
+static int send_packet (pcrdr_conn* conn, int op,
+        const char* text, size_t len)
+{
+    struct iovec seg = { (void *)text, len };
+    return send_segments (conn, op, &seg, 1);
+}
+
+int pcrdr_purcmc_send_text_packet (pcrdr_conn* conn, const char* text, size_t len)
+{
+    return send_packet (conn, US_OPCODE_TEXT, text, len);
+}
+
+int pcrdr_purcmc_send_binary_packet (pcrdr_conn* conn,
+        const void* data, size_t len)
+{
+    return send_packet (conn, US_OPCODE_BIN, data, len);
 }
 
 #define SCHEMA_UNIX_SOCKET  "unix://"
+#define SCHEMA_WEB_SOCKET   "ws://"
+
+/* connects to the renderer at `ws://<host>[:<port>][/<path>]` */
+static int connect_via_web_socket_uri (const char* uri,
+        const char* app_name, const char* runner_name, pcrdr_conn** conn)
+{
+    const char *host = uri + sizeof (SCHEMA_WEB_SOCKET) - 1;
+    const char *path = strchr (host, '/');
+    const char *end = path ? path : host + strlen (host);
+    const char *host_end = end, *colon;
+    int port = atoi (PCRDR_PURCMC_WS_PORT);
+
+    if (host[0] == '[') {
+        /* an IPv6 address, e.g., `[::1]:7702` */
+        const char *bracket = memchr (host, ']', end - host);
+        if (bracket == NULL)
+            goto bad_uri;
+
+        host++;
+        host_end = bracket;
+        colon = (bracket + 1 < end && bracket[1] == ':') ? bracket + 1 : NULL;
+    }
+    else {
+        colon = memchr (host, ':', end - host);
+        if (colon)
+            host_end = colon;
+    }
+
+    if (colon) {
+        char *port_end;
+        long n = strtol (colon + 1, &port_end, 10);
+        if (port_end != end || n <= 0 || n > 65535)
+            goto bad_uri;
+        port = (int)n;
+    }
+
+    if (host_end == host)
+        goto bad_uri;
+
+    char *host_name = strndup (host, host_end - host);
+    if (host_name == NULL) {
+        purc_set_error (PCRDR_ERROR_NOMEM);
+        return -1;
+    }
+
+    int fd = purcmc_connect_via_web_socket (host_name, port, path,
+            app_name, runner_name, conn);
+    free (host_name);
+    return fd;
+
+bad_uri:
+    purc_set_error (PURC_ERROR_INVALID_VALUE);
+    return -1;
+}
 
 pcrdr_msg *pcrdr_purcmc_connect(const char* renderer_uri,
         const char* app_name, const char* runner_name, pcrdr_conn** conn)
@@ -658,14 +947,22 @@ pcrdr_msg *pcrdr_purcmc_connect(const char* renderer_uri,
     pcrdr_msg *msg = NULL;
 
     if (pcutils_strncasecmp (SCHEMA_UNIX_SOCKET, renderer_uri,
-            sizeof(SCHEMA_UNIX_SOCKET) - 1)) {
-        purc_set_error(PURC_ERROR_NOT_SUPPORTED);
-        return NULL;
+            sizeof(SCHEMA_UNIX_SOCKET) - 1) == 0) {
+        if (purcmc_connect_via_unix_socket(
+                renderer_uri + sizeof(SCHEMA_UNIX_SOCKET) - 1,
+                app_name, runner_name, conn) < 0) {
+            return NULL;
+        }
     }
-
-    if (purcmc_connect_via_unix_socket(
-            renderer_uri + sizeof(SCHEMA_UNIX_SOCKET) - 1,
-            app_name, runner_name, conn) < 0) {
+    else if (pcutils_strncasecmp (SCHEMA_WEB_SOCKET, renderer_uri,
+            sizeof(SCHEMA_WEB_SOCKET) - 1) == 0) {
+        if (connect_via_web_socket_uri (renderer_uri,
+                app_name, runner_name, conn) < 0) {
+            return NULL;
+        }
+    }
+    else {
+        purc_set_error(PURC_ERROR_NOT_SUPPORTED);
         return NULL;
     }
 
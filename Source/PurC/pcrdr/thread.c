@@ -50,26 +50,13 @@ static int my_wait_message(pcrdr_conn* conn, int timeout_ms)
     size_t count = 0;
     UNUSED_PARAM(conn);
 
-    if (purc_inst_holding_messages_count(&count))
+    /* returns as soon as the renderer thread moves a message to us,
+       instead of sleeping out the whole timeout. */
+    if (purc_inst_wait_for_messages(timeout_ms, &count))
         return -1;
 
-    if (count == 0) {
-        if (timeout_ms > 1000) {
-            pcutils_sleep(timeout_ms / 1000);
-        }
-
-        if (timeout_ms > 0) {
-            unsigned int ms = timeout_ms % 1000;
-            if (ms) {
-                pcutils_usleep(ms * 1000);
-            }
-        }
-
-        return 0;
-    }
-
-    // it's time to read a fake response message.
-    return 1;
+    // it's time to read a message.
+    return (count > 0) ? 1 : 0;
 }
 
 static pcrdr_msg *my_read_message(pcrdr_conn* conn)
@@ -164,15 +151,12 @@ pcrdr_msg *pcrdr_thread_connect(const char* renderer_uri,
     list_head_init (&(*conn)->pending_requests);
 
     /* read the initial response message from the rendere thread */
-    int left_ms = PCRDR_DEF_TIME_EXPECTED * 1000;
-    while (left_ms > 0) {
-        if (my_wait_message(*conn, 10) == 0)
-            left_ms -= 10;
-        else
-            break;
+    int r = my_wait_message(*conn, PCRDR_DEF_TIME_EXPECTED * 1000);
+    if (r < 0) {
+        err_code = PCRDR_ERROR_UNEXPECTED;
+        goto failed;
     }
-
-    if (left_ms <= 0) {
+    else if (r == 0) {
         err_code = PCRDR_ERROR_TIMEOUT;
         goto failed;
     }
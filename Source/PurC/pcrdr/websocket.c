@@ -0,0 +1,907 @@
+/*
+ * @file websocket.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The WebSocket transport of PurCMC.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A client of RFC 6455. A message is sent in frames carrying
+ * PCRDR_MAX_FRAME_PAYLOAD_SIZE bytes at most, the same as over UnixSocket,
+ * and the frames are masked as required for a client. The control frames
+ * may come between the frames of a message, and they are handled in place.
+ *
+ * If the renderer accepts the permessage-deflate extension (RFC 7692),
+ * the messages longer than WS_MIN_DEFLATE_SIZE are sent compressed,
+ * and the compressed messages from the renderer are inflated.
+ */
+
+#include "config.h"
+#include "purc-pcrdr.h"
+#include "purc-utils.h"
+#include "private/debug.h"
+#include "private/utils.h"
+#include "private/pcrdr.h"
+#include "websocket.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+
+#if OS(LINUX) || OS(UNIX)
+
+#include <unistd.h>
+
+#if HAVE(ZLIB)
+#include <zlib.h>
+#endif
+
+#define WS_GUID                 "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+#define WS_LEN_KEY              16
+
+/* the maximal length of the response to the opening handshake */
+#define WS_MAX_HANDSHAKE_SIZE   4096
+
+/* the shorter messages are not worth compressing */
+#define WS_MIN_DEFLATE_SIZE     128
+
+/* the length of a frame header at most: 2 + 8 (length) + 4 (mask) */
+#define WS_MAX_HEADER_SIZE      14
+
+#define WS_FIN                  0x80
+#define WS_RSV1                 0x40
+#define WS_MASK                 0x80
+#define WS_CLOSE_NORMAL         1000
+
+/* the maximal payload of a control frame */
+#define WS_MAX_CONTROL_PAYLOAD  125
+
+struct pcrdr_ws {
+    int fd;
+    bool deflated;
+
+    /* the state of the generator of the masking keys */
+    uint32_t rand_state;
+
+#if HAVE(ZLIB)
+    /* whether to reset the context after every message */
+    bool client_no_context_takeover;
+    bool server_no_context_takeover;
+
+    /* whether to compress the messages to send */
+    bool deflater_ready;
+    bool inflater_ready;
+    z_stream deflater;
+    z_stream inflater;
+#endif
+};
+
+static int ws_read (int fd, void *buff, size_t sz)
+{
+    char *p = buff;
+
+    while (sz > 0) {
+        ssize_t n = read (fd, p, sz);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return PCRDR_ERROR_IO;
+        }
+        else if (n == 0) {
+            return PCRDR_ERROR_PEER_CLOSED;
+        }
+
+        p += n;
+        sz -= n;
+    }
+
+    return 0;
+}
+
+static int ws_write (int fd, const void *data, size_t sz)
+{
+    const char *p = data;
+
+    while (sz > 0) {
+        ssize_t n = write (fd, p, sz);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return PCRDR_ERROR_IO;
+        }
+
+        p += n;
+        sz -= n;
+    }
+
+    return 0;
+}
+
+/* the bytes of the segments taken in order */
+struct seg_cursor {
+    const struct iovec *segs;
+    int nr_segs;
+    int seg;
+    size_t off;
+};
+
+static size_t take_bytes (struct seg_cursor *cur, char *dst, size_t sz)
+{
+    size_t taken = 0;
+
+    while (taken < sz && cur->seg < cur->nr_segs) {
+        const struct iovec *seg = cur->segs + cur->seg;
+        size_t n = seg->iov_len - cur->off;
+        if (n > sz - taken)
+            n = sz - taken;
+
+        memcpy (dst + taken, (const char *)seg->iov_base + cur->off, n);
+        taken += n;
+        cur->off += n;
+        if (cur->off == seg->iov_len) {
+            cur->seg++;
+            cur->off = 0;
+        }
+    }
+
+    return taken;
+}
+
+static size_t make_header (unsigned char *header, int first_byte,
+        size_t sz_payload, const unsigned char *mask)
+{
+    size_t len = 0;
+
+    header[len++] = (unsigned char)first_byte;
+    if (sz_payload < 126) {
+        header[len++] = WS_MASK | (unsigned char)sz_payload;
+    }
+    else if (sz_payload <= 0xFFFF) {
+        header[len++] = WS_MASK | 126;
+        header[len++] = (unsigned char)(sz_payload >> 8);
+        header[len++] = (unsigned char)sz_payload;
+    }
+    else {
+        header[len++] = WS_MASK | 127;
+        for (int i = 7; i >= 0; i--)
+            header[len++] = (unsigned char)((uint64_t)sz_payload >> (i * 8));
+    }
+
+    memcpy (header + len, mask, 4);
+    return len + 4;
+}
+
+/* xorshift32, seeded by pcutils_get_random_seed() */
+static uint32_t next_random (struct pcrdr_ws *ws)
+{
+    uint32_t x = ws->rand_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    ws->rand_state = x;
+    return x;
+}
+
+static void make_mask (struct pcrdr_ws *ws, unsigned char *mask)
+{
+    uint32_t r = next_random (ws);
+    memcpy (mask, &r, 4);
+}
+
+static void apply_mask (unsigned char *data, size_t len,
+        const unsigned char *mask)
+{
+    for (size_t i = 0; i < len; i++)
+        data[i] ^= mask[i & 3];
+}
+
+/* sends the bytes of the cursor in frames; rsv1 is set on the first one */
+static int send_frames (struct pcrdr_ws *ws, int opcode, bool rsv1,
+        struct seg_cursor *cur, size_t len)
+{
+    unsigned char frame[WS_MAX_HEADER_SIZE + PCRDR_MAX_FRAME_PAYLOAD_SIZE];
+    size_t left = len;
+    bool first = true;
+
+    do {
+        size_t sz_payload = left > PCRDR_MAX_FRAME_PAYLOAD_SIZE ?
+            PCRDR_MAX_FRAME_PAYLOAD_SIZE : left;
+        left -= sz_payload;
+
+        int first_byte = first ? opcode : WS_OPCODE_CONTINUATION;
+        if (first && rsv1)
+            first_byte |= WS_RSV1;
+        if (left == 0)
+            first_byte |= WS_FIN;
+
+        unsigned char mask[4];
+        make_mask (ws, mask);
+
+        size_t sz_header = make_header (frame, first_byte, sz_payload, mask);
+        take_bytes (cur, (char *)frame + sz_header, sz_payload);
+        apply_mask (frame + sz_header, sz_payload, mask);
+
+        int retv = ws_write (ws->fd, frame, sz_header + sz_payload);
+        if (retv)
+            return retv;
+
+        first = false;
+    } while (left > 0);
+
+    return 0;
+}
+
+#if HAVE(ZLIB)
+
+/* the tail of a block flushed by Z_SYNC_FLUSH, which is not sent */
+static const unsigned char deflate_tail[] = { 0x00, 0x00, 0xFF, 0xFF };
+
+static int deflate_segments (struct pcrdr_ws *ws,
+        const struct iovec *segs, int nr_segs, char **out, size_t *out_len)
+{
+    z_stream *zs = &ws->deflater;
+    size_t sz = PCRDR_MIN_PACKET_BUFF_SIZE, len = 0;
+    char *buf = malloc (sz);
+    if (buf == NULL)
+        return PCRDR_ERROR_NOMEM;
+
+    for (int i = 0; i < nr_segs; i++) {
+        bool last = (i == nr_segs - 1);
+        zs->next_in = (Bytef *)segs[i].iov_base;
+        zs->avail_in = (uInt)segs[i].iov_len;
+
+        do {
+            if (sz - len < 64) {
+                char *p = realloc (buf, sz << 1);
+                if (p == NULL) {
+                    free (buf);
+                    return PCRDR_ERROR_NOMEM;
+                }
+                buf = p;
+                sz <<= 1;
+            }
+
+            zs->next_out = (Bytef *)buf + len;
+            zs->avail_out = (uInt)(sz - len);
+            int ret = deflate (zs, last ? Z_SYNC_FLUSH : Z_NO_FLUSH);
+            if (ret != Z_OK && ret != Z_BUF_ERROR) {
+                free (buf);
+                return PCRDR_ERROR_UNEXPECTED;
+            }
+            len = sz - zs->avail_out;
+        } while (zs->avail_in > 0 || (last && zs->avail_out == 0));
+    }
+
+    if (len >= sizeof (deflate_tail) &&
+            memcmp (buf + len - sizeof (deflate_tail), deflate_tail,
+                sizeof (deflate_tail)) == 0) {
+        len -= sizeof (deflate_tail);
+    }
+
+    if (ws->client_no_context_takeover)
+        deflateReset (zs);
+
+    *out = buf;
+    *out_len = len;
+    return 0;
+}
+
+static int inflate_message (struct pcrdr_ws *ws, char **buf, size_t *len)
+{
+    z_stream *zs = &ws->inflater;
+    size_t sz = PCRDR_MIN_PACKET_BUFF_SIZE, out_len = 0;
+    char *out = malloc (sz);
+    if (out == NULL)
+        return PCRDR_ERROR_NOMEM;
+
+    /* the compressed data and the tail removed by the sender */
+    const struct iovec ins[] = {
+        { *buf, *len },
+        { (void *)deflate_tail, sizeof (deflate_tail) },
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE (ins); i++) {
+        zs->next_in = (Bytef *)ins[i].iov_base;
+        zs->avail_in = (uInt)ins[i].iov_len;
+
+        do {
+            if (sz - out_len < 64) {
+                if (sz >= PCRDR_MAX_INMEM_PAYLOAD_SIZE + 64) {
+                    free (out);
+                    return PCRDR_ERROR_TOO_LARGE;
+                }
+
+                char *p = realloc (out, sz << 1);
+                if (p == NULL) {
+                    free (out);
+                    return PCRDR_ERROR_NOMEM;
+                }
+                out = p;
+                sz <<= 1;
+            }
+
+            zs->next_out = (Bytef *)out + out_len;
+            /* keep the room for the terminating null byte */
+            zs->avail_out = (uInt)(sz - out_len - 1);
+            int ret = inflate (zs, Z_SYNC_FLUSH);
+            if (ret != Z_OK && ret != Z_BUF_ERROR && ret != Z_STREAM_END) {
+                free (out);
+                return PCRDR_ERROR_BAD_MESSAGE;
+            }
+            out_len = sz - 1 - zs->avail_out;
+        } while (zs->avail_in > 0 || zs->avail_out == 0);
+    }
+
+    if (out_len > PCRDR_MAX_INMEM_PAYLOAD_SIZE) {
+        free (out);
+        return PCRDR_ERROR_TOO_LARGE;
+    }
+
+    if (ws->server_no_context_takeover)
+        inflateReset (zs);
+
+    free (*buf);
+    *buf = out;
+    *len = out_len;
+    return 0;
+}
+
+#endif /* HAVE(ZLIB) */
+
+int pcrdr_ws_send_message (struct pcrdr_ws *ws, int opcode,
+        const struct iovec *segs, int nr_segs)
+{
+    size_t len = 0;
+    for (int i = 0; i < nr_segs; i++)
+        len += segs[i].iov_len;
+
+#if HAVE(ZLIB)
+    if (ws->deflater_ready && len >= WS_MIN_DEFLATE_SIZE) {
+        char *buf;
+        size_t buf_len;
+        int retv = deflate_segments (ws, segs, nr_segs, &buf, &buf_len);
+        if (retv)
+            return retv;
+
+        struct iovec seg = { buf, buf_len };
+        struct seg_cursor cur = { &seg, 1, 0, 0 };
+        retv = send_frames (ws, opcode, true, &cur, buf_len);
+        free (buf);
+        return retv;
+    }
+#endif
+
+    struct seg_cursor cur = { segs, nr_segs, 0, 0 };
+    return send_frames (ws, opcode, false, &cur, len);
+}
+
+int pcrdr_ws_send_control (struct pcrdr_ws *ws, int opcode,
+        const void *payload, size_t len)
+{
+    if (len > WS_MAX_CONTROL_PAYLOAD)
+        return PCRDR_ERROR_INVALID_VALUE;
+
+    struct iovec seg = { (void *)payload, len };
+    struct seg_cursor cur = { &seg, 1, 0, 0 };
+    return send_frames (ws, opcode, false, &cur, len);
+}
+
+struct frame_header {
+    bool fin;
+    bool rsv1;
+    bool masked;
+    int opcode;
+    unsigned char mask[4];
+    uint64_t sz_payload;
+};
+
+static int read_frame_header (struct pcrdr_ws *ws, struct frame_header *hdr)
+{
+    unsigned char buf[8];
+    int retv;
+
+    if ((retv = ws_read (ws->fd, buf, 2)))
+        return retv;
+
+    hdr->fin = (buf[0] & WS_FIN) != 0;
+    hdr->rsv1 = (buf[0] & WS_RSV1) != 0;
+    hdr->opcode = buf[0] & 0x0F;
+    hdr->masked = (buf[1] & WS_MASK) != 0;
+    hdr->sz_payload = buf[1] & 0x7F;
+
+    if (hdr->sz_payload == 126) {
+        if ((retv = ws_read (ws->fd, buf, 2)))
+            return retv;
+        hdr->sz_payload = ((uint64_t)buf[0] << 8) | buf[1];
+    }
+    else if (hdr->sz_payload == 127) {
+        if ((retv = ws_read (ws->fd, buf, 8)))
+            return retv;
+        hdr->sz_payload = 0;
+        for (int i = 0; i < 8; i++)
+            hdr->sz_payload = (hdr->sz_payload << 8) | buf[i];
+    }
+
+    if (hdr->masked && (retv = ws_read (ws->fd, hdr->mask, 4)))
+        return retv;
+
+    return 0;
+}
+
+/* handles a control frame; returns PCRDR_ERROR_PEER_CLOSED for closing */
+static int handle_control_frame (struct pcrdr_ws *ws,
+        const struct frame_header *hdr)
+{
+    unsigned char payload[WS_MAX_CONTROL_PAYLOAD];
+    int retv;
+
+    if (!hdr->fin || hdr->sz_payload > WS_MAX_CONTROL_PAYLOAD) {
+        PC_DEBUG ("Bad control frame from WebSocket\n");
+        return PCRDR_ERROR_PROTOCOL;
+    }
+
+    size_t len = (size_t)hdr->sz_payload;
+    if (len > 0 && (retv = ws_read (ws->fd, payload, len)))
+        return retv;
+    if (hdr->masked)
+        apply_mask (payload, len, hdr->mask);
+
+    switch (hdr->opcode) {
+    case WS_OPCODE_PING:
+        return pcrdr_ws_send_control (ws, WS_OPCODE_PONG, payload, len);
+
+    case WS_OPCODE_PONG:
+        /* no state waits for a PONG; an unsolicited one is ignored
+           (RFC 6455, Section 5.5.3) */
+        return 0;
+
+    case WS_OPCODE_CLOSE:
+        PC_INFO ("Peer closed\n");
+        /* echo the status code */
+        pcrdr_ws_send_control (ws, WS_OPCODE_CLOSE, payload,
+                len >= 2 ? 2 : 0);
+        return PCRDR_ERROR_PEER_CLOSED;
+
+    default:
+        PC_DEBUG ("Bad frame op code: %d\n", hdr->opcode);
+        return PCRDR_ERROR_PROTOCOL;
+    }
+}
+
+int pcrdr_ws_read_message (struct pcrdr_ws *ws,
+        void **packet, size_t *sz_packet)
+{
+    struct frame_header hdr;
+    char *buf = NULL;
+    size_t len = 0;
+    int opcode = -1;
+    bool compressed = false;
+    int err_code;
+
+    *packet = NULL;
+    *sz_packet = 0;
+
+    do {
+        if ((err_code = read_frame_header (ws, &hdr)))
+            goto failed;
+
+        if (hdr.opcode & 0x08) {
+            if ((err_code = handle_control_frame (ws, &hdr)))
+                goto failed;
+
+            if (opcode < 0) {
+                /* no message in progress */
+                return 0;
+            }
+
+            /* go on with the frames of the message */
+            hdr.fin = false;
+            continue;
+        }
+
+        if (hdr.opcode == WS_OPCODE_CONTINUATION) {
+            if (opcode < 0) {
+                PC_DEBUG ("Not a continuation frame expected\n");
+                err_code = PCRDR_ERROR_PROTOCOL;
+                goto failed;
+            }
+        }
+        else if (hdr.opcode == WS_OPCODE_TEXT ||
+                hdr.opcode == WS_OPCODE_BIN) {
+            if (opcode >= 0) {
+                PC_DEBUG ("Not a continuation frame\n");
+                err_code = PCRDR_ERROR_PROTOCOL;
+                goto failed;
+            }
+
+            opcode = hdr.opcode;
+            compressed = hdr.rsv1;
+            if (compressed && !ws->deflated) {
+                err_code = PCRDR_ERROR_PROTOCOL;
+                goto failed;
+            }
+        }
+        else {
+            PC_DEBUG ("Bad frame op code: %d\n", hdr.opcode);
+            err_code = PCRDR_ERROR_PROTOCOL;
+            goto failed;
+        }
+
+        if (hdr.sz_payload > PCRDR_MAX_INMEM_PAYLOAD_SIZE - len) {
+            err_code = PCRDR_ERROR_TOO_LARGE;
+            goto failed;
+        }
+
+        size_t sz_payload = (size_t)hdr.sz_payload;
+        char *p = realloc (buf, len + sz_payload + 1);
+        if (p == NULL) {
+            err_code = PCRDR_ERROR_NOMEM;
+            goto failed;
+        }
+        buf = p;
+
+        if (sz_payload > 0 &&
+                (err_code = ws_read (ws->fd, buf + len, sz_payload)))
+            goto failed;
+        if (hdr.masked)
+            apply_mask ((unsigned char *)buf + len, sz_payload, hdr.mask);
+        len += sz_payload;
+    } while (!hdr.fin);
+
+    if (compressed) {
+#if HAVE(ZLIB)
+        err_code = inflate_message (ws, &buf, &len);
+        if (err_code)
+            goto failed;
+#else
+        err_code = PCRDR_ERROR_NOT_IMPLEMENTED;
+        goto failed;
+#endif
+    }
+
+    if (opcode == WS_OPCODE_TEXT) {
+        buf[len] = '\0';
+        *sz_packet = len + 1;
+    }
+    else {
+        *sz_packet = len;
+    }
+
+    *packet = buf;
+    return 0;
+
+failed:
+    free (buf);
+    return err_code;
+}
+
+/* finds the value of the header in the response; the value is trimmed */
+static const char *find_header (const char *response, const char *name,
+        size_t *len)
+{
+    size_t name_len = strlen (name);
+    const char *line = strstr (response, "\r\n");
+
+    while (line && line[2] != '\r') {
+        line += 2;
+        const char *end = strstr (line, "\r\n");
+        if (end == NULL)
+            break;
+
+        if (pcutils_strncasecmp (line, name, name_len) == 0 &&
+                line[name_len] == ':') {
+            const char *value = line + name_len + 1;
+            while (value < end && (*value == ' ' || *value == '\t'))
+                value++;
+            while (end > value && (end[-1] == ' ' || end[-1] == '\t'))
+                end--;
+            *len = end - value;
+            return value;
+        }
+
+        line = end;
+    }
+
+    return NULL;
+}
+
+/* whether the list of tokens separated by commas has the token */
+static bool has_token (const char *list, size_t len, const char *token)
+{
+    size_t token_len = strlen (token);
+    const char *end = list + len;
+
+    while (list < end) {
+        while (list < end && (*list == ' ' || *list == ','))
+            list++;
+
+        const char *next = memchr (list, ',', end - list);
+        if (next == NULL)
+            next = end;
+
+        const char *tail = next;
+        while (tail > list && tail[-1] == ' ')
+            tail--;
+        if ((size_t)(tail - list) == token_len &&
+                pcutils_strncasecmp (list, token, token_len) == 0)
+            return true;
+
+        list = next;
+    }
+
+    return false;
+}
+
+#if HAVE(ZLIB)
+
+#define EXT_PERMESSAGE_DEFLATE  "permessage-deflate"
+
+/*
+ * Sets up the compression by the extension accepted, such as
+ * `permessage-deflate; client_no_context_takeover; client_max_window_bits=10`;
+ * returns false for a bad one.
+ */
+static bool accept_deflate (struct pcrdr_ws *ws, const char *ext, size_t len)
+{
+    const char *end = ext + len;
+    size_t name_len = sizeof (EXT_PERMESSAGE_DEFLATE) - 1;
+    int client_bits = 15;
+
+    if (len < name_len ||
+            pcutils_strncasecmp (ext, EXT_PERMESSAGE_DEFLATE, name_len))
+        return false;
+
+    const char *param = ext + name_len;
+    while (param < end) {
+        while (param < end && (*param == ' ' || *param == ';'))
+            param++;
+
+        const char *next = memchr (param, ';', end - param);
+        if (next == NULL)
+            next = end;
+
+        size_t n = next - param;
+        while (n > 0 && param[n - 1] == ' ')
+            n--;
+
+#define IS_PARAM(p, name)                                       \
+        (n >= sizeof (name) - 1 &&                              \
+         pcutils_strncasecmp (p, name, sizeof (name) - 1) == 0)
+
+        if (n == 0) {
+            ;
+        }
+        else if (IS_PARAM (param, "client_no_context_takeover")) {
+            ws->client_no_context_takeover = true;
+        }
+        else if (IS_PARAM (param, "server_no_context_takeover")) {
+            ws->server_no_context_takeover = true;
+        }
+        else if (IS_PARAM (param, "client_max_window_bits")) {
+            const char *v = memchr (param, '=', n);
+            if (v)
+                client_bits = atoi (v + 1);
+        }
+        else if (IS_PARAM (param, "server_max_window_bits")) {
+            /* the inflater takes any window */
+        }
+        else {
+            return false;
+        }
+#undef IS_PARAM
+
+        param = next;
+    }
+
+    if (client_bits < 8 || client_bits > 15)
+        return false;
+
+    if (inflateInit2 (&ws->inflater, -15) != Z_OK)
+        return false;
+    ws->inflater_ready = true;
+
+    /* zlib does not make a window of 256 bytes; send uncompressed then */
+    if (client_bits >= 9 &&
+            deflateInit2 (&ws->deflater, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                -client_bits, 8, Z_DEFAULT_STRATEGY) == Z_OK) {
+        ws->deflater_ready = true;
+    }
+
+    ws->deflated = true;
+    return true;
+}
+
+#endif /* HAVE(ZLIB) */
+
+static int read_handshake_response (int fd, char *buf, size_t sz)
+{
+    size_t len = 0;
+
+    /* read byte by byte to leave the frames followed in the socket */
+    while (len < sz - 1) {
+        int retv = ws_read (fd, buf + len, 1);
+        if (retv)
+            return retv;
+
+        len++;
+        if (len >= 4 && memcmp (buf + len - 4, "\r\n\r\n", 4) == 0) {
+            buf[len] = '\0';
+            return 0;
+        }
+    }
+
+    return PCRDR_ERROR_TOO_LARGE;
+}
+
+struct pcrdr_ws *pcrdr_ws_handshake (int fd, const char *host_name,
+        int port, const char *path, bool deflate)
+{
+    struct pcrdr_ws *ws;
+    int err_code = PCRDR_ERROR_PROTOCOL;
+    char *request = NULL;
+    char *response = NULL;
+
+    if ((ws = calloc (1, sizeof (*ws))) == NULL) {
+        purc_set_error (PCRDR_ERROR_NOMEM);
+        return NULL;
+    }
+    ws->fd = fd;
+
+#if !HAVE(ZLIB)
+    deflate = false;
+#endif
+
+    ws->rand_state = (uint32_t)pcutils_get_random_seed ();
+    if (ws->rand_state == 0)
+        ws->rand_state = 0x9E3779B9U;
+
+    unsigned char nonce[WS_LEN_KEY];
+    for (size_t i = 0; i < sizeof (nonce); i += 4) {
+        uint32_t r = next_random (ws);
+        memcpy (nonce + i, &r, 4);
+    }
+
+    char key[32];
+    if (pcutils_b64_encode (nonce, sizeof (nonce), key, sizeof (key)) < 0) {
+        err_code = PCRDR_ERROR_UNEXPECTED;
+        goto failed;
+    }
+
+    if ((request = malloc (WS_MAX_HANDSHAKE_SIZE)) == NULL) {
+        err_code = PCRDR_ERROR_NOMEM;
+        goto failed;
+    }
+
+    int n = snprintf (request, WS_MAX_HANDSHAKE_SIZE,
+            "GET %s HTTP/1.1\r\n"
+            "Host: %s:%d\r\n"
+            "Upgrade: websocket\r\n"
+            "Connection: Upgrade\r\n"
+            "Sec-WebSocket-Key: %s\r\n"
+            "Sec-WebSocket-Version: 13\r\n"
+            "%s"
+            "\r\n",
+            (path && path[0]) ? path : "/", host_name, port, key,
+            deflate ? "Sec-WebSocket-Extensions: permessage-deflate; "
+                "client_max_window_bits\r\n" : "");
+    if (n < 0 || n >= WS_MAX_HANDSHAKE_SIZE) {
+        err_code = PCRDR_ERROR_TOO_LARGE;
+        goto failed;
+    }
+
+    if ((err_code = ws_write (fd, request, n)))
+        goto failed;
+
+    if ((response = malloc (WS_MAX_HANDSHAKE_SIZE)) == NULL) {
+        err_code = PCRDR_ERROR_NOMEM;
+        goto failed;
+    }
+
+    if ((err_code = read_handshake_response (fd, response,
+                    WS_MAX_HANDSHAKE_SIZE)))
+        goto failed;
+
+    err_code = PCRDR_ERROR_PROTOCOL;
+    if (strncmp (response, "HTTP/1.1 101", 12)) {
+        PC_DEBUG ("WebSocket handshake refused: %s\n", response);
+        goto failed;
+    }
+
+    const char *value;
+    size_t len;
+    value = find_header (response, "Upgrade", &len);
+    if (value == NULL || !has_token (value, len, "websocket"))
+        goto failed;
+
+    /* the accept key is the Base64 of the SHA1 of the key and the GUID */
+    {
+        pcutils_sha1_ctxt ctx;
+        unsigned char digest[SHA1_DIGEST_SIZE];
+        char accept[32];
+
+        pcutils_sha1_begin (&ctx);
+        pcutils_sha1_hash (&ctx, key, strlen (key));
+        pcutils_sha1_hash (&ctx, WS_GUID, sizeof (WS_GUID) - 1);
+        pcutils_sha1_end (&ctx, digest);
+        if (pcutils_b64_encode (digest, sizeof (digest), accept,
+                    sizeof (accept)) < 0)
+            goto failed;
+
+        value = find_header (response, "Sec-WebSocket-Accept", &len);
+        if (value == NULL || len != strlen (accept) ||
+                strncmp (value, accept, len)) {
+            PC_DEBUG ("Bad Sec-WebSocket-Accept\n");
+            goto failed;
+        }
+    }
+
+    value = find_header (response, "Sec-WebSocket-Extensions", &len);
+    if (value) {
+#if HAVE(ZLIB)
+        if (!deflate || !accept_deflate (ws, value, len)) {
+            PC_DEBUG ("Bad extension accepted\n");
+            goto failed;
+        }
+#else
+        PC_DEBUG ("Extension not offered accepted\n");
+        goto failed;
+#endif
+    }
+
+    free (request);
+    free (response);
+    return ws;
+
+failed:
+    free (request);
+    free (response);
+    pcrdr_ws_delete (ws, false);
+    purc_set_error (err_code);
+    return NULL;
+}
+
+bool pcrdr_ws_is_deflated (struct pcrdr_ws *ws)
+{
+    return ws->deflated;
+}
+
+void pcrdr_ws_delete (struct pcrdr_ws *ws, bool close)
+{
+    if (close) {
+        unsigned char status[2] = {
+            WS_CLOSE_NORMAL >> 8, WS_CLOSE_NORMAL & 0xFF
+        };
+        pcrdr_ws_send_control (ws, WS_OPCODE_CLOSE, status, sizeof (status));
+    }
+
+#if HAVE(ZLIB)
+    if (ws->deflater_ready)
+        deflateEnd (&ws->deflater);
+    if (ws->inflater_ready)
+        inflateEnd (&ws->inflater);
+#endif
+
+    free (ws);
+}
+
+#endif /* OS(LINUX) || OS(UNIX) */
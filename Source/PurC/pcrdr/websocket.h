@@ -0,0 +1,71 @@
+/**
+ * @file websocket.h
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The internal interfaces of the WebSocket transport of PurCMC.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PURC_PCRDR_WEBSOCKET_H
+#define PURC_PCRDR_WEBSOCKET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/uio.h>
+
+#include "purc-pcrdr.h"
+
+/* The frame operation codes for WebSocket (RFC 6455) */
+typedef enum WSOpcode_ {
+    WS_OPCODE_CONTINUATION = 0x00,
+    WS_OPCODE_TEXT = 0x01,
+    WS_OPCODE_BIN = 0x02,
+    WS_OPCODE_CLOSE = 0x08,
+    WS_OPCODE_PING = 0x09,
+    WS_OPCODE_PONG = 0x0A,
+} WSOpcode;
+
+struct pcrdr_ws;
+
+/* does the opening handshake over the connected socket, and offers
+   the permessage-deflate extension if deflate is true */
+struct pcrdr_ws *pcrdr_ws_handshake (int fd, const char *host_name,
+        int port, const char *path, bool deflate) WTF_INTERNAL;
+
+/* whether the permessage-deflate extension is in use */
+bool pcrdr_ws_is_deflated (struct pcrdr_ws *ws) WTF_INTERNAL;
+
+/* sends the closing frame if close is true, and deletes the context */
+void pcrdr_ws_delete (struct pcrdr_ws *ws, bool close) WTF_INTERNAL;
+
+/* sends a message made of the segments; returns 0 or an error code */
+int pcrdr_ws_send_message (struct pcrdr_ws *ws, int opcode,
+        const struct iovec *segs, int nr_segs) WTF_INTERNAL;
+
+/* sends a control frame; returns 0 or an error code */
+int pcrdr_ws_send_control (struct pcrdr_ws *ws, int opcode,
+        const void *payload, size_t len) WTF_INTERNAL;
+
+/* reads a message, which is NULL for a control frame;
+   returns 0 or an error code */
+int pcrdr_ws_read_message (struct pcrdr_ws *ws,
+        void **packet, size_t *sz_packet) WTF_INTERNAL;
+
+#endif  /* PURC_PCRDR_WEBSOCKET_H */
+
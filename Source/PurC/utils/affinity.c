@@ -0,0 +1,224 @@
+/*
+ * @file affinity.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The implementation of the CPU affinity and the NUMA nodes.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE         // pthread_setaffinity_np, sched_getcpu
+#include "config.h"
+
+#include "private/affinity.h"
+#include "private/tls.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+unsigned pcutils_parse_cpu_list(const char *str, int *ids, unsigned max)
+{
+    unsigned nr = 0;
+
+    while (*str && nr < max) {
+        char *end;
+        long first = strtol(str, &end, 10), last;
+        if (end == str || first < 0)
+            break;
+
+        last = first;
+        if (*end == '-') {
+            str = end + 1;
+            last = strtol(str, &end, 10);
+            if (end == str || last < first)
+                break;
+        }
+
+        for (long id = first; id <= last && nr < max; id++) {
+            if (id < PCUTILS_MAX_CPU_LIST)
+                ids[nr++] = (int)id;
+        }
+
+        str = end;
+        if (*str == ',')
+            str++;
+        else
+            break;
+    }
+
+    return nr;
+}
+
+#if OS(LINUX)
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+#define PATH_SYS_CPU            "/sys/devices/system/cpu/cpu"
+
+struct saved_binding {
+    bool        saved;
+    cpu_set_t   cpus;
+};
+
+PURC_DEFINE_THREAD_LOCAL(struct saved_binding, saved_binding);
+
+int pcutils_cpu_node(int cpu)
+{
+    char path[sizeof(PATH_SYS_CPU) + 16];
+    snprintf(path, sizeof(path), PATH_SYS_CPU "%d", cpu);
+
+    /* there is a link like `node1` in the directory of the CPU */
+    int node = 0;
+    DIR *dir = opendir(path);
+    if (dir) {
+        struct dirent *d;
+        while ((d = readdir(dir))) {
+            if (strncmp(d->d_name, "node", 4) == 0 &&
+                    d->d_name[4] >= '0' && d->d_name[4] <= '9') {
+                node = atoi(d->d_name + 4);
+                break;
+            }
+        }
+        closedir(dir);
+    }
+
+    return node;
+}
+
+int pcutils_current_node(void)
+{
+    int cpu = sched_getcpu();
+    return (cpu < 0) ? 0 : pcutils_cpu_node(cpu);
+}
+
+static bool in_list(const int *ids, unsigned nr, int id)
+{
+    for (unsigned i = 0; i < nr; i++) {
+        if (ids[i] == id)
+            return true;
+    }
+    return false;
+}
+
+static void prefer_node(int node)
+{
+    unsigned long mask[PCUTILS_MAX_CPU_LIST / (8 * sizeof(unsigned long))];
+    memset(mask, 0, sizeof(mask));
+    mask[node / (8 * sizeof(unsigned long))] |=
+        1UL << (node % (8 * sizeof(unsigned long)));
+
+    /* not fatal: the pages are still allocated on the node of the CPU
+       touching them first */
+    syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask, sizeof(mask) * 8 + 1);
+}
+
+int pcutils_bind_thread(const char *cpus, const char *nodes)
+{
+    int ids[PCUTILS_MAX_CPU_LIST];
+    int node_ids[PCUTILS_MAX_CPU_LIST];
+    unsigned nr_nodes = 0;
+    cpu_set_t current, set;
+
+    if (nodes) {
+        nr_nodes = pcutils_parse_cpu_list(nodes, node_ids,
+                PCUTILS_MAX_CPU_LIST);
+        if (nr_nodes == 0)
+            return -1;
+    }
+
+    if (pthread_getaffinity_np(pthread_self(), sizeof(current), &current))
+        return -1;
+
+    CPU_ZERO(&set);
+    if (cpus) {
+        unsigned nr = pcutils_parse_cpu_list(cpus, ids, PCUTILS_MAX_CPU_LIST);
+        for (unsigned i = 0; i < nr; i++) {
+            if (ids[i] < CPU_SETSIZE)
+                CPU_SET(ids[i], &set);
+        }
+    }
+    else {
+        CPU_OR(&set, &set, &current);
+    }
+
+    if (nr_nodes > 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set) &&
+                    !in_list(node_ids, nr_nodes, pcutils_cpu_node(cpu)))
+                CPU_CLR(cpu, &set);
+        }
+    }
+
+    if (CPU_COUNT(&set) == 0 ||
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set))
+        return -1;
+
+    struct saved_binding *saved = PURC_GET_THREAD_LOCAL(saved_binding);
+    if (!saved->saved) {
+        saved->cpus = current;
+        saved->saved = true;
+    }
+
+    if (nr_nodes > 0)
+        prefer_node(node_ids[0]);
+    return 0;
+}
+
+void pcutils_unbind_thread(void)
+{
+    struct saved_binding *saved = PURC_GET_THREAD_LOCAL(saved_binding);
+    if (!saved->saved)
+        return;
+
+    pthread_setaffinity_np(pthread_self(), sizeof(saved->cpus), &saved->cpus);
+    syscall(SYS_set_mempolicy, MPOL_DEFAULT, NULL, 0);
+    saved->saved = false;
+}
+
+#else   /* OS(LINUX) */
+
+int pcutils_cpu_node(int cpu)
+{
+    (void)cpu;
+    return 0;
+}
+
+int pcutils_current_node(void)
+{
+    return 0;
+}
+
+int pcutils_bind_thread(const char *cpus, const char *nodes)
+{
+    (void)cpus;
+    (void)nodes;
+    return -1;
+}
+
+void pcutils_unbind_thread(void)
+{
+}
+
+#endif  /* !OS(LINUX) */
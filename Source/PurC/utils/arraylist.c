@@ -46,6 +46,16 @@
 #include <stdint.h>
 #include <string.h>
 
+/*
+ * The slots of a small initial size are allocated along with the list
+ * itself, so a list which never grows beyond the initial size costs only
+ * one allocation. They are left unused once the list grows.
+ */
+static inline void **inline_slots(struct pcutils_arrlist *arr)
+{
+    return (void **)(arr + 1);
+}
+
 struct pcutils_arrlist *pcutils_arrlist_new_ex(array_list_free_fn *free_fn,
         size_t initial_size)
 {
@@ -56,7 +66,12 @@ struct pcutils_arrlist *pcutils_arrlist_new_ex(array_list_free_fn *free_fn,
     if (initial_size == 0)
         initial_size = 1;
 
-    arr = (struct pcutils_arrlist *)malloc(sizeof(struct pcutils_arrlist));
+    size_t nr_inline = 0;
+    if (initial_size <= ARRAY_LIST_DEFAULT_SIZE)
+        nr_inline = initial_size;
+
+    arr = (struct pcutils_arrlist *)malloc(sizeof(struct pcutils_arrlist) +
+            nr_inline * sizeof(void *));
     if (!arr)
         return NULL;
 
@@ -64,13 +79,30 @@ struct pcutils_arrlist *pcutils_arrlist_new_ex(array_list_free_fn *free_fn,
     arr->length = 0;
     arr->free_fn = free_fn;
 
-    if (!(arr->array = (void **)malloc(arr->size * sizeof(void *)))) {
+    if (nr_inline) {
+        arr->array = inline_slots(arr);
+    }
+    else if (!(arr->array = (void **)malloc(arr->size * sizeof(void *)))) {
         free(arr);
         return NULL;
     }
     return arr;
 }
 
+/* changes the size of the slots like realloc() does */
+static void **resize_slots(struct pcutils_arrlist *arr, size_t new_size)
+{
+    if (arr->array != inline_slots(arr))
+        return (void **)realloc(arr->array, new_size * sizeof(void *));
+
+    void **t = (void **)malloc(new_size * sizeof(void *));
+    if (t) {
+        memcpy(t, arr->array, (arr->length < new_size ? arr->length :
+                    new_size) * sizeof(void *));
+    }
+    return t;
+}
+
 void pcutils_arrlist_free(struct pcutils_arrlist *arr)
 {
     size_t i;
@@ -83,7 +115,8 @@ void pcutils_arrlist_free(struct pcutils_arrlist *arr)
         }
     }
 
-    free(arr->array);
+    if (arr->array != inline_slots(arr))
+        free(arr->array);
     free(arr);
 }
 
@@ -123,7 +156,7 @@ static int pcutils_arrlist_expand_internal(struct pcutils_arrlist *arr, size_t m
     }
     if (new_size > (~((size_t)0)) / sizeof(void *))
         return -1;
-    if (!(t = realloc(arr->array, new_size * sizeof(void *))))
+    if (!(t = resize_slots(arr, new_size)))
         return -1;
     arr->array = (void **)t;
     arr->size = new_size;
@@ -144,6 +177,9 @@ int pcutils_arrlist_shrink(struct pcutils_arrlist *arr, size_t empty_slots)
         return pcutils_arrlist_expand_internal(arr, new_size);
     if (new_size == 0)
         new_size = 1;
+    /* the inline slots can not be shrunk */
+    if (arr->array == inline_slots(arr))
+        return 0;
 
     if (!(t = realloc(arr->array, new_size * sizeof(void *))))
         return -1;
@@ -22,6 +22,7 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdlib.h>
@@ -31,20 +32,67 @@
 #include "purc-ports.h"
 #include "purc-utils.h"
 #include "purc-errors.h"
+#include "private/atom-buckets.h"
+#include "private/hashtable.h"
 #include "private/instance.h"
-#include "private/map.h"
 #include "private/utils.h"
 
 #if PURC_ATOM_BUCKET_BITS > 16
 #error "Too many bits reserved for bucket"
 #endif
 
+/*
+ * The lookups take no lock and write nothing shared: a bucket has a hash
+ * table of chained entries, and an array of the strings indexed by the
+ * sequence numbers of the atoms. The writers are serialized by a mutex and
+ * publish a new entry or a new array with a release store, so a reader
+ * sees either the old state or the new one.
+ *
+ * Nothing a reader may be reading is freed before the program exits:
+ *  - a removed string stays in the table with its atom cleared, and gets
+ *    a new atom if it is added again;
+ *  - the tables and the string arrays replaced by the bigger ones are
+ *    retired, which at most doubles the memory used.
+ * This is the same trade-off made by the quarks of glib.
+ *
+ * The static strings of a bucket (the keywords and the exception names)
+ * are not in the table at all: they are found by the perfect hash made at
+ * build time, have the first sequence numbers, and are never removed.
+ */
+
+struct atom_entry {
+    /* immutable once the entry is published */
+    struct atom_entry              *next;
+    char                           *string;
+    unsigned long                   hash;
+    bool                            need_free;
+
+    /* zero if the string is removed */
+    atomic_uint                     atom;
+};
+
+struct atom_table {
+    struct atom_table              *retired;    /* the older tables */
+    size_t                          nr_slots;   /* a power of 2 */
+    size_t                          nr_entries; /* including the removed */
+    _Atomic(struct atom_entry *)    slots[];
+};
+
+struct atom_strings {
+    struct atom_strings            *retired;    /* the older arrays */
+    size_t                          size;
+    _Atomic(char *)                 strings[];  /* indexed by sequence */
+};
+
 static struct atom_bucket {
-    purc_atom_t     bucket_bits;
-    purc_atom_t     atom_seq_id;
+    purc_atom_t                     bucket_bits;
+    purc_atom_t                     atom_seq_id;
+
+    _Atomic(struct atom_table *)    table;
+    _Atomic(struct atom_strings *)  quarks;
 
-    pcutils_map    *atom_map;
-    char**          quarks;
+    size_t                          nr_removed;
+    size_t                          nr_resizes;
 } atom_buckets[PURC_ATOM_BUCKETS_NR];
 
 #define ATOM_BITS_NR        (sizeof(purc_atom_t) << 3)
@@ -62,101 +110,202 @@ static struct atom_bucket {
     (seq < ((purc_atom_t)1 << (ATOM_BITS_NR - PURC_ATOM_BUCKET_BITS)))
 
 #define ATOM_BLOCK_SIZE         (1024 >> PURC_ATOM_BUCKET_BITS)
+#define ATOM_TABLE_SIZE         256
 #define ATOM_STRING_BLOCK_SIZE  (4096 - sizeof (size_t))
 
 static inline purc_atom_t
-atom_new(struct atom_bucket *bucket, char *string, bool need_free);
+atom_new(struct atom_bucket *bucket, char *string);
 
-static purc_rwlock atom_rwlock;
+static purc_mutex atom_mutex;
 static char *atom_block = NULL;
 static int  atom_block_offset = 0;
 
-static void atom_init_bucket(struct atom_bucket *bucket)
+static struct atom_table *atom_table_new(size_t nr_slots)
+{
+    struct atom_table *table = calloc(1, sizeof(*table) +
+            sizeof(table->slots[0]) * nr_slots);
+    if (table)
+        table->nr_slots = nr_slots;
+    return table;
+}
+
+static struct atom_strings *atom_strings_new(size_t size)
+{
+    struct atom_strings *quarks = calloc(1, sizeof(*quarks) +
+            sizeof(quarks->strings[0]) * size);
+    if (quarks)
+        quarks->size = size;
+    return quarks;
+}
+
+/* HOLDS: atom_mutex */
+static bool atom_init_bucket(struct atom_bucket *bucket)
 {
     assert (bucket->atom_seq_id == 0);
 
-    bucket->atom_map = pcutils_map_create(NULL, NULL, NULL, NULL,
-            comp_key_string, false);
-    bucket->quarks = (char **)malloc(sizeof(char *) * ATOM_BLOCK_SIZE);
-    bucket->quarks[0] = NULL;
-    bucket->atom_seq_id = 1;
+    struct atom_table *table = atom_table_new(ATOM_TABLE_SIZE);
+    struct atom_strings *quarks = atom_strings_new(ATOM_BLOCK_SIZE);
+    if (table == NULL || quarks == NULL) {
+        free(table);
+        free(quarks);
+        return false;
+    }
 
-    assert(bucket->quarks != NULL);
+    atomic_store_explicit(&bucket->table, table, memory_order_release);
+    atomic_store_explicit(&bucket->quarks, quarks, memory_order_release);
+    /* the first sequence numbers are taken by the static strings */
+    bucket->atom_seq_id = 1 +
+        pcatom_static_buckets[ATOM_TO_BUCKET(bucket->bucket_bits)].nr_strings;
+    return true;
 }
 
+/* HOLDS: atom_mutex */
 static inline struct atom_bucket *atom_get_bucket(int bucket)
 {
     assert(bucket >= 0 && bucket < PURC_ATOM_BUCKETS_NR);
 
     struct atom_bucket *atom_bucket = atom_buckets + bucket;
     if (UNLIKELY(atom_bucket->atom_seq_id == 0)) {
-        atom_init_bucket(atom_bucket);
         atom_bucket->bucket_bits = BUCKET_BITS(bucket);
+        if (!atom_init_bucket(atom_bucket))
+            return NULL;
     }
 
     return atom_bucket;
 }
 
-static inline void atom_put_bucket(int bucket)
+static void atom_put_bucket(int bucket)
 {
     assert(bucket >= 0 && bucket < PURC_ATOM_BUCKETS_NR);
 
     struct atom_bucket *atom_bucket = atom_buckets + bucket;
-    if (LIKELY(atom_bucket->atom_map)) {
-        pcutils_map_destroy(atom_bucket->atom_map);
-        free(atom_bucket->quarks);
-        memset(atom_bucket, 0, sizeof(*atom_bucket));
+    struct atom_table *table = atomic_load_explicit(&atom_bucket->table,
+            memory_order_relaxed);
+    while (table) {
+        for (size_t i = 0; i < table->nr_slots; i++) {
+            struct atom_entry *entry = atomic_load_explicit(&table->slots[i],
+                    memory_order_relaxed);
+            while (entry) {
+                struct atom_entry *next = entry->next;
+                if (entry->need_free)
+                    free(entry->string);
+                free(entry);
+                entry = next;
+            }
+        }
+
+        struct atom_table *retired = table->retired;
+        free(table);
+        table = retired;
+    }
+
+    struct atom_strings *quarks = atomic_load_explicit(&atom_bucket->quarks,
+            memory_order_relaxed);
+    while (quarks) {
+        struct atom_strings *retired = quarks->retired;
+        free(quarks);
+        quarks = retired;
     }
+
+    memset(atom_bucket, 0, sizeof(*atom_bucket));
 }
 
-purc_atom_t
-purc_atom_try_string_ex(int bucket, const char *string)
+/* returns the atom of @string if it is a static string of @bucket */
+static inline purc_atom_t static_atom(int bucket, const char *string)
 {
-    struct atom_bucket *atom_bucket = atom_get_bucket(bucket);
-    const pcutils_map_entry* entry = NULL;
-    purc_atom_t atom = 0;
+    const struct pcatom_static_bucket *sb = pcatom_static_buckets + bucket;
+    if (sb->nr_strings == 0)
+        return 0;
 
-    if (string == NULL || atom_bucket == NULL)
+    uint32_t seed = sb->seeds[pcatom_static_hash(0, string) % sb->nr_seeds];
+    uint32_t slot = pcatom_static_hash(seed, string) % sb->nr_strings;
+    if (strcmp(sb->strings[slot], string))
         return 0;
 
-    purc_rwlock_reader_lock(&atom_rwlock);
-    if ((entry = pcutils_map_find(atom_bucket->atom_map, string))) {
-        atom = (purc_atom_t)(uintptr_t)entry->val;
+    return PCATOM_STATIC(bucket, slot + 1);
+}
+
+static inline unsigned long atom_hash(const char *string)
+{
+    return pchash_perllike_str_hash(string);
+}
+
+/* finds the entry of @string in @table, including a removed one */
+static struct atom_entry *
+atom_find(struct atom_table *table, const char *string, unsigned long hash)
+{
+    struct atom_entry *entry = atomic_load_explicit(
+            &table->slots[hash & (table->nr_slots - 1)], memory_order_acquire);
+
+    while (entry) {
+        if (entry->hash == hash && strcmp(entry->string, string) == 0)
+            return entry;
+        entry = entry->next;
     }
-    purc_rwlock_reader_unlock(&atom_rwlock);
 
-    return atom;
+    return NULL;
+}
+
+purc_atom_t
+purc_atom_try_string_ex(int bucket, const char *string)
+{
+    if (string == NULL || bucket < 0 || bucket >= PURC_ATOM_BUCKETS_NR)
+        return 0;
+
+    purc_atom_t atom = static_atom(bucket, string);
+    if (atom)
+        return atom;
+
+    struct atom_table *table = atomic_load_explicit(
+            &atom_buckets[bucket].table, memory_order_acquire);
+    if (table == NULL)
+        return 0;
+
+    struct atom_entry *entry = atom_find(table, string, atom_hash(string));
+    if (entry)
+        return atomic_load_explicit(&entry->atom, memory_order_acquire);
+    return 0;
 }
 
 bool
 purc_atom_remove_string_ex(int bucket, const char *string)
 {
-    struct atom_bucket *atom_bucket = atom_get_bucket(bucket);
+    if (string == NULL || bucket < 0 || bucket >= PURC_ATOM_BUCKETS_NR)
+        return false;
 
-    if (string == NULL || atom_bucket == NULL)
+    /* the static strings are never removed */
+    if (static_atom(bucket, string))
         return false;
 
-    const pcutils_map_entry* entry;
-    bool ret;
-    purc_atom_t atom;
+    bool ret = false;
+    purc_mutex_lock(&atom_mutex);
+
+    struct atom_bucket *atom_bucket = atom_get_bucket(bucket);
+    if (atom_bucket == NULL)
+        goto done;
 
-    purc_rwlock_writer_lock(&atom_rwlock);
-    if ((entry = pcutils_map_find(atom_bucket->atom_map, string))) {
-        atom = (purc_atom_t)(uintptr_t)entry->val;
-        pcutils_map_erase(atom_bucket->atom_map, (void *)string);
-        atom = ATOM_TO_SEQUENCE(atom);
-        atom_bucket->quarks[atom] = NULL;
+    struct atom_table *table = atomic_load_explicit(&atom_bucket->table,
+            memory_order_relaxed);
+    struct atom_entry *entry = atom_find(table, string, atom_hash(string));
+    purc_atom_t atom;
+    if (entry && (atom = atomic_load_explicit(&entry->atom,
+                    memory_order_relaxed))) {
+        atomic_store_explicit(&entry->atom, 0, memory_order_release);
+
+        struct atom_strings *quarks = atomic_load_explicit(
+                &atom_bucket->quarks, memory_order_relaxed);
+        atomic_store_explicit(&quarks->strings[ATOM_TO_SEQUENCE(atom)], NULL,
+                memory_order_release);
+        atom_bucket->nr_removed++;
         ret = true;
     }
-    else {
-        ret = false;
-    }
-    purc_rwlock_writer_unlock(&atom_rwlock);
 
+done:
+    purc_mutex_unlock(&atom_mutex);
     return ret;
 }
 
-/* HOLDS: atom_rwlock_lock */
+/* HOLDS: atom_mutex */
 static char *
 atom_strdup(const char *string, bool *need_free)
 {
@@ -176,6 +325,8 @@ atom_strdup(const char *string, bool *need_free)
     *need_free = false;
     if (atom_block == NULL) {
         atom_block = malloc(ATOM_STRING_BLOCK_SIZE);
+        if (atom_block == NULL)
+            return NULL;
     }
 
     copy = atom_block + atom_block_offset;
@@ -185,45 +336,152 @@ atom_strdup(const char *string, bool *need_free)
     return copy;
 }
 
-/* HOLDS: purc_atom_rwlock_writer_lock */
+/* HOLDS: atom_mutex; doubles the slots of the table of @bucket */
+static void
+atom_grow_table(struct atom_bucket *bucket)
+{
+    struct atom_table *old = atomic_load_explicit(&bucket->table,
+            memory_order_relaxed);
+    struct atom_table *table = atom_table_new(old->nr_slots * 2);
+    if (table == NULL)
+        return;     /* keep the longer chains */
+
+    /* the entries of the old table may be being read; copy them */
+    for (size_t i = 0; i < old->nr_slots; i++) {
+        struct atom_entry *entry = atomic_load_explicit(&old->slots[i],
+                memory_order_relaxed);
+        for (; entry; entry = entry->next) {
+            struct atom_entry *copy = malloc(sizeof(*copy));
+            if (copy == NULL)
+                goto failed;
+
+            size_t slot = entry->hash & (table->nr_slots - 1);
+            copy->next = atomic_load_explicit(&table->slots[slot],
+                    memory_order_relaxed);
+            copy->string = entry->string;
+            copy->hash = entry->hash;
+            copy->need_free = false;
+            atomic_init(&copy->atom,
+                    atomic_load_explicit(&entry->atom, memory_order_relaxed));
+            atomic_store_explicit(&table->slots[slot], copy,
+                    memory_order_relaxed);
+            table->nr_entries++;
+        }
+    }
+
+    /* the new table owns the strings now */
+    for (size_t i = 0; i < table->nr_slots; i++) {
+        struct atom_entry *copy = atomic_load_explicit(&table->slots[i],
+                memory_order_relaxed);
+        for (; copy; copy = copy->next) {
+            struct atom_entry *entry = atom_find(old, copy->string, copy->hash);
+            copy->need_free = entry->need_free;
+            entry->need_free = false;
+        }
+    }
+
+    table->retired = old;
+    atomic_store_explicit(&bucket->table, table, memory_order_release);
+    bucket->nr_resizes++;
+    return;
+
+failed:
+    for (size_t i = 0; i < table->nr_slots; i++) {
+        struct atom_entry *copy = atomic_load_explicit(&table->slots[i],
+                memory_order_relaxed);
+        while (copy) {
+            struct atom_entry *next = copy->next;
+            free(copy);
+            copy = next;
+        }
+    }
+    free(table);
+}
+
+/* HOLDS: atom_mutex */
 static inline purc_atom_t
 atom_from_string(struct atom_bucket *bucket, const char *string,
         bool duplicate, bool *newly_created)
 {
     purc_atom_t atom = 0;
-    pcutils_map_entry* entry;
+    struct atom_table *table = atomic_load_explicit(&bucket->table,
+            memory_order_relaxed);
+    unsigned long hash = atom_hash(string);
 
-    entry = pcutils_map_find(bucket->atom_map, string);
+    struct atom_entry *entry = atom_find(table, string, hash);
     if (entry) {
-        atom = (purc_atom_t)(uintptr_t)entry->val;
-        assert(atom);
-
-        if (newly_created)
-            *newly_created = false;
+        atom = atomic_load_explicit(&entry->atom, memory_order_relaxed);
+        if (atom) {
+            if (newly_created)
+                *newly_created = false;
+            return atom;
+        }
+
+        /* removed before; give it a new atom */
+        atom = atom_new(bucket, entry->string);
+        if (atom) {
+            atomic_store_explicit(&entry->atom, atom, memory_order_release);
+            bucket->nr_removed--;
+        }
     }
     else {
-        bool need_free;
-        if (duplicate)
-            string = atom_strdup(string, &need_free);
-        else
-            need_free = false;
-        atom = atom_new(bucket, (char *)string, need_free);
-
-        if (newly_created)
-            *newly_created = true;
+        entry = malloc(sizeof(*entry));
+        if (entry == NULL)
+            return 0;
+
+        bool need_free = false;
+        char *copy = (char *)string;
+        if (duplicate && (copy = atom_strdup(string, &need_free)) == NULL) {
+            free(entry);
+            return 0;
+        }
+
+        atom = atom_new(bucket, copy);
+        if (atom == 0) {
+            if (need_free)
+                free(copy);
+            free(entry);
+            return 0;
+        }
+
+        size_t slot = hash & (table->nr_slots - 1);
+        entry->next = atomic_load_explicit(&table->slots[slot],
+                memory_order_relaxed);
+        entry->string = copy;
+        entry->hash = hash;
+        entry->need_free = need_free;
+        atomic_init(&entry->atom, atom);
+        atomic_store_explicit(&table->slots[slot], entry,
+                memory_order_release);
+
+        if (++table->nr_entries > table->nr_slots)
+            atom_grow_table(bucket);
     }
 
+    if (newly_created)
+        *newly_created = (atom != 0);
     return atom;
 }
 
 static inline purc_atom_t
-atom_from_string_locked(struct atom_bucket *bucket, const char *string,
+atom_from_string_locked(int bucket, const char *string,
         bool duplicate, bool *newly_created)
 {
-    purc_atom_t atom = 0;
-    purc_rwlock_writer_lock(&atom_rwlock);
-    atom = atom_from_string(bucket, string, duplicate, newly_created);
-    purc_rwlock_writer_unlock(&atom_rwlock);
+    if (bucket < 0 || bucket >= PURC_ATOM_BUCKETS_NR)
+        return 0;
+
+    purc_atom_t atom = static_atom(bucket, string);
+    if (atom) {
+        if (newly_created)
+            *newly_created = false;
+        return atom;
+    }
+
+    purc_mutex_lock(&atom_mutex);
+    struct atom_bucket *atom_bucket = atom_get_bucket(bucket);
+    if (atom_bucket)
+        atom = atom_from_string(atom_bucket, string, duplicate, newly_created);
+    purc_mutex_unlock(&atom_mutex);
 
     return atom;
 }
@@ -234,8 +492,7 @@ purc_atom_from_string_ex2(int bucket, const char *string, bool *newly_created)
     if (!string)
         return 0;
 
-    return atom_from_string_locked(atom_get_bucket(bucket), string,
-            true, newly_created);
+    return atom_from_string_locked(bucket, string, true, newly_created);
 }
 
 purc_atom_t
@@ -245,79 +502,108 @@ purc_atom_from_static_string_ex2(int bucket, const char *string,
     if (!string)
         return 0;
 
-    return atom_from_string_locked(atom_get_bucket(bucket), string,
-            false, newly_created);
+    return atom_from_string_locked(bucket, string, false, newly_created);
 }
 
 const char *
 purc_atom_to_string(purc_atom_t atom)
 {
-    int bucket;
-    char* result = NULL;
-
     if (atom == 0)
         return NULL;
 
-    bucket = ATOM_TO_BUCKET(atom);
-    struct atom_bucket *atom_bucket = atom_get_bucket(bucket);
+    int bucket = ATOM_TO_BUCKET(atom);
+    const struct pcatom_static_bucket *sb = pcatom_static_buckets + bucket;
     atom = ATOM_TO_SEQUENCE(atom);
-    purc_rwlock_reader_lock(&atom_rwlock);
-    if (atom < atom_bucket->atom_seq_id)
-        result = atom_bucket->quarks[atom];
-    purc_rwlock_reader_unlock(&atom_rwlock);
+    if (atom == 0)
+        return NULL;
+    if (atom <= sb->nr_strings)
+        return sb->strings[atom - 1];
 
-    return result;
-}
+    struct atom_strings *quarks = atomic_load_explicit(
+            &atom_buckets[bucket].quarks, memory_order_acquire);
+    if (quarks && atom < quarks->size)
+        return atomic_load_explicit(&quarks->strings[atom],
+                memory_order_acquire);
 
-static void free_dup_key(void *key, void *data)
-{
-    UNUSED_PARAM(data);
-    if (key)
-        free(key);
+    return NULL;
 }
 
-/* HOLDS: purc_atom_rwlock_writer_lock */
+/* HOLDS: atom_mutex */
 static inline purc_atom_t
-atom_new(struct atom_bucket *bucket, char *string, bool need_free)
+atom_new(struct atom_bucket *bucket, char *string)
 {
     purc_atom_t atom;
-    char **atoms_new;
-
-    if (bucket->atom_seq_id % ATOM_BLOCK_SIZE == 0) {
-        atoms_new = (char **)malloc(sizeof (char *) *
-                (bucket->atom_seq_id + ATOM_BLOCK_SIZE));
-        if (bucket->atom_seq_id != 0)
-            memcpy(atoms_new, bucket->quarks,
-                    sizeof (char *) * bucket->atom_seq_id);
-        memset(atoms_new + bucket->atom_seq_id, 0,
-                sizeof (char *) * ATOM_BLOCK_SIZE);
-
-        /*
-         * The implementation in glib did not free the old quarks array.
-         * The author said: `This leaks the old quarks array. Its unfortunate,
-         * but it allows us to do lockless lookup of the arrays, and there
-         * shouldn't be that many quarks in an app`.
-         *
-         * In our implementation, we do free the old quarks.
-         * Indeed, we can use realloc() instead of malloc() and memcpy()
-         */
-        free(bucket->quarks);
-        bucket->quarks = atoms_new;
+    struct atom_strings *quarks = atomic_load_explicit(&bucket->quarks,
+            memory_order_relaxed);
+
+    if (!IS_VALID_SEQ_ID(bucket->atom_seq_id))
+        return 0;
+
+    if (bucket->atom_seq_id >= quarks->size) {
+        /* the old array may be being read; retire it instead of freeing */
+        struct atom_strings *quarks_new = atom_strings_new(quarks->size * 2);
+        if (quarks_new == NULL)
+            return 0;
+
+        for (size_t i = 0; i < quarks->size; i++) {
+            atomic_init(&quarks_new->strings[i],
+                    atomic_load_explicit(&quarks->strings[i],
+                        memory_order_relaxed));
+        }
+
+        quarks_new->retired = quarks;
+        atomic_store_explicit(&bucket->quarks, quarks_new,
+                memory_order_release);
+        quarks = quarks_new;
     }
 
     atom = bucket->atom_seq_id;
-    bucket->quarks[atom] = string;
+    atomic_store_explicit(&quarks->strings[atom], string,
+            memory_order_release);
     atom |= bucket->bucket_bits;
-    pcutils_map_insert_ex(bucket->atom_map,
-                string, (void *)(uintptr_t)atom,
-                need_free ? free_dup_key : NULL);
     bucket->atom_seq_id++;
 
-    assert(IS_VALID_SEQ_ID(bucket->atom_seq_id));
-
     return atom;
 }
 
+bool
+purc_atom_bucket_stat(int bucket, struct purc_atom_stat *stat)
+{
+    if (bucket < 0 || bucket >= PURC_ATOM_BUCKETS_NR || stat == NULL)
+        return false;
+
+    memset(stat, 0, sizeof(*stat));
+
+    purc_mutex_lock(&atom_mutex);
+    struct atom_bucket *atom_bucket = atom_buckets + bucket;
+    struct atom_table *table = atomic_load_explicit(&atom_bucket->table,
+            memory_order_relaxed);
+    stat->nr_atoms = pcatom_static_buckets[bucket].nr_strings;
+    if (table) {
+        stat->nr_atoms += table->nr_entries - atom_bucket->nr_removed;
+        stat->nr_removed = atom_bucket->nr_removed;
+        stat->nr_slots = table->nr_slots;
+        stat->nr_resizes = atom_bucket->nr_resizes;
+
+        for (size_t i = 0; i < table->nr_slots; i++) {
+            struct atom_entry *entry = atomic_load_explicit(&table->slots[i],
+                    memory_order_relaxed);
+            size_t len = 0;
+            for (; entry; entry = entry->next)
+                len++;
+
+            if (len) {
+                stat->nr_used_slots++;
+                if (len > stat->max_chain_len)
+                    stat->max_chain_len = len;
+            }
+        }
+    }
+    purc_mutex_unlock(&atom_mutex);
+
+    return true;
+}
+
 static void
 atom_cleanup_once(void)
 {
@@ -327,8 +613,8 @@ atom_cleanup_once(void)
         atom_put_bucket(bucket);
     }
 
-    if (atom_rwlock.native_impl)
-        purc_rwlock_clear(&atom_rwlock);
+    if (atom_mutex.native_impl)
+        purc_mutex_clear(&atom_mutex);
     if (atom_block)
         free(atom_block);
 }
@@ -338,8 +624,8 @@ atom_init_once(void)
 {
     int r = 0;
 
-    purc_rwlock_init(&atom_rwlock);
-    if (atom_rwlock.native_impl == NULL)
+    purc_mutex_init(&atom_mutex);
+    if (atom_mutex.native_impl == NULL)
         goto fail_lock;
 
     /* init the default bucket only */
@@ -360,13 +646,14 @@ fail_atexit:
     }
 
 fail_atom:
-    purc_rwlock_clear(&atom_rwlock);
+    purc_mutex_clear(&atom_mutex);
 
 fail_lock:
     return -1;
 }
 
 struct pcmodule _module_atom = {
+    .name            = "atom",
     .id              = PURC_HAVE_UTILS,
     .module_inited   = 0,
 
@@ -62,6 +62,23 @@
 
 #include "private/utils.h"
 
+/*
+ * The blocks of the complete quanta are converted with SIMD instructions:
+ * the SSSE3 ones are used on x86 when the CPU supports them, which is
+ * checked at run time; the NEON ones are always there on AArch64. The
+ * algorithms are those of Wojciech Muła and Daniel Lemire. The decoder
+ * leaves a block with a white space, a pad, or an invalid character to
+ * the scalar code, so the results are always the same as the latter.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <tmmintrin.h>
+#define HAVE_B64_SSSE3      1
+#define TARGET_SSSE3        __attribute__((target("ssse3")))
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define HAVE_B64_NEON       1
+#endif
+
 static const char Base64[] =
     "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 static const char Pad64 = '=';
@@ -129,61 +146,276 @@ static const char Pad64 = '=';
        characters followed by one "=" padding character.
    */
 
+static inline char *encode_quantum(char *target, const unsigned char *src)
+{
+    uint32_t v = ((uint32_t)src[0] << 16) | ((uint32_t)src[1] << 8) | src[2];
+
+    target[0] = Base64[v >> 18];
+    target[1] = Base64[(v >> 12) & 0x3f];
+    target[2] = Base64[(v >> 6) & 0x3f];
+    target[3] = Base64[v & 0x3f];
+    return target + 4;
+}
+
+/* not a character of the alphabet */
+#define B64_INVALID     0xFF
+
+/* the values of the characters of the alphabet */
+static const unsigned char b64_values[256] = {
+#define XX  B64_INVALID
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, 62, XX, XX, XX, 63,
+    52, 53, 54, 55, 56, 57, 58, 59, 60, 61, XX, XX, XX, XX, XX, XX,
+    XX,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, XX, XX, XX, XX, XX,
+    XX, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+    41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+#undef XX
+};
+
+#if HAVE_B64_SSSE3
+
+/* converts 12 bytes read from 16 ones at @src to 16 characters */
+static inline TARGET_SSSE3 __m128i
+encode_block_ssse3(const unsigned char *src)
+{
+    __m128i in = _mm_loadu_si128((const __m128i *)src);
+
+    /* the bytes of a quantum in a 32-bit lane: b, a, c, b */
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7,
+                4, 5, 3, 4, 1, 2, 0, 1));
+
+    /* move the 6-bit fields to the bytes */
+    __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    __m128i indices = _mm_or_si128(t1, t3);
+
+    /* the offsets of the characters for the ranges of the values */
+    __m128i classes = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    classes = _mm_or_si128(classes, _mm_and_si128(less, _mm_set1_epi8(13)));
+
+    const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    return _mm_add_epi8(_mm_shuffle_epi8(offsets, classes), indices);
+}
+
+static TARGET_SSSE3 size_t
+encode_blocks_ssse3(char *target, const unsigned char *src, size_t srclength)
+{
+    size_t done = 0;
+
+    /* 16 bytes are read for a block of 12 ones */
+    while (srclength - done >= 16) {
+        __m128i out = encode_block_ssse3(src + done);
+        _mm_storeu_si128((__m128i *)target, out);
+        target += 16;
+        done += 12;
+    }
+
+    return done;
+}
+
+/* converts the blocks of 16 characters in @src to 12 bytes each; returns
+   the number of the characters converted */
+static TARGET_SSSE3 size_t
+decode_blocks_ssse3(unsigned char *target, const char *src, size_t len,
+        size_t targsize)
+{
+    const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11,
+            0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08,
+            0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+            0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    size_t done = 0;
+    size_t tarindex = 0;
+
+    while (len - done >= 16 && tarindex + 12 <= targsize) {
+        __m128i in = _mm_loadu_si128((const __m128i *)(src + done));
+        __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(in, 4), nibble);
+        __m128i lo_nibbles = _mm_and_si128(in, nibble);
+
+        /* a character out of the alphabet has a bit in both lookups */
+        __m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+        __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+        if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi),
+                        _mm_setzero_si128())))
+            break;
+
+        __m128i eq_slash = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+        __m128i roll = _mm_shuffle_epi8(lut_roll,
+                _mm_add_epi8(eq_slash, hi_nibbles));
+        __m128i values = _mm_add_epi8(in, roll);
+
+        /* pack four 6-bit values to three bytes */
+        __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+        __m128i out = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+        out = _mm_shuffle_epi8(out, _mm_setr_epi8(2, 1, 0, 6, 5, 4,
+                    10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+        /* store exactly 12 bytes, the bytes after are of the caller */
+        _mm_storel_epi64((__m128i *)(target + tarindex), out);
+        uint32_t last = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(out, 8));
+        memcpy(target + tarindex + 8, &last, sizeof(last));
+
+        done += 16;
+        tarindex += 12;
+    }
+
+    return done;
+}
+
+#elif HAVE_B64_NEON
+
+/* converts the blocks of 48 bytes to 64 characters each */
+static size_t
+encode_blocks_neon(char *target, const unsigned char *src, size_t srclength)
+{
+    const uint8x16x4_t alphabet = vld1q_u8_x4((const uint8_t *)Base64);
+    const uint8x16_t mask6 = vdupq_n_u8(0x3f);
+    size_t done = 0;
+
+    while (srclength - done >= 48) {
+        uint8x16x3_t in = vld3q_u8(src + done);
+        uint8x16x4_t out;
+
+        out.val[0] = vshrq_n_u8(in.val[0], 2);
+        out.val[1] = vandq_u8(vorrq_u8(vshlq_n_u8(in.val[0], 4),
+                    vshrq_n_u8(in.val[1], 4)), mask6);
+        out.val[2] = vandq_u8(vorrq_u8(vshlq_n_u8(in.val[1], 2),
+                    vshrq_n_u8(in.val[2], 6)), mask6);
+        out.val[3] = vandq_u8(in.val[2], mask6);
+
+        for (int i = 0; i < 4; i++)
+            out.val[i] = vqtbl4q_u8(alphabet, out.val[i]);
+
+        vst4q_u8((uint8_t *)target, out);
+        target += 64;
+        done += 48;
+    }
+
+    return done;
+}
+
+/* converts the blocks of 64 characters in @src to 48 bytes each; returns
+   the number of the characters converted */
+static size_t
+decode_blocks_neon(unsigned char *target, const char *src, size_t len,
+        size_t targsize)
+{
+    const uint8x16x4_t values_lo = vld1q_u8_x4(b64_values);
+    const uint8x16x4_t values_hi = vld1q_u8_x4(b64_values + 64);
+    size_t done = 0;
+    size_t tarindex = 0;
+
+    while (len - done >= 64 && tarindex + 48 <= targsize) {
+        uint8x16x4_t in = vld4q_u8((const uint8_t *)src + done);
+        uint8x16_t bad = vdupq_n_u8(0);
+
+        for (int i = 0; i < 4; i++) {
+            uint8x16_t c = in.val[i];
+            /* the indices out of a table give zeros */
+            uint8x16_t v = vorrq_u8(vqtbl4q_u8(values_lo, c),
+                    vqtbl4q_u8(values_hi, vsubq_u8(c, vdupq_n_u8(64))));
+            bad = vorrq_u8(bad, vorrq_u8(vceqq_u8(v, vdupq_n_u8(B64_INVALID)),
+                        vcgeq_u8(c, vdupq_n_u8(0x80))));
+            in.val[i] = v;
+        }
+
+        if (vmaxvq_u8(bad))
+            break;
+
+        uint8x16x3_t out;
+        out.val[0] = vorrq_u8(vshlq_n_u8(in.val[0], 2),
+                vshrq_n_u8(in.val[1], 4));
+        out.val[1] = vorrq_u8(vshlq_n_u8(in.val[1], 4),
+                vshrq_n_u8(in.val[2], 2));
+        out.val[2] = vorrq_u8(vshlq_n_u8(in.val[2], 6), in.val[3]);
+        vst3q_u8(target + tarindex, out);
+
+        done += 64;
+        tarindex += 48;
+    }
+
+    return done;
+}
+
+#endif /* HAVE_B64_NEON */
+
+/*
+ * The size of the target is checked once in advance, so the loop converts
+ * the complete quanta without any bounds checking, four quanta per round.
+ */
 ssize_t pcutils_b64_encode(const void *_src, size_t srclength,
            void *dest, size_t targsize)
 {
     const unsigned char *src = _src;
     char *target = dest;
-    size_t datalength = 0;
-    u_char input[3] = {0};
-    u_char output[4];
-    size_t i;
 
     assert(dest && targsize > 0);
 
-    while (2 < srclength) {
-        input[0] = *src++;
-        input[1] = *src++;
-        input[2] = *src++;
-        srclength -= 3;
+    /* Returned value doesn't count \0. */
+    size_t datalength = (srclength + 2) / 3 * 4;
+    if (datalength >= targsize)
+        return (-1);
 
-        output[0] = input[0] >> 2;
-        output[1] = ((input[0] & 0x03) << 4) + (input[1] >> 4);
-        output[2] = ((input[1] & 0x0f) << 2) + (input[2] >> 6);
-        output[3] = input[2] & 0x3f;
+#if HAVE_B64_SSSE3
+    if (__builtin_cpu_supports("ssse3")) {
+        size_t done = encode_blocks_ssse3(target, src, srclength);
+        target += done / 3 * 4;
+        src += done;
+        srclength -= done;
+    }
+#elif HAVE_B64_NEON
+    size_t done = encode_blocks_neon(target, src, srclength);
+    target += done / 3 * 4;
+    src += done;
+    srclength -= done;
+#endif
+
+    while (srclength >= 12) {
+        target = encode_quantum(target, src);
+        target = encode_quantum(target, src + 3);
+        target = encode_quantum(target, src + 6);
+        target = encode_quantum(target, src + 9);
+        src += 12;
+        srclength -= 12;
+    }
 
-        if (datalength + 4 > targsize)
-            return (-1);
-        target[datalength++] = Base64[output[0]];
-        target[datalength++] = Base64[output[1]];
-        target[datalength++] = Base64[output[2]];
-        target[datalength++] = Base64[output[3]];
+    while (srclength >= 3) {
+        target = encode_quantum(target, src);
+        src += 3;
+        srclength -= 3;
     }
 
     /* Now we worry about padding. */
     if (0 != srclength) {
-        /* Get what's left. */
-        input[0] = input[1] = input[2] = '\0';
-        for (i = 0; i < srclength; i++)
-            input[i] = *src++;
-
-        output[0] = input[0] >> 2;
-        output[1] = ((input[0] & 0x03) << 4) + (input[1] >> 4);
-        output[2] = ((input[1] & 0x0f) << 2) + (input[2] >> 6);
+        unsigned char input[3] = { src[0], 0, 0 };
+        if (srclength == 2)
+            input[1] = src[1];
 
-        if (datalength + 4 > targsize)
-            return (-1);
-        target[datalength++] = Base64[output[0]];
-        target[datalength++] = Base64[output[1]];
+        encode_quantum(target, input);
         if (srclength == 1)
-            target[datalength++] = Pad64;
-        else
-            target[datalength++] = Base64[output[2]];
-        target[datalength++] = Pad64;
+            target[2] = Pad64;
+        target[3] = Pad64;
+        target += 4;
     }
-    if (datalength >= targsize)
-        return (-1);
-    target[datalength] = '\0';    /* Returned value doesn't count \0. */
+
+    *target = '\0';
     return (datalength);
 }
 
@@ -199,14 +431,28 @@ ssize_t pcutils_b64_decode(const void *_src, void *dest, size_t targsize)
     unsigned char *target = dest;
     int state, ch;
     size_t tarindex;
-    u_char nextbyte;
-    char *pos;
+    u_char nextbyte, value;
 
     state = 0;
     tarindex = 0;
 
     assert(dest && targsize > 0);
 
+#if HAVE_B64_SSSE3 || HAVE_B64_NEON
+    /* the length is known before reading the blocks */
+    size_t len = strlen(src);
+    size_t done = 0;
+#if HAVE_B64_SSSE3
+    if (__builtin_cpu_supports("ssse3"))
+        done = decode_blocks_ssse3(target, src, len, targsize);
+    tarindex = done / 4 * 3;
+#else
+    done = decode_blocks_neon(target, src, len, targsize);
+    tarindex = done / 4 * 3;
+#endif
+    src += done;
+#endif
+
     while ((ch = (unsigned char)*src++) != '\0') {
         if (purc_isspace(ch))    /* Skip whitespace anywhere. */
             continue;
@@ -214,8 +460,8 @@ ssize_t pcutils_b64_decode(const void *_src, void *dest, size_t targsize)
         if (ch == Pad64)
             break;
 
-        pos = strchr(Base64, ch);
-        if (pos == 0)        /* A non-base64 character. */
+        value = b64_values[ch];
+        if (value == B64_INVALID)        /* A non-base64 character. */
             return (-1);
 
         switch (state) {
@@ -223,7 +469,7 @@ ssize_t pcutils_b64_decode(const void *_src, void *dest, size_t targsize)
             if (target) {
                 if (tarindex >= targsize)
                     return (-1);
-                target[tarindex] = (pos - Base64) << 2;
+                target[tarindex] = value << 2;
             }
             state = 1;
             break;
@@ -231,8 +477,8 @@ ssize_t pcutils_b64_decode(const void *_src, void *dest, size_t targsize)
             if (target) {
                 if (tarindex >= targsize)
                     return (-1);
-                target[tarindex]   |=  (pos - Base64) >> 4;
-                nextbyte = ((pos - Base64) & 0x0f) << 4;
+                target[tarindex]   |=  value >> 4;
+                nextbyte = (value & 0x0f) << 4;
                 if (tarindex + 1 < targsize)
                     target[tarindex+1] = nextbyte;
                 else if (nextbyte)
@@ -245,8 +491,8 @@ ssize_t pcutils_b64_decode(const void *_src, void *dest, size_t targsize)
             if (target) {
                 if (tarindex >= targsize)
                     return (-1);
-                target[tarindex]   |=  (pos - Base64) >> 2;
-                nextbyte = ((pos - Base64) & 0x03) << 6;
+                target[tarindex]   |=  value >> 2;
+                nextbyte = (value & 0x03) << 6;
                 if (tarindex + 1 < targsize)
                     target[tarindex+1] = nextbyte;
                 else if (nextbyte)
@@ -259,7 +505,7 @@ ssize_t pcutils_b64_decode(const void *_src, void *dest, size_t targsize)
             if (target) {
                 if (tarindex >= targsize)
                     return (-1);
-                target[tarindex] |= (pos - Base64);
+                target[tarindex] |= value;
             }
             tarindex++;
             state = 0;
@@ -0,0 +1,451 @@
+/*
+ * @file btree.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The implementation of the B-trees of pointers.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "private/btree.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The nodes are split before being descended into if they are full when
+ * inserting, and are filled before being descended into if they have the
+ * minimal items when erasing, so both are done in a single pass from the
+ * root, without the links to the parent nodes.
+ */
+
+#define MIN_DEGREE      8
+#define MAX_ITEMS       (2 * MIN_DEGREE - 1)
+#define MIN_ITEMS       (MIN_DEGREE - 1)
+
+struct pcutils_btree_node {
+    unsigned int                nr_items;
+    unsigned int                leaf;
+    void                       *items[MAX_ITEMS];
+
+    /* only allocated for the internal nodes */
+    struct pcutils_btree_node  *children[];
+};
+
+static struct pcutils_btree_node *node_new(bool leaf)
+{
+    size_t sz = sizeof(struct pcutils_btree_node);
+    if (!leaf)
+        sz += sizeof(struct pcutils_btree_node *) * (MAX_ITEMS + 1);
+
+    struct pcutils_btree_node *node = malloc(sz);
+    if (node) {
+        node->nr_items = 0;
+        node->leaf = leaf;
+    }
+    return node;
+}
+
+/* returns the position of the first item not less than @key (or greater
+   than @key if @after_equal); @found tells whether an equal one exists */
+static unsigned int
+search_node(const struct pcutils_btree_node *node, const void *key,
+        pcutils_btree_cmp_f cmp, void *ctxt, bool after_equal, bool *found)
+{
+    unsigned int lo = 0, hi = node->nr_items;
+
+    *found = false;
+    while (lo < hi) {
+        unsigned int mid = (lo + hi) >> 1;
+        int diff = cmp(node->items[mid], key, ctxt);
+        if (diff == 0)
+            *found = true;
+
+        if (diff < 0 || (diff == 0 && after_equal))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+void pcutils_btree_init(pcutils_btree *tree, pcutils_btree_cmp_f cmp,
+        void *ctxt)
+{
+    memset(tree, 0, sizeof(*tree));
+    tree->cmp = cmp;
+    tree->ctxt = ctxt;
+}
+
+static void
+free_node(struct pcutils_btree_node *node,
+        void (*free_fn)(void *item, void *ctxt), void *ctxt)
+{
+    if (free_fn) {
+        for (unsigned int i = 0; i < node->nr_items; i++)
+            free_fn(node->items[i], ctxt);
+    }
+
+    if (!node->leaf) {
+        for (unsigned int i = 0; i <= node->nr_items; i++)
+            free_node(node->children[i], free_fn, ctxt);
+    }
+
+    free(node);
+}
+
+void pcutils_btree_clear(pcutils_btree *tree,
+        void (*free_fn)(void *item, void *ctxt))
+{
+    if (tree->root)
+        free_node(tree->root, free_fn, tree->ctxt);
+
+    tree->root = NULL;
+    tree->nr_items = 0;
+    tree->height = 0;
+}
+
+/* splits the full child @i of @parent, moving the median up to @parent */
+static int split_child(struct pcutils_btree_node *parent, unsigned int i)
+{
+    struct pcutils_btree_node *left = parent->children[i];
+    struct pcutils_btree_node *right = node_new(left->leaf);
+    if (right == NULL)
+        return -1;
+
+    assert(left->nr_items == MAX_ITEMS);
+    right->nr_items = MIN_ITEMS;
+    memcpy(right->items, left->items + MIN_DEGREE,
+            sizeof(void *) * MIN_ITEMS);
+    if (!left->leaf) {
+        memcpy(right->children, left->children + MIN_DEGREE,
+                sizeof(void *) * MIN_DEGREE);
+    }
+    left->nr_items = MIN_ITEMS;
+
+    memmove(parent->items + i + 1, parent->items + i,
+            sizeof(void *) * (parent->nr_items - i));
+    memmove(parent->children + i + 2, parent->children + i + 1,
+            sizeof(void *) * (parent->nr_items - i));
+    parent->items[i] = left->items[MIN_ITEMS];
+    parent->children[i + 1] = right;
+    parent->nr_items++;
+    return 0;
+}
+
+int pcutils_btree_insert(pcutils_btree *tree, void *item)
+{
+    if (tree->root == NULL) {
+        tree->root = node_new(true);
+        if (tree->root == NULL)
+            return -1;
+        tree->height = 1;
+    }
+    else if (tree->root->nr_items == MAX_ITEMS) {
+        struct pcutils_btree_node *root = node_new(false);
+        if (root == NULL)
+            return -1;
+
+        root->children[0] = tree->root;
+        if (split_child(root, 0)) {
+            free(root);
+            return -1;
+        }
+        tree->root = root;
+        tree->height++;
+    }
+
+    struct pcutils_btree_node *node = tree->root;
+    for (;;) {
+        bool found;
+        unsigned int i = search_node(node, item, tree->cmp, tree->ctxt,
+                false, &found);
+        if (found)
+            return 1;
+
+        if (node->leaf) {
+            memmove(node->items + i + 1, node->items + i,
+                    sizeof(void *) * (node->nr_items - i));
+            node->items[i] = item;
+            node->nr_items++;
+            tree->nr_items++;
+            return 0;
+        }
+
+        if (node->children[i]->nr_items == MAX_ITEMS) {
+            /* the tree is still valid if failed here */
+            if (split_child(node, i))
+                return -1;
+
+            int diff = tree->cmp(node->items[i], item, tree->ctxt);
+            if (diff == 0)
+                return 1;
+            if (diff < 0)
+                i++;
+        }
+
+        node = node->children[i];
+    }
+}
+
+/* merges the child @i + 1 and the item @i of @node into the child @i */
+static struct pcutils_btree_node *
+merge_children(struct pcutils_btree_node *node, unsigned int i)
+{
+    struct pcutils_btree_node *left = node->children[i];
+    struct pcutils_btree_node *right = node->children[i + 1];
+
+    left->items[left->nr_items] = node->items[i];
+    memcpy(left->items + left->nr_items + 1, right->items,
+            sizeof(void *) * right->nr_items);
+    if (!left->leaf) {
+        memcpy(left->children + left->nr_items + 1, right->children,
+                sizeof(void *) * (right->nr_items + 1));
+    }
+    left->nr_items += right->nr_items + 1;
+    free(right);
+
+    memmove(node->items + i, node->items + i + 1,
+            sizeof(void *) * (node->nr_items - i - 1));
+    memmove(node->children + i + 1, node->children + i + 2,
+            sizeof(void *) * (node->nr_items - i - 1));
+    node->nr_items--;
+    return left;
+}
+
+/* makes the child @i of @node have more than the minimal items by
+   borrowing one from a sibling or merging with a sibling */
+static struct pcutils_btree_node *
+fill_child(struct pcutils_btree_node *node, unsigned int i)
+{
+    struct pcutils_btree_node *child = node->children[i];
+
+    if (i > 0 && node->children[i - 1]->nr_items > MIN_ITEMS) {
+        struct pcutils_btree_node *left = node->children[i - 1];
+
+        memmove(child->items + 1, child->items,
+                sizeof(void *) * child->nr_items);
+        child->items[0] = node->items[i - 1];
+        if (!child->leaf) {
+            memmove(child->children + 1, child->children,
+                    sizeof(void *) * (child->nr_items + 1));
+            child->children[0] = left->children[left->nr_items];
+        }
+        child->nr_items++;
+
+        node->items[i - 1] = left->items[left->nr_items - 1];
+        left->nr_items--;
+        return child;
+    }
+
+    if (i < node->nr_items && node->children[i + 1]->nr_items > MIN_ITEMS) {
+        struct pcutils_btree_node *right = node->children[i + 1];
+
+        child->items[child->nr_items] = node->items[i];
+        if (!child->leaf)
+            child->children[child->nr_items + 1] = right->children[0];
+        child->nr_items++;
+
+        node->items[i] = right->items[0];
+        memmove(right->items, right->items + 1,
+                sizeof(void *) * (right->nr_items - 1));
+        if (!right->leaf) {
+            memmove(right->children, right->children + 1,
+                    sizeof(void *) * right->nr_items);
+        }
+        right->nr_items--;
+        return child;
+    }
+
+    if (i < node->nr_items)
+        return merge_children(node, i);
+    return merge_children(node, i - 1);
+}
+
+void *pcutils_btree_erase(pcutils_btree *tree, const void *item)
+{
+    struct pcutils_btree_node *node = tree->root;
+    const void *key = item;
+    void *removed = NULL;
+
+    while (node) {
+        bool found;
+        unsigned int i = search_node(node, key, tree->cmp, tree->ctxt,
+                false, &found);
+
+        if (node->leaf) {
+            if (found) {
+                if (removed == NULL)
+                    removed = node->items[i];
+                memmove(node->items + i, node->items + i + 1,
+                        sizeof(void *) * (node->nr_items - i - 1));
+                node->nr_items--;
+                tree->nr_items--;
+            }
+            else {
+                assert(removed == NULL);
+            }
+            break;
+        }
+
+        if (found) {
+            struct pcutils_btree_node *left = node->children[i];
+            struct pcutils_btree_node *right = node->children[i + 1];
+
+            if (left->nr_items > MIN_ITEMS) {
+                /* replace it by the predecessor, then erase that one */
+                struct pcutils_btree_node *p = left;
+                while (!p->leaf)
+                    p = p->children[p->nr_items];
+
+                if (removed == NULL)
+                    removed = node->items[i];
+                node->items[i] = p->items[p->nr_items - 1];
+                key = node->items[i];
+                node = left;
+            }
+            else if (right->nr_items > MIN_ITEMS) {
+                struct pcutils_btree_node *p = right;
+                while (!p->leaf)
+                    p = p->children[0];
+
+                if (removed == NULL)
+                    removed = node->items[i];
+                node->items[i] = p->items[0];
+                key = node->items[i];
+                node = right;
+            }
+            else {
+                node = merge_children(node, i);
+            }
+        }
+        else {
+            struct pcutils_btree_node *child = node->children[i];
+            if (child->nr_items == MIN_ITEMS)
+                child = fill_child(node, i);
+            node = child;
+        }
+    }
+
+    struct pcutils_btree_node *root = tree->root;
+    if (root && root->nr_items == 0) {
+        tree->root = root->leaf ? NULL : root->children[0];
+        tree->height--;
+        free(root);
+    }
+
+    return removed;
+}
+
+void *pcutils_btree_find(const pcutils_btree *tree, const void *key,
+        pcutils_btree_cmp_f cmp)
+{
+    struct pcutils_btree_node *node = tree->root;
+    if (cmp == NULL)
+        cmp = tree->cmp;
+
+    while (node) {
+        bool found;
+        unsigned int i = search_node(node, key, cmp, tree->ctxt,
+                false, &found);
+        if (found)
+            return node->items[i];
+
+        node = node->leaf ? NULL : node->children[i];
+    }
+
+    return NULL;
+}
+
+/* goes up from the end of the current node to the next item */
+static void *iter_up(pcutils_btree_iter *it)
+{
+    while (it->depth > 0) {
+        struct pcutils_btree_node *node = it->nodes[it->depth - 1];
+        if (it->pos[it->depth - 1] < node->nr_items)
+            return node->items[it->pos[it->depth - 1]];
+        it->depth--;
+    }
+
+    return NULL;
+}
+
+/* goes down to the leftmost leaf of @node */
+static void *iter_down(pcutils_btree_iter *it, struct pcutils_btree_node *node)
+{
+    for (;;) {
+        assert(it->depth < PCUTILS_BTREE_MAX_HEIGHT);
+        it->nodes[it->depth] = node;
+        it->pos[it->depth] = 0;
+        it->depth++;
+        if (node->leaf)
+            break;
+        node = node->children[0];
+    }
+
+    return iter_up(it);
+}
+
+void *pcutils_btree_first(const pcutils_btree *tree, pcutils_btree_iter *it)
+{
+    it->depth = 0;
+    if (tree->root == NULL)
+        return NULL;
+    return iter_down(it, tree->root);
+}
+
+void *pcutils_btree_seek(const pcutils_btree *tree, pcutils_btree_iter *it,
+        const void *key, pcutils_btree_cmp_f cmp, bool after_equal)
+{
+    struct pcutils_btree_node *node = tree->root;
+    if (cmp == NULL)
+        cmp = tree->cmp;
+
+    /* the position kept for an internal node is the child descended into,
+       which is also the item after that child */
+    it->depth = 0;
+    while (node) {
+        bool found;
+        unsigned int i = search_node(node, key, cmp, tree->ctxt,
+                after_equal, &found);
+
+        assert(it->depth < PCUTILS_BTREE_MAX_HEIGHT);
+        it->nodes[it->depth] = node;
+        it->pos[it->depth] = (unsigned short)i;
+        it->depth++;
+        node = node->leaf ? NULL : node->children[i];
+    }
+
+    return iter_up(it);
+}
+
+void *pcutils_btree_next(pcutils_btree_iter *it)
+{
+    if (it->depth == 0)
+        return NULL;
+
+    struct pcutils_btree_node *node = it->nodes[it->depth - 1];
+    unsigned short pos = ++it->pos[it->depth - 1];
+    if (!node->leaf)
+        return iter_down(it, node->children[pos]);
+    return iter_up(it);
+}
@@ -28,6 +28,10 @@
 #include "private/utils.h"
 #include "private/debug.h"
 
+#if USE(PTHREADS)
+#include <pthread.h>
+#endif
+
 /*
 
 // program to generate the crc32_table.
@@ -471,6 +475,71 @@ static const uint32_t crc32_table_000000af[] =
   0x00006494, 0x0000643b, 0x000065ca, 0x00006565
 };
 
+/*
+ * Slicing-by-8: the table of the n-th slice gives the CRC of a byte followed
+ * by n zero bytes, so eight bytes are folded into the CRC by eight lookups
+ * which do not depend on each other, instead of eight dependent ones.
+ * The slices are derived once from the static tables.
+ */
+#define NR_SLICES               8
+#define MIN_SLICING_LENGTH      16
+
+static const struct crc32_static_table {
+    const uint32_t *table;
+    bool            reflected;
+} static_tables[] = {
+    { crc32_table_04c11db7_reflected,   true },
+    { crc32_table_04c11db7,             false },
+    { crc32_table_1edc6f41_reflected,   true },
+    { crc32_table_a833982b_reflected,   true },
+    { crc32_table_814141ab,             false },
+    { crc32_table_000000af,             false },
+};
+
+/* the first slice of every entry is a copy of the static table */
+static uint32_t crc32_slices[PCA_TABLESIZE(static_tables)][NR_SLICES][256];
+
+static void init_slices(void)
+{
+    for (size_t t = 0; t < PCA_TABLESIZE(static_tables); t++) {
+        const uint32_t *table = static_tables[t].table;
+        uint32_t (*slices)[256] = crc32_slices[t];
+
+        memcpy(slices[0], table, sizeof(slices[0]));
+        for (int i = 0; i < 256; i++) {
+            uint32_t c = table[i];
+            for (int k = 1; k < NR_SLICES; k++) {
+                if (static_tables[t].reflected)
+                    c = (c >> 8) ^ table[c & 0xFF];
+                else
+                    c = (c << 8) ^ table[c >> 24];
+                slices[k][i] = c;
+            }
+        }
+    }
+}
+
+static const uint32_t (*get_slices(const uint32_t *table))[256]
+{
+#if USE(PTHREADS)
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    pthread_once(&once, init_slices);
+#else
+    static bool inited = false;
+    if (!inited) {
+        init_slices();
+        inited = true;
+    }
+#endif
+
+    for (size_t t = 0; t < PCA_TABLESIZE(static_tables); t++) {
+        if (static_tables[t].table == table)
+            return (const uint32_t (*)[256])crc32_slices[t];
+    }
+
+    return NULL;
+}
+
 /* For the parameters of different CRC32 algorithms, see
    <https://crccalc.com/> */
 void pcutils_crc32_begin(pcutils_crc32_ctxt *ctxt, purc_crc32_algo_t algo)
@@ -566,6 +635,52 @@ void pcutils_crc32_begin(pcutils_crc32_ctxt *ctxt, purc_crc32_algo_t algo)
     }
 
     ctxt->crc32 = ctxt->init;
+    ctxt->slices = get_slices(ctxt->table_static);
+}
+
+static inline uint32_t
+load_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+        ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint32_t
+load_be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+        ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static const uint8_t *
+update_by_slices(pcutils_crc32_ctxt *ctxt, const uint8_t *buf, size_t *n)
+{
+    const uint32_t (*t)[256] = ctxt->slices;
+    uint32_t crc = ctxt->crc32;
+
+    if (ctxt->refout) {
+        for (; *n >= NR_SLICES; *n -= NR_SLICES, buf += NR_SLICES) {
+            uint32_t lo = crc ^ load_le32(buf);
+            uint32_t hi = load_le32(buf + 4);
+            crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^
+                t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+                t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^
+                t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+        }
+    }
+    else {
+        for (; *n >= NR_SLICES; *n -= NR_SLICES, buf += NR_SLICES) {
+            uint32_t hi = crc ^ load_be32(buf);
+            uint32_t lo = load_be32(buf + 4);
+            crc = t[7][hi >> 24] ^ t[6][(hi >> 16) & 0xFF] ^
+                t[5][(hi >> 8) & 0xFF] ^ t[4][hi & 0xFF] ^
+                t[3][lo >> 24] ^ t[2][(lo >> 16) & 0xFF] ^
+                t[1][(lo >> 8) & 0xFF] ^ t[0][lo & 0xFF];
+        }
+    }
+
+    ctxt->crc32 = crc;
+    return buf;
 }
 
 void pcutils_crc32_update(pcutils_crc32_ctxt *ctxt,
@@ -573,6 +688,9 @@ void pcutils_crc32_update(pcutils_crc32_ctxt *ctxt,
 {
     const uint8_t *buf = data;
 
+    if (ctxt->slices && n >= MIN_SLICING_LENGTH)
+        buf = update_by_slices(ctxt, buf, &n);
+
     while (n--) {
         uint8_t ch;
         ch = *buf;
@@ -678,6 +796,7 @@ pcutils_crc32_begin_custom(uint32_t poly, uint32_t init, uint32_t xorout,
         ctxt->xorout = xorout;
         ctxt->refin = true;
         ctxt->refout = refout;
+        ctxt->slices = NULL;
         if (refin) {
             calc_crc32_table(ctxt->table_alloc, poly, refin);
         }
@@ -0,0 +1,257 @@
+/*
+ * @file dlmodule.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The loader of the shared libraries of extensions.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "purc-errors.h"
+#include "purc-version.h"
+
+#include "private/debug.h"
+#include "private/dlmodule.h"
+#include "private/errors.h"
+#include "private/list.h"
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if OS(LINUX) || OS(UNIX) || OS(MAC_OS_X)
+#include <dlfcn.h>
+
+/* a library found, keyed by the value of the environment variable then */
+struct found_path {
+    struct list_head    node;
+    char               *env;
+    char               *file;
+    char               *path;
+};
+
+static pthread_mutex_t paths_lock = PTHREAD_MUTEX_INITIALIZER;
+static LIST_HEAD(found_paths);
+static bool cleanup_registered;
+
+static void free_found(struct found_path *p)
+{
+    list_del(&p->node);
+    free(p->env);
+    free(p->file);
+    free(p->path);
+    free(p);
+}
+
+static void forget_all(void)
+{
+    pthread_mutex_lock(&paths_lock);
+    struct found_path *p, *n;
+    list_for_each_entry_safe(p, n, &found_paths, node) {
+        free_found(p);
+    }
+    pthread_mutex_unlock(&paths_lock);
+}
+
+/* called with the lock held */
+static struct found_path *find_found(const char *env, const char *file)
+{
+    struct found_path *p;
+    list_for_each_entry(p, &found_paths, node) {
+        if (strcmp(p->file, file) == 0 && strcmp(p->env, env) == 0)
+            return p;
+    }
+    return NULL;
+}
+
+/* returns a copy of the path found for @file, or NULL */
+static char *recall_path(const char *env, const char *file)
+{
+    char *path = NULL;
+
+    pthread_mutex_lock(&paths_lock);
+    struct found_path *p = find_found(env, file);
+    if (p)
+        path = strdup(p->path);
+    pthread_mutex_unlock(&paths_lock);
+
+    return path;
+}
+
+static void forget_path(const char *env, const char *file)
+{
+    pthread_mutex_lock(&paths_lock);
+    struct found_path *p = find_found(env, file);
+    if (p)
+        free_found(p);
+    pthread_mutex_unlock(&paths_lock);
+}
+
+/* the library is still loaded if the path can not be remembered */
+static void remember_path(const char *env, const char *file, const char *path)
+{
+    struct found_path *p = calloc(1, sizeof(*p));
+    if (p == NULL)
+        return;
+
+    p->env = strdup(env);
+    p->file = strdup(file);
+    p->path = strdup(path);
+    if (!p->env || !p->file || !p->path) {
+        free(p->env);
+        free(p->file);
+        free(p->path);
+        free(p);
+        return;
+    }
+
+    pthread_mutex_lock(&paths_lock);
+    if (find_found(env, file)) {
+        /* found by another thread meanwhile */
+        free(p->env);
+        free(p->file);
+        free(p->path);
+        free(p);
+    }
+    else {
+        list_add(&p->node, &found_paths);
+        if (!cleanup_registered)
+            cleanup_registered = (atexit(forget_all) == 0);
+    }
+    pthread_mutex_unlock(&paths_lock);
+}
+
+static void *try_open(const char *so)
+{
+    void *handle = dlopen(so, RTLD_LAZY);
+    if (handle) {
+        PC_DEBUGX("Loaded from %s\n", so);
+    }
+    return handle;
+}
+
+/* searches @file in the directories; @so holds the path when found */
+static void *search_library(const char *env, const char *file,
+        char *so, size_t sz)
+{
+    void *handle = NULL;
+    int n;
+
+    if (env) {
+        char *path = strdup(env);
+        char *str1;
+        char *saveptr1;
+        char *dir;
+
+        for (str1 = path; path; str1 = NULL) {
+            dir = strtok_r(str1, ":;", &saveptr1);
+            if (dir == NULL || dir[0] != '/') {
+                break;
+            }
+
+            n = snprintf(so, sz, "%s/%s", dir, file);
+            if (n > 0 && (size_t)n < sz && (handle = try_open(so)))
+                break;
+        }
+
+        free(path);
+
+        if (handle)
+            return handle;
+    }
+
+    static const char *ver = PURC_API_VERSION_STRING;
+
+    // try in system directories.
+    static const char *other_tries[] = {
+        "/usr/local/lib/purc-%s/%s",
+        "/usr/lib/purc-%s/%s",
+        "/lib/purc-%s/%s",
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(other_tries); i++) {
+        n = snprintf(so, sz, other_tries[i], ver, file);
+        if (n > 0 && (size_t)n < sz && (handle = try_open(so)))
+            break;
+    }
+
+    return handle;
+}
+
+void *pcutils_dlmodule_open(const char *env_name, const char *prefix,
+        const char *module)
+{
+    const char *ext = ".so";
+#if OS(MAC_OS_X)
+    ext = ".dylib";
+#endif
+
+    char file[PATH_MAX + 1];
+    int n = snprintf(file, sizeof(file), "%s%s%s",
+            prefix ? prefix : "", module, ext);
+    if (n < 0 || (size_t)n >= sizeof(file)) {
+        purc_set_error_with_info(PURC_ERROR_BAD_SYSTEM_CALL,
+                "name too long: %s", module);
+        return NULL;
+    }
+
+    const char *env = env_name ? getenv(env_name) : NULL;
+    const char *env_key = env ? env : "";
+
+    void *handle = NULL;
+    char *path = recall_path(env_key, file);
+    if (path) {
+        handle = dlopen(path, RTLD_LAZY);
+        free(path);
+        if (handle)
+            return handle;
+
+        /* removed after found */
+        forget_path(env_key, file);
+    }
+
+    char so[PATH_MAX + 1];
+    handle = search_library(env, file, so, sizeof(so));
+    if (handle == NULL) {
+        purc_set_error_with_info(PURC_ERROR_BAD_SYSTEM_CALL,
+                "failed to load: %s", file);
+        return NULL;
+    }
+
+    remember_path(env_key, file, so);
+    return handle;
+}
+
+#else   /* OS(LINUX) || OS(UNIX) || OS(MAC_OS_X) */
+
+void *pcutils_dlmodule_open(const char *env_name, const char *prefix,
+        const char *module)
+{
+    UNUSED_PARAM(env_name);
+    UNUSED_PARAM(prefix);
+    UNUSED_PARAM(module);
+
+    // TODO: Add codes for other OS.
+    purc_set_error(PURC_ERROR_NOT_SUPPORTED);
+    return NULL;
+}
+
+#endif  /* !(OS(LINUX) || OS(UNIX) || OS(MAC_OS_X)) */
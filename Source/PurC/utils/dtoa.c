@@ -0,0 +1,544 @@
+/*
+ * @file dtoa.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The fast formatting of integers and doubles, and the fast parsing
+ *  of double.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "purc-utils.h"
+#include "private/utils.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * pcutils_dtoa() finds the shortest decimal digits which are read back as
+ * the same double by the algorithm Ryu of Ulf Adams (PLDI 2018), and lays
+ * them out like "%.17g" does. Without the 128-bit integers, it tries the
+ * precisions of snprintf() from 15 to 17 instead, which gives the shortest
+ * digits too but for the subnormal numbers.
+ */
+
+#define DTOA_PRECISION  17
+
+/* the default precision of "%g" */
+#define GTOA_PRECISION  6
+
+/* the integers are formatted two digits at a time by this table */
+static const char digit_pairs[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+size_t
+pcutils_u64toa(uint64_t u, char *buf)
+{
+    char tmp[20];
+    char *p = tmp + sizeof(tmp);
+
+    while (u >= 100) {
+        p -= 2;
+        memcpy(p, digit_pairs + (u % 100) * 2, 2);
+        u /= 100;
+    }
+
+    if (u >= 10) {
+        p -= 2;
+        memcpy(p, digit_pairs + u * 2, 2);
+    }
+    else {
+        *--p = '0' + (char)u;
+    }
+
+    size_t n = tmp + sizeof(tmp) - p;
+    memcpy(buf, p, n);
+    buf[n] = 0;
+    return n;
+}
+
+size_t
+pcutils_i64toa(int64_t i, char *buf)
+{
+    if (i < 0) {
+        *buf = '-';
+        return pcutils_u64toa(-(uint64_t)i, buf + 1) + 1;
+    }
+
+    return pcutils_u64toa((uint64_t)i, buf);
+}
+
+#ifdef __SIZEOF_INT128__
+
+#include "dtoa-tables.h"
+
+#define DOUBLE_MANTISSA_BITS    52
+#define DOUBLE_EXPONENT_BITS    11
+#define DOUBLE_BIAS             1023
+
+typedef __uint128_t uint128_t;
+
+/* ceil(log2(5^e)) for 0 <= e <= 3528 */
+static inline int32_t pow5bits(int32_t e)
+{
+    return (int32_t)(((uint32_t)e * 1217359) >> 19) + 1;
+}
+
+/* floor(log10(2^e)) for 0 <= e <= 1650 */
+static inline uint32_t log10_pow2(int32_t e)
+{
+    return ((uint32_t)e * 78913) >> 18;
+}
+
+/* floor(log10(5^e)) for 0 <= e <= 2620 */
+static inline uint32_t log10_pow5(int32_t e)
+{
+    return ((uint32_t)e * 732923) >> 20;
+}
+
+static inline uint32_t pow5_factor(uint64_t value)
+{
+    uint32_t count = 0;
+    while (value % 5 == 0) {
+        value /= 5;
+        count++;
+    }
+    return count;
+}
+
+static inline bool multiple_of_pow5(uint64_t value, uint32_t p)
+{
+    return pow5_factor(value) >= p;
+}
+
+static inline bool multiple_of_pow2(uint64_t value, uint32_t p)
+{
+    return (value & ((1ULL << p) - 1)) == 0;
+}
+
+static inline uint64_t mul_shift(uint64_t m, const uint64_t *mul, int32_t j)
+{
+    uint128_t b0 = (uint128_t)m * mul[0];
+    uint128_t b2 = (uint128_t)m * mul[1];
+    return (uint64_t)(((b0 >> 64) + b2) >> (j - 64));
+}
+
+/* Gives the shortest digits in @digits, and returns the decimal exponent
+   of the last digit. @m and @e are the fields of a finite non-zero double. */
+static int32_t
+shortest_digits(uint64_t m, uint32_t e, uint64_t *digits)
+{
+    int32_t e2;
+    uint64_t m2;
+    if (e == 0) {
+        e2 = 1 - DOUBLE_BIAS - DOUBLE_MANTISSA_BITS - 2;
+        m2 = m;
+    }
+    else {
+        e2 = (int32_t)e - DOUBLE_BIAS - DOUBLE_MANTISSA_BITS - 2;
+        m2 = (1ULL << DOUBLE_MANTISSA_BITS) | m;
+    }
+    const bool accept_bounds = (m2 & 1) == 0;
+
+    /* the value and the halfway points to the neighbours, times 4 */
+    const uint64_t mv = 4 * m2;
+    const uint32_t mm_shift = m != 0 || e <= 1;
+
+    uint64_t vr, vp, vm;
+    int32_t e10;
+    bool vm_trailing_zeros = false;
+    bool vr_trailing_zeros = false;
+
+    if (e2 >= 0) {
+        const uint32_t q = log10_pow2(e2) - (e2 > 3);
+        const int32_t k = POW5_INV_BITCOUNT + pow5bits((int32_t)q) - 1;
+        const int32_t i = -e2 + (int32_t)q + k;
+        e10 = (int32_t)q;
+        vr = mul_shift(4 * m2, POW5_INV_SPLIT[q], i);
+        vp = mul_shift(4 * m2 + 2, POW5_INV_SPLIT[q], i);
+        vm = mul_shift(4 * m2 - 1 - mm_shift, POW5_INV_SPLIT[q], i);
+        if (q <= 21) {
+            /* only one of mp, mv, and mm can be a multiple of 5, if any */
+            if (mv % 5 == 0)
+                vr_trailing_zeros = multiple_of_pow5(mv, q);
+            else if (accept_bounds)
+                vm_trailing_zeros = multiple_of_pow5(mv - 1 - mm_shift, q);
+            else
+                vp -= multiple_of_pow5(mv + 2, q);
+        }
+    }
+    else {
+        const uint32_t q = log10_pow5(-e2) - (-e2 > 1);
+        const int32_t i = -e2 - (int32_t)q;
+        const int32_t k = pow5bits(i) - POW5_BITCOUNT;
+        const int32_t j = (int32_t)q - k;
+        e10 = (int32_t)q + e2;
+        vr = mul_shift(4 * m2, POW5_SPLIT[i], j);
+        vp = mul_shift(4 * m2 + 2, POW5_SPLIT[i], j);
+        vm = mul_shift(4 * m2 - 1 - mm_shift, POW5_SPLIT[i], j);
+        if (q <= 1) {
+            /* mv has at least q trailing zero bits */
+            vr_trailing_zeros = true;
+            if (accept_bounds)
+                vm_trailing_zeros = mm_shift == 1;
+            else
+                vp--;
+        }
+        else if (q < 63) {
+            vr_trailing_zeros = multiple_of_pow2(mv, q);
+        }
+    }
+
+    int32_t removed = 0;
+    uint32_t last_removed = 0;
+    uint64_t output;
+    if (vm_trailing_zeros || vr_trailing_zeros) {
+        /* the rare case: the exact halfway may matter */
+        while (vp / 10 > vm / 10) {
+            vm_trailing_zeros &= vm % 10 == 0;
+            vr_trailing_zeros &= last_removed == 0;
+            last_removed = (uint32_t)(vr % 10);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        if (vm_trailing_zeros) {
+            while (vm % 10 == 0) {
+                vr_trailing_zeros &= last_removed == 0;
+                last_removed = (uint32_t)(vr % 10);
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                removed++;
+            }
+        }
+        if (vr_trailing_zeros && last_removed == 5 && vr % 2 == 0) {
+            /* round to even */
+            last_removed = 4;
+        }
+        output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros)) ||
+                last_removed >= 5);
+    }
+    else {
+        bool round_up = false;
+        if (vp / 100 > vm / 100) {
+            round_up = vr % 100 >= 50;
+            vr /= 100;
+            vp /= 100;
+            vm /= 100;
+            removed += 2;
+        }
+        while (vp / 10 > vm / 10) {
+            round_up = vr % 10 >= 5;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        output = vr + (vr == vm || round_up);
+    }
+
+    *digits = output;
+    return e10 + removed;
+}
+
+/* writes the digits of @d to @buf; returns the number of them */
+static int
+decimal_digits(double d, char *buf, int32_t *exp10)
+{
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+
+    uint64_t m = bits & ((1ULL << DOUBLE_MANTISSA_BITS) - 1);
+    uint32_t e = (uint32_t)(bits >> DOUBLE_MANTISSA_BITS) &
+        ((1U << DOUBLE_EXPONENT_BITS) - 1);
+
+    uint64_t digits;
+    *exp10 = shortest_digits(m, e, &digits);
+    return (int)pcutils_u64toa(digits, buf);
+}
+
+#else   /* not defined __SIZEOF_INT128__ */
+
+static int
+decimal_digits(double d, char *buf, int32_t *exp10)
+{
+    char tmp[32];
+    int n = 0;
+
+    for (int prec = 15; prec <= DTOA_PRECISION; prec++) {
+        snprintf(tmp, sizeof(tmp), "%.*e", prec - 1, d);
+        if (prec == DTOA_PRECISION || strtod(tmp, NULL) == d)
+            break;
+    }
+
+    /* tmp is like `d.ddde-XX` */
+    char *p = tmp;
+    buf[n++] = *p++;
+    if (*p == '.' || *p == ',') {
+        for (p++; purc_isdigit(*p); p++)
+            buf[n++] = *p;
+    }
+    while (n > 1 && buf[n - 1] == '0')
+        n--;
+
+    *exp10 = atoi(p + 1) - (n - 1);
+    return n;
+}
+
+#endif  /* not defined __SIZEOF_INT128__ */
+
+/* lays the `n` digits with the exponent `exp10` out like "%.*g" does with
+   the precision; returns the end */
+static char *
+layout_digits(char *p, const char *digits, int n, int32_t exp10,
+        int32_t precision)
+{
+    /* the exponent in the scientific notation */
+    int32_t x = exp10 + n - 1;
+    if (x < -4 || x >= precision) {
+        *p++ = digits[0];
+        if (n > 1) {
+            *p++ = '.';
+            memcpy(p, digits + 1, n - 1);
+            p += n - 1;
+        }
+
+        *p++ = 'e';
+        if (x < 0) {
+            *p++ = '-';
+            x = -x;
+        }
+        else {
+            *p++ = '+';
+        }
+
+        if (x >= 100) {
+            *p++ = '0' + x / 100;
+            x %= 100;
+        }
+        *p++ = '0' + x / 10;
+        *p++ = '0' + x % 10;
+    }
+    else if (x < 0) {
+        *p++ = '0';
+        *p++ = '.';
+        for (int32_t i = -1; i > x; i--)
+            *p++ = '0';
+        memcpy(p, digits, n);
+        p += n;
+    }
+    else if (x + 1 >= n) {
+        memcpy(p, digits, n);
+        p += n;
+        for (int32_t i = n; i <= x; i++)
+            *p++ = '0';
+    }
+    else {
+        memcpy(p, digits, x + 1);
+        p += x + 1;
+        *p++ = '.';
+        memcpy(p, digits + x + 1, n - x - 1);
+        p += n - x - 1;
+    }
+
+    return p;
+}
+
+size_t
+pcutils_dtoa(double d, char *buf)
+{
+    char *p = buf;
+
+    if (signbit(d)) {
+        *p++ = '-';
+        d = -d;
+    }
+
+    if (isnan(d) || isinf(d)) {
+        strcpy(p, isnan(d) ? "nan" : "inf");
+        return p - buf + 3;
+    }
+
+    if (d == 0) {
+        *p++ = '0';
+        *p = 0;
+        return p - buf;
+    }
+
+    char digits[24];
+    int32_t exp10;
+    int n = decimal_digits(d, digits, &exp10);
+
+    p = layout_digits(p, digits, n, exp10, DTOA_PRECISION);
+    *p = 0;
+    return p - buf;
+}
+
+/*
+ * When the shortest digits of a normal double are not more than the
+ * precision of "%g", they are what "%g" gives: the double is within half an
+ * ULP of them, which is far less than half a unit of the sixth digit. Others
+ * (including the subnormal numbers) are left to snprintf().
+ */
+size_t
+pcutils_gtoa(double d, char *buf)
+{
+    if (d == 0 || isnan(d) || isinf(d))
+        return pcutils_dtoa(d, buf);
+
+#ifdef __SIZEOF_INT128__
+    char digits[24];
+    int32_t exp10;
+    int n = 0;
+    if (fabs(d) >= DBL_MIN)
+        n = decimal_digits(fabs(d), digits, &exp10);
+
+    if (n > 0 && n <= GTOA_PRECISION) {
+        char *p = buf;
+        if (signbit(d))
+            *p++ = '-';
+
+        p = layout_digits(p, digits, n, exp10, GTOA_PRECISION);
+        *p = 0;
+        return p - buf;
+    }
+#endif
+
+    return snprintf(buf, PCUTILS_DTOA_BUFSZ, "%g", d);
+}
+
+/*
+ * pcutils_strtod() converts a decimal number having not more than 19
+ * significant digits and 2^53 as the value of them, and a power of 10 not
+ * beyond 10^22, by one multiplication or division, which is correctly
+ * rounded since both operands are exact (Clinger, PLDI 1990). Others are
+ * left to strtod().
+ */
+
+#define MAX_FAST_DIGITS     19
+#define MAX_FAST_POW10      22
+#define MAX_FAST_MANTISSA   (1ULL << 53)
+
+double
+pcutils_strtod(const char *str, char **end)
+{
+#if FLT_EVAL_METHOD == 0
+    static const double pow10[MAX_FAST_POW10 + 1] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10,
+        1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21,
+        1e22,
+    };
+
+    const char *p = str;
+    bool negative = false;
+    if (*p == '-') {
+        negative = true;
+        p++;
+    }
+    else if (*p == '+') {
+        p++;
+    }
+
+    uint64_t w = 0;
+    int nr_digits = 0;      /* the significant ones */
+    int nr_int = 0, nr_frac = 0;
+    int exp10 = 0;
+
+    for (; purc_isdigit(*p); p++, nr_int++) {
+        if (w == 0 && *p == '0')
+            continue;
+        if (++nr_digits > MAX_FAST_DIGITS)
+            goto slow;
+        w = w * 10 + (*p - '0');
+    }
+
+    if (*p == '.') {
+        for (p++; purc_isdigit(*p); p++, nr_frac++) {
+            exp10--;
+            if (w == 0 && *p == '0')
+                continue;
+            if (++nr_digits > MAX_FAST_DIGITS)
+                goto slow;
+            w = w * 10 + (*p - '0');
+        }
+    }
+
+    /* not a decimal number, or a hexadecimal one */
+    if ((nr_int == 0 && nr_frac == 0) || *p == 'x' || *p == 'X')
+        goto slow;
+
+    if (*p == 'e' || *p == 'E') {
+        const char *q = p + 1;
+        bool negative_exp = false;
+        if (*q == '-') {
+            negative_exp = true;
+            q++;
+        }
+        else if (*q == '+') {
+            q++;
+        }
+
+        if (purc_isdigit(*q)) {
+            int e = 0;
+            for (; purc_isdigit(*q); q++) {
+                if (e < 10000)
+                    e = e * 10 + (*q - '0');
+            }
+            exp10 += negative_exp ? -e : e;
+            p = q;
+        }
+    }
+
+    double d;
+    if (w == 0) {
+        d = 0;
+    }
+    else if (w <= MAX_FAST_MANTISSA &&
+            exp10 >= -MAX_FAST_POW10 && exp10 <= MAX_FAST_POW10) {
+        d = (double)w;
+        if (exp10 < 0)
+            d /= pow10[-exp10];
+        else
+            d *= pow10[exp10];
+    }
+    else {
+        goto slow;
+    }
+
+    if (end)
+        *end = (char *)p;
+    return negative ? -d : d;
+
+slow:
+#endif  /* FLT_EVAL_METHOD == 0 */
+    return strtod(str, end);
+}
+
@@ -38,6 +38,7 @@
 #undef PCUTILS_HASH_EXTERN
 
 #include "private/str.h"
+#include "private/wyhash.h"
 
 #define PCHTML_STR_RES_MAP_LOWERCASE
 #define PCHTML_STR_RES_MAP_UPPERCASE
@@ -368,61 +369,27 @@ pcutils_hash_search_by_hash_id(pcutils_hash_t *hash, uint32_t hash_id,
     return NULL;
 }
 
+/* the keys are often the names of the tags and attributes, so they are
+   hashed by wyhash, and folded while being read for the caseless ones */
 uint32_t
 pcutils_hash_make_id(const unsigned char *key, size_t length)
 {
-    size_t i;
-    uint32_t hash_id;
-
-    for (i = hash_id = 0; i < length; i++) {
-        hash_id += key[i];
-        hash_id += (hash_id << 10);
-        hash_id ^= (hash_id >> 6);
-    }
-
-    hash_id += (hash_id << 3);
-    hash_id ^= (hash_id >> 11);
-    hash_id += (hash_id << 15);
-
-    return hash_id;
+    return (uint32_t)pcutils_wyhash_ex(key, length, pcutils_hash_seed(),
+            PCUTILS_WYHASH_FOLD_NONE);
 }
 
 uint32_t
 pcutils_hash_make_id_lower(const unsigned char *key, size_t length)
 {
-    size_t i;
-    uint32_t hash_id;
-
-    for (i = hash_id = 0; i < length; i++) {
-        hash_id += pcutils_str_res_map_lowercase[ key[i] ];
-        hash_id += (hash_id << 10);
-        hash_id ^= (hash_id >> 6);
-    }
-
-    hash_id += (hash_id << 3);
-    hash_id ^= (hash_id >> 11);
-    hash_id += (hash_id << 15);
-
-    return hash_id;
+    return (uint32_t)pcutils_wyhash_ex(key, length, pcutils_hash_seed(),
+            PCUTILS_WYHASH_FOLD_LOWER);
 }
 
 uint32_t
 pcutils_hash_make_id_upper(const unsigned char *key, size_t length)
 {
-    size_t i;
-    uint32_t hash_id;
-
-    for (i = hash_id = 0; i < length; i++) {
-        hash_id += pcutils_str_res_map_uppercase[ key[i] ];
-        hash_id += (hash_id << 10);
-        hash_id ^= (hash_id >> 6);
-    }
-
-    hash_id += (hash_id << 3);
-    hash_id ^= (hash_id >> 11);
-    hash_id += (hash_id << 15);
-
-    return hash_id;
+    return (uint32_t)pcutils_wyhash_ex(key, length, pcutils_hash_seed(),
+            PCUTILS_WYHASH_FOLD_UPPER);
 }
 
 unsigned int
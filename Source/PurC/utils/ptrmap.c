@@ -0,0 +1,222 @@
+/*
+ * @file ptrmap.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The implementation of the maps keyed by pointers.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "private/ptrmap.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* the key of a slot removed; the probing goes on over it */
+#define REMOVED_KEY     ((void *)(uintptr_t)1)
+
+#define MIN_SLOTS       16
+
+static inline size_t hash_ptr(const void *key, size_t mask)
+{
+    /* the low bits of the pointers are mostly zeros because of alignment */
+    uint64_t h = (uint64_t)(uintptr_t)key * 0x9E3779B97F4A7C15ULL;
+    return (size_t)(h >> 32) & mask;
+}
+
+void pcutils_ptrmap_init(pcutils_ptrmap *map)
+{
+    memset(map, 0, sizeof(*map));
+}
+
+void pcutils_ptrmap_clear(pcutils_ptrmap *map)
+{
+    if (map->nr_slots)
+        free(map->slots);
+    memset(map, 0, sizeof(*map));
+}
+
+pcutils_ptrmap *pcutils_ptrmap_create(void)
+{
+    return calloc(1, sizeof(pcutils_ptrmap));
+}
+
+void pcutils_ptrmap_destroy(pcutils_ptrmap *map)
+{
+    if (map) {
+        pcutils_ptrmap_clear(map);
+        free(map);
+    }
+}
+
+static struct pcutils_ptrmap_entry *
+lookup_slot(struct pcutils_ptrmap_entry *slots, size_t nr_slots,
+        const void *key)
+{
+    size_t mask = nr_slots - 1;
+    size_t i = hash_ptr(key, mask);
+
+    while (slots[i].key) {
+        if (slots[i].key == key)
+            return slots + i;
+        i = (i + 1) & mask;
+    }
+
+    return NULL;
+}
+
+struct pcutils_ptrmap_entry *
+pcutils_ptrmap_find(pcutils_ptrmap *map, const void *key)
+{
+    assert(key && key != REMOVED_KEY);
+
+    if (map->nr_slots == 0) {
+        for (size_t i = 0; i < map->nr_entries; i++) {
+            if (map->inlined[i].key == key)
+                return map->inlined + i;
+        }
+        return NULL;
+    }
+
+    return lookup_slot(map->slots, map->nr_slots, key);
+}
+
+static void
+insert_slot(struct pcutils_ptrmap_entry *slots, size_t nr_slots,
+        void *key, void *val)
+{
+    size_t mask = nr_slots - 1;
+    size_t i = hash_ptr(key, mask);
+
+    while (slots[i].key)
+        i = (i + 1) & mask;
+
+    slots[i].key = key;
+    slots[i].val = val;
+}
+
+/* rebuilds the hash table for @nr_entries entries, dropping the removed */
+static int rehash(pcutils_ptrmap *map, size_t nr_entries)
+{
+    size_t nr_slots = MIN_SLOTS;
+    while (nr_slots < nr_entries * 2)
+        nr_slots <<= 1;
+
+    struct pcutils_ptrmap_entry *slots = calloc(nr_slots, sizeof(*slots));
+    if (slots == NULL)
+        return -1;
+
+    size_t pos = 0;
+    struct pcutils_ptrmap_entry *entry;
+    while ((entry = pcutils_ptrmap_next(map, &pos)))
+        insert_slot(slots, nr_slots, entry->key, entry->val);
+
+    if (map->nr_slots)
+        free(map->slots);
+
+    map->slots = slots;
+    map->nr_slots = nr_slots;
+    map->nr_used = map->nr_entries;
+    return 0;
+}
+
+int pcutils_ptrmap_set(pcutils_ptrmap *map, const void *key, void *val)
+{
+    struct pcutils_ptrmap_entry *entry = pcutils_ptrmap_find(map, key);
+    if (entry) {
+        entry->val = val;
+        return 0;
+    }
+
+    if (map->nr_slots == 0) {
+        if (map->nr_entries < PCUTILS_PTRMAP_NR_INLINE) {
+            entry = map->inlined + map->nr_entries;
+            entry->key = (void *)key;
+            entry->val = val;
+            map->nr_entries++;
+            return 0;
+        }
+
+        if (rehash(map, map->nr_entries + 1))
+            return -1;
+    }
+    else if ((map->nr_used + 1) * 4 > map->nr_slots * 3) {
+        /* the load factor is kept under 3/4 */
+        if (rehash(map, map->nr_entries + 1))
+            return -1;
+    }
+
+    /* reuse the first removed slot on the probing sequence */
+    size_t mask = map->nr_slots - 1;
+    size_t i = hash_ptr(key, mask);
+    while (map->slots[i].key && map->slots[i].key != REMOVED_KEY)
+        i = (i + 1) & mask;
+
+    if (map->slots[i].key == NULL)
+        map->nr_used++;
+
+    map->slots[i].key = (void *)key;
+    map->slots[i].val = val;
+    map->nr_entries++;
+    return 0;
+}
+
+bool pcutils_ptrmap_erase(pcutils_ptrmap *map, const void *key)
+{
+    struct pcutils_ptrmap_entry *entry = pcutils_ptrmap_find(map, key);
+    if (entry == NULL)
+        return false;
+
+    map->nr_entries--;
+    if (map->nr_slots == 0) {
+        /* keep the inline entries contiguous */
+        struct pcutils_ptrmap_entry *last = map->inlined + map->nr_entries;
+        if (entry != last)
+            *entry = *last;
+        last->key = NULL;
+        last->val = NULL;
+    }
+    else {
+        entry->key = REMOVED_KEY;
+        entry->val = NULL;
+    }
+
+    return true;
+}
+
+struct pcutils_ptrmap_entry *
+pcutils_ptrmap_next(pcutils_ptrmap *map, size_t *pos)
+{
+    if (map->nr_slots == 0) {
+        if (*pos < map->nr_entries)
+            return map->inlined + (*pos)++;
+        return NULL;
+    }
+
+    while (*pos < map->nr_slots) {
+        struct pcutils_ptrmap_entry *entry = map->slots + (*pos)++;
+        if (entry->key && entry->key != REMOVED_KEY)
+            return entry;
+    }
+
+    return NULL;
+}
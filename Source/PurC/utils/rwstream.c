@@ -28,6 +28,7 @@
 #include "purc-utils.h"
 #include "private/errors.h"
 #include "private/instance.h"
+#include "private/list.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -38,6 +39,9 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
 #endif // 0S(UNIX)
 
 #include "rwstream_err_msgs.inc"
@@ -45,6 +49,13 @@
 #define BUFFER_SIZE 4096
 #define MIN_BUFFER_SIZE 32
 
+/* the sizes of the chunks of a rope; they double up to the maximum */
+#define MIN_ROPE_CHUNK  4096
+#define MAX_ROPE_CHUNK  (1024 * 1024)
+
+/* the chunks written to a file descriptor by a call to writev() */
+#define NR_ROPE_IOVS    64
+
 /* Make sure the number of error messages matches the number of error codes */
 #define _COMPILE_TIME_ASSERT(name, x)               \
        typedef int _dummy_ ## name[(x) * 2 - 1]
@@ -68,6 +79,7 @@ static int rwstream_init_once(void)
 }
 
 struct pcmodule _module_rwstream = {
+    .name            = "rwstream",
     .id              = PURC_HAVE_UTILS,
     .module_inited   = 0,
 
@@ -106,6 +118,13 @@ struct mem_rwstream
     uint8_t* stop;
 };
 
+struct rdonly_mem_rwstream
+{
+    struct mem_rwstream mem;
+    pcrws_cb_release release;
+    void *ctxt;
+};
+
 struct buffer_rwstream
 {
     purc_rwstream rwstream;
@@ -119,6 +138,35 @@ struct buffer_rwstream
     bool buff_reserved;
 };
 
+/*
+ * A rope is a list of the chunks which are never moved once allocated, so
+ * a large output is written without copying the written content again,
+ * and it can be gathered into a file descriptor without copying. It is
+ * made contiguous only when the memory buffer is requested.
+ */
+struct rope_chunk
+{
+    struct list_head ln;
+    uint8_t* data;          // with the room for a terminating null byte
+    size_t sz;
+    size_t used;
+};
+
+struct rope_rwstream
+{
+    purc_rwstream rwstream;
+    struct list_head chunks;
+    size_t total;
+    size_t sz_max;
+    size_t sz_next;         // the size of the next chunk
+
+    size_t pos;
+    struct rope_chunk* curr;    // the chunk containing pos, or NULL
+    size_t curr_start;          // the position of the first byte of curr
+
+    bool buff_reserved;
+};
+
 #if OS(LINUX) || OS(UNIX) || OS(MAC_OS_X)
 struct fd_rwstream
 {
@@ -163,6 +211,22 @@ static rwstream_funcs mem_funcs = {
     mem_get_mem_buffer
 };
 
+static ssize_t rdonly_mem_write (purc_rwstream_t rws, const void* buf,
+        size_t count);
+static int rdonly_mem_destroy (purc_rwstream_t rws);
+static void* rdonly_mem_get_mem_buffer (purc_rwstream_t rws,
+        size_t *sz_content, size_t *sz_buffer, bool res_buff);
+
+static rwstream_funcs rdonly_mem_funcs = {
+    mem_seek,
+    mem_tell,
+    mem_read,
+    rdonly_mem_write,
+    mem_flush,
+    rdonly_mem_destroy,
+    rdonly_mem_get_mem_buffer
+};
+
 static off_t buffer_seek (purc_rwstream_t rws, off_t offset, int whence);
 static off_t buffer_tell (purc_rwstream_t rws);
 static ssize_t buffer_read (purc_rwstream_t rws, void* buf, size_t count);
@@ -182,9 +246,40 @@ static rwstream_funcs buffer_funcs = {
     buffer_get_mem_buffer
 };
 
+static off_t rope_seek (purc_rwstream_t rws, off_t offset, int whence);
+static off_t rope_tell (purc_rwstream_t rws);
+static ssize_t rope_read (purc_rwstream_t rws, void* buf, size_t count);
+static ssize_t rope_write (purc_rwstream_t rws, const void* buf, size_t count);
+static int rope_destroy (purc_rwstream_t rws);
+static void* rope_get_mem_buffer (purc_rwstream_t rws,
+        size_t *sz_content, size_t *sz_buffer, bool res_buff);
+
+static rwstream_funcs rope_funcs = {
+    rope_seek,
+    rope_tell,
+    rope_read,
+    rope_write,
+    buffer_flush,
+    rope_destroy,
+    rope_get_mem_buffer
+};
+
 
 #if OS(LINUX) || OS(UNIX) || OS(MAC_OS_X)
 
+static int mmap_destroy (purc_rwstream_t rws);
+
+/* the mapped file is read-only memory which is unmapped on destroy */
+static rwstream_funcs mmap_funcs = {
+    mem_seek,
+    mem_tell,
+    mem_read,
+    rdonly_mem_write,
+    mem_flush,
+    mmap_destroy,
+    rdonly_mem_get_mem_buffer
+};
+
 static off_t fd_seek (purc_rwstream_t rws, off_t offset, int whence);
 static off_t fd_tell (purc_rwstream_t rws);
 static ssize_t fd_read (purc_rwstream_t rws, void* buf, size_t count);
@@ -242,6 +337,30 @@ purc_rwstream_t purc_rwstream_new_buffer (size_t sz_init, size_t sz_max)
     return (purc_rwstream_t)rws;
 }
 
+purc_rwstream_t purc_rwstream_new_rope (size_t sz_chunk, size_t sz_max)
+{
+    struct rope_rwstream* rws = (struct rope_rwstream*) calloc(
+            1, sizeof(struct rope_rwstream));
+    if (rws == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    if (sz_chunk < MIN_ROPE_CHUNK) {
+        sz_chunk = MIN_ROPE_CHUNK;
+    }
+    else if (sz_chunk > MAX_ROPE_CHUNK) {
+        sz_chunk = MAX_ROPE_CHUNK;
+    }
+
+    rws->rwstream.funcs = &rope_funcs;
+    INIT_LIST_HEAD(&rws->chunks);
+    rws->sz_max = sz_max ? sz_max : SIZE_MAX;
+    rws->sz_next = sz_chunk;
+
+    return (purc_rwstream_t)rws;
+}
+
 purc_rwstream_t purc_rwstream_new_from_mem (void* mem, size_t sz)
 {
     struct mem_rwstream* rws = (struct mem_rwstream*) calloc(
@@ -255,6 +374,31 @@ purc_rwstream_t purc_rwstream_new_from_mem (void* mem, size_t sz)
     return (purc_rwstream_t)rws;
 }
 
+purc_rwstream_t purc_rwstream_new_from_mem_ex (const void* mem, size_t sz,
+        pcrws_cb_release release, void *ctxt)
+{
+    if (mem == NULL && sz > 0) {
+        pcinst_set_error(PURC_ERROR_INVALID_VALUE);
+        return NULL;
+    }
+
+    struct rdonly_mem_rwstream* rws = (struct rdonly_mem_rwstream*) calloc(
+            1, sizeof(struct rdonly_mem_rwstream));
+    if (rws == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    rws->mem.rwstream.funcs = &rdonly_mem_funcs;
+    rws->mem.base = (uint8_t*)mem;
+    rws->mem.here = rws->mem.base;
+    rws->mem.stop = rws->mem.base + sz;
+    rws->release = release;
+    rws->ctxt = ctxt;
+
+    return (purc_rwstream_t)rws;
+}
+
 purc_rwstream_t purc_rwstream_new_from_file (const char* file, const char* mode)
 {
     FILE* fp = fopen(file, mode);
@@ -266,6 +410,61 @@ purc_rwstream_t purc_rwstream_new_from_file (const char* file, const char* mode)
     return purc_rwstream_new_from_fp(fp);
 }
 
+purc_rwstream_t purc_rwstream_new_from_mmap (const char* file)
+{
+#if OS(LINUX) || OS(UNIX) || OS(MAC_OS_X)
+    int fd = open(file, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        pcinst_set_error(PURC_ERROR_BAD_SYSTEM_CALL);
+        return NULL;
+    }
+
+    struct mem_rwstream* rws = NULL;
+    struct stat statbuf;
+    if (fstat(fd, &statbuf)) {
+        pcinst_set_error(PURC_ERROR_BAD_SYSTEM_CALL);
+        goto done;
+    }
+
+    /* a pipe or a device can not be mapped as a whole */
+    if (!S_ISREG(statbuf.st_mode)) {
+        pcinst_set_error(PURC_ERROR_NOT_SUPPORTED);
+        goto done;
+    }
+
+    rws = (struct mem_rwstream*) calloc(1, sizeof(struct mem_rwstream));
+    if (rws == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto done;
+    }
+
+    /* an empty file can not be mapped, but its stream is empty memory */
+    uint8_t *base = NULL;
+    if (statbuf.st_size > 0) {
+        base = mmap(NULL, statbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (base == MAP_FAILED) {
+            pcinst_set_error(PURC_ERROR_BAD_SYSTEM_CALL);
+            free(rws);
+            rws = NULL;
+            goto done;
+        }
+    }
+
+    rws->rwstream.funcs = &mmap_funcs;
+    rws->base = base;
+    rws->here = rws->base;
+    rws->stop = rws->base + statbuf.st_size;
+
+done:
+    close(fd);
+    return (purc_rwstream_t)rws;
+#else
+    UNUSED_PARAM(file);
+    pcinst_set_error(PURC_ERROR_NOT_IMPLEMENTED);
+    return NULL;
+#endif
+}
+
 purc_rwstream_t purc_rwstream_new_from_fp (FILE* fp)
 {
     struct stdio_rwstream* rws = (struct stdio_rwstream*) calloc(
@@ -585,9 +784,17 @@ ssize_t purc_rwstream_flush (purc_rwstream_t rws)
     return -1;
 }
 
+static ssize_t rope_dump (struct rope_rwstream* rope, purc_rwstream_t out,
+        ssize_t count);
+
 ssize_t purc_rwstream_dump_to_another (purc_rwstream_t in,
         purc_rwstream_t out, ssize_t count)
 {
+    /* the chunks of a rope are written out directly */
+    if (in && in->funcs == &rope_funcs) {
+        return rope_dump((struct rope_rwstream *)in, out, count);
+    }
+
     char buffer[BUFFER_SIZE] = {0};
     ssize_t ret_count = 0;
     ssize_t write_len = 0;
@@ -635,6 +842,49 @@ ssize_t purc_rwstream_dump_to_another (purc_rwstream_t in,
     return ret_count;
 }
 
+#if OS(LINUX) || OS(UNIX) || OS(MAC_OS_X)
+static ssize_t rope_dump_to_fd (struct rope_rwstream* rope, int fd);
+#endif
+
+ssize_t purc_rwstream_dump_to_fd (purc_rwstream_t in, int fd)
+{
+#if OS(LINUX) || OS(UNIX) || OS(MAC_OS_X)
+    if (in == NULL || fd < 0) {
+        pcinst_set_error(PURC_ERROR_INVALID_VALUE);
+        return -1;
+    }
+
+    if (in->funcs == &rope_funcs) {
+        return rope_dump_to_fd((struct rope_rwstream *)in, fd);
+    }
+
+    char buffer[BUFFER_SIZE];
+    ssize_t ret_count = 0;
+    ssize_t read_len;
+    while ((read_len = purc_rwstream_read(in, buffer, BUFFER_SIZE)) > 0) {
+        ssize_t done = 0;
+        while (done < read_len) {
+            ssize_t n = write(fd, buffer + done, read_len - done);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                purc_set_error(purc_error_from_errno(errno));
+                return -1;
+            }
+            done += n;
+        }
+        ret_count += read_len;
+    }
+
+    return read_len < 0 ? -1 : ret_count;
+#else
+    UNUSED_PARAM(in);
+    UNUSED_PARAM(fd);
+    pcinst_set_error(PURC_ERROR_NOT_IMPLEMENTED);
+    return -1;
+#endif
+}
+
 void* purc_rwstream_get_mem_buffer_ex (purc_rwstream_t rws,
         size_t *sz_content, size_t *sz_buffer, bool res_buff)
 {
@@ -747,8 +997,11 @@ static ssize_t mem_read (purc_rwstream_t rws, void* buf, size_t count)
     {
         count = mem->stop - mem->here;
     }
-    memcpy(buf, mem->here, count);
-    mem->here += count;
+    /* the memory of an empty stream may be NULL */
+    if (count > 0) {
+        memcpy(buf, mem->here, count);
+        mem->here += count;
+    }
     return count;
 }
 
@@ -801,6 +1054,49 @@ static void* mem_get_mem_buffer (purc_rwstream_t rws,
     return mem->base;
 }
 
+/* read-only memory rwstream functions */
+static ssize_t rdonly_mem_write (purc_rwstream_t rws, const void* buf,
+        size_t count)
+{
+    UNUSED_PARAM(rws);
+    UNUSED_PARAM(buf);
+    UNUSED_PARAM(count);
+    pcinst_set_error(PURC_ERROR_NOT_SUPPORTED);
+    return -1;
+}
+
+static int rdonly_mem_destroy (purc_rwstream_t rws)
+{
+    struct rdonly_mem_rwstream* rdonly = (struct rdonly_mem_rwstream *)rws;
+    if (rdonly->release) {
+        rdonly->release(rdonly->ctxt);
+    }
+    free(rws);
+    return 0;
+}
+
+static void* rdonly_mem_get_mem_buffer (purc_rwstream_t rws,
+        size_t *sz_content, size_t *sz_buffer, bool res_buff)
+{
+    struct mem_rwstream* mem = (struct mem_rwstream *)rws;
+
+    /* the memory is not ours; it can not be taken over */
+    if (res_buff) {
+        pcinst_set_error(PURC_ERROR_NOT_SUPPORTED);
+        return NULL;
+    }
+
+    if (sz_content) {
+        *sz_content = mem->stop - mem->base;
+    }
+
+    if (sz_buffer) {
+        *sz_buffer = mem->stop - mem->base;
+    }
+
+    return mem->base;
+}
+
 /* buffer rwstream functions */
 static int buffer_extend (struct buffer_rwstream* buffer, size_t size)
 {
@@ -948,8 +1244,338 @@ static void* buffer_get_mem_buffer (purc_rwstream_t rws,
     return buffer->base;
 }
 
+/* rope rwstream functions */
+static struct rope_chunk* rope_new_chunk (struct rope_rwstream* rope,
+        size_t sz)
+{
+    struct rope_chunk* chunk = (struct rope_chunk*) malloc(sizeof(*chunk));
+    if (chunk == NULL) {
+        return NULL;
+    }
+
+    chunk->data = (uint8_t*) malloc(sz + 1);
+    if (chunk->data == NULL) {
+        free(chunk);
+        return NULL;
+    }
+
+    chunk->sz = sz;
+    chunk->used = 0;
+    list_add_tail(&chunk->ln, &rope->chunks);
+    return chunk;
+}
+
+/* makes curr the chunk containing pos, or the last one if pos is the end */
+static void rope_locate (struct rope_rwstream* rope)
+{
+    struct rope_chunk* chunk = rope->curr;
+    size_t start = rope->curr_start;
+
+    if (chunk == NULL || rope->pos < start) {
+        if (list_empty(&rope->chunks)) {
+            return;
+        }
+        chunk = list_first_entry(&rope->chunks, struct rope_chunk, ln);
+        start = 0;
+    }
+
+    while (start + chunk->used <= rope->pos &&
+            chunk->ln.next != &rope->chunks) {
+        start += chunk->used;
+        chunk = list_entry(chunk->ln.next, struct rope_chunk, ln);
+    }
+
+    rope->curr = chunk;
+    rope->curr_start = start;
+}
+
+static off_t rope_seek (purc_rwstream_t rws, off_t offset, int whence)
+{
+    struct rope_rwstream* rope = (struct rope_rwstream *)rws;
+    off_t newpos;
+
+    switch (whence) {
+        case SEEK_SET:
+            newpos = offset;
+            break;
+        case SEEK_CUR:
+            newpos = rope->pos + offset;
+            break;
+        case SEEK_END:
+            newpos = rope->total + offset;
+            break;
+        default:
+            return(-1);
+    }
+
+    if (newpos < 0) {
+        newpos = 0;
+    }
+    else if ((size_t)newpos > rope->total) {
+        newpos = rope->total;
+    }
+
+    rope->pos = newpos;
+    return newpos;
+}
+
+static off_t rope_tell (purc_rwstream_t rws)
+{
+    return ((struct rope_rwstream *)rws)->pos;
+}
+
+static ssize_t rope_read (purc_rwstream_t rws, void* buf, size_t count)
+{
+    struct rope_rwstream* rope = (struct rope_rwstream *)rws;
+    size_t left = rope->total - rope->pos;
+    if (count > left) {
+        count = left;
+    }
+
+    size_t done = 0;
+    while (done < count) {
+        rope_locate(rope);
+        size_t off = rope->pos - rope->curr_start;
+        size_t n = rope->curr->used - off;
+        if (n > count - done) {
+            n = count - done;
+        }
+
+        memcpy((uint8_t *)buf + done, rope->curr->data + off, n);
+        done += n;
+        rope->pos += n;
+    }
+
+    return done;
+}
+
+static ssize_t rope_write (purc_rwstream_t rws, const void* buf, size_t count)
+{
+    struct rope_rwstream* rope = (struct rope_rwstream *)rws;
+    const uint8_t* p = (const uint8_t *)buf;
+
+    if (count > rope->sz_max - rope->pos) {
+        count = rope->sz_max - rope->pos;
+        if (count == 0) {
+            pcinst_set_error(PCRWSTREAM_ERROR_NO_SPACE);
+            return -1;
+        }
+    }
+
+    size_t done = 0;
+
+    /* overwrite the content after pos */
+    while (done < count && rope->pos < rope->total) {
+        rope_locate(rope);
+        size_t off = rope->pos - rope->curr_start;
+        size_t n = rope->curr->used - off;
+        if (n > count - done) {
+            n = count - done;
+        }
+
+        memcpy(rope->curr->data + off, p + done, n);
+        done += n;
+        rope->pos += n;
+    }
+
+    /* append the rest to the last chunk, then to the new ones */
+    while (done < count) {
+        struct rope_chunk* last = list_empty(&rope->chunks) ? NULL :
+            list_last_entry(&rope->chunks, struct rope_chunk, ln);
+        if (last == NULL || last->used == last->sz) {
+            last = rope_new_chunk(rope, rope->sz_next);
+            if (last == NULL) {
+                pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+                break;
+            }
+
+            if (rope->sz_next < MAX_ROPE_CHUNK) {
+                rope->sz_next *= 2;
+            }
+        }
+
+        size_t n = last->sz - last->used;
+        if (n > count - done) {
+            n = count - done;
+        }
+
+        memcpy(last->data + last->used, p + done, n);
+        last->used += n;
+        done += n;
+        rope->pos += n;
+        rope->total += n;
+    }
+
+    if (done == 0 && count > 0) {
+        return -1;
+    }
+
+    return done;
+}
+
+static void rope_free_chunks (struct rope_rwstream* rope)
+{
+    struct list_head *p, *n;
+    list_for_each_safe(p, n, &rope->chunks) {
+        struct rope_chunk* chunk = list_entry(p, struct rope_chunk, ln);
+        list_del(p);
+        free(chunk->data);
+        free(chunk);
+    }
+
+    rope->curr = NULL;
+    rope->curr_start = 0;
+}
+
+static int rope_destroy (purc_rwstream_t rws)
+{
+    struct rope_rwstream* rope = (struct rope_rwstream *)rws;
+
+    /* the only chunk left after the memory buffer was reserved */
+    if (rope->buff_reserved) {
+        struct rope_chunk* chunk;
+        chunk = list_first_entry(&rope->chunks, struct rope_chunk, ln);
+        chunk->data = NULL;
+    }
+
+    rope_free_chunks(rope);
+    free(rws);
+    return 0;
+}
+
+static void* rope_get_mem_buffer (purc_rwstream_t rws,
+        size_t *sz_content, size_t *sz_buffer, bool res_buff)
+{
+    struct rope_rwstream* rope = (struct rope_rwstream *)rws;
+    struct rope_chunk* chunk = NULL;
+
+    if (!list_empty(&rope->chunks)) {
+        chunk = list_first_entry(&rope->chunks, struct rope_chunk, ln);
+        if (chunk->ln.next != &rope->chunks) {
+            chunk = NULL;
+        }
+    }
+
+    /* make the content contiguous in a new chunk */
+    if (chunk == NULL) {
+        struct rope_chunk* whole;
+        whole = (struct rope_chunk*) malloc(sizeof(*whole));
+        uint8_t* data = (uint8_t*) malloc(rope->total + 1);
+        if (whole == NULL || data == NULL) {
+            free(whole);
+            free(data);
+            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return NULL;
+        }
+
+        size_t len = 0;
+        struct list_head *p;
+        list_for_each(p, &rope->chunks) {
+            struct rope_chunk* part = list_entry(p, struct rope_chunk, ln);
+            memcpy(data + len, part->data, part->used);
+            len += part->used;
+        }
+        rope_free_chunks(rope);
+
+        whole->data = data;
+        whole->sz = rope->total;
+        whole->used = rope->total;
+        list_add_tail(&whole->ln, &rope->chunks);
+        chunk = whole;
+    }
+
+    chunk->data[chunk->used] = 0;
+
+    if (sz_content) {
+        *sz_content = chunk->used;
+    }
+
+    if (sz_buffer) {
+        *sz_buffer = chunk->sz;
+    }
+
+    rope->buff_reserved = res_buff;
+    return chunk->data;
+}
+
+static ssize_t rope_dump (struct rope_rwstream* rope, purc_rwstream_t out,
+        ssize_t count)
+{
+    size_t left = rope->total - rope->pos;
+    if (count >= 0 && (size_t)count < left) {
+        left = count;
+    }
+
+    ssize_t ret_count = 0;
+    while (left > 0) {
+        rope_locate(rope);
+        size_t off = rope->pos - rope->curr_start;
+        size_t n = rope->curr->used - off;
+        if (n > left) {
+            n = left;
+        }
+
+        ssize_t written = purc_rwstream_write(out, rope->curr->data + off, n);
+        if (written != (ssize_t)n) {
+            return -1;
+        }
+
+        rope->pos += n;
+        left -= n;
+        ret_count += n;
+    }
+
+    return ret_count;
+}
+
 #if OS(LINUX) || OS(UNIX) || OS(MAC_OS_X)
 
+static ssize_t rope_dump_to_fd (struct rope_rwstream* rope, int fd)
+{
+    ssize_t ret_count = 0;
+
+    while (rope->pos < rope->total) {
+        struct iovec iov[NR_ROPE_IOVS];
+        int nr_iov = 0;
+
+        /* gather the chunks from pos */
+        rope_locate(rope);
+        struct rope_chunk* chunk = rope->curr;
+        size_t off = rope->pos - rope->curr_start;
+        while (nr_iov < NR_ROPE_IOVS) {
+            if (chunk->used > off) {
+                iov[nr_iov].iov_base = chunk->data + off;
+                iov[nr_iov].iov_len = chunk->used - off;
+                nr_iov++;
+            }
+
+            if (chunk->ln.next == &rope->chunks) {
+                break;
+            }
+            chunk = list_entry(chunk->ln.next, struct rope_chunk, ln);
+            off = 0;
+        }
+
+        ssize_t n = writev(fd, iov, nr_iov);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            purc_set_error(purc_error_from_errno(errno));
+            return -1;
+        }
+        else if (n == 0) {
+            break;
+        }
+
+        /* a short write is continued from the new pos */
+        rope->pos += n;
+        ret_count += n;
+    }
+
+    return ret_count;
+}
+
 static off_t fd_seek (purc_rwstream_t rws, off_t offset, int whence)
 {
     struct fd_rwstream* fd_rws = (struct fd_rwstream *)rws;
@@ -996,4 +1622,14 @@ static int fd_destroy (purc_rwstream_t rws)
     return 0;
 }
 
+static int mmap_destroy (purc_rwstream_t rws)
+{
+    struct mem_rwstream* mem = (struct mem_rwstream *)rws;
+    if (mem->stop > mem->base) {
+        munmap(mem->base, mem->stop - mem->base);
+    }
+    free(rws);
+    return 0;
+}
+
 #endif // OS(LINUX) || OS(UNIX) || OS(MAC_OS_X)
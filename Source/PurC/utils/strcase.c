@@ -33,10 +33,12 @@
 #include "purc-utils.h"
 
 #include <string.h>
+#include <ctype.h>
 #include <assert.h>
 
 #include "config.h"
 #include "private/utf8.h"
+#include "private/utils.h"
 
 #if USE(GLIB)
 #include <glib.h>
@@ -210,6 +212,27 @@ int pcutils_strncasecmp(const char *s1, const char *s2, size_t n)
 
     locale_type lt = get_locale_type();
 
+    /* only the Turkic languages lower an ASCII letter (`I`) specially */
+    if (lt != LOCALE_TURKIC) {
+        size_t len = pcutils_ascii_caseless_prefix(s1, s2, n);
+        if (len < n) {
+            unsigned char c1 = s1[len], c2 = s2[len];
+            if (c1 < 0x80 && c2 < 0x80)
+                return purc_tolower(c1) - purc_tolower(c2);
+        }
+        else if (lt == LOCALE_NORMAL) {
+            return 0;
+        }
+
+        /* the last ASCII letter may be lowered with the following accents
+           (in Lithuanian), so it is compared again */
+        if (len > 0)
+            len--;
+        s1 += len;
+        s2 += len;
+        n -= len;
+    }
+
     while (n > 0) {
         size_t len1 = utf8_char_to_lower(lt, s1, ucs1);
         size_t len2 = utf8_char_to_lower(lt, s2, ucs2);
@@ -232,16 +255,35 @@ int pcutils_strncasecmp(const char *s1, const char *s2, size_t n)
     return 0;
 }
 
+bool pcutils_strfold_ascii(char *dst, const char *src, size_t len)
+{
+    if (get_locale_type() == LOCALE_TURKIC)
+        return false;
+
+    return pcutils_ascii_tolower_copy(dst, src, len);
+}
+
 char *pcutils_strcasestr(const char *haystack, const char *needle)
 {
     locale_type lt = get_locale_type();
+
+    /* only the Turkic languages lower an ASCII letter (`I`) specially */
+    if (lt != LOCALE_TURKIC) {
+        size_t len_haystack = strlen(haystack);
+        size_t len_needle = strlen(needle);
+        if (pcutils_is_ascii(needle, len_needle) &&
+                pcutils_is_ascii(haystack, len_haystack))
+            return (char *)pcutils_memcasemem(haystack, len_haystack,
+                    needle, len_needle);
+    }
+
     gunichar ucs1[MAX_LOWER_CHARS];
     gunichar ucs2[MAX_LOWER_CHARS];
 
     char* p = (char *)haystack;
     while (*p) {
 
-        size_t len1 = utf8_char_to_lower(lt, haystack, ucs1);
+        size_t len1 = utf8_char_to_lower(lt, p, ucs1);
         size_t len2 = utf8_char_to_lower(lt, needle, ucs2);
 
         int diff = memcmp(ucs1, ucs2, sizeof(ucs1));
@@ -331,40 +373,19 @@ int pcutils_strncasecmp(const char *s1, const char *s2, size_t n)
     return strncasecmp(s1, s2, n);
 }
 
-char *pcutils_strcasestr(const char *haystack, const char *needle)
+bool pcutils_strfold_ascii(char *dst, const char *src, size_t len)
 {
-    char* p = (char *)haystack;
+    /* strncasecmp() lowers the letters with tolower() of the locale */
+    if (tolower('I') != 'i')
+        return false;
 
-    while (*p) {
-
-        int lower1, lower2;
-
-        lower1 = purc_tolower(*p);
-        lower2 = purc_tolower(*needle);
-
-        if (lower1 == lower2) {
-            const char *p1 = p + 1, *p2 = needle + 1;
-            while (*p1 && *p2) {
-                if (purc_tolower(*p1) != purc_tolower(*p2))
-                    goto not_matched;
-
-                p1++;
-                p2++;
-            }
-
-            if (*p1 == 0 && *p2)    // end of haystack
-                goto done;
-
-            /* matched */
-            return p;
-        }
-
-not_matched:
-        p++;
-    }
+    return pcutils_ascii_tolower_copy(dst, src, len);
+}
 
-done:
-    return NULL;
+char *pcutils_strcasestr(const char *haystack, const char *needle)
+{
+    return (char *)pcutils_memcasemem(haystack, strlen(haystack),
+            needle, strlen(needle));
 }
 
 #endif  /* !USE(GLIB) */
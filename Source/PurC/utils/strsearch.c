@@ -0,0 +1,387 @@
+/*
+ * @file strsearch.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The substring search, the byte scanning, and the ASCII case
+ *  folding accelerated by SIMD instructions.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The candidates are the positions where both the first and the last bytes
+ * of the needle match, found 16 positions at a time; only the candidates
+ * are compared with the needle. When the filter lets too many candidates
+ * through (e.g., for a needle like `aaab`), the search goes on with
+ * memmem(), which implements the two-way algorithm in linear time.
+ */
+
+#define _GNU_SOURCE
+#include "config.h"
+
+#include "purc-utils.h"
+#include "private/utils.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#if defined(__SSE2__) || (defined(__ARM_NEON) && defined(__aarch64__))
+#define HAVE_SIMD_FILTER    1
+#endif
+
+/* the candidates failed allowed per 16 bytes before going on with memmem() */
+#define MAX_FALSE_CANDIDATES    4
+
+#if HAVE_SIMD_FILTER
+
+#if defined(__SSE2__)
+/* the bits of a position in the mask returned by candidates() */
+#define MASK_STRIDE     1
+#define MASK_BITS       0x1
+
+static inline __m128i
+fold_case(__m128i chunk)
+{
+    const __m128i v_before_a = _mm_set1_epi8('A' - 1);
+    const __m128i v_after_z = _mm_set1_epi8('Z' + 1);
+    const __m128i v_case = _mm_set1_epi8(0x20);
+
+    /* the bytes not less than 0x80 are negative, thus not uppercase */
+    __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(chunk, v_before_a),
+            _mm_cmplt_epi8(chunk, v_after_z));
+    return _mm_or_si128(chunk, _mm_and_si128(upper, v_case));
+}
+
+static inline uint64_t
+candidates(const char *p, size_t off_last, int first, int last, bool caseless)
+{
+    __m128i head = _mm_loadu_si128((const __m128i *)p);
+    __m128i tail = _mm_loadu_si128((const __m128i *)(p + off_last));
+    if (caseless) {
+        head = fold_case(head);
+        tail = fold_case(tail);
+    }
+
+    __m128i hit = _mm_and_si128(_mm_cmpeq_epi8(head, _mm_set1_epi8(first)),
+            _mm_cmpeq_epi8(tail, _mm_set1_epi8(last)));
+    return (uint64_t)_mm_movemask_epi8(hit);
+}
+
+#else /* NEON */
+#define MASK_STRIDE     4
+#define MASK_BITS       0xF
+
+static inline uint8x16_t
+fold_case(uint8x16_t chunk)
+{
+    uint8x16_t upper = vcleq_u8(vsubq_u8(chunk, vdupq_n_u8('A')),
+            vdupq_n_u8('Z' - 'A'));
+    return vorrq_u8(chunk, vandq_u8(upper, vdupq_n_u8(0x20)));
+}
+
+static inline uint64_t
+candidates(const char *p, size_t off_last, int first, int last, bool caseless)
+{
+    uint8x16_t head = vld1q_u8((const uint8_t *)p);
+    uint8x16_t tail = vld1q_u8((const uint8_t *)(p + off_last));
+    if (caseless) {
+        head = fold_case(head);
+        tail = fold_case(tail);
+    }
+
+    uint8x16_t hit = vandq_u8(vceqq_u8(head, vdupq_n_u8((uint8_t)first)),
+            vceqq_u8(tail, vdupq_n_u8((uint8_t)last)));
+    /* four bits for a byte, since there is no movemask */
+    uint8x8_t mask = vshrn_n_u16(vreinterpretq_u16_u8(hit), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(mask), 0);
+}
+
+#endif /* NEON */
+#endif /* HAVE_SIMD_FILTER */
+
+static bool
+equal_caseless(const char *s1, const char *s2, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (purc_tolower(s1[i]) != purc_tolower(s2[i]))
+            return false;
+    }
+
+    return true;
+}
+
+static const char *
+search_caseless(const char *haystack, size_t len_haystack,
+        const char *needle, size_t len_needle)
+{
+    if (len_needle > len_haystack)
+        return NULL;
+
+    int first = purc_tolower(needle[0]);
+    size_t end = len_haystack - len_needle;
+
+    for (size_t i = 0; i <= end; i++) {
+        if (purc_tolower(haystack[i]) == first &&
+                equal_caseless(haystack + i + 1, needle + 1, len_needle - 1))
+            return haystack + i;
+    }
+
+    return NULL;
+}
+
+static const char *
+search(const char *haystack, size_t len_haystack,
+        const char *needle, size_t len_needle, bool caseless)
+{
+    if (len_needle == 0)
+        return haystack;
+    if (len_needle > len_haystack)
+        return NULL;
+    if (len_needle == 1 && !caseless)
+        return memchr(haystack, needle[0], len_haystack);
+
+    size_t i = 0;
+
+#if HAVE_SIMD_FILTER
+    int first = caseless ? purc_tolower(needle[0]) : (unsigned char)needle[0];
+    int last = (unsigned char)needle[len_needle - 1];
+    if (caseless)
+        last = purc_tolower(last);
+
+    size_t off_last = len_needle - 1;
+    size_t nr_false = 0;
+    while (i + off_last + 16 <= len_haystack) {
+        uint64_t mask = candidates(haystack + i, off_last, first, last,
+                caseless);
+        while (mask) {
+            unsigned bit = __builtin_ctzll(mask);
+            size_t pos = i + bit / MASK_STRIDE;
+            /* the first and the last bytes are matched already */
+            if (len_needle <= 2)
+                return haystack + pos;
+            if (caseless) {
+                if (equal_caseless(haystack + pos + 1, needle + 1,
+                            len_needle - 2))
+                    return haystack + pos;
+            }
+            else if (memcmp(haystack + pos + 1, needle + 1,
+                        len_needle - 2) == 0) {
+                return haystack + pos;
+            }
+
+            nr_false++;
+            mask &= ~((uint64_t)MASK_BITS << (bit - bit % MASK_STRIDE));
+        }
+
+        i += 16;
+        if (!caseless && nr_false > MAX_FALSE_CANDIDATES * (i / 16 + 1))
+            break;
+    }
+#endif
+
+    if (caseless)
+        return search_caseless(haystack + i, len_haystack - i,
+                needle, len_needle);
+    return memmem(haystack + i, len_haystack - i, needle, len_needle);
+}
+
+const char *
+pcutils_memmem(const char *haystack, size_t len_haystack,
+        const char *needle, size_t len_needle)
+{
+    return search(haystack, len_haystack, needle, len_needle, false);
+}
+
+const char *
+pcutils_memcasemem(const char *haystack, size_t len_haystack,
+        const char *needle, size_t len_needle)
+{
+    return search(haystack, len_haystack, needle, len_needle, true);
+}
+
+const unsigned char *
+pcutils_memchr4(const unsigned char *p, const unsigned char *end,
+        unsigned char c1, unsigned char c2, unsigned char c3, unsigned char c4)
+{
+#if defined(__SSE2__)
+    const __m128i v1 = _mm_set1_epi8((char)c1);
+    const __m128i v2 = _mm_set1_epi8((char)c2);
+    const __m128i v3 = _mm_set1_epi8((char)c3);
+    const __m128i v4 = _mm_set1_epi8((char)c4);
+
+    /* two chunks a time, since the significant bytes are usually sparse */
+    while (end - p >= 32) {
+        __m128i a = _mm_loadu_si128((const __m128i *)p);
+        __m128i b = _mm_loadu_si128((const __m128i *)(p + 16));
+        __m128i hit_a = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(a, v1), _mm_cmpeq_epi8(a, v2)),
+                _mm_or_si128(_mm_cmpeq_epi8(a, v3), _mm_cmpeq_epi8(a, v4)));
+        __m128i hit_b = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(b, v1), _mm_cmpeq_epi8(b, v2)),
+                _mm_or_si128(_mm_cmpeq_epi8(b, v3), _mm_cmpeq_epi8(b, v4)));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(hit_a) |
+            ((uint32_t)_mm_movemask_epi8(hit_b) << 16);
+        if (mask)
+            return p + __builtin_ctz(mask);
+        p += 32;
+    }
+
+    if (end - p >= 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)p);
+        __m128i hit = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(a, v1), _mm_cmpeq_epi8(a, v2)),
+                _mm_or_si128(_mm_cmpeq_epi8(a, v3), _mm_cmpeq_epi8(a, v4)));
+        unsigned mask = (unsigned)_mm_movemask_epi8(hit);
+        if (mask)
+            return p + __builtin_ctz(mask);
+        p += 16;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x16_t v1 = vdupq_n_u8(c1);
+    const uint8x16_t v2 = vdupq_n_u8(c2);
+    const uint8x16_t v3 = vdupq_n_u8(c3);
+    const uint8x16_t v4 = vdupq_n_u8(c4);
+
+    while (end - p >= 16) {
+        uint8x16_t a = vld1q_u8(p);
+        uint8x16_t hit = vorrq_u8(
+                vorrq_u8(vceqq_u8(a, v1), vceqq_u8(a, v2)),
+                vorrq_u8(vceqq_u8(a, v3), vceqq_u8(a, v4)));
+        /* four bits for a byte, since there is no movemask */
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(
+                    vshrn_n_u16(vreinterpretq_u16_u8(hit), 4)), 0);
+        if (mask)
+            return p + __builtin_ctzll(mask) / 4;
+        p += 16;
+    }
+#endif
+
+    for (; p < end; p++) {
+        if (*p == c1 || *p == c2 || *p == c3 || *p == c4)
+            break;
+    }
+
+    return p;
+}
+
+bool
+pcutils_is_ascii(const char *str, size_t len)
+{
+    const unsigned char *p = (const unsigned char *)str;
+    size_t n = 0;
+
+#if defined(__SSE2__)
+    while (n + 16 <= len) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(p + n));
+        if (_mm_movemask_epi8(chunk))
+            return false;
+        n += 16;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    while (n + 16 <= len) {
+        if (vmaxvq_u8(vld1q_u8(p + n)) >= 0x80)
+            return false;
+        n += 16;
+    }
+#endif
+
+    for (; n < len; n++) {
+        if (p[n] >= 0x80)
+            return false;
+    }
+
+    return true;
+}
+
+size_t
+pcutils_ascii_caseless_prefix(const char *s1, const char *s2, size_t n)
+{
+    const unsigned char *p1 = (const unsigned char *)s1;
+    const unsigned char *p2 = (const unsigned char *)s2;
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    while (i + 16 <= n) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(p1 + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(p2 + i));
+        unsigned same = _mm_movemask_epi8(
+                _mm_cmpeq_epi8(fold_case(a), fold_case(b)));
+        same &= ~_mm_movemask_epi8(_mm_or_si128(a, b)) & 0xFFFF;
+        if (same != 0xFFFF)
+            return i + __builtin_ctz(~same);
+        i += 16;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    while (i + 16 <= n) {
+        uint8x16_t a = vld1q_u8(p1 + i);
+        uint8x16_t b = vld1q_u8(p2 + i);
+        uint8x16_t same = vandq_u8(vceqq_u8(fold_case(a), fold_case(b)),
+                vcltq_u8(vorrq_u8(a, b), vdupq_n_u8(0x80)));
+        /* the scalar loop below finds the position */
+        if (vminvq_u8(same) != 0xFF)
+            break;
+        i += 16;
+    }
+#endif
+
+    for (; i < n; i++) {
+        if ((p1[i] | p2[i]) >= 0x80 ||
+                purc_tolower(p1[i]) != purc_tolower(p2[i]))
+            break;
+    }
+
+    return i;
+}
+
+bool
+pcutils_ascii_tolower_copy(char *dst, const char *src, size_t len)
+{
+    const unsigned char *p = (const unsigned char *)src;
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    while (i + 16 <= len) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(p + i));
+        if (_mm_movemask_epi8(chunk))
+            return false;
+        _mm_storeu_si128((__m128i *)(dst + i), fold_case(chunk));
+        i += 16;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    while (i + 16 <= len) {
+        uint8x16_t chunk = vld1q_u8(p + i);
+        if (vmaxvq_u8(chunk) >= 0x80)
+            return false;
+        vst1q_u8((uint8_t *)(dst + i), fold_case(chunk));
+        i += 16;
+    }
+#endif
+
+    for (; i < len; i++) {
+        if (p[i] >= 0x80)
+            return false;
+        dst[i] = purc_tolower(p[i]);
+    }
+
+    return true;
+}
@@ -0,0 +1,681 @@
+/*
+ * @file threadpool.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The implementation of the thread pool of the CPU-bound tasks.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE         // pthread_setaffinity_np
+#include "config.h"
+
+#include "purc-helpers.h"
+#include "purc-runloop.h"
+
+#include "private/threadpool.h"
+#include "private/affinity.h"
+#include "private/instance.h"
+#include "private/list.h"
+#include "private/tls.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_POOL_WORKERS        64
+
+#if USE(PTHREADS) && HAVE(STDATOMIC_H)
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#define POOL_THREADED           1
+#else
+#define POOL_THREADED           0
+#endif
+
+enum {
+    TASK_QUEUED = 0,
+    TASK_RUNNING,
+    TASK_FINISHED,
+    TASK_CANCELED,
+};
+
+struct pcutils_task {
+    pcutils_task_func       func;
+    void                   *arg;
+    void                   *result;
+
+    pcutils_task_done_func  done;
+    void                   *ctxt;
+
+    /* the run loop to call @done on; NULL to call it on the worker */
+    purc_runloop_t          runloop;
+    /* the instance owning the task, and the node in its list; only
+       accessed on the thread of the instance */
+    struct pcinst          *inst;
+    struct list_head        ln;
+
+#if POOL_THREADED
+    atomic_int              state;
+    atomic_uint             refc;
+#else
+    int                     state;
+    unsigned                refc;
+#endif
+};
+
+static struct {
+    unsigned                nr_workers;     /* 0 for the default */
+    char                   *cpus;
+    bool                    configured;
+} pool_config;
+
+static unsigned default_nr_workers(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+    /* the threads waiting for the tasks run the tasks as well */
+    if (n > MAX_POOL_WORKERS + 1)
+        return MAX_POOL_WORKERS;
+    return (n > 2) ? (unsigned)(n - 1) : 1;
+}
+
+unsigned pcutils_threadpool_nr_workers(void)
+{
+    return pool_config.nr_workers ? pool_config.nr_workers :
+        default_nr_workers();
+}
+
+static void call_done(pcutils_task *task)
+{
+    if (task->state == TASK_FINISHED)
+        task->done(task, task->result, task->ctxt);
+}
+
+#if POOL_THREADED
+
+struct task_deque {
+    pthread_mutex_t         lock;
+    pcutils_task          **tasks;
+    size_t                  sz;
+    size_t                  head;
+    size_t                  nr;
+};
+
+struct pool_worker {
+    struct task_deque       dq;
+    pthread_t               th;
+    unsigned                idx;
+    bool                    running;
+};
+
+static struct {
+    /* protects the starting and stopping and the sleeping of workers */
+    pthread_mutex_t         lock;
+    pthread_cond_t          work_cond;
+    /* the threads waiting for the tasks sleep on this */
+    pthread_mutex_t         done_lock;
+    pthread_cond_t          done_cond;
+
+    atomic_bool             started;
+    bool                    stopping;
+    unsigned                nr_workers;
+    struct pool_worker     *workers;
+
+    /* the tasks submitted by the threads other than the workers */
+    struct task_deque       shared;
+
+    atomic_long             nr_queued;
+    atomic_uint             nr_idle;
+} pool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .work_cond = PTHREAD_COND_INITIALIZER,
+    .done_lock = PTHREAD_MUTEX_INITIALIZER,
+    .done_cond = PTHREAD_COND_INITIALIZER,
+    .shared = { .lock = PTHREAD_MUTEX_INITIALIZER },
+};
+
+/* the worker of the current thread; NULL if it is not a worker */
+PURC_DEFINE_THREAD_LOCAL(struct pool_worker *, self_worker);
+
+static int deque_push(struct task_deque *dq, pcutils_task *task)
+{
+    int ret = 0;
+
+    pthread_mutex_lock(&dq->lock);
+    if (dq->nr == dq->sz) {
+        size_t sz = dq->sz ? dq->sz * 2 : 16;
+        pcutils_task **tasks = malloc(sizeof(*tasks) * sz);
+        if (tasks == NULL) {
+            ret = -1;
+            goto done;
+        }
+
+        for (size_t i = 0; i < dq->nr; i++)
+            tasks[i] = dq->tasks[(dq->head + i) % dq->sz];
+        free(dq->tasks);
+        dq->tasks = tasks;
+        dq->sz = sz;
+        dq->head = 0;
+    }
+
+    dq->tasks[(dq->head + dq->nr) % dq->sz] = task;
+    dq->nr++;
+
+done:
+    pthread_mutex_unlock(&dq->lock);
+    return ret;
+}
+
+/* takes the newest task; used by the owner */
+static pcutils_task *deque_pop(struct task_deque *dq)
+{
+    pcutils_task *task = NULL;
+
+    pthread_mutex_lock(&dq->lock);
+    if (dq->nr > 0) {
+        dq->nr--;
+        task = dq->tasks[(dq->head + dq->nr) % dq->sz];
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return task;
+}
+
+/* takes the oldest task; used by the thieves */
+static pcutils_task *deque_steal(struct task_deque *dq)
+{
+    pcutils_task *task = NULL;
+
+    pthread_mutex_lock(&dq->lock);
+    if (dq->nr > 0) {
+        task = dq->tasks[dq->head];
+        dq->head = (dq->head + 1) % dq->sz;
+        dq->nr--;
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return task;
+}
+
+static void deque_clear(struct task_deque *dq)
+{
+    assert(dq->nr == 0);
+    free(dq->tasks);
+    dq->tasks = NULL;
+    dq->sz = dq->head = dq->nr = 0;
+}
+
+static void retain_task(pcutils_task *task)
+{
+    atomic_fetch_add(&task->refc, 1);
+}
+
+void pcutils_task_release(pcutils_task *task)
+{
+    if (atomic_fetch_sub(&task->refc, 1) == 1)
+        free(task);
+}
+
+bool pcutils_task_is_done(pcutils_task *task)
+{
+    return atomic_load(&task->state) >= TASK_FINISHED;
+}
+
+/* called on the run loop of the instance owning the task */
+static void on_task_done(void *ctxt)
+{
+    pcutils_task *task = ctxt;
+
+    /* the task was dropped if the instance has been cleaned up */
+    if (task->inst) {
+        list_del(&task->ln);
+        task->inst = NULL;
+        call_done(task);
+        pcutils_task_release(task);
+    }
+
+    pcutils_task_release(task);
+}
+
+static void settle_task(pcutils_task *task, int state)
+{
+    pthread_mutex_lock(&pool.done_lock);
+    atomic_store(&task->state, state);
+    pthread_cond_broadcast(&pool.done_cond);
+    pthread_mutex_unlock(&pool.done_lock);
+
+    if (task->done == NULL)
+        return;
+
+    if (task->runloop) {
+        retain_task(task);
+        purc_runloop_dispatch(task->runloop, on_task_done, task);
+    }
+    else {
+        call_done(task);
+    }
+}
+
+/* runs a task taken from a queue, and releases the reference of the queue */
+static void run_task(pcutils_task *task)
+{
+    int expected = TASK_QUEUED;
+    if (atomic_compare_exchange_strong(&task->state, &expected,
+                TASK_RUNNING)) {
+        task->result = task->func(task->arg);
+        settle_task(task, TASK_FINISHED);
+    }
+
+    pcutils_task_release(task);
+}
+
+static pcutils_task *take_task(struct pool_worker *self)
+{
+    if (atomic_load(&pool.nr_queued) <= 0)
+        return NULL;
+
+    pcutils_task *task = NULL;
+    if (self)
+        task = deque_pop(&self->dq);
+    if (task == NULL)
+        task = deque_steal(&pool.shared);
+
+    /* steal from the next workers, so the thieves spread out */
+    unsigned nr = pool.nr_workers;
+    unsigned start = self ? self->idx + 1 : 0;
+    for (unsigned i = 0; task == NULL && i < nr; i++) {
+        struct pool_worker *victim = pool.workers + (start + i) % nr;
+        if (victim != self)
+            task = deque_steal(&victim->dq);
+    }
+
+    if (task)
+        atomic_fetch_sub(&pool.nr_queued, 1);
+    return task;
+}
+
+#if OS(LINUX)
+static void set_affinity(unsigned idx)
+{
+    int cpus[MAX_POOL_WORKERS];
+    unsigned nr = pool_config.cpus ?
+        pcutils_parse_cpu_list(pool_config.cpus, cpus,
+            MAX_POOL_WORKERS) : 0;
+    if (nr == 0)
+        return;
+
+    /* one CPU for a worker, in turn */
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpus[idx % nr], &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+#else
+static void set_affinity(unsigned idx)
+{
+    (void)idx;
+}
+#endif
+
+static void *worker_main(void *arg)
+{
+    struct pool_worker *self = arg;
+    *PURC_GET_THREAD_LOCAL(self_worker) = self;
+
+    /* leave the signals to the threads of the instances */
+    sigset_t set;
+    sigfillset(&set);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+    set_affinity(self->idx);
+
+    for (;;) {
+        pcutils_task *task = take_task(self);
+        if (task) {
+            run_task(task);
+            continue;
+        }
+
+        pthread_mutex_lock(&pool.lock);
+        atomic_fetch_add(&pool.nr_idle, 1);
+        while (atomic_load(&pool.nr_queued) <= 0 && !pool.stopping)
+            pthread_cond_wait(&pool.work_cond, &pool.lock);
+        atomic_fetch_sub(&pool.nr_idle, 1);
+        bool stop = pool.stopping && atomic_load(&pool.nr_queued) <= 0;
+        pthread_mutex_unlock(&pool.lock);
+
+        if (stop)
+            break;
+    }
+
+    *PURC_GET_THREAD_LOCAL(self_worker) = NULL;
+    return NULL;
+}
+
+static int start_workers(void)
+{
+    if (atomic_load(&pool.started))
+        return 0;
+
+    int ret = 0;
+    pthread_mutex_lock(&pool.lock);
+    if (atomic_load(&pool.started))
+        goto done;
+
+    unsigned nr = pcutils_threadpool_nr_workers();
+    struct pool_worker *workers = calloc(nr, sizeof(*workers));
+    if (workers == NULL) {
+        ret = -1;
+        goto done;
+    }
+
+    for (unsigned i = 0; i < nr; i++) {
+        pthread_mutex_init(&workers[i].dq.lock, NULL);
+        workers[i].idx = i;
+    }
+
+    /* the workers steal from each other once started */
+    pool.workers = workers;
+    pool.nr_workers = nr;
+
+    unsigned nr_started = 0;
+    for (unsigned i = 0; i < nr; i++) {
+        if (pthread_create(&workers[i].th, NULL, worker_main, workers + i))
+            continue;
+        workers[i].running = true;
+        nr_started++;
+    }
+
+    if (nr_started == 0) {
+        for (unsigned i = 0; i < nr; i++)
+            pthread_mutex_destroy(&workers[i].dq.lock);
+        free(workers);
+        pool.workers = NULL;
+        pool.nr_workers = 0;
+        ret = -1;
+        goto done;
+    }
+
+    atomic_store(&pool.started, true);
+
+done:
+    pthread_mutex_unlock(&pool.lock);
+    return ret;
+}
+
+static int queue_task(pcutils_task *task)
+{
+    if (start_workers())
+        return -1;
+
+    struct pool_worker *self = *PURC_GET_THREAD_LOCAL(self_worker);
+    atomic_fetch_add(&pool.nr_queued, 1);
+    if (deque_push(self ? &self->dq : &pool.shared, task)) {
+        atomic_fetch_sub(&pool.nr_queued, 1);
+        return -1;
+    }
+
+    if (atomic_load(&pool.nr_idle) > 0) {
+        pthread_mutex_lock(&pool.lock);
+        pthread_cond_signal(&pool.work_cond);
+        pthread_mutex_unlock(&pool.lock);
+    }
+
+    return 0;
+}
+
+void *pcutils_task_wait(pcutils_task *task)
+{
+    struct pool_worker *self = *PURC_GET_THREAD_LOCAL(self_worker);
+
+    while (!pcutils_task_is_done(task)) {
+        /* run the queued tasks, including this one if not taken yet */
+        pcutils_task *other = take_task(self);
+        if (other) {
+            run_task(other);
+            continue;
+        }
+
+        pthread_mutex_lock(&pool.done_lock);
+        if (!pcutils_task_is_done(task) && atomic_load(&pool.nr_queued) <= 0)
+            pthread_cond_wait(&pool.done_cond, &pool.done_lock);
+        pthread_mutex_unlock(&pool.done_lock);
+    }
+
+    return (atomic_load(&task->state) == TASK_FINISHED) ? task->result : NULL;
+}
+
+bool pcutils_task_cancel(pcutils_task *task)
+{
+    int expected = TASK_QUEUED;
+    if (!atomic_compare_exchange_strong(&task->state, &expected,
+                TASK_RUNNING))
+        return false;
+
+    /* still in the queue; released when taken by a worker */
+    settle_task(task, TASK_CANCELED);
+    return true;
+}
+
+void pcutils_threadpool_shutdown(void)
+{
+    pthread_mutex_lock(&pool.lock);
+    if (!atomic_load(&pool.started)) {
+        pthread_mutex_unlock(&pool.lock);
+        return;
+    }
+
+    pool.stopping = true;
+    pthread_cond_broadcast(&pool.work_cond);
+    pthread_mutex_unlock(&pool.lock);
+
+    for (unsigned i = 0; i < pool.nr_workers; i++) {
+        if (pool.workers[i].running)
+            pthread_join(pool.workers[i].th, NULL);
+    }
+
+    pthread_mutex_lock(&pool.lock);
+    for (unsigned i = 0; i < pool.nr_workers; i++) {
+        deque_clear(&pool.workers[i].dq);
+        pthread_mutex_destroy(&pool.workers[i].dq.lock);
+    }
+    deque_clear(&pool.shared);
+    free(pool.workers);
+    pool.workers = NULL;
+    pool.nr_workers = 0;
+    pool.stopping = false;
+    atomic_store(&pool.started, false);
+    pthread_mutex_unlock(&pool.lock);
+}
+
+#else   /* POOL_THREADED */
+
+static void retain_task(pcutils_task *task)
+{
+    task->refc++;
+}
+
+void pcutils_task_release(pcutils_task *task)
+{
+    if (--task->refc == 0)
+        free(task);
+}
+
+bool pcutils_task_is_done(pcutils_task *task)
+{
+    return task->state >= TASK_FINISHED;
+}
+
+/* no worker; the tasks are run when submitted */
+static int queue_task(pcutils_task *task)
+{
+    (void)task;
+    return -1;
+}
+
+static void run_task(pcutils_task *task)
+{
+    task->state = TASK_RUNNING;
+    task->result = task->func(task->arg);
+    task->state = TASK_FINISHED;
+    if (task->done) {
+        if (task->inst) {
+            list_del(&task->ln);
+            task->inst = NULL;
+            pcutils_task_release(task);
+        }
+        call_done(task);
+    }
+
+    pcutils_task_release(task);
+}
+
+void *pcutils_task_wait(pcutils_task *task)
+{
+    return task->result;
+}
+
+bool pcutils_task_cancel(pcutils_task *task)
+{
+    (void)task;
+    return false;
+}
+
+void pcutils_threadpool_shutdown(void)
+{
+}
+
+#endif  /* !POOL_THREADED */
+
+static int
+configure(unsigned nr_workers, const char *cpus, bool unless_configured)
+{
+    int ret = 0;
+
+#if POOL_THREADED
+    pthread_mutex_lock(&pool.lock);
+    if (atomic_load(&pool.started)) {
+        ret = -1;
+        goto done;
+    }
+#endif
+
+    if (unless_configured && pool_config.configured)
+        goto done;
+
+    if (nr_workers > MAX_POOL_WORKERS)
+        nr_workers = MAX_POOL_WORKERS;
+    pool_config.nr_workers = nr_workers;
+    free(pool_config.cpus);
+    pool_config.cpus = (cpus && cpus[0]) ? strdup(cpus) : NULL;
+    pool_config.configured = true;
+
+done:
+#if POOL_THREADED
+    pthread_mutex_unlock(&pool.lock);
+#endif
+    return ret;
+}
+
+int pcutils_threadpool_configure(unsigned nr_workers, const char *cpus)
+{
+    return configure(nr_workers, cpus, false);
+}
+
+pcutils_task *pcutils_task_submit_ex(pcutils_task_func func, void *arg,
+        pcutils_task_done_func done, void *ctxt)
+{
+    pcutils_task *task = calloc(1, sizeof(*task));
+    if (task == NULL)
+        return NULL;
+
+    task->func = func;
+    task->arg = arg;
+    task->done = done;
+    task->ctxt = ctxt;
+    task->state = TASK_QUEUED;
+    /* one for the caller, one for the queue */
+    task->refc = 2;
+
+    struct pcinst *inst;
+    if (done && (inst = pcinst_current())) {
+        task->inst = inst;
+        task->runloop = purc_runloop_get_current();
+        /* one for the list of the instance */
+        retain_task(task);
+        list_add_tail(&task->ln, &inst->tasks);
+    }
+
+    /* run it here if failed to queue it */
+    if (queue_task(task))
+        run_task(task);
+
+    return task;
+}
+
+pcutils_task *pcutils_task_submit(pcutils_task_func func, void *arg)
+{
+    return pcutils_task_submit_ex(func, arg, NULL, NULL);
+}
+
+static int
+threadpool_init_instance(struct pcinst *curr_inst,
+        const purc_instance_extra_info* extra_info)
+{
+    INIT_LIST_HEAD(&curr_inst->tasks);
+
+    /* the first instance configures the pool for the process */
+    unsigned nr_workers = extra_info ? extra_info->nr_pool_workers : 0;
+    if (nr_workers == 0) {
+        const char *env_value = getenv(PURC_ENVV_POOL_WORKERS);
+        if (env_value)
+            nr_workers = (unsigned)strtoul(env_value, NULL, 10);
+    }
+
+    const char *cpus = extra_info ? extra_info->pool_cpu_affinity : NULL;
+    if (cpus == NULL)
+        cpus = getenv(PURC_ENVV_POOL_AFFINITY);
+
+    configure(nr_workers, cpus, true);
+    return 0;
+}
+
+static void threadpool_cleanup_instance(struct pcinst *curr_inst)
+{
+    /* the done functions of the tasks left are dropped */
+    while (!list_empty(&curr_inst->tasks)) {
+        pcutils_task *task;
+        task = list_first_entry(&curr_inst->tasks, pcutils_task, ln);
+        if (!pcutils_task_cancel(task))
+            pcutils_task_wait(task);
+
+        list_del(&task->ln);
+        task->inst = NULL;
+        pcutils_task_release(task);
+    }
+}
+
+struct pcmodule _module_threadpool = {
+    .name            = "threadpool",
+    .id              = PURC_HAVE_UTILS,
+    .module_inited   = 0,
+
+    .init_once       = NULL,
+    .init_instance   = threadpool_init_instance,
+    .cleanup_instance = threadpool_cleanup_instance,
+};
@@ -38,85 +38,96 @@
 #include <string.h>
 #include <assert.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #define VALIDATE_BYTE(mask, expect)                         \
 do {                                                        \
     if (UNLIKELY((*(uint8_t *)p & (mask)) != (expect)))     \
     goto error;                                             \
 } while (0)
 
-/* see IETF RFC 3629 Section 4 */
+/*
+ * Most of the strings are ASCII, or mostly ASCII like the markups and the
+ * keys of JSON; so the runs of the ASCII characters are validated and
+ * counted a block at a time, and only the other characters one by one.
+ */
 
-static const char *
-fast_validate(const char *str, size_t *nr_chars)
+#define ONES_U64    0x0101010101010101ULL
+#define HIGHS_U64   0x8080808080808080ULL
+
+/* returns the length of the run of the ASCII characters other than NUL
+   at @p; only a prefix of (at least) the whole blocks is checked */
+static inline size_t
+ascii_run(const char *p, size_t len)
 {
     size_t n = 0;
-    const char *p;
 
-    for (p = str; *p; p++) {
-        if (*(uint8_t *)p < 128) {
-            n++;
+#if defined(__SSE2__)
+    const __m128i v_zero = _mm_setzero_si128();
+
+    while (n + 16 <= len) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(p + n));
+        /* the bytes with the high bit or equal to zero */
+        int mask = _mm_movemask_epi8(_mm_or_si128(chunk,
+                    _mm_cmpeq_epi8(chunk, v_zero)));
+        if (mask) {
+            return n + __builtin_ctz(mask);
         }
-        else {
-            const char *last;
+        n += 16;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    while (n + 16 <= len) {
+        uint8x16_t chunk = vld1q_u8((const uint8_t *)p + n);
+        if (vminvq_u8(chunk) == 0 || vmaxvq_u8(chunk) >= 0x80) {
+            break;
+        }
+        n += 16;
+    }
+#else
+    while (n + 8 <= len) {
+        uint64_t w;
+        memcpy(&w, p + n, sizeof(w));
+        if (((w | ((w - ONES_U64) & ~w)) & HIGHS_U64) != 0) {
+            break;
+        }
+        n += 8;
+    }
+#endif
 
-            last = p;
-            if (*(uint8_t *)p < 0xe0) /* 110xxxxx */
-            {
-                if (UNLIKELY (*(uint8_t *)p < 0xc2))
-                    goto error;
-            }
-            else {
-                if (*(uint8_t *)p < 0xf0) /* 1110xxxx */
-                {
-                    switch (*(uint8_t *)p++ & 0x0f) {
-                    case 0:
-                        VALIDATE_BYTE(0xe0, 0xa0); /* 0xa0 ... 0xbf */
-                        break;
-                    case 0x0d:
-                        VALIDATE_BYTE(0xe0, 0x80); /* 0x80 ... 0x9f */
-                        break;
-                    default:
-                        VALIDATE_BYTE(0xc0, 0x80); /* 10xxxxxx */
-                    }
-                }
-                else if (*(uint8_t *)p < 0xf5) /* 11110xxx excluding out-of-range */
-                {
-                    switch (*(uint8_t *)p++ & 0x07) {
-                    case 0:
-                        VALIDATE_BYTE(0xc0, 0x80); /* 10xxxxxx */
-                        if (UNLIKELY((*(uint8_t *)p & 0x30) == 0))
-                            goto error;
-                        break;
-                    case 4:
-                        VALIDATE_BYTE(0xf0, 0x80); /* 0x80 ... 0x8f */
-                        break;
-                    default:
-                        VALIDATE_BYTE(0xc0, 0x80); /* 10xxxxxx */
-                    }
-                    p++;
-                    VALIDATE_BYTE(0xc0, 0x80); /* 10xxxxxx */
-                }
-                else
-                    goto error;
-            }
+    return n;
+}
 
-            p++;
-            VALIDATE_BYTE(0xc0, 0x80); /* 10xxxxxx */
+/* returns the number of the characters in the valid UTF-8 string of @len
+   bytes, i.e., the number of the bytes other than 10xxxxxx */
+static size_t
+count_chars(const char *p, size_t len)
+{
+    size_t n = len;
+    size_t i = 0;
 
-            n++;
-            continue;
-error:
-            if (nr_chars)
-                *nr_chars = n;
-            return last;
-        }
+    for (; i + 8 <= len; i += 8) {
+        uint64_t w;
+        memcpy(&w, p + i, sizeof(w));
+        /* the bit 7 set and the bit 6 clear */
+        uint64_t conts = w & ~(w << 1) & HIGHS_U64;
+        if (conts)
+            n -= __builtin_popcountll(conts);
     }
 
-    if (nr_chars)
-        *nr_chars = n;
-    return p;
+    for (; i < len; i++) {
+        if ((*(uint8_t *)(p + i) & 0xc0) == 0x80)
+            n--;
+    }
+
+    return n;
 }
 
+/* see IETF RFC 3629 Section 4 */
+
 static const char *
 fast_validate_len(const char *str, ssize_t max_len, size_t *nr_chars)
 {
@@ -127,7 +138,14 @@ fast_validate_len(const char *str, ssize_t max_len, size_t *nr_chars)
 
     for (p = str; ((p - str) < max_len) && *p; p++) {
         if (*(uint8_t *)p < 128) {
-            n++;
+            size_t run = ascii_run(p, max_len - (p - str));
+            if (run > 0) {
+                n += run;
+                p += run - 1;
+            }
+            else {
+                n++;
+            }
         }
         else {
             const char *last;
@@ -224,7 +242,8 @@ bool pcutils_string_check_utf8(const char *str, ssize_t max_len,
     if (max_len >= 0)
         return pcutils_string_check_utf8_len(str, max_len, nr_chars, end);
 
-    p = fast_validate(str, nr_chars);
+    /* strlen() is fast, and no byte after the terminating NUL is read */
+    p = fast_validate_len(str, strlen(str), nr_chars);
 
     if (end)
         *end = p;
@@ -251,31 +270,22 @@ const char * const _pcutils_utf8_skip = utf8_skip_data;
 size_t
 pcutils_string_utf8_chars(const char *p, ssize_t max)
 {
-    size_t nr_chars = 0;
-    const char *start = p;
-
     if (p == NULL || max == 0)
         return 0;
 
-    if (max < 0) {
-        while (*p) {
-            p = pcutils_utf8_next_char(p);
-            ++nr_chars;
-        }
-    }
-    else {
-        p = pcutils_utf8_next_char(p);
+    size_t len = (max < 0) ? strlen(p) : strnlen(p, max);
+    size_t nr_chars = count_chars(p, len);
 
-        while (p - start < max && *p) {
-            ++nr_chars;
-            p = pcutils_utf8_next_char(p);
-        }
+    /* do not count the partial character at the end */
+    if (len > 0 && len == (size_t)max) {
+        size_t last = len - 1;
+        while (last > 0 && len - last < 4 &&
+                (*(uint8_t *)(p + last) & 0xc0) == 0x80)
+            last--;
 
-        /* only do the last nr_chars increment if we got a complete
-         * char (don't count partial chars)
-         */
-        if (p - start <= max)
-            ++nr_chars;
+        uint8_t c = *(uint8_t *)(p + last);
+        if ((c & 0xc0) != 0x80 && last + _pcutils_utf8_skip[c] > len)
+            nr_chars--;
     }
 
     return nr_chars;
@@ -908,16 +918,15 @@ pcutils_strreverse(const char *str, ssize_t len, size_t nr_chars)
     }
     else if (nr_chars == length) {
         // ASCII string
-        new_str = strndup(str, length);
+        new_str = malloc(length + 1);
         if (new_str == NULL) {
             goto fatal;
         }
 
-        for (size_t i =  0; i < length >> 1; i++) {
-            char tmp = new_str[length - i - 1];
-            new_str[length - i - 1] = new_str[i];
-            new_str[i] = tmp;
+        for (size_t i =  0; i < length; i++) {
+            new_str[i] = str[length - i - 1];
         }
+        new_str[length] = 0;
     }
     else {
         new_str = malloc(length + 1);
@@ -928,7 +937,8 @@ pcutils_strreverse(const char *str, ssize_t len, size_t nr_chars)
         new_str[length] = 0;
 
         char *dst = new_str + length;
-        while (*str) {
+        const char *end = str + length;
+        while (str < end) {
             const char* next;
             next = pcutils_utf8_next_char(str);
 
@@ -281,7 +281,7 @@ int pcutils_parse_double(const char *buf, size_t len, double *retval)
 
     COPY_STRING(buf, len);
 
-    *retval = strtod(buf, &end);
+    *retval = pcutils_strtod(buf, &end);
     if (buf + len == end)
         return 0; // It worked
     return 1;
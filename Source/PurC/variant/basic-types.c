@@ -31,12 +31,15 @@
 #include "private/errors.h"
 #include "private/tls.h"
 #include "private/variant.h"
+#include "private/hashtable.h"
 #include "private/utf8.h"
 
 #include "variant-internals.h"
 
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 #ifndef MAX
 #define MAX(a, b)   (a) > (b)? (a) : (b)
@@ -226,7 +229,7 @@ purc_variant_make_string_ex(const char* str_utf8, size_t len,
     }
 
     value->type = PURC_VARIANT_TYPE_STRING;
-    value->flags = 0;
+    value->flags = (nr_chars == len) ? PCVARIANT_FLAG_STRING_ASCII : 0;
     value->refc = 1;
     value->extra_size = nr_chars;
 
@@ -245,7 +248,7 @@ purc_variant_make_string_ex(const char* str_utf8, size_t len,
             return PURC_VARIANT_INVALID;
         }
 
-        value->flags = PCVARIANT_FLAG_EXTRA_SIZE;
+        value->flags |= PCVARIANT_FLAG_EXTRA_SIZE;
         // VWNOTE: sz_ptr[0] will be set in pcvariant_stat_set_extra_size
         value->sz_ptr[1] = (uintptr_t)new_buf;
         memcpy(new_buf, str_utf8, len);
@@ -294,6 +297,8 @@ purc_variant_t purc_variant_make_string_reuse_buff(char* str_utf8,
 
     value->type = PURC_VARIANT_TYPE_STRING;
     value->flags = PCVARIANT_FLAG_EXTRA_SIZE;
+    if (nr_chars == len - 1)
+        value->flags |= PCVARIANT_FLAG_STRING_ASCII;
     value->refc = 1;
     value->extra_size = nr_chars;
 
@@ -303,6 +308,28 @@ purc_variant_t purc_variant_make_string_reuse_buff(char* str_utf8,
     return value;
 }
 
+purc_variant_t
+pcvariant_make_ascii_string_reuse_buff(char *str, size_t len)
+{
+    purc_variant_t value = pcvariant_get(PURC_VARIANT_TYPE_STRING);
+    if (value == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return PURC_VARIANT_INVALID;
+    }
+
+    str[len] = '\0';
+
+    value->type = PURC_VARIANT_TYPE_STRING;
+    value->flags = PCVARIANT_FLAG_EXTRA_SIZE | PCVARIANT_FLAG_STRING_ASCII;
+    value->refc = 1;
+    value->extra_size = len;
+
+    value->sz_ptr[1] = (uintptr_t)str;
+    pcvariant_stat_set_extra_size(value, len + 1);
+
+    return value;
+}
+
 
 purc_variant_t purc_variant_make_string_static(const char* str_utf8,
         bool check_encoding)
@@ -329,11 +356,60 @@ purc_variant_t purc_variant_make_string_static(const char* str_utf8,
         return PURC_VARIANT_INVALID;
     }
 
+    size_t len = strlen(str_utf8);
+
     value->type = PURC_VARIANT_TYPE_STRING;
     value->flags = PCVARIANT_FLAG_STRING_STATIC;
+    if (nr_chars == len)
+        value->flags |= PCVARIANT_FLAG_STRING_ASCII;
     value->refc = 1;
     value->extra_size = nr_chars;
-    value->sz_ptr[0] = (uintptr_t)strlen(str_utf8) + 1;
+    value->sz_ptr[0] = (uintptr_t)len + 1;
+    value->sz_ptr[1] = (uintptr_t)str_utf8;
+
+    return value;
+}
+
+/* unmaps the pages from the one containing @ptr to the one of the last byte */
+static void unmap_region(const void *ptr, size_t sz)
+{
+    uintptr_t page_mask = (uintptr_t)sysconf(_SC_PAGESIZE) - 1;
+    uintptr_t base = (uintptr_t)ptr & ~page_mask;
+
+    munmap((void *)base, (uintptr_t)ptr + sz - base);
+}
+
+purc_variant_t purc_variant_make_string_mapped(const char* str_utf8,
+        size_t len, bool check_encoding)
+{
+    PCVARIANT_CHECK_FAIL_RET((str_utf8 != NULL && str_utf8[len] == '\0'),
+        PURC_VARIANT_INVALID);
+
+    size_t nr_chars;
+    if (check_encoding) {
+        if (!pcutils_string_check_utf8_len(str_utf8, len, &nr_chars, NULL)) {
+            pcinst_set_error(PURC_ERROR_BAD_ENCODING);
+            return PURC_VARIANT_INVALID;
+        }
+    }
+    else {
+        nr_chars = pcutils_string_utf8_chars(str_utf8, len);
+    }
+
+    purc_variant_t value = pcvariant_get(PURC_VARIANT_TYPE_STRING);
+    if (value == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return PURC_VARIANT_INVALID;
+    }
+
+    /* accessed as a static string */
+    value->type = PURC_VARIANT_TYPE_STRING;
+    value->flags = PCVARIANT_FLAG_STRING_STATIC | PCVARIANT_FLAG_MAPPED;
+    if (nr_chars == len)
+        value->flags |= PCVARIANT_FLAG_STRING_ASCII;
+    value->refc = 1;
+    value->extra_size = nr_chars;
+    value->sz_ptr[0] = (uintptr_t)len + 1;
     value->sz_ptr[1] = (uintptr_t)str_utf8;
 
     return value;
@@ -402,7 +478,13 @@ bool purc_variant_string_chars(purc_variant_t string, size_t *nr_chars)
         IS_TYPE(string, PURC_VARIANT_TYPE_ATOMSTRING) ||
         IS_TYPE(string, PURC_VARIANT_TYPE_EXCEPTION)) {
 
-        *nr_chars = string->extra_size;
+#if SIZE_MAX > UINT32_MAX
+        /* see pcvariant_string_hash() */
+        if (string->flags & PCVARIANT_FLAG_STRING_HASHED)
+            *nr_chars = string->extra_dwords[0];
+        else
+#endif
+            *nr_chars = string->extra_size;
         return true;
     }
 
@@ -410,6 +492,32 @@ bool purc_variant_string_chars(purc_variant_t string, size_t *nr_chars)
     return false;
 }
 
+uint32_t pcvariant_string_hash(purc_variant_t string)
+{
+    PC_ASSERT(IS_TYPE(string, PURC_VARIANT_TYPE_STRING));
+
+#if SIZE_MAX > UINT32_MAX
+    if (string->flags & PCVARIANT_FLAG_STRING_HASHED)
+        return string->extra_dwords[1];
+#endif
+
+    /* the same as the hash of a C string, which stops at a null byte */
+    const char *str = purc_variant_get_string_const(string);
+    uint32_t hash = (uint32_t)pchash_default_char_hash_len(str, strlen(str));
+
+#if SIZE_MAX > UINT32_MAX
+    /* the strings are immutable, so the hash value is kept for ever */
+    if (string->extra_size <= UINT32_MAX) {
+        uint32_t nr_chars = (uint32_t)string->extra_size;
+        string->extra_dwords[0] = nr_chars;
+        string->extra_dwords[1] = hash;
+        string->flags |= PCVARIANT_FLAG_STRING_HASHED;
+    }
+#endif
+
+    return hash;
+}
+
 void pcvariant_string_release (purc_variant_t string)
 {
     PC_ASSERT(string);
@@ -420,6 +528,10 @@ void pcvariant_string_release (purc_variant_t string)
             pcvariant_stat_set_extra_size (string, 0);
             free ((void *)string->sz_ptr[1]);
         }
+        else if (string->flags & PCVARIANT_FLAG_MAPPED) {
+            unmap_region((const void *)string->sz_ptr[1],
+                    (size_t)string->sz_ptr[0]);
+        }
     }
     else
         pcinst_set_error (PCVARIANT_ERROR_INVALID_TYPE);
@@ -617,6 +729,16 @@ purc_variant_t purc_variant_make_byte_sequence_reuse_buff(void* bytes,
     return value;
 }
 
+purc_variant_t purc_variant_make_byte_sequence_mapped(const void* bytes,
+        size_t nr_bytes)
+{
+    purc_variant_t value = purc_variant_make_byte_sequence_static(bytes,
+            nr_bytes);
+    if (value)
+        value->flags |= PCVARIANT_FLAG_MAPPED;
+    return value;
+}
+
 purc_variant_t purc_variant_make_byte_sequence_empty(void)
 {
     static const size_t sz_bytes = MAX(sizeof(long double), sizeof(void*) * 2);
@@ -699,6 +821,10 @@ void pcvariant_sequence_release(purc_variant_t sequence)
             pcvariant_stat_set_extra_size (sequence, 0);
             free((void *)sequence->sz_ptr[1]);
         }
+        else if (sequence->flags & PCVARIANT_FLAG_MAPPED) {
+            unmap_region((const void *)sequence->sz_ptr[1],
+                    (size_t)sequence->sz_ptr[0]);
+        }
     }
     else
         pcinst_set_error (PCVARIANT_ERROR_INVALID_TYPE);
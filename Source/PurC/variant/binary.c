@@ -0,0 +1,682 @@
+/*
+ * @file binary.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The binary eJSON encoding of variants.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A binary eJSON value is a tag (u8) followed by the payload of the type,
+ * in little endian: a double or an integer is 8 bytes, a long double is
+ * a string in the hexadecimal format of `%La` for portability, a container
+ * is the number of members (u32) followed by the members (the key string
+ * and the value for an object), and a set has its unique keys as a string
+ * first. A dynamic or native value is written as null as the text format
+ * does.
+ *
+ * A string is its length (u32) followed by the bytes, and the length
+ * 0xFFFFFFFF stands for a missing one. With PCVARIANT_BINARY_FLAG_NUL,
+ * a NUL byte follows the bytes of a string (but not of a byte sequence),
+ * so the strings can be referenced in the buffer without copying.
+ *
+ * The data made by purc_variant_serialize_binary() start with the magic
+ * `\0PCV` and the version (u8), followed by a value with the NUL bytes.
+ * The binary PurCMC framing uses the values without the NUL bytes.
+ */
+
+#include "config.h"
+
+#include "private/variant.h"
+#include "private/errors.h"
+#include "private/atom-buckets.h"
+
+#include "variant-internals.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#define BINARY_MAGIC            "\0PCV"
+#define LEN_BINARY_MAGIC        4
+#define BINARY_VERSION          1
+
+#define LEN_NONE_STRING         0xFFFFFFFFU
+
+#define LEN_BUFF_LONGDOUBLE     64
+
+#define SZ_READ_CHUNK           4096
+
+enum {
+    BJSON_UNDEFINED = 0,
+    BJSON_NULL,
+    BJSON_FALSE,
+    BJSON_TRUE,
+    BJSON_EXCEPTION,
+    BJSON_NUMBER,
+    BJSON_LONGINT,
+    BJSON_ULONGINT,
+    BJSON_LONGDOUBLE,
+    BJSON_ATOMSTRING,
+    BJSON_STRING,
+    BJSON_BSEQUENCE,
+    BJSON_OBJECT,
+    BJSON_ARRAY,
+    BJSON_SET,
+    BJSON_TUPLE,
+};
+
+struct writer {
+    pcvariant_cb_write  fn;
+    void               *ctxt;
+    unsigned int        flags;
+    bool                failed;
+};
+
+static void put_raw(struct writer *wr, const void *buf, size_t count)
+{
+    if (wr->fn(wr->ctxt, buf, count) != (ssize_t)count)
+        wr->failed = true;
+}
+
+static void put_u8(struct writer *wr, uint8_t u8)
+{
+    put_raw(wr, &u8, 1);
+}
+
+static void put_u32(struct writer *wr, uint32_t u32)
+{
+    uint8_t buf[4];
+    for (int i = 0; i < 4; i++) {
+        buf[i] = (uint8_t)(u32 >> (i * 8));
+    }
+    put_raw(wr, buf, sizeof(buf));
+}
+
+static void put_u64(struct writer *wr, uint64_t u64)
+{
+    uint8_t buf[8];
+    for (int i = 0; i < 8; i++) {
+        buf[i] = (uint8_t)(u64 >> (i * 8));
+    }
+    put_raw(wr, buf, sizeof(buf));
+}
+
+static void put_bytes(struct writer *wr, const void *bytes, size_t len)
+{
+    put_u32(wr, (uint32_t)len);
+    if (len > 0)
+        put_raw(wr, bytes, len);
+}
+
+static void put_string(struct writer *wr, const char *str, size_t len)
+{
+    put_bytes(wr, str, len);
+    if (wr->flags & PCVARIANT_BINARY_FLAG_NUL)
+        put_u8(wr, 0);
+}
+
+/* writes the string variant, or a missing string for any other */
+static void put_string_variant(struct writer *wr, purc_variant_t v)
+{
+    size_t len;
+    const char *str = v ? purc_variant_get_string_const_ex(v, &len) : NULL;
+    if (str)
+        put_string(wr, str, len);
+    else
+        put_u32(wr, LEN_NONE_STRING);
+}
+
+static int put_bjson(struct writer *wr, purc_variant_t v)
+{
+    const char *str;
+    size_t len;
+    purc_variant_t key, val;
+
+    switch (purc_variant_get_type(v)) {
+    case PURC_VARIANT_TYPE_UNDEFINED:
+        put_u8(wr, BJSON_UNDEFINED);
+        break;
+
+    case PURC_VARIANT_TYPE_NULL:
+    case PURC_VARIANT_TYPE_DYNAMIC:
+    case PURC_VARIANT_TYPE_NATIVE:
+        put_u8(wr, BJSON_NULL);
+        break;
+
+    case PURC_VARIANT_TYPE_BOOLEAN:
+        put_u8(wr, v->b ? BJSON_TRUE : BJSON_FALSE);
+        break;
+
+    case PURC_VARIANT_TYPE_EXCEPTION:
+        put_u8(wr, BJSON_EXCEPTION);
+        str = purc_variant_get_exception_string_const(v);
+        put_string(wr, str, strlen(str));
+        break;
+
+    case PURC_VARIANT_TYPE_NUMBER: {
+        uint64_t u64;
+        memcpy(&u64, &v->d, sizeof(u64));
+        put_u8(wr, BJSON_NUMBER);
+        put_u64(wr, u64);
+        break;
+    }
+
+    case PURC_VARIANT_TYPE_LONGINT:
+        put_u8(wr, BJSON_LONGINT);
+        put_u64(wr, (uint64_t)v->i64);
+        break;
+
+    case PURC_VARIANT_TYPE_ULONGINT:
+        put_u8(wr, BJSON_ULONGINT);
+        put_u64(wr, v->u64);
+        break;
+
+    case PURC_VARIANT_TYPE_LONGDOUBLE: {
+        char buf[LEN_BUFF_LONGDOUBLE];
+        int n = snprintf(buf, sizeof(buf), "%La", v->ld);
+        if (n < 0 || (size_t)n >= sizeof(buf))
+            return -1;
+        put_u8(wr, BJSON_LONGDOUBLE);
+        put_string(wr, buf, n);
+        break;
+    }
+
+    case PURC_VARIANT_TYPE_ATOMSTRING:
+        put_u8(wr, BJSON_ATOMSTRING);
+        str = purc_variant_get_atom_string_const(v);
+        put_string(wr, str, strlen(str));
+        break;
+
+    case PURC_VARIANT_TYPE_STRING:
+        put_u8(wr, BJSON_STRING);
+        str = purc_variant_get_string_const_ex(v, &len);
+        put_string(wr, str, len);
+        break;
+
+    case PURC_VARIANT_TYPE_BSEQUENCE:
+        put_u8(wr, BJSON_BSEQUENCE);
+        str = (const char *)purc_variant_get_bytes_const(v, &len);
+        put_bytes(wr, str, len);
+        break;
+
+    case PURC_VARIANT_TYPE_OBJECT:
+        put_u8(wr, BJSON_OBJECT);
+        purc_variant_object_size(v, &len);
+        put_u32(wr, (uint32_t)len);
+        foreach_key_value_in_variant_object(v, key, val) {
+            put_string_variant(wr, key);
+            if (put_bjson(wr, val))
+                return -1;
+        } end_foreach;
+        break;
+
+    case PURC_VARIANT_TYPE_SET: {
+        variant_set_t set = pcvar_set_get_data(v);
+        put_u8(wr, BJSON_SET);
+        if (set->unique_key)
+            put_string(wr, set->unique_key, strlen(set->unique_key));
+        else
+            put_u32(wr, LEN_NONE_STRING);
+        purc_variant_set_size(v, &len);
+        put_u32(wr, (uint32_t)len);
+        foreach_value_in_variant_set(v, val) {
+            if (put_bjson(wr, val))
+                return -1;
+        } end_foreach;
+        break;
+    }
+
+    case PURC_VARIANT_TYPE_ARRAY:
+    case PURC_VARIANT_TYPE_TUPLE:
+        put_u8(wr, purc_variant_is_array(v) ? BJSON_ARRAY : BJSON_TUPLE);
+        purc_variant_linear_container_size(v, &len);
+        put_u32(wr, (uint32_t)len);
+        for (size_t i = 0; i < len; i++) {
+            if (put_bjson(wr, purc_variant_linear_container_get(v, i)))
+                return -1;
+        }
+        break;
+
+    default:
+        return -1;
+    }
+
+    return 0;
+}
+
+int pcvariant_write_binary(pcvariant_cb_write fn, void *ctxt,
+        purc_variant_t v, unsigned int flags)
+{
+    struct writer wr = { fn, ctxt, flags, false };
+
+    if (put_bjson(&wr, v)) {
+        purc_set_error(PURC_ERROR_NOT_SUPPORTED);
+        return -1;
+    }
+
+    if (wr.failed) {
+        purc_set_error(PURC_ERROR_BAD_STDC_CALL);
+        return -1;
+    }
+
+    return 0;
+}
+
+struct reader {
+    const uint8_t  *p;
+    const uint8_t  *end;
+    unsigned int    flags;
+};
+
+static bool get_u8(struct reader *rd, uint8_t *u8)
+{
+    if (rd->p + 1 > rd->end)
+        return false;
+    *u8 = *rd->p++;
+    return true;
+}
+
+static bool get_u32(struct reader *rd, uint32_t *u32)
+{
+    if (rd->p + 4 > rd->end)
+        return false;
+
+    *u32 = 0;
+    for (int i = 0; i < 4; i++) {
+        *u32 |= (uint32_t)rd->p[i] << (i * 8);
+    }
+    rd->p += 4;
+    return true;
+}
+
+static bool get_u64(struct reader *rd, uint64_t *u64)
+{
+    if (rd->p + 8 > rd->end)
+        return false;
+
+    *u64 = 0;
+    for (int i = 0; i < 8; i++) {
+        *u64 |= (uint64_t)rd->p[i] << (i * 8);
+    }
+    rd->p += 8;
+    return true;
+}
+
+/* the bytes are not terminated by NUL; *bytes is NULL for a missing one */
+static bool get_bytes(struct reader *rd, const char **bytes, size_t *len)
+{
+    uint32_t u32;
+    if (!get_u32(rd, &u32))
+        return false;
+
+    if (u32 == LEN_NONE_STRING) {
+        *bytes = NULL;
+        *len = 0;
+        return true;
+    }
+
+    if ((size_t)(rd->end - rd->p) < u32)
+        return false;
+
+    *bytes = (const char *)rd->p;
+    *len = u32;
+    rd->p += u32;
+    return true;
+}
+
+/* the same as get_bytes(), but skips the NUL byte following a string */
+static bool get_string(struct reader *rd, const char **str, size_t *len)
+{
+    if (!get_bytes(rd, str, len))
+        return false;
+
+    if (*str && (rd->flags & PCVARIANT_BINARY_FLAG_NUL)) {
+        uint8_t nul;
+        if (!get_u8(rd, &nul) || nul != 0)
+            return false;
+    }
+
+    return true;
+}
+
+static purc_variant_t make_string(struct reader *rd,
+        const char *str, size_t len)
+{
+    if ((rd->flags & PCVARIANT_BINARY_OPT_ZERO_COPY) &&
+            (rd->flags & PCVARIANT_BINARY_FLAG_NUL) && strlen(str) == len)
+        return purc_variant_make_string_static(str, true);
+
+    return purc_variant_make_string_ex(str, len, true);
+}
+
+static purc_variant_t get_string_variant(struct reader *rd, bool *ok)
+{
+    const char *str;
+    size_t len;
+
+    *ok = get_string(rd, &str, &len);
+    if (!*ok || str == NULL)
+        return PURC_VARIANT_INVALID;
+
+    purc_variant_t v = make_string(rd, str, len);
+    if (v == PURC_VARIANT_INVALID)
+        *ok = false;
+    return v;
+}
+
+/* makes a C string of the bytes in the buffer */
+static const char *get_cstring(struct reader *rd, char *buf, size_t sz)
+{
+    const char *str;
+    size_t len;
+    if (!get_string(rd, &str, &len) || str == NULL || len >= sz)
+        return NULL;
+
+    memcpy(buf, str, len);
+    buf[len] = '\0';
+    return buf;
+}
+
+static purc_variant_t get_bjson(struct reader *rd, int level);
+
+static bool get_members(struct reader *rd, int level, purc_variant_t container)
+{
+    uint32_t n;
+    if (!get_u32(rd, &n))
+        return false;
+
+    for (uint32_t i = 0; i < n; i++) {
+        purc_variant_t key = PURC_VARIANT_INVALID;
+        bool ok = true;
+        if (purc_variant_is_object(container)) {
+            key = get_string_variant(rd, &ok);
+            if (key == PURC_VARIANT_INVALID)
+                return false;
+        }
+
+        purc_variant_t val = get_bjson(rd, level + 1);
+        if (val == PURC_VARIANT_INVALID) {
+            if (key)
+                purc_variant_unref(key);
+            return false;
+        }
+
+        if (key) {
+            ok = purc_variant_object_set(container, key, val);
+            purc_variant_unref(key);
+        }
+        else if (purc_variant_is_array(container)) {
+            ok = purc_variant_array_append(container, val);
+        }
+        else if (purc_variant_is_set(container)) {
+            ok = purc_variant_set_add(container, val, true);
+        }
+        else {
+            ok = purc_variant_tuple_set(container, i, val);
+        }
+
+        purc_variant_unref(val);
+        if (!ok)
+            return false;
+    }
+
+    return true;
+}
+
+static purc_variant_t get_bjson(struct reader *rd, int level)
+{
+    purc_variant_t v = PURC_VARIANT_INVALID;
+    uint8_t tag;
+    uint64_t u64;
+    const char *bytes;
+    size_t len;
+
+    if (level > MAX_EMBEDDED_LEVELS || !get_u8(rd, &tag))
+        return PURC_VARIANT_INVALID;
+
+    switch (tag) {
+    case BJSON_UNDEFINED:
+        v = purc_variant_make_undefined();
+        break;
+
+    case BJSON_NULL:
+        v = purc_variant_make_null();
+        break;
+
+    case BJSON_FALSE:
+    case BJSON_TRUE:
+        v = purc_variant_make_boolean(tag == BJSON_TRUE);
+        break;
+
+    case BJSON_EXCEPTION: {
+        char buf[PURC_LEN_IDENTIFIER + 1];
+        const char *name = get_cstring(rd, buf, sizeof(buf));
+        purc_atom_t atom = name ?
+            purc_atom_try_string_ex(ATOM_BUCKET_EXCEPT, name) : 0;
+        if (atom)
+            v = purc_variant_make_exception(atom);
+        break;
+    }
+
+    case BJSON_NUMBER:
+        if (get_u64(rd, &u64)) {
+            double d;
+            memcpy(&d, &u64, sizeof(d));
+            v = purc_variant_make_number(d);
+        }
+        break;
+
+    case BJSON_LONGINT:
+        if (get_u64(rd, &u64))
+            v = purc_variant_make_longint((int64_t)u64);
+        break;
+
+    case BJSON_ULONGINT:
+        if (get_u64(rd, &u64))
+            v = purc_variant_make_ulongint(u64);
+        break;
+
+    case BJSON_LONGDOUBLE: {
+        char buf[LEN_BUFF_LONGDOUBLE];
+        const char *str = get_cstring(rd, buf, sizeof(buf));
+        if (str)
+            v = purc_variant_make_longdouble(strtold(str, NULL));
+        break;
+    }
+
+    case BJSON_ATOMSTRING:
+    case BJSON_STRING:
+        if (get_string(rd, &bytes, &len) && bytes) {
+            if (tag == BJSON_STRING) {
+                v = make_string(rd, bytes, len);
+            }
+            else {
+                char *str = strndup(bytes, len);
+                if (str) {
+                    v = purc_variant_make_atom_string(str, true);
+                    free(str);
+                }
+            }
+        }
+        break;
+
+    case BJSON_BSEQUENCE:
+        if (get_bytes(rd, &bytes, &len) && bytes) {
+            if ((rd->flags & PCVARIANT_BINARY_OPT_ZERO_COPY) && len > 0)
+                v = purc_variant_make_byte_sequence_static(bytes, len);
+            else
+                v = purc_variant_make_byte_sequence(bytes, len);
+        }
+        break;
+
+    case BJSON_OBJECT:
+        v = purc_variant_make_object_0();
+        break;
+
+    case BJSON_ARRAY:
+        v = purc_variant_make_array_0();
+        break;
+
+    case BJSON_SET:
+        if (get_string(rd, &bytes, &len)) {
+            char *unique_key = bytes ? strndup(bytes, len) : NULL;
+            if (bytes == NULL || unique_key)
+                v = purc_variant_make_set_by_ckey(0, unique_key,
+                        PURC_VARIANT_INVALID);
+            free(unique_key);
+        }
+        break;
+
+    case BJSON_TUPLE: {
+        /* peek the size, which is read again by get_members() */
+        struct reader peek = *rd;
+        uint32_t n;
+        if (get_u32(&peek, &n) && n <= (size_t)(rd->end - rd->p))
+            v = purc_variant_make_tuple(n, NULL);
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    if (v && tag >= BJSON_OBJECT && !get_members(rd, level, v)) {
+        purc_variant_unref(v);
+        v = PURC_VARIANT_INVALID;
+    }
+
+    return v;
+}
+
+purc_variant_t pcvariant_read_binary(const uint8_t **p, const uint8_t *end,
+        unsigned int flags)
+{
+    struct reader rd = { *p, end, flags };
+
+    purc_variant_t v = get_bjson(&rd, 0);
+    if (v == PURC_VARIANT_INVALID) {
+        if (purc_get_last_error() == PURC_ERROR_OK)
+            purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return PURC_VARIANT_INVALID;
+    }
+
+    *p = rd.p;
+    return v;
+}
+
+struct stream_ctxt {
+    purc_rwstream_t     stm;
+    size_t              written;
+};
+
+static ssize_t write_to_stream(void *ctxt, const void *buf, size_t count)
+{
+    struct stream_ctxt *sc = ctxt;
+    ssize_t n = purc_rwstream_write(sc->stm, buf, count);
+    if (n > 0)
+        sc->written += n;
+    return n;
+}
+
+ssize_t purc_variant_serialize_binary(purc_variant_t value,
+        purc_rwstream_t stream, unsigned int flags)
+{
+    UNUSED_PARAM(flags);
+
+    if (value == PURC_VARIANT_INVALID || stream == NULL) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return -1;
+    }
+
+    struct stream_ctxt sc = { stream, 0 };
+    uint8_t version = BINARY_VERSION;
+    if (write_to_stream(&sc, BINARY_MAGIC, LEN_BINARY_MAGIC) !=
+                LEN_BINARY_MAGIC ||
+            write_to_stream(&sc, &version, 1) != 1) {
+        purc_set_error(PURC_ERROR_BAD_STDC_CALL);
+        return -1;
+    }
+
+    if (pcvariant_write_binary(write_to_stream, &sc, value,
+                PCVARIANT_BINARY_FLAG_NUL))
+        return -1;
+
+    return (ssize_t)sc.written;
+}
+
+purc_variant_t purc_variant_load_from_binary(const void *data, size_t sz,
+        unsigned int flags)
+{
+    const uint8_t *p = data;
+    const uint8_t *end = p + sz;
+
+    if (data == NULL || sz < LEN_BINARY_MAGIC + 1 ||
+            memcmp(p, BINARY_MAGIC, LEN_BINARY_MAGIC) ||
+            p[LEN_BINARY_MAGIC] != BINARY_VERSION) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return PURC_VARIANT_INVALID;
+    }
+    p += LEN_BINARY_MAGIC + 1;
+
+    flags &= PCVARIANT_BINARY_OPT_ZERO_COPY;
+    purc_variant_t v = pcvariant_read_binary(&p, end,
+            flags | PCVARIANT_BINARY_FLAG_NUL);
+    if (v && p != end) {
+        purc_variant_unref(v);
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        v = PURC_VARIANT_INVALID;
+    }
+
+    return v;
+}
+
+purc_variant_t purc_variant_load_from_binary_stream(purc_rwstream_t stream)
+{
+    if (stream == NULL) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return PURC_VARIANT_INVALID;
+    }
+
+    uint8_t *buf = NULL;
+    size_t sz = 0, sz_buf = 0;
+    ssize_t n;
+    do {
+        if (sz_buf - sz < SZ_READ_CHUNK) {
+            uint8_t *p = realloc(buf, sz_buf + SZ_READ_CHUNK);
+            if (p == NULL) {
+                free(buf);
+                purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+                return PURC_VARIANT_INVALID;
+            }
+            buf = p;
+            sz_buf += SZ_READ_CHUNK;
+        }
+
+        n = purc_rwstream_read(stream, buf + sz, sz_buf - sz);
+        if (n > 0)
+            sz += n;
+    } while (n > 0);
+
+    /* the buffer is released, so the values are copied */
+    purc_variant_t v = purc_variant_load_from_binary(buf, sz, 0);
+    free(buf);
+    return v;
+}
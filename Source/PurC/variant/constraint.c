@@ -29,36 +29,23 @@
 
 #include <stdlib.h>
 
-static int
-key_comp(const void *key1, const void *key2)
-{
-    return (char*)key1 - (char*)key2;
-}
-
-pcutils_map*
+/* a chain has mostly one edge, which is stored in the map itself */
+pcutils_ptrmap*
 pcvar_create_rev_update_chain(void)
 {
-    copy_key_fn copy_key = NULL;
-    free_key_fn free_key = NULL;
-    copy_val_fn copy_val = NULL;
-    free_val_fn free_val = NULL;
-    comp_key_fn comp_key = key_comp;
-
-    bool threads = false;
-    return pcutils_map_create(copy_key, free_key, copy_val, free_val,
-            comp_key, threads);
+    return pcutils_ptrmap_create();
 }
 
 void
-pcvar_destroy_rev_update_chain(pcutils_map *chain)
+pcvar_destroy_rev_update_chain(pcutils_ptrmap *chain)
 {
     if (!chain)
         return;
 
-    size_t nr = pcutils_map_get_size(chain);
+    size_t nr = pcutils_ptrmap_size(chain);
     PC_ASSERT(nr == 0);
 
-    pcutils_map_destroy(chain);
+    pcutils_ptrmap_destroy(chain);
 }
 
 static int
@@ -226,21 +213,20 @@ rebuild_ex(purc_variant_t val, pcutils_map *cache)
 }
 
 static int
-reverse_check_chain(pcutils_map *chain, struct reverse_checker *checker)
+reverse_check_chain(pcutils_ptrmap *chain, struct reverse_checker *checker)
 {
     int r = 0;
     do {
         if (!chain)
             break;
 
-        size_t nr = pcutils_map_get_size(chain);
+        size_t nr = pcutils_ptrmap_size(chain);
         if (nr == 0)
             break;
 
-        struct pcutils_map_entry *entry;
-        struct pcutils_map_iterator it;
-        it = pcutils_map_it_begin_first(chain);
-        while ((entry = pcutils_map_it_value(&it))) {
+        struct pcutils_ptrmap_entry *entry;
+        size_t pos = 0;
+        while ((entry = pcutils_ptrmap_next(chain, &pos))) {
             purc_variant_t parent;
             parent = (purc_variant_t)entry->val;
 
@@ -264,10 +250,7 @@ reverse_check_chain(pcutils_map *chain, struct reverse_checker *checker)
 
             if (r)
                 break;
-
-            pcutils_map_it_next(&it);
         }
-        pcutils_map_it_end(&it);
         if (r)
             break;
 
@@ -410,7 +393,7 @@ pcvar_reverse_check(purc_variant_t _old, purc_variant_t _new)
     return r ? -1 : 0;
 }
 
-struct pcutils_map*
+struct pcutils_ptrmap*
 get_chain(purc_variant_t val)
 {
     variant_arr_t arr_data;
@@ -440,19 +423,18 @@ wind_up_val(purc_variant_t val, struct reverse_checker *checker)
 {
     int r = 0;
 
-    struct pcutils_map *chain;
+    struct pcutils_ptrmap *chain;
     chain = get_chain(val);
     if (!chain)
         return 0;
 
-    size_t nr = pcutils_map_get_size(chain);
+    size_t nr = pcutils_ptrmap_size(chain);
     if (nr == 0)
         return 0;
 
-    struct pcutils_map_entry *entry;
-    struct pcutils_map_iterator it;
-    it = pcutils_map_it_begin_first(chain);
-    while ((entry = pcutils_map_it_value(&it))) {
+    struct pcutils_ptrmap_entry *entry;
+    size_t pos = 0;
+    while ((entry = pcutils_ptrmap_next(chain, &pos))) {
         purc_variant_t parent;
         parent = (purc_variant_t)entry->val;
 
@@ -467,9 +449,7 @@ wind_up_val(purc_variant_t val, struct reverse_checker *checker)
         }
         if (r)
             break;
-        pcutils_map_it_next(&it);
     }
-    pcutils_map_it_end(&it);
 
     return r ? -1 : 0;
 }
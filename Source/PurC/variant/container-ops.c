@@ -199,7 +199,6 @@ pcvariant_array_clear(purc_variant_t array, bool silently)
         if (!purc_variant_array_remove(array, curr)) {
             goto end;
         }
-        --curr;
     end_foreach;
     ret = true;
 
@@ -254,6 +253,140 @@ end:
     return ret;
 }
 
+/*
+ * A temporary open-addressing hash index of the members of a container,
+ * which are compared like the elements of a generic case-sensitive set.
+ * The members are borrowed from the containers, not referenced.
+ */
+struct member_index {
+    purc_variant_t     *vals;
+    uint64_t           *hashes;
+    size_t              size;       // always a power of 2
+    size_t              nr;
+};
+
+#define MEMBER_INDEX_MIN_SIZE   16
+
+static int
+member_index_init(struct member_index *index, size_t nr_expected)
+{
+    size_t size = MEMBER_INDEX_MIN_SIZE;
+    while (size < nr_expected * 2)
+        size <<= 1;
+
+    index->vals = calloc(size, sizeof(*index->vals) + sizeof(uint64_t));
+    if (index->vals == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    index->hashes = (uint64_t *)(index->vals + size);
+    index->size = size;
+    index->nr = 0;
+    return 0;
+}
+
+static void
+member_index_release(struct member_index *index)
+{
+    free(index->vals);
+    index->vals = NULL;
+}
+
+static size_t
+member_index_slot(struct member_index *index, purc_variant_t val,
+        uint64_t hash)
+{
+    size_t mask = index->size - 1;
+    size_t i = hash & mask;
+
+    while (index->vals[i]) {
+        if (index->hashes[i] == hash && (index->vals[i] == val ||
+                    purc_variant_compare_ex(index->vals[i], val,
+                        PCVARIANT_COMPARE_OPT_CASE) == 0))
+            break;
+        i = (i + 1) & mask;
+    }
+
+    return i;
+}
+
+static bool
+member_index_has(struct member_index *index, purc_variant_t val)
+{
+    uint64_t hash = pcvariant_hash(val);
+    return index->vals[member_index_slot(index, val, hash)] != NULL;
+}
+
+/* returns 1 if an equal member is there, 0 if added, and -1 for no memory */
+static int
+member_index_add(struct member_index *index, purc_variant_t val)
+{
+    uint64_t hash = pcvariant_hash(val);
+    size_t i = member_index_slot(index, val, hash);
+    if (index->vals[i])
+        return 1;
+
+    /* keeps the load factor under 1/2 */
+    if ((index->nr + 1) * 2 > index->size) {
+        struct member_index bigger;
+        if (member_index_init(&bigger, index->nr + 1))
+            return -1;
+
+        for (size_t j = 0; j < index->size; j++) {
+            if (index->vals[j]) {
+                size_t k = member_index_slot(&bigger, index->vals[j],
+                        index->hashes[j]);
+                bigger.vals[k] = index->vals[j];
+                bigger.hashes[k] = index->hashes[j];
+            }
+        }
+
+        bigger.nr = index->nr;
+        member_index_release(index);
+        *index = bigger;
+        i = member_index_slot(index, val, hash);
+    }
+
+    index->vals[i] = val;
+    index->hashes[i] = hash;
+    index->nr++;
+    return 0;
+}
+
+static bool
+add_index_member(void* ctxt, purc_variant_t member,
+        purc_variant_t member_extra, bool silently)
+{
+    UNUSED_PARAM(member_extra);
+    UNUSED_PARAM(silently);
+
+    return member_index_add((struct member_index *)ctxt, member) >= 0;
+}
+
+/* indexes all members of the linear container */
+static int
+member_index_build(struct member_index *index, purc_variant_t container,
+        bool silently)
+{
+    size_t sz = 0;
+    purc_variant_linear_container_size(container, &sz);
+    if (member_index_init(index, sz))
+        return -1;
+
+    if (sz == 0)
+        return 0;
+
+    bool ok = purc_variant_is_array(container) ?
+        array_foreach(container, add_index_member, index, silently) :
+        set_foreach(container, add_index_member, index, silently);
+    if (!ok) {
+        member_index_release(index);
+        return -1;
+    }
+    return 0;
+}
+
 static purc_variant_t
 clone_if_necessary(purc_variant_t val)
 {
@@ -866,6 +999,144 @@ end:
     return ret;
 }
 
+struct unite_ctxt {
+    purc_variant_t          array;
+    struct member_index    *index;
+};
+
+static bool
+unite_array_member(void* ctxt, purc_variant_t member,
+        purc_variant_t member_extra, bool silently)
+{
+    UNUSED_PARAM(member_extra);
+    UNUSED_PARAM(silently);
+
+    struct unite_ctxt *uc = (struct unite_ctxt *)ctxt;
+    int r = member_index_add(uc->index, member);
+    if (r)
+        return r > 0;
+
+    purc_variant_t v = clone_if_necessary(member);
+    if (v == PURC_VARIANT_INVALID)
+        return false;
+
+    bool ok = purc_variant_array_append(uc->array, v);
+    purc_variant_unref(v);
+    return ok;
+}
+
+static bool
+is_in_index(purc_variant_t member, void *ctxt)
+{
+    return member_index_has((struct member_index *)ctxt, member);
+}
+
+static bool
+is_not_in_index(purc_variant_t member, void *ctxt)
+{
+    return !member_index_has((struct member_index *)ctxt, member);
+}
+
+static bool
+check_array_and_src(purc_variant_t array, purc_variant_t src, bool silently)
+{
+    if (array == PURC_VARIANT_INVALID || src == PURC_VARIANT_INVALID) {
+        SET_SILENT_ERROR(PURC_ERROR_INVALID_VALUE);
+        return false;
+    }
+
+    if (array == src) {
+        SET_SILENT_ERROR(PURC_ERROR_INVALID_OPERAND);
+        return false;
+    }
+
+    if (!purc_variant_is_array(array) ||
+            (!purc_variant_is_array(src) && !purc_variant_is_set(src))) {
+        SET_SILENT_ERROR(PURC_ERROR_WRONG_DATA_TYPE);
+        return false;
+    }
+
+    return true;
+}
+
+bool
+purc_variant_array_unite(purc_variant_t array,
+        purc_variant_t src, bool silently)
+{
+    bool ret = false;
+
+    if (!check_array_and_src(array, src, silently))
+        goto end;
+
+    struct member_index index;
+    if (member_index_build(&index, array, silently))
+        goto end;
+
+    size_t sz = 0;
+    purc_variant_linear_container_size(src, &sz);
+    if (sz == 0) {
+        ret = true;
+    }
+    else {
+        /* the members appended are borrowed by the index from src */
+        struct unite_ctxt uc = { array, &index };
+        ret = purc_variant_is_array(src) ?
+            array_foreach(src, unite_array_member, &uc, silently) :
+            set_foreach(src, unite_array_member, &uc, silently);
+    }
+
+    member_index_release(&index);
+end:
+    return ret;
+}
+
+bool
+purc_variant_array_intersect(purc_variant_t array,
+        purc_variant_t src, bool silently)
+{
+    bool ret = false;
+
+    if (!check_array_and_src(array, src, silently))
+        goto end;
+
+    struct member_index index;
+    if (member_index_build(&index, src, silently))
+        goto end;
+
+    ret = pcvariant_array_remove_if(array, is_not_in_index, &index) == 0;
+    member_index_release(&index);
+
+end:
+    return ret;
+}
+
+bool
+purc_variant_array_subtract(purc_variant_t array,
+        purc_variant_t src, bool silently)
+{
+    bool ret = false;
+
+    if (!check_array_and_src(array, src, silently))
+        goto end;
+
+    size_t sz = 0;
+    purc_variant_linear_container_size(src, &sz);
+    if (sz == 0) {
+        ret = true;
+        goto end;
+    }
+
+    struct member_index index;
+    if (member_index_build(&index, src, silently))
+        goto end;
+
+    ret = pcvariant_array_remove_if(array, is_in_index, &index) == 0;
+    member_index_release(&index);
+
+end:
+    return ret;
+}
+
 bool
 purc_variant_set_unite(purc_variant_t set,
         purc_variant_t src, bool silently)
@@ -923,6 +1194,36 @@ purc_variant_set_intersect(purc_variant_t set,
         goto end;
     }
 
+    if (!purc_variant_is_set(src) && !purc_variant_is_array(src)) {
+        SET_SILENT_ERROR(PURC_ERROR_WRONG_DATA_TYPE);
+        goto end;
+    }
+
+    variant_set_t data = pcvar_set_get_data(set);
+    if (data->unique_key == NULL && !data->caseless) {
+        /* removes only the elements not in src, without rebuilding the set */
+        struct member_index index;
+        if (member_index_build(&index, src, silently))
+            goto end;
+
+        ret = true;
+        for (size_t i = purc_variant_set_get_size(set); i > 0; i--) {
+            purc_variant_t v = purc_variant_set_get_by_index(set, i - 1);
+            if (v == PURC_VARIANT_INVALID || member_index_has(&index, v))
+                continue;
+
+            v = purc_variant_set_remove_by_index(set, i - 1);
+            if (v == PURC_VARIANT_INVALID) {
+                ret = false;
+                break;
+            }
+            purc_variant_unref(v);
+        }
+
+        member_index_release(&index);
+        goto end;
+    }
+
     purc_variant_t result = purc_variant_make_array(0, PURC_VARIANT_INVALID);
     if (result == PURC_VARIANT_INVALID) {
         goto end;
@@ -937,15 +1238,11 @@ purc_variant_set_intersect(purc_variant_t set,
             ret = set_displace(set, result, silently);
         }
     }
-    else if (purc_variant_is_array(src)) {
+    else {
         if(array_foreach(src, intersect_set, &c_ctxt, silently)) {
             ret = set_displace(set, result, silently);
         }
     }
-    else {
-        SET_SILENT_ERROR(PURC_ERROR_WRONG_DATA_TYPE);
-        ret = false;
-    }
 
     purc_variant_unref(result);
 end:
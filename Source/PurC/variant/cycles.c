@@ -0,0 +1,628 @@
+/*
+ * @file cycles.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The cycle collector of the containers.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A synchronous trial-deletion collector (Bacon and Rajan, 2001).
+ *
+ * A container unreferenced to a count other than zero may be the root of
+ * a garbage cycle, so it is buffered by purc_variant_unref(). Collecting
+ * from a root marks the containers reachable from it gray, and subtracts
+ * the references between them from trial reference counts kept aside;
+ * the containers whose trial counts drop to zero, and which are not
+ * reachable from one referenced from outside, are referenced only by each
+ * other: they are released together.
+ *
+ * The references from anything but the containers traced (variables,
+ * frames, native entities, ...) are never subtracted, so such containers
+ * are always kept. The containers listened to, frozen, or belonging to a
+ * set (see pcvar_container_belongs_to_set()) are not traced, so a cycle
+ * through them is not collected.
+ *
+ * A collection from one root is never interrupted; the time budget is
+ * checked between the roots.
+ */
+
+#include "config.h"
+
+#include "private/instance.h"
+#include "private/variant.h"
+#include "private/debug.h"
+
+#include "variant-internals.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MIN_GC_SLOTS        64
+
+enum {
+    GC_GRAY = 1,
+    GC_WHITE,
+    GC_BLACK,
+};
+
+/* the trial reference count and the color of a container in `marks` */
+#define GC_MARK(trc, color)     ((void *)(((uintptr_t)(trc) << 2) | (color)))
+#define GC_MARK_TRC(mark)       ((uintptr_t)(mark) >> 2)
+#define GC_MARK_COLOR(mark)     ((int)((uintptr_t)(mark) & 0x03))
+
+struct gc_vector {
+    purc_variant_t     *vals;
+    size_t              nr;
+    size_t              sz;
+};
+
+struct pcvariant_gc {
+    /* the time budget of a collection on idle */
+    unsigned int        budget_us;
+    bool                collecting;
+    /* the white containers are being released */
+    bool                releasing;
+    /* nothing is collected if the containers could not be marked */
+    bool                failed;
+
+    /* the possible roots; a root released is set to NULL in place */
+    struct gc_vector    roots;
+    /* the map from a root to its position in `roots` */
+    pcutils_ptrmap      index;
+
+    /* the containers visited in a collection */
+    pcutils_ptrmap      marks;
+    struct gc_vector    stack;
+    struct gc_vector    stack_black;
+    struct gc_vector    whites;
+};
+
+unsigned int pcvariant_nr_gc_heaps;
+
+static int
+vector_push(struct gc_vector *vec, purc_variant_t v)
+{
+    if (vec->nr == vec->sz) {
+        size_t sz = vec->sz ? vec->sz * 2 : MIN_GC_SLOTS;
+        purc_variant_t *vals = realloc(vec->vals, sizeof(*vals) * sz);
+        if (vals == NULL)
+            return -1;
+        vec->vals = vals;
+        vec->sz = sz;
+    }
+
+    vec->vals[vec->nr++] = v;
+    return 0;
+}
+
+static inline purc_variant_t
+vector_pop(struct gc_vector *vec)
+{
+    return vec->nr ? vec->vals[--vec->nr] : NULL;
+}
+
+static void
+vector_free(struct gc_vector *vec)
+{
+    free(vec->vals);
+    memset(vec, 0, sizeof(*vec));
+}
+
+static struct pcvariant_gc *
+current_gc(struct pcvariant_heap **heap)
+{
+    struct pcinst *inst = pcinst_current();
+    if (inst == NULL || inst->org_vrt_heap == NULL)
+        return NULL;
+
+    *heap = inst->org_vrt_heap;
+    return inst->org_vrt_heap->gc;
+}
+
+void
+pcvariant_gc_init(struct pcvariant_heap *heap)
+{
+    const char *env = getenv(PURC_ENVV_VARIANT_GC_BUDGET);
+    if (env == NULL)
+        return;
+
+    unsigned long budget = strtoul(env, NULL, 10);
+    if (budget == 0)
+        return;
+
+    struct pcvariant_gc *gc = calloc(1, sizeof(*gc));
+    if (gc == NULL)
+        return;
+
+    gc->budget_us = budget > UINT_MAX ? UINT_MAX : (unsigned int)budget;
+    pcutils_ptrmap_init(&gc->index);
+    pcutils_ptrmap_init(&gc->marks);
+    heap->gc = gc;
+    __atomic_add_fetch(&pcvariant_nr_gc_heaps, 1, __ATOMIC_RELAXED);
+}
+
+void
+pcvariant_gc_cleanup(struct pcvariant_heap *heap)
+{
+    struct pcvariant_gc *gc = heap->gc;
+    if (gc == NULL)
+        return;
+
+    /* the flags of the roots left do not matter any longer */
+    pcutils_ptrmap_clear(&gc->index);
+    pcutils_ptrmap_clear(&gc->marks);
+    vector_free(&gc->roots);
+    vector_free(&gc->stack);
+    vector_free(&gc->stack_black);
+    vector_free(&gc->whites);
+    free(gc);
+
+    heap->gc = NULL;
+    __atomic_sub_fetch(&pcvariant_nr_gc_heaps, 1, __ATOMIC_RELAXED);
+}
+
+/* removes the holes left by the roots released */
+static void
+compact_roots(struct pcvariant_gc *gc)
+{
+    size_t nr = 0;
+    for (size_t i = 0; i < gc->roots.nr; i++) {
+        purc_variant_t v = gc->roots.vals[i];
+        if (v == NULL)
+            continue;
+
+        pcutils_ptrmap_set(&gc->index, v, (void *)(uintptr_t)nr);
+        gc->roots.vals[nr++] = v;
+    }
+    gc->roots.nr = nr;
+}
+
+void
+pcvariant_gc_buffer(purc_variant_t v)
+{
+    struct pcvariant_heap *heap;
+    struct pcvariant_gc *gc = current_gc(&heap);
+    if (gc == NULL || gc->collecting ||
+            pcinst_current()->variant_heap != heap)
+        return;
+
+    if (gc->roots.nr == gc->roots.sz &&
+            pcutils_ptrmap_size(&gc->index) < gc->roots.nr / 2)
+        compact_roots(gc);
+
+    size_t pos = gc->roots.nr;
+    if (vector_push(&gc->roots, v))
+        return;
+
+    if (pcutils_ptrmap_set(&gc->index, v, (void *)(uintptr_t)pos)) {
+        gc->roots.nr--;
+        return;
+    }
+
+    v->flags |= PCVARIANT_FLAG_GC_BUFFERED;
+    heap->stat.nr_gc_roots++;
+}
+
+void
+pcvariant_gc_forget(purc_variant_t v)
+{
+    v->flags &= ~PCVARIANT_FLAG_GC_BUFFERED;
+
+    struct pcvariant_heap *heap;
+    struct pcvariant_gc *gc = current_gc(&heap);
+    if (gc == NULL)
+        return;
+
+    struct pcutils_ptrmap_entry *entry = pcutils_ptrmap_find(&gc->index, v);
+    if (entry) {
+        gc->roots.vals[(uintptr_t)entry->val] = NULL;
+        pcutils_ptrmap_erase(&gc->index, v);
+        heap->stat.nr_gc_roots--;
+    }
+}
+
+bool
+pcvariant_gc_is_releasing(purc_variant_t v)
+{
+    if (pcvariant_nr_gc_heaps == 0)
+        return false;
+
+    struct pcvariant_heap *heap;
+    struct pcvariant_gc *gc = current_gc(&heap);
+    if (gc == NULL || !gc->releasing)
+        return false;
+
+    struct pcutils_ptrmap_entry *entry = pcutils_ptrmap_find(&gc->marks, v);
+    return entry && GC_MARK_COLOR(entry->val) == GC_WHITE;
+}
+
+static purc_variant_t
+pop_root(struct pcvariant_gc *gc)
+{
+    purc_variant_t v;
+    while (gc->roots.nr > 0) {
+        v = gc->roots.vals[--gc->roots.nr];
+        if (v) {
+            pcutils_ptrmap_erase(&gc->index, v);
+            v->flags &= ~PCVARIANT_FLAG_GC_BUFFERED;
+            return v;
+        }
+    }
+
+    return NULL;
+}
+
+static bool
+is_traced(purc_variant_t v)
+{
+    if (v->flags & (PCVARIANT_FLAG_NOFREE | PCVARIANT_FLAG_SHARED))
+        return false;
+
+    switch (v->type) {
+    case PURC_VARIANT_TYPE_ARRAY:
+    case PURC_VARIANT_TYPE_OBJECT:
+    case PURC_VARIANT_TYPE_SET:
+        return list_empty(&v->listeners) &&
+            !pcvar_container_belongs_to_set(v);
+    case PURC_VARIANT_TYPE_TUPLE:
+        return list_empty(&v->listeners);
+    default:
+        break;
+    }
+
+    return false;
+}
+
+typedef void (*child_visitor)(struct pcvariant_gc *gc, purc_variant_t child);
+
+static void
+visit_children(struct pcvariant_gc *gc, purc_variant_t v,
+        child_visitor visitor)
+{
+    purc_variant_t m;
+
+    switch (v->type) {
+    case PURC_VARIANT_TYPE_ARRAY:
+    {
+        size_t idx;
+        foreach_value_in_variant_array(v, m, idx) {
+            if (is_traced(m))
+                visitor(gc, m);
+        } end_foreach;
+        break;
+    }
+
+    case PURC_VARIANT_TYPE_OBJECT:
+        foreach_value_in_variant_object(v, m) {
+            if (is_traced(m))
+                visitor(gc, m);
+        } end_foreach;
+        break;
+
+    case PURC_VARIANT_TYPE_SET:
+        foreach_value_in_variant_set(v, m) {
+            if (is_traced(m))
+                visitor(gc, m);
+        } end_foreach;
+        break;
+
+    case PURC_VARIANT_TYPE_TUPLE:
+    {
+        size_t sz;
+        purc_variant_t *members = tuple_members(v, &sz);
+        for (size_t n = 0; n < sz; n++) {
+            if (members[n] && is_traced(members[n]))
+                visitor(gc, members[n]);
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+static void
+set_mark(struct pcvariant_gc *gc, purc_variant_t v, uintptr_t trc, int color)
+{
+    if (pcutils_ptrmap_set(&gc->marks, v, GC_MARK(trc, color)))
+        gc->failed = true;
+}
+
+static void
+mark_gray_child(struct pcvariant_gc *gc, purc_variant_t child)
+{
+    struct pcutils_ptrmap_entry *entry;
+    entry = pcutils_ptrmap_find(&gc->marks, child);
+    if (entry) {
+        uintptr_t trc = GC_MARK_TRC(entry->val);
+        if (trc > 0)
+            entry->val = GC_MARK(trc - 1, GC_MARK_COLOR(entry->val));
+        return;
+    }
+
+    set_mark(gc, child, child->refc - 1, GC_GRAY);
+    if (vector_push(&gc->stack, child))
+        gc->failed = true;
+}
+
+/* subtracts the references between the containers reachable from @root */
+static void
+mark_gray(struct pcvariant_gc *gc, purc_variant_t root)
+{
+    set_mark(gc, root, root->refc, GC_GRAY);
+    if (vector_push(&gc->stack, root))
+        gc->failed = true;
+
+    purc_variant_t v;
+    while ((v = vector_pop(&gc->stack)))
+        visit_children(gc, v, mark_gray_child);
+}
+
+static void
+scan_black_child(struct pcvariant_gc *gc, purc_variant_t child)
+{
+    struct pcutils_ptrmap_entry *entry;
+    entry = pcutils_ptrmap_find(&gc->marks, child);
+    PC_ASSERT(entry);
+
+    uintptr_t trc = GC_MARK_TRC(entry->val) + 1;
+    if (GC_MARK_COLOR(entry->val) != GC_BLACK) {
+        entry->val = GC_MARK(trc, GC_BLACK);
+        if (vector_push(&gc->stack_black, child))
+            gc->failed = true;
+    }
+    else {
+        entry->val = GC_MARK(trc, GC_BLACK);
+    }
+}
+
+/* restores the references from @v, which is referenced from outside */
+static void
+scan_black(struct pcvariant_gc *gc, purc_variant_t v)
+{
+    struct pcutils_ptrmap_entry *entry = pcutils_ptrmap_find(&gc->marks, v);
+    entry->val = GC_MARK(GC_MARK_TRC(entry->val), GC_BLACK);
+    if (vector_push(&gc->stack_black, v))
+        gc->failed = true;
+
+    while ((v = vector_pop(&gc->stack_black)))
+        visit_children(gc, v, scan_black_child);
+}
+
+static void
+scan_child(struct pcvariant_gc *gc, purc_variant_t child)
+{
+    struct pcutils_ptrmap_entry *entry;
+    entry = pcutils_ptrmap_find(&gc->marks, child);
+    if (entry && GC_MARK_COLOR(entry->val) == GC_GRAY) {
+        if (vector_push(&gc->stack, child))
+            gc->failed = true;
+    }
+}
+
+static void
+scan(struct pcvariant_gc *gc, purc_variant_t root)
+{
+    if (vector_push(&gc->stack, root))
+        gc->failed = true;
+
+    purc_variant_t v;
+    while ((v = vector_pop(&gc->stack))) {
+        struct pcutils_ptrmap_entry *entry;
+        entry = pcutils_ptrmap_find(&gc->marks, v);
+        if (GC_MARK_COLOR(entry->val) != GC_GRAY)
+            continue;
+
+        if (GC_MARK_TRC(entry->val) > 0) {
+            scan_black(gc, v);
+        }
+        else {
+            entry->val = GC_MARK(0, GC_WHITE);
+            visit_children(gc, v, scan_child);
+        }
+    }
+}
+
+static void
+collect_white_child(struct pcvariant_gc *gc, purc_variant_t child)
+{
+    struct pcutils_ptrmap_entry *entry;
+    entry = pcutils_ptrmap_find(&gc->marks, child);
+    if (entry && GC_MARK_COLOR(entry->val) == GC_WHITE) {
+        entry->val = GC_MARK(0, GC_BLACK);
+        if (vector_push(&gc->whites, child))
+            gc->failed = true;
+        else if (vector_push(&gc->stack, child))
+            gc->failed = true;
+    }
+}
+
+static void
+collect_white(struct pcvariant_gc *gc, purc_variant_t root)
+{
+    struct pcutils_ptrmap_entry *entry;
+    entry = pcutils_ptrmap_find(&gc->marks, root);
+    if (GC_MARK_COLOR(entry->val) != GC_WHITE)
+        return;
+
+    entry->val = GC_MARK(0, GC_BLACK);
+    if (vector_push(&gc->whites, root) || vector_push(&gc->stack, root)) {
+        gc->failed = true;
+        return;
+    }
+
+    purc_variant_t v;
+    while ((v = vector_pop(&gc->stack)))
+        visit_children(gc, v, collect_white_child);
+}
+
+static void
+release_members(purc_variant_t v)
+{
+    switch (v->type) {
+    case PURC_VARIANT_TYPE_ARRAY:
+        pcvariant_array_release(v);
+        break;
+    case PURC_VARIANT_TYPE_OBJECT:
+        pcvariant_object_release(v);
+        break;
+    case PURC_VARIANT_TYPE_SET:
+        pcvariant_set_release(v);
+        break;
+    case PURC_VARIANT_TYPE_TUPLE:
+        pcvariant_tuple_release(v);
+        break;
+    default:
+        break;
+    }
+}
+
+/* releases the containers referenced only by each other */
+static void
+release_whites(struct pcvariant_gc *gc)
+{
+    /* hold the containers until all of them are emptied */
+    for (size_t i = 0; i < gc->whites.nr; i++) {
+        purc_variant_t v = gc->whites.vals[i];
+        v->refc++;
+        if (v->flags & PCVARIANT_FLAG_GC_BUFFERED)
+            pcvariant_gc_forget(v);
+        /* marked black when collected; see pcvariant_gc_is_releasing() */
+        pcutils_ptrmap_set(&gc->marks, v, GC_MARK(0, GC_WHITE));
+    }
+
+    gc->releasing = true;
+    for (size_t i = 0; i < gc->whites.nr; i++)
+        release_members(gc->whites.vals[i]);
+    gc->releasing = false;
+
+    for (size_t i = 0; i < gc->whites.nr; i++) {
+        purc_variant_t v = gc->whites.vals[i];
+        PC_ASSERT(v->refc == 1);
+        v->refc = 0;
+        pcvariant_put(v);
+    }
+}
+
+/* returns the number of the containers collected from @root */
+static size_t
+collect_from(struct pcvariant_gc *gc, purc_variant_t root)
+{
+    gc->failed = false;
+    gc->stack.nr = 0;
+    gc->stack_black.nr = 0;
+    gc->whites.nr = 0;
+
+    mark_gray(gc, root);
+    if (!gc->failed)
+        scan(gc, root);
+    if (!gc->failed)
+        collect_white(gc, root);
+
+    if (gc->failed) {
+        pcutils_ptrmap_clear(&gc->marks);
+        return 0;
+    }
+
+    /* the marks tell the whites while releasing them */
+    release_whites(gc);
+    pcutils_ptrmap_clear(&gc->marks);
+    return gc->whites.nr;
+}
+
+static double
+elapsed_us(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1.0E6 +
+        (now.tv_nsec - start->tv_nsec) / 1.0E3;
+}
+
+static size_t
+collect(struct pcvariant_gc *gc, struct pcvariant_heap *heap,
+        unsigned int budget_us)
+{
+    if (gc->collecting)
+        return 0;
+
+    struct purc_variant_stat *stat = &heap->stat;
+    size_t sz_before = stat->sz_total_mem;
+    size_t nr_collected = 0;
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    gc->collecting = true;
+    purc_variant_t root;
+    while ((root = pop_root(gc))) {
+        stat->nr_gc_roots--;
+        if (is_traced(root))
+            nr_collected += collect_from(gc, root);
+
+        if (budget_us && elapsed_us(&start) >= budget_us)
+            break;
+    }
+    gc->collecting = false;
+
+    size_t reclaimed = 0;
+    if (nr_collected) {
+        if (sz_before > stat->sz_total_mem)
+            reclaimed = sz_before - stat->sz_total_mem;
+        stat->nr_gc_collected += nr_collected;
+        stat->sz_gc_reclaimed += reclaimed;
+    }
+
+    return reclaimed;
+}
+
+bool
+pcvariant_gc_has_roots(void)
+{
+    struct pcvariant_heap *heap;
+    struct pcvariant_gc *gc = current_gc(&heap);
+    return gc && pcutils_ptrmap_size(&gc->index) > 0;
+}
+
+size_t
+pcvariant_gc_collect_on_idle(void)
+{
+    struct pcvariant_heap *heap;
+    struct pcvariant_gc *gc = current_gc(&heap);
+    if (gc == NULL || gc->roots.nr == 0 ||
+            pcinst_current()->variant_heap != heap)
+        return 0;
+
+    return collect(gc, heap, gc->budget_us);
+}
+
+size_t
+purc_variant_collect_cycles(unsigned int budget_us)
+{
+    struct pcvariant_heap *heap;
+    struct pcvariant_gc *gc = current_gc(&heap);
+    if (gc == NULL || pcinst_current()->variant_heap != heap)
+        return 0;
+
+    return collect(gc, heap, budget_us);
+}
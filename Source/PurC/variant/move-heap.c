@@ -65,6 +65,11 @@ static void mvheap_cleanup_once(void)
 
     PC_ASSERT(stat->nr_total_values == 4);
     PC_ASSERT(stat->sz_total_mem == 4 * sizeof(purc_variant));
+
+    if (move_heap.slab) {
+        pcvariant_slab_destroy(move_heap.slab);
+        move_heap.slab = NULL;
+    }
 }
 
 static int mvheap_init_once(void)
@@ -107,9 +112,13 @@ static int mvheap_init_once(void)
     INIT_LIST_HEAD(&move_heap.v_reserved);
 #endif
 
+    move_heap.slab = pcvariant_slab_create();
+    if (move_heap.slab == NULL)
+        return -1;
+
     purc_mutex_init(&mh_lock);
     if (mh_lock.native_impl == NULL)
-        return -1;
+        goto fail_mutex;
 
     int r;
     r = atexit(mvheap_cleanup_once);
@@ -121,10 +130,14 @@ static int mvheap_init_once(void)
 fail_atexit:
     purc_mutex_clear(&mh_lock);
 
+fail_mutex:
+    pcvariant_slab_destroy(move_heap.slab);
+    move_heap.slab = NULL;
     return -1;
 }
 
 struct pcmodule _module_mvheap = {
+    .name            = "move-heap",
     .id              = PURC_HAVE_VARIANT,
     .module_inited   = 0,
 
@@ -132,602 +145,323 @@ struct pcmodule _module_mvheap = {
     .init_instance   = NULL,
 };
 
-static void
-move_variant_in(struct pcinst *inst, purc_variant_t v)
-{
-    /* move directly and change the stat info */
+/*
+ * Moving a variant tree is done in two phases. First, the tree is made
+ * exclusively owned and its bookkeeping is transferred in the heap of
+ * the current instance, without the lock of the move heap: the shared
+ * members are replaced with clones made in the heap of the instance
+ * (the slab of the instance takes the chunks back when they are freed
+ * by another thread), and the statistics to transfer are recorded in
+ * the move context. Then the recorded deltas are applied to the move
+ * heap with the lock held, which takes a constant time.
+ */
 
-    if (IS_CONTAINER(v->type) ||
-            ((v->type == PURC_VARIANT_TYPE_STRING ||
-                v->type == PURC_VARIANT_TYPE_BSEQUENCE) &&
-            (v->flags & PCVARIANT_FLAG_EXTRA_SIZE))) {
-        inst->org_vrt_heap->stat.sz_mem[v->type] -= v->sz_ptr[0];
-        inst->org_vrt_heap->stat.sz_total_mem -= v->sz_ptr[0];
+enum {
+    MOVE_CONST_UNDEFINED = 0,
+    MOVE_CONST_NULL,
+    MOVE_CONST_FALSE,
+    MOVE_CONST_TRUE,
+    MOVE_NR_CONSTS,
+};
 
-        move_heap.stat.sz_mem[v->type] += v->sz_ptr[0];
-        move_heap.stat.sz_total_mem += v->sz_ptr[0];
-    }
+struct move_context {
+    struct pcinst *inst;
+    struct pcutils_arrlist *vrts_to_unref;
 
-    inst->org_vrt_heap->stat.nr_values[v->type]--;
-    inst->org_vrt_heap->stat.nr_total_values--;
-    move_heap.stat.nr_values[v->type]++;
-    move_heap.stat.nr_total_values++;
+    /* the statistics to transfer to or from the move heap */
+    size_t nr_values[PURC_VARIANT_TYPE_NR];
+    size_t sz_mem[PURC_VARIANT_TYPE_NR];
+    size_t nr_total_values;
+    size_t sz_total_mem;
 
-    inst->org_vrt_heap->stat.sz_mem[v->type] -= sizeof(purc_variant);
-    inst->org_vrt_heap->stat.sz_total_mem -= sizeof(purc_variant);
-    move_heap.stat.sz_mem[v->type] += sizeof(purc_variant);
-    move_heap.stat.sz_total_mem += sizeof(purc_variant);
-}
+    /* the references to the constants of the move heap to add or drop */
+    unsigned int nr_consts[MOVE_NR_CONSTS];
+};
 
 static purc_variant_t
-move_or_clone_immutable(struct pcinst *inst, purc_variant_t v)
+heap_const(struct pcvariant_heap *heap, int c)
 {
-    purc_variant_t retv = PURC_VARIANT_INVALID;
-
-    if (IS_CONTAINER(v->type))
-        return retv;
-
-    if (v == &inst->org_vrt_heap->v_undefined) {
-        retv = &move_heap.v_undefined;
-        v->refc--;
-        retv->refc++;
-    }
-    else if (v == &inst->org_vrt_heap->v_null) {
-        retv = &move_heap.v_null;
-        v->refc--;
-        retv->refc++;
-    }
-    else if (v == &inst->org_vrt_heap->v_false) {
-        retv = &move_heap.v_false;
-        v->refc--;
-        retv->refc++;
-    }
-    else if (v == &inst->org_vrt_heap->v_true) {
-        retv = &move_heap.v_true;
-        v->refc--;
-        retv->refc++;
-    }
-    else if (v->refc == 1) {
-        PC_DEBUG("Move in variant type %s (%u): %s\n",
-                purc_variant_typename(v->type),
-                (unsigned)move_heap.stat.nr_values[v->type],
-                purc_variant_get_string_const(v));
-
-        retv = v;
-        move_variant_in(inst, v);
-    }
-    else {
-        // clone the immutable variant
-        PC_DEBUG("Clone a variant type %s (%u): %s\n",
-                purc_variant_typename(v->type),
-                (unsigned)move_heap.stat.nr_values[v->type],
-                purc_variant_get_string_const(v));
-
-        retv = pcvariant_alloc();
-        memcpy(retv, v, sizeof(*retv));
-        retv->refc = 1;
-
-        /* copy the extra space */
-        if ((v->type == PURC_VARIANT_TYPE_STRING ||
-                v->type == PURC_VARIANT_TYPE_BSEQUENCE) &&
-                (v->flags & PCVARIANT_FLAG_EXTRA_SIZE)) {
-
-            retv->sz_ptr[1] = (uintptr_t)malloc(v->sz_ptr[0]);
-            memcpy((void *)retv->sz_ptr[1], (void *)v->sz_ptr[1], v->sz_ptr[0]);
-
-            move_heap.stat.sz_mem[v->type] += v->sz_ptr[0];
-            move_heap.stat.sz_total_mem += v->sz_ptr[0];
-        }
-
-        move_heap.stat.nr_values[v->type]++;
-        move_heap.stat.nr_total_values++;
-        move_heap.stat.sz_mem[v->type] += sizeof(purc_variant);
-        move_heap.stat.sz_total_mem += sizeof(purc_variant);
+    switch (c) {
+    case MOVE_CONST_UNDEFINED:
+        return &heap->v_undefined;
+    case MOVE_CONST_NULL:
+        return &heap->v_null;
+    case MOVE_CONST_FALSE:
+        return &heap->v_false;
+    default:
+        return &heap->v_true;
     }
-
-    return retv;
 }
 
-struct travel_context {
-    struct pcinst *inst;
-    struct pcutils_arrlist *vrts_to_unref;
-};
-
-static bool
-move_keys_in_cloned_array(struct travel_context *ctxt, purc_variant_t arr);
-static bool
-move_keys_in_cloned_object(struct travel_context *ctxt, purc_variant_t arr);
-static bool
-move_keys_in_cloned_set(struct travel_context *ctxt, purc_variant_t arr);
-
-static bool
-move_keys_in_cloned_array(struct travel_context *ctxt, purc_variant_t arr)
-{
-    size_t idx;
-    purc_variant_t v;
-    foreach_value_in_variant_array(arr, v, idx) {
-        UNUSED_PARAM(idx);
-
-        switch (v->type) {
-        case PURC_VARIANT_TYPE_ARRAY:
-            move_keys_in_cloned_array(ctxt, v);
-            break;
-
-        case PURC_VARIANT_TYPE_OBJECT:
-            move_keys_in_cloned_array(ctxt, v);
-            break;
-
-        case PURC_VARIANT_TYPE_SET:
-            move_keys_in_cloned_set(ctxt, v);
-            break;
-
-        default:
-            // immutable element
-            break;
-        }
-
-    } end_foreach;
-
-    return true;
-}
-
-static bool
-move_keys_in_cloned_object(struct travel_context *ctxt, purc_variant_t obj)
+static int
+const_index(struct pcvariant_heap *heap, purc_variant_t v)
 {
-    purc_variant_t k,v;
-    foreach_key_value_in_variant_object(obj, k, v) {
-
-        if (IS_CONTAINER(v->type)) {
-            PC_DEBUG("Move in a key %s (%u): %s\n",
-                    purc_variant_typename(k->type),
-                    (unsigned)move_heap.stat.nr_values[k->type],
-                    purc_variant_get_string_const(k));
-        }
-
-        switch (v->type) {
-        case PURC_VARIANT_TYPE_ARRAY:
-            move_variant_in(ctxt->inst, k);
-            move_keys_in_cloned_array(ctxt, v);
-            break;
-
-        case PURC_VARIANT_TYPE_OBJECT:
-            move_variant_in(ctxt->inst, k);
-            move_keys_in_cloned_object(ctxt, v);
-            break;
-
-        case PURC_VARIANT_TYPE_SET:
-            move_variant_in(ctxt->inst, k);
-            move_keys_in_cloned_set(ctxt, v);
-            break;
-
-        default:
-            break;
-        }
-
-    } end_foreach;
+    for (int c = 0; c < MOVE_NR_CONSTS; c++) {
+        if (v == heap_const(heap, c))
+            return c;
+    }
 
-    return true;
+    return -1;
 }
 
-static bool
-move_keys_in_cloned_set(struct travel_context *ctxt, purc_variant_t set)
+static size_t
+variant_mem_size(purc_variant_t v)
 {
-    purc_variant_t v;
-    foreach_value_in_variant_set(set, v) {
-
-        switch (v->type) {
-        case PURC_VARIANT_TYPE_ARRAY:
-            move_keys_in_cloned_array(ctxt, v);
-            break;
-
-        case PURC_VARIANT_TYPE_OBJECT:
-            move_keys_in_cloned_object(ctxt, v);
-            break;
-
-        case PURC_VARIANT_TYPE_SET:
-            move_keys_in_cloned_set(ctxt, v);
-            break;
-
-        default:
-            // immutable element
-            break;
-        }
-
-    } end_foreach;
-
-    return true;
+    size_t sz = sizeof(purc_variant);
+    if (IS_CONTAINER(v->type) ||
+            ((v->type == PURC_VARIANT_TYPE_STRING ||
+                v->type == PURC_VARIANT_TYPE_BSEQUENCE) &&
+            (v->flags & PCVARIANT_FLAG_EXTRA_SIZE)))
+        sz += v->sz_ptr[0];
+    return sz;
 }
 
-static bool
-move_keys_in_cloned_container(struct travel_context *ctxt,
-        purc_variant_t cntr)
+/* transfer the bookkeeping of `v` between the instance and the context */
+static void
+account_variant(struct move_context *ctxt, purc_variant_t v, bool in)
 {
-    switch (cntr->type) {
-        case PURC_VARIANT_TYPE_ARRAY:
-            move_keys_in_cloned_array(ctxt, cntr);
-            break;
-
-        case PURC_VARIANT_TYPE_OBJECT:
-            move_keys_in_cloned_object(ctxt, cntr);
-            break;
-
-        case PURC_VARIANT_TYPE_SET:
-            move_keys_in_cloned_set(ctxt, cntr);
-            break;
-
-        default:
-            assert(0);
-            break;
+    struct purc_variant_stat *stat = &ctxt->inst->org_vrt_heap->stat;
+    size_t sz = variant_mem_size(v);
+
+    if (in) {
+        stat->nr_values[v->type]--;
+        stat->nr_total_values--;
+        stat->sz_mem[v->type] -= sz;
+        stat->sz_total_mem -= sz;
+    }
+    else {
+        stat->nr_values[v->type]++;
+        stat->nr_total_values++;
+        stat->sz_mem[v->type] += sz;
+        stat->sz_total_mem += sz;
     }
 
-    return true;
+    ctxt->nr_values[v->type]++;
+    ctxt->nr_total_values++;
+    ctxt->sz_mem[v->type] += sz;
+    ctxt->sz_total_mem += sz;
 }
 
-static bool
-move_or_clone_mutable_descendants_in_array(struct travel_context *ctxt,
-        purc_variant_t v);
-static bool
-move_or_clone_mutable_descendants_in_object(struct travel_context *ctxt,
-        purc_variant_t v);
-static bool
-move_or_clone_mutable_descendants_in_set(struct travel_context *ctxt,
-        purc_variant_t v);
-
-static bool
-move_or_clone_mutable_descendants_in_array(struct travel_context *ctxt,
-        purc_variant_t arr)
+/* clone an immutable variant in the heap of the current instance */
+static purc_variant_t
+clone_immutable(purc_variant_t v)
 {
-    size_t idx;
-    purc_variant_t v;
-    foreach_value_in_variant_array(arr, v, idx) {
-        purc_variant_t retv;
-
-        UNUSED_PARAM(idx);
-        switch (v->type) {
-        case PURC_VARIANT_TYPE_ARRAY:
-            if (v->refc == 1) {
-                move_variant_in(ctxt->inst, v);
-                move_or_clone_mutable_descendants_in_array(ctxt, v);
-            }
-            break;
-
-        case PURC_VARIANT_TYPE_OBJECT:
-            if (v->refc == 1) {
-                move_variant_in(ctxt->inst, v);
-                move_or_clone_mutable_descendants_in_object(ctxt, v);
-            }
-            break;
-
-        case PURC_VARIANT_TYPE_SET:
-            if (v->refc == 1) {
-                move_variant_in(ctxt->inst, v);
-                move_or_clone_mutable_descendants_in_set(ctxt, v);
-            }
-            break;
-
-        default:
-            // immutable element
-            break;
-        }
-
-        if (IS_CONTAINER(v->type) && v->refc > 1) {
-            retv = purc_variant_container_clone_recursively(v);
-            if (retv == PURC_VARIANT_INVALID) {
-                purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-                return false;
-            }
+    if (v->type == PURC_VARIANT_TYPE_TUPLE)
+        return pcvariant_tuple_clone(v, false);
 
-            move_keys_in_cloned_container(ctxt, retv);
+    purc_variant_t retv = pcvariant_alloc();
+    if (retv == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return PURC_VARIANT_INVALID;
+    }
 
-            _p->val = retv;
-            pcutils_arrlist_append(ctxt->vrts_to_unref, v);
+    memcpy(retv, v, sizeof(*retv));
+    retv->refc = 1;
+    INIT_LIST_HEAD(&retv->listeners);
+
+    /* copy the extra space */
+    if ((v->type == PURC_VARIANT_TYPE_STRING ||
+            v->type == PURC_VARIANT_TYPE_BSEQUENCE) &&
+            (v->flags & PCVARIANT_FLAG_EXTRA_SIZE)) {
+        void *extra = malloc(v->sz_ptr[0]);
+        if (extra == NULL) {
+            pcvariant_free(retv);
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return PURC_VARIANT_INVALID;
         }
 
-    } end_foreach;
+        memcpy(extra, (void *)v->sz_ptr[1], v->sz_ptr[0]);
+        retv->sz_ptr[1] = (uintptr_t)extra;
+    }
 
-    return true;
+    /* the clone is accounted in the heap of the instance until moved */
+    struct purc_variant_stat *stat = &pcinst_current()->variant_heap->stat;
+    size_t sz = variant_mem_size(retv);
+    stat->nr_values[v->type]++;
+    stat->nr_total_values++;
+    stat->sz_mem[v->type] += sz;
+    stat->sz_total_mem += sz;
+    return retv;
 }
 
-static bool
-move_or_clone_mutable_descendants_in_object(struct travel_context *ctxt,
-        purc_variant_t obj)
-{
-    purc_variant_t k,v;
-    foreach_key_value_in_variant_object(obj, k, v) {
-        purc_variant_t retk, retv;
-
-        PC_DEBUG("a key when handling mutable variant: %s (%u)\n",
-                purc_variant_get_string_const(k), (unsigned)v->refc);
-
-        switch (v->type) {
-        case PURC_VARIANT_TYPE_ARRAY:
-            if (v->refc == 1) {
-                move_variant_in(ctxt->inst, v);
-                move_or_clone_mutable_descendants_in_array(ctxt, v);
-            }
-            break;
-
-        case PURC_VARIANT_TYPE_OBJECT:
-            if (v->refc == 1) {
-                move_variant_in(ctxt->inst, v);
-                move_or_clone_mutable_descendants_in_object(ctxt, v);
-            }
-            break;
-
-        case PURC_VARIANT_TYPE_SET:
-            if (v->refc == 1) {
-                move_variant_in(ctxt->inst, v);
-                move_or_clone_mutable_descendants_in_set(ctxt, v);
-            }
-            break;
-
-        default:
-            // immutable element
-            break;
-        }
-
-        if (IS_CONTAINER(v->type)) {
-            retk = move_or_clone_immutable(ctxt->inst, k);
-            if (retk != k) {
-                _node->key = retk;
-                pcutils_arrlist_append(ctxt->vrts_to_unref, k);
-            }
-
-            if (v->refc > 1) {
-                retv = purc_variant_container_clone_recursively(v);
-                if (retv == PURC_VARIANT_INVALID) {
-                    purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-                    return false;
-                }
-
-                /* XXX: for cloned object, we need to move in the cloned keys,
-                 * cause purc_variant_container_clone_recursively() only
-                 * references the keys */
-                PC_DEBUG("a container cloned for key %s: %s (%u)\n",
-                        purc_variant_get_string_const(k),
-                        purc_variant_typename(retv->type),
-                        (unsigned)retv->refc);
-                move_keys_in_cloned_object(ctxt, retv);
-
-                _node->val = retv;
-                pcutils_arrlist_append(ctxt->vrts_to_unref, v);
-            }
-        }
-
-    } end_foreach;
-
-    return true;
-}
+static purc_variant_t
+move_in(struct move_context *ctxt, purc_variant_t v);
 
 static bool
-move_or_clone_mutable_descendants_in_set(struct travel_context *ctxt,
-        purc_variant_t set)
+move_members_in(struct move_context *ctxt, purc_variant_t v)
 {
-    purc_variant_t v;
-    foreach_value_in_variant_set(set, v) {
-        purc_variant_t retv;
-
-        switch (v->type) {
-        case PURC_VARIANT_TYPE_ARRAY:
-            if (v->refc == 1) {
-                move_variant_in(ctxt->inst, v);
-                move_or_clone_mutable_descendants_in_array(ctxt, v);
-            }
-            break;
-
-        case PURC_VARIANT_TYPE_OBJECT:
-            if (v->refc == 1) {
-                move_variant_in(ctxt->inst, v);
-                move_or_clone_mutable_descendants_in_object(ctxt, v);
-            }
-            break;
-
-        case PURC_VARIANT_TYPE_SET:
-            if (v->refc == 1) {
-                move_variant_in(ctxt->inst, v);
-                move_or_clone_mutable_descendants_in_set(ctxt, v);
-            }
-            break;
-
-        default:
-            // immutable element
-            break;
-        }
+    purc_variant_t retv;
 
-        if (IS_CONTAINER(v->type) && v->refc > 1) {
-            retv = purc_variant_container_clone_recursively(v);
-            if (retv == PURC_VARIANT_INVALID) {
-                purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    switch (v->type) {
+    case PURC_VARIANT_TYPE_ARRAY:
+    {
+        purc_variant_t m;
+        size_t idx;
+        foreach_value_in_variant_array(v, m, idx) {
+            if ((retv = move_in(ctxt, m)) == PURC_VARIANT_INVALID)
                 return false;
-            }
+            _data->vals[idx] = retv;
+        } end_foreach;
+        break;
+    }
 
-            move_keys_in_cloned_container(ctxt, retv);
+    case PURC_VARIANT_TYPE_OBJECT:
+    {
+        purc_variant_t k, m;
+        foreach_key_value_in_variant_object(v, k, m) {
+            if ((retv = move_in(ctxt, k)) == PURC_VARIANT_INVALID)
+                return false;
+            _node->key = retv;
+            if ((retv = move_in(ctxt, m)) == PURC_VARIANT_INVALID)
+                return false;
+            _node->val = retv;
+        } end_foreach;
+        break;
+    }
 
+    case PURC_VARIANT_TYPE_SET:
+    {
+        purc_variant_t m;
+        foreach_value_in_variant_set(v, m) {
+            if ((retv = move_in(ctxt, m)) == PURC_VARIANT_INVALID)
+                return false;
             _sn->val = retv;
-            pcutils_arrlist_append(ctxt->vrts_to_unref, v);
+        } end_foreach;
+        break;
+    }
+
+    case PURC_VARIANT_TYPE_TUPLE:
+    {
+        size_t sz;
+        purc_variant_t *members = tuple_members(v, &sz);
+        for (size_t n = 0; n < sz; n++) {
+            if ((retv = move_in(ctxt, members[n])) == PURC_VARIANT_INVALID)
+                return false;
+            members[n] = retv;
         }
+        break;
+    }
 
-    } end_foreach;
+    default:
+        break;
+    }
 
     return true;
 }
 
-static bool
-move_or_clone_mutable_descendants(struct travel_context *ctxt,
-        purc_variant_t v)
+/*
+ * Returns the variant to hold in place of `v`, which is held only by the
+ * moved tree. The reference to `v` held by the tree is dropped after the
+ * move if `v` is replaced.
+ */
+static purc_variant_t
+move_in(struct move_context *ctxt, purc_variant_t v)
 {
-    switch (v->type) {
-        case PURC_VARIANT_TYPE_ARRAY:
-            return move_or_clone_mutable_descendants_in_array(ctxt, v);
-        case PURC_VARIANT_TYPE_OBJECT:
-            return move_or_clone_mutable_descendants_in_object(ctxt, v);
-        case PURC_VARIANT_TYPE_SET:
-            return move_or_clone_mutable_descendants_in_set(ctxt, v);
-        default:
-            break;
+    int c = const_index(ctxt->inst->org_vrt_heap, v);
+    if (c >= 0) {
+        v->refc--;
+        ctxt->nr_consts[c]++;
+        return heap_const(&move_heap, c);
     }
 
-    return true;
-}
+    /* a shared dataset lives in the move heap already */
+    if (pcvariant_is_shared(v))
+        return v;
 
-static bool
-move_or_clone_immutable_descendants_in_array(struct travel_context *ctxt,
-        purc_variant_t v);
-static bool
-move_or_clone_immutable_descendants_in_object(struct travel_context *ctxt,
-        purc_variant_t v);
-static bool
-move_or_clone_immutable_descendants_in_set(struct travel_context *ctxt,
-        purc_variant_t v);
-
-static bool
-move_or_clone_immutable_descendants_in_array(struct travel_context *ctxt,
-        purc_variant_t arr)
-{
-    size_t idx;
-    purc_variant_t v;
-    foreach_value_in_variant_array(arr, v, idx) {
-        purc_variant_t retv;
-
-        UNUSED_PARAM(idx);
-        switch (v->type) {
-        case PURC_VARIANT_TYPE_ARRAY:
-            move_or_clone_immutable_descendants_in_array(ctxt, v);
-            retv = v;
-            break;
-
-        case PURC_VARIANT_TYPE_OBJECT:
-            move_or_clone_immutable_descendants_in_object(ctxt, v);
-            retv = v;
-            break;
-
-        case PURC_VARIANT_TYPE_SET:
-            move_or_clone_immutable_descendants_in_set(ctxt, v);
-            retv = v;
-            break;
-
-        default:
-            retv = move_or_clone_immutable(ctxt->inst, v);
-            if (retv == PURC_VARIANT_INVALID) {
-                purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-                return false;
-            }
-            break;
-        }
+    purc_variant_t retv = v;
+    if (v->refc > 1) {
+        PC_DEBUG("Clone a variant type %s when moving it in\n",
+                purc_variant_typename(v->type));
+
+        /* the members of a shallow clone are cloned when moving them in */
+        if (IS_CONTAINER(v->type))
+            retv = pcvariant_container_clone(v, false);
+        else
+            retv = clone_immutable(v);
+        if (retv == PURC_VARIANT_INVALID)
+            return PURC_VARIANT_INVALID;
+
+        pcutils_arrlist_append(ctxt->vrts_to_unref, v);
+    }
 
-        if (retv != v) {
-            _p->val = retv;
-            if (!(v->flags & PCVARIANT_FLAG_NOFREE))
-                pcutils_arrlist_append(ctxt->vrts_to_unref, v);
-        }
+    /* the variant moved is no longer a root of this instance */
+    if (retv->flags & PCVARIANT_FLAG_GC_BUFFERED)
+        pcvariant_gc_forget(retv);
 
-    } end_foreach;
+    if (!move_members_in(ctxt, retv))
+        return PURC_VARIANT_INVALID;
 
-    return true;
+    account_variant(ctxt, retv, true);
+    return retv;
 }
 
-static bool
-move_or_clone_immutable_descendants_in_object(struct travel_context *ctxt,
-        purc_variant_t obj)
-{
-    purc_variant_t k,v;
-    foreach_key_value_in_variant_object(obj, k, v) {
-        purc_variant_t retk, retv;
-
-        switch (v->type) {
-        case PURC_VARIANT_TYPE_ARRAY:
-            move_or_clone_immutable_descendants_in_array(ctxt, v);
-            break;
-
-        case PURC_VARIANT_TYPE_OBJECT:
-            move_or_clone_immutable_descendants_in_object(ctxt, v);
-            break;
-
-        case PURC_VARIANT_TYPE_SET:
-            move_or_clone_immutable_descendants_in_set(ctxt, v);
-            break;
-
-        default:
-            retk = move_or_clone_immutable(ctxt->inst, k);
-            if (retk != k) {
-                _node->key = retk;
-                pcutils_arrlist_append(ctxt->vrts_to_unref, k);
-            }
-
-            retv = move_or_clone_immutable(ctxt->inst, v);
-            if (retv != v) {
-                _node->val = retv;
-                if (!(v->flags & PCVARIANT_FLAG_NOFREE))
-                    pcutils_arrlist_append(ctxt->vrts_to_unref, v);
-            }
-            break;
-        }
+static void
+move_out(struct move_context *ctxt, purc_variant_t v, purc_variant_t *slot);
 
-    } end_foreach;
+static void
+move_members_out(struct move_context *ctxt, purc_variant_t v)
+{
+    switch (v->type) {
+    case PURC_VARIANT_TYPE_ARRAY:
+    {
+        purc_variant_t m;
+        size_t idx;
+        foreach_value_in_variant_array(v, m, idx) {
+            move_out(ctxt, m, _data->vals + idx);
+        } end_foreach;
+        break;
+    }
 
-    return true;
-}
+    case PURC_VARIANT_TYPE_OBJECT:
+    {
+        purc_variant_t k, m;
+        foreach_key_value_in_variant_object(v, k, m) {
+            move_out(ctxt, k, &_node->key);
+            move_out(ctxt, m, &_node->val);
+        } end_foreach;
+        break;
+    }
 
-static bool
-move_or_clone_immutable_descendants_in_set(struct travel_context *ctxt,
-        purc_variant_t set)
-{
-    purc_variant_t v;
-    foreach_value_in_variant_set(set, v) {
-        purc_variant_t retv;
-
-        switch (v->type) {
-        case PURC_VARIANT_TYPE_ARRAY:
-            move_or_clone_immutable_descendants_in_array(ctxt, v);
-            retv = v;
-            break;
-
-        case PURC_VARIANT_TYPE_OBJECT:
-            move_or_clone_immutable_descendants_in_object(ctxt, v);
-            retv = v;
-            break;
-
-        case PURC_VARIANT_TYPE_SET:
-            move_or_clone_immutable_descendants_in_set(ctxt, v);
-            retv = v;
-            break;
-
-        default:
-            retv = move_or_clone_immutable(ctxt->inst, v);
-            if (retv == PURC_VARIANT_INVALID) {
-                purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-                return false;
-            }
-            break;
-        }
+    case PURC_VARIANT_TYPE_SET:
+    {
+        purc_variant_t m;
+        foreach_value_in_variant_set(v, m) {
+            move_out(ctxt, m, &_sn->val);
+        } end_foreach;
+        break;
+    }
 
-        if (retv != v) {
-            _sn->val = retv;
-            if (!(v->flags & PCVARIANT_FLAG_NOFREE))
-                pcutils_arrlist_append(ctxt->vrts_to_unref, v);
+    case PURC_VARIANT_TYPE_TUPLE:
+    {
+        size_t sz;
+        purc_variant_t *members = tuple_members(v, &sz);
+        for (size_t n = 0; n < sz; n++) {
+            move_out(ctxt, members[n], members + n);
         }
+        break;
+    }
 
-    } end_foreach;
-
-    return true;
+    default:
+        break;
+    }
 }
 
-static bool
-move_or_clone_immutable_descendants(struct travel_context *ctxt,
-        purc_variant_t v)
+static void
+move_out(struct move_context *ctxt, purc_variant_t v, purc_variant_t *slot)
 {
-    switch (v->type) {
-        case PURC_VARIANT_TYPE_ARRAY:
-            return move_or_clone_immutable_descendants_in_array(ctxt, v);
-        case PURC_VARIANT_TYPE_OBJECT:
-            return move_or_clone_immutable_descendants_in_object(ctxt, v);
-        case PURC_VARIANT_TYPE_SET:
-            return move_or_clone_immutable_descendants_in_set(ctxt, v);
-        default:
-            break;
+    int c = const_index(&move_heap, v);
+    if (c >= 0) {
+        *slot = heap_const(ctxt->inst->org_vrt_heap, c);
+        (*slot)->refc++;
+        ctxt->nr_consts[c]++;
+        return;
     }
 
-    return true;
+    if (pcvariant_is_shared(v))
+        return;
+
+    move_members_out(ctxt, v);
+    account_variant(ctxt, v, false);
 }
 
 static void cb_free_element(void *data)
@@ -738,275 +472,61 @@ static void cb_free_element(void *data)
 // move the variant from the current instance to the move heap.
 purc_variant_t pcvariant_move_heap_in(purc_variant_t v)
 {
-    purc_variant_t retv = PURC_VARIANT_INVALID;
-    struct pcinst *inst = pcinst_current();
-    struct travel_context ctxt;
+    struct move_context ctxt;
 
+    memset(&ctxt, 0, sizeof(ctxt));
     ctxt.inst = pcinst_current();
     ctxt.vrts_to_unref = pcutils_arrlist_new(cb_free_element);
     if (ctxt.vrts_to_unref == NULL) {
         purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-        return retv;
+        return PURC_VARIANT_INVALID;
     }
 
-    pcvariant_use_move_heap();
-
-    if (IS_CONTAINER(v->type)) {
-        if (v->refc == 1) {
-            retv = v;
-            move_variant_in(inst, v);
-            move_or_clone_mutable_descendants(&ctxt, v);
-
-        }
-        else {
-            retv = purc_variant_container_clone_recursively(v);
-
-            /* XXX: for cloned container, we need to move in the cloned keys
-             * of descendant objects,
-             * cause purc_variant_container_clone_recursively() only
-             * references the keys */
-            move_keys_in_cloned_container(&ctxt, retv);
-        }
+    purc_variant_t retv = move_in(&ctxt, v);
 
-        move_or_clone_immutable_descendants(&ctxt, retv);
-    }
-    else {
-        retv = move_or_clone_immutable(inst, v);
+    purc_mutex_lock(&mh_lock);
+    for (int t = 0; t < PURC_VARIANT_TYPE_NR; t++) {
+        move_heap.stat.nr_values[t] += ctxt.nr_values[t];
+        move_heap.stat.sz_mem[t] += ctxt.sz_mem[t];
     }
+    move_heap.stat.nr_total_values += ctxt.nr_total_values;
+    move_heap.stat.sz_total_mem += ctxt.sz_total_mem;
 
-    pcvariant_use_norm_heap();
-
-    if (retv != PURC_VARIANT_INVALID && retv != v &&
-            !(v->flags & PCVARIANT_FLAG_NOFREE)) {
-        purc_variant_unref(v);
+    for (int c = 0; c < MOVE_NR_CONSTS; c++) {
+        heap_const(&move_heap, c)->refc += ctxt.nr_consts[c];
     }
+    purc_mutex_unlock(&mh_lock);
 
-    // the cloned immutable descendants will be unreferenced in cb_free_element
+    // the replaced variants are unreferenced in cb_free_element
     pcutils_arrlist_free(ctxt.vrts_to_unref);
 
     return retv;
 }
 
 // move the variant from the move heap to the current instance.
-// we only need to update the stat information.
-static void move_container_self_out(purc_variant_t v)
-{
-    struct pcinst *inst = pcinst_current();
-
-    inst->org_vrt_heap->stat.sz_mem[v->type] += v->sz_ptr[0];
-    inst->org_vrt_heap->stat.sz_total_mem += v->sz_ptr[0];
-
-    move_heap.stat.sz_mem[v->type] -= v->sz_ptr[0];
-    move_heap.stat.sz_total_mem -= v->sz_ptr[0];
-
-    inst->org_vrt_heap->stat.nr_values[v->type]++;
-    inst->org_vrt_heap->stat.nr_total_values++;
-
-    move_heap.stat.nr_values[v->type]--;
-    move_heap.stat.nr_total_values--;
-
-    inst->org_vrt_heap->stat.sz_mem[v->type] += sizeof(purc_variant);
-    inst->org_vrt_heap->stat.sz_total_mem += sizeof(purc_variant);
-    move_heap.stat.sz_mem[v->type] -= sizeof(purc_variant);
-    move_heap.stat.sz_total_mem -= sizeof(purc_variant);
-}
-
-static purc_variant_t move_variant_out(purc_variant_t v);
-static purc_variant_t move_array_descendants_out(purc_variant_t v);
-static purc_variant_t move_object_descendants_out(purc_variant_t v);
-static purc_variant_t move_set_descendants_out(purc_variant_t v);
-
-static purc_variant_t move_array_descendants_out(purc_variant_t arr)
-{
-    size_t idx;
-    purc_variant_t v;
-
-    foreach_value_in_variant_array(arr, v, idx) {
-        purc_variant_t retv;
-
-        UNUSED_PARAM(idx);
-        switch (v->type) {
-        case PURC_VARIANT_TYPE_ARRAY:
-            retv = move_array_descendants_out(v);
-            move_container_self_out(retv);
-            break;
-
-        case PURC_VARIANT_TYPE_OBJECT:
-            retv = move_object_descendants_out(v);
-            move_container_self_out(retv);
-            break;
-
-        case PURC_VARIANT_TYPE_SET:
-            retv = move_set_descendants_out(v);
-            move_container_self_out(retv);
-            break;
-
-        default:
-            retv = move_variant_out(v);
-            break;
-        }
-
-        _p->val = retv;
-
-    } end_foreach;
-
-    return arr;
-}
-
-static purc_variant_t move_object_descendants_out(purc_variant_t obj)
-{
-    purc_variant_t k,v;
-    foreach_key_value_in_variant_object(obj, k, v) {
-        purc_variant_t retk, retv;
-
-        retk = move_variant_out(k);
-        switch (v->type) {
-        case PURC_VARIANT_TYPE_ARRAY:
-            retv = move_array_descendants_out(v);
-            move_container_self_out(retv);
-            break;
-
-        case PURC_VARIANT_TYPE_OBJECT:
-            retv = move_object_descendants_out(v);
-            move_container_self_out(retv);
-            break;
-
-        case PURC_VARIANT_TYPE_SET:
-            retv = move_set_descendants_out(v);
-            move_container_self_out(retv);
-            break;
-
-        default:
-            retv = move_variant_out(v);
-            break;
-        }
-
-        _node->key = retk;
-        _node->val = retv;
-
-    } end_foreach;
-
-    return obj;
-}
-
-static purc_variant_t move_set_descendants_out(purc_variant_t set)
+purc_variant_t pcvariant_move_heap_out(purc_variant_t v)
 {
-    purc_variant_t v;
-    foreach_value_in_variant_set(set, v) {
-        purc_variant_t retv;
-
-        switch (v->type) {
-        case PURC_VARIANT_TYPE_ARRAY:
-            retv = move_array_descendants_out(v);
-            move_container_self_out(retv);
-            break;
-
-        case PURC_VARIANT_TYPE_OBJECT:
-            retv = move_object_descendants_out(v);
-            move_container_self_out(retv);
-            break;
-
-        case PURC_VARIANT_TYPE_SET:
-            retv = move_set_descendants_out(v);
-            move_container_self_out(retv);
-            break;
-
-        default:
-            retv = move_variant_out(v);
-            break;
-        }
+    struct move_context ctxt;
 
-        _sn->val = retv;
-    } end_foreach;
-
-    return set;
-}
+    memset(&ctxt, 0, sizeof(ctxt));
+    ctxt.inst = pcinst_current();
 
-static purc_variant_t move_variant_out(purc_variant_t v)
-{
     purc_variant_t retv = v;
-    struct pcinst *inst = pcinst_current();
+    move_out(&ctxt, v, &retv);
 
-    if (v == &move_heap.v_undefined) {
-        retv = &inst->org_vrt_heap->v_undefined;
-        v->refc--;
-        retv->refc++;
-        return retv;
-    }
-    else if (v == &move_heap.v_null) {
-        retv = &inst->org_vrt_heap->v_null;
-        v->refc--;
-        retv->refc++;
-        return retv;
-    }
-    else if (v == &move_heap.v_false) {
-        retv = &inst->org_vrt_heap->v_false;
-        v->refc--;
-        retv->refc++;
-        return retv;
-    }
-    else if (v == &move_heap.v_true) {
-        retv = &inst->org_vrt_heap->v_true;
-        v->refc--;
-        retv->refc++;
-        return retv;
-    }
-    else if ((v->type == PURC_VARIANT_TYPE_STRING ||
-                  v->type == PURC_VARIANT_TYPE_BSEQUENCE) &&
-                 (v->flags & PCVARIANT_FLAG_EXTRA_SIZE)) {
-        inst->org_vrt_heap->stat.sz_mem[v->type] += v->sz_ptr[0];
-        inst->org_vrt_heap->stat.sz_total_mem += v->sz_ptr[0];
-
-        move_heap.stat.sz_mem[v->type] -= v->sz_ptr[0];
-        move_heap.stat.sz_total_mem -= v->sz_ptr[0];
+    purc_mutex_lock(&mh_lock);
+    for (int t = 0; t < PURC_VARIANT_TYPE_NR; t++) {
+        PC_ASSERT(move_heap.stat.nr_values[t] >= ctxt.nr_values[t]);
+        move_heap.stat.nr_values[t] -= ctxt.nr_values[t];
+        move_heap.stat.sz_mem[t] -= ctxt.sz_mem[t];
     }
-    else if (IS_CONTAINER(v->type)) {
-        inst->org_vrt_heap->stat.sz_mem[v->type] += v->sz_ptr[0];
-        inst->org_vrt_heap->stat.sz_total_mem += v->sz_ptr[0];
+    move_heap.stat.nr_total_values -= ctxt.nr_total_values;
+    move_heap.stat.sz_total_mem -= ctxt.sz_total_mem;
 
-        move_heap.stat.sz_mem[v->type] -= v->sz_ptr[0];
-        move_heap.stat.sz_total_mem -= v->sz_ptr[0];
-
-        if (v->type == PURC_VARIANT_TYPE_ARRAY) {
-            retv = move_array_descendants_out(v);
-        }
-        else if (v->type == PURC_VARIANT_TYPE_OBJECT) {
-            retv = move_object_descendants_out(v);
-        }
-        else if (v->type == PURC_VARIANT_TYPE_SET) {
-            retv = move_set_descendants_out(v);
-        }
+    for (int c = 0; c < MOVE_NR_CONSTS; c++) {
+        heap_const(&move_heap, c)->refc -= ctxt.nr_consts[c];
     }
-
-    inst->org_vrt_heap->stat.nr_values[v->type]++;
-    inst->org_vrt_heap->stat.nr_total_values++;
-
-    PC_DEBUG("Move out a variant type: %s (%u): %s\n",
-            purc_variant_typename(v->type),
-            (unsigned)move_heap.stat.nr_values[v->type],
-            purc_variant_get_string_const(v));
-
-    assert(move_heap.stat.nr_values[v->type] > 0);
-    assert(move_heap.stat.nr_total_values > 0);
-
-    move_heap.stat.nr_values[v->type]--;
-    move_heap.stat.nr_total_values--;
-
-    inst->org_vrt_heap->stat.sz_mem[v->type] += sizeof(purc_variant);
-    inst->org_vrt_heap->stat.sz_total_mem += sizeof(purc_variant);
-    move_heap.stat.sz_mem[v->type] -= sizeof(purc_variant);
-    move_heap.stat.sz_total_mem -= sizeof(purc_variant);
-
-    return retv;
-}
-
-purc_variant_t pcvariant_move_heap_out(purc_variant_t v)
-{
-    purc_variant_t retv = PURC_VARIANT_INVALID;
-
-    pcvariant_use_move_heap();
-    retv = move_variant_out(v);
-    pcvariant_use_norm_heap();
+    purc_mutex_unlock(&mh_lock);
 
     return retv;
 }
@@ -23,6 +23,7 @@
  */
 
 #include "variant-internals.h"
+#include "private/utils.h"
 
 static double
 _numberify_str(const char *s)
@@ -31,7 +32,7 @@ _numberify_str(const char *s)
     if (!*s)
         return 0.0;
 
-    return strtod(s, NULL);
+    return pcutils_strtod(s, NULL);
 }
 
 double
@@ -54,9 +54,25 @@ register_listener(purc_variant_t v, unsigned int flags,
         list_add_tail(&listener->list_node, listeners);
     }
 
+    v->flags |= (op << PCVARIANT_FLAG_LISTENED_SHIFT);
     return listener;
 }
 
+/* recalculate the operations listened after revoking a listener */
+static void
+refresh_listened_ops(purc_variant_t v)
+{
+    pcvar_op_t ops = 0;
+
+    struct pcvar_listener *p;
+    list_for_each_entry(p, &v->listeners, list_node) {
+        ops |= p->op;
+    }
+
+    v->flags &= ~PCVARIANT_FLAG_LISTENED_MASK;
+    v->flags |= (ops << PCVARIANT_FLAG_LISTENED_SHIFT);
+}
+
 struct pcvar_listener*
 purc_variant_register_pre_listener(purc_variant_t v,
         pcvar_op_t op, pcvar_op_handler handler, void *ctxt)
@@ -71,7 +87,8 @@ purc_variant_register_pre_listener(purc_variant_t v,
         return NULL;
     }
 
-    if (!IS_CONTAINER(v->type)) {
+    /* a shared dataset never changes */
+    if (!IS_CONTAINER(v->type) || pcvariant_is_shared(v)) {
         pcinst_set_error(PCVARIANT_ERROR_NOT_SUPPORTED);
         return NULL;
     }
@@ -93,7 +110,8 @@ purc_variant_register_post_listener(purc_variant_t v,
         return NULL;
     }
 
-    if (!IS_CONTAINER(v->type)) {
+    /* a shared dataset never changes */
+    if (!IS_CONTAINER(v->type) || pcvariant_is_shared(v)) {
         pcinst_set_error(PCVARIANT_ERROR_NOT_SUPPORTED);
         return NULL;
     }
@@ -127,6 +145,7 @@ purc_variant_revoke_listener(purc_variant_t v,
 
         list_del(p);
         free(curr);
+        refresh_listened_ops(v);
         return true;
     }
 
@@ -143,6 +162,14 @@ bool pcvariant_on_pre_fired(
     op &= PCVAR_OPERATION_ALL;
     PC_ASSERT(op != PCVAR_OPERATION_ALL);
 
+    if (UNLIKELY(pcvariant_is_immutable(source))) {
+        pcinst_set_error(PURC_ERROR_ACCESS_DENIED);
+        return false;
+    }
+
+    if (!pcvariant_is_listened(source, op))
+        return true;
+
     struct list_head *listeners;
     listeners = &source->listeners;
 
@@ -174,6 +201,9 @@ void pcvariant_on_post_fired(
     op &= PCVAR_OPERATION_ALL;
     PC_ASSERT(op != PCVAR_OPERATION_ALL);
 
+    if (!pcvariant_is_listened(source, op))
+        return;
+
     struct list_head *listeners;
     listeners = &source->listeners;
 
@@ -196,6 +226,9 @@ void
 pcvar_break_rue_downward(purc_variant_t val)
 {
     PC_ASSERT(val != PURC_VARIANT_INVALID);
+    if (pcvariant_is_shared(val) || pcvariant_gc_is_releasing(val))
+        return;
+
     switch (val->type) {
         case PURC_VARIANT_TYPE_ARRAY:
             if (pcvar_container_belongs_to_set(val))
@@ -208,6 +241,7 @@ pcvar_break_rue_downward(purc_variant_t val)
             pcvar_object_break_rue_downward(val);
             return;
         case PURC_VARIANT_TYPE_SET:
+        case PURC_VARIANT_TYPE_TUPLE:
         case PURC_VARIANT_TYPE_NULL:
         case PURC_VARIANT_TYPE_BOOLEAN:
         case PURC_VARIANT_TYPE_EXCEPTION:
@@ -232,7 +266,7 @@ pcvar_break_edge_to_parent(purc_variant_t val,
         struct pcvar_rev_update_edge *edge)
 {
     PC_ASSERT(val != PURC_VARIANT_INVALID);
-    if (pcvariant_is_mutable(val) == false)
+    if (pcvariant_is_mutable(val) == false || pcvariant_gc_is_releasing(val))
         return;
 
     switch (val->type) {
@@ -245,6 +279,9 @@ pcvar_break_edge_to_parent(purc_variant_t val,
         case PURC_VARIANT_TYPE_SET:
             pcvar_set_break_edge_to_parent(val, edge);
             return;
+        case PURC_VARIANT_TYPE_TUPLE:
+            // a tuple has no reverse update chain
+            return;
         default:
             PC_ASSERT(0);
     }
@@ -254,12 +291,16 @@ int
 pcvar_build_rue_downward(purc_variant_t val)
 {
     PC_ASSERT(val != PURC_VARIANT_INVALID);
+    if (pcvariant_is_shared(val))
+        return 0;
+
     switch (val->type) {
         case PURC_VARIANT_TYPE_ARRAY:
             return pcvar_array_build_rue_downward(val);
         case PURC_VARIANT_TYPE_OBJECT:
             return pcvar_object_build_rue_downward(val);
         case PURC_VARIANT_TYPE_SET:
+        case PURC_VARIANT_TYPE_TUPLE:
         case PURC_VARIANT_TYPE_NULL:
         case PURC_VARIANT_TYPE_BOOLEAN:
         case PURC_VARIANT_TYPE_EXCEPTION:
@@ -297,6 +338,9 @@ pcvar_build_edge_to_parent(purc_variant_t val,
             return pcvar_object_build_edge_to_parent(val, edge);
         case PURC_VARIANT_TYPE_SET:
             return pcvar_set_build_edge_to_parent(val, edge);
+        case PURC_VARIANT_TYPE_TUPLE:
+            // a tuple has no reverse update chain
+            return 0;
         default:
             PC_ASSERT(0);
             break;
@@ -306,12 +350,12 @@ pcvar_build_edge_to_parent(purc_variant_t val,
 }
 
 static bool
-is_rev_update_chain_empty(pcutils_map *chain)
+is_rev_update_chain_empty(pcutils_ptrmap *chain)
 {
     if (!chain)
         return true;
 
-    size_t nr = pcutils_map_get_size(chain);
+    size_t nr = pcutils_ptrmap_size(chain);
     return nr == 0 ? true : false;
 }
 
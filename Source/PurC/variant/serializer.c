@@ -46,6 +46,7 @@
 #include "private/instance.h"
 #include "private/errors.h"
 #include "private/debug.h"
+#include "private/utils.h"
 
 #include "variant/variant-internals.h"
 
@@ -56,6 +57,12 @@
 #include <float.h>
 #include <assert.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 static const char *hex_chars = "0123456789abcdefABCDEF";
 
 #define MY_WRITE(rws, buff, count)                                      \
@@ -96,6 +103,63 @@ static const char *hex_chars = "0123456789abcdefABCDEF";
         }                                                               \
     } while (0)
 
+/* returns the length of the leading run of bytes which need no escaping:
+   the control characters, `"`, `\`, and `/` */
+static size_t
+clean_run_length(const unsigned char *p, size_t len)
+{
+    size_t n = 0;
+
+#if defined(__SSE2__)
+    const __m128i v_ctrl = _mm_set1_epi8(0x1F);
+    const __m128i v_quot = _mm_set1_epi8('"');
+    const __m128i v_bslash = _mm_set1_epi8('\\');
+    const __m128i v_slash = _mm_set1_epi8('/');
+
+    while (n + 16 <= len) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(p + n));
+        /* the unsigned bytes not greater than 0x1F */
+        __m128i hit = _mm_cmpeq_epi8(_mm_min_epu8(chunk, v_ctrl), chunk);
+        hit = _mm_or_si128(hit,
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, v_quot),
+                    _mm_or_si128(_mm_cmpeq_epi8(chunk, v_bslash),
+                        _mm_cmpeq_epi8(chunk, v_slash))));
+        int mask = _mm_movemask_epi8(hit);
+        if (mask) {
+            return n + __builtin_ctz(mask);
+        }
+        n += 16;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x16_t v_space = vdupq_n_u8(' ');
+    const uint8x16_t v_quot = vdupq_n_u8('"');
+    const uint8x16_t v_bslash = vdupq_n_u8('\\');
+    const uint8x16_t v_slash = vdupq_n_u8('/');
+
+    while (n + 16 <= len) {
+        uint8x16_t chunk = vld1q_u8(p + n);
+        uint8x16_t hit = vorrq_u8(vcltq_u8(chunk, v_space),
+                vorrq_u8(vceqq_u8(chunk, v_quot),
+                    vorrq_u8(vceqq_u8(chunk, v_bslash),
+                        vceqq_u8(chunk, v_slash))));
+        if (vmaxvq_u8(hit)) {
+            /* the scalar loop below locates the byte */
+            break;
+        }
+        n += 16;
+    }
+#endif
+
+    while (n < len) {
+        unsigned char c = p[n];
+        if (c < ' ' || c == '"' || c == '\\' || c == '/') {
+            break;
+        }
+        n++;
+    }
+    return n;
+}
+
 static ssize_t
 serialize_string(purc_rwstream_t rws, const char* str,
         size_t len, unsigned int flags, size_t *len_expected)
@@ -105,7 +169,12 @@ serialize_string(purc_rwstream_t rws, const char* str,
     unsigned char c;
     char buff[3];
 
-    while (len--) {
+    while (pos < len) {
+        /* skips the run of bytes which need no escaping at once */
+        pos += clean_run_length((const unsigned char *)str + pos, len - pos);
+        if (pos == len)
+            break;
+
         c = str[pos];
         switch (c) {
         case '\b':
@@ -430,14 +499,26 @@ serialize_number(purc_rwstream_t rws, double d, size_t *len_expected)
             size = static_strlen("-Infinity");
         }
     }
+    else if (d > -9223372036854775808.0 && d < 9223372036854775808.0) {
+        /* the integers in the range of int64_t */
+        int64_t i = (int64_t)d;
+        if ((double)i != d)
+            return 0;
+
+        /* keep the sign of -0 */
+        char *p = buf;
+        if (signbit(d))
+            *p++ = '-';
+        size = p - buf + pcutils_u64toa(i < 0 ? -(uint64_t)i : (uint64_t)i, p);
+    }
     else {
         double test;
 
         /* try to format the double without decimals */
         size = snprintf(buf, sizeof(buf), "%.0f", d);
         if (size < 0 || size >= (int)sizeof(buf)) {
-            pcinst_set_error(PURC_ERROR_TOO_SMALL_BUFF);
-            return -1;
+            /* too large; use the scientific notation */
+            return 0;
         }
 
         /* Check whether the original double can be recovered */
@@ -464,10 +545,14 @@ serialize_double(purc_rwstream_t rws, double d, int flags,
     int looks_numeric = 0;
 
     if (!format) {
+        /* the shortest digits which round-trip, regardless of the locale */
         format = std_format;
+        size = pcutils_dtoa(d, buf);
+    }
+    else {
+        size = snprintf(buf, sizeof(buf), format, d);
     }
 
-    size = snprintf(buf, sizeof(buf), format, d);
     // although unlikely, snprintf might fail
     if (UNLIKELY(size < 0)) {
         pcinst_set_error(PURC_ERROR_OUTPUT);
@@ -734,33 +819,19 @@ ssize_t purc_variant_serialize(purc_variant_t value, purc_rwstream_t rws,
 
         case PURC_VARIANT_TYPE_LONGINT:
         {
-            const char *format;
+            size_t len = pcutils_i64toa(value->i64, buff);
             if (flags & PCVARIANT_SERIALIZE_OPT_REAL_EJSON)
-                format = "%lldL";
-            else
-                format = "%lld";
-
-            if (snprintf(buff, sizeof(buff), format,
-                        (long long int)value->i64) < 0)
-                goto failed;
+                strcpy(buff + len, "L");
             content = buff;
-            // sz_content = strlen(buff);
             break;
         }
 
         case PURC_VARIANT_TYPE_ULONGINT:
         {
-            const char *format;
+            size_t len = pcutils_u64toa(value->u64, buff);
             if (flags & PCVARIANT_SERIALIZE_OPT_REAL_EJSON)
-                format = "%lluUL";
-            else
-                format = "%llu";
-
-            if (snprintf(buff, sizeof(buff), format,
-                        (long long unsigned)value->u64) < 0)
-                goto failed;
+                strcpy(buff + len, "UL");
             content = buff;
-            // sz_content = strlen(buff);
             break;
         }
 
@@ -0,0 +1,394 @@
+/*
+ * @file shared-data.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The immutable datasets shared by all instances.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A dataset is moved to the move heap, then frozen: every variant in it
+ * is marked with PCVARIANT_FLAG_SHARED, so it is referenced atomically
+ * and can not be changed any more. The constants of the move heap are
+ * replaced with the ones made for the dataset, for the former ones are
+ * referenced by the move heap without atomic operations.
+ *
+ * The registry does not hold the datasets: a dataset is found by its name
+ * as long as some instance holds it, and it is removed from the registry
+ * when the last reference is dropped.
+ */
+
+#include "config.h"
+
+#include "private/instance.h"
+#include "private/list.h"
+#include "private/variant.h"
+
+#include "variant-internals.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+    SHARED_UNDEFINED = 0,
+    SHARED_NULL,
+    SHARED_FALSE,
+    SHARED_TRUE,
+    SHARED_NR_CONSTS,
+};
+
+struct shared_entry {
+    struct list_head    node;
+    char               *name;
+    purc_variant_t      root;
+};
+
+struct freeze_context {
+    /* the constants made for the dataset */
+    purc_variant_t      consts[SHARED_NR_CONSTS];
+
+    /* the references to the constants of the move heap to drop */
+    unsigned int        nr_dropped[SHARED_NR_CONSTS];
+};
+
+static struct purc_mutex    sd_lock;
+static struct list_head     sd_entries;
+
+static void shared_data_cleanup_once(void)
+{
+    PC_ASSERT(list_empty(&sd_entries));
+
+    if (sd_lock.native_impl)
+        purc_mutex_clear(&sd_lock);
+}
+
+static int shared_data_init_once(void)
+{
+    INIT_LIST_HEAD(&sd_entries);
+
+    purc_mutex_init(&sd_lock);
+    if (sd_lock.native_impl == NULL)
+        return -1;
+
+    if (atexit(shared_data_cleanup_once)) {
+        purc_mutex_clear(&sd_lock);
+        return -1;
+    }
+
+    return 0;
+}
+
+struct pcmodule _module_shared_data = {
+    .name            = "shared-data",
+    .id              = PURC_HAVE_VARIANT,
+    .module_inited   = 0,
+
+    .init_once       = shared_data_init_once,
+    .init_instance   = NULL,
+};
+
+static int
+const_index(purc_variant_t v)
+{
+    switch (v->type) {
+    case PURC_VARIANT_TYPE_UNDEFINED:
+        return SHARED_UNDEFINED;
+    case PURC_VARIANT_TYPE_NULL:
+        return SHARED_NULL;
+    default:
+        return v->b ? SHARED_TRUE : SHARED_FALSE;
+    }
+}
+
+/* called with the move heap used */
+static purc_variant_t
+make_const(int c)
+{
+    static const enum purc_variant_type types[] = {
+        PURC_VARIANT_TYPE_UNDEFINED,
+        PURC_VARIANT_TYPE_NULL,
+        PURC_VARIANT_TYPE_BOOLEAN,
+        PURC_VARIANT_TYPE_BOOLEAN,
+    };
+
+    purc_variant_t v = pcvariant_get(types[c]);
+    if (v == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    v->type = types[c];
+    v->size = 0;
+    v->flags = PCVARIANT_FLAG_SHARED;
+    v->refc = 1;
+    v->b = (c == SHARED_TRUE);
+    return v;
+}
+
+static bool
+freeze(struct freeze_context *ctxt, purc_variant_t *slot);
+
+static bool
+freeze_members(struct freeze_context *ctxt, purc_variant_t v)
+{
+    switch (v->type) {
+    case PURC_VARIANT_TYPE_ARRAY:
+    {
+        purc_variant_t m;
+        size_t idx;
+        foreach_value_in_variant_array(v, m, idx) {
+            (void)m;
+            if (!freeze(ctxt, _data->vals + idx))
+                return false;
+        } end_foreach;
+        break;
+    }
+
+    case PURC_VARIANT_TYPE_OBJECT:
+    {
+        purc_variant_t k, m;
+        foreach_key_value_in_variant_object(v, k, m) {
+            (void)k;
+            (void)m;
+            if (!freeze(ctxt, &_node->key) || !freeze(ctxt, &_node->val))
+                return false;
+        } end_foreach;
+        break;
+    }
+
+    case PURC_VARIANT_TYPE_SET:
+    {
+        purc_variant_t m;
+        foreach_value_in_variant_set(v, m) {
+            (void)m;
+            if (!freeze(ctxt, &_sn->val))
+                return false;
+        } end_foreach;
+        break;
+    }
+
+    case PURC_VARIANT_TYPE_TUPLE:
+    {
+        size_t sz;
+        purc_variant_t *members = tuple_members(v, &sz);
+        for (size_t n = 0; n < sz; n++) {
+            if (!freeze(ctxt, members + n))
+                return false;
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    return true;
+}
+
+/* the variant in @slot is held only by the dataset, except the constants */
+static bool
+freeze(struct freeze_context *ctxt, purc_variant_t *slot)
+{
+    purc_variant_t v = *slot;
+    if (pcvariant_is_shared(v))
+        return true;
+
+    /* only the constants of the move heap are not freeable */
+    if (v->flags & PCVARIANT_FLAG_NOFREE) {
+        int c = const_index(v);
+        ctxt->nr_dropped[c]++;
+        *slot = purc_variant_ref(ctxt->consts[c]);
+        return true;
+    }
+
+    switch (v->type) {
+    case PURC_VARIANT_TYPE_DYNAMIC:
+    case PURC_VARIANT_TYPE_NATIVE:
+        /* the entities may change when they are used */
+        purc_set_error(PURC_ERROR_NOT_SUPPORTED);
+        return false;
+
+    case PURC_VARIANT_TYPE_STRING:
+        /* cache the hash value now, since it can not be set afterwards */
+        pcvariant_string_hash(v);
+        break;
+
+    default:
+        break;
+    }
+
+    if (!freeze_members(ctxt, v))
+        return false;
+
+    if (v->flags & PCVARIANT_FLAG_GC_BUFFERED)
+        pcvariant_gc_forget(v);
+    v->flags |= PCVARIANT_FLAG_SHARED;
+    return true;
+}
+
+/* returns a reference to @v unless it is being released */
+static purc_variant_t
+try_ref(purc_variant_t v)
+{
+    unsigned int refc = __atomic_load_n(&v->refc, __ATOMIC_ACQUIRE);
+    while (refc > 0) {
+        if (__atomic_compare_exchange_n(&v->refc, &refc, refc + 1, true,
+                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            return v;
+    }
+
+    return PURC_VARIANT_INVALID;
+}
+
+/* called with the lock held */
+static purc_variant_t
+find_dataset(const char *name)
+{
+    struct shared_entry *p;
+    list_for_each_entry(p, &sd_entries, node) {
+        if (strcmp(p->name, name) == 0) {
+            purc_variant_t v = try_ref(p->root);
+            if (v)
+                return v;
+        }
+    }
+
+    return PURC_VARIANT_INVALID;
+}
+
+purc_variant_t
+pcvariant_shared_data_get(const char *name)
+{
+    purc_mutex_lock(&sd_lock);
+    purc_variant_t v = find_dataset(name);
+    purc_mutex_unlock(&sd_lock);
+
+    if (v == PURC_VARIANT_INVALID)
+        purc_set_error(PCVARIANT_ERROR_NOT_FOUND);
+    return v;
+}
+
+void
+pcvariant_shared_data_forget(purc_variant_t root)
+{
+    purc_mutex_lock(&sd_lock);
+
+    struct shared_entry *p;
+    list_for_each_entry(p, &sd_entries, node) {
+        if (p->root == root) {
+            list_del(&p->node);
+            free(p->name);
+            free(p);
+            break;
+        }
+    }
+
+    purc_mutex_unlock(&sd_lock);
+}
+
+static purc_variant_t
+freeze_dataset(purc_variant_t v)
+{
+    struct freeze_context ctxt;
+    memset(&ctxt, 0, sizeof(ctxt));
+
+    purc_variant_t root = pcvariant_move_heap_in(v);
+    if (root == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    bool ok = true;
+    pcvariant_use_move_heap();
+    for (int c = 0; c < SHARED_NR_CONSTS; c++) {
+        if ((ctxt.consts[c] = make_const(c)) == PURC_VARIANT_INVALID)
+            ok = false;
+    }
+    pcvariant_use_norm_heap();
+
+    /* the tree is not visible to others yet, so no lock is needed */
+    if (ok) {
+        ok = freeze(&ctxt, &root);
+    }
+
+    pcvariant_use_move_heap();
+    struct pcvariant_heap *heap = pcinst_current()->variant_heap;
+    heap->v_undefined.refc -= ctxt.nr_dropped[SHARED_UNDEFINED];
+    heap->v_null.refc -= ctxt.nr_dropped[SHARED_NULL];
+    heap->v_false.refc -= ctxt.nr_dropped[SHARED_FALSE];
+    heap->v_true.refc -= ctxt.nr_dropped[SHARED_TRUE];
+
+    if (!ok) {
+        purc_variant_unref(root);
+        root = PURC_VARIANT_INVALID;
+    }
+
+    for (int c = 0; c < SHARED_NR_CONSTS; c++) {
+        if (ctxt.consts[c])
+            purc_variant_unref(ctxt.consts[c]);
+    }
+    pcvariant_use_norm_heap();
+
+    if (root == PURC_VARIANT_INVALID && purc_get_last_error() == PURC_ERROR_OK)
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    return root;
+}
+
+purc_variant_t
+pcvariant_shared_data_freeze(purc_variant_t v)
+{
+    if (pcvariant_is_shared(v))
+        return v;
+
+    return freeze_dataset(v);
+}
+
+purc_variant_t
+pcvariant_shared_data_publish(const char *name, purc_variant_t v)
+{
+    struct shared_entry *entry = calloc(1, sizeof(*entry));
+    if (entry == NULL || (entry->name = strdup(name)) == NULL) {
+        free(entry);
+        purc_variant_unref(v);
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return PURC_VARIANT_INVALID;
+    }
+
+    purc_variant_t root = freeze_dataset(v);
+    if (root == PURC_VARIANT_INVALID) {
+        free(entry->name);
+        free(entry);
+        return PURC_VARIANT_INVALID;
+    }
+
+    purc_mutex_lock(&sd_lock);
+    purc_variant_t published = find_dataset(name);
+    if (published == PURC_VARIANT_INVALID) {
+        root->flags |= PCVARIANT_FLAG_SHARED_ROOT;
+        entry->root = root;
+        list_add(&entry->node, &sd_entries);
+    }
+    purc_mutex_unlock(&sd_lock);
+
+    if (published) {
+        /* another instance published the same dataset meanwhile */
+        free(entry->name);
+        free(entry);
+        purc_variant_unref(root);
+        return published;
+    }
+
+    return root;
+}
@@ -0,0 +1,309 @@
+/*
+ * @file slab.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The size-class slab allocator for variants and container nodes.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Every instance owns a slab; all chunks are carved from blocks aligned
+ * to SLAB_BLOCK_SIZE, so the block (and its owner) of a chunk can be
+ * found by masking the address.
+ *
+ * The owner allocates and frees chunks without any lock or atomic
+ * operation. A variant moved to another instance (see move-heap.c) may
+ * be freed by a thread which is not the owner; such a chunk is pushed to
+ * the lock-free remote list of the owner, and the owner takes the chunks
+ * back on its next allocation miss.
+ *
+ * When the instance exits while some chunks are still alive in other
+ * instances, the slab is orphaned, and the last remote free releases
+ * the slab.
+ */
+
+#include "config.h"
+
+#include "private/instance.h"
+#include "private/variant.h"
+#include "private/debug.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* this feature needs C11 (stdatomic.h) or above */
+#if HAVE(STDATOMIC_H)
+#include <stdatomic.h>
+#else
+#error "Not implemented for this platform."
+#endif
+
+#define SLAB_BLOCK_SIZE         (16 * 1024)
+#define SLAB_CHUNK_ALIGN        16
+#define SLAB_MAX_CHUNK_SIZE     256
+#define SLAB_NR_CLASSES         (SLAB_MAX_CHUNK_SIZE / SLAB_CHUNK_ALIGN)
+
+#define SLAB_CLASS(sz)          (((sz) + SLAB_CHUNK_ALIGN - 1) / \
+                                    SLAB_CHUNK_ALIGN - 1)
+#define SLAB_CHUNK_SIZE(cls)    (((cls) + 1) * SLAB_CHUNK_ALIGN)
+
+/* the value of the remote list after the slab is orphaned */
+#define SLAB_ORPHANED           ((struct slab_chunk *)(uintptr_t)1)
+
+struct slab_chunk {
+    struct slab_chunk          *next;
+};
+
+struct slab_block {
+    struct pcvariant_slab      *owner;
+    struct slab_block          *next;
+    unsigned int                cls;
+};
+
+#define SLAB_BLOCK_HEADER_SIZE  \
+    ((sizeof(struct slab_block) + SLAB_CHUNK_ALIGN - 1) & \
+        ~(SLAB_CHUNK_ALIGN - 1))
+
+struct slab_class {
+    struct slab_chunk          *free_chunks;
+    char                       *bump;   /* the unused area in current block */
+    char                       *end;
+};
+
+struct pcvariant_slab {
+    struct slab_class           classes[SLAB_NR_CLASSES];
+    struct slab_block          *blocks;
+
+    /* the chunks freed by other threads */
+    _Atomic(struct slab_chunk *) remote_chunks;
+    /* the number of live chunks after the slab is orphaned */
+    atomic_size_t               nr_orphan_chunks;
+
+    size_t                      nr_live_chunks;
+    size_t                      nr_hits;
+    size_t                      nr_misses;
+    size_t                      sz_mem;
+};
+
+static inline struct slab_block *
+block_of_chunk(void *chunk)
+{
+    return (struct slab_block *)((uintptr_t)chunk &
+            ~((uintptr_t)SLAB_BLOCK_SIZE - 1));
+}
+
+static inline struct pcvariant_slab *
+current_slab(void)
+{
+    struct pcinst *inst = pcinst_current();
+    if (inst && inst->variant_heap)
+        return inst->variant_heap->slab;
+    return NULL;
+}
+
+struct pcvariant_slab *
+pcvariant_slab_create(void)
+{
+    struct pcvariant_slab *slab = calloc(1, sizeof(*slab));
+    if (slab) {
+        atomic_init(&slab->remote_chunks, NULL);
+        atomic_init(&slab->nr_orphan_chunks, 0);
+    }
+
+    return slab;
+}
+
+static void
+slab_release(struct pcvariant_slab *slab)
+{
+    struct slab_block *block = slab->blocks;
+    while (block) {
+        struct slab_block *next = block->next;
+        free(block);
+        block = next;
+    }
+
+    free(slab);
+}
+
+/* move the chunks freed by other threads to the local free lists */
+static size_t
+take_remote_chunks(struct pcvariant_slab *slab, struct slab_chunk *chunk)
+{
+    size_t n = 0;
+
+    while (chunk) {
+        struct slab_chunk *next = chunk->next;
+        struct slab_class *cls = slab->classes + block_of_chunk(chunk)->cls;
+
+        chunk->next = cls->free_chunks;
+        cls->free_chunks = chunk;
+        n++;
+        chunk = next;
+    }
+
+    slab->nr_live_chunks -= n;
+    return n;
+}
+
+void
+pcvariant_slab_destroy(struct pcvariant_slab *slab)
+{
+    /* the chunks in the remote list are counted as live ones */
+    if (slab->nr_live_chunks == 0) {
+        slab_release(slab);
+        return;
+    }
+
+    /* some chunks are still alive in other instances; the one more count
+       is held by us, and it will be dropped after orphaning the slab. */
+    atomic_store(&slab->nr_orphan_chunks, slab->nr_live_chunks + 1);
+
+    struct slab_chunk *chunk;
+    chunk = atomic_exchange(&slab->remote_chunks, SLAB_ORPHANED);
+    size_t n = take_remote_chunks(slab, chunk);
+
+    PC_DEBUG("Orphan a slab with %u live chunks\n",
+            (unsigned)slab->nr_live_chunks);
+    if (atomic_fetch_sub(&slab->nr_orphan_chunks, n + 1) == n + 1) {
+        slab_release(slab);
+    }
+}
+
+static void *
+alloc_chunk_in_new_block(struct pcvariant_slab *slab, unsigned int cls)
+{
+    struct slab_block *block;
+
+    if (posix_memalign((void **)&block, SLAB_BLOCK_SIZE, SLAB_BLOCK_SIZE))
+        return NULL;
+
+    block->owner = slab;
+    block->cls = cls;
+    block->next = slab->blocks;
+    slab->blocks = block;
+    slab->sz_mem += SLAB_BLOCK_SIZE;
+
+    struct slab_class *klass = slab->classes + cls;
+    klass->bump = (char *)block + SLAB_BLOCK_HEADER_SIZE;
+    klass->end = (char *)block + SLAB_BLOCK_SIZE;
+
+    void *chunk = klass->bump;
+    klass->bump += SLAB_CHUNK_SIZE(cls);
+    return chunk;
+}
+
+void *
+pcvariant_slab_alloc(size_t sz)
+{
+    if (sz > SLAB_MAX_CHUNK_SIZE)
+        return malloc(sz);
+
+    struct pcvariant_slab *slab = current_slab();
+    PC_ASSERT(slab);
+
+    unsigned int cls = SLAB_CLASS(sz);
+    struct slab_class *klass = slab->classes + cls;
+    void *chunk;
+
+    if (klass->free_chunks == NULL &&
+            atomic_load_explicit(&slab->remote_chunks,
+                memory_order_relaxed)) {
+        take_remote_chunks(slab,
+                atomic_exchange(&slab->remote_chunks, NULL));
+    }
+
+    if (klass->free_chunks) {
+        chunk = klass->free_chunks;
+        klass->free_chunks = klass->free_chunks->next;
+        slab->nr_hits++;
+    }
+    else if (klass->end - klass->bump >= SLAB_CHUNK_SIZE(cls)) {
+        chunk = klass->bump;
+        klass->bump += SLAB_CHUNK_SIZE(cls);
+        slab->nr_misses++;
+    }
+    else {
+        chunk = alloc_chunk_in_new_block(slab, cls);
+        if (chunk == NULL)
+            return NULL;
+        slab->nr_misses++;
+    }
+
+    slab->nr_live_chunks++;
+    return chunk;
+}
+
+void *
+pcvariant_slab_alloc0(size_t sz)
+{
+    void *chunk = pcvariant_slab_alloc(sz);
+    if (chunk)
+        memset(chunk, 0, sz);
+    return chunk;
+}
+
+static void
+free_remote_chunk(struct pcvariant_slab *owner, struct slab_chunk *chunk)
+{
+    struct slab_chunk *head = atomic_load(&owner->remote_chunks);
+
+    do {
+        if (head == SLAB_ORPHANED) {
+            if (atomic_fetch_sub(&owner->nr_orphan_chunks, 1) == 1) {
+                slab_release(owner);
+            }
+            return;
+        }
+
+        chunk->next = head;
+    } while (!atomic_compare_exchange_weak(&owner->remote_chunks,
+                &head, chunk));
+}
+
+void
+pcvariant_slab_free(size_t sz, void *p)
+{
+    if (sz > SLAB_MAX_CHUNK_SIZE) {
+        free(p);
+        return;
+    }
+
+    struct slab_chunk *chunk = p;
+    struct pcvariant_slab *owner = block_of_chunk(chunk)->owner;
+    if (owner == current_slab()) {
+        struct slab_class *klass = owner->classes + SLAB_CLASS(sz);
+        chunk->next = klass->free_chunks;
+        klass->free_chunks = chunk;
+        owner->nr_live_chunks--;
+    }
+    else {
+        free_remote_chunk(owner, chunk);
+    }
+}
+
+void
+pcvariant_slab_get_stat(struct pcvariant_slab *slab,
+        struct purc_variant_stat *stat)
+{
+    stat->nr_slab_hits = slab->nr_hits;
+    stat->nr_slab_misses = slab->nr_misses;
+    stat->sz_slab_mem = slab->sz_mem;
+}
+
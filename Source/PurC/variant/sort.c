@@ -0,0 +1,426 @@
+/*
+ * @file sort.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The implementation of sorting containers by precomputed keys.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include "config.h"
+#include "private/variant.h"
+#include "private/errors.h"
+#include "private/utils.h"
+#include "private/threadpool.h"
+#include "variant-internals.h"
+#include "purc-errors.h"
+#include "purc-utils.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Decorate-sort-undecorate: the keys of every member are extracted once
+ * into a contiguous vector, the members are sorted by the vector, and then
+ * put back in order. A comparison only touches the vector, instead of
+ * looking the keys up and stringifying them again.
+ */
+
+#define UNDEFINED_STR       "undefined"
+
+/* the default least number of members to sort in parallel */
+#define DEF_PARALLEL_SORT_CUTOFF    (64 * 1024)
+#define MAX_SORT_WORKERS            64
+
+/*
+ * Only the builtin key comparisons run on the workers: they read the key
+ * vector (and the strings of the members referenced by it) only, which is
+ * not changed while the calling thread waits for the workers.
+ */
+static unsigned s_nr_sort_workers = 1;
+static size_t s_parallel_sort_cutoff = DEF_PARALLEL_SORT_CUTOFF;
+
+struct sort_key {
+    double          number;
+    const char     *str;
+    /* the string allocated for a member which is not a string,
+       or the case-folded copy of the string for a caseless sorting */
+    char           *buf;
+    /* the string is folded, and can be compared with strcmp() */
+    bool            folded;
+};
+
+struct sort_record {
+    struct sort_key    *keys;
+    size_t              idx;    // the original position, to keep stable
+    void               *item;   // the member or the set node
+};
+
+struct sort_info {
+    size_t              nr_keys;
+    const bool         *by_number;
+    bool                desc;
+    bool                caseless;
+};
+
+/* folds the case of an ASCII key once, instead of in every comparison */
+static void
+fold_key(struct sort_key *key, size_t len)
+{
+    /* not in place: the string is kept if it is not in ASCII */
+    char *dst = malloc(len + 1);
+    if (dst == NULL)
+        return;
+
+    if (pcutils_strfold_ascii(dst, key->str, len)) {
+        dst[len] = '\0';
+        free(key->buf);
+        key->buf = dst;
+        key->str = dst;
+        key->folded = true;
+    }
+    else {
+        free(dst);
+    }
+}
+
+static void
+extract_key(struct sort_key *key, purc_variant_t v, bool by_number,
+        bool caseless)
+{
+    if (by_number) {
+        key->number = v ? purc_variant_numberify(v) : 0.0;
+        return;
+    }
+
+    if (v == PURC_VARIANT_INVALID) {
+        key->str = UNDEFINED_STR;
+    }
+    else if (purc_variant_is_string(v) || purc_variant_is_atomstring(v)) {
+        key->str = purc_variant_get_string_const(v);
+    }
+    else if (purc_variant_stringify_alloc(&key->buf, v) >= 0) {
+        key->str = key->buf;
+    }
+    else {
+        key->buf = NULL;
+        key->str = "";
+    }
+
+    if (caseless)
+        fold_key(key, strlen(key->str));
+}
+
+static int
+compare_keys(const struct sort_record *l, const struct sort_record *r,
+        const struct sort_info *info)
+{
+    for (size_t i = 0; i < info->nr_keys; i++) {
+        const struct sort_key *kl = l->keys + i;
+        const struct sort_key *kr = r->keys + i;
+        int ret;
+
+        if (info->by_number[i]) {
+            if (pcutils_equal_doubles(kl->number, kr->number))
+                ret = 0;
+            else
+                ret = kl->number < kr->number ? -1 : 1;
+        }
+        else if (info->caseless && !(kl->folded && kr->folded)) {
+            ret = pcutils_strcasecmp(kl->str, kr->str);
+        }
+        else {
+            ret = strcmp(kl->str, kr->str);
+        }
+
+        if (ret)
+            return info->desc ? -ret : ret;
+    }
+
+    return (l->idx > r->idx) - (l->idx < r->idx);
+}
+
+#if OS(HURD) || OS(LINUX)
+static int record_cmp(const void *l, const void *r, void *ud)
+{
+    return compare_keys(l, r, ud);
+}
+#elif OS(DARWIN) || OS(FREEBSD) || OS(NETBSD) || OS(OPENBSD) || OS(WINDOWS)
+static int record_cmp(void *ud, const void *l, const void *r)
+{
+    return compare_keys(l, r, ud);
+}
+#else
+#error Unsupported operating system.
+#endif
+
+static inline void
+sort_records(struct sort_record *records, size_t nr,
+        const struct sort_info *info)
+{
+#if OS(HURD) || OS(LINUX)
+    qsort_r(records, nr, sizeof(*records), record_cmp, (void *)info);
+#elif OS(DARWIN) || OS(FREEBSD) || OS(NETBSD) || OS(OPENBSD)
+    qsort_r(records, nr, sizeof(*records), (void *)info, record_cmp);
+#elif OS(WINDOWS)
+    qsort_s(records, nr, sizeof(*records), record_cmp, (void *)info);
+#endif
+}
+
+#if USE(PTHREADS)
+
+/* a run to sort, or two adjacent runs to merge into `dst` */
+struct sort_task {
+    const struct sort_info     *info;
+    struct sort_record         *src;
+    struct sort_record         *dst;
+    size_t                      nr_left;
+    size_t                      nr_right;
+};
+
+static void *sort_run_main(void *arg)
+{
+    struct sort_task *task = arg;
+    sort_records(task->src, task->nr_left, task->info);
+    return NULL;
+}
+
+static void *merge_runs_main(void *arg)
+{
+    struct sort_task *task = arg;
+    const struct sort_record *l = task->src;
+    const struct sort_record *l_end = l + task->nr_left;
+    const struct sort_record *r = l_end;
+    const struct sort_record *r_end = r + task->nr_right;
+    struct sort_record *out = task->dst;
+
+    while (l < l_end && r < r_end) {
+        if (compare_keys(r, l, task->info) < 0)
+            *out++ = *r++;
+        else
+            *out++ = *l++;
+    }
+
+    memcpy(out, l, (l_end - l) * sizeof(*out));
+    out += l_end - l;
+    memcpy(out, r, (r_end - r) * sizeof(*out));
+    return NULL;
+}
+
+/* runs the tasks on the thread pool; the calling thread takes the first
+   one, and the ones failed to submit */
+static void
+run_tasks(struct sort_task *tasks, pcutils_task **handles, unsigned nr_tasks,
+        void *(*task_main)(void *))
+{
+    for (unsigned i = 1; i < nr_tasks; i++)
+        handles[i] = pcutils_task_submit(task_main, tasks + i);
+
+    task_main(tasks);
+    for (unsigned i = 1; i < nr_tasks; i++) {
+        if (handles[i]) {
+            pcutils_task_wait(handles[i]);
+            pcutils_task_release(handles[i]);
+        }
+        else {
+            task_main(tasks + i);
+        }
+    }
+}
+
+/*
+ * Merge sort: the records are split into a run per worker, the runs are
+ * sorted in parallel, and then the adjacent runs are merged pair by pair
+ * in parallel until one run is left. Returns -1 if no memory.
+ */
+static int
+sort_records_parallel(struct sort_record *records, size_t nr,
+        const struct sort_info *info, unsigned nr_workers)
+{
+    struct sort_record *buf = malloc(nr * sizeof(*buf));
+    struct sort_task *tasks = calloc(nr_workers, sizeof(*tasks));
+    pcutils_task **handles = calloc(nr_workers, sizeof(*handles));
+    size_t *bounds = malloc((nr_workers + 1) * sizeof(*bounds));
+    if (buf == NULL || tasks == NULL || handles == NULL || bounds == NULL) {
+        free(buf);
+        free(tasks);
+        free(handles);
+        free(bounds);
+        return -1;
+    }
+
+    unsigned nr_runs = nr_workers;
+    for (unsigned i = 0; i <= nr_runs; i++)
+        bounds[i] = nr * i / nr_runs;
+
+    for (unsigned i = 0; i < nr_runs; i++) {
+        tasks[i].info = info;
+        tasks[i].src = records + bounds[i];
+        tasks[i].nr_left = bounds[i + 1] - bounds[i];
+    }
+    run_tasks(tasks, handles, nr_runs, sort_run_main);
+
+    struct sort_record *src = records, *dst = buf;
+    while (nr_runs > 1) {
+        unsigned nr_tasks = 0;
+        for (unsigned i = 0; i < nr_runs; i += 2) {
+            struct sort_task *task = tasks + nr_tasks;
+            size_t end = bounds[(i + 2 <= nr_runs) ? i + 2 : i + 1];
+
+            task->info = info;
+            task->src = src + bounds[i];
+            task->dst = dst + bounds[i];
+            task->nr_left = bounds[i + 1] - bounds[i];
+            task->nr_right = end - bounds[i + 1];
+            bounds[nr_tasks++] = bounds[i];
+        }
+        bounds[nr_tasks] = nr;
+
+        run_tasks(tasks, handles, nr_tasks, merge_runs_main);
+        nr_runs = nr_tasks;
+
+        struct sort_record *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != records)
+        memcpy(records, src, nr * sizeof(*records));
+
+    free(buf);
+    free(tasks);
+    free(handles);
+    free(bounds);
+    return 0;
+}
+
+#endif /* USE(PTHREADS) */
+
+unsigned purc_variant_set_sort_workers(unsigned nr_workers, size_t cutoff)
+{
+    unsigned old = s_nr_sort_workers;
+
+    if (nr_workers > MAX_SORT_WORKERS)
+        nr_workers = MAX_SORT_WORKERS;
+    s_nr_sort_workers = nr_workers ? nr_workers : 1;
+    s_parallel_sort_cutoff = cutoff ? cutoff : DEF_PARALLEL_SORT_CUTOFF;
+    return old;
+}
+
+int pcvariant_sort_by_keys(purc_variant_t container, size_t nr_keys,
+        const bool *by_number, pcvariant_sort_key_getter getter, void *ud,
+        bool desc, bool caseless)
+{
+    variant_arr_t arr = NULL;
+    struct pcutils_array_list *al = NULL;
+    size_t nr;
+
+    if (container->type == PURC_VARIANT_TYPE_ARRAY) {
+        arr = pcvar_arr_get_data(container);
+        nr = arr->nr;
+    }
+    else if (container->type == PURC_VARIANT_TYPE_SET) {
+        al = &pcvar_set_get_data(container)->al;
+        nr = pcutils_array_list_length(al);
+    }
+    else {
+        pcinst_set_error(PCVARIANT_ERROR_INVALID_TYPE);
+        return -1;
+    }
+
+    if (pcvariant_is_immutable(container)) {
+        pcinst_set_error(PURC_ERROR_ACCESS_DENIED);
+        return -1;
+    }
+
+    if (nr < 2 || nr_keys == 0)
+        return 0;
+
+    struct sort_record *records = malloc(nr * sizeof(*records));
+    struct sort_key *keys = calloc(nr * nr_keys, sizeof(*keys));
+    if (records == NULL || keys == NULL) {
+        free(records);
+        free(keys);
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    for (size_t i = 0; i < nr; i++) {
+        purc_variant_t member;
+        if (arr) {
+            member = arr->vals[i];
+            records[i].item = member;
+        }
+        else {
+            struct set_node *node;
+            node = container_of(al->nodes[i], struct set_node, alnode);
+            member = node->val;
+            records[i].item = node;
+        }
+
+        records[i].keys = keys + i * nr_keys;
+        records[i].idx = i;
+        for (size_t k = 0; k < nr_keys; k++) {
+            purc_variant_t v = getter ? getter(member, k, ud) : member;
+            extract_key(records[i].keys + k, v, by_number[k], caseless);
+        }
+    }
+
+    struct sort_info info = {
+        .nr_keys = nr_keys,
+        .by_number = by_number,
+        .desc = desc,
+        .caseless = caseless,
+    };
+
+#if USE(PTHREADS)
+    unsigned nr_workers = s_nr_sort_workers;
+    if (nr_workers > 1 && nr >= s_parallel_sort_cutoff &&
+            nr >= nr_workers * 2 &&
+            sort_records_parallel(records, nr, &info, nr_workers) == 0)
+        goto sorted;
+#endif
+
+    sort_records(records, nr, &info);
+
+#if USE(PTHREADS)
+sorted:
+#endif
+
+    for (size_t i = 0; i < nr; i++) {
+        if (arr) {
+            arr->vals[i] = records[i].item;
+        }
+        else {
+            struct set_node *node = records[i].item;
+            al->nodes[i] = &node->alnode;
+            node->alnode.idx = i;
+        }
+    }
+
+    for (size_t i = 0; i < nr * nr_keys; i++) {
+        if (keys[i].buf)
+            free(keys[i].buf);
+    }
+    free(keys);
+    free(records);
+    return 0;
+}
+
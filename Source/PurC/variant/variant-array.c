@@ -27,6 +27,7 @@
 #include "config.h"
 #include "private/variant.h"
 #include "private/errors.h"
+#include "private/utils.h"
 #include "variant-internals.h"
 #include "purc-errors.h"
 #include "purc-utils.h"
@@ -36,11 +37,12 @@
 #include <stdlib.h>
 #include <string.h>
 
-static size_t
+#define ARR_MIN_CAPACITY        8
+
+static inline size_t
 variant_arr_length(variant_arr_t data)
 {
-    struct pcutils_array_list *al = &data->al;
-    return pcutils_array_list_length(al);
+    return data->nr;
 }
 
 static inline bool
@@ -129,83 +131,99 @@ pcvar_arr_get_data(purc_variant_t arr)
     return (variant_arr_t)arr->sz_ptr[1];
 }
 
-static void
-break_rev_update_chain(purc_variant_t arr, struct arr_node *node)
+static int
+variant_arr_reserve(variant_arr_t data, size_t capacity)
 {
-    struct pcvar_rev_update_edge edge = {
-        .parent        = arr,
-        .arr_me        = node,
-    };
+    if (capacity <= data->sz)
+        return 0;
+
+    /* a compacted array gets the minimal capacity back once it grows */
+    size_t sz = data->sz > ARR_MIN_CAPACITY ? data->sz : ARR_MIN_CAPACITY;
+    while (sz < capacity)
+        sz <<= 1;
+
+    purc_variant_t *vals = realloc(data->vals, sz * sizeof(*vals));
+    if (!vals)
+        return -1;
 
-    pcvar_break_edge_to_parent(node->val, &edge);
-    pcvar_break_rue_downward(node->val);
+    data->vals = vals;
+    data->sz = sz;
+    return 0;
 }
 
-static void
-arr_node_release(purc_variant_t arr, struct arr_node *node)
+/* the caller takes the reference of the member */
+static purc_variant_t
+variant_arr_take(variant_arr_t data, size_t idx)
 {
-    if (!node)
-        return;
-
-    break_rev_update_chain(arr, node);
+    PC_ASSERT(idx < data->nr);
 
-    if (node->node.idx != (size_t)-1) {
-        variant_arr_t data = pcvar_arr_get_data(arr);
-        PC_ASSERT(data);
+    purc_variant_t val = data->vals[idx];
+    data->nr--;
+    memmove(data->vals + idx, data->vals + idx + 1,
+            (data->nr - idx) * sizeof(*data->vals));
 
-        struct pcutils_array_list *al = &data->al;
-        PC_ASSERT(al);
+    return val;
+}
 
-        struct pcutils_array_list_node *p;
-        int r = pcutils_array_list_remove(al, node->node.idx, &p);
-        PC_ASSERT(r == 0);
-        PC_ASSERT(&node->node == p);
-        PC_ASSERT(node->node.idx == (size_t)-1);
+/* whether `val` is held by a slot other than `except` */
+static bool
+is_held_by_others(variant_arr_t data, purc_variant_t val, size_t except)
+{
+    for (size_t i = 0; i < data->nr; i++) {
+        if (i != except && data->vals[i] == val)
+            return true;
     }
 
-    PURC_VARIANT_SAFE_CLEAR(node->val);
+    return false;
 }
 
+/*
+ * The reverse update edges of the members are keyed by the array itself,
+ * and they are built only when the array belongs to a set. A member held
+ * by more than one slot shares one edge, so the edge is broken only after
+ * the last slot holding the member is gone.
+ */
 static void
-arr_node_destroy(purc_variant_t arr, struct arr_node *node)
+break_rev_update_chain(purc_variant_t arr, purc_variant_t val)
 {
-    if (!node)
-        return;
+    struct pcvar_rev_update_edge edge = {
+        .parent        = arr,
+        .arr_me        = arr,
+    };
 
-    arr_node_release(arr, node);
-    free(node);
+    pcvar_break_edge_to_parent(val, &edge);
+    pcvar_break_rue_downward(val);
 }
 
-static purc_variant_t
-variant_arr_make_pos(variant_arr_t data, size_t idx)
+static void
+release_member(purc_variant_t arr, variant_arr_t data, purc_variant_t val,
+        size_t except)
 {
-    size_t len = variant_arr_length(data);
-    if (idx > len)
-        idx = len;
-
-    return purc_variant_make_longint(idx);
+    if (pcvar_container_belongs_to_set(arr) &&
+            !is_held_by_others(data, val, except)) {
+        break_rev_update_chain(arr, val);
+    }
 }
 
-static struct arr_node*
-arr_node_create(purc_variant_t val)
+/* the position is made only if a listener will receive it */
+static int
+variant_arr_make_pos(purc_variant_t arr, variant_arr_t data, size_t idx,
+        pcvar_op_t op, bool check, purc_variant_t *pos)
 {
-    struct arr_node *node;
-    node = (struct arr_node*)calloc(1, sizeof(*node));
-    if (!node) {
-        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
-        return NULL;
-    }
-
-    node->node.idx = (size_t)-1;
+    *pos = PURC_VARIANT_INVALID;
+    if (!check || !pcvariant_is_listened(arr, op))
+        return 0;
 
-    node->val = val;
-    purc_variant_ref(val);
+    size_t len = variant_arr_length(data);
+    if (idx > len)
+        idx = len;
 
-    return node;
+    *pos = purc_variant_make_longint(idx);
+    return (*pos == PURC_VARIANT_INVALID) ? -1 : 0;
 }
 
 static int
-build_rev_update_chain(purc_variant_t arr, struct arr_node *node)
+build_rev_update_chain(purc_variant_t arr, purc_variant_t val)
 {
     if (!pcvar_container_belongs_to_set(arr))
         return 0;
@@ -214,12 +232,12 @@ build_rev_update_chain(purc_variant_t arr, struct arr_node *node)
 
     struct pcvar_rev_update_edge edge = {
         .parent        = arr,
-        .arr_me        = node,
+        .arr_me        = arr,
     };
 
-    r = pcvar_build_edge_to_parent(node->val, &edge);
+    r = pcvar_build_edge_to_parent(val, &edge);
     if (r == 0) {
-        r = pcvar_build_rue_downward(node->val);
+        r = pcvar_build_rue_downward(val);
     }
 
     return r ? -1 : 0;
@@ -278,19 +296,15 @@ variant_arr_insert_before(purc_variant_t arr, size_t idx, purc_variant_t val,
     variant_arr_t data = pcvar_arr_get_data(arr);
     PC_ASSERT(data);
 
-    struct pcutils_array_list *al = &data->al;
-    PC_ASSERT(al);
-
-    size_t nr = pcutils_array_list_length(al);
+    size_t nr = variant_arr_length(data);
     if (idx > nr)
         idx = nr;
 
-    purc_variant_t pos = variant_arr_make_pos(data, idx);
-    if (pos == PURC_VARIANT_INVALID)
+    purc_variant_t pos;
+    if (variant_arr_make_pos(arr, data, idx, PCVAR_OPERATION_GROW,
+                check, &pos))
         return -1;
 
-    struct arr_node *node = NULL;
-
     do {
         if (check) {
             if (!grow(arr, pos, val, check))
@@ -300,35 +314,34 @@ variant_arr_insert_before(purc_variant_t arr, size_t idx, purc_variant_t val,
                 break;
         }
 
-        node = arr_node_create(val);
-        if (!node)
-            break;
-
-        int r;
-        PC_ASSERT(node->node.idx == (size_t)-1);
-        r = pcutils_array_list_insert_before(al, idx, &node->node);
-        if (r) {
-            PC_ASSERT(node->node.idx == (size_t)-1);
+        if (variant_arr_reserve(data, nr + 1)) {
             purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
             break;
         }
-        PC_ASSERT(node->node.idx != (size_t)-1);
+
+        memmove(data->vals + idx + 1, data->vals + idx,
+                (nr - idx) * sizeof(*data->vals));
+        data->vals[idx] = purc_variant_ref(val);
+        data->nr++;
 
         if (check) {
-            if (build_rev_update_chain(arr, node))
+            if (build_rev_update_chain(arr, val)) {
+                val = variant_arr_take(data, idx);
+                release_member(arr, data, val, (size_t)-1);
+                purc_variant_unref(val);
                 break;
+            }
 
             pcvar_adjust_set_by_descendant(arr);
             grown(arr, pos, val, check);
         }
 
-        purc_variant_unref(pos);
+        PURC_VARIANT_SAFE_CLEAR(pos);
 
         return 0;
     } while (0);
 
-    arr_node_destroy(arr, node);
-    purc_variant_unref(pos);
+    PURC_VARIANT_SAFE_CLEAR(pos);
 
     return -1;
 }
@@ -340,9 +353,7 @@ refresh_extra(purc_variant_t arr)
     variant_arr_t data = pcvar_arr_get_data(arr);
     if (data) {
         extra += sizeof(*data);
-        struct pcutils_array_list *al = &data->al;
-        extra += al->sz * sizeof(*al->nodes);
-        extra += al->nr * sizeof(struct arr_node);
+        extra += data->sz * sizeof(*data->vals);
     }
     pcvariant_stat_set_extra_size(arr, extra);
 }
@@ -352,8 +363,7 @@ variant_arr_append(purc_variant_t arr, purc_variant_t val,
         bool check)
 {
     variant_arr_t data = pcvar_arr_get_data(arr);
-    struct pcutils_array_list *al = &data->al;
-    size_t nr = pcutils_array_list_length(al);
+    size_t nr = variant_arr_length(data);
     int r = variant_arr_insert_before(arr, nr, val, check);
     refresh_extra(arr);
     return r ? -1 : 0;
@@ -369,19 +379,14 @@ variant_arr_prepend(purc_variant_t arr, purc_variant_t val,
 static purc_variant_t
 variant_arr_get(variant_arr_t data, size_t idx)
 {
-    struct pcutils_array_list *al = &data->al;
-    struct pcutils_array_list_node *p;
-    p = pcutils_array_list_get(al, idx);
-    if (p == NULL)
+    if (idx >= data->nr)
         return PURC_VARIANT_INVALID;
 
-    struct arr_node *node;
-    node = (struct arr_node*)container_of(p, struct arr_node, node);
-    return node->val;
+    return data->vals[idx];
 }
 
 static int
-check_change(purc_variant_t arr, struct arr_node *node, purc_variant_t val)
+check_change(purc_variant_t arr, size_t idx, purc_variant_t val)
 {
     if (!pcvar_container_belongs_to_set(arr))
         return 0;
@@ -396,10 +401,10 @@ check_change(purc_variant_t arr, struct arr_node *node, purc_variant_t val)
         size_t i;
         purc_variant_t v;
         foreach_value_in_variant_array(arr, v, i) {
-            if (i == node->node.idx) {
+            if (i == idx) {
                 found = true;
             }
-            r = pcvar_arr_append(_new, i == node->node.idx ? val : v);
+            r = pcvar_arr_append(_new, i == idx ? val : v);
             if (r)
                 break;
         } end_foreach;
@@ -429,54 +434,41 @@ variant_arr_set(purc_variant_t arr, size_t idx, purc_variant_t val,
     variant_arr_t data = pcvar_arr_get_data(arr);
     PC_ASSERT(data);
 
-    struct pcutils_array_list *al = &data->al;
-    PC_ASSERT(al);
-
-    size_t nr = pcutils_array_list_length(al);
+    size_t nr = variant_arr_length(data);
     if (idx >= nr) {
         purc_set_error(PURC_ERROR_OVERFLOW);
         return -1;
     }
 
-    struct pcutils_array_list_node *p;
-    p = pcutils_array_list_get(al, idx);
-    PC_ASSERT(p);
-
-    struct arr_node *old_node;
-    old_node = (struct arr_node*)container_of(p, struct arr_node, node);
-    PC_ASSERT(old_node->val != PURC_VARIANT_INVALID);
-    if (old_node->val == val) {
+    purc_variant_t old = data->vals[idx];
+    PC_ASSERT(old != PURC_VARIANT_INVALID);
+    if (old == val) {
         // NOTE: keep refc intact
         return 0;
     }
 
-    purc_variant_t pos = variant_arr_make_pos(data, idx);
-    if (pos == PURC_VARIANT_INVALID)
+    purc_variant_t pos;
+    if (variant_arr_make_pos(arr, data, idx, PCVAR_OPERATION_CHANGE,
+                check, &pos))
         return -1;
 
     do {
-        purc_variant_t old = old_node->val;
-
         if (check) {
             if (!change(arr, pos, old, val, check))
                 break;
 
-            if (check_change(arr, old_node, val))
+            if (check_change(arr, idx, val))
                 break;
 
-            old_node->val = val;
-
-            if (build_rev_update_chain(arr, old_node)) {
-                break_rev_update_chain(arr, old_node);
-                old_node->val = old;
+            if (build_rev_update_chain(arr, val)) {
+                release_member(arr, data, val, idx);
                 break;
             }
 
-            old_node->val = old;
-            break_rev_update_chain(arr, old_node);
+            release_member(arr, data, old, idx);
         }
 
-        old_node->val = purc_variant_ref(val);
+        data->vals[idx] = purc_variant_ref(val);
 
         if (check) {
             pcvar_adjust_set_by_descendant(arr);
@@ -485,18 +477,18 @@ variant_arr_set(purc_variant_t arr, size_t idx, purc_variant_t val,
         }
 
         purc_variant_unref(old);
-        purc_variant_unref(pos);
+        PURC_VARIANT_SAFE_CLEAR(pos);
 
         return 0;
     } while (0);
 
-    purc_variant_unref(pos);
+    PURC_VARIANT_SAFE_CLEAR(pos);
 
     return -1;
 }
 
 static int
-check_shrink(purc_variant_t arr, struct arr_node *node)
+check_shrink(purc_variant_t arr, size_t idx)
 {
     if (!pcvar_container_belongs_to_set(arr))
         return 0;
@@ -511,7 +503,7 @@ check_shrink(purc_variant_t arr, struct arr_node *node)
         size_t i;
         purc_variant_t v;
         foreach_value_in_variant_array(arr, v, i) {
-            if (i == node->node.idx) {
+            if (i == idx) {
                 PC_ASSERT(!found);
                 found = true;
                 continue;
@@ -546,57 +538,46 @@ variant_arr_remove(purc_variant_t arr, size_t idx,
     variant_arr_t data = pcvar_arr_get_data(arr);
     PC_ASSERT(data);
 
-    struct pcutils_array_list *al = &data->al;
-    PC_ASSERT(al);
-
-    size_t nr = pcutils_array_list_length(al);
+    size_t nr = variant_arr_length(data);
     if (idx >= nr) {
         // FIXME: failure or success???
         return 0;
     }
 
-    purc_variant_t pos = variant_arr_make_pos(data, idx);
-    if (pos == PURC_VARIANT_INVALID)
+    purc_variant_t pos;
+    if (variant_arr_make_pos(arr, data, idx, PCVAR_OPERATION_SHRINK,
+                check, &pos))
         return -1;
 
-    struct pcutils_array_list_node *p, *n;
-    p = pcutils_array_list_get(al, idx);
-    PC_ASSERT(p);
-
-    struct arr_node *node;
-    node = (struct arr_node*)container_of(p, struct arr_node, node);
-    PC_ASSERT(node->val);
+    purc_variant_t val = data->vals[idx];
+    PC_ASSERT(val);
 
     do {
         if (check) {
-            if (!shrink(arr, pos, node->val, check))
+            if (!shrink(arr, pos, val, check))
                 break;
 
-            if (check_shrink(arr, node))
+            if (check_shrink(arr, idx))
                 break;
 
-            break_rev_update_chain(arr, node);
+            release_member(arr, data, val, idx);
         }
 
-        PC_ASSERT(node->node.idx != (size_t)-1);
-        int r = pcutils_array_list_remove(al, idx, &n);
-        PC_ASSERT(r == 0);
-        PC_ASSERT(&node->node == n);
-        PC_ASSERT(node->node.idx == (size_t)-1);
+        variant_arr_take(data, idx);
 
         if (check) {
             pcvar_adjust_set_by_descendant(arr);
 
-            shrunk(arr, pos, node->val, check);
+            shrunk(arr, pos, val, check);
         }
 
-        arr_node_destroy(arr, node);
-        purc_variant_unref(pos);
+        purc_variant_unref(val);
+        PURC_VARIANT_SAFE_CLEAR(pos);
 
         return 0;
     } while (0);
 
-    purc_variant_unref(pos);
+    PURC_VARIANT_SAFE_CLEAR(pos);
 
     return -1;
 }
@@ -608,20 +589,24 @@ array_release (purc_variant_t arr)
     if (!data)
         return;
 
-    struct pcutils_array_list *al = &data->al;
-    struct arr_node *p, *n;
-    array_list_for_each_entry_reverse_safe(al, p, n, node) {
-        arr_node_destroy(arr, p);
-    };
+    bool in_set = pcvar_container_belongs_to_set(arr);
+    for (size_t i = data->nr; i-- > 0; ) {
+        if (in_set)
+            break_rev_update_chain(arr, data->vals[i]);
+        purc_variant_unref(data->vals[i]);
+    }
 
-    pcutils_array_list_reset(al);
+    free(data->vals);
+    data->vals = NULL;
+    data->nr = 0;
+    data->sz = 0;
 
     if (data->rev_update_chain) {
         pcvar_destroy_rev_update_chain(data->rev_update_chain);
         data->rev_update_chain = NULL;
     }
 
-    free(data);
+    pcvariant_slab_delete(struct variant_arr, data);
     arr->sz_ptr[1] = (uintptr_t)NULL;
 
     pcvariant_stat_set_extra_size(arr, 0);
@@ -640,22 +625,15 @@ make_array(size_t sz)
         var->flags         = PCVARIANT_FLAG_EXTRA_SIZE;
         var->refc          = 1;
 
-        size_t initial_size = ARRAY_LIST_DEFAULT_SIZE;
-        if (sz>initial_size)
-            initial_size = sz;
-
-        variant_arr_t data = (variant_arr_t)calloc(1, sizeof(*data));
+        variant_arr_t data = pcvariant_slab_new(struct variant_arr);
         if (!data) {
             pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
             break;
         }
 
-        struct pcutils_array_list *al;
-        al = &data->al;
-        pcutils_array_list_init(al);
-        if (pcutils_array_list_expand(al, initial_size)) {
-            pcutils_array_list_reset(al);
-            free(data);
+        /* the storage of an empty array is allocated on the first append */
+        if (sz > 0 && variant_arr_reserve(data, sz)) {
+            pcvariant_slab_delete(struct variant_arr, data);
             pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
             break;
         }
@@ -845,6 +823,48 @@ bool purc_variant_array_remove (purc_variant_t arr, int idx)
     return r ? false : true;
 }
 
+int pcvariant_array_remove_if(purc_variant_t arr,
+        bool (*pred)(purc_variant_t member, void *ctxt), void *ctxt)
+{
+    PCVARIANT_CHECK_FAIL_RET(arr && arr->type==PVT(_ARRAY) && pred, -1);
+
+    if (pcvariant_is_immutable(arr)) {
+        pcinst_set_error(PURC_ERROR_ACCESS_DENIED);
+        return -1;
+    }
+
+    variant_arr_t data = pcvar_arr_get_data(arr);
+    int r = 0;
+
+    if (pcvariant_is_listened(arr, PCVAR_OPERATION_SHRINK) ||
+            pcvar_container_belongs_to_set(arr)) {
+        /* the earlier positions are intact when removing from the last */
+        for (size_t i = variant_arr_length(data); i > 0; i--) {
+            /* a listener may have removed the members */
+            if (i > data->nr)
+                continue;
+            if (pred(data->vals[i - 1], ctxt) &&
+                    variant_arr_remove(arr, i - 1, true))
+                r = -1;
+        }
+    }
+    else {
+        size_t nr = 0;
+        for (size_t i = 0; i < data->nr; i++) {
+            purc_variant_t val = data->vals[i];
+            if (pred(val, ctxt)) {
+                purc_variant_unref(val);
+                continue;
+            }
+            data->vals[nr++] = val;
+        }
+        data->nr = nr;
+    }
+
+    refresh_extra(arr);
+    return r;
+}
+
 bool purc_variant_array_insert_before (purc_variant_t arr, int idx,
         purc_variant_t value)
 {
@@ -868,17 +888,23 @@ struct arr_user_data {
     void *ud;
 };
 
+#if OS(HURD) || OS(LINUX)
 static int
-sort_cmp(struct pcutils_array_list_node *l, struct pcutils_array_list_node *r,
-        void *ud)
+sort_cmp(const void *l, const void *r, void *ud)
+{
+    struct arr_user_data *d = (struct arr_user_data*)ud;
+    return d->cmp(*(purc_variant_t *)l, *(purc_variant_t *)r, d->ud);
+}
+#elif OS(DARWIN) || OS(FREEBSD) || OS(NETBSD) || OS(OPENBSD) || OS(WINDOWS)
+static int
+sort_cmp(void *ud, const void *l, const void *r)
 {
-    struct arr_node *l_n, *r_n;
-    l_n = container_of(l, struct arr_node, node);
-    r_n = container_of(r, struct arr_node, node);
-
     struct arr_user_data *d = (struct arr_user_data*)ud;
-    return d->cmp(l_n->val, r_n->val, d->ud);
+    return d->cmp(*(purc_variant_t *)l, *(purc_variant_t *)r, d->ud);
 }
+#else
+#error Unsupported operating system.
+#endif
 
 static int vrtcmp(purc_variant_t l, purc_variant_t r, void *ud)
 {
@@ -894,13 +920,59 @@ static int vrtcmp(purc_variant_t l, purc_variant_t r, void *ud)
     return retv;
 }
 
+static inline bool
+is_number_type(purc_variant_t v)
+{
+    return v->type == PURC_VARIANT_TYPE_NUMBER ||
+        v->type == PURC_VARIANT_TYPE_LONGINT ||
+        v->type == PURC_VARIANT_TYPE_ULONGINT ||
+        v->type == PURC_VARIANT_TYPE_LONGDOUBLE;
+}
+
+/*
+ * Sorts the members by numbers: the members are numberified once into
+ * a vector of keys instead of in every comparison, and large arrays are
+ * sorted in parallel. Returns -1 if the default comparison does not compare
+ * the members by numbers, or no memory for the vector.
+ */
+static int
+sort_by_numbers(purc_variant_t arr, uintptr_t sort_flags)
+{
+    variant_arr_t data = pcvar_arr_get_data(arr);
+    purc_vrtcmp_opt_t cmpopt;
+    cmpopt = (purc_vrtcmp_opt_t)(sort_flags & PCVARIANT_CMPOPT_MASK);
+
+    if (cmpopt == PCVARIANT_COMPARE_OPT_AUTO) {
+        /* the auto option compares by numbers only for number members */
+        for (size_t i = 0; i < data->nr; i++) {
+            if (!is_number_type(data->vals[i]))
+                return -1;
+        }
+    }
+    else if (cmpopt != PCVARIANT_COMPARE_OPT_NUMBER) {
+        return -1;
+    }
+
+    bool by_number = true;
+    return pcvariant_sort_by_keys(arr, 1, &by_number, NULL, NULL,
+            sort_flags & PCVARIANT_SORT_DESC, false);
+}
+
 int pcvariant_array_sort(purc_variant_t arr, void *ud,
         int (*cmp)(purc_variant_t l, purc_variant_t r, void *ud))
 {
     if (!arr || arr->type != PURC_VARIANT_TYPE_ARRAY)
         return -1;
 
+    if (pcvariant_is_immutable(arr)) {
+        pcinst_set_error(PURC_ERROR_ACCESS_DENIED);
+        return -1;
+    }
+
     variant_arr_t data = pcvar_arr_get_data(arr);
+    if (cmp == NULL && data->nr > 1 &&
+            sort_by_numbers(arr, (uintptr_t)ud) == 0)
+        return 0;
 
     struct arr_user_data d = {
         .cmp = cmp,
@@ -911,23 +983,49 @@ int pcvariant_array_sort(purc_variant_t arr, void *ud,
         d.cmp = vrtcmp;
     }
 
-    pcutils_array_list_sort(&data->al, &d, sort_cmp);
+#if OS(HURD) || OS(LINUX)
+    qsort_r(data->vals, data->nr, sizeof(*data->vals), sort_cmp, &d);
+#elif OS(DARWIN) || OS(FREEBSD) || OS(NETBSD) || OS(OPENBSD)
+    qsort_r(data->vals, data->nr, sizeof(*data->vals), &d, sort_cmp);
+#elif OS(WINDOWS)
+    qsort_s(data->vals, data->nr, sizeof(*data->vals), sort_cmp, &d);
+#endif
 
     return 0;
 }
 
+void
+pcvariant_array_compact(purc_variant_t arr)
+{
+    variant_arr_t data = pcvar_arr_get_data(arr);
+    if (data->nr == 0 || data->nr >= ARR_MIN_CAPACITY || data->nr == data->sz)
+        return;
+
+    /* keep the storage if it cannot be shrunk */
+    purc_variant_t *vals = realloc(data->vals, data->nr * sizeof(*vals));
+    if (vals) {
+        data->vals = vals;
+        data->sz = data->nr;
+        refresh_extra(arr);
+    }
+}
+
+/*
+ * The clone is a new array which belongs to no set and has no listener,
+ * so the members are stored directly instead of being appended one by
+ * one, which would make a position variant for every member.
+ */
 purc_variant_t
 pcvariant_array_clone(purc_variant_t arr, bool recursively)
 {
-    purc_variant_t var;
-    var = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    variant_arr_t data = pcvar_arr_get_data(arr);
+    purc_variant_t var = make_array(data->nr);
     if (var == PURC_VARIANT_INVALID)
         return PURC_VARIANT_INVALID;
 
-    purc_variant_t v;
-    size_t idx;
-    foreach_value_in_variant_array(arr, v, idx) {
-        UNUSED_PARAM(idx);
+    variant_arr_t new_data = pcvar_arr_get_data(var);
+    for (size_t i = 0; i < data->nr; i++) {
+        purc_variant_t v = data->vals[i];
         purc_variant_t val;
         if (recursively) {
             val = pcvariant_container_clone(v, recursively);
@@ -939,14 +1037,9 @@ pcvariant_array_clone(purc_variant_t arr, bool recursively)
             purc_variant_unref(var);
             return PURC_VARIANT_INVALID;
         }
-        bool ok;
-        ok = purc_variant_array_append(var, val);
-        purc_variant_unref(val);
-        if (!ok) {
-            purc_variant_unref(var);
-            return PURC_VARIANT_INVALID;
-        }
-    } end_foreach;
+
+        new_data->vals[new_data->nr++] = val;
+    }
 
     PC_ASSERT(var != arr);
     return var;
@@ -961,14 +1054,8 @@ pcvar_array_break_rue_downward(purc_variant_t arr)
     if (!data)
         return;
 
-    struct arr_node *p;
-    foreach_in_variant_array(arr, p) {
-        struct pcvar_rev_update_edge edge = {
-            .parent         = arr,
-            .arr_me         = p,
-        };
-        pcvar_break_edge_to_parent(p->val, &edge);
-        pcvar_break_rue_downward(p->val);
+    for (size_t i = 0; i < data->nr; i++) {
+        break_rev_update_chain(arr, data->vals[i]);
     }
 }
 
@@ -984,7 +1071,7 @@ pcvar_array_break_edge_to_parent(purc_variant_t arr,
     if (!data->rev_update_chain)
         return;
 
-    pcutils_map_erase(data->rev_update_chain, edge->arr_me);
+    pcutils_ptrmap_erase(data->rev_update_chain, edge->arr_me);
 }
 
 int
@@ -996,16 +1083,16 @@ pcvar_array_build_rue_downward(purc_variant_t arr)
     if (!data)
         return 0;
 
-    struct arr_node *p;
-    foreach_in_variant_array(arr, p) {
-        struct pcvar_rev_update_edge edge = {
-            .parent         = arr,
-            .arr_me         = p,
-        };
-        int r = pcvar_build_edge_to_parent(p->val, &edge);
+    struct pcvar_rev_update_edge edge = {
+        .parent         = arr,
+        .arr_me         = arr,
+    };
+
+    for (size_t i = 0; i < data->nr; i++) {
+        int r = pcvar_build_edge_to_parent(data->vals[i], &edge);
         if (r)
             return -1;
-        r = pcvar_build_rue_downward(p->val);
+        r = pcvar_build_rue_downward(data->vals[i]);
         if (r)
             return -1;
     }
@@ -1028,78 +1115,28 @@ pcvar_array_build_edge_to_parent(purc_variant_t arr,
             return -1;
     }
 
-    pcutils_map_entry *entry;
-    entry = pcutils_map_find(data->rev_update_chain, edge->arr_me);
-    if (entry)
+    if (pcutils_ptrmap_find(data->rev_update_chain, edge->arr_me))
         return 0;
 
     int r;
-    r = pcutils_map_insert(data->rev_update_chain,
+    r = pcutils_ptrmap_set(data->rev_update_chain,
             edge->arr_me, edge->parent);
 
     return r ? -1 : 0;
 }
 
-static struct pcutils_array_list_node*
-next_node(struct pcutils_array_list *al, struct pcutils_array_list_node *node)
-{
-    if (!node)
-        return NULL;
-    size_t count = pcutils_array_list_length(al);
-    size_t idx = node->idx + 1;
-    if (idx >= count)
-        return NULL;
-
-    return pcutils_array_list_get(al, idx);
-}
-
-static struct pcutils_array_list_node*
-prev_node(struct pcutils_array_list *al, struct pcutils_array_list_node *node)
-{
-    if (!node)
-        return NULL;
-    if (node->idx == 0)
-        return NULL;
-
-    size_t count = pcutils_array_list_length(al);
-    size_t idx = node->idx - 1;
-    if (idx >= count)
-        return NULL;
-
-    return pcutils_array_list_get(al, idx);
-}
-
 static void
-it_refresh(struct arr_iterator *it,
-        struct pcutils_array_list *al,
-        struct pcutils_array_list_node *curr)
+it_refresh(struct arr_iterator *it, size_t idx)
 {
-    struct pcutils_array_list_node *next  = NULL;
-    struct pcutils_array_list_node *prev  = NULL;
-    if (curr) {
-        next  = next_node(al, curr);
-        prev  = prev_node(al, curr);
-    }
-
-    if (curr) {
-        it->curr = container_of(curr, struct arr_node, node);
-    }
-    else {
-        it->curr = NULL;
-    }
-
-    if (next) {
-        it->next = container_of(next, struct arr_node, node);
-    }
-    else {
-        it->next = NULL;
-    }
+    variant_arr_t data = pcvar_arr_get_data(it->arr);
 
-    if (prev) {
-        it->prev = container_of(prev, struct arr_node, node);
+    if (idx < variant_arr_length(data)) {
+        it->idx = idx;
+        it->curr = data->vals[idx];
     }
     else {
-        it->prev = NULL;
+        it->idx = 0;
+        it->curr = PURC_VARIANT_INVALID;
     }
 }
 
@@ -1112,17 +1149,7 @@ pcvar_arr_it_first(purc_variant_t arr)
     if (arr == PURC_VARIANT_INVALID)
         return it;
 
-    variant_arr_t data = pcvar_arr_get_data(arr);
-    size_t count = variant_arr_length(data);
-    if (count == 0)
-        return it;
-
-    struct pcutils_array_list *al = &data->al;
-
-    struct pcutils_array_list_node *first;
-    first = pcutils_array_list_get_first(al);
-
-    it_refresh(&it, al, first);
+    it_refresh(&it, 0);
 
     return it;
 }
@@ -1141,12 +1168,7 @@ pcvar_arr_it_last(purc_variant_t arr)
     if (count == 0)
         return it;
 
-    struct pcutils_array_list *al = &data->al;
-
-    struct pcutils_array_list_node *last;
-    last = pcutils_array_list_get_last(al);
-
-    it_refresh(&it, al, last);
+    it_refresh(&it, count - 1);
 
     return it;
 }
@@ -1154,45 +1176,22 @@ pcvar_arr_it_last(purc_variant_t arr)
 void
 pcvar_arr_it_next(struct arr_iterator *it)
 {
-    if (it->curr == NULL)
+    if (it->curr == PURC_VARIANT_INVALID)
         return;
 
-    if (it->next) {
-        variant_arr_t data = pcvar_arr_get_data(it->arr);
-        struct pcutils_array_list *al = &data->al;
-
-        struct pcutils_array_list_node *next;
-        next = &it->next->node;
-
-        it_refresh(it, al, next);
-    }
-    else {
-        it->curr = NULL;
-        it->next = NULL;
-        it->prev = NULL;
-    }
+    it_refresh(it, it->idx + 1);
 }
 
 void
 pcvar_arr_it_prev(struct arr_iterator *it)
 {
-    if (it->curr == NULL)
+    if (it->curr == PURC_VARIANT_INVALID)
         return;
 
-    if (it->prev) {
-        variant_arr_t data = pcvar_arr_get_data(it->arr);
-        struct pcutils_array_list *al = &data->al;
-
-        struct pcutils_array_list_node *prev;
-        prev = &it->prev->node;
-
-        it_refresh(it, al, prev);
-    }
-    else {
-        it->curr = NULL;
-        it->next = NULL;
-        it->prev = NULL;
+    if (it->idx == 0) {
+        it->curr = PURC_VARIANT_INVALID;
+        return;
     }
-}
-
 
+    it_refresh(it, it->idx - 1);
+}
@@ -60,6 +60,9 @@ purc_variant_t pcvariant_get (enum purc_variant_type type) WTF_INTERNAL;
  */
 void pcvariant_put(purc_variant_t value) WTF_INTERNAL;
 
+/* removes the root of a shared dataset being released from the registry */
+void pcvariant_shared_data_forget(purc_variant_t root) WTF_INTERNAL;
+
 // for release the resource in a variant
 typedef void (* pcvariant_release_fn) (purc_variant_t value);
 
@@ -81,15 +84,15 @@ pcvar_set_get_data(purc_variant_t set) WTF_INTERNAL;
 void
 pcvar_adjust_set_by_descendant(purc_variant_t val) WTF_INTERNAL;
 
-pcutils_map*
+pcutils_ptrmap*
 pcvar_create_rev_update_chain(void) WTF_INTERNAL;
 void
-pcvar_destroy_rev_update_chain(pcutils_map *chain) WTF_INTERNAL;
+pcvar_destroy_rev_update_chain(pcutils_ptrmap *chain) WTF_INTERNAL;
 int
-pcvar_rev_update_chain_add(pcutils_map *chain,
+pcvar_rev_update_chain_add(pcutils_ptrmap *chain,
         struct pcvar_rev_update_edge *edge) WTF_INTERNAL;
 void
-pcvar_rev_update_chain_del(pcutils_map *chain,
+pcvar_rev_update_chain_del(pcutils_ptrmap *chain,
         struct pcvar_rev_update_edge *edge) WTF_INTERNAL;
 
 int
@@ -169,6 +172,8 @@ struct obj_iterator {
 struct obj_iterator
 pcvar_obj_it_first(purc_variant_t obj);
 struct obj_iterator
+pcvar_obj_it_lower_bound(purc_variant_t obj, const char *key);
+struct obj_iterator
 pcvar_obj_it_last(purc_variant_t obj);
 void
 pcvar_obj_it_next(struct obj_iterator *it);
@@ -178,9 +183,9 @@ pcvar_obj_it_prev(struct obj_iterator *it);
 struct arr_iterator {
     purc_variant_t                arr;
 
-    struct arr_node              *curr;
-    struct arr_node              *next;
-    struct arr_node              *prev;
+    size_t                        idx;
+    // the member at idx; PURC_VARIANT_INVALID at the end
+    purc_variant_t                curr;
 };
 
 struct arr_iterator
@@ -25,7 +25,10 @@
 
 #include "config.h"
 #include "private/variant.h"
+#include "private/instance.h"
+#include "private/atom-buckets.h"
 #include "private/errors.h"
+#include "private/hashtable.h"
 #include "purc-errors.h"
 #include "variant-internals.h"
 
@@ -36,7 +39,12 @@
 #include <string.h>
 
 #define OBJ_EXTRA_SIZE(data) (sizeof(*data) + \
-        (data->size) * sizeof(struct obj_node))
+        (data->size) * sizeof(struct obj_node) + \
+        (data->index_size) * sizeof(struct obj_node *))
+
+#define OBJ_INDEX_THRESHOLD     16
+#define OBJ_INDEX_MIN_SIZE      64
+#define OBJ_INDEX_REMOVED       ((struct obj_node *)(uintptr_t)1)
 
 static inline bool
 grow(purc_variant_t obj, purc_variant_t key, purc_variant_t val,
@@ -139,7 +147,7 @@ static purc_variant_t v_object_new_with_capacity(void)
     var->flags         = PCVARIANT_FLAG_EXTRA_SIZE;
 
     variant_obj_t data;
-    data = (variant_obj_t)calloc(1, sizeof(*data));
+    data = pcvariant_slab_new(struct variant_obj);
 
     if (!data) {
         pcvariant_put(var);
@@ -170,6 +178,180 @@ break_rev_update_chain(purc_variant_t obj, struct obj_node *node)
     pcvar_break_rue_downward(node->val);
 }
 
+static inline uint32_t
+obj_key_hash(const char *key)
+{
+    return (uint32_t)pchash_default_char_hash(key);
+}
+
+purc_variant_t
+pcvariant_make_object_key(const char *key)
+{
+    struct pcinst *inst = pcinst_current();
+
+    /* do not cache the keys made in the move heap */
+    if (inst == NULL || inst->variant_heap != inst->org_vrt_heap)
+        return purc_variant_make_string(key, false);
+
+    struct pcvariant_heap *heap = inst->variant_heap;
+    purc_variant_t *slot = heap->interned_keys +
+        (obj_key_hash(key) & (NR_INTERNED_KEYS - 1));
+
+    if (*slot && strcmp(purc_variant_get_string_const(*slot), key) == 0)
+        return purc_variant_ref(*slot);
+
+    /* the atoms in ATOM_BUCKET_OBJKEY are never removed, so the string
+       lives longer than any variant referring to it. */
+    purc_atom_t atom = purc_atom_from_string_ex(ATOM_BUCKET_OBJKEY, key);
+    if (atom == 0)
+        return purc_variant_make_string(key, false);
+
+    purc_variant_t v;
+    v = purc_variant_make_string_static(purc_atom_to_string(atom), false);
+    if (v == PURC_VARIANT_INVALID)
+        return v;
+
+    if (*slot)
+        purc_variant_unref(*slot);
+    *slot = purc_variant_ref(v);
+    return v;
+}
+
+static struct obj_node *
+obj_index_find(variant_obj_t data, const char *key, uint32_t hash)
+{
+    size_t mask = data->index_size - 1;
+    size_t i = hash & mask;
+    struct obj_node *node;
+
+    while ((node = data->index[i])) {
+        if (node != OBJ_INDEX_REMOVED && node->key_hash == hash) {
+            /* the interned keys share the same string */
+            const char *sk = purc_variant_get_string_const(node->key);
+            if (sk == key || strcmp(sk, key) == 0)
+                return node;
+        }
+        i = (i + 1) & mask;
+    }
+
+    return NULL;
+}
+
+/* the key of the node must not be in the index */
+static void
+obj_index_put(variant_obj_t data, struct obj_node *node)
+{
+    size_t mask = data->index_size - 1;
+    size_t i = node->key_hash & mask;
+
+    while (data->index[i] && data->index[i] != OBJ_INDEX_REMOVED)
+        i = (i + 1) & mask;
+
+    if (data->index[i] == NULL)
+        data->index_used++;
+    data->index[i] = node;
+}
+
+static void
+obj_index_remove(variant_obj_t data, struct obj_node *node)
+{
+    size_t mask = data->index_size - 1;
+    size_t i = node->key_hash & mask;
+
+    while (data->index[i] != node) {
+        PC_ASSERT(data->index[i]);
+        i = (i + 1) & mask;
+    }
+
+    data->index[i] = OBJ_INDEX_REMOVED;
+}
+
+static void
+obj_index_drop(variant_obj_t data)
+{
+    free(data->index);
+    data->index = NULL;
+    data->index_size = 0;
+    data->index_used = 0;
+}
+
+static int
+obj_index_rebuild(variant_obj_t data)
+{
+    size_t size = OBJ_INDEX_MIN_SIZE;
+    while (size < data->size * 2)
+        size <<= 1;
+
+    struct obj_node **index = calloc(size, sizeof(*index));
+    if (index == NULL)
+        return -1;
+
+    free(data->index);
+    data->index = index;
+    data->index_size = size;
+    data->index_used = 0;
+
+    struct rb_node *p = pcutils_rbtree_first(&data->kvs);
+    for (; p; p = pcutils_rbtree_next(p)) {
+        obj_index_put(data, container_of(p, struct obj_node, node));
+    }
+
+    return 0;
+}
+
+/* called after the node was linked to the rbtree */
+static void
+obj_index_add(variant_obj_t data, struct obj_node *node)
+{
+    if (data->index == NULL) {
+        /* still work without the index if failed to build it */
+        if (data->size > OBJ_INDEX_THRESHOLD)
+            obj_index_rebuild(data);
+    }
+    else if ((data->index_used + 1) * 4 > data->index_size * 3) {
+        if (obj_index_rebuild(data))
+            obj_index_drop(data);
+    }
+    else {
+        obj_index_put(data, node);
+    }
+}
+
+static void
+obj_unlink_node(variant_obj_t data, struct obj_node *node)
+{
+    --data->size;
+    pcutils_rbtree_erase(&node->node, &data->kvs);
+    node->node.rb_parent = NULL;
+
+    if (data->index)
+        obj_index_remove(data, node);
+}
+
+static struct obj_node *
+obj_find_node(variant_obj_t data, const char *key)
+{
+    if (data->index)
+        return obj_index_find(data, key, obj_key_hash(key));
+
+    struct rb_node *entry = data->kvs.rb_node;
+    while (entry) {
+        struct obj_node *node;
+        node = container_of(entry, struct obj_node, node);
+        const char *sk = purc_variant_get_string_const(node->key);
+
+        int ret = (sk == key) ? 0 : strcmp(key, sk);
+        if (ret < 0)
+            entry = entry->rb_left;
+        else if (ret > 0)
+            entry = entry->rb_right;
+        else
+            return node;
+    }
+
+    return NULL;
+}
+
 static void
 obj_node_release(purc_variant_t obj, struct obj_node *node)
 {
@@ -183,9 +365,7 @@ obj_node_release(purc_variant_t obj, struct obj_node *node)
 
     struct rb_root *root = &data->kvs;
     if (&node->node == root->rb_node || node->node.rb_parent) {
-        --data->size;
-        pcutils_rbtree_erase(&node->node, root);
-        node->node.rb_parent = NULL;
+        obj_unlink_node(data, node);
     }
 
     PURC_VARIANT_SAFE_CLEAR(node->key);
@@ -200,7 +380,7 @@ obj_node_destroy(purc_variant_t obj, struct obj_node *node)
 
     obj_node_release(obj, node);
 
-    free(node);
+    pcvariant_slab_delete(struct obj_node, node);
 }
 
 static struct obj_node*
@@ -212,7 +392,7 @@ obj_node_create(purc_variant_t k, purc_variant_t v)
     }
 
     struct obj_node *node;
-    node = (struct obj_node*)calloc(1, sizeof(*node));
+    node = pcvariant_slab_new(struct obj_node);
     if (!node) {
         pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
         return NULL;
@@ -220,6 +400,7 @@ obj_node_create(purc_variant_t k, purc_variant_t v)
 
     node->key = purc_variant_ref(k);
     node->val = purc_variant_ref(v);
+    node->key_hash = pcvariant_string_hash(k);
 
     return node;
 }
@@ -295,29 +476,8 @@ v_object_remove(purc_variant_t obj, const char *key, bool silently,
         bool check)
 {
     variant_obj_t data = pcvar_obj_get_data(obj);
-    struct rb_root *root = &data->kvs;
-    struct rb_node **pnode = &root->rb_node;
-    struct rb_node *parent = NULL;
-    struct rb_node *entry = NULL;
-    while (*pnode) {
-        struct obj_node *node;
-        node = container_of(*pnode, struct obj_node, node);
-        const char *sk = purc_variant_get_string_const(node->key);
-        int ret = strcmp(key, sk);
-
-        parent = *pnode;
-
-        if (ret < 0)
-            pnode = &parent->rb_left;
-        else if (ret > 0)
-            pnode = &parent->rb_right;
-        else{
-            entry = *pnode;
-            break;
-        }
-    }
-
-    if (!entry) {
+    struct obj_node *node = obj_find_node(data, key);
+    if (!node) {
         if (silently)
             return 0;
 
@@ -325,8 +485,6 @@ v_object_remove(purc_variant_t obj, const char *key, bool silently,
         return -1;
     }
 
-    struct obj_node *node;
-    node = container_of(entry, struct obj_node, node);
     purc_variant_t k = node->key;
     purc_variant_t v = node->val;
 
@@ -341,10 +499,8 @@ v_object_remove(purc_variant_t obj, const char *key, bool silently,
             break_rev_update_chain(obj, node);
         }
 
-        --data->size;
-        PC_ASSERT(entry == root->rb_node || entry->rb_parent);
-        pcutils_rbtree_erase(entry, root);
-        entry->rb_parent = NULL;
+        PC_ASSERT(&node->node == data->kvs.rb_node || node->node.rb_parent);
+        obj_unlink_node(data, node);
 
         if (check) {
             pcvar_adjust_set_by_descendant(obj);
@@ -477,11 +633,19 @@ v_object_set(purc_variant_t obj, purc_variant_t key, purc_variant_t val,
     struct rb_node **pnode = &root->rb_node;
     struct rb_node *parent = NULL;
     struct rb_node *entry = NULL;
-    while (*pnode) {
+    if (data->index) {
+        struct obj_node *node = obj_index_find(data, sk,
+                pcvariant_string_hash(key));
+        if (node)
+            entry = &node->node;
+    }
+
+    /* look for the position to insert the new node */
+    while (entry == NULL && *pnode) {
         struct obj_node *node;
         node = container_of(*pnode, struct obj_node, node);
         const char *sko = purc_variant_get_string_const(node->key);
-        int ret = strcmp(sk, sko);
+        int ret = (sk == sko) ? 0 : strcmp(sk, sko);
 
         parent = *pnode;
 
@@ -515,6 +679,7 @@ v_object_set(purc_variant_t obj, purc_variant_t key, purc_variant_t val,
             pcutils_rbtree_insert_color(entry, root);
 
             ++data->size;
+            obj_index_add(data, node);
 
             if (check) {
                 if (build_rev_update_chain(obj, node))
@@ -754,6 +919,9 @@ void pcvariant_object_release (purc_variant_t value)
 
     struct rb_root *root = &data->kvs;
 
+    /* no need to maintain the index when destroying all nodes */
+    obj_index_drop(data);
+
     struct rb_node *p, *n;
     pcutils_rbtree_for_each_safe(pcutils_rbtree_first(root), p, n) {
         struct obj_node *node;
@@ -767,7 +935,7 @@ void pcvariant_object_release (purc_variant_t value)
         data->rev_update_chain = NULL;
     }
 
-    free(data);
+    pcvariant_slab_delete(struct variant_obj, data);
 
     value->sz_ptr[1] = (uintptr_t)NULL; // say no to double free
 
@@ -804,38 +972,13 @@ purc_variant_object_get_by_ckey(purc_variant_t obj, const char* key)
         PURC_VARIANT_INVALID);
 
     variant_obj_t data = pcvar_obj_get_data(obj);
-    struct rb_root *root = &data->kvs;
-
-    struct rb_node **pnode = &root->rb_node;
-    struct rb_node *parent = NULL;
-    struct rb_node *entry = NULL;
-    while (*pnode) {
-        struct obj_node *node;
-        node = container_of(*pnode, struct obj_node, node);
-        const char *sk = purc_variant_get_string_const(node->key);
-
-        int ret = strcmp(key, sk);
-
-        parent = *pnode;
-
-        if (ret < 0)
-            pnode = &parent->rb_left;
-        else if (ret > 0)
-            pnode = &parent->rb_right;
-        else{
-            entry = *pnode;
-            break;
-        }
-    }
-
-    if (!entry) {
+    struct obj_node *node = obj_find_node(data, key);
+    if (!node) {
         pcinst_set_error(PCVARIANT_ERROR_NOT_FOUND);
 
         return PURC_VARIANT_INVALID;
     }
 
-    struct obj_node *node;
-    node = container_of(entry, struct obj_node, node);
     return node->val;
 }
 
@@ -933,6 +1076,29 @@ purc_variant_object_make_iterator_end (purc_variant_t object) {
     return it;
 }
 
+purc_variant_t
+pcvariant_object_lower_bound(purc_variant_t object, const char *key,
+        bool after, purc_variant_t *found_key)
+{
+    PCVARIANT_CHECK_FAIL_RET((object && object->type==PVT(_OBJECT) &&
+        object->sz_ptr[1] && key),
+        PURC_VARIANT_INVALID);
+
+    struct obj_iterator obj_it = pcvar_obj_it_lower_bound(object, key);
+    if (after && obj_it.curr &&
+            strcmp(purc_variant_get_string_const(obj_it.curr->key), key) == 0)
+        pcvar_obj_it_next(&obj_it);
+
+    if (obj_it.curr == NULL) {
+        pcinst_set_error(PCVARIANT_ERROR_NOT_FOUND);
+        return PURC_VARIANT_INVALID;
+    }
+
+    if (found_key)
+        *found_key = obj_it.curr->key;
+    return obj_it.curr->val;
+}
+
 void
 purc_variant_object_release_iterator (struct purc_variant_object_iterator* it)
 {
@@ -1017,10 +1183,10 @@ pcvariant_object_clone(purc_variant_t obj, bool recursively)
             purc_variant_unref(var);
             return PURC_VARIANT_INVALID;
         }
-        bool ok;
-        ok = purc_variant_object_set(var, k, val);
+        /* the clone belongs to no set and has no listener */
+        int r = pcvar_obj_set(var, k, val);
         purc_variant_unref(val);
-        if (!ok) {
+        if (r) {
             purc_variant_unref(var);
             return PURC_VARIANT_INVALID;
         }
@@ -1065,7 +1231,7 @@ pcvar_object_break_edge_to_parent(purc_variant_t obj,
     if (!data->rev_update_chain)
         return;
 
-    pcutils_map_erase(data->rev_update_chain, edge->obj_me);
+    pcutils_ptrmap_erase(data->rev_update_chain, edge->obj_me);
 }
 
 int
@@ -1111,13 +1277,11 @@ pcvar_object_build_edge_to_parent(purc_variant_t obj,
             return -1;
     }
 
-    pcutils_map_entry *entry;
-    entry = pcutils_map_find(data->rev_update_chain, edge->obj_me);
-    if (entry)
+    if (pcutils_ptrmap_find(data->rev_update_chain, edge->obj_me))
         return 0;
 
     int r;
-    r = pcutils_map_insert(data->rev_update_chain,
+    r = pcutils_ptrmap_set(data->rev_update_chain,
             edge->obj_me, edge->parent);
 
     return r ? -1 : 0;
@@ -1176,6 +1340,39 @@ pcvar_obj_it_first(purc_variant_t obj)
     return it;
 }
 
+// the members are ordered by strcmp() of the keys in the tree
+struct obj_iterator
+pcvar_obj_it_lower_bound(purc_variant_t obj, const char *key)
+{
+    struct obj_iterator it = {
+        .obj         = obj,
+    };
+    if (obj == PURC_VARIANT_INVALID)
+        return it;
+
+    variant_obj_t data = pcvar_obj_get_data(obj);
+    struct rb_node *entry = data->kvs.rb_node;
+    struct rb_node *found = NULL;
+    while (entry) {
+        struct obj_node *node;
+        node = container_of(entry, struct obj_node, node);
+        const char *sk = purc_variant_get_string_const(node->key);
+
+        if (strcmp(sk, key) >= 0) {
+            found = entry;
+            entry = entry->rb_left;
+        }
+        else {
+            entry = entry->rb_right;
+        }
+    }
+
+    if (found)
+        it_refresh(&it, found);
+
+    return it;
+}
+
 struct obj_iterator
 pcvar_obj_it_last(purc_variant_t obj)
 {
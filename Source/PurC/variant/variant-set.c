@@ -27,6 +27,7 @@
 #include "config.h"
 #include "private/variant.h"
 #include "private/list.h"
+#include "private/btree.h"
 #include "private/hashtable.h"
 #include "private/errors.h"
 #include "private/stringbuilder.h"
@@ -35,10 +36,15 @@
 
 
 #include <limits.h>
+#include <math.h>
 #include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
 
+#define SET_INDEX_THRESHOLD     16
+#define SET_INDEX_MIN_SIZE      64
+#define SET_INDEX_REMOVED       ((struct set_node *)(uintptr_t)1)
+
 static bool
 grow(purc_variant_t set, purc_variant_t value,
         bool check)
@@ -140,6 +146,7 @@ variant_set_get_extra_size(variant_set_t data)
 
     extra += sz_record * count;
     extra += sizeof(struct set_node*)*(data->al.nr);
+    extra += sizeof(struct set_node*)*(data->index_size);
 
     return extra;
 }
@@ -150,71 +157,6 @@ pcv_set_set_data(purc_variant_t set, variant_set_t data)
     set->sz_ptr[1]     = (uintptr_t)data;
 }
 
-static int
-obj_node_diff(struct obj_node *l, struct obj_node *r)
-{
-    int diff = 0;
-
-    purc_variant_t lk, rk;
-    lk = l->key;
-    rk = r->key;
-    PC_ASSERT(lk);
-    PC_ASSERT(rk);
-
-    if (lk != rk) {
-        diff = pcvariant_diff(lk, rk);
-        if (diff)
-            return diff;
-    }
-
-    purc_variant_t lv, rv;
-    lv = l->val;
-    rv = r->val;
-    PC_ASSERT(lv);
-    PC_ASSERT(rv);
-
-    if (lv != rv) {
-        diff = pcvariant_diff(lv, rv);
-    }
-
-    return diff;
-}
-
-static int
-variant_set_compare_by_set_keys(purc_variant_t set,
-        purc_variant_t l, purc_variant_t r)
-{
-    PC_ASSERT(set != PURC_VARIANT_INVALID);
-    PC_ASSERT(purc_variant_is_set(set));
-    PC_ASSERT(l != PURC_VARIANT_INVALID);
-    PC_ASSERT(r != PURC_VARIANT_INVALID);
-    PC_ASSERT(pcvariant_is_mutable(l));
-    PC_ASSERT(pcvariant_is_mutable(r));
-
-    int diff;
-
-    struct kv_iterator lit, rit;
-    lit = pcvar_kv_it_first(set, l);
-    rit = pcvar_kv_it_first(set, r);
-    while (1) {
-        struct obj_node *ln = lit.it.curr;
-        struct obj_node *rn = rit.it.curr;
-        if (ln == NULL && rn == NULL)
-            return 0;
-        if (ln == NULL)
-            return -1;
-        if (rn == NULL)
-            return 1;
-
-        diff = obj_node_diff(ln, rn);
-        if (diff)
-            return diff;
-
-        pcvar_kv_it_next(&lit);
-        pcvar_kv_it_next(&rit);
-    }
-}
-
 static int
 variant_set_init(variant_set_t data, const char *unique_key, bool caseless)
 {
@@ -281,7 +223,7 @@ pcv_set_new(void)
     set->type          = PVT(_SET);
     set->flags         = PCVARIANT_FLAG_EXTRA_SIZE;
 
-    variant_set_t data  = (variant_set_t)calloc(1, sizeof(*data));
+    variant_set_t data  = pcvariant_slab_new(struct variant_set);
     pcv_set_set_data(set, data);
 
     if (!data) {
@@ -358,6 +300,7 @@ struct element_rb_node {
     struct rb_node     **pnode;
     struct rb_node      *parent;
     struct rb_node      *entry;
+    uint64_t             hash;
 };
 
 static int
@@ -435,6 +378,352 @@ _compare(purc_variant_t _new, purc_variant_t _old,
     return _compare_by_unique_keys(_new, _old, data);
 }
 
+static struct set_node *
+set_index_find(variant_set_t data, purc_variant_t kvs, uint64_t hash)
+{
+    size_t mask = data->index_size - 1;
+    size_t i = hash & mask;
+    struct set_node *node;
+
+    while ((node = data->index[i])) {
+        if (node != SET_INDEX_REMOVED && node->hash == hash &&
+                _compare(kvs, node->val, data) == 0)
+            return node;
+        i = (i + 1) & mask;
+    }
+
+    return NULL;
+}
+
+/* the element must not be in the index */
+static void
+set_index_put(variant_set_t data, struct set_node *node)
+{
+    size_t mask = data->index_size - 1;
+    size_t i = node->hash & mask;
+
+    while (data->index[i] && data->index[i] != SET_INDEX_REMOVED)
+        i = (i + 1) & mask;
+
+    if (data->index[i] == NULL)
+        data->index_used++;
+    data->index[i] = node;
+}
+
+static void
+set_index_remove(variant_set_t data, struct set_node *node)
+{
+    size_t mask = data->index_size - 1;
+    size_t i = node->hash & mask;
+
+    while (data->index[i] != node) {
+        PC_ASSERT(data->index[i]);
+        i = (i + 1) & mask;
+    }
+
+    data->index[i] = SET_INDEX_REMOVED;
+}
+
+static void
+set_index_drop(variant_set_t data)
+{
+    free(data->index);
+    data->index = NULL;
+    data->index_size = 0;
+    data->index_used = 0;
+}
+
+static int
+set_index_rebuild(variant_set_t data)
+{
+    size_t count = pcutils_array_list_length(&data->al);
+    size_t size = SET_INDEX_MIN_SIZE;
+    while (size < count * 2)
+        size <<= 1;
+
+    struct set_node **index = calloc(size, sizeof(*index));
+    if (index == NULL)
+        return -1;
+
+    free(data->index);
+    data->index = index;
+    data->index_size = size;
+    data->index_used = 0;
+
+    struct rb_node *p = pcutils_rbtree_first(&data->elems);
+    for (; p; p = pcutils_rbtree_next(p)) {
+        set_index_put(data, container_of(p, struct set_node, rbnode));
+    }
+
+    return 0;
+}
+
+/* called after the element was linked to the rbtree */
+static void
+set_index_add(variant_set_t data, struct set_node *node)
+{
+    if (data->index == NULL) {
+        /* still work without the index if failed to build it */
+        if (pcutils_array_list_length(&data->al) > SET_INDEX_THRESHOLD)
+            set_index_rebuild(data);
+    }
+    else if ((data->index_used + 1) * 4 > data->index_size * 3) {
+        if (set_index_rebuild(data))
+            set_index_drop(data);
+    }
+    else {
+        set_index_put(data, node);
+    }
+}
+
+/*
+ * A secondary index is a B-tree of the entries of the elements, ordered
+ * by the class and then the value of their member; the entries of
+ * an element are chained to the set node, so they can be removed without
+ * the old value of the member.
+ */
+enum sindex_class {
+    SINDEX_ABSENT = 0,          // no such member, or NaN
+    SINDEX_NUMBER,
+    SINDEX_STRING,
+    SINDEX_OTHER,
+    SINDEX_NR_CLASSES,
+};
+
+struct set_sindex_entry {
+    struct set_sindex          *sindex;
+    struct set_node            *node;
+    struct set_sindex_entry    *next;       // the next one of the node
+
+    enum sindex_class           cls;
+    double                      number;
+    purc_variant_t              str;        // referenced
+};
+
+struct set_sindex {
+    char                       *keyname;
+    pcutils_btree               entries;
+    size_t                      nr_entries[SINDEX_NR_CLASSES];
+    struct set_sindex          *next;
+};
+
+struct sindex_key {
+    enum sindex_class           cls;
+    double                      number;
+    const char                 *str;
+};
+
+static void
+sindex_classify(purc_variant_t v, struct sindex_key *key)
+{
+    key->cls = SINDEX_ABSENT;
+    key->number = 0;
+    key->str = NULL;
+
+    if (v == PURC_VARIANT_INVALID)
+        return;
+
+    if (pcvariant_is_of_number(v)) {
+        key->number = purc_variant_numberify(v);
+        if (!isnan(key->number))
+            key->cls = SINDEX_NUMBER;
+    }
+    else if (v->type == PURC_VARIANT_TYPE_STRING ||
+            v->type == PURC_VARIANT_TYPE_ATOMSTRING) {
+        key->str = purc_variant_get_string_const(v);
+        key->cls = SINDEX_STRING;
+    }
+    else {
+        key->cls = SINDEX_OTHER;
+    }
+}
+
+static purc_variant_t
+sindex_get_member(purc_variant_t val, const char *keyname)
+{
+    if (!purc_variant_is_object(val))
+        return PURC_VARIANT_INVALID;
+
+    purc_variant_t v = purc_variant_object_get_by_ckey(val, keyname);
+    if (v == PURC_VARIANT_INVALID)
+        purc_clr_error();
+    return v;
+}
+
+static int
+sindex_compare_key(const struct set_sindex_entry *entry,
+        const struct sindex_key *key)
+{
+    if (entry->cls != key->cls)
+        return (int)entry->cls - (int)key->cls;
+
+    switch (entry->cls) {
+    case SINDEX_NUMBER:
+        return (entry->number > key->number) - (entry->number < key->number);
+    case SINDEX_STRING:
+        return strcmp(purc_variant_get_string_const(entry->str), key->str);
+    default:
+        return 0;
+    }
+}
+
+static int
+sindex_compare(const struct set_sindex_entry *l,
+        const struct set_sindex_entry *r)
+{
+    struct sindex_key key = {
+        .cls = r->cls,
+        .number = r->number,
+        .str = r->str ? purc_variant_get_string_const(r->str) : NULL,
+    };
+
+    int diff = sindex_compare_key(l, &key);
+    if (diff)
+        return diff;
+
+    /* the elements having the same value are ordered by the nodes */
+    return ((uintptr_t)l->node > (uintptr_t)r->node) -
+        ((uintptr_t)l->node < (uintptr_t)r->node);
+}
+
+static void
+sindex_free_entry(struct set_sindex_entry *entry)
+{
+    PURC_VARIANT_SAFE_CLEAR(entry->str);
+    free(entry);
+}
+
+static int
+sindex_btree_compare(const void *item, const void *key, void *ctxt)
+{
+    (void)ctxt;
+    return sindex_compare(item, key);
+}
+
+static int
+sindex_btree_compare_key(const void *item, const void *key, void *ctxt)
+{
+    (void)ctxt;
+    return sindex_compare_key(item, key);
+}
+
+static int
+sindex_add_entry(struct set_sindex *sindex, struct set_node *node)
+{
+    struct set_sindex_entry *entry = calloc(1, sizeof(*entry));
+    if (entry == NULL)
+        return -1;
+
+    struct sindex_key key;
+    purc_variant_t v = sindex_get_member(node->val, sindex->keyname);
+    sindex_classify(v, &key);
+
+    entry->sindex = sindex;
+    entry->node = node;
+    entry->cls = key.cls;
+    entry->number = key.number;
+    if (key.cls == SINDEX_STRING)
+        entry->str = purc_variant_ref(v);
+
+    /* the entries are unique since they are ordered by the nodes at last */
+    if (pcutils_btree_insert(&sindex->entries, entry)) {
+        sindex_free_entry(entry);
+        return -1;
+    }
+    sindex->nr_entries[entry->cls]++;
+
+    entry->next = node->sindex_entries;
+    node->sindex_entries = entry;
+    return 0;
+}
+
+static void
+sindex_unlink_free_entry(void *item, void *ctxt)
+{
+    (void)ctxt;
+    struct set_sindex_entry *entry = item;
+
+    /* unlink it from the entries of the node */
+    struct set_sindex_entry **pe = &entry->node->sindex_entries;
+    while (*pe != entry)
+        pe = &(*pe)->next;
+    *pe = entry->next;
+
+    sindex_free_entry(entry);
+}
+
+static void
+sindex_destroy(struct set_sindex *sindex)
+{
+    pcutils_btree_clear(&sindex->entries, sindex_unlink_free_entry);
+    free(sindex->keyname);
+    free(sindex);
+}
+
+/* drops the index and unlinks it from the set */
+static void
+sindex_drop(variant_set_t data, struct set_sindex *sindex)
+{
+    struct set_sindex **ps = &data->sindexes;
+    while (*ps != sindex)
+        ps = &(*ps)->next;
+    *ps = sindex->next;
+
+    sindex_destroy(sindex);
+}
+
+static void
+sindexes_drop_all(variant_set_t data)
+{
+    while (data->sindexes)
+        sindex_drop(data, data->sindexes);
+}
+
+/* called after the element was added, or changed */
+static void
+sindexes_add_node(variant_set_t data, struct set_node *node)
+{
+    struct set_sindex *sindex = data->sindexes;
+    while (sindex) {
+        struct set_sindex *next = sindex->next;
+
+        /* still work without the index if failed to update it */
+        if (sindex_add_entry(sindex, node))
+            sindex_drop(data, sindex);
+        sindex = next;
+    }
+}
+
+/* called before the element is removed, or changed */
+static void
+sindexes_remove_node(struct set_node *node)
+{
+    struct set_sindex_entry *entry = node->sindex_entries;
+    while (entry) {
+        struct set_sindex_entry *next = entry->next;
+        struct set_sindex *sindex = entry->sindex;
+
+        pcutils_btree_erase(&sindex->entries, entry);
+        sindex->nr_entries[entry->cls]--;
+        sindex_free_entry(entry);
+        entry = next;
+    }
+
+    node->sindex_entries = NULL;
+}
+
+static struct set_sindex *
+sindex_find(variant_set_t data, const char *keyname)
+{
+    struct set_sindex *sindex = data->sindexes;
+    for (; sindex; sindex = sindex->next) {
+        if (strcmp(sindex->keyname, keyname) == 0)
+            return sindex;
+    }
+
+    return NULL;
+}
+
 static void
 find_element_rb_node(struct element_rb_node *node,
         purc_variant_t set, purc_variant_t kvs)
@@ -444,22 +733,24 @@ find_element_rb_node(struct element_rb_node *node,
     struct rb_node **pnode = &root->rb_node;
     struct rb_node *parent = NULL;
     struct rb_node *entry = NULL;
-    char md5[33];
-    pcvariant_md5_by_set(md5, kvs, set);
 
+    node->hash = pcvariant_hash_by_set(kvs, set);
+    if (data->index) {
+        struct set_node *found;
+        found = set_index_find(data, kvs, node->hash);
+        if (found) {
+            node->pnode  = NULL;
+            node->parent = NULL;
+            node->entry  = &found->rbnode;
+            return;
+        }
+    }
+
+    /* descend the tree for the position of a new element */
     while (*pnode) {
         struct set_node *on;
         on = container_of(*pnode, struct set_node, rbnode);
-        int diff;
-        if (0) {
-            diff = variant_set_compare_by_set_keys(set, kvs, on->val);
-        }
-        else if (0) {
-            diff = pcvariant_diff_by_set(md5, kvs, on->md5, on->val, set);
-        }
-        else {
-            diff = _compare(kvs, on->val, data);
-        }
+        int diff = _compare(kvs, on->val, data);
 
         parent = *pnode;
 
@@ -483,6 +774,14 @@ find_element_rb_node(struct element_rb_node *node,
 static struct set_node*
 find_element(purc_variant_t set, purc_variant_t kvs)
 {
+    variant_set_t data = pcvar_set_get_data(set);
+
+    /* the hash of a caseless set folds the ASCII letters only, so
+       the tree is descended again if the index does not have the value */
+    if (data->index && !data->caseless) {
+        return set_index_find(data, kvs, pcvariant_hash_by_set(kvs, set));
+    }
+
     struct element_rb_node node;
     find_element_rb_node(&node, set, kvs);
 
@@ -574,6 +873,9 @@ elem_node_remove(purc_variant_t set, struct set_node *node)
     PC_ASSERT(data);
 
     pcutils_rbtree_erase(&node->rbnode, &data->elems);
+    if (data->index)
+        set_index_remove(data, node);
+    sindexes_remove_node(node);
 
     int r;
     struct pcutils_array_list_node *old;
@@ -603,7 +905,7 @@ elem_node_destroy(purc_variant_t set, struct set_node *node)
         return;
 
     elem_node_release(set, node);
-    free(node);
+    pcvariant_slab_delete(struct set_node, node);
 }
 
 static int
@@ -618,9 +920,17 @@ elem_node_replace(purc_variant_t set, struct set_node *node,
         elem_node_revoke_constraints(set, node);
     }
 
+    /* the other members of the element may be changed */
+    variant_set_t data = pcvar_set_get_data(set);
+    bool indexed = (node->alnode.idx != (size_t)-1 && data->sindexes);
+    if (indexed)
+        sindexes_remove_node(node);
+
     PURC_VARIANT_SAFE_CLEAR(node->val);
 
     node->val = val;
+    if (indexed)
+        sindexes_add_node(data, node);
 
     if (check) {
         if (!elem_node_setup_constraints(set, node))
@@ -651,7 +961,9 @@ variant_set_release_elems(purc_variant_t set, variant_set_t data)
 static void
 variant_set_release(purc_variant_t set, variant_set_t data)
 {
+    sindexes_drop_all(data);
     variant_set_release_elems(set, data);
+    set_index_drop(data);
 
     if (data->rev_update_chain) {
         pcvar_destroy_rev_update_chain(data->rev_update_chain);
@@ -704,19 +1016,19 @@ variant_set_create_kvs_n(variant_set_t set, purc_variant_t v1, va_list ap)
 }
 
 static struct set_node*
-variant_set_create_elem_node(purc_variant_t set, purc_variant_t val)
+variant_set_create_elem_node(purc_variant_t set, purc_variant_t val,
+        uint64_t hash)
 {
     variant_set_t data = pcvar_set_get_data(set);
     PC_ASSERT(data);
 
-    struct set_node *_new = (struct set_node*)calloc(1, sizeof(*_new));
+    struct set_node *_new = pcvariant_slab_new(struct set_node);
     if (!_new) {
         pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
         return NULL;
     }
 
-    pcvariant_md5_by_set(_new->md5, val, set);
-
+    _new->hash = hash;
     _new->alnode.idx = (size_t)-1;
     _new->val = val;
     purc_variant_ref(val);
@@ -840,8 +1152,7 @@ check_grow(purc_variant_t set, purc_variant_t val)
 
 static int
 insert(purc_variant_t set, variant_set_t data,
-        purc_variant_t val,
-        struct rb_node *parent, struct rb_node **pnode,
+        purc_variant_t val, struct element_rb_node *rbn,
         bool check)
 {
     struct set_node *node = NULL;
@@ -855,7 +1166,7 @@ insert(purc_variant_t set, variant_set_t data,
                 break;
         }
 
-        node = variant_set_create_elem_node(set, val);
+        node = variant_set_create_elem_node(set, val, rbn->hash);
         if (!node)
             break;
 
@@ -870,8 +1181,10 @@ insert(purc_variant_t set, variant_set_t data,
 
         struct rb_node *entry = &node->rbnode;
 
-        pcutils_rbtree_link_node(entry, parent, pnode);
+        pcutils_rbtree_link_node(entry, rbn->parent, rbn->pnode);
         pcutils_rbtree_insert_color(entry, &data->elems);
+        set_index_add(data, node);
+        sindexes_add_node(data, node);
 
         if (check) {
             if (!elem_node_setup_constraints(set, node))
@@ -905,7 +1218,7 @@ pcvar_set_add(purc_variant_t set, purc_variant_t val)
     }
 
     bool check = false;
-    return insert(set, data, val, rbn.parent, rbn.pnode, check);
+    return insert(set, data, val, &rbn, check);
 }
 
 static int
@@ -963,7 +1276,7 @@ insert_or_replace(purc_variant_t set,
     find_element_rb_node(&rbn, set, val);
 
     if (!rbn.entry) {
-        int r = insert(set, data, val, rbn.parent, rbn.pnode, check);
+        int r = insert(set, data, val, &rbn, check);
 
         return r ? -1 : 0;
     }
@@ -1350,6 +1663,8 @@ struct purc_variant_set_iterator {
     struct rb_node     *prev, *next;
 };
 
+/* the neighbors are NULL at both ends, so no lookup of the first or the
+   last element is needed for every step */
 static void
 iterator_refresh(struct purc_variant_set_iterator *it)
 {
@@ -1358,26 +1673,9 @@ iterator_refresh(struct purc_variant_set_iterator *it)
         it->prev = NULL;
         return;
     }
-    variant_set_t data = pcvar_set_get_data(it->set);
-    size_t count = pcutils_array_list_length(&data->al);
-    if (count==0) {
-        it->next = NULL;
-        it->prev = NULL;
-        return;
-    }
-    struct rb_node *first, *last;
-    first = pcutils_rbtree_first(&data->elems);
-    last  = pcutils_rbtree_last(&data->elems);
-    if (it->curr == first) {
-        it->prev = NULL;
-    } else {
-        it->prev = pcutils_rbtree_prev(it->curr);
-    }
-    if (it->curr == last) {
-        it->next = NULL;
-    } else {
-        it->next = pcutils_rbtree_next(it->curr);
-    }
+
+    it->prev = pcutils_rbtree_prev(it->curr);
+    it->next = pcutils_rbtree_next(it->curr);
 }
 
 struct purc_variant_set_iterator*
@@ -1505,7 +1803,7 @@ pcvariant_set_release(purc_variant_t value)
     PC_ASSERT(data);
 
     variant_set_release(value, data);
-    free(data);
+    pcvariant_slab_delete(struct variant_set, data);
     pcv_set_set_data(value, NULL);
 
     pcvariant_stat_set_extra_size(value, 0);
@@ -1573,6 +1871,11 @@ int pcvariant_set_sort(purc_variant_t value, void *ud,
 {
     PC_ASSERT(value != PURC_VARIANT_INVALID);
 
+    if (pcvariant_is_immutable(value)) {
+        pcinst_set_error(PURC_ERROR_ACCESS_DENIED);
+        return -1;
+    }
+
     variant_set_t data = pcvar_set_get_data(value);
     struct pcutils_array_list *al = &data->al;
 
@@ -1618,6 +1921,152 @@ int pcvariant_set_get_uniqkeys(purc_variant_t set, size_t *nr_keynames,
     return 0;
 }
 
+int
+pcvariant_set_create_index(purc_variant_t set, const char *keyname)
+{
+    PCVARIANT_CHECK_FAIL_RET(set && set->type==PVT(_SET) && keyname, -1);
+
+    variant_set_t data = pcvar_set_get_data(set);
+    PC_ASSERT(data);
+
+    if (sindex_find(data, keyname))
+        return 0;
+
+    struct set_sindex *sindex = calloc(1, sizeof(*sindex));
+    if (sindex == NULL || (sindex->keyname = strdup(keyname)) == NULL) {
+        free(sindex);
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    pcutils_btree_init(&sindex->entries, sindex_btree_compare, NULL);
+    sindex->next = data->sindexes;
+    data->sindexes = sindex;
+
+    struct pcutils_array_list *al = &data->al;
+    size_t nr = pcutils_array_list_length(al);
+    for (size_t i = 0; i < nr; i++) {
+        struct set_node *node;
+        node = container_of(pcutils_array_list_get(al, i),
+                struct set_node, alnode);
+        if (sindex_add_entry(sindex, node)) {
+            sindex_drop(data, sindex);
+            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int
+pcvariant_set_drop_index(purc_variant_t set, const char *keyname)
+{
+    PCVARIANT_CHECK_FAIL_RET(set && set->type==PVT(_SET) && keyname, -1);
+
+    variant_set_t data = pcvar_set_get_data(set);
+    struct set_sindex *sindex = sindex_find(data, keyname);
+    if (sindex == NULL) {
+        pcinst_set_error(PURC_ERROR_NOT_EXISTS);
+        return -1;
+    }
+
+    sindex_drop(data, sindex);
+    return 0;
+}
+
+bool
+pcvariant_set_has_index(purc_variant_t set, const char *keyname)
+{
+    PCVARIANT_CHECK_FAIL_RET(set && set->type==PVT(_SET) && keyname, false);
+
+    return sindex_find(pcvar_set_get_data(set), keyname) != NULL;
+}
+
+static int
+compare_positions(const void *l, const void *r)
+{
+    size_t a = *(const size_t *)l;
+    size_t b = *(const size_t *)r;
+    return (a > b) - (a < b);
+}
+
+int
+pcvariant_set_index_lookup(purc_variant_t set, const char *keyname,
+        purc_variant_t lo, bool lo_incl, purc_variant_t hi, bool hi_incl,
+        size_t **positions, size_t *nr_positions)
+{
+    PCVARIANT_CHECK_FAIL_RET(set && set->type==PVT(_SET) && keyname &&
+            (lo || hi) && positions && nr_positions, -1);
+
+    variant_set_t data = pcvar_set_get_data(set);
+    struct set_sindex *sindex = sindex_find(data, keyname);
+    if (sindex == NULL) {
+        pcinst_set_error(PURC_ERROR_NOT_EXISTS);
+        return -1;
+    }
+
+    struct sindex_key start, end;
+    if (lo)
+        sindex_classify(lo, &start);
+    if (hi)
+        sindex_classify(hi, &end);
+
+    enum sindex_class cls = lo ? start.cls : end.cls;
+    if ((cls != SINDEX_NUMBER && cls != SINDEX_STRING) ||
+            (lo && hi && start.cls != end.cls)) {
+        pcinst_set_error(PURC_ERROR_INVALID_VALUE);
+        return -1;
+    }
+
+    for (int c = SINDEX_NUMBER; c < SINDEX_NR_CLASSES; c++) {
+        if (c != (int)cls && sindex->nr_entries[c] > 0) {
+            pcinst_set_error(PURC_ERROR_NOT_SUPPORTED);
+            return -1;
+        }
+    }
+
+    if (!lo) {
+        /* the least value of the class */
+        start.cls = cls;
+        start.number = -INFINITY;
+        start.str = "";
+        lo_incl = true;
+    }
+
+    size_t *found = malloc(sizeof(*found) *
+            (sindex->nr_entries[cls] ? sindex->nr_entries[cls] : 1));
+    if (found == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    /* the first entry after the lower bound */
+    pcutils_btree_iter it;
+    struct set_sindex_entry *entry;
+    entry = pcutils_btree_seek(&sindex->entries, &it, &start,
+            sindex_btree_compare_key, !lo_incl);
+
+    size_t nr = 0;
+    for (; entry; entry = pcutils_btree_next(&it)) {
+        if (entry->cls != cls)
+            break;
+
+        if (hi) {
+            int diff = sindex_compare_key(entry, &end);
+            if (diff > 0 || (diff == 0 && !hi_incl))
+                break;
+        }
+
+        found[nr++] = entry->node->alnode.idx;
+    }
+
+    qsort(found, nr, sizeof(*found), compare_positions);
+    *positions = found;
+    *nr_positions = nr;
+    return 0;
+}
+
 purc_variant_t
 pcvariant_set_clone(purc_variant_t set, bool recursively)
 {
@@ -1666,7 +2115,7 @@ pcvar_set_break_edge_to_parent(purc_variant_t set,
     if (!data->rev_update_chain)
         return;
 
-    pcutils_map_erase(data->rev_update_chain, edge->set_me);
+    pcutils_ptrmap_erase(data->rev_update_chain, edge->set_me);
 }
 
 int
@@ -1684,13 +2133,11 @@ pcvar_set_build_edge_to_parent(purc_variant_t set,
             return -1;
     }
 
-    pcutils_map_entry *entry;
-    entry = pcutils_map_find(data->rev_update_chain, edge->set_me);
-    if (entry)
+    if (pcutils_ptrmap_find(data->rev_update_chain, edge->set_me))
         return 0;
 
     int r;
-    r = pcutils_map_insert(data->rev_update_chain,
+    r = pcutils_ptrmap_set(data->rev_update_chain,
             edge->set_me, edge->parent);
 
     return r ? -1 : 0;
@@ -2091,6 +2538,9 @@ pcvar_readjust_set(purc_variant_t set, struct set_node *node)
     variant_set_t data = pcvar_set_get_data(set);
 
     pcutils_rbtree_erase(&node->rbnode, &data->elems);
+    /* the hash of the element changed with its content */
+    if (data->index)
+        set_index_remove(data, node);
 
     struct element_rb_node rbn;
     find_element_rb_node(&rbn, set, node->val);
@@ -2101,6 +2551,13 @@ pcvar_readjust_set(purc_variant_t set, struct set_node *node)
     pcutils_rbtree_link_node(entry, rbn.parent, rbn.pnode);
     pcutils_rbtree_insert_color(entry, &data->elems);
 
+    node->hash = rbn.hash;
+    set_index_add(data, node);
+
+    /* the indexed members may be changed too */
+    sindexes_remove_node(node);
+    sindexes_add_node(data, node);
+
     return 0;
 }
 
@@ -37,6 +37,10 @@ purc_variant_t purc_variant_make_tuple(size_t argc, purc_variant_t *argv)
         return PURC_VARIANT_INVALID;
     }
 
+    vrt->type = PVT(_TUPLE);
+    vrt->flags = 0;
+    vrt->refc = 1;
+
     purc_variant_t *members;
     if (argc < PCVARIANT_MIN_TUPLE_SIZE_USING_EXTRA_SPACE) {
         vrt->size = argc;
@@ -107,6 +111,11 @@ bool purc_variant_tuple_set(purc_variant_t tuple,
     if (members == NULL || idx >= sz)
         return false;
 
+    if (pcvariant_is_immutable(tuple)) {
+        pcinst_set_error(PURC_ERROR_ACCESS_DENIED);
+        return false;
+    }
+
     assert(value);
     /* do not change */
     if (value == members[idx])
@@ -124,23 +133,25 @@ pcvariant_tuple_clone(purc_variant_t tuple, bool recursively)
     purc_variant_t *members = tuple_members(tuple, &sz);
     purc_variant_t cloned;
 
-    cloned = purc_variant_make_tuple(sz, NULL);
+    cloned = purc_variant_make_tuple(sz, members);
     if (cloned == PURC_VARIANT_INVALID)
         return PURC_VARIANT_INVALID;
 
-    for (size_t n = 0; n < sz; n++) {
-        purc_variant_t nv;
-        if (recursively) {
+    if (recursively) {
+        purc_variant_t *new_members = tuple_members(cloned, &sz);
+        for (size_t n = 0; n < sz; n++) {
+            if (!IS_CONTAINER(members[n]->type))
+                continue;
+
+            purc_variant_t nv;
             nv = pcvariant_container_clone(members[n], recursively);
             if (nv == PURC_VARIANT_INVALID) {
                 goto failed;
             }
-        }
-        else {
-            nv = purc_variant_ref(members[n]);
-        }
 
-        members[n] = nv;
+            purc_variant_unref(new_members[n]);
+            new_members[n] = nv;
+        }
     }
 
     return cloned;
@@ -29,6 +29,7 @@
 #include "private/vcm.h"
 #include "private/errors.h"
 #include "private/debug.h"
+#include "private/dlmodule.h"
 #include "private/dvobjs.h"
 #include "private/utils.h"
 #include "variant-internals.h"
@@ -86,31 +87,19 @@ static struct err_msg_seg _variant_err_msgs_seg = {
     variant_err_msgs
 };
 
-#if HAVE(GLIB)
-purc_variant *pcvariant_alloc(void) {
-    return (purc_variant *)g_slice_alloc(sizeof(purc_variant));
-}
-
-purc_variant *pcvariant_alloc_0(void) {
-    return (purc_variant *)g_slice_alloc0(sizeof(purc_variant));
-}
-
-void pcvariant_free(purc_variant *v) {
-    return g_slice_free1(sizeof(purc_variant), (gpointer)v);
-}
-#else
 purc_variant *pcvariant_alloc(void) {
-    return (purc_variant *)malloc(sizeof(purc_variant));
+    pcinst_count_alloc(sizeof(purc_variant));
+    return (purc_variant *)pcvariant_slab_alloc(sizeof(purc_variant));
 }
 
 purc_variant *pcvariant_alloc_0(void) {
-    return (purc_variant *)calloc(1, sizeof(purc_variant));
+    pcinst_count_alloc(sizeof(purc_variant));
+    return (purc_variant *)pcvariant_slab_alloc0(sizeof(purc_variant));
 }
 
 void pcvariant_free(purc_variant *v) {
-    return free(v);
+    pcvariant_slab_free(sizeof(purc_variant), v);
 }
-#endif
 
 purc_atom_t pcvariant_atom_grow;
 purc_atom_t pcvariant_atom_shrink;
@@ -146,6 +135,13 @@ static void _cleanup_instance(struct pcinst *inst)
     if (heap == NULL)
         return;
 
+    for (int i = 0; i < NR_INTERNED_KEYS; i++) {
+        if (heap->interned_keys[i]) {
+            purc_variant_unref(heap->interned_keys[i]);
+            heap->interned_keys[i] = NULL;
+        }
+    }
+
     /* VWNOTE: do not try to release the extra memory here. */
 #if USE(LOOP_BUFFER_FOR_RESERVED)
     for (int i = 0; i < MAX_RESERVED_VARIANTS; i++) {
@@ -171,6 +167,8 @@ static void _cleanup_instance(struct pcinst *inst)
     assert(heap->v_true.refc == 0);
     assert(heap->v_false.refc == 0);
 
+    pcvariant_gc_cleanup(heap);
+    pcvariant_slab_destroy(heap->slab);
     free(heap);
     inst->variant_heap = NULL;
     inst->org_vrt_heap = NULL;
@@ -190,6 +188,14 @@ static int _init_instance(struct pcinst *curr_inst,
 
     inst->org_vrt_heap = inst->variant_heap;
 
+    inst->variant_heap->slab = pcvariant_slab_create();
+    if (inst->variant_heap->slab == NULL) {
+        free(inst->variant_heap);
+        inst->variant_heap = NULL;
+        inst->org_vrt_heap = NULL;
+        return PURC_ERROR_OUT_OF_MEMORY;
+    }
+
     // initialize const values in instance
     inst->variant_heap->v_undefined.type = PURC_VARIANT_TYPE_UNDEFINED;
     inst->variant_heap->v_undefined.refc = 0;
@@ -231,10 +237,12 @@ static int _init_instance(struct pcinst *curr_inst,
     INIT_LIST_HEAD(&inst->variant_heap->v_reserved);
 #endif
 
+    pcvariant_gc_init(inst->variant_heap);
     return PURC_ERROR_OK;
 }
 
 struct pcmodule _module_variant = {
+    .name            = "variant",
     .id              = PURC_HAVE_VARIANT,
     .module_inited   = 0,
 
@@ -295,6 +303,9 @@ enum purc_variant_type purc_variant_get_type(purc_variant_t value)
 
 bool pcvariant_is_mutable(purc_variant_t val)
 {
+    if (pcvariant_is_shared(val))
+        return false;
+
     switch (val->type) {
         case PURC_VARIANT_TYPE_ARRAY:
         case PURC_VARIANT_TYPE_OBJECT:
@@ -334,10 +345,55 @@ purc_variant_ref_count(purc_variant_t value)
     return value->refc;
 }
 
+/*
+ * The variants of a shared dataset may be referenced by the instances in
+ * other threads, so they are counted atomically. When released, they are
+ * put back to the move heap in which they live.
+ */
+static purc_variant_t
+ref_shared(purc_variant_t value)
+{
+    unsigned int refc;
+    refc = __atomic_fetch_add(&value->refc, 1, __ATOMIC_RELAXED);
+    PC_ASSERT(refc > 0);
+    UNUSED_PARAM(refc);
+    return value;
+}
+
+static unsigned int
+unref_shared(purc_variant_t value)
+{
+    unsigned int refc;
+    refc = __atomic_sub_fetch(&value->refc, 1, __ATOMIC_ACQ_REL);
+    if (refc > 0 || (value->flags & PCVARIANT_FLAG_NOFREE))
+        return refc;
+
+    if (value->flags & PCVARIANT_FLAG_SHARED_ROOT)
+        pcvariant_shared_data_forget(value);
+
+    /* the members are released with the move heap used already */
+    struct pcinst *inst = pcinst_current();
+    bool nested = (inst->variant_heap != inst->org_vrt_heap);
+    if (!nested)
+        pcvariant_use_move_heap();
+
+    pcvariant_release_fn release_fn = variant_releasers[value->type];
+    if (release_fn)
+        release_fn(value);
+    pcvariant_put(value);
+
+    if (!nested)
+        pcvariant_use_norm_heap();
+    return 0;
+}
+
 purc_variant_t purc_variant_ref (purc_variant_t value)
 {
     PC_ASSERT(value);
 
+    if (UNLIKELY(pcvariant_is_shared(value)))
+        return ref_shared(value);
+
     /* this should not occur */
     if (UNLIKELY(value->refc == 0)) {
         PC_ASSERT(0);
@@ -355,6 +411,9 @@ unsigned int purc_variant_unref(purc_variant_t value)
 {
     PC_ASSERT(value);
 
+    if (UNLIKELY(pcvariant_is_shared(value)))
+        return unref_shared(value);
+
     /* this should not occur */
     if (UNLIKELY(value->refc == 0)) {
         PC_ASSERT(0);
@@ -368,6 +427,9 @@ unsigned int purc_variant_unref(purc_variant_t value)
 
     // VWNOTE: only non-constant values has a releaser
     if (value->refc == 0 && !(value->flags & PCVARIANT_FLAG_NOFREE)) {
+        if (UNLIKELY(value->flags & PCVARIANT_FLAG_GC_BUFFERED))
+            pcvariant_gc_forget(value);
+
         // release the extra memory used by the variant
         pcvariant_release_fn release_fn = variant_releasers[value->type];
         if (release_fn)
@@ -378,6 +440,16 @@ unsigned int purc_variant_unref(purc_variant_t value)
         return 0;
     }
 
+    // a container still referenced may be in a garbage cycle now
+    if (UNLIKELY(__atomic_load_n(&pcvariant_nr_gc_heaps, __ATOMIC_RELAXED)) &&
+            value->refc > 0 &&
+            (IS_CONTAINER(value->type) ||
+             value->type == PURC_VARIANT_TYPE_TUPLE) &&
+            !(value->flags & (PCVARIANT_FLAG_GC_BUFFERED |
+                    PCVARIANT_FLAG_NOFREE))) {
+        pcvariant_gc_buffer(value);
+    }
+
     return value->refc;
 }
 
@@ -398,6 +470,8 @@ const struct purc_variant_stat *purc_variant_usage_stat(void)
     value = &(inst->variant_heap->v_false);
     inst->variant_heap->stat.nr_values[PURC_VARIANT_TYPE_BOOLEAN] += value->refc;
 
+    pcvariant_slab_get_stat(inst->variant_heap->slab,
+            &inst->variant_heap->stat);
     return &inst->variant_heap->stat;
 }
 
@@ -415,6 +489,11 @@ void pcvariant_stat_set_extra_size(purc_variant_t value, size_t extra_size)
         stat->sz_mem[type] -= value->sz_ptr[0];
         stat->sz_total_mem -= value->sz_ptr[0];
 
+        struct pcvariant_charge *charge = instance->variant_heap->charge;
+        if (charge) {
+            charge->sz_mem += (int64_t)extra_size - (int64_t)value->sz_ptr[0];
+        }
+
         value->sz_ptr[0] = extra_size;
 
         stat->sz_mem[type] += extra_size;
@@ -422,6 +501,21 @@ void pcvariant_stat_set_extra_size(purc_variant_t value, size_t extra_size)
     }
 }
 
+void pcvariant_set_charge(struct pcvariant_charge *charge)
+{
+    struct pcinst *instance = pcinst_current();
+    if (instance && instance->org_vrt_heap)
+        instance->org_vrt_heap->charge = charge;
+}
+
+void pcvariant_drop_charge(struct pcvariant_charge *charge)
+{
+    struct pcinst *instance = pcinst_current();
+    if (instance && instance->org_vrt_heap &&
+            instance->org_vrt_heap->charge == charge)
+        instance->org_vrt_heap->charge = NULL;
+}
+
 purc_variant_t pcvariant_get(enum purc_variant_type type)
 {
     purc_variant_t value = NULL;
@@ -475,6 +569,11 @@ purc_variant_t pcvariant_get(enum purc_variant_type type)
     stat->nr_values[type]++;
     stat->nr_total_values++;
 
+    if (heap->charge) {
+        heap->charge->nr_values++;
+        heap->charge->sz_mem += sizeof(purc_variant);
+    }
+
     // init listeners
     INIT_LIST_HEAD(&value->listeners);
 
@@ -496,6 +595,11 @@ void pcvariant_put(purc_variant_t value)
     stat->nr_values[value->type]--;
     stat->nr_total_values--;
 
+    if (heap->charge) {
+        heap->charge->nr_values--;
+        heap->charge->sz_mem -= sizeof(purc_variant);
+    }
+
 #if USE(LOOP_BUFFER_FOR_RESERVED)
     if ((heap->headpos + 1) % MAX_RESERVED_VARIANTS == heap->tailpos) {
         stat->sz_mem[value->type] -= sizeof(purc_variant);
@@ -586,28 +690,23 @@ static bool equal_sets(purc_variant_t v1, purc_variant_t v2)
 {
     size_t sz1 = purc_variant_set_get_size(v1);
     size_t sz2 = purc_variant_set_get_size(v2);
-    struct purc_variant_set_iterator* it;
-    purc_variant_t m1, m2;
+    purc_variant_t m1;
 
     if (sz1 != sz2)
         return false;
 
-    it = purc_variant_set_make_iterator_begin(v2);
+    /* walk the elements of both sets in order without making an iterator */
+    variant_set_t data2 = pcvar_set_get_data(v2);
+    struct rb_node *p2 = pcutils_rbtree_first(&data2->elems);
     foreach_value_in_variant_set_order(v1, m1)
+        struct set_node *sn2 = container_of(p2, struct set_node, rbnode);
+        if (!purc_variant_is_equal_to(m1, sn2->val))
+            return false;
 
-        m2 = purc_variant_set_iterator_get_value(it);
-        if (!purc_variant_is_equal_to(m1, m2))
-            goto not_equal;
-
-        purc_variant_set_iterator_next(it);
+        p2 = pcutils_rbtree_next(p2);
     end_foreach;
 
-    purc_variant_set_release_iterator(it);
     return true;
-
-not_equal:
-    purc_variant_set_release_iterator(it);
-    return false;
 }
 
 static bool equal_tuples(purc_variant_t v1, purc_variant_t v2)
@@ -1452,8 +1551,7 @@ bool purc_variant_cast_to_byte_sequence(purc_variant_t v,
 
         case PURC_VARIANT_TYPE_STRING:
         case PURC_VARIANT_TYPE_BSEQUENCE:
-            if (v->type == PURC_VARIANT_TYPE_STRING &&
-                    v->flags & PCVARIANT_FLAG_STRING_STATIC) {
+            if (v->flags & PCVARIANT_FLAG_STRING_STATIC) {
                 *bytes = (void*)v->sz_ptr[1];
                 *sz = v->sz_ptr[0]; // strlen((const char*)*bytes) + 1;
             }
@@ -1608,6 +1706,12 @@ int purc_variant_compare_ex (purc_variant_t v1,
 }
 
 purc_variant_t purc_variant_load_from_json_stream(purc_rwstream_t stream)
+{
+    return pcvariant_load_from_json_stream_ex(stream, 0);
+}
+
+purc_variant_t
+pcvariant_load_from_json_stream_ex(purc_rwstream_t stream, uint32_t flags)
 {
     if (stream  == NULL) {
         return PURC_VARIANT_INVALID;
@@ -1617,6 +1721,43 @@ purc_variant_t purc_variant_load_from_json_stream(purc_rwstream_t stream)
     struct pcvcm_node* root = NULL;
     struct pcejson* parser = NULL;
 
+    /* try to make the variant without the VCM tree if we can re-read
+       the stream on failure, e.g., the text has dynamic expressions */
+    off_t start = purc_rwstream_tell(stream);
+    if (start < 0) {
+        purc_clr_error();
+    }
+    else {
+        /* the plain JSON text in memory is parsed without decoding */
+        size_t sz;
+        const char *json;
+        json = (start == 0) ? purc_rwstream_get_mem_buffer(stream, &sz) : NULL;
+        if (json) {
+            if (pcejson_parse_plain(&value, json, sz,
+                        PCEJSON_DEFAULT_DEPTH, flags) == 0) {
+                purc_rwstream_seek(stream, 0, SEEK_END);
+                return value;
+            }
+        }
+        else {
+            purc_clr_error();
+        }
+
+        if (pcejson_parse_static(&value, stream, PCEJSON_DEFAULT_DEPTH,
+                    flags) == 0)
+            return value;
+
+        if (purc_rwstream_seek(stream, start, SEEK_SET) != start)
+            return PURC_VARIANT_INVALID;
+        purc_clr_error();
+    }
+
+    if (flags) {
+        parser = pcejson_create(PCEJSON_DEFAULT_DEPTH, 1 | flags);
+        if (parser == NULL)
+            return PURC_VARIANT_INVALID;
+    }
+
     int ret = pcejson_parse (&root, &parser, stream, PCEJSON_DEFAULT_DEPTH);
     if (ret != PCEJSON_SUCCESS) {
         goto ret;
@@ -1646,7 +1787,12 @@ purc_variant_t purc_variant_make_from_json_string(const char* json, size_t sz)
 purc_variant_t purc_variant_load_from_json_file(const char* file)
 {
     purc_variant_t value;
-    purc_rwstream_t rwstream = purc_rwstream_new_from_file(file, "r");
+    purc_rwstream_t rwstream = purc_rwstream_new_from_mmap(file);
+    if (rwstream == NULL) {
+        /* not a regular file, e.g., a named pipe */
+        purc_clr_error();
+        rwstream = purc_rwstream_new_from_file(file, "r");
+    }
     if (rwstream == NULL)
         return PURC_VARIANT_INVALID;
 
@@ -1665,113 +1811,28 @@ purc_variant_t purc_variant_load_dvobj_from_so (const char *so_name,
     purc_variant_t value = PURC_VARIANT_INVALID;
 
 #if OS(LINUX) || OS(UNIX) || OS(MAC_OS_X)
-    const char *ext = ".so";
-#if OS(MAC_OS_X)
-    ext = ".dylib";
-#endif
     purc_variant_t val = PURC_VARIANT_INVALID;
     int ver_code;
 
     void *library_handle = NULL;
 
-    char so[PATH_MAX+1];
-    int n;
-    do {
-        if (so_name && strchr(so_name, '/')) {
-            // let dlopen to handle path search
-            n = snprintf(so, sizeof(so), "%s", so_name);
-            PC_ASSERT(n>0 && (size_t)n<sizeof(so));
-            library_handle = dlopen(so, RTLD_LAZY);
-            break;
-        }
-        if (so_name && strchr(so_name, '.')) {
-            // user specified dynamic library filename
-            n = snprintf(so, sizeof(so), "%s", so_name);
-            PC_ASSERT(n>0 && (size_t)n<sizeof(so));
-        }
-        else {
-            // we build dynamic library filename
-            // TODO: check validity of name!!!!
-            n = snprintf(so, sizeof(so), "libpurc-dvobj-%s%s",
-                    so_name ? so_name : var_name, ext);
-            PC_ASSERT(n>0 && (size_t)n<sizeof(so));
+    if (so_name && strchr(so_name, '/')) {
+        // let dlopen to handle path search
+        library_handle = dlopen(so_name, RTLD_LAZY);
+        if (!library_handle) {
+            purc_set_error_with_info(PURC_ERROR_BAD_SYSTEM_CALL,
+                    "failed to load: %s", so_name);
         }
-#ifdef PRINT_DEBUG        /* { */
-        PC_DEBUGX("generated so: %s\n", so);
-#endif                    /* } */
-
-        /* XXX: the order of searching directories:
-         *
-         * 1. the valid directories contains in the environment variable:
-         *      PURC_DVOBJS_PATH
-         * 2. /usr/local/lib/purc-<purc-api-version>/
-         * 3. /usr/lib/purc-<purc-api-version>/
-         * 4. /lib/purc-<purc-api-version>/
-         */
-
-        // step1: search in directories defined by the env var
-        const char *env = getenv(PURC_ENVV_DVOBJS_PATH);
-        if (env) {
-            char *path = strdup(env);
-            char *str1;
-            char *saveptr1;
-            char *dir;
-
-            for (str1 = path; ; str1 = NULL) {
-                dir = strtok_r(str1, ":;", &saveptr1);
-                if (dir == NULL || dir[0] != '/') {
-                    break;
-                }
-
-                n = snprintf(so, sizeof(so),
-                        "%s/libpurc-dvobj-%s%s",
-                        dir, so_name ? so_name : var_name, ext);
-                PC_ASSERT(n>0 && (size_t)n<sizeof(so));
-                library_handle = dlopen(so, RTLD_LAZY);
-
-                if (library_handle) {
-                    break;
-                }
-            }
-
-            free(path);
-
-            if (library_handle)
-                break;
-        }
-
-        static const char *ver = PURC_API_VERSION_STRING;
-
-        // try in system directories.
-        static const char *other_tries[] = {
-            "/usr/local/lib/purc-%s/libpurc-dvobj-%s%s",
-            "/usr/lib/purc-%s/libpurc-dvobj-%s%s",
-            "/lib/purc-%s/libpurc-dvobj-%s%s",
-        };
-
-        for (size_t i = 0; i < PCA_TABLESIZE(other_tries); i++) {
-            n = snprintf(so, sizeof(so), other_tries[i],
-                    ver, so_name ? so_name : var_name, ext);
-            PC_ASSERT(n>0 && (size_t)n<sizeof(so));
-            library_handle = dlopen(so, RTLD_LAZY);
-            if (library_handle) {
-#ifdef PRINT_DEBUG        /* { */
-                PC_DEBUGX("Loaded DVObj from %s\n", so);
-#endif                    /* } */
-                break;
-            }
-        }
-
-    } while (0);
+    }
+    else {
+        // TODO: check validity of name!!!!
+        library_handle = pcutils_dlmodule_open(PURC_ENVV_DVOBJS_PATH,
+                "libpurc-dvobj-", so_name ? so_name : var_name);
+    }
 
     if (!library_handle) {
-        purc_set_error_with_info(PURC_ERROR_BAD_SYSTEM_CALL,
-                "failed to load: %s", so);
         return PURC_VARIANT_INVALID;
     }
-#ifdef PRINT_DEBUG        /* { */
-    PC_DEBUGX("loaded: %s", so);
-#endif                    /* } */
 
     purc_variant_t (* purcex_load_dynamic_variant)(const char *, int *);
 
@@ -1867,7 +1928,7 @@ numberify_str(const char *s)
     if (!s || !*s)
         return 0.0;
 
-    return strtod(s, NULL);
+    return pcutils_strtod(s, NULL);
 }
 
 static double
@@ -2331,8 +2392,7 @@ variant_stringify(struct stringify_arg *arg, purc_variant_t value)
             arg->cb(arg, &value->d, sizeof(double));
         }
         else {
-            snprintf(buf, sizeof(buf), "%g", value->d);
-            arg->cb(arg, buf, 0);
+            arg->cb(arg, buf, pcutils_gtoa(value->d, buf));
         }
         break;
     case PURC_VARIANT_TYPE_LONGINT:
@@ -2340,8 +2400,7 @@ variant_stringify(struct stringify_arg *arg, purc_variant_t value)
             arg->cb(arg, &value->i64, sizeof(int64_t));
         }
         else {
-            snprintf(buf, sizeof(buf), "%" PRId64 "", value->i64);
-            arg->cb(arg, buf, 0);
+            arg->cb(arg, buf, pcutils_i64toa(value->i64, buf));
         }
         break;
 
@@ -2350,8 +2409,7 @@ variant_stringify(struct stringify_arg *arg, purc_variant_t value)
             arg->cb(arg, &value->u64, sizeof(uint64_t));
         }
         else {
-            snprintf(buf, sizeof(buf), "%" PRIu64 "", value->u64);
-            arg->cb(arg, buf, 0);
+            arg->cb(arg, buf, pcutils_u64toa(value->u64, buf));
         }
         break;
 
@@ -2416,12 +2474,38 @@ variant_stringify(struct stringify_arg *arg, purc_variant_t value)
     }
 }
 
+ssize_t
+pcvariant_stringify_number(purc_variant_t val, char *buf)
+{
+    switch (val->type) {
+    case PURC_VARIANT_TYPE_NUMBER:
+        return pcutils_gtoa(val->d, buf);
+    case PURC_VARIANT_TYPE_LONGINT:
+        return pcutils_i64toa(val->i64, buf);
+    case PURC_VARIANT_TYPE_ULONGINT:
+        return pcutils_u64toa(val->u64, buf);
+    case PURC_VARIANT_TYPE_LONGDOUBLE:
+        return snprintf(buf, PCVARIANT_NUMBER_BUFSZ, "%Lg", val->ld);
+    default:
+        break;
+    }
+
+    return -1;
+}
+
 ssize_t
 purc_variant_stringify_buff(char *buf, size_t len, purc_variant_t value)
 {
     PC_ASSERT(buf);
     PC_ASSERT(len > 0);
 
+    /* no stream for a number */
+    if (len >= PCVARIANT_NUMBER_BUFSZ && value != PURC_VARIANT_INVALID) {
+        ssize_t sz = pcvariant_stringify_number(value, buf);
+        if (sz >= 0)
+            return sz;
+    }
+
     purc_rwstream_t stream;
     stream = purc_rwstream_new_from_mem((void*)buf, len);
     if (!stream)
@@ -2520,6 +2604,18 @@ purc_variant_stringify(purc_rwstream_t stream, purc_variant_t value,
 ssize_t
 purc_variant_stringify_alloc(char **strp, purc_variant_t value)
 {
+    if (strp && value != PURC_VARIANT_INVALID) {
+        char buf[PCVARIANT_NUMBER_BUFSZ];
+        ssize_t sz = pcvariant_stringify_number(value, buf);
+        if (sz >= 0) {
+            if ((*strp = strndup(buf, sz)) == NULL) {
+                pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+                return -1;
+            }
+            return sz;
+        }
+    }
+
     purc_rwstream_t stream;
     stream = purc_rwstream_new_buffer(0, 0);
     if (!stream)
@@ -2762,6 +2858,76 @@ purc_variant_container_clone_recursively(purc_variant_t ctnr)
     return pcvariant_container_clone(ctnr, true);
 }
 
+static int
+scan_members(purc_variant_t ctnr, purc_variant_member_cb cb, void *ctxt)
+{
+    purc_variant_t k, v;
+    size_t idx = 0;
+    int r = 0;
+
+    switch (ctnr->type) {
+    case PURC_VARIANT_TYPE_OBJECT:
+        foreach_key_value_in_variant_object(ctnr, k, v)
+            if ((r = cb(ctxt, idx++, k, v)))
+                break;
+        end_foreach;
+        break;
+
+    case PURC_VARIANT_TYPE_ARRAY:
+        foreach_value_in_variant_array(ctnr, v, idx)
+            if ((r = cb(ctxt, idx, PURC_VARIANT_INVALID, v)))
+                break;
+        end_foreach;
+        break;
+
+    case PURC_VARIANT_TYPE_SET:
+        foreach_value_in_variant_set(ctnr, v)
+            if ((r = cb(ctxt, idx++, PURC_VARIANT_INVALID, v)))
+                break;
+        end_foreach;
+        break;
+
+    case PURC_VARIANT_TYPE_TUPLE: {
+        size_t sz;
+        purc_variant_t *members = tuple_members(ctnr, &sz);
+        for (idx = 0; idx < sz; idx++) {
+            if ((r = cb(ctxt, idx, PURC_VARIANT_INVALID, members[idx])))
+                break;
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    return r;
+}
+
+int
+purc_variant_container_scan(purc_variant_t ctnr,
+        purc_variant_member_cb cb, void *ctxt)
+{
+    PCVARIANT_CHECK_FAIL_RET(ctnr && cb, -1);
+
+    if (!IS_CONTAINER(ctnr->type) && ctnr->type != PURC_VARIANT_TYPE_TUPLE) {
+        pcinst_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+        return -1;
+    }
+
+    /* a shared container is never changed, and a nested scan of the same
+       container leaves the pin to the outer one */
+    bool pinned = pcvariant_is_immutable(ctnr);
+    if (!pinned)
+        ctnr->flags |= PCVARIANT_FLAG_PINNED;
+
+    int r = scan_members(ctnr, cb, ctxt);
+
+    if (!pinned)
+        ctnr->flags &= ~PCVARIANT_FLAG_PINNED;
+    return r;
+}
+
 int
 pcvariant_diff(purc_variant_t l, purc_variant_t r)
 {
@@ -2796,7 +2962,12 @@ struct purc_ejson_parse_tree *
 purc_variant_ejson_parse_file(const char *fname)
 {
     struct purc_ejson_parse_tree *ptree;
-    purc_rwstream_t rwstream = purc_rwstream_new_from_file(fname, "r");
+    purc_rwstream_t rwstream = purc_rwstream_new_from_mmap(fname);
+    if (rwstream == NULL) {
+        /* not a regular file, e.g., a named pipe */
+        purc_clr_error();
+        rwstream = purc_rwstream_new_from_file(fname, "r");
+    }
     if (rwstream == NULL)
         return NULL;
 
@@ -2901,23 +3072,10 @@ cmp_by_arr(purc_variant_t l, purc_variant_t r,
     PC_ASSERT(ld);
     PC_ASSERT(rd);
 
-    struct pcutils_array_list *la = &ld->al;
-    struct pcutils_array_list *ra = &rd->al;
-
-    struct pcutils_array_list_node *lnode = pcutils_array_list_get_first(la);
-    struct pcutils_array_list_node *rnode = pcutils_array_list_get_first(ra);
-
-    for (;
-        lnode && rnode;
-        lnode = pcutils_array_list_get(la, lnode->idx + 1),
-        rnode = pcutils_array_list_get(ra, rnode->idx + 1))
-    {
-        struct arr_node *lo, *ro;
-        lo = container_of(lnode, struct arr_node, node);
-        ro = container_of(rnode, struct arr_node, node);
-
-        purc_variant_t lv = lo->val;
-        purc_variant_t rv = ro->val;
+    size_t i;
+    for (i = 0; i < ld->nr && i < rd->nr; i++) {
+        purc_variant_t lv = ld->vals[i];
+        purc_variant_t rv = rd->vals[i];
         PC_ASSERT(lv != PURC_VARIANT_INVALID);
         PC_ASSERT(rv != PURC_VARIANT_INVALID);
 
@@ -2926,9 +3084,9 @@ cmp_by_arr(purc_variant_t l, purc_variant_t r,
             return diff;
     }
 
-    if (lnode)
+    if (i < ld->nr)
         return 1;
-    else if (rnode)
+    else if (i < rd->nr)
         return -1;
     else
         return 0;
@@ -3246,19 +3404,11 @@ stringify(char *buf, size_t len, purc_variant_t v)
             break;
 
         case PURC_VARIANT_TYPE_NUMBER:
-            nr = snprintf(buf, len, "%g", v->d);
-            break;
-
         case PURC_VARIANT_TYPE_LONGINT:
-            nr = snprintf(buf, len, "%" PRId64 "", v->i64);
-            break;
-
         case PURC_VARIANT_TYPE_ULONGINT:
-            nr = snprintf(buf, len, "%" PRIu64 "", v->u64);
-            break;
-
         case PURC_VARIANT_TYPE_LONGDOUBLE:
-            nr = snprintf(buf, len, "%Lg", v->ld);
+            PC_ASSERT(len >= PCVARIANT_NUMBER_BUFSZ);
+            nr = pcvariant_stringify_number(v, buf);
             break;
 
         case PURC_VARIANT_TYPE_ATOMSTRING:
@@ -3608,108 +3758,106 @@ void pcvariant_md5_ex(char *md5, purc_variant_t val, const char *salt,
     pcutils_bin2hex(md5_digest, MD5_DIGEST_SIZE, md5, uppercase);
 }
 
-void
-pcvariant_md5_by_set(char *md5, purc_variant_t val, purc_variant_t set)
-{
-    PC_ASSERT(md5);
-    PC_ASSERT(val != PURC_VARIANT_INVALID);
-    PC_ASSERT(set != PURC_VARIANT_INVALID);
-
-    variant_set_t data = pcvar_set_get_data(set);
-    PC_ASSERT(data);
+#define FNV_OFFSET_BASIS_64      0xcbf29ce484222325ULL
+#define FNV_PRIME_64             0x100000001b3ULL
 
-    if (data->unique_key == NULL) {
-        pcvariant_md5(md5, val);
-        return;
-    }
+struct stringify_hash {
+    uint64_t    hash;
+    bool        stopped;    // a null character was met
+    bool        caseless;   // the ASCII letters are hashed in lowercase
+};
 
-    purc_variant_t undefined = purc_variant_make_undefined();
-    PC_ASSERT(undefined);
+/* the sets compare the stringified values with strcmp(),
+   so the hash stops at the first null character. For a caseless set,
+   only the ASCII letters are folded, thus two values equal in Unicode
+   case folding may have different hashes; see find_element(). */
+static void
+do_stringify_hash(struct stringify_arg *arg, const void *src, size_t len)
+{
+    struct stringify_hash *ud = (struct stringify_hash *)arg->arg;
+    const unsigned char *p = src;
 
-    if (val->type != PVT(_OBJECT)) {
-        pcvariant_md5(md5, undefined);
-        purc_variant_unref(undefined);
+    if (ud->stopped)
         return;
-    }
-
-    pcutils_md5_ctxt ud;
 
-    pcutils_md5_begin(&ud);
-
-    struct stringify_arg arg;
-    arg.cb    = do_stringify_md5;
-    arg.arg   = &ud;
-    arg.flags = 0;
+    if (len == 0)
+        len = strlen(src);
 
-    for (size_t i=0; i<data->nr_keynames; ++i) {
-        purc_variant_t v;
-        v = purc_variant_object_get_by_ckey(val, data->keynames[i]);
-        if (v == PURC_VARIANT_INVALID) {
-            v = undefined;
+    for (size_t i = 0; i < len; i++) {
+        if (p[i] == 0) {
+            ud->stopped = true;
+            break;
         }
-        stringify_kv(&arg, data->keynames[i], v);
+
+        ud->hash ^= ud->caseless ? purc_tolower(p[i]) : p[i];
+        ud->hash *= FNV_PRIME_64;
     }
+}
 
-    unsigned char md5_digest[MD5_DIGEST_SIZE];
-    pcutils_md5_end(&ud, md5_digest);
+static uint64_t
+stringify_hash(struct stringify_arg *arg, purc_variant_t val)
+{
+    struct stringify_hash *ud = (struct stringify_hash *)arg->arg;
 
-    bool uppercase = true;
-    pcutils_bin2hex(md5_digest, MD5_DIGEST_SIZE, md5, uppercase);
+    ud->hash = FNV_OFFSET_BASIS_64;
+    ud->stopped = false;
+
+    if (val == PURC_VARIANT_INVALID)
+        arg->cb(arg, "undefined", 0);
+    else
+        variant_stringify(arg, val);
 
-    purc_variant_unref(undefined);
+    return ud->hash;
 }
 
-int
-pcvariant_diff_by_set(const char *md5l, purc_variant_t l,
-        const char *md5r, purc_variant_t r, purc_variant_t set)
+uint64_t
+pcvariant_hash(purc_variant_t val)
 {
-    // TODO: https://gitlab.fmsoft.cn/hvml/hvml-docs/-/blob/master/zh/hvml-spec-v1.0-zh.md#21610-%E9%9B%86%E5%90%88%E5%8F%98%E9%87%8F
+    PC_ASSERT(val != PURC_VARIANT_INVALID);
 
-    PC_ASSERT(md5l);
-    PC_ASSERT(l != PURC_VARIANT_INVALID);
-    PC_ASSERT(md5r);
-    PC_ASSERT(r != PURC_VARIANT_INVALID);
+    struct stringify_hash ud = { .caseless = false };
+    struct stringify_arg arg;
+    arg.cb    = do_stringify_hash;
+    arg.arg   = &ud;
+    arg.flags = 0;
 
-    PC_ASSERT(set != PURC_VARIANT_INVALID);
+    return stringify_hash(&arg, val);
+}
 
-    int diff;
+uint64_t
+pcvariant_hash_by_set(purc_variant_t val, purc_variant_t set)
+{
+    PC_ASSERT(val != PURC_VARIANT_INVALID);
+    PC_ASSERT(set != PURC_VARIANT_INVALID);
 
     variant_set_t data = pcvar_set_get_data(set);
     PC_ASSERT(data);
 
+    struct stringify_hash ud = { .caseless = data->caseless };
+    struct stringify_arg arg;
+    arg.cb    = do_stringify_hash;
+    arg.arg   = &ud;
+    arg.flags = 0;
+
     if (data->unique_key == NULL) {
-        return pcvariant_diff(l, r);
+        return stringify_hash(&arg, val);
     }
 
-    diff = strcmp(md5l, md5r);
-    if (diff)
-        return diff;
-
-    purc_variant_t undefined = purc_variant_make_undefined();
-    PC_ASSERT(undefined);
-
+    uint64_t hash = FNV_OFFSET_BASIS_64;
     for (size_t i=0; i<data->nr_keynames; ++i) {
-        purc_variant_t vl = PURC_VARIANT_INVALID;
-        purc_variant_t vr = PURC_VARIANT_INVALID;
-
-        if (l->type == PVT(_OBJECT))
-            vl = purc_variant_object_get_by_ckey(l, data->keynames[i]);
-        if (r->type == PVT(_OBJECT))
-            vr = purc_variant_object_get_by_ckey(r, data->keynames[i]);
-
-        if (vl == PURC_VARIANT_INVALID)
-            vl = undefined;
-        if (vr == PURC_VARIANT_INVALID)
-            vr = undefined;
+        purc_variant_t v = PURC_VARIANT_INVALID;
+        if (val->type == PVT(_OBJECT)) {
+            v = purc_variant_object_get_by_ckey(val, data->keynames[i]);
+            if (v == PURC_VARIANT_INVALID)
+                purc_clr_error();
+        }
 
-        diff = pcvariant_diff(vl, vr);
-        if (diff)
-            break;
+        /* undefined is used for a missing key, as _compare() does */
+        hash ^= stringify_hash(&arg, v);
+        hash *= FNV_PRIME_64;
     }
 
-    purc_variant_unref(undefined);
-
-    return diff;
+    return hash;
 }
 
 bool pcvariant_is_scalar(purc_variant_t v)
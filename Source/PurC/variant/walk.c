@@ -67,7 +67,7 @@ arr_parallel_walk(purc_variant_t l, purc_variant_t r, void *ctxt,
     rit = pcvar_arr_it_first(r);
 
     while (lit.curr && rit.curr) {
-        int r = parallel_walk(lit.curr->val, rit.curr->val, ctxt, cb);
+        int r = parallel_walk(lit.curr, rit.curr, ctxt, cb);
         if (r)
             return r;
 
@@ -75,13 +75,13 @@ arr_parallel_walk(purc_variant_t l, purc_variant_t r, void *ctxt,
         pcvar_arr_it_next(&rit);
     }
 
-    if (lit.curr == NULL && rit.curr == NULL)
+    if (lit.curr == PURC_VARIANT_INVALID && rit.curr == PURC_VARIANT_INVALID)
         return 0;
 
     if (lit.curr)
-        return parallel_walk(lit.curr->val, PURC_VARIANT_INVALID, ctxt, cb);
+        return parallel_walk(lit.curr, PURC_VARIANT_INVALID, ctxt, cb);
     else
-        return parallel_walk(PURC_VARIANT_INVALID, rit.curr->val, ctxt, cb);
+        return parallel_walk(PURC_VARIANT_INVALID, rit.curr, ctxt, cb);
 }
 
 static int
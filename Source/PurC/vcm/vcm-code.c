@@ -0,0 +1,775 @@
+/**
+ * @file vcm-code.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The compiler of VCM trees to a linear code, and the evaluator
+ *  of the code.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Every node of the tree but the operators of CJSONEE gets a register.
+ * The instructions are laid out in the order the tree walker evaluates the
+ * nodes, and each one puts the value of its node into its register. The
+ * registers hold their values until the end of the evaluation, so the value
+ * of any node is at hand for the getters of dynamic variants, which the
+ * tree walker keeps in its frames.
+ *
+ * A failed instruction fails the evaluation, or gives `undefined` when
+ * evaluating silently, as the tree walker does for a failed node.
+ *
+ * A constant subtree marked for folding is one instruction, and the check
+ * of the caller of a call to be folded skips the arguments and the call
+ * once the value is folded.
+ */
+
+#include "config.h"
+
+#include "purc-utils.h"
+#include "purc-errors.h"
+#include "private/errors.h"
+#include "private/variant.h"
+#include "private/vcm.h"
+
+#include "vcm-internal.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TREE_NODE(node)              ((struct pctree_node*)(node))
+#define VCM_NODE(node)               ((struct pcvcm_node*)(node))
+#define FIRST_CHILD(node)            \
+    (VCM_NODE(pctree_node_child(TREE_NODE(node))))
+#define NEXT_CHILD(node)             \
+    ((node) ? VCM_NODE(pctree_node_next(TREE_NODE(node))) : NULL)
+#define CHILDREN_NUMBER(node)        \
+    (pctree_node_children_number(TREE_NODE(node)))
+
+#define NO_REG                  UINT32_MAX
+
+/* the operands of an instruction fitting in the stack of the evaluator */
+#define NR_LOCAL_ARGS           16
+/* the registers fitting in the stack of the evaluator */
+#define NR_LOCAL_REGS           32
+
+enum pcvcm_opcode {
+    /* constants; from the node */
+    PCVCM_OP_UNDEFINED,
+    PCVCM_OP_NULL,
+    PCVCM_OP_BOOLEAN,
+    PCVCM_OP_NUMBER,
+    PCVCM_OP_LONG_INT,
+    PCVCM_OP_ULONG_INT,
+    PCVCM_OP_LONG_DOUBLE,
+    PCVCM_OP_STRING,
+    PCVCM_OP_OBJECT_KEY,
+    PCVCM_OP_BYTE_SEQUENCE,
+
+    /* args: key0, value0, key1, value1, ... */
+    PCVCM_OP_MAKE_OBJECT,
+    /* args: member0, member1, ... */
+    PCVCM_OP_MAKE_ARRAY,
+    /* args: string0, string1, ... */
+    PCVCM_OP_CONCAT,
+    /* args: name */
+    PCVCM_OP_GET_VAR,
+    /* args: caller, param, root of caller */
+    PCVCM_OP_GET_ELEM,
+    /* args: caller, root of caller; jumps with a failure if the caller is
+       not callable, or with the value if folded or called lazily */
+    PCVCM_OP_CHECK_CALLABLE,
+    /* args: caller, root of caller, param0, param1, ... */
+    PCVCM_OP_CALL_GETTER,
+    PCVCM_OP_CALL_SETTER,
+
+    /* the value of a constant subtree; evaluated once by the tree walker */
+    PCVCM_OP_FOLDED,
+
+    /* args: source */
+    PCVCM_OP_MOVE,
+    /* args: condition */
+    PCVCM_OP_JUMP_IF_FALSE,
+    PCVCM_OP_JUMP_IF_TRUE,
+};
+
+struct pcvcm_insn {
+    enum pcvcm_opcode   op;
+    uint32_t            dst;
+    uint32_t            nr_args;
+    /* the index of the first operand in the operands of the code */
+    uint32_t            args;
+    uint32_t            jump;
+    struct pcvcm_node  *node;
+};
+
+struct pcvcm_code {
+    size_t              nr_regs;
+    size_t              nr_insns;
+    uint32_t            result;
+    struct pcvcm_insn  *insns;
+    uint32_t           *args;
+};
+
+struct compiler {
+    struct pcvcm_insn  *insns;
+    size_t              nr_insns;
+    size_t              sz_insns;
+
+    uint32_t           *args;
+    size_t              nr_args;
+    size_t              sz_args;
+
+    uint32_t            nr_regs;
+};
+
+static struct pcvcm_insn *
+emit(struct compiler *c, enum pcvcm_opcode op, uint32_t dst,
+        struct pcvcm_node *node, const uint32_t *args, size_t nr_args)
+{
+    if (c->nr_insns == c->sz_insns) {
+        size_t sz = c->sz_insns ? c->sz_insns * 2 : 16;
+        struct pcvcm_insn *insns = realloc(c->insns, sizeof(*insns) * sz);
+        if (insns == NULL)
+            return NULL;
+        c->insns = insns;
+        c->sz_insns = sz;
+    }
+
+    if (c->nr_args + nr_args > c->sz_args) {
+        size_t sz = c->sz_args ? c->sz_args * 2 : 32;
+        while (sz < c->nr_args + nr_args)
+            sz *= 2;
+        uint32_t *a = realloc(c->args, sizeof(*a) * sz);
+        if (a == NULL)
+            return NULL;
+        c->args = a;
+        c->sz_args = sz;
+    }
+
+    struct pcvcm_insn *insn = c->insns + c->nr_insns++;
+    insn->op = op;
+    insn->dst = dst;
+    insn->nr_args = nr_args;
+    insn->args = c->nr_args;
+    insn->jump = 0;
+    insn->node = node;
+
+    if (nr_args) {
+        memcpy(c->args + c->nr_args, args, sizeof(*args) * nr_args);
+        c->nr_args += nr_args;
+    }
+    return insn;
+}
+
+static uint32_t
+compile_node(struct compiler *c, struct pcvcm_node *node,
+        uint32_t *first_child_reg);
+
+static uint32_t
+compile_leaf(struct compiler *c, struct pcvcm_node *node,
+        enum pcvcm_opcode op)
+{
+    uint32_t dst = c->nr_regs++;
+    return emit(c, op, dst, node, NULL, 0) ? dst : NO_REG;
+}
+
+/*
+ * Compiles the first nr_children children of node, and then the instruction
+ * of node with the registers of the children as its operands.
+ */
+static uint32_t
+compile_with_children(struct compiler *c, struct pcvcm_node *node,
+        enum pcvcm_opcode op, size_t nr_children, bool intern_keys,
+        uint32_t *first_child_reg)
+{
+    uint32_t local_args[NR_LOCAL_ARGS];
+    uint32_t *args = local_args;
+    uint32_t dst = NO_REG;
+
+    if (nr_children > NR_LOCAL_ARGS) {
+        args = malloc(sizeof(*args) * nr_children);
+        if (args == NULL)
+            return NO_REG;
+    }
+
+    struct pcvcm_node *child = FIRST_CHILD(node);
+    for (size_t i = 0; i < nr_children; i++) {
+        if (intern_keys && (i % 2) == 0 &&
+                child->type == PCVCM_NODE_TYPE_STRING) {
+            args[i] = compile_leaf(c, child, PCVCM_OP_OBJECT_KEY);
+        }
+        else {
+            args[i] = compile_node(c, child, NULL);
+        }
+
+        if (args[i] == NO_REG)
+            goto out;
+        child = NEXT_CHILD(child);
+    }
+
+    if (first_child_reg)
+        *first_child_reg = nr_children ? args[0] : NO_REG;
+
+    dst = c->nr_regs++;
+    if (!emit(c, op, dst, node, args, nr_children))
+        dst = NO_REG;
+
+out:
+    if (args != local_args)
+        free(args);
+    return dst;
+}
+
+static uint32_t
+compile_get_variable(struct compiler *c, struct pcvcm_node *node,
+        uint32_t *first_child_reg)
+{
+    if (CHILDREN_NUMBER(node) < 1)
+        return NO_REG;
+
+    return compile_with_children(c, node, PCVCM_OP_GET_VAR, 1, false,
+            first_child_reg);
+}
+
+static uint32_t
+compile_get_element(struct compiler *c, struct pcvcm_node *node,
+        uint32_t *first_child_reg)
+{
+    uint32_t args[3];
+
+    if (CHILDREN_NUMBER(node) < 2)
+        return NO_REG;
+
+    struct pcvcm_node *caller_node = FIRST_CHILD(node);
+    args[0] = compile_node(c, caller_node, &args[2]);
+    if (args[0] == NO_REG)
+        return NO_REG;
+
+    args[1] = compile_node(c, NEXT_CHILD(caller_node), NULL);
+    if (args[1] == NO_REG)
+        return NO_REG;
+
+    if (first_child_reg)
+        *first_child_reg = args[0];
+
+    uint32_t dst = c->nr_regs++;
+    return emit(c, PCVCM_OP_GET_ELEM, dst, node, args, 3) ? dst : NO_REG;
+}
+
+static uint32_t
+compile_call_method(struct compiler *c, struct pcvcm_node *node,
+        enum pcvcm_opcode op, uint32_t *first_child_reg)
+{
+    uint32_t local_args[NR_LOCAL_ARGS];
+    uint32_t *args = local_args;
+    uint32_t dst = NO_REG;
+    size_t nr_args = CHILDREN_NUMBER(node) + 1;
+    size_t check;
+
+    if (nr_args < 2)
+        return NO_REG;
+
+    if (nr_args > NR_LOCAL_ARGS) {
+        args = malloc(sizeof(*args) * nr_args);
+        if (args == NULL)
+            return NO_REG;
+    }
+
+    struct pcvcm_node *child = FIRST_CHILD(node);
+    args[0] = compile_node(c, child, &args[1]);
+    if (args[0] == NO_REG)
+        goto out;
+
+    /* the parameters are not evaluated if the caller is not callable */
+    dst = c->nr_regs++;
+    if (!emit(c, PCVCM_OP_CHECK_CALLABLE, dst, node, args, 2)) {
+        dst = NO_REG;
+        goto out;
+    }
+    check = c->nr_insns - 1;
+
+    child = NEXT_CHILD(child);
+    for (size_t i = 2; i < nr_args; i++) {
+        args[i] = compile_node(c, child, NULL);
+        if (args[i] == NO_REG) {
+            dst = NO_REG;
+            goto out;
+        }
+        child = NEXT_CHILD(child);
+    }
+
+    if (first_child_reg)
+        *first_child_reg = args[0];
+
+    if (!emit(c, op, dst, node, args, nr_args)) {
+        dst = NO_REG;
+        goto out;
+    }
+    c->insns[check].jump = c->nr_insns;
+
+out:
+    if (args != local_args)
+        free(args);
+    return dst;
+}
+
+static uint32_t
+compile_cjsonee(struct compiler *c, struct pcvcm_node *node,
+        uint32_t *first_child_reg)
+{
+    struct pcvcm_node *child = FIRST_CHILD(node);
+    uint32_t src;
+
+    /* leave the malformed ones to the tree walker to report */
+    if (child == NULL || is_cjsonee_op(child))
+        return NO_REG;
+
+    uint32_t dst = c->nr_regs++;
+    src = compile_node(c, child, NULL);
+    if (src == NO_REG || !emit(c, PCVCM_OP_MOVE, dst, node, &src, 1))
+        return NO_REG;
+
+    if (first_child_reg)
+        *first_child_reg = src;
+
+    struct pcvcm_node *op_node;
+    while ((op_node = NEXT_CHILD(child))) {
+        enum pcvcm_opcode jump_op = PCVCM_OP_MOVE;
+        size_t jump = 0;
+
+        child = NEXT_CHILD(op_node);
+        switch (op_node->type) {
+        case PCVCM_NODE_TYPE_CJSONEE_OP_SEMICOLON:
+            /* a tailing semicolon */
+            if (child == NULL)
+                return dst;
+            break;
+
+        case PCVCM_NODE_TYPE_CJSONEE_OP_AND:
+            jump_op = PCVCM_OP_JUMP_IF_FALSE;
+            break;
+
+        case PCVCM_NODE_TYPE_CJSONEE_OP_OR:
+            jump_op = PCVCM_OP_JUMP_IF_TRUE;
+            break;
+
+        default:
+            return NO_REG;
+        }
+
+        if (child == NULL || is_cjsonee_op(child))
+            return NO_REG;
+
+        /* skip the operand by the value so far for `&&` and `||` */
+        if (jump_op != PCVCM_OP_MOVE) {
+            if (!emit(c, jump_op, dst, op_node, &dst, 1))
+                return NO_REG;
+            jump = c->nr_insns - 1;
+        }
+
+        src = compile_node(c, child, NULL);
+        if (src == NO_REG || !emit(c, PCVCM_OP_MOVE, dst, node, &src, 1))
+            return NO_REG;
+
+        if (jump_op != PCVCM_OP_MOVE)
+            c->insns[jump].jump = c->nr_insns;
+    }
+
+    return dst;
+}
+
+static uint32_t
+compile_node(struct compiler *c, struct pcvcm_node *node,
+        uint32_t *first_child_reg)
+{
+    if (first_child_reg)
+        *first_child_reg = NO_REG;
+
+    if (node->const_id && node->type != PCVCM_NODE_TYPE_FUNC_CALL_GETTER)
+        return compile_leaf(c, node, PCVCM_OP_FOLDED);
+
+    switch (node->type) {
+    case PCVCM_NODE_TYPE_UNDEFINED:
+        return compile_leaf(c, node, PCVCM_OP_UNDEFINED);
+
+    case PCVCM_NODE_TYPE_OBJECT:
+        return compile_with_children(c, node, PCVCM_OP_MAKE_OBJECT,
+                CHILDREN_NUMBER(node) & ~(size_t)1,
+                (node->extra & EXTRA_INTERN_KEYS_FLAG), first_child_reg);
+
+    case PCVCM_NODE_TYPE_ARRAY:
+        return compile_with_children(c, node, PCVCM_OP_MAKE_ARRAY,
+                CHILDREN_NUMBER(node), false, first_child_reg);
+
+    case PCVCM_NODE_TYPE_STRING:
+        return compile_leaf(c, node, PCVCM_OP_STRING);
+
+    case PCVCM_NODE_TYPE_NULL:
+        return compile_leaf(c, node, PCVCM_OP_NULL);
+
+    case PCVCM_NODE_TYPE_BOOLEAN:
+        return compile_leaf(c, node, PCVCM_OP_BOOLEAN);
+
+    case PCVCM_NODE_TYPE_NUMBER:
+        return compile_leaf(c, node, PCVCM_OP_NUMBER);
+
+    case PCVCM_NODE_TYPE_LONG_INT:
+        return compile_leaf(c, node, PCVCM_OP_LONG_INT);
+
+    case PCVCM_NODE_TYPE_ULONG_INT:
+        return compile_leaf(c, node, PCVCM_OP_ULONG_INT);
+
+    case PCVCM_NODE_TYPE_LONG_DOUBLE:
+        return compile_leaf(c, node, PCVCM_OP_LONG_DOUBLE);
+
+    case PCVCM_NODE_TYPE_BYTE_SEQUENCE:
+        return compile_leaf(c, node, PCVCM_OP_BYTE_SEQUENCE);
+
+    case PCVCM_NODE_TYPE_FUNC_CONCAT_STRING:
+        return compile_with_children(c, node, PCVCM_OP_CONCAT,
+                CHILDREN_NUMBER(node), false, first_child_reg);
+
+    case PCVCM_NODE_TYPE_FUNC_GET_VARIABLE:
+        return compile_get_variable(c, node, first_child_reg);
+
+    case PCVCM_NODE_TYPE_FUNC_GET_ELEMENT:
+        return compile_get_element(c, node, first_child_reg);
+
+    case PCVCM_NODE_TYPE_FUNC_CALL_GETTER:
+        return compile_call_method(c, node, PCVCM_OP_CALL_GETTER,
+                first_child_reg);
+
+    case PCVCM_NODE_TYPE_FUNC_CALL_SETTER:
+        return compile_call_method(c, node, PCVCM_OP_CALL_SETTER,
+                first_child_reg);
+
+    case PCVCM_NODE_TYPE_CJSONEE:
+        return compile_cjsonee(c, node, first_child_reg);
+
+    default:
+        /* the tree walker gives null for the others */
+        return compile_leaf(c, node, PCVCM_OP_NULL);
+    }
+}
+
+struct pcvcm_code *pcvcm_code_new(struct pcvcm_node *tree)
+{
+    struct compiler c = { };
+    struct pcvcm_code *code = NULL;
+
+    uint32_t result = compile_node(&c, tree, NULL);
+    if (result == NO_REG)
+        goto out;
+
+    /* one block for the code, the instructions, and the operands */
+    size_t sz_insns = sizeof(struct pcvcm_insn) * c.nr_insns;
+    code = malloc(sizeof(*code) + sz_insns + sizeof(uint32_t) * c.nr_args);
+    if (code == NULL)
+        goto out;
+
+    code->nr_regs = c.nr_regs;
+    code->nr_insns = c.nr_insns;
+    code->result = result;
+    code->insns = (struct pcvcm_insn *)(code + 1);
+    code->args = (uint32_t *)((char *)code->insns + sz_insns);
+    memcpy(code->insns, c.insns, sz_insns);
+    if (c.nr_args)
+        memcpy(code->args, c.args, sizeof(uint32_t) * c.nr_args);
+
+out:
+    free(c.insns);
+    free(c.args);
+    return code;
+}
+
+void pcvcm_code_destroy(struct pcvcm_code *code)
+{
+    free(code);
+}
+
+static purc_variant_t
+make_object(purc_variant_t *regs, const uint32_t *args, size_t nr_args)
+{
+    purc_variant_t object = purc_variant_make_object(0,
+            PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+    if (object == PURC_VARIANT_INVALID) {
+        return PURC_VARIANT_INVALID;
+    }
+
+    for (size_t i = 0; i < nr_args; i += 2) {
+        if (!purc_variant_object_set(object, regs[args[i]],
+                    regs[args[i + 1]])) {
+            purc_variant_unref(object);
+            return PURC_VARIANT_INVALID;
+        }
+    }
+
+    return object;
+}
+
+static purc_variant_t
+make_array(purc_variant_t *regs, const uint32_t *args, size_t nr_args)
+{
+    purc_variant_t array = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    if (array == PURC_VARIANT_INVALID) {
+        return PURC_VARIANT_INVALID;
+    }
+
+    for (size_t i = 0; i < nr_args; i++) {
+        if (!purc_variant_array_append(array, regs[args[i]])) {
+            purc_variant_unref(array);
+            return PURC_VARIANT_INVALID;
+        }
+    }
+
+    return array;
+}
+
+/* concatenates the stringified values into one buffer */
+static purc_variant_t
+concat_string(purc_variant_t *regs, const uint32_t *args, size_t nr_args)
+{
+    purc_variant_t local_values[NR_LOCAL_ARGS];
+    purc_variant_t *values = local_values;
+
+    if (nr_args > NR_LOCAL_ARGS) {
+        values = malloc(sizeof(*values) * nr_args);
+        if (values == NULL) {
+            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return PURC_VARIANT_INVALID;
+        }
+    }
+
+    for (size_t i = 0; i < nr_args; i++) {
+        values[i] = regs[args[i]];
+    }
+
+    purc_variant_t ret = pcvcm_concat_values(values, nr_args);
+
+    if (values != local_values)
+        free(values);
+    return ret;
+}
+
+static purc_variant_t
+call_method(struct pcvcm_insn *insn, purc_variant_t *regs,
+        const uint32_t *args, bool silently)
+{
+    purc_variant_t local_params[NR_LOCAL_ARGS];
+    purc_variant_t *params = local_params;
+    size_t nr_params = insn->nr_args - 2;
+
+    if (nr_params > NR_LOCAL_ARGS) {
+        params = malloc(sizeof(*params) * nr_params);
+        if (params == NULL) {
+            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return PURC_VARIANT_INVALID;
+        }
+    }
+
+    for (size_t i = 0; i < nr_params; i++) {
+        params[i] = regs[args[i + 2]];
+    }
+
+    purc_variant_t root = (args[1] == NO_REG) ?
+        PURC_VARIANT_INVALID : regs[args[1]];
+    purc_variant_t ret;
+    if (insn->node->const_id && insn->op == PCVCM_OP_CALL_GETTER) {
+        ret = pcvcm_call_method_folding(insn->node, regs[args[0]], root,
+                nr_params, nr_params ? params : NULL, silently);
+    }
+    else {
+        ret = pcvcm_call_method(insn->node, regs[args[0]], root,
+                nr_params, nr_params ? params : NULL,
+                (insn->op == PCVCM_OP_CALL_GETTER) ?
+                    GETTER_METHOD : SETTER_METHOD,
+                silently);
+    }
+
+    if (params != local_params)
+        free(params);
+    return ret;
+}
+
+purc_variant_t pcvcm_code_eval(struct pcvcm_code *code,
+        struct pcvcm_node_op *ops, bool silently)
+{
+    purc_variant_t local_regs[NR_LOCAL_REGS];
+    purc_variant_t *regs = local_regs;
+    purc_variant_t ret = PURC_VARIANT_INVALID;
+
+    if (code->nr_regs > NR_LOCAL_REGS) {
+        regs = calloc(code->nr_regs, sizeof(*regs));
+        if (regs == NULL) {
+            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return PURC_VARIANT_INVALID;
+        }
+    }
+    else {
+        memset(regs, 0, sizeof(*regs) * code->nr_regs);
+    }
+
+    size_t pc = 0;
+    while (pc < code->nr_insns) {
+        struct pcvcm_insn *insn = code->insns + pc++;
+        const uint32_t *args = code->args + insn->args;
+        struct pcvcm_node *node = insn->node;
+        purc_variant_t v;
+
+        switch (insn->op) {
+        case PCVCM_OP_UNDEFINED:
+            v = purc_variant_make_undefined();
+            break;
+
+        case PCVCM_OP_NULL:
+            v = purc_variant_make_null();
+            break;
+
+        case PCVCM_OP_BOOLEAN:
+            v = purc_variant_make_boolean(node->b);
+            break;
+
+        case PCVCM_OP_NUMBER:
+            v = purc_variant_make_number(node->d);
+            break;
+
+        case PCVCM_OP_LONG_INT:
+            v = purc_variant_make_longint(node->i64);
+            break;
+
+        case PCVCM_OP_ULONG_INT:
+            v = purc_variant_make_ulongint(node->u64);
+            break;
+
+        case PCVCM_OP_LONG_DOUBLE:
+            v = purc_variant_make_longdouble(node->ld);
+            break;
+
+        case PCVCM_OP_STRING:
+            v = purc_variant_make_string((char*)node->sz_ptr[1], false);
+            break;
+
+        case PCVCM_OP_OBJECT_KEY:
+            v = pcvariant_make_object_key((const char*)node->sz_ptr[1]);
+            break;
+
+        case PCVCM_OP_BYTE_SEQUENCE:
+            v = (node->sz_ptr[0] > 0) ? purc_variant_make_byte_sequence(
+                    (void*)node->sz_ptr[1], node->sz_ptr[0])
+                    : purc_variant_make_byte_sequence_empty();
+            break;
+
+        case PCVCM_OP_MAKE_OBJECT:
+            v = make_object(regs, args, insn->nr_args);
+            break;
+
+        case PCVCM_OP_MAKE_ARRAY:
+            v = make_array(regs, args, insn->nr_args);
+            break;
+
+        case PCVCM_OP_CONCAT:
+            v = concat_string(regs, args, insn->nr_args);
+            break;
+
+        case PCVCM_OP_GET_VAR:
+            v = pcvcm_get_variable(ops, regs[args[0]]);
+            break;
+
+        case PCVCM_OP_GET_ELEM:
+            v = pcvcm_get_element(node, regs[args[0]], regs[args[1]],
+                    (args[2] == NO_REG) ? PURC_VARIANT_INVALID : regs[args[2]],
+                    silently);
+            break;
+
+        case PCVCM_OP_CHECK_CALLABLE:
+            if (pcvcm_is_callable(regs[args[0]])) {
+                if (node->const_id &&
+                        (v = pcvcm_folded_value(node, regs[args[0]]))) {
+                    /* folded */
+                }
+                else if (pcvcm_is_lazy(node, regs[args[0]])) {
+                    v = pcvcm_call_method_lazily(node, regs[args[0]],
+                            (args[1] == NO_REG) ?
+                                PURC_VARIANT_INVALID : regs[args[1]],
+                            ops, silently);
+                }
+                else {
+                    continue;
+                }
+            }
+            else {
+                v = PURC_VARIANT_INVALID;
+            }
+            pc = insn->jump;
+            break;
+
+        case PCVCM_OP_CALL_GETTER:
+        case PCVCM_OP_CALL_SETTER:
+            v = call_method(insn, regs, args, silently);
+            break;
+
+        case PCVCM_OP_FOLDED:
+            v = pcvcm_node_to_variant(node, ops, silently);
+            break;
+
+        case PCVCM_OP_MOVE:
+            v = purc_variant_ref(regs[args[0]]);
+            break;
+
+        case PCVCM_OP_JUMP_IF_FALSE:
+            if (!purc_variant_booleanize(regs[args[0]]))
+                pc = insn->jump;
+            continue;
+
+        case PCVCM_OP_JUMP_IF_TRUE:
+            if (purc_variant_booleanize(regs[args[0]]))
+                pc = insn->jump;
+            continue;
+
+        default:
+            PC_ASSERT(0);
+            v = PURC_VARIANT_INVALID;
+            break;
+        }
+
+        if (v == PURC_VARIANT_INVALID) {
+            if (!silently || pcvcm_has_fatal_error())
+                goto out;
+            v = purc_variant_make_undefined();
+        }
+
+        if (regs[insn->dst])
+            purc_variant_unref(regs[insn->dst]);
+        regs[insn->dst] = v;
+    }
+
+    ret = regs[code->result];
+    regs[code->result] = PURC_VARIANT_INVALID;
+
+out:
+    for (size_t i = 0; i < code->nr_regs; i++) {
+        if (regs[i])
+            purc_variant_unref(regs[i]);
+    }
+
+    if (regs != local_regs)
+        free(regs);
+    return ret;
+}
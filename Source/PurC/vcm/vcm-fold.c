@@ -0,0 +1,291 @@
+/*
+ * @file vcm-fold.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The constant folding of VCM trees.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A node made of literals only is constant. The largest constant subtrees
+ * rooted at an object, an array, or a string concatenation, and the calls
+ * with constant arguments, get an identifier when the tree is marked.
+ *
+ * The vDOM and its trees may be shared by the instances, but a variant
+ * belongs to the instance made it. So the folded values are kept by the
+ * instance in a map by the identifiers, instead of on the nodes, and an
+ * identifier is never reused.
+ *
+ * A folded string is shared by reference as is; a folded container is
+ * cloned for every use, since the consumer may change it. A call is folded
+ * only if the getter called is pure and it returned without any error; the
+ * folded value is used only if the caller turns out to be the same getter
+ * when evaluating the node again.
+ */
+
+#include "config.h"
+
+#include "purc-utils.h"
+#include "purc-errors.h"
+#include "private/errors.h"
+#include "private/instance.h"
+#include "private/variant.h"
+#include "private/map.h"
+#include "private/vcm.h"
+
+#include "vcm-internal.h"
+
+#include <stdlib.h>
+
+#if HAVE(STDATOMIC_H)
+#include <stdatomic.h>
+#else
+#error "Not implemented for this platform."
+#endif
+
+#define TREE_NODE(node)              ((struct pctree_node*)(node))
+#define VCM_NODE(node)               ((struct pcvcm_node*)(node))
+#define FIRST_CHILD(node)            \
+    (VCM_NODE(pctree_node_child(TREE_NODE(node))))
+#define NEXT_CHILD(node)             \
+    ((node) ? VCM_NODE(pctree_node_next(TREE_NODE(node))) : NULL)
+
+/* the values kept by an instance at most */
+#define MAX_FOLDED_VALUES           4096
+
+struct folded_value {
+    purc_variant_t  value;
+    /* the getter called for a call node, or PURC_VARIANT_INVALID */
+    purc_variant_t  method;
+};
+
+static atomic_uint last_const_id;
+
+static bool is_literal(struct pcvcm_node *node)
+{
+    switch (node->type) {
+    case PCVCM_NODE_TYPE_UNDEFINED:
+    case PCVCM_NODE_TYPE_STRING:
+    case PCVCM_NODE_TYPE_NULL:
+    case PCVCM_NODE_TYPE_BOOLEAN:
+    case PCVCM_NODE_TYPE_NUMBER:
+    case PCVCM_NODE_TYPE_LONG_INT:
+    case PCVCM_NODE_TYPE_ULONG_INT:
+    case PCVCM_NODE_TYPE_LONG_DOUBLE:
+    case PCVCM_NODE_TYPE_BYTE_SEQUENCE:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+/* whether it is worth folding the constant node */
+static bool is_worth_folding(struct pcvcm_node *node)
+{
+    switch (node->type) {
+    case PCVCM_NODE_TYPE_OBJECT:
+    case PCVCM_NODE_TYPE_ARRAY:
+    case PCVCM_NODE_TYPE_FUNC_CONCAT_STRING:
+        return pctree_node_children_number(TREE_NODE(node)) > 0;
+
+    default:
+        return false;
+    }
+}
+
+static inline bool is_const(struct pcvcm_node *node)
+{
+    return node && (node->extra & EXTRA_CONST_FLAG);
+}
+
+static void assign_const_id(struct pcvcm_node *node)
+{
+    if (node->const_id == 0) {
+        uint32_t id;
+        do {
+            id = atomic_fetch_add(&last_const_id, 1) + 1;
+        } while (id == 0);
+        node->const_id = id;
+    }
+}
+
+static bool mark_constants(struct pcvcm_node *node)
+{
+    bool all_const = true;
+    struct pcvcm_node *child = FIRST_CHILD(node);
+    while (child) {
+        if (!mark_constants(child))
+            all_const = false;
+        child = NEXT_CHILD(child);
+    }
+
+    bool constant;
+    switch (node->type) {
+    case PCVCM_NODE_TYPE_OBJECT:
+    case PCVCM_NODE_TYPE_ARRAY:
+    case PCVCM_NODE_TYPE_FUNC_CONCAT_STRING:
+        constant = all_const;
+        break;
+
+    default:
+        constant = is_literal(node);
+        break;
+    }
+
+    if (constant) {
+        node->extra |= EXTRA_CONST_FLAG;
+        return true;
+    }
+
+    child = FIRST_CHILD(node);
+    if (node->type == PCVCM_NODE_TYPE_FUNC_CALL_GETTER && child) {
+        /* the caller is checked when evaluated */
+        bool const_args = true;
+        for (struct pcvcm_node *arg = NEXT_CHILD(child); arg;
+                arg = NEXT_CHILD(arg)) {
+            if (!is_const(arg)) {
+                const_args = false;
+                break;
+            }
+        }
+
+        if (const_args)
+            assign_const_id(node);
+    }
+
+    while (child) {
+        if (is_const(child) && is_worth_folding(child))
+            assign_const_id(child);
+        child = NEXT_CHILD(child);
+    }
+
+    return false;
+}
+
+void pcvcm_node_fold_constants(struct pcvcm_node *tree)
+{
+    if (tree && mark_constants(tree) && is_worth_folding(tree))
+        assign_const_id(tree);
+}
+
+static int comp_const_ids(const void *key1, const void *key2)
+{
+    uintptr_t id1 = (uintptr_t)key1;
+    uintptr_t id2 = (uintptr_t)key2;
+    return (id1 > id2) - (id1 < id2);
+}
+
+static void free_folded_value(void *val)
+{
+    struct folded_value *folded = val;
+    purc_variant_unref(folded->value);
+    if (folded->method)
+        purc_variant_unref(folded->method);
+    free(folded);
+}
+
+void pcvcm_release_folded_values(struct pcinst *inst)
+{
+    if (inst->vcm_folded) {
+        pcutils_map_destroy(inst->vcm_folded);
+        inst->vcm_folded = NULL;
+    }
+}
+
+static purc_variant_t copy_value(purc_variant_t value)
+{
+    if (IS_CONTAINER(value->type))
+        return purc_variant_container_clone_recursively(value);
+
+    return purc_variant_ref(value);
+}
+
+purc_variant_t pcvcm_folded_value(struct pcvcm_node *node,
+        purc_variant_t method)
+{
+    struct pcinst *inst = pcinst_current();
+    if (inst == NULL || inst->vcm_folded == NULL)
+        return PURC_VARIANT_INVALID;
+
+    pcutils_map_entry *entry = pcutils_map_find(inst->vcm_folded,
+            (const void *)(uintptr_t)node->const_id);
+    if (entry == NULL)
+        return PURC_VARIANT_INVALID;
+
+    struct folded_value *folded = entry->val;
+    if (folded->method != method)
+        return PURC_VARIANT_INVALID;
+
+    return copy_value(folded->value);
+}
+
+void pcvcm_fold_value(struct pcvcm_node *node, purc_variant_t method,
+        purc_variant_t value)
+{
+    struct pcinst *inst = pcinst_current();
+    if (inst == NULL)
+        return;
+
+    if (inst->vcm_folded == NULL) {
+        inst->vcm_folded = pcutils_map_create(NULL, NULL, NULL,
+                free_folded_value, comp_const_ids, false);
+        if (inst->vcm_folded == NULL)
+            return;
+    }
+    else if (pcutils_map_get_size(inst->vcm_folded) >= MAX_FOLDED_VALUES) {
+        return;
+    }
+
+    struct folded_value *folded = malloc(sizeof(*folded));
+    if (folded == NULL)
+        return;
+
+    /* the caller may change the value it got */
+    folded->value = copy_value(value);
+    if (folded->value == PURC_VARIANT_INVALID) {
+        free(folded);
+        return;
+    }
+    folded->method = method ? purc_variant_ref(method) : PURC_VARIANT_INVALID;
+    if (pcutils_map_find_replace_or_insert(inst->vcm_folded,
+                (const void *)(uintptr_t)node->const_id, folded, NULL)) {
+        free_folded_value(folded);
+    }
+}
+
+purc_variant_t pcvcm_call_method_folding(struct pcvcm_node *node,
+        purc_variant_t caller_var, purc_variant_t caller_root,
+        size_t nr_params, purc_variant_t *params, bool silently)
+{
+    /* a value given silently for an error is told by the error code,
+       so the call is not folded if there is an error already */
+    bool foldable = purc_variant_is_dynamic(caller_var) &&
+        (caller_var->flags & PCVARIANT_FLAG_DYNAMIC_PURE) &&
+        purc_get_last_error() == PURC_ERROR_OK;
+
+    purc_variant_t ret = pcvcm_call_method(node, caller_var, caller_root,
+            nr_params, params, GETTER_METHOD, silently);
+    if (foldable && ret != PURC_VARIANT_INVALID &&
+            purc_get_last_error() == PURC_ERROR_OK) {
+        pcvcm_fold_value(node, caller_var, ret);
+    }
+
+    return ret;
+}
@@ -0,0 +1,161 @@
+/**
+ * @file vcm-internal.h
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The internal interfaces shared by the tree walker and the compiled
+ *  code of VCM.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PURC_VCM_VCM_INTERNAL_H
+#define PURC_VCM_VCM_INTERNAL_H
+
+#include "private/vcm.h"
+#include "private/instance.h"
+
+/* the node being evaluated by the tree walker */
+struct pcvcm_walk_frame {
+    struct pcvcm_node *node;
+    /* the value of the first child of the node, not referenced */
+    purc_variant_t first_value;
+    struct pcvcm_walk_frame *parent;
+};
+
+struct pcvcm_node_op {
+    cb_find_var find_var;
+    void *find_var_ctxt;
+    /* log the value of every node evaluated */
+    bool trace;
+    /* the innermost node being evaluated by the tree walker */
+    struct pcvcm_walk_frame *frame;
+    /* the value of the first child of the node evaluated last, which is
+       the root of the caller for a getter or a call; it is kept here
+       instead of in the nodes, since a tree may be evaluated by
+       several threads at the same time */
+    purc_variant_t first_value;
+};
+
+enum method_type {
+    GETTER_METHOD,
+    SETTER_METHOD
+};
+
+/* the tree is compiled when it is evaluated for this time */
+#define PCVCM_NR_EVALS_TO_COMPILE       2
+
+#ifdef __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+bool is_cjsonee_op(struct pcvcm_node *node);
+
+bool pcvcm_has_fatal_error(void);
+
+/* evaluates the node by walking the subtree */
+purc_variant_t pcvcm_node_to_variant(struct pcvcm_node *node,
+        struct pcvcm_node_op *ops, bool silently);
+
+/* the variable named by name_var; the caller owns the returned reference */
+purc_variant_t pcvcm_get_variable(struct pcvcm_node_op *ops,
+        purc_variant_t name_var);
+
+/*
+ * The element of caller_var indexed by param_var for the get element node.
+ * caller_root is the value of the first child of the caller node, passed
+ * to the getter of a dynamic caller.
+ */
+purc_variant_t pcvcm_get_element(struct pcvcm_node *node,
+        purc_variant_t caller_var, purc_variant_t param_var,
+        purc_variant_t caller_root, bool silently);
+
+bool pcvcm_is_callable(purc_variant_t caller_var);
+
+/* concatenates the stringified values into a new string */
+purc_variant_t pcvcm_concat_values(purc_variant_t *values, size_t nr_values);
+
+/* calls the method of caller_var for the node, which names the method
+   in the statistics of the profiler */
+purc_variant_t pcvcm_call_method(struct pcvcm_node *node,
+        purc_variant_t caller_var, purc_variant_t caller_root, size_t nr_params, purc_variant_t *params,
+        enum method_type type, bool silently);
+
+#if ENABLE(VCM_PROFILE)
+/* the statistics of the current instance if the profiler is running */
+static inline struct pcvcm_profile *pcvcm_profiling(void)
+{
+    struct pcinst *inst = pcinst_current();
+    return UNLIKELY(inst != NULL) ? inst->vcm_profile : NULL;
+}
+#else
+#define pcvcm_profiling()       NULL
+#endif
+
+/* marks the beginning of an evaluation or a call; returns false if nested
+   too deep to count */
+bool pcvcm_profile_enter(struct pcvcm_profile *prof);
+
+/* counts the evaluation of the tree for the bottom frame of the stack */
+void pcvcm_profile_leave_tree(struct pcvcm_profile *prof,
+        struct pcvcm_node *tree, struct pcintr_stack *stack);
+
+/* counts the call to the method func for the node */
+void pcvcm_profile_leave_method(struct pcvcm_profile *prof,
+        const void *func, struct pcvcm_node *node);
+
+/* compiles the tree; returns NULL if the tree cannot be compiled */
+struct pcvcm_code *pcvcm_code_new(struct pcvcm_node *tree);
+
+void pcvcm_code_destroy(struct pcvcm_code *code);
+
+purc_variant_t pcvcm_code_eval(struct pcvcm_code *code,
+        struct pcvcm_node_op *ops, bool silently);
+
+/*
+ * The copy of the value folded for the node with a const_id, which is the
+ * result of calling method for a call node, or PURC_VARIANT_INVALID if not
+ * folded yet.
+ */
+purc_variant_t pcvcm_folded_value(struct pcvcm_node *node,
+        purc_variant_t method);
+
+/* keeps the value of the node with a const_id in the current instance */
+void pcvcm_fold_value(struct pcvcm_node *node, purc_variant_t method,
+        purc_variant_t value);
+
+/* calls the getter for the call node with a const_id, and folds the value
+   if the getter is pure */
+purc_variant_t pcvcm_call_method_folding(struct pcvcm_node *node,
+        purc_variant_t caller_var, purc_variant_t caller_root,
+        size_t nr_params, purc_variant_t *params, bool silently);
+
+/* whether the call node calls a getter taking lazy arguments */
+bool pcvcm_is_lazy(struct pcvcm_node *node, purc_variant_t caller_var);
+
+/* calls the lazy getter for the call node with the thunks of the
+   arguments, which are evaluated only when forced by the getter */
+purc_variant_t pcvcm_call_method_lazily(struct pcvcm_node *node,
+        purc_variant_t caller_var, purc_variant_t caller_root,
+        struct pcvcm_node_op *ops, bool silently);
+
+#ifdef __cplusplus
+}
+#endif  /* __cplusplus */
+
+#endif /* not defined PURC_VCM_VCM_INTERNAL_H */
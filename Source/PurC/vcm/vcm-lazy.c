@@ -0,0 +1,168 @@
+/*
+ * @file vcm-lazy.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The lazy arguments of the getters called by VCM.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A getter marked lazy gets a thunk for every argument instead of the value,
+ * and forces the ones it needs by purc_dvobj_force_argument(). A thunk is
+ * a native variant keeping the node of the argument and the operations of
+ * the evaluation, so it can only be forced during the call; the value is
+ * kept once forced.
+ */
+
+#include "config.h"
+
+#include "purc-utils.h"
+#include "purc-errors.h"
+#include "private/errors.h"
+#include "private/variant.h"
+#include "private/vcm.h"
+
+#include "vcm-internal.h"
+
+#include <stdlib.h>
+
+#define TREE_NODE(node)              ((struct pctree_node*)(node))
+#define VCM_NODE(node)               ((struct pcvcm_node*)(node))
+#define FIRST_CHILD(node)            \
+    (VCM_NODE(pctree_node_child(TREE_NODE(node))))
+#define NEXT_CHILD(node)             \
+    ((node) ? VCM_NODE(pctree_node_next(TREE_NODE(node))) : NULL)
+#define CHILDREN_NUMBER(node)        \
+    (pctree_node_children_number(TREE_NODE(node)))
+
+struct thunk {
+    /* NULL once the call returned */
+    struct pcvcm_node      *node;
+    struct pcvcm_node_op   *ops;
+    bool                    silently;
+
+    /* the value forced */
+    purc_variant_t          value;
+};
+
+static purc_nvariant_method no_property(const char *name)
+{
+    UNUSED_PARAM(name);
+    return NULL;
+}
+
+static void on_release(void *native_entity)
+{
+    struct thunk *thunk = native_entity;
+    if (thunk->value)
+        purc_variant_unref(thunk->value);
+    free(thunk);
+}
+
+static struct purc_native_ops thunk_ops = {
+    .property_getter            = no_property,
+    .property_setter            = no_property,
+    .property_eraser            = no_property,
+    .property_cleaner           = no_property,
+    .on_release                 = on_release,
+};
+
+bool pcvcm_is_lazy(struct pcvcm_node *node, purc_variant_t caller_var)
+{
+    return node->type == PCVCM_NODE_TYPE_FUNC_CALL_GETTER &&
+        purc_variant_is_dynamic(caller_var) &&
+        (caller_var->flags & PCVARIANT_FLAG_DYNAMIC_LAZY);
+}
+
+purc_variant_t pcvcm_force_argument(purc_variant_t arg)
+{
+    if (!purc_variant_is_native(arg) ||
+            purc_variant_native_get_ops(arg) != &thunk_ops)
+        return purc_variant_ref(arg);
+
+    struct thunk *thunk = purc_variant_native_get_entity(arg);
+    if (thunk->value == PURC_VARIANT_INVALID) {
+        if (thunk->node == NULL) {
+            pcinst_set_error(PURC_ERROR_WRONG_STAGE);
+            return PURC_VARIANT_INVALID;
+        }
+
+        thunk->value = pcvcm_node_to_variant(thunk->node, thunk->ops,
+                thunk->silently);
+        if (thunk->value == PURC_VARIANT_INVALID)
+            return PURC_VARIANT_INVALID;
+    }
+
+    return purc_variant_ref(thunk->value);
+}
+
+purc_variant_t pcvcm_call_method_lazily(struct pcvcm_node *node,
+        purc_variant_t caller_var, purc_variant_t caller_root,
+        struct pcvcm_node_op *ops, bool silently)
+{
+    purc_variant_t ret = PURC_VARIANT_INVALID;
+    size_t nr_params = CHILDREN_NUMBER(node) - 1;
+    purc_variant_t *params = NULL;
+    size_t i = 0;
+
+    if (nr_params > 0) {
+        params = calloc(nr_params, sizeof(purc_variant_t));
+        if (params == NULL) {
+            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            goto out;
+        }
+
+        struct pcvcm_node *param_node = NEXT_CHILD(FIRST_CHILD(node));
+        for (; i < nr_params; i++) {
+            struct thunk *thunk = malloc(sizeof(*thunk));
+            if (thunk == NULL) {
+                pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+                goto out_release;
+            }
+
+            thunk->node = param_node;
+            thunk->ops = ops;
+            thunk->silently = silently;
+            thunk->value = PURC_VARIANT_INVALID;
+            params[i] = purc_variant_make_native(thunk, &thunk_ops);
+            if (params[i] == PURC_VARIANT_INVALID) {
+                free(thunk);
+                goto out_release;
+            }
+
+            param_node = NEXT_CHILD(param_node);
+        }
+    }
+
+    ret = pcvcm_call_method(node, caller_var, caller_root, nr_params,
+            params, GETTER_METHOD, silently);
+
+out_release:
+    for (size_t j = 0; j < i; j++) {
+        /* the thunk may be kept by the getter */
+        struct thunk *thunk = purc_variant_native_get_entity(params[j]);
+        thunk->node = NULL;
+        thunk->ops = NULL;
+        purc_variant_unref(params[j]);
+    }
+    free(params);
+
+out:
+    return ret;
+}
@@ -0,0 +1,460 @@
+/*
+ * @file vcm-profile.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The profiler of VCM evaluation.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The evaluations and the calls being timed make a stack of frames; when
+ * one ends, its time is added to the nested time of the enclosing one,
+ * which is excluded from the self time of the latter.
+ *
+ * A tree is counted by its address, along with the element it belongs to;
+ * the tree of an attribute or a content of the vDOM lives as long as the
+ * element, so the entry is described again if the element changed. The
+ * trees evaluated for other purposes, e.g., the temporary ones, are not
+ * counted, but the time spent in them is still in the self time of the
+ * enclosing tree. A method is counted by its getter or setter, and named
+ * after the expression of the first call to it.
+ */
+
+#include "config.h"
+
+#include "purc-utils.h"
+#include "purc-errors.h"
+#include "private/errors.h"
+#include "private/instance.h"
+#include "private/interpreter.h"
+#include "private/map.h"
+#include "private/vcm.h"
+
+#include "vcm-internal.h"
+#include "../vdom/vdom-internal.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* the frames timed by the profiler at most */
+#define MAX_PROFILE_DEPTH           64
+
+struct profile_entry {
+    /* the element of a tree; NULL for a method */
+    const struct pcvdom_element *elem;
+
+    /* the attribute of a tree, NULL for a content;
+       the expression for a method */
+    char           *name;
+    int             line;
+
+    uint64_t        nr_calls;
+    uint64_t        total_ns;
+    uint64_t        self_ns;
+};
+
+struct profile_frame {
+    uint64_t        start_ns;
+    uint64_t        nested_ns;
+};
+
+struct pcvcm_profile {
+    /* struct profile_entry by the trees */
+    pcutils_map    *trees;
+    /* struct profile_entry by the getters and setters */
+    pcutils_map    *methods;
+
+    unsigned int    depth;
+    /* stopped by a call being timed; freed when the last frame is left */
+    bool            stopped;
+    struct profile_frame frames[MAX_PROFILE_DEPTH];
+};
+
+static inline uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int comp_addresses(const void *key1, const void *key2)
+{
+    uintptr_t a1 = (uintptr_t)key1;
+    uintptr_t a2 = (uintptr_t)key2;
+    return (a1 > a2) - (a1 < a2);
+}
+
+static void free_entry(void *val)
+{
+    struct profile_entry *entry = val;
+    free(entry->name);
+    free(entry);
+}
+
+int pcvcm_profile_start(struct pcinst *inst)
+{
+#if ENABLE(VCM_PROFILE)
+    if (inst->vcm_profile)
+        return 0;
+
+    struct pcvcm_profile *prof = calloc(1, sizeof(*prof));
+    if (prof == NULL)
+        goto failed;
+
+    prof->trees = pcutils_map_create(NULL, NULL, NULL, free_entry,
+            comp_addresses, false);
+    prof->methods = pcutils_map_create(NULL, NULL, NULL, free_entry,
+            comp_addresses, false);
+    if (prof->trees == NULL || prof->methods == NULL)
+        goto failed;
+
+    inst->vcm_profile = prof;
+    return 0;
+
+failed:
+    if (prof) {
+        if (prof->trees)
+            pcutils_map_destroy(prof->trees);
+        if (prof->methods)
+            pcutils_map_destroy(prof->methods);
+        free(prof);
+    }
+    pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    return -1;
+#else
+    UNUSED_PARAM(inst);
+    pcinst_set_error(PURC_ERROR_NOT_SUPPORTED);
+    return -1;
+#endif
+}
+
+static void destroy_profile(struct pcvcm_profile *prof)
+{
+    pcutils_map_destroy(prof->trees);
+    pcutils_map_destroy(prof->methods);
+    free(prof);
+}
+
+void pcvcm_profile_stop(struct pcinst *inst)
+{
+    struct pcvcm_profile *prof = inst->vcm_profile;
+    if (prof) {
+        inst->vcm_profile = NULL;
+        if (prof->depth > 0)
+            prof->stopped = true;
+        else
+            destroy_profile(prof);
+    }
+}
+
+bool pcvcm_profile_enter(struct pcvcm_profile *prof)
+{
+    if (prof->depth >= MAX_PROFILE_DEPTH)
+        return false;
+
+    struct profile_frame *frame = prof->frames + prof->depth++;
+    frame->nested_ns = 0;
+    frame->start_ns = now_ns();
+    return true;
+}
+
+/* pops the frame; returns the time of it and gives the self time */
+static uint64_t leave_frame(struct pcvcm_profile *prof, uint64_t *self_ns)
+{
+    struct profile_frame *frame = prof->frames + --prof->depth;
+    uint64_t elapsed = now_ns() - frame->start_ns;
+    *self_ns = (elapsed > frame->nested_ns) ? elapsed - frame->nested_ns : 0;
+    return elapsed;
+}
+
+static inline void add_nested(struct pcvcm_profile *prof, uint64_t ns)
+{
+    if (prof->depth > 0)
+        prof->frames[prof->depth - 1].nested_ns += ns;
+}
+
+/* the statistics of a stopped profiler are not counted any more */
+static inline bool release_if_stopped(struct pcvcm_profile *prof)
+{
+    if (!prof->stopped)
+        return false;
+
+    if (prof->depth == 0)
+        destroy_profile(prof);
+    return true;
+}
+
+static void count(struct profile_entry *entry, uint64_t elapsed,
+        uint64_t self_ns)
+{
+    entry->nr_calls++;
+    entry->total_ns += elapsed;
+    entry->self_ns += self_ns;
+}
+
+/* finds the attribute or the content of the element with the tree */
+static bool describe_tree(struct pcvdom_element *elem,
+        struct pcvcm_node *tree, const char **attr_key)
+{
+    for (size_t i = 0; i < elem->nr_attrs; i++) {
+        if (elem->attrs[i]->val == tree) {
+            *attr_key = elem->attrs[i]->key;
+            return true;
+        }
+    }
+
+    struct pcvdom_node *child = pcvdom_node_first_child(&elem->node);
+    for (; child; child = pcvdom_node_next_sibling(child)) {
+        if (child->type == PCVDOM_NODE_CONTENT &&
+                PCVDOM_CONTENT_FROM_NODE(child)->vcm == tree) {
+            *attr_key = NULL;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void pcvcm_profile_leave_tree(struct pcvcm_profile *prof,
+        struct pcvcm_node *tree, struct pcintr_stack *stack)
+{
+    uint64_t self_ns;
+    uint64_t elapsed = leave_frame(prof, &self_ns);
+    if (release_if_stopped(prof))
+        return;
+
+    struct pcintr_stack_frame *frame = pcintr_stack_get_bottom_frame(stack);
+    struct pcvdom_element *elem = frame ? frame->pos : NULL;
+
+    struct profile_entry *entry = NULL;
+    pcutils_map_entry *found = pcutils_map_find(prof->trees, tree);
+    if (found) {
+        entry = found->val;
+        if (entry->elem != elem)
+            entry = NULL;
+    }
+
+    if (entry == NULL) {
+        const char *attr_key;
+        if (elem == NULL || !describe_tree(elem, tree, &attr_key))
+            goto not_counted;
+
+        entry = calloc(1, sizeof(*entry));
+        if (entry == NULL)
+            goto not_counted;
+
+        entry->elem = elem;
+        entry->name = attr_key ? strdup(attr_key) : NULL;
+        entry->line = elem->line;
+        if (pcutils_map_find_replace_or_insert(prof->trees, tree, entry,
+                    NULL)) {
+            free_entry(entry);
+            goto not_counted;
+        }
+    }
+
+    count(entry, elapsed, self_ns);
+    add_nested(prof, elapsed);
+    return;
+
+not_counted:
+    /* the nested ones were counted already */
+    add_nested(prof, elapsed - self_ns);
+}
+
+static char *describe_method(struct pcvcm_node *node)
+{
+    if (node == NULL)
+        return NULL;
+
+    if (node->type == PCVCM_NODE_TYPE_FUNC_CALL_GETTER ||
+            node->type == PCVCM_NODE_TYPE_FUNC_CALL_SETTER) {
+        node = (struct pcvcm_node *)pctree_node_child(&node->tree_node);
+        if (node == NULL)
+            return NULL;
+    }
+
+    size_t len;
+    return pcvcm_node_to_string(node, &len);
+}
+
+void pcvcm_profile_leave_method(struct pcvcm_profile *prof,
+        const void *func, struct pcvcm_node *node)
+{
+    uint64_t self_ns;
+    uint64_t elapsed = leave_frame(prof, &self_ns);
+    if (release_if_stopped(prof))
+        return;
+
+    struct profile_entry *entry;
+    pcutils_map_entry *found = pcutils_map_find(prof->methods, func);
+    if (found) {
+        entry = found->val;
+    }
+    else if ((entry = calloc(1, sizeof(*entry)))) {
+        entry->name = describe_method(node);
+        if (pcutils_map_find_replace_or_insert(prof->methods, func, entry,
+                    NULL)) {
+            free_entry(entry);
+            entry = NULL;
+        }
+    }
+
+    if (entry) {
+        count(entry, elapsed, self_ns);
+        add_nested(prof, elapsed);
+    }
+    else {
+        add_nested(prof, elapsed - self_ns);
+    }
+}
+
+struct entry_list {
+    struct profile_entry  **entries;
+    size_t                  nr_entries;
+};
+
+static int collect_entry(void *key, void *val, void *ud)
+{
+    UNUSED_PARAM(key);
+
+    struct entry_list *list = ud;
+    list->entries[list->nr_entries++] = val;
+    return 0;
+}
+
+static int comp_total_times(const void *p1, const void *p2)
+{
+    const struct profile_entry *e1 = *(const struct profile_entry **)p1;
+    const struct profile_entry *e2 = *(const struct profile_entry **)p2;
+    return (e1->total_ns < e2->total_ns) - (e1->total_ns > e2->total_ns);
+}
+
+static bool set_member(purc_variant_t obj, const char *key,
+        purc_variant_t val)
+{
+    if (val == PURC_VARIANT_INVALID)
+        return false;
+
+    bool ok = purc_variant_object_set_by_static_ckey(obj, key, val);
+    purc_variant_unref(val);
+    return ok;
+}
+
+static purc_variant_t make_name(const char *name)
+{
+    return name ? purc_variant_make_string(name, false) :
+        purc_variant_make_null();
+}
+
+static purc_variant_t make_entry(const struct profile_entry *entry)
+{
+    purc_variant_t obj = purc_variant_make_object(0,
+            PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+    if (obj == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    bool ok;
+    if (entry->elem) {
+        ok = set_member(obj, "element",
+                purc_variant_make_string(entry->elem->tag_name, false)) &&
+            set_member(obj, "attribute", make_name(entry->name)) &&
+            set_member(obj, "line", purc_variant_make_longint(entry->line));
+    }
+    else {
+        ok = set_member(obj, "method", make_name(entry->name));
+    }
+
+    ok = ok &&
+        set_member(obj, "calls", purc_variant_make_ulongint(entry->nr_calls)) &&
+        set_member(obj, "totalTime",
+                purc_variant_make_number(entry->total_ns / 1e9)) &&
+        set_member(obj, "selfTime",
+                purc_variant_make_number(entry->self_ns / 1e9));
+    if (!ok) {
+        purc_variant_unref(obj);
+        return PURC_VARIANT_INVALID;
+    }
+
+    return obj;
+}
+
+static purc_variant_t make_report(pcutils_map *map)
+{
+    purc_variant_t arr = PURC_VARIANT_INVALID;
+    struct entry_list list = { NULL, 0 };
+    size_t nr = pcutils_map_get_size(map);
+
+    if (nr > 0) {
+        list.entries = malloc(sizeof(*list.entries) * nr);
+        if (list.entries == NULL) {
+            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            goto failed;
+        }
+
+        pcutils_map_traverse(map, &list, collect_entry);
+        qsort(list.entries, list.nr_entries, sizeof(*list.entries),
+                comp_total_times);
+    }
+
+    arr = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    if (arr == PURC_VARIANT_INVALID)
+        goto failed;
+
+    for (size_t i = 0; i < list.nr_entries; i++) {
+        purc_variant_t obj = make_entry(list.entries[i]);
+        if (obj == PURC_VARIANT_INVALID)
+            goto failed;
+
+        bool ok = purc_variant_array_append(arr, obj);
+        purc_variant_unref(obj);
+        if (!ok)
+            goto failed;
+    }
+
+    free(list.entries);
+    return arr;
+
+failed:
+    if (arr)
+        purc_variant_unref(arr);
+    free(list.entries);
+    return PURC_VARIANT_INVALID;
+}
+
+purc_variant_t pcvcm_profile_report(struct pcinst *inst)
+{
+    struct pcvcm_profile *prof = inst->vcm_profile;
+    if (prof == NULL)
+        return purc_variant_make_null();
+
+    purc_variant_t report = purc_variant_make_object(0,
+            PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+    if (report == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    if (!set_member(report, "roots", make_report(prof->trees)) ||
+            !set_member(report, "methods", make_report(prof->methods))) {
+        purc_variant_unref(report);
+        return PURC_VARIANT_INVALID;
+    }
+
+    return report;
+}
@@ -26,6 +26,7 @@
 #include <stdint.h>
 #include <string.h>
 #include <errno.h>
+#include <inttypes.h>
 
 #include "config.h"
 #include "purc-utils.h"
@@ -35,7 +36,19 @@
 #include "private/vcm.h"
 #include "private/stack.h"
 #include "private/interpreter.h"
+#include "private/instance.h"
 #include "private/utils.h"
+#include "private/variant.h"
+#include "private/trace.h"
+#include "private/metrics.h"
+
+#include "vcm-internal.h"
+
+#if HAVE(STDATOMIC_H)
+#include <stdatomic.h>
+#else
+#error "Not implemented for this platform."
+#endif
 
 #define TREE_NODE(node)              ((struct pctree_node*)(node))
 #define VCM_NODE(node)               ((struct pcvcm_node*)(node))
@@ -54,8 +67,6 @@
 #define MIN_BUF_SIZE         32
 #define MAX_BUF_SIZE         SIZE_MAX
 
-#define PURC_ENVV_VCM_LOG_ENABLE    "PURC_VCM_LOG_ENABLE"
-
 typedef
 void (*pcvcm_node_handle)(purc_rwstream_t rws, struct pcvcm_node *node,
         bool ignore_string_quoted);
@@ -68,11 +79,6 @@ static
 void pcvcm_node_serialize_to_rwstream(purc_rwstream_t rws,
         struct pcvcm_node *node, bool ignore_string_quoted);
 
-struct pcvcm_node_op {
-    cb_find_var find_var;
-    void *find_var_ctxt;
-};
-
 // expression variable
 struct pcvcm_ev {
     struct pcvcm_node *vcm;
@@ -81,20 +87,168 @@ struct pcvcm_ev {
     bool release_vcm;
 };
 
-static bool _print_vcm_log = false;
+#define ARENA_CHUNK_SIZE            (4096 * 4)
+/* enough for the long double in pcvcm_node */
+#define ARENA_ALIGN                 16
+#define ARENA_ALIGN_SIZE(sz)        \
+    (((sz) + ARENA_ALIGN - 1) & ~((size_t)ARENA_ALIGN - 1))
+
+struct arena_chunk {
+    struct arena_chunk *prev;
+    size_t size;
+    size_t used;
+};
+
+#define ARENA_CHUNK_HDR_SIZE        ARENA_ALIGN_SIZE(sizeof(struct arena_chunk))
+
+struct pcvcm_arena {
+    struct arena_chunk *chunk;
+    /* the vDOM may be released in another thread */
+    atomic_ulong refc;
+};
+
+struct pcvcm_arena *pcvcm_arena_new(void)
+{
+    struct pcvcm_arena *arena = (struct pcvcm_arena*)calloc(1,
+            sizeof(struct pcvcm_arena));
+    if (!arena) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+    atomic_init(&arena->refc, 1);
+    return arena;
+}
+
+struct pcvcm_arena *pcvcm_arena_ref(struct pcvcm_arena *arena)
+{
+    atomic_fetch_add(&arena->refc, 1);
+    return arena;
+}
+
+void pcvcm_arena_unref(struct pcvcm_arena *arena)
+{
+    if (!arena || atomic_fetch_sub(&arena->refc, 1) > 1) {
+        return;
+    }
+
+    struct arena_chunk *chunk = arena->chunk;
+    while (chunk) {
+        struct arena_chunk *prev = chunk->prev;
+        free(chunk);
+        chunk = prev;
+    }
+    free(arena);
+}
+
+struct pcvcm_arena *pcvcm_arena_switch(struct pcvcm_arena *arena)
+{
+    struct pcinst *inst = pcinst_current();
+    if (!inst) {
+        return NULL;
+    }
+
+    struct pcvcm_arena *old = inst->vcm_arena;
+    inst->vcm_arena = arena;
+    return old;
+}
+
+static inline struct pcvcm_arena *current_arena(void)
+{
+    struct pcinst *inst = pcinst_current();
+    return inst ? inst->vcm_arena : NULL;
+}
+
+/* returns zeroed memory from the arena */
+static void *arena_alloc(struct pcvcm_arena *arena, size_t size)
+{
+    size = ARENA_ALIGN_SIZE(size);
+
+    struct arena_chunk *chunk = arena->chunk;
+    if (!chunk || chunk->size - chunk->used < size) {
+        /* a large block gets a chunk of its own */
+        size_t sz_chunk = size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE;
+        chunk = (struct arena_chunk*)malloc(ARENA_CHUNK_HDR_SIZE + sz_chunk);
+        if (!chunk) {
+            return NULL;
+        }
+        chunk->size = sz_chunk;
+        chunk->used = 0;
+        if (arena->chunk && size > ARENA_CHUNK_SIZE) {
+            /* keep bumping in the current chunk */
+            chunk->prev = arena->chunk->prev;
+            arena->chunk->prev = chunk;
+        }
+        else {
+            chunk->prev = arena->chunk;
+            arena->chunk = chunk;
+        }
+    }
+
+    void *p = (uint8_t*)chunk + ARENA_CHUNK_HDR_SIZE + chunk->used;
+    chunk->used += size;
+    memset(p, 0, size);
+    return p;
+}
+
+struct pcvcm_arena *pcvcm_arena_current(void)
+{
+    return current_arena();
+}
+
+void *pcvcm_arena_alloc(struct pcvcm_arena *arena, size_t size)
+{
+    void *p = arena_alloc(arena, size);
+    if (!p) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    }
+    return p;
+}
 
 static struct pcvcm_node *pcvcm_node_new(enum pcvcm_node_type type)
 {
-    struct pcvcm_node *node = (struct pcvcm_node*)calloc(1,
-            sizeof(struct pcvcm_node));
+    struct pcvcm_arena *arena = current_arena();
+    struct pcvcm_node *node;
+    if (arena) {
+        node = (struct pcvcm_node*)arena_alloc(arena,
+                sizeof(struct pcvcm_node));
+    }
+    else {
+        node = (struct pcvcm_node*)calloc(1, sizeof(struct pcvcm_node));
+    }
+
     if (!node) {
         pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
         return NULL;
     }
     node->type = type;
+    node->in_arena = (arena != NULL);
     return node;
 }
 
+/* allocates the zeroed buffer of a string or byte sequence node */
+static uint8_t *node_buf_alloc(struct pcvcm_node *node, size_t sz)
+{
+    uint8_t *buf;
+    if (node->in_arena) {
+        buf = (uint8_t*)arena_alloc(current_arena(), sz);
+    }
+    else {
+        buf = (uint8_t*)calloc(sz, 1);
+    }
+
+    if (!buf) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    }
+    return buf;
+}
+
+static void node_buf_free(struct pcvcm_node *node, uint8_t *buf)
+{
+    if (!node->in_arena) {
+        free(buf);
+    }
+}
+
 
 struct pcvcm_node *pcvcm_node_new_undefined()
 {
@@ -142,9 +296,12 @@ struct pcvcm_node *pcvcm_node_new_string(const char *str_utf8)
 
     size_t nr_bytes = strlen(str_utf8);
 
-    uint8_t *buf = (uint8_t*)malloc(nr_bytes + 1);
+    uint8_t *buf = node_buf_alloc(n, nr_bytes + 1);
+    if (!buf) {
+        pcvcm_node_destroy(n);
+        return NULL;
+    }
     memcpy(buf, str_utf8, nr_bytes);
-    buf[nr_bytes] = 0;
 
     n->sz_ptr[0] = nr_bytes;
     n->sz_ptr[1] = (uintptr_t)buf;
@@ -226,9 +383,12 @@ struct pcvcm_node *pcvcm_node_new_byte_sequence(const void *bytes,
         return n;
     }
 
-    uint8_t *buf = (uint8_t*)malloc(nr_bytes + 1);
+    uint8_t *buf = node_buf_alloc(n, nr_bytes + 1);
+    if (!buf) {
+        pcvcm_node_destroy(n);
+        return NULL;
+    }
     memcpy(buf, bytes, nr_bytes);
-    buf[nr_bytes] = 0;
 
     n->sz_ptr[0] = nr_bytes;
     n->sz_ptr[1] = (uintptr_t)buf;
@@ -287,7 +447,11 @@ struct pcvcm_node *pcvcm_node_new_byte_sequence_from_bx(const void *bytes,
         return NULL;
     }
     size_t sz_buf = sz / 2;
-    uint8_t *buf = (uint8_t*)calloc(sz_buf + 1, 1);
+    uint8_t *buf = node_buf_alloc(n, sz_buf + 1);
+    if (!buf) {
+        pcvcm_node_destroy(n);
+        return NULL;
+    }
     hex_to_bytes(p, sz, buf);
 
     n->sz_ptr[0] = sz_buf;
@@ -317,7 +481,11 @@ struct pcvcm_node *pcvcm_node_new_byte_sequence_from_bb(const void *bytes,
     }
 
     size_t sz_buf = sz / 8;
-    uint8_t *buf = (uint8_t*)calloc(sz_buf + 1, 1);
+    uint8_t *buf = node_buf_alloc(n, sz_buf + 1);
+    if (!buf) {
+        pcvcm_node_destroy(n);
+        return NULL;
+    }
     for (size_t i = 0; i < sz_buf; i++) {
         uint8_t b = 0;
         uint8_t c = 0;
@@ -350,11 +518,15 @@ struct pcvcm_node *pcvcm_node_new_byte_sequence_from_b64 (const void *bytes,
 
     const uint8_t *p = bytes;
     size_t sz_buf = nr_bytes;
-    uint8_t *buf = (uint8_t*)calloc(sz_buf, 1);
+    uint8_t *buf = node_buf_alloc(n, sz_buf);
+    if (!buf) {
+        pcvcm_node_destroy(n);
+        return NULL;
+    }
 
     ssize_t ret = pcutils_b64_decode(p, buf, sz_buf);
     if (ret == -1) {
-        free(buf);
+        node_buf_free(n, buf);
         pcinst_set_error(PCHVML_ERROR_UNEXPECTED_CHARACTER);
         return NULL;
     }
@@ -915,6 +1087,16 @@ static void pcvcm_node_destroy_callback(struct pctree_node *n,  void *data)
 {
     UNUSED_PARAM(data);
     struct pcvcm_node *node = VCM_NODE(n);
+    if (node->code) {
+        pcvcm_code_destroy(node->code);
+        node->code = NULL;
+    }
+
+    if (node->in_arena) {
+        /* freed together with the arena */
+        return;
+    }
+
     if ((node->type == PCVCM_NODE_TYPE_STRING
                 || node->type == PCVCM_NODE_TYPE_BYTE_SEQUENCE
         ) && node->sz_ptr[1]) {
@@ -976,10 +1158,6 @@ void pcvcm_stack_destroy(struct pcvcm_stack *stack)
     free(stack);
 }
 
-static
-purc_variant_t pcvcm_node_to_variant(struct pcvcm_node *node,
-        struct pcvcm_node_op *ops, bool silently);
-
 static
 purc_variant_t pcvcm_node_object_to_variant(struct pcvcm_node *node,
         struct pcvcm_node_op *ops, bool silently)
@@ -995,7 +1173,13 @@ purc_variant_t pcvcm_node_object_to_variant(struct pcvcm_node *node,
     struct pcvcm_node *k_node = FIRST_CHILD(node);
     struct pcvcm_node *v_node = NEXT_CHILD(k_node);
     while (k_node && v_node) {
-        key = pcvcm_node_to_variant(k_node, ops, silently);
+        if ((node->extra & EXTRA_INTERN_KEYS_FLAG) &&
+                k_node->type == PCVCM_NODE_TYPE_STRING) {
+            key = pcvariant_make_object_key((const char*)k_node->sz_ptr[1]);
+        }
+        else {
+            key = pcvcm_node_to_variant(k_node, ops, silently);
+        }
         if (key == PURC_VARIANT_INVALID) {
             goto out_unref_object;
         }
@@ -1059,60 +1243,169 @@ out_unref_array:
     return PURC_VARIANT_INVALID;
 }
 
-purc_variant_t pcvcm_node_concat_string_to_variant(struct pcvcm_node *node,
-       struct pcvcm_node_op *ops, bool silently)
+/* the text of a value to concatenate */
+struct concat_piece {
+    /* NULL if the value is stringified when writing */
+    const char         *str;
+    size_t              len;
+    char                buf[PCVARIANT_NUMBER_BUFSZ];
+};
+
+#define NR_LOCAL_PIECES     16
+
+/* the text of a scalar, or only the length of the text for the others */
+static void measure_piece(struct concat_piece *piece, purc_variant_t v)
 {
-    purc_rwstream_t rws = purc_rwstream_new_buffer(MIN_BUF_SIZE, MAX_BUF_SIZE);
-    if (!rws) {
-        return PURC_VARIANT_INVALID;
+    int n = 0;
+
+    piece->str = piece->buf;
+    switch (purc_variant_get_type(v)) {
+    case PURC_VARIANT_TYPE_UNDEFINED:
+        piece->str = "undefined";
+        piece->len = sizeof("undefined") - 1;
+        return;
+
+    case PURC_VARIANT_TYPE_NULL:
+        piece->str = "null";
+        piece->len = sizeof("null") - 1;
+        return;
+
+    case PURC_VARIANT_TYPE_BOOLEAN:
+        piece->str = v->b ? "true" : "false";
+        piece->len = v->b ? sizeof("true") - 1 : sizeof("false") - 1;
+        return;
+
+    case PURC_VARIANT_TYPE_NUMBER:
+    case PURC_VARIANT_TYPE_LONGINT:
+    case PURC_VARIANT_TYPE_ULONGINT:
+    case PURC_VARIANT_TYPE_LONGDOUBLE:
+        n = pcvariant_stringify_number(v, piece->buf);
+        break;
+
+    case PURC_VARIANT_TYPE_EXCEPTION:
+    case PURC_VARIANT_TYPE_ATOMSTRING:
+    case PURC_VARIANT_TYPE_STRING:
+        piece->str = purc_variant_get_string_const_ex(v, &piece->len);
+        return;
+
+    default:
+        piece->str = NULL;
+        piece->len = 0;
+        purc_variant_stringify(NULL, v, 0, &piece->len);
+        return;
     }
 
-    purc_variant_t ret_var = PURC_VARIANT_INVALID;
-    struct pcvcm_node *child = FIRST_CHILD(node);
-    while (child) {
-        purc_variant_t v = pcvcm_node_to_variant(child, ops, silently);
-        if (v == PURC_VARIANT_INVALID) {
-            goto out_destroy_rws;
+    if (n < 0 || (size_t)n >= sizeof(piece->buf)) {
+        piece->str = NULL;
+        piece->len = 0;
+        purc_variant_stringify(NULL, v, 0, &piece->len);
+    }
+    else {
+        piece->len = n;
+    }
+}
+
+purc_variant_t pcvcm_concat_values(purc_variant_t *values, size_t nr_values)
+{
+    struct concat_piece local_pieces[NR_LOCAL_PIECES];
+    struct concat_piece *pieces = local_pieces;
+    purc_variant_t ret = PURC_VARIANT_INVALID;
+
+    if (nr_values > NR_LOCAL_PIECES) {
+        pieces = malloc(sizeof(*pieces) * nr_values);
+        if (pieces == NULL) {
+            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return PURC_VARIANT_INVALID;
         }
+    }
+
+    /* the first pass gets the exact length of the result */
+    size_t total = 0;
+    for (size_t i = 0; i < nr_values; i++) {
+        measure_piece(pieces + i, values[i]);
+        total += pieces[i].len;
+    }
 
-        // FIXME: stringify or serialize
-        char *buf = NULL;
-        int total = purc_variant_stringify_alloc(&buf, v);
-        if (total) {
-            purc_rwstream_write(rws, buf, total);
+    /* and the second pass writes them into the buffer of the string */
+    char *buf = malloc(total + 1);
+    if (buf == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto out;
+    }
+
+    size_t len = 0;
+    for (size_t i = 0; i < nr_values; i++) {
+        struct concat_piece *piece = pieces + i;
+        if (piece->len == 0)
+            continue;
+
+        if (piece->str) {
+            memcpy(buf + len, piece->str, piece->len);
+            len += piece->len;
+            continue;
         }
-        free(buf);
-        purc_variant_unref(v);
 
-        child = NEXT_CHILD(child);
+        purc_rwstream_t rws = purc_rwstream_new_from_mem(buf + len,
+                piece->len + 1);
+        if (rws == NULL) {
+            free(buf);
+            goto out;
+        }
+
+        ssize_t written = purc_variant_stringify(rws, values[i], 0, NULL);
+        purc_rwstream_destroy(rws);
+        if (written > 0)
+            len += written;
     }
+    buf[len] = '\0';
 
-    // do not forget tailing-null-terminator
-    purc_rwstream_write(rws, "", 1);
+    ret = purc_variant_make_string_reuse_buff(buf, len + 1, false);
+    if (ret == PURC_VARIANT_INVALID) {
+        free(buf);
+        pcinst_set_error(PURC_ERROR_INVALID_VALUE);
+    }
 
-    size_t rw_size = 0;
-    size_t content_size = 0;
-    char *rw_string = purc_rwstream_get_mem_buffer_ex(rws,
-            &content_size, &rw_size, true);
+out:
+    if (pieces != local_pieces)
+        free(pieces);
+    return ret;
+}
 
-    if ((rw_size == 0) || (rw_string == NULL))
-        ret_var = PURC_VARIANT_INVALID;
-    else {
-        PC_ASSERT(content_size <= rw_size);
-        size_t len = strnlen(rw_string, rw_size);
-        PC_ASSERT(len <= content_size);
-        PC_ASSERT(len+1 == content_size);
-        PC_ASSERT(rw_string[len] == '\0');
-        ret_var = purc_variant_make_string_reuse_buff(rw_string,
-                content_size, false);
-        if (ret_var == PURC_VARIANT_INVALID) {
-            pcinst_set_error(PURC_ERROR_INVALID_VALUE);
-            ret_var = PURC_VARIANT_INVALID;
+purc_variant_t pcvcm_node_concat_string_to_variant(struct pcvcm_node *node,
+       struct pcvcm_node_op *ops, bool silently)
+{
+    purc_variant_t local_values[NR_LOCAL_PIECES];
+    purc_variant_t *values = local_values;
+    purc_variant_t ret_var = PURC_VARIANT_INVALID;
+    size_t nr_values = CHILDREN_NUMBER(node);
+    size_t i = 0;
+
+    if (nr_values > NR_LOCAL_PIECES) {
+        values = malloc(sizeof(*values) * nr_values);
+        if (values == NULL) {
+            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return PURC_VARIANT_INVALID;
         }
     }
 
-out_destroy_rws:
-    purc_rwstream_destroy(rws);
+    struct pcvcm_node *child = FIRST_CHILD(node);
+    for (; i < nr_values; i++) {
+        values[i] = pcvcm_node_to_variant(child, ops, silently);
+        if (values[i] == PURC_VARIANT_INVALID) {
+            goto out_unref_values;
+        }
+
+        child = NEXT_CHILD(child);
+    }
+
+    ret_var = pcvcm_concat_values(values, nr_values);
+
+out_unref_values:
+    for (size_t j = 0; j < i; j++) {
+        purc_variant_unref(values[j]);
+    }
+    if (values != local_values)
+        free(values);
     return ret_var;
 }
 
@@ -1136,19 +1429,30 @@ purc_variant_t pcvcm_node_get_variable_to_variant(struct pcvcm_node *node,
         goto out;
     }
 
+    ret = pcvcm_get_variable(ops, name_var);
+    purc_variant_unref(name_var);
+
+out:
+    return ret;
+}
+
+purc_variant_t pcvcm_get_variable(struct pcvcm_node_op *ops,
+        purc_variant_t name_var)
+{
+    purc_variant_t ret = PURC_VARIANT_INVALID;
     if (!purc_variant_is_string(name_var)) {
-        goto out_unref_name_var;
+        goto out;
     }
 
     const char *name = purc_variant_get_string_const(name_var);
     size_t nr_name = strlen(name);
     if (!name || nr_name == 0) {
-        goto out_unref_name_var;
+        goto out;
     }
 
     if(!ops->find_var) {
         pcinst_set_error(PCVARIANT_ERROR_NOT_FOUND);
-        goto out_unref_name_var;
+        goto out;
     }
 
     ret = ops->find_var(ops->find_var_ctxt, name);
@@ -1156,9 +1460,6 @@ purc_variant_t pcvcm_node_get_variable_to_variant(struct pcvcm_node *node,
         purc_variant_ref(ret);
     }
 
-out_unref_name_var:
-    purc_variant_unref(name_var);
-
 out:
     return ret;
 }
@@ -1182,23 +1483,27 @@ static bool is_handle_as_getter(struct pcvcm_node *node)
     return true;
 }
 
-enum method_type {
-    GETTER_METHOD,
-    SETTER_METHOD
-};
-
 static
-purc_variant_t call_dvariant_method(purc_variant_t root, purc_variant_t var,
+purc_variant_t call_dvariant_method(struct pcvcm_node *node,
+        purc_variant_t root, purc_variant_t var,
         size_t nr_args, purc_variant_t *argv, enum method_type type,
         bool silently)
 {
     purc_dvariant_method func = (type == GETTER_METHOD) ?
          purc_variant_dynamic_get_getter(var) :
          purc_variant_dynamic_get_setter(var);
-    if (func) {
+    if (func == NULL) {
+        return PURC_VARIANT_INVALID;
+    }
+
+    struct pcvcm_profile *prof = pcvcm_profiling();
+    if (prof == NULL || !pcvcm_profile_enter(prof)) {
         return func(root, nr_args, argv, silently);
     }
-    return PURC_VARIANT_INVALID;
+
+    purc_variant_t ret = func(root, nr_args, argv, silently);
+    pcvcm_profile_leave_method(prof, (const void *)func, node);
+    return ret;
 }
 
 static
@@ -1219,11 +1524,6 @@ purc_variant_t call_nvariant_method(purc_variant_t var,
     return PURC_VARIANT_INVALID;
 }
 
-static purc_variant_t get_attach_variant(struct pcvcm_node *node)
-{
-    return node ? (purc_variant_t)node->attach : PURC_VARIANT_INVALID;
-}
-
 #define KEY_INNER_HANDLER           "__vcm_native_wrapper"
 #define KEY_CALLER_NODE             "__vcm_caller_node"
 #define KEY_PARAM_NODE              "__vcm_param_node"
@@ -1292,6 +1592,7 @@ purc_variant_t pcvcm_node_get_element_to_variant(struct pcvcm_node *node,
     if (caller_var == PURC_VARIANT_INVALID) {
         goto out;
     }
+    purc_variant_t caller_root = ops->first_value;
 
     struct pcvcm_node *param_node  = NEXT_CHILD(caller_node);
     purc_variant_t param_var = pcvcm_node_to_variant(param_node, ops,
@@ -1300,6 +1601,24 @@ purc_variant_t pcvcm_node_get_element_to_variant(struct pcvcm_node *node,
         goto out_unref_caller_var;
     }
 
+    ret_var = pcvcm_get_element(node, caller_var, param_var,
+            caller_root, silently);
+    purc_variant_unref(param_var);
+
+out_unref_caller_var:
+    purc_variant_unref(caller_var);
+out:
+    return ret_var;
+}
+
+purc_variant_t pcvcm_get_element(struct pcvcm_node *node,
+        purc_variant_t caller_var, purc_variant_t param_var,
+        purc_variant_t caller_root, bool silently)
+{
+    purc_variant_t ret_var = PURC_VARIANT_INVALID;
+    purc_variant_t inner_ret = PURC_VARIANT_INVALID;
+    struct pcvcm_node *param_node = NEXT_CHILD(FIRST_CHILD(node));
+
     bool has_index = true;
     int64_t index = -1;
     if (param_node->type == PCVCM_NODE_TYPE_STRING) {
@@ -1316,11 +1635,10 @@ purc_variant_t pcvcm_node_get_element_to_variant(struct pcvcm_node *node,
     if (is_inner_native_wrapper(caller_var)) {
         purc_variant_t inner_caller = inner_native_wrapper_get_caller(caller_var);
         purc_variant_t inner_param = inner_native_wrapper_get_param(caller_var);
-        purc_variant_t inner_ret = call_nvariant_method(inner_caller,
+        inner_ret = call_nvariant_method(inner_caller,
                 purc_variant_get_string_const(inner_param), 0, NULL,
                 GETTER_METHOD, silently);
         if (inner_ret) {
-            purc_variant_unref(caller_var);
             caller_var = inner_ret;
         }
     }
@@ -1328,112 +1646,111 @@ purc_variant_t pcvcm_node_get_element_to_variant(struct pcvcm_node *node,
     if (purc_variant_is_object(caller_var)) {
         purc_variant_t val = purc_variant_object_get(caller_var, param_var);
         if (val == PURC_VARIANT_INVALID) {
-            goto out_unref_param_var;
+            goto out;
         }
 
         purc_variant_ref(val);
         if (!purc_variant_is_dynamic(val)) {
             ret_var = val;
-            goto out_unref_param_var;
+            goto out;
         }
 
         if (!is_handle_as_getter(node)) {
             ret_var = val;
-            goto out_unref_param_var;
+            goto out;
         }
 
-        ret_var = call_dvariant_method(caller_var, val, 0, NULL, GETTER_METHOD,
-                silently);
+        ret_var = call_dvariant_method(node, caller_var, val, 0, NULL,
+                GETTER_METHOD, silently);
         purc_variant_unref(val);
     }
     else if (purc_variant_is_array(caller_var)) {
         if (!has_index) {
-            goto out_unref_param_var;
+            goto out;
         }
         if (index < 0) {
             size_t len = purc_variant_array_get_size(caller_var);
             index += len;
         }
         if (index < 0) {
-            goto out_unref_param_var;
+            goto out;
         }
 
         purc_variant_t val = purc_variant_array_get(caller_var, index);
         if (val == PURC_VARIANT_INVALID) {
-            goto out_unref_param_var;
+            goto out;
         }
 
         purc_variant_ref(val);
         if (!purc_variant_is_dynamic(val)) {
             ret_var = val;
-            goto out_unref_param_var;
+            goto out;
         }
 
         if (!is_handle_as_getter(node)) {
             ret_var = val;
-            goto out_unref_param_var;
+            goto out;
         }
-        ret_var = call_dvariant_method(caller_var, val, 0, NULL, GETTER_METHOD,
-                silently);
+        ret_var = call_dvariant_method(node, caller_var, val, 0, NULL,
+                GETTER_METHOD, silently);
         purc_variant_unref(val);
     }
     else if (purc_variant_is_set(caller_var)) {
         if (!has_index) {
-            goto out_unref_param_var;
+            goto out;
         }
         if (index < 0) {
             size_t len = purc_variant_set_get_size(caller_var);
             index += len;
         }
         if (index < 0) {
-            goto out_unref_param_var;
+            goto out;
         }
 
         purc_variant_t val = purc_variant_set_get_by_index(caller_var, index);
         if (val == PURC_VARIANT_INVALID) {
-            goto out_unref_param_var;
+            goto out;
         }
 
         purc_variant_ref(val);
         if (!purc_variant_is_dynamic(val)) {
             ret_var = val;
-            goto out_unref_param_var;
+            goto out;
         }
 
         if (!is_handle_as_getter(node)) {
             ret_var = val;
-            goto out_unref_param_var;
+            goto out;
         }
-        ret_var = call_dvariant_method(caller_var, val, 0, NULL, GETTER_METHOD,
-                silently);
+        ret_var = call_dvariant_method(node, caller_var, val, 0, NULL,
+                GETTER_METHOD, silently);
         purc_variant_unref(val);
     }
     else if (purc_variant_is_dynamic(caller_var)) {
-        ret_var = call_dvariant_method(
-                get_attach_variant(FIRST_CHILD(caller_node)),
-                caller_var, 1, &param_var, GETTER_METHOD,
+        ret_var = call_dvariant_method(node,
+                caller_root, caller_var, 1, &param_var, GETTER_METHOD,
                 silently);
-        goto out_unref_param_var;
+        goto out;
     }
     else if (purc_variant_is_native(caller_var)) {
         if (!is_handle_as_getter(node)) {
             ret_var = inner_native_wrapper_create(caller_var, param_var);
-            goto out_unref_param_var;
+            goto out;
         }
         ret_var = call_nvariant_method(caller_var,
                 purc_variant_get_string_const(param_var), 0, NULL,
                 GETTER_METHOD, silently);
-        goto out_unref_param_var;
+        goto out;
     }
 
-out_unref_param_var:
-    purc_variant_unref(param_var);
-out_unref_caller_var:
-    purc_variant_unref(caller_var);
 out:
+    if (inner_ret) {
+        purc_variant_unref(inner_ret);
+    }
     return ret_var;
 }
 
+
 purc_variant_t pcvcm_node_call_method_to_variant(struct pcvcm_node *node,
        struct pcvcm_node_op *ops, enum method_type type, bool silently)
 {
@@ -1447,9 +1764,22 @@ purc_variant_t pcvcm_node_call_method_to_variant(struct pcvcm_node *node,
     if (caller_var == PURC_VARIANT_INVALID) {
         goto out;
     }
+    purc_variant_t caller_root = ops->first_value;
 
-    if (!purc_variant_is_dynamic(caller_var)
-            && !is_inner_native_wrapper(caller_var)) {
+    if (!pcvcm_is_callable(caller_var)) {
+        goto out_unref_caller_var;
+    }
+
+    if (node->const_id) {
+        ret_var = pcvcm_folded_value(node, caller_var);
+        if (ret_var != PURC_VARIANT_INVALID) {
+            goto out_unref_caller_var;
+        }
+    }
+
+    if (pcvcm_is_lazy(node, caller_var)) {
+        ret_var = pcvcm_call_method_lazily(node, caller_var,
+                caller_root, ops, silently);
         goto out_unref_caller_var;
     }
 
@@ -1476,21 +1806,15 @@ purc_variant_t pcvcm_node_call_method_to_variant(struct pcvcm_node *node,
         }
     }
 
-    if (purc_variant_is_dynamic(caller_var)) {
-        ret_var = call_dvariant_method(
-                get_attach_variant(FIRST_CHILD(caller_node)),
-                caller_var, nr_params, params, type, silently);
+    if (node->const_id) {
+        ret_var = pcvcm_call_method_folding(node, caller_var,
+                caller_root,
+                nr_params, params, silently);
     }
-    else if (is_inner_native_wrapper(caller_var)) {
-        purc_variant_t nv = inner_native_wrapper_get_caller(caller_var);
-        if (purc_variant_is_native(nv)) {
-            purc_variant_t name = inner_native_wrapper_get_param(caller_var);
-            if (name) {
-                ret_var = call_nvariant_method(nv,
-                        purc_variant_get_string_const(name), nr_params,
-                        params, type, silently);
-            }
-        }
+    else {
+        ret_var = pcvcm_call_method(node, caller_var,
+                caller_root,
+                nr_params, params, type, silently);
     }
 
 out_unref_params:
@@ -1507,6 +1831,36 @@ out:
     return ret_var;
 }
 
+bool pcvcm_is_callable(purc_variant_t caller_var)
+{
+    return purc_variant_is_dynamic(caller_var)
+        || is_inner_native_wrapper(caller_var);
+}
+
+purc_variant_t pcvcm_call_method(struct pcvcm_node *node,
+        purc_variant_t caller_var, purc_variant_t caller_root,
+        size_t nr_params, purc_variant_t *params,
+        enum method_type type, bool silently)
+{
+    purc_variant_t ret_var = PURC_VARIANT_INVALID;
+    if (purc_variant_is_dynamic(caller_var)) {
+        ret_var = call_dvariant_method(node, caller_root,
+                caller_var, nr_params, params, type, silently);
+    }
+    else if (is_inner_native_wrapper(caller_var)) {
+        purc_variant_t nv = inner_native_wrapper_get_caller(caller_var);
+        if (purc_variant_is_native(nv)) {
+            purc_variant_t name = inner_native_wrapper_get_param(caller_var);
+            if (name) {
+                ret_var = call_nvariant_method(nv,
+                        purc_variant_get_string_const(name), nr_params,
+                        params, type, silently);
+            }
+        }
+    }
+    return ret_var;
+}
+
 bool is_cjsonee_op(struct pcvcm_node *node)
 {
     if (!node) {
@@ -1606,7 +1960,7 @@ failed:
     return PURC_VARIANT_INVALID;
 }
 
-static bool has_fatal_error()
+bool pcvcm_has_fatal_error(void)
 {
     int err = purc_get_last_error();
     return (err == PURC_ERROR_OUT_OF_MEMORY);
@@ -1616,6 +1970,18 @@ purc_variant_t pcvcm_node_to_variant(struct pcvcm_node *node,
         struct pcvcm_node_op *ops, bool silently)
 {
     purc_variant_t ret = PURC_VARIANT_INVALID;
+    struct pcvcm_walk_frame frame = { node, PURC_VARIANT_INVALID, ops->frame };
+    ops->frame = &frame;
+
+    /* a call is folded by pcvcm_node_call_method_to_variant() */
+    bool folding = (node->const_id &&
+            node->type != PCVCM_NODE_TYPE_FUNC_CALL_GETTER);
+    if (folding) {
+        ret = pcvcm_folded_value(node, PURC_VARIANT_INVALID);
+        if (ret != PURC_VARIANT_INVALID)
+            goto done;
+    }
+
     switch(node->type)
     {
         case PCVCM_NODE_TYPE_UNDEFINED:
@@ -1694,14 +2060,22 @@ purc_variant_t pcvcm_node_to_variant(struct pcvcm_node *node,
             break;
     }
 
+    if (folding && ret != PURC_VARIANT_INVALID) {
+        pcvcm_fold_value(node, PURC_VARIANT_INVALID, ret);
+    }
+
     if (ret == PURC_VARIANT_INVALID
-            && silently && !has_fatal_error()) {
+            && silently && !pcvcm_has_fatal_error()) {
         ret = purc_variant_make_undefined();
     }
 
-    node->attach = (uintptr_t)ret;
+done:
+    ops->frame = frame.parent;
+    if (frame.parent && FIRST_CHILD(frame.parent->node) == node)
+        frame.parent->first_value = ret;
+    ops->first_value = frame.first_value;
 
-    if (_print_vcm_log) {
+    if (ops->trace) {
         PRINT_VCM_NODE(node);
         PRINT_VARIANT(ret);
     }
@@ -1713,8 +2087,7 @@ static inline bool is_digit(char c)
     return c >= '0' && c <= '9';
 }
 
-static
-purc_variant_t find_stack_var(void *ctxt, const char *name)
+purc_variant_t pcvcm_find_stack_var(void *ctxt, const char *name)
 {
     struct pcintr_stack *stack = (struct pcintr_stack*)ctxt;
     size_t nr_name = strlen(name);
@@ -1749,46 +2122,104 @@ purc_variant_t find_stack_var(void *ctxt, const char *name)
 purc_variant_t pcvcm_eval(struct pcvcm_node *tree, struct pcintr_stack *stack,
         bool silently)
 {
-    if (stack) {
-        return pcvcm_eval_ex(tree, find_stack_var, stack, silently);
+    if (stack == NULL) {
+        return pcvcm_eval_ex(tree, NULL, NULL, silently);
+    }
+
+    struct pcvcm_profile *prof = pcvcm_profiling();
+    if (prof == NULL || tree == NULL || !pcvcm_profile_enter(prof)) {
+        return pcvcm_eval_ex(tree, pcvcm_find_stack_var, stack, silently);
     }
-    return pcvcm_eval_ex(tree, NULL, NULL, silently);
+
+    purc_variant_t ret = pcvcm_eval_ex(tree, pcvcm_find_stack_var, stack,
+            silently);
+    pcvcm_profile_leave_tree(prof, tree, stack);
+    return ret;
 }
 
-purc_variant_t pcvcm_eval_ex(struct pcvcm_node *tree,
-        cb_find_var find_var, void *ctxt, bool silently)
+/* the tree may be evaluated by several threads at the same time, so the
+   code is compiled privately and only one is published */
+bool pcvcm_node_compile(struct pcvcm_node *tree)
 {
-    const char *env_value;
-    if ((env_value = getenv(PURC_ENVV_VCM_LOG_ENABLE))) {
-        _print_vcm_log = (*env_value == '1' ||
-                pcutils_strcasecmp(env_value, "true") == 0);
+    struct pcvcm_code *code = __atomic_load_n(&tree->code, __ATOMIC_ACQUIRE);
+    if (code == NULL) {
+        code = pcvcm_code_new(tree);
+
+        struct pcvcm_code *published = NULL;
+        if (code && !__atomic_compare_exchange_n(&tree->code, &published,
+                    code, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            /* compiled by another thread meanwhile */
+            pcvcm_code_destroy(code);
+            code = published;
+        }
     }
+    /* not to try again */
+    __atomic_store_n(&tree->nr_evals, UINT8_MAX, __ATOMIC_RELAXED);
+    return code != NULL;
+}
 
-    if (_print_vcm_log) {
-        PC_DEBUG("pcvcm_eval_ex|begin|silently=%d\n", silently);
+static purc_variant_t eval_tree(struct pcvcm_node *tree,
+        struct pcvcm_node_op *ops, bool silently, bool walk)
+{
+    struct pcvcm_code *code = __atomic_load_n(&tree->code, __ATOMIC_ACQUIRE);
+    if (!walk && code == NULL &&
+            __atomic_load_n(&tree->nr_evals, __ATOMIC_RELAXED) < UINT8_MAX &&
+            __atomic_add_fetch(&tree->nr_evals, 1, __ATOMIC_RELAXED) ==
+                PCVCM_NR_EVALS_TO_COMPILE) {
+        pcvcm_node_compile(tree);
+        code = __atomic_load_n(&tree->code, __ATOMIC_ACQUIRE);
     }
 
+    /* only the tree walker logs the value of every node */
+    if (walk || code == NULL || ops->trace) {
+        return pcvcm_node_to_variant(tree, ops, silently);
+    }
+
+    return pcvcm_code_eval(code, ops, silently);
+}
+
+static purc_variant_t eval(struct pcvcm_node *tree,
+        cb_find_var find_var, void *ctxt, bool silently, bool walk)
+{
     purc_variant_t ret = PURC_VARIANT_INVALID;
 
     struct pcvcm_node_op ops = {
         .find_var = find_var,
         .find_var_ctxt = ctxt,
+        .trace = pctrace_enabled(PC_TRACE_VCM),
     };
 
+    if (ops.trace) {
+        PC_DEBUG("pcvcm_eval_ex|begin|silently=%d\n", silently);
+    }
+
+    pcinst_metrics_count(pcinst_current(), PCINST_METRIC_VCM_EVALS, 1);
     if (tree) {
-        ret = pcvcm_node_to_variant(tree, &ops, silently);
+        ret = eval_tree(tree, &ops, silently, walk);
     }
     else if (silently) {
         ret = purc_variant_make_undefined();
     }
 
-    if (_print_vcm_log) {
+    if (ops.trace) {
         PRINT_VARIANT(ret);
         PC_DEBUG("pcvcm_eval_ex|end|silently=%d\n", silently);
     }
     return ret;
 }
 
+purc_variant_t pcvcm_eval_ex(struct pcvcm_node *tree,
+        cb_find_var find_var, void *ctxt, bool silently)
+{
+    return eval(tree, find_var, ctxt, silently, false);
+}
+
+purc_variant_t pcvcm_eval_walk(struct pcvcm_node *tree,
+        cb_find_var find_var, void *ctxt, bool silently)
+{
+    return eval(tree, find_var, ctxt, silently, true);
+}
+
 static purc_variant_t
 eval_getter(void *native_entity, size_t nr_args, purc_variant_t *argv,
         bool silently)
@@ -28,6 +28,7 @@
 #include "private/debug.h"
 #include "private/utils.h"
 #include "private/vdom.h"
+#include "private/phash.h"
 
 #include "hvml-attr.h"
 #include "hvml-attr-static-list.inc"
@@ -35,26 +36,15 @@
 const struct pchvml_attr_entry*
 pchvml_attr_static_search(const char* name, size_t length)
 {
-    unsigned int v = (unsigned char)purc_tolower(name[0])
-        * (unsigned char)purc_tolower(name[length-1]);
-    unsigned idx = v % PCHVML_ATTR_STATIC_SIZE;
+    uint32_t v = pcutils_phash_name(name, length);
+    size_t idx = pcutils_phash_slot(v, pchvml_attr_displacements,
+            PCHVML_ATTR_NR_BUCKETS, PCHVML_ATTR_NR_SLOTS);
 
-    const struct pchvml_attr_entry *entry = &pchvml_attr_static_list_index[idx];
-    while (entry) {
-        if (!entry->name) {
-            return NULL;
-        }
-        if (pcutils_strncasecmp(name, entry->name, length)==0) {
-            return entry;
-        }
-        if (entry->next==0) {
-            return NULL;
-        }
-        idx = entry->next;
-        entry = &pchvml_attr_static_list_index[idx];
+    const struct pchvml_attr_entry *entry = pchvml_attr_slots[idx];
+    if (entry && entry->name_length == length &&
+            pcutils_strncasecmp(name, entry->name, length) == 0) {
+        return entry;
     }
+
     return NULL;
 }
-
-
-
@@ -28,6 +28,7 @@
 #include "private/debug.h"
 #include "private/utils.h"
 #include "private/vdom.h"
+#include "private/phash.h"
 
 #include "hvml-tag.h"
 #include "hvml-tag-static-list.inc"
@@ -46,69 +47,18 @@ pchvml_tag_static_get_by_id(enum pchvml_tag_id id)
     return entry;
 }
 
-#if SIZEOF_PTR == 8
-
-#define FNV_PRIME 0x100000001b3
-#define FNV_INIT  0xcbf29ce484222325
-
-static uint64_t
-hash_str(const char *name, size_t length)
-{
-    uint64_t v = FNV_INIT;
-    for (size_t i=0; i<length; ++i) {
-        v ^= (unsigned char)name[i];
-        v *= FNV_PRIME;
-    }
-
-    return v;
-}
-
-#else /* SIZEOF_PTR == 4 */
-
-#define FNV_PRIME 0x01000193
-#define FNV_INIT  0x811c9dc5
-
-static uint32_t
-hash_str(const char *name, size_t length)
-{
-    uint32_t v = FNV_INIT;
-    for (size_t i=0; i<length; ++i) {
-        v ^= (unsigned char)name[i];
-        v *= FNV_PRIME;
-    }
-
-    return v;
-}
-
-#endif /* SIZEOF_PTR == 8 */
-
 const struct pchvml_tag_entry*
 pchvml_tag_static_search(const char* name, size_t length)
 {
-    uint64_t v = hash_str(name, length);
-    uint64_t idx = v % PCHVML_BASE_STATIC_SIZE;
-
-    const struct pchvml_tag_static_list *rec;
-    rec = &pchvml_tag_static_list_index[idx];
-
-    while (rec) {
-        const struct pchvml_tag_entry *entry;
-        entry = rec->ctx;
-        if (!entry) {
-            return NULL;
-        }
-        if (!entry->name) {
-            return NULL;
-        }
-        if (pcutils_strncasecmp(name, entry->name, length)==0) {
-            return entry;
-        }
-        if (rec->next==0) {
-            return NULL;
-        }
-        idx = rec->next;
-        rec = &pchvml_tag_static_list_index[idx];
+    uint32_t v = pcutils_phash_name(name, length);
+    size_t idx = pcutils_phash_slot(v, pchvml_tag_displacements,
+            PCHVML_TAG_NR_BUCKETS, PCHVML_TAG_NR_SLOTS);
+
+    const struct pchvml_tag_entry *entry = pchvml_tag_slots[idx];
+    if (entry && entry->name_length == length &&
+            pcutils_strncasecmp(name, entry->name, length) == 0) {
+        return entry;
     }
+
     return NULL;
 }
-
@@ -0,0 +1,731 @@
+/*
+ * @file vdom-cache.c
+ * @author Vincent Wei
+ * @date 2026/10/14
+ * @brief The binary cache of vDOM trees.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * The layout of a cache (all integers are in the native byte order):
+ *
+ *  - the header: the magic, the version string of PurC, the size of
+ *    `long double` and a byte order mark; a cache made by another build
+ *    or on another platform is refused.
+ *  - the document: the doctype, the quirks flag, and the child nodes.
+ *  - a node: the node type, then
+ *      - element: the tag name, the flags, the source line, the attributes
+ *        and the children;
+ *      - content: the VCM tree;
+ *      - comment: the text.
+ *  - a VCM node: the type, the extra flags, the closed flag, the payload
+ *    by type, and the children. The packed VCM tree of a lazy attribute
+ *    is in the same format, so it is copied between the cache and the
+ *    attribute as is.
+ *
+ * A string is written as its length plus one followed by the bytes,
+ * and a zero length stands for NULL.
+ */
+
+#include "private/instance.h"
+#include "private/errors.h"
+#include "private/debug.h"
+#include "private/utils.h"
+#include "private/vdom.h"
+
+#include "vdom-internal.h"
+
+#include <string.h>
+
+#define CACHE_MAGIC             "PCVDOM2"
+#define CACHE_BOM               0x01020304U
+
+#define ELEMENT_FLAG_SELF_CLOSING   0x01
+#define ELEMENT_FLAG_ROOT           0x02
+#define ELEMENT_FLAG_HEAD           0x04
+#define ELEMENT_FLAG_BODY           0x08
+
+struct cache_writer {
+    purc_rwstream_t     out;
+    bool                failed;
+};
+
+static void
+put_bytes(struct cache_writer *wr, const void *data, size_t len)
+{
+    if (!wr->failed && len > 0 &&
+            purc_rwstream_write(wr->out, data, len) != (ssize_t)len) {
+        wr->failed = true;
+    }
+}
+
+static void
+put_u8(struct cache_writer *wr, uint8_t u8)
+{
+    put_bytes(wr, &u8, sizeof(u8));
+}
+
+static void
+put_u32(struct cache_writer *wr, uint32_t u32)
+{
+    put_bytes(wr, &u32, sizeof(u32));
+}
+
+static void
+put_string(struct cache_writer *wr, const char *str, size_t len)
+{
+    if (str == NULL) {
+        put_u32(wr, 0);
+    }
+    else {
+        put_u32(wr, (uint32_t)len + 1);
+        put_bytes(wr, str, len);
+    }
+}
+
+static void
+put_cstring(struct cache_writer *wr, const char *str)
+{
+    put_string(wr, str, str ? strlen(str) : 0);
+}
+
+static void
+save_vcm(struct cache_writer *wr, struct pcvcm_node *vcm)
+{
+    put_u8(wr, (uint8_t)vcm->type);
+    put_u32(wr, vcm->extra);
+    put_u8(wr, vcm->is_closed);
+
+    switch (vcm->type) {
+    case PCVCM_NODE_TYPE_STRING:
+    case PCVCM_NODE_TYPE_BYTE_SEQUENCE:
+        put_string(wr, (const char *)vcm->sz_ptr[1], vcm->sz_ptr[0]);
+        break;
+
+    case PCVCM_NODE_TYPE_BOOLEAN:
+        put_u8(wr, vcm->b);
+        break;
+
+    case PCVCM_NODE_TYPE_NUMBER:
+        put_bytes(wr, &vcm->d, sizeof(vcm->d));
+        break;
+
+    case PCVCM_NODE_TYPE_LONG_INT:
+        put_bytes(wr, &vcm->i64, sizeof(vcm->i64));
+        break;
+
+    case PCVCM_NODE_TYPE_ULONG_INT:
+        put_bytes(wr, &vcm->u64, sizeof(vcm->u64));
+        break;
+
+    case PCVCM_NODE_TYPE_LONG_DOUBLE:
+        put_bytes(wr, &vcm->ld, sizeof(vcm->ld));
+        break;
+
+    default:
+        break;
+    }
+
+    put_u32(wr, (uint32_t)pcvcm_node_children_count(vcm));
+    struct pctree_node *child = pctree_node_child(&vcm->tree_node);
+    while (child) {
+        save_vcm(wr, (struct pcvcm_node *)child);
+        child = pctree_node_next(child);
+    }
+}
+
+static void
+save_attr(struct cache_writer *wr, struct pcvdom_attr *attr)
+{
+    put_cstring(wr, attr->key);
+    put_u8(wr, (uint8_t)attr->op);
+    if (attr->packed_val) {
+        /* a packed VCM tree is in the same format as the cache */
+        put_u8(wr, 1);
+        put_bytes(wr, attr->packed_val, attr->sz_packed_val);
+    }
+    else {
+        put_u8(wr, attr->val ? 1 : 0);
+        if (attr->val)
+            save_vcm(wr, attr->val);
+    }
+}
+
+static void
+save_node(struct cache_writer *wr, struct pcvdom_document *doc,
+        struct pcvdom_node *node);
+
+static void
+save_children(struct cache_writer *wr, struct pcvdom_document *doc,
+        struct pcvdom_node *node)
+{
+    put_u32(wr, (uint32_t)pctree_node_children_number(&node->node));
+
+    struct pcvdom_node *child = pcvdom_node_first_child(node);
+    while (child) {
+        save_node(wr, doc, child);
+        child = pcvdom_node_next_sibling(child);
+    }
+}
+
+static bool
+is_body(struct pcvdom_document *doc, struct pcvdom_element *elem)
+{
+    size_t nr = pcutils_arrlist_length(doc->bodies);
+    for (size_t i = 0; i < nr; i++) {
+        if (pcutils_arrlist_get_idx(doc->bodies, i) == elem)
+            return true;
+    }
+
+    return false;
+}
+
+static void
+save_node(struct cache_writer *wr, struct pcvdom_document *doc,
+        struct pcvdom_node *node)
+{
+    put_u8(wr, (uint8_t)node->type);
+
+    switch (node->type) {
+    case PCVDOM_NODE_ELEMENT:
+    {
+        struct pcvdom_element *elem = PCVDOM_ELEMENT_FROM_NODE(node);
+        uint8_t flags = 0;
+
+        if (elem->self_closing)
+            flags |= ELEMENT_FLAG_SELF_CLOSING;
+        if (doc->root == elem)
+            flags |= ELEMENT_FLAG_ROOT;
+        if (doc->head == elem)
+            flags |= ELEMENT_FLAG_HEAD;
+        if (is_body(doc, elem))
+            flags |= ELEMENT_FLAG_BODY;
+
+        put_cstring(wr, elem->tag_name);
+        put_u8(wr, flags);
+        put_u32(wr, (uint32_t)elem->line);
+        put_u32(wr, (uint32_t)elem->nr_attrs);
+        for (size_t i = 0; i < elem->nr_attrs; i++)
+            save_attr(wr, elem->attrs[i]);
+        save_children(wr, doc, node);
+        break;
+    }
+
+    case PCVDOM_NODE_CONTENT:
+        save_vcm(wr, PCVDOM_CONTENT_FROM_NODE(node)->vcm);
+        break;
+
+    case PCVDOM_NODE_COMMENT:
+        put_cstring(wr, PCVDOM_COMMENT_FROM_NODE(node)->text);
+        break;
+
+    default:
+        wr->failed = true;
+        break;
+    }
+}
+
+bool
+purc_vdom_save_cache(purc_vdom_t vdom, purc_rwstream_t out)
+{
+    if (vdom == NULL || out == NULL) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return false;
+    }
+
+    struct cache_writer wr = { out, false };
+
+    put_bytes(&wr, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    put_cstring(&wr, PURC_VERSION_STRING);
+    put_u8(&wr, (uint8_t)sizeof(long double));
+    put_u32(&wr, CACHE_BOM);
+
+    put_cstring(&wr, vdom->doctype.name);
+    put_cstring(&wr, vdom->doctype.system_info);
+    put_u8(&wr, vdom->quirks);
+    save_children(&wr, vdom, &vdom->node);
+
+    if (wr.failed) {
+        purc_set_error(PCRWSTREAM_ERROR_IO);
+        return false;
+    }
+
+    return true;
+}
+
+struct cache_reader {
+    const uint8_t      *p;
+    const uint8_t      *end;
+    bool                failed;
+    /* keep the VCM trees of attributes packed */
+    bool                lazy_attrs;
+};
+
+static const void *
+get_bytes(struct cache_reader *rd, size_t len)
+{
+    if (rd->failed || (size_t)(rd->end - rd->p) < len) {
+        rd->failed = true;
+        return NULL;
+    }
+
+    const void *data = rd->p;
+    rd->p += len;
+    return data;
+}
+
+static uint8_t
+get_u8(struct cache_reader *rd)
+{
+    const uint8_t *p = get_bytes(rd, sizeof(uint8_t));
+    return p ? *p : 0;
+}
+
+static uint32_t
+get_u32(struct cache_reader *rd)
+{
+    uint32_t u32 = 0;
+    const void *p = get_bytes(rd, sizeof(u32));
+    if (p)
+        memcpy(&u32, p, sizeof(u32));
+    return u32;
+}
+
+/* returns a pointer into the cache; the string is not null-terminated */
+static const char *
+get_string(struct cache_reader *rd, size_t *len)
+{
+    uint32_t n = get_u32(rd);
+    if (n == 0) {
+        *len = 0;
+        return NULL;
+    }
+
+    *len = n - 1;
+    return get_bytes(rd, *len);
+}
+
+static char *
+get_strdup(struct cache_reader *rd, bool *is_null)
+{
+    size_t len;
+    const char *str = get_string(rd, &len);
+    *is_null = (str == NULL);
+    if (str == NULL)
+        return NULL;
+
+    return strndup(str, len);
+}
+
+static struct pcvcm_node *
+load_vcm(struct cache_reader *rd)
+{
+    struct pcvcm_node *vcm = calloc(1, sizeof(*vcm));
+    if (vcm == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        rd->failed = true;
+        return NULL;
+    }
+
+    vcm->type = get_u8(rd);
+    vcm->extra = get_u32(rd);
+    vcm->is_closed = get_u8(rd);
+
+    const void *p;
+    switch (vcm->type) {
+    case PCVCM_NODE_TYPE_STRING:
+    case PCVCM_NODE_TYPE_BYTE_SEQUENCE:
+    {
+        size_t len;
+        const char *str = get_string(rd, &len);
+        if (str) {
+            char *buf = malloc(len + 1);
+            if (buf == NULL) {
+                rd->failed = true;
+                break;
+            }
+            memcpy(buf, str, len);
+            buf[len] = 0;
+            vcm->sz_ptr[0] = len;
+            vcm->sz_ptr[1] = (uintptr_t)buf;
+        }
+        break;
+    }
+
+    case PCVCM_NODE_TYPE_BOOLEAN:
+        vcm->b = get_u8(rd);
+        break;
+
+    case PCVCM_NODE_TYPE_NUMBER:
+        if ((p = get_bytes(rd, sizeof(vcm->d))))
+            memcpy(&vcm->d, p, sizeof(vcm->d));
+        break;
+
+    case PCVCM_NODE_TYPE_LONG_INT:
+        if ((p = get_bytes(rd, sizeof(vcm->i64))))
+            memcpy(&vcm->i64, p, sizeof(vcm->i64));
+        break;
+
+    case PCVCM_NODE_TYPE_ULONG_INT:
+        if ((p = get_bytes(rd, sizeof(vcm->u64))))
+            memcpy(&vcm->u64, p, sizeof(vcm->u64));
+        break;
+
+    case PCVCM_NODE_TYPE_LONG_DOUBLE:
+        if ((p = get_bytes(rd, sizeof(vcm->ld))))
+            memcpy(&vcm->ld, p, sizeof(vcm->ld));
+        break;
+
+    default:
+        if (vcm->type > PCVCM_NODE_TYPE_CJSONEE_OP_SEMICOLON)
+            rd->failed = true;
+        break;
+    }
+
+    uint32_t nr_children = get_u32(rd);
+    for (uint32_t i = 0; i < nr_children && !rd->failed; i++) {
+        struct pcvcm_node *child = load_vcm(rd);
+        if (child)
+            pctree_node_append_child(&vcm->tree_node, &child->tree_node);
+    }
+
+    if (rd->failed) {
+        pcvcm_node_destroy(vcm);
+        return NULL;
+    }
+
+    return vcm;
+}
+
+/* skips a VCM tree without building it; returns the number of nodes */
+static size_t
+skip_vcm(struct cache_reader *rd)
+{
+    size_t len;
+    uint8_t type = get_u8(rd);
+    get_bytes(rd, sizeof(uint32_t) + sizeof(uint8_t));
+
+    switch (type) {
+    case PCVCM_NODE_TYPE_STRING:
+    case PCVCM_NODE_TYPE_BYTE_SEQUENCE:
+        get_string(rd, &len);
+        break;
+
+    case PCVCM_NODE_TYPE_BOOLEAN:
+        get_u8(rd);
+        break;
+
+    case PCVCM_NODE_TYPE_NUMBER:
+        get_bytes(rd, sizeof(double));
+        break;
+
+    case PCVCM_NODE_TYPE_LONG_INT:
+        get_bytes(rd, sizeof(int64_t));
+        break;
+
+    case PCVCM_NODE_TYPE_ULONG_INT:
+        get_bytes(rd, sizeof(uint64_t));
+        break;
+
+    case PCVCM_NODE_TYPE_LONG_DOUBLE:
+        get_bytes(rd, sizeof(long double));
+        break;
+
+    default:
+        if (type > PCVCM_NODE_TYPE_CJSONEE_OP_SEMICOLON)
+            rd->failed = true;
+        break;
+    }
+
+    size_t nr_nodes = 1;
+    uint32_t nr_children = get_u32(rd);
+    for (uint32_t i = 0; i < nr_children && !rd->failed; i++) {
+        nr_nodes += skip_vcm(rd);
+    }
+
+    return nr_nodes;
+}
+
+static bool
+load_children(struct cache_reader *rd, struct pcvdom_document *doc,
+        struct pcvdom_node *parent);
+
+static struct pcvdom_attr *
+load_attr(struct cache_reader *rd)
+{
+    bool is_null;
+    char *key = get_strdup(rd, &is_null);
+    enum pchvml_attr_operator op = get_u8(rd);
+    struct pcvcm_node *val = NULL;
+    struct pcvdom_attr *attr = NULL;
+
+    if (get_u8(rd)) {
+        /* keep a tree of more than one node packed; it is copied as is
+           without building the nodes */
+        const uint8_t *packed = rd->p;
+        if (rd->lazy_attrs && skip_vcm(rd) > 1) {
+            if (key == NULL || rd->failed)
+                goto failed;
+
+            attr = pcvdom_attr_create_packed(key, op, packed,
+                    rd->p - packed);
+            if (attr == NULL)
+                goto failed;
+
+            free(key);
+            return attr;
+        }
+
+        rd->p = packed;
+        if ((val = load_vcm(rd)) == NULL)
+            goto failed;
+    }
+
+    if (key == NULL || rd->failed)
+        goto failed;
+
+    attr = pcvdom_attr_create(key, op, val);
+    if (attr == NULL)
+        goto failed;
+
+    free(key);
+    return attr;
+
+failed:
+    rd->failed = true;
+    pcvcm_node_destroy(val);
+    free(key);
+    return NULL;
+}
+
+static struct pcvdom_element *
+load_element(struct cache_reader *rd, struct pcvdom_document *doc,
+        uint8_t *flags)
+{
+    bool is_null;
+    char *tag_name = get_strdup(rd, &is_null);
+    *flags = get_u8(rd);
+    if (tag_name == NULL || rd->failed) {
+        free(tag_name);
+        rd->failed = true;
+        return NULL;
+    }
+
+    struct pcvdom_element *elem = pcvdom_element_create_c(tag_name);
+    free(tag_name);
+    if (elem == NULL) {
+        rd->failed = true;
+        return NULL;
+    }
+
+    elem->self_closing = (*flags & ELEMENT_FLAG_SELF_CLOSING) ? 1 : 0;
+    elem->line = (int)get_u32(rd);
+
+    uint32_t nr_attrs = get_u32(rd);
+    for (uint32_t i = 0; i < nr_attrs && !rd->failed; i++) {
+        struct pcvdom_attr *attr = load_attr(rd);
+        if (attr && pcvdom_element_append_attr(elem, attr)) {
+            pcvdom_attr_destroy(attr);
+            rd->failed = true;
+        }
+    }
+
+    if (rd->failed || !load_children(rd, doc, &elem->node)) {
+        pcvdom_node_destroy(&elem->node);
+        rd->failed = true;
+        return NULL;
+    }
+
+    return elem;
+}
+
+static struct pcvdom_node *
+load_node(struct cache_reader *rd, struct pcvdom_document *doc,
+        uint8_t *flags)
+{
+    *flags = 0;
+
+    switch (get_u8(rd)) {
+    case PCVDOM_NODE_ELEMENT:
+    {
+        struct pcvdom_element *elem = load_element(rd, doc, flags);
+        return elem ? &elem->node : NULL;
+    }
+
+    case PCVDOM_NODE_CONTENT:
+    {
+        struct pcvcm_node *vcm = load_vcm(rd);
+        if (vcm == NULL)
+            break;
+
+        struct pcvdom_content *content = pcvdom_content_create(vcm);
+        if (content == NULL) {
+            pcvcm_node_destroy(vcm);
+            break;
+        }
+        return &content->node;
+    }
+
+    case PCVDOM_NODE_COMMENT:
+    {
+        bool is_null;
+        char *text = get_strdup(rd, &is_null);
+        if (text == NULL)
+            break;
+
+        struct pcvdom_comment *comment = pcvdom_comment_create(text);
+        free(text);
+        if (comment == NULL)
+            break;
+        return &comment->node;
+    }
+
+    default:
+        break;
+    }
+
+    rd->failed = true;
+    return NULL;
+}
+
+static bool
+load_children(struct cache_reader *rd, struct pcvdom_document *doc,
+        struct pcvdom_node *parent)
+{
+    uint32_t nr_children = get_u32(rd);
+
+    for (uint32_t i = 0; i < nr_children && !rd->failed; i++) {
+        uint8_t flags;
+        struct pcvdom_node *node = load_node(rd, doc, &flags);
+        if (node == NULL)
+            break;
+
+        int r;
+        if (parent->type == PCVDOM_NODE_DOCUMENT &&
+                (flags & ELEMENT_FLAG_ROOT)) {
+            r = pcvdom_document_set_root(doc, PCVDOM_ELEMENT_FROM_NODE(node));
+        }
+        else {
+            r = pctree_node_append_child(&parent->node, &node->node) ? 0 : -1;
+        }
+
+        if (r) {
+            pcvdom_node_destroy(node);
+            rd->failed = true;
+            break;
+        }
+
+        struct pcvdom_element *elem = PCVDOM_ELEMENT_FROM_NODE(node);
+        if (flags & ELEMENT_FLAG_HEAD)
+            doc->head = elem;
+        if ((flags & ELEMENT_FLAG_BODY) &&
+                pcutils_arrlist_append(doc->bodies, elem) == 0) {
+            /* the last body in the document order */
+            doc->body = elem;
+        }
+    }
+
+    return !rd->failed;
+}
+
+void *
+pcvdom_pack_vcm(struct pcvcm_node *vcm, size_t *sz_packed)
+{
+    purc_rwstream_t out = purc_rwstream_new_buffer(64, 0);
+    if (out == NULL)
+        return NULL;
+
+    struct cache_writer wr = { out, false };
+    save_vcm(&wr, vcm);
+
+    void *packed = NULL;
+    if (!wr.failed)
+        packed = purc_rwstream_get_mem_buffer_ex(out, sz_packed, NULL, true);
+    purc_rwstream_destroy(out);
+
+    if (packed == NULL)
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    return packed;
+}
+
+struct pcvcm_node *
+pcvdom_unpack_vcm(const void *packed, size_t sz_packed)
+{
+    struct cache_reader rd = { packed, (const uint8_t *)packed + sz_packed,
+        false, false };
+
+    struct pcvcm_node *vcm = load_vcm(&rd);
+    if (vcm && rd.p != rd.end) {
+        pcvcm_node_destroy(vcm);
+        vcm = NULL;
+    }
+
+    if (vcm == NULL)
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+    return vcm;
+}
+
+purc_vdom_t
+purc_load_hvml_from_cache(const void *data, size_t sz)
+{
+    if (data == NULL || sz == 0) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return NULL;
+    }
+
+    struct pcinst *inst = pcinst_current();
+    struct cache_reader rd = { data, (const uint8_t *)data + sz, false,
+        inst && inst->lazy_attr_vcm };
+    struct pcvdom_document *doc = NULL;
+    size_t len;
+    bool is_null;
+
+    const char *magic = get_bytes(&rd, sizeof(CACHE_MAGIC));
+    if (magic == NULL || memcmp(magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)))
+        goto bad_cache;
+
+    const char *version = get_string(&rd, &len);
+    if (version == NULL || len != strlen(PURC_VERSION_STRING) ||
+            memcmp(version, PURC_VERSION_STRING, len))
+        goto bad_cache;
+
+    if (get_u8(&rd) != sizeof(long double) || get_u32(&rd) != CACHE_BOM)
+        goto bad_cache;
+
+    doc = pcvdom_document_create();
+    if (doc == NULL)
+        return NULL;
+
+    doc->doctype.name = get_strdup(&rd, &is_null);
+    doc->doctype.system_info = get_strdup(&rd, &is_null);
+    doc->quirks = get_u8(&rd) ? 1 : 0;
+
+    if (!load_children(&rd, doc, &doc->node) || rd.p != rd.end)
+        goto bad_cache;
+
+    return doc;
+
+bad_cache:
+    if (doc)
+        pcvdom_document_unref(doc);
+    purc_set_error(PURC_ERROR_INVALID_VALUE);
+    return NULL;
+}
+
@@ -58,7 +58,9 @@
 struct pcvdom_node {
     struct pctree_node     node;
     enum pcvdom_nodetype   type;
-    void (*remove_child)(struct pcvdom_node *me, struct pcvdom_node *child);
+    // the node (and its strings) was allocated from the arena of the
+    // document, and is freed together with the arena
+    unsigned int           in_arena:1;
 };
 
 struct pcvdom_doctype {
@@ -81,6 +83,10 @@ struct pcvdom_document {
 
     atomic_ulong            refc;
 
+    /* the arena the VCM nodes and the vDOM nodes of the document were
+       allocated from when parsed */
+    struct pcvcm_arena     *vcm_arena;
+
     unsigned int            quirks:1;
 };
 
@@ -93,11 +99,24 @@ struct pcvdom_attr {
     const struct pchvml_attr_entry  *pre_defined;
     char                     *key;
 
+    // the atom of the key as an HVML keyword, resolved when created;
+    // 0 if the key is not a keyword (yet)
+    purc_atom_t               atom;
+
     // operator
     enum pchvml_attr_operator       op;
 
     // text/jsonnee/no-value
     struct pcvcm_node        *val;
+
+    // the packed VCM tree (see pcvdom_pack_vcm), kept after unpacked to
+    // `val` at the first use; use pcvdom_attr_get_vcm() instead of
+    // accessing val directly.
+    void                     *packed_val;
+    uint32_t                  sz_packed_val;
+
+    // the attribute (and its key) was allocated from the arena
+    unsigned int              in_arena:1;
 };
 
 struct pcvdom_element {
@@ -106,13 +125,33 @@ struct pcvdom_element {
     // for those non-pre-defined tags(UNDEF)
     // tag_name shall be free'd afterwards in case when tag_id is tag(UNDEF)
     pcvdom_tag_id           tag_id;
+    // the line of the start tag in the source; 0 if unknown
+    int                     line;
     char                   *tag_name;
 
-    // key: char *, the same as struct pcvdom_attr:key
-    // val: struct pcvdom_attr*
-    struct pcutils_map     *attrs;
+    // the attributes sorted by the keys (in the order of strcmp()),
+    // so they are walked in the same order as they were in a map
+    struct pcvdom_attr    **attrs;
+    uint32_t                nr_attrs;
+    uint32_t                sz_attrs;
+
+    // the anchor given by a literal `id` attribute (without the leading
+    // `#`), determined when the attribute is appended; NULL if none
+    char                   *anchor;
+
+    // the data compiled from the element by the interpreter when the
+    // element is executed the first time (e.g. the dispatch table of
+    // `test`); released by calling `free_compiled` if the element or its
+    // children are changed. Use pcvdom_element_get_compiled() and
+    // pcvdom_element_set_compiled(), since the vDOM may be shared.
+    void                   *compiled;
+    void                  (*free_compiled)(void *compiled);
 
     unsigned int            self_closing:1;
+    // the `id` attribute has to be evaluated to get the anchor
+    unsigned int            dynamic_id:1;
+    // the array of the attributes was allocated from the arena
+    unsigned int            attrs_in_arena:1;
 };
 
 struct pcvdom_content {
@@ -127,5 +166,20 @@ struct pcvdom_comment {
     char                   *text;
 };
 
+/* reserves the slots for @nr attributes of the element, from the arena if
+   the element was allocated from it */
+int
+pcvdom_element_reserve_attrs(struct pcvdom_element *elem,
+        size_t nr) WTF_INTERNAL;
+
+/* packs a VCM tree in the format of the vDOM cache; the returned buffer
+   should be released by calling free() */
+void *
+pcvdom_pack_vcm(struct pcvcm_node *vcm, size_t *sz_packed) WTF_INTERNAL;
+
+/* unpacks a VCM tree packed by pcvdom_pack_vcm() */
+struct pcvcm_node *
+pcvdom_unpack_vcm(const void *packed, size_t sz_packed) WTF_INTERNAL;
+
 #endif // PURC_VDOM_VDOM_INTERNAL_H
 
@@ -31,6 +31,7 @@
 #include "private/stringbuilder.h"
 
 #include "hvml-attr.h"
+#include "keywords.h"
 
 #include "vdom-internal.h"
 
@@ -113,6 +114,54 @@ attr_create(void);
 static void
 vdom_node_destroy(struct pcvdom_node *node);
 
+/*
+ * The nodes of a document parsed with an arena, their attributes, and the
+ * strings of them are bump-allocated from the arena of the document, next
+ * to each other in the order of the source, so walking the tree touches
+ * the memory in order; they are freed all together with the document.
+ * The nodes created later (e.g. by the interpreter) come from the heap.
+ */
+static void *
+node_alloc(size_t size, bool *in_arena)
+{
+    struct pcvcm_arena *arena = pcvcm_arena_current();
+    void *p;
+
+    *in_arena = (arena != NULL);
+    if (arena)
+        return pcvcm_arena_alloc(arena, size);
+
+    p = calloc(1, size);
+    if (!p)
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    return p;
+}
+
+static void
+node_free(bool in_arena, void *p)
+{
+    if (!in_arena)
+        free(p);
+}
+
+static char *
+node_strdup(bool in_arena, const char *str)
+{
+    if (!in_arena) {
+        char *dup = strdup(str);
+        if (!dup)
+            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return dup;
+    }
+
+    /* the node is still being parsed, so the arena is the current one */
+    size_t len = strlen(str);
+    char *dup = pcvcm_arena_alloc(pcvcm_arena_current(), len + 1);
+    if (dup)
+        memcpy(dup, str, len);
+    return dup;
+}
+
 struct pcvdom_document*
 pcvdom_document_ref(struct pcvdom_document *doc)
 {
@@ -187,9 +236,8 @@ pcvdom_element_create_c(const char *tag_name)
         elem->tag_id   = entry->id;
         elem->tag_name = (char*)entry->name;
     } else {
-        elem->tag_name = strdup(tag_name);
+        elem->tag_name = node_strdup(elem->node.in_arena, tag_name);
         if (!elem->tag_name) {
-            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
             element_destroy(elem);
             return NULL;
         }
@@ -246,19 +294,118 @@ pcvdom_attr_create(const char *key, enum pchvml_attr_operator op,
     if (attr->pre_defined) {
         attr->key = (char*)attr->pre_defined->name;
     } else {
-        attr->key = strdup(key);
+        attr->key = node_strdup(attr->in_arena, key);
         if (!attr->key) {
-            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
             attr_destroy(attr);
             return NULL;
         }
     }
 
+    attr->atom = PCHVML_KEYWORD_ATOM(HVML, attr->key);
     attr->val = vcm;
+    pcvcm_node_fold_constants(vcm);
+
+    return attr;
+}
+
+struct pcvdom_attr*
+pcvdom_attr_create_lazy(const char *key, enum pchvml_attr_operator op,
+    struct pcvcm_node *vcm)
+{
+    // it is not worth packing a single node
+    if (!vcm || pcvcm_node_children_count(vcm) == 0)
+        return pcvdom_attr_create(key, op, vcm);
+
+    size_t sz_packed;
+    void *packed = pcvdom_pack_vcm(vcm, &sz_packed);
+    if (!packed)
+        return NULL;
+
+    if (sz_packed > UINT32_MAX) {
+        free(packed);
+        return pcvdom_attr_create(key, op, vcm);
+    }
+
+    struct pcvdom_attr *attr = pcvdom_attr_create(key, op, NULL);
+    if (!attr) {
+        free(packed);
+        return NULL;
+    }
+
+    attr->packed_val = packed;
+    attr->sz_packed_val = sz_packed;
+    pcinst_current()->nr_lazy_attrs++;
+
+    pcvcm_node_destroy(vcm);
+    return attr;
+}
+
+struct pcvdom_attr*
+pcvdom_attr_create_packed(const char *key, enum pchvml_attr_operator op,
+    const void *packed, size_t sz_packed)
+{
+    if (!packed || sz_packed == 0 || sz_packed > UINT32_MAX) {
+        pcinst_set_error(PURC_ERROR_INVALID_VALUE);
+        return NULL;
+    }
+
+    void *copied = malloc(sz_packed);
+    if (!copied) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+    memcpy(copied, packed, sz_packed);
+
+    struct pcvdom_attr *attr = pcvdom_attr_create(key, op, NULL);
+    if (!attr) {
+        free(copied);
+        return NULL;
+    }
 
+    attr->packed_val = copied;
+    attr->sz_packed_val = sz_packed;
+    pcinst_current()->nr_lazy_attrs++;
     return attr;
 }
 
+struct pcvcm_node*
+pcvdom_attr_get_vcm(struct pcvdom_attr *attr)
+{
+    struct pcvcm_node *vcm = __atomic_load_n(&attr->val, __ATOMIC_ACQUIRE);
+    if (vcm || attr->packed_val == NULL)
+        return vcm;
+
+    /* the vDOM may be evaluated by other threads at the same time, so the
+       tree is unpacked privately and only one is published; the packed
+       tree is kept until the attribute is destroyed */
+    vcm = pcvdom_unpack_vcm(attr->packed_val, attr->sz_packed_val);
+    if (!vcm)
+        return NULL;
+    pcvcm_node_fold_constants(vcm);
+
+    struct pcvcm_node *published = NULL;
+    if (!__atomic_compare_exchange_n(&attr->val, &published, vcm, false,
+                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        /* unpacked by another thread meanwhile */
+        pcvcm_node_destroy(vcm);
+        return published;
+    }
+
+    struct pcinst *inst = pcinst_current();
+    if (inst)
+        inst->nr_lazy_attrs_compiled++;
+
+    return vcm;
+}
+
+void
+pcvdom_get_lazy_attr_stat(size_t *nr_lazy, size_t *nr_compiled)
+{
+    struct pcinst *inst = pcinst_current();
+    *nr_lazy = inst ? inst->nr_lazy_attrs : 0;
+    *nr_compiled = inst ? inst->nr_lazy_attrs_compiled : 0;
+}
+
 void
 pcvdom_attr_destroy(struct pcvdom_attr *attr)
 {
@@ -342,6 +489,161 @@ pcvdom_document_append_comment(struct pcvdom_document *doc,
     return 0;
 }
 
+/* the string of a literal, or of a concatenation of a single literal */
+static const char *
+literal_string(struct pcvcm_node *vcm, size_t *len)
+{
+    if (vcm && vcm->type == PCVCM_NODE_TYPE_FUNC_CONCAT_STRING &&
+            pctree_node_children_number(&vcm->tree_node) == 1) {
+        vcm = (struct pcvcm_node *)pctree_node_child(&vcm->tree_node);
+    }
+
+    if (vcm && vcm->type == PCVCM_NODE_TYPE_STRING) {
+        *len = (size_t)vcm->sz_ptr[0];
+        return (const char *)vcm->sz_ptr[1];
+    }
+
+    return NULL;
+}
+
+const char*
+pcvdom_attr_get_literal(struct pcvdom_attr *attr, size_t *len)
+{
+    if (attr->packed_val)
+        return NULL;
+
+    return literal_string(attr->val, len);
+}
+
+void
+pcvdom_element_discard_compiled(struct pcvdom_element *elem)
+{
+    if (elem && elem->compiled) {
+        elem->free_compiled(elem->compiled);
+        elem->compiled = NULL;
+        elem->free_compiled = NULL;
+    }
+}
+
+void *
+pcvdom_element_get_compiled(struct pcvdom_element *elem,
+        void (*free_compiled)(void *compiled))
+{
+    void *compiled = __atomic_load_n(&elem->compiled, __ATOMIC_ACQUIRE);
+    if (compiled && elem->free_compiled == free_compiled)
+        return compiled;
+    return NULL;
+}
+
+void *
+pcvdom_element_set_compiled(struct pcvdom_element *elem, void *compiled,
+        void (*free_compiled)(void *compiled))
+{
+    void *published = __atomic_load_n(&elem->compiled, __ATOMIC_ACQUIRE);
+    if (published && elem->free_compiled != free_compiled) {
+        /* compiled by another kind of element; never for a shared vDOM */
+        pcvdom_element_discard_compiled(elem);
+        published = NULL;
+    }
+
+    if (published == NULL) {
+        /* set before publishing, so the data is never seen without it */
+        elem->free_compiled = free_compiled;
+        if (__atomic_compare_exchange_n(&elem->compiled, &published, compiled,
+                    false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            return compiled;
+    }
+
+    /* compiled by another thread meanwhile */
+    free_compiled(compiled);
+    return published;
+}
+
+static void
+update_anchor(struct pcvdom_element *elem, struct pcvdom_attr *attr)
+{
+    free(elem->anchor);
+    elem->anchor = NULL;
+    elem->dynamic_id = 0;
+
+    size_t len;
+    const char *id = attr->packed_val ? NULL : literal_string(attr->val, &len);
+    if (id == NULL) {
+        elem->dynamic_id = (attr->val || attr->packed_val) ? 1 : 0;
+    }
+    else if (len > 0 && id[0] == '#') {
+        elem->anchor = strndup(id + 1, len - 1);
+        /* fall back to the evaluation if out of memory */
+        if (elem->anchor == NULL)
+            elem->dynamic_id = 1;
+    }
+}
+
+#define MIN_ATTR_SLOTS      4
+
+/* returns the index of the attribute with the key, or the index to insert
+   the attribute at if not found */
+static size_t
+find_attr_index(struct pcvdom_element *elem, const char *key, bool *found)
+{
+    size_t lo = 0, hi = elem->nr_attrs;
+
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        int diff = strcmp(key, elem->attrs[mid]->key);
+        if (diff == 0) {
+            *found = true;
+            return mid;
+        }
+
+        if (diff < 0)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+
+    *found = false;
+    return lo;
+}
+
+int
+pcvdom_element_reserve_attrs(struct pcvdom_element *elem, size_t nr)
+{
+    if (nr <= elem->sz_attrs)
+        return 0;
+
+    if (nr > UINT32_MAX) {
+        pcinst_set_error(PURC_ERROR_INVALID_VALUE);
+        return -1;
+    }
+
+    struct pcvcm_arena *arena = elem->node.in_arena ?
+        pcvcm_arena_current() : NULL;
+    struct pcvdom_attr **attrs;
+    if (arena && elem->nr_attrs == 0) {
+        attrs = pcvcm_arena_alloc(arena, sizeof(*attrs) * nr);
+        if (!attrs)
+            return -1;
+        node_free(elem->attrs_in_arena, elem->attrs);
+        elem->attrs_in_arena = 1;
+    }
+    else {
+        attrs = elem->attrs_in_arena ? malloc(sizeof(*attrs) * nr) :
+            realloc(elem->attrs, sizeof(*attrs) * nr);
+        if (!attrs) {
+            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return -1;
+        }
+        if (elem->attrs_in_arena)
+            memcpy(attrs, elem->attrs, sizeof(*attrs) * elem->nr_attrs);
+        elem->attrs_in_arena = 0;
+    }
+
+    elem->attrs = attrs;
+    elem->sz_attrs = nr;
+    return 0;
+}
+
 int
 pcvdom_element_append_attr(struct pcvdom_element *elem,
         struct pcvdom_attr *attr)
@@ -351,15 +653,57 @@ pcvdom_element_append_attr(struct pcvdom_element *elem,
         return -1;
     }
 
-    PC_ASSERT(elem->attrs);
+    bool found;
+    size_t idx = find_attr_index(elem, attr->key, &found);
+    if (found) {
+        /* replaces the attribute with the same key */
+        struct pcvdom_attr *old = elem->attrs[idx];
+        old->parent = NULL;
+        attr_destroy(old);
+        elem->attrs[idx] = attr;
+    }
+    else {
+        if (elem->nr_attrs == elem->sz_attrs) {
+            size_t sz = elem->sz_attrs ? elem->sz_attrs * 2 : MIN_ATTR_SLOTS;
+            struct pcvdom_attr **attrs;
+            if (elem->attrs_in_arena) {
+                /* outgrown the slots reserved in the arena */
+                attrs = malloc(sizeof(*attrs) * sz);
+                if (attrs)
+                    memcpy(attrs, elem->attrs,
+                            sizeof(*attrs) * elem->nr_attrs);
+            }
+            else {
+                attrs = realloc(elem->attrs, sizeof(*attrs) * sz);
+            }
+            if (!attrs) {
+                pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+                return -1;
+            }
+
+            elem->attrs = attrs;
+            elem->sz_attrs = sz;
+            elem->attrs_in_arena = 0;
+        }
 
-    int r;
-    r = pcutils_map_find_replace_or_insert(elem->attrs,
-            attr->key, attr, NULL);
-    PC_ASSERT(r==0);
+        memmove(elem->attrs + idx + 1, elem->attrs + idx,
+                sizeof(*elem->attrs) * (elem->nr_attrs - idx));
+        elem->attrs[idx] = attr;
+        elem->nr_attrs++;
+    }
 
     attr->parent = elem;
 
+    if (strcmp(attr->key, "id") == 0)
+        update_anchor(elem, attr);
+
+    pcvdom_element_discard_compiled(elem);
+    if (elem->node.node.parent) {
+        struct pcvdom_node *parent;
+        parent = container_of(elem->node.node.parent, struct pcvdom_node, node);
+        if (parent->type == PCVDOM_NODE_ELEMENT)
+            pcvdom_element_discard_compiled(PCVDOM_ELEMENT_FROM_NODE(parent));
+    }
     return 0;
 }
 
@@ -375,6 +719,7 @@ pcvdom_element_append_element(struct pcvdom_element *elem,
     bool b = pctree_node_append_child(&elem->node.node, &child->node.node);
     PC_ASSERT(b);
 
+    pcvdom_element_discard_compiled(elem);
     return 0;
 }
 
@@ -546,20 +891,14 @@ pcvdom_element_get_attr_c(struct pcvdom_element *elem,
         return NULL;
     }
 
-    if (!elem->attrs) {
-        pcinst_set_error(PURC_ERROR_NO_INSTANCE);
-        return NULL;
-    }
-
-    pcutils_map_entry *entry;
-    entry = pcutils_map_find(elem->attrs, key);
-
-    if (!entry || !entry->val) {
+    bool found;
+    size_t idx = find_attr_index(elem, key, &found);
+    if (!found) {
         pcinst_set_error(PURC_ERROR_NOT_EXISTS);
         return NULL;
     }
 
-    return entry->val;
+    return elem->attrs[idx];
 }
 
 // operation api
@@ -721,14 +1060,11 @@ document_serialize(struct pcvdom_document *doc, int level, int push,
 }
 
 static int
-attr_serialize(void *key, void *val, void *ctxt)
+attr_serialize(struct pcvdom_attr *attr, struct serialize_data *ud)
 {
-    const char *sk = (const char*)key;
-    struct pcvdom_attr *attr = (struct pcvdom_attr*)val;
-    struct serialize_data *ud = (struct serialize_data*)ctxt;
-    PC_ASSERT(sk == attr->key);
+    const char *sk = attr->key;
     enum pchvml_attr_operator  op  = attr->op;
-    struct pcvcm_node         *v = attr->val;
+    struct pcvcm_node         *v = pcvdom_attr_get_vcm(attr);
 
     ud->cb(" ", 1, ud->ctxt);
     ud->cb(sk, strlen(sk), ud->ctxt);
@@ -802,14 +1138,11 @@ element_serialize(struct pcvdom_element *element, int level, int push,
     char *tag_name = element->tag_name;
 
     if (push) {
-        // key: char *, the same as struct pcvdom_attr:key
-        // val: struct pcvdom_attr*
-        struct pcutils_map *attrs = element->attrs;
-
         ud->cb("<", 1, ud->ctxt);
         ud->cb(tag_name, strlen(tag_name), ud->ctxt);
 
-        pcutils_map_traverse(attrs, ud, attr_serialize);
+        for (size_t i = 0; i < element->nr_attrs; i++)
+            attr_serialize(element->attrs[i], ud);
 
         ud->cb(">", 1, ud->ctxt);
     }
@@ -973,6 +1306,7 @@ document_destroy(struct pcvdom_document *doc)
 {
     document_reset(doc);
     PC_ASSERT(doc->node.node.first_child == NULL);
+    pcvcm_arena_unref(doc->vcm_arena);
     free(doc);
 }
 
@@ -1007,7 +1341,6 @@ document_create(void)
     }
 
     doc->node.type = VDT(DOCUMENT);
-    doc->node.remove_child = document_remove_child;
 
     doc->refc = 1;
 
@@ -1036,13 +1369,16 @@ document_set_doctype(struct pcvdom_document *doc,
 static void
 element_reset(struct pcvdom_element *elem)
 {
-    int r;
-
     if (elem->tag_id==VTT(_UNDEF) && elem->tag_name) {
-        free(elem->tag_name);
+        node_free(elem->node.in_arena, elem->tag_name);
     }
     elem->tag_name = NULL;
 
+    free(elem->anchor);
+    elem->anchor = NULL;
+
+    pcvdom_element_discard_compiled(elem);
+
     while (elem->node.node.first_child) {
         struct pcvdom_node *node;
         node = container_of(elem->node.node.first_child, struct pcvdom_node, node);
@@ -1050,11 +1386,15 @@ element_reset(struct pcvdom_element *elem)
         pcvdom_node_destroy(node);
     }
 
-    if (elem->attrs) {
-        r = pcutils_map_destroy(elem->attrs);
-        PC_ASSERT(r==0);
-        elem->attrs = NULL;
+    for (size_t i = 0; i < elem->nr_attrs; i++) {
+        elem->attrs[i]->parent = NULL;
+        attr_destroy(elem->attrs[i]);
     }
+    node_free(elem->attrs_in_arena, elem->attrs);
+    elem->attrs = NULL;
+    elem->nr_attrs = 0;
+    elem->sz_attrs = 0;
+    elem->attrs_in_arena = 0;
 }
 
 static void
@@ -1062,68 +1402,24 @@ element_destroy(struct pcvdom_element *elem)
 {
     element_reset(elem);
     PC_ASSERT(elem->node.node.first_child == NULL);
-    free(elem);
-}
-
-static void*
-element_attr_copy_key(const void *key)
-{
-    return (void*)key;
-}
-
-static void
-element_attr_free_key(void *key)
-{
-    UNUSED_PARAM(key);
-}
-
-static void*
-element_attr_copy_val(const void *val)
-{
-    return (void*)val;
-}
-
-static int
-element_attr_comp_key(const void *key1, const void *key2)
-{
-    const char *s1 = (const char*)key1;
-    const char *s2 = (const char*)key2;
-
-    return strcmp(s1, s2);
-}
-
-static void
-element_attr_free_val(void *val)
-{
-    struct pcvdom_attr *attr = (struct pcvdom_attr*)val;
-    attr->parent = NULL;
-    attr_destroy(attr);
+    node_free(elem->node.in_arena, elem);
 }
 
 static struct pcvdom_element*
 element_create(void)
 {
     struct pcvdom_element *elem;
-    elem = (struct pcvdom_element*)calloc(1, sizeof(*elem));
+    bool in_arena;
+    elem = (struct pcvdom_element*)node_alloc(sizeof(*elem), &in_arena);
     if (!elem) {
-        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
         return NULL;
     }
 
     elem->node.type = VDT(ELEMENT);
-    elem->node.remove_child = NULL;
+    elem->node.in_arena = in_arena;
 
     elem->tag_id    = VTT(_UNDEF);
 
-    elem->attrs = pcutils_map_create(element_attr_copy_key, element_attr_free_key,
-        element_attr_copy_val, element_attr_free_val,
-        element_attr_comp_key, false); // non-thread-safe
-    if (!elem->attrs) {
-        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
-        element_destroy(elem);
-        return NULL;
-    }
-
     // FIXME:
     // if (pcintr_get_stack() == NULL)
     //     return elem;
@@ -1145,23 +1441,24 @@ content_destroy(struct pcvdom_content *content)
 {
     content_reset(content);
     PC_ASSERT(content->node.node.first_child == NULL);
-    free(content);
+    node_free(content->node.in_arena, content);
 }
 
 static struct pcvdom_content*
 content_create(struct pcvcm_node *vcm_content)
 {
     struct pcvdom_content *content;
-    content = (struct pcvdom_content*)calloc(1, sizeof(*content));
+    bool in_arena;
+    content = (struct pcvdom_content*)node_alloc(sizeof(*content), &in_arena);
     if (!content) {
-        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
         return NULL;
     }
 
     content->node.type = VDT(CONTENT);
-    content->node.remove_child = NULL;
+    content->node.in_arena = in_arena;
 
     content->vcm = vcm_content;
+    pcvcm_node_fold_constants(vcm_content);
 
     return content;
 }
@@ -1170,7 +1467,7 @@ static void
 comment_reset(struct pcvdom_comment *comment)
 {
     if (comment->text) {
-        free(comment->text);
+        node_free(comment->node.in_arena, comment->text);
         comment->text = NULL;
     }
 }
@@ -1180,25 +1477,24 @@ comment_destroy(struct pcvdom_comment *comment)
 {
     comment_reset(comment);
     PC_ASSERT(comment->node.node.first_child == NULL);
-    free(comment);
+    node_free(comment->node.in_arena, comment);
 }
 
 static struct pcvdom_comment*
 comment_create(const char *text)
 {
     struct pcvdom_comment *comment;
-    comment = (struct pcvdom_comment*)calloc(1, sizeof(*comment));
+    bool in_arena;
+    comment = (struct pcvdom_comment*)node_alloc(sizeof(*comment), &in_arena);
     if (!comment) {
-        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
         return NULL;
     }
 
     comment->node.type = VDT(COMMENT);
-    comment->node.remove_child = NULL;
+    comment->node.in_arena = in_arena;
 
-    comment->text = strdup(text);
+    comment->text = node_strdup(in_arena, text);
     if (!comment->text) {
-        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
         comment_destroy(comment);
         return NULL;
     }
@@ -1210,13 +1506,17 @@ static void
 attr_reset(struct pcvdom_attr *attr)
 {
     if (attr->pre_defined==NULL) {
-        free(attr->key);
+        node_free(attr->in_arena, attr->key);
     }
     attr->pre_defined = NULL;
     attr->key = NULL;
 
     pcvcm_node_destroy(attr->val);
     attr->val = NULL;
+
+    free(attr->packed_val);
+    attr->packed_val = NULL;
+    attr->sz_packed_val = 0;
 }
 
 static void
@@ -1224,19 +1524,20 @@ attr_destroy(struct pcvdom_attr *attr)
 {
     PC_ASSERT(attr->parent==NULL);
     attr_reset(attr);
-    free(attr);
+    node_free(attr->in_arena, attr);
 }
 
 static struct pcvdom_attr*
 attr_create(void)
 {
     struct pcvdom_attr *attr;
-    attr = (struct pcvdom_attr*)calloc(1, sizeof(*attr));
+    bool in_arena;
+    attr = (struct pcvdom_attr*)node_alloc(sizeof(*attr), &in_arena);
     if (!attr) {
-        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
         return NULL;
     }
 
+    attr->in_arena = in_arena;
     return attr;
 }
 
@@ -1247,8 +1548,8 @@ vdom_node_remove(struct pcvdom_node *node)
     if (!parent)
         return;
 
-    if (parent->remove_child)
-        parent->remove_child(parent, node);
+    if (parent->type == VDT(DOCUMENT))
+        document_remove_child(parent, node);
     else
         pctree_node_remove(&node->node);
 }
@@ -1335,20 +1636,9 @@ pcvdom_element_is_hvml_operation(struct pcvdom_element *element)
 struct pcvdom_attr*
 pcvdom_element_find_attr(struct pcvdom_element *element, const char *key)
 {
-    struct pcutils_map *attrs = element->attrs;
-    if (!attrs)
-        return NULL;
-
-    pcutils_map_entry *entry;
-    entry = pcutils_map_find(attrs, key);
-    if (!entry)
-        return NULL;
-    PC_ASSERT(entry->val);
-
-    struct pcvdom_attr *attr;
-    attr = (struct pcvdom_attr*)entry->val;
-
-    return attr;
+    bool found;
+    size_t idx = find_attr_index(element, key, &found);
+    return found ? element->attrs[idx] : NULL;
 }
 
 purc_variant_t
@@ -1360,7 +1650,7 @@ pcvdom_element_eval_attr_val(pcintr_stack_t stack, pcvdom_element_t element,
     if (!attr)
         return purc_variant_make_undefined();
 
-    struct pcvcm_node           *val = attr->val;
+    struct pcvcm_node           *val = pcvdom_attr_get_vcm(attr);
 
     purc_variant_t v;
     v = pcvcm_eval(val, stack, pcvdom_element_is_silently(element));
@@ -0,0 +1,38 @@
+#!/bin/sh
+
+# Run the standard benchmark corpus with `purc --bench`.
+#
+# Usage: bench_samples.sh [ times [ warmup ] ]
+#
+# Set PURC to the path of `purc`; set PURC_BENCH_FLAGS for extra options,
+# e.g. `--parallel` to run the programs in parallel.
+
+PURC=${PURC:-Source/Tools/purc/purc}
+BENCH_TIMES=${1:-10}
+BENCH_WARMUP=${2:-1}
+
+BENCH_PROGS="
+    hvml/fibonacci-void-temp.hvml
+    hvml/fibonacci-html-temp.hvml
+    hvml/calculator-bc.hvml
+    hvml/call-concurrently.hvml
+"
+
+total_failed=0
+
+for x in $BENCH_PROGS; do
+    echo ">> Benchmark of $x"
+    if ! $PURC $PURC_BENCH_FLAGS --bench=$BENCH_TIMES --warmup=$BENCH_WARMUP \
+            $x 2> /dev/null; then
+        total_failed=$((total_failed + 1))
+        echo "FAILED: $x"
+    fi
+    echo "<< End of $x"
+    echo ""
+done
+
+if test $total_failed -ne 0; then
+    exit 1
+fi
+
+exit 0
@@ -27,6 +27,7 @@
 #include "purc.h"
 
 #include <stdio.h>
+#include <ctype.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
@@ -34,6 +35,15 @@
 #include <limits.h>
 #include <assert.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 #define KEY_APP_NAME            "app"
 #define DEF_APP_NAME            "cn.fmsoft.hvml.purc"
@@ -59,6 +69,8 @@
 #define KEY_FLAG_PARALLEL       "parallel"
 #define KEY_FLAG_VERBOSE        "verbose"
 
+#define DEF_BENCH_WARMUP        1
+
 struct run_info {
     purc_variant_t opts;
     purc_variant_t app_info;
@@ -154,6 +166,39 @@ static void print_usage(FILE *fp)
         "  -l --parallel\n"
         "        Execute multiple programs in parallel.\n"
         "\n"
+        "  -C --vdom-cache=< directory >\n"
+        "        Keep the parsed HVML programs loaded from files in the specified\n"
+        "        directory, and load them from there if the files do not change.\n"
+        "\n"
+        "  -B --bench=< times >\n"
+        "        Execute the program(s) the specified times after the warmup runs,\n"
+        "        and report the wall time, the CPU time, the peak RSS, the variants\n"
+        "        and the messages made of every run; use with `--parallel` or an\n"
+        "        app description to measure the scaling across runners.\n"
+        "\n"
+        "  -W --warmup=< times >\n"
+        "        The times of the warmup runs of `--bench` (default value is 1).\n"
+        "\n"
+        "  -P --prefork=< socket_path >\n"
+        "        Initialize the modules once, then listen on the specified Unix\n"
+        "        socket and fork a child to execute every program requested;\n"
+        "        a request is a line of the file or URL of the program, and the\n"
+        "        output of the child is sent back through the connection, e.g.:\n"
+        "            echo hello.hvml | socat - UNIX-CONNECT:/tmp/purc.sock\n"
+        "        The vDOM caches of the programs given in the command line are\n"
+        "        read in advance when used with `--vdom-cache`.\n"
+        "\n"
+        "  -j --batch=< list_file | - >\n"
+        "        Execute the programs given in the command line and the ones listed\n"
+        "        in the specified file (one file or URL per line) by a pool of\n"
+        "        runners in this process, and print the status and the result of\n"
+        "        every program in one line; use `-` to read the list from stdin.\n"
+        "        Exit with failure if any program fails.\n"
+        "\n"
+        "  -n --runners=< number >\n"
+        "        The number of the runners of `--batch`; 0 (default) for one runner\n"
+        "        per online CPU.\n"
+        "\n"
         "  -b --verbose\n"
         "        Execute the program(s) with verbose output.\n"
         "\n"
@@ -175,12 +220,19 @@ struct my_opts {
     const char *rdr_prot;
     char *rdr_uri;
     char *request;
+    char *vdom_cache;
+    char *prefork;
+    char *batch;
 
     pcutils_array_t *urls;
     pcutils_array_t *body_ids;
     pcutils_array_t *contents;
     char *app_info;
 
+    unsigned int bench;
+    unsigned int warmup;
+    unsigned int nr_runners;
+
     bool parallel;
     bool verbose;
 };
@@ -244,6 +296,8 @@ static struct my_opts *my_opts_new(void)
 
     opts->contents = pcutils_array_create();
     pcutils_array_init(opts->contents, 1);
+
+    opts->warmup = DEF_BENCH_WARMUP;
     return opts;
 }
 
@@ -272,6 +326,15 @@ static void my_opts_delete(struct my_opts *opts, bool deep)
     if (opts->request)
         free(opts->request);
 
+    if (opts->vdom_cache)
+        free(opts->vdom_cache);
+
+    if (opts->prefork)
+        free(opts->prefork);
+
+    if (opts->batch)
+        free(opts->batch);
+
     if (opts->app_info)
         free(opts->app_info);
 
@@ -361,7 +424,7 @@ static bool validate_url(struct my_opts *opts, const char *url)
 
 static int read_option_args(struct my_opts *opts, int argc, char **argv)
 {
-    static const char short_options[] = "a:r:d:p:u:t:lbcvh";
+    static const char short_options[] = "a:r:d:p:u:t:C:B:W:P:j:n:lbcvh";
     static const struct option long_opts[] = {
         { "app"            , required_argument , NULL , 'a' },
         { "runner"         , required_argument , NULL , 'r' },
@@ -370,6 +433,12 @@ static int read_option_args(struct my_opts *opts, int argc, char **argv)
         { "rdr-uri"        , required_argument , NULL , 'u' },
         { "request"        , required_argument , NULL , 't' },
         { "parallel"       , no_argument       , NULL , 'l' },
+        { "vdom-cache"     , required_argument , NULL , 'C' },
+        { "bench"          , required_argument , NULL , 'B' },
+        { "warmup"         , required_argument , NULL , 'W' },
+        { "prefork"        , required_argument , NULL , 'P' },
+        { "batch"          , required_argument , NULL , 'j' },
+        { "runners"        , required_argument , NULL , 'n' },
         { "verbose"        , no_argument       , NULL , 'b' },
         { "copying"        , no_argument       , NULL , 'c' },
         { "version"        , no_argument       , NULL , 'v' },
@@ -471,6 +540,59 @@ static int read_option_args(struct my_opts *opts, int argc, char **argv)
             opts->parallel = true;
             break;
 
+        case 'C':
+        {
+            struct stat st;
+            if (stat(optarg, &st) == 0 && S_ISDIR(st.st_mode)) {
+                opts->vdom_cache = strdup(optarg);
+            }
+            else {
+                goto bad_arg;
+            }
+
+            break;
+        }
+
+        case 'B':
+        case 'W':
+        case 'n':
+        {
+            char *end;
+            unsigned long n = strtoul(optarg, &end, 10);
+            if (*optarg == 0 || *end != 0 || n > UINT_MAX ||
+                    (o == 'B' && n == 0)) {
+                goto bad_arg;
+            }
+
+            if (o == 'B')
+                opts->bench = (unsigned int)n;
+            else if (o == 'W')
+                opts->warmup = (unsigned int)n;
+            else
+                opts->nr_runners = (unsigned int)n;
+            break;
+        }
+
+        case 'j':
+            if (strcmp(optarg, "-") == 0 || access(optarg, R_OK) == 0) {
+                opts->batch = strdup(optarg);
+            }
+            else {
+                goto bad_arg;
+            }
+
+            break;
+
+        case 'P':
+            if (strlen(optarg) < sizeof(((struct sockaddr_un *)0)->sun_path)) {
+                opts->prefork = strdup(optarg);
+            }
+            else {
+                goto bad_arg;
+            }
+
+            break;
+
         case 'b':
             opts->verbose = true;
             break;
@@ -654,6 +776,158 @@ static bool evalute_app_info(const char *app_info)
 }
 
 
+static const char *vdom_cache_dir;
+
+/* the 64-bit FNV-1a hash of the contents */
+static uint64_t hash_contents(const unsigned char *data, size_t sz)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < sz; i++) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static void *map_file(const char *file, size_t *sz)
+{
+    void *data = NULL;
+    struct stat st;
+
+    int fd = open(file, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+            data = NULL;
+        else
+            *sz = st.st_size;
+    }
+
+    close(fd);
+    return data;
+}
+
+/* the cache of vDOM is keyed by the hash and the size of the contents */
+static bool get_cache_path(const char *file, char *cache, size_t sz)
+{
+    size_t sz_src;
+    void *src = map_file(file, &sz_src);
+    if (src == NULL)
+        return false;
+
+    snprintf(cache, sz, "%s/%016llx-%llu.vdom", vdom_cache_dir,
+            (unsigned long long)hash_contents(src, sz_src),
+            (unsigned long long)sz_src);
+    munmap(src, sz_src);
+    return true;
+}
+
+/* the caches of vDOM mapped by the prefork server for the children */
+struct preloaded_vdom {
+    char *file;
+    off_t size;
+    time_t mtime;
+    void *data;
+    size_t sz;
+};
+
+static struct preloaded_vdom *preloaded;
+static size_t nr_preloaded;
+
+static void preload_vdom_cache(const char *file)
+{
+    struct stat st;
+    char cache[PATH_MAX + 1];
+    if (stat(file, &st) || !get_cache_path(file, cache, sizeof(cache)))
+        return;
+
+    size_t sz;
+    void *data = map_file(cache, &sz);
+    if (data == NULL)
+        return;
+
+    struct preloaded_vdom *p;
+    p = realloc(preloaded, sizeof(*p) * (nr_preloaded + 1));
+    if (p == NULL) {
+        munmap(data, sz);
+        return;
+    }
+    preloaded = p;
+
+    p += nr_preloaded;
+    if ((p->file = strdup(file)) == NULL) {
+        munmap(data, sz);
+        return;
+    }
+    p->size = st.st_size;
+    p->mtime = st.st_mtime;
+    p->data = data;
+    p->sz = sz;
+    nr_preloaded++;
+}
+
+/* returns the cache preloaded if the file does not change since then */
+static const struct preloaded_vdom *find_preloaded(const char *file)
+{
+    struct stat st;
+    for (size_t i = 0; i < nr_preloaded; i++) {
+        const struct preloaded_vdom *p = preloaded + i;
+        if (strcmp(p->file, file) == 0) {
+            if (stat(file, &st) == 0 && st.st_size == p->size &&
+                    st.st_mtime == p->mtime)
+                return p;
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Loads the HVML program from the cache of vDOM; parses the file and saves
+ * the cache if there is no valid cache.
+ */
+static purc_vdom_t load_hvml_from_vdom_cache(const char *file)
+{
+    purc_vdom_t vdom = NULL;
+    size_t sz_cache;
+    char cache[PATH_MAX + 1], tmp[PATH_MAX + 16];
+
+    const struct preloaded_vdom *pre = find_preloaded(file);
+    if (pre && (vdom = purc_load_hvml_from_cache(pre->data, pre->sz)))
+        return vdom;
+
+    if (!get_cache_path(file, cache, sizeof(cache)))
+        return purc_load_hvml_from_file(file);
+
+    void *data = map_file(cache, &sz_cache);
+    if (data) {
+        vdom = purc_load_hvml_from_cache(data, sz_cache);
+        munmap(data, sz_cache);
+        if (vdom)
+            return vdom;
+    }
+
+    vdom = purc_load_hvml_from_file(file);
+    if (vdom == NULL)
+        return NULL;
+
+    /* write to a temporary file first for the concurrent runners */
+    snprintf(tmp, sizeof(tmp), "%s.%d", cache, (int)getpid());
+    purc_rwstream_t out = purc_rwstream_new_from_file(tmp, "w");
+    if (out) {
+        bool ok = purc_vdom_save_cache(vdom, out);
+        purc_rwstream_destroy(out);
+        if (!ok || rename(tmp, cache))
+            unlink(tmp);
+    }
+
+    return vdom;
+}
+
 static purc_vdom_t load_hvml(const char *url)
 {
     struct purc_broken_down_url broken_down;
@@ -663,7 +937,10 @@ static purc_vdom_t load_hvml(const char *url)
 
     purc_vdom_t vdom;
     if (strcasecmp(broken_down.schema, "file") == 0) {
-        vdom = purc_load_hvml_from_file(broken_down.path);
+        if (vdom_cache_dir)
+            vdom = load_hvml_from_vdom_cache(broken_down.path);
+        else
+            vdom = purc_load_hvml_from_file(broken_down.path);
     }
     else {
         vdom = purc_load_hvml_from_url(url);
@@ -1203,6 +1480,533 @@ run_programs_sequentially(struct my_opts *opts, purc_variant_t request)
     return nr_executed > 0;
 }
 
+static bool run_programs(struct my_opts *opts, purc_variant_t request)
+{
+    if (opts->app_info)
+        return run_app(opts);
+    return run_programs_sequentially(opts, request);
+}
+
+struct bench_sample {
+    double wall;            /* in milliseconds */
+    double cpu;             /* in milliseconds, of all threads */
+    long max_rss;           /* in KiB, the peak so far */
+    size_t nr_variants;     /* made by the main runner */
+    size_t nr_msgs;         /* made by the main runner */
+};
+
+static double get_msec(const struct timeval *tv)
+{
+    return tv->tv_sec * 1000.0 + tv->tv_usec / 1000.0;
+}
+
+static void take_snapshot(struct bench_sample *snapshot)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    snapshot->wall = ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    snapshot->cpu = get_msec(&usage.ru_utime) + get_msec(&usage.ru_stime);
+    snapshot->max_rss = usage.ru_maxrss;
+
+    const struct purc_variant_stat *vstat = purc_variant_usage_stat();
+    snapshot->nr_variants = vstat ?
+        vstat->nr_slab_hits + vstat->nr_slab_misses : 0;
+
+    const struct purc_msg_pool_stat *mstat = purc_inst_msg_pool_stat();
+    snapshot->nr_msgs = mstat ? mstat->nr_allocated + mstat->nr_reused : 0;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void print_summary(const char *name, double *values, unsigned int n)
+{
+    double sum = 0;
+    for (unsigned int i = 0; i < n; i++)
+        sum += values[i];
+
+    qsort(values, n, sizeof(double), cmp_double);
+    double median = (n % 2) ? values[n / 2] :
+        (values[n / 2 - 1] + values[n / 2]) / 2;
+
+    fprintf(stdout, "%-8s min %10.3f  median %10.3f  mean %10.3f  "
+            "max %10.3f (ms)\n", name, values[0], median, sum / n,
+            values[n - 1]);
+}
+
+static bool run_benchmark(struct my_opts *opts, purc_variant_t request)
+{
+    unsigned int nr_runs = opts->warmup + opts->bench;
+    double *walls = calloc(opts->bench * 2, sizeof(double));
+    double *cpus = walls + opts->bench;
+    if (walls == NULL)
+        return false;
+
+    bool success = true;
+    fprintf(stdout, "%-8s %12s %12s %12s %12s %12s\n", "run",
+            "wall (ms)", "cpu (ms)", "rss (KiB)", "variants", "messages");
+
+    for (unsigned int i = 0; i < nr_runs; i++) {
+        struct bench_sample before, after;
+
+        take_snapshot(&before);
+        if (!run_programs(opts, request)) {
+            success = false;
+            break;
+        }
+        take_snapshot(&after);
+
+        char name[32];
+        if (i < opts->warmup) {
+            snprintf(name, sizeof(name), "w%u", i);
+        }
+        else {
+            snprintf(name, sizeof(name), "#%u", i - opts->warmup);
+            walls[i - opts->warmup] = after.wall - before.wall;
+            cpus[i - opts->warmup] = after.cpu - before.cpu;
+        }
+
+        fprintf(stdout, "%-8s %12.3f %12.3f %12ld %12zu %12zu\n", name,
+                after.wall - before.wall, after.cpu - before.cpu,
+                after.max_rss, after.nr_variants - before.nr_variants,
+                after.nr_msgs - before.nr_msgs);
+    }
+
+    if (success) {
+        print_summary("wall", walls, opts->bench);
+        print_summary("cpu", cpus, opts->bench);
+    }
+
+    free(walls);
+    return success;
+}
+
+/* the maximal number of the jobs queued for every runner in batch mode */
+#define BATCH_JOBS_PER_RUNNER   8
+#define BATCH_POLL_INTERVAL     1000    /* in microseconds */
+#define BATCH_RUNNER_PREFIX     "batch"
+
+#define LEN_INI_RESULT_BUF      256
+#define LEN_MAX_RESULT_BUF      (1024 * 1024)
+
+struct batch_job {
+    char *name;         /* the file or URL given */
+    char *result;       /* the executed result, or the reason of failure */
+    bool loaded;
+    bool exited;        /* set by the runner */
+    bool done;          /* set by the runner atomically */
+};
+
+static unsigned int nr_batch_done;
+
+static bool add_batch_job(pcutils_array_t *jobs, const char *name)
+{
+    struct batch_job *job = calloc(1, sizeof(*job));
+    if (job == NULL || (job->name = strdup(name)) == NULL) {
+        free(job);
+        return false;
+    }
+
+    pcutils_array_push(jobs, job);
+    return true;
+}
+
+/* reads the files or URLs listed, one per line; `#` starts a comment line */
+static bool read_batch_list(const char *list, pcutils_array_t *jobs)
+{
+    FILE *fp = strcmp(list, "-") ? fopen(list, "r") : stdin;
+    if (fp == NULL)
+        return false;
+
+    bool ok = true;
+    char *line = NULL;
+    size_t sz = 0;
+    ssize_t len;
+    while (ok && (len = getline(&line, &sz, fp)) >= 0) {
+        while (len > 0 && isspace((unsigned char)line[len - 1]))
+            len--;
+        line[len] = 0;
+
+        const char *p = line;
+        while (isspace((unsigned char)*p))
+            p++;
+        if (*p == 0 || *p == '#')
+            continue;
+
+        ok = add_batch_job(jobs, p);
+    }
+
+    free(line);
+    if (fp != stdin)
+        fclose(fp);
+    return ok;
+}
+
+/* serializes the result in one line, so that it can be parsed easily */
+static char *serialize_result(purc_variant_t result)
+{
+    if (result == PURC_VARIANT_INVALID)
+        return strdup("<INVALID VALUE>");
+
+    purc_rwstream_t stm = purc_rwstream_new_buffer(LEN_INI_RESULT_BUF,
+            LEN_MAX_RESULT_BUF);
+    if (stm == NULL)
+        return NULL;
+
+    char *buf = NULL;
+    if (purc_variant_serialize(result, stm, 0,
+                PCVARIANT_SERIALIZE_OPT_PLAIN |
+                PCVARIANT_SERIALIZE_OPT_NOSLASHESCAPE, NULL) >= 0 &&
+            purc_rwstream_write(stm, "", 1) == 1) {
+        size_t sz_content, sz_buffer;
+        buf = purc_rwstream_get_mem_buffer_ex(stm,
+                &sz_content, &sz_buffer, true);
+    }
+
+    purc_rwstream_destroy(stm);
+    return buf;
+}
+
+/* called in the threads of the runners of the pool */
+static int batch_cond_handler(purc_cond_t event, purc_coroutine_t cor,
+        void *data)
+{
+    if (event == PURC_COND_COR_EXITED) {
+        /* the child coroutines have no user data */
+        struct batch_job *job = purc_coroutine_get_user_data(cor);
+        if (job) {
+            struct purc_cor_exit_info *exit_info = data;
+            job->result = serialize_result(exit_info->result);
+            job->exited = true;
+        }
+    }
+    else if (event == PURC_COND_COR_DESTROYED) {
+        struct batch_job *job = data;
+        if (job) {
+            __atomic_store_n(&job->done, true, __ATOMIC_RELEASE);
+            __atomic_add_fetch(&nr_batch_done, 1, __ATOMIC_RELEASE);
+        }
+    }
+
+    return 0;
+}
+
+static purc_vdom_t load_batch_job(struct my_opts *opts,
+        struct batch_job *job, const char **body_id)
+{
+    size_t idx = opts->urls->length;
+    if (!validate_url(opts, job->name)) {
+        job->result = strdup("Bad file or URL");
+        return NULL;
+    }
+
+    purc_vdom_t vdom = load_hvml(opts->urls->list[idx]);
+    if (vdom == NULL) {
+        job->result = strdup(purc_get_error_message(purc_get_last_error()));
+        return NULL;
+    }
+
+    *body_id = opts->body_ids->list[idx];
+    return vdom;
+}
+
+/* prints the results of the jobs done in order; returns the next to print */
+static size_t print_batch_results(pcutils_array_t *jobs, size_t from,
+        size_t to, size_t *nr_failed)
+{
+    for (; from < to; from++) {
+        struct batch_job *job = jobs->list[from];
+        if (!__atomic_load_n(&job->done, __ATOMIC_ACQUIRE))
+            break;
+
+        const char *status;
+        if (!job->loaded)
+            status = "failed";
+        else if (job->exited)
+            status = "exited";
+        else
+            status = "terminated";
+
+        if (!job->exited)
+            (*nr_failed)++;
+
+        fprintf(stdout, "%s\t%s\t%s\n", status, job->name,
+                job->result ? job->result : "");
+    }
+
+    fflush(stdout);
+    return from;
+}
+
+/*
+ * Runs the programs in the runners of a pool in this process, so the
+ * modules, the data fetcher, and the vDOM cache are set up only once.
+ * The vDOMs are loaded in the main runner, and only a few jobs are queued
+ * for every runner at the same time. The results are printed in the given
+ * order, one line per program: the status (`exited`, `terminated`, or
+ * `failed`), the file or URL, and the executed result or the reason.
+ */
+static bool run_batch(struct my_opts *opts, purc_variant_t request,
+        const purc_instance_extra_info *extra_info)
+{
+    pcutils_array_t *jobs = pcutils_array_create();
+    pcutils_array_init(jobs, 16);
+
+    bool success = true;
+    size_t nr_cmdline = opts->urls->length;
+    for (size_t i = 0; success && i < nr_cmdline; i++) {
+        success = add_batch_job(jobs, opts->urls->list[i]);
+    }
+
+    if (success && !read_batch_list(opts->batch, jobs)) {
+        fprintf(stderr, "Failed to read the programs listed in %s\n",
+                opts->batch);
+        success = false;
+    }
+
+    purc_runner_pool_t pool = NULL;
+    if (success) {
+        pool = purc_runner_pool_create(opts->app ? opts->app : DEF_APP_NAME,
+                BATCH_RUNNER_PREFIX, opts->nr_runners,
+                (purc_cond_handler)batch_cond_handler, extra_info);
+        if (pool == NULL) {
+            fprintf(stderr, "Failed to create the runners: %s\n",
+                    purc_get_error_message(purc_get_last_error()));
+            success = false;
+        }
+    }
+
+    if (pool) {
+        size_t nr_workers = purc_runner_pool_nr_workers(pool);
+        size_t max_pending = nr_workers * BATCH_JOBS_PER_RUNNER;
+        size_t nr_scheduled = 0, nr_printed = 0, nr_failed = 0;
+
+        nr_batch_done = 0;
+        for (size_t i = 0; i < jobs->length; i++) {
+            struct batch_job *job = jobs->list[i];
+
+            const char *body_id = NULL;
+            purc_vdom_t vdom = load_batch_job(opts, job, &body_id);
+            if (vdom == NULL) {
+                job->done = true;
+                continue;
+            }
+
+            while (nr_scheduled - __atomic_load_n(&nr_batch_done,
+                        __ATOMIC_ACQUIRE) >= max_pending) {
+                nr_printed = print_batch_results(jobs, nr_printed, i,
+                        &nr_failed);
+                usleep(BATCH_POLL_INTERVAL);
+            }
+
+            /* set before scheduling, for the runner may pick it up at once */
+            job->loaded = true;
+            if (purc_runner_pool_schedule_vdom_ex(pool, vdom, request,
+                        body_id, job)) {
+                job->loaded = false;
+                job->result = strdup(
+                        purc_get_error_message(purc_get_last_error()));
+                job->done = true;
+                continue;
+            }
+
+            nr_scheduled++;
+        }
+
+        while ((nr_printed = print_batch_results(jobs, nr_printed,
+                        jobs->length, &nr_failed)) < jobs->length) {
+            usleep(BATCH_POLL_INTERVAL);
+        }
+
+        if (opts->verbose)
+            fprintf(stderr, "%u program(s) executed by %u runner(s), "
+                    "%u failed\n", (unsigned)jobs->length,
+                    (unsigned)nr_workers, (unsigned)nr_failed);
+
+        if (nr_failed > 0)
+            success = false;
+
+        /* wait for the runners to quit before cleaning up the instance */
+        purc_atom_t *rids = calloc(nr_workers, sizeof(rids[0]));
+        for (size_t i = 0; rids && i < nr_workers; i++) {
+            struct purc_runner_pool_stat stat;
+            if (purc_runner_pool_get_stat(pool, i, &stat) == 0)
+                rids[i] = stat.rid;
+        }
+
+        purc_runner_pool_destroy(pool);
+
+        for (size_t i = 0; rids && i < nr_workers; i++) {
+            while (rids[i] && purc_atom_to_string(rids[i]))
+                usleep(BATCH_POLL_INTERVAL);
+        }
+        free(rids);
+    }
+
+    for (size_t i = 0; i < jobs->length; i++) {
+        struct batch_job *job = jobs->list[i];
+        free(job->name);
+        free(job->result);
+        free(job);
+    }
+    pcutils_array_destroy(jobs, true);
+
+    return success;
+}
+
+static volatile sig_atomic_t prefork_quit;
+
+static void on_quit_signal(int sig)
+{
+    (void)sig;
+    prefork_quit = 1;
+}
+
+/* reads a line of the request; returns false if there is no valid one */
+static bool read_job(int fd, char *buf, size_t sz)
+{
+    size_t len = 0;
+    while (len < sz - 1) {
+        ssize_t n = read(fd, buf + len, 1);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0 || buf[len] == '\n')
+            break;
+        len++;
+    }
+
+    while (len > 0 && (buf[len - 1] == '\r' || buf[len - 1] == ' '))
+        len--;
+    buf[len] = 0;
+    return len > 0;
+}
+
+/* the program of the job replaces the ones given in the command line */
+static bool take_job(struct my_opts *opts, const char *url)
+{
+    for (size_t i = 0; i < opts->urls->length; i++) {
+        free(opts->urls->list[i]);
+        free(opts->body_ids->list[i]);
+    }
+    opts->urls->length = 0;
+    opts->body_ids->length = 0;
+
+    return validate_url(opts, url);
+}
+
+/*
+ * Runs the prefork server: the modules are initialized once with no
+ * instance (and no thread) in the server, so a child forked for a job
+ * shares the tables made, and only initializes its own instance.
+ *
+ * Returns 0 in the child for the job, 1 if the server quits, or -1 if
+ * the server fails to start.
+ */
+static int serve_prefork(struct my_opts *opts)
+{
+    if (opts->app_info) {
+        fprintf(stderr, "Can not serve an app description in prefork mode\n");
+        return -1;
+    }
+
+    int ret = purc_init_once();
+    if (ret != PURC_ERROR_OK) {
+        fprintf(stderr, "Failed to initialize the PurC modules: %s\n",
+                purc_get_error_message(ret));
+        return -1;
+    }
+
+    if (vdom_cache_dir) {
+        for (size_t i = 0; i < opts->urls->length; i++) {
+            const char *url = opts->urls->list[i];
+            if (strncasecmp(url, "file://", 7) == 0)
+                preload_vdom_cache(url + 7);
+        }
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, opts->prefork);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    unlink(opts->prefork);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) ||
+            listen(fd, 64)) {
+        perror(opts->prefork);
+        close(fd);
+        return -1;
+    }
+
+    /* the children are reaped by the system */
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = SIG_IGN;
+    sigaction(SIGCHLD, &sa, NULL);
+
+    /* no SA_RESTART, so that accept() is interrupted */
+    sa.sa_handler = on_quit_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    if (opts->verbose)
+        fprintf(stdout, "Serving on %s (%u vDOM caches preloaded)...\n",
+                opts->prefork, (unsigned)nr_preloaded);
+
+    while (!prefork_quit) {
+        int conn = accept(fd, NULL, NULL);
+        if (conn < 0)
+            continue;
+
+        char url[PATH_MAX + 1];
+        if (!read_job(conn, url, sizeof(url))) {
+            close(conn);
+            continue;
+        }
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            sa.sa_handler = SIG_DFL;
+            sigaction(SIGCHLD, &sa, NULL);
+            sigaction(SIGINT, &sa, NULL);
+            sigaction(SIGTERM, &sa, NULL);
+            close(fd);
+
+            dup2(conn, STDOUT_FILENO);
+            dup2(conn, STDERR_FILENO);
+            close(conn);
+
+            if (!take_job(opts, url)) {
+                fprintf(stdout, "Got a bad file or URL: %s\n", url);
+                exit(EXIT_FAILURE);
+            }
+            return 0;
+        }
+
+        if (pid < 0) {
+            const char *msg = "Failed to fork a child for the job\n";
+            ssize_t n = write(conn, msg, strlen(msg));
+            (void)n;
+        }
+        close(conn);
+    }
+
+    close(fd);
+    unlink(opts->prefork);
+    return 1;
+}
+
 int main(int argc, char** argv)
 {
     int ret;
@@ -1213,9 +2017,19 @@ int main(int argc, char** argv)
         my_opts_delete(opts, true);
         return EXIT_FAILURE;
     }
+    vdom_cache_dir = opts->vdom_cache;
+
+    if (opts->batch && (opts->app_info || opts->parallel || opts->bench ||
+                opts->prefork || (opts->request && strcmp(opts->batch, "-") == 0
+                    && strcmp(opts->request, "-") == 0))) {
+        fprintf(stderr, "Can not use `--batch` with an app description, "
+                "`--parallel`, `--bench`, `--prefork`, or both from stdin\n");
+        my_opts_delete(opts, true);
+        return EXIT_FAILURE;
+    }
 
-    if (opts->app_info == NULL &&
-            (opts->urls == NULL || opts->urls->length == 0)) {
+    if (opts->app_info == NULL && opts->prefork == NULL &&
+            opts->batch == NULL && (opts->urls == NULL || opts->urls->length == 0)) {
         if (opts->verbose) {
             fprintf(stdout, "No valid HVML program specified\n");
             print_usage(stdout);
@@ -1274,6 +2088,16 @@ int main(int argc, char** argv)
 
     extra_info.renderer_uri = opts->rdr_uri;
 
+    if (opts->prefork) {
+        ret = serve_prefork(opts);
+        if (ret) {
+            my_opts_delete(opts, true);
+            return ret > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
+        /* continues in the child forked for the job */
+    }
+
     ret = purc_init_ex(modules, opts->app ? opts->app : DEF_APP_NAME,
             opts->run ? opts->run : DEF_RUN_NAME, &extra_info);
     if (ret != PURC_ERROR_OK) {
@@ -1304,7 +2128,14 @@ int main(int argc, char** argv)
         }
     }
 
-    if (opts->app_info) {
+    if (opts->batch) {
+        if (!run_batch(opts, request, &extra_info)) {
+            success = false;
+        }
+
+        my_opts_delete(opts, true);
+    }
+    else if (opts->app_info) {
         transfer_opts_to_variant(opts, request);
         if (!evalute_app_info(opts->app_info)) {
             if (opts->verbose)
@@ -1314,7 +2145,8 @@ int main(int argc, char** argv)
             goto failed;
         }
 
-        if (!run_app(opts)) {
+        if (!(opts->bench ? run_benchmark(opts, request) :
+                    run_programs(opts, request))) {
             success = false;
         }
 
@@ -1323,7 +2155,8 @@ int main(int argc, char** argv)
     else {
         assert(!opts->parallel);
 
-        if (!run_programs_sequentially(opts, request)) {
+        if (!(opts->bench ? run_benchmark(opts, request) :
+                    run_programs(opts, request))) {
             success = false;
         }
 
@@ -96,6 +96,13 @@ public:
 #if USE(GLIB_EVENT_LOOP)
     WTF_EXPORT_PRIVATE GMainContext* mainContext() const { return m_mainContext.get(); }
     WTF_EXPORT_PRIVATE void setIdleCallback(PurCWTF::Function<void()>&& function);
+    // Stop calling the idle callback until the timeout elapses or any source
+    // of the run loop (dispatch, timer, fd monitor, wakeUp) has been fired.
+    // A negative timeout parks the idle callback until the next wake-up.
+    // It takes no effect if a wake-up happened since the idle callback
+    // was called last time.
+    WTF_EXPORT_PRIVATE void parkIdleCallback(Seconds timeout);
+    WTF_EXPORT_PRIVATE void wakeUpIdleCallback();
     WTF_EXPORT_PRIVATE uintptr_t addFdMonitor(gint fd, GIOCondition condition,
             Function<gboolean(gint, GIOCondition)>&& callback);
     WTF_EXPORT_PRIVATE void removeFdMonitor(uintptr_t handle);
@@ -240,6 +247,12 @@ private:
     GRefPtr<GSource> m_idleSource;
     Function<void()> m_idleCallback;
 
+    // Protect the ready time of the idle source against the wake-ups
+    // happened while the idle callback is running.
+    Lock m_idleLock;
+    uint64_t m_idleWakeUps { 0 };
+    uint64_t m_idleTicket { 0 };
+
     Vector<RefPtr<GFdMonitor>> m_fdMonitors;
 #elif USE(GENERIC_EVENT_LOOP)
     void schedule(Ref<TimerBase::ScheduledTask>&&);
@@ -50,6 +50,23 @@ static GSourceFuncs runLoopSourceFunctions = {
     nullptr, // closure_marshall
 };
 
+// The idle source keeps being dispatched on every iteration while its ready
+// time is reached; parking it only means moving the ready time forward.
+static GSourceFuncs runLoopIdleSourceFunctions = {
+    nullptr, // prepare
+    nullptr, // check
+    // dispatch
+    [](GSource* source, GSourceFunc callback, gpointer userData) -> gboolean
+    {
+        if (g_source_get_ready_time(source) == -1)
+            return G_SOURCE_CONTINUE;
+        return callback(userData);
+    },
+    nullptr, // finalize
+    nullptr, // closure_callback
+    nullptr, // closure_marshall
+};
+
 RunLoop::RunLoop()
 {
     m_mainContext = g_main_context_get_thread_default();
@@ -71,12 +88,17 @@ RunLoop::RunLoop()
     }, this, nullptr);
     g_source_attach(m_source.get(), m_mainContext.get());
 
-    m_idleSource = adoptGRef(g_idle_source_new());
+    m_idleSource = adoptGRef(g_source_new(&runLoopIdleSourceFunctions, sizeof(GSource)));
+    g_source_set_ready_time(m_idleSource.get(), 0);
     g_source_set_priority(m_idleSource.get(), RunLoopSourcePriority::RunLoopDispatcher);
     g_source_set_name(m_idleSource.get(), "[PurCFetcher] RunLoop idle");
     g_source_set_can_recurse(m_idleSource.get(), TRUE);
     g_source_set_callback(m_idleSource.get(), [](gpointer userData) -> gboolean {
         RunLoop* runloop = static_cast<RunLoop*>(userData);
+        {
+            auto locker = holdLock(runloop->m_idleLock);
+            runloop->m_idleTicket = runloop->m_idleWakeUps;
+        }
         if (runloop->m_idleCallback) {
             runloop->m_idleCallback();
         }
@@ -105,11 +127,39 @@ void RunLoop::setIdleCallback(PurCWTF::Function<void()>&& function)
     }
 }
 
+void RunLoop::parkIdleCallback(Seconds timeout)
+{
+    auto locker = holdLock(m_idleLock);
+    if (m_idleWakeUps != m_idleTicket)
+        return;
+
+    if (timeout < 0_s) {
+        g_source_set_ready_time(m_idleSource.get(), -1);
+        return;
+    }
+
+    gint64 currentTime = g_get_monotonic_time();
+    gint64 targetTime = currentTime + std::min<gint64>(G_MAXINT64 - currentTime, timeout.microsecondsAs<gint64>());
+    g_source_set_ready_time(m_idleSource.get(), targetTime);
+}
+
+void RunLoop::wakeUpIdleCallback()
+{
+    auto locker = holdLock(m_idleLock);
+    m_idleWakeUps++;
+    g_source_set_ready_time(m_idleSource.get(), 0);
+}
+
 uintptr_t RunLoop::addFdMonitor(gint fd, GIOCondition condition,
             Function<gboolean(gint, GIOCondition)>&& callback)
 {
     RefPtr<GFdMonitor> monitor = adoptRef(new GFdMonitor());
-    monitor->start(fd, condition, mainContext(), WTFMove(callback));
+    monitor->start(fd, condition, mainContext(),
+            [this, callback = WTFMove(callback)] (gint fd, GIOCondition condition) -> gboolean {
+                gboolean ret = callback(fd, condition);
+                wakeUpIdleCallback();
+                return ret;
+            });
     m_fdMonitors.append(monitor);
     return (uintptr_t)monitor.get();
 }
@@ -165,6 +215,7 @@ void RunLoop::stop()
 void RunLoop::wakeUp()
 {
     g_source_set_ready_time(m_source.get(), 0);
+    wakeUpIdleCallback();
 }
 
 RunLoop::CycleResult RunLoop::cycle(RunLoopMode)
@@ -197,7 +248,11 @@ void RunLoop::dispatchAfter(Seconds duration, Function<void()>&& function)
     g_source_set_name(source.get(), "[PurCFetcher] RunLoop dispatchAfter");
     g_source_set_ready_time(source.get(), g_get_monotonic_time() + duration.microsecondsAs<gint64>());
 
-    std::unique_ptr<DispatchAfterContext> context = makeUnique<DispatchAfterContext>(WTFMove(function));
+    std::unique_ptr<DispatchAfterContext> context = makeUnique<DispatchAfterContext>(
+            [this, function = WTFMove(function)] {
+                function();
+                wakeUpIdleCallback();
+            });
     g_source_set_callback(source.get(), [](gpointer userData) -> gboolean {
         std::unique_ptr<DispatchAfterContext> context(static_cast<DispatchAfterContext*>(userData));
         context->dispatch();
@@ -218,7 +273,9 @@ RunLoop::TimerBase::TimerBase(RunLoop& runLoop)
         // before it is safe to dereference timer again.
         RunLoop::TimerBase* timer = static_cast<RunLoop::TimerBase*>(userData);
         GSource* source = timer->m_source.get();
+        RunLoop& runLoop = timer->m_runLoop.get();
         timer->fired();
+        runLoop.wakeUpIdleCallback();
         if (g_source_is_destroyed(source))
             return G_SOURCE_REMOVE;
         if (timer->m_isRepeating)
@@ -65,6 +65,12 @@ else ()
     SET_AND_EXPOSE_TO_BUILD(HAVE_HIBUS ON)
 endif ()
 
+if (NOT ZLIB_FOUND)
+    SET_AND_EXPOSE_TO_BUILD(HAVE_ZLIB OFF)
+else ()
+    SET_AND_EXPOSE_TO_BUILD(HAVE_ZLIB ON)
+endif ()
+
 if (NOT OPENSSL_FOUND)
     set(ENABLE_SSL_DEFAULT OFF)
     SET_AND_EXPOSE_TO_BUILD(HAVE_OPENSSL OFF)
@@ -95,6 +95,9 @@ macro(PURC_OPTION_BEGIN)
     PURC_OPTION_DEFINE(ENABLE_SSL "Toggle support for SSL" PUBLIC OFF)
     PURC_OPTION_DEFINE(ENABLE_API_TESTS "Enable public API unit tests" PUBLIC ON)
     PURC_OPTION_DEFINE(ENABLE_DEVELOPER_MODE "Toggle developer mode" PUBLIC OFF)
+    PURC_OPTION_DEFINE(ENABLE_TRACE "Toggle the tracing of VCM, HVML and eJSON parsers" PUBLIC ON)
+    PURC_OPTION_DEFINE(ENABLE_VCM_PROFILE "Toggle the profiler of VCM evaluation" PUBLIC ON)
+    PURC_OPTION_DEFINE(ENABLE_BENCHMARKS "Toggle the benchmarks in the test directories and the counting of allocations" PUBLIC OFF)
 
     PURC_OPTION_DEFINE(USE_SYSTEM_MALLOC "Toggle system allocator instead of PurC's custom allocator" PRIVATE ${USE_SYSTEM_MALLOC_DEFAULT})
     PURC_OPTION_DEFINE(ENABLE_ICU "Enable icu" PUBLIC OFF)
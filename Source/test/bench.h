@@ -0,0 +1,245 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * The timing harness shared by the benchmarks of the test directories
+ * (bench_variant, bench_ejson, bench_html, bench_dvobjs, bench_executors,
+ * and bench_interpreter), which are built if ENABLE_BENCHMARKS is on.
+ *
+ * An operation is run until it takes MIN_BENCH_TIME_NS, and the variants
+ * and the messages allocated meanwhile are counted by the counter of the
+ * instance (see pcinst_count_alloc()). An operation measured in several
+ * threads at once runs in an instance of each thread, and the costs are
+ * the averages of all the threads. Every benchmark writes a document like
+ * the following one, so the results of the releases can be compared by
+ * the operation, the size, and the number of the threads:
+ *
+ *  {
+ *    "benchmark": "bench_variant",
+ *    "purc_version": "0.8.1",
+ *    "date": "2026-10-15T10:00:00+0800",
+ *    "results": [
+ *      { "operation": "array/append", "size": 1000, "threads": 1,
+ *        "iterations": 2950, "ns_per_op": 6780.1, "bytes_per_op": 32000.0,
+ *        "allocs_per_op": 1000.0 },
+ *      ...
+ *    ]
+ *  }
+ *
+ * Environment variables:
+ *
+ *  - PURC_BENCH_SIZES: the sizes passed to the operations, separated by
+ *    commas; the default is given by the benchmark, e.g. `10,1000`.
+ *  - PURC_BENCH_THREADS: the numbers of the threads for the benchmarks
+ *    measuring the operations in several threads, separated by commas;
+ *    the default is given by the benchmark, e.g. `1,2`.
+ *  - PURC_BENCH_OUTPUT: the directory to write the results to, as
+ *    `<benchmark>.json`; the results are only printed if it is not set.
+ */
+
+#pragma once
+
+#include "purc.h"
+
+#include "private/instance.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+#define MIN_BENCH_TIME_NS       2.0e7
+#define MAX_BENCH_ITERATIONS    10000
+
+struct bench_result {
+    std::string         operation;
+    size_t              size;
+    size_t              threads;
+    size_t              iterations;
+    double              ns_per_op;
+    double              bytes_per_op;
+    double              allocs_per_op;
+};
+
+/* the cost of the runs of an operation in a thread */
+struct bench_stats {
+    size_t                      iterations;
+    double                      elapsed;
+    struct pcinst_alloc_counter counter;
+};
+
+class BenchRunner
+{
+public:
+    BenchRunner(const char *name) : name(name) {}
+
+    /* the sizes from PURC_BENCH_SIZES, or @def_sizes */
+    static std::vector<size_t> get_sizes(const char *def_sizes) {
+        return get_numbers("PURC_BENCH_SIZES", def_sizes);
+    }
+
+    /* the numbers of the threads from PURC_BENCH_THREADS, or @def_threads */
+    static std::vector<size_t> get_threads(const char *def_threads) {
+        return get_numbers("PURC_BENCH_THREADS", def_threads);
+    }
+
+    /* runs @op (returning false on failure) repeatedly in the current
+       instance, and fills @stats with the cost of all the runs */
+    template <typename Op>
+    static bool measure(Op op, struct bench_stats *stats) {
+        *stats = { 0, 0, { 0, 0 } };
+        struct pcinst_alloc_counter *old =
+            pcinst_set_alloc_counter(&stats->counter);
+
+        double started = clock_ns();
+        bool ok = true;
+        while (stats->elapsed < MIN_BENCH_TIME_NS &&
+                stats->iterations < MAX_BENCH_ITERATIONS) {
+            if (!op()) {
+                ok = false;
+                break;
+            }
+            stats->iterations++;
+            stats->elapsed = clock_ns() - started;
+        }
+
+        pcinst_set_alloc_counter(old);
+        return ok;
+    }
+
+    /* runs @op repeatedly in the current instance, and records the cost
+       of one run */
+    template <typename Op>
+    bool run(const char *operation, size_t size, Op op) {
+        struct bench_stats stats;
+        bool ok = measure(op, &stats);
+        return record(operation, size, 1, ok ? &stats : NULL);
+    }
+
+    /* records the cost of one run from the stats of the @nr_threads
+       threads measuring the operation at once; @stats is NULL if any of
+       the threads failed */
+    bool record(const char *operation, size_t size, size_t nr_threads,
+            const struct bench_stats *stats) {
+        char name[128];
+        snprintf(name, sizeof(name), "%s/%zu/threads:%zu", operation, size,
+                nr_threads);
+
+        size_t iterations = 0;
+        double elapsed = 0, nr_allocs = 0, sz_allocs = 0;
+        for (size_t i = 0; stats && i < nr_threads; i++) {
+            iterations += stats[i].iterations;
+            elapsed += stats[i].elapsed;
+            nr_allocs += stats[i].counter.nr_allocs;
+            sz_allocs += stats[i].counter.sz_allocs;
+        }
+
+        if (iterations == 0) {
+            fprintf(stderr, "%-40s FAILED\n", name);
+            return false;
+        }
+
+        bench_result r;
+        r.operation = operation;
+        r.size = size;
+        r.threads = nr_threads;
+        r.iterations = iterations;
+        r.ns_per_op = elapsed / iterations;
+        r.bytes_per_op = sz_allocs / iterations;
+        r.allocs_per_op = nr_allocs / iterations;
+        results.push_back(r);
+
+        fprintf(stderr, "%-40s %8zu %14.1f ns %12.1f B %10.1f allocs\n",
+                name, iterations, r.ns_per_op, r.bytes_per_op,
+                r.allocs_per_op);
+        return true;
+    }
+
+    /* writes the results to PURC_BENCH_OUTPUT if it is set */
+    bool write_results(void) {
+        const char *dir = getenv("PURC_BENCH_OUTPUT");
+        if (dir == NULL)
+            return true;
+
+        std::string file = std::string(dir) + "/" + name + ".json";
+        FILE *fp = fopen(file.c_str(), "w");
+        if (!fp)
+            return false;
+
+        char date[64];
+        time_t t = time(NULL);
+        strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime(&t));
+
+        fprintf(fp, "{\n  \"benchmark\": \"%s\",\n", name.c_str());
+        fprintf(fp, "  \"purc_version\": \"%s\",\n",
+                purc_get_version_string());
+        fprintf(fp, "  \"date\": \"%s\",\n", date);
+        fprintf(fp, "  \"results\": [");
+
+        for (size_t i = 0; i < results.size(); i++) {
+            const bench_result &r = results[i];
+            fprintf(fp, "%s\n    { \"operation\": \"%s\", \"size\": %zu, "
+                    "\"threads\": %zu,\n      \"iterations\": %zu, "
+                    "\"ns_per_op\": %.3f, \"bytes_per_op\": %.3f, "
+                    "\"allocs_per_op\": %.3f }",
+                    i ? "," : "", r.operation.c_str(), r.size, r.threads,
+                    r.iterations, r.ns_per_op, r.bytes_per_op,
+                    r.allocs_per_op);
+        }
+
+        fprintf(fp, "\n  ]\n}\n");
+        return fclose(fp) == 0;
+    }
+
+private:
+    static double clock_ns(void) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1.0e9 + ts.tv_nsec;
+    }
+
+    /* the positive numbers separated by commas in @env_name, or in
+       @def_value if it is not set */
+    static std::vector<size_t> get_numbers(const char *env_name,
+            const char *def_value) {
+        const char *env = getenv(env_name);
+        std::string numbers = env ? env : def_value;
+        std::vector<size_t> ret;
+
+        size_t pos = 0;
+        while (pos < numbers.size()) {
+            size_t end = numbers.find(',', pos);
+            if (end == std::string::npos)
+                end = numbers.size();
+
+            unsigned long n = strtoul(numbers.substr(pos, end - pos).c_str(),
+                    NULL, 10);
+            if (n > 0)
+                ret.push_back(n);
+            pos = end + 1;
+        }
+
+        return ret;
+    }
+
+    std::string                 name;
+    std::vector<bench_result>   results;
+};
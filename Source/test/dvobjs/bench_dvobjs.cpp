@@ -0,0 +1,117 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * The benchmarks of the methods of the dynamic variant objects; see
+ * bench.h for the results. The size is the number of the rows in `$DATA`
+ * passed to the methods.
+ */
+
+#include "purc.h"
+
+#include "../helpers.h"
+#include "../bench.h"
+
+#include <gtest/gtest.h>
+
+#define DEF_BENCH_SIZES         "10,1000"
+
+struct bench_vars {
+    purc_variant_t      ejson;
+    purc_variant_t      data;
+};
+
+static purc_variant_t
+get_var(void *ctxt, const char *name)
+{
+    struct bench_vars *vars = (struct bench_vars *)ctxt;
+    if (strcmp(name, "EJSON") == 0)
+        return vars->ejson;
+    if (strcmp(name, "DATA") == 0)
+        return vars->data;
+    return PURC_VARIANT_INVALID;
+}
+
+static purc_variant_t
+make_rows(size_t size)
+{
+    std::string json = "[";
+    for (size_t i = 0; i < size; i++) {
+        if (i)
+            json += ",";
+        json += "{\"id\":" + std::to_string(size - i) +
+            ",\"name\":\"row" + std::to_string(i) + "\"}";
+    }
+    json += "]";
+    return purc_variant_make_from_json_string(json.c_str(), json.size());
+}
+
+static const struct {
+    const char     *operation;
+    const char     *ejson;
+} bench_calls[] = {
+    { "ejson/count",        "$EJSON.count($DATA)" },
+    { "ejson/stringify",    "$EJSON.stringify($DATA)" },
+    { "ejson/serialize",    "$EJSON.serialize($DATA)" },
+    { "ejson/md5",          "$EJSON.md5($DATA)" },
+    { "ejson/isequal",      "$EJSON.isequal($DATA, $DATA)" },
+};
+
+TEST(bench_dvobjs, methods)
+{
+    PurCInstance purc(false);
+    ASSERT_TRUE(purc);
+
+    struct bench_vars vars;
+    vars.ejson = purc_dvobj_ejson_new();
+    ASSERT_NE(vars.ejson, nullptr);
+
+    BenchRunner bench("bench_dvobjs");
+    std::vector<size_t> sizes = BenchRunner::get_sizes(DEF_BENCH_SIZES);
+    ASSERT_FALSE(sizes.empty());
+
+    for (size_t size : sizes) {
+        vars.data = make_rows(size);
+        ASSERT_NE(vars.data, nullptr);
+
+        for (const auto &c : bench_calls) {
+            struct purc_ejson_parse_tree *ptree;
+            ptree = purc_variant_ejson_parse_string(c.ejson,
+                    strlen(c.ejson));
+            ASSERT_NE(ptree, nullptr) << c.ejson;
+
+            EXPECT_TRUE(bench.run(c.operation, size, [ptree, &vars]() {
+                purc_variant_t v = purc_variant_ejson_parse_tree_evalute(
+                        ptree, get_var, &vars, false);
+                if (v == PURC_VARIANT_INVALID)
+                    return false;
+                purc_variant_unref(v);
+                return true;
+            })) << c.ejson;
+
+            purc_variant_ejson_parse_tree_destroy(ptree);
+        }
+
+        purc_variant_unref(vars.data);
+    }
+
+    purc_variant_unref(vars.ejson);
+    ASSERT_TRUE(bench.write_results());
+}
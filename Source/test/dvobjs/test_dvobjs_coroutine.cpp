@@ -44,7 +44,7 @@ extern void get_variant_total_info (size_t *mem, size_t *value, size_t *resv);
 TEST(dvobjs, dvobjs_hvml_setter)
 {
     const char *function[] = {"base", "max_iteration_count", "max_recursion_depth",
-                              "timeout"};
+                              "timeout", "slice_steps", "slice_time"};
     purc_variant_t param[MAX_PARAM_NR] = {0};
     purc_variant_t ret_var = PURC_VARIANT_INVALID;
     purc_variant_t ret_result = PURC_VARIANT_INVALID;
@@ -22,6 +22,7 @@
 #include "purc-ports.h"
 
 #include "config.h"
+#include "private/dvobjs.h"
 #include "../helpers.h"
 
 #include <stdio.h>
@@ -819,3 +820,126 @@ TEST(dvobjs, broken_down_time)
     purc_cleanup();
 }
 
+/* the formats compiled and cached give the same results in the direct ways
+   as strftime() does */
+TEST(dvobjs, fmttime_compiled)
+{
+    static const struct {
+        const char *ejson;
+        const char *expected;
+    } test_cases[] = {
+        { "$DATETIME.fmttime('%Y-%m-%dT%H:%M:%S.{m}{%z:}', 1124121121.5, 'UTC')",
+            "2005-08-15T15:52:01.500+00:00" },
+        { "$DATETIME.fmttime('%a, %d %b %Y %H:%M:%S %z', 1124121121, 'UTC')",
+            "Mon, 15 Aug 2005 15:52:01 +0000" },
+        { "$DATETIME.fmttime('%H:%M {%z:} %Z', 1124121121, 'Asia/Kolkata')",
+            "21:22 +05:30 IST" },
+        { "$DATETIME.fmttime('%j%%%n%y', 1124121121, 'UTC')",
+            "227%\n05" },
+        /* interpreted by strftime() as a whole */
+        { "$DATETIME.fmttime('{x} %-d/%e', 1124121121, 'UTC')",
+            "{x} 15/15" },
+        { "$DATETIME.fmttime('%Y', -62135596800, 'UTC')",
+            "1" },
+    };
+
+    int ret = purc_init_ex(PURC_MODULE_EJSON, "cn.fmsfot.hvml.test",
+            "dvobjs", NULL);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    setlocale(LC_TIME, "C");
+
+    purc_variant_t dvobj = purc_dvobj_datetime_new();
+    ASSERT_NE(dvobj, nullptr);
+
+    /* the second round uses the formats cached */
+    for (int round = 0; round < 2; round++) {
+        for (size_t i = 0; i < PCA_TABLESIZE(test_cases); i++) {
+            purc_variant_t result = eval(test_cases[i].ejson, dvobj);
+            ASSERT_NE(result, nullptr);
+
+            const char *str = purc_variant_get_string_const(result);
+            ASSERT_NE(str, nullptr);
+            ASSERT_STREQ(str, test_cases[i].expected);
+            purc_variant_unref(result);
+        }
+    }
+
+    purc_variant_unref(dvobj);
+    purc_cleanup();
+}
+
+/* the conversions with the cached timezone data agree with the C library */
+TEST(dvobjs, tzinfo)
+{
+    static const char *zones[] = {
+        "America/New_York",
+        "Europe/Berlin",
+        "Australia/Sydney",
+        "Asia/Shanghai",
+        "America/Sao_Paulo",
+        "Asia/Kolkata",
+    };
+
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_EJSON, "cn.fmsfot.hvml.test",
+            "dvobjs", &info);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    ASSERT_EQ(pcdvobjs_tzinfo_get("Not/A_Zone"), nullptr);
+
+    char *tz_old = NULL;
+    const char *env = getenv("TZ");
+    if (env)
+        tz_old = strdup(env);
+
+    for (size_t i = 0; i < PCA_TABLESIZE(zones); i++) {
+        const struct pcdvobjs_tzinfo *tz = pcdvobjs_tzinfo_get(zones[i]);
+        if (tz == NULL) {
+            std::cout << "Skip the timezone not installed: " << zones[i]
+                << std::endl;
+            continue;
+        }
+        ASSERT_EQ(pcdvobjs_tzinfo_get(zones[i]), tz);
+
+        char buf[128];
+        snprintf(buf, sizeof(buf), ":%s", zones[i]);
+        setenv("TZ", buf, 1);
+        tzset();
+
+        /* from 1940 to 2100, for the rules after the last transition */
+        for (long long t = -946771200LL; t < 4102444800LL; t += 86399 * 3) {
+            time_t sec = (time_t)t;
+            struct tm expected, result;
+            localtime_r(&sec, &expected);
+            pcdvobjs_tzinfo_localtime(tz, sec, &result);
+
+            ASSERT_EQ(result.tm_year, expected.tm_year);
+            ASSERT_EQ(result.tm_yday, expected.tm_yday);
+            ASSERT_EQ(result.tm_hour, expected.tm_hour);
+            ASSERT_EQ(result.tm_min, expected.tm_min);
+            ASSERT_EQ(result.tm_isdst, expected.tm_isdst);
+#if HAVE(TM_GMTOFF)
+            ASSERT_EQ(result.tm_gmtoff, expected.tm_gmtoff);
+#endif
+#if HAVE(TM_ZONE)
+            ASSERT_STREQ(result.tm_zone, expected.tm_zone);
+#endif
+
+            expected.tm_isdst = -1;
+            result = expected;
+            ASSERT_EQ(pcdvobjs_tzinfo_mktime(tz, &result), mktime(&expected));
+        }
+    }
+
+    if (tz_old) {
+        setenv("TZ", tz_old, 1);
+        free(tz_old);
+    }
+    else {
+        unsetenv("TZ");
+    }
+    tzset();
+
+    purc_cleanup();
+}
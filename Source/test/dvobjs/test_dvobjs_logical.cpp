@@ -282,6 +282,26 @@ TEST(dvobjs, dvobjs_logical_eval)
                     nr_reserved_before) * sizeof(purc_variant));
     }
 
+    /* the same expression evaluated with other variables */
+    param[0] = purc_variant_make_string ("(x > 2) && (x < 5)", false);
+    for (int x = 0; x < 8; x++) {
+        param[1] = purc_variant_make_object (0, PURC_VARIANT_INVALID,
+                PURC_VARIANT_INVALID);
+        purc_variant_t v = purc_variant_make_number (x);
+        purc_variant_object_set_by_static_ckey (param[1], "x", v);
+        purc_variant_unref(v);
+
+        ret_var = func (NULL, 2, param, false);
+        ASSERT_NE(ret_var, nullptr);
+        ASSERT_EQ(purc_variant_is_type (ret_var,
+                    PURC_VARIANT_TYPE_BOOLEAN), true);
+        ASSERT_EQ(x > 2 && x < 5, ret_var->b);
+
+        purc_variant_unref(ret_var);
+        purc_variant_unref(param[1]);
+    }
+    purc_variant_unref(param[0]);
+
     purc_variant_unref(logical);
 
     purc_cleanup ();
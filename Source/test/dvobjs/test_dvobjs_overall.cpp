@@ -43,3 +43,614 @@ TEST(dvobjs, overall)
     tester.run_testcases_in_file("overall");
 }
 
+
+TEST(dvobjs, doc_query_memoized)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test",
+            "dvobjs", &info);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    static const char html[] =
+        "<html><body><div id='list'><p class='item'>a</p>"
+        "<p class='item'>b</p></div></body></html>";
+    purc_document_t doc = purc_document_load(PCDOC_K_TYPE_HTML,
+            html, sizeof(html) - 1);
+    ASSERT_NE(doc, nullptr);
+
+    purc_variant_t dvobj = purc_dvobj_doc_new(doc);
+    ASSERT_NE(dvobj, PURC_VARIANT_INVALID);
+
+    struct purc_native_ops *ops = purc_variant_native_get_ops(dvobj);
+    purc_nvariant_method query = ops->property_getter("query");
+    ASSERT_NE(query, nullptr);
+
+    purc_variant_t css = purc_variant_make_string(".item", false);
+    void *entity = purc_variant_native_get_entity(dvobj);
+
+    purc_variant_t first = query(entity, 1, &css, false);
+    ASSERT_NE(first, PURC_VARIANT_INVALID);
+    purc_variant_t again = query(entity, 1, &css, false);
+    /* the document is not changed, so the result is shared */
+    ASSERT_EQ(first, again);
+    purc_variant_unref(again);
+
+    pcdoc_element_t root = purc_document_root(doc);
+    pcdoc_element_new_element(doc, root, PCDOC_OP_APPEND, "p", false);
+
+    again = query(entity, 1, &css, false);
+    ASSERT_NE(again, PURC_VARIANT_INVALID);
+    ASSERT_NE(first, again);
+    purc_variant_unref(again);
+
+    purc_variant_unref(first);
+    purc_variant_unref(css);
+    purc_variant_unref(dvobj);
+    purc_document_delete(doc);
+
+    purc_cleanup();
+}
+
+TEST(dvobjs, doc_find_element)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test",
+            "dvobjs", &info);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    static const char html[] =
+        "<html><body><div id='list' class='a b'>"
+        "<p id='p1' class='item'>a</p>"
+        "<p id='p2' class='item sel' lang='en-US'>b</p>"
+        "<span id='s1'></span>"
+        "</div><p id='p3'>c</p></body></html>";
+    purc_document_t doc = purc_document_load(PCDOC_K_TYPE_HTML,
+            html, sizeof(html) - 1);
+    ASSERT_NE(doc, nullptr);
+
+    static const struct {
+        const char *selector;
+        const char *id;
+    } cases[] = {
+        { "#p2", "p2" },
+        { "p.item", "p1" },
+        { ".item.sel", "p2" },
+        /* the pseudo-classes not supported make the selector bad */
+        { "div.a.b > p:last-of-type, span", NULL },
+        { "div.b > span", "s1" },
+        { "body > p", "p3" },
+        { "div p + p", "p2" },
+        { "#p1 ~ span", "s1" },
+        { "[lang|=en]", "p2" },
+        { "p[id^='p'][id$='3']", "p3" },
+        { "span:empty:last-child", "s1" },
+        { "div > p:first-child", "p1" },
+        { "P#P1", NULL },
+        { "div span p", NULL },
+        { "body >", NULL },
+    };
+
+    for (size_t i = 0; i < sizeof(cases)/sizeof(cases[0]); i++) {
+        pcdoc_element_t elem;
+        elem = pcdoc_find_element_in_document(doc, cases[i].selector);
+        if (cases[i].id == NULL) {
+            ASSERT_EQ(elem, nullptr) << cases[i].selector;
+            continue;
+        }
+
+        ASSERT_NE(elem, nullptr) << cases[i].selector;
+        size_t len;
+        const char *id = pcdoc_element_id(doc, elem, &len);
+        ASSERT_NE(id, nullptr);
+        ASSERT_EQ(std::string(id, len), cases[i].id) << cases[i].selector;
+    }
+
+    purc_document_delete(doc);
+    purc_cleanup();
+}
+
+TEST(dvobjs, doc_element_index)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test",
+            "dvobjs", &info);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    static const char html[] =
+        "<html><body><div id='list'>"
+        "<p id='p1' class='item'>a</p>"
+        "<p id='p2' class='item'>b</p>"
+        "</div></body></html>";
+    purc_document_t doc = purc_document_load(PCDOC_K_TYPE_HTML,
+            html, sizeof(html) - 1);
+    ASSERT_NE(doc, nullptr);
+
+    /* the first lookup builds the indexes */
+    pcdoc_element_t p1 = pcdoc_find_element_in_document(doc, "#p1");
+    ASSERT_NE(p1, nullptr);
+    pcdoc_element_t p2 = pcdoc_find_element_in_document(doc, "#p2");
+    ASSERT_NE(p2, nullptr);
+    ASSERT_EQ(pcdoc_find_element_in_document(doc, ".item"), p1);
+
+    /* the indexes follow the changes of attributes */
+    pcdoc_element_set_attribute(doc, p1, PCDOC_OP_DISPLACE, "id", "p0", 0);
+    ASSERT_EQ(pcdoc_find_element_in_document(doc, "#p1"), nullptr);
+    ASSERT_EQ(pcdoc_find_element_in_document(doc, "#p0"), p1);
+
+    pcdoc_element_set_attribute(doc, p1, PCDOC_OP_DISPLACE,
+            "class", "other", 0);
+    ASSERT_EQ(pcdoc_find_element_in_document(doc, ".item"), p2);
+    ASSERT_EQ(pcdoc_find_element_in_document(doc, "p.other"), p1);
+
+    /* and the elements erased or inserted */
+    pcdoc_element_erase(doc, p2);
+    ASSERT_EQ(pcdoc_find_element_in_document(doc, "#p2"), nullptr);
+    ASSERT_EQ(pcdoc_find_element_in_document(doc, ".item"), nullptr);
+
+    pcdoc_element_t list = pcdoc_find_element_in_document(doc, "#list");
+    ASSERT_NE(list, nullptr);
+    static const char frag[] = "<p id='p3' class='item'>c</p>";
+    pcdoc_element_new_content(doc, list, PCDOC_OP_PREPEND,
+            frag, sizeof(frag) - 1);
+    pcdoc_element_t p3 = pcdoc_find_element_in_document(doc, ".item");
+    ASSERT_NE(p3, nullptr);
+    ASSERT_EQ(pcdoc_find_element_in_document(doc, "#p3"), p3);
+    ASSERT_EQ(pcdoc_find_element_in_document(doc, "#list > .item"), p3);
+
+    pcdoc_element_clear(doc, list);
+    ASSERT_EQ(pcdoc_find_element_in_document(doc, "#p3"), nullptr);
+    ASSERT_EQ(pcdoc_find_element_in_document(doc, "#p0"), nullptr);
+
+    purc_document_delete(doc);
+    purc_cleanup();
+}
+
+TEST(dvobjs, doc_child_by_index)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test",
+            "dvobjs", &info);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    std::string html = "<html><body><ul id='list'>";
+    for (int i = 0; i < 20; i++) {
+        html += "<li id='i" + std::to_string(i) + "'>x</li>";
+    }
+    html += "</ul></body></html>";
+
+    purc_document_t doc = purc_document_load(PCDOC_K_TYPE_HTML,
+            html.c_str(), html.length());
+    ASSERT_NE(doc, nullptr);
+
+    pcdoc_element_t list = pcdoc_find_element_in_document(doc, "#list");
+    ASSERT_NE(list, nullptr);
+
+    size_t nr_elems = 0;
+    ret = pcdoc_element_children_count(doc, list, &nr_elems, NULL, NULL);
+    ASSERT_EQ(ret, 0);
+    ASSERT_EQ(nr_elems, 20U);
+
+    for (size_t i = 0; i < nr_elems; i++) {
+        pcdoc_element_t child = pcdoc_element_get_child_element(doc, list, i);
+        ASSERT_NE(child, nullptr);
+
+        size_t len;
+        const char *id = pcdoc_element_id(doc, child, &len);
+        ASSERT_EQ(std::string(id, len), "i" + std::to_string(i));
+    }
+    ASSERT_EQ(pcdoc_element_get_child_element(doc, list, 20), nullptr);
+
+    /* the cached children are refreshed after the document changed */
+    pcdoc_element_erase(doc, pcdoc_element_get_child_element(doc, list, 10));
+    pcdoc_element_t child = pcdoc_element_get_child_element(doc, list, 10);
+    ASSERT_NE(child, nullptr);
+    size_t len;
+    const char *id = pcdoc_element_id(doc, child, &len);
+    ASSERT_EQ(std::string(id, len), "i11");
+
+    purc_document_delete(doc);
+    purc_cleanup();
+}
+
+static std::string
+serialize_document(purc_document_t doc)
+{
+    purc_rwstream_t out = purc_rwstream_new_buffer(1024, 1024 * 1024);
+    int ret = purc_document_serialize_contents_to_stream(doc, 0, out);
+
+    std::string s;
+    if (ret == 0) {
+        size_t sz_content = 0;
+        const char *buf = (const char *)purc_rwstream_get_mem_buffer(out,
+                &sz_content);
+        s.assign(buf, sz_content);
+    }
+    purc_rwstream_destroy(out);
+    return s;
+}
+
+static void
+change_document(purc_document_t doc)
+{
+    pcdoc_element_t elem = pcdoc_find_element_in_document(doc, "#i3");
+    pcdoc_element_set_attribute(doc, elem, PCDOC_OP_DISPLACE,
+            "class", "changed", 0);
+
+    elem = pcdoc_find_element_in_document(doc, "#i5");
+    pcdoc_element_new_text_content(doc, elem, PCDOC_OP_APPEND, "y", 0);
+
+    elem = pcdoc_find_element_in_document(doc, "#i7");
+    pcdoc_element_erase(doc, elem);
+
+    elem = pcdoc_find_element_in_document(doc, "#list");
+    pcdoc_element_new_content(doc, elem, PCDOC_OP_APPEND,
+            "<li id='new'>z</li>", 0);
+}
+
+TEST(dvobjs, doc_serialize_cached)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test",
+            "dvobjs", &info);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    std::string html = "<html><body><ul id='list'>";
+    for (int i = 0; i < 10; i++) {
+        html += "<li id='i" + std::to_string(i) + "'>x<b>b</b></li>";
+    }
+    html += "</ul><p>end</p></body></html>";
+
+    purc_document_t doc = purc_document_load(PCDOC_K_TYPE_HTML,
+            html.c_str(), html.length());
+    ASSERT_NE(doc, nullptr);
+    purc_document_t ref = purc_document_load(PCDOC_K_TYPE_HTML,
+            html.c_str(), html.length());
+    ASSERT_NE(ref, nullptr);
+
+    /* the unchanged document serializes identically from the cache */
+    std::string first = serialize_document(doc);
+    ASSERT_FALSE(first.empty());
+    ASSERT_EQ(serialize_document(doc), first);
+
+    /* the changed subtrees are serialized again */
+    change_document(doc);
+    change_document(ref);
+    std::string second = serialize_document(doc);
+    ASSERT_NE(second, first);
+    ASSERT_EQ(second, serialize_document(ref));
+    ASSERT_NE(second.find("class=\"changed\""), std::string::npos);
+    ASSERT_NE(second.find("id=\"new\""), std::string::npos);
+    ASSERT_EQ(second.find("id=\"i7\""), std::string::npos);
+
+    purc_document_delete(ref);
+    purc_document_delete(doc);
+    purc_cleanup();
+}
+
+TEST(dvobjs, doc_transient)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test",
+            "dvobjs", &info);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    const char *html = "<html><body><ul id='list'><li id='a'>a</li>"
+        "<li id='b'>b</li><li id='c'>c</li></ul><p id='p'>p</p>"
+        "</body></html>";
+    purc_document_t doc = purc_document_load_transient(PCDOC_K_TYPE_HTML,
+            html, 0);
+    ASSERT_NE(doc, nullptr);
+
+    pcdoc_element_erase(doc, pcdoc_find_element_in_document(doc, "#b"));
+    ASSERT_EQ(pcdoc_find_element_in_document(doc, "#b"), nullptr);
+    ASSERT_NE(pcdoc_find_element_in_document(doc, "#c"), nullptr);
+
+    pcdoc_element_t list = pcdoc_find_element_in_document(doc, "#list");
+    pcdoc_element_new_content(doc, list, PCDOC_OP_DISPLACE,
+            "<li id='d'>d</li>", 0);
+    ASSERT_EQ(pcdoc_find_element_in_document(doc, "#a"), nullptr);
+    ASSERT_NE(pcdoc_find_element_in_document(doc, "#d"), nullptr);
+
+    pcdoc_element_clear(doc, list);
+    ASSERT_EQ(pcdoc_find_element_in_document(doc, "#d"), nullptr);
+
+    /* reuse the document for another content */
+    ret = purc_document_reset(doc, "<html><body><div id='x'>x</div>"
+            "</body></html>", 0);
+    ASSERT_EQ(ret, 0);
+    ASSERT_EQ(pcdoc_find_element_in_document(doc, "#p"), nullptr);
+    ASSERT_NE(pcdoc_find_element_in_document(doc, "#x"), nullptr);
+    ASSERT_NE(purc_document_body(doc), nullptr);
+
+    purc_document_delete(doc);
+    purc_cleanup();
+}
+
+TEST(dvobjs, doc_build_subtree)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test",
+            "dvobjs", &info);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    purc_document_t doc = purc_document_load(PCDOC_K_TYPE_HTML,
+            "<html><body><ul id='list'><li id='first'>0</li></ul>"
+            "</body></html>", 0);
+    ASSERT_NE(doc, nullptr);
+
+    std::vector<struct pcdoc_build_step> steps;
+    std::vector<std::string> ids;
+    for (int i = 0; i < 3; i++)
+        ids.push_back("i" + std::to_string(i));
+    for (int i = 0; i < 3; i++) {
+        steps.push_back({ PCDOC_BUILD_ELEMENT, "li", NULL, 0 });
+        steps.push_back({ PCDOC_BUILD_ATTRIBUTE, "id", ids[i].c_str(), 0 });
+        steps.push_back({ PCDOC_BUILD_ATTRIBUTE, "class", "item", 0 });
+        steps.push_back({ PCDOC_BUILD_TEXT, NULL, "a<b", 0 });
+        steps.push_back({ PCDOC_BUILD_END, NULL, NULL, 0 });
+    }
+
+    pcdoc_element_t list = pcdoc_find_element_in_document(doc, "#list");
+    ASSERT_NE(list, nullptr);
+
+    purc_rwstream_t markup = purc_rwstream_new_buffer(1024, 1024 * 1024);
+    ret = pcdoc_element_build_subtree(doc, list, PCDOC_OP_APPEND,
+            steps.data(), steps.size(), PCDOC_SERIALIZE_OPT_SKIP_WS_NODES |
+            PCDOC_SERIALIZE_OPT_WITHOUT_TEXT_INDENT, markup);
+    ASSERT_EQ(ret, 0);
+
+    size_t sz_content = 0;
+    const char *content = (const char *)purc_rwstream_get_mem_buffer(markup,
+            &sz_content);
+    std::string s(content, sz_content);
+    ASSERT_NE(s.find("<li id=\"i0\" class=\"item\">a&lt;b</li>"),
+            std::string::npos);
+    purc_rwstream_destroy(markup);
+
+    size_t nr_elems = 0;
+    pcdoc_element_children_count(doc, list, &nr_elems, NULL, NULL);
+    ASSERT_EQ(nr_elems, 4U);
+
+    pcdoc_element_t child = pcdoc_element_get_child_element(doc, list, 3);
+    size_t len;
+    const char *id = pcdoc_element_id(doc, child, &len);
+    ASSERT_EQ(std::string(id, len), "i2");
+    ASSERT_EQ(pcdoc_find_element_in_document(doc, "#i1"),
+            pcdoc_element_get_child_element(doc, list, 2));
+
+    /* an unbalanced end makes nothing */
+    struct pcdoc_build_step bad[] = {
+        { PCDOC_BUILD_END, NULL, NULL, 0 },
+    };
+    ret = pcdoc_element_build_subtree(doc, list, PCDOC_OP_APPEND,
+            bad, 1, 0, NULL);
+    ASSERT_EQ(ret, -1);
+
+    purc_document_delete(doc);
+    purc_cleanup();
+}
+
+TEST(dvobjs, doc_parse_steps)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test",
+            "dvobjs", &info);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    purc_document_t doc = purc_document_load(PCDOC_K_TYPE_HTML,
+            "<html><body><ul id='list'></ul></body></html>", 0);
+    ASSERT_NE(doc, nullptr);
+
+    pcdoc_element_t list = pcdoc_find_element_in_document(doc, "#list");
+    ASSERT_NE(list, nullptr);
+
+    const char *markup = "<li class='item'>a&amp;b<b>c</b></li>";
+    size_t nr_steps = 0;
+    const struct pcdoc_build_step *steps;
+    steps = pcdoc_element_parse_steps(doc, list, markup, 0, &nr_steps);
+    ASSERT_NE(steps, nullptr);
+    ASSERT_EQ(nr_steps, 7U);
+    ASSERT_EQ(steps[0].type, PCDOC_BUILD_ELEMENT);
+    ASSERT_STREQ(steps[0].name, "li");
+    ASSERT_EQ(steps[1].type, PCDOC_BUILD_ATTRIBUTE);
+    ASSERT_STREQ(steps[1].name, "class");
+    ASSERT_STREQ(steps[1].value, "item");
+    ASSERT_EQ(steps[2].type, PCDOC_BUILD_TEXT);
+    ASSERT_EQ(std::string(steps[2].value, steps[2].len), "a&b");
+    ASSERT_STREQ(steps[3].name, "b");
+    ASSERT_EQ(steps[5].type, PCDOC_BUILD_END);
+    ASSERT_EQ(steps[6].type, PCDOC_BUILD_END);
+
+    /* the same markup in the same kind of element is not parsed again */
+    ASSERT_EQ(pcdoc_element_parse_steps(doc, list, markup, 0, &nr_steps),
+            steps);
+
+    ret = pcdoc_element_build_subtree(doc, list, PCDOC_OP_APPEND,
+            steps, nr_steps, 0, NULL);
+    ASSERT_EQ(ret, 0);
+
+    size_t nr_elems = 0;
+    pcdoc_element_children_count(doc, list, &nr_elems, NULL, NULL);
+    ASSERT_EQ(nr_elems, 1U);
+
+    /* the comments can not be built by steps */
+    ASSERT_EQ(pcdoc_element_parse_steps(doc, list, "<li><!-- c --></li>", 0,
+                &nr_steps), nullptr);
+    ASSERT_EQ(purc_get_last_error(), PURC_ERROR_NOT_SUPPORTED);
+
+    purc_document_delete(doc);
+    purc_cleanup();
+}
+
+TEST(dvobjs, doc_compact)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test",
+            "dvobjs", &info);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    purc_document_t doc = purc_document_load_compact(
+            "<html><head><title>T</title></head>"
+            "<body><ul id='list' class='a b'><li>0</li></ul></body></html>", 0);
+    ASSERT_NE(doc, nullptr);
+
+    pcdoc_element_t body = purc_document_body(doc);
+    ASSERT_NE(body, nullptr);
+    pcdoc_element_t list = pcdoc_element_get_child_element(doc, body, 0);
+    ASSERT_NE(list, nullptr);
+
+    size_t len;
+    const char *id = pcdoc_element_id(doc, list, &len);
+    ASSERT_EQ(std::string(id, len), "list");
+
+    pcdoc_element_t li = pcdoc_element_new_element(doc, list,
+            PCDOC_OP_APPEND, "li", false);
+    ASSERT_NE(li, nullptr);
+    pcdoc_element_set_attribute(doc, li, PCDOC_OP_DISPLACE, "id", "x", 0);
+    pcdoc_element_new_text_content(doc, li, PCDOC_OP_APPEND, "a<b&c", 0);
+    pcdoc_element_new_content(doc, body, PCDOC_OP_APPEND,
+            "<p>1<br>2</p>", 0);
+
+    size_t nr_elems = 0;
+    pcdoc_element_children_count(doc, list, &nr_elems, NULL, NULL);
+    ASSERT_EQ(nr_elems, 2U);
+
+    purc_rwstream_t out = purc_rwstream_new_buffer(1024, 1024 * 1024);
+    pcdoc_serialize_descendants_to_stream(doc, body, 0, out);
+    size_t sz_content = 0;
+    const char *content = (const char *)purc_rwstream_get_mem_buffer(out,
+            &sz_content);
+    ASSERT_EQ(std::string(content, sz_content),
+            "<body><ul id=\"list\" class=\"a b\"><li>0</li>"
+            "<li id=\"x\">a&lt;b&amp;c</li></ul><p>1<br>2</p></body>");
+    purc_rwstream_destroy(out);
+
+    /* erasing the list leaves the paragraph only */
+    pcdoc_element_erase(doc, list);
+    ASSERT_EQ(pcdoc_element_get_child_element(doc, body, 1), nullptr);
+
+    ret = purc_document_reset(doc, NULL, 0);
+    ASSERT_EQ(ret, 0);
+    ASSERT_NE(purc_document_body(doc), nullptr);
+    ASSERT_EQ(pcdoc_element_get_child_element(doc,
+                purc_document_body(doc), 0), nullptr);
+
+    purc_document_delete(doc);
+    purc_cleanup();
+}
+
+static std::string
+serialize_doc(purc_document_t doc, pcdoc_element_t ancestor)
+{
+    purc_rwstream_t out = purc_rwstream_new_buffer(4096, 64 * 1024 * 1024);
+    if (ancestor)
+        pcdoc_serialize_descendants_to_stream(doc, ancestor, 0, out);
+    else
+        purc_document_serialize_contents_to_stream(doc, 0, out);
+
+    size_t sz_content = 0;
+    const char *content = (const char *)purc_rwstream_get_mem_buffer(out,
+            &sz_content);
+    std::string s(content, sz_content);
+    purc_rwstream_destroy(out);
+    return s;
+}
+
+TEST(dvobjs, doc_serialize_parallel)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test",
+            "dvobjs", &info);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    std::string html = "<html><head><title>T</title></head><body>";
+    for (int i = 0; i < 3000; i++) {
+        html += "<div class='row'><span>" + std::to_string(i) +
+            "</span><br><a href='#'>a&amp;b</a></div>";
+    }
+    html += "<template><p>t</p></template></body></html>";
+
+    purc_document_t doc = purc_document_load(PCDOC_K_TYPE_HTML,
+            html.c_str(), html.size());
+    ASSERT_NE(doc, nullptr);
+
+    std::string serial = serialize_doc(doc, NULL);
+    std::string serial_body = serialize_doc(doc, purc_document_body(doc));
+
+    ASSERT_EQ(purc_document_set_serialize_workers(doc, 4), 0U);
+    ASSERT_EQ(serialize_doc(doc, NULL), serial);
+    ASSERT_EQ(serialize_doc(doc, purc_document_body(doc)), serial_body);
+
+    /* more workers than the children of the body */
+    purc_document_set_serialize_workers(doc, 5000);
+    ASSERT_EQ(serialize_doc(doc, NULL), serial);
+
+    purc_document_delete(doc);
+    purc_cleanup();
+}
+
+TEST(dvobjs, doc_shared_text)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test",
+            "dvobjs", &info);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    purc_document_t doc = purc_document_load(PCDOC_K_TYPE_HTML,
+            "<html><body><p id='p'></p></body></html>", 0);
+    ASSERT_NE(doc, nullptr);
+
+    std::string long_text(200, 'x');
+    purc_variant_t str = purc_variant_make_string(long_text.c_str(), false);
+    ASSERT_NE(str, nullptr);
+    size_t nr_refs = purc_variant_ref_count(str);
+
+    pcdoc_element_t p = pcdoc_find_element_in_document(doc, "#p");
+    ASSERT_NE(p, nullptr);
+    pcdoc_text_node_t text = pcdoc_element_new_text_content_ex(doc, p,
+            PCDOC_OP_APPEND, str, PCDOC_TEXT_CONTENT_F_SHARED);
+    ASSERT_NE(text, nullptr);
+    ASSERT_EQ(purc_variant_ref_count(str), nr_refs + 1);
+
+    /* the text node refers to the bytes of the variant */
+    const char *s;
+    size_t len;
+    ASSERT_EQ(pcdoc_text_content_get_text(doc, text, &s, &len), 0);
+    ASSERT_EQ(s, purc_variant_get_string_const(str));
+    ASSERT_EQ(len, long_text.size());
+
+    purc_rwstream_t out = purc_rwstream_new_buffer(1024, 1024 * 1024);
+    pcdoc_serialize_descendants_to_stream(doc, p,
+            PCDOC_SERIALIZE_OPT_SKIP_WS_NODES |
+            PCDOC_SERIALIZE_OPT_WITHOUT_TEXT_INDENT, out);
+    size_t sz_content = 0;
+    const char *content = (const char *)purc_rwstream_get_mem_buffer(out,
+            &sz_content);
+    ASSERT_NE(std::string(content, sz_content).find(long_text),
+            std::string::npos);
+    purc_rwstream_destroy(out);
+
+    /* a short text is copied */
+    purc_variant_t short_str = purc_variant_make_string("short", false);
+    pcdoc_text_node_t short_text = pcdoc_element_new_text_content_ex(doc, p,
+            PCDOC_OP_APPEND, short_str, PCDOC_TEXT_CONTENT_F_SHARED);
+    ASSERT_NE(short_text, nullptr);
+    ASSERT_EQ(pcdoc_text_content_get_text(doc, short_text, &s, &len), 0);
+    ASSERT_NE(s, purc_variant_get_string_const(short_str));
+    purc_variant_unref(short_str);
+
+    /* the variant is released with the node */
+    pcdoc_element_clear(doc, p);
+    ASSERT_EQ(purc_variant_ref_count(str), nr_refs);
+
+    pcdoc_element_new_text_content_ex(doc, p, PCDOC_OP_APPEND, str,
+            PCDOC_TEXT_CONTENT_F_SHARED);
+    ASSERT_EQ(purc_variant_ref_count(str), nr_refs + 1);
+
+    /* or with the document */
+    purc_document_delete(doc);
+    ASSERT_EQ(purc_variant_ref_count(str), nr_refs);
+
+    purc_variant_unref(str);
+    purc_cleanup();
+}
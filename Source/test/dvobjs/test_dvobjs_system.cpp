@@ -1148,6 +1148,74 @@ TEST(dvobjs, random)
     purc_cleanup();
 }
 
+static purc_variant_t eval_system(purc_variant_t sys, const char *ejson)
+{
+    struct purc_ejson_parse_tree *ptree;
+    purc_variant_t result;
+
+    ptree = purc_variant_ejson_parse_string(ejson, strlen(ejson));
+    result = purc_variant_ejson_parse_tree_evalute(ptree,
+            get_dvobj_system, sys, true);
+    purc_variant_ejson_parse_tree_destroy(ptree);
+    return result;
+}
+
+TEST(dvobjs, random_seeded)
+{
+    int ret = purc_init_ex(PURC_MODULE_EJSON, "cn.fmsfot.hvml.test",
+            "dvobj", NULL);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    purc_variant_t sys = purc_dvobj_system_new();
+    ASSERT_NE(sys, nullptr);
+
+    /* the same seed gives the same numbers */
+    int64_t first[8];
+    purc_variant_t result = eval_system(sys, "$SYS.random(! 2022 )");
+    ASSERT_EQ(purc_variant_booleanize(result), true);
+    purc_variant_unref(result);
+    for (size_t i = 0; i < PCA_TABLESIZE(first); i++) {
+        result = eval_system(sys, "$SYS.random()");
+        ASSERT_EQ(purc_variant_cast_to_longint(result, first + i, false), true);
+        ASSERT_GE(first[i], 0);
+        ASSERT_LE(first[i], RAND_MAX);
+        purc_variant_unref(result);
+    }
+
+    result = eval_system(sys, "$SYS.random(! 2022, 128 )");
+    ASSERT_EQ(purc_variant_booleanize(result), true);
+    purc_variant_unref(result);
+    for (size_t i = 0; i < PCA_TABLESIZE(first); i++) {
+        int64_t number;
+        result = eval_system(sys, "$SYS.random()");
+        ASSERT_EQ(purc_variant_cast_to_longint(result, &number, false), true);
+        ASSERT_EQ(number, first[i]);
+        purc_variant_unref(result);
+    }
+
+    for (uint64_t bound = 1; bound < 100; bound += 7) {
+        for (int i = 0; i < 100; i++) {
+            ASSERT_LT(pcdvobjs_get_random_below(bound), bound);
+        }
+    }
+
+#if OS(LINUX)
+    result = eval_system(sys, "$SYS.random_sequence(256)");
+    size_t nr_bytes;
+    ASSERT_NE(purc_variant_get_bytes_const(result, &nr_bytes), nullptr);
+    ASSERT_EQ(nr_bytes, 256);
+    purc_variant_unref(result);
+
+    result = eval_system(sys, "$SYS.random_sequence(3)");
+    ASSERT_NE(purc_variant_get_bytes_const(result, &nr_bytes), nullptr);
+    ASSERT_EQ(nr_bytes, 3);
+    purc_variant_unref(result);
+#endif
+
+    purc_variant_unref(sys);
+    purc_cleanup();
+}
+
 purc_variant_t system_cwd(purc_variant_t dvobj, const char* name)
 {
     (void)dvobj;
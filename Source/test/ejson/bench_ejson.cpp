@@ -0,0 +1,118 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * The benchmarks of the eJSON parsers; see bench.h for the results. The
+ * size is the number of the rows in the document.
+ */
+
+#include "purc.h"
+
+#include "private/ejson.h"
+#include "private/vcm.h"
+
+#include "../helpers.h"
+#include "../bench.h"
+
+#include <gtest/gtest.h>
+
+#define DEF_BENCH_SIZES         "10,1000"
+
+/* [{"id":0,"name":"row","point":[0,-0.5]}, ...] */
+static std::string
+make_rows_json(size_t size)
+{
+    std::string json = "[";
+    for (size_t i = 0; i < size; i++) {
+        if (i)
+            json += ",";
+        json += "{\"id\":" + std::to_string(i) +
+            ",\"name\":\"row\",\"point\":[" + std::to_string(i) +
+            ",-0.5]}";
+    }
+    json += "]";
+    return json;
+}
+
+TEST(bench_ejson, parsers)
+{
+    PurCInstance purc(false);
+    ASSERT_TRUE(purc);
+
+    BenchRunner bench("bench_ejson");
+    std::vector<size_t> sizes = BenchRunner::get_sizes(DEF_BENCH_SIZES);
+    ASSERT_FALSE(sizes.empty());
+
+    for (size_t size : sizes) {
+        std::string json = make_rows_json(size);
+
+        EXPECT_TRUE(bench.run("parse/vcm", size, [&json]() {
+            purc_rwstream_t rws = purc_rwstream_new_from_mem(
+                    (void*)json.c_str(), json.size());
+            struct pcvcm_node* root = NULL;
+            struct pcejson* parser = NULL;
+            purc_variant_t vt = PURC_VARIANT_INVALID;
+            if (pcejson_parse(&root, &parser, rws, 32) == 0)
+                vt = pcvcm_eval(root, NULL, false);
+            pcvcm_node_destroy(root);
+            pcejson_destroy(parser);
+            purc_rwstream_destroy(rws);
+            if (vt == PURC_VARIANT_INVALID)
+                return false;
+            purc_variant_unref(vt);
+            return true;
+        }));
+
+        static const struct {
+            const char     *operation;
+            uint32_t        flags;
+        } plain_cases[] = {
+            { "parse/plain", 0 },
+            { "parse/plain/intern_keys", PCEJSON_FLAG_INTERN_KEYS },
+            { "parse/plain/compact_arrays", PCEJSON_FLAG_COMPACT_ARRAYS },
+        };
+
+        for (const auto &c : plain_cases) {
+            uint32_t flags = c.flags;
+            EXPECT_TRUE(bench.run(c.operation, size, [&json, flags]() {
+                purc_variant_t vt;
+                if (pcejson_parse_plain(&vt, json.c_str(), json.size(),
+                            32, flags))
+                    return false;
+                purc_variant_unref(vt);
+                return true;
+            }));
+        }
+
+        EXPECT_TRUE(bench.run("parse/static", size, [&json]() {
+            purc_variant_t vt = PURC_VARIANT_INVALID;
+            purc_rwstream_t rws = purc_rwstream_new_from_mem(
+                    (void*)json.c_str(), json.size());
+            int ret = pcejson_parse_static(&vt, rws, 32, 0);
+            purc_rwstream_destroy(rws);
+            if (ret)
+                return false;
+            purc_variant_unref(vt);
+            return true;
+        }));
+    }
+
+    ASSERT_TRUE(bench.write_results());
+}
@@ -21,6 +21,7 @@
 
 #include "private/ejson.h"
 #include "private/utils.h"
+#include "private/variant.h"
 #include "purc-rwstream.h"
 
 #include "../helpers.h"
@@ -28,6 +29,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <limits.h>
+#include <sys/time.h>
 #include <gtest/gtest.h>
 
 using namespace std;
@@ -347,3 +349,507 @@ std::vector<ejson_test_data> read_ejson_test_data()
 INSTANTIATE_TEST_SUITE_P(ejson, ejson_parser_vcm_eval,
         testing::ValuesIn(read_ejson_test_data()));
 
+
+#define NR_ROWS     100
+
+TEST(ejson, intern_keys)
+{
+    PurCInstance purc;
+
+    std::string json = "[";
+    for (int i = 0; i < NR_ROWS; i++) {
+        if (i)
+            json += ",";
+        json += "{id:" + std::to_string(i) + ",'name':'row','value':1.0}";
+    }
+    json += "]";
+
+    purc_rwstream_t rws = purc_rwstream_new_from_mem((void*)json.c_str(),
+            json.size() + 1);
+    struct pcvcm_node* root = NULL;
+    struct pcejson* parser = pcejson_create(32, PCEJSON_FLAG_INTERN_KEYS);
+    ASSERT_NE(parser, nullptr);
+    pcejson_parse(&root, &parser, rws, 32);
+    ASSERT_NE(root, nullptr);
+
+    purc_variant_t vt = pcvcm_eval(root, NULL, false);
+    ASSERT_NE(vt, PURC_VARIANT_INVALID);
+    ASSERT_EQ(purc_variant_array_get_size(vt), (size_t)NR_ROWS);
+
+    /* the keys are iterated in the same order for all rows */
+    std::vector<purc_variant_t> keys;
+    purc_variant_t k, v;
+    foreach_key_value_in_variant_object(purc_variant_array_get(vt, 0), k, v)
+        keys.push_back(k);
+        (void)v;
+    end_foreach;
+    ASSERT_EQ(keys.size(), 3U);
+
+    for (size_t i = 0; i < NR_ROWS; i++) {
+        purc_variant_t row = purc_variant_array_get(vt, i);
+        ASSERT_EQ(purc_variant_object_get_size(row), 3U);
+
+        /* the rows share the key variants */
+        size_t n = 0;
+        foreach_key_value_in_variant_object(row, k, v)
+            ASSERT_EQ(k, keys[n]);
+            n++;
+        end_foreach;
+
+        int64_t id;
+        purc_variant_t val = purc_variant_object_get_by_ckey(row, "id");
+        ASSERT_NE(val, PURC_VARIANT_INVALID);
+        ASSERT_TRUE(purc_variant_cast_to_longint(val, &id, false));
+        ASSERT_EQ(id, (int64_t)i);
+    }
+
+    purc_variant_unref(vt);
+    pcvcm_node_destroy(root);
+    pcejson_destroy(parser);
+    purc_rwstream_destroy(rws);
+}
+
+#define SZ_DOCUMENT     (1024 * 1024)
+
+static double
+current_time_ms(void)
+{
+    struct timeval now;
+    gettimeofday(&now, 0);
+    return now.tv_sec * 1000.0 + now.tv_usec / 1000.0;
+}
+
+TEST(ejson, parse_throughput)
+{
+    PurCInstance purc;
+
+    size_t nr_rows = 0;
+    std::string json = "[";
+    while (json.size() < SZ_DOCUMENT) {
+        if (nr_rows)
+            json += ",";
+        json += "{id:" + std::to_string(nr_rows) +
+            ", 'name': 'row', \"note\": \"line\\nbreak\", "
+            "\"values\": [1.5, -2e3, true, null, \"tail\"]}";
+        nr_rows++;
+    }
+    json += "]";
+
+    purc_rwstream_t rws = purc_rwstream_new_from_mem((void*)json.c_str(),
+            json.size());
+    struct pcvcm_node* root = NULL;
+    struct pcejson* parser = pcejson_create(32, 0);
+    ASSERT_NE(parser, nullptr);
+
+    double started = current_time_ms();
+    pcejson_parse(&root, &parser, rws, 32);
+    double elapsed = current_time_ms() - started;
+    ASSERT_NE(root, nullptr);
+
+    purc_variant_t vt = pcvcm_eval(root, NULL, false);
+    ASSERT_NE(vt, PURC_VARIANT_INVALID);
+    ASSERT_EQ(purc_variant_array_get_size(vt), nr_rows);
+
+    fprintf(stderr, "parsed %zu bytes in %.3f ms: %.2f MB/s\n",
+            json.size(), elapsed,
+            json.size() / 1024.0 / 1024.0 / (elapsed / 1000.0));
+
+    purc_variant_unref(vt);
+    pcvcm_node_destroy(root);
+    pcejson_destroy(parser);
+    purc_rwstream_destroy(rws);
+}
+
+/* the multi-byte characters span the boundaries of the blocks read */
+TEST(ejson, parse_multibyte_blocks)
+{
+    PurCInstance purc;
+
+    std::string str;
+    for (int i = 0; i < 4096; i++) {
+        str += (i % 3) ? "\xe4\xb8\xad" : "a";
+    }
+    std::string json = "{\"key\": \"" + str + "\"}";
+
+    purc_rwstream_t rws = purc_rwstream_new_from_mem((void*)json.c_str(),
+            json.size());
+    struct pcvcm_node* root = NULL;
+    struct pcejson* parser = pcejson_create(32, 0);
+    ASSERT_NE(parser, nullptr);
+    pcejson_parse(&root, &parser, rws, 32);
+    ASSERT_NE(root, nullptr);
+
+    purc_variant_t vt = pcvcm_eval(root, NULL, false);
+    ASSERT_NE(vt, PURC_VARIANT_INVALID);
+    purc_variant_t val = purc_variant_object_get_by_ckey(vt, "key");
+    ASSERT_NE(val, PURC_VARIANT_INVALID);
+    ASSERT_STREQ(purc_variant_get_string_const(val), str.c_str());
+
+    purc_variant_unref(vt);
+    pcvcm_node_destroy(root);
+    pcejson_destroy(parser);
+    purc_rwstream_destroy(rws);
+}
+
+static std::string
+serialize_variant(purc_variant_t vt)
+{
+    char buf[4096] = {0};
+    purc_rwstream_t rws = purc_rwstream_new_from_mem(buf, sizeof(buf) - 1);
+    ssize_t n = purc_variant_serialize(vt, rws, 0,
+            PCVARIANT_SERIALIZE_OPT_REAL_EJSON |
+            PCVARIANT_SERIALIZE_OPT_PLAIN |
+            PCVARIANT_SERIALIZE_OPT_BSEQUENCE_BASE64, NULL);
+    purc_rwstream_destroy(rws);
+    return n > 0 ? std::string(buf, n) : std::string();
+}
+
+static purc_variant_t
+parse_static_string(const char *json, int *ret)
+{
+    purc_variant_t vt = PURC_VARIANT_INVALID;
+    purc_rwstream_t rws = purc_rwstream_new_from_mem((void*)json,
+            strlen(json));
+    *ret = pcejson_parse_static(&vt, rws, 32, 0);
+    purc_rwstream_destroy(rws);
+    return vt;
+}
+
+/* the static parser makes the same values as the VCM tree does */
+TEST(ejson, parse_static)
+{
+    PurCInstance purc;
+
+    static const char *cases[] = {
+        "123",
+        "-1.5e3",
+        "12L",
+        "-12L",
+        "18446744073709551615UL",
+        "1.25FL",
+        "0x1F",
+        "0xFFU",
+        "Infinity",
+        "-Infinity",
+        "NaN",
+        "true",
+        "false",
+        "null",
+        "undefined",
+        "\"\"",
+        "''",
+        "'single quoted'",
+        "\"line\\nbreak \\\" \\u4E2D \\/\"",
+        "\"\"\"raw \"quoted\" text\"\"\"",
+        "\"\xe4\xb8\xad\xe6\x96\x87\"",
+        "bx0A0B",
+        "bb0000.1111",
+        "b64SGVsbG8=",
+        "[]",
+        "{}",
+        " [ 1 , 2 , [ 3 , { } ] ] ",
+        "{id: 1, 'name': 'row', \"values\": [1.5, true, null]}",
+        "{\"a\": {\"b\": {\"c\": [\"d\"]}}, \"e\": -0}",
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(cases); i++) {
+        purc_variant_t expected = purc_variant_make_from_json_string(
+                cases[i], strlen(cases[i]));
+        ASSERT_NE(expected, PURC_VARIANT_INVALID) << cases[i];
+
+        purc_rwstream_t rws = purc_rwstream_new_from_mem((void*)cases[i],
+                strlen(cases[i]));
+        struct pcvcm_node* root = NULL;
+        struct pcejson* parser = NULL;
+        ASSERT_EQ(pcejson_parse(&root, &parser, rws, 32), 0) << cases[i];
+        purc_variant_t evaluated = pcvcm_eval(root, NULL, false);
+        ASSERT_NE(evaluated, PURC_VARIANT_INVALID) << cases[i];
+        pcvcm_node_destroy(root);
+        pcejson_destroy(parser);
+        purc_rwstream_destroy(rws);
+
+        int ret;
+        purc_variant_t vt = parse_static_string(cases[i], &ret);
+        ASSERT_EQ(ret, 0) << cases[i];
+        ASSERT_NE(vt, PURC_VARIANT_INVALID) << cases[i];
+        ASSERT_EQ(purc_variant_get_type(vt),
+                purc_variant_get_type(evaluated)) << cases[i];
+        ASSERT_EQ(serialize_variant(vt), serialize_variant(evaluated))
+            << cases[i];
+        ASSERT_EQ(serialize_variant(expected), serialize_variant(evaluated))
+            << cases[i];
+
+        purc_variant_unref(vt);
+        purc_variant_unref(evaluated);
+        purc_variant_unref(expected);
+    }
+
+    /* dynamic expressions are left to the VCM tree */
+    static const char *dynamic_cases[] = {
+        "$foo",
+        "{\"a\": \"x$y\"}",
+        "[1, {{ $a }}]",
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(dynamic_cases); i++) {
+        int ret;
+        purc_variant_t vt = parse_static_string(dynamic_cases[i], &ret);
+        ASSERT_EQ(ret, -1) << dynamic_cases[i];
+        ASSERT_EQ(vt, PURC_VARIANT_INVALID) << dynamic_cases[i];
+    }
+
+    int ret;
+    ASSERT_EQ(parse_static_string("$foo", &ret), PURC_VARIANT_INVALID);
+    ASSERT_EQ(purc_get_last_error(), PURC_ERROR_NOT_SUPPORTED);
+
+    ASSERT_EQ(parse_static_string("[1, 2", &ret), PURC_VARIANT_INVALID);
+    ASSERT_EQ(purc_get_last_error(), PCEJSON_ERROR_UNEXPECTED_EOF);
+
+    ASSERT_EQ(parse_static_string("[1] 2", &ret), PURC_VARIANT_INVALID);
+    ASSERT_EQ(purc_get_last_error(), PCEJSON_ERROR_UNEXPECTED_CHARACTER);
+}
+
+struct member_counter {
+    size_t nr_members;
+    size_t nr_stop;
+};
+
+static bool
+on_member(void *ctxt, purc_variant_t member)
+{
+    struct member_counter *counter = (struct member_counter *)ctxt;
+
+    int64_t id = -1;
+    purc_variant_t val = purc_variant_object_get_by_ckey(member, "id");
+    if (val == PURC_VARIANT_INVALID ||
+            !purc_variant_cast_to_longint(val, &id, false) ||
+            id != (int64_t)counter->nr_members)
+        return false;
+
+    counter->nr_members++;
+    return counter->nr_members != counter->nr_stop;
+}
+
+TEST(ejson, parse_static_members)
+{
+    PurCInstance purc;
+
+    std::string json = "[";
+    for (int i = 0; i < NR_ROWS; i++) {
+        if (i)
+            json += ",";
+        json += "{id:" + std::to_string(i) + ",'name':'row','value':1.0}";
+    }
+    json += "]";
+
+    struct member_counter counter = { 0, 0 };
+    purc_rwstream_t rws = purc_rwstream_new_from_mem((void*)json.c_str(),
+            json.size());
+    ASSERT_EQ(pcejson_parse_static_members(rws, 32, 0, on_member, &counter),
+            0);
+    ASSERT_EQ(counter.nr_members, (size_t)NR_ROWS);
+    purc_rwstream_destroy(rws);
+
+    /* the callback stops the parsing */
+    counter = { 0, 10 };
+    rws = purc_rwstream_new_from_mem((void*)json.c_str(), json.size());
+    ASSERT_EQ(pcejson_parse_static_members(rws, 32, 0, on_member, &counter),
+            0);
+    ASSERT_EQ(counter.nr_members, 10U);
+    purc_rwstream_destroy(rws);
+
+    /* the top-level value must be an array */
+    counter = { 0, 0 };
+    rws = purc_rwstream_new_from_mem((void*)"{\"id\": 0}", 9);
+    ASSERT_EQ(pcejson_parse_static_members(rws, 32, 0, on_member, &counter),
+            -1);
+    ASSERT_EQ(counter.nr_members, 0U);
+    purc_rwstream_destroy(rws);
+}
+
+static purc_variant_t
+parse_with_vcm(const char *json, size_t len)
+{
+    purc_rwstream_t rws = purc_rwstream_new_from_mem((void*)json, len);
+    struct pcvcm_node* root = NULL;
+    struct pcejson* parser = NULL;
+    purc_variant_t vt = PURC_VARIANT_INVALID;
+    if (pcejson_parse(&root, &parser, rws, 32) == 0)
+        vt = pcvcm_eval(root, NULL, false);
+    pcvcm_node_destroy(root);
+    pcejson_destroy(parser);
+    purc_rwstream_destroy(rws);
+    return vt;
+}
+
+/* the plain JSON parser makes the same values as the eJSON parser does */
+TEST(ejson, parse_plain)
+{
+    PurCInstance purc;
+
+    static const char *cases[] = {
+        "0",
+        "-0",
+        "123456789012345",
+        "1234567890123456789",
+        "-1.5e3",
+        "2.5E-3",
+        "true",
+        "false",
+        "null",
+        "\"\"",
+        "\"line\\nbreak \\\" \\\\ \\/ \\u4E2D\"",
+        "\"\xe4\xb8\xad\xe6\x96\x87 and a long tail of ASCII text\"",
+        "[]",
+        "{}",
+        " [ 1 ,\t2 ,\n[ 3 , { } ] ] ",
+        "{\"id\": 1, \"name\": \"row\", \"values\": [1.5, true, null]}",
+        "{\"a\": {\"b\": {\"c\": [\"d\"]}}, \"a\": -0}",
+        "\xef\xbb\xbf{\"bom\": true}",
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(cases); i++) {
+        size_t len = strlen(cases[i]);
+        purc_variant_t expected = parse_with_vcm(cases[i], len);
+        ASSERT_NE(expected, PURC_VARIANT_INVALID) << cases[i];
+
+        purc_variant_t vt;
+        ASSERT_EQ(pcejson_parse_plain(&vt, cases[i], len, 32, 0), 0)
+            << cases[i];
+        ASSERT_EQ(purc_variant_get_type(vt), purc_variant_get_type(expected))
+            << cases[i];
+        ASSERT_EQ(serialize_variant(vt), serialize_variant(expected))
+            << cases[i];
+
+        purc_variant_unref(vt);
+        purc_variant_unref(expected);
+    }
+
+    /* the constructs left to the eJSON parser */
+    static const char *other_cases[] = {
+        "'single'",
+        "{id: 1}",
+        "\"a$b\"",
+        "\"\"\"triple\"\"\"",
+        "[1, 2,]",
+        "12L",
+        "01",
+        "0x10",
+        "undefined",
+        "NaN",
+        "[1]\r\n",
+        "\"\xf0\x9f\x98\x80\"",
+        "\"\xe4\xb8\"",
+        "[1, 2",
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(other_cases); i++) {
+        purc_variant_t vt;
+        ASSERT_EQ(pcejson_parse_plain(&vt, other_cases[i],
+                    strlen(other_cases[i]), 32, 0), -1) << other_cases[i];
+        ASSERT_EQ(vt, PURC_VARIANT_INVALID) << other_cases[i];
+    }
+
+    /* too deep */
+    std::string deep(33, '[');
+    deep += std::string(33, ']');
+    purc_variant_t vt;
+    ASSERT_EQ(pcejson_parse_plain(&vt, deep.c_str(), deep.size(), 32, 0), -1);
+}
+
+TEST(ejson, parse_plain_throughput)
+{
+    PurCInstance purc;
+
+    size_t nr_rows = 0;
+    std::string json = "[";
+    while (json.size() < SZ_DOCUMENT) {
+        if (nr_rows)
+            json += ",";
+        json += "{\"id\":" + std::to_string(nr_rows) +
+            ", \"name\": \"row\", \"note\": \"line\\nbreak\", "
+            "\"values\": [1.5, -2e3, true, null, \"tail\"]}";
+        nr_rows++;
+    }
+    json += "]";
+
+    double started = current_time_ms();
+    purc_variant_t expected = parse_with_vcm(json.c_str(), json.size());
+    double ejson_time = current_time_ms() - started;
+    ASSERT_NE(expected, PURC_VARIANT_INVALID);
+
+    purc_variant_t vt;
+    started = current_time_ms();
+    ASSERT_EQ(pcejson_parse_plain(&vt, json.c_str(), json.size(), 32, 0), 0);
+    double plain_time = current_time_ms() - started;
+    ASSERT_EQ(purc_variant_array_get_size(vt), nr_rows);
+    ASSERT_TRUE(purc_variant_is_equal_to(vt, expected));
+
+    fprintf(stderr, "parsed %zu bytes: eJSON %.3f ms, plain JSON %.3f ms\n",
+            json.size(), ejson_time, plain_time);
+
+    purc_variant_unref(vt);
+    purc_variant_unref(expected);
+}
+
+static size_t
+array_memory_used(void)
+{
+    const struct purc_variant_stat *stat = purc_variant_usage_stat();
+    return stat->sz_mem[PURC_VARIANT_TYPE_ARRAY];
+}
+
+/* the small arrays take only the space of their members */
+TEST(ejson, compact_arrays)
+{
+    PurCInstance purc;
+
+    std::string json = "[";
+    for (int i = 0; i < NR_ROWS; i++) {
+        if (i)
+            json += ",";
+        json += "[" + std::to_string(i) + ", " + std::to_string(-i) + "]";
+    }
+    json += "]";
+
+    size_t base = array_memory_used();
+    purc_variant_t normal;
+    ASSERT_EQ(pcejson_parse_plain(&normal, json.c_str(), json.size(), 32, 0),
+            0);
+    size_t sz_normal = array_memory_used() - base;
+
+    base = array_memory_used();
+    purc_variant_t compact;
+    ASSERT_EQ(pcejson_parse_plain(&compact, json.c_str(), json.size(), 32,
+                PCEJSON_FLAG_COMPACT_ARRAYS), 0);
+    size_t sz_compact = array_memory_used() - base;
+
+    ASSERT_LT(sz_compact, sz_normal);
+    ASSERT_TRUE(purc_variant_is_equal_to(compact, normal));
+
+    /* the static parser honors the flag as well */
+    purc_variant_t vt = PURC_VARIANT_INVALID;
+    purc_rwstream_t rws = purc_rwstream_new_from_mem((void*)json.c_str(),
+            json.size());
+    base = array_memory_used();
+    ASSERT_EQ(pcejson_parse_static(&vt, rws, 32,
+                PCEJSON_FLAG_COMPACT_ARRAYS), 0);
+    ASSERT_EQ(array_memory_used() - base, sz_compact);
+    purc_rwstream_destroy(rws);
+    ASSERT_TRUE(purc_variant_is_equal_to(vt, normal));
+    purc_variant_unref(vt);
+
+    /* a compacted array grows as usual */
+    purc_variant_t point = purc_variant_array_get(compact, 1);
+    purc_variant_t z = purc_variant_make_longint(3);
+    for (int i = 0; i < 10; i++)
+        ASSERT_TRUE(purc_variant_array_append(point, z));
+    purc_variant_unref(z);
+    ASSERT_EQ(purc_variant_array_get_size(point), 12U);
+    ASSERT_TRUE(purc_variant_array_remove(point, 0));
+    ASSERT_TRUE(purc_variant_array_insert_before(point, 0,
+                purc_variant_array_get(point, 0)));
+
+    purc_variant_unref(compact);
+    purc_variant_unref(normal);
+}
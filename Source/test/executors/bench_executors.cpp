@@ -0,0 +1,267 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * The benchmarks of the builtin executors; see bench.h for the results.
+ * The size is the number of the members of the synthetic input, and three
+ * costs are measured for every executor:
+ *
+ *  - parse: compiling a rule not seen before and beginning the iteration
+ *    over an input of one member;
+ *  - first: the latency of the first result with a compiled rule;
+ *  - scan: iterating all the results.
+ */
+
+#include "purc.h"
+
+#include "private/executor.h"
+
+#include "../helpers.h"
+#include "../bench.h"
+
+#include <gtest/gtest.h>
+
+#define DEF_BENCH_SIZES         "10,1000"
+
+enum bench_input {
+    BENCH_INPUT_ARRAY,      // [0, 1, ...]
+    BENCH_INPUT_SET,        // a generic set of 0, 1, ...
+    BENCH_INPUT_OBJECT,     // { "k0": 0, "k1": 1, ... }
+    BENCH_INPUT_ROWS,       // [{ "v": 0 }, { "v": 1 }, ...]
+    BENCH_INPUT_STRING,     // "aaa..."
+    BENCH_INPUT_TOKENS,     // "a a a ..."
+    BENCH_INPUT_ZERO,       // 0
+    BENCH_INPUT_SIZE,       // the size
+};
+
+static const char *input_names[] = {
+    "array",
+    "set",
+    "object",
+    "rows",
+    "string",
+    "tokens",
+    "zero",
+    "size",
+};
+
+struct bench_case {
+    const char         *exe;
+    enum bench_input    input;
+    // the rule to iterate; `%zu` is replaced by the size if there is
+    const char         *rule;
+    // the format of the rules to compile, made distinct by `%u`
+    const char         *parse_rule;
+};
+
+static const struct bench_case bench_cases[] = {
+    { "KEY", BENCH_INPUT_OBJECT, "KEY: ALL", "KEY: AS 'k%u'" },
+    { "KEY", BENCH_INPUT_OBJECT, "KEY: AS 'k1'", "KEY: AS 'k1%u'" },
+    { "RANGE", BENCH_INPUT_ARRAY, "RANGE: FROM 0", "RANGE: FROM %u" },
+    { "RANGE", BENCH_INPUT_SET, "RANGE: FROM 0", "RANGE: FROM %u" },
+    { "FILTER", BENCH_INPUT_ARRAY, "FILTER: ALL", "FILTER: LT %u" },
+    { "FILTER", BENCH_INPUT_ARRAY, "FILTER: LT 100", "FILTER: GT %u" },
+    { "FILTER", BENCH_INPUT_SET, "FILTER: LT 100", "FILTER: GT %u" },
+    { "FILTER", BENCH_INPUT_OBJECT, "FILTER: ALL FOR KEY",
+        "FILTER: LT %u FOR KEY" },
+    { "CHAR", BENCH_INPUT_STRING, "CHAR: FROM 0", "CHAR: FROM %u" },
+    { "TOKEN", BENCH_INPUT_TOKENS, "TOKEN: FROM 0", "TOKEN: FROM %u" },
+    { "ADD", BENCH_INPUT_ZERO, "ADD: LT %zu BY 1", "ADD: LT %u BY 1" },
+    { "SUB", BENCH_INPUT_SIZE, "SUB: GT 0 BY 1", "SUB: GT %u BY 1" },
+    { "SQL", BENCH_INPUT_ROWS, "SQL: SELECT v WHERE v < 100",
+        "SQL: SELECT v WHERE v < %u" },
+    { "SQL", BENCH_INPUT_ROWS, "SQL: SELECT * ORDER BY v DESC",
+        "SQL: SELECT * WHERE v > %u ORDER BY v DESC" },
+};
+
+static purc_variant_t
+make_input(enum bench_input type, size_t size)
+{
+    purc_variant_t input = PURC_VARIANT_INVALID;
+    std::string str;
+
+    switch (type) {
+    case BENCH_INPUT_ARRAY:
+    case BENCH_INPUT_ROWS:
+        input = purc_variant_make_array_0();
+        break;
+    case BENCH_INPUT_SET:
+        input = purc_variant_make_set_0(PURC_VARIANT_INVALID);
+        break;
+    case BENCH_INPUT_OBJECT:
+        input = purc_variant_make_object_0();
+        break;
+    case BENCH_INPUT_STRING:
+        str.assign(size, 'a');
+        return purc_variant_make_string(str.c_str(), false);
+    case BENCH_INPUT_TOKENS:
+        for (size_t i = 0; i < size; i++)
+            str += i ? " a" : "a";
+        return purc_variant_make_string(str.c_str(), false);
+    case BENCH_INPUT_ZERO:
+        return purc_variant_make_number(0);
+    case BENCH_INPUT_SIZE:
+        return purc_variant_make_number(size);
+    }
+
+    if (input == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    for (size_t i = 0; i < size; i++) {
+        purc_variant_t v = purc_variant_make_number(i);
+        bool ok;
+
+        if (type == BENCH_INPUT_ARRAY) {
+            ok = purc_variant_array_append(input, v);
+        }
+        else if (type == BENCH_INPUT_SET) {
+            ok = purc_variant_set_add(input, v, false);
+        }
+        else if (type == BENCH_INPUT_OBJECT) {
+            char key[32];
+            snprintf(key, sizeof(key), "k%zu", i);
+            purc_variant_t k = purc_variant_make_string(key, false);
+            ok = k && purc_variant_object_set(input, k, v);
+            if (k)
+                purc_variant_unref(k);
+        }
+        else {
+            purc_variant_t row;
+            row = purc_variant_make_object_by_static_ckey(1, "v", v);
+            ok = row && purc_variant_array_append(input, row);
+            if (row)
+                purc_variant_unref(row);
+        }
+
+        purc_variant_unref(v);
+        if (!ok) {
+            purc_variant_unref(input);
+            return PURC_VARIANT_INVALID;
+        }
+    }
+
+    return input;
+}
+
+static std::string
+format_rule(const char *fmt, size_t size)
+{
+    char rule[128];
+    snprintf(rule, sizeof(rule), fmt, size);
+    return rule;
+}
+
+// returns the number of the results, or -1 on failure
+static ssize_t
+iterate(purc_exec_ops_t ops, purc_variant_t input, const char *rule,
+        bool first_only)
+{
+    purc_exec_inst_t inst = ops->create(PURC_EXEC_TYPE_ITERATE, input, true);
+    if (!inst)
+        return -1;
+
+    ssize_t n = 0;
+    purc_exec_iter_t it = ops->it_begin(inst, rule);
+    if (!it && inst->err_msg)
+        n = -1;
+
+    for (; it; it = ops->it_next(inst, it, NULL)) {
+        if (ops->it_value(inst, it) == PURC_VARIANT_INVALID) {
+            n = -1;
+            break;
+        }
+        n++;
+        if (first_only)
+            break;
+    }
+
+    ops->destroy(inst);
+    return n;
+}
+
+static void
+bench_case(BenchRunner &bench, purc_exec_ops_t ops,
+        const struct bench_case *bc, size_t size)
+{
+    char prefix[64];
+    snprintf(prefix, sizeof(prefix), "%s/%s", bc->exe,
+            input_names[bc->input]);
+    std::string rule = format_rule(bc->rule, size);
+
+    purc_variant_t input = make_input(bc->input, size);
+    ASSERT_NE(input, PURC_VARIANT_INVALID) << prefix;
+
+    // parse: the rules differ in every iteration to miss the cache
+    static unsigned serial;
+    purc_variant_t one = make_input(bc->input, 1);
+    ASSERT_NE(one, PURC_VARIANT_INVALID) << prefix;
+
+    size_t nr_hits, nr_misses, nr_misses_org;
+    pcexecutor_get_rule_cache_stats(&nr_hits, &nr_misses_org);
+
+    size_t nr_parsed = 0;
+    std::string op = std::string(prefix) + "/parse";
+    EXPECT_TRUE(bench.run(op.c_str(), size, [ops, bc, one, &nr_parsed]() {
+        char parse_rule[128];
+        snprintf(parse_rule, sizeof(parse_rule), bc->parse_rule, ++serial);
+        nr_parsed++;
+        return iterate(ops, one, parse_rule, true) >= 0;
+    }));
+    purc_variant_unref(one);
+
+    pcexecutor_get_rule_cache_stats(&nr_hits, &nr_misses);
+    EXPECT_EQ(nr_misses - nr_misses_org, nr_parsed) << prefix;
+
+    // compile the rule before measuring the latency
+    ssize_t nr_results = iterate(ops, input, rule.c_str(), false);
+    ASSERT_GE(nr_results, 0) << rule;
+
+    op = std::string(prefix) + "/first";
+    EXPECT_TRUE(bench.run(op.c_str(), size, [ops, input, &rule, nr_results]() {
+        return iterate(ops, input, rule.c_str(), true) ==
+            (nr_results ? 1 : 0);
+    })) << rule;
+
+    op = std::string(prefix) + "/scan";
+    EXPECT_TRUE(bench.run(op.c_str(), size, [ops, input, &rule, nr_results]() {
+        return iterate(ops, input, rule.c_str(), false) == nr_results;
+    })) << rule;
+
+    purc_variant_unref(input);
+}
+
+TEST(bench_executors, builtin)
+{
+    PurCInstance purc(false);
+    ASSERT_TRUE(purc);
+
+    BenchRunner bench("bench_executors");
+    std::vector<size_t> sizes = BenchRunner::get_sizes(DEF_BENCH_SIZES);
+    ASSERT_FALSE(sizes.empty());
+
+    for (size_t size : sizes) {
+        for (const struct bench_case &bc : bench_cases) {
+            purc_exec_ops_t ops;
+            ASSERT_TRUE(purc_get_executor(bc.exe, &ops)) << bc.exe;
+            bench_case(bench, ops, &bc, size);
+        }
+    }
+
+    ASSERT_TRUE(bench.write_results());
+}
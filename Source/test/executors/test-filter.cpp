@@ -21,6 +21,7 @@
 
 #include "purc-executor.h"
 
+#include "private/executor.h"
 #include "private/utils.h"
 
 #include <gtest/gtest.h>
@@ -110,4 +111,158 @@ TEST(exe_filter, files)
     ASSERT_TRUE(ok);
 }
 
+TEST(exe_filter, rule_cache)
+{
+    purc_instance_extra_info info = {};
+    int r = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test",
+            "exe_filter", &info);
+    ASSERT_EQ(r, PURC_ERROR_OK);
+
+    purc_exec_ops_t ops;
+    ASSERT_TRUE(purc_get_executor("FILTER", &ops));
+
+    purc_variant_t input = purc_variant_make_array_0();
+    for (int i = 0; i < 20; i++) {
+        purc_variant_t v = purc_variant_make_number(i);
+        purc_variant_array_append(input, v);
+        purc_variant_unref(v);
+    }
+
+    size_t hits0, misses0, hits, misses;
+    pcexecutor_get_rule_cache_stats(&hits0, &misses0);
+
+    const char *rule = "FILTER: GT 15";
+    for (int i = 0; i < 3; i++) {
+        purc_exec_inst_t inst;
+        inst = ops->create(PURC_EXEC_TYPE_CHOOSE, input, true);
+        ASSERT_NE(inst, nullptr);
+
+        purc_variant_t v = ops->choose(inst, rule);
+        ASSERT_NE(v, PURC_VARIANT_INVALID);
+        ASSERT_EQ(purc_variant_array_get_size(v), 4);
+        purc_variant_unref(v);
+        ops->destroy(inst);
+    }
+
+    pcexecutor_get_rule_cache_stats(&hits, &misses);
+    ASSERT_EQ(misses - misses0, 1);
+    ASSERT_EQ(hits - hits0, 2);
+
+    purc_variant_unref(input);
+    ASSERT_TRUE(purc_cleanup());
+}
 
+TEST(exe_filter, member_chooser)
+{
+    purc_instance_extra_info info = {};
+    int r = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test",
+            "exe_filter", &info);
+    ASSERT_EQ(r, PURC_ERROR_OK);
+
+    ASSERT_EQ(pcexecutor_get_member_chooser("RANGE: FROM 0"), nullptr);
+
+    const char *rule = "FILTER: GT 15";
+    pcexecutor_member_chooser_f chooser;
+    chooser = pcexecutor_get_member_chooser(rule);
+    ASSERT_NE(chooser, nullptr);
+
+    for (int i = 14; i < 18; i++) {
+        purc_variant_t v = purc_variant_make_number(i);
+        bool chosen = false;
+        ASSERT_EQ(chooser(rule, v, &chosen), 0);
+        ASSERT_EQ(chosen, i > 15);
+        purc_variant_unref(v);
+    }
+
+    ASSERT_TRUE(purc_cleanup());
+}
+
+TEST(exe_filter, bulk_compare)
+{
+    purc_instance_extra_info info = {};
+    int r = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test",
+            "exe_filter", &info);
+    ASSERT_EQ(r, PURC_ERROR_OK);
+
+    purc_exec_ops_t ops;
+    ASSERT_TRUE(purc_get_executor("FILTER", &ops));
+
+    // large enough to be compared in bulk
+    purc_variant_t input = purc_variant_make_array_0();
+    for (int i = 0; i < 200; i++) {
+        purc_variant_t v = (i % 2) ? purc_variant_make_number(i) :
+            purc_variant_make_ulongint(i);
+        purc_variant_array_append(input, v);
+        purc_variant_unref(v);
+    }
+
+    purc_exec_inst_t inst;
+    inst = ops->create(PURC_EXEC_TYPE_CHOOSE, input, true);
+    ASSERT_NE(inst, nullptr);
+
+    purc_variant_t v = ops->choose(inst,
+            "FILTER: GE 10 AND LT 20 OR EQ 150");
+    ASSERT_NE(v, PURC_VARIANT_INVALID);
+    ASSERT_EQ(purc_variant_array_get_size(v), 11);
+    double d = 0;
+    purc_variant_cast_to_number(purc_variant_array_get(v, 0), &d, false);
+    ASSERT_EQ(d, 10);
+    purc_variant_cast_to_number(purc_variant_array_get(v, 10), &d, false);
+    ASSERT_EQ(d, 150);
+    purc_variant_unref(v);
+
+    v = ops->choose(inst, "FILTER: NOT GT 3");
+    ASSERT_NE(v, PURC_VARIANT_INVALID);
+    ASSERT_EQ(purc_variant_array_get_size(v), 4);
+    purc_variant_unref(v);
+
+    ops->destroy(inst);
+
+    purc_variant_unref(input);
+    ASSERT_TRUE(purc_cleanup());
+}
+
+TEST(exe_filter, changed_input)
+{
+    purc_instance_extra_info info = {};
+    int r = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test",
+            "exe_filter", &info);
+    ASSERT_EQ(r, PURC_ERROR_OK);
+
+    purc_exec_ops_t ops;
+    ASSERT_TRUE(purc_get_executor("FILTER", &ops));
+
+    const char *json = "{\"a\":1,\"b\":2,\"c\":3,\"d\":4}";
+    purc_variant_t input = purc_variant_make_from_json_string(json,
+            strlen(json));
+    ASSERT_NE(input, PURC_VARIANT_INVALID);
+
+    const char *rule = "FILTER: ALL FOR KEY";
+    purc_exec_inst_t inst;
+    inst = ops->create(PURC_EXEC_TYPE_ITERATE, input, true);
+    ASSERT_NE(inst, nullptr);
+
+    purc_exec_iter_t it = ops->it_begin(inst, rule);
+    ASSERT_NE(it, nullptr);
+    ASSERT_STREQ(purc_variant_get_string_const(ops->it_value(inst, it)), "a");
+
+    // the member after the current one is removed
+    ASSERT_TRUE(purc_variant_object_remove_by_static_ckey(input, "b", false));
+    it = ops->it_next(inst, it, rule);
+    ASSERT_NE(it, nullptr);
+    ASSERT_STREQ(purc_variant_get_string_const(ops->it_value(inst, it)), "c");
+
+    // the current member is removed
+    ASSERT_TRUE(purc_variant_object_remove_by_static_ckey(input, "c", false));
+    it = ops->it_next(inst, it, rule);
+    ASSERT_NE(it, nullptr);
+    ASSERT_STREQ(purc_variant_get_string_const(ops->it_value(inst, it)), "d");
+
+    it = ops->it_next(inst, it, rule);
+    ASSERT_EQ(it, nullptr);
+
+    ops->destroy(inst);
+
+    purc_variant_unref(input);
+    ASSERT_TRUE(purc_cleanup());
+}
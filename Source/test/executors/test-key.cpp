@@ -25,6 +25,7 @@
 #include <gtest/gtest.h>
 #include <glob.h>
 #include <limits.h>
+#include <vector>
 
 #include "../helpers.h"
 
@@ -136,3 +137,106 @@ TEST(exe_key, files)
     ASSERT_TRUE(ok);
 }
 
+
+static void
+check_keys(purc_exec_ops_t ops, purc_variant_t input, const char *rule,
+        std::vector<const char *> expected)
+{
+    purc_exec_inst_t inst = ops->create(PURC_EXEC_TYPE_CHOOSE, input, true);
+    ASSERT_NE(inst, nullptr);
+
+    purc_variant_t v = ops->choose(inst, rule);
+    ops->destroy(inst);
+    ASSERT_NE(v, PURC_VARIANT_INVALID);
+
+    ASSERT_EQ(purc_variant_array_get_size(v), expected.size()) << rule;
+    for (size_t i = 0; i < expected.size(); i++) {
+        purc_variant_t k = purc_variant_array_get(v, i);
+        ASSERT_STREQ(purc_variant_get_string_const(k), expected[i]) << rule;
+    }
+    purc_variant_unref(v);
+}
+
+TEST(exe_key, prefixes)
+{
+    purc_instance_extra_info info = {};
+    int r = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test", "exe_key",
+            &info);
+    ASSERT_EQ(r, PURC_ERROR_OK);
+
+    purc_exec_ops_t ops;
+    ASSERT_TRUE(purc_get_executor("KEY", &ops));
+
+    const char *json = "{\"ab\":1,\"b\":2,\"a\":3,\"ba\":4,\"c\":5}";
+    purc_variant_t input = purc_variant_make_from_json_string(json,
+            strlen(json));
+    ASSERT_NE(input, PURC_VARIANT_INVALID);
+
+    // the literals match the keys starting with them, in the order of keys
+    check_keys(ops, input, "KEY: AS 'b', 'a' FOR KEY",
+            { "a", "ab", "b", "ba" });
+    check_keys(ops, input, "KEY: AS 'ab', 'z', 'a' FOR KEY", { "a", "ab" });
+    check_keys(ops, input, "KEY: AS 'c' OR AS 'ba' FOR KEY", { "ba", "c" });
+    // not by the prefixes
+    check_keys(ops, input, "KEY: LIKE 'b*' FOR KEY", { "b", "ba" });
+
+    purc_variant_unref(input);
+    ASSERT_TRUE(purc_cleanup());
+}
+
+TEST(exe_key, changed_input)
+{
+    purc_instance_extra_info info = {};
+    int r = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test", "exe_key",
+            &info);
+    ASSERT_EQ(r, PURC_ERROR_OK);
+
+    purc_exec_ops_t ops;
+    ASSERT_TRUE(purc_get_executor("KEY", &ops));
+
+    const char *rules[] = {
+        "KEY: ALL FOR KEY",
+        "KEY: AS 'a', 'b', 'c', 'd' FOR KEY",
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(rules); i++) {
+        const char *rule = rules[i];
+        const char *json = "{\"a\":1,\"b\":2,\"c\":3,\"d\":4}";
+        purc_variant_t input = purc_variant_make_from_json_string(json,
+                strlen(json));
+        ASSERT_NE(input, PURC_VARIANT_INVALID);
+
+        purc_exec_inst_t inst;
+        inst = ops->create(PURC_EXEC_TYPE_ITERATE, input, true);
+        ASSERT_NE(inst, nullptr);
+
+        purc_exec_iter_t it = ops->it_begin(inst, rule);
+        ASSERT_NE(it, nullptr) << rule;
+        ASSERT_STREQ(purc_variant_get_string_const(ops->it_value(inst, it)),
+                "a") << rule;
+
+        // the member after the current one is removed
+        ASSERT_TRUE(purc_variant_object_remove_by_static_ckey(input, "b",
+                    false));
+        it = ops->it_next(inst, it, rule);
+        ASSERT_NE(it, nullptr) << rule;
+        ASSERT_STREQ(purc_variant_get_string_const(ops->it_value(inst, it)),
+                "c") << rule;
+
+        // the current member is removed
+        ASSERT_TRUE(purc_variant_object_remove_by_static_ckey(input, "c",
+                    false));
+        it = ops->it_next(inst, it, rule);
+        ASSERT_NE(it, nullptr) << rule;
+        ASSERT_STREQ(purc_variant_get_string_const(ops->it_value(inst, it)),
+                "d") << rule;
+
+        it = ops->it_next(inst, it, rule);
+        ASSERT_EQ(it, nullptr) << rule;
+
+        ops->destroy(inst);
+        purc_variant_unref(input);
+    }
+
+    ASSERT_TRUE(purc_cleanup());
+}
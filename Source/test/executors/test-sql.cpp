@@ -21,6 +21,8 @@
 
 #include "purc-executor.h"
 
+#include "private/executor.h"
+#include "private/variant.h"
 #include "private/utils.h"
 
 #include <gtest/gtest.h>
@@ -30,6 +32,8 @@
 #include "../helpers.h"
 
 extern "C" {
+#include "pcexe-helper.h"
+#include "exe_sql.h"
 #include "exe_sql.tab.h"
 }
 
@@ -68,9 +72,8 @@ parse(const char *rule, char *err_msg, size_t sz_err_msg)
     r = exe_sql_parse(rule, strlen(rule), &param) == 0;
     if (param.err_msg) {
         snprintf(err_msg, sz_err_msg, "%s", param.err_msg);
-        free(param.err_msg);
-        param.err_msg = NULL;
     }
+    exe_sql_param_reset(&param);
 
     return r;
 }
@@ -105,3 +108,242 @@ TEST(exe_sql, files)
     ASSERT_TRUE(ok);
 }
 
+
+static const char *sql_rows =
+    "["
+    "{\"name\":\"a\",\"locale\":\"zh_CN\",\"rank\":90,\"age\":3},"
+    "{\"name\":\"b\",\"locale\":\"en_US\",\"rank\":80,\"age\":5},"
+    "{\"name\":\"c\",\"locale\":\"zh_TW\",\"rank\":60,\"age\":3},"
+    "{\"name\":\"d\",\"locale\":\"zh_HK\",\"rank\":75,\"age\":5},"
+    "{\"name\":\"e\",\"locale\":\"fr_FR\",\"age\":3}"
+    "]";
+
+static purc_variant_t
+sql_choose(purc_exec_ops_t ops, purc_variant_t input, const char *rule)
+{
+    purc_exec_inst_t inst = ops->create(PURC_EXEC_TYPE_CHOOSE, input, true);
+    if (!inst)
+        return PURC_VARIANT_INVALID;
+
+    purc_variant_t v = ops->choose(inst, rule);
+    ops->destroy(inst);
+    return v;
+}
+
+TEST(exe_sql, choose)
+{
+    purc_instance_extra_info info = {};
+    int r = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test",
+            "exe_sql", &info);
+    ASSERT_EQ(r, PURC_ERROR_OK);
+
+    purc_exec_ops_t ops;
+    ASSERT_TRUE(purc_get_executor("SQL", &ops));
+
+    purc_variant_t input = purc_variant_make_from_json_string(sql_rows,
+            strlen(sql_rows));
+    ASSERT_NE(input, PURC_VARIANT_INVALID);
+
+    purc_variant_t v;
+    v = sql_choose(ops, input, "SQL: SELECT * WHERE locale LIKE 'zh_*'");
+    ASSERT_NE(v, PURC_VARIANT_INVALID);
+    ASSERT_EQ(purc_variant_array_get_size(v), 3);
+    purc_variant_unref(v);
+
+    // an absent `rank` compares false
+    v = sql_choose(ops, input,
+            "SQL: SELECT name WHERE rank > 70 AND locale IN ('zh_CN', 'zh_HK')"
+            " ORDER BY rank DESC");
+    ASSERT_NE(v, PURC_VARIANT_INVALID);
+    ASSERT_EQ(purc_variant_array_get_size(v), 2);
+    purc_variant_t name;
+    name = purc_variant_object_get_by_ckey(purc_variant_array_get(v, 0),
+            "name");
+    ASSERT_STREQ(purc_variant_get_string_const(name), "a");
+    purc_variant_unref(v);
+
+    v = sql_choose(ops, input, "SQL: SELECT (rank + 10) AS r WHERE name = 'c'");
+    ASSERT_NE(v, PURC_VARIANT_INVALID);
+    ASSERT_EQ(purc_variant_numberify(
+                purc_variant_object_get_by_ckey(v, "r")), 70);
+    purc_variant_unref(v);
+
+    v = sql_choose(ops, input, "SQL: SELECT age GROUP BY age ORDER BY age");
+    ASSERT_NE(v, PURC_VARIANT_INVALID);
+    ASSERT_EQ(purc_variant_array_get_size(v), 2);
+    purc_variant_unref(v);
+
+    purc_exec_inst_t inst = ops->create(PURC_EXEC_TYPE_REDUCE, input, true);
+    ASSERT_NE(inst, nullptr);
+    v = ops->reduce(inst, "SQL: SELECT rank GROUP BY age");
+    ops->destroy(inst);
+    ASSERT_NE(v, PURC_VARIANT_INVALID);
+    purc_variant_t stats = purc_variant_object_get_by_ckey(v, "5");
+    ASSERT_NE(stats, PURC_VARIANT_INVALID);
+    ASSERT_EQ(purc_variant_numberify(
+                purc_variant_object_get_by_ckey(stats, "sum")), 155);
+    purc_variant_unref(v);
+
+    // all the items are reduced in one pass, keyed by their names
+    inst = ops->create(PURC_EXEC_TYPE_REDUCE, input, true);
+    ASSERT_NE(inst, nullptr);
+    v = ops->reduce(inst, "SQL: SELECT rank, age GROUP BY age");
+    ops->destroy(inst);
+    ASSERT_NE(v, PURC_VARIANT_INVALID);
+    stats = purc_variant_object_get_by_ckey(v, "3");
+    ASSERT_NE(stats, PURC_VARIANT_INVALID);
+    ASSERT_EQ(purc_variant_numberify(purc_variant_object_get_by_ckey(
+                    purc_variant_object_get_by_ckey(stats, "rank"), "max")),
+            90);
+    ASSERT_EQ(purc_variant_numberify(purc_variant_object_get_by_ckey(
+                    purc_variant_object_get_by_ckey(stats, "age"), "sum")),
+            9);
+    purc_variant_unref(v);
+
+    purc_variant_unref(input);
+    ASSERT_TRUE(purc_cleanup());
+}
+
+// the rows reduced by a rule are many more than the ones of the other tests
+#define NR_LARGE_ROWS       100000
+
+TEST(exe_sql, reduce_large)
+{
+    purc_instance_extra_info info = {};
+    int r = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test",
+            "exe_sql", &info);
+    ASSERT_EQ(r, PURC_ERROR_OK);
+
+    purc_exec_ops_t ops;
+    ASSERT_TRUE(purc_get_executor("SQL", &ops));
+
+    // [{ "id": 0, "rank": 0, "age": 0 }, ...]; every tenth row has no rank,
+    // so no rank ends with 9
+    purc_variant_t input = purc_variant_make_array_0();
+    ASSERT_NE(input, PURC_VARIANT_INVALID);
+    for (size_t i = 0; i < NR_LARGE_ROWS; i++) {
+        purc_variant_t id = purc_variant_make_ulongint(i);
+        purc_variant_t rank = purc_variant_make_number(i % 100);
+        purc_variant_t age = purc_variant_make_number(i % 7);
+        purc_variant_t row = (i % 10 == 9) ?
+            purc_variant_make_object_by_static_ckey(2,
+                    "id", id, "age", age) :
+            purc_variant_make_object_by_static_ckey(3,
+                    "id", id, "rank", rank, "age", age);
+        purc_variant_unref(id);
+        purc_variant_unref(rank);
+        purc_variant_unref(age);
+        ASSERT_NE(row, PURC_VARIANT_INVALID);
+        ASSERT_TRUE(purc_variant_array_append(input, row));
+        purc_variant_unref(row);
+    }
+
+    // the expected stats of the ranks of the rows matched and of a group
+    size_t count = 0, count_of_3 = 0;
+    double sum = 0, sum_of_3 = 0;
+    for (size_t i = 0; i < NR_LARGE_ROWS; i++) {
+        if (i >= NR_LARGE_ROWS / 2)
+            continue;
+        count++;
+        if (i % 7 == 3)
+            count_of_3++;
+        if (i % 10 == 9)
+            continue;
+        sum += i % 100;
+        if (i % 7 == 3)
+            sum_of_3 += i % 100;
+    }
+
+    char rule[128];
+    snprintf(rule, sizeof(rule), "SQL: SELECT rank WHERE id < %d",
+            NR_LARGE_ROWS / 2);
+    purc_exec_inst_t inst = ops->create(PURC_EXEC_TYPE_REDUCE, input, true);
+    ASSERT_NE(inst, nullptr);
+    purc_variant_t v = ops->reduce(inst, rule);
+    ops->destroy(inst);
+    ASSERT_NE(v, PURC_VARIANT_INVALID);
+    ASSERT_EQ(purc_variant_numberify(
+                purc_variant_object_get_by_ckey(v, "count")), count);
+    ASSERT_EQ(purc_variant_numberify(
+                purc_variant_object_get_by_ckey(v, "sum")), sum);
+    ASSERT_EQ(purc_variant_numberify(
+                purc_variant_object_get_by_ckey(v, "max")), 98);
+    ASSERT_EQ(purc_variant_numberify(
+                purc_variant_object_get_by_ckey(v, "min")), 0);
+    purc_variant_unref(v);
+
+    snprintf(rule, sizeof(rule),
+            "SQL: SELECT rank WHERE id < %d GROUP BY age", NR_LARGE_ROWS / 2);
+    inst = ops->create(PURC_EXEC_TYPE_REDUCE, input, true);
+    ASSERT_NE(inst, nullptr);
+    v = ops->reduce(inst, rule);
+    ops->destroy(inst);
+    ASSERT_NE(v, PURC_VARIANT_INVALID);
+    ASSERT_EQ(purc_variant_object_get_size(v), 7);
+    purc_variant_t stats = purc_variant_object_get_by_ckey(v, "3");
+    ASSERT_NE(stats, PURC_VARIANT_INVALID);
+    ASSERT_EQ(purc_variant_numberify(
+                purc_variant_object_get_by_ckey(stats, "count")), count_of_3);
+    ASSERT_EQ(purc_variant_numberify(
+                purc_variant_object_get_by_ckey(stats, "sum")), sum_of_3);
+    purc_variant_unref(v);
+
+    purc_variant_unref(input);
+    ASSERT_TRUE(purc_cleanup());
+}
+
+TEST(exe_sql, set_index)
+{
+    purc_instance_extra_info info = {};
+    int r = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test",
+            "exe_sql", &info);
+    ASSERT_EQ(r, PURC_ERROR_OK);
+
+    purc_exec_ops_t ops;
+    ASSERT_TRUE(purc_get_executor("SQL", &ops));
+
+    purc_variant_t rows = purc_variant_make_from_json_string(sql_rows,
+            strlen(sql_rows));
+    ASSERT_NE(rows, PURC_VARIANT_INVALID);
+
+    purc_variant_t input = purc_variant_make_set_by_ckey(0, "name",
+            PURC_VARIANT_INVALID);
+    ASSERT_NE(input, PURC_VARIANT_INVALID);
+    ssize_t nr_rows = purc_variant_array_get_size(rows);
+    for (ssize_t i = 0; i < nr_rows; i++) {
+        ASSERT_TRUE(purc_variant_set_add(input,
+                    purc_variant_array_get(rows, i), true));
+    }
+
+    const char *rules[] = {
+        "SQL: SELECT name WHERE rank > 70",
+        "SQL: SELECT name WHERE locale = 'zh_TW' OR rank >= 80",
+        "SQL: SELECT name WHERE 75 <= rank AND age = 5",
+        "SQL: SELECT name WHERE locale IN ('zh_CN', 'fr_FR')",
+    };
+
+    // the results are the same with the indexes or without them
+    size_t sizes[PCA_TABLESIZE(rules)];
+    for (size_t i = 0; i < PCA_TABLESIZE(rules); i++) {
+        purc_variant_t v = sql_choose(ops, input, rules[i]);
+        ASSERT_NE(v, PURC_VARIANT_INVALID);
+        sizes[i] = purc_variant_is_array(v) ?
+            purc_variant_array_get_size(v) : 1;
+        purc_variant_unref(v);
+    }
+
+    ASSERT_EQ(pcvariant_set_create_index(input, "rank"), 0);
+    ASSERT_EQ(pcvariant_set_create_index(input, "locale"), 0);
+
+    for (size_t i = 0; i < PCA_TABLESIZE(rules); i++) {
+        purc_variant_t v = sql_choose(ops, input, rules[i]);
+        ASSERT_NE(v, PURC_VARIANT_INVALID);
+        ASSERT_EQ(purc_variant_is_array(v) ?
+                purc_variant_array_get_size(v) : 1, sizes[i]);
+        purc_variant_unref(v);
+    }
+
+    purc_variant_unref(input);
+    purc_variant_unref(rows);
+    ASSERT_TRUE(purc_cleanup());
+}
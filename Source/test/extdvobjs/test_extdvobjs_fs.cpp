@@ -1480,6 +1480,198 @@ TEST(dvobjs, dvobjs_fs_read)
 {
 }
 
+static purc_dvariant_method
+get_method(purc_variant_t obj, const char *name)
+{
+    purc_variant_t dynamic = purc_variant_object_get_by_ckey (obj, name);
+    if (dynamic == PURC_VARIANT_INVALID || !purc_variant_is_dynamic (dynamic))
+        return NULL;
+    return purc_variant_dynamic_get_getter (dynamic);
+}
+
+/* reads all entries by batches of @count, returns the number read */
+static size_t
+read_all_batches(purc_dvariant_method read_batch, purc_variant_t dir,
+        size_t count, const char *filter, bool with_stat, size_t *nr_dirs)
+{
+    purc_variant_t param[3];
+    size_t nr = 0;
+
+    param[0] = purc_variant_make_ulongint (count);
+    param[1] = filter ? purc_variant_make_string (filter, true) :
+        purc_variant_make_null ();
+    param[2] = purc_variant_make_boolean (with_stat);
+
+    *nr_dirs = 0;
+    for (;;) {
+        purc_variant_t batch = read_batch (dir, 3, param, false);
+        if (batch == PURC_VARIANT_INVALID ||
+                !purc_variant_is_array (batch)) {
+            if (batch)
+                purc_variant_unref (batch);
+            break;
+        }
+
+        size_t size = purc_variant_array_get_size (batch);
+        EXPECT_LE(size, count);
+        for (size_t i = 0; i < size; i++) {
+            purc_variant_t entry = purc_variant_array_get (batch, i);
+            purc_variant_t type = purc_variant_object_get_by_ckey (entry,
+                    "type");
+            if (strcmp (purc_variant_get_string_const (type), "d") == 0)
+                (*nr_dirs)++;
+
+            purc_variant_t size_var = purc_variant_object_get_by_ckey (entry,
+                    "size");
+            EXPECT_EQ(size_var != PURC_VARIANT_INVALID, with_stat);
+        }
+        nr += size;
+        purc_variant_unref (batch);
+    }
+
+    for (int i = 0; i < 3; i++)
+        purc_variant_unref (param[i]);
+    return nr;
+}
+
+// more than MIN_PARALLEL_STATS of fs-unix-like.c
+#define NR_MANY_FILES   100
+
+// dir_read_batch
+TEST(dvobjs, dvobjs_fs_read_batch)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex (PURC_MODULE_EJSON, "cn.fmsoft.hvml.test",
+            "dvobjs", &info);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    setenv(PURC_ENVV_DVOBJS_PATH, SOPATH, 1);
+    purc_variant_t fs = purc_variant_load_dvobj_from_so (NULL, "FS");
+    ASSERT_NE(fs, nullptr);
+
+    /* tree/{a.txt,b.md,sub/{c.txt,deep/d.txt}} */
+    char root[] = "/tmp/purc-fs-batch-XXXXXX";
+    ASSERT_NE(mkdtemp (root), nullptr);
+
+    static const char *dirs[] = { "sub", "sub/deep" };
+    static const char *files[] = { "a.txt", "b.md", "sub/c.txt",
+        "sub/deep/d.txt" };
+    char path[PATH_MAX];
+    for (size_t i = 0; i < PCA_TABLESIZE(dirs); i++) {
+        snprintf (path, sizeof(path), "%s/%s", root, dirs[i]);
+        ASSERT_EQ(mkdir (path, 0700), 0);
+    }
+    for (size_t i = 0; i < PCA_TABLESIZE(files); i++) {
+        snprintf (path, sizeof(path), "%s/%s", root, files[i]);
+        FILE *fp = fopen (path, "w");
+        ASSERT_NE(fp, nullptr);
+        fclose (fp);
+    }
+
+    purc_dvariant_method opendir_func = get_method (fs, "opendir");
+    purc_dvariant_method closedir_func = get_method (fs, "closedir");
+    ASSERT_NE(opendir_func, nullptr);
+    ASSERT_NE(closedir_func, nullptr);
+
+    size_t nr_dirs;
+    purc_variant_t param[2];
+    param[0] = purc_variant_make_string (root, true);
+
+    // the top level only
+    purc_variant_t dir = opendir_func (NULL, 1, param, false);
+    ASSERT_NE(dir, nullptr);
+    ASSERT_EQ(purc_variant_is_object (dir), true);
+    purc_dvariant_method read_batch = get_method (dir, "read_batch");
+    ASSERT_NE(read_batch, nullptr);
+
+    ASSERT_EQ(read_all_batches (read_batch, dir, 2, NULL, false, &nr_dirs), 3);
+    ASSERT_EQ(nr_dirs, 1);
+
+    purc_variant_t closed = closedir_func (NULL, 1, &dir, false);
+    ASSERT_EQ(purc_variant_is_true (closed), true);
+    purc_variant_unref (closed);
+    purc_variant_unref (dir);
+
+    // walk the subdirectories with stat, in parallel
+    param[1] = purc_variant_make_string ("recursive parallel", true);
+    dir = opendir_func (NULL, 2, param, false);
+    ASSERT_NE(dir, nullptr);
+    read_batch = get_method (dir, "read_batch");
+
+    ASSERT_EQ(read_all_batches (read_batch, dir, 2, NULL, true, &nr_dirs), 6);
+    ASSERT_EQ(nr_dirs, 2);
+
+    // the filter does not prevent walking the subdirectories
+    purc_dvariant_method rewind = get_method (dir, "rewind");
+    purc_variant_t rewound = rewind (dir, 0, NULL, false);
+    purc_variant_unref (rewound);
+    ASSERT_EQ(read_all_batches (read_batch, dir, 2, "*.txt", false, &nr_dirs),
+            3);
+    ASSERT_EQ(nr_dirs, 0);
+
+    closed = closedir_func (NULL, 1, &dir, false);
+    purc_variant_unref (closed);
+    purc_variant_unref (dir);
+
+    // bad options
+    purc_variant_unref (param[1]);
+    param[1] = purc_variant_make_string ("recursively", true);
+    dir = opendir_func (NULL, 2, param, false);
+    ASSERT_EQ(dir, nullptr);
+
+    purc_variant_unref (param[1]);
+    purc_variant_unref (param[0]);
+
+    // a batch large enough to be stat'ed by several threads
+    char many[] = "/tmp/purc-fs-many-XXXXXX";
+    ASSERT_NE(mkdtemp (many), nullptr);
+    snprintf (path, sizeof(path), "%s/sub", many);
+    ASSERT_EQ(mkdir (path, 0700), 0);
+    for (size_t i = 0; i < NR_MANY_FILES; i++) {
+        snprintf (path, sizeof(path), "%s/sub/%zu.txt", many, i);
+        FILE *fp = fopen (path, "w");
+        ASSERT_NE(fp, nullptr);
+        fclose (fp);
+    }
+
+    param[0] = purc_variant_make_string (many, true);
+    param[1] = purc_variant_make_string ("recursive parallel", true);
+    dir = opendir_func (NULL, 2, param, false);
+    ASSERT_NE(dir, nullptr);
+    read_batch = get_method (dir, "read_batch");
+
+    ASSERT_EQ(read_all_batches (read_batch, dir, 256, NULL, true, &nr_dirs),
+            NR_MANY_FILES + 1);
+    ASSERT_EQ(nr_dirs, 1);
+
+    closed = closedir_func (NULL, 1, &dir, false);
+    purc_variant_unref (closed);
+    purc_variant_unref (dir);
+    purc_variant_unref (param[1]);
+    purc_variant_unref (param[0]);
+
+    for (size_t i = 0; i < NR_MANY_FILES; i++) {
+        snprintf (path, sizeof(path), "%s/sub/%zu.txt", many, i);
+        unlink (path);
+    }
+    snprintf (path, sizeof(path), "%s/sub", many);
+    rmdir (path);
+    rmdir (many);
+
+    for (size_t i = PCA_TABLESIZE(files); i > 0; i--) {
+        snprintf (path, sizeof(path), "%s/%s", root, files[i - 1]);
+        unlink (path);
+    }
+    for (size_t i = PCA_TABLESIZE(dirs); i > 0; i--) {
+        snprintf (path, sizeof(path), "%s/%s", root, dirs[i - 1]);
+        rmdir (path);
+    }
+    rmdir (root);
+
+    purc_variant_unload_dvobj (fs);
+    purc_cleanup ();
+}
+
 // dir_rewind
 TEST(dvobjs, dvobjs_fs_rewind)
 {
@@ -849,6 +849,104 @@ TEST(dvobjs, dvobjs_math_eval)
     purc_cleanup ();
 }
 
+TEST(dvobjs, dvobjs_math_compile)
+{
+    purc_variant_t param[MAX_PARAM_NR];
+    purc_variant_t ret_var = NULL;
+    double number;
+    long double numberl;
+    size_t sz_total_mem_before = 0;
+    size_t sz_total_values_before = 0;
+    size_t nr_reserved_before = 0;
+    size_t sz_total_mem_after = 0;
+    size_t sz_total_values_after = 0;
+    size_t nr_reserved_after = 0;
+
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.hvml.test",
+            "dvobjs", &info);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    get_variant_total_info (&sz_total_mem_before, &sz_total_values_before,
+            &nr_reserved_before);
+
+    setenv(PURC_ENVV_DVOBJS_PATH, SOPATH, 1);
+    purc_variant_t math = purc_variant_load_dvobj_from_so (NULL, "MATH");
+    ASSERT_NE(math, nullptr);
+    ASSERT_EQ(purc_variant_is_object (math), true);
+
+    purc_variant_t dynamic = purc_variant_object_get_by_ckey (math, "compile");
+    ASSERT_NE(dynamic, nullptr);
+    ASSERT_EQ(purc_variant_is_dynamic (dynamic), true);
+
+    purc_dvariant_method func = NULL;
+    func = purc_variant_dynamic_get_getter (dynamic);
+    ASSERT_NE(func, nullptr);
+
+    param[0] = purc_variant_make_string ("(3 + 7", false);
+    ret_var = func (NULL, 1, param, false);
+    ASSERT_EQ(ret_var, nullptr);
+    purc_variant_unref(param[0]);
+
+    param[0] = purc_variant_make_string ("pi * r * r", false);
+    purc_variant_t prog = func (NULL, 1, param, false);
+    purc_variant_unref(param[0]);
+    ASSERT_NE(prog, nullptr);
+    ASSERT_EQ(purc_variant_is_native (prog), true);
+
+    struct purc_native_ops *ops = purc_variant_native_get_ops (prog);
+    void *entity = purc_variant_native_get_entity (prog);
+    purc_nvariant_method eval = ops->property_getter ("eval");
+    purc_nvariant_method eval_l = ops->property_getter ("eval_l");
+    ASSERT_NE(eval, nullptr);
+    ASSERT_NE(eval_l, nullptr);
+
+    /* the variables are bound when evaluating */
+    for (int r = 1; r <= 3; r++) {
+        param[0] = purc_variant_make_object (0, PURC_VARIANT_INVALID,
+                PURC_VARIANT_INVALID);
+        purc_variant_t pi = purc_variant_make_number(M_PI);
+        purc_variant_t radius = purc_variant_make_number(r);
+        purc_variant_object_set_by_static_ckey (param[0], "pi", pi);
+        purc_variant_object_set_by_static_ckey (param[0], "r", radius);
+        purc_variant_unref(radius);
+        purc_variant_unref(pi);
+
+        ret_var = eval (entity, 1, param, false);
+        ASSERT_NE(ret_var, nullptr);
+        ASSERT_EQ(purc_variant_is_type (ret_var, PURC_VARIANT_TYPE_NUMBER),
+                true);
+        purc_variant_cast_to_number (ret_var, &number, false);
+        ASSERT_LT(fabs (number - M_PI * r * r), 0.0001);
+        purc_variant_unref(ret_var);
+
+        ret_var = eval_l (entity, 1, param, false);
+        ASSERT_NE(ret_var, nullptr);
+        ASSERT_EQ(purc_variant_is_type (ret_var,
+                    PURC_VARIANT_TYPE_LONGDOUBLE), true);
+        purc_variant_cast_to_longdouble (ret_var, &numberl, false);
+        ASSERT_LT(fabsl (numberl - M_PI * r * r), 0.0001);
+        purc_variant_unref(ret_var);
+
+        purc_variant_unref(param[0]);
+    }
+
+    /* an unbound variable fails the evaluation */
+    ret_var = eval (entity, 0, param, false);
+    ASSERT_EQ(ret_var, nullptr);
+
+    purc_variant_unref(prog);
+    purc_variant_unload_dvobj (math);
+
+    get_variant_total_info (&sz_total_mem_after,
+            &sz_total_values_after, &nr_reserved_after);
+    ASSERT_EQ(sz_total_values_before, sz_total_values_after);
+    ASSERT_EQ(sz_total_mem_after, sz_total_mem_before + (nr_reserved_after -
+                nr_reserved_before) * sizeof(purc_variant));
+
+    purc_cleanup ();
+}
+
 TEST(dvobjs, dvobjs_math_assignment)
 {
     size_t sz_total_mem_before = 0;
@@ -25,6 +25,7 @@
 #include "config.h"
 
 #include <libgen.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
@@ -34,6 +35,9 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <unistd.h>
+
+#include <string>
 
 #if OS(LINUX) || OS(UNIX)
 // get path from env or __FILE__/../<rel> otherwise
@@ -171,3 +175,112 @@ TEST(local_fetcher, async)
     purc_cleanup();
 #endif                        /* } */
 }
+
+static void write_test_file(const char *dir, const char *name,
+        const char *content)
+{
+    char path[PATH_MAX + 1];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    FILE *fp = fopen(path, "w");
+    ASSERT_NE(fp, nullptr);
+    fputs(content, fp);
+    fclose(fp);
+}
+
+static std::string fetch_bundled(const char *url, int *ret_code,
+        std::string *mime)
+{
+    struct pcfetcher_resp_header resp_header = {};
+    purc_rwstream_t resp = pcfetcher_request_sync(url,
+            PCFETCHER_REQUEST_METHOD_GET, NULL, 10, &resp_header);
+
+    std::string body;
+    *ret_code = resp_header.ret_code;
+    if (resp) {
+        size_t sz;
+        const char *mem = (const char *)purc_rwstream_get_mem_buffer(resp,
+                &sz);
+        body.assign(mem, sz);
+        purc_rwstream_destroy(resp);
+    }
+    if (resp_header.mime_type) {
+        *mime = resp_header.mime_type;
+        free(resp_header.mime_type);
+    }
+    return body;
+}
+
+TEST(local_fetcher, bundle)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hybridos.test",
+            "bundle", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    char dir[] = "/tmp/purc-bundle-XXXXXX";
+    ASSERT_NE(mkdtemp(dir), nullptr);
+
+    char sub[sizeof(dir) + sizeof("/assets")];
+    snprintf(sub, sizeof(sub), "%s/assets", dir);
+    ASSERT_EQ(mkdir(sub, 0755), 0);
+
+    const char *hvml = "<hvml target=\"html\"><body>hello</body></hvml>";
+    std::string json = "[";
+    for (int i = 0; i < 100; i++)
+        json += "{\"id\": 1}, ";
+    json += "{}]";
+    write_test_file(dir, "index.hvml", hvml);
+    write_test_file(sub, "data.json", json.c_str());
+
+    char file[PATH_MAX + 1];
+    snprintf(file, sizeof(file), "%s.bundle", dir);
+
+    unsigned int flags = PURC_BUNDLE_FLAG_COMPRESS |
+        PURC_BUNDLE_FLAG_VDOM_CACHE;
+    ret = purc_bundle_make(dir, file, flags);
+    if (ret && purc_get_last_error() == PURC_ERROR_NOT_SUPPORTED) {
+        /* built without zlib */
+        ret = purc_bundle_make(dir, file, PURC_BUNDLE_FLAG_VDOM_CACHE);
+    }
+    ASSERT_EQ(ret, 0);
+
+    ASSERT_EQ(purc_bundle_mount(file, "app"), 0);
+    ASSERT_EQ(purc_bundle_mount(file, "app"), -1);
+    ASSERT_EQ(purc_get_last_error(), PURC_ERROR_EXISTS);
+
+    int ret_code;
+    std::string mime;
+    ASSERT_EQ(fetch_bundled("bundle://app/index.hvml", &ret_code, &mime),
+            hvml);
+    ASSERT_EQ(ret_code, 200);
+    ASSERT_EQ(mime, "text/hvml");
+
+    ASSERT_EQ(fetch_bundled("bundle://app/assets/data.json?x=1", &ret_code,
+                &mime), json);
+    ASSERT_EQ(ret_code, 200);
+    ASSERT_EQ(mime, "application/json");
+
+    fetch_bundled("bundle://app/none.json", &ret_code, &mime);
+    ASSERT_EQ(ret_code, 404);
+    fetch_bundled("bundle://other/index.hvml", &ret_code, &mime);
+    ASSERT_EQ(ret_code, 404);
+
+    /* loaded from the vDOM cache in the bundle */
+    purc_vdom_t vdom = purc_load_hvml_from_url("bundle://app/index.hvml");
+    ASSERT_NE(vdom, nullptr);
+
+    unlink(file);
+
+    /* not a bundle */
+    snprintf(file, sizeof(file), "%s/index.hvml", dir);
+    ASSERT_EQ(purc_bundle_mount(file, "broken"), -1);
+    ASSERT_EQ(purc_get_last_error(), PURC_ERROR_INVALID_VALUE);
+
+    unlink(file);
+    snprintf(file, sizeof(file), "%s/data.json", sub);
+    unlink(file);
+    rmdir(sub);
+    rmdir(dir);
+
+    purc_cleanup();
+}
@@ -0,0 +1,181 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * The benchmarks of parsing, loading, and serializing the HTML documents;
+ * see bench.h for the results. The size is the number of the paragraphs.
+ */
+
+#include "purc.h"
+
+#include "private/html.h"
+
+#include "../helpers.h"
+#include "../bench.h"
+
+#include <gtest/gtest.h>
+
+#define DEF_BENCH_SIZES         "10,1000"
+
+/* the size of a chunk when parsing a document in chunks, like the
+   documents written by `write_more` */
+#define SZ_BENCH_CHUNK          256
+
+struct bench_doc {
+    const char         *name;
+    const char         *line;   // a paragraph of the document
+};
+
+static const struct bench_doc bench_docs[] = {
+    { "text",
+        "<p>The quick brown fox jumps over the lazy dog; the lazy dog "
+        "sleeps under the warm sun, and the fox runs away &amp; hides "
+        "in the woods until the night comes.</p>\n" },
+    { "attributes",
+        "<a href=\"https://www.example.com/path/to/the/page?a=1&amp;b=2\" "
+        "title='A link to the page of the example site' "
+        "class=\"link link-external link-highlighted\">link</a>\n" },
+    { "cjk",
+        "<p>\xe6\x95\x8f\xe6\x8d\xb7\xe7\x9a\x84\xe6\xa3\x95"
+        "\xe8\x89\xb2\xe7\x8b\x90\xe7\x8b\xb8\xe8\xb7\xb3"
+        "\xe8\xbf\x87\xe4\xba\x86\xe9\x82\xa3\xe5\x8f\xaa"
+        "\xe6\x87\x92\xe7\x8b\x97\xe3\x80\x82</p>\n" },
+};
+
+static std::string
+make_document(size_t size)
+{
+    std::string html = "<!DOCTYPE html>\n<html><head><title>bench"
+        "</title></head><body>\n";
+    for (size_t i = 0; i < size; i++) {
+        html.append("<p class=\"note\" id=\"p");
+        html.append(std::to_string(i));
+        html.append("\">The quick brown fox jumps over the lazy dog "
+                "&amp; runs away.</p>\n");
+    }
+    html.append("</body></html>\n");
+    return html;
+}
+
+static std::string
+make_document(const struct bench_doc *doc, size_t size)
+{
+    std::string html = "<!DOCTYPE html>\n<html><head><title>";
+    html.append(doc->name);
+    html.append("</title></head><body>\n");
+    for (size_t i = 0; i < size; i++)
+        html.append(doc->line);
+    html.append("</body></html>\n");
+    return html;
+}
+
+/* parses the document in chunks of @chunk bytes */
+static bool
+parse_document(const std::string &html, size_t chunk)
+{
+    pchtml_html_document_t *doc = pchtml_html_document_create();
+    if (doc == NULL)
+        return false;
+
+    unsigned int ur = pchtml_html_document_parse_chunk_begin(doc);
+    for (size_t i = 0; ur == PCHTML_STATUS_OK && i < html.size(); i += chunk) {
+        size_t len = std::min(chunk, html.size() - i);
+        ur = pchtml_html_document_parse_chunk(doc,
+                (const unsigned char *)html.c_str() + i, len);
+    }
+    if (ur == PCHTML_STATUS_OK)
+        ur = pchtml_html_document_parse_chunk_end(doc);
+
+    pchtml_html_document_destroy(doc);
+    return ur == PCHTML_STATUS_OK;
+}
+
+TEST(bench_html, documents)
+{
+    PurCInstance purc(false);
+    ASSERT_TRUE(purc);
+
+    BenchRunner bench("bench_html");
+    std::vector<size_t> sizes = BenchRunner::get_sizes(DEF_BENCH_SIZES);
+    ASSERT_FALSE(sizes.empty());
+
+    for (size_t size : sizes) {
+        for (const struct bench_doc &doc : bench_docs) {
+            std::string html = make_document(&doc, size);
+            std::string op = std::string("parse/") + doc.name;
+
+            EXPECT_TRUE(bench.run(op.c_str(), size, [&html]() {
+                return parse_document(html, html.size());
+            }));
+
+            op += "/chunked";
+            EXPECT_TRUE(bench.run(op.c_str(), size, [&html]() {
+                return parse_document(html, SZ_BENCH_CHUNK);
+            }));
+        }
+
+        std::string html = make_document(size);
+
+        EXPECT_TRUE(bench.run("load", size, [&html]() {
+            purc_document_t doc = purc_document_load(PCDOC_K_TYPE_HTML,
+                    html.c_str(), html.size());
+            if (doc == NULL)
+                return false;
+            purc_document_delete(doc);
+            return true;
+        }));
+
+        EXPECT_TRUE(bench.run("load/transient", size, [&html]() {
+            purc_document_t doc = purc_document_load_transient(
+                    PCDOC_K_TYPE_HTML, html.c_str(), html.size());
+            if (doc == NULL)
+                return false;
+            purc_document_delete(doc);
+            return true;
+        }));
+
+        EXPECT_TRUE(bench.run("load/compact", size, [&html]() {
+            purc_document_t doc = purc_document_load_compact(html.c_str(),
+                    html.size());
+            if (doc == NULL)
+                return false;
+            purc_document_delete(doc);
+            return true;
+        }));
+
+        purc_document_t doc = purc_document_load(PCDOC_K_TYPE_HTML,
+                html.c_str(), html.size());
+        ASSERT_NE(doc, nullptr);
+
+        EXPECT_TRUE(bench.run("serialize", size, [doc]() {
+            purc_rwstream_t rws = purc_rwstream_new_buffer(1024, 0);
+            if (rws == NULL)
+                return false;
+            int ret = purc_document_serialize_contents_to_stream(doc,
+                    PCDOC_SERIALIZE_OPT_UNDEF, rws);
+            purc_rwstream_destroy(rws);
+            return ret == 0;
+        }));
+
+        purc_document_delete(doc);
+    }
+
+    ASSERT_TRUE(bench.write_results());
+}
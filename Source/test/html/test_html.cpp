@@ -1062,3 +1062,52 @@ TEST(html, html_parser_specialchars)
 
     printf(" OK\n");
 }
+
+TEST(html, html_serialize_long_text)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex (PURC_MODULE_HTML, "cn.fmsoft.hybridos.test",
+            "test_init", &info);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    // long clean runs with the special chars around the 16-byte boundaries
+    std::string escaped;
+    for (size_t i = 0; i < 4096; i++) {
+        if (i % 37 == 15 || i % 37 == 16) {
+            escaped += "&amp;";
+        }
+        else if (i % 101 == 31) {
+            escaped += "&lt;";
+        }
+        else if (i % 211 == 32) {
+            escaped += "&nbsp;";
+        }
+        else {
+            escaped += (char)('a' + i % 26);
+        }
+    }
+
+    std::string html = "<html><body><p>" + escaped + "</p></body></html>";
+
+    pchtml_html_document_t *doc = pchtml_html_document_create();
+    ASSERT_NE(doc, nullptr);
+
+    purc_rwstream_t rwstream = purc_rwstream_new_from_mem(
+            (void *)html.c_str(), html.length());
+    unsigned int status = pchtml_html_document_parse(doc, rwstream);
+    purc_rwstream_destroy (rwstream);
+    ASSERT_EQ(status, PCHTML_STATUS_OK);
+
+    char buf[64];
+    size_t sz = sizeof(buf);
+    char *p = pchtml_doc_snprintf_plain(doc, buf, &sz, "");
+    ASSERT_NE(p, nullptr);
+    std::string out(p, sz);
+    if (p != buf)
+        free(p);
+
+    ASSERT_NE(out.find("<p>" + escaped + "</p>"), std::string::npos);
+
+    pchtml_html_document_destroy(doc);
+    purc_cleanup ();
+}
@@ -31,6 +31,8 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 
+#include <string>
+
 // test html parser for whole html file
 TEST(html, html_parser_html_file_x)
 {
@@ -622,3 +624,149 @@ TEST(html, collection)
     purc_cleanup ();
 }
 
+
+static std::string
+serialize_html_doc(pchtml_html_document_t *doc)
+{
+    purc_rwstream_t io = purc_rwstream_new_buffer(1024, 1024 * 1024 * 16);
+    if (io == NULL)
+        return "";
+
+    pchtml_doc_write_to_stream(doc, io);
+
+    size_t size = 0;
+    const char *buffer = (const char *)purc_rwstream_get_mem_buffer(io, &size);
+    std::string result(buffer, size);
+    purc_rwstream_destroy(io);
+    return result;
+}
+
+// a large chunk is tokenized on a helper thread; the result must be the
+// same as the one got by feeding small chunks
+TEST(html, html_parser_large_chunk)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex (PURC_MODULE_HTML, "cn.fmsoft.hybridos.test",
+            "test_init", &info);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    static const char block[] =
+        "<div class=\"item\" id=\"item\" data-x>"
+        "<p title='a &amp; b'>Some <b>bold</b> and <i>italic</i> text</p>"
+        "<x-widget x-attr=\"1\" another-attr>custom &lt;tag&gt;</x-widget>"
+        "<textarea name=\"t\"><b>not a tag</b></textarea>"
+        "<script>if (a < b && c > d) { document.write('</div>'); }</script>"
+        "<style>p > b { color: red; }</style>"
+        "<svg><![CDATA[ raw <data> ]]><circle r=\"1\"/></svg>"
+        "<!-- a comment -->"
+        "<table><tr><td>cell</td></tr></table>"
+        "</div>\n";
+
+    std::string html = "<!DOCTYPE html><html><head><title>Large "
+        "<document></title></head><body>";
+    while (html.size() < 256 * 1024) {
+        html += block;
+    }
+    html += "<plaintext></body></html> and more";
+
+    pchtml_html_document_t *doc_large = pchtml_html_document_create();
+    ASSERT_NE(doc_large, nullptr);
+    unsigned int ur = pchtml_html_document_parse_chunk_begin(doc_large);
+    ASSERT_EQ(ur, PCHTML_STATUS_OK);
+    ur = pchtml_html_document_parse_chunk(doc_large,
+            (const unsigned char *)html.c_str(), html.size());
+    ASSERT_EQ(ur, PCHTML_STATUS_OK);
+    ur = pchtml_html_document_parse_chunk_end(doc_large);
+    ASSERT_EQ(ur, PCHTML_STATUS_OK);
+
+    pchtml_html_document_t *doc_small = pchtml_html_document_create();
+    ASSERT_NE(doc_small, nullptr);
+    ur = pchtml_html_document_parse_chunk_begin(doc_small);
+    ASSERT_EQ(ur, PCHTML_STATUS_OK);
+    for (size_t pos = 0; pos < html.size(); pos += 1000) {
+        size_t len = html.size() - pos;
+        if (len > 1000)
+            len = 1000;
+        ur = pchtml_html_document_parse_chunk(doc_small,
+                (const unsigned char *)html.c_str() + pos, len);
+        ASSERT_EQ(ur, PCHTML_STATUS_OK);
+    }
+    ur = pchtml_html_document_parse_chunk_end(doc_small);
+    ASSERT_EQ(ur, PCHTML_STATUS_OK);
+
+    std::string large = serialize_html_doc(doc_large);
+    std::string small = serialize_html_doc(doc_small);
+    ASSERT_GT(large.size(), 256 * 1024);
+    ASSERT_EQ(large, small);
+
+    pchtml_html_document_destroy(doc_large);
+    pchtml_html_document_destroy(doc_small);
+
+    purc_cleanup ();
+}
+
+static std::string
+parse_and_serialize(const std::string &html, size_t chunk)
+{
+    std::string result;
+    pchtml_html_document_t *doc = pchtml_html_document_create();
+    if (doc == NULL)
+        return result;
+
+    unsigned int ur = pchtml_html_document_parse_chunk_begin(doc);
+    for (size_t i = 0; ur == PCHTML_STATUS_OK && i < html.size(); i += chunk) {
+        size_t len = std::min(chunk, html.size() - i);
+        ur = pchtml_html_document_parse_chunk(doc,
+                (const unsigned char *)html.c_str() + i, len);
+    }
+    if (ur == PCHTML_STATUS_OK)
+        ur = pchtml_html_document_parse_chunk_end(doc);
+
+    purc_rwstream_t io = purc_rwstream_new_buffer(1024, 1024 * 1024);
+    if (ur == PCHTML_STATUS_OK && io &&
+            pchtml_doc_write_to_stream_ex(doc,
+                PCHTML_HTML_SERIALIZE_OPT_WITHOUT_TEXT_INDENT, io) == 0) {
+        size_t size = 0;
+        const char *buf = (const char *)purc_rwstream_get_mem_buffer(io,
+                &size);
+        result.assign(buf, size);
+    }
+
+    if (io)
+        purc_rwstream_destroy(io);
+    pchtml_html_document_destroy(doc);
+    return result;
+}
+
+// the long runs of the text and the attribute values are scanned in chunks
+TEST(html, html_parser_long_runs)
+{
+    int ret = purc_init_ex(PURC_MODULE_HTML, "cn.fmsoft.hybridos.test",
+            "test_init", NULL);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    std::string run(45, 'x');
+    std::string html = "<html><body><p title=\"" + run + " &amp; 'a' " + run +
+        "\" class='" + run + " \"b\" &lt;" + run + "'>" + run + " &lt; " +
+        run + "\r\n" + run + "\r" + run + " good for 我 me " + run +
+        "</p></body></html>";
+
+    std::string whole = parse_and_serialize(html, html.size());
+    ASSERT_FALSE(whole.empty());
+
+    EXPECT_NE(whole.find("title=\"" + run + " &amp; &#039;a&#039; " + run +
+                "\""), std::string::npos) << whole;
+    EXPECT_NE(whole.find(run + " &lt; " + run + "\n" + run + "\n" + run),
+            std::string::npos) << whole;
+    EXPECT_NE(whole.find(" good for 我 me " + run + "\n</p>"),
+            std::string::npos) << whole;
+    EXPECT_EQ(whole.find('\r'), std::string::npos) << whole;
+
+    /* the same result wherever the chunks end */
+    static const size_t chunks[] = { 1, 7, 16, 31, 33 };
+    for (size_t chunk : chunks) {
+        EXPECT_EQ(parse_and_serialize(html, chunk), whole) << chunk;
+    }
+
+    purc_cleanup();
+}
@@ -18,6 +18,8 @@
 */
 
 #include "purc.h"
+#include "private/executor.h"
+#include "private/instance.h"
 #include "private/utils.h"
 #include "../helpers.h"
 
@@ -57,4 +59,44 @@ TEST(interpreter, purc_init)
     }
 }
 
+TEST(interpreter, init_on_demand)
+{
+    purc_instance_extra_info extra_info = {};
+    extra_info.renderer_prot = PURC_RDRPROT_HEADLESS;
+
+    int r = purc_init_ex(PURC_MODULE_HVML, "foo", "bar", &extra_info);
+    ASSERT_EQ(r, 0);
+
+    struct pcinst *inst = pcinst_current();
+    ASSERT_NE(inst, nullptr);
+
+    /* the executors are initialized by the first use */
+    ASSERT_EQ(inst->executor_heap, nullptr);
+
+    struct pcexec_ops ops;
+    ASSERT_EQ(pcexecutor_get_by_rule("KEY: ALL", &ops), 0);
+    ASSERT_NE(inst->executor_heap, nullptr);
 
+    purc_variant_t report = pcinst_make_startup_report(inst);
+    ASSERT_NE(report, PURC_VARIANT_INVALID);
+
+    purc_variant_t modules = purc_variant_object_get_by_ckey(report,
+            "modules");
+    ASSERT_NE(modules, PURC_VARIANT_INVALID);
+    ASSERT_NE(purc_variant_object_get_by_ckey(modules, "executor"),
+            PURC_VARIANT_INVALID);
+    ASSERT_NE(purc_variant_object_get_by_ckey(report, "total"),
+            PURC_VARIANT_INVALID);
+
+    /* the builtin variables are made by the initializers */
+    uint64_t u64 = 0;
+    purc_variant_t v = purc_variant_object_get_by_ckey(report, "values");
+    ASSERT_TRUE(v && purc_variant_cast_to_ulongint(v, &u64, false));
+    ASSERT_GT(u64, 0);
+    v = purc_variant_object_get_by_ckey(report, "memory");
+    ASSERT_TRUE(v && purc_variant_cast_to_ulongint(v, &u64, false));
+    ASSERT_GT(u64, 0);
+    purc_variant_unref(report);
+
+    purc_cleanup();
+}
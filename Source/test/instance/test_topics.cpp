@@ -0,0 +1,164 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "purc.h"
+
+#include <gtest/gtest.h>
+
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#define NR_SUBSCRIBERS      8
+#define TOPIC_NAME          "feed"
+#define MAX_WAIT_ROUNDS     500      // 10ms per round
+
+struct subscriber_arg {
+    pthread_barrier_t  *ready;
+    int                 nr;
+    bool                ok;
+    /* the data delivered */
+    const void         *data;
+};
+
+static bool
+check_message(struct subscriber_arg *arg, pcrdr_msg *msg)
+{
+    const char *str;
+
+    if (msg->type != PCRDR_MSG_TYPE_EVENT ||
+            msg->target != PCRDR_MSG_TARGET_COROUTINE ||
+            msg->targetValue != PURC_EVENT_TARGET_BROADCAST)
+        return false;
+
+    str = purc_variant_get_string_const(msg->eventName);
+    if (str == NULL || strcmp(str, PURC_EVENT_TYPE_TOPIC ":" TOPIC_NAME))
+        return false;
+
+    str = purc_variant_get_string_const(msg->elementValue);
+    if (str == NULL || strcmp(str, PURC_PREDEF_VARNAME_RUNNER))
+        return false;
+
+    purc_variant_t price = purc_variant_object_get_by_ckey(msg->data, "price");
+    double d;
+    if (price == PURC_VARIANT_INVALID ||
+            !purc_variant_cast_to_number(price, &d, false) || d != 100)
+        return false;
+
+    /* the data delivered is immutable */
+    purc_variant_t num = purc_variant_make_number(0);
+    bool changed = purc_variant_object_set_by_static_ckey(msg->data,
+            "price", num);
+    purc_variant_unref(num);
+    if (changed || purc_get_last_error() != PURC_ERROR_ACCESS_DENIED)
+        return false;
+
+    arg->data = msg->data;
+    return true;
+}
+
+static void *
+subscriber_entry(void *data)
+{
+    struct subscriber_arg *arg = (struct subscriber_arg *)data;
+    char runner[32];
+
+    snprintf(runner, sizeof(runner), "subscriber%d", arg->nr);
+    int ret = purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.purc.test",
+            runner, NULL);
+    bool ready = (ret == PURC_ERROR_OK) &&
+        purc_inst_create_move_buffer(0, 16) != 0 &&
+        purc_inst_subscribe_topic(TOPIC_NAME) == 0 &&
+        /* subscribing again has no effect */
+        purc_inst_subscribe_topic(TOPIC_NAME) == 0;
+    pthread_barrier_wait(arg->ready);
+
+    if (ready) {
+        size_t n = 0;
+        for (int i = 0; i < MAX_WAIT_ROUNDS; i++) {
+            if (purc_inst_holding_messages_count(&n) || n > 0)
+                break;
+            usleep(10000);
+        }
+
+        if (n == 1) {
+            pcrdr_msg *msg = purc_inst_take_away_message(0);
+            arg->ok = msg && check_message(arg, msg);
+            if (msg)
+                pcrdr_release_message(msg);
+        }
+
+        purc_inst_destroy_move_buffer();
+    }
+
+    if (ret == PURC_ERROR_OK)
+        purc_cleanup();
+    return NULL;
+}
+
+/* one publication is delivered to all subscribers, sharing the data */
+TEST(topics, publish)
+{
+    pthread_t threads[NR_SUBSCRIBERS];
+    struct subscriber_arg args[NR_SUBSCRIBERS] = {};
+    pthread_barrier_t ready;
+
+    ASSERT_EQ(purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.purc.test",
+                "publisher", NULL), PURC_ERROR_OK);
+
+    ASSERT_EQ(pthread_barrier_init(&ready, NULL, NR_SUBSCRIBERS + 1), 0);
+    for (int i = 0; i < NR_SUBSCRIBERS; i++) {
+        args[i].ready = &ready;
+        args[i].nr = i;
+        ASSERT_EQ(pthread_create(threads + i, NULL, subscriber_entry,
+                    args + i), 0);
+    }
+    pthread_barrier_wait(&ready);
+
+    ASSERT_EQ(purc_inst_publish_topic("nobody", PURC_VARIANT_INVALID), 0);
+    ASSERT_EQ(purc_inst_publish_topic("not a token", PURC_VARIANT_INVALID),
+            -1);
+    ASSERT_EQ(purc_inst_unsubscribe_topic(TOPIC_NAME), -1);
+    ASSERT_EQ(purc_get_last_error(), PURC_ERROR_NOT_EXISTS);
+
+    const char *json = "{ 'symbol': 'HVML', 'price': 100 }";
+    purc_variant_t data = purc_variant_make_from_json_string(json,
+            strlen(json));
+    ASSERT_NE(data, PURC_VARIANT_INVALID);
+    EXPECT_EQ(purc_inst_publish_topic(TOPIC_NAME, data),
+            (ssize_t)NR_SUBSCRIBERS);
+
+    /* the publisher keeps its own data */
+    purc_variant_t num = purc_variant_make_number(200);
+    EXPECT_TRUE(purc_variant_object_set_by_static_ckey(data, "price", num));
+    purc_variant_unref(num);
+    purc_variant_unref(data);
+
+    for (int i = 0; i < NR_SUBSCRIBERS; i++) {
+        pthread_join(threads[i], NULL);
+        EXPECT_TRUE(args[i].ok) << "subscriber " << i;
+        EXPECT_EQ(args[i].data, args[0].data);
+    }
+    pthread_barrier_destroy(&ready);
+
+    /* the instances cleaned up are unsubscribed */
+    ASSERT_EQ(purc_inst_publish_topic(TOPIC_NAME, PURC_VARIANT_INVALID), 0);
+
+    purc_cleanup();
+}
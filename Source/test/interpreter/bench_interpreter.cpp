@@ -0,0 +1,106 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * The benchmarks of running the HVML programs; see bench.h for the
+ * results. A program is loaded once for every size, and a coroutine
+ * runs it to the end in an iteration. The size is the number of the
+ * iterations in the program.
+ */
+
+#include "purc.h"
+
+#include "../helpers.h"
+#include "../bench.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#define DEF_BENCH_SIZES         "10,1000"
+
+static const struct {
+    const char     *operation;
+    const char     *hvml;       // `%zu` is replaced with the size
+} bench_programs[] = {
+    { "run/iterate",
+        "<!DOCTYPE hvml>"
+        "<hvml target=\"void\">"
+        "    <body>"
+        "        <iterate on 0 onlyif $L.lt($0<, %zu)"
+        "                with $EJSON.arith('+', $0<, 1) nosetotail >"
+        "        </iterate>"
+        "    </body>"
+        "</hvml>" },
+    { "run/update",
+        "<!DOCTYPE hvml>"
+        "<hvml target=\"void\">"
+        "    <body>"
+        "        <init as \"rows\" with [] />"
+        "        <iterate on 0 onlyif $L.lt($0<, %zu)"
+        "                with $EJSON.arith('+', $0<, 1) nosetotail >"
+        "            <update on $rows to \"append\""
+        "                    with { id: $?, name: \"row\" } />"
+        "        </iterate>"
+        "    </body>"
+        "</hvml>" },
+};
+
+static size_t nr_exited;
+
+static int
+cond_handler(purc_cond_t event, void *arg, void *data)
+{
+    (void)arg;
+    (void)data;
+
+    if (event == PURC_COND_COR_EXITED)
+        nr_exited++;
+    return 0;
+}
+
+TEST(bench_interpreter, programs)
+{
+    PurCInstance purc(false);
+    ASSERT_TRUE(purc);
+
+    BenchRunner bench("bench_interpreter");
+    std::vector<size_t> sizes = BenchRunner::get_sizes(DEF_BENCH_SIZES);
+    ASSERT_FALSE(sizes.empty());
+
+    for (size_t size : sizes) {
+        for (const auto &p : bench_programs) {
+            char hvml[1024];
+            snprintf(hvml, sizeof(hvml), p.hvml, size);
+            purc_vdom_t vdom = purc_load_hvml_from_string(hvml);
+            ASSERT_NE(vdom, nullptr) << p.operation;
+
+            EXPECT_TRUE(bench.run(p.operation, size, [vdom]() {
+                if (purc_schedule_vdom_null(vdom) == NULL)
+                    return false;
+                nr_exited = 0;
+                purc_run(cond_handler);
+                return nr_exited == 1;
+            })) << p.operation;
+        }
+    }
+
+    ASSERT_TRUE(bench.write_results());
+}
@@ -0,0 +1,153 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "purc.h"
+#include "private/instance.h"
+#include "private/interpreter.h"
+
+#include <gtest/gtest.h>
+
+#include <sys/time.h>
+#include <unistd.h>
+
+#define NR_PIPES                200
+#define NR_ROUNDS               100
+
+struct fdmon_bench {
+    purc_runloop_t  runloop;
+    int             pipes[NR_PIPES][2];
+    uintptr_t       monitors[NR_PIPES];
+    size_t          nr_rounds;
+    size_t          nr_left;
+    size_t          nr_events;
+};
+
+static struct fdmon_bench bench;
+
+static double
+current_time_ms(void)
+{
+    struct timeval now;
+    gettimeofday(&now, 0);
+    return now.tv_sec * 1000.0 + now.tv_usec / 1000.0;
+}
+
+static void
+write_all_pipes(void *ctxt)
+{
+    (void)ctxt;
+
+    bench.nr_left = NR_PIPES;
+    for (size_t i = 0; i < NR_PIPES; i++) {
+        char c = 'a';
+        ASSERT_EQ(write(bench.pipes[i][1], &c, 1), 1);
+    }
+}
+
+static bool
+on_readable(int fd, purc_runloop_io_event event, void *ctxt)
+{
+    (void)ctxt;
+
+    if (event & PCRUNLOOP_IO_IN) {
+        char c;
+        if (read(fd, &c, 1) == 1) {
+            bench.nr_events++;
+            if (--bench.nr_left == 0) {
+                if (++bench.nr_rounds == NR_ROUNDS) {
+                    purc_runloop_stop(bench.runloop);
+                }
+                else {
+                    write_all_pipes(NULL);
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+static double
+run_bench(purc_runloop_fdmon backend, struct pcintr_fdmon_stat *stat)
+{
+    purc_instance_extra_info info = {};
+    info.fd_monitor = backend;
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hybridos.test",
+            "test_fdmon", &info);
+    if (ret != PURC_ERROR_OK)
+        return -1;
+
+    memset(&bench, 0, sizeof(bench));
+    bench.runloop = purc_runloop_get_current();
+
+    for (size_t i = 0; i < NR_PIPES; i++) {
+        if (pipe(bench.pipes[i]))
+            return -1;
+        bench.monitors[i] = purc_runloop_add_fd_monitor(bench.runloop,
+                bench.pipes[i][0], PCRUNLOOP_IO_IN, on_readable, NULL);
+        if (bench.monitors[i] == 0)
+            return -1;
+    }
+
+    double started = current_time_ms();
+    purc_runloop_dispatch(bench.runloop, write_all_pipes, NULL);
+    purc_runloop_run();
+    double elapsed = current_time_ms() - started;
+
+    struct pcintr_heap *heap = pcinst_current()->intr_heap;
+    memset(stat, 0, sizeof(*stat));
+    if (heap->fdmon) {
+        pcintr_fdmon_get_stat(heap->fdmon, stat);
+    }
+
+    for (size_t i = 0; i < NR_PIPES; i++) {
+        purc_runloop_remove_fd_monitor(bench.runloop, bench.monitors[i]);
+        close(bench.pipes[i][0]);
+        close(bench.pipes[i][1]);
+    }
+
+    purc_cleanup();
+    return elapsed;
+}
+
+TEST(fdmon, glib_vs_epoll)
+{
+    struct pcintr_fdmon_stat stat;
+
+    double glib_time = run_bench(PCRUNLOOP_FDMON_GLIB, &stat);
+    ASSERT_GE(glib_time, 0.0);
+    ASSERT_EQ(bench.nr_events, (size_t)NR_PIPES * NR_ROUNDS);
+    ASSERT_EQ(stat.nr_dispatches, 0U);
+
+    double epoll_time = run_bench(PCRUNLOOP_FDMON_EPOLL, &stat);
+    ASSERT_GE(epoll_time, 0.0);
+    ASSERT_EQ(bench.nr_events, (size_t)NR_PIPES * NR_ROUNDS);
+
+#if OS(LINUX)
+    ASSERT_EQ(stat.nr_watches, (size_t)NR_PIPES);
+    ASSERT_EQ(stat.nr_events, (size_t)NR_PIPES * NR_ROUNDS);
+    ASSERT_GT(stat.max_batch, 1U);
+    fprintf(stderr, "epoll: %zu events in %zu batches (max %zu)\n",
+            stat.nr_events, stat.nr_dispatches, stat.max_batch);
+#endif
+
+    fprintf(stderr, "%d pipes x %d rounds: GLib %.3f ms, epoll %.3f ms\n",
+            NR_PIPES, NR_ROUNDS, glib_time, epoll_time);
+}
+
@@ -36,15 +36,21 @@
 
 #define NR_WORKERS  5
 
-static struct purc_instance_extra_info worker_info = {
-    PURC_RDRPROT_HEADLESS,
-    "file:///tmp/" APP_NAME ".log",
-    "sslCert",
-    "sslKey",
-    "workspaceName",
-    "workspaceTitle",
-    "<html></html>",            // workspaceLayout
-};
+static struct purc_instance_extra_info make_worker_info(void)
+{
+    // the members not given are zero for the defaults
+    struct purc_instance_extra_info info = { };
+    info.renderer_prot = PURC_RDRPROT_HEADLESS;
+    info.renderer_uri = "file:///tmp/" APP_NAME ".log";
+    info.ssl_cert = "sslCert";
+    info.ssl_key = "sslKey";
+    info.workspace_name = "workspaceName";
+    info.workspace_title = "workspaceTitle";
+    info.workspace_layout = "<html></html>";
+    return info;
+}
+
+static struct purc_instance_extra_info worker_info = make_worker_info();
 
 static const char *cond_names[] = {
     "PURC_COND_STARTED",
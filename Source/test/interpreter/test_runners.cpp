@@ -8,6 +8,8 @@
  *      - purc_get_rid_by_cid()
  *      - purc_inst_ask_to_shutdown()
  *      - purc_schedule_vdom()
+ *      - purc_runner_pool_xxx()
+ *      - purc_inst_set_pool()
  *      - Instance Manager/Move Buffer
  *
  * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
@@ -34,18 +36,27 @@
 #include "../helpers.h"
 
 #include <gtest/gtest.h>
+#include <sched.h>
+
+#include <atomic>
 
 #define NR_WORKERS  5
 
-static struct purc_instance_extra_info worker_info = {
-    PURC_RDRPROT_HEADLESS,
-    "file:///tmp/" APP_NAME ".log",
-    "sslCert",
-    "sslKey",
-    "workspaceName",
-    "workspaceTitle",
-    "<html></html>",            // workspaceLayout
-};
+static struct purc_instance_extra_info make_worker_info(void)
+{
+    // the members not given are zero for the defaults
+    struct purc_instance_extra_info info = { };
+    info.renderer_prot = PURC_RDRPROT_HEADLESS;
+    info.renderer_uri = "file:///tmp/" APP_NAME ".log";
+    info.ssl_cert = "sslCert";
+    info.ssl_key = "sslKey";
+    info.workspace_name = "workspaceName";
+    info.workspace_title = "workspaceTitle";
+    info.workspace_layout = "<html></html>";
+    return info;
+}
+
+static struct purc_instance_extra_info worker_info = make_worker_info();
 
 static const char *cond_names[] = {
     "PURC_COND_STARTED",
@@ -223,3 +234,290 @@ TEST(interpreter, runners)
     purc_variant_unref(toolkit_style);
 }
 
+
+#define NR_POOL_WORKERS     3
+#define NR_POOL_JOBS        30
+
+static std::atomic<size_t> nr_pool_exited;
+
+static int pool_cond_handler(purc_cond_t event, void *arg, void *data)
+{
+    (void)arg;
+    (void)data;
+
+    if (event == PURC_COND_COR_EXITED) {
+        nr_pool_exited++;
+    }
+
+    return 0;
+}
+
+static const char *pool_hvml =
+    "<hvml target=\"void\">"
+    "    <body>"
+    "        <iterate on 0 onlyif $L.lt($0<, 100)"
+    "                with $EJSON.arith('+', $0<, 1) nosetotail >"
+    "        </iterate>"
+    "    </body>"
+    "</hvml>";
+
+TEST(interpreter, runner_pool)
+{
+    struct purc_instance_extra_info inst_info = { };
+    inst_info.renderer_prot = PURC_RDRPROT_HEADLESS;
+    inst_info.workspace_name = "main";
+
+    PurCInstance purc(PURC_MODULE_HVML, APP_NAME, "main", &inst_info);
+    ASSERT_TRUE(purc);
+
+    purc_vdom_t vdom = purc_load_hvml_from_string(pool_hvml);
+    ASSERT_NE(vdom, nullptr);
+
+    purc_runner_pool_t pool = purc_runner_pool_create(APP_NAME, "pool",
+            NR_POOL_WORKERS, pool_cond_handler, &worker_info);
+    ASSERT_NE(pool, nullptr);
+    ASSERT_EQ(purc_runner_pool_nr_workers(pool), (size_t)NR_POOL_WORKERS);
+
+    purc_variant_t request =
+        purc_variant_make_from_json_string(request_json,
+                strlen(request_json));
+    ASSERT_NE(request, nullptr);
+
+    nr_pool_exited = 0;
+    for (int i = 0; i < NR_POOL_JOBS; i++) {
+        int ret = purc_runner_pool_schedule_vdom(pool, vdom,
+                (i % 2) ? request : PURC_VARIANT_INVALID, NULL);
+        ASSERT_EQ(ret, 0);
+    }
+    purc_variant_unref(request);
+
+    unsigned int seconds = 0;
+    while (nr_pool_exited < NR_POOL_JOBS) {
+        sleep(1);
+        seconds++;
+        ASSERT_LT(seconds, 10);
+    }
+
+    size_t nr_run = 0;
+    purc_atom_t rids[NR_POOL_WORKERS];
+    for (size_t i = 0; i < NR_POOL_WORKERS; i++) {
+        struct purc_runner_pool_stat stat;
+        ASSERT_EQ(purc_runner_pool_get_stat(pool, i, &stat), 0);
+        ASSERT_NE(stat.rid, 0);
+        ASSERT_EQ(stat.nr_pending, 0);
+        rids[i] = stat.rid;
+        nr_run += stat.nr_run;
+        purc_log_info("worker %u: %u run, %u stolen\n", (unsigned)i,
+                (unsigned)stat.nr_run, (unsigned)stat.nr_stolen);
+    }
+    ASSERT_EQ(nr_run, (size_t)NR_POOL_JOBS);
+
+    struct purc_runner_pool_stat stat;
+    ASSERT_EQ(purc_runner_pool_get_stat(pool, NR_POOL_WORKERS, &stat), -1);
+
+    ASSERT_EQ(purc_runner_pool_destroy(pool), 0);
+
+    for (size_t i = 0; i < NR_POOL_WORKERS; i++) {
+        seconds = 0;
+        while (purc_atom_to_string(rids[i])) {
+            sleep(1);
+            seconds++;
+            ASSERT_LT(seconds, 10);
+        }
+    }
+}
+
+static const char *shared_hvml =
+    "<hvml target=\"void\">"
+    "    <body>"
+    "        <iterate on 0 onlyif $L.lt($0<, 100)"
+    "                with $EJSON.arith('+', $0<, 1) nosetotail >"
+    "            <test on=\"$EJSON.arith('+', $?, 0)\">"
+    "                <match for=\"EQ 1\" exclusively></match>"
+    "                <match for=\"EQ 2\" exclusively></match>"
+    "            </test>"
+    "        </iterate>"
+    "    </body>"
+    "</hvml>";
+
+/* the vDOM loaded with lazy attributes is run by all workers at the same
+   time; the attributes are unpacked and compiled by whichever is first */
+TEST(interpreter, runner_pool_shared_vdom)
+{
+    struct purc_instance_extra_info inst_info = { };
+    inst_info.renderer_prot = PURC_RDRPROT_HEADLESS;
+    inst_info.workspace_name = "main";
+    inst_info.lazy_attr_vcm = true;
+
+    PurCInstance purc(PURC_MODULE_HVML, APP_NAME, "main", &inst_info);
+    ASSERT_TRUE(purc);
+
+    purc_vdom_t vdom = purc_load_hvml_from_string(shared_hvml);
+    ASSERT_NE(vdom, nullptr);
+
+    purc_runner_pool_t pool = purc_runner_pool_create(APP_NAME, "shared",
+            NR_POOL_WORKERS, pool_cond_handler, &worker_info);
+    ASSERT_NE(pool, nullptr);
+
+    nr_pool_exited = 0;
+    for (int i = 0; i < NR_POOL_JOBS; i++) {
+        int ret = purc_runner_pool_schedule_vdom(pool, vdom,
+                PURC_VARIANT_INVALID, NULL);
+        ASSERT_EQ(ret, 0);
+    }
+
+    unsigned int seconds = 0;
+    while (nr_pool_exited < NR_POOL_JOBS) {
+        sleep(1);
+        seconds++;
+        ASSERT_LT(seconds, 10);
+    }
+
+    purc_atom_t rids[NR_POOL_WORKERS];
+    for (size_t i = 0; i < NR_POOL_WORKERS; i++) {
+        struct purc_runner_pool_stat stat;
+        ASSERT_EQ(purc_runner_pool_get_stat(pool, i, &stat), 0);
+        rids[i] = stat.rid;
+    }
+
+    ASSERT_EQ(purc_runner_pool_destroy(pool), 0);
+
+    for (size_t i = 0; i < NR_POOL_WORKERS; i++) {
+        seconds = 0;
+        while (purc_atom_to_string(rids[i])) {
+            sleep(1);
+            seconds++;
+            ASSERT_LT(seconds, 10);
+        }
+    }
+}
+
+/* the pool is filled by the instance manager when it is idle */
+static bool wait_pool_idle(size_t nr_idle)
+{
+    for (int i = 0; i < 1000; i++) {
+        struct purc_inst_pool_stat stat;
+        if (purc_inst_get_pool_stat(&stat) == 0 && stat.nr_idle == nr_idle)
+            return true;
+        usleep(10000);
+    }
+    return false;
+}
+
+TEST(interpreter, inst_pool)
+{
+    struct purc_instance_extra_info inst_info = { };
+    inst_info.renderer_prot = PURC_RDRPROT_HEADLESS;
+    inst_info.workspace_name = "main";
+
+    PurCInstance purc(PURC_MODULE_HVML, APP_NAME, "main", &inst_info);
+    ASSERT_TRUE(purc);
+
+    ASSERT_EQ(purc_inst_get_pool_stat(NULL), -1);
+    ASSERT_EQ(purc_inst_set_pool(2, true), 0);
+    ASSERT_TRUE(wait_pool_idle(2));
+
+    struct purc_inst_pool_stat before;
+    ASSERT_EQ(purc_inst_get_pool_stat(&before), 0);
+
+    for (int i = 0; i < 3; i++) {
+        ASSERT_TRUE(wait_pool_idle(2));
+
+        char name[sizeof("pooled") + 10];
+        sprintf(name, "pooled%d", i);
+
+        purc_atom_t rid = purc_inst_create_or_get(APP_NAME, name,
+                NULL, &worker_info);
+        ASSERT_NE(rid, 0);
+
+        char endpoint[PURC_LEN_ENDPOINT_NAME + 1];
+        purc_assemble_endpoint_name_ex(PCRDR_LOCALHOST, APP_NAME, name,
+                endpoint, sizeof(endpoint));
+        ASSERT_STREQ(purc_atom_to_string(rid), endpoint);
+
+        purc_inst_ask_to_shutdown(rid);
+        unsigned int seconds = 0;
+        while (purc_atom_to_string(rid)) {
+            sleep(1);
+            seconds++;
+            ASSERT_LT(seconds, 10);
+        }
+    }
+
+    /* all instances are run in the threads of the pool */
+    ASSERT_TRUE(wait_pool_idle(2));
+    struct purc_inst_pool_stat after;
+    ASSERT_EQ(purc_inst_get_pool_stat(&after), 0);
+    ASSERT_EQ(after.nr_reused - before.nr_reused, (size_t)3);
+
+    ASSERT_EQ(purc_inst_set_pool(0, false), 0);
+    ASSERT_TRUE(wait_pool_idle(0));
+}
+
+static std::atomic<int> affinity_cpu;
+
+static int affinity_cond_handler(purc_cond_t event, void *arg, void *data)
+{
+    (void)arg;
+    (void)data;
+
+    /* called in the thread of the instance */
+    if (event == PURC_COND_STARTED) {
+        affinity_cpu = sched_getcpu();
+    }
+
+    return 0;
+}
+
+TEST(interpreter, runner_affinity)
+{
+    struct purc_instance_extra_info inst_info = { };
+    inst_info.renderer_prot = PURC_RDRPROT_HEADLESS;
+    inst_info.workspace_name = "main";
+
+    PurCInstance purc(PURC_MODULE_HVML, APP_NAME, "main", &inst_info);
+    ASSERT_TRUE(purc);
+
+    /* the last CPU the process is allowed to run on */
+    cpu_set_t allowed;
+    ASSERT_EQ(sched_getaffinity(0, sizeof(allowed), &allowed), 0);
+    int cpu = CPU_SETSIZE - 1;
+    while (cpu > 0 && !CPU_ISSET(cpu, &allowed))
+        cpu--;
+
+    char cpus[16];
+    snprintf(cpus, sizeof(cpus), "%d", cpu);
+
+    struct purc_instance_extra_info info = worker_info;
+    info.cpu_affinity = cpus;
+
+    affinity_cpu = -1;
+    purc_atom_t rid = purc_inst_create_or_get(APP_NAME, "bound",
+            affinity_cond_handler, &info);
+    ASSERT_NE(rid, 0);
+    ASSERT_EQ(affinity_cpu, cpu);
+
+    purc_inst_ask_to_shutdown(rid);
+    unsigned int seconds = 0;
+    while (purc_atom_to_string(rid)) {
+        sleep(1);
+        seconds++;
+        ASSERT_LT(seconds, 10);
+    }
+
+    /* every machine has node 0 */
+    info.cpu_affinity = NULL;
+    info.numa_nodes = "0";
+    purc_runner_pool_t pool = purc_runner_pool_create(APP_NAME, "numa",
+            NR_POOL_WORKERS, NULL, &info);
+    ASSERT_NE(pool, nullptr);
+
+    for (size_t i = 0; i < NR_POOL_WORKERS; i++) {
+        struct purc_runner_pool_stat stat;
+        ASSERT_EQ(purc_runner_pool_get_stat(pool, i, &stat), 0);
+        ASSERT_EQ(stat.node, 0);
+        ASSERT_EQ(stat.nr_stolen_remote, 0);
+    }
+
+    ASSERT_EQ(purc_runner_pool_destroy(pool), 0);
+}
@@ -0,0 +1,255 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "purc.h"
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+#include <sys/time.h>
+
+#include <string>
+
+#define NR_IDLE_COROUTINES      10000
+#define NR_BUSY_ITERATIONS      1000
+
+static const char *idle_hvml =
+    "<!DOCTYPE hvml>"
+    "<hvml target=\"void\">"
+    "    <body>"
+    "        <observe on=\"$CRTN\" for=\"idle\">"
+    "            <exit with=\"idle\" />"
+    "        </observe>"
+    "    </body>"
+    "</hvml>";
+
+static const char *busy_hvml =
+    "<!DOCTYPE hvml>"
+    "<hvml target=\"void\">"
+    "    <body>"
+    "        <iterate on 0 onlyif $L.lt($0<, 1000)"
+    "                with $EJSON.arith('+', $0<, 1) nosetotail >"
+    "        </iterate>"
+    "    </body>"
+    "</hvml>";
+
+struct bench_info {
+    purc_coroutine_t    busy_cor;
+    double              time_started;
+    double              time_busy_exited;
+    size_t              nr_exited;
+};
+
+static struct bench_info bench;
+
+static double
+current_time_ms(void)
+{
+    struct timeval now;
+    gettimeofday(&now, 0);
+    return now.tv_sec * 1000.0 + now.tv_usec / 1000.0;
+}
+
+static int my_cond_handler(purc_cond_t event, void *arg, void *data)
+{
+    (void)data;
+
+    if (event == PURC_COND_COR_EXITED) {
+        if ((purc_coroutine_t)arg == bench.busy_cor) {
+            bench.time_busy_exited = current_time_ms();
+        }
+        bench.nr_exited++;
+    }
+
+    return 0;
+}
+
+/* the busy coroutine should finish in a time independent of
+   the number of idle coroutines sharing the same instance. */
+TEST(scheduler, idle_coroutines_and_one_busy)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hybridos.test",
+            "test_scheduler", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    purc_vdom_t idle_vdom = purc_load_hvml_from_string(idle_hvml);
+    ASSERT_NE(idle_vdom, nullptr);
+
+    purc_vdom_t busy_vdom = purc_load_hvml_from_string(busy_hvml);
+    ASSERT_NE(busy_vdom, nullptr);
+
+    for (size_t i = 0; i < NR_IDLE_COROUTINES; i++) {
+        purc_coroutine_t cor = purc_schedule_vdom_null(idle_vdom);
+        ASSERT_NE(cor, nullptr);
+    }
+
+    bench.busy_cor = purc_schedule_vdom_null(busy_vdom);
+    ASSERT_NE(bench.busy_cor, nullptr);
+
+    bench.time_started = current_time_ms();
+    purc_run(my_cond_handler);
+
+    ASSERT_EQ(bench.nr_exited, (size_t)NR_IDLE_COROUTINES + 1);
+    ASSERT_GT(bench.time_busy_exited, 0.0);
+
+    fprintf(stderr, "%d idle coroutines + 1 busy coroutine "
+            "(%d iterations): busy one exited in %.3f ms\n",
+            NR_IDLE_COROUTINES, NR_BUSY_ITERATIONS,
+            bench.time_busy_exited - bench.time_started);
+
+    bool cleanup = purc_cleanup();
+    ASSERT_EQ(cleanup, true);
+}
+
+#define MY_IDLE_PERIOD          5
+
+/* the idle events should be fired in the period set for the instance */
+TEST(scheduler, idle_period)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hybridos.test",
+            "test_scheduler", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    ASSERT_EQ(purc_set_idle_period(MY_IDLE_PERIOD), 100U);
+    ASSERT_EQ(purc_set_idle_period(MY_IDLE_PERIOD), (unsigned)MY_IDLE_PERIOD);
+
+    purc_vdom_t vdom = purc_load_hvml_from_string(idle_hvml);
+    ASSERT_NE(vdom, nullptr);
+
+    memset(&bench, 0, sizeof(bench));
+    bench.busy_cor = purc_schedule_vdom_null(vdom);
+    ASSERT_NE(bench.busy_cor, nullptr);
+
+    bench.time_started = current_time_ms();
+    purc_run(my_cond_handler);
+
+    ASSERT_EQ(bench.nr_exited, 1U);
+    /* far less than the default period */
+    ASSERT_LT(bench.time_busy_exited - bench.time_started, 80.0);
+
+    bool cleanup = purc_cleanup();
+    ASSERT_EQ(cleanup, true);
+}
+
+static const char *sleeping_hvml =
+    "<!DOCTYPE hvml>"
+    "<hvml target=\"void\">"
+    "    <body>"
+    "        <init as \"rem\" with $SYS.sleep(0.3) />"
+    "        <exit with $rem />"
+    "    </body>"
+    "</hvml>";
+
+static purc_coroutine_t sleeping_cor;
+static double time_sleeping_exited;
+
+static int sleep_cond_handler(purc_cond_t event, void *arg, void *data)
+{
+    if (event == PURC_COND_COR_EXITED && (purc_coroutine_t)arg == sleeping_cor)
+        time_sleeping_exited = current_time_ms();
+
+    return my_cond_handler(event, arg, data);
+}
+
+/* $SYS.sleep should not stall the other coroutines of the instance */
+TEST(scheduler, system_sleep_yields)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hybridos.test",
+            "test_scheduler", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    purc_vdom_t sleeping_vdom = purc_load_hvml_from_string(sleeping_hvml);
+    ASSERT_NE(sleeping_vdom, nullptr);
+
+    purc_vdom_t busy_vdom = purc_load_hvml_from_string(busy_hvml);
+    ASSERT_NE(busy_vdom, nullptr);
+
+    memset(&bench, 0, sizeof(bench));
+    time_sleeping_exited = 0;
+    sleeping_cor = purc_schedule_vdom_null(sleeping_vdom);
+    ASSERT_NE(sleeping_cor, nullptr);
+    bench.busy_cor = purc_schedule_vdom_null(busy_vdom);
+    ASSERT_NE(bench.busy_cor, nullptr);
+
+    bench.time_started = current_time_ms();
+    purc_run(sleep_cond_handler);
+
+    ASSERT_EQ(bench.nr_exited, 2U);
+    ASSERT_GT(bench.time_busy_exited, 0.0);
+    ASSERT_GT(time_sleeping_exited, 0.0);
+
+    /* the busy one ran while the other was sleeping */
+    EXPECT_LT(bench.time_busy_exited, time_sleeping_exited);
+    EXPECT_GE(time_sleeping_exited - bench.time_started, 290.0);
+
+    bool cleanup = purc_cleanup();
+    ASSERT_EQ(cleanup, true);
+}
+
+static const char *async_hvml =
+    "<!DOCTYPE hvml>"
+    "<hvml target=\"void\">"
+    "    <body>"
+    "        <init as \"digest\""
+    "                with $EJSON.md5('HVML', 'lowercase', 'async') />"
+    "        <exit with $digest.value />"
+    "    </body>"
+    "</hvml>";
+
+static std::string async_result;
+
+static int async_cond_handler(purc_cond_t event, void *arg, void *data)
+{
+    if (event == PURC_COND_COR_EXITED) {
+        struct purc_cor_exit_info *info = (struct purc_cor_exit_info *)data;
+        const char *str = purc_variant_get_string_const(info->result);
+        if (str)
+            async_result = str;
+    }
+
+    return my_cond_handler(event, arg, NULL);
+}
+
+/* the coroutine resumes with the result of an asynchronous method */
+TEST(scheduler, async_method)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hybridos.test",
+            "test_scheduler", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    purc_vdom_t vdom = purc_load_hvml_from_string(async_hvml);
+    ASSERT_NE(vdom, nullptr);
+
+    memset(&bench, 0, sizeof(bench));
+    async_result.clear();
+    bench.busy_cor = purc_schedule_vdom_null(vdom);
+    ASSERT_NE(bench.busy_cor, nullptr);
+
+    purc_run(async_cond_handler);
+
+    ASSERT_EQ(bench.nr_exited, 1U);
+    EXPECT_STREQ(async_result.c_str(), "b2565228770ec540692d8a0cfcd3a990");
+
+    bool cleanup = purc_cleanup();
+    ASSERT_EQ(cleanup, true);
+}
@@ -0,0 +1,146 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "purc.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+static const char *counter_hvml =
+    "<!DOCTYPE hvml>"
+    "<hvml target=\"void\">"
+    "    <head>"
+    "        <init as=\"result\" with=\"$seed\" />"
+    "    </head>"
+    "    <body>"
+    "        <init as=\"local\" with=\"$result\" />"
+    "    </body>"
+    "</hvml>";
+
+static const char *other_hvml =
+    "<!DOCTYPE hvml>"
+    "<hvml target=\"void\">"
+    "    <body>"
+    "    </body>"
+    "</hvml>";
+
+struct snapshot_info {
+    bool                take_snapshot;
+    std::string         snapshot;
+    int64_t             result;
+};
+
+static struct snapshot_info snap;
+
+static int my_cond_handler(purc_cond_t event, void *arg, void *data)
+{
+    (void)data;
+
+    if (event == PURC_COND_COR_EXITED) {
+        purc_coroutine_t cor = (purc_coroutine_t)arg;
+
+        purc_variant_t v = purc_coroutine_get_variable(cor, "result");
+        if (v == PURC_VARIANT_INVALID ||
+                !purc_variant_cast_to_longint(v, &snap.result, false))
+            snap.result = -1;
+
+        if (snap.take_snapshot) {
+            purc_rwstream_t stm = purc_rwstream_new_buffer(0, 0);
+            if (purc_coroutine_snapshot(cor, stm) == 0) {
+                size_t sz;
+                const char *buf = (const char *)
+                    purc_rwstream_get_mem_buffer(stm, &sz);
+                snap.snapshot.assign(buf, sz);
+            }
+            purc_rwstream_destroy(stm);
+        }
+    }
+
+    return 0;
+}
+
+static purc_coroutine_t
+schedule_with_seed(purc_vdom_t vdom, int64_t seed)
+{
+    purc_coroutine_t cor = purc_schedule_vdom_null(vdom);
+    if (cor) {
+        purc_variant_t v = purc_variant_make_longint(seed);
+        purc_coroutine_bind_variable(cor, "seed", v);
+        purc_variant_unref(v);
+    }
+    return cor;
+}
+
+static int
+restore_from(purc_coroutine_t cor, const std::string &snapshot)
+{
+    purc_rwstream_t stm = purc_rwstream_new_from_mem(
+            (void *)snapshot.c_str(), snapshot.size());
+    int r = purc_coroutine_restore(cor, stm);
+    purc_rwstream_destroy(stm);
+    return r;
+}
+
+/* the restored variables are not initialized again */
+TEST(snapshot, restore)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hybridos.test",
+            "test_snapshot", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    purc_vdom_t vdom = purc_load_hvml_from_string(counter_hvml);
+    ASSERT_NE(vdom, nullptr);
+
+    snap.take_snapshot = true;
+    ASSERT_NE(schedule_with_seed(vdom, 1), nullptr);
+    purc_run(my_cond_handler);
+    ASSERT_EQ(snap.result, 1);
+    ASSERT_FALSE(snap.snapshot.empty());
+
+    /* the value of `result` comes from the snapshot, not from `$seed` */
+    snap.take_snapshot = false;
+    purc_coroutine_t cor = schedule_with_seed(vdom, 2);
+    ASSERT_NE(cor, nullptr);
+    ASSERT_EQ(restore_from(cor, snap.snapshot), 0);
+    ASSERT_EQ(restore_from(cor, snap.snapshot), -1);
+    ASSERT_EQ(purc_get_last_error(), PURC_ERROR_WRONG_STAGE);
+    purc_run(my_cond_handler);
+    ASSERT_EQ(snap.result, 1);
+
+    /* without the snapshot */
+    ASSERT_NE(schedule_with_seed(vdom, 2), nullptr);
+    purc_run(my_cond_handler);
+    ASSERT_EQ(snap.result, 2);
+
+    /* a snapshot of another program is refused */
+    purc_vdom_t other = purc_load_hvml_from_string(other_hvml);
+    ASSERT_NE(other, nullptr);
+    cor = purc_schedule_vdom_null(other);
+    ASSERT_NE(cor, nullptr);
+    ASSERT_EQ(restore_from(cor, snap.snapshot), -1);
+    ASSERT_EQ(purc_get_last_error(), PURC_ERROR_INVALID_VALUE);
+    ASSERT_EQ(restore_from(cor, "{ broken"), -1);
+    purc_run(my_cond_handler);
+
+    bool cleanup = purc_cleanup();
+    ASSERT_EQ(cleanup, true);
+}
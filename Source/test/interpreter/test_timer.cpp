@@ -0,0 +1,177 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "purc.h"
+#include "private/timer.h"
+
+#include <gtest/gtest.h>
+
+#include <sys/time.h>
+
+#define NR_ONESHOT_TIMERS       200
+#define NR_REPEATS              5
+
+struct timer_info {
+    double      started;
+    unsigned    nr_fired;
+    unsigned    nr_early;
+    unsigned    nr_repeated;
+    bool        self_destroyed;
+    unsigned    nr_self_repeated;
+};
+
+static struct timer_info info;
+
+static double
+current_time_ms(void)
+{
+    struct timeval now;
+    gettimeofday(&now, 0);
+    return now.tv_sec * 1000.0 + now.tv_usec / 1000.0;
+}
+
+static void
+check_all_done(void)
+{
+    if (info.nr_fired == NR_ONESHOT_TIMERS &&
+            info.nr_repeated == NR_REPEATS && info.self_destroyed &&
+            info.nr_self_repeated == NR_REPEATS) {
+        purc_runloop_stop(purc_runloop_get_current());
+    }
+}
+
+static void
+on_oneshot(pcintr_timer_t timer, const char *id, void *data)
+{
+    (void)id;
+    (void)data;
+
+    /* allow one tick for rounding */
+    double elapsed = current_time_ms() - info.started;
+    if (elapsed + 1 < pcintr_timer_get_interval(timer))
+        info.nr_early++;
+
+    ASSERT_FALSE(pcintr_timer_is_active(timer));
+    info.nr_fired++;
+    check_all_done();
+}
+
+static void
+on_repeat(pcintr_timer_t timer, const char *id, void *data)
+{
+    (void)id;
+    (void)data;
+
+    ASSERT_TRUE(pcintr_timer_is_active(timer));
+    if (++info.nr_repeated == NR_REPEATS)
+        pcintr_timer_stop(timer);
+    check_all_done();
+}
+
+static void
+on_self_destroy(pcintr_timer_t timer, const char *id, void *data)
+{
+    (void)id;
+    (void)data;
+
+    pcintr_timer_destroy(timer);
+    info.self_destroyed = true;
+    check_all_done();
+}
+
+static void
+on_self_destroy_repeat(pcintr_timer_t timer, const char *id, void *data)
+{
+    (void)id;
+    (void)data;
+
+    // destroyed by the callback of its last repeat
+    if (++info.nr_self_repeated == NR_REPEATS)
+        pcintr_timer_destroy(timer);
+    check_all_done();
+}
+
+static void
+on_never(pcintr_timer_t timer, const char *id, void *data)
+{
+    (void)timer;
+    (void)id;
+    (void)data;
+
+    ADD_FAILURE() << "a stopped timer fired";
+}
+
+TEST(timer, wheel)
+{
+    purc_instance_extra_info extra_info = {};
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hybridos.test",
+            "test_timer", &extra_info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    pcintr_timer_t oneshots[NR_ONESHOT_TIMERS];
+
+    info.started = current_time_ms();
+    for (int i = 0; i < NR_ONESHOT_TIMERS; i++) {
+        // many timers share the same deadline
+        oneshots[i] = pcintr_timer_create(NULL, NULL, on_oneshot, NULL);
+        ASSERT_NE(oneshots[i], nullptr);
+        pcintr_timer_set_interval(oneshots[i], (i % 20) * 15);
+        pcintr_timer_start_oneshot(oneshots[i]);
+    }
+
+    // longer than the first level of the wheel
+    pcintr_timer_t repeat = pcintr_timer_create(NULL, "repeat",
+            on_repeat, NULL);
+    pcintr_timer_set_interval(repeat, 300);
+    pcintr_timer_start(repeat);
+
+    pcintr_timer_t self = pcintr_timer_create(NULL, NULL,
+            on_self_destroy, NULL);
+    pcintr_timer_set_interval(self, 20);
+    pcintr_timer_start_oneshot(self);
+
+    pcintr_timer_t self_repeat = pcintr_timer_create(NULL, NULL,
+            on_self_destroy_repeat, NULL);
+    pcintr_timer_set_interval(self_repeat, 20);
+    pcintr_timer_start(self_repeat);
+
+    pcintr_timer_t never = pcintr_timer_create(NULL, NULL, on_never, NULL);
+    pcintr_timer_set_interval(never, 10);
+    pcintr_timer_start(never);
+    pcintr_timer_stop(never);
+    ASSERT_FALSE(pcintr_timer_is_active(never));
+
+    purc_runloop_run();
+
+    ASSERT_EQ(info.nr_fired, (unsigned)NR_ONESHOT_TIMERS);
+    ASSERT_EQ(info.nr_early, 0U);
+    ASSERT_EQ(info.nr_repeated, (unsigned)NR_REPEATS);
+    ASSERT_TRUE(info.self_destroyed);
+    ASSERT_EQ(info.nr_self_repeated, (unsigned)NR_REPEATS);
+    ASSERT_GE(current_time_ms() - info.started, 300.0 * NR_REPEATS - 1);
+
+    for (int i = 0; i < NR_ONESHOT_TIMERS; i++) {
+        pcintr_timer_destroy(oneshots[i]);
+    }
+    pcintr_timer_destroy(repeat);
+    pcintr_timer_destroy(never);
+
+    bool cleanup = purc_cleanup();
+    ASSERT_EQ(cleanup, true);
+}
@@ -93,3 +93,109 @@ TEST(instance, messages)
     purc_cleanup();
 }
 
+
+TEST(instance, binary_messages)
+{
+    int ret = purc_init_ex(PURC_MODULE_EJSON, NULL, NULL, NULL);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    pcrdr_msg *msg;
+    msg = pcrdr_make_request_message(PCRDR_MSG_TARGET_DOM,
+            random(), "update", NULL, NULL,
+            PCRDR_MSG_ELEMENT_TYPE_HANDLE, "7f3e12ab", "attr.class",
+            PCRDR_MSG_DATA_TYPE_VOID, NULL, 0);
+
+    const char *ejson = "{ 'a': [ 1, 2L, 3UL, 4.5FL, true, null ],"
+        "'b': 'text', 'c': bx0AFF }";
+    msg->dataType = PCRDR_MSG_DATA_TYPE_JSON;
+    msg->data = purc_variant_make_from_json_string(ejson, strlen(ejson));
+    ASSERT_NE(msg->data, PURC_VARIANT_INVALID);
+
+    purc_variant_t set = purc_variant_make_set_by_ckey(0, "k",
+            PURC_VARIANT_INVALID);
+    for (int i = 0; i < 2; i++) {
+        purc_variant_t k = purc_variant_make_longint(i);
+        purc_variant_t obj = purc_variant_make_object_by_static_ckey(1,
+                "k", k);
+        purc_variant_set_add(set, obj, true);
+        purc_variant_unref(obj);
+        purc_variant_unref(k);
+    }
+    purc_variant_object_set_by_static_ckey(msg->data, "d", set);
+    purc_variant_unref(set);
+
+    purc_variant_t tuple = purc_variant_make_tuple(2, NULL);
+    purc_variant_object_set_by_static_ckey(msg->data, "e", tuple);
+    purc_variant_unref(tuple);
+
+    struct buff_info info_a = { buffer_a, sizeof (buffer_a), 0 };
+    ret = pcrdr_serialize_message_binary(msg, write_to_buf, &info_a);
+    ASSERT_EQ(ret, 0);
+
+    pcrdr_msg *msg_parsed;
+    ret = pcrdr_parse_packet(buffer_a, info_a.pos, &msg_parsed);
+    ASSERT_EQ(ret, 0);
+
+    ASSERT_EQ(msg_parsed->type, msg->type);
+    ASSERT_EQ(msg_parsed->target, msg->target);
+    ASSERT_EQ(msg_parsed->targetValue, msg->targetValue);
+    ASSERT_EQ(msg_parsed->elementType, msg->elementType);
+    ASSERT_STREQ(purc_variant_get_string_const(msg_parsed->operation),
+            "update");
+    ASSERT_STREQ(purc_variant_get_string_const(msg_parsed->elementValue),
+            "7f3e12ab");
+    ASSERT_STREQ(purc_variant_get_string_const(msg_parsed->property),
+            "attr.class");
+    ASSERT_STREQ(purc_variant_get_string_const(msg_parsed->requestId),
+            purc_variant_get_string_const(msg->requestId));
+    ASSERT_TRUE(purc_variant_is_equal_to(msg_parsed->data, msg->data));
+
+    /* a truncated packet is refused */
+    pcrdr_msg *msg_bad = NULL;
+    ret = pcrdr_parse_packet(buffer_a, info_a.pos - 1, &msg_bad);
+    ASSERT_EQ(ret, -1);
+
+    pcrdr_release_message(msg_parsed);
+    pcrdr_release_message(msg);
+
+    purc_cleanup();
+}
+
+TEST(instance, message_pool)
+{
+    int ret = purc_init_ex(PURC_MODULE_VARIANT, NULL, NULL, NULL);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    const struct purc_msg_pool_stat *stat = purc_inst_msg_pool_stat();
+    ASSERT_NE(stat, nullptr);
+    size_t nr_reused = stat->nr_reused;
+    size_t nr_pooled = stat->nr_pooled;
+
+    pcrdr_msg *msg;
+    msg = pcrdr_make_event_message(PCRDR_MSG_TARGET_SESSION,
+            random(), "click", NULL,
+            PCRDR_MSG_ELEMENT_TYPE_VOID, NULL, NULL,
+            PCRDR_MSG_DATA_TYPE_PLAIN, "The data", 0);
+    ASSERT_NE(msg, nullptr);
+    pcrdr_release_message(msg);
+    ASSERT_EQ(stat->nr_pooled, nr_pooled + 1);
+
+    /* the structure released just now is reused */
+    pcrdr_msg *msg_again;
+    msg_again = pcrdr_make_event_message(PCRDR_MSG_TARGET_SESSION,
+            random(), "click", NULL,
+            PCRDR_MSG_ELEMENT_TYPE_VOID, NULL, NULL,
+            PCRDR_MSG_DATA_TYPE_PLAIN, "The data", 0);
+    ASSERT_EQ(msg_again, msg);
+    ASSERT_EQ(stat->nr_reused, nr_reused + 1);
+    ASSERT_EQ(stat->nr_pooled, nr_pooled);
+
+    /* the pool is disabled */
+    purc_inst_set_msg_pool_size(0);
+    size_t nr_freed = stat->nr_freed;
+    pcrdr_release_message(msg_again);
+    ASSERT_EQ(stat->nr_pooled, 0U);
+    ASSERT_EQ(stat->nr_freed, nr_freed + 1);
+
+    purc_cleanup();
+}
@@ -27,9 +27,12 @@
 #include <errno.h>
 #include <gtest/gtest.h>
 
+#include <string>
+
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <unistd.h>
 
 
 void create_temp_file(const char* file, const char* buf, size_t buf_len)
@@ -564,6 +567,168 @@ TEST(mem_rwstream, seek_read)
     ASSERT_EQ(ret, 0);
 }
 
+static void release_counter(void *ctxt)
+{
+    int *counter = (int *)ctxt;
+    (*counter)++;
+}
+
+TEST(mem_rwstream, read_only)
+{
+    char buf[] = "This is test file. 这是测试文件。";
+    size_t buf_len = strlen(buf);
+    int released = 0;
+
+    purc_rwstream_t rws = purc_rwstream_new_from_mem_ex (buf, buf_len,
+            release_counter, &released);
+    ASSERT_NE(rws, nullptr);
+
+    size_t sz = 0;
+    char* mem_buffer = (char*)purc_rwstream_get_mem_buffer (rws, &sz);
+    ASSERT_EQ(mem_buffer, buf);
+    ASSERT_EQ(sz, buf_len);
+
+    mem_buffer = (char*)purc_rwstream_get_mem_buffer_ex (rws, &sz, NULL, true);
+    ASSERT_EQ(mem_buffer, nullptr);
+
+    char read_buf[1024] = {0};
+    int read_len = purc_rwstream_read (rws, read_buf, buf_len);
+    ASSERT_EQ(read_len, buf_len);
+    ASSERT_STREQ(read_buf, buf);
+
+    off_t pos = purc_rwstream_seek (rws, 0, SEEK_SET);
+    ASSERT_EQ(pos, 0);
+    int write_len = purc_rwstream_write (rws, "xyz", 3);
+    ASSERT_EQ(write_len, -1);
+    ASSERT_STREQ(buf, "This is test file. 这是测试文件。");
+
+    ASSERT_EQ(released, 0);
+    int ret = purc_rwstream_destroy (rws);
+    ASSERT_EQ(ret, 0);
+    ASSERT_EQ(released, 1);
+}
+
+/* test mmap rwstream */
+TEST(mmap_rwstream, read_only)
+{
+    char tmp_file[] = "/tmp/rwstream.txt";
+    char buf[] = "This is test file. 这是测试文件。";
+    size_t buf_len = strlen(buf);
+    create_temp_file(tmp_file, buf, buf_len);
+
+    purc_rwstream_t rws = purc_rwstream_new_from_mmap(tmp_file);
+    ASSERT_NE(rws, nullptr);
+
+    size_t sz = 0;
+    char* mem_buffer = (char*)purc_rwstream_get_mem_buffer (rws, &sz);
+    ASSERT_NE(mem_buffer, nullptr);
+    ASSERT_EQ(sz, buf_len);
+    ASSERT_EQ(memcmp(mem_buffer, buf, buf_len), 0);
+
+    mem_buffer = (char*)purc_rwstream_get_mem_buffer_ex (rws, &sz, NULL, true);
+    ASSERT_EQ(mem_buffer, nullptr);
+
+    char read_buf[1024] = {0};
+    int read_len = purc_rwstream_read (rws, read_buf, sizeof(read_buf));
+    ASSERT_EQ(read_len, buf_len);
+    ASSERT_STREQ(read_buf, buf);
+
+    off_t pos = purc_rwstream_seek (rws, 5, SEEK_SET);
+    ASSERT_EQ(pos, 5);
+    int write_len = purc_rwstream_write (rws, "xyz", 3);
+    ASSERT_EQ(write_len, -1);
+
+    int ret = purc_rwstream_destroy (rws);
+    ASSERT_EQ(ret, 0);
+
+    /* an empty file */
+    create_temp_file(tmp_file, buf, 0);
+    rws = purc_rwstream_new_from_mmap(tmp_file);
+    ASSERT_NE(rws, nullptr);
+    read_len = purc_rwstream_read (rws, read_buf, sizeof(read_buf));
+    ASSERT_EQ(read_len, 0);
+    ret = purc_rwstream_destroy (rws);
+    ASSERT_EQ(ret, 0);
+
+    remove_temp_file(tmp_file);
+
+    rws = purc_rwstream_new_from_mmap(tmp_file);
+    ASSERT_EQ(rws, nullptr);
+
+    /* not a regular file */
+    rws = purc_rwstream_new_from_mmap("/tmp");
+    ASSERT_EQ(rws, nullptr);
+}
+
+/* test rope rwstream */
+TEST(rope_rwstream, write_read)
+{
+    purc_rwstream_t rws = purc_rwstream_new_rope (0, 0);
+    ASSERT_NE(rws, nullptr);
+
+    /* across several chunks */
+    std::string expected;
+    char line[64];
+    for (int i = 0; i < 10000; i++) {
+        int n = snprintf(line, sizeof(line), "line %d\n", i);
+        ASSERT_EQ(purc_rwstream_write (rws, line, n), n);
+        expected.append(line, n);
+    }
+    ASSERT_EQ(purc_rwstream_tell (rws), (off_t)expected.size());
+
+    /* overwrite across the boundary of the first two chunks */
+    ASSERT_EQ(purc_rwstream_seek (rws, 4090, SEEK_SET), 4090);
+    ASSERT_EQ(purc_rwstream_write (rws, "0123456789", 10), 10);
+    expected.replace(4090, 10, "0123456789");
+    ASSERT_EQ(purc_rwstream_seek (rws, 0, SEEK_END), (off_t)expected.size());
+
+    std::string content;
+    char buf[1000];
+    ssize_t n;
+    ASSERT_EQ(purc_rwstream_seek (rws, 0, SEEK_SET), 0);
+    while ((n = purc_rwstream_read (rws, buf, sizeof(buf))) > 0)
+        content.append(buf, n);
+    ASSERT_EQ(content, expected);
+
+    /* gathered into a file */
+    char tmp_file[] = "/tmp/rwstream.txt";
+    int fd = open(tmp_file, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(purc_rwstream_seek (rws, 10, SEEK_SET), 10);
+    ASSERT_EQ(purc_rwstream_dump_to_fd (rws, fd),
+            (ssize_t)expected.size() - 10);
+    close(fd);
+
+    purc_rwstream_t in = purc_rwstream_new_from_file (tmp_file, "r");
+    ASSERT_NE(in, nullptr);
+    content.clear();
+    while ((n = purc_rwstream_read (in, buf, sizeof(buf))) > 0)
+        content.append(buf, n);
+    purc_rwstream_destroy (in);
+    remove_temp_file(tmp_file);
+    ASSERT_EQ(content, expected.substr(10));
+
+    /* made contiguous, and taken over */
+    size_t sz_content = 0, sz_buffer = 0;
+    char* mem_buffer = (char*)purc_rwstream_get_mem_buffer_ex (rws,
+            &sz_content, &sz_buffer, true);
+    ASSERT_NE(mem_buffer, nullptr);
+    ASSERT_EQ(sz_content, expected.size());
+    ASSERT_GE(sz_buffer, sz_content);
+    ASSERT_STREQ(mem_buffer, expected.c_str());
+
+    int ret = purc_rwstream_destroy (rws);
+    ASSERT_EQ(ret, 0);
+    free(mem_buffer);
+
+    /* the maximal size */
+    rws = purc_rwstream_new_rope (0, 8);
+    ASSERT_NE(rws, nullptr);
+    ASSERT_EQ(purc_rwstream_write (rws, "0123456789", 10), 8);
+    ASSERT_EQ(purc_rwstream_write (rws, "0", 1), -1);
+    purc_rwstream_destroy (rws);
+}
+
 /* test buffer rwstream */
 TEST(buffer_rwstream, new_destroy)
 {
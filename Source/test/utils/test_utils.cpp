@@ -22,11 +22,17 @@
 #include "private/array_list.h"
 #include "private/list.h"
 #include "private/avl.h"
+#include "private/btree.h"
+#include "private/hash.h"
 #include "private/hashtable.h"
 #include "private/map.h"
+#include "private/ptrmap.h"
 #include "private/rbtree.h"
 #include "private/atom-buckets.h"
 #include "private/sorted-array.h"
+#include "private/smallvec.h"
+#include "private/threadpool.h"
+#include "private/utils.h"
 
 #include "../helpers.h"
 
@@ -34,6 +40,9 @@
 
 #include <stdio.h>
 #include <errno.h>
+#include <math.h>
+#include <sys/time.h>
+#include <pthread.h>
 #include <gtest/gtest.h>
 
 #define ATOM_BUCKET     1
@@ -179,6 +188,83 @@ TEST(utils, atom_ex)
     purc_cleanup ();
 }
 
+#define NR_STAT_ATOMS   1000
+#define NR_READERS      4
+
+static void *atom_reader(void *arg)
+{
+    volatile bool *done = (volatile bool *)arg;
+    size_t nr_mismatched = 0;
+    char buf[32];
+
+    while (!*done) {
+        for (int i = 0; i < NR_STAT_ATOMS; i++) {
+            snprintf(buf, sizeof(buf), "stat-%d", i);
+            purc_atom_t atom = purc_atom_try_string_ex(PURC_ATOM_BUCKET_USER,
+                    buf);
+            if (atom == 0)
+                continue;
+
+            const char *string = purc_atom_to_string(atom);
+            if (string && strcmp(string, buf))
+                nr_mismatched++;
+        }
+    }
+
+    return (void *)(uintptr_t)nr_mismatched;
+}
+
+// to test the lookups concurrent with the changes, and the statistics
+TEST(utils, atom_stat)
+{
+    int ret = purc_init_ex(PURC_MODULE_UTILS, "cn.fmsoft.hybridos.test",
+            "utils", NULL);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    struct purc_atom_stat stat;
+    ASSERT_FALSE(purc_atom_bucket_stat(-1, &stat));
+
+    volatile bool done = false;
+    pthread_t readers[NR_READERS];
+    for (int i = 0; i < NR_READERS; i++) {
+        ASSERT_EQ(pthread_create(&readers[i], NULL, atom_reader,
+                    (void *)&done), 0);
+    }
+
+    char buf[32];
+    for (int i = 0; i < NR_STAT_ATOMS; i++) {
+        snprintf(buf, sizeof(buf), "stat-%d", i);
+        ASSERT_NE(purc_atom_from_string_ex(PURC_ATOM_BUCKET_USER, buf), 0);
+    }
+
+    for (int i = 0; i < NR_STAT_ATOMS; i += 2) {
+        snprintf(buf, sizeof(buf), "stat-%d", i);
+        ASSERT_TRUE(purc_atom_remove_string_ex(PURC_ATOM_BUCKET_USER, buf));
+    }
+
+    done = true;
+    for (int i = 0; i < NR_READERS; i++) {
+        void *nr_mismatched;
+        pthread_join(readers[i], &nr_mismatched);
+        ASSERT_EQ((uintptr_t)nr_mismatched, 0);
+    }
+
+    ASSERT_TRUE(purc_atom_bucket_stat(PURC_ATOM_BUCKET_USER, &stat));
+    ASSERT_GE(stat.nr_atoms, NR_STAT_ATOMS / 2);
+    ASSERT_GE(stat.nr_removed, NR_STAT_ATOMS / 2);
+    ASSERT_GE(stat.nr_slots, stat.nr_used_slots);
+    ASSERT_GT(stat.max_chain_len, 0);
+
+    /* a removed string gets a new atom */
+    purc_atom_t atom = purc_atom_from_string_ex(PURC_ATOM_BUCKET_USER,
+            "stat-0");
+    ASSERT_STREQ(purc_atom_to_string(atom), "stat-0");
+    ASSERT_TRUE(purc_atom_bucket_stat(PURC_ATOM_BUCKET_USER, &stat));
+    ASSERT_GE(stat.nr_removed, NR_STAT_ATOMS / 2 - 1);
+
+    purc_cleanup ();
+}
+
 enum {
     ID_EXCEPT_BusError = 0,
     ID_EXCEPT_SegFault,
@@ -353,6 +439,39 @@ TEST(utils, atom_buckets)
     purc_cleanup ();
 }
 
+TEST(utils, atom_static)
+{
+    /* the static atoms are available before initializing the instance */
+    purc_atom_t atom = purc_atom_try_string_ex(ATOM_BUCKET_EXCEPT, "NoData");
+    ASSERT_NE(atom, 0);
+    ASSERT_STREQ(purc_atom_to_string(atom), "NoData");
+
+    int ret = purc_init_ex(PURC_MODULE_UTILS, "cn.fmsoft.hybridos.test",
+            "utils", NULL);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    ASSERT_EQ(purc_get_except_atom_by_id(PURC_EXCEPT_NO_DATA), atom);
+    for (int id = 0; id < PURC_EXCEPT_NR; id++) {
+        purc_atom_t a = purc_get_except_atom_by_id(id);
+        ASSERT_TRUE(purc_is_except_atom(a));
+        ASSERT_EQ(purc_atom_from_string_ex(ATOM_BUCKET_EXCEPT,
+                    purc_atom_to_string(a)), a);
+    }
+    ASSERT_EQ(purc_get_except_atom_by_id(PURC_EXCEPT_NR), 0);
+
+    /* never removed, and a new atom of the bucket follows them */
+    ASSERT_FALSE(purc_atom_remove_string_ex(ATOM_BUCKET_EXCEPT, "NoData"));
+    ASSERT_EQ(purc_atom_try_string_ex(ATOM_BUCKET_EXCEPT, "NoData"), atom);
+
+    atom = purc_atom_from_static_string_ex(ATOM_BUCKET_EXCEPT, "NotAnError");
+    ASSERT_NE(atom, 0);
+    ASSERT_FALSE(purc_is_except_atom(atom));
+    ASSERT_STREQ(purc_atom_to_string(atom), "NotAnError");
+    ASSERT_TRUE(purc_atom_remove_string_ex(ATOM_BUCKET_EXCEPT, "NotAnError"));
+
+    purc_cleanup ();
+}
+
 // to test sorted array
 static int sortv[10] = { 1, 8, 7, 5, 4, 6, 9, 0, 2, 3 };
 
@@ -663,6 +782,61 @@ TEST(arrlist, double_free)
     ASSERT_EQ(_arrlist_items_free, 1);
 }
 
+TEST(arrlist, inline_slots)
+{
+    static int vals[100];
+    struct pcutils_arrlist *al = pcutils_arrlist_new_ex(NULL, 4);
+
+    /* beyond the inline slots */
+    for (size_t i = 0; i < 100; i++)
+        ASSERT_EQ(pcutils_arrlist_append(al, vals + i), 0);
+    ASSERT_EQ(pcutils_arrlist_length(al), 100);
+    for (size_t i = 0; i < 100; i++)
+        ASSERT_EQ(pcutils_arrlist_get_idx(al, i), vals + i);
+
+    ASSERT_EQ(pcutils_arrlist_shrink(al, 0), 0);
+    ASSERT_EQ(pcutils_arrlist_get_last(al), vals + 99);
+    pcutils_arrlist_free(al);
+
+    al = pcutils_arrlist_new_ex(NULL, 4);
+    ASSERT_EQ(pcutils_arrlist_put_idx(al, 2, vals), 0);
+    ASSERT_EQ(pcutils_arrlist_shrink(al, 0), 0);
+    ASSERT_EQ(pcutils_arrlist_put_idx(al, 9, vals + 9), 0);
+    ASSERT_EQ(pcutils_arrlist_get_idx(al, 1), nullptr);
+    ASSERT_EQ(pcutils_arrlist_get_idx(al, 2), vals);
+    ASSERT_EQ(pcutils_arrlist_get_idx(al, 9), vals + 9);
+    pcutils_arrlist_free(al);
+}
+
+PCUTILS_SMALLVEC_DEFINE(test_intvec, int, 4);
+
+TEST(utils, smallvec)
+{
+    struct test_intvec v;
+    test_intvec_init(&v);
+    ASSERT_EQ(test_intvec_size(&v), 0);
+
+    for (int i = 0; i < 4; i++)
+        ASSERT_EQ(test_intvec_push(&v, i), 0);
+    ASSERT_TRUE(test_intvec_is_inline(&v));
+
+    for (int i = 4; i < 100; i++)
+        ASSERT_EQ(test_intvec_push(&v, i), 0);
+    ASSERT_FALSE(test_intvec_is_inline(&v));
+    ASSERT_EQ(test_intvec_size(&v), 100);
+    for (int i = 0; i < 100; i++)
+        ASSERT_EQ(*test_intvec_at(&v, i), i);
+
+    test_intvec_clear(&v);
+    ASSERT_EQ(test_intvec_size(&v), 0);
+    ASSERT_TRUE(test_intvec_is_inline(&v));
+    ASSERT_EQ(test_intvec_reserve(&v, 3), 0);
+    ASSERT_TRUE(test_intvec_is_inline(&v));
+    ASSERT_EQ(test_intvec_reserve(&v, 30), 0);
+    ASSERT_FALSE(test_intvec_is_inline(&v));
+    test_intvec_clear(&v);
+}
+
 /* test hashtable.double_free */
 static size_t _hash_table_items_free = 0;
 static void _hash_table_item_free(pchash_entry *e)
@@ -696,6 +870,40 @@ TEST(hashtable, double_free)
     ASSERT_EQ(_hash_table_items_free, 1);
 }
 
+TEST(hashtable, wyhash)
+{
+    static const char *keys[] = {
+        "", "a", "Id", "DIV", "href", "Content-Type", "background-color",
+        "A_Very_Long_Name_Of_The_Attribute_Beyond_Forty_Eight_Bytes_\xe4\xb8",
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(keys); i++) {
+        size_t len = strlen(keys[i]);
+        char lower[128], upper[128];
+        for (size_t j = 0; j <= len; j++) {
+            lower[j] = purc_tolower(keys[i][j]);
+            upper[j] = purc_toupper(keys[i][j]);
+        }
+
+        uint32_t h = pcutils_hash_make_id((const unsigned char *)lower, len);
+        ASSERT_EQ(pcutils_hash_make_id_lower(
+                    (const unsigned char *)keys[i], len), h);
+        ASSERT_EQ(pcutils_hash_make_id_lower(
+                    (const unsigned char *)upper, len), h);
+
+        h = pcutils_hash_make_id((const unsigned char *)upper, len);
+        ASSERT_EQ(pcutils_hash_make_id_upper(
+                    (const unsigned char *)keys[i], len), h);
+
+        ASSERT_EQ(pchash_default_char_hash(keys[i]),
+                pchash_default_char_hash_len(keys[i], len));
+        if (len > 0) {
+            ASSERT_NE(pchash_default_char_hash(keys[i]),
+                    pchash_default_char_hash_len(keys[i], len - 1));
+        }
+    }
+}
+
 struct string_s {
     struct list_head      list;
     char                 *s;
@@ -995,6 +1203,197 @@ TEST(utils, map)
     ASSERT_EQ(r, 0);
 }
 
+TEST(utils, ptrmap)
+{
+    static char keys[100];
+    pcutils_ptrmap map;
+    pcutils_ptrmap_init(&map);
+
+    /* the inline entries first, then the hash table */
+    for (size_t i = 0; i < 100; i++) {
+        ASSERT_EQ(pcutils_ptrmap_set(&map, keys + i, (void *)(i + 1)), 0);
+        ASSERT_EQ(pcutils_ptrmap_size(&map), i + 1);
+    }
+
+    ASSERT_EQ(pcutils_ptrmap_set(&map, keys, (void *)1000), 0);
+    ASSERT_EQ(pcutils_ptrmap_size(&map), 100);
+
+    for (size_t i = 0; i < 100; i += 2) {
+        ASSERT_TRUE(pcutils_ptrmap_erase(&map, keys + i));
+    }
+    ASSERT_FALSE(pcutils_ptrmap_erase(&map, keys));
+    ASSERT_EQ(pcutils_ptrmap_size(&map), 50);
+
+    for (size_t i = 0; i < 100; i++) {
+        struct pcutils_ptrmap_entry *entry;
+        entry = pcutils_ptrmap_find(&map, keys + i);
+        if (i % 2) {
+            ASSERT_NE(entry, nullptr);
+            ASSERT_EQ((size_t)entry->val, i + 1);
+        }
+        else {
+            ASSERT_EQ(entry, nullptr);
+        }
+    }
+
+    size_t pos = 0, nr = 0;
+    struct pcutils_ptrmap_entry *entry;
+    while ((entry = pcutils_ptrmap_next(&map, &pos))) {
+        size_t i = (char *)entry->key - keys;
+        ASSERT_EQ(i % 2, 1);
+        ASSERT_EQ((size_t)entry->val, i + 1);
+        nr++;
+    }
+    ASSERT_EQ(nr, 50);
+
+    pcutils_ptrmap_clear(&map);
+    ASSERT_EQ(pcutils_ptrmap_size(&map), 0);
+    ASSERT_EQ(pcutils_ptrmap_find(&map, keys + 1), nullptr);
+
+    /* back to the inline entries */
+    ASSERT_EQ(pcutils_ptrmap_set(&map, keys + 1, (void *)2), 0);
+    ASSERT_TRUE(pcutils_ptrmap_erase(&map, keys + 1));
+    pcutils_ptrmap_clear(&map);
+}
+
+static int
+btree_cmp_ints(const void *item, const void *key, void *ctxt)
+{
+    (void)ctxt;
+    int a = *(const int *)item;
+    int b = *(const int *)key;
+    return (a > b) - (a < b);
+}
+
+TEST(utils, btree)
+{
+    static int vals[1000];
+    pcutils_btree tree;
+    pcutils_btree_init(&tree, btree_cmp_ints, NULL);
+
+    /* insert in a shuffled order */
+    for (int i = 0; i < 1000; i++)
+        vals[i] = i * 2;
+    for (int i = 0; i < 1000; i++) {
+        int j = (i * 7919) % 1000;
+        ASSERT_EQ(pcutils_btree_insert(&tree, vals + j), 0);
+    }
+    ASSERT_EQ(pcutils_btree_size(&tree), 1000);
+    ASSERT_EQ(pcutils_btree_insert(&tree, vals + 10), 1);
+
+    int key = 100;
+    ASSERT_EQ(pcutils_btree_find(&tree, &key, NULL), vals + 50);
+    key = 101;
+    ASSERT_EQ(pcutils_btree_find(&tree, &key, NULL), nullptr);
+
+    pcutils_btree_iter it;
+    int nr = 0;
+    for (int *v = (int *)pcutils_btree_first(&tree, &it); v;
+            v = (int *)pcutils_btree_next(&it)) {
+        ASSERT_EQ(*v, nr * 2);
+        nr++;
+    }
+    ASSERT_EQ(nr, 1000);
+
+    key = 101;
+    ASSERT_EQ(pcutils_btree_seek(&tree, &it, &key, NULL, false), vals + 51);
+    key = 102;
+    ASSERT_EQ(pcutils_btree_seek(&tree, &it, &key, NULL, false), vals + 51);
+    ASSERT_EQ(pcutils_btree_seek(&tree, &it, &key, NULL, true), vals + 52);
+    ASSERT_EQ(pcutils_btree_next(&it), vals + 53);
+    key = 1998;
+    ASSERT_EQ(pcutils_btree_seek(&tree, &it, &key, NULL, true), nullptr);
+
+    /* erase the items at the odd positions */
+    for (int i = 1; i < 1000; i += 2)
+        ASSERT_EQ(pcutils_btree_erase(&tree, vals + i), vals + i);
+    ASSERT_EQ(pcutils_btree_erase(&tree, vals + 1), nullptr);
+    ASSERT_EQ(pcutils_btree_size(&tree), 500);
+
+    nr = 0;
+    for (int *v = (int *)pcutils_btree_first(&tree, &it); v;
+            v = (int *)pcutils_btree_next(&it)) {
+        ASSERT_EQ(*v, nr * 4);
+        nr++;
+    }
+    ASSERT_EQ(nr, 500);
+
+    for (int i = 0; i < 1000; i += 2)
+        ASSERT_EQ(pcutils_btree_erase(&tree, vals + i), vals + i);
+    ASSERT_EQ(pcutils_btree_size(&tree), 0);
+    ASSERT_EQ(pcutils_btree_first(&tree, &it), nullptr);
+
+    ASSERT_EQ(pcutils_btree_insert(&tree, vals), 0);
+    pcutils_btree_clear(&tree, NULL);
+    ASSERT_EQ(pcutils_btree_size(&tree), 0);
+}
+
+static void *
+threadpool_sum(void *arg)
+{
+    uintptr_t n = (uintptr_t)arg, sum = 0;
+    for (uintptr_t i = 1; i <= n; i++)
+        sum += i;
+    return (void *)sum;
+}
+
+/* splits the sum into the sub-tasks, and waits for them on the worker */
+static void *
+threadpool_split_sum(void *arg)
+{
+    uintptr_t n = (uintptr_t)arg;
+    if (n <= 1000)
+        return threadpool_sum(arg);
+
+    pcutils_task *sub = pcutils_task_submit(threadpool_sum, (void *)1000);
+    uintptr_t sum = (uintptr_t)threadpool_split_sum((void *)(n - 1000));
+    sum += (uintptr_t)pcutils_task_wait(sub);
+    pcutils_task_release(sub);
+
+    /* sum(n) = sum(n - 1000) + (n - 1000) * 1000 + sum(1000) */
+    return (void *)(sum + (n - 1000) * 1000);
+}
+
+TEST(utils, threadpool)
+{
+    ASSERT_GT(pcutils_threadpool_nr_workers(), 0U);
+
+    pcutils_task *tasks[100];
+    for (uintptr_t i = 0; i < 100; i++) {
+        tasks[i] = pcutils_task_submit(threadpool_sum, (void *)(i * 100));
+        ASSERT_NE(tasks[i], nullptr);
+    }
+
+    for (uintptr_t i = 0; i < 100; i++) {
+        uintptr_t n = i * 100;
+        ASSERT_EQ((uintptr_t)pcutils_task_wait(tasks[i]), n * (n + 1) / 2);
+        ASSERT_TRUE(pcutils_task_is_done(tasks[i]));
+        ASSERT_FALSE(pcutils_task_cancel(tasks[i]));
+        pcutils_task_release(tasks[i]);
+    }
+
+    /* the tasks waiting for their sub-tasks on the workers */
+    for (uintptr_t i = 0; i < 16; i++)
+        tasks[i] = pcutils_task_submit(threadpool_split_sum, (void *)20000);
+    for (uintptr_t i = 0; i < 16; i++) {
+        ASSERT_EQ((uintptr_t)pcutils_task_wait(tasks[i]), 20000 * 20001 / 2);
+        pcutils_task_release(tasks[i]);
+    }
+
+    pcutils_threadpool_shutdown();
+    ASSERT_EQ(pcutils_threadpool_configure(2, NULL), 0);
+    ASSERT_EQ(pcutils_threadpool_nr_workers(), 2U);
+
+    /* started again by the submission */
+    pcutils_task *task = pcutils_task_submit(threadpool_sum, (void *)10);
+    ASSERT_EQ((uintptr_t)pcutils_task_wait(task), 55U);
+    ASSERT_EQ(pcutils_threadpool_configure(4, NULL), -1);
+    pcutils_task_release(task);
+
+    pcutils_threadpool_shutdown();
+    ASSERT_EQ(pcutils_threadpool_configure(0, NULL), 0);
+}
+
 struct array_list_sample_node {
     struct pcutils_array_list_node          node;
     int                                     val;
@@ -1709,3 +2108,319 @@ TEST(utils, url)
     }
 }
 
+
+static double
+current_time_ms(void)
+{
+    struct timeval now;
+    gettimeofday(&now, 0);
+    return now.tv_sec * 1000.0 + now.tv_usec / 1000.0;
+}
+
+#define SZ_BENCH_DATA       (16 * 1024 * 1024)
+
+TEST(utils, crc32)
+{
+    static const uint32_t check_values[] = {
+        0xcbf43926, // CRC-32
+        0xfc891918, // CRC-32/BZIP2
+        0x0376e6e7, // CRC-32/MPEG-2
+        0x765e7680, // CRC-32/POSIX
+        0xbd0be338, // CRC-32/XFER
+        0xe3069283, // CRC-32/ISCSI
+        0xe3069283, // CRC-32C
+        0x87315576, // CRC-32/BASE91-D
+        0x87315576, // CRC-32D
+        0x340bc6d9, // CRC-32/JAMCRC
+        0x3010bf7f, // CRC-32/AIXM
+        0x3010bf7f, // CRC-32Q
+    };
+
+    unsigned char data[1000];
+    for (size_t i = 0; i < sizeof(data); i++)
+        data[i] = (unsigned char)(i * 131 + 7);
+
+    for (int algo = PURC_K_ALGO_CRC32; algo <= PURC_K_ALGO_CRC32Q; algo++) {
+        pcutils_crc32_ctxt ctxt;
+        uint32_t crc32, crc32_whole, crc32_pieces;
+
+        pcutils_crc32_begin(&ctxt, (purc_crc32_algo_t)algo);
+        pcutils_crc32_update(&ctxt, "123456789", 9);
+        pcutils_crc32_end(&ctxt, &crc32);
+        ASSERT_EQ(crc32, check_values[algo]);
+
+        /* the long pieces go by slices, the short ones byte by byte */
+        pcutils_crc32_begin(&ctxt, (purc_crc32_algo_t)algo);
+        pcutils_crc32_update(&ctxt, data, sizeof(data));
+        pcutils_crc32_end(&ctxt, &crc32_whole);
+
+        pcutils_crc32_begin(&ctxt, (purc_crc32_algo_t)algo);
+        for (size_t i = 0; i < sizeof(data); i += 7) {
+            size_t n = sizeof(data) - i;
+            pcutils_crc32_update(&ctxt, data + i, n < 7 ? n : 7);
+        }
+        pcutils_crc32_end(&ctxt, &crc32_pieces);
+        ASSERT_EQ(crc32_whole, crc32_pieces);
+    }
+
+    unsigned char *buf = (unsigned char *)malloc(SZ_BENCH_DATA);
+    ASSERT_NE(buf, nullptr);
+    memset(buf, 0x5a, SZ_BENCH_DATA);
+
+    pcutils_crc32_ctxt ctxt;
+    uint32_t crc32;
+    double started = current_time_ms();
+    pcutils_crc32_begin(&ctxt, PURC_K_ALGO_CRC32);
+    pcutils_crc32_update(&ctxt, buf, SZ_BENCH_DATA);
+    pcutils_crc32_end(&ctxt, &crc32);
+    double elapsed = current_time_ms() - started;
+    fprintf(stderr, "CRC-32 of %d MiB: %.1f ms (%.1f MiB/s)\n",
+            SZ_BENCH_DATA >> 20, elapsed,
+            (SZ_BENCH_DATA >> 20) * 1000.0 / (elapsed > 0 ? elapsed : 1));
+
+    free(buf);
+}
+
+TEST(utils, base64)
+{
+    static const struct {
+        const char *data;
+        const char *encoded;
+    } cases[] = {
+        { "", "" },
+        { "f", "Zg==" },
+        { "fo", "Zm8=" },
+        { "foo", "Zm9v" },
+        { "foob", "Zm9vYg==" },
+        { "fooba", "Zm9vYmE=" },
+        { "foobar", "Zm9vYmFy" },
+        { "HVML is a programmable markup language",
+            "SFZNTCBpcyBhIHByb2dyYW1tYWJsZSBtYXJrdXAgbGFuZ3VhZ2U=" },
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(cases); i++) {
+        size_t len = strlen(cases[i].data);
+        char encoded[128], decoded[128];
+
+        ssize_t n = pcutils_b64_encode(cases[i].data, len,
+                encoded, sizeof(encoded));
+        ASSERT_EQ(n, (ssize_t)strlen(cases[i].encoded));
+        ASSERT_STREQ(encoded, cases[i].encoded);
+
+        n = pcutils_b64_decode(encoded, decoded, sizeof(decoded));
+        ASSERT_EQ(n, (ssize_t)len);
+        ASSERT_EQ(memcmp(decoded, cases[i].data, len), 0);
+
+        /* no room for the terminating null character */
+        if (len > 0) {
+            n = pcutils_b64_encode(cases[i].data, len, encoded,
+                    strlen(cases[i].encoded));
+            ASSERT_EQ(n, -1);
+        }
+    }
+
+    unsigned char *buf = (unsigned char *)malloc(SZ_BENCH_DATA);
+    ASSERT_NE(buf, nullptr);
+    for (size_t i = 0; i < SZ_BENCH_DATA; i++)
+        buf[i] = (unsigned char)i;
+
+    size_t sz_encoded = pcutils_b64_encoded_length(SZ_BENCH_DATA);
+    char *encoded = (char *)malloc(sz_encoded);
+    ASSERT_NE(encoded, nullptr);
+
+    double started = current_time_ms();
+    ssize_t n = pcutils_b64_encode(buf, SZ_BENCH_DATA, encoded, sz_encoded);
+    double elapsed = current_time_ms() - started;
+    ASSERT_EQ(n, (ssize_t)((SZ_BENCH_DATA + 2) / 3 * 4));
+    fprintf(stderr, "Base64 encoding of %d MiB: %.1f ms (%.1f MiB/s)\n",
+            SZ_BENCH_DATA >> 20, elapsed,
+            (SZ_BENCH_DATA >> 20) * 1000.0 / (elapsed > 0 ? elapsed : 1));
+
+    free(encoded);
+    free(buf);
+}
+
+TEST(utils, ascii_case_folding)
+{
+    static const char upper[] =
+        "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG @[`{ 0123456789";
+    static const char lower[] =
+        "the quick brown fox jumps over the lazy dog @[`{ 0123456789";
+    size_t len = sizeof(upper) - 1;
+
+    char folded[sizeof(upper)] = { };
+    ASSERT_TRUE(pcutils_ascii_tolower_copy(folded, upper, len));
+    ASSERT_STREQ(folded, lower);
+    ASSERT_FALSE(pcutils_ascii_tolower_copy(folded, "caf\xc3\xa9", 5));
+
+    ASSERT_EQ(pcutils_ascii_caseless_prefix(upper, lower, len), len);
+    for (size_t i = 0; i < len; i++) {
+        char mixed[sizeof(upper)];
+        memcpy(mixed, upper, sizeof(upper));
+
+        mixed[i] = '#';
+        ASSERT_EQ(pcutils_ascii_caseless_prefix(mixed, lower, len), i);
+        mixed[i] = '\x80';
+        ASSERT_EQ(pcutils_ascii_caseless_prefix(lower, mixed, len), i);
+    }
+
+    ASSERT_EQ(pcutils_strcasecmp(upper, lower), 0);
+    ASSERT_LT(pcutils_strcasecmp("HVML-A", "hvml-b"), 0);
+    ASSERT_GT(pcutils_strcasecmp("HVML-Z", "hvml-b"), 0);
+    ASSERT_LT(pcutils_strcasecmp("HVML", "hvml-b"), 0);
+    ASSERT_EQ(pcutils_strcasecmp("\xc3\x89T\xc3\x89", "\xc3\xa9t\xc3\xa9"), 0);
+}
+
+#define NR_DTOA_SAMPLES     (1024 * 1024)
+
+TEST(utils, dtoa)
+{
+    static const struct {
+        double d;
+        const char *str;
+    } cases[] = {
+        { 0.0, "0" },
+        { -0.0, "-0" },
+        { 0.1, "0.1" },
+        { -0.1, "-0.1" },
+        { 1.0 / 3, "0.3333333333333333" },
+        { 123.456, "123.456" },
+        { 0.0001, "0.0001" },
+        { 0.00001, "1e-05" },
+        { 1e16, "10000000000000000" },
+        { 1e17, "1e+17" },
+        { 1e22, "1e+22" },
+        { 1e23, "1e+23" },
+        { 9007199254740993.0, "9007199254740992" },
+        { 5e-324, "5e-324" },
+        { 2.2250738585072014e-308, "2.2250738585072014e-308" },
+        { 1.7976931348623157e308, "1.7976931348623157e+308" },
+    };
+
+    char buf[PCUTILS_DTOA_BUFSZ];
+    for (size_t i = 0; i < PCA_TABLESIZE(cases); i++) {
+        size_t len = pcutils_dtoa(cases[i].d, buf);
+        ASSERT_STREQ(buf, cases[i].str);
+        ASSERT_EQ(len, strlen(cases[i].str));
+    }
+
+    static const char *numbers[] = {
+        "0", "-0", "12", "-12.5", "00012.5000e-0003", ".5", "5.", "1e22",
+        "1e23", "123456789012345678901234567890", "4.9e-324", "1e-400",
+        "1e400", "0x10", "1e", "1e+", "-", ".", "nan", "  3",
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(numbers); i++) {
+        char *end1, *end2;
+        double d1 = pcutils_strtod(numbers[i], &end1);
+        double d2 = strtod(numbers[i], &end2);
+        ASSERT_EQ(memcmp(&d1, &d2, sizeof(double)), 0) << numbers[i];
+        ASSERT_EQ(end1, end2) << numbers[i];
+    }
+
+    /* the shortest digits are read back as the same double */
+    double *samples = (double *)malloc(sizeof(double) * NR_DTOA_SAMPLES);
+    ASSERT_NE(samples, nullptr);
+
+    uint64_t seed = 88172645463325252ULL;
+    for (size_t i = 0; i < NR_DTOA_SAMPLES; i++) {
+        uint64_t bits;
+        do {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            bits = seed;
+            if (i & 1) {
+                /* the numbers of short decimal digits */
+                samples[i] = (double)(int64_t)(bits % 2000000) /
+                    (double)(1 + (bits >> 32) % 1000);
+            }
+            else {
+                memcpy(&samples[i], &bits, sizeof(double));
+            }
+        } while (isnan(samples[i]) || isinf(samples[i]));
+    }
+
+    char (*strs)[PCUTILS_DTOA_BUFSZ];
+    strs = (char (*)[PCUTILS_DTOA_BUFSZ])malloc(PCUTILS_DTOA_BUFSZ *
+            NR_DTOA_SAMPLES);
+    ASSERT_NE(strs, nullptr);
+
+    double started = current_time_ms();
+    for (size_t i = 0; i < NR_DTOA_SAMPLES; i++)
+        pcutils_dtoa(samples[i], strs[i]);
+    double elapsed_dtoa = current_time_ms() - started;
+
+    started = current_time_ms();
+    for (size_t i = 0; i < NR_DTOA_SAMPLES; i++) {
+        char *end;
+        double d = pcutils_strtod(strs[i], &end);
+        ASSERT_EQ(d, samples[i]) << strs[i];
+        ASSERT_EQ(*end, 0);
+    }
+    double elapsed_strtod = current_time_ms() - started;
+
+    started = current_time_ms();
+    for (size_t i = 0; i < NR_DTOA_SAMPLES; i++)
+        snprintf(strs[i], PCUTILS_DTOA_BUFSZ, "%.17g", samples[i]);
+    double elapsed_printf = current_time_ms() - started;
+
+    fprintf(stderr, "Formatting %d doubles: %.1f ms (snprintf: %.1f ms); "
+            "parsing them back: %.1f ms\n", NR_DTOA_SAMPLES,
+            elapsed_dtoa, elapsed_printf, elapsed_strtod);
+
+    free(strs);
+    free(samples);
+}
+
+TEST(utils, gtoa_itoa)
+{
+    static const double cases[] = {
+        0.0, -0.0, 0.1, -2.5, 1.0 / 3, 123456, 1234567, 999999.5, 1e6,
+        0.0001, 0.00001, 1e100, 5e-324, 2.2250738585072014e-308,
+        1.7976931348623157e308, NAN, INFINITY, -INFINITY,
+    };
+
+    char buf[PCUTILS_DTOA_BUFSZ], expected[PCUTILS_DTOA_BUFSZ];
+    for (size_t i = 0; i < PCA_TABLESIZE(cases); i++) {
+        snprintf(expected, sizeof(expected), "%g", cases[i]);
+        size_t len = pcutils_gtoa(cases[i], buf);
+        ASSERT_STREQ(buf, expected);
+        ASSERT_EQ(len, strlen(expected));
+    }
+
+    /* the same as "%g" for the short and the random doubles */
+    uint64_t seed = 88172645463325252ULL;
+    for (size_t i = 0; i < NR_DTOA_SAMPLES; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+
+        double d;
+        if (i & 1) {
+            d = (double)(int64_t)(seed % 2000000) /
+                (double)(1 + (seed >> 32) % 1000);
+        }
+        else {
+            memcpy(&d, &seed, sizeof(double));
+        }
+
+        snprintf(expected, sizeof(expected), "%g", d);
+        pcutils_gtoa(d, buf);
+        ASSERT_STREQ(buf, expected);
+
+        snprintf(expected, sizeof(expected), "%" PRIu64, seed >> (i % 64));
+        pcutils_u64toa(seed >> (i % 64), buf);
+        ASSERT_STREQ(buf, expected);
+
+        int64_t i64 = (int64_t)seed >> (i % 64);
+        snprintf(expected, sizeof(expected), "%" PRId64, i64);
+        pcutils_i64toa(i64, buf);
+        ASSERT_STREQ(buf, expected);
+    }
+
+    pcutils_i64toa(INT64_MIN, buf);
+    ASSERT_STREQ(buf, "-9223372036854775808");
+    pcutils_u64toa(UINT64_MAX, buf);
+    ASSERT_STREQ(buf, "18446744073709551615");
+}
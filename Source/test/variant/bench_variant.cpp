@@ -0,0 +1,644 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * The benchmarks of making, changing, and walking the variants; see
+ * bench.h for the results. The size is the number of the members, and
+ * every operation is measured in every number of the threads, each
+ * running it in an instance of its own.
+ */
+
+#include "purc.h"
+
+#include "private/variant.h"
+
+#include "../bench.h"
+
+#include <gtest/gtest.h>
+#include <pthread.h>
+
+#define DEF_BENCH_SIZES         "10,1000"
+#define DEF_BENCH_THREADS       "1,2"
+
+#define LONG_STRING \
+    "a string longer than the ones stored in the variant structure"
+
+struct bench_fixture {
+    purc_variant_t      keys;   // the keys or the values to look up
+    purc_variant_t      data;   // the container to operate on
+};
+
+struct bench_op {
+    const char         *name;
+    // makes the fixture; NULL if none needed
+    bool (*setup)(struct bench_fixture *fx, size_t size);
+    // runs the operation once; returns false on failure
+    bool (*run)(struct bench_fixture *fx, size_t size);
+};
+
+/* the members are in a pseudo-random order if @shuffled is true */
+static purc_variant_t
+make_numbers(size_t size, bool shuffled)
+{
+    purc_variant_t arr = purc_variant_make_array_0();
+    if (arr == PURC_VARIANT_INVALID)
+        return arr;
+
+    uint32_t seed = 1;
+    for (size_t i = 0; i < size; i++) {
+        double d = i;
+        if (shuffled) {
+            seed = seed * 1103515245 + 12345;
+            d = seed % (size * 4 + 1);
+        }
+
+        purc_variant_t v = purc_variant_make_number(d);
+        bool ok = v && purc_variant_array_append(arr, v);
+        if (v)
+            purc_variant_unref(v);
+        if (!ok) {
+            purc_variant_unref(arr);
+            return PURC_VARIANT_INVALID;
+        }
+    }
+
+    return arr;
+}
+
+static purc_variant_t
+make_keys(size_t size, const char *fmt)
+{
+    purc_variant_t arr = purc_variant_make_array_0();
+    if (arr == PURC_VARIANT_INVALID)
+        return arr;
+
+    for (size_t i = 0; i < size; i++) {
+        char key[64];
+        snprintf(key, sizeof(key), fmt, i);
+
+        purc_variant_t v = purc_variant_make_string(key, false);
+        bool ok = v && purc_variant_array_append(arr, v);
+        if (v)
+            purc_variant_unref(v);
+        if (!ok) {
+            purc_variant_unref(arr);
+            return PURC_VARIANT_INVALID;
+        }
+    }
+
+    return arr;
+}
+
+/* [{ "id": 0, "name": "name0" }, ...], or the set of them by `id` */
+static purc_variant_t
+make_rows(size_t size, bool set)
+{
+    purc_variant_t rows = set ?
+        purc_variant_make_set_by_ckey(0, "id", PURC_VARIANT_INVALID) :
+        purc_variant_make_array_0();
+    if (rows == PURC_VARIANT_INVALID)
+        return rows;
+
+    for (size_t i = 0; i < size; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "name%zu", i);
+
+        purc_variant_t id = purc_variant_make_ulongint(i);
+        purc_variant_t str = purc_variant_make_string(name, false);
+        purc_variant_t row = (id && str) ?
+            purc_variant_make_object_by_static_ckey(2,
+                    "id", id, "name", str) : PURC_VARIANT_INVALID;
+        if (id)
+            purc_variant_unref(id);
+        if (str)
+            purc_variant_unref(str);
+
+        bool ok = row && (set ? purc_variant_set_add(rows, row, false) :
+                purc_variant_array_append(rows, row));
+        if (row)
+            purc_variant_unref(row);
+        if (!ok) {
+            purc_variant_unref(rows);
+            return PURC_VARIANT_INVALID;
+        }
+    }
+
+    return rows;
+}
+
+static bool
+setup_string(struct bench_fixture *fx, size_t size)
+{
+    (void)size;
+    fx->data = purc_variant_make_string(LONG_STRING, false);
+    return fx->data != PURC_VARIANT_INVALID;
+}
+
+static bool
+setup_keys(struct bench_fixture *fx, size_t size)
+{
+    fx->keys = make_keys(size, "k%zu");
+    return fx->keys != PURC_VARIANT_INVALID;
+}
+
+static bool
+setup_object(struct bench_fixture *fx, size_t size)
+{
+    if (!setup_keys(fx, size))
+        return false;
+
+    fx->data = purc_variant_make_object_0();
+    if (fx->data == PURC_VARIANT_INVALID)
+        return false;
+
+    for (size_t i = 0; i < size; i++) {
+        purc_variant_t key = purc_variant_array_get(fx->keys, i);
+        if (!purc_variant_object_set(fx->data, key, key))
+            return false;
+    }
+    return true;
+}
+
+static bool
+setup_numbers(struct bench_fixture *fx, size_t size)
+{
+    fx->data = make_numbers(size, false);
+    return fx->data != PURC_VARIANT_INVALID;
+}
+
+static bool
+setup_shuffled(struct bench_fixture *fx, size_t size)
+{
+    fx->data = make_numbers(size, true);
+    return fx->data != PURC_VARIANT_INVALID;
+}
+
+static bool
+setup_rows(struct bench_fixture *fx, size_t size)
+{
+    fx->data = make_rows(size, false);
+    return fx->data != PURC_VARIANT_INVALID;
+}
+
+static bool
+setup_set(struct bench_fixture *fx, size_t size)
+{
+    /* the values to find have the unique key only */
+    fx->keys = purc_variant_make_array_0();
+    if (fx->keys == PURC_VARIANT_INVALID)
+        return false;
+
+    for (size_t i = 0; i < size; i++) {
+        purc_variant_t id = purc_variant_make_ulongint(i);
+        purc_variant_t key = id ?
+            purc_variant_make_object_by_static_ckey(1, "id", id) :
+            PURC_VARIANT_INVALID;
+        if (id)
+            purc_variant_unref(id);
+
+        bool ok = key && purc_variant_array_append(fx->keys, key);
+        if (key)
+            purc_variant_unref(key);
+        if (!ok)
+            return false;
+    }
+
+    fx->data = make_rows(size, true);
+    return fx->data != PURC_VARIANT_INVALID;
+}
+
+static bool
+setup_numeric_strings(struct bench_fixture *fx, size_t size)
+{
+    fx->data = make_keys(size, "%zu.125");
+    return fx->data != PURC_VARIANT_INVALID;
+}
+
+/* the numbers having the fractions, and the JSON text of them */
+static bool
+setup_reals(struct bench_fixture *fx, size_t size)
+{
+    fx->data = purc_variant_make_array_0();
+    if (fx->data == PURC_VARIANT_INVALID)
+        return false;
+
+    for (size_t i = 0; i < size; i++) {
+        purc_variant_t v = purc_variant_make_number(i + 1.0 / (i + 3));
+        bool ok = v && purc_variant_array_append(fx->data, v);
+        if (v)
+            purc_variant_unref(v);
+        if (!ok)
+            return false;
+    }
+
+    char *json = NULL;
+    purc_rwstream_t rws = purc_rwstream_new_buffer(1024, 0);
+    if (rws == NULL)
+        return false;
+
+    size_t len_expected = 0;
+    ssize_t n = purc_variant_serialize(fx->data, rws, 0,
+            PCVARIANT_SERIALIZE_OPT_PLAIN, &len_expected);
+    if (n > 0)
+        json = (char *)purc_rwstream_get_mem_buffer(rws, NULL);
+    if (json)
+        fx->keys = purc_variant_make_string_ex(json, n, false);
+    purc_rwstream_destroy(rws);
+    return fx->keys != PURC_VARIANT_INVALID;
+}
+
+/* @size lines of the markup, ASCII only or mostly CJK */
+static bool
+setup_utf8_text(struct bench_fixture *fx, size_t size, const char *line)
+{
+    std::string text;
+    for (size_t i = 0; i < size; i++)
+        text.append(line);
+
+    fx->data = purc_variant_make_string_ex(text.c_str(), text.size(), false);
+    return fx->data != PURC_VARIANT_INVALID;
+}
+
+static bool
+setup_ascii_text(struct bench_fixture *fx, size_t size)
+{
+    return setup_utf8_text(fx, size,
+            "<p class=\"note\">The quick brown fox jumps over the dog.</p>\n");
+}
+
+static bool
+setup_cjk_text(struct bench_fixture *fx, size_t size)
+{
+    return setup_utf8_text(fx, size,
+            "<p>\xe6\x95\x8f\xe6\x8d\xb7\xe7\x9a\x84\xe6\xa3\x95"
+            "\xe8\x89\xb2\xe7\x8b\x90\xe7\x8b\xb8\xe8\xb7\xb3"
+            "\xe8\xbf\x87\xe4\xba\x86\xe9\x82\xa3\xe5\x8f\xaa"
+            "\xe7\x8b\x97\xe3\x80\x82</p>\n");
+}
+
+static bool
+run_make_number(struct bench_fixture *fx, size_t size)
+{
+    (void)fx;
+    for (size_t i = 0; i < size; i++) {
+        purc_variant_t v = purc_variant_make_number(i);
+        if (v == PURC_VARIANT_INVALID)
+            return false;
+        purc_variant_unref(v);
+    }
+    return true;
+}
+
+static bool
+run_make_string(struct bench_fixture *fx, size_t size)
+{
+    (void)fx;
+    for (size_t i = 0; i < size; i++) {
+        purc_variant_t v = purc_variant_make_string(LONG_STRING, false);
+        if (v == PURC_VARIANT_INVALID)
+            return false;
+        purc_variant_unref(v);
+    }
+    return true;
+}
+
+static bool
+run_check_utf8(struct bench_fixture *fx, size_t size)
+{
+    (void)size;
+    size_t nr_chars;
+    const char *str = purc_variant_get_string_const(fx->data);
+    return pcutils_string_check_utf8(str, -1, &nr_chars, NULL);
+}
+
+static bool
+run_ref_unref(struct bench_fixture *fx, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        purc_variant_ref(fx->data);
+        purc_variant_unref(fx->data);
+    }
+    return true;
+}
+
+static bool
+run_object_set(struct bench_fixture *fx, size_t size)
+{
+    purc_variant_t obj = purc_variant_make_object_0();
+    if (obj == PURC_VARIANT_INVALID)
+        return false;
+
+    bool ok = true;
+    for (size_t i = 0; ok && i < size; i++) {
+        purc_variant_t key = purc_variant_array_get(fx->keys, i);
+        /* the keys outlive the object */
+        ok = purc_variant_object_set_by_static_ckey(obj,
+                purc_variant_get_string_const(key), key);
+    }
+
+    purc_variant_unref(obj);
+    return ok;
+}
+
+static bool
+run_object_get(struct bench_fixture *fx, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        purc_variant_t key = purc_variant_array_get(fx->keys, i);
+        if (purc_variant_object_get_by_ckey(fx->data,
+                    purc_variant_get_string_const(key)) != key)
+            return false;
+    }
+    return true;
+}
+
+static bool
+run_array_append(struct bench_fixture *fx, size_t size)
+{
+    (void)fx;
+    purc_variant_t arr = make_numbers(size, false);
+    if (arr == PURC_VARIANT_INVALID)
+        return false;
+    purc_variant_unref(arr);
+    return true;
+}
+
+static bool
+run_array_get(struct bench_fixture *fx, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        if (purc_variant_array_get(fx->data, i) == PURC_VARIANT_INVALID)
+            return false;
+    }
+    return true;
+}
+
+/* sorts a copy, so every run sorts the same pseudo-random order */
+static bool
+run_array_sort(struct bench_fixture *fx, size_t size)
+{
+    (void)size;
+    purc_variant_t arr = purc_variant_container_clone(fx->data);
+    if (arr == PURC_VARIANT_INVALID)
+        return false;
+
+    bool by_number = true;
+    int ret = pcvariant_sort_by_keys(arr, 1, &by_number, NULL, NULL,
+            false, false);
+    purc_variant_unref(arr);
+    return ret == 0;
+}
+
+static bool
+run_array_rows(struct bench_fixture *fx, size_t size)
+{
+    (void)fx;
+    purc_variant_t rows = make_rows(size, false);
+    if (rows == PURC_VARIANT_INVALID)
+        return false;
+    purc_variant_unref(rows);
+    return true;
+}
+
+static int
+count_member(void *ctxt, size_t idx, purc_variant_t key,
+        purc_variant_t member)
+{
+    (void)idx;
+    (void)key;
+    (void)member;
+    (*(size_t *)ctxt)++;
+    return 0;
+}
+
+static bool
+run_array_scan(struct bench_fixture *fx, size_t size)
+{
+    size_t n = 0;
+    purc_variant_container_scan(fx->data, count_member, &n);
+    return n == size;
+}
+
+static bool
+run_array_clone(struct bench_fixture *fx, size_t size)
+{
+    (void)size;
+    purc_variant_t v = purc_variant_container_clone_recursively(fx->data);
+    if (v == PURC_VARIANT_INVALID)
+        return false;
+    purc_variant_unref(v);
+    return true;
+}
+
+static bool
+run_set_add(struct bench_fixture *fx, size_t size)
+{
+    (void)fx;
+    purc_variant_t set = make_rows(size, true);
+    if (set == PURC_VARIANT_INVALID)
+        return false;
+    purc_variant_unref(set);
+    return true;
+}
+
+static bool
+run_set_find(struct bench_fixture *fx, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        purc_variant_t key = purc_variant_array_get(fx->keys, i);
+        if (pcvariant_set_find(fx->data, key) == PURC_VARIANT_INVALID)
+            return false;
+    }
+    return true;
+}
+
+static bool
+run_serialize(struct bench_fixture *fx, size_t size)
+{
+    (void)size;
+    purc_rwstream_t rws = purc_rwstream_new_buffer(1024, 0);
+    if (rws == NULL)
+        return false;
+
+    size_t len_expected = 0;
+    ssize_t n = purc_variant_serialize(fx->data, rws, 0,
+            PCVARIANT_SERIALIZE_OPT_PLAIN, &len_expected);
+    purc_rwstream_destroy(rws);
+    return n > 0;
+}
+
+static bool
+run_parse_json(struct bench_fixture *fx, size_t size)
+{
+    (void)size;
+    size_t len;
+    const char *json = purc_variant_get_string_const_ex(fx->keys, &len);
+    purc_variant_t v = purc_variant_make_from_json_string(json, len);
+    if (v == PURC_VARIANT_INVALID)
+        return false;
+    purc_variant_unref(v);
+    return true;
+}
+
+static bool
+run_stringify(struct bench_fixture *fx, size_t size)
+{
+    (void)size;
+    char *str = NULL;
+    ssize_t n = purc_variant_stringify_alloc(&str, fx->data);
+    free(str);
+    return n >= 0;
+}
+
+static bool
+run_numberify(struct bench_fixture *fx, size_t size)
+{
+    double sum = 0;
+    for (size_t i = 0; i < size; i++)
+        sum += purc_variant_numberify(purc_variant_array_get(fx->data, i));
+    return sum > 0;
+}
+
+static bool
+run_move_heap(struct bench_fixture *fx, size_t size)
+{
+    (void)fx;
+    purc_variant_t arr = make_rows(size, false);
+    if (arr == PURC_VARIANT_INVALID)
+        return false;
+
+    purc_variant_t moved = pcvariant_move_heap_in(arr);
+    if (moved == PURC_VARIANT_INVALID)
+        return false;
+
+    moved = pcvariant_move_heap_out(moved);
+    bool ok = purc_variant_array_get_size(moved) == (ssize_t)size;
+    purc_variant_unref(moved);
+    return ok;
+}
+
+static const struct bench_op bench_ops[] = {
+    { "make/number", NULL, run_make_number },
+    { "make/string", NULL, run_make_string },
+    { "ref_unref", setup_string, run_ref_unref },
+    { "object/set", setup_keys, run_object_set },
+    { "object/get", setup_object, run_object_get },
+    { "array/append", NULL, run_array_append },
+    { "array/get", setup_numbers, run_array_get },
+    { "array/sort", setup_shuffled, run_array_sort },
+    { "array/rows", NULL, run_array_rows },
+    { "array/scan", setup_rows, run_array_scan },
+    { "array/clone", setup_rows, run_array_clone },
+    { "set/add", NULL, run_set_add },
+    { "set/find", setup_set, run_set_find },
+    { "serialize", setup_rows, run_serialize },
+    { "serialize/reals", setup_reals, run_serialize },
+    { "parse/reals", setup_reals, run_parse_json },
+    { "stringify", setup_rows, run_stringify },
+    { "numberify", setup_numeric_strings, run_numberify },
+    { "move_heap", NULL, run_move_heap },
+    { "check_utf8/ascii", setup_ascii_text, run_check_utf8 },
+    { "check_utf8/cjk", setup_cjk_text, run_check_utf8 },
+};
+
+struct bench_thread {
+    const struct bench_op  *op;
+    size_t                  size;
+    int                     nr;
+
+    bool                    ok;
+    struct bench_stats     *stats;  // in the array of all the threads
+};
+
+/* all the threads start measuring at the same time */
+static pthread_barrier_t bench_barrier;
+
+static void *
+bench_entry(void *data)
+{
+    struct bench_thread *arg = (struct bench_thread *)data;
+    char runner[32];
+
+    snprintf(runner, sizeof(runner), "bench%d", arg->nr);
+    bool inited = purc_init_ex(PURC_MODULE_VARIANT, "cn.fmsoft.purc.test",
+            runner, NULL) == PURC_ERROR_OK;
+
+    struct bench_fixture fx = { PURC_VARIANT_INVALID, PURC_VARIANT_INVALID };
+    arg->ok = inited && (arg->op->setup == NULL ||
+            arg->op->setup(&fx, arg->size));
+
+    pthread_barrier_wait(&bench_barrier);
+    if (arg->ok) {
+        arg->ok = BenchRunner::measure([arg, &fx]() {
+            return arg->op->run(&fx, arg->size);
+        }, arg->stats);
+    }
+
+    if (fx.keys)
+        purc_variant_unref(fx.keys);
+    if (fx.data)
+        purc_variant_unref(fx.data);
+    if (inited)
+        purc_cleanup();
+    return NULL;
+}
+
+static bool
+bench_op(BenchRunner &bench, const struct bench_op *op, size_t size,
+        size_t nr_threads)
+{
+    std::vector<pthread_t> threads(nr_threads);
+    std::vector<bench_thread> args(nr_threads);
+    std::vector<bench_stats> stats(nr_threads);
+
+    pthread_barrier_init(&bench_barrier, NULL, nr_threads);
+    for (size_t i = 0; i < nr_threads; i++) {
+        args[i] = { op, size, (int)i, false, &stats[i] };
+        pthread_create(&threads[i], NULL, bench_entry, &args[i]);
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < nr_threads; i++) {
+        pthread_join(threads[i], NULL);
+        ok = ok && args[i].ok;
+    }
+    pthread_barrier_destroy(&bench_barrier);
+
+    return bench.record(op->name, size, nr_threads, ok ? &stats[0] : NULL);
+}
+
+TEST(bench_variant, operations)
+{
+    BenchRunner bench("bench_variant");
+    std::vector<size_t> sizes = BenchRunner::get_sizes(DEF_BENCH_SIZES);
+    std::vector<size_t> threads = BenchRunner::get_threads(DEF_BENCH_THREADS);
+    ASSERT_FALSE(sizes.empty());
+    ASSERT_FALSE(threads.empty());
+
+    for (size_t nr_threads : threads) {
+        for (size_t size : sizes) {
+            for (const struct bench_op &op : bench_ops) {
+                EXPECT_TRUE(bench_op(bench, &op, size, nr_threads))
+                    << op.name;
+            }
+        }
+    }
+
+    ASSERT_TRUE(bench.write_results());
+}
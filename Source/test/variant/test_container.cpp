@@ -400,15 +400,24 @@ TEST_P(TestCaseData, container_ops)
             break;
 
         case CONTAINER_OPS_TYPE_UNITE:
-            result = purc_variant_set_unite(dst, src, true);
+            if (purc_variant_is_array(dst))
+                result = purc_variant_array_unite(dst, src, true);
+            else
+                result = purc_variant_set_unite(dst, src, true);
             break;
 
         case CONTAINER_OPS_TYPE_INTERSECT:
-            result = purc_variant_set_intersect(dst, src, true);
+            if (purc_variant_is_array(dst))
+                result = purc_variant_array_intersect(dst, src, true);
+            else
+                result = purc_variant_set_intersect(dst, src, true);
             break;
 
         case CONTAINER_OPS_TYPE_SUBTRACT:
-            result = purc_variant_set_subtract(dst, src, true);
+            if (purc_variant_is_array(dst))
+                result = purc_variant_array_subtract(dst, src, true);
+            else
+                result = purc_variant_set_subtract(dst, src, true);
             break;
 
         case CONTAINER_OPS_TYPE_XOR:
@@ -544,3 +553,136 @@ TEST(variant, clone)
     PURC_VARIANT_SAFE_CLEAR(set);
 }
 
+
+TEST(variant, clone_nested)
+{
+    PurCInstance purc("cn.fmsoft.hybridos.test", "purc_variant", false);
+
+    purc_variant_t arr = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    ASSERT_NE(arr, nullptr);
+    for (int i = 0; i < 100; i++) {
+        purc_variant_t obj = purc_variant_make_object(0,
+                PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+        purc_variant_t id = purc_variant_make_longint(i);
+        purc_variant_object_set_by_static_ckey(obj, "id", id);
+        purc_variant_array_append(arr, obj);
+        purc_variant_unref(id);
+        purc_variant_unref(obj);
+    }
+
+    purc_variant_t members[2] = { arr, purc_variant_make_null() };
+    purc_variant_t tuple = purc_variant_make_tuple(2, members);
+    ASSERT_NE(tuple, nullptr);
+
+    purc_variant_t cloned = purc_variant_container_clone_recursively(tuple);
+    ASSERT_NE(cloned, nullptr);
+    ASSERT_EQ(purc_variant_compare_ex(tuple, cloned,
+                PCVARIANT_COMPARE_OPT_AUTO), 0);
+
+    /* the source is intact, and the clone owns its containers */
+    ASSERT_EQ(purc_variant_tuple_get(tuple, 0), arr);
+    purc_variant_t arr2 = purc_variant_tuple_get(cloned, 0);
+    ASSERT_NE(arr2, arr);
+    ASSERT_EQ(purc_variant_array_get_size(arr2), 100U);
+    purc_variant_t obj2 = purc_variant_array_get(arr2, 50);
+    ASSERT_NE(obj2, purc_variant_array_get(arr, 50));
+
+    purc_variant_t id = purc_variant_make_longint(1000);
+    purc_variant_object_set_by_static_ckey(obj2, "id", id);
+    purc_variant_unref(id);
+    ASSERT_NE(purc_variant_compare_ex(tuple, cloned,
+                PCVARIANT_COMPARE_OPT_AUTO), 0);
+
+    purc_variant_unref(cloned);
+    purc_variant_unref(tuple);
+    purc_variant_unref(members[1]);
+    purc_variant_unref(arr);
+}
+
+struct scan_ctxt {
+    purc_variant_t container;
+    int64_t sum;
+    size_t nr;
+    bool change_failed;
+};
+
+static int
+sum_member(void *ctxt, size_t idx, purc_variant_t key, purc_variant_t member)
+{
+    struct scan_ctxt *sc = (struct scan_ctxt *)ctxt;
+    (void)key;
+
+    int64_t i;
+    purc_variant_cast_to_longint(member, &i, false);
+    sc->sum += i;
+    if (idx != sc->nr)
+        return -2;
+    sc->nr++;
+
+    /* the container is pinned while scanning */
+    if (idx == 0 && purc_variant_is_array(sc->container)) {
+        sc->change_failed = !purc_variant_array_append(sc->container, member)
+            && purc_get_last_error() == PURC_ERROR_ACCESS_DENIED;
+    }
+
+    return (sc->nr == 10) ? 1 : 0;
+}
+
+TEST(variant, container_scan)
+{
+    PurCInstance purc;
+
+    purc_variant_t arr = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    purc_variant_t obj = purc_variant_make_object(0,
+            PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+    purc_variant_t set = purc_variant_make_set_0(PURC_VARIANT_INVALID);
+    for (int i = 1; i <= 5; i++) {
+        purc_variant_t v = purc_variant_make_longint(i);
+        purc_variant_array_append(arr, v);
+        purc_variant_set_add(set, v, false);
+        char key[8];
+        snprintf(key, sizeof(key), "k%d", i);
+        purc_variant_t k = purc_variant_make_string(key, false);
+        purc_variant_object_set(obj, k, v);
+        purc_variant_unref(k);
+        purc_variant_unref(v);
+    }
+
+    purc_variant_t containers[] = { arr, obj, set };
+    for (size_t i = 0; i < PCA_TABLESIZE(containers); i++) {
+        struct scan_ctxt sc = { containers[i], 0, 0, false };
+        unsigned int refc = purc_variant_ref_count(containers[i]);
+        ASSERT_EQ(purc_variant_container_scan(containers[i],
+                    sum_member, &sc), 0);
+        ASSERT_EQ(sc.sum, 15);
+        ASSERT_EQ(sc.nr, 5U);
+        ASSERT_EQ(purc_variant_ref_count(containers[i]), refc);
+    }
+
+    /* the pin is released after the scan */
+    struct scan_ctxt sc = { arr, 0, 0, false };
+    ASSERT_EQ(purc_variant_container_scan(arr, sum_member, &sc), 0);
+    ASSERT_TRUE(sc.change_failed);
+    purc_variant_t v = purc_variant_make_longint(5);
+    ASSERT_TRUE(purc_variant_array_append(arr, v));
+    purc_variant_unref(v);
+
+    /* the value returned by the callback stops the scan */
+    for (int i = 0; i < 10; i++) {
+        v = purc_variant_make_longint(1);
+        purc_variant_array_append(arr, v);
+        purc_variant_unref(v);
+    }
+    sc = { arr, 0, 0, false };
+    ASSERT_EQ(purc_variant_container_scan(arr, sum_member, &sc), 1);
+    ASSERT_EQ(sc.nr, 10U);
+
+    v = purc_variant_make_longint(1);
+    ASSERT_EQ(purc_variant_container_scan(v, sum_member, &sc), -1);
+    ASSERT_EQ(purc_get_last_error(), PURC_ERROR_WRONG_DATA_TYPE);
+    purc_variant_unref(v);
+
+    purc_variant_unref(set);
+    purc_variant_unref(obj);
+    purc_variant_unref(arr);
+}
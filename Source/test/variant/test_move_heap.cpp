@@ -0,0 +1,241 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "purc.h"
+#include "private/variant.h"
+
+#include <gtest/gtest.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <sys/time.h>
+
+#define NR_MAX_THREADS          16
+#define NR_MOVES                2000
+#define NR_MEMBERS              16
+
+struct bench_arg {
+    int                 nr;
+    size_t              nr_moved;
+    bool                ok;
+};
+
+static double
+current_time_ms(void)
+{
+    struct timeval now;
+    gettimeofday(&now, 0);
+    return now.tv_sec * 1000.0 + now.tv_usec / 1000.0;
+}
+
+/* an array of objects sharing a string and holding constants */
+static purc_variant_t
+make_message(purc_variant_t shared)
+{
+    purc_variant_t arr = purc_variant_make_array_0();
+
+    for (int i = 0; i < NR_MEMBERS; i++) {
+        purc_variant_t num = purc_variant_make_number(i);
+        purc_variant_t flag = purc_variant_make_boolean(i % 2);
+        purc_variant_t obj = purc_variant_make_object_by_static_ckey(3,
+                "name", shared, "index", num, "flag", flag);
+        purc_variant_array_append(arr, obj);
+        purc_variant_unref(obj);
+        purc_variant_unref(flag);
+        purc_variant_unref(num);
+    }
+
+    return arr;
+}
+
+static void *
+bench_entry(void *data)
+{
+    struct bench_arg *arg = (struct bench_arg *)data;
+    char runner[32];
+
+    snprintf(runner, sizeof(runner), "bench%d", arg->nr);
+    if (purc_init_ex(PURC_MODULE_VARIANT, "cn.fmsoft.purc.test",
+                runner, NULL) != PURC_ERROR_OK)
+        return NULL;
+
+    size_t nr_values = purc_variant_usage_stat()->nr_total_values;
+
+    purc_variant_t shared = purc_variant_make_string("a shared string", false);
+    arg->ok = true;
+    for (size_t i = 0; i < NR_MOVES; i++) {
+        purc_variant_t msg = make_message(shared);
+        purc_variant_t moved = pcvariant_move_heap_in(msg);
+        if (moved == PURC_VARIANT_INVALID) {
+            arg->ok = false;
+            break;
+        }
+
+        moved = pcvariant_move_heap_out(moved);
+        if (purc_variant_array_get_size(moved) != NR_MEMBERS) {
+            arg->ok = false;
+        }
+        purc_variant_unref(moved);
+        arg->nr_moved++;
+    }
+    purc_variant_unref(shared);
+
+    /* all variants moved in and out are accounted in this instance */
+    if (purc_variant_usage_stat()->nr_total_values != nr_values)
+        arg->ok = false;
+
+    purc_cleanup();
+    return NULL;
+}
+
+static double
+run_bench(int nr_threads)
+{
+    pthread_t threads[NR_MAX_THREADS];
+    struct bench_arg args[NR_MAX_THREADS] = {};
+
+    double started = current_time_ms();
+    for (int i = 0; i < nr_threads; i++) {
+        args[i].nr = i;
+        if (pthread_create(threads + i, NULL, bench_entry, args + i))
+            return -1;
+    }
+
+    for (int i = 0; i < nr_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    double elapsed = current_time_ms() - started;
+
+    for (int i = 0; i < nr_threads; i++) {
+        if (!args[i].ok || args[i].nr_moved != NR_MOVES)
+            return -1;
+    }
+
+    return elapsed;
+}
+
+/* the move heap should not serialize the threads moving variants */
+TEST(move_heap, threads)
+{
+    static const int nr_threads[] = { 1, 4, NR_MAX_THREADS };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(nr_threads); i++) {
+        double elapsed = run_bench(nr_threads[i]);
+        ASSERT_GE(elapsed, 0.0);
+
+        fprintf(stderr, "%d threads x %d moves of %d objects: %.3f ms\n",
+                nr_threads[i], NR_MOVES, NR_MEMBERS, elapsed);
+    }
+}
+
+#define NR_SHARED_THREADS       8
+#define DATASET_NAME            "test-dataset"
+
+struct shared_arg {
+    int                 nr;
+    purc_variant_t      dataset;
+    bool                ok;
+};
+
+static bool
+check_dataset(purc_variant_t dataset)
+{
+    if (purc_variant_array_get_size(dataset) != NR_MEMBERS)
+        return false;
+
+    purc_variant_t obj = purc_variant_array_get(dataset, 1);
+    purc_variant_t flag = purc_variant_object_get_by_ckey(obj, "flag");
+    return flag && purc_variant_is_true(flag);
+}
+
+static void *
+shared_entry(void *data)
+{
+    struct shared_arg *arg = (struct shared_arg *)data;
+    char runner[32];
+
+    snprintf(runner, sizeof(runner), "shared%d", arg->nr);
+    if (purc_init_ex(PURC_MODULE_VARIANT, "cn.fmsoft.purc.test",
+                runner, NULL) != PURC_ERROR_OK)
+        return NULL;
+
+    size_t nr_values = purc_variant_usage_stat()->nr_total_values;
+
+    purc_variant_t dataset = pcvariant_shared_data_get(DATASET_NAME);
+    if (dataset == PURC_VARIANT_INVALID) {
+        purc_variant_t name = purc_variant_make_string("a dataset", false);
+        dataset = pcvariant_shared_data_publish(DATASET_NAME,
+                make_message(name));
+        purc_variant_unref(name);
+    }
+
+    arg->ok = dataset && check_dataset(dataset);
+    arg->dataset = dataset;
+    if (dataset) {
+        /* the dataset can not be changed */
+        purc_variant_t num = purc_variant_make_number(0);
+        if (purc_variant_array_append(dataset, num) ||
+                purc_get_last_error() != PURC_ERROR_ACCESS_DENIED)
+            arg->ok = false;
+        purc_variant_unref(num);
+
+        /* but held by the variants of the instance */
+        for (size_t i = 0; i < NR_MOVES; i++) {
+            purc_variant_t arr = purc_variant_make_array_0();
+            purc_variant_array_append(arr, dataset);
+            purc_variant_array_append(arr, purc_variant_array_get(dataset, 0));
+            purc_variant_t moved = pcvariant_move_heap_in(arr);
+            moved = pcvariant_move_heap_out(moved);
+            if (purc_variant_array_get(moved, 0) != dataset)
+                arg->ok = false;
+            purc_variant_unref(moved);
+        }
+        purc_variant_unref(dataset);
+    }
+
+    /* the dataset is accounted in the move heap */
+    if (purc_variant_usage_stat()->nr_total_values != nr_values)
+        arg->ok = false;
+
+    purc_cleanup();
+    return NULL;
+}
+
+/* the threads bind the same dataset, which is released by the last one */
+TEST(shared_data, threads)
+{
+    pthread_t threads[NR_SHARED_THREADS];
+    struct shared_arg args[NR_SHARED_THREADS] = {};
+
+    for (int i = 0; i < NR_SHARED_THREADS; i++) {
+        args[i].nr = i;
+        ASSERT_EQ(pthread_create(threads + i, NULL, shared_entry, args + i),
+                0);
+    }
+
+    for (int i = 0; i < NR_SHARED_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        ASSERT_TRUE(args[i].ok);
+    }
+
+    ASSERT_EQ(purc_init_ex(PURC_MODULE_VARIANT, "cn.fmsoft.purc.test",
+                "shared", NULL), PURC_ERROR_OK);
+    ASSERT_EQ(pcvariant_shared_data_get(DATASET_NAME), PURC_VARIANT_INVALID);
+    purc_cleanup();
+}
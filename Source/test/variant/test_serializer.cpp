@@ -262,6 +262,38 @@ TEST(variant, serialize_number)
     ASSERT_STREQ(buf, "1.123456");
     purc_variant_unref(my_variant);
 
+    /* case 5: the shortest digits which can be read back */
+    purc_remove_local_data("format-double");
+
+    static const struct {
+        double d;
+        const char *str;
+    } doubles[] = {
+        { 0.1, "0.1" },
+        { -2.5, "-2.5" },
+        { 1.0 / 3, "0.3333333333333333" },
+        { 1e-7, "1e-07" },
+        { 1.5e300, "1.5e+300" },
+        { -0.0, "-0" },
+        { 4e18, "4000000000000000000" },
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(doubles); i++) {
+        my_variant = purc_variant_make_number(doubles[i].d);
+        ASSERT_NE(my_variant, PURC_VARIANT_INVALID);
+
+        len_expected = 0;
+        purc_rwstream_seek(my_rws, 0, SEEK_SET);
+        n = purc_variant_serialize(my_variant, my_rws,
+                0, PCVARIANT_SERIALIZE_OPT_PLAIN, &len_expected);
+        ASSERT_GT(n, 0);
+
+        buf[n] = 0;
+        ASSERT_STREQ(buf, doubles[i].str);
+        ASSERT_EQ(strtod(buf, NULL), doubles[i].d);
+        purc_variant_unref(my_variant);
+    }
+
     purc_rwstream_destroy(my_rws);
 
     purc_cleanup ();
@@ -994,3 +1026,145 @@ TEST(variant, serialize_object_with_empty_key2)
 
     purc_cleanup ();
 }
+
+// to test: serialize a long string with a few chars to escape
+TEST(variant, serialize_long_string)
+{
+    int ret = purc_init_ex (PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test",
+            "variant", NULL);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    std::string str, expected = "\"";
+    for (size_t i = 0; i < 65536; i++) {
+        if (i % 53 == 15) {
+            str += '"';
+            expected += "\\\"";
+        }
+        else if (i % 97 == 16) {
+            str += '\n';
+            expected += "\\n";
+        }
+        else if (i % 211 == 31) {
+            str += '\x1c';
+            expected += "\\u001c";
+        }
+        else if (i % 307 == 32) {
+            str += "\xe4\xb8\xad";
+            expected += "\xe4\xb8\xad";
+        }
+        else {
+            str += (char)('a' + i % 26);
+            expected += (char)('a' + i % 26);
+        }
+    }
+    expected += "\"";
+
+    purc_variant_t my_variant = purc_variant_make_string(str.c_str(), false);
+    ASSERT_NE(my_variant, PURC_VARIANT_INVALID);
+
+    purc_rwstream_t my_rws = purc_rwstream_new_buffer(1024, 1024 * 1024);
+    ASSERT_NE(my_rws, nullptr);
+
+    size_t len_expected = 0;
+    ssize_t n = purc_variant_serialize(my_variant, my_rws,
+            0, PCVARIANT_SERIALIZE_OPT_PLAIN, &len_expected);
+    ASSERT_GT(n, 0);
+    ASSERT_EQ((size_t)n, expected.length());
+
+    size_t sz_content = 0;
+    const char *buf = (const char *)purc_rwstream_get_mem_buffer(my_rws,
+            &sz_content);
+    ASSERT_EQ(std::string(buf, sz_content), expected);
+
+    purc_variant_unref(my_variant);
+    purc_rwstream_destroy(my_rws);
+
+    purc_cleanup ();
+}
+
+// to test: the binary eJSON encoding keeps the types lost by the text one
+TEST(variant, serialize_binary)
+{
+    int ret = purc_init_ex (PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test",
+            "variant", NULL);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    const char *ejson = "{"
+        "\"bytes\": bx0102030405,"
+        "\"text\": \"\xe4\xb8\xad\xe6\x96\x87\","
+        "\"array\": [ null, true, false, 1.5 ]"
+    "}";
+    purc_variant_t my_variant = purc_variant_make_from_json_string(ejson,
+            strlen(ejson));
+    ASSERT_NE(my_variant, PURC_VARIANT_INVALID);
+
+    /* the eJSON parser has no syntax for the sets */
+    purc_variant_t objs[2];
+    for (size_t i = 0; i < 2; i++) {
+        objs[i] = purc_variant_make_object(0, PURC_VARIANT_INVALID,
+                PURC_VARIANT_INVALID);
+        purc_variant_t id = purc_variant_make_longint(i + 1);
+        ASSERT_TRUE(purc_variant_object_set_by_static_ckey(objs[i],
+                    "id", id));
+        purc_variant_unref(id);
+    }
+    purc_variant_t set = purc_variant_make_set_by_ckey(2, "id",
+            objs[0], objs[1]);
+    ASSERT_NE(set, PURC_VARIANT_INVALID);
+    for (size_t i = 0; i < 2; i++)
+        purc_variant_unref(objs[i]);
+    ASSERT_TRUE(purc_variant_object_set_by_static_ckey(my_variant,
+                "set", set));
+    purc_variant_unref(set);
+
+    purc_variant_t members[] = {
+        purc_variant_make_longint(1),
+        purc_variant_make_ulongint(2),
+        purc_variant_make_longdouble(3.5L),
+    };
+    purc_variant_t tuple = purc_variant_make_tuple(3, members);
+    ASSERT_NE(tuple, PURC_VARIANT_INVALID);
+    for (size_t i = 0; i < 3; i++)
+        purc_variant_unref(members[i]);
+    ASSERT_TRUE(purc_variant_object_set_by_static_ckey(my_variant,
+                "tuple", tuple));
+    purc_variant_unref(tuple);
+
+    purc_rwstream_t my_rws = purc_rwstream_new_buffer(1024, 1024 * 1024);
+    ASSERT_NE(my_rws, nullptr);
+
+    ssize_t n = purc_variant_serialize_binary(my_variant, my_rws, 0);
+    ASSERT_GT(n, 0);
+
+    size_t sz_content = 0;
+    const char *buf = (const char *)purc_rwstream_get_mem_buffer(my_rws,
+            &sz_content);
+    ASSERT_EQ((size_t)n, sz_content);
+
+    unsigned opts[] = { 0, PCVARIANT_BINARY_OPT_ZERO_COPY };
+    for (size_t i = 0; i < sizeof(opts)/sizeof(opts[0]); i++) {
+        purc_variant_t loaded = purc_variant_load_from_binary(buf,
+                sz_content, opts[i]);
+        ASSERT_NE(loaded, PURC_VARIANT_INVALID);
+        ASSERT_TRUE(purc_variant_is_equal_to(my_variant, loaded));
+
+        purc_variant_t v = purc_variant_object_get_by_ckey(loaded, "tuple");
+        ASSERT_EQ(purc_variant_get_type(v), PURC_VARIANT_TYPE_TUPLE);
+        v = purc_variant_tuple_get(v, 2);
+        ASSERT_TRUE(purc_variant_is_longdouble(v));
+
+        v = purc_variant_object_get_by_ckey(loaded, "set");
+        ASSERT_TRUE(purc_variant_is_set(v));
+        purc_variant_unref(loaded);
+    }
+
+    /* the truncated data are rejected */
+    purc_variant_t loaded = purc_variant_load_from_binary(buf,
+            sz_content - 1, 0);
+    ASSERT_EQ(loaded, PURC_VARIANT_INVALID);
+
+    purc_variant_unref(my_variant);
+    purc_rwstream_destroy(my_rws);
+
+    purc_cleanup ();
+}
@@ -115,3 +115,162 @@ TEST(set, unique_key_find)
     ASSERT_EQ (cleanup, true);
 }
 
+
+static char *make_member(int id, const char *rank_json)
+{
+    char *json;
+    if (asprintf(&json, "{\"id\":%d,\"rank\":%s}", id, rank_json) < 0)
+        return NULL;
+    return json;
+}
+
+static purc_variant_t
+add_member(purc_variant_t set, int id, const char *rank_json)
+{
+    char *json = make_member(id, rank_json);
+    purc_variant_t v = purc_variant_make_from_json_string(json, strlen(json));
+    free(json);
+    if (v == PURC_VARIANT_INVALID)
+        return v;
+
+    bool ok = purc_variant_set_add(set, v, true);
+    purc_variant_unref(v);
+    return ok ? set : PURC_VARIANT_INVALID;
+}
+
+TEST(set, secondary_index)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex (PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test",
+            "test_init", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    purc_variant_t set = purc_variant_make_set_by_ckey(0, "id",
+            PURC_VARIANT_INVALID);
+    ASSERT_NE(set, PURC_VARIANT_INVALID);
+
+    for (int i = 0; i < 100; i++) {
+        char rank[16];
+        snprintf(rank, sizeof(rank), "%d", (i * 37) % 100);
+        ASSERT_NE(add_member(set, i, rank), PURC_VARIANT_INVALID);
+    }
+
+    ASSERT_EQ(pcvariant_set_create_index(set, "rank"), 0);
+    ASSERT_TRUE(pcvariant_set_has_index(set, "rank"));
+
+    purc_variant_t lo = purc_variant_make_number(10);
+    purc_variant_t hi = purc_variant_make_number(20);
+    size_t *positions, nr;
+
+    // 10 <= rank < 20
+    ASSERT_EQ(pcvariant_set_index_lookup(set, "rank", lo, true, hi, false,
+                &positions, &nr), 0);
+    ASSERT_EQ(nr, 10);
+    for (size_t i = 0; i < nr; i++) {
+        purc_variant_t m = purc_variant_set_get_by_index(set, positions[i]);
+        double rank = purc_variant_numberify(
+                purc_variant_object_get_by_ckey(m, "rank"));
+        ASSERT_GE(rank, 10);
+        ASSERT_LT(rank, 20);
+        if (i > 0) {
+            ASSERT_LT(positions[i - 1], positions[i]);
+        }
+    }
+    free(positions);
+
+    // the index follows the elements added, overwritten, and removed
+    ASSERT_NE(add_member(set, 100, "15"), PURC_VARIANT_INVALID);
+    ASSERT_NE(add_member(set, 0, "50"), PURC_VARIANT_INVALID);
+    purc_variant_t v = purc_variant_set_remove_by_index(set, 1);
+    ASSERT_NE(v, PURC_VARIANT_INVALID);
+    purc_variant_unref(v);
+
+    ASSERT_EQ(pcvariant_set_index_lookup(set, "rank", lo, true, hi, true,
+                &positions, &nr), 0);
+    size_t expected = 0;
+    size_t sz = purc_variant_set_get_size(set);
+    for (size_t i = 0; i < sz; i++) {
+        purc_variant_t m = purc_variant_set_get_by_index(set, i);
+        double rank = purc_variant_numberify(
+                purc_variant_object_get_by_ckey(m, "rank"));
+        if (rank >= 10 && rank <= 20)
+            expected++;
+    }
+    ASSERT_EQ(nr, expected);
+    free(positions);
+
+    // a string among the numbers needs a scan
+    ASSERT_NE(add_member(set, 200, "\"abc\""), PURC_VARIANT_INVALID);
+    ASSERT_EQ(pcvariant_set_index_lookup(set, "rank", lo, true, NULL, false,
+                &positions, &nr), -1);
+    ASSERT_EQ(purc_get_last_error(), PURC_ERROR_NOT_SUPPORTED);
+
+    ASSERT_EQ(pcvariant_set_drop_index(set, "rank"), 0);
+    ASSERT_FALSE(pcvariant_set_has_index(set, "rank"));
+
+    purc_variant_unref(lo);
+    purc_variant_unref(hi);
+    purc_variant_unref(set);
+    ASSERT_TRUE(purc_cleanup());
+}
+
+static purc_variant_t make_named(const char *name, int id)
+{
+    char json[128];
+    snprintf(json, sizeof(json), "{\"name\":\"%s\",\"id\":%d}", name, id);
+    return purc_variant_make_from_json_string(json, strlen(json));
+}
+
+TEST(set, caseless_unique_key)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex (PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test",
+            "test_init", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    purc_variant_t set = purc_variant_make_set_by_ckey_ex(0, "name", true,
+            PURC_VARIANT_INVALID);
+    ASSERT_NE(set, PURC_VARIANT_INVALID);
+
+    // more elements than the threshold of the hash index
+    char name[64];
+    for (int i = 0; i < 100; i++) {
+        snprintf(name, sizeof(name), "Member-%d", i);
+        purc_variant_t v = make_named(name, i);
+        ASSERT_TRUE(purc_variant_set_add(set, v, true));
+        purc_variant_unref(v);
+    }
+
+    // the non-ASCII letters are folded in comparing but not in hashing
+    purc_variant_t v = make_named("\xc3\x89t\xc3\xa9", 100);
+    ASSERT_TRUE(purc_variant_set_add(set, v, true));
+    purc_variant_unref(v);
+    ASSERT_EQ(purc_variant_set_get_size(set), 101);
+
+    for (int i = 0; i < 100; i++) {
+        snprintf(name, sizeof(name), "MEMBER-%d", i);
+        v = make_named(name, i + 200);
+        purc_variant_t found = pcvariant_set_find(set, v);
+        ASSERT_NE(found, PURC_VARIANT_INVALID);
+        ASSERT_EQ(purc_variant_numberify(
+                    purc_variant_object_get_by_ckey(found, "id")), i);
+
+        ASSERT_TRUE(purc_variant_set_add(set, v, true));
+        purc_variant_unref(v);
+    }
+    ASSERT_EQ(purc_variant_set_get_size(set), 101);
+
+    v = make_named("\xc3\xa9T\xc3\x89", 300);
+    purc_variant_t found = pcvariant_set_find(set, v);
+    purc_variant_unref(v);
+    ASSERT_NE(found, PURC_VARIANT_INVALID);
+    ASSERT_EQ(purc_variant_numberify(
+                purc_variant_object_get_by_ckey(found, "id")), 100);
+
+    v = make_named("member-100", 400);
+    ASSERT_EQ(pcvariant_set_find(set, v), PURC_VARIANT_INVALID);
+    purc_variant_unref(v);
+
+    purc_variant_unref(set);
+    ASSERT_TRUE(purc_cleanup());
+}
@@ -21,6 +21,7 @@
 #include "private/debug.h"
 #include "private/errors.h"
 #include "private/variant.h"
+#include "private/hashtable.h"
 
 #include <stdio.h>
 #include <errno.h>
@@ -684,6 +685,13 @@ TEST(variant, pcvariant_string)
     ASSERT_EQ (length, strlen(purc_variant_get_string_const (value)) + 1);
     ASSERT_GT (length, real_size);
 
+    purc_variant_string_chars (value, &nr_chars);
+    ASSERT_EQ (nr_chars, 10);
+
+    // the hash value cached does not change the number of the characters
+    uint32_t hash = pcvariant_string_hash (value);
+    ASSERT_EQ (hash, (uint32_t)pchash_default_char_hash (long_ok));
+    ASSERT_EQ (pcvariant_string_hash (value), hash);
     purc_variant_string_chars (value, &nr_chars);
     ASSERT_EQ (nr_chars, 10);
     purc_variant_unref(value);
@@ -1153,6 +1161,90 @@ TEST(variant, pcvariant_loopbuffer_all)
     purc_cleanup ();
 }
 
+// to test:
+// the chunks of variants and container nodes are recycled by the slab
+TEST(variant, pcvariant_slab)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex (PURC_MODULE_VARIANT, "cn.fmsfot.hvml.test",
+            "variant", &info);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    const struct purc_variant_stat * stat = purc_variant_usage_stat ();
+    ASSERT_NE(stat, nullptr);
+    size_t old_hits = stat->nr_slab_hits;
+
+    for (int round = 0; round < 2; round++) {
+        purc_variant_t arr = purc_variant_make_array_0 ();
+        ASSERT_NE(arr, nullptr);
+        for (int i = 0; i < 1000; i++) {
+            purc_variant_t obj = purc_variant_make_object_0 ();
+            purc_variant_t v = purc_variant_make_longint (i);
+            ASSERT_TRUE(purc_variant_object_set_by_static_ckey (obj, "v", v));
+            ASSERT_TRUE(purc_variant_array_append (arr, obj));
+            purc_variant_unref (v);
+            purc_variant_unref (obj);
+        }
+        purc_variant_unref (arr);
+
+        stat = purc_variant_usage_stat ();
+        ASSERT_NE(stat, nullptr);
+        ASSERT_GT(stat->nr_slab_misses, 0U);
+        ASSERT_GT(stat->sz_slab_mem, 0U);
+    }
+
+    // the second round should be served by the chunks freed in the first one
+    ASSERT_GT(stat->nr_slab_hits, old_hits + 1000 * 3);
+
+    purc_cleanup ();
+}
+
+TEST(variant, pcvariant_string_ascii)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex (PURC_MODULE_VARIANT, "cn.fmsfot.hvml.test",
+            "variant", &info);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    const char *strs[] = {
+        "short",
+        "a long string which is stored in the extra space",
+        "\xe4\xb8\xad",
+        "a long string with a non-ASCII character: \xe4\xb8\xad",
+    };
+    const bool is_ascii[] = { true, true, false, false };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(strs); i++) {
+        purc_variant_t v = purc_variant_make_string (strs[i], true);
+        ASSERT_NE(v, nullptr);
+        ASSERT_EQ(pcvariant_string_is_ascii (v), is_ascii[i]);
+        purc_variant_unref (v);
+
+        v = purc_variant_make_string_static (strs[i], true);
+        ASSERT_NE(v, nullptr);
+        ASSERT_EQ(pcvariant_string_is_ascii (v), is_ascii[i]);
+        purc_variant_unref (v);
+
+        char *buf = strdup (strs[i]);
+        v = purc_variant_make_string_reuse_buff (buf, strlen (buf), true);
+        ASSERT_NE(v, nullptr);
+        ASSERT_EQ(pcvariant_string_is_ascii (v), is_ascii[i]);
+        purc_variant_unref (v);
+    }
+
+    char *buf = strdup ("ascii");
+    purc_variant_t v = pcvariant_make_ascii_string_reuse_buff (buf, 5);
+    ASSERT_NE(v, nullptr);
+    size_t len, nr_chars;
+    ASSERT_STREQ(purc_variant_get_string_const_ex (v, &len), "ascii");
+    ASSERT_EQ(len, 5U);
+    ASSERT_TRUE(purc_variant_string_chars (v, &nr_chars));
+    ASSERT_EQ(nr_chars, 5U);
+    purc_variant_unref (v);
+
+    purc_cleanup ();
+}
+
 static inline purc_variant_t
 _getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         bool silently)
@@ -1579,3 +1671,50 @@ TEST(variant, reuse_buff)
     purc_cleanup ();
 }
 
+
+TEST(variant, collect_cycles)
+{
+    setenv(PURC_ENVV_VARIANT_GC_BUDGET, "1000", 1);
+
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_VARIANT, "cn.fmsfot.hvml.test",
+            "variant", &info);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    const struct purc_variant_stat *stat = purc_variant_usage_stat();
+    ASSERT_NE(stat, nullptr);
+    size_t nr_collected = stat->nr_gc_collected;
+
+    // an array holding an object which holds the array
+    purc_variant_t arr = purc_variant_make_array_0();
+    purc_variant_t obj = purc_variant_make_object_0();
+    ASSERT_NE(arr, PURC_VARIANT_INVALID);
+    ASSERT_NE(obj, PURC_VARIANT_INVALID);
+    ASSERT_TRUE(purc_variant_array_append(arr, obj));
+    ASSERT_TRUE(purc_variant_object_set_by_static_ckey(obj, "arr", arr));
+
+    // a live array holding another object
+    purc_variant_t live = purc_variant_make_array_0();
+    purc_variant_t member = purc_variant_make_object_0();
+    ASSERT_TRUE(purc_variant_array_append(live, member));
+    purc_variant_unref(member);
+
+    purc_variant_unref(arr);
+    purc_variant_unref(obj);
+
+    size_t reclaimed = purc_variant_collect_cycles(0);
+    ASSERT_GT(reclaimed, 0U);
+
+    stat = purc_variant_usage_stat();
+    ASSERT_GE(stat->nr_gc_collected - nr_collected, 2U);
+    ASSERT_GT(stat->sz_gc_reclaimed, 0U);
+
+    // nothing more to collect, and the live one is intact
+    ASSERT_EQ(purc_variant_collect_cycles(0), 0U);
+    ASSERT_EQ(purc_variant_array_get_size(live), 1U);
+    ASSERT_TRUE(purc_variant_is_object(purc_variant_array_get(live, 0)));
+    purc_variant_unref(live);
+
+    purc_cleanup ();
+    unsetenv(PURC_ENVV_VARIANT_GC_BUDGET);
+}
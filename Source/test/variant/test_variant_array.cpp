@@ -533,3 +533,187 @@ TEST(variant_array, sort)
     ASSERT_STREQ(inbuf, outbuf);
 }
 
+
+TEST(variant_array, insert_remove_sort_many)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex (PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test",
+            "test_init", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    const struct purc_variant_stat *stat = purc_variant_usage_stat();
+    ASSERT_NE(stat, nullptr);
+
+    purc_variant_t arr = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    ASSERT_NE(arr, nullptr);
+
+    // the even numbers are appended, the odd ones are inserted in between
+    const int count = 10000;
+    for (int j = 0; j < count; j += 2) {
+        purc_variant_t v = purc_variant_make_longint(j);
+        ASSERT_TRUE(purc_variant_array_append(arr, v));
+        purc_variant_unref(v);
+    }
+    for (int j = 1; j < count; j += 2) {
+        purc_variant_t v = purc_variant_make_longint(j);
+        ASSERT_TRUE(purc_variant_array_insert_after(arr, j - 1, v));
+        purc_variant_unref(v);
+    }
+    ASSERT_EQ(purc_variant_array_get_size(arr), count);
+
+    purc_variant_t val;
+    size_t idx;
+    foreach_value_in_variant_array(arr, val, idx)
+        int64_t i64;
+        ASSERT_TRUE(purc_variant_cast_to_longint(val, &i64, false));
+        ASSERT_EQ(i64, (int64_t)idx);
+    end_foreach;
+
+    // sort descending
+    uintptr_t sort_flags = PCVARIANT_SORT_DESC | PCVARIANT_COMPARE_OPT_NUMBER;
+    ASSERT_EQ(pcvariant_array_sort(arr, (void *)sort_flags, NULL), 0);
+    foreach_value_in_variant_array(arr, val, idx)
+        int64_t i64;
+        ASSERT_TRUE(purc_variant_cast_to_longint(val, &i64, false));
+        ASSERT_EQ(i64, (int64_t)(count - 1 - idx));
+    end_foreach;
+
+    // remove the odd numbers in the reverse order
+    foreach_value_in_variant_array_reverse_safe(arr, val, idx)
+        int64_t i64;
+        ASSERT_TRUE(purc_variant_cast_to_longint(val, &i64, false));
+        if (i64 % 2) {
+            ASSERT_TRUE(purc_variant_array_remove(arr, idx));
+        }
+    end_foreach;
+    ASSERT_EQ(purc_variant_array_get_size(arr), count / 2);
+
+    // the same value held by more than one slot
+    purc_variant_t s = purc_variant_make_string("shared", false);
+    ASSERT_TRUE(purc_variant_array_set(arr, 0, s));
+    ASSERT_TRUE(purc_variant_array_set(arr, 1, s));
+    ASSERT_EQ(s->refc, 3);
+    ASSERT_TRUE(purc_variant_array_remove(arr, 0));
+    ASSERT_EQ(s->refc, 2);
+    ASSERT_EQ(purc_variant_array_get(arr, 0), s);
+    purc_variant_unref(s);
+
+    purc_variant_unref(arr);
+    ASSERT_EQ(stat->nr_values[PVT(_ARRAY)], 0);
+
+    bool cleanup = purc_cleanup ();
+    ASSERT_EQ (cleanup, true);
+}
+
+TEST(variant_array, sort_by_numbers)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex (PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test",
+            "test_init", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    purc_variant_t arr = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    ASSERT_NE(arr, nullptr);
+
+    // the numbers of different types and the numeric strings
+    purc_variant_t vals[] = {
+        purc_variant_make_number(3.5),
+        purc_variant_make_string("10", false),
+        purc_variant_make_longint(-2),
+        purc_variant_make_ulongint(7),
+        purc_variant_make_longdouble(0.25),
+    };
+    const double sorted[] = { -2, 0.25, 3.5, 7, 10 };
+    for (size_t i = 0; i < PCA_TABLESIZE(vals); i++) {
+        ASSERT_TRUE(purc_variant_array_append(arr, vals[i]));
+        purc_variant_unref(vals[i]);
+    }
+
+    uintptr_t sort_flags = PCVARIANT_SORT_ASC | PCVARIANT_COMPARE_OPT_NUMBER;
+    ASSERT_EQ(pcvariant_array_sort(arr, (void *)sort_flags, NULL), 0);
+    for (size_t i = 0; i < PCA_TABLESIZE(sorted); i++) {
+        double d = purc_variant_numberify(purc_variant_array_get(arr, i));
+        ASSERT_EQ(d, sorted[i]);
+    }
+
+    // the string member makes the auto option compare by strings
+    sort_flags = PCVARIANT_SORT_DESC | PCVARIANT_COMPARE_OPT_AUTO;
+    ASSERT_EQ(pcvariant_array_sort(arr, (void *)sort_flags, NULL), 0);
+    ASSERT_EQ(purc_variant_array_get_size(arr), PCA_TABLESIZE(sorted));
+
+    // all numbers after removing the string
+    for (ssize_t i = 0; i < purc_variant_array_get_size(arr); i++) {
+        if (purc_variant_is_string(purc_variant_array_get(arr, i))) {
+            ASSERT_TRUE(purc_variant_array_remove(arr, i));
+            break;
+        }
+    }
+    ASSERT_EQ(purc_variant_array_get_size(arr), PCA_TABLESIZE(sorted) - 1);
+    sort_flags = PCVARIANT_SORT_DESC | PCVARIANT_COMPARE_OPT_AUTO;
+    ASSERT_EQ(pcvariant_array_sort(arr, (void *)sort_flags, NULL), 0);
+    double last = purc_variant_numberify(purc_variant_array_get(arr, 0));
+    for (ssize_t i = 1; i < purc_variant_array_get_size(arr); i++) {
+        double d = purc_variant_numberify(purc_variant_array_get(arr, i));
+        ASSERT_LE(d, last);
+        last = d;
+    }
+
+    purc_variant_unref(arr);
+    purc_cleanup();
+}
+
+static size_t nr_grown;
+
+static bool
+on_grown(purc_variant_t source, pcvar_op_t op, void *ctxt,
+        size_t nargs, purc_variant_t *argv)
+{
+    (void)source;
+    (void)ctxt;
+
+    EXPECT_EQ(op, PCVAR_OPERATION_GROW);
+    EXPECT_EQ(nargs, 2U);
+
+    int64_t pos;
+    EXPECT_TRUE(purc_variant_cast_to_longint(argv[0], &pos, false));
+    EXPECT_EQ(pos, (int64_t)nr_grown);
+    nr_grown++;
+    return true;
+}
+
+TEST(variant_array, listened_ops)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex (PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test",
+            "test_init", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    purc_variant_t arr = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    ASSERT_NE(arr, nullptr);
+    ASSERT_FALSE(pcvariant_is_listened(arr, PCVAR_OPERATION_GROW));
+
+    struct pcvar_listener *listener;
+    listener = purc_variant_register_post_listener(arr,
+            PCVAR_OPERATION_GROW, on_grown, NULL);
+    ASSERT_NE(listener, nullptr);
+    ASSERT_TRUE(pcvariant_is_listened(arr, PCVAR_OPERATION_GROW));
+    ASSERT_FALSE(pcvariant_is_listened(arr, PCVAR_OPERATION_SHRINK));
+
+    purc_variant_t v = purc_variant_make_longint(0);
+    for (int i = 0; i < 10; i++) {
+        ASSERT_TRUE(purc_variant_array_append(arr, v));
+    }
+    ASSERT_EQ(nr_grown, 10U);
+
+    // no listener for shrinking
+    ASSERT_TRUE(purc_variant_array_remove(arr, 0));
+
+    ASSERT_TRUE(purc_variant_revoke_listener(arr, listener));
+    ASSERT_FALSE(pcvariant_is_listened(arr, PCVAR_OPERATION_GROW));
+    ASSERT_TRUE(purc_variant_array_append(arr, v));
+    ASSERT_EQ(nr_grown, 10U);
+
+    purc_variant_unref(v);
+    purc_variant_unref(arr);
+    purc_cleanup();
+}
@@ -27,6 +27,8 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <errno.h>
+#include <string.h>
+#include <time.h>
 #include <gtest/gtest.h>
 
 static inline void
@@ -466,3 +468,116 @@ TEST(object, compare)
     purc_variant_unref(obj2);
 }
 
+
+/* the lookup without the hash index, as done before */
+static purc_variant_t
+rbtree_get_by_ckey(purc_variant_t obj, const char *key)
+{
+    variant_obj_t data = (variant_obj_t)obj->sz_ptr[1];
+    struct rb_node *entry = data->kvs.rb_node;
+    while (entry) {
+        struct obj_node *node = container_of(entry, struct obj_node, node);
+        int ret = strcmp(key, purc_variant_get_string_const(node->key));
+        if (ret < 0)
+            entry = entry->rb_left;
+        else if (ret > 0)
+            entry = entry->rb_right;
+        else
+            return node->val;
+    }
+
+    return PURC_VARIANT_INVALID;
+}
+
+static double
+current_time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1.0e9 + ts.tv_nsec;
+}
+
+#define NR_LOOKUPS      1000000
+
+static bool
+set_member(purc_variant_t obj, const char *key, uint64_t u64)
+{
+    purc_variant_t k = purc_variant_make_string(key, true);
+    purc_variant_t v = purc_variant_make_ulongint(u64);
+    bool ok = purc_variant_object_set(obj, k, v);
+    purc_variant_unref(k);
+    purc_variant_unref(v);
+    return ok;
+}
+
+static void
+bench_object_lookup(size_t nr_members)
+{
+    purc_variant_t obj = purc_variant_make_object_0();
+    ASSERT_NE(obj, nullptr);
+
+    char key[32];
+    for (size_t i = 0; i < nr_members; i++) {
+        snprintf(key, sizeof(key), "member%zu", i);
+        ASSERT_TRUE(set_member(obj, key, i));
+    }
+
+    /* remove and add back some members to leave removed slots */
+    for (size_t i = 0; i < nr_members; i += 3) {
+        snprintf(key, sizeof(key), "member%zu", i);
+        ASSERT_TRUE(purc_variant_object_remove_by_static_ckey(obj, key,
+                    false));
+        ASSERT_EQ(purc_variant_object_get_by_ckey(obj, key), nullptr);
+        ASSERT_TRUE(set_member(obj, key, i));
+    }
+    ASSERT_EQ(purc_variant_object_get_size(obj), (size_t)nr_members);
+
+    /* the iteration is still sorted by the keys */
+    const char *last = NULL;
+    purc_variant_t k, v;
+    foreach_key_value_in_variant_object(obj, k, v) {
+        const char *sk = purc_variant_get_string_const(k);
+        if (last) {
+            ASSERT_LT(strcmp(last, sk), 0);
+        }
+        snprintf(key, sizeof(key), "%s", sk);
+        ASSERT_EQ(purc_variant_object_get_by_ckey(obj, key), v);
+        last = sk;
+    } end_foreach;
+
+    char (*keys)[32] = (char (*)[32])malloc(nr_members * sizeof(*keys));
+    for (size_t i = 0; i < nr_members; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "member%zu", i);
+    }
+
+    uint64_t sum = 0;
+    double started = current_time_ns();
+    for (size_t i = 0; i < NR_LOOKUPS; i++) {
+        v = rbtree_get_by_ckey(obj, keys[i % nr_members]);
+        sum += v->u64;
+    }
+    double rbtree_ns = (current_time_ns() - started) / NR_LOOKUPS;
+
+    started = current_time_ns();
+    for (size_t i = 0; i < NR_LOOKUPS; i++) {
+        v = purc_variant_object_get_by_ckey(obj, keys[i % nr_members]);
+        sum -= v->u64;
+    }
+    double hash_ns = (current_time_ns() - started) / NR_LOOKUPS;
+    ASSERT_EQ(sum, 0U);
+
+    fprintf(stderr, "%zu members: rbtree %.1f ns, current %.1f ns "
+            "per lookup\n", nr_members, rbtree_ns, hash_ns);
+
+    free(keys);
+    purc_variant_unref(obj);
+}
+
+TEST(object, hash_index)
+{
+    PurCInstance purc;
+
+    bench_object_lookup(8);
+    bench_object_lookup(64);
+    bench_object_lookup(10000);
+}
@@ -1112,3 +1112,121 @@ TEST(variant, set)
     }
 }
 
+
+#define NR_INDEXED_ELEMS        5000
+
+static purc_variant_t
+make_record(uint64_t id, const char *name)
+{
+    purc_variant_t obj = purc_variant_make_object_0();
+    purc_variant_t v = purc_variant_make_ulongint(id);
+    purc_variant_object_set_by_static_ckey(obj, "id", v);
+    purc_variant_unref(v);
+
+    v = purc_variant_make_string(name, false);
+    purc_variant_object_set_by_static_ckey(obj, "name", v);
+    purc_variant_unref(v);
+
+    return obj;
+}
+
+TEST(set, hash_index)
+{
+    PurCInstance purc;
+
+    purc_variant_t set;
+    set = purc_variant_make_set_by_ckey_ex(0, "id", false,
+            PURC_VARIANT_INVALID);
+    ASSERT_NE(set, PURC_VARIANT_INVALID);
+
+    for (uint64_t i = 0; i < NR_INDEXED_ELEMS; i++) {
+        purc_variant_t obj = make_record(i, "foo");
+        ASSERT_TRUE(purc_variant_set_add(set, obj, false));
+        purc_variant_unref(obj);
+    }
+    ASSERT_TRUE(sanity_check(set));
+
+    size_t sz;
+    purc_variant_set_size(set, &sz);
+    ASSERT_EQ(sz, (size_t)NR_INDEXED_ELEMS);
+
+    // duplicates are detected by the index
+    purc_variant_t obj = make_record(7, "bar");
+    ASSERT_FALSE(purc_variant_set_add(set, obj, false));
+    ASSERT_TRUE(purc_variant_set_add(set, obj, true));
+    purc_variant_unref(obj);
+    purc_variant_set_size(set, &sz);
+    ASSERT_EQ(sz, (size_t)NR_INDEXED_ELEMS);
+
+    for (uint64_t i = 0; i < NR_INDEXED_ELEMS; i++) {
+        purc_variant_t id = purc_variant_make_ulongint(i);
+        purc_variant_t v = purc_variant_set_get_member_by_key_values(set, id);
+        ASSERT_NE(v, PURC_VARIANT_INVALID);
+
+        purc_variant_t name = purc_variant_object_get_by_ckey(v, "name");
+        ASSERT_STREQ(purc_variant_get_string_const(name),
+                i == 7 ? "bar" : "foo");
+
+        if (i % 2) {
+            v = purc_variant_set_remove_member_by_key_values(set, id);
+            ASSERT_NE(v, PURC_VARIANT_INVALID);
+            purc_variant_unref(v);
+        }
+        purc_variant_unref(id);
+    }
+    ASSERT_TRUE(sanity_check(set));
+
+    purc_variant_set_size(set, &sz);
+    ASSERT_EQ(sz, (size_t)NR_INDEXED_ELEMS / 2);
+
+    for (uint64_t i = 0; i < NR_INDEXED_ELEMS; i++) {
+        purc_variant_t id = purc_variant_make_ulongint(i);
+        purc_variant_t v = purc_variant_set_get_member_by_key_values(set, id);
+        if (i % 2) {
+            ASSERT_EQ(v, PURC_VARIANT_INVALID);
+            purc_clr_error();
+        }
+        else {
+            ASSERT_NE(v, PURC_VARIANT_INVALID);
+        }
+        purc_variant_unref(id);
+    }
+
+    // the elements are still in the canonical order
+    purc_variant_t prev = PURC_VARIANT_INVALID;
+    purc_variant_t v;
+    foreach_value_in_variant_set_order(set, v) {
+        if (prev) {
+            ASSERT_LT(purc_variant_compare_ex(
+                        purc_variant_object_get_by_ckey(prev, "id"),
+                        purc_variant_object_get_by_ckey(v, "id"),
+                        PCVARIANT_COMPARE_OPT_CASE), 0);
+        }
+        prev = v;
+    } end_foreach;
+
+    purc_variant_unref(set);
+
+    // the values equal in their stringified forms are duplicates
+    set = purc_variant_make_set_by_ckey_ex(0, NULL, false,
+            PURC_VARIANT_INVALID);
+    ASSERT_NE(set, PURC_VARIANT_INVALID);
+    for (int i = 0; i < NR_INDEXED_ELEMS; i++) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%d", i);
+        purc_variant_t s = purc_variant_make_string(buf, false);
+        ASSERT_TRUE(purc_variant_set_add(set, s, false));
+        purc_variant_unref(s);
+    }
+
+    for (int i = 0; i < NR_INDEXED_ELEMS; i++) {
+        purc_variant_t n = purc_variant_make_number(i);
+        ASSERT_FALSE(purc_variant_set_add(set, n, false));
+        purc_clr_error();
+        purc_variant_unref(n);
+    }
+
+    purc_variant_set_size(set, &sz);
+    ASSERT_EQ(sz, (size_t)NR_INDEXED_ELEMS);
+    purc_variant_unref(set);
+}
@@ -18,9 +18,11 @@
 */
 
 #include "purc.h"
+#include "private/instance.h"
 #include "private/vcm.h"
 
 #include <gtest/gtest.h>
+#include <time.h>
 
 purc_variant_t find_var(void* ctxt, const char* name)
 {
@@ -117,3 +119,309 @@ TEST_P(test_vcm_eval, eval_silently)
 
 INSTANTIATE_TEST_SUITE_P(vcm_eval, test_vcm_eval,
         testing::ValuesIn(test_cases));
+
+static purc_variant_t find_named_var(void* ctxt, const char* name)
+{
+    return purc_variant_object_get_by_ckey(purc_variant_t(ctxt), name);
+}
+
+static const char *compiled_cases[] = {
+    "$OBJ.title",
+    "$OBJ.list[1]",
+    "$OBJ.list[-1]",
+    "$OBJ.nothing",
+    "$NOTHING.title",
+    "{ \"a\": $OBJ.title, \"b\": [1, 2.5, $OBJ.count, null, true], "
+        "\"c\": { \"d\": $OBJ.list } }",
+    "\"title: $OBJ.title and count: $OBJ.count\"",
+    "[ bx1234, \"$OBJ.title and $OBJ.list[0]\" ]",
+    "{{ $OBJ.nothing || $OBJ.title }}",
+    "{{ $OBJ.count && $OBJ.title ; $OBJ.list }}",
+    "{{ $OBJ.zero && $OBJ.title }}",
+    "{{ $OBJ.zero || $OBJ.nothing || $OBJ.count }}",
+    "{{ $OBJ.title ; }}",
+    "$OBJ.title()",
+};
+
+// the compiled code gives the same values as the tree walker
+TEST(vcm_eval, compiled)
+{
+    purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.hybridos.test",
+            "vcm_eval", NULL);
+
+    const char *obj_json = "{ \"OBJ\": { \"title\": \"Object title\", "
+        "\"count\": 3, \"zero\": 0, \"list\": [\"x\", \"y\", \"z\"] } }";
+    struct purc_ejson_parse_tree *ptree;
+    ptree = purc_variant_ejson_parse_string(obj_json, strlen(obj_json));
+    purc_variant_t vars = purc_variant_ejson_parse_tree_evalute(ptree, NULL,
+            PURC_VARIANT_INVALID, false);
+    purc_variant_ejson_parse_tree_destroy(ptree);
+    ASSERT_NE(vars, nullptr);
+
+    for (size_t i = 0; i < PCA_TABLESIZE(compiled_cases); i++) {
+        const char *exp = compiled_cases[i];
+        ptree = purc_variant_ejson_parse_string(exp, strlen(exp));
+        ASSERT_NE(ptree, nullptr) << exp;
+
+        struct pcvcm_node *tree = (struct pcvcm_node *)ptree;
+        for (int silently = 0; silently < 2; silently++) {
+            purc_variant_t walked = pcvcm_eval_walk(tree, find_named_var,
+                    vars, silently);
+            purc_variant_t first = pcvcm_eval_ex(tree, find_named_var,
+                    vars, silently);
+            purc_variant_t compiled = pcvcm_eval_ex(tree, find_named_var,
+                    vars, silently);
+            ASSERT_NE(tree->code, nullptr) << exp;
+
+            if (walked == PURC_VARIANT_INVALID) {
+                ASSERT_EQ(first, nullptr) << exp;
+                ASSERT_EQ(compiled, nullptr) << exp;
+                continue;
+            }
+
+            ASSERT_NE(compiled, nullptr) << exp;
+            ASSERT_EQ(purc_variant_get_type(compiled),
+                    purc_variant_get_type(walked)) << exp;
+            ASSERT_TRUE(purc_variant_is_equal_to(compiled, walked)) << exp;
+
+            purc_variant_unref(walked);
+            purc_variant_unref(first);
+            purc_variant_unref(compiled);
+        }
+
+        purc_variant_ejson_parse_tree_destroy(ptree);
+    }
+
+    purc_variant_unref(vars);
+    purc_cleanup();
+}
+
+// the concatenated string is the same as the one of stringified values
+TEST(vcm_eval, concat_string)
+{
+    purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.hybridos.test",
+            "vcm_eval", NULL);
+
+    const char *obj_json = "{ \"OBJ\": { \"title\": \"Object title\", "
+        "\"count\": 3, \"ratio\": 2.5, \"yes\": true, "
+        "\"list\": [\"x\", 1, { \"y\": null }] } }";
+    struct purc_ejson_parse_tree *ptree;
+    ptree = purc_variant_ejson_parse_string(obj_json, strlen(obj_json));
+    purc_variant_t vars = purc_variant_ejson_parse_tree_evalute(ptree, NULL,
+            PURC_VARIANT_INVALID, false);
+    purc_variant_ejson_parse_tree_destroy(ptree);
+    ASSERT_NE(vars, nullptr);
+
+    purc_variant_t obj = purc_variant_object_get_by_ckey(vars, "OBJ");
+    std::string expected = "Hello ";
+    static const char *keys[] = { "title", "count", "ratio", "yes", "list" };
+    for (size_t i = 0; i < PCA_TABLESIZE(keys); i++) {
+        char *buf = NULL;
+        purc_variant_t v = purc_variant_object_get_by_ckey(obj, keys[i]);
+        ASSERT_GE(purc_variant_stringify_alloc(&buf, v), 0);
+        expected += buf;
+        if (i + 1 < PCA_TABLESIZE(keys))
+            expected += " and ";
+        free(buf);
+    }
+
+    // the eJSON parser takes a punctuation after a variable as a part of it
+    const char *exp = "\"Hello $OBJ.title and $OBJ.count and $OBJ.ratio "
+        "and $OBJ.yes and $OBJ.list\"";
+    ptree = purc_variant_ejson_parse_string(exp, strlen(exp));
+    ASSERT_NE(ptree, nullptr);
+
+    // walked, and then compiled
+    for (int i = 0; i < 3; i++) {
+        purc_variant_t v = pcvcm_eval_ex((struct pcvcm_node *)ptree,
+                find_named_var, vars, false);
+        ASSERT_NE(v, nullptr);
+        ASSERT_STREQ(purc_variant_get_string_const(v), expected.c_str());
+        purc_variant_unref(v);
+    }
+
+    purc_variant_ejson_parse_tree_destroy(ptree);
+    purc_variant_unref(vars);
+    purc_cleanup();
+}
+
+TEST(vcm_eval, compiled_benchmark)
+{
+    purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.hybridos.test",
+            "vcm_eval", NULL);
+
+    const char *obj_json = "{ \"OBJ\": { \"title\": \"Object title\", "
+        "\"count\": 3, \"list\": [\"x\", \"y\", \"z\"] } }";
+    struct purc_ejson_parse_tree *ptree;
+    ptree = purc_variant_ejson_parse_string(obj_json, strlen(obj_json));
+    purc_variant_t vars = purc_variant_ejson_parse_tree_evalute(ptree, NULL,
+            PURC_VARIANT_INVALID, false);
+    purc_variant_ejson_parse_tree_destroy(ptree);
+    ASSERT_NE(vars, nullptr);
+
+    const char *exp = "{{ $OBJ.count && \"$OBJ.title: $OBJ.list[1]\" }}";
+    ptree = purc_variant_ejson_parse_string(exp, strlen(exp));
+    struct pcvcm_node *tree = (struct pcvcm_node *)ptree;
+    ASSERT_TRUE(pcvcm_node_compile(tree));
+
+    const int nr_loops = 100000;
+    clock_t start = clock();
+    for (int i = 0; i < nr_loops; i++) {
+        purc_variant_t v = pcvcm_eval_walk(tree, find_named_var, vars, false);
+        ASSERT_NE(v, nullptr);
+        purc_variant_unref(v);
+    }
+    double walked = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    for (int i = 0; i < nr_loops; i++) {
+        purc_variant_t v = pcvcm_eval_ex(tree, find_named_var, vars, false);
+        ASSERT_NE(v, nullptr);
+        purc_variant_unref(v);
+    }
+    double compiled = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    fprintf(stderr, "%d evaluations of `%s`: tree walker %.3fs, "
+            "compiled %.3fs\n", nr_loops, exp, walked, compiled);
+
+    purc_variant_ejson_parse_tree_destroy(ptree);
+    purc_variant_unref(vars);
+    purc_cleanup();
+}
+
+// the constant subtrees and the calls to pure getters are evaluated once
+TEST(vcm_eval, fold_constants)
+{
+    purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.hybridos.test",
+            "vcm_eval", NULL);
+
+    purc_variant_t vars = purc_variant_make_object(0,
+            PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+    purc_variant_t str = purc_dvobj_string_new();
+    purc_variant_object_set_by_static_ckey(vars, "STR", str);
+    purc_variant_unref(str);
+
+    struct pcinst *inst = pcinst_current();
+    ASSERT_NE(inst, nullptr);
+
+    // a folded container is cloned for every evaluation
+    const char *exp = "[1, \"two\", { \"three\": 3 }]";
+    struct purc_ejson_parse_tree *ptree;
+    ptree = purc_variant_ejson_parse_string(exp, strlen(exp));
+    ASSERT_NE(ptree, nullptr);
+
+    struct pcvcm_node *tree = (struct pcvcm_node *)ptree;
+    pcvcm_node_fold_constants(tree);
+    ASSERT_NE(tree->const_id, 0U);
+
+    purc_variant_t v1 = pcvcm_eval_ex(tree, find_named_var, vars, false);
+    ASSERT_NE(v1, nullptr);
+    ASSERT_NE(inst->vcm_folded, nullptr);
+    ASSERT_EQ(pcutils_map_get_size(inst->vcm_folded), 1U);
+
+    purc_variant_t n = purc_variant_make_number(4);
+    purc_variant_array_append(v1, n);
+    purc_variant_unref(n);
+
+    for (int i = 0; i < 2; i++) {
+        purc_variant_t v2 = pcvcm_eval_ex(tree, find_named_var, vars, false);
+        ASSERT_NE(v2, nullptr);
+        ASSERT_NE(v2, v1);
+        ASSERT_EQ(purc_variant_array_get_size(v2), 3U);
+        purc_variant_unref(v2);
+    }
+    purc_variant_unref(v1);
+    purc_variant_ejson_parse_tree_destroy(ptree);
+
+    // a call to a pure getter with constant arguments
+    exp = "$STR.nr_chars('hello')";
+    ptree = purc_variant_ejson_parse_string(exp, strlen(exp));
+    ASSERT_NE(ptree, nullptr);
+    tree = (struct pcvcm_node *)ptree;
+    pcvcm_node_fold_constants(tree);
+    ASSERT_NE(tree->const_id, 0U);
+
+    for (int i = 0; i < 3; i++) {
+        purc_variant_t v = pcvcm_eval_ex(tree, find_named_var, vars, false);
+        ASSERT_NE(v, nullptr);
+        uint64_t u64 = 0;
+        ASSERT_TRUE(purc_variant_cast_to_ulongint(v, &u64, false));
+        ASSERT_EQ(u64, 5U);
+        purc_variant_unref(v);
+    }
+    ASSERT_EQ(pcutils_map_get_size(inst->vcm_folded), 2U);
+    purc_variant_ejson_parse_tree_destroy(ptree);
+
+    // a getter not pure is called every time
+    exp = "$STR.shuffle('hello')";
+    ptree = purc_variant_ejson_parse_string(exp, strlen(exp));
+    ASSERT_NE(ptree, nullptr);
+    tree = (struct pcvcm_node *)ptree;
+    pcvcm_node_fold_constants(tree);
+
+    for (int i = 0; i < 3; i++) {
+        purc_variant_t v = pcvcm_eval_ex(tree, find_named_var, vars, false);
+        ASSERT_NE(v, nullptr);
+        purc_variant_unref(v);
+    }
+    ASSERT_EQ(pcutils_map_get_size(inst->vcm_folded), 2U);
+    purc_variant_ejson_parse_tree_destroy(ptree);
+
+    purc_variant_unref(vars);
+    purc_cleanup();
+}
+
+TEST(vcm_eval, lazy_arguments)
+{
+    purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.hybridos.test",
+            "vcm_eval", NULL);
+
+    purc_variant_t vars = purc_variant_make_object(0,
+            PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+    purc_variant_t logical = purc_dvobj_logical_new();
+    purc_variant_object_set_by_static_ckey(vars, "L", logical);
+    purc_variant_unref(logical);
+
+    static const struct {
+        const char *exp;
+        bool        result;
+    } cases[] = {
+        // `$NOSUCH` is never evaluated
+        { "$L.or(true, $NOSUCH)", true },
+        { "$L.and(false, $NOSUCH)", false },
+        { "$L.and(true, $L.or(false, true), true)", true },
+        { "$L.or(false, 0, '')", false },
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(cases); i++) {
+        const char *exp = cases[i].exp;
+        struct purc_ejson_parse_tree *ptree;
+        ptree = purc_variant_ejson_parse_string(exp, strlen(exp));
+        ASSERT_NE(ptree, nullptr);
+
+        // the tree is compiled after evaluated for a few times
+        for (int j = 0; j < 3; j++) {
+            purc_variant_t v = pcvcm_eval_ex((struct pcvcm_node *)ptree,
+                    find_named_var, vars, false);
+            ASSERT_NE(v, nullptr) << exp;
+            ASSERT_EQ(purc_variant_booleanize(v), cases[i].result) << exp;
+            purc_variant_unref(v);
+        }
+        purc_variant_ejson_parse_tree_destroy(ptree);
+    }
+
+    // the argument needed is still evaluated
+    const char *exp = "$L.and(true, $NOSUCH)";
+    struct purc_ejson_parse_tree *ptree;
+    ptree = purc_variant_ejson_parse_string(exp, strlen(exp));
+    ASSERT_NE(ptree, nullptr);
+    for (int j = 0; j < 3; j++) {
+        purc_variant_t v = pcvcm_eval_ex((struct pcvcm_node *)ptree,
+                find_named_var, vars, false);
+        ASSERT_EQ(v, nullptr);
+    }
+    purc_variant_ejson_parse_tree_destroy(ptree);
+
+    purc_variant_unref(vars);
+    purc_cleanup();
+}
@@ -19,6 +19,7 @@
 
 #include "purc.h"
 #include "private/vdom.h"
+#include "hvml-attr.h"
 
 #include "../helpers.h"
 
@@ -143,3 +144,69 @@ TEST(vdom, fragment)
     }
 }
 
+TEST(vdom, attrs)
+{
+    PurCInstance purc("cn.fmsoft.hybridos.test", "test_init", false);
+
+    struct pcvdom_element *elem = pcvdom_element_create_c("update");
+    ASSERT_NE(elem, nullptr);
+
+    /* more than the initial slots, in no particular order */
+    const char *keys[] = { "with", "on", "to", "at", "x-foo", "in", "by" };
+    struct pcvdom_attr *attrs[PCA_TABLESIZE(keys)];
+    for (size_t i = 0; i < PCA_TABLESIZE(keys); i++) {
+        attrs[i] = pcvdom_attr_create(keys[i],
+                PCHVML_ATTRIBUTE_OPERATOR, NULL);
+        ASSERT_NE(attrs[i], nullptr);
+        ASSERT_EQ(0, pcvdom_element_append_attr(elem, attrs[i]));
+    }
+
+    for (size_t i = 0; i < PCA_TABLESIZE(keys); i++) {
+        EXPECT_EQ(pcvdom_element_find_attr(elem, keys[i]), attrs[i]);
+        EXPECT_EQ(pcvdom_element_get_attr_c(elem, keys[i]), attrs[i]);
+    }
+    EXPECT_EQ(pcvdom_element_find_attr(elem, "from"), nullptr);
+    EXPECT_EQ(pcvdom_element_find_attr(elem, "zzz"), nullptr);
+    EXPECT_EQ(pcvdom_element_find_attr(elem, "a"), nullptr);
+
+    /* an attribute with the same key replaces the old one */
+    struct pcvdom_attr *attr;
+    attr = pcvdom_attr_create("to", PCHVML_ATTRIBUTE_OPERATOR, NULL);
+    ASSERT_NE(attr, nullptr);
+    ASSERT_EQ(0, pcvdom_element_append_attr(elem, attr));
+    EXPECT_EQ(pcvdom_element_find_attr(elem, "to"), attr);
+    EXPECT_EQ(pcvdom_element_find_attr(elem, "with"), attrs[0]);
+
+    pcvdom_node_destroy(pcvdom_node_from_element(elem));
+}
+
+TEST(vdom, static_search)
+{
+    for (int id = PCHVML_TAG_FIRST_ENTRY; id < PCHVML_TAG_LAST_ENTRY; id++) {
+        const struct pchvml_tag_entry *entry;
+        entry = pchvml_tag_static_get_by_id((enum pchvml_tag_id)id);
+        ASSERT_NE(entry, nullptr);
+        EXPECT_EQ(entry, pchvml_tag_static_search(entry->name,
+                    strlen(entry->name)));
+    }
+
+    const struct pchvml_tag_entry *tag;
+    tag = pchvml_tag_static_search("ARCHEDATA", 9);
+    ASSERT_NE(tag, nullptr);
+    EXPECT_EQ(tag->id, PCHVML_TAG_ARCHEDATA);
+
+    // a prefix or an extension of a tag name is not the tag
+    EXPECT_EQ(pchvml_tag_static_search("ini", 3), nullptr);
+    EXPECT_EQ(pchvml_tag_static_search("inits", 5), nullptr);
+    EXPECT_EQ(pchvml_tag_static_search("div", 3), nullptr);
+
+    const struct pchvml_attr_entry *attr;
+    attr = pchvml_attr_static_search("with", 4);
+    ASSERT_NE(attr, nullptr);
+    EXPECT_EQ(attr->type, PCHVML_ATTR_TYPE_PREP);
+    attr = pchvml_attr_static_search("On", 2);
+    ASSERT_NE(attr, nullptr);
+    EXPECT_EQ(attr->type, PCHVML_ATTR_TYPE_PREP);
+    EXPECT_EQ(pchvml_attr_static_search("wit", 3), nullptr);
+    EXPECT_EQ(pchvml_attr_static_search("class", 5), nullptr);
+}
@@ -46,6 +46,41 @@ end:
         pcvdom_document_unref(doc);
 }
 
+static int
+_append_to_string(const char *buf, size_t len, void *ctxt)
+{
+    std::string *str = (std::string *)ctxt;
+    str->append(buf, len);
+    return 0;
+}
+
+/* the vDOM loaded from the cache should be the same as the parsed one */
+static void
+_check_vdom_cache(struct pcvdom_document *doc)
+{
+    purc_rwstream_t out = purc_rwstream_new_buffer(1024, 0);
+    ASSERT_NE(out, nullptr);
+    ASSERT_TRUE(purc_vdom_save_cache(doc, out));
+
+    size_t sz;
+    const void *data = purc_rwstream_get_mem_buffer(out, &sz);
+    struct pcvdom_document *cached = purc_load_hvml_from_cache(data, sz);
+    ASSERT_NE(cached, nullptr);
+
+    /* a truncated cache is refused */
+    ASSERT_EQ(purc_load_hvml_from_cache(data, sz - 1), nullptr);
+    purc_rwstream_destroy(out);
+
+    std::string parsed, loaded;
+    pcvdom_util_node_serialize(pcvdom_node_from_document(doc),
+            _append_to_string, &parsed);
+    pcvdom_util_node_serialize(pcvdom_node_from_document(cached),
+            _append_to_string, &loaded);
+    ASSERT_EQ(parsed, loaded);
+
+    pcvdom_document_unref(cached);
+}
+
 static int
 _process_file(const char *fn)
 {
@@ -95,6 +130,7 @@ _process_file(const char *fn)
     }
     else {
         PRINT_VDOM_NODE(pcvdom_node_from_document(doc));
+        _check_vdom_cache(doc);
     }
     int r = 0;
     if (doc && neg) {
@@ -160,3 +196,318 @@ end:
     purc_cleanup ();
 }
 
+
+static struct pcvdom_document *
+_parse_string(const char *hvml)
+{
+    purc_rwstream_t rin = purc_rwstream_new_from_mem((void *)hvml,
+            strlen(hvml));
+    if (!rin)
+        return NULL;
+
+    struct pcvdom_pos pos;
+    struct pcvdom_document *doc = pcvdom_util_document_from_stream(rin, &pos);
+    purc_rwstream_destroy(rin);
+    return doc;
+}
+
+static std::string
+_serialize_document(struct pcvdom_document *doc)
+{
+    std::string str;
+    pcvdom_util_node_serialize(pcvdom_node_from_document(doc),
+            _append_to_string, &str);
+    return str;
+}
+
+TEST(vdom_gen, lazy_attrs)
+{
+    static const char *hvml =
+        "<hvml target=\"html\">"
+        "<body>"
+        "<init as=\"users\" with=\"[{id: 1, name: 'foo'}, {id: 2}]\" />"
+        "<test on=\"$users[0].id\">"
+        "<match for=\"AS 1\" exclusively>"
+        "<p id=\"one\">$users[0].name</p>"
+        "</match>"
+        "</test>"
+        "<catch for=\"ANY\"><p>$?.message</p></catch>"
+        "</body>"
+        "</hvml>";
+
+    purc_instance_extra_info info = {};
+    info.lazy_attr_vcm = true;
+    int r = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hybridos.test",
+        "vdom_gen", &info);
+    ASSERT_EQ(r, PURC_ERROR_OK);
+
+    size_t nr_lazy, nr_compiled;
+    struct pcvdom_document *doc = _parse_string(hvml);
+    ASSERT_NE(doc, nullptr);
+
+    /* the attributes with more than a single node are packed */
+    pcvdom_get_lazy_attr_stat(&nr_lazy, &nr_compiled);
+    ASSERT_GT(nr_lazy, 0U);
+    ASSERT_EQ(nr_compiled, 0U);
+
+    /* the packed attributes are saved to the cache as is, and kept packed
+       when loaded from the cache */
+    purc_rwstream_t out = purc_rwstream_new_buffer(1024, 0);
+    ASSERT_NE(out, nullptr);
+    ASSERT_TRUE(purc_vdom_save_cache(doc, out));
+
+    size_t sz;
+    const void *data = purc_rwstream_get_mem_buffer(out, &sz);
+    struct pcvdom_document *cached = purc_load_hvml_from_cache(data, sz);
+    ASSERT_NE(cached, nullptr);
+    purc_rwstream_destroy(out);
+
+    size_t nr_packed = nr_lazy;
+    pcvdom_get_lazy_attr_stat(&nr_lazy, &nr_compiled);
+    ASSERT_EQ(nr_lazy, nr_packed * 2);
+    ASSERT_EQ(nr_compiled, 0U);
+
+    /* an attribute of a single node is not packed, so nothing compiled */
+    struct pcvdom_element *root = pcvdom_document_get_root(doc);
+    struct pcvdom_attr *attr = pcvdom_element_find_attr(root, "target");
+    ASSERT_NE(attr, nullptr);
+    ASSERT_NE(pcvdom_attr_get_vcm(attr), nullptr);
+    pcvdom_get_lazy_attr_stat(&nr_lazy, &nr_compiled);
+    ASSERT_EQ(nr_compiled, 0U);
+
+    /* serializing compiles all attributes */
+    std::string lazy = _serialize_document(doc);
+    std::string loaded = _serialize_document(cached);
+    pcvdom_get_lazy_attr_stat(&nr_lazy, &nr_compiled);
+    ASSERT_EQ(nr_compiled, nr_lazy);
+    pcvdom_document_unref(cached);
+    pcvdom_document_unref(doc);
+
+    purc_cleanup();
+
+    /* the same vDOM is got without the lazy mode */
+    info.lazy_attr_vcm = false;
+    r = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hybridos.test",
+        "vdom_gen", &info);
+    ASSERT_EQ(r, PURC_ERROR_OK);
+
+    doc = _parse_string(hvml);
+    ASSERT_NE(doc, nullptr);
+    pcvdom_get_lazy_attr_stat(&nr_lazy, &nr_compiled);
+    ASSERT_EQ(nr_lazy, 0U);
+
+    std::string eager = _serialize_document(doc);
+    ASSERT_EQ(lazy, eager);
+    ASSERT_EQ(loaded, eager);
+    pcvdom_document_unref(doc);
+
+    purc_cleanup();
+}
+
+TEST(vdom_gen, progressive_loader)
+{
+    static const char *hvml =
+        "<!DOCTYPE hvml>"
+        "<hvml target=\"html\" lang=\"zh\">"
+        "<head><title>中文标题</title></head>"
+        "<body>"
+        "<!-- 注释 -->"
+        "<init as=\"users\" with=\"[{id: 1, name: '张三'}, {id: 2}]\" />"
+        "<iterate on=\"$users\" by=\"RANGE: FROM 0\">"
+        "<p class=\"user\">$?.id: $?.name</p>"
+        "</iterate>"
+        "</body>"
+        "</hvml>";
+
+    PurCInstance purc(PURC_MODULE_HVML, "cn.fmsoft.hybridos.test",
+            "vdom_gen");
+    ASSERT_TRUE(purc);
+
+    size_t len = strlen(hvml);
+    struct pcvdom_pos pos;
+    struct pcvdom_document *doc = pcvdom_util_document_from_buf(
+            (const unsigned char *)hvml, len, &pos);
+    ASSERT_NE(doc, nullptr);
+    std::string expected = _serialize_document(doc);
+    pcvdom_document_unref(doc);
+
+    /* the pieces end in the middle of tags, attribute values and
+       multi-byte characters */
+    static const size_t piece_sizes[] = { 1, 2, 3, 7, 64 };
+    for (size_t i = 0; i < PCA_TABLESIZE(piece_sizes); i++) {
+        purc_hvml_loader_t loader = purc_hvml_loader_new();
+        ASSERT_NE(loader, nullptr);
+
+        for (size_t off = 0; off < len; off += piece_sizes[i]) {
+            size_t sz = std::min(piece_sizes[i], len - off);
+            ASSERT_EQ(purc_hvml_loader_feed(loader, hvml + off, sz), 0);
+        }
+
+        doc = purc_hvml_loader_end(loader);
+        ASSERT_NE(doc, nullptr);
+        ASSERT_EQ(_serialize_document(doc), expected);
+        pcvdom_document_unref(doc);
+    }
+
+    /* a bad program is refused */
+    static const char *bad = "<hvml><body><init with=\"[1,,2]\"/></body>";
+    purc_hvml_loader_t loader = purc_hvml_loader_new();
+    ASSERT_NE(loader, nullptr);
+    ASSERT_EQ(purc_hvml_loader_feed(loader, bad, strlen(bad)), -1);
+    ASSERT_EQ(purc_hvml_loader_feed(loader, "</hvml>", 7), -1);
+    ASSERT_EQ(purc_hvml_loader_end(loader), nullptr);
+}
+
+static int _count_arena_attrs(struct pcvdom_element *top,
+    struct pcvdom_element *elem, void *ctx)
+{
+    UNUSED_PARAM(top);
+
+    struct pcvdom_attr *attr = pcvdom_element_find_attr(elem, "with");
+    if (attr) {
+        struct pcvcm_node *vcm = pcvdom_attr_get_vcm(attr);
+        if (vcm && vcm->in_arena)
+            *(int*)ctx += 1;
+    }
+    return 0;
+}
+
+TEST(vdom_gen, vcm_arena)
+{
+    static const char *hvml =
+        "<hvml target=\"html\">"
+        "<body>"
+        "<init as=\"users\" with=\"[{id: 1, name: 'foo'}, {id: 2}]\" />"
+        "<init as=\"names\" with=\"['foo', 'bar']\" />"
+        "</body>"
+        "</hvml>";
+
+    PurCInstance purc(false);
+
+    /* the VCM trees of a document come from the arena of the document */
+    struct pcvdom_document *doc;
+    doc = pcvdom_util_document_from_buf((const unsigned char*)hvml,
+            strlen(hvml), NULL);
+    ASSERT_NE(doc, nullptr);
+
+    int nr = 0;
+    struct pcvdom_element *root = pcvdom_document_get_root(doc);
+    ASSERT_EQ(0, pcvdom_element_traverse(root, &nr, _count_arena_attrs));
+    ASSERT_EQ(nr, 2);
+    pcvdom_document_unref(doc);
+
+    /* a fragment outlives its document, so it gets no arena */
+    const char *buf = "<init as=\"x\" with=\"[1, 2]\" />";
+    struct pcvdom_element *elem;
+    elem = pcvdom_util_document_parse_fragment_buf(
+            (const unsigned char*)buf, strlen(buf), NULL);
+    ASSERT_NE(elem, nullptr);
+
+    nr = 0;
+    ASSERT_EQ(0, pcvdom_element_traverse(elem, &nr, _count_arena_attrs));
+    ASSERT_EQ(nr, 0);
+    pcvdom_node_destroy(pcvdom_node_from_element(elem));
+}
+
+static int _count_elements(struct pcvdom_element *top,
+    struct pcvdom_element *elem, void *ctx)
+{
+    UNUSED_PARAM(top);
+    UNUSED_PARAM(elem);
+
+    *(int*)ctx += 1;
+    return 0;
+}
+
+struct find_element_ctx {
+    const char             *tag;
+    struct pcvdom_element  *found;
+};
+
+static int _find_element(struct pcvdom_element *top,
+    struct pcvdom_element *elem, void *ctx)
+{
+    UNUSED_PARAM(top);
+
+    struct find_element_ctx *fe = (struct find_element_ctx *)ctx;
+    if (fe->found == NULL &&
+            strcmp(pcvdom_element_get_tagname(elem), fe->tag) == 0)
+        fe->found = elem;
+    return 0;
+}
+
+static struct pcvdom_element *
+find_element(struct pcvdom_element *root, const char *tag)
+{
+    struct find_element_ctx fe = { tag, NULL };
+    pcvdom_element_traverse(root, &fe, _find_element);
+    return fe.found;
+}
+
+TEST(vdom_gen, node_arena)
+{
+    static const char *hvml =
+        "<hvml target=\"html\">"
+        "<body>"
+        "<!-- the nodes come from the arena -->"
+        "<init as=\"users\" with=\"[{id: 1}]\" at=\"_topmost\" temp />"
+        "<my-tag my-attr=\"foo\">text</my-tag>"
+        "<p id=\"#para\">hello</p>"
+        "</body>"
+        "</hvml>";
+
+    PurCInstance purc(false);
+
+    struct pcvdom_document *doc;
+    doc = pcvdom_util_document_from_buf((const unsigned char*)hvml,
+            strlen(hvml), NULL);
+    ASSERT_NE(doc, nullptr);
+
+    struct pcvdom_element *root = pcvdom_document_get_root(doc);
+    ASSERT_NE(root, nullptr);
+
+    int nr_elements = 0;
+    ASSERT_EQ(0, pcvdom_element_traverse(root, &nr_elements, _count_elements));
+
+    struct pcvdom_element *body = find_element(root, "body");
+    ASSERT_NE(body, nullptr);
+    struct pcvdom_element *init = find_element(root, "init");
+    ASSERT_NE(init, nullptr);
+    ASSERT_NE(pcvdom_element_find_attr(init, "as"), nullptr);
+    ASSERT_NE(pcvdom_element_find_attr(init, "temp"), nullptr);
+
+    struct pcvdom_element *mine = find_element(root, "my-tag");
+    ASSERT_NE(mine, nullptr);
+    ASSERT_EQ(pcvdom_element_next_sibling_element(init), mine);
+    ASSERT_NE(pcvdom_element_find_attr(mine, "my-attr"), nullptr);
+
+    /* outgrows the attributes reserved in the arena */
+    const char *keys[] = { "a1", "a2", "a3", "a4", "a5", "a6" };
+    for (size_t i = 0; i < PCA_TABLESIZE(keys); i++) {
+        struct pcvdom_attr *attr = pcvdom_attr_create_simple(keys[i], NULL);
+        ASSERT_NE(attr, nullptr);
+        ASSERT_EQ(0, pcvdom_element_append_attr(init, attr));
+    }
+    ASSERT_NE(pcvdom_element_find_attr(init, "as"), nullptr);
+    ASSERT_NE(pcvdom_element_find_attr(init, "a6"), nullptr);
+
+    /* the nodes removed from the tree are freed with the document */
+    struct pcvdom_node *node = pcvdom_node_from_element(mine);
+    pcvdom_node_remove(node);
+    pcvdom_node_destroy(node);
+
+    int nr = 0;
+    ASSERT_EQ(0, pcvdom_element_traverse(root, &nr, _count_elements));
+    ASSERT_EQ(nr, nr_elements - 1);
+
+    /* a node from the heap in a tree from the arena */
+    struct pcvdom_element *elem = pcvdom_element_create_c("your-tag");
+    ASSERT_NE(elem, nullptr);
+    ASSERT_EQ(0, pcvdom_element_append_element(body, elem));
+
+    nr = 0;
+    ASSERT_EQ(0, pcvdom_element_traverse(root, &nr, _count_elements));
+    ASSERT_EQ(nr, nr_elements);
+
+    pcvdom_document_unref(doc);
+}